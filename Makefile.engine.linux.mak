@@ -5,8 +5,8 @@ OBJ_DIR := obj
 ASSEMBLY := engine
 EXTENSION := .so
 COMPILER_FLAGS := -g -MD -Wall -Werror -Wvla -Wgnu-folding-constant -Wno-missing-braces -fdeclspec -fPIC
-INCLUDE_FLAGS := -Iengine/src -I$(VULKAN_SDK)/include
-LINKER_FLAGS := -g -shared -lvulkan -lxcb -lX11 -lX11-xcb -lxkbcommon -L$(VULKAN_SDK)/lib -L/usr/X11R6/lib
+INCLUDE_FLAGS := -Iengine/src -I$(VULKAN_SDK)/include -I$(OBJ_DIR)/$(ASSEMBLY)/protocols
+LINKER_FLAGS := -g -shared -lvulkan -lxcb -lxcb-xinput -lX11 -lX11-xcb -lxkbcommon -lwayland-client -L$(VULKAN_SDK)/lib -L/usr/X11R6/lib
 DEFINES := -D_DEBUG -DKEXPORT
 
 # Make does not offer a recursive wildcard function, so here's one:
@@ -16,6 +16,22 @@ SRC_FILES := $(shell find $(ASSEMBLY) -name *.c)		# .c files
 DIRECTORIES := $(shell find $(ASSEMBLY) -type d)		# directories with .h files
 OBJ_FILES := $(SRC_FILES:%=$(OBJ_DIR)/%.o)		# compiled .o objects
 
+# Wayland protocols used by the native Wayland backend (sudo apt-get install wayland-protocols libwayland-bin).
+WAYLAND_PROTOCOLS_DIR := $(shell pkg-config --variable=pkgdatadir wayland-protocols)
+WAYLAND_SCANNER := $(shell pkg-config --variable=wayland_scanner wayland-scanner)
+WAYLAND_PROTOCOL_DIR := $(OBJ_DIR)/$(ASSEMBLY)/protocols
+WAYLAND_PROTOCOL_NAMES := xdg-shell presentation-time
+WAYLAND_PROTOCOL_HEADERS := $(WAYLAND_PROTOCOL_NAMES:%=$(WAYLAND_PROTOCOL_DIR)/%-client-protocol.h)
+define wayland_protocol_rules
+$(WAYLAND_PROTOCOL_DIR)/$(1)-client-protocol.h: $(WAYLAND_PROTOCOLS_DIR)/stable/$(1)/$(1).xml
+	@mkdir -p $(WAYLAND_PROTOCOL_DIR)
+	@$(WAYLAND_SCANNER) client-header $$< $$@
+$(WAYLAND_PROTOCOL_DIR)/$(1)-protocol.c: $(WAYLAND_PROTOCOLS_DIR)/stable/$(1)/$(1).xml
+	@mkdir -p $(WAYLAND_PROTOCOL_DIR)
+	@$(WAYLAND_SCANNER) private-code $$< $$@
+endef
+OBJ_FILES += $(WAYLAND_PROTOCOL_NAMES:%=$(WAYLAND_PROTOCOL_DIR)/%-protocol.c.o)
+
 all: scaffold compile link
 
 .PHONY: scaffold
@@ -43,4 +59,14 @@ $(OBJ_DIR)/%.c.o: %.c # compile .c to .o object
 	@echo   $<...
 	@clang $< $(COMPILER_FLAGS) -c -o $@ $(DEFINES) $(INCLUDE_FLAGS)
 
+# Wayland protocol glue, generated from the system's protocol descriptions rather than checked in.
+$(foreach protocol,$(WAYLAND_PROTOCOL_NAMES),$(eval $(call wayland_protocol_rules,$(protocol))))
+
+$(WAYLAND_PROTOCOL_DIR)/%-protocol.c.o: $(WAYLAND_PROTOCOL_DIR)/%-protocol.c
+	@echo   $<...
+	@clang $< -fPIC -c -o $@
+
+# The backend includes the generated headers, so they must exist before it is compiled.
+$(OBJ_DIR)/$(ASSEMBLY)/src/platform/platform_linux_wayland.c.o: $(WAYLAND_PROTOCOL_HEADERS)
+
 -include $(OBJ_FILES:.o=.d)
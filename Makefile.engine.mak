@@ -5,6 +5,23 @@ ASSEMBLY := engine
 
 DEFINES := -DKEXPORT
 
+# Wayland protocols used by the native Wayland backend on Linux (sudo apt-get install wayland-protocols libwayland-bin).
+ifneq ($(OS),Windows_NT)
+WAYLAND_PROTOCOLS_DIR := $(shell pkg-config --variable=pkgdatadir wayland-protocols)
+WAYLAND_SCANNER := $(shell pkg-config --variable=wayland_scanner wayland-scanner)
+WAYLAND_PROTOCOL_DIR := $(OBJ_DIR)/$(ASSEMBLY)/protocols
+WAYLAND_PROTOCOL_NAMES := xdg-shell presentation-time
+WAYLAND_PROTOCOL_HEADERS := $(WAYLAND_PROTOCOL_NAMES:%=$(WAYLAND_PROTOCOL_DIR)/%-client-protocol.h)
+define wayland_protocol_rules
+$(WAYLAND_PROTOCOL_DIR)/$(1)-client-protocol.h: $(WAYLAND_PROTOCOLS_DIR)/stable/$(1)/$(1).xml
+	@mkdir -p $(WAYLAND_PROTOCOL_DIR)
+	@$(WAYLAND_SCANNER) client-header $$< $$@
+$(WAYLAND_PROTOCOL_DIR)/$(1)-protocol.c: $(WAYLAND_PROTOCOLS_DIR)/stable/$(1)/$(1).xml
+	@mkdir -p $(WAYLAND_PROTOCOL_DIR)
+	@$(WAYLAND_SCANNER) private-code $$< $$@
+endef
+endif
+
 # Detect OS and architecture.
 ifeq ($(OS),Windows_NT)
     # WIN32
@@ -12,7 +29,7 @@ ifeq ($(OS),Windows_NT)
 	EXTENSION := .dll
 	COMPILER_FLAGS := -Wall -Werror -Wvla -Wgnu-folding-constant -Wno-missing-braces -fdeclspec
 	INCLUDE_FLAGS := -Iengine\src -I$(VULKAN_SDK)\include
-	LINKER_FLAGS := -shared -luser32 -lvulkan-1 -L$(VULKAN_SDK)\Lib -L$(OBJ_DIR)\engine
+	LINKER_FLAGS := -shared -luser32 -lwinmm -lvulkan-1 -L$(VULKAN_SDK)\Lib -L$(OBJ_DIR)\engine
 	DEFINES += -D_CRT_SECURE_NO_WARNINGS
 
 # Make does not offer a recursive wildcard function, and Windows needs one, so here it is:
@@ -41,13 +58,13 @@ else
 		BUILD_PLATFORM := linux
 		EXTENSION := .so
 		COMPILER_FLAGS := -Wall -Werror -Wvla -Wgnu-folding-constant -Wno-missing-braces -fdeclspec -fPIC
-		INCLUDE_FLAGS := -Iengine/src -I$(VULKAN_SDK)/include
-		LINKER_FLAGS := -shared -lvulkan -lxcb -lX11 -lX11-xcb -lxkbcommon -L$(VULKAN_SDK)/lib -L/usr/X11R6/lib
+		INCLUDE_FLAGS := -Iengine/src -I$(VULKAN_SDK)/include -I$(OBJ_DIR)/$(ASSEMBLY)/protocols
+		LINKER_FLAGS := -shared -lvulkan -lxcb -lxcb-xinput -lX11 -lX11-xcb -lxkbcommon -lwayland-client -L$(VULKAN_SDK)/lib -L/usr/X11R6/lib
 		# .c files
 		SRC_FILES := $(shell find $(ASSEMBLY) -name *.c)
 		# directories with .h files
 		DIRECTORIES := $(shell find $(ASSEMBLY) -type d)
-		OBJ_FILES := $(SRC_FILES:%=$(OBJ_DIR)/%.o)
+		OBJ_FILES := $(SRC_FILES:%=$(OBJ_DIR)/%.o) $(WAYLAND_PROTOCOL_NAMES:%=$(WAYLAND_PROTOCOL_DIR)/%-protocol.c.o)
     endif
     ifeq ($(UNAME_S),Darwin)
         # OSX
@@ -152,6 +169,18 @@ $(OBJ_DIR)/%.c.o: %.c
 	@echo   $<...
 	@clang $< $(COMPILER_FLAGS) -c -o $@ $(DEFINES) $(INCLUDE_FLAGS)
 
+ifeq ($(BUILD_PLATFORM),linux)
+# Wayland protocol glue, generated from the system's protocol descriptions rather than checked in.
+$(foreach protocol,$(WAYLAND_PROTOCOL_NAMES),$(eval $(call wayland_protocol_rules,$(protocol))))
+
+$(WAYLAND_PROTOCOL_DIR)/%-protocol.c.o: $(WAYLAND_PROTOCOL_DIR)/%-protocol.c
+	@echo   $<...
+	@clang $< -fPIC -c -o $@
+
+# The backend includes the generated headers, so they must exist before it is compiled.
+$(OBJ_DIR)/$(ASSEMBLY)/src/platform/platform_linux_wayland.c.o: $(WAYLAND_PROTOCOL_HEADERS)
+endif
+
 # compile .m to .o object only for macos
 ifeq ($(BUILD_PLATFORM),macos)
 $(OBJ_DIR)/%.m.o: %.m
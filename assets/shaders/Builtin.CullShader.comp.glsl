@@ -0,0 +1,160 @@
+#version 450
+
+// Culls the batched draws of a frame against the view frustum and, where the depth of the last frame
+// is available, against its depth pyramid. Draws of meshlets are also culled if every triangle of the
+// meshlet faces away from the camera. Draws found hidden have their instance count cleared, so they are
+// skipped when their run is drawn indirectly. Draws of several instances are culled as a whole.
+
+layout(local_size_x = 64) in;
+
+// Matches the draw data read by the material shader.
+struct draw_data {
+	mat4 model;
+	uint highlight;
+	uint material;
+	vec3 extents_min;
+	vec3 extents_max;
+	// The axis of the normal cone of a meshlet in xyz, and its cutoff in w, which is 1 for whole geometries.
+	vec4 cone;
+};
+
+// Matches VkDrawIndexedIndirectCommand.
+struct draw_command {
+	uint index_count;
+	uint instance_count;
+	uint first_index;
+	int vertex_offset;
+	uint first_instance;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer draw_data_buffer {
+	draw_data draws[];
+} u_draw_data;
+
+layout(std430, set = 0, binding = 1) buffer draw_command_buffer {
+	draw_command commands[];
+} u_commands;
+
+layout(std430, set = 0, binding = 2) readonly buffer cull_params_buffer {
+	uvec3 dispatch;
+	uint draw_count;
+	mat4 projection;
+	mat4 view;
+	mat4 occlusion_projection;
+	mat4 occlusion_view;
+	vec2 pyramid_size;
+	uint pyramid_level_count;
+	uint occlusion_enabled;
+	// The fraction of the depth, from its top left, the last frame was rendered to at a lower resolution.
+	float occlusion_scale;
+} u_params;
+
+layout(set = 0, binding = 3) uniform sampler2D depth_pyramid;
+
+// Gets a corner of the box between min and max.
+vec4 corner(vec3 extents_min, vec3 extents_max, int i) {
+	return vec4(
+		(i & 1) != 0 ? extents_max.x : extents_min.x,
+		(i & 2) != 0 ? extents_max.y : extents_min.y,
+		(i & 4) != 0 ? extents_max.z : extents_min.z,
+		1.0);
+}
+
+// Tests if any of the box is inside the clip volume, which is 0 <= z <= w in Vulkan.
+bool frustum_visible(mat4 mvp, vec3 extents_min, vec3 extents_max) {
+	// Each bit is set while all corners so far are outside that plane.
+	uint outside = 0x3F;
+	for (int i = 0; i < 8; ++i) {
+		vec4 clip = mvp * corner(extents_min, extents_max, i);
+		uint corner_outside = 0;
+		corner_outside |= clip.x < -clip.w ? 0x01 : 0;
+		corner_outside |= clip.x > clip.w ? 0x02 : 0;
+		corner_outside |= clip.y < -clip.w ? 0x04 : 0;
+		corner_outside |= clip.y > clip.w ? 0x08 : 0;
+		corner_outside |= clip.z < 0.0 ? 0x10 : 0;
+		corner_outside |= clip.z > clip.w ? 0x20 : 0;
+		outside &= corner_outside;
+	}
+	return outside == 0;
+}
+
+// Tests if every triangle of a meshlet faces away from the camera, from the cone its normals lie within.
+bool backfacing(draw_data draw, vec3 camera_position) {
+	if (draw.cone.w >= 1.0) {
+		return false;
+	}
+	vec3 center = (draw.model * vec4((draw.extents_min + draw.extents_max) * 0.5, 1.0)).xyz;
+	float scale = max(length(draw.model[0].xyz), max(length(draw.model[1].xyz), length(draw.model[2].xyz)));
+	float radius = length(draw.extents_max - draw.extents_min) * 0.5 * scale;
+	vec3 axis = normalize(transpose(inverse(mat3(draw.model))) * draw.cone.xyz);
+	vec3 to_center = center - camera_position;
+	return dot(to_center, axis) >= draw.cone.w * length(to_center) + radius;
+}
+
+// Tests if the box is behind the depth of the last frame, projecting it as the last frame was.
+bool occluded(mat4 mvp, vec3 extents_min, vec3 extents_max) {
+	vec2 uv_min = vec2(1.0);
+	vec2 uv_max = vec2(0.0);
+	float nearest = 1.0;
+	for (int i = 0; i < 8; ++i) {
+		vec4 clip = mvp * corner(extents_min, extents_max, i);
+		if (clip.w <= 0.0) {
+			// Reaches behind the camera, so cannot be bounded on screen.
+			return false;
+		}
+		vec3 ndc = clip.xyz / clip.w;
+		// The viewport is flipped, so the top of the screen is at y = 1.
+		vec2 uv = vec2(ndc.x * 0.5 + 0.5, 0.5 - ndc.y * 0.5) * u_params.occlusion_scale;
+		uv_min = min(uv_min, uv);
+		uv_max = max(uv_max, uv);
+		nearest = min(nearest, ndc.z);
+	}
+	if (nearest < 0.0) {
+		// Crosses the near plane.
+		return false;
+	}
+
+	// Widen the box by a texel of the first level, which covers the rounding of odd-sized levels.
+	vec2 texel = 1.0 / u_params.pyramid_size;
+	uv_min = clamp(uv_min - texel, 0.0, 1.0);
+	uv_max = clamp(uv_max + texel, 0.0, 1.0);
+
+	// The level where the box is at most two texels across.
+	vec2 extent = (uv_max - uv_min) * u_params.pyramid_size;
+	int level = int(ceil(log2(max(max(extent.x, extent.y), 1.0))));
+	level = clamp(level, 0, int(u_params.pyramid_level_count) - 1);
+
+	ivec2 level_size = textureSize(depth_pyramid, level);
+	ivec2 lo = clamp(ivec2(uv_min * vec2(level_size)), ivec2(0), level_size - 1);
+	ivec2 hi = clamp(ivec2(uv_max * vec2(level_size)), ivec2(0), level_size - 1);
+	float farthest = 0.0;
+	for (int y = lo.y; y <= hi.y; ++y) {
+		for (int x = lo.x; x <= hi.x; ++x) {
+			farthest = max(farthest, texelFetch(depth_pyramid, ivec2(x, y), level).r);
+		}
+	}
+	return nearest > farthest;
+}
+
+void main() {
+	uint index = gl_GlobalInvocationID.x;
+	if (index >= u_params.draw_count) {
+		return;
+	}
+
+	// A draw of several instances has their draw data in the slots from its own, and the slots after it
+	// have empty commands. It is drawn whole if any instance is visible.
+	uint instance_count = u_commands.commands[index].instance_count;
+	// The view holds no scale, so its rotation inverts by transposing.
+	vec3 camera_position = -(transpose(mat3(u_params.view)) * u_params.view[3].xyz);
+	bool visible = false;
+	for (uint i = 0; i < instance_count && index + i < u_params.draw_count && !visible; ++i) {
+		draw_data draw = u_draw_data.draws[index + i];
+		visible = frustum_visible(u_params.projection * u_params.view * draw.model, draw.extents_min, draw.extents_max) &&
+				  !backfacing(draw, camera_position);
+		if (visible && u_params.occlusion_enabled != 0) {
+			visible = !occluded(u_params.occlusion_projection * u_params.occlusion_view * draw.model, draw.extents_min, draw.extents_max);
+		}
+	}
+	u_commands.commands[index].instance_count = visible ? instance_count : 0;
+}
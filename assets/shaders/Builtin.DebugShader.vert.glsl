@@ -0,0 +1,16 @@
+#version 450
+
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec4 in_colour;
+
+layout(set = 0, binding = 0) uniform global_uniform_object {
+    mat4 projection;
+	mat4 view;
+} global_ubo;
+
+layout(location = 0) out vec4 out_colour;
+
+void main() {
+	out_colour = in_colour;
+	gl_Position = global_ubo.projection * global_ubo.view * vec4(in_position, 1.0);
+}
@@ -0,0 +1,38 @@
+#version 450
+
+layout(set = 0, binding = 0) uniform global_uniform_object {
+    mat4 projection;
+	mat4 view;
+} global_ubo;
+
+// Per-draw data, written by the renderer for each geometry of a batch and indexed by its instance.
+struct draw_data {
+	mat4 model;
+	uint highlight;
+	uint material;
+	uint vertex_stride;
+	vec3 extents_min;
+	vec3 extents_max;
+	vec4 cone;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer draw_data_buffer {
+	draw_data draws[];
+} u_draw_data;
+
+// The vertices of the geometry block, pulled by index. Each starts with its position, whatever its format.
+layout(std430, set = 2, binding = 0) readonly buffer vertex_buffer {
+	float words[];
+} u_vertices;
+
+// Worked out exactly as the material shader does, so its draws pass the depth test where these wrote.
+invariant gl_Position;
+
+void main() {
+	draw_data draw = u_draw_data.draws[gl_InstanceIndex];
+	// The vertex index includes the geometry's first vertex, so is where it is in the whole block.
+	uint base = (uint(gl_VertexIndex) * draw.vertex_stride) / 4;
+	vec3 in_position = vec3(u_vertices.words[base], u_vertices.words[base + 1], u_vertices.words[base + 2]);
+	mat4 model = draw.model;
+    gl_Position = global_ubo.projection * global_ubo.view * model * vec4(in_position, 1.0);
+}
@@ -0,0 +1,28 @@
+#version 450
+
+// Builds one level of the depth pyramid, each texel holding the farthest depth of the 2x2 texels
+// of the level before it, or of the depth buffer for the first level.
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(set = 0, binding = 0) uniform sampler2D source;
+layout(set = 0, binding = 1, r32f) uniform writeonly image2D dest;
+
+void main() {
+	ivec2 dest_size = imageSize(dest);
+	ivec2 coord = ivec2(gl_GlobalInvocationID.xy);
+	if (coord.x >= dest_size.x || coord.y >= dest_size.y) {
+		return;
+	}
+
+	// Levels are half the size of the last, rounded up, so the last row and column of an odd-sized
+	// source are covered by clamping.
+	ivec2 source_max = textureSize(source, 0) - 1;
+	ivec2 base = coord * 2;
+	float depth = texelFetch(source, min(base, source_max), 0).r;
+	depth = max(depth, texelFetch(source, min(base + ivec2(1, 0), source_max), 0).r);
+	depth = max(depth, texelFetch(source, min(base + ivec2(0, 1), source_max), 0).r);
+	depth = max(depth, texelFetch(source, min(base + ivec2(1, 1), source_max), 0).r);
+
+	imageStore(dest, coord, vec4(depth));
+}
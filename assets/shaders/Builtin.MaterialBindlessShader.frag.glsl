@@ -0,0 +1,232 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) out vec4 out_colour;
+
+layout(set = 0, binding = 0) uniform global_uniform_object {
+    mat4 projection;
+    mat4 view;
+    vec4 ambient_colour;
+    vec3 view_position;
+    float time;
+} global_ubo;
+
+// The materials of every instance, each the instance uniforms in configured order, packed as vec4s:
+// diffuse_colour, then the diffuse, specular and normal texture indices and the shininess. The texture
+// indices are entries of the renderer's bindless texture table. Found by the draw data of each draw.
+layout(std430, set = 1, binding = 0) readonly buffer material_table {
+    vec4 data[];
+} materials;
+
+struct material {
+    vec4 diffuse_colour;
+    uint diffuse_index;
+    uint specular_index;
+    uint normal_index;
+    float shininess;
+};
+
+material object_material;
+
+struct point_light {
+    // The position in world space, and the distance beyond which the light adds nothing.
+    vec4 position_radius;
+    vec4 colour;
+    // The constant, linear and quadratic attenuation.
+    vec4 attenuation;
+};
+
+// These match LIGHT_CLUSTERS_MAX_LIGHTS and LIGHT_CLUSTERS_COUNT in light_clusters.h.
+const uint MAX_POINT_LIGHTS = 1024;
+const uint CLUSTER_COUNT = 16 * 9 * 24;
+
+// The lights of the scene, and the lights reaching each cluster of the view frustum, written by the
+// world view each frame. Clusters are ordered across the screen, then down it, then in depth.
+layout(std430, set = 2, binding = 0) readonly buffer light_buffer {
+    // The number of clusters across, down and in depth, and the number of point lights.
+    uvec4 dimensions;
+    // The near and far clip, then the scale and bias making the slice of a view depth d: log(d) * scale + bias.
+    vec4 depth_slicing;
+    vec4 directional_direction;
+    vec4 directional_colour;
+    point_light point_lights[MAX_POINT_LIGHTS];
+    // The offset into indices of the lights of each cluster, and their number.
+    uvec2 clusters[CLUSTER_COUNT];
+    uint indices[];
+} lights;
+
+// Sampled once, however many lights there are.
+vec4 diffuse_sample;
+vec3 specular_sample;
+
+// The bindless texture table, which follows the draw data set.
+layout(set = 4, binding = 0) uniform sampler2D textures[];
+
+// The render mode, being the index of the shader's variant: 0 default, 1 lighting, 2 normals. Each
+// variant is its own pipeline, so the branches on it are resolved when the pipeline is built.
+layout(constant_id = 0) const int render_mode = 0;
+layout(location = 9) flat in uint in_highlight;
+layout(location = 10) flat in uint in_material;
+// Data Transfer Object
+layout(location = 1) in struct dto {
+    vec4 ambient;
+	vec2 tex_coord;
+	vec3 normal;
+	vec3 view_position;
+	vec3 frag_position;
+    vec4 colour;
+	vec3 tangent;
+} in_dto;
+
+mat3 TBN;
+
+uint cluster_index(vec3 frag_position);
+vec4 calculate_directional_light(vec3 normal, vec3 view_direction);
+vec4 calculate_point_light(point_light light, vec3 normal, vec3 frag_position, vec3 view_direction);
+
+void main() {
+    vec4 packed_indices = materials.data[in_material + 1];
+    object_material.diffuse_colour = materials.data[in_material];
+    object_material.diffuse_index = floatBitsToUint(packed_indices.x);
+    object_material.specular_index = floatBitsToUint(packed_indices.y);
+    object_material.normal_index = floatBitsToUint(packed_indices.z);
+    object_material.shininess = packed_indices.w;
+
+    vec3 normal = in_dto.normal;
+    vec3 tangent = in_dto.tangent;
+    tangent = (tangent - dot(tangent, normal) *  normal);
+    vec3 bitangent = cross(in_dto.normal, in_dto.tangent);
+    TBN = mat3(tangent, bitangent, normal);
+
+    // Update the normal to use a sample from the normal map.
+    vec3 localNormal = 2.0 * texture(textures[object_material.normal_index], in_dto.tex_coord).rgb - 1.0;
+    normal = normalize(TBN * localNormal);
+
+    if(render_mode == 0 || render_mode == 1) {
+        vec3 view_direction = normalize(in_dto.view_position - in_dto.frag_position);
+
+        diffuse_sample = texture(textures[object_material.diffuse_index], in_dto.tex_coord);
+        specular_sample = texture(textures[object_material.specular_index], in_dto.tex_coord).rgb;
+
+        out_colour = calculate_directional_light(normal, view_direction);
+
+        // Only the lights which reach the fragment's cluster are listed in it.
+        uvec2 cluster = lights.clusters[cluster_index(in_dto.frag_position)];
+        for (uint i = 0; i < cluster.y; ++i) {
+            out_colour += calculate_point_light(lights.point_lights[lights.indices[cluster.x + i]], normal, in_dto.frag_position, view_direction);
+        }
+    } else if(render_mode == 2) {
+        out_colour = vec4(abs(normal), 1.0);
+    } else {
+        out_colour = vec4(0.0, 0.0, 0.0, 1.0);
+    }
+
+    // Doom Eternal glory-kill glow: pulsing red rim + energy scan lines.
+    // Avoids body tinting so it works on any texture colour.
+    if(in_highlight != 0) {
+        vec3 view_dir = normalize(in_dto.view_position - in_dto.frag_position);
+        float ndotv = max(dot(normal, view_dir), 0.0);
+
+        // Multi-layer Fresnel
+        float rim_sharp = pow(1.0 - ndotv, 5.0);   // razor silhouette edge
+        float rim_wide  = pow(1.0 - ndotv, 2.2);   // mid aura
+        float rim_body  = pow(1.0 - ndotv, 1.0);   // very wide, for subtle darkening
+
+        // Organic double-beat pulse
+        float pulse = 0.55 + 0.3 * sin(global_ubo.time * 6.0) + 0.15 * sin(global_ubo.time * 12.5);
+
+        // Energy scan line sweeping upward through world space
+        float scan_pos  = fract(in_dto.frag_position.y * 0.35 - global_ubo.time * 0.9);
+        float scan      = smoothstep(0.0, 0.04, scan_pos) * (1.0 - smoothstep(0.07, 0.14, scan_pos));
+
+        // Secondary thin faster scan line
+        float scan2     = fract(in_dto.frag_position.y * 0.8  - global_ubo.time * 2.2);
+        float thin_scan = smoothstep(0.0, 0.01, scan2) * (1.0 - smoothstep(0.025, 0.04, scan2));
+
+        // Colour palette: Argent D'Nur teal — the energy of Doom's ancient realm
+        vec3 aura_col = vec3(0.0,  0.5,  0.6);   // deep teal body aura
+        vec3 rim_col  = vec3(0.05, 0.85, 0.9);   // bright cyan rim
+        vec3 edge_col = vec3(0.55, 1.0,  1.0);   // white-cyan silhouette flash
+        vec3 scan_col = vec3(0.1,  0.9,  0.85);  // pure Argent teal scan line
+
+        // Slightly darken non-edge areas so the rim pops
+        out_colour.rgb *= 1.0 - rim_body * 0.2;
+
+        // Wide aura — breathes with the pulse (low intensity, no colour shift)
+        out_colour.rgb += aura_col * rim_wide * 0.28 * pulse;
+
+        // Bright cyan rim at silhouette
+        out_colour.rgb += rim_col * rim_sharp * 0.7 * pulse;
+
+        // Hot bright edge — always on (gives the "outlined" feel)
+        out_colour.rgb += edge_col * pow(rim_sharp, 1.2) * 0.85;
+
+        // Energy scan lines
+        out_colour.rgb += scan_col * scan      * 0.4 * (0.3 + 0.7 * rim_wide);
+        out_colour.rgb += scan_col * thin_scan * 0.25;
+    }
+}
+
+// Gets the cluster of a position in world space, as light_clusters_index does.
+uint cluster_index(vec3 frag_position) {
+    vec4 view_position = global_ubo.view * vec4(frag_position, 1.0);
+    vec4 clip = global_ubo.projection * view_position;
+    vec2 cells = vec2(lights.dimensions.xy);
+    uvec2 tile = uvec2(clamp((clip.xy / clip.w * 0.5 + 0.5) * cells, vec2(0.0), cells - 1.0));
+    float depth = max(-view_position.z, lights.depth_slicing.x);
+    uint slice = uint(clamp(log(depth) * lights.depth_slicing.z + lights.depth_slicing.w, 0.0, float(lights.dimensions.z) - 1.0));
+    return (slice * lights.dimensions.y + tile.y) * lights.dimensions.x + tile.x;
+}
+
+vec4 calculate_directional_light(vec3 normal, vec3 view_direction) {
+    vec3 direction = lights.directional_direction.xyz;
+    vec4 colour = lights.directional_colour;
+    float diffuse_factor = max(dot(normal, -direction), 0.0);
+
+    vec3 half_direction = normalize(view_direction - direction);
+    float specular_factor = pow(max(dot(half_direction, normal), 0.0), object_material.shininess);
+
+    vec4 diff_samp = diffuse_sample;
+    vec4 ambient = vec4(vec3(in_dto.ambient * object_material.diffuse_colour), diff_samp.a);
+    vec4 diffuse = vec4(vec3(colour * diffuse_factor), diff_samp.a);
+    vec4 specular = vec4(vec3(colour * specular_factor), diff_samp.a);
+    
+    if(render_mode == 0) {
+        diffuse *= diff_samp;
+        ambient *= diff_samp;
+        specular *= vec4(specular_sample, diffuse.a);
+    }
+
+    return (ambient + diffuse + specular);
+}
+
+vec4 calculate_point_light(point_light light, vec3 normal, vec3 frag_position, vec3 view_direction) {
+    vec3 light_position = light.position_radius.xyz;
+    vec3 light_direction =  normalize(light_position - frag_position);
+    float diff = max(dot(normal, light_direction), 0.0);
+
+    vec3 reflect_direction = reflect(-light_direction, normal);
+    float spec = pow(max(dot(view_direction, reflect_direction), 0.0), object_material.shininess);
+
+    // Calculate attenuation, or light falloff over distance. It is faded to nothing at the radius,
+    // so the light ends where the clusters it is listed in do.
+    float distance = length(light_position - frag_position);
+    float falloff = clamp(1.0 - pow(distance / light.position_radius.w, 4.0), 0.0, 1.0);
+    float attenuation = falloff * falloff / (light.attenuation.x + light.attenuation.y * distance + light.attenuation.z * (distance * distance));
+
+    vec4 ambient = in_dto.ambient;
+    vec4 diffuse = light.colour * diff;
+    vec4 specular = light.colour * spec;
+    
+    if(render_mode == 0) {
+        vec4 diff_samp = diffuse_sample;
+        diffuse *= diff_samp;
+        ambient *= diff_samp;
+        specular *= vec4(specular_sample, diffuse.a);
+    }
+
+    ambient *= attenuation;
+    diffuse *= attenuation;
+    specular *= attenuation;
+    return (ambient + diffuse + specular);
+}
\ No newline at end of file
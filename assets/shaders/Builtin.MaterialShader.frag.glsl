@@ -7,7 +7,6 @@ layout(set = 0, binding = 0) uniform global_uniform_object {
     mat4 view;
     vec4 ambient_colour;
     vec3 view_position;
-    int mode;
     float time;
 } global_ubo;
 
@@ -16,46 +15,36 @@ layout(set = 1, binding = 0) uniform local_uniform_object {
     float shininess;
 } object_ubo;
 
-struct directional_light {
-    vec3 direction;
-    vec4 colour;
-};
-
 struct point_light {
-    vec3 position;
+    // The position in world space, and the distance beyond which the light adds nothing.
+    vec4 position_radius;
     vec4 colour;
-    // Usually 1, make sure denominator never gets smaller than 1
-    float constant_f;
-    // Reduces light intensity linearly
-    float linear;
-    // Makes the light fall off slower at longer distances.
-    float quadratic;
+    // The constant, linear and quadratic attenuation.
+    vec4 attenuation;
 };
 
-// TODO: feed in from cpu
-directional_light dir_light = {
-    vec3(-0.57735, -0.57735, -0.57735),
-    //vec4(0.6, 0.6, 0.6, 1.0)
-    vec4(0.4, 0.4, 0.2, 1.0)
-};
-
-// TODO: feed in from cpu
-point_light p_light_0 = {
-    vec3(-5.5, 0.0, -5.5),
-    vec4(0.0, 1.0, 0.0, 1.0),
-    1.0, // constant_f
-    0.35, // Linear
-    0.44  // Quadratic
-};
-
-// TODO: feed in from cpu
-point_light p_light_1 = {
-    vec3(5.5, 0.0, -5.5),
-    vec4(1.0, 0.0, 0.0, 1.0),
-    1.0, // constant_f
-    0.35, // Linear
-    0.44  // Quadratic
-};
+// These match LIGHT_CLUSTERS_MAX_LIGHTS and LIGHT_CLUSTERS_COUNT in light_clusters.h.
+const uint MAX_POINT_LIGHTS = 1024;
+const uint CLUSTER_COUNT = 16 * 9 * 24;
+
+// The lights of the scene, and the lights reaching each cluster of the view frustum, written by the
+// world view each frame. Clusters are ordered across the screen, then down it, then in depth.
+layout(std430, set = 2, binding = 0) readonly buffer light_buffer {
+    // The number of clusters across, down and in depth, and the number of point lights.
+    uvec4 dimensions;
+    // The near and far clip, then the scale and bias making the slice of a view depth d: log(d) * scale + bias.
+    vec4 depth_slicing;
+    vec4 directional_direction;
+    vec4 directional_colour;
+    point_light point_lights[MAX_POINT_LIGHTS];
+    // The offset into indices of the lights of each cluster, and their number.
+    uvec2 clusters[CLUSTER_COUNT];
+    uint indices[];
+} lights;
+
+// Sampled once, however many lights there are.
+vec4 diffuse_sample;
+vec3 specular_sample;
 
 // Samplers, diffuse, spec
 const int SAMP_DIFFUSE = 0;
@@ -63,7 +52,9 @@ const int SAMP_SPECULAR = 1;
 const int SAMP_NORMAL = 2;
 layout(set = 1, binding = 1) uniform sampler2D samplers[3];
 
-layout(location = 0) flat in int in_mode;
+// The render mode, being the index of the shader's variant: 0 default, 1 lighting, 2 normals. Each
+// variant is its own pipeline, so the branches on it are resolved when the pipeline is built.
+layout(constant_id = 0) const int render_mode = 0;
 layout(location = 9) flat in uint in_highlight;
 // Data Transfer Object
 layout(location = 1) in struct dto {
@@ -78,7 +69,8 @@ layout(location = 1) in struct dto {
 
 mat3 TBN;
 
-vec4 calculate_directional_light(directional_light light, vec3 normal, vec3 view_direction);
+uint cluster_index(vec3 frag_position);
+vec4 calculate_directional_light(vec3 normal, vec3 view_direction);
 vec4 calculate_point_light(point_light light, vec3 normal, vec3 frag_position, vec3 view_direction);
 
 void main() {
@@ -92,14 +84,20 @@ void main() {
     vec3 localNormal = 2.0 * texture(samplers[SAMP_NORMAL], in_dto.tex_coord).rgb - 1.0;
     normal = normalize(TBN * localNormal);
 
-    if(in_mode == 0 || in_mode == 1) {
+    if(render_mode == 0 || render_mode == 1) {
         vec3 view_direction = normalize(in_dto.view_position - in_dto.frag_position);
 
-        out_colour = calculate_directional_light(dir_light, normal, view_direction);
+        diffuse_sample = texture(samplers[SAMP_DIFFUSE], in_dto.tex_coord);
+        specular_sample = texture(samplers[SAMP_SPECULAR], in_dto.tex_coord).rgb;
+
+        out_colour = calculate_directional_light(normal, view_direction);
 
-        out_colour += calculate_point_light(p_light_0, normal, in_dto.frag_position, view_direction);
-        out_colour += calculate_point_light(p_light_1, normal, in_dto.frag_position, view_direction);
-    } else if(in_mode == 2) {
+        // Only the lights which reach the fragment's cluster are listed in it.
+        uvec2 cluster = lights.clusters[cluster_index(in_dto.frag_position)];
+        for (uint i = 0; i < cluster.y; ++i) {
+            out_colour += calculate_point_light(lights.point_lights[lights.indices[cluster.x + i]], normal, in_dto.frag_position, view_direction);
+        }
+    } else if(render_mode == 2) {
         out_colour = vec4(abs(normal), 1.0);
     } else {
         out_colour = vec4(0.0, 0.0, 0.0, 1.0);
@@ -151,46 +149,62 @@ void main() {
     }
 }
 
-vec4 calculate_directional_light(directional_light light, vec3 normal, vec3 view_direction) {
-    float diffuse_factor = max(dot(normal, -light.direction), 0.0);
+// Gets the cluster of a position in world space, as light_clusters_index does.
+uint cluster_index(vec3 frag_position) {
+    vec4 view_position = global_ubo.view * vec4(frag_position, 1.0);
+    vec4 clip = global_ubo.projection * view_position;
+    vec2 cells = vec2(lights.dimensions.xy);
+    uvec2 tile = uvec2(clamp((clip.xy / clip.w * 0.5 + 0.5) * cells, vec2(0.0), cells - 1.0));
+    float depth = max(-view_position.z, lights.depth_slicing.x);
+    uint slice = uint(clamp(log(depth) * lights.depth_slicing.z + lights.depth_slicing.w, 0.0, float(lights.dimensions.z) - 1.0));
+    return (slice * lights.dimensions.y + tile.y) * lights.dimensions.x + tile.x;
+}
+
+vec4 calculate_directional_light(vec3 normal, vec3 view_direction) {
+    vec3 direction = lights.directional_direction.xyz;
+    vec4 colour = lights.directional_colour;
+    float diffuse_factor = max(dot(normal, -direction), 0.0);
 
-    vec3 half_direction = normalize(view_direction - light.direction);
+    vec3 half_direction = normalize(view_direction - direction);
     float specular_factor = pow(max(dot(half_direction, normal), 0.0), object_ubo.shininess);
 
-    vec4 diff_samp = texture(samplers[SAMP_DIFFUSE], in_dto.tex_coord);
+    vec4 diff_samp = diffuse_sample;
     vec4 ambient = vec4(vec3(in_dto.ambient * object_ubo.diffuse_colour), diff_samp.a);
-    vec4 diffuse = vec4(vec3(light.colour * diffuse_factor), diff_samp.a);
-    vec4 specular = vec4(vec3(light.colour * specular_factor), diff_samp.a);
+    vec4 diffuse = vec4(vec3(colour * diffuse_factor), diff_samp.a);
+    vec4 specular = vec4(vec3(colour * specular_factor), diff_samp.a);
     
-    if(in_mode == 0) {
+    if(render_mode == 0) {
         diffuse *= diff_samp;
         ambient *= diff_samp;
-        specular *= vec4(texture(samplers[SAMP_SPECULAR], in_dto.tex_coord).rgb, diffuse.a);
+        specular *= vec4(specular_sample, diffuse.a);
     }
 
     return (ambient + diffuse + specular);
 }
 
 vec4 calculate_point_light(point_light light, vec3 normal, vec3 frag_position, vec3 view_direction) {
-    vec3 light_direction =  normalize(light.position - frag_position);
+    vec3 light_position = light.position_radius.xyz;
+    vec3 light_direction =  normalize(light_position - frag_position);
     float diff = max(dot(normal, light_direction), 0.0);
 
     vec3 reflect_direction = reflect(-light_direction, normal);
     float spec = pow(max(dot(view_direction, reflect_direction), 0.0), object_ubo.shininess);
 
-    // Calculate attenuation, or light falloff over distance.
-    float distance = length(light.position - frag_position);
-    float attenuation = 1.0 / (light.constant_f + light.linear * distance + light.quadratic * (distance * distance));
+    // Calculate attenuation, or light falloff over distance. It is faded to nothing at the radius,
+    // so the light ends where the clusters it is listed in do.
+    float distance = length(light_position - frag_position);
+    float falloff = clamp(1.0 - pow(distance / light.position_radius.w, 4.0), 0.0, 1.0);
+    float attenuation = falloff * falloff / (light.attenuation.x + light.attenuation.y * distance + light.attenuation.z * (distance * distance));
 
     vec4 ambient = in_dto.ambient;
     vec4 diffuse = light.colour * diff;
     vec4 specular = light.colour * spec;
     
-    if(in_mode == 0) {
-        vec4 diff_samp = texture(samplers[SAMP_DIFFUSE], in_dto.tex_coord);
+    if(render_mode == 0) {
+        vec4 diff_samp = diffuse_sample;
         diffuse *= diff_samp;
         ambient *= diff_samp;
-        specular *= vec4(texture(samplers[SAMP_SPECULAR], in_dto.tex_coord).rgb, diffuse.a);
+        specular *= vec4(specular_sample, diffuse.a);
     }
 
     ambient *= attenuation;
@@ -1,10 +1,12 @@
 #version 450
 
 layout(location = 0) in vec3 in_position;
-layout(location = 1) in vec3 in_normal;
+// Octahedral-encoded, decode with oct_decode.
+layout(location = 1) in vec2 in_normal;
 layout(location = 2) in vec2 in_texcoord;
 layout(location = 3) in vec4 in_colour;
-layout(location = 4) in vec3 in_tangent;
+// Octahedral-encoded, decode with oct_decode.
+layout(location = 4) in vec2 in_tangent;
 
 
 layout(set = 0, binding = 0) uniform global_uniform_object {
@@ -12,19 +14,27 @@ layout(set = 0, binding = 0) uniform global_uniform_object {
 	mat4 view;
 	vec4 ambient_colour;
 	vec3 view_position;
-	int mode;
 	float time;
 } global_ubo;
 
-layout(push_constant) uniform push_constants {
+// Per-draw data, written by the renderer for each geometry of a batch and indexed by its instance.
+struct draw_data {
+	mat4 model;
+	uint highlight;
+	// Where the material of a bindless draw starts in the material table, in vec4s.
+	uint material;
+	// The bounds and normal cone of the geometry or meshlet, which the cull shader reads.
+	vec3 extents_min;
+	vec3 extents_max;
+	vec4 cone;
+};
 
-	// Only guaranteed a total of 128 bytes.
-	mat4 model;     // 64 bytes
-	uint highlight; // 4 bytes
-} u_push_constants;
+layout(std430, set = 3, binding = 0) readonly buffer draw_data_buffer {
+	draw_data draws[];
+} u_draw_data;
 
-layout(location = 0) flat out int out_mode;
 layout(location = 9) flat out uint out_highlight;
+layout(location = 10) flat out uint out_material;
 
 // Data Transfer Object
 layout(location = 1) out struct dto {
@@ -37,19 +47,32 @@ layout(location = 1) out struct dto {
 	vec3 tangent;
 } out_dto;
 
+// Decodes a unit vector from the octahedral mapping written by vec3_to_octahedral_snorm16.
+vec3 oct_decode(vec2 e) {
+	vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (v.z < 0.0) {
+		v.xy = (1.0 - abs(v.yx)) * vec2(e.x >= 0.0 ? 1.0 : -1.0, e.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return normalize(v);
+}
+
+// Worked out exactly as the depth prepass does, so these draws pass the depth test where it wrote.
+invariant gl_Position;
+
 void main() {
+	mat4 model = u_draw_data.draws[gl_InstanceIndex].model;
 	out_dto.tex_coord = in_texcoord;
 	out_dto.colour = in_colour;
 	// Fragment position in world space.
-	out_dto.frag_position = vec3(u_push_constants.model * vec4(in_position, 1.0));
+	out_dto.frag_position = vec3(model * vec4(in_position, 1.0));
 	// Copy the normal over.
-	mat3 m3_model = mat3(u_push_constants.model);
-	out_dto.normal = normalize(m3_model * in_normal);
-	out_dto.tangent = normalize(m3_model * in_tangent);
+	mat3 m3_model = mat3(model);
+	out_dto.normal = normalize(m3_model * oct_decode(in_normal));
+	out_dto.tangent = normalize(m3_model * oct_decode(in_tangent));
 	out_dto.ambient = global_ubo.ambient_colour;
 	out_dto.view_position = global_ubo.view_position;
-    gl_Position = global_ubo.projection * global_ubo.view * u_push_constants.model * vec4(in_position, 1.0);
+    gl_Position = global_ubo.projection * global_ubo.view * model * vec4(in_position, 1.0);
 
-	out_mode = global_ubo.mode;
-	out_highlight = u_push_constants.highlight;
+	out_highlight = u_draw_data.draws[gl_InstanceIndex].highlight;
+	out_material = u_draw_data.draws[gl_InstanceIndex].material;
 }
@@ -0,0 +1,124 @@
+#version 450
+
+// Spawns the particles of every emitter spawning this frame into free slots of the particle pool, taken
+// from the top of the free list. Particles with no slot left are dropped. Also starts the frame's draw
+// with no instances, for the simulation to count the living into.
+
+layout(local_size_x = 64) in;
+
+// Matches the particle of the other particle shaders.
+struct particle {
+	vec3 position;
+	// The seconds left to live. Dead once not above zero.
+	float life;
+	vec3 velocity;
+	float lifetime;
+	vec3 acceleration;
+	float size_start;
+	vec4 colour_start;
+	vec4 colour_end;
+	float size_end;
+	float padding[3];
+};
+
+// Matches particle_emitter_data.
+struct emitter {
+	vec3 position;
+	uint spawn_count;
+	vec3 velocity;
+	float spread;
+	vec3 acceleration;
+	float lifetime;
+	vec4 colour_start;
+	vec4 colour_end;
+	float size_start;
+	float size_end;
+	uint first_spawn;
+	uint seed;
+};
+
+layout(std430, set = 0, binding = 0) writeonly buffer particle_buffer {
+	particle particles[];
+} u_particles;
+
+layout(std430, set = 0, binding = 1) buffer free_buffer {
+	int count;
+	uint slots[];
+} u_free;
+
+layout(std430, set = 0, binding = 2) readonly buffer emitter_buffer {
+	emitter emitters[];
+} u_emitters;
+
+// Matches renderer_draw_indirect_command.
+layout(std430, set = 0, binding = 3) writeonly buffer draw_buffer {
+	uint vertex_count;
+	uint instance_count;
+	uint first_vertex;
+	uint first_instance;
+} u_draw;
+
+layout(push_constant) uniform push_constants {
+	uint spawn_count;
+	uint emitter_count;
+} u_push;
+
+uint hash(uint x) {
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+float random(inout uint state) {
+	state = hash(state);
+	return float(state) / 4294967295.0;
+}
+
+void main() {
+	uint index = gl_GlobalInvocationID.x;
+	if (index == 0) {
+		u_draw.vertex_count = 6;
+		u_draw.instance_count = 0;
+		u_draw.first_vertex = 0;
+		u_draw.first_instance = 0;
+	}
+	if (index >= u_push.spawn_count) {
+		return;
+	}
+
+	// The emitter this particle belongs to. There are few, so are searched one by one.
+	uint e = 0;
+	while (e + 1 < u_push.emitter_count && index >= u_emitters.emitters[e + 1].first_spawn) {
+		e++;
+	}
+	emitter em = u_emitters.emitters[e];
+
+	// Only slots are taken here, so a failed take is given back without racing the others.
+	int top = atomicAdd(u_free.count, -1) - 1;
+	if (top < 0) {
+		atomicAdd(u_free.count, 1);
+		return;
+	}
+	uint slot = u_free.slots[top];
+
+	// A direction within the unit sphere, for the spread.
+	uint state = hash(em.seed * 0x9e3779b9u + (index - em.first_spawn));
+	vec3 direction = vec3(random(state), random(state), random(state)) * 2.0 - 1.0;
+	direction *= random(state) / max(length(direction), 0.0001);
+
+	particle p;
+	p.position = em.position;
+	p.life = em.lifetime;
+	p.velocity = em.velocity + direction * em.spread;
+	p.lifetime = em.lifetime;
+	p.acceleration = em.acceleration;
+	p.size_start = em.size_start;
+	p.colour_start = em.colour_start;
+	p.colour_end = em.colour_end;
+	p.size_end = em.size_end;
+	p.padding = float[3](0.0, 0.0, 0.0);
+	u_particles.particles[slot] = p;
+}
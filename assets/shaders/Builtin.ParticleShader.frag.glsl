@@ -0,0 +1,15 @@
+#version 450
+
+layout(location = 0) in vec4 in_colour;
+layout(location = 1) in vec2 in_corner;
+
+layout(location = 0) out vec4 out_colour;
+
+void main() {
+	// A soft disc within the quad.
+	float alpha = in_colour.a * (1.0 - smoothstep(0.5, 1.0, length(in_corner)));
+	if (alpha <= 0.0) {
+		discard;
+	}
+	out_colour = vec4(in_colour.rgb, alpha);
+}
@@ -0,0 +1,56 @@
+#version 450
+
+// Draws each living particle as a quad facing the camera, one instance each, in the order sorted, from
+// the farthest to the nearest. Six vertices each, found from the vertex index, with no vertex buffer.
+
+// Matches the particle of the other particle shaders.
+struct particle {
+	vec3 position;
+	float life;
+	vec3 velocity;
+	float lifetime;
+	vec3 acceleration;
+	float size_start;
+	vec4 colour_start;
+	vec4 colour_end;
+	float size_end;
+	float padding[3];
+};
+
+struct sort_entry {
+	float key;
+	uint index;
+};
+
+layout(set = 0, binding = 0) uniform global_uniform_object {
+	mat4 projection;
+	mat4 view;
+} global_ubo;
+
+layout(std430, set = 1, binding = 0) readonly buffer particle_buffer {
+	particle particles[];
+} u_particles;
+
+layout(std430, set = 1, binding = 1) readonly buffer sort_buffer {
+	sort_entry entries[];
+} u_sort;
+
+layout(location = 0) out vec4 out_colour;
+layout(location = 1) out vec2 out_corner;
+
+const vec2 CORNERS[6] = vec2[6](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+void main() {
+	particle p = u_particles.particles[u_sort.entries[gl_InstanceIndex].index];
+	// How far through its life it is.
+	float t = clamp(1.0 - p.life / p.lifetime, 0.0, 1.0);
+	float half_size = mix(p.size_start, p.size_end, t) * 0.5;
+
+	vec2 corner = CORNERS[gl_VertexIndex];
+	vec4 view_position = global_ubo.view * vec4(p.position, 1.0);
+	view_position.xy += corner * half_size;
+
+	out_colour = mix(p.colour_start, p.colour_end, t);
+	out_corner = corner;
+	gl_Position = global_ubo.projection * view_position;
+}
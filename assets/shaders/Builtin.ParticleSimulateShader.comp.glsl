@@ -0,0 +1,88 @@
+#version 450
+
+// Moves every living particle of the pool on by the frame's time. Those which die give their slot back
+// to the free list. Each slot writes its sort entry, keyed by the distance of its particle from the
+// camera, with the dead keyed to sort after every living particle. The living are counted into the
+// frame's draw.
+
+layout(local_size_x = 64) in;
+
+// Matches the particle of the other particle shaders.
+struct particle {
+	vec3 position;
+	// The seconds left to live. Dead once not above zero.
+	float life;
+	vec3 velocity;
+	float lifetime;
+	vec3 acceleration;
+	float size_start;
+	vec4 colour_start;
+	vec4 colour_end;
+	float size_end;
+	float padding[3];
+};
+
+struct sort_entry {
+	float key;
+	uint index;
+};
+
+layout(std430, set = 0, binding = 0) buffer particle_buffer {
+	particle particles[];
+} u_particles;
+
+layout(std430, set = 0, binding = 1) buffer free_buffer {
+	int count;
+	uint slots[];
+} u_free;
+
+layout(std430, set = 0, binding = 2) writeonly buffer sort_buffer {
+	sort_entry entries[];
+} u_sort;
+
+// Matches renderer_draw_indirect_command.
+layout(std430, set = 0, binding = 3) buffer draw_buffer {
+	uint vertex_count;
+	uint instance_count;
+	uint first_vertex;
+	uint first_instance;
+} u_draw;
+
+layout(push_constant) uniform push_constants {
+	mat4 view;
+	float delta_time;
+	uint capacity;
+} u_push;
+
+// Below any distance, so the dead sort after the living.
+const float DEAD_KEY = -3.402823466e38;
+
+void main() {
+	uint index = gl_GlobalInvocationID.x;
+	if (index >= u_push.capacity) {
+		return;
+	}
+
+	float key = DEAD_KEY;
+	float life = u_particles.particles[index].life;
+	if (life > 0.0) {
+		life -= u_push.delta_time;
+		u_particles.particles[index].life = life;
+		if (life > 0.0) {
+			vec3 velocity = u_particles.particles[index].velocity + u_particles.particles[index].acceleration * u_push.delta_time;
+			vec3 position = u_particles.particles[index].position + velocity * u_push.delta_time;
+			u_particles.particles[index].velocity = velocity;
+			u_particles.particles[index].position = position;
+			// The camera looks down negative z, so the farthest have the largest key.
+			key = -(u_push.view * vec4(position, 1.0)).z;
+			atomicAdd(u_draw.instance_count, 1);
+		} else {
+			// Only slots are given back here, so the top is never taken at once.
+			int top = atomicAdd(u_free.count, 1);
+			u_free.slots[top] = index;
+		}
+	}
+
+	u_sort.entries[index].key = key;
+	u_sort.entries[index].index = index;
+}
@@ -0,0 +1,79 @@
+#version 450
+
+// One step of a bitonic sort of the particles' sort entries, largest key first, so the particles are
+// drawn back to front. The entries of the pool, a power of two of them, are sorted in sequences of
+// doubling size k, each merged by comparing entries j apart for halving j. Steps comparing entries
+// farther apart than a workgroup holds each take a dispatch of their own. The rest are done together
+// in shared memory by the local steps: all of them for the sequences up to a workgroup long, or just
+// those of sequence k.
+
+layout(local_size_x = 256) in;
+
+// The entries held by a workgroup at once, two for each invocation.
+const uint BLOCK_SIZE = 512;
+
+struct sort_entry {
+	float key;
+	uint index;
+};
+
+layout(std430, set = 0, binding = 0) buffer sort_buffer {
+	sort_entry entries[];
+} u_sort;
+
+layout(push_constant) uniform push_constants {
+	// The length of the sequences being merged.
+	uint k;
+	// The distance between the entries compared, or the greatest of them for the local steps.
+	uint j;
+	// Nonzero for the local steps.
+	uint local_steps;
+} u_push;
+
+shared sort_entry s_entries[BLOCK_SIZE];
+
+// Orders the given pair, whose first is at the given index, for a sequence of the given length.
+void compare_swap(inout sort_entry a, inout sort_entry b, uint index, uint k) {
+	// Sequences alternate, so each pair of them forms a bitonic sequence to merge. The longest ends largest first.
+	bool descending = (index & k) == 0;
+	if ((a.key < b.key) == descending) {
+		sort_entry t = a;
+		a = b;
+		b = t;
+	}
+}
+
+void main() {
+	uint t = gl_LocalInvocationID.x;
+	if (u_push.local_steps == 0) {
+		uint thread = gl_GlobalInvocationID.x;
+		uint i = 2 * u_push.j * (thread / u_push.j) + (thread % u_push.j);
+		sort_entry a = u_sort.entries[i];
+		sort_entry b = u_sort.entries[i + u_push.j];
+		compare_swap(a, b, i, u_push.k);
+		u_sort.entries[i] = a;
+		u_sort.entries[i + u_push.j] = b;
+		return;
+	}
+
+	uint block_start = gl_WorkGroupID.x * BLOCK_SIZE;
+	s_entries[t] = u_sort.entries[block_start + t];
+	s_entries[t + BLOCK_SIZE / 2] = u_sort.entries[block_start + t + BLOCK_SIZE / 2];
+	barrier();
+
+	uint first_k = u_push.k <= BLOCK_SIZE ? 2 : u_push.k;
+	for (uint k = first_k; k <= u_push.k; k <<= 1) {
+		for (uint j = min(k >> 1, u_push.j); j > 0; j >>= 1) {
+			uint i = 2 * j * (t / j) + (t % j);
+			sort_entry a = s_entries[i];
+			sort_entry b = s_entries[i + j];
+			compare_swap(a, b, block_start + i, k);
+			s_entries[i] = a;
+			s_entries[i + j] = b;
+			barrier();
+		}
+	}
+
+	u_sort.entries[block_start + t] = s_entries[t];
+	u_sort.entries[block_start + t + BLOCK_SIZE / 2] = s_entries[t + BLOCK_SIZE / 2];
+}
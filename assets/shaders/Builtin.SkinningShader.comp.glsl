@@ -0,0 +1,91 @@
+#version 450
+
+// Skins the vertices of one geometry with its joint palette of the frame, from its vertices in the bind
+// pose into its own range of the geometry block's vertex buffer, so every shader draws it as posed. Each
+// vertex is moved by up to four joints, blended by their weights. Normals and tangents are turned by the
+// same blend, so joints are not expected to scale unevenly.
+
+layout(local_size_x = 64) in;
+
+// Matches vertex_3d_skinned, as words: the position, normal, texcoord, colour, tangent, joints then weights.
+layout(std430, set = 0, binding = 0) readonly buffer source_buffer {
+	uint words[];
+} u_source;
+
+layout(std430, set = 0, binding = 1) readonly buffer palette_buffer {
+	mat4 joints[];
+} u_palette;
+
+// The vertices of the geometry block, written as vertex_3d_packed.
+layout(std430, set = 1, binding = 0) writeonly buffer vertex_buffer {
+	uint words[];
+} u_vertices;
+
+layout(push_constant) uniform push_constants {
+	uint vertex_count;
+	// The first joint of this geometry's palette in the palette buffer.
+	uint first_joint;
+	// The first word of the geometry's vertices in the vertex buffer.
+	uint first_word;
+	uint joint_count;
+} u_push;
+
+const uint SOURCE_STRIDE = 9;
+const uint PACKED_STRIDE = 7;
+
+// Decodes a unit vector from the octahedral mapping written by vec3_to_octahedral_snorm16.
+vec3 oct_decode(vec2 e) {
+	vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (v.z < 0.0) {
+		v.xy = (1.0 - abs(v.yx)) * vec2(e.x >= 0.0 ? 1.0 : -1.0, e.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return normalize(v);
+}
+
+// Encodes a unit vector as vec3_to_octahedral_snorm16 does.
+uint oct_encode(vec3 v) {
+	vec2 e = v.xy / (abs(v.x) + abs(v.y) + abs(v.z));
+	if (v.z < 0.0) {
+		e = (1.0 - abs(e.yx)) * vec2(e.x >= 0.0 ? 1.0 : -1.0, e.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return packSnorm2x16(e);
+}
+
+void main() {
+	uint index = gl_GlobalInvocationID.x;
+	if (index >= u_push.vertex_count) {
+		return;
+	}
+
+	uint source = index * SOURCE_STRIDE;
+	vec3 position = uintBitsToFloat(uvec3(u_source.words[source], u_source.words[source + 1], u_source.words[source + 2]));
+	vec3 normal = oct_decode(unpackSnorm2x16(u_source.words[source + 3]));
+	vec3 tangent = oct_decode(unpackSnorm2x16(u_source.words[source + 6]));
+	uvec4 joints = (uvec4(u_source.words[source + 7]) >> uvec4(0, 8, 16, 24)) & 0xFF;
+	vec4 weights = unpackUnorm4x8(u_source.words[source + 8]);
+
+	// Joints past the end of the palette are left out, rather than read from another geometry's. A vertex
+	// left with none stays as it is bound.
+	mat4 skin = mat4(0.0);
+	float total = 0.0;
+	for (int i = 0; i < 4; ++i) {
+		if (weights[i] > 0.0 && joints[i] < u_push.joint_count) {
+			skin += u_palette.joints[u_push.first_joint + joints[i]] * weights[i];
+			total += weights[i];
+		}
+	}
+	if (total == 0.0) {
+		skin = mat4(1.0);
+	}
+
+	uint dest = u_push.first_word + index * PACKED_STRIDE;
+	uvec3 skinned = floatBitsToUint((skin * vec4(position, 1.0)).xyz);
+	u_vertices.words[dest] = skinned.x;
+	u_vertices.words[dest + 1] = skinned.y;
+	u_vertices.words[dest + 2] = skinned.z;
+	u_vertices.words[dest + 3] = oct_encode(normalize(mat3(skin) * normal));
+	// The texture coordinate and colour are as they are bound.
+	u_vertices.words[dest + 4] = u_source.words[source + 4];
+	u_vertices.words[dest + 5] = u_source.words[source + 5];
+	u_vertices.words[dest + 6] = oct_encode(normalize(mat3(skin) * tangent));
+}
@@ -1,10 +1,12 @@
 #version 450
 
 layout(location = 0) in vec3 in_position;
-layout(location = 1) in vec3 in_normal;
+// Octahedral-encoded. Unused here.
+layout(location = 1) in vec2 in_normal;
 layout(location = 2) in vec2 in_texcoord;
 layout(location = 3) in vec4 in_colour;
-layout(location = 4) in vec4 in_tangent;
+// Octahedral-encoded. Unused here.
+layout(location = 4) in vec2 in_tangent;
 
 layout(set = 0, binding = 0) uniform global_uniform_object {
     mat4 projection;
@@ -15,5 +17,6 @@ layout(location = 0) out vec3 tex_coord;
 
 void main() {
 	tex_coord = in_position;
-	gl_Position = global_ubo.projection * global_ubo.view * vec4(in_position, 1.0);
+	// Kept at the far plane, so drawn after the world it only shades pixels nothing else covered.
+	gl_Position = (global_ubo.projection * global_ubo.view * vec4(in_position, 1.0)).xyww;
 } 
\ No newline at end of file
@@ -8,12 +8,10 @@ layout(set = 0, binding = 0) uniform global_uniform_object {
 	mat4 view;
 } global_ubo;
 
-layout(push_constant) uniform push_constants {
-
-	// Only guaranteed a total of 128 bytes.
-	mat4 model; // 64 bytes
-} u_push_constants;
+layout(set = 2, binding = 0) uniform local_uniform_object {
+	mat4 model;
+} local_ubo;
 
 void main() {
-	gl_Position = global_ubo.projection * global_ubo.view * u_push_constants.model * vec4(in_position, 0.0, 1.0);
+	gl_Position = global_ubo.projection * global_ubo.view * local_ubo.model * vec4(in_position, 0.0, 1.0);
 }
@@ -1,5 +1,9 @@
 #version 450
 
+// The shader variant. 0 draws the diffuse texture as it is, 1 draws it as a signed distance field
+// of text, covered where it is above 0.5.
+layout(constant_id = 0) const int text_mode = 0;
+
 layout(location = 0) out vec4 out_colour;
 
 layout(set = 1, binding = 0) uniform local_uniform_object {
@@ -16,5 +20,14 @@ layout(location = 1) in struct dto {
 } in_dto;
 
 void main() {
-    out_colour =  object_ubo.diffuse_colour * texture(samplers[SAMP_DIFFUSE], in_dto.tex_coord);
+    vec4 sampled = texture(samplers[SAMP_DIFFUSE], in_dto.tex_coord);
+    if (text_mode == 1) {
+        // Blend across about a pixel of the edge, whatever size the text is drawn at.
+        float distance = sampled.r;
+        float width = max(fwidth(distance), 0.0001);
+        float coverage = smoothstep(0.5 - width, 0.5 + width, distance);
+        out_colour = vec4(object_ubo.diffuse_colour.rgb, object_ubo.diffuse_colour.a * coverage);
+    } else {
+        out_colour = object_ubo.diffuse_colour * sampled;
+    }
 }
\ No newline at end of file
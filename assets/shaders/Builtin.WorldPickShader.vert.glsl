@@ -1,22 +1,22 @@
 #version 450
 
 layout(location = 0) in vec3 in_position;
-layout(location = 1) in vec3 in_normal;
+// Octahedral-encoded. Unused here.
+layout(location = 1) in vec2 in_normal;
 layout(location = 2) in vec2 in_texcoord;
 layout(location = 3) in vec4 in_colour;
-layout(location = 4) in vec3 in_tangent;
+// Octahedral-encoded. Unused here.
+layout(location = 4) in vec2 in_tangent;
 
 layout(set = 0, binding = 0) uniform global_uniform_object {
     mat4 projection;
 	mat4 view;
 } global_ubo;
 
-layout(push_constant) uniform push_constants {
-
-	// Only guaranteed a total of 128 bytes.
-	mat4 model; // 64 bytes
-} u_push_constants;
+layout(set = 2, binding = 0) uniform local_uniform_object {
+	mat4 model;
+} local_ubo;
 
 void main() {
-	gl_Position = global_ubo.projection * global_ubo.view * u_push_constants.model * vec4(in_position, 1.0);
+	gl_Position = global_ubo.projection * global_ubo.view * local_ubo.model * vec4(in_position, 1.0);
 }
@@ -0,0 +1,36 @@
+@ECHO OFF
+REM Runs every benchmark scene of the testbed, comparing each against its stored baseline.
+REM Exits with an error if any scene regressed past the threshold, or failed to run.
+REM Pass --update-baseline to store the results as the new baselines instead.
+
+SET UPDATE_BASELINE=%1
+SET FRAMES=1000
+SET THRESHOLD=10
+SET FAILED=
+
+if not exist bin\bench mkdir bin\bench
+if not exist benchmarks\baselines mkdir benchmarks\baselines
+PUSHD bin
+
+FOR %%S IN (sponza cubes ui streaming) DO (
+    ECHO Benchmarking scene '%%S'...
+    if "%UPDATE_BASELINE%" == "--update-baseline" (
+        testbed.exe --benchmark=%FRAMES% --benchmark-scene=%%S --benchmark-output=bench\%%S.json
+        IF NOT ERRORLEVEL 1 copy /Y bench\%%S.json ..\benchmarks\baselines\%%S.json >NUL
+    ) else (
+        testbed.exe --benchmark=%FRAMES% --benchmark-scene=%%S --benchmark-output=bench\%%S.json --benchmark-baseline=..\benchmarks\baselines\%%S.json --benchmark-threshold=%THRESHOLD%
+    )
+    IF ERRORLEVEL 1 (
+        ECHO Error in scene '%%S'.
+        SET FAILED=1
+    )
+)
+
+POPD
+
+IF DEFINED FAILED (
+    ECHO Benchmarks failed.
+    exit /b 1
+)
+
+ECHO All benchmark scenes passed.
@@ -0,0 +1,47 @@
+#!/bin/bash
+# Runs every benchmark scene of the testbed, comparing each against its stored baseline.
+# Exits with an error if any scene regressed past the threshold, or failed to run.
+# Pass --update-baseline to store the results as the new baselines instead.
+UPDATE_BASELINE="$1"
+FRAMES=1000
+THRESHOLD=10
+SCENES="sponza cubes ui streaming"
+
+set echo off
+
+mkdir -p bin/bench benchmarks/baselines
+pushd bin
+
+FAILED=""
+for SCENE in $SCENES
+do
+   echo "Benchmarking scene '$SCENE'..."
+   OUTPUT=bench/$SCENE.json
+   BASELINE=../benchmarks/baselines/$SCENE.json
+   if [ "$UPDATE_BASELINE" = "--update-baseline" ]
+   then
+      ./testbed --benchmark=$FRAMES --benchmark-scene=$SCENE --benchmark-output=$OUTPUT
+      ERRORLEVEL=$?
+      if [ $ERRORLEVEL -eq 0 ]
+      then
+         cp $OUTPUT $BASELINE
+      fi
+   else
+      ./testbed --benchmark=$FRAMES --benchmark-scene=$SCENE --benchmark-output=$OUTPUT --benchmark-baseline=$BASELINE --benchmark-threshold=$THRESHOLD
+      ERRORLEVEL=$?
+   fi
+   if [ $ERRORLEVEL -ne 0 ]
+   then
+      echo "Error:"$ERRORLEVEL" in scene '$SCENE'."
+      FAILED="$FAILED $SCENE"
+   fi
+done
+
+popd
+
+if [ -n "$FAILED" ]
+then
+echo "Benchmarks failed:$FAILED" && exit 1
+fi
+
+echo "All benchmark scenes passed."
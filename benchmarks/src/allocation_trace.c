@@ -0,0 +1,274 @@
+#include "allocation_trace.h"
+
+#include <containers/darray.h>
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <core/logger.h>
+#include <platform/filesystem.h>
+
+#include <stdio.h>  // sscanf
+
+// Frees are mostly of recent allocations, as most engine allocations are temporaries.
+#define RECENT_WINDOW 32
+
+typedef struct trace_builder {
+    allocation_op* ops;
+    // Slots not currently in use.
+    u32* free_slots;
+    // Slots currently in use, oldest first.
+    u32* live_slots;
+    u64* slot_sizes;
+    u64 live_size;
+    u64 rng;
+    allocation_trace* trace;
+} trace_builder;
+
+static u64 rng_next(u64* state) {
+    // xorshift64*, so that traces are the same on every platform.
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+static u64 rng_range(u64* state, u64 min, u64 max) {
+    return min + rng_next(state) % (max - min + 1);
+}
+
+static void builder_begin(trace_builder* builder, const char* name, u64 seed, allocation_trace* out_trace) {
+    kzero_memory(out_trace, sizeof(allocation_trace));
+    string_ncopy(out_trace->name, name, sizeof(out_trace->name) - 1);
+    builder->ops = darray_create(allocation_op);
+    builder->free_slots = darray_create(u32);
+    builder->live_slots = darray_create(u32);
+    builder->slot_sizes = darray_create(u64);
+    builder->live_size = 0;
+    builder->rng = seed ? seed : 1;
+    builder->trace = out_trace;
+}
+
+static void builder_allocate(trace_builder* builder, u64 size) {
+    u32 slot;
+    if (darray_length(builder->free_slots)) {
+        darray_pop(builder->free_slots, &slot);
+        builder->slot_sizes[slot] = size;
+    } else {
+        slot = builder->trace->slot_count++;
+        darray_push(builder->slot_sizes, size);
+    }
+    darray_push(builder->live_slots, slot);
+
+    allocation_op op = {ALLOCATION_OP_ALLOCATE, slot, size};
+    darray_push(builder->ops, op);
+    builder->live_size += size;
+    builder->trace->peak_live_size = KMAX(builder->trace->peak_live_size, builder->live_size);
+    builder->trace->max_size = KMAX(builder->trace->max_size, size);
+}
+
+static void builder_free(trace_builder* builder, u64 live_index) {
+    // Shift the rest down, rather than swapping with the last, to keep the slots in age order.
+    u32* live = builder->live_slots;
+    u64 live_count = darray_length(live);
+    u32 slot = live[live_index];
+    for (u64 i = live_index; i + 1 < live_count; ++i) {
+        live[i] = live[i + 1];
+    }
+    darray_length_set(live, live_count - 1);
+    darray_push(builder->free_slots, slot);
+    allocation_op op = {ALLOCATION_OP_FREE, slot, 0};
+    darray_push(builder->ops, op);
+    builder->live_size -= builder->slot_sizes[slot];
+}
+
+// Frees a random live allocation, favouring recent ones.
+static void builder_free_random(trace_builder* builder) {
+    u64 live_count = darray_length(builder->live_slots);
+    u64 index;
+    if (live_count > RECENT_WINDOW && rng_next(&builder->rng) % 10 < 7) {
+        index = live_count - 1 - rng_next(&builder->rng) % RECENT_WINDOW;
+    } else {
+        index = rng_next(&builder->rng) % live_count;
+    }
+    builder_free(builder, index);
+}
+
+static void builder_end(trace_builder* builder) {
+    // Free anything left, so every trace ends with nothing allocated.
+    while (darray_length(builder->live_slots)) {
+        builder_free(builder, darray_length(builder->live_slots) - 1);
+    }
+
+    allocation_trace* trace = builder->trace;
+    trace->op_count = (u32)darray_length(builder->ops);
+    trace->ops = kallocate(sizeof(allocation_op) * trace->op_count, MEMORY_TAG_ARRAY);
+    kcopy_memory(trace->ops, builder->ops, sizeof(allocation_op) * trace->op_count);
+
+    darray_destroy(builder->ops);
+    darray_destroy(builder->free_slots);
+    darray_destroy(builder->live_slots);
+    darray_destroy(builder->slot_sizes);
+}
+
+void allocation_trace_generate_engine_mix(u32 op_count, u64 seed, allocation_trace* out_trace) {
+    trace_builder builder;
+    builder_begin(&builder, "engine mix", seed, out_trace);
+
+    // Hovers around this many live allocations.
+    const u64 target_live = 2048;
+    while (darray_length(builder.ops) < op_count) {
+        u64 live_count = darray_length(builder.live_slots);
+        // Lean towards allocating while below the target, and towards freeing above it.
+        u64 allocate_chance = live_count < target_live ? 60 : 40;
+        if (live_count == 0 || rng_next(&builder.rng) % 100 < allocate_chance) {
+            u64 kind = rng_next(&builder.rng) % 100;
+            u64 size;
+            if (kind < 60) {
+                // Strings and small structures.
+                size = rng_range(&builder.rng, 8, 128);
+            } else if (kind < 90) {
+                // Arrays and hashtables.
+                size = rng_range(&builder.rng, 128, KIBIBYTES(4));
+            } else if (kind < 99) {
+                // Larger arrays, such as geometry being built.
+                size = rng_range(&builder.rng, KIBIBYTES(4), KIBIBYTES(64));
+            } else {
+                // Resource data, such as pixels or file contents.
+                size = rng_range(&builder.rng, KIBIBYTES(64), MEBIBYTES(1));
+            }
+            builder_allocate(&builder, size);
+        } else {
+            builder_free_random(&builder);
+        }
+    }
+
+    builder_end(&builder);
+}
+
+void allocation_trace_generate_frame_churn(u32 frame_count, u32 allocations_per_frame, u64 seed, allocation_trace* out_trace) {
+    trace_builder builder;
+    builder_begin(&builder, "frame churn", seed, out_trace);
+
+    for (u32 frame = 0; frame < frame_count; ++frame) {
+        for (u32 i = 0; i < allocations_per_frame; ++i) {
+            // Mostly render and UI data, with the odd larger buffer.
+            u64 size = rng_next(&builder.rng) % 100 < 95 ? rng_range(&builder.rng, 16, KIBIBYTES(2)) : rng_range(&builder.rng, KIBIBYTES(2), KIBIBYTES(32));
+            builder_allocate(&builder, size);
+        }
+        // Everything made during the frame goes at the end of it, in the order it was made.
+        while (darray_length(builder.live_slots)) {
+            builder_free(&builder, 0);
+        }
+    }
+
+    builder_end(&builder);
+}
+
+void allocation_trace_generate_small_objects(u32 op_count, u64 max_size, u64 seed, allocation_trace* out_trace) {
+    trace_builder builder;
+    builder_begin(&builder, "small objects", seed, out_trace);
+
+    const u64 target_live = 4096;
+    while (darray_length(builder.ops) < op_count) {
+        u64 live_count = darray_length(builder.live_slots);
+        u64 allocate_chance = live_count < target_live ? 60 : 40;
+        if (live_count == 0 || rng_next(&builder.rng) % 100 < allocate_chance) {
+            builder_allocate(&builder, rng_range(&builder.rng, 8, max_size));
+        } else {
+            // Small objects are usually freed in no particular order.
+            builder_free(&builder, rng_next(&builder.rng) % live_count);
+        }
+    }
+
+    builder_end(&builder);
+}
+
+b8 allocation_trace_load(const char* path, allocation_trace* out_trace) {
+    file_handle f;
+    if (!filesystem_open(path, FILE_MODE_READ, false, &f)) {
+        KERROR("allocation_trace_load - unable to open '%s'.", path);
+        return false;
+    }
+
+    kzero_memory(out_trace, sizeof(allocation_trace));
+    string_ncopy(out_trace->name, path, sizeof(out_trace->name) - 1);
+    allocation_op* ops = darray_create(allocation_op);
+    // The size of each slot, or 0 when unused.
+    u64* slot_sizes = darray_create(u64);
+    u64 live_size = 0;
+    b8 success = true;
+
+    char line_buf[512] = "";
+    char* p = &line_buf[0];
+    u64 line_length = 0;
+    u32 line_number = 1;
+    while (filesystem_read_line(&f, 511, &p, &line_length)) {
+        char* trimmed = string_trim(line_buf);
+        if (string_length(trimmed) == 0 || trimmed[0] == '#') {
+            line_number++;
+            continue;
+        }
+
+        allocation_op op = {0};
+        char type = 0;
+        if (sscanf(trimmed, "%c %u %llu", &type, &op.slot, &op.size) < 2 || (type == 'a' && op.size == 0) || (type != 'a' && type != 'f')) {
+            KERROR("allocation_trace_load - invalid operation on line %u of '%s'.", line_number, path);
+            success = false;
+            break;
+        }
+        while (darray_length(slot_sizes) <= op.slot) {
+            darray_push(slot_sizes, (u64)0);
+        }
+        if (type == 'a') {
+            if (slot_sizes[op.slot]) {
+                KERROR("allocation_trace_load - slot %u is allocated twice on line %u of '%s'.", op.slot, line_number, path);
+                success = false;
+                break;
+            }
+            op.type = ALLOCATION_OP_ALLOCATE;
+            slot_sizes[op.slot] = op.size;
+            live_size += op.size;
+            out_trace->peak_live_size = KMAX(out_trace->peak_live_size, live_size);
+            out_trace->max_size = KMAX(out_trace->max_size, op.size);
+        } else {
+            if (!slot_sizes[op.slot]) {
+                KERROR("allocation_trace_load - slot %u is freed while unused on line %u of '%s'.", op.slot, line_number, path);
+                success = false;
+                break;
+            }
+            op.type = ALLOCATION_OP_FREE;
+            op.size = 0;
+            live_size -= slot_sizes[op.slot];
+            slot_sizes[op.slot] = 0;
+        }
+        darray_push(ops, op);
+        line_number++;
+    }
+    filesystem_close(&f);
+
+    if (success) {
+        // Free anything the trace leaves allocated, so every trace ends with nothing allocated.
+        u64 slot_count = darray_length(slot_sizes);
+        for (u32 i = 0; i < slot_count; ++i) {
+            if (slot_sizes[i]) {
+                allocation_op op = {ALLOCATION_OP_FREE, i, 0};
+                darray_push(ops, op);
+            }
+        }
+        out_trace->slot_count = (u32)slot_count;
+        out_trace->op_count = (u32)darray_length(ops);
+        out_trace->ops = kallocate(sizeof(allocation_op) * out_trace->op_count, MEMORY_TAG_ARRAY);
+        kcopy_memory(out_trace->ops, ops, sizeof(allocation_op) * out_trace->op_count);
+    }
+
+    darray_destroy(ops);
+    darray_destroy(slot_sizes);
+    return success;
+}
+
+void allocation_trace_destroy(allocation_trace* trace) {
+    if (trace && trace->ops) {
+        kfree(trace->ops, sizeof(allocation_op) * trace->op_count, MEMORY_TAG_ARRAY);
+        trace->ops = 0;
+        trace->op_count = 0;
+    }
+}
@@ -0,0 +1,98 @@
+/**
+ * @file allocation_trace.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Allocation traces used to benchmark the engine's allocators.
+ * @details A trace is a sequence of allocate and free operations. Each allocation is placed
+ * in a numbered slot, and each free releases whatever was placed in its slot, so a trace can
+ * be replayed against any allocator. Traces are either generated to mimic engine allocation
+ * patterns, or loaded from a text file with one operation per line:
+ *   a <slot> <size>   Allocates size bytes into slot.
+ *   f <slot>          Frees the allocation in slot.
+ * Lines starting with '#' are ignored.
+ * @version 1.0
+ *
+ * 
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ * 
+ */
+
+#pragma once
+
+#include <defines.h>
+
+/** @brief The type of a single trace operation. */
+typedef enum allocation_op_type {
+    ALLOCATION_OP_ALLOCATE,
+    ALLOCATION_OP_FREE
+} allocation_op_type;
+
+/** @brief A single operation of an allocation trace. */
+typedef struct allocation_op {
+    allocation_op_type type;
+    /** @brief The slot allocated into or freed. */
+    u32 slot;
+    /** @brief The size in bytes to allocate. Unused for frees. */
+    u64 size;
+} allocation_op;
+
+/** @brief A sequence of allocation operations. */
+typedef struct allocation_trace {
+    /** @brief The name of the trace, used when reporting. */
+    char name[64];
+    /** @brief The number of operations. */
+    u32 op_count;
+    /** @brief The number of slots used, which is the most allocations live at once. */
+    u32 slot_count;
+    /** @brief The largest single allocation in bytes. */
+    u64 max_size;
+    /** @brief The most bytes live at once. */
+    u64 peak_live_size;
+    /** @brief The operations. */
+    allocation_op* ops;
+} allocation_trace;
+
+/**
+ * @brief Generates a trace mimicking a mix of long- and short-lived engine allocations: mostly small
+ * strings and structures, a good share of growing arrays, and occasional large resource buffers.
+ *
+ * @param op_count The number of operations to generate.
+ * @param seed The seed for the generator, so runs are repeatable.
+ * @param out_trace A pointer to hold the trace.
+ */
+void allocation_trace_generate_engine_mix(u32 op_count, u64 seed, allocation_trace* out_trace);
+
+/**
+ * @brief Generates a trace mimicking per-frame allocations, which are all freed by the end of each frame.
+ *
+ * @param frame_count The number of frames to generate.
+ * @param allocations_per_frame The number of allocations made each frame.
+ * @param seed The seed for the generator, so runs are repeatable.
+ * @param out_trace A pointer to hold the trace.
+ */
+void allocation_trace_generate_frame_churn(u32 frame_count, u32 allocations_per_frame, u64 seed, allocation_trace* out_trace);
+
+/**
+ * @brief Generates a trace of randomly allocated and freed small objects, suited to pool and slab allocators.
+ *
+ * @param op_count The number of operations to generate.
+ * @param max_size The largest size to allocate, in bytes.
+ * @param seed The seed for the generator, so runs are repeatable.
+ * @param out_trace A pointer to hold the trace.
+ */
+void allocation_trace_generate_small_objects(u32 op_count, u64 max_size, u64 seed, allocation_trace* out_trace);
+
+/**
+ * @brief Loads a trace from a text file in the format described above.
+ *
+ * @param path The path to the file.
+ * @param out_trace A pointer to hold the trace.
+ * @return True on success; otherwise false.
+ */
+b8 allocation_trace_load(const char* path, allocation_trace* out_trace);
+
+/**
+ * @brief Destroys the given trace, releasing its operations.
+ *
+ * @param trace A pointer to the trace to be destroyed.
+ */
+void allocation_trace_destroy(allocation_trace* trace);
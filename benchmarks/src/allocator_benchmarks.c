@@ -0,0 +1,451 @@
+#include "allocator_benchmarks.h"
+
+#include <containers/freelist.h>
+#include <core/katomic.h>
+#include <core/kmemory.h>
+#include <core/kmutex.h>
+#include <core/kstring.h>
+#include <core/kthread.h>
+#include <core/logger.h>
+#include <memory/dynamic_allocator.h>
+#include <memory/pool_allocator.h>
+#include <memory/slab_allocator.h>
+#include <platform/platform.h>
+
+#include <stdlib.h>  // qsort
+
+// The most threads a threaded run may use.
+#define BENCHMARK_MAX_THREADS 16
+
+// The block size used for pool allocator runs.
+#define BENCHMARK_POOL_BLOCK_SIZE 256
+
+typedef struct benchmark_allocator {
+    const char* name;
+    // The largest allocation supported, or 0 for any size.
+    u64 max_size;
+    // Indicates if the allocator can be shared between threads without a lock.
+    b8 thread_safe;
+    b8 (*create)(struct benchmark_allocator* self, const allocation_trace* trace, u32 thread_count);
+    void (*destroy)(struct benchmark_allocator* self);
+    void* (*allocate)(struct benchmark_allocator* self, u64 size);
+    void (*free)(struct benchmark_allocator* self, void* block, u64 size);
+    // Optional.
+    f32 (*fragmentation)(struct benchmark_allocator* self);
+
+    void* memory;
+    u64 memory_size;
+    dynamic_allocator dynamic;
+    freelist list;
+    pool_allocator pool;
+    slab_allocator slab;
+    // Set for threaded runs of allocators which are not thread safe.
+    b8 locked;
+    kmutex lock;
+} benchmark_allocator;
+
+typedef struct benchmark_result {
+    f64 elapsed;
+    u64 op_count;
+    u64 failed_count;
+    // Sorted, in seconds. Only set for timed runs.
+    f64* latencies;
+    f32 fragmentation;
+    b8 has_fragmentation;
+} benchmark_result;
+
+// Enough for every allocation of the trace on every thread, plus per-allocation overhead, with room to fragment.
+static u64 heap_capacity(const allocation_trace* trace, u32 thread_count) {
+    return ((trace->peak_live_size + (u64)trace->slot_count * 64) * 2 + MEBIBYTES(1)) * thread_count;
+}
+
+static b8 backing_allocate(benchmark_allocator* self, u64 size) {
+    self->memory_size = size;
+    self->memory = kallocate(size, MEMORY_TAG_APPLICATION);
+    return self->memory != 0;
+}
+
+static void backing_free(benchmark_allocator* self) {
+    kfree(self->memory, self->memory_size, MEMORY_TAG_APPLICATION);
+    self->memory = 0;
+    self->memory_size = 0;
+}
+
+// kmemory
+
+static b8 kmemory_create(benchmark_allocator* self, const allocation_trace* trace, u32 thread_count) {
+    return true;
+}
+
+static void kmemory_destroy(benchmark_allocator* self) {
+    kmemory_thread_cache_flush();
+}
+
+static void* kmemory_allocate(benchmark_allocator* self, u64 size) {
+    // NOTE: kallocate also zeroes the memory, which the other allocators do not.
+    return kallocate(size, MEMORY_TAG_APPLICATION);
+}
+
+static void kmemory_free(benchmark_allocator* self, void* block, u64 size) {
+    kfree(block, size, MEMORY_TAG_APPLICATION);
+}
+
+// dynamic_allocator
+
+static b8 dynamic_create(benchmark_allocator* self, const allocation_trace* trace, u32 thread_count) {
+    u64 capacity = heap_capacity(trace, thread_count);
+    u64 memory_requirement = 0;
+    dynamic_allocator_create(capacity, &memory_requirement, 0, 0);
+    return backing_allocate(self, memory_requirement) && dynamic_allocator_create(capacity, &memory_requirement, self->memory, &self->dynamic);
+}
+
+static void dynamic_destroy(benchmark_allocator* self) {
+    dynamic_allocator_destroy(&self->dynamic);
+    backing_free(self);
+}
+
+static void* dynamic_allocate(benchmark_allocator* self, u64 size) {
+    return dynamic_allocator_allocate(&self->dynamic, size);
+}
+
+static void dynamic_free(benchmark_allocator* self, void* block, u64 size) {
+    dynamic_allocator_free(&self->dynamic, block, size);
+}
+
+static f32 dynamic_fragmentation(benchmark_allocator* self) {
+    return dynamic_allocator_fragmentation(&self->dynamic);
+}
+
+// freelist. Offsets are handed out as pointers, offset by one so that 0 still means failure.
+
+static b8 freelist_bench_create(benchmark_allocator* self, freelist_mode mode, const allocation_trace* trace, u32 thread_count) {
+    u64 capacity = heap_capacity(trace, thread_count);
+    u64 memory_requirement = 0;
+    freelist_create_with_mode(capacity, mode, &memory_requirement, 0, 0);
+    if (!backing_allocate(self, memory_requirement)) {
+        return false;
+    }
+    freelist_create_with_mode(capacity, mode, &memory_requirement, self->memory, &self->list);
+    return true;
+}
+
+static b8 first_fit_create(benchmark_allocator* self, const allocation_trace* trace, u32 thread_count) {
+    return freelist_bench_create(self, FREELIST_MODE_FIRST_FIT, trace, thread_count);
+}
+
+static b8 segregated_create(benchmark_allocator* self, const allocation_trace* trace, u32 thread_count) {
+    return freelist_bench_create(self, FREELIST_MODE_SEGREGATED_FIT, trace, thread_count);
+}
+
+static void freelist_bench_destroy(benchmark_allocator* self) {
+    freelist_destroy(&self->list);
+    backing_free(self);
+}
+
+static void* freelist_bench_allocate(benchmark_allocator* self, u64 size) {
+    u64 offset = 0;
+    return freelist_allocate_block(&self->list, size, &offset) ? (void*)(offset + 1) : 0;
+}
+
+static void freelist_bench_free(benchmark_allocator* self, void* block, u64 size) {
+    freelist_free_block(&self->list, size, (u64)block - 1);
+}
+
+static f32 freelist_bench_fragmentation(benchmark_allocator* self) {
+    return freelist_fragmentation(&self->list);
+}
+
+// pool_allocator
+
+static b8 pool_create(benchmark_allocator* self, const allocation_trace* trace, u32 thread_count) {
+    u32 block_count = trace->slot_count * thread_count;
+    u64 memory_requirement = 0;
+    pool_allocator_create(BENCHMARK_POOL_BLOCK_SIZE, 16, block_count, &memory_requirement, 0, 0);
+    return backing_allocate(self, memory_requirement) && pool_allocator_create(BENCHMARK_POOL_BLOCK_SIZE, 16, block_count, &memory_requirement, self->memory, &self->pool);
+}
+
+static void pool_destroy(benchmark_allocator* self) {
+    pool_allocator_destroy(&self->pool);
+    backing_free(self);
+}
+
+static void* pool_allocate(benchmark_allocator* self, u64 size) {
+    return pool_allocator_allocate(&self->pool);
+}
+
+static void pool_free(benchmark_allocator* self, void* block, u64 size) {
+    pool_allocator_free(&self->pool, block);
+}
+
+// slab_allocator
+
+static b8 slab_create(benchmark_allocator* self, const allocation_trace* trace, u32 thread_count) {
+    // Every allocation may be rounded up to nearly twice its size, and each class needs slabs of its own.
+    u64 capacity = heap_capacity(trace, thread_count) + SLAB_ALLOCATOR_SLAB_SIZE * SLAB_ALLOCATOR_CLASS_COUNT * 2;
+    u64 memory_requirement = 0;
+    slab_allocator_create(capacity, &memory_requirement, 0, 0);
+    return backing_allocate(self, memory_requirement) && slab_allocator_create(capacity, &memory_requirement, self->memory, &self->slab);
+}
+
+static void slab_destroy(benchmark_allocator* self) {
+    slab_allocator_destroy(&self->slab);
+    backing_free(self);
+}
+
+static void* slab_allocate(benchmark_allocator* self, u64 size) {
+    return slab_allocator_allocate(&self->slab, size);
+}
+
+static void slab_free(benchmark_allocator* self, void* block, u64 size) {
+    slab_allocator_free(&self->slab, block);
+}
+
+static benchmark_allocator allocators[] = {
+    {"kmemory", 0, true, kmemory_create, kmemory_destroy, kmemory_allocate, kmemory_free, 0},
+    {"dynamic_allocator", 0, false, dynamic_create, dynamic_destroy, dynamic_allocate, dynamic_free, dynamic_fragmentation},
+    {"freelist (first fit)", 0, false, first_fit_create, freelist_bench_destroy, freelist_bench_allocate, freelist_bench_free, freelist_bench_fragmentation},
+    {"freelist (segregated)", 0, false, segregated_create, freelist_bench_destroy, freelist_bench_allocate, freelist_bench_free, freelist_bench_fragmentation},
+    {"pool_allocator", BENCHMARK_POOL_BLOCK_SIZE, false, pool_create, pool_destroy, pool_allocate, pool_free, 0},
+    {"slab_allocator", SLAB_ALLOCATOR_MAX_BLOCK_SIZE, false, slab_create, slab_destroy, slab_allocate, slab_free, 0},
+};
+
+static void* bench_allocate(benchmark_allocator* a, u64 size) {
+    if (!a->locked) {
+        return a->allocate(a, size);
+    }
+    kmutex_lock(&a->lock);
+    void* block = a->allocate(a, size);
+    kmutex_unlock(&a->lock);
+    return block;
+}
+
+static void bench_free(benchmark_allocator* a, void* block, u64 size) {
+    if (!a->locked) {
+        a->free(a, block, size);
+        return;
+    }
+    kmutex_lock(&a->lock);
+    a->free(a, block, size);
+    kmutex_unlock(&a->lock);
+}
+
+/**
+ * Replays the trace once. If latencies is given, each operation is timed into it. Otherwise,
+ * fragmentation is sampled when the peak amount of memory is live, if supported and requested.
+ */
+static void replay(benchmark_allocator* a, const allocation_trace* trace, void** slots, u64* slot_sizes, f64* latencies, b8 sample_fragmentation, benchmark_result* result) {
+    u64 live_size = 0;
+    u64 failed_count = 0;
+    f64 start = platform_get_absolute_time();
+    for (u32 i = 0; i < trace->op_count; ++i) {
+        const allocation_op* op = &trace->ops[i];
+        f64 op_start = latencies ? platform_get_absolute_time() : 0;
+        if (op->type == ALLOCATION_OP_ALLOCATE) {
+            slots[op->slot] = bench_allocate(a, op->size);
+            slot_sizes[op->slot] = op->size;
+            if (!slots[op->slot]) {
+                failed_count++;
+            }
+        } else if (slots[op->slot]) {
+            bench_free(a, slots[op->slot], slot_sizes[op->slot]);
+            slots[op->slot] = 0;
+        }
+        if (latencies) {
+            latencies[i] = platform_get_absolute_time() - op_start;
+        } else if (sample_fragmentation) {
+            // Tracking the live size is cheap next to the operations themselves.
+            live_size = op->type == ALLOCATION_OP_ALLOCATE ? live_size + op->size : live_size - slot_sizes[op->slot];
+            if (live_size == trace->peak_live_size && !result->has_fragmentation) {
+                result->fragmentation = a->fragmentation(a);
+                result->has_fragmentation = true;
+            }
+        }
+    }
+    result->elapsed = platform_get_absolute_time() - start;
+    result->op_count = trace->op_count;
+    result->failed_count = failed_count;
+}
+
+static i32 compare_latencies(const void* a, const void* b) {
+    f64 x = *(const f64*)a;
+    f64 y = *(const f64*)b;
+    return (x > y) - (x < y);
+}
+
+static f64 percentile(const f64* sorted, u64 count, f64 fraction) {
+    u64 index = (u64)(fraction * (f64)(count - 1));
+    return sorted[index];
+}
+
+static void report(const benchmark_allocator* a, const benchmark_result* throughput, const f64* sorted_latencies, u64 latency_count) {
+    f64 mops = throughput->elapsed > 0 ? (f64)throughput->op_count / throughput->elapsed / 1000000.0 : 0;
+    const f64 ns = 1000000000.0;
+    char fragmentation[16] = "n/a";
+    if (throughput->has_fragmentation) {
+        string_format(fragmentation, "%.3f", throughput->fragmentation);
+    }
+    KINFO("  %-22s %8.2f Mops/s | p50 %6.0fns p90 %6.0fns p99 %7.0fns p99.9 %8.0fns max %9.0fns | frag %s",
+          a->name,
+          mops,
+          percentile(sorted_latencies, latency_count, 0.5) * ns,
+          percentile(sorted_latencies, latency_count, 0.9) * ns,
+          percentile(sorted_latencies, latency_count, 0.99) * ns,
+          percentile(sorted_latencies, latency_count, 0.999) * ns,
+          sorted_latencies[latency_count - 1] * ns,
+          fragmentation);
+    if (throughput->failed_count) {
+        KWARN("  %-22s %llu allocations failed.", a->name, throughput->failed_count);
+    }
+}
+
+static b8 supports(const benchmark_allocator* a, const allocation_trace* trace) {
+    return !a->max_size || trace->max_size <= a->max_size;
+}
+
+void allocator_benchmarks_run(const allocation_trace* trace) {
+    KINFO("Trace '%s': %u ops, %u slots, peak %llu bytes live, single thread", trace->name, trace->op_count, trace->slot_count, trace->peak_live_size);
+    void** slots = kallocate(sizeof(void*) * trace->slot_count, MEMORY_TAG_ARRAY);
+    u64* slot_sizes = kallocate(sizeof(u64) * trace->slot_count, MEMORY_TAG_ARRAY);
+    f64* latencies = kallocate(sizeof(f64) * trace->op_count, MEMORY_TAG_ARRAY);
+
+    u32 allocator_count = sizeof(allocators) / sizeof(allocators[0]);
+    for (u32 i = 0; i < allocator_count; ++i) {
+        benchmark_allocator* a = &allocators[i];
+        if (!supports(a, trace)) {
+            KINFO("  %-22s skipped, as it only supports allocations up to %llu bytes.", a->name, a->max_size);
+            continue;
+        }
+        if (!a->create(a, trace, 1)) {
+            KERROR("  %-22s could not be created.", a->name);
+            continue;
+        }
+        a->locked = false;
+
+        // A warm-up pass, so that the timed passes can't be skewed by first touching memory.
+        benchmark_result throughput = {0};
+        replay(a, trace, slots, slot_sizes, 0, false, &throughput);
+        throughput = (benchmark_result){0};
+        replay(a, trace, slots, slot_sizes, 0, a->fragmentation != 0, &throughput);
+        benchmark_result timed = {0};
+        replay(a, trace, slots, slot_sizes, latencies, false, &timed);
+        qsort(latencies, trace->op_count, sizeof(f64), compare_latencies);
+        report(a, &throughput, latencies, trace->op_count);
+
+        a->destroy(a);
+    }
+
+    kfree(latencies, sizeof(f64) * trace->op_count, MEMORY_TAG_ARRAY);
+    kfree(slot_sizes, sizeof(u64) * trace->slot_count, MEMORY_TAG_ARRAY);
+    kfree(slots, sizeof(void*) * trace->slot_count, MEMORY_TAG_ARRAY);
+}
+
+typedef struct benchmark_thread {
+    kthread thread;
+    benchmark_allocator* allocator;
+    const allocation_trace* trace;
+    // Shared between all threads.
+    volatile u32* start_flag;
+    volatile u32* finished_count;
+    void** slots;
+    u64* slot_sizes;
+    // Set for the timed pass only.
+    f64* latencies;
+    benchmark_result result;
+} benchmark_thread;
+
+static u32 benchmark_thread_run(void* params) {
+    benchmark_thread* thread = params;
+    while (!katomic_load_acquire(thread->start_flag)) {
+    }
+    replay(thread->allocator, thread->trace, thread->slots, thread->slot_sizes, thread->latencies, false, &thread->result);
+    if (thread->allocator->allocate == kmemory_allocate) {
+        // Hand back anything cached on this thread before it exits.
+        kmemory_thread_cache_flush();
+    }
+    katomic_fetch_add(thread->finished_count, 1);
+    return 0;
+}
+
+// Runs one pass of the trace on every thread at once, returning the wall time taken.
+static f64 run_threads(benchmark_thread* threads, u32 thread_count, b8 timed) {
+    volatile u32 start_flag = 0;
+    volatile u32 finished_count = 0;
+    for (u32 i = 0; i < thread_count; ++i) {
+        threads[i].start_flag = &start_flag;
+        threads[i].finished_count = &finished_count;
+        threads[i].result = (benchmark_result){0};
+        void* latencies = threads[i].latencies;
+        if (!timed) {
+            threads[i].latencies = 0;
+        }
+        if (!kthread_create(benchmark_thread_run, &threads[i], true, &threads[i].thread)) {
+            KFATAL("Unable to create benchmark thread.");
+            return 0;
+        }
+        threads[i].latencies = latencies;
+    }
+    f64 start = platform_get_absolute_time();
+    katomic_store_release(&start_flag, 1);
+    while (katomic_load_acquire(&finished_count) < thread_count) {
+    }
+    return platform_get_absolute_time() - start;
+}
+
+void allocator_benchmarks_run_threaded(const allocation_trace* trace, u32 thread_count) {
+    thread_count = KMAX(thread_count, 2);
+    thread_count = KMIN(thread_count, BENCHMARK_MAX_THREADS);
+    KINFO("Trace '%s': %u ops, %u slots, peak %llu bytes live, %u threads", trace->name, trace->op_count, trace->slot_count, trace->peak_live_size, thread_count);
+
+    benchmark_thread threads[BENCHMARK_MAX_THREADS];
+    u64 latency_count = (u64)trace->op_count * thread_count;
+    f64* latencies = kallocate(sizeof(f64) * latency_count, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < thread_count; ++i) {
+        threads[i].trace = trace;
+        threads[i].slots = kallocate(sizeof(void*) * trace->slot_count, MEMORY_TAG_ARRAY);
+        threads[i].slot_sizes = kallocate(sizeof(u64) * trace->slot_count, MEMORY_TAG_ARRAY);
+        threads[i].latencies = latencies + (u64)trace->op_count * i;
+    }
+
+    u32 allocator_count = sizeof(allocators) / sizeof(allocators[0]);
+    for (u32 i = 0; i < allocator_count; ++i) {
+        benchmark_allocator* a = &allocators[i];
+        if (!supports(a, trace)) {
+            continue;
+        }
+        if (!a->create(a, trace, thread_count)) {
+            KERROR("  %-22s could not be created.", a->name);
+            continue;
+        }
+        a->locked = !a->thread_safe;
+        if (a->locked) {
+            kmutex_create(&a->lock);
+        }
+        for (u32 t = 0; t < thread_count; ++t) {
+            threads[t].allocator = a;
+        }
+
+        // Warm up, then measure throughput and latencies in separate passes.
+        run_threads(threads, thread_count, false);
+        benchmark_result throughput = {0};
+        throughput.elapsed = run_threads(threads, thread_count, false);
+        throughput.op_count = latency_count;
+        for (u32 t = 0; t < thread_count; ++t) {
+            throughput.failed_count += threads[t].result.failed_count;
+        }
+        run_threads(threads, thread_count, true);
+        qsort(latencies, latency_count, sizeof(f64), compare_latencies);
+        report(a, &throughput, latencies, latency_count);
+
+        if (a->locked) {
+            kmutex_destroy(&a->lock);
+            a->locked = false;
+        }
+        a->destroy(a);
+    }
+
+    for (u32 i = 0; i < thread_count; ++i) {
+        kfree(threads[i].slots, sizeof(void*) * trace->slot_count, MEMORY_TAG_ARRAY);
+        kfree(threads[i].slot_sizes, sizeof(u64) * trace->slot_count, MEMORY_TAG_ARRAY);
+    }
+    kfree(latencies, sizeof(f64) * latency_count, MEMORY_TAG_ARRAY);
+}
@@ -0,0 +1,36 @@
+/**
+ * @file allocator_benchmarks.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Replays allocation traces against the engine's allocators, and reports on them.
+ * @details Each trace is replayed twice per allocator: once untimed per operation to measure
+ * throughput, and once timing every operation to obtain latency percentiles. Fragmentation is
+ * sampled where supported at the point the most memory is live. Multithreaded runs replay the
+ * trace on several threads at once against a single allocator. Allocators which are not
+ * thread safe are guarded by a mutex for these, which is what sharing them would require.
+ * @version 1.0
+ *
+ * 
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ * 
+ */
+
+#pragma once
+
+#include "allocation_trace.h"
+
+/**
+ * @brief Runs the trace against every allocator that supports its allocation sizes on a single
+ * thread, logging the results.
+ *
+ * @param trace A pointer to the trace to run.
+ */
+void allocator_benchmarks_run(const allocation_trace* trace);
+
+/**
+ * @brief Runs the trace against every allocator that supports its allocation sizes on the given
+ * number of threads at once, logging the results.
+ *
+ * @param trace A pointer to the trace to run.
+ * @param thread_count The number of threads to replay the trace on.
+ */
+void allocator_benchmarks_run_threaded(const allocation_trace* trace, u32 thread_count);
@@ -0,0 +1,502 @@
+#include "container_benchmarks.h"
+
+#include <containers/bitset.h>
+#include <containers/darray.h>
+#include <containers/flat_map.h>
+#include <containers/freelist.h>
+#include <containers/hashtable.h>
+#include <containers/mpmc_queue.h>
+#include <containers/ring_queue.h>
+#include <containers/slot_map.h>
+#include <containers/spsc_queue.h>
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <core/logger.h>
+#include <platform/filesystem.h>
+#include <platform/platform.h>
+
+// The sizes every container is benchmarked at.
+static const u32 benchmark_sizes[] = {100, 10000, 1000000};
+#define BENCHMARK_SIZE_COUNT (sizeof(benchmark_sizes) / sizeof(benchmark_sizes[0]))
+
+// Smaller sizes are repeated until at least this many operations are timed.
+#define BENCHMARK_MIN_OPS 1000000
+
+// Containers whose operations cost O(n) each are only run up to this size: flat map inserts and
+// removes shift entries, first-fit frees walk the list, and hashtable entries each hold a copy of
+// their name from the engine's allocator, which is itself a first-fit list.
+#define BENCHMARK_LINEAR_MAX_SIZE 100000
+
+// The longest key used for hashtable runs, including the terminator.
+#define BENCHMARK_KEY_LENGTH 16
+
+typedef struct benchmark_context {
+    file_handle csv;
+    b8 has_csv;
+    b8 write_failed;
+    // Shuffled 0..size-1, used to visit keys and indices in a fixed random order.
+    u32* order;
+    // A null-terminated string per index, for hashtable runs.
+    char* keys;
+    u64 rng;
+} benchmark_context;
+
+// Written to so that the compiler can't drop the work being timed.
+static volatile u64 benchmark_sink;
+
+static u64 rng_next(u64* state) {
+    // xorshift64*, so that runs visit the same order on every platform.
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+static void shuffle_order(benchmark_context* context, u32 size) {
+    for (u32 i = 0; i < size; ++i) {
+        context->order[i] = i;
+    }
+    for (u32 i = size - 1; i > 0; --i) {
+        u32 j = (u32)(rng_next(&context->rng) % (i + 1));
+        u32 temp = context->order[i];
+        context->order[i] = context->order[j];
+        context->order[j] = temp;
+    }
+}
+
+static u32 repeat_count(u32 size) {
+    return size >= BENCHMARK_MIN_OPS ? 1 : BENCHMARK_MIN_OPS / size;
+}
+
+static void report(benchmark_context* context, const char* container, const char* operation, u32 size, u64 op_count, f64 elapsed) {
+    f64 total_ns = elapsed * 1000000000.0;
+    f64 ns_per_op = op_count ? total_ns / (f64)op_count : 0;
+    KINFO("  %-12s %-8s size %8u: %10llu ops %8.2f ns/op", container, operation, size, op_count, ns_per_op);
+    if (context->has_csv) {
+        char line[256];
+        string_format(line, "%s,%s,%u,%llu,%.0f,%.3f", container, operation, size, op_count, total_ns, ns_per_op);
+        if (!filesystem_write_line(&context->csv, line)) {
+            context->write_failed = true;
+        }
+    }
+}
+
+static const char* key_at(const benchmark_context* context, u32 index) {
+    return context->keys + (u64)index * BENCHMARK_KEY_LENGTH;
+}
+
+static void benchmark_darray(benchmark_context* context, u32 size) {
+    u32 repeats = repeat_count(size);
+    f64 insert = 0, lookup = 0, iterate = 0, remove = 0;
+    for (u32 r = 0; r < repeats; ++r) {
+        u64* array = darray_create(u64);
+
+        f64 start = platform_get_absolute_time();
+        for (u64 i = 0; i < size; ++i) {
+            darray_push(array, i);
+        }
+        insert += platform_get_absolute_time() - start;
+
+        start = platform_get_absolute_time();
+        u64 sum = 0;
+        for (u32 i = 0; i < size; ++i) {
+            sum += array[context->order[i]];
+        }
+        lookup += platform_get_absolute_time() - start;
+
+        start = platform_get_absolute_time();
+        u64 length = darray_length(array);
+        for (u64 i = 0; i < length; ++i) {
+            sum += array[i];
+        }
+        iterate += platform_get_absolute_time() - start;
+
+        start = platform_get_absolute_time();
+        u64 value;
+        for (u32 i = 0; i < size; ++i) {
+            darray_pop(array, &value);
+            sum += value;
+        }
+        remove += platform_get_absolute_time() - start;
+
+        benchmark_sink = sum;
+        darray_destroy(array);
+    }
+
+    u64 op_count = (u64)size * repeats;
+    report(context, "darray", "insert", size, op_count, insert);
+    report(context, "darray", "lookup", size, op_count, lookup);
+    report(context, "darray", "iterate", size, op_count, iterate);
+    report(context, "darray", "remove", size, op_count, remove);
+}
+
+static void benchmark_hashtable(benchmark_context* context, u32 size) {
+    if (size > BENCHMARK_LINEAR_MAX_SIZE) {
+        return;
+    }
+    u32 repeats = repeat_count(size);
+    f64 insert = 0, lookup = 0, remove = 0;
+    for (u32 r = 0; r < repeats; ++r) {
+        hashtable table;
+        hashtable_create_with_mode(sizeof(u64), 1, HASHTABLE_MODE_OPEN_ADDRESSING, 0, false, &table);
+
+        f64 start = platform_get_absolute_time();
+        for (u64 i = 0; i < size; ++i) {
+            hashtable_set(&table, key_at(context, (u32)i), &i);
+        }
+        insert += platform_get_absolute_time() - start;
+
+        start = platform_get_absolute_time();
+        u64 sum = 0;
+        u64 value;
+        for (u32 i = 0; i < size; ++i) {
+            if (hashtable_get(&table, key_at(context, context->order[i]), &value)) {
+                sum += value;
+            }
+        }
+        lookup += platform_get_absolute_time() - start;
+
+        start = platform_get_absolute_time();
+        for (u32 i = 0; i < size; ++i) {
+            sum += hashtable_remove(&table, key_at(context, context->order[i]));
+        }
+        remove += platform_get_absolute_time() - start;
+
+        benchmark_sink = sum;
+        hashtable_destroy(&table);
+    }
+
+    // There is no way to iterate a hashtable, so that is not measured.
+    u64 op_count = (u64)size * repeats;
+    report(context, "hashtable", "insert", size, op_count, insert);
+    report(context, "hashtable", "lookup", size, op_count, lookup);
+    report(context, "hashtable", "remove", size, op_count, remove);
+}
+
+static void benchmark_freelist(benchmark_context* context, u32 size, freelist_mode mode, const char* name) {
+    if (mode == FREELIST_MODE_FIRST_FIT && size > BENCHMARK_LINEAR_MAX_SIZE) {
+        return;
+    }
+    // Blocks of 16-256 bytes, in a list with room for all of them plus slack.
+    u64 total_size = (u64)size * 256 * 2;
+    u64* offsets = kallocate(sizeof(u64) * size, MEMORY_TAG_APPLICATION);
+    u64* sizes = kallocate(sizeof(u64) * size, MEMORY_TAG_APPLICATION);
+    for (u32 i = 0; i < size; ++i) {
+        sizes[i] = 16 + (rng_next(&context->rng) % 16) * 16;
+    }
+
+    u64 memory_requirement = 0;
+    freelist_create_with_mode(total_size, mode, &memory_requirement, 0, 0);
+    void* memory = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+
+    u32 repeats = repeat_count(size);
+    f64 insert = 0, remove = 0;
+    u64 failed = 0;
+    for (u32 r = 0; r < repeats; ++r) {
+        freelist list;
+        freelist_create_with_mode(total_size, mode, &memory_requirement, memory, &list);
+
+        f64 start = platform_get_absolute_time();
+        for (u32 i = 0; i < size; ++i) {
+            if (!freelist_allocate_block(&list, sizes[i], &offsets[i])) {
+                offsets[i] = INVALID_ID_U64;
+                failed++;
+            }
+        }
+        insert += platform_get_absolute_time() - start;
+
+        // Free in random order, so that coalescing is exercised.
+        start = platform_get_absolute_time();
+        for (u32 i = 0; i < size; ++i) {
+            u32 index = context->order[i];
+            if (offsets[index] != INVALID_ID_U64) {
+                freelist_free_block(&list, sizes[index], offsets[index]);
+            }
+        }
+        remove += platform_get_absolute_time() - start;
+
+        freelist_destroy(&list);
+    }
+    if (failed) {
+        KWARN("  %s failed %llu allocations.", name, failed);
+    }
+
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+    kfree(offsets, sizeof(u64) * size, MEMORY_TAG_APPLICATION);
+    kfree(sizes, sizeof(u64) * size, MEMORY_TAG_APPLICATION);
+
+    u64 op_count = (u64)size * repeats;
+    report(context, name, "insert", size, op_count, insert);
+    report(context, name, "remove", size, op_count, remove);
+}
+
+static void benchmark_ring_queue(benchmark_context* context, u32 size) {
+    ring_queue queue;
+    ring_queue_create(sizeof(u64), size, 0, &queue);
+
+    u32 repeats = repeat_count(size);
+    f64 insert = 0, remove = 0;
+    u64 sum = 0;
+    for (u32 r = 0; r < repeats; ++r) {
+        f64 start = platform_get_absolute_time();
+        for (u64 i = 0; i < size; ++i) {
+            ring_queue_enqueue(&queue, &i);
+        }
+        insert += platform_get_absolute_time() - start;
+
+        start = platform_get_absolute_time();
+        u64 value;
+        for (u32 i = 0; i < size; ++i) {
+            ring_queue_dequeue(&queue, &value);
+            sum += value;
+        }
+        remove += platform_get_absolute_time() - start;
+    }
+    benchmark_sink = sum;
+    ring_queue_destroy(&queue);
+
+    u64 op_count = (u64)size * repeats;
+    report(context, "ring_queue", "insert", size, op_count, insert);
+    report(context, "ring_queue", "remove", size, op_count, remove);
+}
+
+static void benchmark_lockfree_queues(benchmark_context* context, u32 size) {
+    // Queues are a power of 2, so round up.
+    u32 capacity = 1;
+    while (capacity < size) {
+        capacity *= 2;
+    }
+    spsc_queue spsc;
+    mpmc_queue mpmc;
+    spsc_queue_create(sizeof(u64), capacity, 0, &spsc);
+    mpmc_queue_create(sizeof(u64), capacity, 0, &mpmc);
+
+    // Uncontended, to measure the cost of the operations themselves.
+    u32 repeats = repeat_count(size);
+    f64 spsc_insert = 0, spsc_remove = 0, mpmc_insert = 0, mpmc_remove = 0;
+    u64 sum = 0;
+    u64 value;
+    for (u32 r = 0; r < repeats; ++r) {
+        f64 start = platform_get_absolute_time();
+        for (u64 i = 0; i < size; ++i) {
+            spsc_queue_try_push(&spsc, &i);
+        }
+        spsc_insert += platform_get_absolute_time() - start;
+
+        start = platform_get_absolute_time();
+        for (u32 i = 0; i < size; ++i) {
+            spsc_queue_try_pop(&spsc, &value);
+            sum += value;
+        }
+        spsc_remove += platform_get_absolute_time() - start;
+
+        start = platform_get_absolute_time();
+        for (u64 i = 0; i < size; ++i) {
+            mpmc_queue_try_push(&mpmc, &i);
+        }
+        mpmc_insert += platform_get_absolute_time() - start;
+
+        start = platform_get_absolute_time();
+        for (u32 i = 0; i < size; ++i) {
+            mpmc_queue_try_pop(&mpmc, &value);
+            sum += value;
+        }
+        mpmc_remove += platform_get_absolute_time() - start;
+    }
+    benchmark_sink = sum;
+    spsc_queue_destroy(&spsc);
+    mpmc_queue_destroy(&mpmc);
+
+    u64 op_count = (u64)size * repeats;
+    report(context, "spsc_queue", "insert", size, op_count, spsc_insert);
+    report(context, "spsc_queue", "remove", size, op_count, spsc_remove);
+    report(context, "mpmc_queue", "insert", size, op_count, mpmc_insert);
+    report(context, "mpmc_queue", "remove", size, op_count, mpmc_remove);
+}
+
+static void benchmark_slot_map(benchmark_context* context, u32 size) {
+    u64 memory_requirement = 0;
+    slot_map_create(sizeof(u64), size, &memory_requirement, 0, 0);
+    void* memory = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    slot_handle* handles = kallocate(sizeof(slot_handle) * size, MEMORY_TAG_APPLICATION);
+
+    u32 repeats = repeat_count(size);
+    f64 insert = 0, lookup = 0, iterate = 0, remove = 0;
+    u64 sum = 0;
+    for (u32 r = 0; r < repeats; ++r) {
+        slot_map map;
+        slot_map_create(sizeof(u64), size, &memory_requirement, memory, &map);
+
+        f64 start = platform_get_absolute_time();
+        for (u64 i = 0; i < size; ++i) {
+            handles[i] = slot_map_insert(&map, &i);
+        }
+        insert += platform_get_absolute_time() - start;
+
+        start = platform_get_absolute_time();
+        for (u32 i = 0; i < size; ++i) {
+            sum += *(u64*)slot_map_get(&map, handles[context->order[i]]);
+        }
+        lookup += platform_get_absolute_time() - start;
+
+        start = platform_get_absolute_time();
+        for (u32 i = 0; i < map.count; ++i) {
+            sum += *(u64*)slot_map_element_at(&map, i);
+        }
+        iterate += platform_get_absolute_time() - start;
+
+        start = platform_get_absolute_time();
+        for (u32 i = 0; i < size; ++i) {
+            sum += slot_map_remove(&map, handles[context->order[i]]);
+        }
+        remove += platform_get_absolute_time() - start;
+
+        slot_map_destroy(&map);
+    }
+    benchmark_sink = sum;
+    kfree(handles, sizeof(slot_handle) * size, MEMORY_TAG_APPLICATION);
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+
+    u64 op_count = (u64)size * repeats;
+    report(context, "slot_map", "insert", size, op_count, insert);
+    report(context, "slot_map", "lookup", size, op_count, lookup);
+    report(context, "slot_map", "iterate", size, op_count, iterate);
+    report(context, "slot_map", "remove", size, op_count, remove);
+}
+
+static void benchmark_flat_map(benchmark_context* context, u32 size) {
+    if (size > BENCHMARK_LINEAR_MAX_SIZE) {
+        return;
+    }
+
+    u32 repeats = repeat_count(size);
+    f64 insert = 0, lookup = 0, iterate = 0, remove = 0;
+    u64 sum = 0;
+    for (u32 r = 0; r < repeats; ++r) {
+        flat_map map;
+        flat_map_create(sizeof(u64), 0, &map);
+
+        f64 start = platform_get_absolute_time();
+        for (u32 i = 0; i < size; ++i) {
+            u64 key = context->order[i];
+            flat_map_set(&map, key, &key);
+        }
+        insert += platform_get_absolute_time() - start;
+
+        start = platform_get_absolute_time();
+        for (u32 i = 0; i < size; ++i) {
+            sum += *(u64*)flat_map_get(&map, context->order[size - 1 - i]);
+        }
+        lookup += platform_get_absolute_time() - start;
+
+        start = platform_get_absolute_time();
+        for (u32 i = 0; i < map.count; ++i) {
+            sum += *(u64*)flat_map_value_at(&map, i);
+        }
+        iterate += platform_get_absolute_time() - start;
+
+        start = platform_get_absolute_time();
+        for (u32 i = 0; i < size; ++i) {
+            sum += flat_map_remove(&map, context->order[i], 0);
+        }
+        remove += platform_get_absolute_time() - start;
+
+        flat_map_destroy(&map);
+    }
+    benchmark_sink = sum;
+
+    u64 op_count = (u64)size * repeats;
+    report(context, "flat_map", "insert", size, op_count, insert);
+    report(context, "flat_map", "lookup", size, op_count, lookup);
+    report(context, "flat_map", "iterate", size, op_count, iterate);
+    report(context, "flat_map", "remove", size, op_count, remove);
+}
+
+static void benchmark_bitset(benchmark_context* context, u32 size) {
+    bitset set;
+    bitset_create(size, 0, &set);
+
+    // Only every other index is set, so that iteration has gaps to skip.
+    u32 half = size / 2;
+    u32 repeats = repeat_count(size);
+    f64 insert = 0, lookup = 0, iterate = 0, remove = 0;
+    u64 sum = 0;
+    for (u32 r = 0; r < repeats; ++r) {
+        f64 start = platform_get_absolute_time();
+        for (u32 i = 0; i < half; ++i) {
+            bitset_set(&set, context->order[i]);
+        }
+        insert += platform_get_absolute_time() - start;
+
+        start = platform_get_absolute_time();
+        for (u32 i = 0; i < size; ++i) {
+            sum += bitset_test(&set, context->order[i]);
+        }
+        lookup += platform_get_absolute_time() - start;
+
+        start = platform_get_absolute_time();
+        for (u32 i = bitset_find_first_set(&set, 0); i != INVALID_ID; i = bitset_find_first_set(&set, i + 1)) {
+            sum += i;
+        }
+        iterate += platform_get_absolute_time() - start;
+
+        start = platform_get_absolute_time();
+        bitset_clear_all(&set);
+        remove += platform_get_absolute_time() - start;
+    }
+    benchmark_sink = sum;
+    bitset_destroy(&set);
+
+    // Iteration and clearing are reported per bit held, as that is what they scale with.
+    u64 op_count = (u64)size * repeats;
+    report(context, "bitset", "insert", size, (u64)half * repeats, insert);
+    report(context, "bitset", "lookup", size, op_count, lookup);
+    report(context, "bitset", "iterate", size, op_count, iterate);
+    report(context, "bitset", "remove", size, op_count, remove);
+}
+
+b8 container_benchmarks_run(const char* csv_path) {
+    benchmark_context context = {0};
+    context.rng = 0x2468ace;
+    if (csv_path) {
+        if (!filesystem_open(csv_path, FILE_MODE_WRITE, false, &context.csv)) {
+            KERROR("Unable to open '%s' to write container benchmark results.", csv_path);
+            return false;
+        }
+        context.has_csv = true;
+        filesystem_write_line(&context.csv, "container,operation,size,op_count,total_ns,ns_per_op");
+    }
+
+    u32 max_size = benchmark_sizes[BENCHMARK_SIZE_COUNT - 1];
+    context.order = kallocate(sizeof(u32) * max_size, MEMORY_TAG_APPLICATION);
+    context.keys = kallocate((u64)BENCHMARK_KEY_LENGTH * max_size, MEMORY_TAG_APPLICATION);
+    for (u32 i = 0; i < max_size; ++i) {
+        string_format(context.keys + (u64)i * BENCHMARK_KEY_LENGTH, "key_%u", i);
+    }
+
+    for (u32 s = 0; s < BENCHMARK_SIZE_COUNT; ++s) {
+        u32 size = benchmark_sizes[s];
+        KINFO("Containers, %u elements", size);
+        shuffle_order(&context, size);
+        benchmark_darray(&context, size);
+        benchmark_hashtable(&context, size);
+        benchmark_freelist(&context, size, FREELIST_MODE_FIRST_FIT, "freelist_ff");
+        benchmark_freelist(&context, size, FREELIST_MODE_SEGREGATED_FIT, "freelist_sf");
+        benchmark_ring_queue(&context, size);
+        benchmark_lockfree_queues(&context, size);
+        benchmark_slot_map(&context, size);
+        benchmark_flat_map(&context, size);
+        benchmark_bitset(&context, size);
+    }
+
+    kfree(context.order, sizeof(u32) * max_size, MEMORY_TAG_APPLICATION);
+    kfree(context.keys, (u64)BENCHMARK_KEY_LENGTH * max_size, MEMORY_TAG_APPLICATION);
+    if (context.has_csv) {
+        filesystem_close(&context.csv);
+        if (context.write_failed) {
+            KERROR("Failed to write some container benchmark results to '%s'.", csv_path);
+            return false;
+        }
+    }
+    return true;
+}
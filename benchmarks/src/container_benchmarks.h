@@ -0,0 +1,28 @@
+/**
+ * @file container_benchmarks.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Times the basic operations of the engine's containers at several sizes, and reports on them.
+ * @details Each container is filled, queried, iterated and emptied at every size, with keys and
+ * indices visited in a fixed pseudo-random order so that runs are comparable. Small sizes are
+ * repeated so that every measurement covers enough operations to be meaningful, and containers
+ * whose operations are O(n) each are skipped at the largest size. Results are
+ * logged, and also written as CSV for tracking over time, one row per container, operation and
+ * size: container,operation,size,op_count,total_ns,ns_per_op.
+ * @version 1.0
+ *
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include <defines.h>
+
+/**
+ * @brief Runs every container benchmark, logging the results.
+ *
+ * @param csv_path The path of the CSV file to write the results to, or 0 to only log them.
+ * @return True if the results file could be written (or none was requested); otherwise false.
+ */
+b8 container_benchmarks_run(const char* csv_path);
@@ -0,0 +1,54 @@
+#include "allocation_trace.h"
+#include "allocator_benchmarks.h"
+#include "container_benchmarks.h"
+
+#include <core/kmemory.h>
+#include <core/logger.h>
+#include <platform/platform.h>
+
+// The number of traces generated, plus one which may be loaded from a file.
+#define BENCHMARK_TRACE_COUNT 4
+
+int main(int argc, char** argv) {
+    memory_system_configuration memory_system_config = {0};
+    memory_system_config.total_alloc_size = GIBIBYTES(1);
+    memory_system_config.page_size = MEBIBYTES(2);
+    memory_system_config.node_local = true;
+    if (!memory_system_initialize(memory_system_config)) {
+        KERROR("Failed to initialize memory system.");
+        return 1;
+    }
+
+    allocation_trace traces[BENCHMARK_TRACE_COUNT] = {0};
+    u32 trace_count = 0;
+    allocation_trace_generate_engine_mix(200000, 0x1234, &traces[trace_count++]);
+    allocation_trace_generate_frame_churn(500, 200, 0x5678, &traces[trace_count++]);
+    allocation_trace_generate_small_objects(200000, 256, 0x9abc, &traces[trace_count++]);
+
+    // A trace recorded from a real run may be passed on the command line.
+    if (argc > 1) {
+        if (allocation_trace_load(argv[1], &traces[trace_count])) {
+            trace_count++;
+        } else {
+            KERROR("Failed to load allocation trace '%s'.", argv[1]);
+        }
+    }
+
+    // Clamped, so that locked allocators aren't timed mostly waiting on each other.
+    u32 thread_count = platform_get_processor_count();
+    thread_count = KMAX(thread_count, 2);
+    thread_count = KMIN(thread_count, 4);
+    for (u32 i = 0; i < trace_count; ++i) {
+        allocator_benchmarks_run(&traces[i]);
+        allocator_benchmarks_run_threaded(&traces[i], thread_count);
+    }
+
+    for (u32 i = 0; i < trace_count; ++i) {
+        allocation_trace_destroy(&traces[i]);
+    }
+
+    container_benchmarks_run("container_benchmarks.csv");
+
+    memory_system_shutdown();
+    return 0;
+}
@@ -44,4 +44,8 @@ REM Tools
 make -f "Makefile.executable.mak" %ACTION% TARGET=%TARGET% ASSEMBLY=tools
 IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
 
+REM Benchmarks
+make -f "Makefile.executable.mak" %ACTION% TARGET=%TARGET% ASSEMBLY=benchmarks
+IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
+
 ECHO All assemblies %ACTION_STR_PAST% successfully on %PLATFORM% (%TARGET%).
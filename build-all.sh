@@ -59,4 +59,11 @@ then
 echo "Error:"$ERRORLEVEL && exit
 fi
 
+make -f Makefile.executable.mak $ACTION TARGET=$TARGET ASSEMBLY=benchmarks
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]
+then
+echo "Error:"$ERRORLEVEL && exit
+fi
+
 echo "All assemblies $ACTION_STR_PAST successfully on $PLATFORM ($TARGET)."
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "bitset.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+// The number of words in a cache line. Storage is always a whole number of lines.
+#define BITSET_LINE_WORDS (KCACHE_LINE_SIZE / sizeof(u64))
+
+static u32 word_count_get(u32 bit_count) {
+    u32 word_count = (bit_count + BITSET_WORD_BITS - 1) / BITSET_WORD_BITS;
+    return (u32)get_aligned(word_count ? word_count : 1, BITSET_LINE_WORDS);
+}
+
+// Clears the bits of the last word past bit_count, so that counts and searches can work on whole words.
+static void clear_trailing_bits(bitset* set) {
+    u32 word = set->bit_count / BITSET_WORD_BITS;
+    u32 bit = set->bit_count % BITSET_WORD_BITS;
+    if (bit) {
+        set->words[word] &= (1ull << bit) - 1;
+        word++;
+    }
+    if (word < set->word_count) {
+        kzero_memory(set->words + word, sizeof(u64) * (set->word_count - word));
+    }
+}
+
+u64 bitset_memory_requirement(u32 bit_count) {
+    return sizeof(u64) * word_count_get(bit_count);
+}
+
+b8 bitset_create(u32 bit_count, void* memory, bitset* out_set) {
+    if (!out_set) {
+        KERROR("bitset_create requires a valid pointer to hold the bitset.");
+        return false;
+    }
+
+    out_set->bit_count = bit_count;
+    out_set->word_count = word_count_get(bit_count);
+    if (memory) {
+        out_set->owns_memory = false;
+        out_set->words = memory;
+    } else {
+        out_set->owns_memory = true;
+        out_set->words = kallocate_aligned(sizeof(u64) * out_set->word_count, KCACHE_LINE_SIZE, MEMORY_TAG_ARRAY);
+    }
+    bitset_clear_all(out_set);
+    return true;
+}
+
+void bitset_destroy(bitset* set) {
+    if (set) {
+        if (set->owns_memory && set->words) {
+            kfree_aligned(set->words, sizeof(u64) * set->word_count, KCACHE_LINE_SIZE, MEMORY_TAG_ARRAY);
+        }
+        kzero_memory(set, sizeof(bitset));
+    }
+}
+
+b8 bitset_resize(bitset* set, u32 bit_count) {
+    if (!set || !set->words) {
+        KERROR("bitset_resize requires a valid bitset.");
+        return false;
+    }
+    if (!set->owns_memory) {
+        KERROR("bitset_resize - Cannot resize a bitset which does not own its memory: %p", set);
+        return false;
+    }
+
+    u32 word_count = word_count_get(bit_count);
+    if (word_count != set->word_count) {
+        u64* words = kreallocate_aligned(set->words, sizeof(u64) * set->word_count, sizeof(u64) * word_count, KCACHE_LINE_SIZE, MEMORY_TAG_ARRAY);
+        if (!words) {
+            KERROR("bitset_resize - Failed to resize storage to %u bits.", bit_count);
+            return false;
+        }
+        if (word_count > set->word_count) {
+            kzero_memory(words + set->word_count, sizeof(u64) * (word_count - set->word_count));
+        }
+        set->words = words;
+        set->word_count = word_count;
+    }
+    set->bit_count = bit_count;
+    clear_trailing_bits(set);
+    return true;
+}
+
+void bitset_clear_all(bitset* set) {
+    if (set && set->words) {
+        kzero_memory(set->words, sizeof(u64) * set->word_count);
+    }
+}
+
+void bitset_set_all(bitset* set) {
+    if (set && set->words) {
+        kset_memory(set->words, 0xFF, sizeof(u64) * set->word_count);
+        clear_trailing_bits(set);
+    }
+}
+
+u32 bitset_count(const bitset* set) {
+    if (!set || !set->words) {
+        return 0;
+    }
+    u32 count = 0;
+    for (u32 i = 0; i < set->word_count; ++i) {
+        count += (u32)__builtin_popcountll(set->words[i]);
+    }
+    return count;
+}
+
+u32 bitset_find_first_set(const bitset* set, u32 start) {
+    if (!set || !set->words || start >= set->bit_count) {
+        return INVALID_ID;
+    }
+
+    u32 word = start / BITSET_WORD_BITS;
+    // Ignore the bits of the first word before start.
+    u64 bits = set->words[word] & (~0ull << (start % BITSET_WORD_BITS));
+    while (true) {
+        if (bits) {
+            // Trailing bits are always clear, so any set bit found is within bit_count.
+            return word * BITSET_WORD_BITS + (u32)__builtin_ctzll(bits);
+        }
+        if (++word == set->word_count) {
+            return INVALID_ID;
+        }
+        bits = set->words[word];
+    }
+}
@@ -0,0 +1,109 @@
+/**
+ * @file bitset.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Contains the implementation of a fixed-size bitset.
+ * @details A bitset stores one bit per flag, packed into 64-bit words. Storage is
+ * rounded up to whole cache lines and aligned to one, so clearing or setting every
+ * bit is a straight run of cache-line writes the compiler is free to vectorize.
+ * Counting and searching for set bits work a word at a time. Not thread-safe.
+ * @version 1.0
+ *
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief The number of bits held by each word of a bitset. */
+#define BITSET_WORD_BITS 64
+
+/** @brief The bitset structure. */
+typedef struct bitset {
+    /** @brief The number of usable bits. */
+    u32 bit_count;
+    /** @brief The number of words in the storage, always a whole number of cache lines. */
+    u32 word_count;
+    /** @brief The bit storage. Bits past bit_count are always clear. */
+    u64* words;
+    /** @brief Indicates if the bitset owns its storage. */
+    b8 owns_memory;
+} bitset;
+
+/**
+ * @brief Obtains the size of the storage a bitset of the given number of bits requires.
+ *
+ * @param bit_count The number of bits.
+ * @return The required size in bytes. The storage should be aligned to KCACHE_LINE_SIZE.
+ */
+KAPI u64 bitset_memory_requirement(u32 bit_count);
+
+/**
+ * @brief Creates a new bitset with every bit clear.
+ *
+ * @param bit_count The number of bits to hold.
+ * @param memory The storage for the bits, of the size given by bitset_memory_requirement.
+ * If 0 is passed, storage is automatically allocated and freed upon creation/destruction.
+ * @param out_set A pointer to hold the bitset.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 bitset_create(u32 bit_count, void* memory, bitset* out_set);
+
+/**
+ * @brief Destroys the given bitset. If memory was not passed in during creation,
+ * it is freed here.
+ *
+ * @param set A pointer to the bitset to destroy.
+ */
+KAPI void bitset_destroy(bitset* set);
+
+/**
+ * @brief Changes the number of bits held, keeping the values of those which remain.
+ * Added bits are clear. Only bitsets which own their storage can be resized.
+ *
+ * @param set A pointer to the bitset to resize.
+ * @param bit_count The new number of bits.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 bitset_resize(bitset* set, u32 bit_count);
+
+/** @brief Clears every bit of the given bitset. */
+KAPI void bitset_clear_all(bitset* set);
+
+/** @brief Sets every bit of the given bitset. */
+KAPI void bitset_set_all(bitset* set);
+
+/**
+ * @brief Counts the set bits of the given bitset.
+ *
+ * @param set A constant pointer to the bitset.
+ * @return The number of set bits.
+ */
+KAPI u32 bitset_count(const bitset* set);
+
+/**
+ * @brief Finds the first set bit at or after the given index. Also used to iterate
+ * set bits: start from 0, then from one past each index found.
+ *
+ * @param set A constant pointer to the bitset.
+ * @param start The index to start searching from.
+ * @return The index of the first set bit found, or INVALID_ID if there are none.
+ */
+KAPI u32 bitset_find_first_set(const bitset* set, u32 start);
+
+/** @brief Sets the bit at the given index, which must be less than bit_count. */
+KINLINE void bitset_set(bitset* set, u32 index) {
+    set->words[index / BITSET_WORD_BITS] |= 1ull << (index % BITSET_WORD_BITS);
+}
+
+/** @brief Clears the bit at the given index, which must be less than bit_count. */
+KINLINE void bitset_clear(bitset* set, u32 index) {
+    set->words[index / BITSET_WORD_BITS] &= ~(1ull << (index % BITSET_WORD_BITS));
+}
+
+/** @brief Indicates if the bit at the given index, which must be less than bit_count, is set. */
+KINLINE b8 bitset_test(const bitset* set, u32 index) {
+    return (set->words[index / BITSET_WORD_BITS] >> (index % BITSET_WORD_BITS)) & 1;
+}
@@ -2,23 +2,79 @@
 
 #include "core/kmemory.h"
 #include "core/logger.h"
+#include "memory/linear_allocator.h"
+#include "memory/pool_allocator.h"
+
+// Sets up the header of a new array in the given block and returns the array.
+static void* darray_init(u64* header, u64 capacity, u64 stride, void* allocator, darray_storage storage) {
+    kset_memory(header, 0, DARRAY_FIELD_LENGTH * sizeof(u64) + capacity * stride);
+    header[DARRAY_CAPACITY] = capacity;
+    header[DARRAY_LENGTH] = 0;
+    header[DARRAY_STRIDE] = stride;
+    header[DARRAY_ALLOCATOR] = (u64)allocator;
+    header[DARRAY_STORAGE] = storage;
+    return (void*)(header + DARRAY_FIELD_LENGTH);
+}
 
 void* _darray_create(u64 length, u64 stride) {
+    return _darray_create_with_allocator(length, stride, 0);
+}
+
+void* _darray_create_with_allocator(u64 length, u64 stride, struct linear_allocator* allocator) {
+    // Always have room for at least one element, so that resizing can grow the array.
+    if (length == 0) {
+        length = DARRAY_DEFAULT_CAPACITY;
+    }
     u64 header_size = DARRAY_FIELD_LENGTH * sizeof(u64);
     u64 array_size = length * stride;
-    u64* new_array = kallocate(header_size + array_size, MEMORY_TAG_DARRAY);
-    kset_memory(new_array, 0, header_size + array_size);
-    new_array[DARRAY_CAPACITY] = length;
-    new_array[DARRAY_LENGTH] = 0;
-    new_array[DARRAY_STRIDE] = stride;
-    return (void*)(new_array + DARRAY_FIELD_LENGTH);
+    if (allocator) {
+        u64* header = linear_allocator_allocate(allocator, header_size + array_size);
+        if (header) {
+            return darray_init(header, length, stride, allocator, DARRAY_STORAGE_LINEAR);
+        }
+        KWARN("_darray_create_with_allocator - allocator is out of space, falling back to the heap.");
+    }
+    return darray_init(kallocate(header_size + array_size, MEMORY_TAG_DARRAY), length, stride, 0, DARRAY_STORAGE_HEAP);
+}
+
+void* _darray_create_with_pool(u64 stride, struct pool_allocator* pool) {
+    u64 header_size = DARRAY_FIELD_LENGTH * sizeof(u64);
+    if (pool && pool->block_size >= header_size + stride) {
+        u64* header = pool_allocator_allocate(pool);
+        if (header) {
+            return darray_init(header, (pool->block_size - header_size) / stride, stride, pool, DARRAY_STORAGE_POOL);
+        }
+        KWARN("_darray_create_with_pool - pool is out of blocks, falling back to the heap.");
+    } else {
+        KWARN("_darray_create_with_pool - pool blocks cannot hold an element of %llu bytes, falling back to the heap.", stride);
+    }
+    return _darray_create(DARRAY_DEFAULT_CAPACITY, stride);
+}
+
+void* _darray_create_in_buffer(u64 stride, void* buffer, u64 buffer_size) {
+    u64 header_size = DARRAY_FIELD_LENGTH * sizeof(u64);
+    if (buffer && buffer_size >= header_size + stride) {
+        return darray_init(buffer, (buffer_size - header_size) / stride, stride, 0, DARRAY_STORAGE_BUFFER);
+    }
+    KWARN("_darray_create_in_buffer - buffer cannot hold an element of %llu bytes, falling back to the heap.", stride);
+    return _darray_create(DARRAY_DEFAULT_CAPACITY, stride);
 }
 
 void _darray_destroy(void* array) {
     u64* header = (u64*)array - DARRAY_FIELD_LENGTH;
-    u64 header_size = DARRAY_FIELD_LENGTH * sizeof(u64);
-    u64 total_size = header_size + header[DARRAY_CAPACITY] * header[DARRAY_STRIDE];
-    kfree(header, total_size, MEMORY_TAG_DARRAY);
+    switch (header[DARRAY_STORAGE]) {
+        case DARRAY_STORAGE_HEAP: {
+            u64 header_size = DARRAY_FIELD_LENGTH * sizeof(u64);
+            u64 total_size = header_size + header[DARRAY_CAPACITY] * header[DARRAY_STRIDE];
+            kfree(header, total_size, MEMORY_TAG_DARRAY);
+        } break;
+        case DARRAY_STORAGE_POOL:
+            pool_allocator_free((pool_allocator*)header[DARRAY_ALLOCATOR], header);
+            break;
+        default:
+            // Memory belongs to the allocator or the caller and is reclaimed along with it.
+            break;
+    }
 }
 
 u64 _darray_field_get(void* array, u64 field) {
@@ -31,12 +87,45 @@ void _darray_field_set(void* array, u64 field, u64 value) {
     header[field] = value;
 }
 
-void* _darray_resize(void* array) {
+// Grows the array to hold at least min_capacity elements, at least doubling its capacity
+// so that repeated growth stays amortized.
+static void* darray_grow(void* array, u64 min_capacity) {
     u64 length = darray_length(array);
     u64 stride = darray_stride(array);
-    void* temp = _darray_create(
-        (DARRAY_RESIZE_FACTOR * darray_capacity(array)),
-        stride);
+    u64* header = (u64*)array - DARRAY_FIELD_LENGTH;
+    u64 header_size = DARRAY_FIELD_LENGTH * sizeof(u64);
+    u64 old_capacity = header[DARRAY_CAPACITY];
+    u64 new_capacity = DARRAY_RESIZE_FACTOR * old_capacity;
+    if (new_capacity < min_capacity) {
+        new_capacity = min_capacity;
+    }
+    linear_allocator* allocator = 0;
+
+    switch (header[DARRAY_STORAGE]) {
+        case DARRAY_STORAGE_HEAP: {
+            // Heap arrays are resized in place where there is room, which avoids the copy.
+            u64* new_header = kreallocate(header, header_size + old_capacity * stride, header_size + new_capacity * stride, MEMORY_TAG_DARRAY);
+            if (!new_header) {
+                KERROR("_darray_resize - failed to grow the array to a capacity of %llu.", new_capacity);
+                return array;
+            }
+            new_header[DARRAY_CAPACITY] = new_capacity;
+            return (void*)(new_header + DARRAY_FIELD_LENGTH);
+        }
+        case DARRAY_STORAGE_LINEAR:
+            allocator = (linear_allocator*)header[DARRAY_ALLOCATOR];
+            // If this is the allocator's newest block, it can just be extended.
+            if (linear_allocator_extend(allocator, header, header_size + old_capacity * stride, header_size + new_capacity * stride)) {
+                header[DARRAY_CAPACITY] = new_capacity;
+                return array;
+            }
+            break;
+        default:
+            // Pool blocks and buffers can't grow, so the array moves to the heap.
+            break;
+    }
+
+    void* temp = _darray_create_with_allocator(new_capacity, stride, allocator);
     kcopy_memory(temp, array, length * stride);
 
     _darray_field_set(temp, DARRAY_LENGTH, length);
@@ -44,6 +133,10 @@ void* _darray_resize(void* array) {
     return temp;
 }
 
+void* _darray_resize(void* array) {
+    return darray_grow(array, 0);
+}
+
 void* _darray_push(void* array, const void* value_ptr) {
     u64 length = darray_length(array);
     u64 stride = darray_stride(array);
@@ -58,6 +151,26 @@ void* _darray_push(void* array, const void* value_ptr) {
     return array;
 }
 
+void* _darray_push_range(void* array, const void* values, u64 count) {
+    u64 length = darray_length(array);
+    u64 stride = darray_stride(array);
+    if (length + count > darray_capacity(array)) {
+        array = darray_grow(array, length + count);
+    }
+
+    kcopy_memory((u8*)array + length * stride, values, count * stride);
+    _darray_field_set(array, DARRAY_LENGTH, length + count);
+    return array;
+}
+
+void* _darray_resize_uninitialized(void* array, u64 length) {
+    if (length > darray_capacity(array)) {
+        array = darray_grow(array, length);
+    }
+    _darray_field_set(array, DARRAY_LENGTH, length);
+    return array;
+}
+
 void _darray_pop(void* array, void* dest) {
     u64 length = darray_length(array);
     u64 stride = darray_stride(array);
@@ -76,24 +189,46 @@ void* _darray_pop_at(void* array, u64 index, void* dest) {
     }
 
     u64 addr = (u64)array;
-    kcopy_memory(dest, (void*)(addr + (index * stride)), stride);
+    if (dest) {
+        kcopy_memory(dest, (void*)(addr + (index * stride)), stride);
+    }
 
-    // If not on the last element, snip out the entry and copy the rest inward.
+    // If not on the last element, snip out the entry and move the rest inward.
     if (index != length - 1) {
-        kcopy_memory(
+        kmove_memory(
             (void*)(addr + (index * stride)),
             (void*)(addr + ((index + 1) * stride)),
-            stride * (length - index));
+            stride * (length - index - 1));
     }
 
     _darray_field_set(array, DARRAY_LENGTH, length - 1);
     return array;
 }
 
-void* _darray_insert_at(void* array, u64 index, void* value_ptr) {
+void _darray_swap_remove(void* array, u64 index, void* dest) {
     u64 length = darray_length(array);
     u64 stride = darray_stride(array);
     if (index >= length) {
+        KERROR("Index outside the bounds of this array! Length: %llu, index: %llu", length, index);
+        return;
+    }
+
+    u8* element = (u8*)array + index * stride;
+    if (dest) {
+        kcopy_memory(dest, element, stride);
+    }
+    // Fill the hole with the last element rather than shifting everything after it.
+    if (index != length - 1) {
+        kcopy_memory(element, (u8*)array + (length - 1) * stride, stride);
+    }
+    _darray_field_set(array, DARRAY_LENGTH, length - 1);
+}
+
+void* _darray_insert_at(void* array, u64 index, void* value_ptr) {
+    u64 length = darray_length(array);
+    u64 stride = darray_stride(array);
+    // Inserting at the length appends.
+    if (index > length) {
         KERROR("Index outside the bounds of this array! Length: %i, index: %index", length, index);
         return array;
     }
@@ -103,9 +238,9 @@ void* _darray_insert_at(void* array, u64 index, void* value_ptr) {
 
     u64 addr = (u64)array;
 
-    // If not on the last element, copy the rest outward.
-    if (index != length - 1) {
-        kcopy_memory(
+    // If not past the last element, move the rest outward.
+    if (index != length) {
+        kmove_memory(
             (void*)(addr + ((index + 1) * stride)),
             (void*)(addr + (index * stride)),
             stride * (length - index));
@@ -8,6 +8,9 @@
  * - u64 capacity = number elements that can be held.
  * - u64 length = number of elements currently contained
  * - u64 stride = size of each element in bytes
+ * - u64 allocator = the allocator backing the array, or 0 for the heap or a buffer
+ * - u64 storage = where the array's memory comes from (see darray_storage)
+ * - u64 padding = unused, keeps the elements 16-byte aligned
  * - void* elements
  * @version 1.0
  *
@@ -20,13 +23,31 @@
 
 #include "defines.h"
 
+struct linear_allocator;
+struct pool_allocator;
+
 enum {
     DARRAY_CAPACITY,
     DARRAY_LENGTH,
     DARRAY_STRIDE,
+    DARRAY_ALLOCATOR,
+    DARRAY_STORAGE,
+    DARRAY_PADDING,
     DARRAY_FIELD_LENGTH
 };
 
+/** @brief Where the memory of a darray comes from. */
+typedef enum darray_storage {
+    /** @brief The global allocator. Resized in place where possible. */
+    DARRAY_STORAGE_HEAP,
+    /** @brief A linear allocator, such as a frame arena or scratch allocator. */
+    DARRAY_STORAGE_LINEAR,
+    /** @brief A single block of a pool allocator. Moves to the heap if it outgrows the block. */
+    DARRAY_STORAGE_POOL,
+    /** @brief A buffer provided by the caller, usually on the stack. Moves to the heap if it outgrows the buffer. */
+    DARRAY_STORAGE_BUFFER
+} darray_storage;
+
 /**
  * @brief Creates a new darray of the given length and stride.
  * Note that this performs a dynamic memory allocation. 
@@ -37,6 +58,46 @@ enum {
  */
 KAPI void* _darray_create(u64 length, u64 stride);
 
+/**
+ * @brief Creates a new darray of the given length and stride, whose memory (including
+ * that of any resize) is taken from the given linear allocator instead of the heap.
+ * The memory is reclaimed when the allocator is freed, and destroying the array does
+ * nothing. If the allocator runs out of space, the array falls back to the heap and
+ * must then be destroyed as usual, so arrays created this way should still be destroyed.
+ * @note Avoid using this directly; use the darray_create_with_allocator macro instead.
+ * @param length The default number of elements in the array.
+ * @param stride The size of each array element.
+ * @param allocator The linear allocator to take memory from.
+ * @returns A pointer representing the block of memory containing the array.
+ */
+KAPI void* _darray_create_with_allocator(u64 length, u64 stride, struct linear_allocator* allocator);
+
+/**
+ * @brief Creates a new darray of the given stride in a single block of the given pool
+ * allocator, with as much capacity as fits in the block. If the array outgrows the
+ * block, it moves to the heap and the block is returned to the pool. If the pool has
+ * no free blocks, or its blocks are too small for a single element, the array is
+ * created on the heap instead.
+ * @note Avoid using this directly; use the darray_create_with_pool macro instead.
+ * @param stride The size of each array element.
+ * @param pool The pool allocator to take a block from.
+ * @returns A pointer representing the block of memory containing the array.
+ */
+KAPI void* _darray_create_with_pool(u64 stride, struct pool_allocator* pool);
+
+/**
+ * @brief Creates a new darray of the given stride inside the given buffer, with as much
+ * capacity as fits in it. Nothing is allocated until the array outgrows the buffer, at
+ * which point it moves to the heap. The buffer must outlive the array, and the array
+ * should be destroyed as usual in case it moved.
+ * @note Avoid using this directly; use the darray_create_in_buffer macro instead.
+ * @param stride The size of each array element.
+ * @param buffer The buffer to hold the array. Should be aligned to at least 8 bytes.
+ * @param buffer_size The size of the buffer in bytes. See DARRAY_BUFFER_SIZE.
+ * @returns A pointer representing the block of memory containing the array.
+ */
+KAPI void* _darray_create_in_buffer(u64 stride, void* buffer, u64 buffer_size);
+
 /**
  * @brief destroys the given array, freeing resources. Frees associated memory.
  * @note Avoid using this function directly. Use the darray_destroy macro instead.
@@ -80,6 +141,26 @@ KAPI void* _darray_resize(void* array);
  */
 KAPI void* _darray_push(void* array, const void* value_ptr);
 
+/**
+ * @brief Appends count entries to the given array in a single copy, resizing at most once.
+ * @note Avoid using this directly; call the darray_push_range macro instead.
+ * @param array The array to be pushed to.
+ * @param values A pointer to count tightly packed values. A copy of these values is taken.
+ * @param count The number of values to push.
+ * @returns A pointer to the array block.
+ */
+KAPI void* _darray_push_range(void* array, const void* values, u64 count);
+
+/**
+ * @brief Sets the length of the given array, growing it if needed. Entries past the
+ * previous length are left uninitialized, and are meant to be written directly.
+ * @note Avoid using this directly; call the darray_resize_uninitialized macro instead.
+ * @param array The array to resize.
+ * @param length The new length of the array.
+ * @returns A pointer to the array block.
+ */
+KAPI void* _darray_resize_uninitialized(void* array, u64 length);
+
 /**
  * @brief Pops an entry out of the array and places it into dest.
  * @note Avoid using this directly; call the darray_pop macro instead.
@@ -94,17 +175,27 @@ KAPI void _darray_pop(void* array, void* dest);
  * @note Avoid using this directly; call the darray_pop_at macro instead.
  * @param array The array to pop from.
  * @param index The index to pop from.
- * @param dest A pointer to hold the popped value.
+ * @param dest A pointer to hold the popped value. Optional.
  * @returns The array block.
  */
 KAPI void* _darray_pop_at(void* array, u64 index, void* dest);
 
+/**
+ * @brief Removes the entry at the given index by moving the last entry into its place.
+ * Does not preserve the order of the array, but does not shift any other entries.
+ * @note Avoid using this directly; call the darray_swap_remove macro instead.
+ * @param array The array to remove from.
+ * @param index The index to remove.
+ * @param dest A pointer to hold the removed value. Optional.
+ */
+KAPI void _darray_swap_remove(void* array, u64 index, void* dest);
+
 /**
  * @brief Inserts a copy of the given value into the supplied array at the given index.
  * Triggers an array resize if required.
  * @note Avoid using this directly; call the darray_insert_at macro instead.
  * @param array The array to insert into.
- * @param index The index to insert at.
+ * @param index The index to insert at. Inserting at the length appends.
  * @param value_ptr A pointer holding the value to be inserted.
  * @returns The array block.
  */
@@ -135,6 +226,61 @@ KAPI void* _darray_insert_at(void* array, u64 index, void* value_ptr);
 #define darray_reserve(type, capacity) \
     _darray_create(capacity, sizeof(type))
 
+/**
+ * @brief Creates a new darray of the given type with the default capacity, backed by
+ * the given linear allocator. Does not perform a dynamic memory allocation.
+ * @param type The type to be used to create the darray.
+ * @param allocator A pointer to the linear allocator to take memory from.
+ * @returns A pointer to the array's memory block.
+ */
+#define darray_create_with_allocator(type, allocator) \
+    _darray_create_with_allocator(DARRAY_DEFAULT_CAPACITY, sizeof(type), allocator)
+
+/**
+ * @brief Creates a new darray of the given type with the provided capacity, backed by
+ * the given linear allocator. Does not perform a dynamic memory allocation.
+ * @param type The type to be used to create the darray.
+ * @param capacity The number of elements the darray can initially hold (can be resized).
+ * @param allocator A pointer to the linear allocator to take memory from.
+ * @returns A pointer to the array's memory block.
+ */
+#define darray_reserve_with_allocator(type, capacity, allocator) \
+    _darray_create_with_allocator(capacity, sizeof(type), allocator)
+
+/**
+ * @brief Creates a new darray of the given type in a block of the given pool allocator.
+ * Does not perform a dynamic memory allocation unless the array outgrows the block.
+ * @param type The type to be used to create the darray.
+ * @param pool A pointer to the pool allocator to take a block from.
+ * @returns A pointer to the array's memory block.
+ */
+#define darray_create_with_pool(type, pool) \
+    _darray_create_with_pool(sizeof(type), pool)
+
+/** @brief Gets the size in bytes of a buffer able to hold a darray of count elements of the given type. */
+#define DARRAY_BUFFER_SIZE(type, count) (DARRAY_FIELD_LENGTH * sizeof(u64) + (count) * sizeof(type))
+
+/**
+ * @brief Declares a buffer named name, able to hold a darray of count elements of the given type
+ * without allocating. Intended to be declared on the stack for short-lived arrays.
+ * @param name The name of the buffer variable.
+ * @param type The type of the array elements.
+ * @param count The number of elements the buffer can hold.
+ */
+#define darray_buffer(name, type, count) \
+    u64 name[(DARRAY_BUFFER_SIZE(type, count) + sizeof(u64) - 1) / sizeof(u64)]
+
+/**
+ * @brief Creates a new darray of the given type inside the given buffer, which must be an
+ * array (not a pointer) such as one declared by darray_buffer. Does not perform a dynamic
+ * memory allocation unless the array outgrows the buffer.
+ * @param type The type to be used to create the darray.
+ * @param buffer The buffer array to hold the darray.
+ * @returns A pointer to the array's memory block.
+ */
+#define darray_create_in_buffer(type, buffer) \
+    _darray_create_in_buffer(sizeof(type), buffer, sizeof(buffer))
+
 /**
  * @brief Destroys the provided array, freeing any memory allocated by it.
  * @param array The array to be destroyed.
@@ -156,6 +302,24 @@ KAPI void* _darray_insert_at(void* array, u64 index, void* value_ptr);
 // for VSCode flags it as an unknown type. typeof() seems to
 // work just fine, though. Both are GNU extensions.
 
+/**
+ * @brief Appends count entries to the given array in a single copy, resizing at most once.
+ * @param array The array to be pushed to.
+ * @param values_ptr A pointer to count values of the array's type.
+ * @param count The number of values to push.
+ */
+#define darray_push_range(array, values_ptr, count) \
+    array = _darray_push_range(array, values_ptr, count)
+
+/**
+ * @brief Sets the length of the given array, growing it if needed. Entries past the
+ * previous length are left uninitialized, so that they can be written directly.
+ * @param array The array to resize.
+ * @param length The new length of the array.
+ */
+#define darray_resize_uninitialized(array, length) \
+    array = _darray_resize_uninitialized(array, length)
+
 /**
  * @brief Pops an entry out of the array and places it into dest.
  * @param array The array to pop from.
@@ -164,6 +328,16 @@ KAPI void* _darray_insert_at(void* array, u64 index, void* value_ptr);
 #define darray_pop(array, value_ptr) \
     _darray_pop(array, value_ptr)
 
+/**
+ * @brief Removes the entry at the given index by moving the last entry into its place.
+ * Does not preserve the order of the array.
+ * @param array The array to remove from.
+ * @param index The index to remove.
+ * @param value_ptr A pointer to hold the removed value, or 0 if not needed.
+ */
+#define darray_swap_remove(array, index, value_ptr) \
+    _darray_swap_remove(array, index, value_ptr)
+
 /**
  * @brief Inserts a copy of the given value into the supplied array at the given index.
  * Triggers an array resize if required.
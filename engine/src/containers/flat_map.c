@@ -0,0 +1,158 @@
+#include "flat_map.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+// The capacity a map grows to when first written to, if created without any.
+#define FLAT_MAP_MIN_CAPACITY 8
+
+static b8 flat_map_grow(flat_map* map, u32 capacity) {
+    u64* keys = kallocate(sizeof(u64) * capacity, MEMORY_TAG_BST);
+    void* values = kallocate((u64)map->value_size * capacity, MEMORY_TAG_BST);
+    if (!keys || !values) {
+        if (keys) {
+            kfree(keys, sizeof(u64) * capacity, MEMORY_TAG_BST);
+        }
+        if (values) {
+            kfree(values, (u64)map->value_size * capacity, MEMORY_TAG_BST);
+        }
+        return false;
+    }
+    if (map->capacity) {
+        kcopy_memory(keys, map->keys, sizeof(u64) * map->count);
+        kcopy_memory(values, map->values, (u64)map->value_size * map->count);
+        kfree(map->keys, sizeof(u64) * map->capacity, MEMORY_TAG_BST);
+        kfree(map->values, (u64)map->value_size * map->capacity, MEMORY_TAG_BST);
+    }
+    map->keys = keys;
+    map->values = values;
+    map->capacity = capacity;
+    return true;
+}
+
+b8 flat_map_create(u32 value_size, u32 capacity, flat_map* out_map) {
+    if (!out_map || value_size == 0) {
+        KERROR("flat_map_create requires a non-zero value_size and a valid pointer to hold the map.");
+        return false;
+    }
+
+    kzero_memory(out_map, sizeof(flat_map));
+    out_map->value_size = value_size;
+    if (capacity > 0) {
+        out_map->keys = kallocate(sizeof(u64) * capacity, MEMORY_TAG_BST);
+        out_map->values = kallocate((u64)value_size * capacity, MEMORY_TAG_BST);
+        out_map->capacity = capacity;
+    }
+    return true;
+}
+
+void flat_map_destroy(flat_map* map) {
+    if (map) {
+        if (map->capacity) {
+            kfree(map->keys, sizeof(u64) * map->capacity, MEMORY_TAG_BST);
+            kfree(map->values, (u64)map->value_size * map->capacity, MEMORY_TAG_BST);
+        }
+        kzero_memory(map, sizeof(flat_map));
+    }
+}
+
+u32 flat_map_lower_bound(const flat_map* map, u64 key) {
+    if (!map || map->count == 0) {
+        return 0;
+    }
+
+    // Branchless binary search: halve the window each step without a hard-to-predict branch.
+    const u64* base = map->keys;
+    u32 length = map->count;
+    while (length > 1) {
+        u32 half = length / 2;
+        base = base[half - 1] < key ? base + half : base;
+        length -= half;
+    }
+    return (u32)(base - map->keys) + (*base < key);
+}
+
+void* flat_map_set(flat_map* map, u64 key, const void* value) {
+    if (!map || map->value_size == 0) {
+        KERROR("flat_map_set requires a valid map.");
+        return 0;
+    }
+
+    u32 index = flat_map_lower_bound(map, key);
+    void* slot = 0;
+    if (index < map->count && map->keys[index] == key) {
+        slot = flat_map_value_at(map, index);
+    } else {
+        if (map->count == map->capacity) {
+            u32 capacity = map->capacity ? map->capacity * 2 : FLAT_MAP_MIN_CAPACITY;
+            if (!flat_map_grow(map, capacity)) {
+                KERROR("flat_map_set - Failed to grow the map to %u entries.", capacity);
+                return 0;
+            }
+        }
+
+        // Open a gap at the insert position.
+        u32 move_count = map->count - index;
+        if (move_count) {
+            kmove_memory(map->keys + index + 1, map->keys + index, sizeof(u64) * move_count);
+            kmove_memory(flat_map_value_at(map, index + 1), flat_map_value_at(map, index), (u64)map->value_size * move_count);
+        }
+        map->keys[index] = key;
+        map->count++;
+        slot = flat_map_value_at(map, index);
+    }
+
+    if (value) {
+        kcopy_memory(slot, value, map->value_size);
+    } else {
+        kzero_memory(slot, map->value_size);
+    }
+    return slot;
+}
+
+void* flat_map_get(const flat_map* map, u64 key) {
+    u32 index = flat_map_lower_bound(map, key);
+    if (!map || index >= map->count || map->keys[index] != key) {
+        return 0;
+    }
+    return flat_map_value_at(map, index);
+}
+
+b8 flat_map_remove(flat_map* map, u64 key, void* out_value) {
+    u32 index = flat_map_lower_bound(map, key);
+    if (!map || index >= map->count || map->keys[index] != key) {
+        return false;
+    }
+
+    if (out_value) {
+        kcopy_memory(out_value, flat_map_value_at(map, index), map->value_size);
+    }
+    // Close the gap.
+    u32 move_count = map->count - index - 1;
+    if (move_count) {
+        kmove_memory(map->keys + index, map->keys + index + 1, sizeof(u64) * move_count);
+        kmove_memory(flat_map_value_at(map, index), flat_map_value_at(map, index + 1), (u64)map->value_size * move_count);
+    }
+    map->count--;
+    return true;
+}
+
+void flat_map_clear(flat_map* map) {
+    if (map) {
+        map->count = 0;
+    }
+}
+
+u32 flat_map_range(const flat_map* map, u64 min_key, u64 max_key, u32* out_first) {
+    u32 first = flat_map_lower_bound(map, min_key);
+    if (out_first) {
+        *out_first = first;
+    }
+    if (!map || min_key > max_key) {
+        return 0;
+    }
+
+    // The end of the range is the first key past max_key.
+    u32 last = max_key == INVALID_ID_U64 ? map->count : flat_map_lower_bound(map, max_key + 1);
+    return last - first;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file flat_map.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Contains the implementation of a sorted flat map.
+ * @details A flat map holds values of a single size ordered by unique u64 keys, such
+ * as sort keys, timestamps or name hashes. Keys and values are kept in two packed
+ * arrays in key order, so lookups are a binary search over contiguous keys, and
+ * ordered iteration and range queries are a linear walk with no pointer chasing.
+ * Inserting and removing shift the entries after the affected position, which is
+ * cheap for the small-to-medium sizes this is meant for, and for maps built mostly
+ * in key order. Grows as needed. Not thread-safe.
+ * @version 1.0
+ *
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief The sorted flat map structure. */
+typedef struct flat_map {
+    /** @brief The size of each value in bytes. */
+    u32 value_size;
+    /** @brief The number of entries. */
+    u32 count;
+    /** @brief The number of entries which fit before the map needs to grow. */
+    u32 capacity;
+    /** @brief The keys, in ascending order. */
+    u64* keys;
+    /** @brief The values, in the same order as the keys. */
+    void* values;
+} flat_map;
+
+/**
+ * @brief Creates a new flat map.
+ *
+ * @param value_size The size of each value in bytes.
+ * @param capacity The number of entries to reserve space for. Grows as needed.
+ * @param out_map A pointer to hold the map.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 flat_map_create(u32 value_size, u32 capacity, flat_map* out_map);
+
+/**
+ * @brief Destroys the given map, freeing its memory.
+ *
+ * @param map A pointer to the map to destroy.
+ */
+KAPI void flat_map_destroy(flat_map* map);
+
+/**
+ * @brief Sets the value for the given key, inserting it in order if not already present.
+ *
+ * @param map A pointer to the map.
+ * @param key The key.
+ * @param value A pointer to the value to copy in. If 0, the value is zeroed.
+ * @return A pointer to the value stored in the map, valid until the map is next changed; or 0 on failure.
+ */
+KAPI void* flat_map_set(flat_map* map, u64 key, const void* value);
+
+/**
+ * @brief Obtains the value for the given key.
+ *
+ * @param map A constant pointer to the map.
+ * @param key The key to look up.
+ * @return A pointer to the value, valid until the map is next changed; or 0 if not present.
+ */
+KAPI void* flat_map_get(const flat_map* map, u64 key);
+
+/**
+ * @brief Removes the entry for the given key.
+ *
+ * @param map A pointer to the map.
+ * @param key The key to remove.
+ * @param out_value A pointer to hold the removed value. Optional.
+ * @return True if an entry was removed; false if the key was not present.
+ */
+KAPI b8 flat_map_remove(flat_map* map, u64 key, void* out_value);
+
+/** @brief Removes every entry from the given map, keeping its memory. */
+KAPI void flat_map_clear(flat_map* map);
+
+/**
+ * @brief Obtains the position of the first entry whose key is not less than the given key.
+ *
+ * @param map A constant pointer to the map.
+ * @param key The key to search for.
+ * @return The position, which is count if every key is less than key.
+ */
+KAPI u32 flat_map_lower_bound(const flat_map* map, u64 key);
+
+/**
+ * @brief Obtains the entries whose keys are within the given inclusive range, as a run of
+ * positions. Use flat_map_key_at and flat_map_value_at to read them.
+ *
+ * @param map A constant pointer to the map.
+ * @param min_key The lowest key to include.
+ * @param max_key The highest key to include.
+ * @param out_first A pointer to hold the position of the first entry in the range.
+ * @return The number of entries in the range.
+ */
+KAPI u32 flat_map_range(const flat_map* map, u64 min_key, u64 max_key, u32* out_first);
+
+/** @brief Obtains the key at the given position, which must be less than count. */
+KINLINE u64 flat_map_key_at(const flat_map* map, u32 index) {
+    return map->keys[index];
+}
+
+/** @brief Obtains the value at the given position, which must be less than count. */
+KINLINE void* flat_map_value_at(const flat_map* map, u32 index) {
+    return (u8*)map->values + (u64)map->value_size * index;
+}
@@ -9,17 +9,61 @@ typedef struct freelist_node {
     struct freelist_node* next;
 } freelist_node;
 
+// The number of second-level lists per first-level class, as a power of 2.
+#define SEGREGATED_SL_LOG2 4
+#define SEGREGATED_SL_COUNT (1 << SEGREGATED_SL_LOG2)
+// Enough first-level classes for any u64 size.
+#define SEGREGATED_FL_COUNT 64
+// Marks a lookup entry as the end boundary of a range, rather than its start.
+#define SEGREGATED_END_FLAG 0x80000000U
+// Keeps node indices clear of the end flag, and the lookup table within a u32 capacity.
+#define SEGREGATED_MAX_ENTRIES 0x3FFFFFFFU
+
+typedef struct segregated_node {
+    u64 offset;
+    // 0 when the node is not in use.
+    u64 size;
+    // Links within the node's size list, or the list of unused nodes.
+    u32 prev;
+    u32 next;
+} segregated_node;
+
+typedef struct segregated_state {
+    u64 free_space;
+    // Set bits mark first-level classes with at least one free range.
+    u64 fl_bitmap;
+    // Set bits mark second-level lists with at least one free range.
+    u32 sl_bitmaps[SEGREGATED_FL_COUNT];
+    u32 heads[SEGREGATED_FL_COUNT][SEGREGATED_SL_COUNT];
+    u32 unused_head;
+    // The lookup table holds the start and end boundary of every free range, mapping each to
+    // its node index. Since free ranges are always coalesced, no two boundaries share an offset.
+    u32 lookup_capacity;
+    u32* lookup;
+    segregated_node* nodes;
+} segregated_state;
+
 typedef struct internal_state {
     u64 total_size;
     u64 max_entries;
     freelist_node* head;
     freelist_node* nodes;
+    freelist_mode mode;
+    // Only set in segregated-fit mode.
+    segregated_state* segregated;
 } internal_state;
 
 freelist_node* get_node(freelist* list);
 void return_node(freelist* list, freelist_node* node);
 
-void freelist_create(u64 total_size, u64* memory_requirement, void* memory, freelist* out_list) {
+static u64 segregated_requirement(u64 max_entries, u32* out_lookup_capacity);
+static void segregated_reset(internal_state* state);
+static b8 segregated_allocate(internal_state* state, u64 size, u64* out_offset);
+static b8 segregated_free(internal_state* state, u64 size, u64 offset);
+static b8 segregated_extend(internal_state* state, u64 offset, u64 extra_size);
+static u64 segregated_largest_free(internal_state* state);
+
+static u64 entries_for_size(u64 total_size) {
     // Enough space to hold state, plus array for all nodes.
     u64 max_entries = (total_size / (sizeof(void*) * sizeof(freelist_node)));  // NOTE: This might have a remainder, but that's ok.
 
@@ -28,8 +72,27 @@ void freelist_create(u64 total_size, u64* memory_requirement, void* memory, free
     if (max_entries < 20) {
         max_entries = 20;
     }
+    return max_entries;
+}
 
-    *memory_requirement = sizeof(internal_state) + (sizeof(freelist_node) * max_entries);
+static u64 state_requirement(freelist_mode mode, u64 max_entries) {
+    if (mode == FREELIST_MODE_SEGREGATED_FIT) {
+        return sizeof(internal_state) + segregated_requirement(max_entries, 0);
+    }
+    return sizeof(internal_state) + (sizeof(freelist_node) * max_entries);
+}
+
+void freelist_create(u64 total_size, u64* memory_requirement, void* memory, freelist* out_list) {
+    freelist_create_with_mode(total_size, FREELIST_MODE_FIRST_FIT, memory_requirement, memory, out_list);
+}
+
+void freelist_create_with_mode(u64 total_size, freelist_mode mode, u64* memory_requirement, void* memory, freelist* out_list) {
+    u64 max_entries = entries_for_size(total_size);
+    if (mode == FREELIST_MODE_SEGREGATED_FIT && max_entries > SEGREGATED_MAX_ENTRIES) {
+        max_entries = SEGREGATED_MAX_ENTRIES;
+    }
+
+    *memory_requirement = state_requirement(mode, max_entries);
     if (!memory) {
         return;
     }
@@ -50,6 +113,15 @@ void freelist_create(u64 total_size, u64* memory_requirement, void* memory, free
     state->nodes = (void*)(out_list->memory + sizeof(internal_state));
     state->max_entries = max_entries;
     state->total_size = total_size;
+    state->mode = mode;
+
+    if (mode == FREELIST_MODE_SEGREGATED_FIT) {
+        // The segregated block's layout is its state, then the nodes, then the lookup table.
+        state->nodes = 0;
+        state->segregated = (void*)(out_list->memory + sizeof(internal_state));
+        segregated_reset(state);
+        return;
+    }
 
     state->head = &state->nodes[0];
     state->head->offset = 0;
@@ -68,7 +140,7 @@ void freelist_destroy(freelist* list) {
     if (list && list->memory) {
         // Just zero out the memory before giving it back.
         internal_state* state = list->memory;
-        kzero_memory(list->memory, sizeof(internal_state) + sizeof(freelist_node) * state->max_entries);
+        kzero_memory(list->memory, state_requirement(state->mode, state->max_entries));
         list->memory = 0;
     }
 }
@@ -78,6 +150,10 @@ b8 freelist_allocate_block(freelist* list, u64 size, u64* out_offset) {
         return false;
     }
     internal_state* state = list->memory;
+    if (state->mode == FREELIST_MODE_SEGREGATED_FIT) {
+        return segregated_allocate(state, size, out_offset);
+    }
+
     freelist_node* node = state->head;
     freelist_node* previous = 0;
     while (node) {
@@ -119,6 +195,10 @@ b8 freelist_free_block(freelist* list, u64 size, u64 offset) {
         return false;
     }
     internal_state* state = list->memory;
+    if (state->mode == FREELIST_MODE_SEGREGATED_FIT) {
+        return segregated_free(state, size, offset);
+    }
+
     freelist_node* node = state->head;
     freelist_node* previous = 0;
     if (!node) {
@@ -206,11 +286,87 @@ b8 freelist_free_block(freelist* list, u64 size, u64 offset) {
     return false;
 }
 
+b8 freelist_extend_block(freelist* list, u64 offset, u64 size, u64 extra_size) {
+    if (!list || !list->memory || !extra_size) {
+        return false;
+    }
+    internal_state* state = list->memory;
+    if (state->mode == FREELIST_MODE_SEGREGATED_FIT) {
+        return segregated_extend(state, offset + size, extra_size);
+    }
+
+    // The list is sorted by offset, so stop once past the end of the block.
+    u64 end = offset + size;
+    freelist_node* node = state->head;
+    freelist_node* previous = 0;
+    while (node && node->offset <= end) {
+        if (node->offset == end) {
+            if (node->size < extra_size) {
+                return false;
+            }
+            if (node->size == extra_size) {
+                // Takes the whole range, so the node is no longer needed.
+                if (previous) {
+                    previous->next = node->next;
+                } else {
+                    state->head = node->next;
+                }
+                return_node(list, node);
+            } else {
+                node->offset += extra_size;
+                node->size -= extra_size;
+            }
+            return true;
+        }
+        previous = node;
+        node = node->next;
+    }
+    return false;
+}
+
 b8 freelist_resize(freelist* list, u64* memory_requirement, void* new_memory, u64 new_size, void** out_old_memory) {
     if (!list || !memory_requirement || ((internal_state*)list->memory)->total_size > new_size) {
         return false;
     }
 
+    internal_state* current_state = (internal_state*)list->memory;
+    if (current_state->mode == FREELIST_MODE_SEGREGATED_FIT) {
+        u64 max_entries = entries_for_size(new_size);
+        if (max_entries > SEGREGATED_MAX_ENTRIES) {
+            max_entries = SEGREGATED_MAX_ENTRIES;
+        }
+        // Every old range needs a node in the new list.
+        max_entries = KMAX(max_entries, current_state->max_entries);
+        *memory_requirement = state_requirement(FREELIST_MODE_SEGREGATED_FIT, max_entries);
+        if (!new_memory) {
+            return true;
+        }
+
+        *out_old_memory = list->memory;
+        list->memory = new_memory;
+        kzero_memory(list->memory, *memory_requirement);
+
+        internal_state* state = (internal_state*)list->memory;
+        state->max_entries = max_entries;
+        state->total_size = new_size;
+        state->mode = FREELIST_MODE_SEGREGATED_FIT;
+        state->segregated = (void*)(list->memory + sizeof(internal_state));
+        segregated_reset(state);
+
+        // segregated_reset leaves the whole new range free, so mark everything allocated and
+        // then free each of the old ranges, followed by the newly added space.
+        u64 whole_offset = 0;
+        segregated_allocate(state, new_size, &whole_offset);
+        segregated_state* old = current_state->segregated;
+        for (u64 i = 0; i < current_state->max_entries; ++i) {
+            if (old->nodes[i].size) {
+                segregated_free(state, old->nodes[i].size, old->nodes[i].offset);
+            }
+        }
+        segregated_free(state, new_size - current_state->total_size, current_state->total_size);
+        return true;
+    }
+
     // Enough space to hold state, plus array for all nodes.
     u64 max_entries = (new_size / sizeof(void*));  // NOTE: This might have a remainder, but that's ok.
     
@@ -306,6 +462,11 @@ void freelist_clear(freelist* list) {
     }
 
     internal_state* state = list->memory;
+    if (state->mode == FREELIST_MODE_SEGREGATED_FIT) {
+        segregated_reset(state);
+        return;
+    }
+
     // Invalidate the offset and size for all but the first node. The invalid
     // value will be checked for when seeking a new node from the list.
     for (u64 i = 1; i < state->max_entries; ++i) {
@@ -326,6 +487,10 @@ u64 freelist_free_space(freelist* list) {
 
     u64 running_total = 0;
     internal_state* state = list->memory;
+    if (state->mode == FREELIST_MODE_SEGREGATED_FIT) {
+        return state->segregated->free_space;
+    }
+
     freelist_node* node = state->head;
     while (node) {
         running_total += node->size;
@@ -335,6 +500,32 @@ u64 freelist_free_space(freelist* list) {
     return running_total;
 }
 
+f32 freelist_fragmentation(freelist* list) {
+    if (!list || !list->memory) {
+        return 0;
+    }
+
+    internal_state* state = list->memory;
+    u64 free_space = 0;
+    u64 largest = 0;
+    if (state->mode == FREELIST_MODE_SEGREGATED_FIT) {
+        free_space = state->segregated->free_space;
+        largest = segregated_largest_free(state);
+    } else {
+        freelist_node* node = state->head;
+        while (node) {
+            free_space += node->size;
+            largest = KMAX(largest, node->size);
+            node = node->next;
+        }
+    }
+
+    if (free_space == 0) {
+        return 0;
+    }
+    return 1.0f - (f32)((f64)largest / (f64)free_space);
+}
+
 freelist_node* get_node(freelist* list) {
     internal_state* state = list->memory;
     for (u64 i = 1; i < state->max_entries; ++i) {
@@ -351,4 +542,345 @@ void return_node(freelist* list, freelist_node* node) {
     node->offset = INVALID_ID;
     node->size = INVALID_ID;
     node->next = 0;
-}
\ No newline at end of file
+}
+
+static u64 segregated_requirement(u64 max_entries, u32* out_lookup_capacity) {
+    // Each free range has two boundaries in the lookup table. Keep at least one slot
+    // empty so that probing always terminates.
+    u64 lookup_capacity = 1;
+    while (lookup_capacity <= max_entries * 2) {
+        lookup_capacity <<= 1;
+    }
+    if (out_lookup_capacity) {
+        *out_lookup_capacity = (u32)lookup_capacity;
+    }
+    return sizeof(segregated_state) + sizeof(segregated_node) * max_entries + sizeof(u32) * lookup_capacity;
+}
+
+// Obtains the first and second-level list indices for a range of the given size.
+static void segregated_mapping(u64 size, u32* out_fl, u32* out_sl) {
+    if (size < SEGREGATED_SL_COUNT) {
+        *out_fl = 0;
+        *out_sl = (u32)size;
+        return;
+    }
+    u32 msb = 63 - (u32)__builtin_clzll(size);
+    *out_fl = msb - SEGREGATED_SL_LOG2 + 1;
+    *out_sl = (u32)(size >> (msb - SEGREGATED_SL_LOG2)) ^ SEGREGATED_SL_COUNT;
+}
+
+static u32 lookup_home(segregated_state* seg, u64 key) {
+    return (u32)((key * 0x9E3779B97F4A7C15ULL) >> 32) & (seg->lookup_capacity - 1);
+}
+
+static u64 lookup_key(segregated_state* seg, u32 entry) {
+    segregated_node* node = &seg->nodes[entry & ~SEGREGATED_END_FLAG];
+    return (entry & SEGREGATED_END_FLAG) ? node->offset + node->size : node->offset;
+}
+
+// Returns the slot holding the given boundary, or INVALID_ID if it is not in the table.
+static u32 lookup_find(segregated_state* seg, u64 key, b8 is_end) {
+    u32 mask = seg->lookup_capacity - 1;
+    u32 slot = lookup_home(seg, key);
+    while (seg->lookup[slot] != INVALID_ID) {
+        u32 entry = seg->lookup[slot];
+        if (((entry & SEGREGATED_END_FLAG) != 0) == is_end && lookup_key(seg, entry) == key) {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return INVALID_ID;
+}
+
+static void lookup_insert(segregated_state* seg, u32 node_index, b8 is_end) {
+    u32 entry = node_index | (is_end ? SEGREGATED_END_FLAG : 0);
+    u32 mask = seg->lookup_capacity - 1;
+    u32 slot = lookup_home(seg, lookup_key(seg, entry));
+    while (seg->lookup[slot] != INVALID_ID) {
+        slot = (slot + 1) & mask;
+    }
+    seg->lookup[slot] = entry;
+}
+
+// Removes the entry at the given slot, shifting back any later entries of the same probe
+// sequence so that no tombstones are needed.
+static void lookup_remove_slot(segregated_state* seg, u32 slot) {
+    u32 mask = seg->lookup_capacity - 1;
+    u32 hole = slot;
+    u32 next = (hole + 1) & mask;
+    while (seg->lookup[next] != INVALID_ID) {
+        u32 home = lookup_home(seg, lookup_key(seg, seg->lookup[next]));
+        // Move the entry into the hole unless its home lies cyclically within (hole, next].
+        b8 stays = (hole <= next) ? (home > hole && home <= next) : (home > hole || home <= next);
+        if (!stays) {
+            seg->lookup[hole] = seg->lookup[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    seg->lookup[hole] = INVALID_ID;
+}
+
+static void lookup_remove(segregated_state* seg, u32 node_index, b8 is_end) {
+    segregated_node* node = &seg->nodes[node_index];
+    u32 slot = lookup_find(seg, is_end ? node->offset + node->size : node->offset, is_end);
+    if (slot != INVALID_ID) {
+        lookup_remove_slot(seg, slot);
+    }
+}
+
+static void segregated_insert(segregated_state* seg, u32 node_index) {
+    segregated_node* node = &seg->nodes[node_index];
+    u32 fl, sl;
+    segregated_mapping(node->size, &fl, &sl);
+    node->prev = INVALID_ID;
+    node->next = seg->heads[fl][sl];
+    if (node->next != INVALID_ID) {
+        seg->nodes[node->next].prev = node_index;
+    }
+    seg->heads[fl][sl] = node_index;
+    seg->fl_bitmap |= 1ULL << fl;
+    seg->sl_bitmaps[fl] |= 1U << sl;
+}
+
+static void segregated_remove(segregated_state* seg, u32 node_index) {
+    segregated_node* node = &seg->nodes[node_index];
+    u32 fl, sl;
+    segregated_mapping(node->size, &fl, &sl);
+    if (node->prev != INVALID_ID) {
+        seg->nodes[node->prev].next = node->next;
+    } else {
+        seg->heads[fl][sl] = node->next;
+        if (node->next == INVALID_ID) {
+            seg->sl_bitmaps[fl] &= ~(1U << sl);
+            if (!seg->sl_bitmaps[fl]) {
+                seg->fl_bitmap &= ~(1ULL << fl);
+            }
+        }
+    }
+    if (node->next != INVALID_ID) {
+        seg->nodes[node->next].prev = node->prev;
+    }
+}
+
+static u32 segregated_acquire_node(segregated_state* seg) {
+    u32 index = seg->unused_head;
+    if (index != INVALID_ID) {
+        seg->unused_head = seg->nodes[index].next;
+    }
+    return index;
+}
+
+static void segregated_release_node(segregated_state* seg, u32 node_index) {
+    seg->nodes[node_index].offset = 0;
+    seg->nodes[node_index].size = 0;
+    seg->nodes[node_index].next = seg->unused_head;
+    seg->unused_head = node_index;
+}
+
+static void segregated_reset(internal_state* state) {
+    segregated_state* seg = state->segregated;
+    u32 lookup_capacity = 0;
+    segregated_requirement(state->max_entries, &lookup_capacity);
+    seg->nodes = (void*)((u8*)seg + sizeof(segregated_state));
+    seg->lookup = (void*)((u8*)seg->nodes + sizeof(segregated_node) * state->max_entries);
+    seg->lookup_capacity = lookup_capacity;
+    seg->fl_bitmap = 0;
+    kzero_memory(seg->sl_bitmaps, sizeof(seg->sl_bitmaps));
+    for (u32 fl = 0; fl < SEGREGATED_FL_COUNT; ++fl) {
+        for (u32 sl = 0; sl < SEGREGATED_SL_COUNT; ++sl) {
+            seg->heads[fl][sl] = INVALID_ID;
+        }
+    }
+    for (u32 i = 0; i < lookup_capacity; ++i) {
+        seg->lookup[i] = INVALID_ID;
+    }
+
+    // Chain all but the first node into the unused list.
+    seg->unused_head = INVALID_ID;
+    for (u64 i = state->max_entries; i > 1; --i) {
+        segregated_release_node(seg, (u32)(i - 1));
+    }
+
+    // The first node covers the entire range.
+    seg->nodes[0].offset = 0;
+    seg->nodes[0].size = state->total_size;
+    seg->free_space = state->total_size;
+    segregated_insert(seg, 0);
+    lookup_insert(seg, 0, false);
+    lookup_insert(seg, 0, true);
+}
+
+static b8 segregated_allocate(internal_state* state, u64 size, u64* out_offset) {
+    segregated_state* seg = state->segregated;
+    if (size == 0 || size > seg->free_space) {
+        KWARN("freelist_find_block, no block with enough free space found (requested: %lluB, available: %lluB).", size, seg->free_space);
+        return false;
+    }
+
+    // Round the size up to the next list boundary, so that any range in the list found
+    // is guaranteed to be large enough.
+    u64 search_size = size;
+    if (size >= SEGREGATED_SL_COUNT) {
+        u32 msb = 63 - (u32)__builtin_clzll(size);
+        u64 round = (1ULL << (msb - SEGREGATED_SL_LOG2)) - 1;
+        if (size <= ~0ULL - round) {
+            search_size = size + round;
+        }
+    }
+
+    u32 fl, sl;
+    segregated_mapping(search_size, &fl, &sl);
+    u32 node_index = INVALID_ID;
+    u32 sl_map = seg->sl_bitmaps[fl] & (~0U << sl);
+    if (!sl_map) {
+        u64 fl_map = fl + 1 < SEGREGATED_FL_COUNT ? seg->fl_bitmap & (~0ULL << (fl + 1)) : 0;
+        if (fl_map) {
+            fl = (u32)__builtin_ctzll(fl_map);
+            sl_map = seg->sl_bitmaps[fl];
+        }
+    }
+    if (sl_map) {
+        sl = (u32)__builtin_ctz(sl_map);
+        node_index = seg->heads[fl][sl];
+    } else {
+        // Nothing in the larger lists, but a range in the list the size itself maps to may
+        // still fit. This only happens when nearly out of space, so a walk is acceptable.
+        segregated_mapping(size, &fl, &sl);
+        u32 candidate = seg->heads[fl][sl];
+        while (candidate != INVALID_ID && seg->nodes[candidate].size < size) {
+            candidate = seg->nodes[candidate].next;
+        }
+        node_index = candidate;
+    }
+
+    if (node_index == INVALID_ID) {
+        KWARN("freelist_find_block, no block with enough free space found (requested: %lluB, available: %lluB).", size, seg->free_space);
+        return false;
+    }
+
+    segregated_node* node = &seg->nodes[node_index];
+    segregated_remove(seg, node_index);
+    *out_offset = node->offset;
+    if (node->size == size) {
+        // Exact match. The node is no longer needed.
+        lookup_remove(seg, node_index, false);
+        lookup_remove(seg, node_index, true);
+        segregated_release_node(seg, node_index);
+    } else {
+        // Take the memory from the start of the range. Its end boundary is unchanged.
+        lookup_remove(seg, node_index, false);
+        node->offset += size;
+        node->size -= size;
+        lookup_insert(seg, node_index, false);
+        segregated_insert(seg, node_index);
+    }
+    seg->free_space -= size;
+    return true;
+}
+
+static b8 segregated_free(internal_state* state, u64 size, u64 offset) {
+    segregated_state* seg = state->segregated;
+    if (offset > state->total_size || size > state->total_size - offset) {
+        KWARN("Unable to find block to be freed. Corruption possible?");
+        return false;
+    }
+    if (lookup_find(seg, offset, false) != INVALID_ID) {
+        // If a free range starts here, the exact block of memory that is already free is being freed again.
+        KFATAL("Attempting to free already-freed block of memory at offset %llu", offset);
+        return false;
+    }
+
+    u32 left_slot = lookup_find(seg, offset, true);
+    u32 right_slot = lookup_find(seg, offset + size, false);
+    u32 left = left_slot != INVALID_ID ? seg->lookup[left_slot] & ~SEGREGATED_END_FLAG : INVALID_ID;
+    u32 right = right_slot != INVALID_ID ? seg->lookup[right_slot] : INVALID_ID;
+
+    if (left != INVALID_ID && right != INVALID_ID) {
+        // Joins the ranges on both sides. Keep the left node, and hand the right node's
+        // end boundary over to it.
+        segregated_remove(seg, left);
+        segregated_remove(seg, right);
+        lookup_remove(seg, left, true);
+        lookup_remove(seg, right, false);
+        u32 end_slot = lookup_find(seg, seg->nodes[right].offset + seg->nodes[right].size, true);
+        seg->nodes[left].size += size + seg->nodes[right].size;
+        seg->lookup[end_slot] = left | SEGREGATED_END_FLAG;
+        segregated_release_node(seg, right);
+        segregated_insert(seg, left);
+    } else if (left != INVALID_ID) {
+        // Can be appended to the right of the previous range.
+        segregated_remove(seg, left);
+        lookup_remove(seg, left, true);
+        seg->nodes[left].size += size;
+        lookup_insert(seg, left, true);
+        segregated_insert(seg, left);
+    } else if (right != INVALID_ID) {
+        // Can be prepended to the left of the next range.
+        segregated_remove(seg, right);
+        lookup_remove(seg, right, false);
+        seg->nodes[right].offset = offset;
+        seg->nodes[right].size += size;
+        lookup_insert(seg, right, false);
+        segregated_insert(seg, right);
+    } else {
+        // Not touching any free range. Need a new node.
+        u32 node_index = segregated_acquire_node(seg);
+        if (node_index == INVALID_ID) {
+            KERROR("freelist_free_block - out of nodes to track free ranges (max: %llu).", state->max_entries);
+            return false;
+        }
+        seg->nodes[node_index].offset = offset;
+        seg->nodes[node_index].size = size;
+        lookup_insert(seg, node_index, false);
+        lookup_insert(seg, node_index, true);
+        segregated_insert(seg, node_index);
+    }
+
+    seg->free_space += size;
+    return true;
+}
+
+// Takes extra_size from the start of the free range beginning at offset, if there is one large enough.
+static b8 segregated_extend(internal_state* state, u64 offset, u64 extra_size) {
+    segregated_state* seg = state->segregated;
+    u32 slot = lookup_find(seg, offset, false);
+    if (slot == INVALID_ID) {
+        return false;
+    }
+    u32 node_index = seg->lookup[slot];
+    segregated_node* node = &seg->nodes[node_index];
+    if (node->size < extra_size) {
+        return false;
+    }
+
+    segregated_remove(seg, node_index);
+    lookup_remove_slot(seg, slot);
+    if (node->size == extra_size) {
+        lookup_remove(seg, node_index, true);
+        segregated_release_node(seg, node_index);
+    } else {
+        node->offset += extra_size;
+        node->size -= extra_size;
+        lookup_insert(seg, node_index, false);
+        segregated_insert(seg, node_index);
+    }
+    seg->free_space -= extra_size;
+    return true;
+}
+
+static u64 segregated_largest_free(internal_state* state) {
+    segregated_state* seg = state->segregated;
+    if (!seg->fl_bitmap) {
+        return 0;
+    }
+
+    // The largest range is in the highest non-empty list, which only spans 1/16th of its class.
+    u32 fl = 63 - (u32)__builtin_clzll(seg->fl_bitmap);
+    u32 sl = 31 - (u32)__builtin_clz(seg->sl_bitmaps[fl]);
+    u64 largest = 0;
+    for (u32 i = seg->heads[fl][sl]; i != INVALID_ID; i = seg->nodes[i].next) {
+        largest = KMAX(largest, seg->nodes[i].size);
+    }
+    return largest;
+}
@@ -13,6 +13,25 @@
 
 #include "defines.h"
 
+/**
+ * @brief The strategy a freelist uses to find and track free ranges.
+ */
+typedef enum freelist_mode {
+    /**
+     * @brief Free ranges are kept in a single list sorted by offset. Allocation takes
+     * the first range large enough, and freeing walks the list to coalesce. Allocation
+     * and free are O(n) in the number of free ranges, but the memory overhead is low.
+     */
+    FREELIST_MODE_FIRST_FIT,
+    /**
+     * @brief Free ranges are kept in size-segregated lists indexed by a two-level bitmap
+     * (TLSF). Allocation finds a good fit in O(1), and freeing coalesces with neighbours
+     * in O(1) through a lookup table of range boundaries. Requests are matched against
+     * ranges at most 1/16th larger than required, which bounds fragmentation.
+     */
+    FREELIST_MODE_SEGREGATED_FIT
+} freelist_mode;
+
 /**
  * @brief A data structure to be used alongside an allocator for dynamic memory
  * allocation. Tracks free ranges of memory.
@@ -34,6 +53,19 @@ typedef struct freelist {
  */
 KAPI void freelist_create(u64 total_size, u64* memory_requirement, void* memory, freelist* out_list);
 
+/**
+ * @brief Creates a new freelist using the given mode, or obtains the memory requirement
+ * for one. Call twice; once passing 0 to memory to obtain memory requirement, and a second
+ * time passing an allocated block to memory. The mode is kept across resizes.
+ *
+ * @param total_size The total size in bytes that the free list should track.
+ * @param mode The strategy the list should use to track free ranges.
+ * @param memory_requirement A pointer to hold memory requirement for the free list itself.
+ * @param memory 0, or a pre-allocated block of memory for the free list to use.
+ * @param out_list A pointer to hold the created free list.
+ */
+KAPI void freelist_create_with_mode(u64 total_size, freelist_mode mode, u64* memory_requirement, void* memory, freelist* out_list);
+
 /**
  * @brief Destroys the provided list.
  * 
@@ -62,6 +94,18 @@ KAPI b8 freelist_allocate_block(freelist* list, u64 size, u64* out_offset);
  */
 KAPI b8 freelist_free_block(freelist* list, u64 size, u64 offset);
 
+/**
+ * @brief Attempts to grow an allocated block in place, by claiming the given amount of memory
+ * directly after it. Only succeeds if that memory is free. Unlike allocation, failure is not an error.
+ *
+ * @param list A pointer to the list to allocate from.
+ * @param offset The offset of the allocated block.
+ * @param size The current size of the allocated block.
+ * @param extra_size The amount to grow the block by.
+ * @return True if the block was grown; otherwise false.
+ */
+KAPI b8 freelist_extend_block(freelist* list, u64 offset, u64 size, u64 extra_size);
+
 /**
  * @brief Attempts to resize the provided freelist to the given size. Internal data is copied to the new
  * block of memory. The old block must be freed after this call.
@@ -86,11 +130,22 @@ KAPI b8 freelist_resize(freelist* list, u64* memory_requirement, void* new_memor
 KAPI void freelist_clear(freelist* list);
 
 /**
- * @brief Returns the amount of free space in this list. NOTE: Since this has
- * to iterate the entire internal list, this can be an expensive operation.
- * Use sparingly.
+ * @brief Returns the amount of free space in this list. NOTE: For first-fit lists,
+ * this has to iterate the entire internal list, and can be an expensive operation.
+ * Use sparingly. Segregated-fit lists track this as they go.
  * 
  * @param list A pointer to the list to obtain from.
  * @return The amount of free space in bytes.
  */
 KAPI u64 freelist_free_space(freelist* list);
+
+/**
+ * @brief Returns how fragmented the free space in this list is, as 1 - (largest free
+ * range / total free space). 0 means all free space is in a single range, and values
+ * approaching 1 mean the free space is split into many small ranges. NOTE: For first-fit
+ * lists, this has to iterate the entire internal list. Use sparingly.
+ *
+ * @param list A pointer to the list to obtain from.
+ * @return The fragmentation in the range [0, 1]. 0 if there is no free space.
+ */
+KAPI f32 freelist_fragmentation(freelist* list);
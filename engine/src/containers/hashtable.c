@@ -1,8 +1,21 @@
 #include "hashtable.h"
 
 #include "core/kmemory.h"
+#include "core/kname.h"
+#include "core/kstring.h"
 #include "core/logger.h"
 
+// The smallest number of slots an open-addressing table will use.
+#define HASHTABLE_MIN_CAPACITY 8
+
+// An open-addressing slot. Values are kept in a separate array so that probing only touches slots.
+typedef struct hashtable_slot {
+    // 0 marks an empty slot.
+    u64 hash;
+    // Interned copy of the name.
+    char* key;
+} hashtable_slot;
+
 u64 hash_name(const char* name, u32 element_count) {
     // A multipler to use when generating a hash. Prime to hopefully avoid collisions.
     static const u64 multiplier = 97;
@@ -20,8 +33,141 @@ u64 hash_name(const char* name, u32 element_count) {
     return hash;
 }
 
+/**
+ * Open-addressing tables are laid out as the slots, then a value per slot, then three
+ * spare values: the fill value and two buffers used to swap entries while inserting.
+ */
+static u64 open_memory_requirement(u64 element_size, u32 capacity) {
+    return (sizeof(hashtable_slot) + element_size) * capacity + element_size * 3;
+}
+
+static void* open_value(const hashtable* table, u32 index) {
+    return (u8*)table->memory + sizeof(hashtable_slot) * table->element_count + table->element_size * index;
+}
+
+static void* open_fill_value(const hashtable* table) {
+    return open_value(table, table->element_count);
+}
+
+static u32 open_probe_distance(const hashtable* table, u32 index, u64 hash) {
+    return (index - (u32)hash) & (table->element_count - 1);
+}
+
+// Pass a name of 0 to match on the hash alone.
+static u32 open_find(const hashtable* table, const char* name, u64 hash) {
+    hashtable_slot* slots = table->memory;
+    u32 mask = table->element_count - 1;
+    for (u32 i = (u32)hash & mask, distance = 0;; i = (i + 1) & mask, ++distance) {
+        const hashtable_slot* slot = &slots[i];
+        // Entries are kept ordered by probe distance, so reaching one closer to its home slot ends the search.
+        if (!slot->hash || open_probe_distance(table, i, slot->hash) < distance) {
+            return INVALID_ID;
+        }
+        if (slot->hash == hash && (!name || strings_equal(slot->key, name))) {
+            return i;
+        }
+    }
+}
+
+// Inserts an entry known not to exist. Takes ownership of key.
+static void open_insert(hashtable* table, u64 hash, char* key, const void* value) {
+    hashtable_slot* slots = table->memory;
+    u32 mask = table->element_count - 1;
+    void* carried = open_value(table, table->element_count + 1);
+    void* swap = open_value(table, table->element_count + 2);
+    kcopy_memory(carried, value, table->element_size);
+    hashtable_slot entry = {hash, key};
+
+    for (u32 i = (u32)hash & mask, distance = 0;; i = (i + 1) & mask, ++distance) {
+        hashtable_slot* slot = &slots[i];
+        if (!slot->hash) {
+            *slot = entry;
+            kcopy_memory(open_value(table, i), carried, table->element_size);
+            table->entry_count++;
+            return;
+        }
+
+        u32 slot_distance = open_probe_distance(table, i, slot->hash);
+        if (slot_distance < distance) {
+            // Robin-hood: the carried entry is further from home, so it takes this slot and the resident moves on.
+            hashtable_slot displaced = *slot;
+            *slot = entry;
+            entry = displaced;
+            kcopy_memory(swap, open_value(table, i), table->element_size);
+            kcopy_memory(open_value(table, i), carried, table->element_size);
+            void* temp = carried;
+            carried = swap;
+            swap = temp;
+            distance = slot_distance;
+        }
+    }
+}
+
+static void open_resize(hashtable* table, u32 capacity) {
+    hashtable old = *table;
+    table->memory = kallocate(open_memory_requirement(table->element_size, capacity), MEMORY_TAG_DICT);
+    table->element_count = capacity;
+    table->entry_count = 0;
+    if (old.memory) {
+        kcopy_memory(open_fill_value(table), open_fill_value(&old), table->element_size);
+        hashtable_slot* old_slots = old.memory;
+        for (u32 i = 0; i < old.element_count; ++i) {
+            if (old_slots[i].hash) {
+                open_insert(table, old_slots[i].hash, old_slots[i].key, open_value(&old, i));
+            }
+        }
+        kfree(old.memory, open_memory_requirement(old.element_size, old.element_count), MEMORY_TAG_DICT);
+    }
+}
+
+static void open_set(hashtable* table, const char* name, const void* value) {
+    u64 hash = kname_create(name);
+    u32 index = open_find(table, name, hash);
+    if (index != INVALID_ID) {
+        kcopy_memory(open_value(table, index), value, table->element_size);
+        return;
+    }
+
+    if (open_find(table, 0, hash) != INVALID_ID) {
+        KWARN("hashtable: '%s' has the same hash as another name; kname lookups will only find one of them.", name);
+    }
+
+    // Keep the load at or below 80%, past which probe lengths grow quickly.
+    if ((u64)(table->entry_count + 1) * 5 > (u64)table->element_count * 4) {
+        open_resize(table, table->element_count * 2);
+    }
+    open_insert(table, hash, string_duplicate(name), value);
+}
+
+static b8 open_remove(hashtable* table, const char* name) {
+    u32 index = open_find(table, name, kname_create(name));
+    if (index == INVALID_ID) {
+        return false;
+    }
+
+    hashtable_slot* slots = table->memory;
+    u32 mask = table->element_count - 1;
+    kfree(slots[index].key, string_length(slots[index].key) + 1, MEMORY_TAG_STRING);
+
+    // Backward-shift deletion: pull following entries back until one sits in its home slot, so no tombstones are needed.
+    u32 next = (index + 1) & mask;
+    while (slots[next].hash && open_probe_distance(table, next, slots[next].hash) != 0) {
+        slots[index] = slots[next];
+        kcopy_memory(open_value(table, index), open_value(table, next), table->element_size);
+        index = next;
+        next = (next + 1) & mask;
+    }
+    kzero_memory(&slots[index], sizeof(hashtable_slot));
+    table->entry_count--;
+    return true;
+}
+
 void hashtable_create(u64 element_size, u32 element_count, void* memory, b8 is_pointer_type, hashtable* out_hashtable) {
-    if (!memory || !out_hashtable) {
+    hashtable_create_with_mode(element_size, element_count, HASHTABLE_MODE_DIRECT, memory, is_pointer_type, out_hashtable);
+}
+
+void hashtable_create_with_mode(u64 element_size, u32 element_count, hashtable_mode mode, void* memory, b8 is_pointer_type, hashtable* out_hashtable) {
+    if (!out_hashtable || (mode == HASHTABLE_MODE_DIRECT && !memory)) {
         KERROR("hashtable_create failed! Pointer to memory and out_hashtable are required.");
         return;
     }
@@ -30,16 +176,37 @@ void hashtable_create(u64 element_size, u32 element_count, void* memory, b8 is_p
         return;
     }
 
+    kzero_memory(out_hashtable, sizeof(hashtable));
+    out_hashtable->element_size = element_size;
+    out_hashtable->is_pointer_type = is_pointer_type;
+    out_hashtable->mode = mode;
+
+    if (mode == HASHTABLE_MODE_OPEN_ADDRESSING) {
+        u32 capacity = HASHTABLE_MIN_CAPACITY;
+        while ((u64)element_count * 5 > (u64)capacity * 4) {
+            capacity *= 2;
+        }
+        open_resize(out_hashtable, capacity);
+        return;
+    }
+
     // TODO: Might want to require an allocator and allocate this memory instead.
     out_hashtable->memory = memory;
     out_hashtable->element_count = element_count;
-    out_hashtable->element_size = element_size;
-    out_hashtable->is_pointer_type = is_pointer_type;
     kzero_memory(out_hashtable->memory, element_size * element_count);
 }
 
 void hashtable_destroy(hashtable* table) {
     if (table) {
+        if (table->mode == HASHTABLE_MODE_OPEN_ADDRESSING && table->memory) {
+            hashtable_slot* slots = table->memory;
+            for (u32 i = 0; i < table->element_count; ++i) {
+                if (slots[i].hash) {
+                    kfree(slots[i].key, string_length(slots[i].key) + 1, MEMORY_TAG_STRING);
+                }
+            }
+            kfree(table->memory, open_memory_requirement(table->element_size, table->element_count), MEMORY_TAG_DICT);
+        }
         // TODO: If using allocator above, free memory here.
         kzero_memory(table, sizeof(hashtable));
     }
@@ -55,6 +222,11 @@ b8 hashtable_set(hashtable* table, const char* name, void* value) {
         return false;
     }
 
+    if (table->mode == HASHTABLE_MODE_OPEN_ADDRESSING) {
+        open_set(table, name, value);
+        return true;
+    }
+
     u64 hash = hash_name(name, table->element_count);
     kcopy_memory(table->memory + (table->element_size * hash), value, table->element_size);
     return true;
@@ -70,6 +242,15 @@ b8 hashtable_set_ptr(hashtable* table, const char* name, void** value) {
         return false;
     }
 
+    if (table->mode == HASHTABLE_MODE_OPEN_ADDRESSING) {
+        if (value && *value) {
+            open_set(table, name, value);
+        } else {
+            open_remove(table, name);
+        }
+        return true;
+    }
+
     u64 hash = hash_name(name, table->element_count);
     ((void**)table->memory)[hash] = value ? *value : 0;
     return true;
@@ -84,6 +265,19 @@ b8 hashtable_get(hashtable* table, const char* name, void* out_value) {
         KERROR("hashtable_get should not be used with tables that have pointer types. Use hashtable_set_ptr instead.");
         return false;
     }
+    if (table->mode == HASHTABLE_MODE_OPEN_ADDRESSING) {
+        u32 index = open_find(table, name, kname_create(name));
+        if (index != INVALID_ID) {
+            kcopy_memory(out_value, open_value(table, index), table->element_size);
+            return true;
+        }
+        if (table->has_fill_value) {
+            kcopy_memory(out_value, open_fill_value(table), table->element_size);
+            return true;
+        }
+        return false;
+    }
+
     u64 hash = hash_name(name, table->element_count);
     kcopy_memory(out_value, table->memory + (table->element_size * hash), table->element_size);
     return true;
@@ -99,11 +293,62 @@ b8 hashtable_get_ptr(hashtable* table, const char* name, void** out_value) {
         return false;
     }
 
+    if (table->mode == HASHTABLE_MODE_OPEN_ADDRESSING) {
+        u32 index = open_find(table, name, kname_create(name));
+        *out_value = index != INVALID_ID ? *(void**)open_value(table, index) : 0;
+        return *out_value != 0;
+    }
+
     u64 hash = hash_name(name, table->element_count);
     *out_value = ((void**)table->memory)[hash];
     return *out_value != 0;
 }
 
+b8 hashtable_get_by_kname(hashtable* table, kname name, void* out_value) {
+    if (!table || name == INVALID_KNAME || !out_value) {
+        KWARN("hashtable_get_by_kname requires table, name and out_value to exist.");
+        return false;
+    }
+    if (table->is_pointer_type) {
+        KERROR("hashtable_get_by_kname should not be used with tables that have pointer types. Use hashtable_get_ptr_by_kname instead.");
+        return false;
+    }
+    if (table->mode != HASHTABLE_MODE_OPEN_ADDRESSING) {
+        KERROR("hashtable_get_by_kname is only supported by tables using HASHTABLE_MODE_OPEN_ADDRESSING.");
+        return false;
+    }
+
+    u32 index = open_find(table, 0, name);
+    if (index != INVALID_ID) {
+        kcopy_memory(out_value, open_value(table, index), table->element_size);
+        return true;
+    }
+    if (table->has_fill_value) {
+        kcopy_memory(out_value, open_fill_value(table), table->element_size);
+        return true;
+    }
+    return false;
+}
+
+b8 hashtable_get_ptr_by_kname(hashtable* table, kname name, void** out_value) {
+    if (!table || name == INVALID_KNAME || !out_value) {
+        KWARN("hashtable_get_ptr_by_kname requires table, name and out_value to exist.");
+        return false;
+    }
+    if (!table->is_pointer_type) {
+        KERROR("hashtable_get_ptr_by_kname should not be used with tables that do not have pointer types. Use hashtable_get_by_kname instead.");
+        return false;
+    }
+    if (table->mode != HASHTABLE_MODE_OPEN_ADDRESSING) {
+        KERROR("hashtable_get_ptr_by_kname is only supported by tables using HASHTABLE_MODE_OPEN_ADDRESSING.");
+        return false;
+    }
+
+    u32 index = open_find(table, 0, name);
+    *out_value = index != INVALID_ID ? *(void**)open_value(table, index) : 0;
+    return *out_value != 0;
+}
+
 b8 hashtable_fill(hashtable* table, void* value) {
     if (!table || !value) {
         KWARN("hashtable_fill requires table and value to exist.");
@@ -114,9 +359,28 @@ b8 hashtable_fill(hashtable* table, void* value) {
         return false;
     }
 
+    if (table->mode == HASHTABLE_MODE_OPEN_ADDRESSING) {
+        kcopy_memory(open_fill_value(table), value, table->element_size);
+        table->has_fill_value = true;
+        return true;
+    }
+
     for (u32 i = 0; i < table->element_count; ++i) {
         kcopy_memory(table->memory + (table->element_size * i), value, table->element_size);
     }
 
     return true;
 }
+
+b8 hashtable_remove(hashtable* table, const char* name) {
+    if (!table || !name) {
+        KWARN("hashtable_remove requires table and name to exist.");
+        return false;
+    }
+    if (table->mode != HASHTABLE_MODE_OPEN_ADDRESSING) {
+        KERROR("hashtable_remove is only supported by tables using HASHTABLE_MODE_OPEN_ADDRESSING.");
+        return false;
+    }
+
+    return open_remove(table, name);
+}
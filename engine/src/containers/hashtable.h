@@ -12,6 +12,26 @@
 #pragma once
 
 #include "defines.h"
+#include "core/kname.h"
+
+/**
+ * @brief The strategy a hashtable uses to place entries.
+ */
+typedef enum hashtable_mode {
+    /**
+     * @brief Names are hashed straight to a slot of a fixed-size block provided by the
+     * caller. Keys are not stored, so names which hash to the same slot overwrite each
+     * other. Cheap, but only safe for tables much larger than the number of names.
+     */
+    HASHTABLE_MODE_DIRECT,
+    /**
+     * @brief Robin-hood open addressing. Each entry keeps its hash and an interned copy
+     * of its name, so collisions are resolved by probing, and the caller's string need
+     * not outlive the entry. Hashes are knames, so entries can also be looked up by kname. The table owns its memory and doubles in size whenever
+     * it would exceed 80% load. Entries can be removed.
+     */
+    HASHTABLE_MODE_OPEN_ADDRESSING
+} hashtable_mode;
 
 /**
  * @brief Represents a simple hashtable. Members of this structure
@@ -24,9 +44,15 @@
  */
 typedef struct hashtable {
     u64 element_size;
+    /** @brief The number of slots. Fixed in direct mode; grows in open-addressing mode. */
     u32 element_count;
     b8 is_pointer_type;
     void* memory;
+    hashtable_mode mode;
+    /** @brief The number of entries currently stored. Only tracked in open-addressing mode. */
+    u32 entry_count;
+    /** @brief Indicates if a fill value is held, to be returned for missing names. Open-addressing mode only. */
+    b8 has_fill_value;
 } hashtable;
 
 /**
@@ -40,8 +66,21 @@ typedef struct hashtable {
  */
 KAPI void hashtable_create(u64 element_size, u32 element_count, void* memory, b8 is_pointer_type, hashtable* out_hashtable);
 
+/**
+ * @brief Creates a hashtable using the given mode and stores it in out_hashtable.
+ *
+ * @param element_size The size of each element in bytes.
+ * @param element_count For direct mode, the number of slots. For open-addressing mode, the number of entries to make room for up front.
+ * @param mode The strategy the table should use to place entries.
+ * @param memory For direct mode, a block of element_size * element_count bytes. Open-addressing tables own their memory, so pass 0.
+ * @param is_pointer_type Indicates if this hashtable will hold pointer types.
+ * @param out_hashtable A pointer to a hashtable in which to hold relevant data.
+ */
+KAPI void hashtable_create_with_mode(u64 element_size, u32 element_count, hashtable_mode mode, void* memory, b8 is_pointer_type, hashtable* out_hashtable);
+
 /**
  * @brief Destroys the provided hashtable. Does not release memory for pointer types.
+ * Open-addressing tables also release their own memory and interned names.
  * 
  * @param table A pointer to the table to be destroyed.
  */
@@ -64,7 +103,7 @@ KAPI b8 hashtable_set(hashtable* table, const char* name, void* value);
  * 
  * @param table A pointer to the table to get from. Required.
  * @param name The name of the entry to set. Required.
- * @param value A pointer value to be set. Can pass 0 to 'unset' an entry.
+ * @param value A pointer value to be set. Can pass 0 to 'unset' an entry, which removes it in open-addressing mode.
  * @return True; or false if a null pointer is passed or if the entry is 0.
  */
 KAPI b8 hashtable_set_ptr(hashtable* table, const char* name, void** value);
@@ -76,7 +115,8 @@ KAPI b8 hashtable_set_ptr(hashtable* table, const char* name, void** value);
  * @param table A pointer to the table to retrieved from. Required.
  * @param name The name of the entry to retrieved. Required.
  * @param value A pointer to store the retrieved value. Required.
- * @return True; or false if a null pointer is passed.
+ * @return True; or false if a null pointer is passed. In open-addressing mode, a missing
+ * name yields the fill value and true if one was set; otherwise false.
  */
 KAPI b8 hashtable_get(hashtable* table, const char* name, void* out_value);
 
@@ -91,13 +131,47 @@ KAPI b8 hashtable_get(hashtable* table, const char* name, void* out_value);
  */
 KAPI b8 hashtable_get_ptr(hashtable* table, const char* name, void** out_value);
 
+/**
+ * @brief Obtains a copy of data present in the hashtable by pre-hashed name, without hashing
+ * or comparing strings. Only supported in open-addressing mode, and only use for tables
+ * which were *NOT* created with is_pointer_type = true.
+ *
+ * @param table A pointer to the table to retrieved from. Required.
+ * @param name The kname of the entry to retrieved. Required.
+ * @param out_value A pointer to store the retrieved value. Required.
+ * @return True if found, or the fill value was copied instead; otherwise false.
+ */
+KAPI b8 hashtable_get_by_kname(hashtable* table, kname name, void* out_value);
+
+/**
+ * @brief Obtains a pointer to data present in the hashtable by pre-hashed name, without hashing
+ * or comparing strings. Only supported in open-addressing mode, and only use for tables
+ * which were created with is_pointer_type = true.
+ *
+ * @param table A pointer to the table to retrieved from. Required.
+ * @param name The kname of the entry to retrieved. Required.
+ * @param out_value A pointer to store the retrieved value. Required.
+ * @return True if retrieved successfully; otherwise false.
+ */
+KAPI b8 hashtable_get_ptr_by_kname(hashtable* table, kname name, void** out_value);
+
 /**
  * @brief Fills all entries in the hashtable with the given value.
  * Useful when non-existent names should return some default value.
- * Should not be used with pointer table types.
+ * Should not be used with pointer table types. In open-addressing mode,
+ * the value is kept and copied out by hashtable_get for missing names.
  * 
  * @param table A pointer to the table filled. Required.
  * @param value The value to be filled with. Required.
  * @return True if successful; otherwise false.
  */
 KAPI b8 hashtable_fill(hashtable* table, void* value);
+
+/**
+ * @brief Removes the entry with the given name. Only supported in open-addressing mode.
+ *
+ * @param table A pointer to the table to remove from. Required.
+ * @param name The name of the entry to remove. Required.
+ * @return True if an entry was removed; otherwise false.
+ */
+KAPI b8 hashtable_remove(hashtable* table, const char* name);
@@ -0,0 +1,154 @@
+#include "mpmc_queue.h"
+
+#include "core/katomic.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+static u32 cell_size_get(u32 stride) {
+    // The sequence number leads each cell, so cells must stay aligned for it.
+    return (u32)get_aligned(sizeof(u64) + stride, sizeof(u64));
+}
+
+static u64* cell_at(const mpmc_queue* queue, u64 position) {
+    return (u64*)((u8*)queue->block + (position & (queue->capacity - 1)) * queue->cell_size);
+}
+
+u64 mpmc_queue_memory_requirement(u32 stride, u32 capacity) {
+    return (u64)cell_size_get(stride) * capacity;
+}
+
+b8 mpmc_queue_create(u32 stride, u32 capacity, void* memory, mpmc_queue* out_queue) {
+    if (!out_queue) {
+        KERROR("mpmc_queue_create requires a valid pointer to hold the queue.");
+        return false;
+    }
+    if (stride == 0 || capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        KERROR("mpmc_queue_create requires a non-zero stride and a power of 2 capacity (got %u).", capacity);
+        return false;
+    }
+
+    kzero_memory(out_queue, sizeof(mpmc_queue));
+    out_queue->stride = stride;
+    out_queue->capacity = capacity;
+    out_queue->cell_size = cell_size_get(stride);
+    if (memory) {
+        out_queue->owns_memory = false;
+        out_queue->block = memory;
+    } else {
+        out_queue->owns_memory = true;
+        out_queue->block = kallocate(mpmc_queue_memory_requirement(stride, capacity), MEMORY_TAG_RING_QUEUE);
+    }
+
+    // Each cell starts out free for the first lap.
+    for (u32 i = 0; i < capacity; ++i) {
+        *cell_at(out_queue, i) = i;
+    }
+    return true;
+}
+
+void mpmc_queue_destroy(mpmc_queue* queue) {
+    if (queue) {
+        if (queue->owns_memory) {
+            kfree(queue->block, mpmc_queue_memory_requirement(queue->stride, queue->capacity), MEMORY_TAG_RING_QUEUE);
+        }
+        kzero_memory(queue, sizeof(mpmc_queue));
+    }
+}
+
+b8 mpmc_queue_try_push(mpmc_queue* queue, const void* value) {
+    if (!queue || !queue->block || !value) {
+        KERROR("mpmc_queue_try_push requires valid pointers to queue and value.");
+        return false;
+    }
+
+    u64 pos = katomic_load_relaxed(&queue->enqueue_pos);
+    u64* cell;
+    while (true) {
+        cell = cell_at(queue, pos);
+        u64 sequence = katomic_load_acquire(cell);
+        i64 diff = (i64)sequence - (i64)pos;
+        if (diff == 0) {
+            // The cell is free for this position, try to claim it.
+            if (katomic_compare_exchange(&queue->enqueue_pos, &pos, pos + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // The cell still holds a value from a lap ago, so the queue is full.
+            return false;
+        } else {
+            // Another producer claimed this position, try the next one.
+            pos = katomic_load_relaxed(&queue->enqueue_pos);
+        }
+    }
+
+    kcopy_memory(cell + 1, value, queue->stride);
+    // Publish the value to the consumers.
+    katomic_store_release(cell, pos + 1);
+    return true;
+}
+
+b8 mpmc_queue_try_pop(mpmc_queue* queue, void* out_value) {
+    if (!queue || !queue->block || !out_value) {
+        KERROR("mpmc_queue_try_pop requires valid pointers to queue and out_value.");
+        return false;
+    }
+
+    u64 pos = katomic_load_relaxed(&queue->dequeue_pos);
+    u64* cell;
+    while (true) {
+        cell = cell_at(queue, pos);
+        u64 sequence = katomic_load_acquire(cell);
+        i64 diff = (i64)sequence - (i64)(pos + 1);
+        if (diff == 0) {
+            // A value is published for this position, try to claim it.
+            if (katomic_compare_exchange(&queue->dequeue_pos, &pos, pos + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Nothing published in this cell yet, so the queue is empty.
+            return false;
+        } else {
+            // Another consumer claimed this position, try the next one.
+            pos = katomic_load_relaxed(&queue->dequeue_pos);
+        }
+    }
+
+    kcopy_memory(out_value, cell + 1, queue->stride);
+    // Hand the cell back to the producers for the next lap.
+    katomic_store_release(cell, pos + queue->capacity);
+    return true;
+}
+
+u32 mpmc_queue_push_batch(mpmc_queue* queue, const void* values, u32 count) {
+    if (!queue || !values) {
+        KERROR("mpmc_queue_push_batch requires valid pointers to queue and values.");
+        return 0;
+    }
+    u32 pushed = 0;
+    while (pushed < count && mpmc_queue_try_push(queue, (const u8*)values + (u64)pushed * queue->stride)) {
+        pushed++;
+    }
+    return pushed;
+}
+
+u32 mpmc_queue_pop_batch(mpmc_queue* queue, void* out_values, u32 count) {
+    if (!queue || !out_values) {
+        KERROR("mpmc_queue_pop_batch requires valid pointers to queue and out_values.");
+        return 0;
+    }
+    u32 popped = 0;
+    while (popped < count && mpmc_queue_try_pop(queue, (u8*)out_values + (u64)popped * queue->stride)) {
+        popped++;
+    }
+    return popped;
+}
+
+u32 mpmc_queue_length(const mpmc_queue* queue) {
+    if (!queue) {
+        return 0;
+    }
+    // Positions only move forward, so reading the dequeue position first keeps the difference from going negative.
+    u64 dequeue_pos = katomic_load_acquire(&queue->dequeue_pos);
+    u64 enqueue_pos = katomic_load_relaxed(&queue->enqueue_pos);
+    return (u32)(enqueue_pos - dequeue_pos);
+}
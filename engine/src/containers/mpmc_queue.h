@@ -0,0 +1,120 @@
+/**
+ * @file mpmc_queue.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Contains the implementation of a lock-free multi-producer, multi-consumer queue.
+ * @details A bounded first in, first out queue which any number of threads may push
+ * to and pop from at once without locks. Each cell carries a sequence number which
+ * tells producers and consumers whose turn it is to use it, so a thread only ever
+ * contends on the position it is claiming. The enqueue and dequeue positions live on
+ * separate cache lines. Does not resize.
+ * @version 1.0
+ *
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief The multi-producer, multi-consumer queue structure. */
+typedef struct mpmc_queue {
+    /** @brief The size of each element in bytes. */
+    u32 stride;
+    /** @brief The total number of elements available. Always a power of 2. */
+    u32 capacity;
+    /** @brief The size of each cell in bytes: the sequence number followed by the element. */
+    u32 cell_size;
+    /** @brief The block of memory to hold the cells. */
+    void* block;
+    /** @brief Indicates if the queue owns its memory block. */
+    b8 owns_memory;
+
+    // Keeps the positions below off the line holding the fields above, which every thread reads.
+    u8 padding0[KCACHE_LINE_SIZE];
+    /** @brief The position of the next element to be pushed. Shared by all producers. */
+    u64 enqueue_pos;
+    u8 padding1[KCACHE_LINE_SIZE - sizeof(u64)];
+    /** @brief The position of the next element to be popped. Shared by all consumers. */
+    u64 dequeue_pos;
+    u8 padding2[KCACHE_LINE_SIZE - sizeof(u64)];
+} mpmc_queue;
+
+/**
+ * @brief Obtains the size of the memory block a queue of the given stride and capacity requires.
+ *
+ * @param stride The size of each element in bytes.
+ * @param capacity The total number of elements to be available in the queue.
+ * @return The required size in bytes. The block should be aligned to at least 8 bytes.
+ */
+KAPI u64 mpmc_queue_memory_requirement(u32 stride, u32 capacity);
+
+/**
+ * @brief Creates a new multi-producer, multi-consumer queue. Not thread-safe.
+ *
+ * @param stride The size of each element in bytes.
+ * @param capacity The total number of elements to be available in the queue. Must be a power of 2.
+ * @param memory The memory block used to hold the data, of the size given by
+ * mpmc_queue_memory_requirement. If 0 is passed, a block is automatically allocated
+ * and freed upon creation/destruction.
+ * @param out_queue A pointer to hold the newly created queue.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 mpmc_queue_create(u32 stride, u32 capacity, void* memory, mpmc_queue* out_queue);
+
+/**
+ * @brief Destroys the given queue. If memory was not passed in during creation,
+ * it is freed here. Not thread-safe.
+ *
+ * @param queue A pointer to the queue to destroy.
+ */
+KAPI void mpmc_queue_destroy(mpmc_queue* queue);
+
+/**
+ * @brief Attempts to add a value to the queue.
+ *
+ * @param queue A pointer to the queue.
+ * @param value A pointer to the value to be copied in.
+ * @return True if the value was added; false if the queue is full.
+ */
+KAPI b8 mpmc_queue_try_push(mpmc_queue* queue, const void* value);
+
+/**
+ * @brief Attempts to retrieve the next value from the queue.
+ *
+ * @param queue A pointer to the queue.
+ * @param out_value A pointer to hold the retrieved value.
+ * @return True if a value was retrieved; false if the queue is empty.
+ */
+KAPI b8 mpmc_queue_try_pop(mpmc_queue* queue, void* out_value);
+
+/**
+ * @brief Adds as many of the given values as fit. Values are claimed one at a time,
+ * so those pushed by other producers at the same time may be interleaved with them.
+ *
+ * @param queue A pointer to the queue.
+ * @param values A pointer to count tightly packed values.
+ * @param count The number of values to add.
+ * @return The number of values added, from the front of values.
+ */
+KAPI u32 mpmc_queue_push_batch(mpmc_queue* queue, const void* values, u32 count);
+
+/**
+ * @brief Retrieves up to count values, stopping early if the queue runs empty.
+ *
+ * @param queue A pointer to the queue.
+ * @param out_values A pointer to hold up to count tightly packed values.
+ * @param count The max number of values to retrieve.
+ * @return The number of values retrieved.
+ */
+KAPI u32 mpmc_queue_pop_batch(mpmc_queue* queue, void* out_values, u32 count);
+
+/**
+ * @brief Obtains the number of values in the queue, including those still being
+ * written or read. Only approximate while other threads are active.
+ *
+ * @param queue A constant pointer to the queue.
+ * @return The number of values in the queue.
+ */
+KAPI u32 mpmc_queue_length(const mpmc_queue* queue);
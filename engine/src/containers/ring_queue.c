@@ -83,3 +83,32 @@ b8 ring_queue_peek(const ring_queue* queue, void* out_value) {
     KERROR("ring_queue_peek requires valid pointers to queue and out_value.");
     return false;
 }
+
+b8 ring_queue_resize(ring_queue* queue, u32 new_capacity) {
+    if (!queue) {
+        KERROR("ring_queue_resize requires a valid pointer to queue.");
+        return false;
+    }
+    if (!queue->owns_memory) {
+        KERROR("ring_queue_resize - Cannot resize a ring queue which does not own its memory: %p", queue);
+        return false;
+    }
+    if (new_capacity < queue->length || new_capacity == 0) {
+        KERROR("ring_queue_resize - New capacity %u cannot hold the %u elements in the queue: %p", new_capacity, queue->length, queue);
+        return false;
+    }
+
+    // Copy the elements over in order, so the head ends up at the start of the new block.
+    void* new_block = kallocate(new_capacity * queue->stride, MEMORY_TAG_RING_QUEUE);
+    for (u32 i = 0; i < queue->length; ++i) {
+        u32 index = (queue->head + i) % queue->capacity;
+        kcopy_memory(new_block + (i * queue->stride), queue->block + (index * queue->stride), queue->stride);
+    }
+    kfree(queue->block, queue->capacity * queue->stride, MEMORY_TAG_RING_QUEUE);
+
+    queue->block = new_block;
+    queue->capacity = new_capacity;
+    queue->head = 0;
+    queue->tail = (i32)queue->length - 1;
+    return true;
+}
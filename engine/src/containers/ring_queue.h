@@ -3,7 +3,8 @@
 #include "defines.h"
 
 /**
- * @brief Represents a ring queue of a particular size. Does not resize dynamically.
+ * @brief Represents a ring queue of a particular size. Does not resize dynamically,
+ * but may be resized explicitly (see ring_queue_resize) if it owns its memory.
  * Naturally, this is a first in, first out structure.
  */
 typedef struct ring_queue {
@@ -70,3 +71,13 @@ b8 ring_queue_dequeue(ring_queue* queue, void* out_value);
  * @return True if success; otherwise false.
  */
 b8 ring_queue_peek(const ring_queue* queue, void* out_value);
+
+/**
+ * @brief Changes the capacity of the queue, keeping its contents in order. Only
+ * queues which own their memory block can be resized.
+ *
+ * @param queue A pointer to the queue to resize.
+ * @param new_capacity The new total number of elements available. Must be at least the current length.
+ * @return True if success; otherwise false.
+ */
+b8 ring_queue_resize(ring_queue* queue, u32 new_capacity);
@@ -0,0 +1,139 @@
+#include "slot_map.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+static slot_handle make_handle(u32 index, u32 generation) {
+    return ((u64)generation << 32) | index;
+}
+
+static b8 handle_live(const slot_map* map, slot_handle handle) {
+    u32 index = slot_handle_index(handle);
+    // Generations are odd only while the slot is live, so a match on one means the element exists.
+    return handle != SLOT_HANDLE_INVALID && index < map->capacity && map->generations[index] == slot_handle_generation(handle) && (map->generations[index] & 1);
+}
+
+b8 slot_map_create(u64 element_size, u32 capacity, u64* memory_requirement, void* memory, slot_map* out_map) {
+    if (element_size == 0 || capacity == 0 || capacity == INVALID_ID) {
+        KERROR("slot_map_create requires a non-zero element_size and a valid, non-zero capacity. Create failed.");
+        return false;
+    }
+    if (!memory_requirement) {
+        KERROR("slot_map_create requires memory_requirement to exist. Create failed.");
+        return false;
+    }
+
+    // Elements first, so they keep the alignment of the block, then the generation, sparse and dense arrays.
+    *memory_requirement = get_aligned(element_size * capacity, sizeof(u32)) + sizeof(u32) * capacity * 3;
+
+    // If only obtaining requirement, boot out.
+    if (!memory) {
+        return true;
+    }
+    if (!out_map) {
+        KERROR("slot_map_create requires a pointer to hold the map. Create failed.");
+        return false;
+    }
+
+    out_map->element_size = element_size;
+    out_map->capacity = capacity;
+    out_map->elements = memory;
+    out_map->generations = (u32*)((u8*)memory + get_aligned(element_size * capacity, sizeof(u32)));
+    out_map->sparse = out_map->generations + capacity;
+    out_map->dense = out_map->sparse + capacity;
+    kzero_memory(out_map->generations, sizeof(u32) * capacity);
+    out_map->count = 0;
+    slot_map_clear(out_map);
+    return true;
+}
+
+void slot_map_destroy(slot_map* map) {
+    if (map) {
+        kzero_memory(map, sizeof(slot_map));
+    }
+}
+
+slot_handle slot_map_insert(slot_map* map, const void* value) {
+    if (!map || !map->elements) {
+        KERROR("slot_map_insert - provided map not initialized.");
+        return SLOT_HANDLE_INVALID;
+    }
+    if (map->free_head == INVALID_ID) {
+        KERROR("slot_map_insert - map of %u slots is full.", map->capacity);
+        return SLOT_HANDLE_INVALID;
+    }
+
+    u32 index = map->free_head;
+    map->free_head = map->sparse[index];
+    map->sparse[index] = map->count;
+    map->dense[map->count] = index;
+    map->count++;
+    map->generations[index]++;
+
+    void* element = (u8*)map->elements + map->element_size * index;
+    if (value) {
+        kcopy_memory(element, value, map->element_size);
+    } else {
+        kzero_memory(element, map->element_size);
+    }
+    return make_handle(index, map->generations[index]);
+}
+
+b8 slot_map_remove(slot_map* map, slot_handle handle) {
+    if (!map || !handle_live(map, handle)) {
+        return false;
+    }
+
+    u32 index = slot_handle_index(handle);
+    // Keep the live elements packed by moving the last one into the hole.
+    u32 position = map->sparse[index];
+    u32 last = map->dense[map->count - 1];
+    map->dense[position] = last;
+    map->sparse[last] = position;
+    map->count--;
+
+    map->generations[index]++;
+    map->sparse[index] = map->free_head;
+    map->free_head = index;
+    return true;
+}
+
+void* slot_map_get(const slot_map* map, slot_handle handle) {
+    if (!map || !handle_live(map, handle)) {
+        return 0;
+    }
+    return (u8*)map->elements + map->element_size * slot_handle_index(handle);
+}
+
+slot_handle slot_map_handle_at(const slot_map* map, u32 dense_index) {
+    if (!map || dense_index >= map->count) {
+        return SLOT_HANDLE_INVALID;
+    }
+    u32 index = map->dense[dense_index];
+    return make_handle(index, map->generations[index]);
+}
+
+void* slot_map_element_at(const slot_map* map, u32 dense_index) {
+    if (!map || dense_index >= map->count) {
+        return 0;
+    }
+    return (u8*)map->elements + map->element_size * map->dense[dense_index];
+}
+
+void slot_map_clear(slot_map* map) {
+    if (!map || !map->elements) {
+        return;
+    }
+
+    // Retire the live slots' generations.
+    for (u32 i = 0; i < map->count; ++i) {
+        map->generations[map->dense[i]]++;
+    }
+    map->count = 0;
+
+    // Chain every slot into the free list in order, so that slots are handed out from the front.
+    for (u32 i = 0; i < map->capacity; ++i) {
+        map->sparse[i] = i + 1 < map->capacity ? i + 1 : INVALID_ID;
+    }
+    map->free_head = 0;
+}
@@ -0,0 +1,135 @@
+/**
+ * @file slot_map.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Contains the implementation of the slot map.
+ * @details A slot map holds a fixed number of elements of a single size, each
+ * addressed by a generational handle. Inserting, removing and looking up an element
+ * are all O(1): free slots are kept in a list, and each slot's generation is bumped
+ * whenever it is inserted into or removed from, so handles to removed elements stop
+ * resolving rather than aliasing whatever reuses the slot. Elements stay in place
+ * for their lifetime, so pointers to them remain valid until they are removed.
+ * Live elements are also tracked in a packed array of slot indices, so they can be
+ * iterated without visiting empty slots. Not thread-safe.
+ * @version 1.0
+ *
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief A generational handle to an element of a slot map. The low 32 bits hold
+ * the slot index, and the high 32 bits the generation the slot had when inserted.
+ */
+typedef u64 slot_handle;
+
+/** @brief A handle which never refers to an element. */
+#define SLOT_HANDLE_INVALID INVALID_ID_U64
+
+/** @brief Obtains the slot index of the given handle. */
+KINLINE u32 slot_handle_index(slot_handle handle) {
+    return (u32)(handle & 0xFFFFFFFF);
+}
+
+/** @brief Obtains the generation of the given handle. */
+KINLINE u32 slot_handle_generation(slot_handle handle) {
+    return (u32)(handle >> 32);
+}
+
+/** @brief The slot map structure. */
+typedef struct slot_map {
+    /** @brief The size of each element in bytes. */
+    u64 element_size;
+    /** @brief The total number of slots. */
+    u32 capacity;
+    /** @brief The number of live elements. */
+    u32 count;
+    /** @brief The first free slot, or INVALID_ID if the map is full. */
+    u32 free_head;
+    /** @brief The element storage, one per slot. */
+    void* elements;
+    /** @brief The generation of each slot. Odd while the slot holds an element. */
+    u32* generations;
+    /** @brief For live slots, the position of the slot in dense. For free slots, the next free slot. */
+    u32* sparse;
+    /** @brief The slot indices of the live elements, packed in the first count entries. */
+    u32* dense;
+} slot_map;
+
+/**
+ * @brief Creates a new slot map. Should be called twice; once to obtain the memory
+ * amount required (passing memory=0), and a second time with memory being set to an allocated block.
+ *
+ * @param element_size The size in bytes of each element.
+ * @param capacity The total number of elements the map should hold.
+ * @param memory_requirement A pointer to hold the required memory for the map.
+ * @param memory An allocated block of memory, or 0 if just obtaining the requirement.
+ * @param out_map A pointer to hold the slot map.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 slot_map_create(u64 element_size, u32 capacity, u64* memory_requirement, void* memory, slot_map* out_map);
+
+/**
+ * @brief Destroys the given slot map. The memory passed at creation is not freed.
+ *
+ * @param map A pointer to the map to be destroyed.
+ */
+KAPI void slot_map_destroy(slot_map* map);
+
+/**
+ * @brief Inserts an element into the given map.
+ *
+ * @param map A pointer to the map to insert into.
+ * @param value The data to copy into the new element. If 0, the element is zeroed.
+ * @return A handle to the new element, or SLOT_HANDLE_INVALID if the map is full.
+ */
+KAPI slot_handle slot_map_insert(slot_map* map, const void* value);
+
+/**
+ * @brief Removes the element referred to by the given handle. Handles to it no longer resolve.
+ *
+ * @param map A pointer to the map to remove from.
+ * @param handle The handle of the element to remove.
+ * @return True if the element was removed; false if the handle did not refer to a live element.
+ */
+KAPI b8 slot_map_remove(slot_map* map, slot_handle handle);
+
+/**
+ * @brief Obtains the element referred to by the given handle.
+ *
+ * @param map A pointer to the map.
+ * @param handle The handle of the element.
+ * @return A pointer to the element, or 0 if the handle does not refer to a live element.
+ */
+KAPI void* slot_map_get(const slot_map* map, slot_handle handle);
+
+/**
+ * @brief Obtains the handle of the live element at the given position in the packed array
+ * of live elements. Use with slot_map_element_at to iterate live elements, from 0 to count.
+ * Removing an element moves the last live element into its position.
+ *
+ * @param map A pointer to the map.
+ * @param dense_index The position, which must be less than count.
+ * @return The handle of the element at that position.
+ */
+KAPI slot_handle slot_map_handle_at(const slot_map* map, u32 dense_index);
+
+/**
+ * @brief Obtains the live element at the given position in the packed array of live elements.
+ *
+ * @param map A pointer to the map.
+ * @param dense_index The position, which must be less than count.
+ * @return A pointer to the element at that position.
+ */
+KAPI void* slot_map_element_at(const slot_map* map, u32 dense_index);
+
+/**
+ * @brief Removes every element from the map at once. Existing handles no longer resolve.
+ *
+ * @param map A pointer to the map to clear.
+ */
+KAPI void slot_map_clear(slot_map* map);
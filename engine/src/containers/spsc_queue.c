@@ -0,0 +1,123 @@
+#include "spsc_queue.h"
+
+#include "core/katomic.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+// Copies count elements into the queue starting at position, wrapping around the end of the block.
+static void copy_in(spsc_queue* queue, u64 position, const void* values, u32 count) {
+    u32 start = (u32)(position & (queue->capacity - 1));
+    u32 first = KMIN(count, queue->capacity - start);
+    kcopy_memory((u8*)queue->block + (u64)start * queue->stride, values, (u64)first * queue->stride);
+    if (first < count) {
+        kcopy_memory(queue->block, (const u8*)values + (u64)first * queue->stride, (u64)(count - first) * queue->stride);
+    }
+}
+
+// Copies count elements out of the queue starting at position, wrapping around the end of the block.
+static void copy_out(const spsc_queue* queue, u64 position, void* out_values, u32 count) {
+    u32 start = (u32)(position & (queue->capacity - 1));
+    u32 first = KMIN(count, queue->capacity - start);
+    kcopy_memory(out_values, (const u8*)queue->block + (u64)start * queue->stride, (u64)first * queue->stride);
+    if (first < count) {
+        kcopy_memory((u8*)out_values + (u64)first * queue->stride, queue->block, (u64)(count - first) * queue->stride);
+    }
+}
+
+b8 spsc_queue_create(u32 stride, u32 capacity, void* memory, spsc_queue* out_queue) {
+    if (!out_queue) {
+        KERROR("spsc_queue_create requires a valid pointer to hold the queue.");
+        return false;
+    }
+    if (stride == 0 || capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        KERROR("spsc_queue_create requires a non-zero stride and a power of 2 capacity (got %u).", capacity);
+        return false;
+    }
+
+    kzero_memory(out_queue, sizeof(spsc_queue));
+    out_queue->stride = stride;
+    out_queue->capacity = capacity;
+    if (memory) {
+        out_queue->owns_memory = false;
+        out_queue->block = memory;
+    } else {
+        out_queue->owns_memory = true;
+        out_queue->block = kallocate((u64)capacity * stride, MEMORY_TAG_RING_QUEUE);
+    }
+    return true;
+}
+
+void spsc_queue_destroy(spsc_queue* queue) {
+    if (queue) {
+        if (queue->owns_memory) {
+            kfree(queue->block, (u64)queue->capacity * queue->stride, MEMORY_TAG_RING_QUEUE);
+        }
+        kzero_memory(queue, sizeof(spsc_queue));
+    }
+}
+
+b8 spsc_queue_try_push(spsc_queue* queue, const void* value) {
+    return spsc_queue_push_batch(queue, value, 1) == 1;
+}
+
+b8 spsc_queue_try_pop(spsc_queue* queue, void* out_value) {
+    return spsc_queue_pop_batch(queue, out_value, 1) == 1;
+}
+
+u32 spsc_queue_push_batch(spsc_queue* queue, const void* values, u32 count) {
+    if (!queue || !queue->block || !values) {
+        KERROR("spsc_queue_push_batch requires valid pointers to queue and values.");
+        return 0;
+    }
+
+    u64 tail = katomic_load_relaxed(&queue->tail);
+    u32 space = queue->capacity - (u32)(tail - queue->cached_head);
+    if (space < count) {
+        // Only go to the consumer's line when the cached view says there isn't enough room.
+        queue->cached_head = katomic_load_acquire(&queue->head);
+        space = queue->capacity - (u32)(tail - queue->cached_head);
+    }
+    count = KMIN(count, space);
+    if (count == 0) {
+        return 0;
+    }
+
+    copy_in(queue, tail, values, count);
+    // Publish the values to the consumer.
+    katomic_store_release(&queue->tail, tail + count);
+    return count;
+}
+
+u32 spsc_queue_pop_batch(spsc_queue* queue, void* out_values, u32 count) {
+    if (!queue || !queue->block || !out_values) {
+        KERROR("spsc_queue_pop_batch requires valid pointers to queue and out_values.");
+        return 0;
+    }
+
+    u64 head = katomic_load_relaxed(&queue->head);
+    u32 available = (u32)(queue->cached_tail - head);
+    if (available < count) {
+        // Only go to the producer's line when the cached view says there isn't enough data.
+        queue->cached_tail = katomic_load_acquire(&queue->tail);
+        available = (u32)(queue->cached_tail - head);
+    }
+    count = KMIN(count, available);
+    if (count == 0) {
+        return 0;
+    }
+
+    copy_out(queue, head, out_values, count);
+    // Hand the slots back to the producer.
+    katomic_store_release(&queue->head, head + count);
+    return count;
+}
+
+u32 spsc_queue_length(const spsc_queue* queue) {
+    if (!queue) {
+        return 0;
+    }
+    // Head never passes tail, so reading it first keeps the difference from going negative.
+    u64 head = katomic_load_acquire(&queue->head);
+    u64 tail = katomic_load_acquire(&queue->tail);
+    return (u32)(tail - head);
+}
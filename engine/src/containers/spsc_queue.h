@@ -0,0 +1,112 @@
+/**
+ * @file spsc_queue.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Contains the implementation of a lock-free single-producer, single-consumer queue.
+ * @details A bounded first in, first out queue which is safe to use without locks
+ * as long as exactly one thread pushes and exactly one thread pops. The producer
+ * and consumer indices live on separate cache lines, and each side keeps a cached
+ * copy of the other side's index so the shared line is only read when the queue
+ * looks full (or empty). Does not resize.
+ * @version 1.0
+ *
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief The single-producer, single-consumer queue structure. */
+typedef struct spsc_queue {
+    /** @brief The size of each element in bytes. */
+    u32 stride;
+    /** @brief The total number of elements available. Always a power of 2. */
+    u32 capacity;
+    /** @brief The block of memory to hold the data. */
+    void* block;
+    /** @brief Indicates if the queue owns its memory block. */
+    b8 owns_memory;
+
+    // Keeps the indices below off the line holding the fields above, which both sides read.
+    u8 padding0[KCACHE_LINE_SIZE];
+    /** @brief The position of the next element to be pushed. Written only by the producer. */
+    u64 tail;
+    /** @brief The producer's last observed value of head. */
+    u64 cached_head;
+    u8 padding1[KCACHE_LINE_SIZE - sizeof(u64) * 2];
+    /** @brief The position of the next element to be popped. Written only by the consumer. */
+    u64 head;
+    /** @brief The consumer's last observed value of tail. */
+    u64 cached_tail;
+    u8 padding2[KCACHE_LINE_SIZE - sizeof(u64) * 2];
+} spsc_queue;
+
+/**
+ * @brief Creates a new single-producer, single-consumer queue.
+ *
+ * @param stride The size of each element in bytes.
+ * @param capacity The total number of elements to be available in the queue. Must be a power of 2.
+ * @param memory The memory block used to hold the data. Should be the size of
+ * stride * capacity. If 0 is passed, a block is automatically allocated and
+ * freed upon creation/destruction.
+ * @param out_queue A pointer to hold the newly created queue.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 spsc_queue_create(u32 stride, u32 capacity, void* memory, spsc_queue* out_queue);
+
+/**
+ * @brief Destroys the given queue. If memory was not passed in during creation,
+ * it is freed here.
+ *
+ * @param queue A pointer to the queue to destroy.
+ */
+KAPI void spsc_queue_destroy(spsc_queue* queue);
+
+/**
+ * @brief Attempts to add a value to the queue. Producer only.
+ *
+ * @param queue A pointer to the queue.
+ * @param value A pointer to the value to be copied in.
+ * @return True if the value was added; false if the queue is full.
+ */
+KAPI b8 spsc_queue_try_push(spsc_queue* queue, const void* value);
+
+/**
+ * @brief Attempts to retrieve the next value from the queue. Consumer only.
+ *
+ * @param queue A pointer to the queue.
+ * @param out_value A pointer to hold the retrieved value.
+ * @return True if a value was retrieved; false if the queue is empty.
+ */
+KAPI b8 spsc_queue_try_pop(spsc_queue* queue, void* out_value);
+
+/**
+ * @brief Adds as many of the given values as fit, publishing them all at once. Producer only.
+ *
+ * @param queue A pointer to the queue.
+ * @param values A pointer to count tightly packed values.
+ * @param count The number of values to add.
+ * @return The number of values added, from the front of values.
+ */
+KAPI u32 spsc_queue_push_batch(spsc_queue* queue, const void* values, u32 count);
+
+/**
+ * @brief Retrieves up to count values at once. Consumer only.
+ *
+ * @param queue A pointer to the queue.
+ * @param out_values A pointer to hold up to count tightly packed values.
+ * @param count The max number of values to retrieve.
+ * @return The number of values retrieved.
+ */
+KAPI u32 spsc_queue_pop_batch(spsc_queue* queue, void* out_values, u32 count);
+
+/**
+ * @brief Obtains the number of values in the queue. Only approximate while the
+ * other side is active.
+ *
+ * @param queue A constant pointer to the queue.
+ * @return The number of values in the queue.
+ */
+KAPI u32 spsc_queue_length(const spsc_queue* queue);
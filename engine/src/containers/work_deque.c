@@ -0,0 +1,125 @@
+#include "work_deque.h"
+
+#include "core/kmemory.h"
+#include "core/katomic.h"
+#include "core/logger.h"
+
+b8 work_deque_create(u32 stride, u32 capacity, void* memory, work_deque* out_deque) {
+    if (!out_deque) {
+        KERROR("work_deque_create requires a valid pointer to hold the deque.");
+        return false;
+    }
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        KERROR("work_deque_create requires a capacity that is a power of 2.");
+        return false;
+    }
+
+    out_deque->stride = stride;
+    out_deque->capacity = capacity;
+    out_deque->top = 0;
+    out_deque->bottom = 0;
+    if (memory) {
+        out_deque->owns_memory = false;
+        out_deque->block = memory;
+    } else {
+        out_deque->owns_memory = true;
+        out_deque->block = kallocate(capacity * stride, MEMORY_TAG_RING_QUEUE);
+    }
+
+    return true;
+}
+
+void work_deque_destroy(work_deque* deque) {
+    if (deque) {
+        if (deque->owns_memory) {
+            kfree(deque->block, deque->capacity * deque->stride, MEMORY_TAG_RING_QUEUE);
+        }
+        kzero_memory(deque, sizeof(work_deque));
+    }
+}
+
+static KINLINE void* element_at(work_deque* deque, i64 index) {
+    return (u8*)deque->block + ((u64)index & (deque->capacity - 1)) * deque->stride;
+}
+
+b8 work_deque_push(work_deque* deque, const void* value) {
+    if (!deque || !value) {
+        KERROR("work_deque_push requires valid pointers to deque and value.");
+        return false;
+    }
+
+    i64 bottom = katomic_load_relaxed(&deque->bottom);
+    i64 top = katomic_load_acquire(&deque->top);
+    if (bottom - top >= (i64)deque->capacity) {
+        // Full. Let the caller decide what to do with the value.
+        return false;
+    }
+
+    kcopy_memory(element_at(deque, bottom), value, deque->stride);
+    // Make sure the element is visible before thieves can see the new bottom.
+    katomic_thread_fence_release();
+    katomic_store_relaxed(&deque->bottom, bottom + 1);
+    return true;
+}
+
+b8 work_deque_pop(work_deque* deque, void* out_value) {
+    if (!deque || !out_value) {
+        KERROR("work_deque_pop requires valid pointers to deque and out_value.");
+        return false;
+    }
+
+    // Reserve the bottom element before looking at the top, so a thief
+    // cannot take the same element without one side noticing.
+    i64 bottom = katomic_load_relaxed(&deque->bottom) - 1;
+    katomic_store_relaxed(&deque->bottom, bottom);
+    katomic_thread_fence();
+    i64 top = katomic_load_relaxed(&deque->top);
+
+    if (top > bottom) {
+        // Empty, restore the bottom.
+        katomic_store_relaxed(&deque->bottom, bottom + 1);
+        return false;
+    }
+
+    kcopy_memory(out_value, element_at(deque, bottom), deque->stride);
+    if (top == bottom) {
+        // Last element. Race any thieves for it by advancing the top.
+        b8 won = katomic_compare_exchange(&deque->top, &top, top + 1);
+        katomic_store_relaxed(&deque->bottom, bottom + 1);
+        return won;
+    }
+
+    return true;
+}
+
+b8 work_deque_steal(work_deque* deque, pfn_work_deque_filter filter, void* filter_context, void* out_value) {
+    if (!deque || !out_value) {
+        KERROR("work_deque_steal requires valid pointers to deque and out_value.");
+        return false;
+    }
+
+    i64 top = katomic_load_acquire(&deque->top);
+    katomic_thread_fence();
+    i64 bottom = katomic_load_acquire(&deque->bottom);
+    if (top >= bottom) {
+        return false;
+    }
+
+    // NOTE: The copy may be stale if the owner wrapped around in the meantime,
+    // but in that case the top has moved and the exchange below fails.
+    kcopy_memory(out_value, element_at(deque, top), deque->stride);
+    if (filter && !filter(out_value, filter_context)) {
+        return false;
+    }
+
+    return katomic_compare_exchange(&deque->top, &top, top + 1);
+}
+
+u32 work_deque_length(work_deque* deque) {
+    if (!deque) {
+        return 0;
+    }
+    i64 top = katomic_load_acquire(&deque->top);
+    i64 bottom = katomic_load_acquire(&deque->bottom);
+    return bottom > top ? (u32)(bottom - top) : 0;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief A filter invoked on the element at the top of a deque before it is stolen.
+ * Return true to steal the element; otherwise false to leave it in the deque.
+ */
+typedef b8 (*pfn_work_deque_filter)(const void* value, void* context);
+
+/**
+ * @brief Represents a fixed-capacity, lock-free work-stealing deque (Chase-Lev).
+ * Does not resize dynamically. A single owning thread pushes and pops values at the
+ * bottom of the deque (last in, first out), while any other thread may steal values
+ * from the top (first in, first out).
+ */
+typedef struct work_deque {
+    /** @brief The size of each element in bytes. */
+    u32 stride;
+    /** @brief The total number of elements available. Always a power of 2. */
+    u32 capacity;
+    /** @brief The block of memory to hold the data. */
+    void* block;
+    /** @brief Indicates if the deque owns its memory block. */
+    b8 owns_memory;
+    /** @brief The index of the top of the deque. Advanced by thieves and the owner. */
+    i64 top;
+    /** @brief The index of the bottom of the deque. Only modified by the owner. */
+    i64 bottom;
+} work_deque;
+
+/**
+ * @brief Creates a new work deque of the given capacity and stride.
+ *
+ * @param stride The size of each element in bytes.
+ * @param capacity The total number of elements to be available in the deque. Must be a power of 2.
+ * @param memory The memory block used to hold the data. Should be the size of
+ * stride * capacity. If 0 is passed, a block is automatically allocated and
+ * freed upon creation/destruction.
+ * @param out_deque A pointer to hold the newly created deque.
+ * @returns True on success; otherwise false.
+ */
+b8 work_deque_create(u32 stride, u32 capacity, void* memory, work_deque* out_deque);
+
+/**
+ * @brief Destroys the given deque. If memory was not passed in during creation,
+ * it is freed here. Must not be called while other threads are using the deque.
+ *
+ * @param deque A pointer to the deque to destroy.
+ */
+void work_deque_destroy(work_deque* deque);
+
+/**
+ * @brief Pushes a value onto the bottom of the deque, if space is available.
+ * Must only be called from the owning thread.
+ *
+ * @param deque A pointer to the deque to add data to.
+ * @param value The value to be added.
+ * @return True if success; otherwise false.
+ */
+b8 work_deque_push(work_deque* deque, const void* value);
+
+/**
+ * @brief Attempts to pop the most recently pushed value from the bottom of the deque.
+ * Must only be called from the owning thread.
+ *
+ * @param deque A pointer to the deque to retrieve data from.
+ * @param out_value A pointer to hold the retrieved value.
+ * @return True if a value was retrieved; otherwise false.
+ */
+b8 work_deque_pop(work_deque* deque, void* out_value);
+
+/**
+ * @brief Attempts to steal the oldest value from the top of the deque. Safe to call from
+ * any thread. Fails if the deque is empty, if the filter rejects the value or if another
+ * thread took the value first.
+ *
+ * @param deque A pointer to the deque to retrieve data from.
+ * @param filter An optional filter used to decide whether the value should be stolen. Pass 0 if not used.
+ * @param filter_context Data passed to the filter. Optional.
+ * @param out_value A pointer to hold the retrieved value.
+ * @return True if a value was stolen; otherwise false.
+ */
+b8 work_deque_steal(work_deque* deque, pfn_work_deque_filter filter, void* filter_context, void* out_value);
+
+/**
+ * @brief Gets the approximate number of elements in the deque. Only exact when
+ * called from the owning thread while no other thread is stealing.
+ *
+ * @param deque A pointer to the deque.
+ * @return The number of elements in the deque.
+ */
+u32 work_deque_length(work_deque* deque);
@@ -4,6 +4,8 @@
 #include "version.h"
 
 #include "platform/platform.h"
+#include "platform/async_io.h"
+#include "platform/filesystem.h"
 #include "core/kmemory.h"
 #include "core/logger.h"
 #include "core/event.h"
@@ -12,10 +14,17 @@
 #include "core/kstring.h"
 #include "core/uuid.h"
 #include "core/metrics.h"
+#include "core/benchmark.h"
+#include "core/counters.h"
+#include "core/profiler.h"
+#include "core/katomic.h"
+#include "core/startup_graph.h"
 #include "containers/darray.h"
 
 #include "memory/linear_allocator.h"
+#include "memory/scratch_allocator.h"
 
+#include "renderer/render_capture.h"
 #include "renderer/renderer_frontend.h"
 
 // systems
@@ -25,18 +34,37 @@
 #include "systems/resource_system.h"
 #include "systems/shader_system.h"
 #include "systems/camera_system.h"
+#include "systems/light_system.h"
 #include "systems/render_view_system.h"
 #include "systems/job_system.h"
 #include "systems/font_system.h"
+#include "systems/hot_reload_system.h"
 
 typedef struct application_state {
     game* game_inst;
     b8 is_running;
     b8 is_suspended;
+    // Indicates if any of the window can be seen, and if it has focus.
+    b8 is_visible;
+    b8 has_focus;
+    // Indicates if job threads were parked while the window cannot be seen.
+    b8 job_threads_parked;
+    // The number of active job threads before they were parked, restored once the window can be seen.
+    u8 resumed_job_thread_count;
     i16 width;
     i16 height;
     clock clock;
     f64 last_time;
+    // The time passed which is not yet simulated by fixed steps.
+    f64 fixed_step_accumulator;
+    // The pipelined fixed steps running while the last frame was drawn, if any.
+    job_handle simulation_job;
+    // Set by the pipelined fixed steps if one of them failed.
+    b8 simulation_failed;
+    // Indicates if frames are drawn on a render thread.
+    b8 render_thread;
+    // The packet of the frame on the render thread, kept until the frame is drawn.
+    render_packet frame_packet;
     linear_allocator systems_allocator;
 
     u64 event_system_memory_requirement;
@@ -45,9 +73,15 @@ typedef struct application_state {
     u64 job_system_memory_requirement;
     void* job_system_state;
 
+    u64 async_io_system_memory_requirement;
+    void* async_io_system_state;
+
     u64 logging_system_memory_requirement;
     void* logging_system_state;
 
+    u64 profiler_memory_requirement;
+    void* profiler_state;
+
     u64 input_system_memory_requirement;
     void* input_system_state;
 
@@ -78,93 +112,103 @@ typedef struct application_state {
     u64 camera_system_memory_requirement;
     void* camera_system_state;
 
+    u64 light_system_memory_requirement;
+    void* light_system_state;
+
     u64 font_system_memory_requirement;
     void* font_system_state;
-} application_state;
 
-static application_state* app_state;
+    u64 hot_reload_system_memory_requirement;
+    // Only set while hot reloading.
+    void* hot_reload_system_state;
 
-// Event handlers
-b8 application_on_event(u16 code, void* sender, void* listener_inst, event_context context);
-b8 application_on_resized(u16 code, void* sender, void* listener_inst, event_context context);
+    u64 benchmark_memory_requirement;
+    // Only set while a benchmark is running.
+    void* benchmark_state;
 
-b8 application_create(game* game_inst) {
-    if (game_inst->application_state) {
-        KERROR("application_create called more than once.");
-        return false;
-    }
+    // Only set while a render capture is being replayed.
+    render_replay* replay;
+} application_state;
 
-    // Memory system must be the first thing to be stood up.
-    memory_system_configuration memory_system_config = {};
-    memory_system_config.total_alloc_size = GIBIBYTES(1);
-    if (!memory_system_initialize(memory_system_config)) {
-        KERROR("Failed to initialize memory system; shutting down.");
-        return false;
-    }
+static application_state* app_state;
 
-    // Seed the uuid generator.
-    // TODO: A better seed here.
-    uuid_seed(101);
+/** @brief The most fixed steps taken in a frame. After a hitch, the rest of the time is dropped rather than caught up on. */
+#define APPLICATION_MAX_FIXED_STEPS_PER_FRAME 8
 
-    // Metrics
-    metrics_initialize();
+/** @brief How long each pass of the loop sleeps while minimized, in milliseconds, as nothing is updated or drawn. */
+#define APPLICATION_SUSPENDED_SLEEP_MS 16
 
-    // Allocate the game state.
-    game_inst->state = kallocate(game_inst->state_memory_requirement, MEMORY_TAG_GAME);
+/** @brief The frame rate while the window is unfocused or hidden, unless configured. */
+#define APPLICATION_DEFAULT_BACKGROUND_FRAME_RATE 10
 
-    // Stand up the application state.
-    game_inst->application_state = kallocate(sizeof(application_state), MEMORY_TAG_APPLICATION);
-    app_state = game_inst->application_state;
-    app_state->game_inst = game_inst;
-    app_state->is_running = false;
-    app_state->is_suspended = false;
+typedef struct simulation_job_params {
+    u32 step_count;
+    f32 step_time;
+} simulation_job_params;
 
-    // Create a linear allocator for all systems (except memory) to use.
-    u64 systems_allocator_total_size = 64 * 1024 * 1024;  // 64 mb
-    linear_allocator_create(systems_allocator_total_size, 0, &app_state->systems_allocator);
+// Event handlers
+b8 application_on_event(u16 code, void* sender, void* listener_inst, event_context context);
+b8 application_on_resized(u16 code, void* sender, void* listener_inst, event_context context);
+b8 application_on_visibility_changed(u16 code, void* sender, void* listener_inst, event_context context);
 
-    // Initialize other subsystems.
+// Startup stages, in the order they are added to the startup graph in application_create.
 
-    // Events
+static b8 startup_events(void* user_data) {
     event_system_initialize(&app_state->event_system_memory_requirement, 0);
     app_state->event_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->event_system_memory_requirement);
     event_system_initialize(&app_state->event_system_memory_requirement, app_state->event_system_state);
 
-    // Logging
+    // Register for engine-level events.
+    event_register(EVENT_CODE_APPLICATION_QUIT, 0, application_on_event);
+    event_register(EVENT_CODE_RESIZED, 0, application_on_resized);
+    event_register(EVENT_CODE_WINDOW_VISIBILITY_CHANGED, 0, application_on_visibility_changed);
+    return true;
+}
+
+static b8 startup_logging(void* user_data) {
     initialize_logging(&app_state->logging_system_memory_requirement, 0);
     app_state->logging_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->logging_system_memory_requirement);
     if (!initialize_logging(&app_state->logging_system_memory_requirement, app_state->logging_system_state)) {
         KERROR("Failed to initialize logging system; shutting down.");
         return false;
     }
+    return true;
+}
 
-    // Input
+static b8 startup_profiler(void* user_data) {
+    profiler_initialize(&app_state->profiler_memory_requirement, 0);
+    app_state->profiler_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->profiler_memory_requirement);
+    profiler_initialize(&app_state->profiler_memory_requirement, app_state->profiler_state);
+    return true;
+}
+
+static b8 startup_input(void* user_data) {
     input_system_initialize(&app_state->input_system_memory_requirement, 0);
     app_state->input_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->input_system_memory_requirement);
     input_system_initialize(&app_state->input_system_memory_requirement, app_state->input_system_state);
+    return true;
+}
 
-    // Register for engine-level events.
-    event_register(EVENT_CODE_APPLICATION_QUIT, 0, application_on_event);
-    event_register(EVENT_CODE_RESIZED, 0, application_on_resized);
-
-    // Platform
+static b8 startup_platform(void* user_data) {
+    application_config* app_config = &app_state->game_inst->app_config;
     platform_system_startup(&app_state->platform_system_memory_requirement, 0, 0, 0, 0, 0, 0);
     app_state->platform_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->platform_system_memory_requirement);
-    if (!platform_system_startup(
-            &app_state->platform_system_memory_requirement,
-            app_state->platform_system_state,
-            game_inst->app_config.name,
-            game_inst->app_config.start_pos_x,
-            game_inst->app_config.start_pos_y,
-            game_inst->app_config.start_width,
-            game_inst->app_config.start_height)) {
-        return false;
-    }
+    return platform_system_startup(
+        &app_state->platform_system_memory_requirement,
+        app_state->platform_system_state,
+        app_config->name,
+        app_config->start_pos_x,
+        app_config->start_pos_y,
+        app_config->start_width,
+        app_config->start_height);
+}
 
-    // Resource system.
-    resource_system_config resource_sys_config;
+static b8 startup_resources(void* user_data) {
+    resource_system_config resource_sys_config = {};
     resource_sys_config.asset_base_path = "../assets";
     resource_sys_config.max_loader_count = 32;
+    resource_sys_config.max_cached_count = 256;
+    resource_sys_config.cache_budget = MEBIBYTES(16);
     resource_system_initialize(&app_state->resource_system_memory_requirement, 0, resource_sys_config);
     app_state->resource_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->resource_system_memory_requirement);
     if (!resource_system_initialize(&app_state->resource_system_memory_requirement, app_state->resource_system_state, resource_sys_config)) {
@@ -172,7 +216,16 @@ b8 application_create(game* game_inst) {
         return false;
     }
 
-    // Shader system
+    // Packed assets, if they have been built, are loaded from the archive rather than as loose files.
+    char archive_path[512];
+    string_format(archive_path, "%s/%s", resource_sys_config.asset_base_path, "assets.kpak");
+    if (filesystem_exists(archive_path) && !resource_system_mount_archive(archive_path)) {
+        KWARN("Failed to mount asset archive '%s'. Loose asset files will be used instead.", archive_path);
+    }
+    return true;
+}
+
+static b8 startup_shaders(void* user_data) {
     shader_system_config shader_sys_config;
     shader_sys_config.max_shader_count = 1024;
     shader_sys_config.max_uniform_count = 128;
@@ -184,25 +237,51 @@ b8 application_create(game* game_inst) {
         KFATAL("Failed to initialize shader system. Aborting application.");
         return false;
     }
+    return true;
+}
 
-    // Renderer system
-    renderer_system_initialize(&app_state->renderer_system_memory_requirement, 0, 0);
+static b8 startup_renderer(void* user_data) {
+    application_config* app_config = &app_state->game_inst->app_config;
+    renderer_swapchain_config swapchain = app_config->swapchain;
+    if (swapchain.present_mode == RENDERER_PRESENT_MODE_DEFAULT) {
+        swapchain.present_mode = app_config->frame_pacing == FRAME_PACING_PRESENT ? RENDERER_PRESENT_MODE_FIFO : RENDERER_PRESENT_MODE_MAILBOX;
+    }
+    // Benchmarks are never paced, including by the display.
+    if (app_config->benchmark.frame_count && swapchain.present_mode == RENDERER_PRESENT_MODE_FIFO) {
+        swapchain.present_mode = RENDERER_PRESENT_MODE_MAILBOX;
+    }
+    renderer_resolution_config resolution = app_config->resolution;
+    if (resolution.target_frame_ms <= 0.0f) {
+        resolution.target_frame_ms = 1000.0f / (app_config->target_frame_rate ? app_config->target_frame_rate : 60);
+    }
+    if (app_config->benchmark.frame_count) {
+        resolution.enabled = false;
+    }
+    renderer_system_initialize(&app_state->renderer_system_memory_requirement, 0, 0, &swapchain, &resolution);
     app_state->renderer_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->renderer_system_memory_requirement);
-    if (!renderer_system_initialize(&app_state->renderer_system_memory_requirement, app_state->renderer_system_state, game_inst->app_config.name)) {
+    if (!renderer_system_initialize(&app_state->renderer_system_memory_requirement, app_state->renderer_system_state, app_config->name, &swapchain, &resolution)) {
         KFATAL("Failed to initialize renderer. Aborting application.");
         return false;
     }
+    return true;
+}
 
-    b8 renderer_multithreaded = renderer_is_multithreaded();
-
+static b8 startup_game_boot(void* user_data) {
     // Perform the game's boot sequence.
-    if (!game_inst->boot(game_inst)) {
+    if (!app_state->game_inst->boot(app_state->game_inst)) {
         KFATAL("Game boot sequence failed; aborting application.");
         return false;
     }
 
     // Report engine version
     KINFO("Ignis Engine v. %s", KVERSION);
+    return true;
+}
+
+static b8 startup_jobs(void* user_data) {
+    // A render thread runs all renderer work, so GPU resource jobs can call the renderer from their own threads.
+    b8 render_thread = app_state->game_inst->app_config.render_thread;
+    b8 renderer_multithreaded = renderer_is_multithreaded() || render_thread;
 
     // This is really a core count. Subtract 1 to account for the main thread already being in use.
     i32 thread_count = platform_get_processor_count() - 1;
@@ -227,10 +306,10 @@ b8 application_create(game* game_inst) {
         job_thread_types[i] = JOB_TYPE_GENERAL;
     }
 
-    if (max_thread_count == 1 || !renderer_multithreaded) {
+    if (thread_count == 1 || !renderer_multithreaded) {
         // Everything on one job thread.
         job_thread_types[0] |= (JOB_TYPE_GPU_RESOURCE | JOB_TYPE_RESOURCE_LOAD);
-    } else if (max_thread_count == 2) {
+    } else if (thread_count == 2) {
         // Split things between the 2 threads
         job_thread_types[0] |= JOB_TYPE_GPU_RESOURCE;
         job_thread_types[1] |= JOB_TYPE_RESOURCE_LOAD;
@@ -240,41 +319,99 @@ b8 application_create(game* game_inst) {
         job_thread_types[1] = JOB_TYPE_RESOURCE_LOAD;
     }
 
-    job_system_initialize(&app_state->job_system_memory_requirement, 0, 0, 0);
+    // Pin the threads handling resource loads and GPU resources to performance cores, so that they
+    // do not end up on efficiency cores on hybrid CPUs. General job threads are left to the OS.
+    u64 job_thread_affinities[15] = {0};
+    platform_cpu_topology topology;
+    if (platform_get_cpu_topology(&topology)) {
+        KINFO("CPU topology: %u logical processors, %u physical cores (%u performance), %u NUMA node(s).",
+              topology.logical_count, topology.physical_count, topology.performance_count, topology.numa_node_count);
+        if (topology.is_hybrid && topology.has_processor_info) {
+            u64 performance_mask = 0;
+            for (u32 i = 0; i < topology.logical_count && i < 64; ++i) {
+                if (!topology.processors[i].is_efficiency) {
+                    performance_mask |= (1ULL << topology.processors[i].index);
+                }
+            }
+            for (i32 i = 0; i < thread_count; ++i) {
+                if (job_thread_types[i] & (JOB_TYPE_GPU_RESOURCE | JOB_TYPE_RESOURCE_LOAD)) {
+                    job_thread_affinities[i] = performance_mask;
+                }
+            }
+        }
+    }
+
+    job_system_initialize(&app_state->job_system_memory_requirement, 0, 0, 0, 0);
     app_state->job_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->job_system_memory_requirement);
-    if (!job_system_initialize(&app_state->job_system_memory_requirement, app_state->job_system_state, thread_count, job_thread_types)) {
+    if (!job_system_initialize(&app_state->job_system_memory_requirement, app_state->job_system_state, thread_count, job_thread_types, job_thread_affinities)) {
         KFATAL("Failed to initialize job system. Aborting application.");
         return false;
     }
+    // Benchmarks keep every thread, so their results stay comparable.
+    if (!app_state->game_inst->app_config.benchmark.frame_count) {
+        job_system_power_policy_set(app_state->game_inst->app_config.job_power_policy);
+    }
 
-    // Texture system.
-    texture_system_config texture_sys_config;
+    // Started with the job system, which threads waiting on the render thread help out.
+    app_state->render_thread = render_thread && renderer_render_thread_start();
+    return true;
+}
+
+static b8 startup_async_io(void* user_data) {
+    async_io_system_config* async_io_sys_config = user_data;
+    if (!async_io_system_initialize(&app_state->async_io_system_memory_requirement, app_state->async_io_system_state, *async_io_sys_config)) {
+        KFATAL("Failed to initialize async I/O system. Aborting application.");
+        return false;
+    }
+    return true;
+}
+
+static b8 startup_textures(void* user_data) {
+    texture_system_config texture_sys_config = {};
     texture_sys_config.max_texture_count = 65536;
+    // Textures loaded from files are streamed in as they are seen closer up, within this budget.
+    texture_sys_config.streaming_budget = GIBIBYTES(1);
+    // Textures released with nothing else referring to them are kept within this, in case they are acquired again.
+    texture_sys_config.cache_budget = MEBIBYTES(256);
     texture_system_initialize(&app_state->texture_system_memory_requirement, 0, texture_sys_config);
     app_state->texture_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->texture_system_memory_requirement);
     if (!texture_system_initialize(&app_state->texture_system_memory_requirement, app_state->texture_system_state, texture_sys_config)) {
         KFATAL("Failed to initialize texture system. Application cannot continue.");
         return false;
     }
+    return true;
+}
 
-    // Font system.
-    font_system_initialize(&app_state->font_system_memory_requirement, 0, &game_inst->app_config.font_config);
+static b8 startup_fonts(void* user_data) {
+    font_system_config* font_config = &app_state->game_inst->app_config.font_config;
+    font_system_initialize(&app_state->font_system_memory_requirement, 0, font_config);
     app_state->font_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->font_system_memory_requirement);
-    if (!font_system_initialize(&app_state->font_system_memory_requirement, app_state->font_system_state, &game_inst->app_config.font_config)) {
+    if (!font_system_initialize(&app_state->font_system_memory_requirement, app_state->font_system_state, font_config)) {
         KFATAL("Failed to initialize font system. Application cannot continue.");
         return false;
     }
+    return true;
+}
 
-    // Camera
-    camera_system_config camera_sys_config;
-    camera_sys_config.max_camera_count = 61;
-    camera_system_initialize(&app_state->camera_system_memory_requirement, 0, camera_sys_config);
-    app_state->camera_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->camera_system_memory_requirement);
-    if (!camera_system_initialize(&app_state->camera_system_memory_requirement, app_state->camera_system_state, camera_sys_config)) {
+static b8 startup_cameras(void* user_data) {
+    camera_system_config* camera_sys_config = user_data;
+    if (!camera_system_initialize(&app_state->camera_system_memory_requirement, app_state->camera_system_state, *camera_sys_config)) {
         KFATAL("Failed to initialize camera system. Application cannot continue.");
         return false;
     }
+    return true;
+}
 
+static b8 startup_lights(void* user_data) {
+    light_system_config* light_sys_config = user_data;
+    if (!light_system_initialize(&app_state->light_system_memory_requirement, app_state->light_system_state, *light_sys_config)) {
+        KFATAL("Failed to initialize light system. Application cannot continue.");
+        return false;
+    }
+    return true;
+}
+
+static b8 startup_render_views(void* user_data) {
     render_view_system_config render_view_sys_config = {};
     render_view_sys_config.max_view_count = 251;
     render_view_system_initialize(&app_state->renderer_view_system_memory_requirement, 0, render_view_sys_config);
@@ -285,40 +422,198 @@ b8 application_create(game* game_inst) {
     }
 
     // Load render views from app config.
-    u32 view_count = darray_length(game_inst->app_config.render_views);
+    application_config* app_config = &app_state->game_inst->app_config;
+    u32 view_count = darray_length(app_config->render_views);
     for (u32 v = 0; v < view_count; ++v) {
-        render_view_config* view = &game_inst->app_config.render_views[v];
+        render_view_config* view = &app_config->render_views[v];
         if (!render_view_system_create(view)) {
             KFATAL("Failed to create view '%s'. Aborting application.", view->name);
             return false;
         }
     }
+    return true;
+}
 
-    // Material system.
+static b8 startup_materials(void* user_data) {
     material_system_config material_sys_config;
     material_sys_config.max_material_count = 4096;
+    material_sys_config.cache_budget = MEBIBYTES(4);
     material_system_initialize(&app_state->material_system_memory_requirement, 0, material_sys_config);
     app_state->material_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->material_system_memory_requirement);
     if (!material_system_initialize(&app_state->material_system_memory_requirement, app_state->material_system_state, material_sys_config)) {
         KFATAL("Failed to initialize material system. Application cannot continue.");
         return false;
     }
+    return true;
+}
 
-    // Geometry system.
+static b8 startup_geometry(void* user_data) {
     geometry_system_config geometry_sys_config;
     geometry_sys_config.max_geometry_count = 4096;
+    geometry_sys_config.cache_budget = MEBIBYTES(64);
     geometry_system_initialize(&app_state->geometry_system_memory_requirement, 0, geometry_sys_config);
     app_state->geometry_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->geometry_system_memory_requirement);
     if (!geometry_system_initialize(&app_state->geometry_system_memory_requirement, app_state->geometry_system_state, geometry_sys_config)) {
         KFATAL("Failed to initialize geometry system. Application cannot continue.");
         return false;
     }
+    return true;
+}
+
+static b8 startup_hot_reload(void* user_data) {
+    hot_reload_system_config* hot_reload_sys_config = user_data;
+    // Not fatal; the application simply runs without reloading.
+    if (!hot_reload_system_initialize(&app_state->hot_reload_system_memory_requirement, app_state->hot_reload_system_state, *hot_reload_sys_config)) {
+        app_state->hot_reload_system_state = 0;
+    }
+    return true;
+}
 
-    // Initialize the game.
+static b8 startup_game_initialize(void* user_data) {
     if (!app_state->game_inst->initialize(app_state->game_inst)) {
         KFATAL("Game failed to initialize.");
         return false;
     }
+    return true;
+}
+
+static b8 startup_benchmark(void* user_data) {
+    benchmark_config* config = &app_state->game_inst->app_config.benchmark;
+    benchmark_initialize(&app_state->benchmark_memory_requirement, 0, config);
+    app_state->benchmark_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->benchmark_memory_requirement);
+    if (!benchmark_initialize(&app_state->benchmark_memory_requirement, app_state->benchmark_state, config)) {
+        KFATAL("Failed to initialize benchmark. Aborting application.");
+        return false;
+    }
+    return true;
+}
+
+static b8 startup_replay(void* user_data) {
+    app_state->replay = linear_allocator_allocate(&app_state->systems_allocator, sizeof(render_replay));
+    if (!render_replay_load(&app_state->game_inst->app_config.replay, app_state->replay)) {
+        KFATAL("Failed to load the render capture to replay. Aborting application.");
+        app_state->replay = 0;
+        return false;
+    }
+    return true;
+}
+
+b8 application_create(game* game_inst) {
+    if (game_inst->application_state) {
+        KERROR("application_create called more than once.");
+        return false;
+    }
+
+    // Memory system must be the first thing to be stood up.
+    memory_system_configuration memory_system_config = {};
+    memory_system_config.total_alloc_size = GIBIBYTES(1);
+    // Back the heap with huge pages and keep it local to the main thread to cut down on TLB misses.
+    memory_system_config.page_size = MEBIBYTES(2);
+    memory_system_config.node_local = true;
+    memory_system_config.no_alloc_action = game_inst->app_config.no_alloc_action;
+    if (!memory_system_initialize(memory_system_config)) {
+        KERROR("Failed to initialize memory system; shutting down.");
+        return false;
+    }
+
+    // Seed the uuid generator.
+    // TODO: A better seed here.
+    uuid_seed(101);
+
+    // Metrics
+    metrics_initialize();
+
+    // Allocate the game state.
+    game_inst->state = kallocate(game_inst->state_memory_requirement, MEMORY_TAG_GAME);
+
+    // Stand up the application state.
+    game_inst->application_state = kallocate(sizeof(application_state), MEMORY_TAG_APPLICATION);
+    app_state = game_inst->application_state;
+    app_state->game_inst = game_inst;
+    app_state->is_running = false;
+    app_state->is_suspended = false;
+    app_state->is_visible = true;
+    app_state->has_focus = true;
+
+    // Create a linear allocator for all systems (except memory) to use. This is only reserved
+    // up front and committed as systems are stood up, so it can be sized generously.
+    u64 systems_allocator_total_size = MEBIBYTES(256);
+    if (!linear_allocator_create_reserved(systems_allocator_total_size, &app_state->systems_allocator)) {
+        KERROR("Failed to create the systems allocator; shutting down.");
+        return false;
+    }
+
+    // Stand up everything else as a graph, so that stages which do not depend on each other run at
+    // the same time once the job system is up. Anything creating GPU resources or registering for
+    // events stays on the main thread.
+    startup_graph graph = {};
+    u32 events = startup_graph_add(&graph, "events", startup_events, 0, STARTUP_STAGE_THREAD_MAIN, 0, 0);
+    u32 logging = startup_graph_add(&graph, "logging", startup_logging, 0, STARTUP_STAGE_THREAD_MAIN, 0, 0);
+    u32 profiler = startup_graph_add(&graph, "profiler", startup_profiler, 0, STARTUP_STAGE_THREAD_MAIN, 0, 0);
+    u32 input = startup_graph_add(&graph, "input", startup_input, 0, STARTUP_STAGE_THREAD_MAIN, 1, (u32[]){events});
+    u32 platform = startup_graph_add(&graph, "platform", startup_platform, 0, STARTUP_STAGE_THREAD_MAIN, 3, (u32[]){events, logging, input});
+    u32 resources = startup_graph_add(&graph, "resources", startup_resources, 0, STARTUP_STAGE_THREAD_MAIN, 1, (u32[]){logging});
+    u32 shaders = startup_graph_add(&graph, "shaders", startup_shaders, 0, STARTUP_STAGE_THREAD_MAIN, 1, (u32[]){logging});
+    u32 renderer = startup_graph_add(&graph, "renderer", startup_renderer, 0, STARTUP_STAGE_THREAD_MAIN, 3, (u32[]){platform, resources, shaders});
+    u32 boot = startup_graph_add(&graph, "game boot", startup_game_boot, 0, STARTUP_STAGE_THREAD_MAIN, 1, (u32[]){renderer});
+    // Thread types depend on whether the renderer is multithreaded. The profiler names job threads.
+    u32 jobs = startup_graph_add(&graph, "jobs", startup_jobs, 0, STARTUP_STAGE_THREAD_MAIN, 2, (u32[]){renderer, profiler});
+
+    // Stages run on job threads can not use the systems allocator, so their memory is set aside up front.
+    async_io_system_config async_io_sys_config = {};
+    async_io_system_initialize(&app_state->async_io_system_memory_requirement, 0, async_io_sys_config);
+    app_state->async_io_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->async_io_system_memory_requirement);
+    u32 async_io = startup_graph_add(&graph, "async io", startup_async_io, &async_io_sys_config, STARTUP_STAGE_THREAD_ANY, 1, (u32[]){jobs});
+
+    u32 textures = startup_graph_add(&graph, "textures", startup_textures, 0, STARTUP_STAGE_THREAD_MAIN, 2, (u32[]){renderer, jobs});
+    u32 fonts = startup_graph_add(&graph, "fonts", startup_fonts, 0, STARTUP_STAGE_THREAD_MAIN, 2, (u32[]){textures, boot});
+
+    camera_system_config camera_sys_config;
+    camera_sys_config.max_camera_count = 61;
+    camera_system_initialize(&app_state->camera_system_memory_requirement, 0, camera_sys_config);
+    app_state->camera_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->camera_system_memory_requirement);
+    u32 cameras = startup_graph_add(&graph, "cameras", startup_cameras, &camera_sys_config, STARTUP_STAGE_THREAD_ANY, 1, (u32[]){jobs});
+
+    light_system_config light_sys_config;
+    light_sys_config.max_point_light_count = 1024;
+    light_system_initialize(&app_state->light_system_memory_requirement, 0, light_sys_config);
+    app_state->light_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->light_system_memory_requirement);
+    u32 lights = startup_graph_add(&graph, "lights", startup_lights, &light_sys_config, STARTUP_STAGE_THREAD_ANY, 1, (u32[]){jobs});
+
+    u32 views = startup_graph_add(&graph, "render views", startup_render_views, 0, STARTUP_STAGE_THREAD_MAIN, 4, (u32[]){boot, cameras, lights, textures});
+    u32 materials = startup_graph_add(&graph, "materials", startup_materials, 0, STARTUP_STAGE_THREAD_MAIN, 1, (u32[]){textures});
+    u32 geometry = startup_graph_add(&graph, "geometry", startup_geometry, 0, STARTUP_STAGE_THREAD_MAIN, 1, (u32[]){materials});
+
+    // Hot reload, if configured. Benchmarks measure fixed assets, so never reload during one.
+    u32 game_dependencies[8] = {async_io, fonts, views, geometry};
+    u32 game_dependency_count = 4;
+    hot_reload_system_config hot_reload_sys_config;
+    if (game_inst->app_config.hot_reload && !game_inst->app_config.benchmark.frame_count) {
+        hot_reload_sys_config.max_pending_count = 256;
+        hot_reload_sys_config.settle_seconds = 0.1;
+        hot_reload_system_initialize(&app_state->hot_reload_system_memory_requirement, 0, hot_reload_sys_config);
+        app_state->hot_reload_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->hot_reload_system_memory_requirement);
+        game_dependencies[game_dependency_count++] = startup_graph_add(&graph, "hot reload", startup_hot_reload, &hot_reload_sys_config, STARTUP_STAGE_THREAD_ANY, 1, (u32[]){jobs});
+    }
+
+    u32 game = startup_graph_add(&graph, "game", startup_game_initialize, 0, STARTUP_STAGE_THREAD_MAIN, game_dependency_count, game_dependencies);
+
+    // Benchmark, if configured. Stood up last, so that it measures from the first frame.
+    if (game_inst->app_config.benchmark.frame_count) {
+        startup_graph_add(&graph, "benchmark", startup_benchmark, 0, STARTUP_STAGE_THREAD_MAIN, 1, (u32[]){game});
+    }
+
+    // Replay, if configured. After the game, so that the geometries it loads may be replayed too.
+    if (game_inst->app_config.replay.path) {
+        startup_graph_add(&graph, "replay", startup_replay, 0, STARTUP_STAGE_THREAD_MAIN, 1, (u32[]){game});
+    }
+
+    b8 started = startup_graph_run(&graph);
+    KINFO("Startup stages:");
+    startup_graph_report(&graph);
+    if (!started) {
+        return false;
+    }
 
     // Call resize once to ensure the proper size has been set.
     renderer_on_resized(app_state->width, app_state->height);
@@ -327,74 +622,263 @@ b8 application_create(game* game_inst) {
     return true;
 }
 
+// Runs the fixed steps of a frame while it is drawn.
+static b8 simulation_job_start(void* params, void* result_data) {
+    simulation_job_params* typed_params = params;
+    KPROFILE_ZONE("fixed_update");
+    for (u32 i = 0; i < typed_params->step_count; ++i) {
+        if (!app_state->game_inst->fixed_update(app_state->game_inst, typed_params->step_time)) {
+            katomic_store_release(&app_state->simulation_failed, true);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Works out how many fixed steps the given time adds up to, keeping the rest for later frames.
+static u32 fixed_steps_take(f64 delta, f64 step_time) {
+    app_state->fixed_step_accumulator += delta;
+    u32 step_count = (u32)(app_state->fixed_step_accumulator / step_time);
+    if (step_count > APPLICATION_MAX_FIXED_STEPS_PER_FRAME) {
+        step_count = APPLICATION_MAX_FIXED_STEPS_PER_FRAME;
+        app_state->fixed_step_accumulator = step_time * step_count;
+    }
+    app_state->fixed_step_accumulator -= step_time * step_count;
+    app_state->game_inst->fixed_step_alpha = (f32)(app_state->fixed_step_accumulator / step_time);
+    return step_count;
+}
+
+// Starts what the systems do each frame: reloading, streaming, job completions and posted events.
+static void systems_update(void) {
+    // Start reloading changed assets. Their jobs complete in the job system update below.
+    hot_reload_system_update();
+
+    // Start loading the texture levels drawn last frame needed.
+    texture_system_update();
+
+    // Update the job system.
+    job_system_update();
+
+    // Dispatch events posted since last frame, including any from job completions above.
+    event_dispatch_deferred();
+}
+
+// Destroys what the views built for the given packet, once its frame is drawn.
+static void frame_packet_destroy(render_packet* packet) {
+    for (u32 i = 0; i < packet->view_count; ++i) {
+        packet->views[i].view->on_destroy_packet(packet->views[i].view, &packet->views[i]);
+    }
+    packet->view_count = 0;
+}
+
+// Keeps a single job thread active while the window cannot be seen, for whatever is still loading.
+static void job_threads_park_update(void) {
+    b8 park = (app_state->is_suspended || !app_state->is_visible) && !app_state->game_inst->app_config.benchmark.frame_count;
+    if (park && !app_state->job_threads_parked) {
+        app_state->resumed_job_thread_count = job_system_active_thread_count_get();
+        job_system_active_thread_count_set(1);
+    } else if (!park && app_state->job_threads_parked) {
+        job_system_active_thread_count_set(app_state->resumed_job_thread_count);
+    }
+    app_state->job_threads_parked = park;
+}
+
+// Runs the given fixed steps on a job thread, alongside the frame drawing what was simulated before them.
+static void simulation_submit(u32 step_count, f32 step_time) {
+    simulation_job_params params = {step_count, step_time};
+    job_info job = job_create_priority(simulation_job_start, 0, 0, &params, sizeof(simulation_job_params), 0, JOB_TYPE_GENERAL, JOB_PRIORITY_HIGH);
+    app_state->simulation_job = job_system_submit(job);
+}
+
+// Waits for the fixed steps running alongside the last frame, if any.
+static b8 simulation_wait(void) {
+    if (app_state->simulation_job != INVALID_ID) {
+        job_system_wait(app_state->simulation_job);
+        app_state->simulation_job = INVALID_ID;
+    }
+    return !katomic_load_acquire(&app_state->simulation_failed);
+}
+
 b8 application_run() {
     app_state->is_running = true;
     clock_start(&app_state->clock);
     clock_update(&app_state->clock);
     app_state->last_time = app_state->clock.elapsed;
     // f64 running_time = 0;
-    f64 target_frame_seconds = 1.0f / 60;
+    u32 target_frame_rate = app_state->game_inst->app_config.target_frame_rate ? app_state->game_inst->app_config.target_frame_rate : 60;
+    f64 target_frame_seconds = 1.0 / target_frame_rate;
+    b8 fixed_steps = app_state->game_inst->fixed_update != 0;
+    u32 fixed_update_rate = app_state->game_inst->app_config.fixed_update_rate ? app_state->game_inst->app_config.fixed_update_rate : 60;
+    f32 fixed_step_time = 1.0f / fixed_update_rate;
+    b8 pipelined_simulation = fixed_steps && app_state->game_inst->app_config.pipelined_simulation;
+    app_state->fixed_step_accumulator = 0;
+    app_state->simulation_job = INVALID_ID;
+    app_state->simulation_failed = false;
+    app_state->game_inst->fixed_step_alpha = 0;
+    b8 render_thread = app_state->render_thread;
+    kzero_memory(&app_state->frame_packet, sizeof(render_packet));
+    // Benchmarks are never throttled.
+    b8 limit_frames = app_state->game_inst->app_config.frame_pacing == FRAME_PACING_TIMER && !app_state->benchmark_state;
+    u32 background_frame_rate = app_state->game_inst->app_config.background_frame_rate ? app_state->game_inst->app_config.background_frame_rate : APPLICATION_DEFAULT_BACKGROUND_FRAME_RATE;
+    f64 background_frame_seconds = 1.0 / background_frame_rate;
+    // Frames are scheduled against a running deadline rather than from each frame's own length,
+    // so that early and late wake-ups do not accumulate into drift.
+    f64 next_frame_time = platform_get_absolute_time();
     f64 frame_elapsed_time = 0;
+    b8 result = true;
 
     KINFO(get_memory_usage_str());
 
     while (app_state->is_running) {
+        // In low-latency mode, wait out the last frame here, so that the input below is as fresh as possible.
+        // With a render thread, that is left until the frame is drawn, to let the update overlap it.
+        if (!render_thread) {
+            renderer_latency_wait();
+        }
+
         if (!platform_pump_messages()) {
             app_state->is_running = false;
         }
 
+        // Handle the input gathered above in one pass, then publish it for jobs to read.
+        input_dispatch_events();
+        input_snapshot_take();
+
         if (!app_state->is_suspended) {
             // Update clock and get delta time.
             clock_update(&app_state->clock);
             f64 current_time = app_state->clock.elapsed;
             f64 delta = (current_time - app_state->last_time);
+            if (app_state->benchmark_state) {
+                // A fixed time step, so that every run renders the same frames.
+                delta = BENCHMARK_FRAME_DELTA;
+            }
             f64 frame_start_time = platform_get_absolute_time();
+            profile_zone frame_zone = profiler_zone_begin("frame");
+            // In the background, frames are slowed down, and not drawn at all while nothing can be seen.
+            b8 hidden = !app_state->is_visible && !app_state->benchmark_state;
+            b8 throttled = hidden || (!app_state->has_focus && !app_state->benchmark_state);
+
+            // With a render thread these change what it draws with, so wait for the update below.
+            if (!render_thread) {
+                systems_update();
+            }
 
-            // Update the job system.
-            job_system_update();
+            f64 update_start_time = platform_get_absolute_time();
 
-            // update metrics
-            metrics_update(frame_elapsed_time);
+            // The steps run alongside the last frame are done before anything reads what they simulated.
+            u32 fixed_step_count = 0;
+            if (fixed_steps) {
+                if (!simulation_wait()) {
+                    KFATAL("Game fixed update failed, shutting down.");
+                    app_state->is_running = false;
+                    break;
+                }
+                fixed_step_count = fixed_steps_take(delta, fixed_step_time);
+                if (!pipelined_simulation) {
+                    profile_zone fixed_zone = profiler_zone_begin("fixed_update");
+                    for (u32 i = 0; i < fixed_step_count; ++i) {
+                        if (!app_state->game_inst->fixed_update(app_state->game_inst, fixed_step_time)) {
+                            KFATAL("Game fixed update failed, shutting down.");
+                            app_state->is_running = false;
+                            break;
+                        }
+                    }
+                    profiler_zone_end(&fixed_zone);
+                    if (!app_state->is_running) {
+                        break;
+                    }
+                }
+            }
 
+            profile_zone game_zone = profiler_zone_begin("game_update");
             if (!app_state->game_inst->update(app_state->game_inst, (f32)delta)) {
                 KFATAL("Game update failed, shutting down.");
                 app_state->is_running = false;
                 break;
             }
-
-            // TODO: refactor packet creation
-            render_packet packet = {};
-            packet.delta_time = delta;
-
-            // Call the game's render routine.
-            if (!app_state->game_inst->render(app_state->game_inst, &packet, (f32)delta)) {
-                KFATAL("Game render failed, shutting down.");
-                app_state->is_running = false;
-                break;
+            profiler_zone_end(&game_zone);
+
+            // Everything from here on changes what the last frame draws with, so it must be drawn first.
+            if (render_thread) {
+                renderer_frame_wait();
+                renderer_latency_wait();
+                frame_packet_destroy(&app_state->frame_packet);
+                systems_update();
             }
+            f64 render_start_time = platform_get_absolute_time();
+            f64 update_time = render_start_time - update_start_time;
+
+            b8 replaying = false;
+            if (!hidden) {
+                // TODO: refactor packet creation
+                render_packet* packet = &app_state->frame_packet;
+                kzero_memory(packet, sizeof(render_packet));
+                packet->delta_time = delta;
+
+                // Call the game's render routine, unless a capture is being replayed in its place.
+                replaying = app_state->replay && render_replay_ready(app_state->replay);
+                if (replaying) {
+                    game_zone = profiler_zone_begin("replay_render");
+                    if (!render_replay_packet_build(app_state->replay, frame_arena_allocator(&app_state->game_inst->frame_arena), packet)) {
+                        KFATAL("Replay render failed, shutting down.");
+                        app_state->is_running = false;
+                        break;
+                    }
+                } else {
+                    game_zone = profiler_zone_begin("game_render");
+                    if (!app_state->game_inst->render(app_state->game_inst, packet, (f32)delta)) {
+                        KFATAL("Game render failed, shutting down.");
+                        app_state->is_running = false;
+                        break;
+                    }
+                }
+                profiler_zone_end(&game_zone);
+                render_capture_frame(packet);
 
-            renderer_draw_frame(&packet);
+                // This frame's steps are simulated while it is drawn, for the next frame to show.
+                if (pipelined_simulation && fixed_step_count) {
+                    simulation_submit(fixed_step_count, fixed_step_time);
+                }
 
-            // Cleanup the packet.
-            for (u32 i = 0; i < packet.view_count; ++i) {
-                packet.views[i].view->on_destroy_packet(packet.views[i].view, &packet.views[i]);
+                // With a render thread, the next frame goes ahead while this one is drawn, and the
+                // packet is cleaned up once it has been.
+                renderer_frame_submit(packet);
+                if (!render_thread) {
+                    frame_packet_destroy(packet);
+                }
+            } else if (pipelined_simulation && fixed_step_count) {
+                // Nothing is drawn, but the game still moves on.
+                simulation_submit(fixed_step_count, fixed_step_time);
             }
 
             // Figure out how long the frame took and, if below
             f64 frame_end_time = platform_get_absolute_time();
+            f64 render_time = frame_end_time - render_start_time;
             frame_elapsed_time = frame_end_time - frame_start_time;
             // running_time += frame_elapsed_time;
-            f64 remaining_seconds = target_frame_seconds - frame_elapsed_time;
-
-            if (remaining_seconds > 0) {
-                u64 remaining_ms = (remaining_seconds * 1000);
 
-                // If there is time left, give it back to the OS.
-                b8 limit_frames = false;
-                if (remaining_ms > 0 && limit_frames) {
-                    platform_sleep(remaining_ms - 1);
+            // If there is time left, give it back to the OS.
+            if (limit_frames || throttled) {
+                f64 frame_seconds = throttled ? background_frame_seconds : target_frame_seconds;
+                next_frame_time += frame_seconds;
+                // After a hitch or a suspend, restart the schedule rather than rushing to catch up.
+                if (next_frame_time < frame_end_time - frame_seconds) {
+                    next_frame_time = frame_end_time;
                 }
+                platform_wait_until(next_frame_time);
+            }
+            f64 sleep_time = platform_get_absolute_time() - frame_end_time;
+
+            // update metrics
+            metrics_update(frame_elapsed_time, update_time, render_time, sleep_time);
+            counters_snapshot();
 
+            if (app_state->benchmark_state && benchmark_frame_end(frame_elapsed_time, update_time, render_time, &result)) {
+                app_state->is_running = false;
+            }
+            if (replaying && render_replay_frame_end(app_state->replay, frame_elapsed_time)) {
+                app_state->is_running = false;
             }
 
             // NOTE: Input update/state copying should always be handled
@@ -403,13 +887,29 @@ b8 application_run() {
             // this frame ends.
             input_update(delta);
 
+            profiler_zone_end(&frame_zone);
+            profiler_frame_end();
+
             // Update last time
             app_state->last_time = current_time;
+        } else {
+            // Minimized, so nothing is updated or drawn. Only look for messages now and then,
+            // rather than spinning a core on them.
+            platform_sleep(APPLICATION_SUSPENDED_SLEEP_MS);
         }
     }
 
     app_state->is_running = false;
 
+    // The game's state is not torn down while it is still being simulated or drawn.
+    simulation_wait();
+    renderer_frame_wait();
+    frame_packet_destroy(&app_state->frame_packet);
+    if (app_state->replay) {
+        render_replay_destroy(app_state->replay);
+        app_state->replay = 0;
+    }
+
     // Shut down the game.
     app_state->game_inst->shutdown(app_state->game_inst);
 
@@ -420,10 +920,22 @@ b8 application_run() {
 
     font_system_shutdown(app_state->font_system_state);
 
+    if (app_state->benchmark_state) {
+        benchmark_shutdown(app_state->benchmark_state);
+        app_state->benchmark_state = 0;
+    }
+
     render_view_system_shutdown(app_state->renderer_view_system_state);
 
+    light_system_shutdown(app_state->light_system_state);
+
     geometry_system_shutdown(app_state->geometry_system_state);
 
+    if (app_state->hot_reload_system_state) {
+        hot_reload_system_shutdown(app_state->hot_reload_system_state);
+        app_state->hot_reload_system_state = 0;
+    }
+
     material_system_shutdown(app_state->material_system_state);
 
     texture_system_shutdown(app_state->texture_system_state);
@@ -434,15 +946,28 @@ b8 application_run() {
 
     resource_system_shutdown(app_state->resource_system_state);
 
+    async_io_system_shutdown(app_state->async_io_system_state);
+
     job_system_shutdown(app_state->job_system_state);
 
     platform_system_shutdown(app_state->platform_system_state);
 
+    profiler_shutdown(app_state->profiler_state);
+
     event_system_shutdown(app_state->event_system_state);
 
+    // Write out any queued log entries. Anything logged after this only goes to the console.
+    shutdown_logging(app_state->logging_system_state);
+
+    scratch_allocator_release();
+
     memory_system_shutdown();
 
-    return true;
+    return result;
+}
+
+b8 application_benchmark_running() {
+    return app_state && app_state->benchmark_state != 0;
 }
 
 void application_get_framebuffer_size(u32* width, u32* height) {
@@ -462,6 +987,22 @@ b8 application_on_event(u16 code, void* sender, void* listener_inst, event_conte
     return false;
 }
 
+b8 application_on_visibility_changed(u16 code, void* sender, void* listener_inst, event_context context) {
+    if (code == EVENT_CODE_WINDOW_VISIBILITY_CHANGED) {
+        b8 visible = context.data.u8[0];
+        b8 focused = context.data.u8[1];
+        if (visible != app_state->is_visible) {
+            KINFO(visible ? "Window visible, drawing again." : "Window hidden, no longer drawing.");
+        }
+        app_state->is_visible = visible;
+        app_state->has_focus = focused;
+        job_threads_park_update();
+    }
+
+    // Event purposely not handled to allow other listeners to get this.
+    return false;
+}
+
 b8 application_on_resized(u16 code, void* sender, void* listener_inst, event_context context) {
     if (code == EVENT_CODE_RESIZED) {
         u16 width = context.data.u16[0];
@@ -478,11 +1019,13 @@ b8 application_on_resized(u16 code, void* sender, void* listener_inst, event_con
             if (width == 0 || height == 0) {
                 KINFO("Window minimized, suspending application.");
                 app_state->is_suspended = true;
+                job_threads_park_update();
                 return true;
             } else {
                 if (app_state->is_suspended) {
                     KINFO("Window restored, resuming application.");
                     app_state->is_suspended = false;
+                    job_threads_park_update();
                 }
                 app_state->game_inst->on_resize(app_state->game_inst, width, height);
                 renderer_on_resized(width, height);
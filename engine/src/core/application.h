@@ -15,11 +15,25 @@
 #pragma once
 
 #include "defines.h"
+#include "core/benchmark.h"
+#include "core/kmemory.h"
+#include "renderer/render_capture.h"
 #include "systems/font_system.h"
+#include "systems/job_system.h"
 #include "renderer/renderer_types.inl"
 
 struct game;
 
+/** @brief How the application paces its frames. */
+typedef enum frame_pacing_mode {
+    /** @brief Frames run back to back, as fast as they can be rendered. */
+    FRAME_PACING_UNLIMITED = 0,
+    /** @brief Frames start at a fixed rate, set by target_frame_rate, waiting out any spare time. */
+    FRAME_PACING_TIMER,
+    /** @brief Frames follow the display; presentation waits for each refresh (vsync). */
+    FRAME_PACING_PRESENT
+} frame_pacing_mode;
+
 /** 
  * @brief Represents configuration for the application.
  */
@@ -44,6 +58,65 @@ typedef struct application_config {
 
     /** @brief A darray of render view configurations. */
     render_view_config* render_views;
+
+    /** @brief Configuration for a benchmark run. A frame_count of 0 runs normally. */
+    benchmark_config benchmark;
+
+    /** @brief Configuration for replaying a render capture in place of the game's render routine. A path of 0 runs normally. */
+    render_replay_config replay;
+
+    /** @brief Indicates if changed asset files should be reloaded while running. Ignored during a benchmark run. */
+    b8 hot_reload;
+
+    /**
+     * @brief How many job threads are kept active. JOB_POWER_POLICY_BATTERY parks the threads load does
+     * not keep busy. Only a single thread is kept while the window cannot be seen either way. Ignored during a benchmark run.
+     */
+    job_power_policy job_power_policy;
+
+    /** @brief How frames are paced. Benchmark runs are never paced. */
+    frame_pacing_mode frame_pacing;
+
+    /** @brief The frame rate for FRAME_PACING_TIMER. 0 uses 60. */
+    u32 target_frame_rate;
+
+    /**
+     * @brief The frame rate while the window is unfocused or cannot be seen, whatever the pacing. Nothing
+     * is drawn while it cannot be seen, though the game is still updated. 0 uses 10. Ignored during a benchmark run.
+     */
+    u32 background_frame_rate;
+
+    /** @brief The rate, in steps per second, the game's fixed_update is called at, if it has one. 0 uses 60. */
+    u32 fixed_update_rate;
+
+    /**
+     * @brief Indicates if the fixed steps of each frame run on a job thread while that frame is
+     * drawn, rather than before its update. What is simulated is then drawn a frame later.
+     */
+    b8 pipelined_simulation;
+
+    /**
+     * @brief Indicates if frames are drawn on a render thread, so the next frame's input, fixed steps
+     * and update run while the last one is recorded and submitted. Its packet is built once the last
+     * frame is drawn, as views keep state of their own across frames. The render thread also runs
+     * renderer resource work, so loader jobs may create GPU resources themselves.
+     */
+    b8 render_thread;
+
+    /** @brief The swapchain configuration: present mode, image count, frames in flight and low-latency mode. */
+    renderer_swapchain_config swapchain;
+
+    /**
+     * @brief The dynamic resolution configuration. A target frame time of 0 uses that of the target
+     * frame rate. Disabled during a benchmark run, so its results stay comparable.
+     */
+    renderer_resolution_config resolution;
+
+    /**
+     * @brief What is done when memory is allocated while a view builds its packet or renders, which
+     * should only use the frame allocator. Such allocations are counted whatever this is set to.
+     */
+    memory_no_alloc_action no_alloc_action;
 } application_config;
 
 /**
@@ -60,6 +133,13 @@ KAPI b8 application_create(struct game* game_inst);
  */
 KAPI b8 application_run();
 
+/**
+ * @brief Indicates if the application is running a benchmark, in which case the game should
+ * drive a reproducible scene from the delta times it is given rather than from input.
+ * @returns True if a benchmark is running; otherwise false.
+ */
+KAPI b8 application_benchmark_running();
+
 /**
  * @brief Obtains the framebuffer size of the application.
  * @deprecated NOTE: This is temporary, and should be removed once kvars are in place.
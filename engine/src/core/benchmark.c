@@ -0,0 +1,410 @@
+#include "benchmark.h"
+
+#include "core/counters.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+#include "core/metrics.h"
+#include "platform/filesystem.h"
+#include "platform/platform.h"
+
+#include <stdarg.h>
+
+// The size of the buffer results are gathered in before being written.
+#define BENCHMARK_WRITE_BUFFER_SIZE KIBIBYTES(64)
+
+typedef enum benchmark_series {
+    BENCHMARK_SERIES_FRAME,
+    BENCHMARK_SERIES_UPDATE,
+    BENCHMARK_SERIES_RENDER,
+    BENCHMARK_SERIES_GPU,
+    BENCHMARK_SERIES_COUNT
+} benchmark_series;
+
+static const char* series_names[BENCHMARK_SERIES_COUNT] = {"frame_ms", "update_ms", "render_ms", "gpu_ms"};
+
+// The stats of each series compared against a baseline. The tails catch hitches the medians hide.
+static const char* compared_stat_names[] = {"p50", "p95", "p99"};
+
+typedef struct benchmark_state {
+    benchmark_config config;
+    // The number of frames recorded so far, including warm-up frames.
+    u32 frames_seen;
+    // Each measured frame's times in milliseconds, one array per series. Held after the state.
+    f64* samples[BENCHMARK_SERIES_COUNT];
+    // Counter values and the hitch count when measuring started.
+    i64 counter_start[COUNTERS_MAX];
+    u64 hitch_start;
+    f64 start_time;
+} benchmark_state;
+
+// Gathers the results' text, writing it to the file whenever the buffer fills.
+typedef struct benchmark_writer {
+    file_handle file;
+    char* buffer;
+    u64 length;
+    b8 failed;
+} benchmark_writer;
+
+static benchmark_state* state_ptr;
+
+static b8 argument_value_get(const char* argument, const char* name, const char** out_value) {
+    u64 length = string_length(name);
+    if (!strings_nequal(argument, name, length)) {
+        return false;
+    }
+    if (argument[length] == '=') {
+        *out_value = argument + length + 1;
+        return true;
+    }
+    if (argument[length] == 0) {
+        *out_value = 0;
+        return true;
+    }
+    return false;
+}
+
+void benchmark_config_parse(i32 argc, char** argv, benchmark_config* out_config) {
+    out_config->frame_count = 0;
+    out_config->warmup_frame_count = BENCHMARK_DEFAULT_WARMUP_FRAME_COUNT;
+    out_config->output_path = BENCHMARK_DEFAULT_OUTPUT_PATH;
+    out_config->scene = BENCHMARK_DEFAULT_SCENE;
+    out_config->baseline_path = 0;
+    out_config->threshold_percent = BENCHMARK_DEFAULT_THRESHOLD_PERCENT;
+
+    for (i32 i = 1; i < argc; ++i) {
+        const char* value = 0;
+        if (argument_value_get(argv[i], "--benchmark", &value)) {
+            out_config->frame_count = BENCHMARK_DEFAULT_FRAME_COUNT;
+            if (value && (!string_to_u32((char*)value, &out_config->frame_count) || out_config->frame_count == 0)) {
+                KWARN("Invalid benchmark frame count '%s', using %u.", value, BENCHMARK_DEFAULT_FRAME_COUNT);
+                out_config->frame_count = BENCHMARK_DEFAULT_FRAME_COUNT;
+            }
+        } else if (argument_value_get(argv[i], "--benchmark-warmup", &value)) {
+            if (!value || !string_to_u32((char*)value, &out_config->warmup_frame_count)) {
+                KWARN("Invalid benchmark warm-up frame count '%s', using %u.", value ? value : "", BENCHMARK_DEFAULT_WARMUP_FRAME_COUNT);
+                out_config->warmup_frame_count = BENCHMARK_DEFAULT_WARMUP_FRAME_COUNT;
+            }
+        } else if (argument_value_get(argv[i], "--benchmark-output", &value)) {
+            if (value && value[0]) {
+                out_config->output_path = value;
+            }
+        } else if (argument_value_get(argv[i], "--benchmark-scene", &value)) {
+            if (value && value[0]) {
+                out_config->scene = value;
+            }
+        } else if (argument_value_get(argv[i], "--benchmark-baseline", &value)) {
+            if (value && value[0]) {
+                out_config->baseline_path = value;
+            }
+        } else if (argument_value_get(argv[i], "--benchmark-threshold", &value)) {
+            if (!value || !string_to_f32((char*)value, &out_config->threshold_percent) || out_config->threshold_percent < 0) {
+                KWARN("Invalid benchmark threshold '%s', using %.1f%%.", value ? value : "", BENCHMARK_DEFAULT_THRESHOLD_PERCENT);
+                out_config->threshold_percent = BENCHMARK_DEFAULT_THRESHOLD_PERCENT;
+            }
+        }
+    }
+}
+
+// Takes the counter values and hitch count that measured frames are compared against.
+static void baseline_take(void) {
+    u32 count = counters_count();
+    for (u32 i = 0; i < count; ++i) {
+        counter_snapshot snapshot;
+        counter_snapshot_get(i, &snapshot);
+        state_ptr->counter_start[i] = snapshot.value;
+    }
+    frame_stats stats;
+    metrics_frame_stats_get(&stats);
+    state_ptr->hitch_start = stats.total_hitch_count;
+    state_ptr->start_time = platform_get_absolute_time();
+}
+
+b8 benchmark_initialize(u64* memory_requirement, void* state, const benchmark_config* config) {
+    u64 series_requirement = sizeof(f64) * config->frame_count;
+    *memory_requirement = sizeof(benchmark_state) + series_requirement * BENCHMARK_SERIES_COUNT;
+    if (state == 0) {
+        return true;
+    }
+    if (config->frame_count == 0) {
+        KERROR("benchmark_initialize - config.frame_count must be > 0.");
+        return false;
+    }
+
+    kzero_memory(state, *memory_requirement);
+    state_ptr = state;
+    state_ptr->config = *config;
+    // The series arrays are after the state. Already allocated, so just set the pointers.
+    for (u32 i = 0; i < BENCHMARK_SERIES_COUNT; ++i) {
+        state_ptr->samples[i] = (f64*)((u8*)state + sizeof(benchmark_state) + series_requirement * i);
+    }
+    baseline_take();
+
+    KINFO("Benchmarking scene '%s' for %u frames after %u warm-up frames. Results will be written to '%s'.", config->scene, config->frame_count, config->warmup_frame_count, config->output_path);
+    return true;
+}
+
+void benchmark_shutdown(void* state) {
+    state_ptr = 0;
+}
+
+static void results_flush(benchmark_writer* writer) {
+    if (writer->length && !writer->failed) {
+        u64 written = 0;
+        if (!filesystem_write(&writer->file, writer->length, writer->buffer, &written) || written != writer->length) {
+            writer->failed = true;
+        }
+    }
+    writer->length = 0;
+}
+
+static void results_append(benchmark_writer* writer, const char* format, ...) {
+    // Leave room for the longest line written.
+    if (BENCHMARK_WRITE_BUFFER_SIZE - writer->length < 512) {
+        results_flush(writer);
+    }
+    __builtin_va_list arg_ptr;
+    va_start(arg_ptr, format);
+    i32 written = string_nformat_v(writer->buffer + writer->length, BENCHMARK_WRITE_BUFFER_SIZE - writer->length, format, arg_ptr);
+    va_end(arg_ptr);
+    if (written > 0) {
+        writer->length = KMIN(writer->length + (u64)written, BENCHMARK_WRITE_BUFFER_SIZE - 1);
+    }
+}
+
+// Moves the value at root down the heap of the first count values until it is no smaller than its children.
+static void heap_sift_down(f64* values, u32 root, u32 count) {
+    while (root * 2 + 1 < count) {
+        u32 child = root * 2 + 1;
+        if (child + 1 < count && values[child] < values[child + 1]) {
+            child++;
+        }
+        if (values[root] >= values[child]) {
+            return;
+        }
+        f64 temp = values[root];
+        values[root] = values[child];
+        values[child] = temp;
+        root = child;
+    }
+}
+
+// Heap sort, so that long runs of equal frame times don't degrade it.
+static void samples_sort(f64* values, u32 count) {
+    for (u32 start = count / 2; start-- > 0;) {
+        heap_sift_down(values, start, count);
+    }
+    for (u32 end = count; end-- > 1;) {
+        // Move the largest to the end, then restore the heap in front of it.
+        f64 temp = values[0];
+        values[0] = values[end];
+        values[end] = temp;
+        heap_sift_down(values, 0, end);
+    }
+}
+
+// The value the given fraction of the sorted values are no greater than.
+static f64 percentile(const f64* sorted, u32 count, f64 fraction) {
+    u32 rank = (u32)(fraction * count + 0.999999);
+    rank = KCLAMP(rank, 1, count);
+    return sorted[rank - 1];
+}
+
+static b8 results_write(void) {
+    u32 frame_count = state_ptr->config.frame_count;
+    f64 duration = platform_get_absolute_time() - state_ptr->start_time;
+    frame_stats stats;
+    metrics_frame_stats_get(&stats);
+
+    benchmark_writer writer = {0};
+    if (!filesystem_open(state_ptr->config.output_path, FILE_MODE_WRITE, false, &writer.file)) {
+        KERROR("Benchmark - Unable to open '%s' for writing.", state_ptr->config.output_path);
+        return false;
+    }
+    writer.buffer = kallocate(BENCHMARK_WRITE_BUFFER_SIZE, MEMORY_TAG_STRING);
+
+    results_append(&writer, "{\n\"frames\":%u,\n\"warmup_frames\":%u,\n\"scene\":\"%s\",\n\"duration_s\":%.3f,\n\"hitches\":%llu",
+                   frame_count, state_ptr->config.warmup_frame_count, state_ptr->config.scene, duration, stats.total_hitch_count - state_ptr->hitch_start);
+
+    f64 frame_avg_ms = 0;
+    f64 frame_p99_ms = 0;
+    for (u32 s = 0; s < BENCHMARK_SERIES_COUNT; ++s) {
+        f64* values = state_ptr->samples[s];
+        f64 total = 0;
+        for (u32 i = 0; i < frame_count; ++i) {
+            total += values[i];
+        }
+        f64 avg = total / frame_count;
+        samples_sort(values, frame_count);
+        f64 p99 = percentile(values, frame_count, 0.99);
+        results_append(&writer, ",\n\"%s\":{\"avg\":%.4f,\"min\":%.4f,\"p50\":%.4f,\"p95\":%.4f,\"p99\":%.4f,\"max\":%.4f}",
+                       series_names[s], avg, values[0], percentile(values, frame_count, 0.5), percentile(values, frame_count, 0.95), p99, values[frame_count - 1]);
+        if (s == BENCHMARK_SERIES_FRAME) {
+            frame_avg_ms = avg;
+            frame_p99_ms = p99;
+        }
+    }
+
+    // The GPU time of each view, averaged over the last frames.
+    results_append(&writer, ",\n\"gpu_views_ms\":{");
+    u32 gpu_timing_count = metrics_gpu_timing_count();
+    for (u32 i = 0; i < gpu_timing_count; ++i) {
+        const char* name = metrics_gpu_timing_name(i);
+        results_append(&writer, "%s\"%s\":%.4f", i ? "," : "", name, metrics_gpu_time(name));
+    }
+    results_append(&writer, "}");
+
+    // Counters hold their total and per-frame average over the measured frames, and gauges their final level.
+    results_append(&writer, ",\n\"counters\":{");
+    u32 count = counters_count();
+    for (u32 i = 0; i < count; ++i) {
+        counter_snapshot snapshot;
+        counter_snapshot_get(i, &snapshot);
+        const char* separator = i ? "," : "";
+        if (snapshot.type == COUNTER_TYPE_GAUGE) {
+            results_append(&writer, "%s\n\"%s\":{\"level\":%lld}", separator, snapshot.name, snapshot.value);
+        } else {
+            i64 total = snapshot.value - state_ptr->counter_start[i];
+            results_append(&writer, "%s\n\"%s\":{\"total\":%lld,\"per_frame\":%.2f}", separator, snapshot.name, total, (f64)total / frame_count);
+        }
+    }
+    results_append(&writer, "\n}\n}\n");
+    results_flush(&writer);
+    b8 result = !writer.failed;
+
+    kfree(writer.buffer, BENCHMARK_WRITE_BUFFER_SIZE, MEMORY_TAG_STRING);
+    filesystem_close(&writer.file);
+    if (!result) {
+        KERROR("Benchmark - Failed to write '%s'.", state_ptr->config.output_path);
+        return false;
+    }
+    KINFO("Benchmark finished: %u frames, avg=%.2fms p99=%.2fms. Results written to '%s'.", frame_count, frame_avg_ms, frame_p99_ms, state_ptr->config.output_path);
+    return true;
+}
+
+// Reads the whole of the given file into a new string, which should be freed with string_free.
+static char* file_text_read(const char* path) {
+    file_handle handle;
+    if (!filesystem_open(path, FILE_MODE_READ, false, &handle)) {
+        return 0;
+    }
+    u64 size = 0;
+    char* text = 0;
+    if (filesystem_size(&handle, &size)) {
+        text = kallocate(size + 1, MEMORY_TAG_STRING);
+        u64 read = 0;
+        if (!filesystem_read_all_text(&handle, text, &read)) {
+            read = 0;
+        }
+        text[read] = 0;
+    }
+    filesystem_close(&handle);
+    return text;
+}
+
+// Compares the results just written against the baseline, if there is one.
+static b8 baseline_check(void) {
+    const char* baseline_path = state_ptr->config.baseline_path;
+    if (!baseline_path) {
+        return true;
+    }
+    char* baseline = file_text_read(baseline_path);
+    if (!baseline) {
+        KWARN("Benchmark - No baseline could be read from '%s', so nothing was compared.", baseline_path);
+        return true;
+    }
+    char* results = file_text_read(state_ptr->config.output_path);
+    if (!results) {
+        KERROR("Benchmark - Unable to read back the results from '%s' to compare.", state_ptr->config.output_path);
+        string_free(baseline);
+        return false;
+    }
+
+    u32 regression_count = benchmark_results_compare(results, baseline, state_ptr->config.threshold_percent);
+    string_free(results);
+    string_free(baseline);
+    if (regression_count) {
+        KERROR("Benchmark - Scene '%s' regressed in %u times against '%s'.", state_ptr->config.scene, regression_count, baseline_path);
+        return false;
+    }
+    KINFO("Benchmark - Scene '%s' is within %.1f%% of '%s'.", state_ptr->config.scene, state_ptr->config.threshold_percent, baseline_path);
+    return true;
+}
+
+// Finds the value of the given stat within the given series' object of a results text.
+static b8 result_value_get(const char* text, const char* series, const char* stat, f64* out_value) {
+    char key[64];
+    i32 key_length = string_format(key, "\"%s\":{", series);
+    const char* object = 0;
+    for (const char* c = text; *c; ++c) {
+        if (strings_nequal(c, key, key_length)) {
+            object = c + key_length;
+            break;
+        }
+    }
+    if (!object) {
+        return false;
+    }
+
+    key_length = string_format(key, "\"%s\":", stat);
+    for (const char* c = object; *c && *c != '}'; ++c) {
+        if (strings_nequal(c, key, key_length)) {
+            const char* value = c + key_length;
+            return string_parse_f64(value, string_length(value), out_value) != 0;
+        }
+    }
+    return false;
+}
+
+u32 benchmark_results_compare(const char* results, const char* baseline, f32 threshold_percent) {
+    if (!results || !baseline) {
+        return 0;
+    }
+
+    u32 regression_count = 0;
+    const u32 stat_count = sizeof(compared_stat_names) / sizeof(const char*);
+    for (u32 s = 0; s < BENCHMARK_SERIES_COUNT; ++s) {
+        for (u32 i = 0; i < stat_count; ++i) {
+            f64 value;
+            f64 baseline_value;
+            if (!result_value_get(results, series_names[s], compared_stat_names[i], &value) ||
+                !result_value_get(baseline, series_names[s], compared_stat_names[i], &baseline_value)) {
+                continue;
+            }
+            f64 limit = baseline_value * (1.0 + threshold_percent / 100.0) + BENCHMARK_BASELINE_TOLERANCE_MS;
+            if (value > limit) {
+                KERROR("Benchmark regression - %s %s is %.4fms, up from %.4fms (limit %.4fms).", series_names[s], compared_stat_names[i], value, baseline_value, limit);
+                regression_count++;
+            }
+        }
+    }
+    return regression_count;
+}
+
+b8 benchmark_frame_end(f64 frame_time, f64 update_time, f64 render_time, b8* out_result) {
+    if (!state_ptr) {
+        return false;
+    }
+
+    u32 warmup_count = state_ptr->config.warmup_frame_count;
+    u32 frame = state_ptr->frames_seen++;
+    if (frame < warmup_count) {
+        // Measure from the end of the last warm-up frame.
+        if (frame + 1 == warmup_count) {
+            baseline_take();
+        }
+        return false;
+    }
+
+    u32 index = frame - warmup_count;
+    state_ptr->samples[BENCHMARK_SERIES_FRAME][index] = frame_time * 1000.0;
+    state_ptr->samples[BENCHMARK_SERIES_UPDATE][index] = update_time * 1000.0;
+    state_ptr->samples[BENCHMARK_SERIES_RENDER][index] = render_time * 1000.0;
+    state_ptr->samples[BENCHMARK_SERIES_GPU][index] = metrics_frame_gpu_time();
+    if (index + 1 < state_ptr->config.frame_count) {
+        return false;
+    }
+
+    *out_result = results_write() && baseline_check();
+    return true;
+}
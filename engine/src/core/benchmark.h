@@ -0,0 +1,116 @@
+/**
+ * @file benchmark.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief A benchmark mode for the application loop, which runs a fixed number of frames
+ * as fast as possible with a fixed time step, then writes frame time statistics and
+ * counters to a file and quits. Intended for catching performance regressions in CI.
+ * @details The game is told when a benchmark is running through application_benchmark_running,
+ * and which scene to drive through its application config's benchmark.scene. It should then drive that scene
+ * reproducibly, such as along a scripted camera path, from the delta times it is given rather
+ * than from input.
+ *
+ * Given a baseline, the results of an earlier run of the same scene, the run's frame, update,
+ * render and GPU times are compared against it once written out, and any which grew by more
+ * than the threshold are logged as regressions and fail the run, so the application exits
+ * with an error.
+ * @version 1.0
+ *
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief The number of frames a benchmark runs for when not given a frame count. */
+#define BENCHMARK_DEFAULT_FRAME_COUNT 1000
+
+/** @brief The number of frames skipped before measuring when not given a warm-up count. */
+#define BENCHMARK_DEFAULT_WARMUP_FRAME_COUNT 60
+
+/** @brief The file results are written to when not given a path. */
+#define BENCHMARK_DEFAULT_OUTPUT_PATH "benchmark.json"
+
+/** @brief The scene benchmarked when not given one. */
+#define BENCHMARK_DEFAULT_SCENE "sponza"
+
+/** @brief How far, as a percentage, a time may grow past its baseline when not given a threshold. */
+#define BENCHMARK_DEFAULT_THRESHOLD_PERCENT 10.0f
+
+/** @brief How far, in milliseconds, a time may always grow past its baseline, so that noise in very short times isn't a regression. */
+#define BENCHMARK_BASELINE_TOLERANCE_MS 0.05
+
+/** @brief The time step, in seconds, each benchmark frame is given regardless of how long it took. */
+#define BENCHMARK_FRAME_DELTA (1.0 / 60.0)
+
+/** @brief Configuration for a benchmark run. */
+typedef struct benchmark_config {
+    /** @brief The number of frames measured. 0 means no benchmark is run. */
+    u32 frame_count;
+    /** @brief The number of frames run before measuring, so that loading and warm-up are not counted. */
+    u32 warmup_frame_count;
+    /** @brief The path results are written to. */
+    const char* output_path;
+    /** @brief The name of the scene the game should drive. */
+    const char* scene;
+    /** @brief The path of the results the run is compared against, or 0 to not compare. */
+    const char* baseline_path;
+    /** @brief How far, as a percentage, a time may grow past its baseline before it is a regression. */
+    f32 threshold_percent;
+} benchmark_config;
+
+/**
+ * @brief Fills out a benchmark configuration from command line arguments. Recognizes
+ * --benchmark[=frames], --benchmark-warmup=frames, --benchmark-output=path,
+ * --benchmark-scene=name, --benchmark-baseline=path and --benchmark-threshold=percent.
+ * Without --benchmark, frame_count is 0 and no benchmark is run.
+ *
+ * @param argc The number of arguments, as given to main.
+ * @param argv The arguments, as given to main. Must outlive the benchmark, as the paths and scene name are not copied.
+ * @param out_config A pointer to hold the configuration.
+ */
+KAPI void benchmark_config_parse(i32 argc, char** argv, benchmark_config* out_config);
+
+/**
+ * @brief Initializes a benchmark run. Should be called twice; once to get the memory requirement
+ * (passing state=0), and a second time passing an allocated block of memory to actually initialize it.
+ *
+ * @param memory_requirement A pointer to hold the memory requirement.
+ * @param state A block of memory to hold the state or, if gathering the memory requirement, 0.
+ * @param config The configuration. frame_count must be nonzero.
+ * @return True on success; otherwise false.
+ */
+b8 benchmark_initialize(u64* memory_requirement, void* state, const benchmark_config* config);
+
+/**
+ * @brief Shuts down a benchmark run.
+ *
+ * @param state The state block of memory.
+ */
+void benchmark_shutdown(void* state);
+
+/**
+ * @brief Records a frame, which should have already been given to metrics_update and followed
+ * by counters_snapshot. Once the last frame is recorded, the results are written out and, if
+ * there is a baseline, compared against it.
+ *
+ * @param frame_time The time taken by the frame in seconds.
+ * @param update_time The time spent in the game's update, in seconds.
+ * @param render_time The time spent in the game's render, and in building and submitting the frame, in seconds.
+ * @param out_result A pointer to hold whether the results were written successfully without any regressions, set once the benchmark is done.
+ * @return True if the benchmark is done; otherwise false.
+ */
+b8 benchmark_frame_end(f64 frame_time, f64 update_time, f64 render_time, b8* out_result);
+
+/**
+ * @brief Compares benchmark results against a baseline, logging every time which grew by more
+ * than the given threshold.
+ *
+ * @param results The text of the results, as written by a benchmark run.
+ * @param baseline The text of the baseline results.
+ * @param threshold_percent How far, as a percentage, a time may grow past its baseline.
+ * @return The number of regressions found. Times missing from either are skipped.
+ */
+KAPI u32 benchmark_results_compare(const char* results, const char* baseline, f32 threshold_percent);
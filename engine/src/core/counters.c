@@ -0,0 +1,109 @@
+#include "counters.h"
+
+#include "core/kstring.h"
+
+typedef struct counter_entry {
+    char name[COUNTER_NAME_MAX_LENGTH];
+    counter_type type;
+    // If set, the value is read from here when snapshotted rather than from counter_values.
+    const u64* source;
+    // The value as of the snapshot before last, and the last snapshot.
+    i64 previous_value;
+    counter_snapshot snapshot;
+} counter_entry;
+
+i64 counter_values[COUNTERS_MAX];
+
+static counter_entry counters[COUNTERS_MAX];
+static u32 counter_count;
+// Serializes registration, which may happen on any thread.
+static u32 registry_lock;
+
+static void registry_lock_take(void) {
+    u32 expected = 0;
+    while (!katomic_compare_exchange(&registry_lock, &expected, 1)) {
+        expected = 0;
+    }
+}
+
+static void registry_lock_release(void) {
+    katomic_store_release(&registry_lock, 0);
+}
+
+// Finds or adds the counter with the given name. The registry lock must be held.
+static u32 counter_find_or_add(const char* name, counter_type type) {
+    for (u32 i = 0; i < counter_count; ++i) {
+        if (strings_nequal(counters[i].name, name, COUNTER_NAME_MAX_LENGTH - 1)) {
+            return i;
+        }
+    }
+    if (counter_count == COUNTERS_MAX) {
+        return INVALID_ID;
+    }
+
+    counter_entry* entry = &counters[counter_count];
+    string_ncopy(entry->name, name, COUNTER_NAME_MAX_LENGTH - 1);
+    entry->name[COUNTER_NAME_MAX_LENGTH - 1] = 0;
+    entry->type = type;
+    entry->snapshot.name = entry->name;
+    entry->snapshot.type = type;
+    // Publish the entry before the count, so that snapshots on other threads only see it complete.
+    katomic_store_release(&counter_count, counter_count + 1);
+    return counter_count - 1;
+}
+
+u32 counter_register(const char* name, counter_type type) {
+    if (!name) {
+        return INVALID_ID;
+    }
+    registry_lock_take();
+    u32 id = counter_find_or_add(name, type);
+    registry_lock_release();
+    return id;
+}
+
+u32 counter_register_source(const char* name, counter_type type, const u64* source) {
+    if (!name || !source) {
+        return INVALID_ID;
+    }
+    registry_lock_take();
+    u32 id = counter_find_or_add(name, type);
+    if (id != INVALID_ID) {
+        katomic_store_release(&counters[id].source, source);
+    }
+    registry_lock_release();
+    return id;
+}
+
+void counter_source_clear(u32 id) {
+    if (id < COUNTERS_MAX) {
+        const u64* source = katomic_exchange(&counters[id].source, (const u64*)0);
+        if (source) {
+            katomic_store_relaxed(&counter_values[id], (i64)katomic_load_relaxed(source));
+        }
+    }
+}
+
+void counters_snapshot(void) {
+    u32 count = katomic_load_acquire(&counter_count);
+    for (u32 i = 0; i < count; ++i) {
+        counter_entry* entry = &counters[i];
+        const u64* source = katomic_load_acquire(&entry->source);
+        i64 value = source ? (i64)katomic_load_relaxed(source) : katomic_load_relaxed(&counter_values[i]);
+        entry->snapshot.value = value;
+        entry->snapshot.frame_value = entry->type == COUNTER_TYPE_COUNTER ? value - entry->previous_value : value;
+        entry->previous_value = value;
+    }
+}
+
+u32 counters_count(void) {
+    return katomic_load_acquire(&counter_count);
+}
+
+b8 counter_snapshot_get(u32 id, counter_snapshot* out_snapshot) {
+    if (id >= counters_count() || !out_snapshot) {
+        return false;
+    }
+    *out_snapshot = counters[id].snapshot;
+    return true;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file counters.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief A registry of named counters and gauges which subsystems publish, such as draw calls,
+ * bytes staged or textures resident, snapshotted once per frame for display and investigation.
+ * @details Counters accumulate, and their snapshots hold how much they went up by in the last
+ * frame as well as their total. Gauges hold a current level, such as a number of live objects.
+ * Updates are single relaxed atomic operations, so can be made from any thread. A counter may
+ * also be backed by a value the subsystem already keeps up to date atomically, which is read at
+ * snapshot time instead, so that publishing it costs nothing on the subsystem's hot path.
+ * The registry is static, so counters may be registered before any other system is stood up.
+ * @version 1.0
+ *
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "core/katomic.h"
+
+/** @brief The most counters which can be registered. */
+#define COUNTERS_MAX 256
+
+/** @brief The longest counter name, including its terminator. Longer names are cut short. */
+#define COUNTER_NAME_MAX_LENGTH 48
+
+/** @brief The kinds of counter. */
+typedef enum counter_type {
+    /** @brief Only goes up. Snapshots hold the amount added in the last frame. */
+    COUNTER_TYPE_COUNTER,
+    /** @brief Holds a level which may go up or down. Snapshots hold the level at the end of the frame. */
+    COUNTER_TYPE_GAUGE
+} counter_type;
+
+/** @brief A counter as of the last snapshot. */
+typedef struct counter_snapshot {
+    /** @brief The name of the counter. */
+    const char* name;
+    /** @brief The kind of counter. */
+    counter_type type;
+    /** @brief For a counter, the amount it went up by in the last frame. For a gauge, its level. */
+    i64 frame_value;
+    /** @brief The value of the counter or gauge. */
+    i64 value;
+} counter_snapshot;
+
+/** @brief The live value of every counter. Use counter_add and counter_set rather than writing these directly. */
+KAPI extern i64 counter_values[COUNTERS_MAX];
+
+/**
+ * @brief Registers a counter or gauge with the given name, or returns the existing one of that name.
+ *
+ * @param name The name, conventionally "subsystem.counter". Copied.
+ * @param type The kind of counter.
+ * @return The id of the counter, or INVALID_ID if the registry is full. Updates to INVALID_ID are ignored.
+ */
+KAPI u32 counter_register(const char* name, counter_type type);
+
+/**
+ * @brief Registers a counter or gauge whose value is read from the given location at each snapshot,
+ * or points the existing one of that name at it.
+ *
+ * @param name The name, conventionally "subsystem.counter". Copied.
+ * @param type The kind of counter.
+ * @param source A pointer to the value, which must stay valid until counter_source_clear is called.
+ * It is read atomically, so should be written atomically.
+ * @return The id of the counter, or INVALID_ID if the registry is full.
+ */
+KAPI u32 counter_register_source(const char* name, counter_type type, const u64* source);
+
+/**
+ * @brief Stops reading a counter's value from the location given to counter_register_source,
+ * such as when that location is about to be freed. The counter keeps its last value.
+ *
+ * @param id The id of the counter.
+ */
+KAPI void counter_source_clear(u32 id);
+
+/**
+ * @brief Takes a snapshot of every counter. Should be called once per frame, at the end of the frame.
+ */
+KAPI void counters_snapshot(void);
+
+/**
+ * @brief Returns the number of registered counters. Ids run from 0 to this count.
+ */
+KAPI u32 counters_count(void);
+
+/**
+ * @brief Gets a counter as of the last snapshot.
+ *
+ * @param id The id of the counter.
+ * @param out_snapshot A pointer to hold the counter's snapshot.
+ * @return True if the id is of a registered counter; otherwise false.
+ */
+KAPI b8 counter_snapshot_get(u32 id, counter_snapshot* out_snapshot);
+
+/**
+ * @brief Adds the given amount to a counter, or to the level of a gauge. Safe to call from any thread.
+ *
+ * @param id The id of the counter, as returned by counter_register.
+ * @param amount The amount to add, which may be negative for gauges.
+ */
+KINLINE void counter_add(u32 id, i64 amount) {
+    if (id < COUNTERS_MAX) {
+        katomic_fetch_add_relaxed(&counter_values[id], amount);
+    }
+}
+
+/**
+ * @brief Sets the level of a gauge. Safe to call from any thread.
+ *
+ * @param id The id of the gauge, as returned by counter_register.
+ * @param value The new level.
+ */
+KINLINE void counter_set(u32 id, i64 value) {
+    if (id < COUNTERS_MAX) {
+        katomic_store_relaxed(&counter_values[id], value);
+    }
+}
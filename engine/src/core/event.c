@@ -2,24 +2,55 @@
 
 #include "core/kmemory.h"
 #include "core/logger.h"
+#include "containers/bitset.h"
 #include "containers/darray.h"
+#include "containers/flat_map.h"
+#include "containers/mpmc_queue.h"
 
 typedef struct registered_event {
     void* listener;
     PFN_on_event callback;
 } registered_event;
 
+// Where a code's listeners sit in the listener array.
 typedef struct event_code_entry {
-    registered_event* events;
+    u32 first;
+    u32 count;
 } event_code_entry;
 
-// This should be more than enough codes...
-#define MAX_MESSAGE_CODES 16384
+// Every possible u16 code, for the per-code flags.
+#define EVENT_CODE_COUNT 65536
+
+// The number of events which can be posted between dispatches. Must be a power of 2.
+#define DEFERRED_EVENT_CAPACITY 1024
+
+// Marks a deferred event superseded by a later one of the same code.
+#define DEFERRED_EVENT_DROPPED INVALID_ID
+
+typedef struct deferred_event {
+    u32 code;
+    void* sender;
+    event_context context;
+} deferred_event;
 
 // State structure.
 typedef struct event_system_state {
-    // Lookup table for event codes.
-    event_code_entry registered[MAX_MESSAGE_CODES];
+    // The codes with listeners, mapped to an event_code_entry. Only codes in use take up space.
+    flat_map codes;
+    // Every listener, grouped by code in code order, so a code's listeners are contiguous.
+    registered_event* listeners;
+
+    // Codes for which only the latest posted event is dispatched.
+    bitset coalesced;
+    u64 coalesced_words[EVENT_CODE_COUNT / BITSET_WORD_BITS];
+    // Coalesced codes already met while walking a batch back to front.
+    bitset seen;
+    u64 seen_words[EVENT_CODE_COUNT / BITSET_WORD_BITS];
+
+    // Events posted from any thread, waiting for the next dispatch. Its memory follows this state.
+    mpmc_queue deferred;
+    // The batch being dispatched, so that posting during dispatch defers to the next one.
+    deferred_event batch[DEFERRED_EVENT_CAPACITY];
 } event_system_state;
 
 /**
@@ -28,49 +59,78 @@ typedef struct event_system_state {
 static event_system_state* state_ptr;
 
 void event_system_initialize(u64* memory_requirement, void* state) {
-    *memory_requirement = sizeof(event_system_state);
+    *memory_requirement = sizeof(event_system_state) + mpmc_queue_memory_requirement(sizeof(deferred_event), DEFERRED_EVENT_CAPACITY);
     if (state == 0) {
         return;
     }
-    kzero_memory(state, sizeof(state));
+    kzero_memory(state, sizeof(event_system_state));
     state_ptr = state;
+
+    flat_map_create(sizeof(event_code_entry), 0, &state_ptr->codes);
+    state_ptr->listeners = darray_create(registered_event);
+    bitset_create(EVENT_CODE_COUNT, state_ptr->coalesced_words, &state_ptr->coalesced);
+    bitset_create(EVENT_CODE_COUNT, state_ptr->seen_words, &state_ptr->seen);
+    mpmc_queue_create(sizeof(deferred_event), DEFERRED_EVENT_CAPACITY, (u8*)state + sizeof(event_system_state), &state_ptr->deferred);
+
+    // Only the latest position and size matter, however many arrive in a frame.
+    bitset_set(&state_ptr->coalesced, EVENT_CODE_MOUSE_MOVED);
+    bitset_set(&state_ptr->coalesced, EVENT_CODE_RESIZED);
 }
 
 void event_system_shutdown(void* state) {
     if (state_ptr) {
-        // Free the events arrays. And objects pointed to should be destroyed on their own.
-        for (u16 i = 0; i < MAX_MESSAGE_CODES; ++i) {
-            if (state_ptr->registered[i].events != 0) {
-                darray_destroy(state_ptr->registered[i].events);
-                state_ptr->registered[i].events = 0;
-            }
-        }
+        // Only the tables are freed. And objects pointed to should be destroyed on their own.
+        flat_map_destroy(&state_ptr->codes);
+        darray_destroy(state_ptr->listeners);
+        state_ptr->listeners = 0;
+        mpmc_queue_destroy(&state_ptr->deferred);
     }
     state_ptr = 0;
 }
 
+// Moves the listeners of every code after the given position in the code map by the given amount.
+static void shift_entries_after(u32 position, i32 amount) {
+    for (u32 i = position + 1; i < state_ptr->codes.count; ++i) {
+        event_code_entry* entry = flat_map_value_at(&state_ptr->codes, i);
+        entry->first += amount;
+    }
+}
+
 b8 event_register(u16 code, void* listener, PFN_on_event on_event) {
     if (!state_ptr) {
         return false;
     }
 
-    if (state_ptr->registered[code].events == 0) {
-        state_ptr->registered[code].events = darray_create(registered_event);
-    }
-
-    u64 registered_count = darray_length(state_ptr->registered[code].events);
-    for (u64 i = 0; i < registered_count; ++i) {
-        if (state_ptr->registered[code].events[i].listener == listener && state_ptr->registered[code].events[i].callback == on_event) {
-            KWARN("Event has already been registered with the code %hu and the callback of %p", code, on_event);
+    u32 position = flat_map_lower_bound(&state_ptr->codes, code);
+    event_code_entry* entry = 0;
+    if (position < state_ptr->codes.count && flat_map_key_at(&state_ptr->codes, position) == code) {
+        entry = flat_map_value_at(&state_ptr->codes, position);
+        for (u32 i = 0; i < entry->count; ++i) {
+            registered_event* e = &state_ptr->listeners[entry->first + i];
+            if (e->listener == listener && e->callback == on_event) {
+                KWARN("Event has already been registered with the code %hu and the callback of %p", code, on_event);
+                return false;
+            }
+        }
+    } else {
+        // A new code's listeners go where the next code's begin, keeping them in code order.
+        event_code_entry new_entry;
+        new_entry.first = position < state_ptr->codes.count ? ((event_code_entry*)flat_map_value_at(&state_ptr->codes, position))->first : (u32)darray_length(state_ptr->listeners);
+        new_entry.count = 0;
+        entry = flat_map_set(&state_ptr->codes, code, &new_entry);
+        if (!entry) {
+            KERROR("event_register - Failed to add the code %hu.", code);
             return false;
         }
     }
 
-    // If at this point, no duplicate was found. Proceed with registration.
+    // If at this point, no duplicate was found. Proceed with registration, after the code's other listeners.
     registered_event event;
     event.listener = listener;
     event.callback = on_event;
-    darray_push(state_ptr->registered[code].events, event);
+    darray_insert_at(state_ptr->listeners, entry->first + entry->count, event);
+    entry->count++;
+    shift_entries_after(position, 1);
 
     return true;
 }
@@ -81,18 +141,22 @@ b8 event_unregister(u16 code, void* listener, PFN_on_event on_event) {
     }
 
     // On nothing is registered for the code, boot out.
-    if (state_ptr->registered[code].events == 0) {
-        // TODO: warn
+    u32 position = flat_map_lower_bound(&state_ptr->codes, code);
+    if (position >= state_ptr->codes.count || flat_map_key_at(&state_ptr->codes, position) != code) {
         return false;
     }
 
-    u64 registered_count = darray_length(state_ptr->registered[code].events);
-    for (u64 i = 0; i < registered_count; ++i) {
-        registered_event e = state_ptr->registered[code].events[i];
-        if (e.listener == listener && e.callback == on_event) {
+    event_code_entry* entry = flat_map_value_at(&state_ptr->codes, position);
+    for (u32 i = 0; i < entry->count; ++i) {
+        registered_event* e = &state_ptr->listeners[entry->first + i];
+        if (e->listener == listener && e->callback == on_event) {
             // Found one, remove it
-            registered_event popped_event;
-            darray_pop_at(state_ptr->registered[code].events, i, &popped_event);
+            darray_pop_at(state_ptr->listeners, entry->first + i, 0);
+            shift_entries_after(position, -1);
+            entry->count--;
+            if (entry->count == 0) {
+                flat_map_remove(&state_ptr->codes, code, 0);
+            }
             return true;
         }
     }
@@ -107,13 +171,17 @@ b8 event_fire(u16 code, void* sender, event_context context) {
     }
 
     // If nothing is registered for the code, boot out.
-    if (state_ptr->registered[code].events == 0) {
+    event_code_entry* entry = flat_map_get(&state_ptr->codes, code);
+    if (!entry) {
         return false;
     }
 
-    u64 registered_count = darray_length(state_ptr->registered[code].events);
-    for (u64 i = 0; i < registered_count; ++i) {
-        registered_event e = state_ptr->registered[code].events[i];
+    // Taken up front, as registering moves entries. The listener array is indexed fresh each time, as
+    // registering may also reallocate it.
+    u32 first = entry->first;
+    u32 count = entry->count;
+    for (u32 i = 0; i < count; ++i) {
+        registered_event e = state_ptr->listeners[first + i];
         if (e.callback(code, sender, e.listener, context)) {
             // Message has been handled, do not send to other listeners.
             return true;
@@ -122,4 +190,67 @@ b8 event_fire(u16 code, void* sender, event_context context) {
 
     // Not found.
     return false;
-}
\ No newline at end of file
+}
+
+b8 event_post(u16 code, void* sender, event_context context) {
+    if (!state_ptr) {
+        return false;
+    }
+
+    deferred_event event;
+    event.code = code;
+    event.sender = sender;
+    event.context = context;
+    if (!mpmc_queue_try_push(&state_ptr->deferred, &event)) {
+        KWARN("event_post - The deferred event queue is full, dropping event with code %hu.", code);
+        return false;
+    }
+    return true;
+}
+
+void event_set_coalesced(u16 code, b8 coalesced) {
+    if (!state_ptr) {
+        return;
+    }
+
+    if (coalesced) {
+        bitset_set(&state_ptr->coalesced, code);
+    } else {
+        bitset_clear(&state_ptr->coalesced, code);
+    }
+}
+
+u32 event_dispatch_deferred(void) {
+    if (!state_ptr) {
+        return 0;
+    }
+
+    // Take everything posted so far in one go. Events posted by listeners wait for the next dispatch.
+    deferred_event* batch = state_ptr->batch;
+    u32 count = mpmc_queue_pop_batch(&state_ptr->deferred, batch, DEFERRED_EVENT_CAPACITY);
+
+    // Walk back to front, so the first of each coalesced code met is the latest, and drop the rest.
+    for (u32 i = count; i > 0; --i) {
+        deferred_event* event = &batch[i - 1];
+        if (bitset_test(&state_ptr->coalesced, event->code)) {
+            if (bitset_test(&state_ptr->seen, event->code)) {
+                event->code = DEFERRED_EVENT_DROPPED;
+            } else {
+                bitset_set(&state_ptr->seen, event->code);
+            }
+        }
+    }
+
+    u32 dispatched = 0;
+    for (u32 i = 0; i < count; ++i) {
+        deferred_event* event = &batch[i];
+        if (event->code == DEFERRED_EVENT_DROPPED) {
+            continue;
+        }
+        // Clearing here, rather than all at once, only touches the codes in this batch.
+        bitset_clear(&state_ptr->seen, event->code);
+        event_fire((u16)event->code, event->sender, event->context);
+        dispatched++;
+    }
+    return dispatched;
+}
@@ -7,6 +7,10 @@
  * data at critical points in the execution of the application in a non-
  * coupled way. For now, this follows a simple pub-sub model of event
  * transmission.
+ * Events may be fired, which calls their listeners immediately, or posted,
+ * which queues them to be dispatched all at once at a fixed point in the
+ * frame. Registering and firing are only safe from the main thread, whereas
+ * posting is safe from any thread, including jobs.
  * @version 1.0
  *
  * 
@@ -72,12 +76,12 @@ typedef b8 (*PFN_on_event)(u16 code, void* sender, void* listener_inst, event_co
 /**
  * @brief Initializes the event system.
  */
-void event_system_initialize(u64* memory_requirement, void* state);
+KAPI void event_system_initialize(u64* memory_requirement, void* state);
 
 /**
  * @brief Shuts the event system down.
  */
-void event_system_shutdown(void* state);
+KAPI void event_system_shutdown(void* state);
 
 /**
  * @brief Register to listen for when events are sent with the provided code. Events with duplicate
@@ -109,6 +113,34 @@ KAPI b8 event_unregister(u16 code, void* listener, PFN_on_event on_event);
  */
 KAPI b8 event_fire(u16 code, void* sender, event_context context);
 
+/**
+ * @brief Posts an event to be fired at the next call to event_dispatch_deferred. Safe to call
+ * from any thread. If the event's code is coalesced, only the latest event posted with that code
+ * before the dispatch is fired, whatever its sender.
+ * @param code The event code to post.
+ * @param sender A pointer to the sender. Can be 0/NULL. Must remain valid until dispatched.
+ * @param context The event data.
+ * @returns True if the event was queued; false if the queue is full.
+ */
+KAPI b8 event_post(u16 code, void* sender, event_context context);
+
+/**
+ * @brief Sets whether posted events of the given code are coalesced, so that only the latest per
+ * dispatch is fired. EVENT_CODE_MOUSE_MOVED and EVENT_CODE_RESIZED are coalesced by default.
+ * Fired events are never coalesced. Must be called from the main thread.
+ * @param code The event code.
+ * @param coalesced True to coalesce posted events of the code; false to fire each of them.
+ */
+KAPI void event_set_coalesced(u16 code, b8 coalesced);
+
+/**
+ * @brief Fires every event posted since the last dispatch, in the order they were posted, minus
+ * any superseded coalesced events. Events posted while dispatching wait for the next call. Must be
+ * called from the main thread; the application does so once per frame.
+ * @returns The number of events fired.
+ */
+KAPI u32 event_dispatch_deferred(void);
+
 /** @brief System internal event codes. Application should use codes beyond 255. */
 typedef enum system_event_code {
     /** @brief Shuts the application down on the next frame. */
@@ -187,6 +219,31 @@ typedef enum system_event_code {
      */
     EVENT_CODE_DEFAULT_RENDERTARGET_REFRESH_REQUIRED = 0x16,
 
+    /**
+     * @brief Turns the depth prepass of the world view on or off.
+     * Context usage:
+     * b8 enabled = context.data.u8[0];
+     */
+    EVENT_CODE_SET_DEPTH_PREPASS = 0x17,
+
+    /**
+     * @brief Posted by the renderer backend when the pressure on GPU memory changes, so that
+     * systems holding memory they can do without give it back before allocations fail.
+     * Context usage:
+     * renderer_memory_pressure pressure = context.data.u8[0];
+     * f32 used = context.data.f32[1]; // The fraction of its budget the fullest device-local heap uses.
+     */
+    EVENT_CODE_GPU_MEMORY_PRESSURE = 0x18,
+
+    /**
+     * @brief Posted by the platform layer when the window is hidden or shown, or loses or gains focus.
+     * A window is hidden while minimized or unmapped, or while entirely covered where that is reported.
+     * Context usage:
+     * b8 visible = context.data.u8[0];
+     * b8 focused = context.data.u8[1];
+     */
+    EVENT_CODE_WINDOW_VISIBILITY_CHANGED = 0x19,
+
     /** @brief The maximum event code that can be used internally. */
     MAX_EVENT_CODE = 0xFF
 } system_event_code;
\ No newline at end of file
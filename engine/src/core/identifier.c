@@ -1,45 +1,137 @@
 #include "identifier.h"
 
-#include "containers/darray.h"
+#include "core/katomic.h"
+#include "core/kmemory.h"
 #include "core/logger.h"
 
-static void** owners = 0;
+// Slots are allocated a page at a time as identifiers are first handed out, and are never moved
+// or freed, so any thread can reach a slot without a lock.
+#define IDENTIFIER_PAGE_SHIFT 12
+#define IDENTIFIER_PAGE_SIZE (1u << IDENTIFIER_PAGE_SHIFT)
+#define IDENTIFIER_PAGE_MASK (IDENTIFIER_PAGE_SIZE - 1)
+#define IDENTIFIER_PAGE_COUNT ((IDENTIFIER_MAX_COUNT + IDENTIFIER_PAGE_SIZE - 1) / IDENTIFIER_PAGE_SIZE)
+
+typedef struct identifier_slot {
+    // The owner, or 0 if the identifier is free.
+    void* owner;
+    // Advanced every time the identifier is released.
+    u32 generation;
+    // While in the free list, the next free identifier, or 0 if this is the last.
+    u32 next_free;
+} identifier_slot;
+
+static identifier_slot* pages[IDENTIFIER_PAGE_COUNT] = {0};
+
+// The free list head: the first free identifier in the low 32 bits, or 0 if the list is empty,
+// and a count of changes to the list in the high 32 bits, so a head popped and pushed back by
+// another thread in between is never mistaken for the one read.
+static u64 free_head = 0;
+
+// The next identifier never handed out. Index 0 is kept from ever being used.
+static u32 next_unused = 1;
+
+// Obtains the slot of the given identifier, or 0 if its page was never allocated.
+static identifier_slot* slot_get(u32 id) {
+    identifier_slot* page = katomic_load_acquire(&pages[id >> IDENTIFIER_PAGE_SHIFT]);
+    return page ? &page[id & IDENTIFIER_PAGE_MASK] : 0;
+}
+
+// Obtains the slot of the given identifier, allocating its page if no thread has yet.
+static identifier_slot* slot_ensure(u32 id) {
+    identifier_slot** page_ptr = &pages[id >> IDENTIFIER_PAGE_SHIFT];
+    identifier_slot* page = katomic_load_acquire(page_ptr);
+    if (!page) {
+        identifier_slot* new_page = kallocate(sizeof(identifier_slot) * IDENTIFIER_PAGE_SIZE, MEMORY_TAG_ARRAY);
+        kzero_memory(new_page, sizeof(identifier_slot) * IDENTIFIER_PAGE_SIZE);
+        identifier_slot* expected = 0;
+        if (katomic_compare_exchange(page_ptr, &expected, new_page)) {
+            page = new_page;
+        } else {
+            // Another thread got there first, so use its page instead.
+            kfree(new_page, sizeof(identifier_slot) * IDENTIFIER_PAGE_SIZE, MEMORY_TAG_ARRAY);
+            page = expected;
+        }
+    }
+    return &page[id & IDENTIFIER_PAGE_MASK];
+}
+
+// Obtains the slot of the given identifier if it has ever been handed out; otherwise 0.
+static identifier_slot* slot_get_handed_out(u32 id) {
+    if (id == 0 || id == INVALID_ID || id >= katomic_load_acquire(&next_unused)) {
+        return 0;
+    }
+    return slot_get(id);
+}
 
 u32 identifier_aquire_new_id(void* owner) {
-    if (!owners) {
-        owners = darray_reserve(void*, 100);
-        // Push invalid id to the first entry. This is to keep
-        // index 0 from ever being used.
-        darray_push(owners, INVALID_ID_U64);
-    }
-    u64 length = darray_length(owners);
-    for (u64 i = 0; i < length; ++i) {
-        // Existing free spot. Take it.
-        if (owners[i] == 0) {
-            owners[i] = owner;
-            return i;
+    if (!owner) {
+        KERROR("identifier_aquire_new_id requires an owner. INVALID_ID returned.");
+        return INVALID_ID;
+    }
+
+    // Take the first free identifier if there is one.
+    u64 head = katomic_load_acquire(&free_head);
+    while ((u32)head) {
+        u32 id = (u32)head;
+        identifier_slot* slot = slot_get(id);
+        u64 next = ((head >> 32) + 1) << 32 | katomic_load_relaxed(&slot->next_free);
+        if (katomic_compare_exchange(&free_head, &head, next)) {
+            katomic_store_release(&slot->owner, owner);
+            return id;
         }
     }
 
-    // If here, no existing free slots. Need a new id, so push one.
-    // This means the id will be length - 1
-    darray_push(owners, owner);
-    length = darray_length(owners);
-    return length - 1;
+    // If here, no free identifiers. Hand out a new one.
+    u32 id = katomic_fetch_add(&next_unused, 1);
+    if (id >= IDENTIFIER_MAX_COUNT) {
+        katomic_fetch_sub(&next_unused, 1);
+        KERROR("identifier_aquire_new_id: all %u identifiers are held. INVALID_ID returned.", IDENTIFIER_MAX_COUNT - 1);
+        return INVALID_ID;
+    }
+    identifier_slot* slot = slot_ensure(id);
+    katomic_store_release(&slot->owner, owner);
+    return id;
 }
 
 void identifier_release_id(u32 id) {
-    if (!owners) {
-        KERROR("identifier_release_id called before initialization. identifier_aquire_new_id should have been called first. Nothing was done.");
+    identifier_slot* slot = slot_get_handed_out(id);
+    if (!slot) {
+        KERROR("identifier_release_id: id '%u' was never acquired. Nothing was done.", id);
         return;
     }
 
-    u64 length = darray_length(owners);
-    if (id > length) {
-        KERROR("identifier_release_id: id '%u' out of range (max=%llu). Nothing was done.", id, length);
+    void* owner = katomic_exchange(&slot->owner, (void*)0);
+    if (!owner) {
+        KERROR("identifier_release_id: id '%u' is not held; was it already released? Nothing was done.", id);
         return;
     }
+    katomic_fetch_add(&slot->generation, 1);
+
+    // Push it onto the free list, making it available for use.
+    u64 head = katomic_load_acquire(&free_head);
+    u64 next;
+    do {
+        katomic_store_relaxed(&slot->next_free, (u32)head);
+        next = ((head >> 32) + 1) << 32 | id;
+    } while (!katomic_compare_exchange(&free_head, &head, next));
+}
 
-    // Just zero out the entry, making it available for use.
-    owners[id] = 0;
+u32 identifier_generation_get(u32 id) {
+    identifier_slot* slot = slot_get_handed_out(id);
+    return slot ? katomic_load_acquire(&slot->generation) : INVALID_ID;
+}
+
+void* identifier_owner_get(u32 id) {
+    identifier_slot* slot = slot_get_handed_out(id);
+    return slot ? katomic_load_acquire(&slot->owner) : 0;
+}
+
+b8 identifier_is_current(u32 id, u32 generation) {
+    identifier_slot* slot = slot_get_handed_out(id);
+    if (!slot) {
+        return false;
+    }
+    // The owner is cleared before the generation advances, so an owner read before a generation
+    // which still matches was not released in between.
+    return katomic_load_acquire(&slot->owner) != 0 && katomic_load_acquire(&slot->generation) == generation;
 }
@@ -2,6 +2,12 @@
  * @file identifier.h
  * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
  * @brief Contains a system for creating numeric identifiers.
+ * @details Identifiers are small indices, starting at 1, so they fit the 24 bits a pick colour holds
+ * and can index arrays of per-object data directly. Released identifiers are kept in a lock-free
+ * free list and handed out again, so acquiring and releasing take constant time from any thread.
+ * As an identifier is soon reused, each one also has a generation, advanced every time it is
+ * released, so anything which held on to an identifier, such as a pick read back a few frames late,
+ * can tell whether it still refers to the same owner.
  * @version 1.0
  * @date 2026-04-14
  *
@@ -13,18 +19,47 @@
 
 #include "defines.h"
 
+/** @brief The most identifiers which can be held at once, plus one for the reserved identifier 0. Keeps identifiers below pure white as a pick colour. */
+#define IDENTIFIER_MAX_COUNT 0x00FFFFFF
+
 /**
- * @brief Acquires a new identifier for the given owner.
+ * @brief Acquires a new identifier for the given owner. Thread-safe.
  *
- * @param owner The owner of the identifier.
- * @return The new identifier.
+ * @param owner The owner of the identifier. Must not be 0.
+ * @return The new identifier, or INVALID_ID if none could be acquired.
  */
 KAPI u32 identifier_aquire_new_id(void* owner);
 
 /**
  * @brief Releases the given identifier, which can then be used
- * again.
+ * again. Advances its generation. Thread-safe.
  *
  * @param id The identifier to be released.
  */
 KAPI void identifier_release_id(u32 id);
+
+/**
+ * @brief Obtains the current generation of the given identifier, which changes every time the identifier is released.
+ *
+ * @param id The identifier.
+ * @return The generation, or INVALID_ID if the identifier was never acquired.
+ */
+KAPI u32 identifier_generation_get(u32 id);
+
+/**
+ * @brief Obtains the owner the given identifier was acquired for.
+ *
+ * @param id The identifier.
+ * @return The owner, or 0 if the identifier is not held.
+ */
+KAPI void* identifier_owner_get(u32 id);
+
+/**
+ * @brief Indicates if the given identifier is held and still has the given generation, meaning it
+ * refers to the same owner it did when the generation was obtained.
+ *
+ * @param id The identifier.
+ * @param generation The generation obtained along with the identifier.
+ * @return True if the identifier is current; otherwise false.
+ */
+KAPI b8 identifier_is_current(u32 id, u32 generation);
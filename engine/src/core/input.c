@@ -1,7 +1,12 @@
 #include "core/input.h"
 #include "core/event.h"
+#include "core/katomic.h"
 #include "core/kmemory.h"
 #include "core/logger.h"
+#include "platform/platform.h"
+
+// The number of platform events held between dispatches. A full queue is dispatched early.
+#define INPUT_EVENT_QUEUE_CAPACITY 512
 
 typedef struct keyboard_state {
     b8 keys[256];
@@ -18,6 +23,29 @@ typedef struct input_state {
     keyboard_state keyboard_previous;
     mouse_state mouse_current;
     mouse_state mouse_previous;
+
+    // Raw mouse motion accumulated this frame.
+    i32 mouse_raw_delta_x;
+    i32 mouse_raw_delta_y;
+
+    // Events received from the platform since the last dispatch, in order.
+    input_event queue[INPUT_EVENT_QUEUE_CAPACITY];
+    u32 queue_count;
+    // The timestamp of the event being dispatched.
+    f64 event_time;
+    // Indicates if the queue is being dispatched.
+    b8 dispatching;
+
+    // The events dispatched since the last snapshot, for the next one to hold.
+    input_event frame_events[INPUT_SNAPSHOT_EVENT_CAPACITY];
+    u32 frame_event_count;
+    u32 frame_dropped_event_count;
+    i32 frame_wheel_delta;
+
+    // The last two snapshots taken. Readers only ever see one once it is complete.
+    input_snapshot snapshots[2];
+    // The number of snapshots taken. The latest is the one at the index below this, modulo 2.
+    u64 snapshot_count;
 } input_state;
 
 // Internal input state pointer
@@ -47,9 +75,62 @@ void input_update(f64 delta_time) {
     // Copy current states to previous states.
     kcopy_memory(&state_ptr->keyboard_previous, &state_ptr->keyboard_current, sizeof(keyboard_state));
     kcopy_memory(&state_ptr->mouse_previous, &state_ptr->mouse_current, sizeof(mouse_state));
+    state_ptr->mouse_raw_delta_x = 0;
+    state_ptr->mouse_raw_delta_y = 0;
 }
 
-void input_process_key(keys key, b8 pressed) {
+static b8 input_event_is_motion(input_event_type type) {
+    return type == INPUT_EVENT_TYPE_MOUSE_MOVE || type == INPUT_EVENT_TYPE_MOUSE_RAW_MOVE || type == INPUT_EVENT_TYPE_MOUSE_WHEEL;
+}
+
+// Adds an event to the queue. Motion is merged into the same kind of motion queued since the last
+// key or button event, as the kinds of motion are independent of each other (platforms interleave
+// pointer and raw motion). Keys and buttons are never merged, so their order relative to motion is kept.
+static void input_queue(input_event_type type, u16 code, b8 pressed, i32 x, i32 y) {
+    if (!state_ptr) {
+        return;
+    }
+    f64 now = platform_get_absolute_time();
+
+    // While dispatching, queued events may already have been handled, so nothing is merged.
+    if (input_event_is_motion(type) && !state_ptr->dispatching) {
+        for (u32 i = state_ptr->queue_count; i > 0; --i) {
+            input_event* queued = &state_ptr->queue[i - 1];
+            if (!input_event_is_motion(queued->type)) {
+                break;
+            }
+            if (queued->type != type) {
+                continue;
+            }
+            if (type == INPUT_EVENT_TYPE_MOUSE_MOVE) {
+                queued->x = x;
+                queued->y = y;
+            } else {
+                queued->x += x;
+                queued->y += y;
+            }
+            queued->timestamp = now;
+            return;
+        }
+    }
+
+    if (state_ptr->queue_count == INPUT_EVENT_QUEUE_CAPACITY) {
+        if (state_ptr->dispatching) {
+            KWARN("Input event queue is full; event dropped.");
+            return;
+        }
+        input_dispatch_events();
+    }
+    input_event* event = &state_ptr->queue[state_ptr->queue_count++];
+    event->timestamp = now;
+    event->x = x;
+    event->y = y;
+    event->code = code;
+    event->type = (u8)type;
+    event->pressed = pressed;
+}
+
+static void input_apply_key(keys key, b8 pressed) {
     // Only handle this if the state actually changed.
     if (state_ptr && state_ptr->keyboard_current.keys[key] != pressed) {
         // Update internal state_ptr->
@@ -80,7 +161,7 @@ void input_process_key(keys key, b8 pressed) {
     }
 }
 
-void input_process_button(buttons button, b8 pressed) {
+static void input_apply_button(buttons button, b8 pressed) {
     // If the state changed, fire an event.
     if (state_ptr->mouse_current.buttons[button] != pressed) {
         state_ptr->mouse_current.buttons[button] = pressed;
@@ -92,7 +173,7 @@ void input_process_button(buttons button, b8 pressed) {
     }
 }
 
-void input_process_mouse_move(i16 x, i16 y) {
+static void input_apply_mouse_move(i16 x, i16 y) {
     // Only process if actually different
     if (state_ptr->mouse_current.x != x || state_ptr->mouse_current.y != y) {
         // NOTE: Enable this if debugging.
@@ -102,15 +183,15 @@ void input_process_mouse_move(i16 x, i16 y) {
         state_ptr->mouse_current.x = x;
         state_ptr->mouse_current.y = y;
 
-        // Fire the event.
+        // Post the event, so that a flood of moves within a frame is handled once.
         event_context context;
         context.data.i16[0] = x;
         context.data.i16[1] = y;
-        event_fire(EVENT_CODE_MOUSE_MOVED, 0, context);
+        event_post(EVENT_CODE_MOUSE_MOVED, 0, context);
     }
 }
 
-void input_process_mouse_wheel(i8 z_delta) {
+static void input_apply_mouse_wheel(i8 z_delta) {
     // NOTE: no internal state to update.
 
     // Fire the event.
@@ -119,6 +200,138 @@ void input_process_mouse_wheel(i8 z_delta) {
     event_fire(EVENT_CODE_MOUSE_WHEEL, 0, context);
 }
 
+void input_process_key(keys key, b8 pressed) {
+    input_queue(INPUT_EVENT_TYPE_KEY, (u16)key, pressed, 0, 0);
+}
+
+void input_process_button(buttons button, b8 pressed) {
+    input_queue(INPUT_EVENT_TYPE_BUTTON, (u16)button, pressed, 0, 0);
+}
+
+void input_process_mouse_move(i16 x, i16 y) {
+    input_queue(INPUT_EVENT_TYPE_MOUSE_MOVE, 0, false, x, y);
+}
+
+void input_process_mouse_raw_move(i32 x_delta, i32 y_delta) {
+    input_queue(INPUT_EVENT_TYPE_MOUSE_RAW_MOVE, 0, false, x_delta, y_delta);
+}
+
+void input_process_mouse_wheel(i8 z_delta) {
+    input_queue(INPUT_EVENT_TYPE_MOUSE_WHEEL, 0, false, z_delta, 0);
+}
+
+void input_dispatch_events() {
+    if (!state_ptr) {
+        return;
+    }
+
+    // Handlers may queue more events (e.g. synthesized keys), so the count is read each time.
+    state_ptr->dispatching = true;
+    for (u32 i = 0; i < state_ptr->queue_count; ++i) {
+        input_event event = state_ptr->queue[i];
+        state_ptr->event_time = event.timestamp;
+        if (state_ptr->frame_event_count < INPUT_SNAPSHOT_EVENT_CAPACITY) {
+            state_ptr->frame_events[state_ptr->frame_event_count++] = event;
+        } else {
+            state_ptr->frame_dropped_event_count++;
+        }
+        switch (event.type) {
+            case INPUT_EVENT_TYPE_KEY:
+                input_apply_key((keys)event.code, event.pressed);
+                break;
+            case INPUT_EVENT_TYPE_BUTTON:
+                input_apply_button((buttons)event.code, event.pressed);
+                break;
+            case INPUT_EVENT_TYPE_MOUSE_MOVE:
+                input_apply_mouse_move((i16)event.x, (i16)event.y);
+                break;
+            case INPUT_EVENT_TYPE_MOUSE_RAW_MOVE:
+                state_ptr->mouse_raw_delta_x += event.x;
+                state_ptr->mouse_raw_delta_y += event.y;
+                break;
+            case INPUT_EVENT_TYPE_MOUSE_WHEEL:
+                state_ptr->frame_wheel_delta += event.x;
+                // Merged scrolls may exceed what the event carries.
+                input_apply_mouse_wheel((i8)KCLAMP(event.x, -128, 127));
+                break;
+        }
+    }
+    state_ptr->queue_count = 0;
+    state_ptr->dispatching = false;
+}
+
+f64 input_event_time() {
+    return state_ptr ? state_ptr->event_time : 0;
+}
+
+void input_snapshot_take() {
+    if (!state_ptr) {
+        return;
+    }
+
+    // Written to the snapshot before the latest, which readers have had a frame to be done with.
+    u64 count = state_ptr->snapshot_count;
+    input_snapshot* snapshot = &state_ptr->snapshots[count & 1];
+    snapshot->frame = count;
+    snapshot->timestamp = platform_get_absolute_time();
+    kcopy_memory(snapshot->keys, state_ptr->keyboard_current.keys, sizeof(snapshot->keys));
+    kcopy_memory(snapshot->previous_keys, state_ptr->keyboard_previous.keys, sizeof(snapshot->previous_keys));
+    kcopy_memory(snapshot->buttons, state_ptr->mouse_current.buttons, sizeof(snapshot->buttons));
+    kcopy_memory(snapshot->previous_buttons, state_ptr->mouse_previous.buttons, sizeof(snapshot->previous_buttons));
+    snapshot->mouse_x = state_ptr->mouse_current.x;
+    snapshot->mouse_y = state_ptr->mouse_current.y;
+    snapshot->previous_mouse_x = state_ptr->mouse_previous.x;
+    snapshot->previous_mouse_y = state_ptr->mouse_previous.y;
+    snapshot->mouse_raw_delta_x = state_ptr->mouse_raw_delta_x;
+    snapshot->mouse_raw_delta_y = state_ptr->mouse_raw_delta_y;
+    snapshot->mouse_wheel_delta = state_ptr->frame_wheel_delta;
+    snapshot->event_count = state_ptr->frame_event_count;
+    snapshot->dropped_event_count = state_ptr->frame_dropped_event_count;
+    kcopy_memory(snapshot->events, state_ptr->frame_events, sizeof(input_event) * state_ptr->frame_event_count);
+
+    state_ptr->frame_event_count = 0;
+    state_ptr->frame_dropped_event_count = 0;
+    state_ptr->frame_wheel_delta = 0;
+
+    // Published only once complete.
+    katomic_store_release(&state_ptr->snapshot_count, count + 1);
+}
+
+const input_snapshot* input_snapshot_get() {
+    if (!state_ptr) {
+        return 0;
+    }
+    u64 count = katomic_load_acquire(&state_ptr->snapshot_count);
+    // Before the first snapshot, an empty one.
+    return &state_ptr->snapshots[(count ? count - 1 : 0) & 1];
+}
+
+b8 input_snapshot_is_key_down(const input_snapshot* snapshot, keys key) {
+    return snapshot && snapshot->keys[key];
+}
+
+b8 input_snapshot_was_key_down(const input_snapshot* snapshot, keys key) {
+    return snapshot && snapshot->previous_keys[key];
+}
+
+b8 input_snapshot_is_button_down(const input_snapshot* snapshot, buttons button) {
+    return snapshot && snapshot->buttons[button];
+}
+
+b8 input_snapshot_was_button_down(const input_snapshot* snapshot, buttons button) {
+    return snapshot && snapshot->previous_buttons[button];
+}
+
+void input_get_mouse_raw_delta(i32* x, i32* y) {
+    if (!state_ptr) {
+        *x = 0;
+        *y = 0;
+        return;
+    }
+    *x = state_ptr->mouse_raw_delta_x;
+    *y = state_ptr->mouse_raw_delta_y;
+}
+
 b8 input_is_key_down(keys key) {
     if (!state_ptr) {
         return false;
@@ -305,6 +305,64 @@ typedef enum keys {
     KEYS_MAX_KEYS
 } keys;
 
+/** @brief The types of input event received from the platform. */
+typedef enum input_event_type {
+    INPUT_EVENT_TYPE_KEY,
+    INPUT_EVENT_TYPE_BUTTON,
+    INPUT_EVENT_TYPE_MOUSE_MOVE,
+    INPUT_EVENT_TYPE_MOUSE_RAW_MOVE,
+    INPUT_EVENT_TYPE_MOUSE_WHEEL
+} input_event_type;
+
+/** @brief A platform input event. Runs of motion are merged into one event before dispatch. */
+typedef struct input_event {
+    /** @brief The time the event was received, as platform_get_absolute_time. */
+    f64 timestamp;
+    /** @brief For the mouse, the position or deltas; for the wheel, the delta in x. */
+    i32 x;
+    i32 y;
+    /** @brief The key or button. */
+    u16 code;
+    /** @brief The input_event_type. */
+    u8 type;
+    b8 pressed;
+} input_event;
+
+/** @brief The most events a snapshot holds. Any more dispatched in a frame are only counted. */
+#define INPUT_SNAPSHOT_EVENT_CAPACITY 256
+
+/**
+ * @brief The input state as of a frame, along with the events dispatched during it. Never changed
+ * once published, so it may be read from any thread without a lock.
+ */
+typedef struct input_snapshot {
+    /** @brief The number of snapshots taken before this one. */
+    u64 frame;
+    /** @brief The time the snapshot was taken, as platform_get_absolute_time. */
+    f64 timestamp;
+    /** @brief The keys down as of this frame and the last. */
+    b8 keys[256];
+    b8 previous_keys[256];
+    /** @brief The mouse buttons down as of this frame and the last. */
+    b8 buttons[BUTTON_MAX_BUTTONS];
+    b8 previous_buttons[BUTTON_MAX_BUTTONS];
+    /** @brief The mouse position as of this frame and the last. */
+    i16 mouse_x;
+    i16 mouse_y;
+    i16 previous_mouse_x;
+    i16 previous_mouse_y;
+    /** @brief The raw mouse motion of this frame. */
+    i32 mouse_raw_delta_x;
+    i32 mouse_raw_delta_y;
+    /** @brief The wheel motion of this frame. */
+    i32 mouse_wheel_delta;
+    /** @brief The number of events held, and of those dispatched this frame which did not fit. */
+    u32 event_count;
+    u32 dropped_event_count;
+    /** @brief The events dispatched since the last snapshot, in order, with the time each was received. */
+    input_event events[INPUT_SNAPSHOT_EVENT_CAPACITY];
+} input_snapshot;
+
 /**
  * @brief Initializes the input system. Call twice; once to obtain memory requirement (passing
  * state = 0), then a second time passing allocated memory to state.
@@ -312,19 +370,81 @@ typedef enum keys {
  * @param memory_requirement The required size of the state memory.
  * @param state Either 0 or the allocated block of state memory.
  */
-void input_system_initialize(u64* memory_requirement, void* state);
+KAPI void input_system_initialize(u64* memory_requirement, void* state);
 
 /**
  * @brief Shuts the input system down.
  * @param state A pointer to the system state.
  */
-void input_system_shutdown(void* state);
+KAPI void input_system_shutdown(void* state);
 
 /**
  * @brief Updates the input system every frame.
  * @param delta_time The delta time in seconds since the last frame.
  */
-void input_update(f64 delta_time);
+KAPI void input_update(f64 delta_time);
+
+/**
+ * @brief Applies the input events received from the platform since the last call, in the
+ * order they arrived, firing their events. The platform's input_process_ calls only queue
+ * events, merging runs of motion, so a frame's input is handled in one pass no matter how
+ * fast the devices report. Should be called once per frame, after pumping platform messages.
+ */
+KAPI void input_dispatch_events();
+
+/**
+ * @brief Gets the time the input event being dispatched was received from the platform, as
+ * platform_get_absolute_time. Meaningful within input event handlers.
+ * @returns The time of the current event, in seconds.
+ */
+KAPI f64 input_event_time();
+
+/**
+ * @brief Publishes a snapshot of the input state and of the events dispatched since the last one.
+ * Should be called once per frame from the main thread, after input_dispatch_events. Snapshots are
+ * double-buffered, so each stays as it is until the next but one is taken.
+ */
+KAPI void input_snapshot_take();
+
+/**
+ * @brief Obtains the latest input snapshot. Thread-safe, and lock-free. Jobs should obtain it once
+ * and read only that, so everything they see is of the same frame. It must not be held on to for
+ * longer than a frame.
+ * @returns A pointer to the snapshot, or 0 if the input system is not running.
+ */
+KAPI const input_snapshot* input_snapshot_get();
+
+/**
+ * @brief Indicates if the given key was down as of the given snapshot.
+ * @param snapshot A constant pointer to the snapshot.
+ * @param key The key to be checked.
+ * @returns True if pressed; otherwise false.
+ */
+KAPI b8 input_snapshot_is_key_down(const input_snapshot* snapshot, keys key);
+
+/**
+ * @brief Indicates if the given key was down as of the frame before the given snapshot.
+ * @param snapshot A constant pointer to the snapshot.
+ * @param key The key to be checked.
+ * @returns True if pressed; otherwise false.
+ */
+KAPI b8 input_snapshot_was_key_down(const input_snapshot* snapshot, keys key);
+
+/**
+ * @brief Indicates if the given mouse button was down as of the given snapshot.
+ * @param snapshot A constant pointer to the snapshot.
+ * @param button The button to be checked.
+ * @returns True if pressed; otherwise false.
+ */
+KAPI b8 input_snapshot_is_button_down(const input_snapshot* snapshot, buttons button);
+
+/**
+ * @brief Indicates if the given mouse button was down as of the frame before the given snapshot.
+ * @param snapshot A constant pointer to the snapshot.
+ * @param button The button to be checked.
+ * @returns True if pressed; otherwise false.
+ */
+KAPI b8 input_snapshot_was_button_down(const input_snapshot* snapshot, buttons button);
 
 // keyboard input
 
@@ -357,11 +477,11 @@ KAPI b8 input_was_key_down(keys key);
 KAPI b8 input_was_key_up(keys key);
 
 /**
- * @brief Sets the state for the given key.
+ * @brief Queues a change in state for the given key, applied by input_dispatch_events.
  * @param key The key to be processed.
  * @param pressed Indicates whether the key is currently pressed.
  */
-void input_process_key(keys key, b8 pressed);
+KAPI void input_process_key(keys key, b8 pressed);
 
 // mouse input
 
@@ -408,23 +528,38 @@ KAPI void input_get_mouse_position(i32* x, i32* y);
 KAPI void input_get_previous_mouse_position(i32* x, i32* y);
 
 /**
- * @brief Sets the press state of the given mouse button.
+ * @brief Gets the raw mouse motion this frame, before any pointer acceleration and
+ * unaffected by the window's edges. Always 0 where the platform does not report raw motion.
+ * @param x A pointer to hold the motion in x, in device units.
+ * @param y A pointer to hold the motion in y, in device units.
+ */
+KAPI void input_get_mouse_raw_delta(i32* x, i32* y);
+
+/**
+ * @brief Queues a change in press state of the given mouse button, applied by input_dispatch_events.
  * @param button The mouse button whose state to set.
  * @param pressed Indicates if the mouse button is currently pressed.
  */
-void input_process_button(buttons button, b8 pressed);
+KAPI void input_process_button(buttons button, b8 pressed);
+
+/**
+ * @brief Queues a move of the mouse to the given x and y positions, applied by
+ * input_dispatch_events. Consecutive moves are merged into the last.
+ */
+KAPI void input_process_mouse_move(i16 x, i16 y);
 
 /**
- * @brief Sets the current position of the mouse to the given x and y positions.
- * Also updates the previous position beforehand.
+ * @brief Queues raw mouse motion, applied by input_dispatch_events. Consecutive motion is summed.
+ * @param x_delta The motion in x, in device units.
+ * @param y_delta The motion in y, in device units.
  */
-void input_process_mouse_move(i16 x, i16 y);
+KAPI void input_process_mouse_raw_move(i32 x_delta, i32 y_delta);
 
 /**
- * @brief Processes mouse wheel scrolling.
+ * @brief Queues mouse wheel scrolling, applied by input_dispatch_events. Consecutive scrolling is summed.
  * @param z_delta The amount of scrolling which occurred on the z axis (mouse wheel)
  */
-void input_process_mouse_wheel(i8 z_delta);
+KAPI void input_process_mouse_wheel(i8 z_delta);
 
 /**
  * @brief Returns a string representation of the provided key. Ex. "tab" for the tab key.
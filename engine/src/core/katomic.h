@@ -0,0 +1,60 @@
+/**
+ * @file katomic.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Thin wrappers around compiler atomic intrinsics, used to build
+ * lock-free structures that are shared between threads. All supported
+ * platforms are built with clang, so the __atomic builtins are used directly.
+ * Unless noted otherwise, operations are sequentially consistent.
+ * @version 1.0
+ *
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief Atomically loads the value at ptr. */
+#define katomic_load(ptr) __atomic_load_n(ptr, __ATOMIC_SEQ_CST)
+
+/** @brief Atomically loads the value at ptr with acquire semantics. */
+#define katomic_load_acquire(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+
+/** @brief Atomically loads the value at ptr without ordering guarantees. */
+#define katomic_load_relaxed(ptr) __atomic_load_n(ptr, __ATOMIC_RELAXED)
+
+/** @brief Atomically stores value to ptr. */
+#define katomic_store(ptr, value) __atomic_store_n(ptr, value, __ATOMIC_SEQ_CST)
+
+/** @brief Atomically stores value to ptr with release semantics. */
+#define katomic_store_release(ptr, value) __atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+
+/** @brief Atomically stores value to ptr without ordering guarantees. */
+#define katomic_store_relaxed(ptr, value) __atomic_store_n(ptr, value, __ATOMIC_RELAXED)
+
+/** @brief Atomically adds value to the value at ptr, returning the previous value. */
+#define katomic_fetch_add(ptr, value) __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST)
+
+/** @brief Atomically adds value to the value at ptr without ordering guarantees, returning the previous value. */
+#define katomic_fetch_add_relaxed(ptr, value) __atomic_fetch_add(ptr, value, __ATOMIC_RELAXED)
+
+/** @brief Atomically subtracts value from the value at ptr, returning the previous value. */
+#define katomic_fetch_sub(ptr, value) __atomic_fetch_sub(ptr, value, __ATOMIC_SEQ_CST)
+
+/** @brief Atomically replaces the value at ptr with value, returning the previous value. */
+#define katomic_exchange(ptr, value) __atomic_exchange_n(ptr, value, __ATOMIC_SEQ_CST)
+
+/**
+ * @brief Atomically replaces the value at ptr with desired if it currently equals
+ * the value pointed to by expected_ptr. On failure, the current value is written to
+ * expected_ptr. Evaluates to true on success; otherwise false.
+ */
+#define katomic_compare_exchange(ptr, expected_ptr, desired) __atomic_compare_exchange_n(ptr, expected_ptr, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
+
+/** @brief A full memory fence. */
+#define katomic_thread_fence() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+/** @brief A release memory fence. */
+#define katomic_thread_fence_release() __atomic_thread_fence(__ATOMIC_RELEASE)
@@ -0,0 +1,186 @@
+#include "kcompress.h"
+
+#include "core/kmemory.h"
+
+// The shortest match which can be encoded.
+#define LZ4_MIN_MATCH 4
+// The furthest back a match can be.
+#define LZ4_MAX_OFFSET 65535
+// The format requires the last 5 bytes to be literals, and the last match to start at least 12 bytes from the end.
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MATCH_START_LIMIT 12
+// The number of bits in the position table used to find matches.
+#define LZ4_HASH_BITS 12
+
+static u32 read_u32(const u8* p) {
+    u32 value;
+    kcopy_memory(&value, p, sizeof(u32));
+    return value;
+}
+
+// Writes the part of a length which does not fit in its 4 bits of the token, or returns 0 if it does not fit.
+static u8* write_length(u8* out, u8* out_end, u64 length) {
+    while (length >= 255) {
+        if (out >= out_end) {
+            return 0;
+        }
+        *out++ = 255;
+        length -= 255;
+    }
+    if (out >= out_end) {
+        return 0;
+    }
+    *out++ = (u8)length;
+    return out;
+}
+
+// Writes a sequence of literals, followed by a match unless match_length is 0, or returns 0 if it does not fit.
+static u8* write_sequence(u8* out, u8* out_end, const u8* literals, u64 literal_count, u64 offset, u64 match_length) {
+    if (out >= out_end) {
+        return 0;
+    }
+    u8* token = out++;
+    *token = (u8)(KMIN(literal_count, 15) << 4);
+    if (literal_count >= 15 && !(out = write_length(out, out_end, literal_count - 15))) {
+        return 0;
+    }
+    if ((u64)(out_end - out) < literal_count) {
+        return 0;
+    }
+    kcopy_memory(out, literals, literal_count);
+    out += literal_count;
+    if (match_length == 0) {
+        return out;
+    }
+
+    if (out_end - out < 2) {
+        return 0;
+    }
+    *out++ = (u8)offset;
+    *out++ = (u8)(offset >> 8);
+    u64 extra = match_length - LZ4_MIN_MATCH;
+    *token |= (u8)KMIN(extra, 15);
+    if (extra >= 15 && !(out = write_length(out, out_end, extra - 15))) {
+        return 0;
+    }
+    return out;
+}
+
+u64 kcompress_lz4_bound(u64 size) {
+    return size + size / 255 + 16;
+}
+
+u64 kcompress_lz4(const void* source, u64 size, void* destination, u64 capacity) {
+    if (size > 0xFFFFFFFFull) {
+        return 0;
+    }
+    const u8* base = source;
+    const u8* in = base;
+    const u8* end = base + size;
+    const u8* anchor = base;
+    u8* out = destination;
+    u8* out_end = out + capacity;
+
+    if (size > LZ4_MATCH_START_LIMIT) {
+        const u8* match_start_limit = end - LZ4_MATCH_START_LIMIT;
+        const u8* match_end_limit = end - LZ4_LAST_LITERALS;
+        // The last position (plus one, so that 0 is empty) each hash of 4 bytes was seen at.
+        u32 positions[1 << LZ4_HASH_BITS];
+        kzero_memory(positions, sizeof(positions));
+
+        while (in < match_start_limit) {
+            u32 sequence = read_u32(in);
+            u32 hash = (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+            u32 candidate = positions[hash];
+            positions[hash] = (u32)(in - base) + 1;
+            if (candidate) {
+                const u8* match = base + candidate - 1;
+                if (in - match <= LZ4_MAX_OFFSET && read_u32(match) == sequence) {
+                    const u8* match_end = in + LZ4_MIN_MATCH;
+                    const u8* from = match + LZ4_MIN_MATCH;
+                    while (match_end < match_end_limit && *match_end == *from) {
+                        match_end++;
+                        from++;
+                    }
+                    out = write_sequence(out, out_end, anchor, (u64)(in - anchor), (u64)(in - match), (u64)(match_end - in));
+                    if (!out) {
+                        return 0;
+                    }
+                    in = match_end;
+                    anchor = in;
+                    continue;
+                }
+            }
+            in++;
+        }
+    }
+
+    // Everything left is literals.
+    out = write_sequence(out, out_end, anchor, (u64)(end - anchor), 0, 0);
+    if (!out) {
+        return 0;
+    }
+    return (u64)(out - (u8*)destination);
+}
+
+// Reads the part of a length which did not fit in its 4 bits of the token, or returns false if the input ends first.
+static b8 read_length(const u8** in, const u8* end, u64* length) {
+    u8 byte;
+    do {
+        if (*in >= end) {
+            return false;
+        }
+        byte = *(*in)++;
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+b8 kdecompress_lz4(const void* source, u64 source_size, void* destination, u64 size) {
+    const u8* in = source;
+    const u8* end = in + source_size;
+    u8* out = destination;
+    u8* out_end = out + size;
+
+    while (in < end) {
+        u8 token = *in++;
+        u64 literal_count = token >> 4;
+        if (literal_count == 15 && !read_length(&in, end, &literal_count)) {
+            return false;
+        }
+        if (literal_count > (u64)(end - in) || literal_count > (u64)(out_end - out)) {
+            return false;
+        }
+        kcopy_memory(out, in, literal_count);
+        in += literal_count;
+        out += literal_count;
+        if (in == end) {
+            // The last sequence has no match.
+            break;
+        }
+
+        if (end - in < 2) {
+            return false;
+        }
+        u64 offset = (u64)in[0] | ((u64)in[1] << 8);
+        in += 2;
+        if (offset == 0 || offset > (u64)(out - (u8*)destination)) {
+            return false;
+        }
+        u64 match_length = token & 15;
+        if (match_length == 15 && !read_length(&in, end, &match_length)) {
+            return false;
+        }
+        match_length += LZ4_MIN_MATCH;
+        if (match_length > (u64)(out_end - out)) {
+            return false;
+        }
+        // Byte by byte, as the match may overlap what it is copied to, repeating it.
+        const u8* match = out - offset;
+        for (u64 i = 0; i < match_length; ++i) {
+            out[i] = match[i];
+        }
+        out += match_length;
+    }
+    return out == out_end;
+}
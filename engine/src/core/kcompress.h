@@ -0,0 +1,49 @@
+/**
+ * @file kcompress.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Contains lossless compression of blocks of memory, in the LZ4 block format.
+ * @details Decompression is fast enough to be cheaper than reading the bytes saved
+ * from most storage. Compression is a simple greedy matcher, meant for offline tools
+ * such as packing asset archives; its output can be decompressed by any LZ4 decoder.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief Gets the most bytes kcompress_lz4 can write when compressing size bytes,
+ * which is a little more than size for data which does not compress.
+ *
+ * @param size The number of bytes to be compressed.
+ * @return The size the compressed buffer must be to be sure of holding the result.
+ */
+KAPI u64 kcompress_lz4_bound(u64 size);
+
+/**
+ * @brief Compresses size bytes of source into destination.
+ *
+ * @param source The bytes to be compressed. Must be under 4 GiB.
+ * @param size The number of bytes to be compressed.
+ * @param destination The memory to write the compressed bytes to.
+ * @param capacity The size of destination in bytes. Compression always succeeds if it is at least kcompress_lz4_bound(size).
+ * @return The number of bytes written to destination; 0 if it did not fit or source was too large.
+ */
+KAPI u64 kcompress_lz4(const void* source, u64 size, void* destination, u64 capacity);
+
+/**
+ * @brief Decompresses source, which must decompress to exactly size bytes, into destination.
+ * Corrupt or truncated input is detected, and never read or written outside of the buffers.
+ *
+ * @param source The compressed bytes.
+ * @param source_size The number of compressed bytes.
+ * @param destination The memory to write the decompressed bytes to.
+ * @param size The size of the decompressed bytes, and of destination.
+ * @return True if source decompressed to exactly size bytes; otherwise false.
+ */
+KAPI b8 kdecompress_lz4(const void* source, u64 source_size, void* destination, u64 size);
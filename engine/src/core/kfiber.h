@@ -0,0 +1,48 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * Represents a fiber, a lightweight execution context with its own stack which
+ * is scheduled cooperatively. Switching to a fiber suspends whatever the calling
+ * thread was doing and resumes the fiber where it left off. Used by the job system
+ * to let jobs yield while they wait, without blocking the job thread.
+ * This calls to the platform-specific fiber implementation.
+ */
+typedef struct kfiber {
+    void *internal_data;
+} kfiber;
+
+// A function pointer to be invoked when the fiber is first switched to. Must never return.
+typedef void (*pfn_fiber_start)(void *);
+
+/**
+ * Creates a new fiber, which starts running start_function_ptr the first time it is switched to.
+ * @param start_function_ptr The pointer to the function to be invoked when the fiber starts. Required. Must never return.
+ * @param params A pointer to any data to be passed to the start_function_ptr. Optional. Pass 0/NULL if not used.
+ * @param stack_size The size of the fiber's stack in bytes.
+ * @param out_fiber A pointer to hold the created fiber.
+ * @returns true if successfully created; otherwise false.
+ */
+b8 kfiber_create(pfn_fiber_start start_function_ptr, void *params, u64 stack_size, kfiber *out_fiber);
+
+/**
+ * Creates a fiber representing the calling thread, so that it can switch to other fibers
+ * and be switched back to. Must be called on a thread before it switches to any fiber.
+ * @param out_fiber A pointer to hold the created fiber.
+ * @returns true if successfully created; otherwise false.
+ */
+b8 kfiber_create_from_thread(kfiber *out_fiber);
+
+/**
+ * Destroys the given fiber. Must not be called for the fiber currently running. A fiber
+ * created from a thread must be destroyed on that thread, which then stops being a fiber.
+ */
+void kfiber_destroy(kfiber *fiber);
+
+/**
+ * Suspends the currently running fiber, and switches to the given one.
+ * @param current The fiber currently running on the calling thread.
+ * @param target The fiber to be switched to.
+ */
+void kfiber_switch(kfiber *current, kfiber *target);
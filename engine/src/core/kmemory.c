@@ -3,6 +3,9 @@
 #include "core/logger.h"
 #include "core/kstring.h"
 #include "core/kmutex.h"
+#include "core/katomic.h"
+#include "core/asserts.h"
+#include "core/counters.h"
 #include "platform/platform.h"
 #include "memory/dynamic_allocator.h"
 
@@ -12,7 +15,16 @@
 
 struct memory_stats {
     u64 total_allocated;
+    u64 peak_total_allocated;
     u64 tagged_allocations[MEMORY_TAG_MAX_TAGS];
+    u64 tagged_peaks[MEMORY_TAG_MAX_TAGS];
+    // The number of allocations made, and the bytes they totalled, since initialization.
+    u64 tagged_allocation_counts[MEMORY_TAG_MAX_TAGS];
+    u64 tagged_allocation_totals[MEMORY_TAG_MAX_TAGS];
+    u64 tagged_live_counts[MEMORY_TAG_MAX_TAGS];
+    // The number of frees made since initialization.
+    u64 free_count;
+    u64 tagged_free_counts[MEMORY_TAG_MAX_TAGS];
 };
 
 static const char* memory_tag_strings[MEMORY_TAG_MAX_TAGS] = {
@@ -43,8 +55,47 @@ static const char* memory_tag_strings[MEMORY_TAG_MAX_TAGS] = {
     "BITMAP_FONT",
     "SYSTEM_FONT"};
 
+// The number of size classes held by the per-thread caches.
+#define MEMORY_CACHE_CLASS_COUNT 6
+// The size of the smallest size class in bytes. Each class is double the size of the one before it.
+#define MEMORY_CACHE_MIN_CLASS_SIZE 16
+// The size of the largest size class in bytes.
+#define MEMORY_CACHE_MAX_CLASS_SIZE (MEMORY_CACHE_MIN_CLASS_SIZE << (MEMORY_CACHE_CLASS_COUNT - 1))
+// The alignment of cached blocks. Also the largest alignment the caches can serve.
+#define MEMORY_CACHE_ALIGNMENT 16
+// The number of blocks taken from the global allocator at once when a cache bin is empty.
+#define MEMORY_CACHE_REFILL_COUNT 16
+// The max number of blocks a cache bin holds. Beyond this, half are given back to the global allocator.
+#define MEMORY_CACHE_MAX_BIN_COUNT 64
+
+// The number of counters published: allocations, frees, bytes allocated and no-alloc violations,
+// then allocations and frees per tag.
+#define MEMORY_COUNTER_COUNT (4 + MEMORY_TAG_MAX_TAGS * 2)
+// The number of distinct stacks which allocated inside a no-alloc region that are reported. Any beyond are only counted.
+#define MEMORY_NO_ALLOC_MAX_STACKS 64
+
+#ifdef KMEMORY_TRACK_CALL_SITES
+// The number of call site records to start with. Doubles whenever it becomes half full.
+#define MEMORY_CALL_SITE_INITIAL_CAPACITY 4096
+// The max number of leaks listed individually at shutdown.
+#define MEMORY_CALL_SITE_MAX_REPORTED_LEAKS 64
+
+/** The call site of a single live allocation. */
+typedef struct memory_call_site {
+    // 0 if the record is unused.
+    void* block;
+    const char* file;
+    u32 line;
+    memory_tag tag;
+    u64 size;
+} memory_call_site;
+#endif
+
 typedef struct memory_system_state {
     memory_system_configuration config;
+    // The pages backing the state and the heap.
+    platform_page_block pages;
+    // NOTE: Stats and the alloc count are updated atomically, so they do not require the allocation mutex.
     struct memory_stats stats;
     u64 alloc_count;
     u64 allocator_memory_requirement;
@@ -52,33 +103,375 @@ typedef struct memory_system_state {
     void* allocator_block;
     // A mutex for allocations/frees
     kmutex allocation_mutex;
+    // The number of allocations made inside no-alloc regions, on any thread.
+    u64 no_alloc_violation_count;
+    // Hashes of the stacks reported for allocating inside a no-alloc region, so each is only reported
+    // once. Filled in without a lock; 0 marks an unused slot.
+    u64 no_alloc_stacks[MEMORY_NO_ALLOC_MAX_STACKS];
+    u32 counter_ids[MEMORY_COUNTER_COUNT];
+#ifdef KMEMORY_TRACK_CALL_SITES
+    // Hash table of live allocations keyed by block address, using linear probing. Held in
+    // platform memory, so that tracking does not itself allocate through this system.
+    memory_call_site* call_sites;
+    u64 call_site_capacity;
+    u64 call_site_count;
+    kmutex call_site_mutex;
+#endif
 } memory_system_state;
 
+/**
+ * A list of free blocks of a single size class. The pointer to the next
+ * block is stored in the first bytes of each block.
+ */
+typedef struct memory_cache_bin {
+    void* head;
+    u32 count;
+} memory_cache_bin;
+
+/**
+ * A per-thread cache of small blocks, so that most small allocations and frees do not
+ * need to take the allocation mutex. Bins are refilled from, and emptied into, the
+ * global allocator several blocks at a time.
+ */
+typedef struct memory_thread_cache {
+    // The memory system the cached blocks belong to.
+    struct memory_system_state* owner;
+    memory_cache_bin bins[MEMORY_CACHE_CLASS_COUNT];
+} memory_thread_cache;
+
 // Pointer to system state.
 static memory_system_state* state_ptr;
 
+// The cache for the calling thread.
+static _Thread_local memory_thread_cache thread_cache;
+
+// How deeply the calling thread is nested in no-alloc regions, and the name of the outermost one.
+static _Thread_local u32 no_alloc_depth;
+static _Thread_local const char* no_alloc_region;
+
+/**
+ * Obtains the index of the size class for the given size.
+ * @returns The size class index, or -1 if the size is too large to be cached.
+ */
+static i32 cache_class_index(u64 size) {
+    if (size == 0 || size > MEMORY_CACHE_MAX_CLASS_SIZE) {
+        return -1;
+    }
+    i32 index = 0;
+    for (u64 class_size = MEMORY_CACHE_MIN_CLASS_SIZE; class_size < size; class_size <<= 1) {
+        index++;
+    }
+    return index;
+}
+
+static memory_thread_cache* get_thread_cache() {
+    if (thread_cache.owner != state_ptr) {
+        // Either first use on this thread, or left over from a memory system which has since shut down.
+        platform_zero_memory(&thread_cache, sizeof(memory_thread_cache));
+        thread_cache.owner = state_ptr;
+    }
+    return &thread_cache;
+}
+
+/**
+ * Gives blocks from the bin back to the global allocator until only keep_count remain.
+ */
+static void cache_bin_trim(memory_cache_bin* bin, u32 keep_count) {
+    if (bin->count <= keep_count) {
+        return;
+    }
+    if (!kmutex_lock(&state_ptr->allocation_mutex)) {
+        KFATAL("Unable to obtain mutex lock for free operation. Heap corruption is likely.");
+        return;
+    }
+    while (bin->count > keep_count) {
+        void* block = bin->head;
+        bin->head = *(void**)block;
+        bin->count--;
+        dynamic_allocator_free_aligned(&state_ptr->allocator, block);
+    }
+    kmutex_unlock(&state_ptr->allocation_mutex);
+}
+
+static void* cache_allocate(i32 class_index) {
+    memory_cache_bin* bin = &get_thread_cache()->bins[class_index];
+    if (!bin->head) {
+        // Refill the bin with several blocks at once, so the mutex is only taken once for them all.
+        u64 class_size = (u64)MEMORY_CACHE_MIN_CLASS_SIZE << class_index;
+        if (!kmutex_lock(&state_ptr->allocation_mutex)) {
+            KFATAL("Error obtaining mutex lock during allocation.");
+            return 0;
+        }
+        for (u32 i = 0; i < MEMORY_CACHE_REFILL_COUNT; ++i) {
+            void* block = dynamic_allocator_allocate_aligned(&state_ptr->allocator, class_size, MEMORY_CACHE_ALIGNMENT);
+            if (!block) {
+                break;
+            }
+            *(void**)block = bin->head;
+            bin->head = block;
+            bin->count++;
+        }
+        kmutex_unlock(&state_ptr->allocation_mutex);
+        if (!bin->head) {
+            return 0;
+        }
+    }
+
+    void* block = bin->head;
+    bin->head = *(void**)block;
+    bin->count--;
+    return block;
+}
+
+static void cache_free(i32 class_index, void* block) {
+    memory_cache_bin* bin = &get_thread_cache()->bins[class_index];
+    *(void**)block = bin->head;
+    bin->head = block;
+    bin->count++;
+    if (bin->count > MEMORY_CACHE_MAX_BIN_COUNT) {
+        cache_bin_trim(bin, MEMORY_CACHE_MAX_BIN_COUNT / 2);
+    }
+}
+
+/**
+ * Determines if the given block was allocated for a size class, and so can be cached.
+ * @returns The size class index of the block, or -1 if it cannot be cached.
+ */
+static i32 cached_block_class_index(void* block) {
+    // Blocks from before the memory system started do not have a header to check.
+    if ((u8*)block < (u8*)state_ptr->allocator_block || (u8*)block >= (u8*)state_ptr->allocator_block + state_ptr->allocator_memory_requirement) {
+        return -1;
+    }
+    u64 block_size;
+    u16 block_alignment;
+    dynamic_allocator_get_size_alignment(block, &block_size, &block_alignment);
+    if (block_alignment != MEMORY_CACHE_ALIGNMENT) {
+        return -1;
+    }
+    i32 class_index = cache_class_index(block_size);
+    if (class_index < 0 || ((u64)MEMORY_CACHE_MIN_CLASS_SIZE << class_index) != block_size) {
+        return -1;
+    }
+    return class_index;
+}
+
+// Raises the given high-water mark to value, if it is higher.
+static void stats_raise_peak(u64* peak, u64 value) {
+    u64 current = katomic_load_relaxed(peak);
+    while (value > current && !katomic_compare_exchange(peak, &current, value)) {
+    }
+}
+
+static void stats_add(u64 size, memory_tag tag) {
+    u64 total = katomic_fetch_add(&state_ptr->stats.total_allocated, size) + size;
+    u64 tagged = katomic_fetch_add(&state_ptr->stats.tagged_allocations[tag], size) + size;
+    stats_raise_peak(&state_ptr->stats.peak_total_allocated, total);
+    stats_raise_peak(&state_ptr->stats.tagged_peaks[tag], tagged);
+    katomic_fetch_add(&state_ptr->stats.tagged_allocation_counts[tag], 1);
+    katomic_fetch_add(&state_ptr->stats.tagged_allocation_totals[tag], size);
+    katomic_fetch_add(&state_ptr->stats.tagged_live_counts[tag], 1);
+    katomic_fetch_add(&state_ptr->alloc_count, 1);
+}
+
+static void stats_subtract(u64 size, memory_tag tag) {
+    katomic_fetch_sub(&state_ptr->stats.total_allocated, size);
+    katomic_fetch_sub(&state_ptr->stats.tagged_allocations[tag], size);
+    katomic_fetch_sub(&state_ptr->stats.tagged_live_counts[tag], 1);
+    katomic_fetch_add(&state_ptr->stats.tagged_free_counts[tag], 1);
+    katomic_fetch_add(&state_ptr->stats.free_count, 1);
+}
+
+/**
+ * Records the given stack as reported for allocating inside a no-alloc region.
+ * @returns True if it had not been reported before, and there was room to record it; otherwise false.
+ */
+static b8 no_alloc_stack_record(u64 hash) {
+    for (u32 i = 0; i < MEMORY_NO_ALLOC_MAX_STACKS; ++i) {
+        u64 expected = 0;
+        if (katomic_compare_exchange(&state_ptr->no_alloc_stacks[i], &expected, hash)) {
+            return true;
+        }
+        if (expected == hash) {
+            return false;
+        }
+    }
+    return false;
+}
+
+static void no_alloc_violation(u64 size, memory_tag tag, const char* file, u32 line) {
+    katomic_fetch_add(&state_ptr->no_alloc_violation_count, 1);
+    memory_no_alloc_action action = state_ptr->config.no_alloc_action;
+    if (action == MEMORY_NO_ALLOC_ACTION_COUNT) {
+        return;
+    }
+
+    // Capture the stack above the allocation function, then hash it along with the call site, so
+    // each offender is reported once rather than every frame.
+    void* frames[PLATFORM_MAX_STACK_FRAMES];
+    u32 frame_count = platform_stack_capture(2, PLATFORM_MAX_STACK_FRAMES, frames);
+    u64 hash = 0xCBF29CE484222325ULL;
+    hash = (hash ^ (u64)file) * 0x100000001B3ULL;
+    hash = (hash ^ ((u64)line << 8 | tag)) * 0x100000001B3ULL;
+    for (u32 i = 0; i < frame_count; ++i) {
+        hash = (hash ^ (u64)frames[i]) * 0x100000001B3ULL;
+    }
+    if (!no_alloc_stack_record(hash ? hash : 1)) {
+        return;
+    }
+
+    // Logging may allocate itself, which must not be reported in turn.
+    u32 depth = no_alloc_depth;
+    no_alloc_depth = 0;
+    if (file) {
+        KWARN("Allocation of %llu bytes [%s] at %s:%u inside the no-alloc region '%s':", size, memory_tag_strings[tag], file, line, no_alloc_region);
+    } else {
+        KWARN("Allocation of %llu bytes [%s] inside the no-alloc region '%s':", size, memory_tag_strings[tag], no_alloc_region);
+    }
+    for (u32 i = 0; i < frame_count; ++i) {
+        char description[256];
+        if (!platform_stack_frame_describe(frames[i], description, sizeof(description))) {
+            string_format(description, "%p", frames[i]);
+        }
+        KWARN("  #%u %s", i, description);
+    }
+    if (action == MEMORY_NO_ALLOC_ACTION_ASSERT) {
+        KASSERT_MSG(false, "Memory was allocated inside a no-alloc region.");
+    }
+    no_alloc_depth = depth;
+}
+
+#ifdef KMEMORY_TRACK_CALL_SITES
+static u64 call_site_home(void* block, u64 capacity) {
+    return (((u64)block >> 4) * 0x9E3779B97F4A7C15ULL) & (capacity - 1);
+}
+
+// Inserts into the table without checking its load. The call site mutex must be held.
+static void call_site_insert(memory_call_site* sites, u64 capacity, const memory_call_site* site) {
+    u64 slot = call_site_home(site->block, capacity);
+    while (sites[slot].block) {
+        slot = (slot + 1) & (capacity - 1);
+    }
+    sites[slot] = *site;
+}
+
+static void call_site_record(void* block, u64 size, memory_tag tag, const char* file, u32 line) {
+    kmutex_lock(&state_ptr->call_site_mutex);
+    if ((state_ptr->call_site_count + 1) * 2 > state_ptr->call_site_capacity) {
+        // Grow the table, rehashing all of the records into it.
+        u64 new_capacity = state_ptr->call_site_capacity ? state_ptr->call_site_capacity * 2 : MEMORY_CALL_SITE_INITIAL_CAPACITY;
+        memory_call_site* new_sites = platform_allocate(sizeof(memory_call_site) * new_capacity, false);
+        platform_zero_memory(new_sites, sizeof(memory_call_site) * new_capacity);
+        for (u64 i = 0; i < state_ptr->call_site_capacity; ++i) {
+            if (state_ptr->call_sites[i].block) {
+                call_site_insert(new_sites, new_capacity, &state_ptr->call_sites[i]);
+            }
+        }
+        if (state_ptr->call_sites) {
+            platform_free(state_ptr->call_sites, false);
+        }
+        state_ptr->call_sites = new_sites;
+        state_ptr->call_site_capacity = new_capacity;
+    }
+
+    memory_call_site site = {block, file, line, tag, size};
+    call_site_insert(state_ptr->call_sites, state_ptr->call_site_capacity, &site);
+    state_ptr->call_site_count++;
+    kmutex_unlock(&state_ptr->call_site_mutex);
+}
+
+// Removes the record of the given block, optionally copying it to out_site first.
+static void call_site_remove(void* block, memory_call_site* out_site) {
+    kmutex_lock(&state_ptr->call_site_mutex);
+    u64 capacity = state_ptr->call_site_capacity;
+    memory_call_site* sites = state_ptr->call_sites;
+    if (capacity) {
+        u64 hole = call_site_home(block, capacity);
+        while (sites[hole].block && sites[hole].block != block) {
+            hole = (hole + 1) & (capacity - 1);
+        }
+        if (sites[hole].block) {
+            if (out_site) {
+                *out_site = sites[hole];
+            }
+            // Shift back any later records of the same probe sequence, so that no tombstones are needed.
+            u64 next = (hole + 1) & (capacity - 1);
+            while (sites[next].block) {
+                u64 home = call_site_home(sites[next].block, capacity);
+                b8 stays = (hole <= next) ? (home > hole && home <= next) : (home > hole || home <= next);
+                if (!stays) {
+                    sites[hole] = sites[next];
+                    hole = next;
+                }
+                next = (next + 1) & (capacity - 1);
+            }
+            sites[hole].block = 0;
+            state_ptr->call_site_count--;
+        }
+    }
+    kmutex_unlock(&state_ptr->call_site_mutex);
+}
+
+static void call_site_report_leaks() {
+    if (state_ptr->call_site_count == 0) {
+        KINFO("Memory system: no leaked allocations.");
+        return;
+    }
+
+    u64 leaked_size = 0;
+    u64 reported = 0;
+    KWARN("Memory system: %llu allocations were not freed:", state_ptr->call_site_count);
+    for (u64 i = 0; i < state_ptr->call_site_capacity; ++i) {
+        memory_call_site* site = &state_ptr->call_sites[i];
+        if (!site->block) {
+            continue;
+        }
+        leaked_size += site->size;
+        if (reported < MEMORY_CALL_SITE_MAX_REPORTED_LEAKS) {
+            KWARN("  [%s] %llu bytes at %s:%u", memory_tag_strings[site->tag], site->size, site->file ? site->file : "<unknown>", site->line);
+            reported++;
+        }
+    }
+    if (reported < state_ptr->call_site_count) {
+        KWARN("  ... and %llu more.", state_ptr->call_site_count - reported);
+    }
+    KWARN("Memory system: %llu bytes leaked in total.", leaked_size);
+}
+#endif
+
 b8 memory_system_initialize(memory_system_configuration config) {
-    // The amount needed by the system state.
-    u64 state_memory_requirement = sizeof(memory_system_state);
+    // The amount needed by the system state, padded so that the heap starts on a cache line.
+    u64 state_memory_requirement = get_aligned(sizeof(memory_system_state), 64);
 
     // Figure out how much space the dynamic allocator needs.
     u64 alloc_requirement = 0;
     dynamic_allocator_create(config.total_alloc_size, &alloc_requirement, 0, 0);
 
-    // Call the platform allocator to get the memory for the whole system, including the state.
-    // TODO: memory alignment
-    void* block = platform_allocate(state_memory_requirement + alloc_requirement, false);
-    if (!block) {
+    // Get the pages for the whole system, including the state, directly from the platform.
+    u32 page_flags = PLATFORM_PAGE_FLAG_NONE;
+    if (config.page_size >= GIBIBYTES(1)) {
+        page_flags |= PLATFORM_PAGE_FLAG_HUGE_1GB;
+    } else if (config.page_size >= MEBIBYTES(2)) {
+        page_flags |= PLATFORM_PAGE_FLAG_HUGE_2MB;
+    }
+    if (config.node_local) {
+        page_flags |= PLATFORM_PAGE_FLAG_NODE_LOCAL;
+    }
+    platform_page_block pages;
+    if (!platform_allocate_pages(state_memory_requirement + alloc_requirement, page_flags, &pages)) {
         KFATAL("Memory system allocation failed and the system cannot continue.");
         return false;
     }
+    void* block = pages.memory;
 
     // The state is in the first part of the massive block of memory.
     state_ptr = (memory_system_state*)block;
     state_ptr->config = config;
+    state_ptr->pages = pages;
     state_ptr->alloc_count = 0;
     state_ptr->allocator_memory_requirement = alloc_requirement;
     platform_zero_memory(&state_ptr->stats, sizeof(state_ptr->stats));
+    state_ptr->no_alloc_violation_count = 0;
+    platform_zero_memory(state_ptr->no_alloc_stacks, sizeof(state_ptr->no_alloc_stacks));
     // The allocator block is in the same block of memory, but after the state.
     state_ptr->allocator_block = ((void*)block + state_memory_requirement);
 
@@ -97,47 +490,115 @@ b8 memory_system_initialize(memory_system_configuration config) {
         return false;
     }
 
-    KDEBUG("Memory system successfully allocated %llu bytes.", config.total_alloc_size);
+#ifdef KMEMORY_TRACK_CALL_SITES
+    state_ptr->call_sites = 0;
+    state_ptr->call_site_capacity = 0;
+    state_ptr->call_site_count = 0;
+    if (!kmutex_create(&state_ptr->call_site_mutex)) {
+        KFATAL("Unable to create call site mutex!");
+        return false;
+    }
+    KWARN("Memory system is tracking allocation call sites. Allocations will be slower.");
+#endif
+
+    if (config.page_size && pages.page_size < config.page_size) {
+        KINFO("Memory system requested %llu byte pages, but only %llu byte pages were available.", config.page_size, pages.page_size);
+    }
+    // Publish the stats as counters. They are already kept up to date atomically, so are read from in place.
+    state_ptr->counter_ids[0] = counter_register_source("memory.allocations", COUNTER_TYPE_COUNTER, &state_ptr->alloc_count);
+    state_ptr->counter_ids[1] = counter_register_source("memory.frees", COUNTER_TYPE_COUNTER, &state_ptr->stats.free_count);
+    state_ptr->counter_ids[2] = counter_register_source("memory.allocated_bytes", COUNTER_TYPE_GAUGE, &state_ptr->stats.total_allocated);
+    state_ptr->counter_ids[3] = counter_register_source("memory.no_alloc_violations", COUNTER_TYPE_COUNTER, &state_ptr->no_alloc_violation_count);
+    for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
+        char name[COUNTER_NAME_MAX_LENGTH];
+        string_format(name, "memory.allocations.%s", memory_tag_strings[i]);
+        state_ptr->counter_ids[i + 4] = counter_register_source(string_trim(name), COUNTER_TYPE_COUNTER, &state_ptr->stats.tagged_allocation_counts[i]);
+        string_format(name, "memory.frees.%s", memory_tag_strings[i]);
+        state_ptr->counter_ids[i + 4 + MEMORY_TAG_MAX_TAGS] = counter_register_source(string_trim(name), COUNTER_TYPE_COUNTER, &state_ptr->stats.tagged_free_counts[i]);
+    }
+
+    KDEBUG("Memory system successfully allocated %llu bytes in %llu byte pages.", config.total_alloc_size, pages.page_size);
     return true;
 }
 
 void memory_system_shutdown() {
     if (state_ptr) {
+        kmemory_thread_cache_flush();
+
+        for (u32 i = 0; i < MEMORY_COUNTER_COUNT; ++i) {
+            counter_source_clear(state_ptr->counter_ids[i]);
+        }
+
+#ifdef KMEMORY_TRACK_CALL_SITES
+        call_site_report_leaks();
+        if (state_ptr->call_sites) {
+            platform_free(state_ptr->call_sites, false);
+        }
+        kmutex_destroy(&state_ptr->call_site_mutex);
+#endif
+
         // Destroy allocation mutex
         kmutex_destroy(&state_ptr->allocation_mutex);
 
         dynamic_allocator_destroy(&state_ptr->allocator);
-        // Free the entire block.
-        platform_free(state_ptr, state_ptr->allocator_memory_requirement + sizeof(memory_system_state));
+        // Free the entire block. The page block is copied out first, since it lives inside it.
+        platform_page_block pages = state_ptr->pages;
+        platform_free_pages(&pages);
     }
     state_ptr = 0;
 }
 
-void* kallocate(u64 size, memory_tag tag) {
-    return kallocate_aligned(size, 1, tag);
+// NOTE: The names are wrapped in parentheses so that they are not expanded when
+// KMEMORY_TRACK_CALL_SITES turns them into macros.
+void* (kallocate)(u64 size, memory_tag tag) {
+    return kallocate_aligned_at(size, 1, tag, 0, 0);
+}
+
+void* (kallocate_aligned)(u64 size, u16 alignment, memory_tag tag) {
+    return kallocate_aligned_at(size, alignment, tag, 0, 0);
 }
 
-void* kallocate_aligned(u64 size, u16 alignment, memory_tag tag) {
+void* kallocate_aligned_at(u64 size, u16 alignment, memory_tag tag, const char* file, u32 line) {
     if (tag == MEMORY_TAG_UNKNOWN) {
         KWARN("kallocate_aligned called using MEMORY_TAG_UNKNOWN. Re-class this allocation.");
     }
+    if (no_alloc_depth && state_ptr) {
+        no_alloc_violation(size, tag, file, line);
+    }
 
     // Either allocate from the system's allocator or the OS. The latter shouldn't ever
     // really happen.
     void* block = 0;
-    if (state_ptr) {
+    // NOTE: Other alignments are not cached, as the alignment reported for cached blocks would not match.
+    i32 class_index = (alignment == 1 || alignment == MEMORY_CACHE_ALIGNMENT) ? cache_class_index(size) : -1;
+    if (state_ptr && class_index >= 0) {
+        // Small blocks come from the thread's cache. These are tracked at the size of their
+        // size class, as this is the size reported for them by kmemory_get_size_alignment.
+        u64 class_size = (u64)MEMORY_CACHE_MIN_CLASS_SIZE << class_index;
+        block = cache_allocate(class_index);
+        if (block) {
+            stats_add(class_size, tag);
+#ifdef KMEMORY_TRACK_CALL_SITES
+            call_site_record(block, class_size, tag, file, line);
+#endif
+            platform_zero_memory(block, class_size);
+            return block;
+        }
+    } else if (state_ptr) {
         // Make sure multithreaded requests don't trample each other.
         if (!kmutex_lock(&state_ptr->allocation_mutex)) {
             KFATAL("Error obtaining mutex lock during allocation.");
             return 0;
         }
-
-        state_ptr->stats.total_allocated += size;
-        state_ptr->stats.tagged_allocations[tag] += size;
-        state_ptr->alloc_count++;
-
         block = dynamic_allocator_allocate_aligned(&state_ptr->allocator, size, alignment);
         kmutex_unlock(&state_ptr->allocation_mutex);
+
+        if (block) {
+            stats_add(size, tag);
+#ifdef KMEMORY_TRACK_CALL_SITES
+            call_site_record(block, size, tag, file, line);
+#endif
+        }
     } else {
         // If the system is not up yet, warn about it but give memory for now.
         KWARN("kallocate_aligned called before the memory system is initialized.");
@@ -155,15 +616,65 @@ void* kallocate_aligned(u64 size, u16 alignment, memory_tag tag) {
 }
 
 void kallocate_report(u64 size, memory_tag tag) {
-    // Make sure multithreaded requests don't trample each other.
+    stats_add(size, tag);
+}
+
+void* kreallocate(void* block, u64 old_size, u64 new_size, memory_tag tag) {
+    return kreallocate_aligned(block, old_size, new_size, 1, tag);
+}
+
+void* kreallocate_aligned(void* block, u64 old_size, u64 new_size, u16 alignment, memory_tag tag) {
+    if (!block) {
+        return kallocate_aligned(new_size, alignment, tag);
+    }
+    if (!new_size) {
+        KERROR("kreallocate_aligned requires a nonzero new_size.");
+        return 0;
+    }
+
+    // Blocks from before the memory system started can't be resized in place, so move them over.
+    if (!state_ptr || (u8*)block < (u8*)state_ptr->allocator_block || (u8*)block >= (u8*)state_ptr->allocator_block + state_ptr->allocator_memory_requirement) {
+        void* new_block = kallocate_aligned(new_size, alignment, tag);
+        if (new_block) {
+            kcopy_memory(new_block, block, KMIN(old_size, new_size));
+            kfree_aligned(block, old_size, alignment, tag);
+        }
+        return new_block;
+    }
+
+    if (no_alloc_depth) {
+        no_alloc_violation(new_size, tag, 0, 0);
+    }
+
+    // Cached blocks are tracked at the size of their size class. Once resized, they are regular
+    // heap blocks, unless they happen to land on a size class again.
+    i32 class_index = cached_block_class_index(block);
+    u64 tracked_size = class_index >= 0 ? (u64)MEMORY_CACHE_MIN_CLASS_SIZE << class_index : old_size;
+
     if (!kmutex_lock(&state_ptr->allocation_mutex)) {
-        KFATAL("Error obtaining mutex lock during allocation reporting.");
-        return;
+        KFATAL("Error obtaining mutex lock during reallocation.");
+        return 0;
     }
-    state_ptr->stats.total_allocated += size;
-    state_ptr->stats.tagged_allocations[tag] += size;
-    state_ptr->alloc_count++;
+    void* new_block = dynamic_allocator_reallocate(&state_ptr->allocator, block, new_size);
     kmutex_unlock(&state_ptr->allocation_mutex);
+    if (!new_block) {
+        KERROR("kreallocate_aligned failed to resize a block of %llu bytes to %llu bytes.", old_size, new_size);
+        return 0;
+    }
+
+    stats_subtract(tracked_size, tag);
+    stats_add(new_size, tag);
+#ifdef KMEMORY_TRACK_CALL_SITES
+    // Keep the site of the original allocation.
+    memory_call_site site = {0};
+    call_site_remove(block, &site);
+    call_site_record(new_block, new_size, tag, site.file, site.line);
+#endif
+
+    if (new_size > old_size) {
+        kzero_memory((u8*)new_block + old_size, new_size - old_size);
+    }
+    return new_block;
 }
 
 void kfree(void* block, u64 size, memory_tag tag) {
@@ -175,19 +686,27 @@ void kfree_aligned(void* block, u64 size, u16 alignment, memory_tag tag) {
         KWARN("kfree_aligned called using MEMORY_TAG_UNKNOWN. Re-class this allocation.");
     }
     if (state_ptr) {
+#ifdef KMEMORY_TRACK_CALL_SITES
+        call_site_remove(block, 0);
+#endif
+        // Blocks of a size class go back to this thread's cache, no matter which thread allocated them.
+        i32 class_index = cached_block_class_index(block);
+        if (class_index >= 0) {
+            stats_subtract((u64)MEMORY_CACHE_MIN_CLASS_SIZE << class_index, tag);
+            cache_free(class_index, block);
+            return;
+        }
+
         // Make sure multithreaded requests don't trample each other.
         if (!kmutex_lock(&state_ptr->allocation_mutex)) {
             KFATAL("Unable to obtain mutex lock for free operation. Heap corruption is likely.");
             return;
         }
-
-        state_ptr->stats.total_allocated -= size;
-        state_ptr->stats.tagged_allocations[tag] -= size;
-        state_ptr->alloc_count--;
         b8 result = dynamic_allocator_free_aligned(&state_ptr->allocator, block);
-
         kmutex_unlock(&state_ptr->allocation_mutex);
 
+        stats_subtract(size, tag);
+
         // If the free failed, it's possible this is because the allocation was made
         // before this system was started up. Since this absolutely should be an exception
         // to the rule, try freeing it on the platform level. If this fails, some other
@@ -203,15 +722,17 @@ void kfree_aligned(void* block, u64 size, u16 alignment, memory_tag tag) {
 }
 
 void kfree_report(u64 size, memory_tag tag) {
-    // Make sure multithreaded requests don't trample each other.
-    if (!kmutex_lock(&state_ptr->allocation_mutex)) {
-        KFATAL("Error obtaining mutex lock during allocation reporting.");
+    stats_subtract(size, tag);
+}
+
+void kmemory_thread_cache_flush() {
+    if (!state_ptr) {
         return;
     }
-    state_ptr->stats.total_allocated -= size;
-    state_ptr->stats.tagged_allocations[tag] -= size;
-    state_ptr->alloc_count--;
-    kmutex_unlock(&state_ptr->allocation_mutex);
+    memory_thread_cache* cache = get_thread_cache();
+    for (u32 i = 0; i < MEMORY_CACHE_CLASS_COUNT; ++i) {
+        cache_bin_trim(&cache->bins[i], 0);
+    }
 }
 
 b8 kmemory_get_size_alignment(void* block, u64* out_size, u16* out_alignment) {
@@ -226,6 +747,10 @@ void* kcopy_memory(void* dest, const void* source, u64 size) {
     return platform_copy_memory(dest, source, size);
 }
 
+void* kmove_memory(void* dest, const void* source, u64 size) {
+    return platform_move_memory(dest, source, size);
+}
+
 void* kset_memory(void* dest, i32 value, u64 size) {
     return platform_set_memory(dest, value, size);
 }
@@ -250,10 +775,21 @@ char* get_memory_usage_str() {
     char buffer[8000] = "System memory use (tagged):\n";
     u64 offset = strlen(buffer);
     for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
-        f32 amount = 1.0f;
-        const char* unit = get_unit_for_size(state_ptr->stats.tagged_allocations[i], &amount);
+        memory_tag_stats stats;
+        kmemory_tag_stats_get((memory_tag)i, &stats);
 
-        i32 length = snprintf(buffer + offset, 8000, "  %s: %.2f%s\n", memory_tag_strings[i], amount, unit);
+        f32 amount = 1.0f;
+        const char* unit = get_unit_for_size(stats.current_size, &amount);
+        f32 peak_amount = 1.0f;
+        const char* peak_unit = get_unit_for_size(stats.peak_size, &peak_amount);
+        f32 average_amount = 1.0f;
+        const char* average_unit = get_unit_for_size(stats.average_size, &average_amount);
+
+        i32 length = snprintf(
+            buffer + offset, sizeof(buffer) - offset,
+            "  %s: %.2f%s (peak %.2f%s, %llu allocs, %llu live, avg %.2f%s)\n",
+            memory_tag_strings[i], amount, unit, peak_amount, peak_unit,
+            stats.allocation_count, stats.live_count, average_amount, average_unit);
         offset += length;
     }
     {
@@ -268,9 +804,14 @@ char* get_memory_usage_str() {
         f32 total_amount = 1.0f;
         const char* total_unit = get_unit_for_size(total_space, &total_amount);
 
-        f64 percent_used = (f64)(used_space) / total_space;
+        f64 percent_used = ((f64)used_space / total_space) * 100.0;
 
-        i32 length = snprintf(buffer + offset, 8000, "Total memory usage: %.2f%s of %.2f%s (%.2f%%)\n", used_amount, used_unit, total_amount, total_unit, percent_used);
+        i32 length = snprintf(buffer + offset, sizeof(buffer) - offset, "Total memory usage: %.2f%s of %.2f%s (%.2f%%)\n", used_amount, used_unit, total_amount, total_unit, percent_used);
+        offset += length;
+
+        f32 peak_amount = 1.0f;
+        const char* peak_unit = get_unit_for_size(kmemory_peak_usage(), &peak_amount);
+        length = snprintf(buffer + offset, sizeof(buffer) - offset, "Peak tagged usage: %.2f%s\n", peak_amount, peak_unit);
         offset += length;
     }
 
@@ -278,6 +819,53 @@ char* get_memory_usage_str() {
     return out_string;
 }
 
+b8 kmemory_tag_stats_get(memory_tag tag, memory_tag_stats* out_stats) {
+    if (!state_ptr || !out_stats || tag >= MEMORY_TAG_MAX_TAGS) {
+        return false;
+    }
+
+    out_stats->current_size = katomic_load_relaxed(&state_ptr->stats.tagged_allocations[tag]);
+    out_stats->peak_size = katomic_load_relaxed(&state_ptr->stats.tagged_peaks[tag]);
+    out_stats->allocation_count = katomic_load_relaxed(&state_ptr->stats.tagged_allocation_counts[tag]);
+    out_stats->free_count = katomic_load_relaxed(&state_ptr->stats.tagged_free_counts[tag]);
+    out_stats->live_count = katomic_load_relaxed(&state_ptr->stats.tagged_live_counts[tag]);
+    u64 allocation_total = katomic_load_relaxed(&state_ptr->stats.tagged_allocation_totals[tag]);
+    out_stats->average_size = out_stats->allocation_count ? allocation_total / out_stats->allocation_count : 0;
+    return true;
+}
+
+void kmemory_no_alloc_begin(const char* region) {
+    if (no_alloc_depth++ == 0) {
+        no_alloc_region = region;
+    }
+}
+
+void kmemory_no_alloc_end() {
+    if (no_alloc_depth) {
+        no_alloc_depth--;
+    }
+}
+
+void kmemory_no_alloc_action_set(memory_no_alloc_action action) {
+    if (state_ptr) {
+        state_ptr->config.no_alloc_action = action;
+    }
+}
+
+u64 kmemory_no_alloc_violation_count() {
+    if (state_ptr) {
+        return katomic_load_relaxed(&state_ptr->no_alloc_violation_count);
+    }
+    return 0;
+}
+
+u64 kmemory_peak_usage() {
+    if (state_ptr) {
+        return katomic_load_relaxed(&state_ptr->stats.peak_total_allocated);
+    }
+    return 0;
+}
+
 u64 get_memory_alloc_count() {
     if (state_ptr) {
         return state_ptr->alloc_count;
@@ -17,6 +17,11 @@
 
 #include "defines.h"
 
+// Enable recording the file and line of every live allocation by uncommenting the below line.
+// Any allocations still live when the memory system shuts down are then reported as leaks.
+// NOTE: This slows down every allocation and free considerably, so is meant for debugging only.
+// #define KMEMORY_TRACK_CALL_SITES
+
 /** @brief Tags to indicate the usage of memory allocations made in this system. */
 typedef enum memory_tag {
     // For temporary use. Should be assigned one of the below or have a new tag created.
@@ -52,10 +57,45 @@ typedef enum memory_tag {
     MEMORY_TAG_MAX_TAGS
 } memory_tag;
 
+/** @brief Usage statistics for a single memory tag. */
+typedef struct memory_tag_stats {
+    /** @brief The number of bytes currently allocated. */
+    u64 current_size;
+    /** @brief The highest number of bytes allocated at once since the system was initialized. */
+    u64 peak_size;
+    /** @brief The number of allocations made since the system was initialized. */
+    u64 allocation_count;
+    /** @brief The number of frees made since the system was initialized. */
+    u64 free_count;
+    /** @brief The number of allocations currently live. */
+    u64 live_count;
+    /** @brief The average size in bytes of the allocations made since the system was initialized. */
+    u64 average_size;
+} memory_tag_stats;
+
+/** @brief What the memory system does when memory is allocated inside a no-alloc region. */
+typedef enum memory_no_alloc_action {
+    /** @brief The allocation is only counted, in the memory.no_alloc_violations counter. */
+    MEMORY_NO_ALLOC_ACTION_COUNT = 0,
+    /** @brief The allocation is counted, and logged with the stack it was made from. */
+    MEMORY_NO_ALLOC_ACTION_LOG,
+    /** @brief The allocation is counted and logged, then asserted on. */
+    MEMORY_NO_ALLOC_ACTION_ASSERT
+} memory_no_alloc_action;
+
 /** @brief The configuration for the memory system. */
 typedef struct memory_system_configuration {
     /** @brief The total memory size in byes used by the internal allocator for this system. */
     u64 total_alloc_size;
+    /**
+     * @brief The page size in bytes requested to back the heap; MEBIBYTES(2) or GIBIBYTES(1) for
+     * huge pages, or 0 for the platform default. Smaller pages are used if the requested size is unavailable.
+     */
+    u64 page_size;
+    /** @brief Indicates if the heap should be placed on the NUMA node of the initializing thread. */
+    b8 node_local;
+    /** @brief What is done when memory is allocated inside a no-alloc region. */
+    memory_no_alloc_action no_alloc_action;
 } memory_system_configuration;
 
 /**
@@ -71,7 +111,8 @@ KAPI void memory_system_shutdown();
 
 /**
  * @brief Performs a memory allocation from the host of the given size. The allocation
- * is tracked for the provided tag.
+ * is tracked for the provided tag. Small allocations are served from a per-thread cache
+ * of size classes, and are tracked at the size of their size class.
  * @param size The size of the allocation.
  * @param tag Indicates the use of the allocated block.
  * @returns If successful, a pointer to a block of allocated memory; otherwise 0.
@@ -89,6 +130,26 @@ KAPI void* kallocate(u64 size, memory_tag tag);
  */
 KAPI void* kallocate_aligned(u64 size, u16 alignment, memory_tag tag);
 
+/**
+ * @brief Performs an aligned memory allocation in the same way as kallocate_aligned, additionally
+ * recording the call site of the allocation when KMEMORY_TRACK_CALL_SITES is defined.
+ * @note Avoid using this directly. When tracking is enabled, kallocate and kallocate_aligned call this.
+ * @param size The size of the allocation.
+ * @param alignment The alignment in bytes.
+ * @param tag Indicates the use of the allocated block.
+ * @param file The file the allocation was made from, or 0 if unknown.
+ * @param line The line the allocation was made from.
+ * @returns If successful, a pointer to a block of allocated memory; otherwise 0.
+ */
+KAPI void* kallocate_aligned_at(u64 size, u16 alignment, memory_tag tag, const char* file, u32 line);
+
+#ifdef KMEMORY_TRACK_CALL_SITES
+/** @brief Performs a memory allocation, recording the call site. */
+#define kallocate(size, tag) kallocate_aligned_at(size, 1, tag, __FILE__, __LINE__)
+/** @brief Performs an aligned memory allocation, recording the call site. */
+#define kallocate_aligned(size, alignment, tag) kallocate_aligned_at(size, alignment, tag, __FILE__, __LINE__)
+#endif
+
 /**
  * @brief Reports an allocation associated with the application, but made externally.
  * This can be done for items allocated within 3rd party libraries, for example, to
@@ -99,6 +160,29 @@ KAPI void* kallocate_aligned(u64 size, u16 alignment, memory_tag tag);
  */
 KAPI void kallocate_report(u64 size, memory_tag tag);
 
+/**
+ * @brief Resizes the given block, growing or shrinking it in place where possible and moving it
+ * otherwise. The contents are preserved up to the smaller of the two sizes, and any newly added
+ * memory is zeroed. The tracked size for the tag is updated accordingly.
+ * @param block A pointer to the block to be resized, or 0 to perform a new allocation.
+ * @param old_size The size the block was allocated or last resized with.
+ * @param new_size The new size of the block.
+ * @param tag The tag indicating the block's use.
+ * @returns The resized block, which may have moved. If this fails, 0 is returned and block is left untouched.
+ */
+KAPI void* kreallocate(void* block, u64 old_size, u64 new_size, memory_tag tag);
+
+/**
+ * @brief Resizes the given aligned block in the same way as kreallocate, keeping its alignment.
+ * @param block A pointer to the block to be resized, or 0 to perform a new allocation.
+ * @param old_size The size the block was allocated or last resized with.
+ * @param new_size The new size of the block.
+ * @param alignment The alignment the block was allocated with.
+ * @param tag The tag indicating the block's use.
+ * @returns The resized block, which may have moved. If this fails, 0 is returned and block is left untouched.
+ */
+KAPI void* kreallocate_aligned(void* block, u64 old_size, u64 new_size, u16 alignment, memory_tag tag);
+
 /**
  * @brief Frees the given block, and untracks its size from the given tag.
  * @param block A pointer to the block of memory to be freed.
@@ -125,8 +209,16 @@ KAPI void kfree_aligned(void* block, u64 size, u16 alignment, memory_tag tag);
  */
 KAPI void kfree_report(u64 size, memory_tag tag);
 
+/**
+ * @brief Gives any small blocks cached by the calling thread back to the memory system.
+ * Small allocations and frees are served from a per-thread cache to avoid contention,
+ * so threads should call this before they exit to avoid holding on to memory.
+ */
+KAPI void kmemory_thread_cache_flush();
+
 /**
  * @brief Returns the size and alignment of the given block of memory.
+ * NOTE: Small blocks are rounded up to a size class, and the rounded size is returned.
  * NOTE: A failure result from this method most likely indicates heap corruption.
  *
  * @param block The memory block.
@@ -136,6 +228,34 @@ KAPI void kfree_report(u64 size, memory_tag tag);
  */
 KAPI b8 kmemory_get_size_alignment(void* block, u64* out_size, u16* out_alignment);
 
+/**
+ * @brief Marks the start of a region of the calling thread which should not allocate, such as
+ * building a view's packet or rendering it. Any allocation or reallocation made in the region is
+ * counted, and logged or asserted on according to the configured memory_no_alloc_action. Each
+ * offending stack is reported once. Regions may nest; the outermost one is the one reported.
+ * NOTE: Frees are allowed, as are allocations made by allocators from memory they already hold.
+ * @param region The name of the region, which must outlive it. Usually a string literal.
+ */
+KAPI void kmemory_no_alloc_begin(const char* region);
+
+/**
+ * @brief Marks the end of the calling thread's innermost no-alloc region.
+ */
+KAPI void kmemory_no_alloc_end();
+
+/**
+ * @brief Sets what is done when memory is allocated inside a no-alloc region.
+ * @param action The action to take.
+ */
+KAPI void kmemory_no_alloc_action_set(memory_no_alloc_action action);
+
+/**
+ * @brief Obtains the number of allocations made inside no-alloc regions since the memory system
+ * was initialized, on any thread.
+ * @returns The number of offending allocations.
+ */
+KAPI u64 kmemory_no_alloc_violation_count();
+
 /**
  * @brief Zeroes out the provided memory block.
  * @param block A pointer to the block of memory to be zeroed out.
@@ -153,6 +273,16 @@ KAPI void* kzero_memory(void* block, u64 size);
  */
 KAPI void* kcopy_memory(void* dest, const void* source, u64 size);
 
+/**
+ * @brief Performs a copy of the memory at source to dest of the given size, where
+ * the two blocks may overlap.
+ * @param dest A pointer to the destination block of memory to copy to.
+ * @param source A pointer to the source block of memory to copy from.
+ * @param size The amount of memory in bytes to be copied over.
+ * @returns A pointer to the block of memory copied to.
+ */
+KAPI void* kmove_memory(void* dest, const void* source, u64 size);
+
 /**
  * @brief Sets the bytes of memory located at dest to value over the given size.
  * @param dest A pointer to the destination block of memory to be set.
@@ -170,6 +300,21 @@ KAPI void* kset_memory(void* dest, i32 value, u64 size);
  */
 KAPI char* get_memory_usage_str();
 
+/**
+ * @brief Obtains the usage statistics for the given memory tag.
+ * @param tag The tag to obtain statistics for.
+ * @param out_stats A pointer to hold the statistics.
+ * @returns True on success; otherwise false.
+ */
+KAPI b8 kmemory_tag_stats_get(memory_tag tag, memory_tag_stats* out_stats);
+
+/**
+ * @brief Obtains the highest number of bytes allocated at once, across all tags, since the memory
+ * system was initialized. Useful for sizing memory_system_configuration.total_alloc_size.
+ * @returns The peak allocated size in bytes.
+ */
+KAPI u64 kmemory_peak_usage();
+
 /**
  * @brief Obtains the number of times kallocate was called since the memory system was initialized.
  * @returns The total count of allocations since the system's initialization.
@@ -0,0 +1,21 @@
+#include "kname.h"
+
+kname kname_create(const char* str) {
+    if (!str) {
+        return INVALID_KNAME;
+    }
+
+    // 64-bit FNV-1a.
+    u64 hash = 0xcbf29ce484222325ULL;
+    for (const u8* c = (const u8*)str; *c; ++c) {
+        hash ^= *c;
+        hash *= 0x100000001b3ULL;
+    }
+
+    // FNV-1a mixes poorly into the low bits used to pick a hashtable slot, so finish with a murmur3-style avalanche.
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+
+    return hash != INVALID_KNAME ? hash : 1;
+}
@@ -0,0 +1,32 @@
+/**
+ * @file kname.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Contains kname, a pre-hashed name used for fast lookups by name.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief A name, pre-hashed to 64 bits. Create one once, ahead of time, for names
+ * looked up on hot paths, then pass it to the kname lookup variants, which skip
+ * hashing and comparing strings. Names are case-sensitive.
+ */
+typedef u64 kname;
+
+/** @brief A kname which no name hashes to. */
+#define INVALID_KNAME 0
+
+/**
+ * @brief Creates a kname from the given string. The same string always yields the same kname.
+ *
+ * @param str The name to hash. Required.
+ * @return The kname for str; INVALID_KNAME if str is 0.
+ */
+KAPI kname kname_create(const char* str);
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * A counting semaphore to be used for synchronization purposes. A
+ * semaphore holds a count which is incremented by signalling and
+ * decremented by waiting. Waiting on a semaphore with a count of 0
+ * blocks the calling thread until another thread signals it, which
+ * makes it suitable for putting idle threads to sleep until work arrives.
+ */
+typedef struct ksemaphore {
+    void *internal_data;
+} ksemaphore;
+
+/** @brief Pass as the timeout to ksemaphore_wait to wait indefinitely. */
+#define KSEMAPHORE_WAIT_INFINITE INVALID_ID_U64
+
+/**
+ * Creates a semaphore.
+ * @param out_semaphore A pointer to hold the created semaphore.
+ * @param max_count The maximum count the semaphore may reach. Not enforced on all platforms.
+ * @param start_count The count the semaphore starts with.
+ * @returns True if created successfully; otherwise false.
+ */
+b8 ksemaphore_create(ksemaphore *out_semaphore, u32 max_count, u32 start_count);
+
+/**
+ * @brief Destroys the provided semaphore.
+ *
+ * @param semaphore A pointer to the semaphore to be destroyed.
+ */
+void ksemaphore_destroy(ksemaphore *semaphore);
+
+/**
+ * Signals the semaphore, incrementing its count and waking
+ * a waiting thread, if there is one.
+ * @param semaphore A pointer to the semaphore to signal.
+ * @returns True if signalled successfully; otherwise false.
+ */
+b8 ksemaphore_signal(ksemaphore *semaphore);
+
+/**
+ * Waits on the semaphore until it is signalled or the timeout elapses,
+ * decrementing its count on success. Should be called from the thread
+ * requiring the wait.
+ * @param semaphore A pointer to the semaphore to wait on.
+ * @param timeout_ms The maximum time to wait in milliseconds. Pass KSEMAPHORE_WAIT_INFINITE to wait indefinitely.
+ * @returns True if the semaphore was signalled; false on timeout or error.
+ */
+b8 ksemaphore_wait(ksemaphore *semaphore, u64 timeout_ms);
@@ -2,10 +2,12 @@
 #include "core/kmemory.h"
 #include "core/logger.h"
 #include "containers/darray.h"
+#include "memory/linear_allocator.h"
 
 #include <string.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdlib.h>  // strtod, strtof
 #include <ctype.h>  // isspace
 
 #ifndef _MSC_VER
@@ -122,7 +124,7 @@ b8 strings_equali(const char* str0, const char* str1) {
 }
 
 b8 strings_nequal(const char* str0, const char* str1, u64 length) {
-    return strncmp(str0, str1, length);
+    return strncmp(str0, str1, length) == 0;
 }
 
 b8 strings_nequali(const char* str0, const char* str1, u64 length) {
@@ -146,12 +148,26 @@ i32 string_format(char* dest, const char* format, ...) {
 
 i32 string_format_v(char* dest, const char* format, void* va_listp) {
     if (dest) {
-        // Big, but can fit on the stack.
-        char buffer[32000];
-        i32 written = vsnprintf(buffer, 32000, format, va_listp);
-        buffer[written] = 0;
-        kcopy_memory(dest, buffer, written + 1);
+        // Formatted straight into dest, which is trusted to be big enough. Still imposes the
+        // 32k character limit of the stack buffer this used to format into first.
+        return vsnprintf(dest, 32000, format, va_listp);
+    }
+    return -1;
+}
+
+i32 string_nformat_v(char* dest, u64 max_length, const char* format, void* va_listp) {
+    if (dest) {
+        return vsnprintf(dest, max_length, format, va_listp);
+    }
+    return -1;
+}
 
+i32 string_nformat(char* dest, u64 max_length, const char* format, ...) {
+    if (dest && max_length) {
+        __builtin_va_list arg_ptr;
+        va_start(arg_ptr, format);
+        i32 written = vsnprintf(dest, max_length, format, arg_ptr);
+        va_end(arg_ptr);
         return written;
     }
     return -1;
@@ -237,8 +253,9 @@ b8 string_to_vec4(char* str, vec4* out_vector) {
     }
 
     kzero_memory(out_vector, sizeof(vec4));
-    i32 result = sscanf(str, "%f %f %f %f", &out_vector->x, &out_vector->y, &out_vector->z, &out_vector->w);
-    return result != -1;
+    kstring_view text = string_view_create(str);
+    return string_view_parse_f32(&text, &out_vector->x) && string_view_parse_f32(&text, &out_vector->y) &&
+           string_view_parse_f32(&text, &out_vector->z) && string_view_parse_f32(&text, &out_vector->w);
 }
 
 b8 string_to_vec3(char* str, vec3* out_vector) {
@@ -247,8 +264,9 @@ b8 string_to_vec3(char* str, vec3* out_vector) {
     }
 
     kzero_memory(out_vector, sizeof(vec3));
-    i32 result = sscanf(str, "%f %f %f", &out_vector->x, &out_vector->y, &out_vector->z);
-    return result != -1;
+    kstring_view text = string_view_create(str);
+    return string_view_parse_f32(&text, &out_vector->x) && string_view_parse_f32(&text, &out_vector->y) &&
+           string_view_parse_f32(&text, &out_vector->z);
 }
 
 b8 string_to_vec2(char* str, vec2* out_vector) {
@@ -257,8 +275,8 @@ b8 string_to_vec2(char* str, vec2* out_vector) {
     }
 
     kzero_memory(out_vector, sizeof(vec2));
-    i32 result = sscanf(str, "%f %f", &out_vector->x, &out_vector->y);
-    return result != -1;
+    kstring_view text = string_view_create(str);
+    return string_view_parse_f32(&text, &out_vector->x) && string_view_parse_f32(&text, &out_vector->y);
 }
 
 b8 string_to_f32(char* str, f32* f) {
@@ -267,8 +285,7 @@ b8 string_to_f32(char* str, f32* f) {
     }
 
     *f = 0;
-    i32 result = sscanf(str, "%f", f);
-    return result != -1;
+    return string_parse_f32(str, string_length(str), f) != 0;
 }
 
 b8 string_to_f64(char* str, f64* f) {
@@ -277,8 +294,7 @@ b8 string_to_f64(char* str, f64* f) {
     }
 
     *f = 0;
-    i32 result = sscanf(str, "%lf", f);
-    return result != -1;
+    return string_parse_f64(str, string_length(str), f) != 0;
 }
 
 b8 string_to_i8(char* str, i8* i) {
@@ -287,8 +303,12 @@ b8 string_to_i8(char* str, i8* i) {
     }
 
     *i = 0;
-    i32 result = sscanf(str, "%hhi", i);
-    return result != -1;
+    i64 value = 0;
+    if (!string_parse_i64(str, string_length(str), &value) || value < -128ll || value > 127ll) {
+        return false;
+    }
+    *i = (i8)value;
+    return true;
 }
 
 b8 string_to_i16(char* str, i16* i) {
@@ -297,8 +317,12 @@ b8 string_to_i16(char* str, i16* i) {
     }
 
     *i = 0;
-    i32 result = sscanf(str, "%hi", i);
-    return result != -1;
+    i64 value = 0;
+    if (!string_parse_i64(str, string_length(str), &value) || value < -32768ll || value > 32767ll) {
+        return false;
+    }
+    *i = (i16)value;
+    return true;
 }
 
 b8 string_to_i32(char* str, i32* i) {
@@ -307,8 +331,12 @@ b8 string_to_i32(char* str, i32* i) {
     }
 
     *i = 0;
-    i32 result = sscanf(str, "%i", i);
-    return result != -1;
+    i64 value = 0;
+    if (!string_parse_i64(str, string_length(str), &value) || value < -2147483648ll || value > 2147483647ll) {
+        return false;
+    }
+    *i = (i32)value;
+    return true;
 }
 
 b8 string_to_i64(char* str, i64* i) {
@@ -317,8 +345,7 @@ b8 string_to_i64(char* str, i64* i) {
     }
 
     *i = 0;
-    i32 result = sscanf(str, "%lli", i);
-    return result != -1;
+    return string_parse_i64(str, string_length(str), i) != 0;
 }
 
 b8 string_to_u8(char* str, u8* u) {
@@ -327,8 +354,12 @@ b8 string_to_u8(char* str, u8* u) {
     }
 
     *u = 0;
-    i32 result = sscanf(str, "%hhu", u);
-    return result != -1;
+    u64 value = 0;
+    if (!string_parse_u64(str, string_length(str), &value) || value > 0xFFull) {
+        return false;
+    }
+    *u = (u8)value;
+    return true;
 }
 
 b8 string_to_u16(char* str, u16* u) {
@@ -337,8 +368,12 @@ b8 string_to_u16(char* str, u16* u) {
     }
 
     *u = 0;
-    i32 result = sscanf(str, "%hu", u);
-    return result != -1;
+    u64 value = 0;
+    if (!string_parse_u64(str, string_length(str), &value) || value > 0xFFFFull) {
+        return false;
+    }
+    *u = (u16)value;
+    return true;
 }
 
 b8 string_to_u32(char* str, u32* u) {
@@ -347,8 +382,12 @@ b8 string_to_u32(char* str, u32* u) {
     }
 
     *u = 0;
-    i32 result = sscanf(str, "%u", u);
-    return result != -1;
+    u64 value = 0;
+    if (!string_parse_u64(str, string_length(str), &value) || value > 0xFFFFFFFFull) {
+        return false;
+    }
+    *u = (u32)value;
+    return true;
 }
 
 b8 string_to_u64(char* str, u64* u) {
@@ -357,8 +396,7 @@ b8 string_to_u64(char* str, u64* u) {
     }
 
     *u = 0;
-    i32 result = sscanf(str, "%llu", u);
-    return result != -1;
+    return string_parse_u64(str, string_length(str), u) != 0;
 }
 
 b8 string_to_bool(char* str, b8* b) {
@@ -519,3 +557,603 @@ void string_filename_no_extension_from_path(char* dest, const char* path) {
 
     string_mid(dest, path, start, end - start);
 }
+
+kstring_view string_view_create(const char* str) {
+    kstring_view view;
+    view.str = str;
+    view.length = str ? strlen(str) : 0;
+    return view;
+}
+
+kstring_view string_view_from(const char* str, u64 length) {
+    kstring_view view;
+    view.str = str;
+    view.length = length;
+    return view;
+}
+
+b8 string_view_next_line(kstring_view* text, kstring_view* out_line) {
+    if (!text->length) {
+        return false;
+    }
+
+    const char* newline = memchr(text->str, '\n', text->length);
+    u64 line_length = newline ? (u64)(newline - text->str) : text->length;
+    *out_line = string_view_from(text->str, line_length);
+    if (line_length && out_line->str[line_length - 1] == '\r') {
+        out_line->length--;
+    }
+
+    // Step past the newline, if there was one.
+    u64 consumed = newline ? line_length + 1 : line_length;
+    text->str += consumed;
+    text->length -= consumed;
+    return true;
+}
+
+b8 string_view_next_token(kstring_view* text, kstring_view* out_token) {
+    const char* p = text->str;
+    const char* end = text->str + text->length;
+    while (p < end && isspace((unsigned char)*p)) {
+        p++;
+    }
+    const char* start = p;
+    while (p < end && !isspace((unsigned char)*p)) {
+        p++;
+    }
+
+    text->length -= (u64)(p - text->str);
+    text->str = p;
+    *out_token = string_view_from(start, (u64)(p - start));
+    return out_token->length != 0;
+}
+
+b8 string_view_next_split(kstring_view* text, char delimiter, kstring_view* out_entry) {
+    if (!text->length) {
+        return false;
+    }
+
+    const char* found = memchr(text->str, delimiter, text->length);
+    u64 entry_length = found ? (u64)(found - text->str) : text->length;
+    *out_entry = string_view_trim(string_view_from(text->str, entry_length));
+
+    u64 consumed = found ? entry_length + 1 : entry_length;
+    text->str += consumed;
+    text->length -= consumed;
+    return true;
+}
+
+kstring_view string_view_trim(kstring_view view) {
+    while (view.length && isspace((unsigned char)view.str[0])) {
+        view.str++;
+        view.length--;
+    }
+    while (view.length && isspace((unsigned char)view.str[view.length - 1])) {
+        view.length--;
+    }
+    return view;
+}
+
+kstring_view string_view_mid(kstring_view view, u64 start, i64 length) {
+    if (start >= view.length) {
+        return string_view_from(view.str + view.length, 0);
+    }
+    u64 remaining = view.length - start;
+    u64 count = (length < 0 || (u64)length > remaining) ? remaining : (u64)length;
+    return string_view_from(view.str + start, count);
+}
+
+i64 string_view_index_of(kstring_view view, char c) {
+    const char* found = view.length ? memchr(view.str, c, view.length) : 0;
+    return found ? (i64)(found - view.str) : -1;
+}
+
+b8 string_view_equal(kstring_view view, const char* str) {
+    return strlen(str) == view.length && (!view.length || strncmp(view.str, str, view.length) == 0);
+}
+
+b8 string_view_equali(kstring_view view, const char* str) {
+    if (strlen(str) != view.length) {
+        return false;
+    }
+#if defined(__GNUC__)
+    return !view.length || strncasecmp(view.str, str, view.length) == 0;
+#elif (defined _MSC_VER)
+    return !view.length || _strnicmp(view.str, str, view.length) == 0;
+#endif
+}
+
+void string_view_copy(char* dest, kstring_view view, u64 max_length) {
+    if (!max_length) {
+        return;
+    }
+    u64 count = view.length < max_length - 1 ? view.length : max_length - 1;
+    kcopy_memory(dest, view.str, count);
+    dest[count] = 0;
+}
+
+char* string_view_duplicate(kstring_view view) {
+    char* copy = kallocate(view.length + 1, MEMORY_TAG_STRING);
+    string_view_copy(copy, view, view.length + 1);
+    return copy;
+}
+
+b8 string_view_parse_f32(kstring_view* text, f32* f) {
+    u64 consumed = string_parse_f32(text->str, text->length, f);
+    text->str += consumed;
+    text->length -= consumed;
+    return consumed != 0;
+}
+
+b8 string_view_parse_i32(kstring_view* text, i32* i) {
+    i64 value = 0;
+    u64 consumed = string_parse_i64(text->str, text->length, &value);
+    if (!consumed || value < -2147483648ll || value > 2147483647ll) {
+        return false;
+    }
+    *i = (i32)value;
+    text->str += consumed;
+    text->length -= consumed;
+    return true;
+}
+
+b8 string_view_to_bool(kstring_view view) {
+    return string_view_equal(view, "1") || string_view_equali(view, "true");
+}
+
+// Powers of ten which are exact as doubles.
+static const f64 exact_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// The most characters a number falling back to the C library may have. Longer ones are rounded approximately.
+#define PARSE_FALLBACK_MAX_LENGTH 127
+
+// A decimal number as written, mantissa * 10^exponent.
+typedef struct parsed_decimal {
+    const char* start;
+    u64 mantissa;
+    i32 exponent;
+    b8 negative;
+    // Indicates if non-zero digits past the 19 that fit in the mantissa were dropped.
+    b8 truncated;
+} parsed_decimal;
+
+// Scans a decimal number after any whitespace, returning the characters consumed or 0 if there is none.
+static u64 scan_decimal(const char* str, u64 length, parsed_decimal* out) {
+    const char* p = str;
+    const char* end = str + length;
+    while (p < end && isspace((unsigned char)*p)) {
+        p++;
+    }
+    out->start = p;
+    out->mantissa = 0;
+    out->exponent = 0;
+    out->negative = false;
+    out->truncated = false;
+
+    if (p < end && (*p == '-' || *p == '+')) {
+        out->negative = *p == '-';
+        p++;
+    }
+
+    // Gather up to 19 significant digits, which fit in a u64; later ones only scale the result.
+    u32 digit_count = 0;
+    u32 significant_count = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p, ++digit_count) {
+        if (significant_count < 19) {
+            out->mantissa = out->mantissa * 10 + (u64)(*p - '0');
+            significant_count += out->mantissa != 0;
+        } else {
+            out->exponent++;
+            out->truncated |= *p != '0';
+        }
+    }
+    if (p < end && *p == '.') {
+        p++;
+        for (; p < end && *p >= '0' && *p <= '9'; ++p, ++digit_count) {
+            if (significant_count < 19) {
+                out->mantissa = out->mantissa * 10 + (u64)(*p - '0');
+                significant_count += out->mantissa != 0;
+                out->exponent--;
+            } else {
+                out->truncated |= *p != '0';
+            }
+        }
+    }
+    if (!digit_count) {
+        return 0;
+    }
+
+    // The exponent only counts if digits follow it.
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* e = p + 1;
+        b8 negative_exponent = false;
+        if (e < end && (*e == '-' || *e == '+')) {
+            negative_exponent = *e == '-';
+            e++;
+        }
+        if (e < end && *e >= '0' && *e <= '9') {
+            i32 value = 0;
+            for (; e < end && *e >= '0' && *e <= '9'; ++e) {
+                if (value < 100000) {
+                    value = value * 10 + (*e - '0');
+                }
+            }
+            out->exponent += negative_exponent ? -value : value;
+            p = e;
+        }
+    }
+    return (u64)(p - str);
+}
+
+// Gets the exact double nearest the number, if it can be found from exact operations alone (Clinger's fast path).
+static b8 decimal_to_f64_fast(const parsed_decimal* d, f64* out_value) {
+    if (d->mantissa == 0 && !d->truncated) {
+        *out_value = d->negative ? -0.0 : 0.0;
+        return true;
+    }
+    if (d->truncated || d->mantissa > (1ull << 53) || d->exponent < -22 || d->exponent > 22) {
+        return false;
+    }
+    // Both the mantissa and the power of ten are exact, so the one rounding is correct.
+    f64 value = (f64)d->mantissa;
+    value = d->exponent < 0 ? value / exact_powers_of_ten[-d->exponent] : value * exact_powers_of_ten[d->exponent];
+    *out_value = d->negative ? -value : value;
+    return true;
+}
+
+// Gets an approximation of the number by repeated scaling, for numbers too long to hand to the C library.
+static f64 decimal_to_f64_approximate(const parsed_decimal* d) {
+    f64 value = (f64)d->mantissa;
+    i32 exponent = d->exponent;
+    if (value != 0.0) {
+        while (exponent > 22) {
+            value *= 1e22;
+            exponent -= 22;
+        }
+        while (exponent < -22) {
+            value /= 1e22;
+            exponent += 22;
+        }
+        value = exponent < 0 ? value / exact_powers_of_ten[-exponent] : value * exact_powers_of_ten[exponent];
+    }
+    return d->negative ? -value : value;
+}
+
+// Copies the scanned number into a terminated buffer for the C library, if it fits. The digits are
+// written without their decimal point, which the C library reads from the locale, and the exponent
+// is moved to make up for it, so the text means the same in any locale.
+static b8 decimal_copy_text(const parsed_decimal* d, const char* end, char* out_text) {
+    const char* p = d->start;
+    u64 length = 0;
+    i32 exponent = 0;
+    if (*p == '-' || *p == '+') {
+        out_text[length++] = *p++;
+    }
+    b8 fraction = false;
+    for (; p < end && ((*p >= '0' && *p <= '9') || (*p == '.' && !fraction)); ++p) {
+        if (*p == '.') {
+            fraction = true;
+            continue;
+        }
+        // Room is left for the exponent.
+        if (length >= PARSE_FALLBACK_MAX_LENGTH - 16) {
+            return false;
+        }
+        out_text[length++] = *p;
+        exponent -= fraction;
+    }
+    // Any exponent was only scanned if digits follow it.
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        b8 negative_exponent = false;
+        if (*p == '-' || *p == '+') {
+            negative_exponent = *p == '-';
+            p++;
+        }
+        i32 value = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+            if (value < 100000) {
+                value = value * 10 + (*p - '0');
+            }
+        }
+        exponent += negative_exponent ? -value : value;
+    }
+    snprintf(out_text + length, PARSE_FALLBACK_MAX_LENGTH + 1 - length, "e%d", exponent);
+    return true;
+}
+
+u64 string_parse_f64(const char* str, u64 length, f64* out_value) {
+    parsed_decimal d;
+    u64 consumed = scan_decimal(str, length, &d);
+    if (!consumed) {
+        return 0;
+    }
+
+    if (!decimal_to_f64_fast(&d, out_value)) {
+        // Rare: too many digits, or too large an exponent. The C library rounds these exactly.
+        char text[PARSE_FALLBACK_MAX_LENGTH + 1];
+        *out_value = decimal_copy_text(&d, str + consumed, text) ? strtod(text, 0) : decimal_to_f64_approximate(&d);
+    }
+    return consumed;
+}
+
+u64 string_parse_f32(const char* str, u64 length, f32* out_value) {
+    parsed_decimal d;
+    u64 consumed = scan_decimal(str, length, &d);
+    if (!consumed) {
+        return 0;
+    }
+
+    f64 exact;
+    if (decimal_to_f64_fast(&d, &exact)) {
+        // Rounding the correctly-rounded double again is only wrong if the double landed exactly
+        // halfway between two floats, since every such midpoint is itself a double.
+        f32 value = (f32)exact;
+        f64 below = (f64)value;
+        if (below == exact) {
+            *out_value = value;
+            return consumed;
+        }
+        union {
+            f32 f;
+            u32 bits;
+        } neighbour;
+        neighbour.f = value;
+        // Step the float's magnitude towards the double, to the float on its other side.
+        neighbour.bits += (exact < 0.0) == (exact < below) ? 1 : -1;
+        f64 other = (f64)neighbour.f;
+        if (exact - below != other - exact) {
+            *out_value = value;
+            return consumed;
+        }
+    }
+
+    // Rare: too many digits, too large an exponent or exactly halfway. The C library rounds these exactly.
+    char text[PARSE_FALLBACK_MAX_LENGTH + 1];
+    *out_value = decimal_copy_text(&d, str + consumed, text) ? strtof(text, 0) : (f32)decimal_to_f64_approximate(&d);
+    return consumed;
+}
+
+u64 string_parse_u64(const char* str, u64 length, u64* out_value) {
+    const char* p = str;
+    const char* end = str + length;
+    while (p < end && isspace((unsigned char)*p)) {
+        p++;
+    }
+    if (p < end && *p == '+') {
+        p++;
+    }
+    if (p >= end || *p < '0' || *p > '9') {
+        return 0;
+    }
+
+    u64 value = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+        u64 digit = (u64)(*p - '0');
+        if (value > (0xFFFFFFFFFFFFFFFFull - digit) / 10) {
+            // Overflow.
+            return 0;
+        }
+        value = value * 10 + digit;
+    }
+    *out_value = value;
+    return (u64)(p - str);
+}
+
+u64 string_parse_i64(const char* str, u64 length, i64* out_value) {
+    const char* p = str;
+    const char* end = str + length;
+    while (p < end && isspace((unsigned char)*p)) {
+        p++;
+    }
+    b8 negative = false;
+    if (p < end && *p == '-') {
+        negative = true;
+        p++;
+    } else if (p < end && *p == '+') {
+        p++;
+    }
+    if (p >= end || *p < '0' || *p > '9') {
+        return 0;
+    }
+
+    // Gathered as a magnitude, which may be one more than the largest positive value when negative.
+    u64 limit = negative ? 0x8000000000000000ull : 0x7FFFFFFFFFFFFFFFull;
+    u64 magnitude = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+        u64 digit = (u64)(*p - '0');
+        if (magnitude > (limit - digit) / 10) {
+            // Overflow.
+            return 0;
+        }
+        magnitude = magnitude * 10 + digit;
+    }
+    *out_value = negative ? (i64)(0 - magnitude) : (i64)magnitude;
+    return (u64)(p - str);
+}
+
+kstring_view string_format_arena(struct linear_allocator* allocator, const char* format, ...) {
+    kstring_view view = {0};
+    if (!allocator || !format) {
+        return view;
+    }
+
+    // Measured first, so exactly enough is taken.
+    __builtin_va_list arg_ptr;
+    va_start(arg_ptr, format);
+    i32 length = vsnprintf(0, 0, format, arg_ptr);
+    va_end(arg_ptr);
+    if (length < 0) {
+        return view;
+    }
+    char* str = linear_allocator_allocate(allocator, (u64)length + 1);
+    if (!str) {
+        return view;
+    }
+    va_start(arg_ptr, format);
+    vsnprintf(str, (u64)length + 1, format, arg_ptr);
+    va_end(arg_ptr);
+    view.str = str;
+    view.length = (u64)length;
+    return view;
+}
+
+void string_builder_create(u64 capacity, kstring_builder* out_builder) {
+    kzero_memory(out_builder, sizeof(kstring_builder));
+    out_builder->capacity = KMAX(capacity, 1);
+    out_builder->data = kallocate(out_builder->capacity, MEMORY_TAG_STRING);
+    out_builder->data[0] = 0;
+}
+
+void string_builder_create_from_buffer(char* buffer, u64 size, kstring_builder* out_builder) {
+    kzero_memory(out_builder, sizeof(kstring_builder));
+    out_builder->fixed = true;
+    if (buffer && size) {
+        out_builder->data = buffer;
+        out_builder->capacity = size;
+        out_builder->data[0] = 0;
+    }
+}
+
+void string_builder_create_arena(struct linear_allocator* allocator, u64 capacity, kstring_builder* out_builder) {
+    kzero_memory(out_builder, sizeof(kstring_builder));
+    out_builder->allocator = allocator;
+    out_builder->data = allocator ? linear_allocator_allocate(allocator, KMAX(capacity, 1)) : 0;
+    if (out_builder->data) {
+        out_builder->capacity = KMAX(capacity, 1);
+        out_builder->data[0] = 0;
+    } else {
+        // Nothing can be added, as there is nowhere to grow from either.
+        out_builder->fixed = true;
+    }
+}
+
+void string_builder_destroy(kstring_builder* builder) {
+    if (!builder) {
+        return;
+    }
+    if (builder->data && !builder->fixed && !builder->allocator) {
+        kfree(builder->data, builder->capacity, MEMORY_TAG_STRING);
+    }
+    kzero_memory(builder, sizeof(kstring_builder));
+}
+
+void string_builder_clear(kstring_builder* builder) {
+    if (builder && builder->data) {
+        builder->length = 0;
+        builder->data[0] = 0;
+        builder->truncated = false;
+    }
+}
+
+void string_builder_truncate(kstring_builder* builder, u64 length) {
+    if (builder && builder->data && length < builder->length) {
+        builder->length = length;
+        builder->data[length] = 0;
+    }
+}
+
+// Makes room for a string of the given length, growing the buffer if it may. Keeps what was built.
+static b8 string_builder_reserve(kstring_builder* builder, u64 length) {
+    if (length + 1 <= builder->capacity) {
+        return true;
+    }
+    if (builder->fixed) {
+        return false;
+    }
+
+    u64 new_capacity = KMAX(builder->capacity * 2, length + 1);
+    char* data;
+    if (builder->allocator) {
+        if (linear_allocator_extend(builder->allocator, builder->data, builder->capacity, new_capacity)) {
+            builder->capacity = new_capacity;
+            return true;
+        }
+        data = linear_allocator_allocate(builder->allocator, new_capacity);
+        if (!data) {
+            return false;
+        }
+        kcopy_memory(data, builder->data, builder->length + 1);
+    } else {
+        data = kallocate(new_capacity, MEMORY_TAG_STRING);
+        kcopy_memory(data, builder->data, builder->length + 1);
+        kfree(builder->data, builder->capacity, MEMORY_TAG_STRING);
+    }
+    builder->data = data;
+    builder->capacity = new_capacity;
+    return true;
+}
+
+// Appends the given characters, cutting them off if there is not room for them all.
+static b8 string_builder_append_bytes(kstring_builder* builder, const char* bytes, u64 count) {
+    if (!builder || !builder->data) {
+        if (builder) {
+            builder->truncated = true;
+        }
+        return false;
+    }
+    b8 fits = string_builder_reserve(builder, builder->length + count);
+    if (!fits) {
+        count = builder->capacity - 1 - builder->length;
+        builder->truncated = true;
+    }
+    kcopy_memory(builder->data + builder->length, bytes, count);
+    builder->length += count;
+    builder->data[builder->length] = 0;
+    return fits;
+}
+
+b8 string_builder_append(kstring_builder* builder, const char* str) {
+    return str ? string_builder_append_bytes(builder, str, strlen(str)) : true;
+}
+
+b8 string_builder_append_view(kstring_builder* builder, kstring_view view) {
+    return string_builder_append_bytes(builder, view.str, view.length);
+}
+
+b8 string_builder_append_char(kstring_builder* builder, char c) {
+    return string_builder_append_bytes(builder, &c, 1);
+}
+
+b8 string_builder_append_format(kstring_builder* builder, const char* format, ...) {
+    if (!builder || !builder->data || !format) {
+        if (builder) {
+            builder->truncated = true;
+        }
+        return false;
+    }
+
+    // Formatted straight into what is left of the buffer, and again once grown if it did not fit.
+    __builtin_va_list arg_ptr;
+    va_start(arg_ptr, format);
+    i32 written = vsnprintf(builder->data + builder->length, builder->capacity - builder->length, format, arg_ptr);
+    va_end(arg_ptr);
+    if (written < 0) {
+        builder->data[builder->length] = 0;
+        return false;
+    }
+    if (builder->length + written + 1 > builder->capacity) {
+        if (!string_builder_reserve(builder, builder->length + written)) {
+            // What fit is kept, cut off.
+            builder->length = builder->capacity - 1;
+            builder->truncated = true;
+            return false;
+        }
+        va_start(arg_ptr, format);
+        vsnprintf(builder->data + builder->length, builder->capacity - builder->length, format, arg_ptr);
+        va_end(arg_ptr);
+    }
+    builder->length += written;
+    return true;
+}
+
+kstring_view string_builder_view(const kstring_builder* builder) {
+    kstring_view view = {0};
+    if (builder && builder->data) {
+        view.str = builder->data;
+        view.length = builder->length;
+    }
+    return view;
+}
@@ -14,6 +14,8 @@
 #include "defines.h"
 #include "math/math_types.h"
 
+struct linear_allocator;
+
 /**
  * @brief Gets the length of the given string.
  * @param str The string whose length to obtain.
@@ -110,6 +112,30 @@ KAPI i32 string_format(char* dest, const char* format, ...);
  */
 KAPI i32 string_format_v(char* dest, const char* format, void* va_list);
 
+/**
+ * @brief Performs variadic string formatting to dest given format string and va_list, writing
+ * no more than max_length characters including the terminator. Formats in place, without the
+ * intermediate buffer string_format_v uses.
+ * @param dest The destination for the formatted string. Always terminated if max_length is non-zero.
+ * @param max_length The size of dest in characters.
+ * @param format The string to be formatted.
+ * @param va_list The variadic argument list.
+ * @returns The length the full formatted string would have, which is max_length or more if it was
+ * truncated; or -1 on error.
+ */
+KAPI i32 string_nformat_v(char* dest, u64 max_length, const char* format, void* va_list);
+
+/**
+ * @brief Performs string formatting into a caller-provided buffer, truncated to fit, and always terminates it.
+ *
+ * @param dest The destination for the formatted string.
+ * @param max_length The size of dest, including the terminator.
+ * @param format The string to be formatted.
+ * @param ... The variadic argument list.
+ * @returns The length of the formatted string, which is greater than or equal to max_length if it was truncated; -1 on error.
+ */
+KAPI i32 string_nformat(char* dest, u64 max_length, const char* format, ...);
+
 /**
  * @brief Empties the provided string by setting the first character to 0.
  *
@@ -380,3 +406,322 @@ KAPI void string_filename_from_path(char* dest, const char* path);
  * @param path The full path to extract from.
  */
 KAPI void string_filename_no_extension_from_path(char* dest, const char* path);
+
+/**
+ * @brief A view of a range of characters in a string, which is not owned and is not
+ * necessarily terminated. Used to parse text, such as a mapped file, without copying it.
+ */
+typedef struct kstring_view {
+    /** @brief The first character of the view. */
+    const char* str;
+    /** @brief The number of characters in the view. */
+    u64 length;
+} kstring_view;
+
+/**
+ * @brief Creates a view of the given terminated string.
+ *
+ * @param str The string to be viewed. May be 0, giving an empty view.
+ * @return The view.
+ */
+KAPI kstring_view string_view_create(const char* str);
+
+/**
+ * @brief Creates a view of the given number of characters.
+ *
+ * @param str The characters to be viewed.
+ * @param length The number of characters.
+ * @return The view.
+ */
+KAPI kstring_view string_view_from(const char* str, u64 length);
+
+/**
+ * @brief Takes the next line from the front of the given text, without its line ending
+ * ("\n" or "\r\n"), and advances the text past it.
+ *
+ * @param text A pointer to the text to take the line from.
+ * @param out_line A pointer to hold the line.
+ * @return True if a line was taken; false if the text was empty.
+ */
+KAPI b8 string_view_next_line(kstring_view* text, kstring_view* out_line);
+
+/**
+ * @brief Takes the next whitespace-separated token from the front of the given text, and
+ * advances the text past it.
+ *
+ * @param text A pointer to the text to take the token from.
+ * @param out_token A pointer to hold the token.
+ * @return True if a token was taken; false if only whitespace remained.
+ */
+KAPI b8 string_view_next_token(kstring_view* text, kstring_view* out_token);
+
+/**
+ * @brief Takes the next entry up to the given delimiter from the front of the given text,
+ * trimmed of whitespace, and advances the text past the delimiter. As string_split does.
+ *
+ * @param text A pointer to the text to take the entry from.
+ * @param delimiter The character entries are separated by.
+ * @param out_entry A pointer to hold the entry, which may be empty.
+ * @return True if an entry was taken; false if the text was empty.
+ */
+KAPI b8 string_view_next_split(kstring_view* text, char delimiter, kstring_view* out_entry);
+
+/**
+ * @brief Gets the given view with leading and trailing whitespace removed.
+ *
+ * @param view The view to be trimmed.
+ * @return The trimmed view.
+ */
+KAPI kstring_view string_view_trim(kstring_view view);
+
+/**
+ * @brief Gets part of the given view, clamped to it.
+ *
+ * @param view The view to take part of.
+ * @param start The index of the first character.
+ * @param length The number of characters, or -1 for the rest of the view.
+ * @return The part of the view.
+ */
+KAPI kstring_view string_view_mid(kstring_view view, u64 start, i64 length);
+
+/**
+ * @brief Gets the index of the first occurance of the given character in the view.
+ *
+ * @param view The view to be searched.
+ * @param c The character to look for.
+ * @return The index of the character, or -1 if not found.
+ */
+KAPI i64 string_view_index_of(kstring_view view, char c);
+
+/**
+ * @brief Case-sensitive comparison of a view to a string.
+ *
+ * @param view The view to compare.
+ * @param str The terminated string to compare.
+ * @return True if the same; otherwise false.
+ */
+KAPI b8 string_view_equal(kstring_view view, const char* str);
+
+/**
+ * @brief Case-insensitive comparison of a view to a string.
+ *
+ * @param view The view to compare.
+ * @param str The terminated string to compare.
+ * @return True if the same; otherwise false.
+ */
+KAPI b8 string_view_equali(kstring_view view, const char* str);
+
+/**
+ * @brief Copies the given view into dest, truncated to fit, and always terminates it.
+ *
+ * @param dest The destination for the string.
+ * @param view The view to copy.
+ * @param max_length The size of dest, including the terminator.
+ */
+KAPI void string_view_copy(char* dest, kstring_view view, u64 max_length);
+
+/**
+ * @brief Copies the given view into a new terminated string. NOTE: This allocates, and
+ * the result must be freed by the caller.
+ *
+ * @param view The view to copy.
+ * @return The new string.
+ */
+KAPI char* string_view_duplicate(kstring_view view);
+
+/**
+ * @brief Parses a decimal floating-point number, such as "-1.5e3", from the front of the
+ * given text after any whitespace, and advances the text past it. As string_parse_f32 does.
+ *
+ * @param text A pointer to the text to parse from.
+ * @param f A pointer to the float to write to.
+ * @return True if a number was parsed; otherwise false, leaving the text as it was.
+ */
+KAPI b8 string_view_parse_f32(kstring_view* text, f32* f);
+
+/**
+ * @brief Parses a decimal integer from the front of the given text after any whitespace,
+ * and advances the text past it. Fails if the number does not fit in an i32.
+ *
+ * @param text A pointer to the text to parse from.
+ * @param i A pointer to the int to write to.
+ * @return True if a number was parsed; otherwise false, leaving the text as it was.
+ */
+KAPI b8 string_view_parse_i32(kstring_view* text, i32* i);
+
+/**
+ * @brief Parses a boolean from a view. "true" or "1" are considered true; anything else is false.
+ *
+ * @param view The view to parse.
+ * @return The parsed boolean.
+ */
+KAPI b8 string_view_to_bool(kstring_view view);
+
+/**
+ * @brief Parses a decimal floating-point number, such as "-1.5e3", from the start of the
+ * given characters after any whitespace. Correctly rounded, and independent of the locale.
+ * Needs no terminator, and does not allocate.
+ *
+ * @param str The characters to parse from.
+ * @param length The number of characters, which need not be terminated.
+ * @param out_value A pointer to the float to write to.
+ * @return The number of characters consumed, including leading whitespace; 0 if there was no number.
+ */
+KAPI u64 string_parse_f32(const char* str, u64 length, f32* out_value);
+
+/**
+ * @brief Parses a decimal floating-point number, as string_parse_f32 does, at double precision.
+ *
+ * @param str The characters to parse from.
+ * @param length The number of characters, which need not be terminated.
+ * @param out_value A pointer to the float to write to.
+ * @return The number of characters consumed, including leading whitespace; 0 if there was no number.
+ */
+KAPI u64 string_parse_f64(const char* str, u64 length, f64* out_value);
+
+/**
+ * @brief Parses an optionally signed decimal integer from the start of the given characters
+ * after any whitespace.
+ *
+ * @param str The characters to parse from.
+ * @param length The number of characters, which need not be terminated.
+ * @param out_value A pointer to the int to write to.
+ * @return The number of characters consumed, including leading whitespace; 0 if there was no number or it overflowed.
+ */
+KAPI u64 string_parse_i64(const char* str, u64 length, i64* out_value);
+
+/**
+ * @brief Parses an unsigned decimal integer from the start of the given characters after any whitespace.
+ *
+ * @param str The characters to parse from.
+ * @param length The number of characters, which need not be terminated.
+ * @param out_value A pointer to the int to write to.
+ * @return The number of characters consumed, including leading whitespace; 0 if there was no number or it overflowed.
+ */
+KAPI u64 string_parse_u64(const char* str, u64 length, u64* out_value);
+
+
+/**
+ * @brief Performs string formatting into memory taken from the given linear allocator, sized to fit
+ * exactly, without an intermediate buffer. Suits strings needed only for a while, such as for a frame.
+ *
+ * @param allocator A pointer to the allocator to take the memory from.
+ * @param format The string to be formatted.
+ * @param ... The variadic argument list.
+ * @returns A view of the terminated string, or an empty view if the allocator is full.
+ */
+KAPI kstring_view string_format_arena(struct linear_allocator* allocator, const char* format, ...);
+
+/**
+ * @brief Builds a string piece by piece, formatting each piece straight into its buffer, which is
+ * always terminated. The buffer is either the caller's, in which case what does not fit is cut off,
+ * or grows as needed, from the heap or from a linear allocator.
+ */
+typedef struct kstring_builder {
+    /** @brief The string built so far, always terminated. */
+    char* data;
+    /** @brief The length of the string built so far. */
+    u64 length;
+    /** @brief The size of the buffer, including the terminator. */
+    u64 capacity;
+    /** @brief The allocator the buffer grows from, or 0 if it is the caller's or from the heap. */
+    struct linear_allocator* allocator;
+    /** @brief Indicates if the buffer is the caller's and so never grows. */
+    b8 fixed;
+    /** @brief Indicates if something was cut off, or could not be added for lack of memory. */
+    b8 truncated;
+} kstring_builder;
+
+/**
+ * @brief Creates a builder whose buffer is taken from the heap and grows as needed. Should be destroyed.
+ *
+ * @param capacity The size of the buffer to start with, including the terminator.
+ * @param out_builder A pointer to hold the builder.
+ */
+KAPI void string_builder_create(u64 capacity, kstring_builder* out_builder);
+
+/**
+ * @brief Creates a builder over the given buffer, which never grows; what does not fit is cut off.
+ *
+ * @param buffer The buffer to build in.
+ * @param size The size of the buffer, including the terminator. Must be at least 1.
+ * @param out_builder A pointer to hold the builder.
+ */
+KAPI void string_builder_create_from_buffer(char* buffer, u64 size, kstring_builder* out_builder);
+
+/**
+ * @brief Creates a builder whose buffer is taken from the given linear allocator, which it grows in
+ * place while it is the allocator's last allocation. The buffer is freed along with the allocator's memory.
+ *
+ * @param allocator A pointer to the allocator to take the buffer from.
+ * @param capacity The size of the buffer to start with, including the terminator.
+ * @param out_builder A pointer to hold the builder.
+ */
+KAPI void string_builder_create_arena(struct linear_allocator* allocator, u64 capacity, kstring_builder* out_builder);
+
+/**
+ * @brief Destroys the given builder, freeing its buffer if it was taken from the heap.
+ *
+ * @param builder A pointer to the builder.
+ */
+KAPI void string_builder_destroy(kstring_builder* builder);
+
+/**
+ * @brief Empties the given builder, keeping its buffer.
+ *
+ * @param builder A pointer to the builder.
+ */
+KAPI void string_builder_clear(kstring_builder* builder);
+
+/**
+ * @brief Cuts the string built so far back to the given length, such as to drop a piece which was cut off.
+ *
+ * @param builder A pointer to the builder.
+ * @param length The length to cut back to. Longer lengths leave the string as it is.
+ */
+KAPI void string_builder_truncate(kstring_builder* builder, u64 length);
+
+/**
+ * @brief Appends the given string.
+ *
+ * @param builder A pointer to the builder.
+ * @param str The string to append.
+ * @return True if all of it was appended; otherwise false.
+ */
+KAPI b8 string_builder_append(kstring_builder* builder, const char* str);
+
+/**
+ * @brief Appends the characters of the given view.
+ *
+ * @param builder A pointer to the builder.
+ * @param view The view to append.
+ * @return True if all of it was appended; otherwise false.
+ */
+KAPI b8 string_builder_append_view(kstring_builder* builder, kstring_view view);
+
+/**
+ * @brief Appends the given character.
+ *
+ * @param builder A pointer to the builder.
+ * @param c The character to append.
+ * @return True if it was appended; otherwise false.
+ */
+KAPI b8 string_builder_append_char(kstring_builder* builder, char c);
+
+/**
+ * @brief Formats and appends a string, formatting straight into the builder's buffer.
+ *
+ * @param builder A pointer to the builder.
+ * @param format The string to be formatted.
+ * @param ... The variadic argument list.
+ * @return True if all of it was appended; otherwise false.
+ */
+KAPI b8 string_builder_append_format(kstring_builder* builder, const char* format, ...);
+
+/**
+ * @brief Obtains a view of the string built so far, valid until the builder next changes.
+ *
+ * @param builder A constant pointer to the builder.
+ * @return The view.
+ */
+KAPI kstring_view string_builder_view(const kstring_builder* builder);
@@ -23,7 +23,7 @@ typedef u32 (*pfn_thread_start)(void *);
  * @param out_thread A pointer to hold the created thread, if auto_detach is false.
  * @returns true if successfully created; otherwise false.
  */
-b8 kthread_create(pfn_thread_start start_function_ptr, void *params, b8 auto_detach, kthread *out_thread);
+KAPI b8 kthread_create(pfn_thread_start start_function_ptr, void *params, b8 auto_detach, kthread *out_thread);
 
 /**
  * Destroys the given thread.
@@ -46,6 +46,15 @@ void kthread_cancel(kthread *thread);
  */
 b8 kthread_is_active(kthread* thread);
 
+/**
+ * Restricts the given thread to run only on the logical processors in the given mask,
+ * where bit n refers to the processor with index n (see platform_get_cpu_topology).
+ * @param thread A pointer to the thread to be pinned.
+ * @param affinity_mask A mask of the logical processors the thread may run on. Must not be 0.
+ * @returns True if the affinity was set; otherwise false, including where not supported.
+ */
+b8 kthread_set_affinity(kthread* thread, u64 affinity_mask);
+
 /**
  * Sleeps on the given thread for a given number of milliseconds. Should be called from the
  * thread requiring the sleep.
@@ -0,0 +1,309 @@
+#include "log_deferred.h"
+
+#include "core/kmemory.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// The longest conversion specification handled, e.g. "%-+#0123.456lld".
+#define LOG_SPEC_MAX_LENGTH 32
+// The most characters of a string argument captured.
+#define LOG_STRING_MAX_LENGTH 4096
+
+typedef enum spec_length {
+    SPEC_LENGTH_NONE,
+    SPEC_LENGTH_HH,
+    SPEC_LENGTH_H,
+    SPEC_LENGTH_L,
+    SPEC_LENGTH_LL,
+    SPEC_LENGTH_Z,
+    SPEC_LENGTH_J,
+    SPEC_LENGTH_T,
+    SPEC_LENGTH_LONG_DOUBLE
+} spec_length;
+
+// A parsed conversion specification.
+typedef struct format_spec {
+    // The characters from '%' up to, but not including, the length modifier.
+    const char* start;
+    u32 prefix_length;
+    // The number of '*' in the width and precision, each taking an int argument first.
+    u32 star_count;
+    spec_length length;
+    char conversion;
+    // The whole specification's length in the format.
+    u32 total_length;
+} format_spec;
+
+// Parses the specification starting at the '%' at format. Returns false at the end of the string.
+static b8 spec_parse(const char* format, format_spec* out_spec) {
+    const char* c = format + 1;
+    out_spec->start = format;
+    out_spec->star_count = 0;
+    out_spec->length = SPEC_LENGTH_NONE;
+
+    // Flags, width and precision.
+    while (*c == '-' || *c == '+' || *c == ' ' || *c == '#' || *c == '0') {
+        c++;
+    }
+    if (*c == '*') {
+        out_spec->star_count++;
+        c++;
+    }
+    while (*c >= '0' && *c <= '9') {
+        c++;
+    }
+    if (*c == '.') {
+        c++;
+        if (*c == '*') {
+            out_spec->star_count++;
+            c++;
+        }
+        while (*c >= '0' && *c <= '9') {
+            c++;
+        }
+    }
+    out_spec->prefix_length = (u32)(c - format);
+
+    // Length modifier.
+    if (c[0] == 'h' && c[1] == 'h') {
+        out_spec->length = SPEC_LENGTH_HH;
+        c += 2;
+    } else if (c[0] == 'l' && c[1] == 'l') {
+        out_spec->length = SPEC_LENGTH_LL;
+        c += 2;
+    } else if (*c == 'h') {
+        out_spec->length = SPEC_LENGTH_H;
+        c++;
+    } else if (*c == 'l') {
+        out_spec->length = SPEC_LENGTH_L;
+        c++;
+    } else if (*c == 'z') {
+        out_spec->length = SPEC_LENGTH_Z;
+        c++;
+    } else if (*c == 'j') {
+        out_spec->length = SPEC_LENGTH_J;
+        c++;
+    } else if (*c == 't') {
+        out_spec->length = SPEC_LENGTH_T;
+        c++;
+    } else if (*c == 'L') {
+        out_spec->length = SPEC_LENGTH_LONG_DOUBLE;
+        c++;
+    }
+
+    if (*c == 0) {
+        return false;
+    }
+    out_spec->conversion = *c;
+    out_spec->total_length = (u32)(c - format) + 1;
+    return true;
+}
+
+static b8 is_integer_conversion(char conversion) {
+    return conversion == 'd' || conversion == 'i' || conversion == 'u' || conversion == 'x' || conversion == 'X' || conversion == 'o' || conversion == 'c';
+}
+
+static b8 is_float_conversion(char conversion) {
+    return conversion == 'f' || conversion == 'F' || conversion == 'e' || conversion == 'E' || conversion == 'g' || conversion == 'G' || conversion == 'a' || conversion == 'A';
+}
+
+static b8 payload_write(u8* payload, u32 max_size, u32* offset, u64 value) {
+    if (*offset + sizeof(u64) > max_size) {
+        return false;
+    }
+    kcopy_memory(payload + *offset, &value, sizeof(u64));
+    *offset += sizeof(u64);
+    return true;
+}
+
+static u64 payload_read(const u8* payload, u32 payload_size, u32* offset) {
+    u64 value = 0;
+    if (*offset + sizeof(u64) <= payload_size) {
+        kcopy_memory(&value, payload + *offset, sizeof(u64));
+        *offset += sizeof(u64);
+    }
+    return value;
+}
+
+u32 log_deferred_capture(const char* format, __builtin_va_list args, u8* out_payload, u32 max_size) {
+    u32 offset = 0;
+    format_spec spec;
+    for (const char* c = format; *c; ++c) {
+        if (*c != '%') {
+            continue;
+        }
+        if (c[1] == '%') {
+            c++;
+            continue;
+        }
+        if (!spec_parse(c, &spec)) {
+            break;
+        }
+        c += spec.total_length - 1;
+
+        for (u32 i = 0; i < spec.star_count; ++i) {
+            if (!payload_write(out_payload, max_size, &offset, (u64)(i64)va_arg(args, int))) {
+                return INVALID_ID;
+            }
+        }
+
+        u64 value = 0;
+        if (is_integer_conversion(spec.conversion)) {
+            switch (spec.length) {
+                case SPEC_LENGTH_L:
+                    value = (u64)va_arg(args, long);
+                    break;
+                case SPEC_LENGTH_LL:
+                    value = (u64)va_arg(args, long long);
+                    break;
+                case SPEC_LENGTH_Z:
+                    value = (u64)va_arg(args, size_t);
+                    break;
+                case SPEC_LENGTH_J:
+                    value = (u64)va_arg(args, intmax_t);
+                    break;
+                case SPEC_LENGTH_T:
+                    value = (u64)va_arg(args, ptrdiff_t);
+                    break;
+                default:
+                    // Anything shorter than an int is promoted to one.
+                    value = (u64)(i64)va_arg(args, int);
+                    break;
+            }
+        } else if (is_float_conversion(spec.conversion)) {
+            f64 f = spec.length == SPEC_LENGTH_LONG_DOUBLE ? (f64)va_arg(args, long double) : va_arg(args, double);
+            kcopy_memory(&value, &f, sizeof(f64));
+        } else if (spec.conversion == 'p') {
+            value = (u64)va_arg(args, void*);
+        } else if (spec.conversion == 's') {
+            const char* str = va_arg(args, const char*);
+            if (!str) {
+                str = "(null)";
+            }
+            // Strings are truncated to fit rather than failing the whole entry.
+            u32 available = offset + sizeof(u16) < max_size ? max_size - offset - sizeof(u16) : 0;
+            u32 length = 0;
+            while (str[length] && length < available && length < LOG_STRING_MAX_LENGTH) {
+                length++;
+            }
+            if (offset + sizeof(u16) > max_size) {
+                return INVALID_ID;
+            }
+            u16 length16 = (u16)length;
+            kcopy_memory(out_payload + offset, &length16, sizeof(u16));
+            kcopy_memory(out_payload + offset + sizeof(u16), str, length);
+            offset += sizeof(u16) + length;
+            continue;
+        } else if (spec.conversion == 'n') {
+            va_arg(args, int*);
+            continue;
+        } else {
+            // Not a conversion which takes an argument.
+            continue;
+        }
+        if (!payload_write(out_payload, max_size, &offset, value)) {
+            return INVALID_ID;
+        }
+    }
+    return offset;
+}
+
+u64 log_deferred_format(const char* format, const u8* payload, u32 payload_size, char* out_text, u64 max_length) {
+    if (!out_text || max_length == 0) {
+        return 0;
+    }
+
+    u64 length = 0;
+    u32 offset = 0;
+    format_spec spec;
+    char spec_text[LOG_SPEC_MAX_LENGTH + 2];
+    // Strings are held unterminated in the payload, so are terminated here before formatting.
+    char string_buffer[LOG_STRING_MAX_LENGTH + 1];
+    for (const char* c = format; *c && length + 1 < max_length; ++c) {
+        if (*c != '%') {
+            out_text[length++] = *c;
+            continue;
+        }
+        if (c[1] == '%') {
+            out_text[length++] = '%';
+            c++;
+            continue;
+        }
+        if (!spec_parse(c, &spec) || spec.total_length > LOG_SPEC_MAX_LENGTH) {
+            break;
+        }
+        c += spec.total_length - 1;
+
+        // Rebuild the specification with any '*' replaced by its captured value, and the length
+        // modifier dropped where the value is passed at a different width below.
+        u32 spec_length = 0;
+        for (u32 i = 0; i < spec.prefix_length && spec_length < LOG_SPEC_MAX_LENGTH; ++i) {
+            if (spec.start[i] == '*') {
+                i32 star = (i32)payload_read(payload, payload_size, &offset);
+                spec_length += (u32)snprintf(spec_text + spec_length, LOG_SPEC_MAX_LENGTH - spec_length, "%d", star);
+                spec_length = KMIN(spec_length, LOG_SPEC_MAX_LENGTH);
+            } else {
+                spec_text[spec_length++] = spec.start[i];
+            }
+        }
+        const char* modifier = "";
+        if (is_integer_conversion(spec.conversion) && spec.length != SPEC_LENGTH_NONE && spec.length != SPEC_LENGTH_LONG_DOUBLE) {
+            // Widths below an int keep their modifier, so the value is narrowed as it would have been.
+            modifier = spec.length == SPEC_LENGTH_HH ? "hh" : spec.length == SPEC_LENGTH_H ? "h" : "ll";
+        }
+        i32 written = snprintf(spec_text + spec_length, sizeof(spec_text) - spec_length, "%s%c", modifier, spec.conversion);
+        if (written < 0) {
+            break;
+        }
+
+        char* dest = out_text + length;
+        u64 remaining = max_length - length;
+        i32 result = 0;
+        if (is_integer_conversion(spec.conversion)) {
+            u64 value = payload_read(payload, payload_size, &offset);
+            if (spec.length == SPEC_LENGTH_NONE || spec.length == SPEC_LENGTH_HH || spec.length == SPEC_LENGTH_H || spec.length == SPEC_LENGTH_LONG_DOUBLE) {
+                result = snprintf(dest, remaining, spec_text, (int)value);
+            } else {
+                result = snprintf(dest, remaining, spec_text, (long long)value);
+            }
+        } else if (is_float_conversion(spec.conversion)) {
+            u64 value = payload_read(payload, payload_size, &offset);
+            f64 f;
+            kcopy_memory(&f, &value, sizeof(f64));
+            result = snprintf(dest, remaining, spec_text, f);
+        } else if (spec.conversion == 'p') {
+            result = snprintf(dest, remaining, spec_text, (void*)payload_read(payload, payload_size, &offset));
+        } else if (spec.conversion == 's') {
+            u16 string_length = 0;
+            if (offset + sizeof(u16) <= payload_size) {
+                kcopy_memory(&string_length, payload + offset, sizeof(u16));
+                offset += sizeof(u16);
+            }
+            if (offset + string_length > payload_size) {
+                string_length = (u16)(payload_size - offset);
+            }
+            string_length = KMIN(string_length, LOG_STRING_MAX_LENGTH);
+            kcopy_memory(string_buffer, payload + offset, string_length);
+            string_buffer[string_length] = 0;
+            offset += string_length;
+            result = snprintf(dest, remaining, spec_text, string_buffer);
+        } else if (spec.conversion == 'n') {
+            continue;
+        } else {
+            // Not a conversion, so it is written as it appears.
+            u32 copy_length = (u32)KMIN((u64)spec.total_length, remaining - 1);
+            kcopy_memory(dest, spec.start, copy_length);
+            result = (i32)copy_length;
+        }
+
+        if (result < 0) {
+            break;
+        }
+        length += KMIN((u64)result, remaining - 1);
+    }
+    out_text[length] = 0;
+    return length;
+}
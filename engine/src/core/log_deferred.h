@@ -0,0 +1,44 @@
+/**
+ * @file log_deferred.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Captures the arguments of a printf-style format into a compact payload, and formats
+ * such a payload later, so that log entries can be formatted away from the thread logging them.
+ * @details A payload is the arguments in format order, with nothing else: every numeric or
+ * pointer argument, including '*' widths and precisions, takes 8 bytes, and every string a 2 byte
+ * length followed by up to 4096 of its characters. The format string itself is not stored, as it is needed to
+ * read the payload back anyway. %n is not supported, and is skipped.
+ * @version 1.0
+ *
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief Captures the arguments described by the given format into a payload, without
+ * formatting any of them. String arguments are copied, truncated if there isn't room.
+ *
+ * @param format The printf-style format string.
+ * @param args The arguments.
+ * @param out_payload A pointer to hold the payload.
+ * @param max_size The size of out_payload in bytes.
+ * @return The size of the payload in bytes; or INVALID_ID if an argument other than a string didn't fit.
+ */
+KAPI u32 log_deferred_capture(const char* format, __builtin_va_list args, u8* out_payload, u32 max_size);
+
+/**
+ * @brief Formats the given format with the arguments held in a payload from log_deferred_capture.
+ * Missing arguments, as in a damaged payload, format as zeroes and empty strings.
+ *
+ * @param format The printf-style format string the payload was captured with.
+ * @param payload The payload.
+ * @param payload_size The size of the payload in bytes.
+ * @param out_text A pointer to hold the formatted text. Always terminated if max_length is non-zero.
+ * @param max_length The size of out_text in characters.
+ * @return The length of the formatted text, not including the terminator.
+ */
+KAPI u64 log_deferred_format(const char* format, const u8* payload, u32 payload_size, char* out_text, u64 max_length);
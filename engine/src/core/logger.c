@@ -2,22 +2,94 @@
 #include "asserts.h"
 #include "platform/platform.h"
 #include "platform/filesystem.h"
+#include "core/katomic.h"
+#include "core/kmutex.h"
+#include "core/ksemaphore.h"
 #include "core/kstring.h"
 #include "core/kmemory.h"
+#include "core/kthread.h"
+#include "core/log_deferred.h"
+#include "containers/flat_map.h"
+#include "containers/mpmc_queue.h"
 
 // TODO: temporary
 #include <stdarg.h>
 
+// The most text a queued entry holds, including the level prefix, newline and terminator.
+// Longer entries are written straight away by the thread logging them.
+#define LOG_RECORD_TEXT_SIZE 1016
+// The number of entries which can wait for the writer. Must be a power of 2.
+#define LOG_QUEUE_CAPACITY 512
+// The number of entries the writer takes from the queue at a time, and writes to the file at once.
+#define LOG_BATCH_SIZE 32
+// How long the writer waits for when idle, unless woken by a new entry.
+#define LOG_WRITER_IDLE_MS 100
+// Every level prefix is the same length.
+#define LOG_LEVEL_PREFIX_LENGTH 9
+// The number of format strings the writer remembers having written to the binary log. Must be a power of 2.
+#define LOG_BINARY_FORMAT_SLOTS 1024
+// The size of the buffer binary log writes are gathered in.
+#define LOG_BINARY_BUFFER_SIZE KIBIBYTES(64)
+
+// Identifies a binary log file.
+#define LOG_BINARY_MAGIC 0x474F4C4B
+#define LOG_BINARY_VERSION 1
+
+// The kinds of block in a binary log, each following a u8 holding its kind.
+typedef enum log_binary_block {
+    // u64 format id, u32 length, then the format string's characters.
+    LOG_BINARY_BLOCK_FORMAT = 1,
+    // u8 level, u8 category, u64 format id, u32 payload size, then the payload.
+    LOG_BINARY_BLOCK_ENTRY = 2
+} log_binary_block;
+
+typedef struct log_record {
+    u8 level;
+    u8 category;
+    // If set, text holds a payload from log_deferred_capture for format, rather than text.
+    b8 deferred;
+    // The length of the text not including the terminator, or of the payload.
+    u32 length;
+    const char* format;
+    char text[LOG_RECORD_TEXT_SIZE];
+} log_record;
+
 typedef struct logger_system_state {
     file_handle log_file_handle;
+    // Serializes console and file writes between the writer and threads writing directly.
+    kmutex write_mutex;
+    // Entries waiting for the writer. Its memory follows this state.
+    mpmc_queue queue;
+    kthread writer;
+    ksemaphore wake_semaphore;
+    // Set while the writer is about to wait, so that loggers only signal it when it needs waking.
+    volatile u32 writer_sleeping;
+    volatile u32 writer_running;
+    volatile u32 writer_exited;
+    // Entries taken from the queue, and their text gathered for the file. Guarded by write_mutex,
+    // as is everything below.
+    log_record batch[LOG_BATCH_SIZE];
+    char file_buffer[LOG_BATCH_SIZE * LOG_RECORD_TEXT_SIZE];
+    // A deferred entry formatted by the writer.
+    char deferred_text[LOG_RECORD_TEXT_SIZE];
+
+    // Deferred entries go here unformatted while open.
+    file_handle binary_file_handle;
+    u8 binary_buffer[LOG_BINARY_BUFFER_SIZE];
+    u64 binary_buffered;
+    // The format strings already written to the binary log, by address.
+    u64 binary_formats[LOG_BINARY_FORMAT_SLOTS];
 } logger_system_state;
 
 static logger_system_state* state_ptr;
 
-void append_to_log_file(const char* message) {
+u8 log_category_levels[LOG_CATEGORY_MAX] = {[0 ... LOG_CATEGORY_MAX - 1] = LOG_LEVEL_TRACE};
+
+static const char* level_strings[6] = {"[FATAL]: ", "[ERROR]: ", "[WARN]:  ", "[INFO]:  ", "[DEBUG]: ", "[TRACE]: "};
+
+void append_to_log_file(const char* message, u64 length) {
     if (state_ptr && state_ptr->log_file_handle.is_valid) {
         // Since the message already contains a '\n', just write the bytes directly.
-        u64 length = string_length(message);
         u64 written = 0;
         if (!filesystem_write(&state_ptr->log_file_handle, length, message, &written)) {
             platform_console_write_error("ERROR writing to console.log.", LOG_LEVEL_ERROR);
@@ -25,63 +97,442 @@ void append_to_log_file(const char* message) {
     }
 }
 
+static void console_write(u32 level, const char* message) {
+    if (level < LOG_LEVEL_WARN) {
+        platform_console_write_error(message, level);
+    } else {
+        platform_console_write(message, level);
+    }
+}
+
+static void binary_flush(void) {
+    if (state_ptr->binary_buffered) {
+        u64 written = 0;
+        if (!filesystem_write(&state_ptr->binary_file_handle, state_ptr->binary_buffered, state_ptr->binary_buffer, &written)) {
+            platform_console_write_error("ERROR writing to the binary log.", LOG_LEVEL_ERROR);
+        }
+        state_ptr->binary_buffered = 0;
+    }
+}
+
+static void binary_write(const void* data, u64 size) {
+    if (state_ptr->binary_buffered + size > LOG_BINARY_BUFFER_SIZE) {
+        binary_flush();
+        if (size > LOG_BINARY_BUFFER_SIZE) {
+            u64 written = 0;
+            filesystem_write(&state_ptr->binary_file_handle, size, data, &written);
+            return;
+        }
+    }
+    kcopy_memory(state_ptr->binary_buffer + state_ptr->binary_buffered, data, size);
+    state_ptr->binary_buffered += size;
+}
+
+// Writes a deferred entry to the binary log, preceded by its format string the first time it is seen.
+static void binary_write_entry(const log_record* record) {
+    u64 id = (u64)record->format;
+    u32 slot = (u32)((id >> 3) * 0x9E3779B97F4A7C15ull >> 54) & (LOG_BINARY_FORMAT_SLOTS - 1);
+    b8 known = false;
+    for (u32 probe = 0; probe < LOG_BINARY_FORMAT_SLOTS; ++probe) {
+        u64* entry = &state_ptr->binary_formats[(slot + probe) & (LOG_BINARY_FORMAT_SLOTS - 1)];
+        if (*entry == id) {
+            known = true;
+            break;
+        }
+        if (*entry == 0) {
+            *entry = id;
+            break;
+        }
+    }
+    // Once the table is full, unremembered formats are written again each time, which the decoder allows.
+    if (!known) {
+        u8 kind = LOG_BINARY_BLOCK_FORMAT;
+        u32 length = (u32)string_length(record->format);
+        binary_write(&kind, sizeof(u8));
+        binary_write(&id, sizeof(u64));
+        binary_write(&length, sizeof(u32));
+        binary_write(record->format, length);
+    }
+
+    u8 header[3] = {LOG_BINARY_BLOCK_ENTRY, record->level, record->category};
+    binary_write(header, sizeof(header));
+    binary_write(&id, sizeof(u64));
+    binary_write(&record->length, sizeof(u32));
+    binary_write(record->text, record->length);
+}
+
+// Formats a deferred entry as text, with its level prefix and newline. Returns the length.
+static u32 deferred_format(const log_record* record, char* out_text) {
+    kcopy_memory(out_text, level_strings[record->level], LOG_LEVEL_PREFIX_LENGTH);
+    u64 length = LOG_LEVEL_PREFIX_LENGTH + log_deferred_format(record->format, (const u8*)record->text, record->length, out_text + LOG_LEVEL_PREFIX_LENGTH, LOG_RECORD_TEXT_SIZE - LOG_LEVEL_PREFIX_LENGTH - 1);
+    out_text[length++] = '\n';
+    out_text[length] = 0;
+    return (u32)length;
+}
+
+// Writes out everything queued, up to when the queue is seen empty. Requires write_mutex.
+static u32 flush_queued(void) {
+    u32 total = 0;
+    u32 count = 0;
+    do {
+        count = mpmc_queue_pop_batch(&state_ptr->queue, state_ptr->batch, LOG_BATCH_SIZE);
+        u64 buffered = 0;
+        for (u32 i = 0; i < count; ++i) {
+            log_record* record = &state_ptr->batch[i];
+            const char* text = record->text;
+            u32 length = record->length;
+            if (record->deferred) {
+                if (state_ptr->binary_file_handle.is_valid) {
+                    binary_write_entry(record);
+                    continue;
+                }
+                length = deferred_format(record, state_ptr->deferred_text);
+                text = state_ptr->deferred_text;
+            }
+            console_write(record->level, text);
+            kcopy_memory(state_ptr->file_buffer + buffered, text, length);
+            buffered += length;
+        }
+        if (buffered) {
+            append_to_log_file(state_ptr->file_buffer, buffered);
+        }
+        total += count;
+    } while (count == LOG_BATCH_SIZE);
+    if (state_ptr->binary_file_handle.is_valid) {
+        binary_flush();
+    }
+    return total;
+}
+
+static u32 log_writer_run(void* params) {
+    while (katomic_load(&state_ptr->writer_running)) {
+        kmutex_lock(&state_ptr->write_mutex);
+        u32 flushed = flush_queued();
+        kmutex_unlock(&state_ptr->write_mutex);
+
+        if (flushed == 0) {
+            katomic_store(&state_ptr->writer_sleeping, 1);
+            // Check again, as an entry may have been queued before the flag was visible.
+            if (mpmc_queue_length(&state_ptr->queue) == 0 && katomic_load(&state_ptr->writer_running)) {
+                ksemaphore_wait(&state_ptr->wake_semaphore, LOG_WRITER_IDLE_MS);
+            }
+            katomic_store(&state_ptr->writer_sleeping, 0);
+        }
+    }
+    katomic_store(&state_ptr->writer_exited, 1);
+    return 0;
+}
+
 b8 initialize_logging(u64* memory_requirement, void* state) {
-    *memory_requirement = sizeof(logger_system_state);
+    *memory_requirement = sizeof(logger_system_state) + mpmc_queue_memory_requirement(sizeof(log_record), LOG_QUEUE_CAPACITY);
     if (state == 0) {
         return true;
     }
 
-    state_ptr = state;
+    logger_system_state* new_state = state;
+    kzero_memory(new_state, sizeof(logger_system_state));
 
     // Create new/wipe existing log file, then open it.
-    if (!filesystem_open("console.log", FILE_MODE_WRITE, false, &state_ptr->log_file_handle)) {
+    if (!filesystem_open("console.log", FILE_MODE_WRITE, false, &new_state->log_file_handle)) {
         platform_console_write_error("ERROR: Unable to open console.log for writing.", LOG_LEVEL_ERROR);
         return false;
     }
+    if (!kmutex_create(&new_state->write_mutex) || !ksemaphore_create(&new_state->wake_semaphore, 1, 0)) {
+        platform_console_write_error("ERROR: Unable to create the logger's synchronization objects.", LOG_LEVEL_ERROR);
+        filesystem_close(&new_state->log_file_handle);
+        return false;
+    }
+    mpmc_queue_create(sizeof(log_record), LOG_QUEUE_CAPACITY, (u8*)state + sizeof(logger_system_state), &new_state->queue);
+
+    state_ptr = new_state;
+
+    // Without a writer, everything is still logged, only on the logging thread.
+    state_ptr->writer_running = 1;
+    if (!kthread_create(log_writer_run, 0, true, &state_ptr->writer)) {
+        state_ptr->writer_running = 0;
+        platform_console_write_error("ERROR: Unable to start the log writer thread; logging synchronously.", LOG_LEVEL_ERROR);
+    }
 
     return true;
 }
 
 void shutdown_logging(void* state) {
-    // TODO: cleanup logging/write queued entries.
+    if (state_ptr) {
+        if (katomic_load(&state_ptr->writer_running)) {
+            katomic_store(&state_ptr->writer_running, 0);
+            ksemaphore_signal(&state_ptr->wake_semaphore);
+            while (!katomic_load(&state_ptr->writer_exited)) {
+                platform_sleep(1);
+            }
+        }
+
+        // Write out whatever the writer didn't get to.
+        kmutex_lock(&state_ptr->write_mutex);
+        flush_queued();
+        if (state_ptr->binary_file_handle.is_valid) {
+            filesystem_close(&state_ptr->binary_file_handle);
+        }
+        kmutex_unlock(&state_ptr->write_mutex);
+
+        filesystem_close(&state_ptr->log_file_handle);
+        ksemaphore_destroy(&state_ptr->wake_semaphore);
+        kmutex_destroy(&state_ptr->write_mutex);
+        mpmc_queue_destroy(&state_ptr->queue);
+    }
     state_ptr = 0;
 }
 
+// Writes an entry on the calling thread, after anything queued before it. Used for errors, which
+// should be out before whatever follows them, and entries too long to queue.
+static void write_now(log_level level, const char* message, u64 length) {
+    if (!state_ptr) {
+        // Not yet started, or already shut down, so only the console is available.
+        console_write(level, message);
+        return;
+    }
+
+    kmutex_lock(&state_ptr->write_mutex);
+    flush_queued();
+    console_write(level, message);
+    append_to_log_file(message, length);
+    kmutex_unlock(&state_ptr->write_mutex);
+}
+
+// Queues a record for the writer. Returns false if it must be written by the caller instead.
+static b8 queue_record(const log_record* record) {
+    if (!state_ptr || !katomic_load(&state_ptr->writer_running) || !mpmc_queue_try_push(&state_ptr->queue, record)) {
+        return false;
+    }
+    if (katomic_load(&state_ptr->writer_sleeping) && katomic_exchange(&state_ptr->writer_sleeping, 0)) {
+        ksemaphore_signal(&state_ptr->wake_semaphore);
+    }
+    return true;
+}
+
+void log_category_level_set(log_category category, log_level level) {
+    if (category < LOG_CATEGORY_MAX) {
+        // Errors can't be silenced.
+        log_category_levels[category] = (u8)KMAX(level, LOG_LEVEL_ERROR);
+    }
+}
+
 void log_output(log_level level, const char* message, ...) {
-    // TODO: These string operations are all pretty slow. This needs to be
-    // moved to another thread eventually, along with the file writes, to
-    // avoid slowing things down while the engine is trying to run.
-    const char* level_strings[6] = {"[FATAL]: ", "[ERROR]: ", "[WARN]:  ", "[INFO]:  ", "[DEBUG]: ", "[TRACE]: "};
-    b8 is_error = level < LOG_LEVEL_WARN;
+    // Format straight into a record, after the level prefix, leaving room for the newline.
+    log_record record;
+    record.level = level;
+    record.category = LOG_CATEGORY_GENERAL;
+    record.deferred = false;
+    record.format = 0;
+    kcopy_memory(record.text, level_strings[level], LOG_LEVEL_PREFIX_LENGTH);
 
+    // NOTE: Oddly enough, MS's headers override the GCC/Clang va_list type with a "typedef char* va_list" in some
+    // cases, and as a result throws a strange error here. The workaround for now is to just use __builtin_va_list,
+    // which is the type GCC/Clang's va_start expects.
+    __builtin_va_list arg_ptr;
+    va_start(arg_ptr, message);
+    i32 written = string_nformat_v(record.text + LOG_LEVEL_PREFIX_LENGTH, LOG_RECORD_TEXT_SIZE - LOG_LEVEL_PREFIX_LENGTH - 1, message, arg_ptr);
+    va_end(arg_ptr);
+    if (written < 0) {
+        written = 0;
+    }
+
+    u64 length = LOG_LEVEL_PREFIX_LENGTH + (u64)written;
+    if (length + 1 < LOG_RECORD_TEXT_SIZE) {
+        record.text[length++] = '\n';
+        record.text[length] = 0;
+        record.length = (u32)length;
+
+        // Errors are written straight away, so they aren't lost if the application goes down after them.
+        // Otherwise, only if the writer has fallen behind, to keep up.
+        if (level < LOG_LEVEL_WARN || !queue_record(&record)) {
+            write_now(level, record.text, length);
+        }
+        return;
+    }
+
+    // Too long to queue, so format it again in full.
     // Technically imposes a 32k character limit on a single log entry, but...
     // DON'T DO THAT!
     char out_message[32000];
-    kzero_memory(out_message, sizeof(out_message));
+    kcopy_memory(out_message, level_strings[level], LOG_LEVEL_PREFIX_LENGTH);
+    va_start(arg_ptr, message);
+    written = string_nformat_v(out_message + LOG_LEVEL_PREFIX_LENGTH, sizeof(out_message) - LOG_LEVEL_PREFIX_LENGTH - 1, message, arg_ptr);
+    va_end(arg_ptr);
+    u64 full_length = LOG_LEVEL_PREFIX_LENGTH + (u64)written;
+    length = KMIN(full_length, sizeof(out_message) - 2);
+    out_message[length++] = '\n';
+    out_message[length] = 0;
+    write_now(level, out_message, length);
+}
+
+void log_output_deferred(log_category category, log_level level, const char* message, ...) {
+    log_record record;
+    record.level = level;
+    record.category = category;
+    record.deferred = true;
+    record.format = message;
 
-    // Format original message.
-    // NOTE: Oddly enough, MS's headers override the GCC/Clang va_list type with a "typedef char* va_list" in some
-    // cases, and as a result throws a strange error here. The workaround for now is to just use __builtin_va_list,
-    // which is the type GCC/Clang's va_start expects.
     __builtin_va_list arg_ptr;
     va_start(arg_ptr, message);
-    string_format_v(out_message, message, arg_ptr);
+    u32 size = log_deferred_capture(message, arg_ptr, (u8*)record.text, LOG_RECORD_TEXT_SIZE);
     va_end(arg_ptr);
 
-    // Prepend log level to message.
-    string_format(out_message, "%s%s\n", level_strings[level], out_message);
+    if (size != INVALID_ID) {
+        record.length = size;
+        if (level >= LOG_LEVEL_WARN && queue_record(&record)) {
+            return;
+        }
+        // Formatted here instead, for the same reasons log_output writes straight away.
+        char text[LOG_RECORD_TEXT_SIZE];
+        u32 length = deferred_format(&record, text);
+        write_now(level, text, length);
+        return;
+    }
 
-    // Print accordingly
-    if (is_error) {
-        platform_console_write_error(out_message, level);
-    } else {
-        platform_console_write(out_message, level);
+    // The arguments didn't fit in a record, so format it in full here.
+    char out_message[32000];
+    kcopy_memory(out_message, level_strings[level], LOG_LEVEL_PREFIX_LENGTH);
+    va_start(arg_ptr, message);
+    i32 written = string_nformat_v(out_message + LOG_LEVEL_PREFIX_LENGTH, sizeof(out_message) - LOG_LEVEL_PREFIX_LENGTH - 1, message, arg_ptr);
+    va_end(arg_ptr);
+    u64 full_length = LOG_LEVEL_PREFIX_LENGTH + (u64)KMAX(written, 0);
+    u64 length = KMIN(full_length, sizeof(out_message) - 2);
+    out_message[length++] = '\n';
+    out_message[length] = 0;
+    write_now(level, out_message, length);
+}
+
+b8 log_binary_open(const char* path) {
+    if (!state_ptr || !katomic_load(&state_ptr->writer_running)) {
+        KERROR("log_binary_open - Requires the logging system and its writer thread to be running.");
+        return false;
     }
 
-    // Queue a copy to be written to the log file.
-    append_to_log_file(out_message);
+    log_binary_close();
+    kmutex_lock(&state_ptr->write_mutex);
+    b8 result = filesystem_open(path, FILE_MODE_WRITE, true, &state_ptr->binary_file_handle);
+    if (result) {
+        u32 header[2] = {LOG_BINARY_MAGIC, LOG_BINARY_VERSION};
+        kzero_memory(state_ptr->binary_formats, sizeof(state_ptr->binary_formats));
+        state_ptr->binary_buffered = 0;
+        binary_write(header, sizeof(header));
+    }
+    kmutex_unlock(&state_ptr->write_mutex);
+    if (!result) {
+        KERROR("log_binary_open - Unable to open '%s' for writing.", path);
+    }
+    return result;
+}
+
+void log_binary_close(void) {
+    if (!state_ptr) {
+        return;
+    }
+
+    kmutex_lock(&state_ptr->write_mutex);
+    if (state_ptr->binary_file_handle.is_valid) {
+        // Anything deferred before closing still belongs in the binary log.
+        flush_queued();
+        filesystem_close(&state_ptr->binary_file_handle);
+    }
+    kmutex_unlock(&state_ptr->write_mutex);
+}
+
+// Reads a value of the given size from a binary log, failing at the end of the data.
+static b8 binary_read(const u8* data, u64 size, u64* offset, void* out_value, u64 value_size) {
+    if (*offset + value_size > size) {
+        return false;
+    }
+    kcopy_memory(out_value, data + *offset, value_size);
+    *offset += value_size;
+    return true;
+}
+
+b8 log_binary_decode(const char* input_path, const char* output_path) {
+    file_handle input;
+    if (!filesystem_open(input_path, FILE_MODE_READ, true, &input)) {
+        KERROR("log_binary_decode - Unable to open '%s'.", input_path);
+        return false;
+    }
+    u64 size = 0;
+    filesystem_size(&input, &size);
+    u8* data = kallocate(size ? size : 1, MEMORY_TAG_STRING);
+    u64 read = 0;
+    b8 result = filesystem_read_all_bytes(&input, data, &read);
+    filesystem_close(&input);
+
+    u32 header[2] = {0};
+    u64 offset = 0;
+    if (!result || !binary_read(data, read, &offset, header, sizeof(header)) || header[0] != LOG_BINARY_MAGIC || header[1] != LOG_BINARY_VERSION) {
+        KERROR("log_binary_decode - '%s' is not a binary log this version can read.", input_path);
+        kfree(data, size ? size : 1, MEMORY_TAG_STRING);
+        return false;
+    }
+
+    file_handle output;
+    if (!filesystem_open(output_path, FILE_MODE_WRITE, false, &output)) {
+        KERROR("log_binary_decode - Unable to open '%s' for writing.", output_path);
+        kfree(data, size ? size : 1, MEMORY_TAG_STRING);
+        return false;
+    }
+
+    // Format strings by id, each held as a copy terminated for formatting.
+    flat_map formats;
+    flat_map_create(sizeof(char*), 0, &formats);
+    char line[LOG_RECORD_TEXT_SIZE];
+    u32 entry_count = 0;
+    while (offset < read) {
+        u8 kind = 0;
+        u64 id = 0;
+        u32 length = 0;
+        binary_read(data, read, &offset, &kind, sizeof(u8));
+        if (kind == LOG_BINARY_BLOCK_FORMAT) {
+            if (!binary_read(data, read, &offset, &id, sizeof(u64)) || !binary_read(data, read, &offset, &length, sizeof(u32)) || offset + length > read) {
+                break;
+            }
+            char** existing = flat_map_get(&formats, id);
+            if (existing) {
+                kfree(*existing, string_length(*existing) + 1, MEMORY_TAG_STRING);
+            }
+            char* format = kallocate(length + 1, MEMORY_TAG_STRING);
+            kcopy_memory(format, data + offset, length);
+            format[length] = 0;
+            flat_map_set(&formats, id, &format);
+            offset += length;
+        } else if (kind == LOG_BINARY_BLOCK_ENTRY) {
+            u8 level_category[2] = {0};
+            if (!binary_read(data, read, &offset, level_category, sizeof(level_category)) || !binary_read(data, read, &offset, &id, sizeof(u64)) ||
+                !binary_read(data, read, &offset, &length, sizeof(u32)) || offset + length > read) {
+                break;
+            }
+            char** format = flat_map_get(&formats, id);
+            if (format && level_category[0] <= LOG_LEVEL_TRACE) {
+                kcopy_memory(line, level_strings[level_category[0]], LOG_LEVEL_PREFIX_LENGTH);
+                u64 line_length = LOG_LEVEL_PREFIX_LENGTH + log_deferred_format(*format, data + offset, length, line + LOG_LEVEL_PREFIX_LENGTH, sizeof(line) - LOG_LEVEL_PREFIX_LENGTH);
+                u64 written = 0;
+                line[line_length++] = '\n';
+                filesystem_write(&output, line_length, line, &written);
+                entry_count++;
+            }
+            offset += length;
+        } else {
+            break;
+        }
+    }
+    if (offset < read) {
+        KWARN("log_binary_decode - '%s' is truncated or damaged; decoded %u entries before the damage.", input_path, entry_count);
+    }
+
+    for (u32 i = 0; i < formats.count; ++i) {
+        char* format = *(char**)flat_map_value_at(&formats, i);
+        kfree(format, string_length(format) + 1, MEMORY_TAG_STRING);
+    }
+    flat_map_destroy(&formats);
+    filesystem_close(&output);
+    kfree(data, size ? size : 1, MEMORY_TAG_STRING);
+    return true;
 }
 
 void report_assertion_failure(const char* expression, const char* message, const char* file, i32 line) {
     log_output(LOG_LEVEL_FATAL, "Assertion Failure: %s, message: '%s', in file: %s, line: %d\n", expression, message, file, line);
-}
\ No newline at end of file
+}
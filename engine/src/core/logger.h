@@ -2,6 +2,21 @@
  * @file logger.h
  * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
  * @brief This file contains structures and logic pertaining to the logging system.
+ * @details Entries are formatted on the logging thread into a preallocated record and queued,
+ * and a background writer thread writes them to the console and to console.log in batches.
+ * Errors and fatal errors are instead written straight away, after anything queued before
+ * them, so they are not lost if the application goes down right after. Entries too long for a
+ * record, logged while the queue is full, or logged before the system starts are also written
+ * directly.
+ *
+ * Levels are filtered twice. Anything above LOG_COMPILED_LEVEL is compiled out entirely. Past
+ * that, each category has a level which can be changed at runtime, and which every log macro
+ * checks with a single compare before doing any work, arguments included.
+ *
+ * Deferred entries (KLOG_DEFERRED and the like) go further: the logging thread only records the
+ * format string and the raw arguments, and formatting happens on the writer thread. If a binary
+ * log is open, they are not formatted at all, but written as-is for log_binary_decode to turn
+ * into text offline, so detailed tracing can be left on in shipping builds.
  * @version 1.0
  *
  * 
@@ -13,20 +28,27 @@
 
 #include "defines.h"
 
+#ifndef LOG_COMPILED_LEVEL
+#if KRELEASE == 1
+/**
+ * @brief The most verbose level compiled in; anything above it costs nothing. Debug and trace
+ * are stripped from release builds unless overridden, e.g. -DLOG_COMPILED_LEVEL=5.
+ */
+#define LOG_COMPILED_LEVEL 3
+#else
+/** @brief The most verbose level compiled in; anything above it costs nothing. */
+#define LOG_COMPILED_LEVEL 5
+#endif
+#endif
+
 /** @brief Indicates if warning level logging is enabled. */
-#define LOG_WARN_ENABLED 1
+#define LOG_WARN_ENABLED (LOG_COMPILED_LEVEL >= 2)
 /** @brief Indicates if info level logging is enabled. */
-#define LOG_INFO_ENABLED 1
+#define LOG_INFO_ENABLED (LOG_COMPILED_LEVEL >= 3)
 /** @brief Indicates if debug level logging is enabled. */
-#define LOG_DEBUG_ENABLED 1
+#define LOG_DEBUG_ENABLED (LOG_COMPILED_LEVEL >= 4)
 /** @brief Indicates if trace level logging is enabled. */
-#define LOG_TRACE_ENABLED 1
-
-// Disable debug and trace logging for release builds.
-#if KRELEASE == 1
-#define LOG_DEBUG_ENABLED 0
-#define LOG_TRACE_ENABLED 0
-#endif
+#define LOG_TRACE_ENABLED (LOG_COMPILED_LEVEL >= 5)
 
 /** @brief Represents levels of logging */
 typedef enum log_level {
@@ -44,6 +66,33 @@ typedef enum log_level {
     LOG_LEVEL_TRACE = 5
 } log_level;
 
+/** @brief The areas of the engine which can have their own runtime log level. */
+typedef enum log_category {
+    /** @brief Anything not otherwise categorized. Used by KINFO, KDEBUG and the like. */
+    LOG_CATEGORY_GENERAL = 0,
+    /** @brief The core of the engine: application, events, input and the platform layer. */
+    LOG_CATEGORY_CORE,
+    /** @brief Memory allocation and allocators. */
+    LOG_CATEGORY_MEMORY,
+    /** @brief The job system. */
+    LOG_CATEGORY_JOBS,
+    /** @brief The renderer and its backends. */
+    LOG_CATEGORY_RENDERER,
+    /** @brief Resource loading and the systems managing resources. */
+    LOG_CATEGORY_RESOURCES,
+    /** @brief The game or application built on the engine. */
+    LOG_CATEGORY_GAME,
+    /** @brief The number of categories. Not a category. */
+    LOG_CATEGORY_MAX
+} log_category;
+
+/**
+ * @brief The current runtime level for each category; entries above it are skipped. Read
+ * directly by the log macros so the check is a single compare. Use log_category_level_set
+ * to change.
+ */
+KAPI extern u8 log_category_levels[LOG_CATEGORY_MAX];
+
 /**
  * @brief Initializes logging system. Call twice; once with state = 0 to get required memory size,
  * then a second time passing allocated memory to state.
@@ -55,11 +104,41 @@ typedef enum log_level {
 b8 initialize_logging(u64* memory_requirement, void* state);
 
 /**
- * @brief Shuts down the logging system.
+ * @brief Shuts down the logging system, stopping the writer thread once it has written
+ * everything queued.
  * @param state A pointer to the system state.
  */
 void shutdown_logging(void* state);
 
+/**
+ * @brief Sets the runtime level of the given category. Entries more verbose than it are
+ * skipped. Errors and fatal errors are always logged.
+ * @param category The category.
+ * @param level The most verbose level to log for the category.
+ */
+KAPI void log_category_level_set(log_category category, log_level level);
+
+/**
+ * @brief Opens a binary log to which deferred entries are written unformatted, instead of being
+ * formatted to the console and console.log. Closes any binary log already open. Requires the
+ * writer thread to be running.
+ * @param path The path of the binary log. Use log_binary_decode to turn it into text.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 log_binary_open(const char* path);
+
+/** @brief Closes the binary log, if one is open, after writing everything queued for it. */
+KAPI void log_binary_close(void);
+
+/**
+ * @brief Decodes a binary log written while log_binary_open was in effect into text, one entry
+ * per line in the same form as console.log. Does not need the logging system to be running.
+ * @param input_path The path of the binary log.
+ * @param output_path The path of the text file to write.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 log_binary_decode(const char* input_path, const char* output_path);
+
 /**
  * @brief Outputs logging at the given level.
  * @param level The log level to use.
@@ -68,6 +147,53 @@ void shutdown_logging(void* state);
  */
 KAPI void log_output(log_level level, const char* message, ...);
 
+/**
+ * @brief Outputs a deferred log entry at the given level. Only the format string pointer and the
+ * arguments are recorded here; formatting happens on the writer thread, or offline. The format
+ * string must therefore outlive the logger, as string literals do. String arguments are copied.
+ * @param category The category of the entry.
+ * @param level The log level to use.
+ * @param message The message to be logged. Must be a string literal or otherwise outlive the logger.
+ * @param ... Any formatted data that should be included in the log entry.
+ */
+KAPI void log_output_deferred(log_category category, log_level level, const char* message, ...);
+
+/**
+ * @brief Indicates if the given level is logged for the given category, at compile time if
+ * possible, and otherwise with a single compare.
+ */
+#define LOG_ENABLED(category, level) ((level) <= LOG_COMPILED_LEVEL && (level) <= log_category_levels[category])
+
+/**
+ * @brief Logs a message at the given level for the given category. Neither the message nor its
+ * arguments are evaluated unless that level is enabled.
+ * @param category The log_category of the message.
+ * @param level The log_level of the message.
+ * @param message The message to be logged. Can be a format string for additional parameters.
+ * @param ... Additional parameters to be logged.
+ */
+#define KLOG(category, level, message, ...)                  \
+    do {                                                     \
+        if (LOG_ENABLED(category, level)) {                  \
+            log_output(level, message, ##__VA_ARGS__);       \
+        }                                                    \
+    } while (0);
+
+/**
+ * @brief Logs a deferred message at the given level for the given category. Only the format
+ * string and arguments are captured on the calling thread. See log_output_deferred.
+ * @param category The log_category of the message.
+ * @param level The log_level of the message.
+ * @param message The message to be logged, which must be a string literal.
+ * @param ... Additional parameters to be logged.
+ */
+#define KLOG_DEFERRED(category, level, message, ...)                             \
+    do {                                                                         \
+        if (LOG_ENABLED(category, level)) {                                      \
+            log_output_deferred(category, level, message, ##__VA_ARGS__);        \
+        }                                                                        \
+    } while (0);
+
 /** 
  * @brief Logs a fatal-level message. Should be used to stop the application when hit.
  * @param message The message to be logged. Can be a format string for additional parameters.
@@ -77,79 +203,57 @@ KAPI void log_output(log_level level, const char* message, ...);
 
 #ifndef KERROR
 /** 
- * @brief Logs an error-level message. Should be used to indicate critical runtime problems 
+ * @brief Logs an error-level message. Should be used to indicate critical runtime problems
  * that cause the application to run improperly or not at all.
- * @param message The message to be logged.
- * @param ... Any formatted data that should be included in the log entry.
+ * @param message The message to be logged. Can be a format string for additional parameters.
+ * @param ... Additional parameters to be logged.
  */
 #define KERROR(message, ...) log_output(LOG_LEVEL_ERROR, message, ##__VA_ARGS__);
 #endif
 
-#if LOG_WARN_ENABLED == 1
 /** 
  * @brief Logs a warning-level message. Should be used to indicate non-critial problems with 
  * the application that cause it to run suboptimally.
  * @param message The message to be logged.
  * @param ... Any formatted data that should be included in the log entry.
  */
-#define KWARN(message, ...) log_output(LOG_LEVEL_WARN, message, ##__VA_ARGS__);
-#else
-/** 
- * @brief Logs a warning-level message. Should be used to indicate non-critial problems with 
- * the application that cause it to run suboptimally. Does nothing when LOG_WARN_ENABLED != 1
- * @param message The message to be logged.
- * @param ... Any formatted data that should be included in the log entry.
- */
-#define KWARN(message, ...)
-#endif
+#define KWARN(message, ...) KLOG(LOG_CATEGORY_GENERAL, LOG_LEVEL_WARN, message, ##__VA_ARGS__)
 
-#if LOG_INFO_ENABLED == 1
-/** 
- * @brief Logs an info-level message. Should be used for non-erronuous informational purposes.
- * @param message The message to be logged.
- * @param ... Any formatted data that should be included in the log entry.
- */
-#define KINFO(message, ...) log_output(LOG_LEVEL_INFO, message, ##__VA_ARGS__);
-#else
 /** 
  * @brief Logs an info-level message. Should be used for non-erronuous informational purposes.
- * Does nothing when LOG_INFO_ENABLED != 1
  * @param message The message to be logged.
  * @param ... Any formatted data that should be included in the log entry.
  */
-#define KINFO(message, ...)
-#endif
+#define KINFO(message, ...) KLOG(LOG_CATEGORY_GENERAL, LOG_LEVEL_INFO, message, ##__VA_ARGS__)
 
-#if LOG_DEBUG_ENABLED == 1
 /** 
  * @brief Logs a debug-level message. Should be used for debugging purposes.
  * @param message The message to be logged.
  * @param ... Any formatted data that should be included in the log entry.
  */
-#define KDEBUG(message, ...) log_output(LOG_LEVEL_DEBUG, message, ##__VA_ARGS__);
-#else
+#define KDEBUG(message, ...) KLOG(LOG_CATEGORY_GENERAL, LOG_LEVEL_DEBUG, message, ##__VA_ARGS__)
+
 /** 
- * @brief Logs a debug-level message. Should be used for debugging purposes.
- * Does nothing when LOG_DEBUG_ENABLED != 1
+ * @brief Logs a trace-level message. Should be used for verbose debugging purposes.
  * @param message The message to be logged.
  * @param ... Any formatted data that should be included in the log entry.
  */
-#define KDEBUG(message, ...)
-#endif
+#define KTRACE(message, ...) KLOG(LOG_CATEGORY_GENERAL, LOG_LEVEL_TRACE, message, ##__VA_ARGS__)
 
-#if LOG_TRACE_ENABLED == 1
-/** 
- * @brief Logs a trace-level message. Should be used for verbose debugging purposes.
- * @param message The message to be logged.
+/**
+ * @brief Logs a deferred trace-level message, formatted off the calling thread. Cheap enough
+ * for hot loops. See log_output_deferred.
+ * @param category The log_category of the message.
+ * @param message The message to be logged, which must be a string literal.
  * @param ... Any formatted data that should be included in the log entry.
  */
-#define KTRACE(message, ...) log_output(LOG_LEVEL_TRACE, message, ##__VA_ARGS__);
-#else
-/** 
- * @brief Logs a trace-level message. Should be used for verbose debugging purposes.
- * Does nothing when LOG_TRACE_ENABLED != 1
- * @param message The message to be logged.
+#define KTRACE_DEFERRED(category, message, ...) KLOG_DEFERRED(category, LOG_LEVEL_TRACE, message, ##__VA_ARGS__)
+
+/**
+ * @brief Logs a deferred debug-level message, formatted off the calling thread. See
+ * log_output_deferred.
+ * @param category The log_category of the message.
+ * @param message The message to be logged, which must be a string literal.
  * @param ... Any formatted data that should be included in the log entry.
  */
-#define KTRACE(message, ...)
-#endif
+#define KDEBUG_DEFERRED(category, message, ...) KLOG_DEFERRED(category, LOG_LEVEL_DEBUG, message, ##__VA_ARGS__)
@@ -1,7 +1,32 @@
 #include "metrics.h"
 #include "core/kmemory.h"
+#include "core/kstring.h"
+#include "systems/job_system.h"
 
 #define AVG_COUNT 30
+// A frame is a hitch if it takes this many times longer than the average frame before it.
+#define HITCH_FACTOR 2.0
+// The number of frames needed in the window before hitches are looked for.
+#define HITCH_MIN_FRAMES 30
+// The most names GPU times can be recorded for.
+#define MAX_GPU_TIMINGS 16
+
+typedef struct gpu_timing {
+    const char* name;
+    f64 ms_times[AVG_COUNT];
+    u8 counter;
+    u8 sample_count;
+    f64 ms_avg;
+} gpu_timing;
+
+typedef struct frame_sample {
+    f64 frame_ms;
+    f64 update_ms;
+    f64 render_ms;
+    f64 gpu_ms;
+    f64 sleep_ms;
+    b8 hitch;
+} frame_sample;
 
 typedef struct metrics_state {
     u8 frame_avg_counter;
@@ -10,6 +35,25 @@ typedef struct metrics_state {
     i32 frames;
     f64 accumulated_frame_ms;
     f64 fps;
+
+    u8 job_thread_count;
+    // Job thread busy/elapsed times as of the last sample, in microseconds.
+    u64 job_busy_us[JOB_MAX_THREAD_COUNT];
+    u64 job_elapsed_us[JOB_MAX_THREAD_COUNT];
+    // Job thread utilization over the last sample period, as a percentage.
+    f64 job_utilization[JOB_MAX_THREAD_COUNT];
+    f64 job_utilization_avg;
+
+    u8 gpu_timing_count;
+    gpu_timing gpu_timings[MAX_GPU_TIMINGS];
+    // GPU time recorded since the last update.
+    f64 gpu_frame_ms;
+
+    // A ring of the most recent frames.
+    frame_sample samples[METRICS_FRAME_WINDOW];
+    u32 frame_head;
+    u32 frame_count;
+    u64 total_hitch_count;
 } metrics_state;
 
 static metrics_state* state_ptr = 0;
@@ -17,18 +61,73 @@ static metrics_state* state_ptr = 0;
 void metrics_initialize() {
     if (!state_ptr) {
         state_ptr = kallocate(sizeof(metrics_state), MEMORY_TAG_APPLICATION);
+    } else {
+        kzero_memory(state_ptr, sizeof(metrics_state));
+    }
+}
+
+static void metrics_sample_jobs() {
+    job_system_stats stats;
+    job_system_stats_get(&stats);
+
+    state_ptr->job_thread_count = stats.thread_count;
+    u64 total_busy = 0;
+    u64 total_elapsed = 0;
+    for (u8 i = 0; i < stats.thread_count; ++i) {
+        job_thread_stats* thread = &stats.threads[i];
+        u64 busy = thread->busy_time_us - state_ptr->job_busy_us[i];
+        u64 elapsed = thread->elapsed_time_us - state_ptr->job_elapsed_us[i];
+        state_ptr->job_utilization[i] = elapsed ? (busy * 100.0) / elapsed : 0;
+        state_ptr->job_busy_us[i] = thread->busy_time_us;
+        state_ptr->job_elapsed_us[i] = thread->elapsed_time_us;
+        total_busy += busy;
+        total_elapsed += elapsed;
+    }
+    state_ptr->job_utilization_avg = total_elapsed ? (total_busy * 100.0) / total_elapsed : 0;
+}
+
+static void metrics_record_frame(f64 frame_ms, f64 update_time, f64 render_time, f64 sleep_time) {
+    frame_sample* sample = &state_ptr->samples[state_ptr->frame_head];
+    sample->frame_ms = frame_ms;
+    sample->update_ms = update_time * 1000.0;
+    sample->render_ms = render_time * 1000.0;
+    sample->sleep_ms = sleep_time * 1000.0;
+    sample->gpu_ms = state_ptr->gpu_frame_ms;
+    state_ptr->gpu_frame_ms = 0;
+
+    // Compare against the average of the frames already in the window.
+    sample->hitch = false;
+    if (state_ptr->frame_count >= HITCH_MIN_FRAMES) {
+        f64 total = 0;
+        for (u32 i = 0; i < state_ptr->frame_count; ++i) {
+            if (i != state_ptr->frame_head) {
+                total += state_ptr->samples[i].frame_ms;
+            }
+        }
+        u32 previous_count = state_ptr->frame_count == METRICS_FRAME_WINDOW ? state_ptr->frame_count - 1 : state_ptr->frame_count;
+        if (frame_ms > HITCH_FACTOR * (total / previous_count)) {
+            sample->hitch = true;
+            state_ptr->total_hitch_count++;
+        }
+    }
+
+    state_ptr->frame_head = (state_ptr->frame_head + 1) % METRICS_FRAME_WINDOW;
+    if (state_ptr->frame_count < METRICS_FRAME_WINDOW) {
+        state_ptr->frame_count++;
     }
 }
 
-void metrics_update(f64 frame_elapsed_time) {
+void metrics_update(f64 frame_elapsed_time, f64 update_time, f64 render_time, f64 sleep_time) {
     if (!state_ptr) {
         return;
     }
 
     // Calculate frame ms average
     f64 frame_ms = (frame_elapsed_time * 1000.0);
+    metrics_record_frame(frame_ms, update_time, render_time, sleep_time);
     state_ptr->ms_times[state_ptr->frame_avg_counter] = frame_ms;
     if (state_ptr->frame_avg_counter == AVG_COUNT - 1) {
+        state_ptr->ms_avg = 0;
         for (u8 i = 0; i < AVG_COUNT; ++i) {
             state_ptr->ms_avg += state_ptr->ms_times[i];
         }
@@ -44,12 +143,69 @@ void metrics_update(f64 frame_elapsed_time) {
         state_ptr->fps = state_ptr->frames;
         state_ptr->accumulated_frame_ms -= 1000;
         state_ptr->frames = 0;
+
+        // Job threads are sampled at the same rate.
+        metrics_sample_jobs();
     }
 
     // Count all frames.
     state_ptr->frames++;
 }
 
+// The value the given fraction of the sorted values are no greater than.
+static f64 percentile(const f64* sorted, u32 count, f64 fraction) {
+    u32 rank = (u32)(fraction * count + 0.999999);
+    rank = KCLAMP(rank, 1, count);
+    return sorted[rank - 1];
+}
+
+void metrics_frame_stats_get(frame_stats* out_stats) {
+    kzero_memory(out_stats, sizeof(frame_stats));
+    if (!state_ptr || state_ptr->frame_count == 0) {
+        return;
+    }
+
+    u32 count = state_ptr->frame_count;
+    f64 sorted[METRICS_FRAME_WINDOW];
+    for (u32 i = 0; i < count; ++i) {
+        const frame_sample* sample = &state_ptr->samples[i];
+        out_stats->frame_avg_ms += sample->frame_ms;
+        out_stats->update_avg_ms += sample->update_ms;
+        out_stats->render_avg_ms += sample->render_ms;
+        out_stats->gpu_avg_ms += sample->gpu_ms;
+        out_stats->sleep_avg_ms += sample->sleep_ms;
+        out_stats->hitch_count += sample->hitch;
+
+        // Insertion sort, as the window is small.
+        f64 value = sample->frame_ms;
+        u32 j = i;
+        for (; j > 0 && sorted[j - 1] > value; --j) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = value;
+    }
+
+    out_stats->frame_count = count;
+    out_stats->frame_avg_ms /= count;
+    out_stats->update_avg_ms /= count;
+    out_stats->render_avg_ms /= count;
+    out_stats->gpu_avg_ms /= count;
+    out_stats->sleep_avg_ms /= count;
+    out_stats->frame_p50_ms = percentile(sorted, count, 0.50);
+    out_stats->frame_p95_ms = percentile(sorted, count, 0.95);
+    out_stats->frame_p99_ms = percentile(sorted, count, 0.99);
+    out_stats->frame_max_ms = sorted[count - 1];
+    out_stats->total_hitch_count = state_ptr->total_hitch_count;
+}
+
+f64 metrics_frame_gpu_time() {
+    if (!state_ptr || !state_ptr->frame_count) {
+        return 0;
+    }
+    u32 last = (state_ptr->frame_head + METRICS_FRAME_WINDOW - 1) % METRICS_FRAME_WINDOW;
+    return state_ptr->samples[last].gpu_ms;
+}
+
 f64 metrics_fps() {
     if (!state_ptr) {
         return 0;
@@ -76,3 +232,76 @@ void metrics_frame(f64* out_fps, f64* out_frame_ms) {
     *out_fps = state_ptr->fps;
     *out_frame_ms = state_ptr->ms_avg;
 }
+
+f64 metrics_job_thread_utilization(u8 thread_index) {
+    if (!state_ptr || thread_index >= state_ptr->job_thread_count) {
+        return 0;
+    }
+
+    return state_ptr->job_utilization[thread_index];
+}
+
+f64 metrics_job_utilization() {
+    if (!state_ptr) {
+        return 0;
+    }
+
+    return state_ptr->job_utilization_avg;
+}
+
+static gpu_timing* gpu_timing_find(const char* name) {
+    for (u8 i = 0; i < state_ptr->gpu_timing_count; ++i) {
+        if (state_ptr->gpu_timings[i].name == name || strings_equal(state_ptr->gpu_timings[i].name, name)) {
+            return &state_ptr->gpu_timings[i];
+        }
+    }
+    return 0;
+}
+
+void metrics_gpu_time_record(const char* name, f64 gpu_ms) {
+    if (!state_ptr || !name) {
+        return;
+    }
+
+    gpu_timing* timing = gpu_timing_find(name);
+    if (!timing) {
+        if (state_ptr->gpu_timing_count == MAX_GPU_TIMINGS) {
+            return;
+        }
+        timing = &state_ptr->gpu_timings[state_ptr->gpu_timing_count++];
+        timing->name = name;
+    }
+
+    // Average over the last AVG_COUNT frames, or as many as have been recorded.
+    timing->ms_times[timing->counter] = gpu_ms;
+    timing->counter = (timing->counter + 1) % AVG_COUNT;
+    if (timing->sample_count < AVG_COUNT) {
+        timing->sample_count++;
+    }
+    f64 total = 0;
+    for (u8 i = 0; i < timing->sample_count; ++i) {
+        total += timing->ms_times[i];
+    }
+    timing->ms_avg = total / timing->sample_count;
+    state_ptr->gpu_frame_ms += gpu_ms;
+}
+
+f64 metrics_gpu_time(const char* name) {
+    if (!state_ptr || !name) {
+        return 0;
+    }
+
+    gpu_timing* timing = gpu_timing_find(name);
+    return timing ? timing->ms_avg : 0;
+}
+
+u32 metrics_gpu_timing_count() {
+    return state_ptr ? state_ptr->gpu_timing_count : 0;
+}
+
+const char* metrics_gpu_timing_name(u32 index) {
+    if (!state_ptr || index >= state_ptr->gpu_timing_count) {
+        return 0;
+    }
+    return state_ptr->gpu_timings[index].name;
+}
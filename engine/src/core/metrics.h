@@ -2,17 +2,66 @@
 
 #include "defines.h"
 
+/** @brief The number of most recent frames frame statistics are gathered over. */
+#define METRICS_FRAME_WINDOW 256
+
 /**
- * @brief Initializes the metrics system.
+ * @brief Statistics over the most recent frames, up to METRICS_FRAME_WINDOW of them. All times are in milliseconds.
+ */
+typedef struct frame_stats {
+    /** @brief The number of frames the statistics cover. */
+    u32 frame_count;
+    /** @brief The average time taken by a frame, not counting time spent sleeping in the frame limiter. */
+    f64 frame_avg_ms;
+    /** @brief The median frame time. */
+    f64 frame_p50_ms;
+    /** @brief The frame time 95% of frames were no slower than. */
+    f64 frame_p95_ms;
+    /** @brief The frame time 99% of frames were no slower than. */
+    f64 frame_p99_ms;
+    /** @brief The slowest frame time. */
+    f64 frame_max_ms;
+    /** @brief The average CPU time spent in the game's update. */
+    f64 update_avg_ms;
+    /** @brief The average CPU time spent in the game's render, and in building and submitting the frame. */
+    f64 render_avg_ms;
+    /** @brief The average time the GPU spent on the render views. Lags the CPU times by the number of frames in flight. */
+    f64 gpu_avg_ms;
+    /** @brief The average time spent sleeping in the frame limiter. */
+    f64 sleep_avg_ms;
+    /** @brief The number of hitches: frames taking more than twice as long as the average frame before them. */
+    u32 hitch_count;
+    /** @brief The number of hitches since the metrics system was initialized. */
+    u64 total_hitch_count;
+} frame_stats;
+
+/**
+ * @brief Initializes the metrics system, or resets it if already initialized.
  */
 KAPI void metrics_initialize();
 
 /**
- * @brief Updates metrics; should be called once per frame.
+ * @brief Updates metrics; should be called once per frame, once the frame is done.
  *
- * @param frame_elapsed_time The amount of time elapsed on the previous frame.
+ * @param frame_elapsed_time The time taken by the frame in seconds, not counting any time spent sleeping.
+ * @param update_time The time spent in the game's update, in seconds.
+ * @param render_time The time spent in the game's render, and in building and submitting the frame, in seconds.
+ * @param sleep_time The time spent sleeping in the frame limiter, in seconds.
  */
-KAPI void metrics_update(f64 frame_elapsed_time);
+KAPI void metrics_update(f64 frame_elapsed_time, f64 update_time, f64 render_time, f64 sleep_time);
+
+/**
+ * @brief Gets statistics over the most recent frames.
+ *
+ * @param out_stats A pointer to hold the statistics.
+ */
+KAPI void metrics_frame_stats_get(frame_stats* out_stats);
+
+/**
+ * @brief Returns the time the GPU spent on the most recent frame given to metrics_update, in milliseconds.
+ * Lags the CPU times by the number of frames in flight.
+ */
+KAPI f64 metrics_frame_gpu_time();
 
 /**
  * @brief Returns the running average frames per second (fps).
@@ -31,3 +80,46 @@ KAPI f64 metrics_frame_time();
  * @param out_frame_ms A pointer to hold the running average frametime in milliseconds.
  */
 KAPI void metrics_frame(f64* out_fps, f64* out_frame_ms);
+
+/**
+ * @brief Returns the percentage of time the given job thread spent running jobs, averaged over the last second.
+ *
+ * @param thread_index The index of the job thread.
+ */
+KAPI f64 metrics_job_thread_utilization(u8 thread_index);
+
+/**
+ * @brief Returns the percentage of time all job threads spent running jobs, averaged over the last second.
+ */
+KAPI f64 metrics_job_utilization();
+
+/**
+ * @brief Records the time the GPU spent on the named work, such as a render view, in a frame.
+ * Should be called once per frame for each name. Also counted towards the frame's GPU time in
+ * the next metrics_update.
+ *
+ * @param name The name of the work. Not copied, so must outlive the metrics system, as a render view's name does.
+ * @param gpu_ms The time the GPU spent on it, in milliseconds.
+ */
+KAPI void metrics_gpu_time_record(const char* name, f64 gpu_ms);
+
+/**
+ * @brief Returns the running average time the GPU spent on the named work, in milliseconds.
+ *
+ * @param name The name of the work, as given to metrics_gpu_time_record.
+ * @return The average time in milliseconds, or 0 if none has been recorded.
+ */
+KAPI f64 metrics_gpu_time(const char* name);
+
+/**
+ * @brief Returns the number of names GPU times have been recorded for.
+ */
+KAPI u32 metrics_gpu_timing_count();
+
+/**
+ * @brief Returns the name of the GPU work at the given index, in the order it was first recorded.
+ *
+ * @param index The index, below metrics_gpu_timing_count.
+ * @return The name, or 0 if the index is out of range.
+ */
+KAPI const char* metrics_gpu_timing_name(u32 index);
@@ -0,0 +1,256 @@
+#include "profiler.h"
+
+#include "core/katomic.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+#include "platform/filesystem.h"
+
+#include <stdarg.h>
+
+// The most threads zones can be recorded on. Zones closed on any others are dropped.
+#define PROFILER_MAX_THREADS 64
+// The number of zones each thread remembers. Must be a power of 2.
+#define PROFILER_RING_SIZE 65536
+// The number of the oldest zones in a ring that has wrapped which are not written, as they may
+// be overwritten while being read.
+#define PROFILER_WRAP_MARGIN 64
+#define PROFILER_THREAD_NAME_LENGTH 64
+#define PROFILER_PATH_LENGTH 512
+// The size of the buffer a capture is gathered in before being written.
+#define PROFILER_WRITE_BUFFER_SIZE KIBIBYTES(64)
+
+typedef struct profile_event {
+    const char* name;
+    f64 start;
+    f64 end;
+} profile_event;
+
+typedef struct profile_thread {
+    // Allocated by the thread when it first closes a zone in a capture.
+    profile_event* events;
+    // The number of zones ever recorded. Only written by the owning thread.
+    u64 count;
+    char name[PROFILER_THREAD_NAME_LENGTH];
+} profile_thread;
+
+typedef struct profiler_state {
+    profile_thread threads[PROFILER_MAX_THREADS];
+    // The number of thread slots claimed, which may run past PROFILER_MAX_THREADS.
+    u32 thread_count;
+    f64 capture_start;
+    // The frames left in a capture started by profiler_capture_frames.
+    u32 frames_remaining;
+    char frames_path[PROFILER_PATH_LENGTH];
+} profiler_state;
+
+// Gathers a capture's text, writing it to the file whenever the buffer fills.
+typedef struct trace_writer {
+    file_handle file;
+    char* buffer;
+    u64 length;
+    b8 failed;
+} trace_writer;
+
+static profiler_state* state_ptr;
+
+volatile b8 profiler_recording = false;
+
+// Incremented with each initialization, so that threads claim a new slot afterwards.
+static u32 profiler_generation;
+static _Thread_local profile_thread* current_profile_thread;
+static _Thread_local u32 current_profile_generation;
+
+static profile_thread* thread_get(void) {
+    if (!state_ptr) {
+        return 0;
+    }
+    if (current_profile_generation != profiler_generation) {
+        u32 index = katomic_fetch_add(&state_ptr->thread_count, 1);
+        current_profile_thread = index < PROFILER_MAX_THREADS ? &state_ptr->threads[index] : 0;
+        current_profile_generation = profiler_generation;
+        if (current_profile_thread) {
+            string_format(current_profile_thread->name, "Thread %u", index);
+        }
+    }
+    return current_profile_thread;
+}
+
+b8 profiler_initialize(u64* memory_requirement, void* state) {
+    *memory_requirement = sizeof(profiler_state);
+    if (state == 0) {
+        return true;
+    }
+
+    kzero_memory(state, sizeof(profiler_state));
+    state_ptr = state;
+    profiler_recording = false;
+    profiler_generation++;
+    profiler_thread_name_set("Main");
+    return true;
+}
+
+void profiler_shutdown(void* state) {
+    if (state_ptr) {
+        profiler_recording = false;
+        for (u32 i = 0; i < PROFILER_MAX_THREADS; ++i) {
+            if (state_ptr->threads[i].events) {
+                kfree(state_ptr->threads[i].events, sizeof(profile_event) * PROFILER_RING_SIZE, MEMORY_TAG_APPLICATION);
+            }
+        }
+        kzero_memory(state_ptr, sizeof(profiler_state));
+    }
+    state_ptr = 0;
+}
+
+void profiler_thread_name_set(const char* name) {
+    profile_thread* thread = thread_get();
+    if (thread && name) {
+        string_ncopy(thread->name, name, PROFILER_THREAD_NAME_LENGTH - 1);
+        thread->name[PROFILER_THREAD_NAME_LENGTH - 1] = 0;
+    }
+}
+
+void profiler_zone_record(const char* name, f64 start, f64 end) {
+    profile_thread* thread = thread_get();
+    if (!thread) {
+        return;
+    }
+    if (!thread->events) {
+        thread->events = kallocate(sizeof(profile_event) * PROFILER_RING_SIZE, MEMORY_TAG_APPLICATION);
+        if (!thread->events) {
+            return;
+        }
+    }
+
+    u64 count = thread->count;
+    profile_event* event = &thread->events[count & (PROFILER_RING_SIZE - 1)];
+    event->name = name;
+    event->start = start;
+    event->end = end;
+    // Publish the zone to a capture being written on another thread.
+    katomic_store_release(&thread->count, count + 1);
+}
+
+void profiler_capture_begin(void) {
+    if (!state_ptr || profiler_recording) {
+        return;
+    }
+    state_ptr->capture_start = platform_get_absolute_time();
+    katomic_store(&profiler_recording, true);
+}
+
+static void trace_flush(trace_writer* writer) {
+    if (writer->length && !writer->failed) {
+        u64 written = 0;
+        if (!filesystem_write(&writer->file, writer->length, writer->buffer, &written) || written != writer->length) {
+            writer->failed = true;
+        }
+    }
+    writer->length = 0;
+}
+
+static void trace_append(trace_writer* writer, const char* format, ...) {
+    // Leave room for the longest line written, with its names escaped.
+    if (PROFILER_WRITE_BUFFER_SIZE - writer->length < 1024) {
+        trace_flush(writer);
+    }
+    __builtin_va_list arg_ptr;
+    va_start(arg_ptr, format);
+    i32 written = string_nformat_v(writer->buffer + writer->length, PROFILER_WRITE_BUFFER_SIZE - writer->length, format, arg_ptr);
+    va_end(arg_ptr);
+    if (written > 0) {
+        writer->length = KMIN(writer->length + (u64)written, PROFILER_WRITE_BUFFER_SIZE - 1);
+    }
+}
+
+// Copies a name into dest as the contents of a JSON string.
+static void json_escape(char* dest, u32 max_length, const char* name) {
+    u32 length = 0;
+    for (const char* c = name; *c && length + 2 < max_length; ++c) {
+        if (*c == '"' || *c == '\\') {
+            dest[length++] = '\\';
+            dest[length++] = *c;
+        } else if ((u8)*c >= 0x20) {
+            dest[length++] = *c;
+        }
+    }
+    dest[length] = 0;
+}
+
+b8 profiler_capture_end(const char* path) {
+    if (!state_ptr || !profiler_recording) {
+        KERROR("profiler_capture_end called without a capture running.");
+        return false;
+    }
+    katomic_store(&profiler_recording, false);
+    f64 capture_start = state_ptr->capture_start;
+    f64 capture_end = platform_get_absolute_time();
+    state_ptr->frames_remaining = 0;
+
+    trace_writer writer = {0};
+    if (!filesystem_open(path, FILE_MODE_WRITE, false, &writer.file)) {
+        KERROR("profiler_capture_end - Unable to open '%s' for writing.", path);
+        return false;
+    }
+    writer.buffer = kallocate(PROFILER_WRITE_BUFFER_SIZE, MEMORY_TAG_STRING);
+
+    u32 thread_count = katomic_load(&state_ptr->thread_count);
+    thread_count = KMIN(thread_count, PROFILER_MAX_THREADS);
+    u64 zone_count = 0;
+    char name[256];
+    trace_append(&writer, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (u32 t = 0; t < thread_count; ++t) {
+        profile_thread* thread = &state_ptr->threads[t];
+        json_escape(name, sizeof(name), thread->name);
+        trace_append(&writer, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", t ? ",\n" : "", t, name);
+
+        u64 count = katomic_load_acquire(&thread->count);
+        if (!count) {
+            continue;
+        }
+        u64 first = count > PROFILER_RING_SIZE ? count - PROFILER_RING_SIZE + PROFILER_WRAP_MARGIN : 0;
+        for (u64 i = first; i < count; ++i) {
+            profile_event* event = &thread->events[i & (PROFILER_RING_SIZE - 1)];
+            if (event->start < capture_start || event->end > capture_end) {
+                continue;
+            }
+            json_escape(name, sizeof(name), event->name);
+            // Chrome traces are in microseconds.
+            trace_append(&writer, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                         name, t, (event->start - capture_start) * 1000000.0, (event->end - event->start) * 1000000.0);
+            zone_count++;
+        }
+    }
+    trace_append(&writer, "\n]}\n");
+    trace_flush(&writer);
+    b8 result = !writer.failed;
+
+    kfree(writer.buffer, PROFILER_WRITE_BUFFER_SIZE, MEMORY_TAG_STRING);
+    filesystem_close(&writer.file);
+    if (!result) {
+        KERROR("profiler_capture_end - Failed to write '%s'.", path);
+        return false;
+    }
+    KINFO("Wrote %llu zones over %.2fms to '%s'.", zone_count, (capture_end - capture_start) * 1000.0, path);
+    return true;
+}
+
+void profiler_capture_frames(u32 frame_count, const char* path) {
+    if (!state_ptr || profiler_recording || frame_count == 0 || !path) {
+        return;
+    }
+    string_ncopy(state_ptr->frames_path, path, PROFILER_PATH_LENGTH - 1);
+    state_ptr->frames_path[PROFILER_PATH_LENGTH - 1] = 0;
+    state_ptr->frames_remaining = frame_count;
+    profiler_capture_begin();
+}
+
+void profiler_frame_end(void) {
+    if (state_ptr && state_ptr->frames_remaining) {
+        state_ptr->frames_remaining--;
+        if (state_ptr->frames_remaining == 0) {
+            profiler_capture_end(state_ptr->frames_path);
+        }
+    }
+}
@@ -0,0 +1,124 @@
+/**
+ * @file profiler.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief A CPU profiler recording named, nested zones on every thread, which can be captured
+ * to a Chrome trace_event JSON file and opened in chrome://tracing or Perfetto.
+ * @details Each thread records the zones it closes into its own ring buffer, so recording takes
+ * no locks. Zones only cost a check of a flag unless a capture is running, and KPROFILE_ZONE
+ * compiles out entirely when KPROFILE_ENABLED is 0. A zone is recorded by the thread which closes it; for a
+ * fiber job resumed on another thread, that is the thread it finished on. Each ring holds the
+ * most recent zones, so a capture too long for it keeps only its end.
+ * @version 1.0
+ *
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "platform/platform.h"
+
+#ifndef KPROFILE_ENABLED
+/** @brief Set to 0 to compile out every KPROFILE_ZONE. */
+#define KPROFILE_ENABLED 1
+#endif
+
+/** @brief A zone being timed. Use KPROFILE_ZONE, or profiler_zone_begin and profiler_zone_end. */
+typedef struct profile_zone {
+    /** @brief The name of the zone. Must outlive any capture it is recorded in, as literals do. */
+    const char* name;
+    /** @brief The time the zone began, or 0 if it is not being recorded. */
+    f64 start;
+} profile_zone;
+
+/** @brief Set while a capture is running. Read by the zone functions so that they cost one check otherwise. */
+KAPI extern volatile b8 profiler_recording;
+
+/**
+ * @brief Initializes the profiler. Call twice; once with state = 0 to get required memory size,
+ * then a second time passing allocated memory to state. Names the calling thread "Main".
+ *
+ * @param memory_requirement A pointer to hold the required memory size of internal state.
+ * @param state 0 if just requesting memory requirement, otherwise allocated block of memory.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 profiler_initialize(u64* memory_requirement, void* state);
+
+/**
+ * @brief Shuts the profiler down, ending any capture without writing it.
+ * @param state A pointer to the system state.
+ */
+KAPI void profiler_shutdown(void* state);
+
+/**
+ * @brief Names the calling thread in captures.
+ * @param name The name, which is copied.
+ */
+KAPI void profiler_thread_name_set(const char* name);
+
+/** @brief Starts recording zones on every thread. Does nothing if a capture is already running. */
+KAPI void profiler_capture_begin(void);
+
+/**
+ * @brief Stops recording, and writes every zone recorded since profiler_capture_begin to the given file.
+ * @param path The path of the Chrome trace_event JSON file to write.
+ * @return True if the file was written; otherwise false.
+ */
+KAPI b8 profiler_capture_end(const char* path);
+
+/**
+ * @brief Starts a capture which ends by itself after the given number of frames, and is then
+ * written to the given file.
+ * @param frame_count The number of frames to capture.
+ * @param path The path of the Chrome trace_event JSON file to write. Copied.
+ */
+KAPI void profiler_capture_frames(u32 frame_count, const char* path);
+
+/** @brief Marks the end of a frame, ending any capture started with profiler_capture_frames once it has run its course. */
+KAPI void profiler_frame_end(void);
+
+/**
+ * @brief Records a closed zone on the calling thread. Use profiler_zone_end instead.
+ * @param name The name of the zone.
+ * @param start The time the zone began.
+ * @param end The time the zone ended.
+ */
+KAPI void profiler_zone_record(const char* name, f64 start, f64 end);
+
+/**
+ * @brief Begins timing a zone. Must be matched with profiler_zone_end on the same zone.
+ * @param name The name of the zone, which must outlive any capture, as literals do.
+ * @return The zone.
+ */
+KINLINE profile_zone profiler_zone_begin(const char* name) {
+    profile_zone zone;
+    zone.name = name;
+    zone.start = profiler_recording ? platform_get_absolute_time() : 0;
+    return zone;
+}
+
+/**
+ * @brief Ends timing a zone, recording it if a capture was running when it began.
+ * @param zone A pointer to the zone.
+ */
+KINLINE void profiler_zone_end(profile_zone* zone) {
+    if (zone->start != 0) {
+        profiler_zone_record(zone->name, zone->start, platform_get_absolute_time());
+    }
+}
+
+#define KPROFILE_CONCAT_INNER(a, b) a##b
+#define KPROFILE_CONCAT(a, b) KPROFILE_CONCAT_INNER(a, b)
+
+#if KPROFILE_ENABLED == 1
+/**
+ * @brief Times the rest of the enclosing scope as a zone with the given name, which must be a
+ * string literal.
+ */
+#define KPROFILE_ZONE(name) \
+    profile_zone KPROFILE_CONCAT(profile_zone_, __LINE__) __attribute__((cleanup(profiler_zone_end))) = profiler_zone_begin(name)
+#else
+#define KPROFILE_ZONE(name)
+#endif
@@ -0,0 +1,194 @@
+#include "startup_graph.h"
+
+#include "core/logger.h"
+#include "core/katomic.h"
+#include "core/profiler.h"
+#include "platform/platform.h"
+#include "systems/job_system.h"
+
+typedef struct startup_stage_job_params {
+    startup_stage* stage;
+    // The time the graph started, which stage times are relative to.
+    f64 graph_start_time;
+} startup_stage_job_params;
+
+// Where a run of a graph has got to.
+typedef struct startup_graph_progress {
+    const startup_graph* graph;
+    // Bit i is set once stage i has been started.
+    u64 started_mask;
+    // Bit i is set once stage i has been seen to have finished.
+    u64 finished_mask;
+} startup_graph_progress;
+
+static void startup_stage_execute(startup_stage* stage, f64 graph_start_time) {
+    profile_zone zone = profiler_zone_begin(stage->name);
+    f64 start = platform_get_absolute_time();
+    stage->start_time = start - graph_start_time;
+    stage->succeeded = stage->run(stage->user_data);
+    stage->duration = platform_get_absolute_time() - start;
+    profiler_zone_end(&zone);
+    // Published last, so that the results above are visible to whoever sees it finished.
+    katomic_store_release(&stage->finished, true);
+}
+
+static b8 startup_stage_job_start(void* params, void* result_data) {
+    startup_stage_job_params* typed_params = params;
+    startup_stage_execute(typed_params->stage, typed_params->graph_start_time);
+    return typed_params->stage->succeeded;
+}
+
+// Met once any started stage has finished but not been taken account of by the graph yet.
+static b8 startup_graph_has_unseen_finish(void* user_data) {
+    const startup_graph_progress* progress = user_data;
+    u64 running = progress->started_mask & ~progress->finished_mask;
+    for (u32 i = 0; i < progress->graph->stage_count; ++i) {
+        if ((running & (1ull << i)) && katomic_load_acquire(&progress->graph->stages[i].finished)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+u32 startup_graph_add(startup_graph* graph, const char* name, pfn_startup_stage run, void* user_data, startup_stage_thread thread, u32 dependency_count, const u32* dependencies) {
+    if (!graph || !run) {
+        KERROR("startup_graph_add requires a valid graph and run function.");
+        return INVALID_ID;
+    }
+    if (graph->stage_count >= STARTUP_GRAPH_MAX_STAGES) {
+        KERROR("Startup graph is full; stage '%s' can not be added.", name);
+        return INVALID_ID;
+    }
+
+    u64 dependency_mask = 0;
+    for (u32 i = 0; i < dependency_count; ++i) {
+        if (dependencies[i] >= graph->stage_count) {
+            KERROR("Startup stage '%s' depends on a stage which has not been added.", name);
+            return INVALID_ID;
+        }
+        dependency_mask |= 1ull << dependencies[i];
+    }
+
+    u32 index = graph->stage_count++;
+    startup_stage* stage = &graph->stages[index];
+    stage->name = name;
+    stage->run = run;
+    stage->user_data = user_data;
+    stage->thread = thread;
+    stage->dependency_mask = dependency_mask;
+    stage->started = false;
+    stage->finished = false;
+    stage->succeeded = false;
+    stage->start_time = 0;
+    stage->duration = 0;
+    return index;
+}
+
+b8 startup_graph_run(startup_graph* graph) {
+    if (!graph) {
+        return false;
+    }
+
+    f64 graph_start_time = platform_get_absolute_time();
+    u64 all_mask = graph->stage_count >= 64 ? ~0ull : ((1ull << graph->stage_count) - 1);
+    startup_graph_progress progress = {graph, 0, 0};
+    u64* started_mask = &progress.started_mask;
+    u64* finished_mask = &progress.finished_mask;
+    b8 failed = false;
+
+    for (;;) {
+        // Take account of stages which have finished, on this thread or job threads.
+        for (u32 i = 0; i < graph->stage_count; ++i) {
+            u64 bit = 1ull << i;
+            if ((*started_mask & bit) && !(*finished_mask & bit) && katomic_load_acquire(&graph->stages[i].finished)) {
+                *finished_mask |= bit;
+                if (!graph->stages[i].succeeded) {
+                    KERROR("Startup stage '%s' failed.", graph->stages[i].name);
+                    failed = true;
+                }
+            }
+        }
+
+        if (*finished_mask == all_mask) {
+            break;
+        }
+
+        b8 running = (*started_mask & ~*finished_mask) != 0;
+        if (failed) {
+            if (!running) {
+                break;
+            }
+            job_system_wait_for(startup_graph_has_unseen_finish, &progress);
+            continue;
+        }
+
+        // Hand out every stage which can run anywhere and is ready first, so that they run alongside
+        // the main thread stage below.
+        startup_stage* main_stage = 0;
+        for (u32 i = 0; i < graph->stage_count; ++i) {
+            startup_stage* stage = &graph->stages[i];
+            u64 bit = 1ull << i;
+            if ((*started_mask & bit) || (stage->dependency_mask & ~*finished_mask)) {
+                continue;
+            }
+            if (stage->thread == STARTUP_STAGE_THREAD_MAIN) {
+                if (!main_stage) {
+                    main_stage = stage;
+                }
+                continue;
+            }
+
+            *started_mask |= bit;
+            stage->started = true;
+            startup_stage_job_params params = {stage, graph_start_time};
+            job_info job = job_create_priority(startup_stage_job_start, 0, 0, &params, sizeof(startup_stage_job_params), 0, JOB_TYPE_GENERAL, JOB_PRIORITY_HIGH);
+            job_system_submit(job);
+            running = true;
+        }
+
+        if (main_stage) {
+            u32 index = (u32)(main_stage - graph->stages);
+            *started_mask |= 1ull << index;
+            main_stage->started = true;
+            startup_stage_execute(main_stage, graph_start_time);
+            // Taken account of at the top of the loop, along with any that finished meanwhile.
+            continue;
+        }
+
+        if (!running) {
+            // Not reachable, as stages can only depend on ones added before them.
+            KERROR("Startup graph has stages which can never run.");
+            failed = true;
+            break;
+        }
+
+        // Nothing to do on this thread until a running stage finishes. Helps with other jobs in the meantime.
+        job_system_wait_for(startup_graph_has_unseen_finish, &progress);
+    }
+
+    graph->total_time = platform_get_absolute_time() - graph_start_time;
+    return !failed;
+}
+
+void startup_graph_report(const startup_graph* graph) {
+    if (!graph) {
+        return;
+    }
+
+    f64 serial_time = 0;
+    for (u32 i = 0; i < graph->stage_count; ++i) {
+        const startup_stage* stage = &graph->stages[i];
+        if (!stage->started) {
+            KINFO("  %-24s not run", stage->name);
+            continue;
+        }
+        serial_time += stage->duration;
+        KINFO("  %-24s %8.2fms at %8.2fms%s%s",
+              stage->name,
+              stage->duration * 1000.0,
+              stage->start_time * 1000.0,
+              stage->thread == STARTUP_STAGE_THREAD_ANY ? " (job)" : "",
+              stage->succeeded ? "" : " FAILED");
+    }
+    KINFO("Startup took %.2fms, against %.2fms for its stages one after another.", graph->total_time * 1000.0, serial_time * 1000.0);
+}
@@ -0,0 +1,105 @@
+/**
+ * @file startup_graph.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief This file contains a dependency graph of startup stages, such as standing up engine
+ * systems, which runs independent stages at the same time and times each one.
+ * @details Each stage is flagged as either needing the main thread, such as anything creating
+ * GPU resources or registering for events, or being able to run anywhere. Main thread stages
+ * are run in turn on the thread running the graph, while stages which can run anywhere are
+ * submitted to the job system as soon as everything they depend on has finished. Those must
+ * therefore depend, directly or otherwise, on a stage which stands up the job system.
+ * @version 1.0
+ *
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief The most stages a graph can hold. */
+#define STARTUP_GRAPH_MAX_STAGES 64
+
+/**
+ * @brief A function pointer definition for a startup stage.
+ * @param user_data The data given when the stage was added.
+ * @returns True on success; otherwise false, which fails the graph.
+ */
+typedef b8 (*pfn_startup_stage)(void* user_data);
+
+/** @brief Where a startup stage may run. */
+typedef enum startup_stage_thread {
+    /** @brief Run on the thread running the graph. */
+    STARTUP_STAGE_THREAD_MAIN,
+    /** @brief Run on any job thread, alongside other stages. */
+    STARTUP_STAGE_THREAD_ANY
+} startup_stage_thread;
+
+/** @brief A single stage of a startup graph. */
+typedef struct startup_stage {
+    /** @brief The name of the stage, for reporting. Not copied. */
+    const char* name;
+    /** @brief The function which performs the stage. */
+    pfn_startup_stage run;
+    /** @brief Data to be passed to run. */
+    void* user_data;
+    /** @brief Where the stage may run. */
+    startup_stage_thread thread;
+    /** @brief Bit i is set if the stage depends on the stage at index i. */
+    u64 dependency_mask;
+
+    /** @brief Indicates if the stage has been started. Set by the graph. */
+    b8 started;
+    /** @brief Set once the stage has finished, from whichever thread ran it. */
+    b8 finished;
+    /** @brief Indicates if the stage succeeded. Only valid once finished. */
+    b8 succeeded;
+    /** @brief The time the stage started, relative to the start of the graph, in seconds. */
+    f64 start_time;
+    /** @brief How long the stage took, in seconds. */
+    f64 duration;
+} startup_stage;
+
+/** @brief A graph of startup stages. Zero-initialize before adding stages. */
+typedef struct startup_graph {
+    /** @brief The number of stages added. */
+    u32 stage_count;
+    /** @brief The stages, in the order they were added. */
+    startup_stage stages[STARTUP_GRAPH_MAX_STAGES];
+    /** @brief How long the whole graph took to run, in seconds. */
+    f64 total_time;
+} startup_graph;
+
+/**
+ * @brief Adds a stage to the graph. A stage can only depend on stages added before it, so
+ * the graph can never hold a cycle.
+ *
+ * @param graph A pointer to the graph.
+ * @param name The name of the stage, for reporting. Not copied, so should be a literal.
+ * @param run A pointer to the function which performs the stage. Required.
+ * @param user_data Data to be passed to run. Optional.
+ * @param thread Where the stage may run.
+ * @param dependency_count The number of stages this one depends on.
+ * @param dependencies The indices of the stages this one depends on, as returned by this function.
+ * @return The index of the stage, or INVALID_ID if the graph is full or a dependency is invalid.
+ */
+KAPI u32 startup_graph_add(startup_graph* graph, const char* name, pfn_startup_stage run, void* user_data, startup_stage_thread thread, u32 dependency_count, const u32* dependencies);
+
+/**
+ * @brief Runs every stage in the graph, each after all of the stages it depends on. If a stage
+ * fails, no further stages are started, and any already running are waited on before returning.
+ *
+ * @param graph A pointer to the graph.
+ * @return True if every stage succeeded; otherwise false.
+ */
+KAPI b8 startup_graph_run(startup_graph* graph);
+
+/**
+ * @brief Logs when each stage of a graph that has been run started and how long it took,
+ * along with the total time taken and the time the stages would have taken one after another.
+ *
+ * @param graph A pointer to the graph.
+ */
+KAPI void startup_graph_report(const startup_graph* graph);
@@ -218,6 +218,12 @@ STATIC_ASSERT(sizeof(f64) == 8, "Expected f64 to be 8 bytes.");
 /** @brief Gets the number of bytes from amount of kibibytes (KiB) (1024) */
 #define KIBIBYTES(amount) (amount * 1024)
 
+/**
+ * @brief The assumed size of a CPU cache line in bytes. Data written by different
+ * threads should be kept at least this far apart to avoid false sharing.
+ */
+#define KCACHE_LINE_SIZE 64
+
 /** @brief Gets the number of bytes from amount of gigabytes (GB) (1000*1000*1000) */
 #define GIGABYTES(amount) (amount * 1000 * 1000 * 1000)
 /** @brief Gets the number of bytes from amount of megabytes (MB) (1000*1000) */
@@ -29,9 +29,11 @@ extern b8 create_game(game* out_game);
 
 /**
  * @brief The main entry point of the application.
+ * @param argc The number of command line arguments.
+ * @param argv The command line arguments. See benchmark_config_parse and render_replay_config_parse for those recognized.
  * @returns 0 on successful execution; nonzero on error.
  */
-int main(void) {
+int main(int argc, char** argv) {
     // Request the game instance from the application.
     game game_inst;
     if (!create_game(&game_inst)) {
@@ -39,6 +41,11 @@ int main(void) {
         return -1;
     }
 
+    // Run a benchmark if asked to on the command line.
+    benchmark_config_parse(argc, argv, &game_inst.app_config.benchmark);
+    // Or replay a render capture.
+    render_replay_config_parse(argc, argv, &game_inst.app_config.replay);
+
     // Ensure the function pointers exist.
     if (!game_inst.render || !game_inst.update || !game_inst.initialize || !game_inst.on_resize) {
         KFATAL("The game's function pointers must be assigned!");
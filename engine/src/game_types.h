@@ -12,7 +12,7 @@
 #pragma once
 
 #include "core/application.h"
-#include "memory/linear_allocator.h"
+#include "memory/frame_arena.h"
 
 struct render_packet;
 
@@ -52,6 +52,19 @@ typedef struct game {
      * */
     b8 (*update)(struct game* game_inst, f32 delta_time);
 
+    /**
+     * @brief Function pointer to the game's fixed step function, called at app_config.fixed_update_rate
+     * however fast frames run, so what it simulates is not tied to the frame rate. Optional.
+     * Called before update, as many times as the time since the last frame holds steps. If
+     * app_config.pipelined_simulation is set, called on a job thread while the frame is drawn
+     * instead, so must then only touch simulated state, which update and render do not read
+     * until the steps are complete.
+     * @param game_inst A pointer to the game instance.
+     * @param step_time The length of a step in seconds.
+     * @returns True on success; otherwise false.
+     * */
+    b8 (*fixed_update)(struct game* game_inst, f32 step_time);
+
     /** 
      * @brief Function pointer to game's render function. 
      * @param game_inst A pointer to the game instance.
@@ -84,12 +97,18 @@ typedef struct game {
     /** @brief A block of memory to hold the application state. Created and managed by the engine. */
     void* application_state;
 
-    /** 
-     * @brief An allocator used for allocations needing to be made every frame. Contents are wiped
-     * at the beginning of the frame.
+    /**
+     * @brief An arena used for allocations needing to be made every frame. Holds one buffer per
+     * frame in flight, the current one of which is wiped at the beginning of the frame.
      */
-    linear_allocator frame_allocator;
+    frame_arena frame_arena;
 
     /** @brief Data which is built up, used and discarded every frame. */
     game_frame_data frame_data;
+
+    /**
+     * @brief How far the frame falls past the last fixed step, from 0 up to 1 step, for simulated
+     * state to be blended between its last two steps by. Set before each update.
+     */
+    f32 fixed_step_alpha;
 } game;
\ No newline at end of file
@@ -0,0 +1,483 @@
+#include "bvh.h"
+
+#include "geometry_utils.h"
+#include "kmath.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+// Set in entries of the frustum query's stack whose nodes are wholly inside, so need no testing.
+#define STACK_INSIDE 0x80000000u
+
+// The most nodes a query has waiting at once. A balanced tree of 2^31 nodes is under 64 deep, and a
+// query never has more than one waiting node per level.
+#define STACK_CAPACITY 128
+
+static b8 is_leaf(const bvh_node* node) {
+    return node->child_a == INVALID_ID;
+}
+
+static f32 surface_area(extents_3d e) {
+    f32 x = e.max.x - e.min.x;
+    f32 y = e.max.y - e.min.y;
+    f32 z = e.max.z - e.min.z;
+    return 2.0f * (x * y + y * z + z * x);
+}
+
+static b8 extents_contain(extents_3d outer, extents_3d inner) {
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+           outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+static b8 extents_overlap(extents_3d a, extents_3d b) {
+    return a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y && a.max.y >= b.min.y &&
+           a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+static b8 leaf_exists(const bvh* tree, u32 leaf_id) {
+    return tree && tree->nodes && leaf_id < tree->node_capacity && tree->nodes[leaf_id].height == 0;
+}
+
+static u32 node_allocate(bvh* tree) {
+    u32 index = tree->free_head;
+    bvh_node* node = &tree->nodes[index];
+    tree->free_head = node->parent;
+    node->parent = INVALID_ID;
+    node->child_a = INVALID_ID;
+    node->child_b = INVALID_ID;
+    node->value = INVALID_ID;
+    node->height = 0;
+    return index;
+}
+
+static void node_free(bvh* tree, u32 index) {
+    tree->nodes[index].parent = tree->free_head;
+    tree->nodes[index].height = -1;
+    tree->free_head = index;
+}
+
+// Points whichever child of the parent of old_child was old_child at new_child instead, or the root.
+static void child_replace(bvh* tree, u32 parent, u32 old_child, u32 new_child) {
+    if (parent == INVALID_ID) {
+        tree->root = new_child;
+    } else if (tree->nodes[parent].child_a == old_child) {
+        tree->nodes[parent].child_a = new_child;
+    } else {
+        tree->nodes[parent].child_b = new_child;
+    }
+}
+
+// If one child of the node is more than one taller than the other, rotates the taller up in its place.
+// Returns the node now where the given one was.
+static u32 balance(bvh* tree, u32 ia) {
+    bvh_node* nodes = tree->nodes;
+    bvh_node* a = &nodes[ia];
+    if (is_leaf(a) || a->height < 2) {
+        return ia;
+    }
+
+    u32 ib = a->child_a;
+    u32 ic = a->child_b;
+    bvh_node* b = &nodes[ib];
+    bvh_node* c = &nodes[ic];
+    i32 difference = c->height - b->height;
+
+    if (difference > 1) {
+        // c takes the place of a, which takes the place of c's shorter child.
+        u32 i_f = c->child_a;
+        u32 ig = c->child_b;
+        bvh_node* f = &nodes[i_f];
+        bvh_node* g = &nodes[ig];
+        c->child_a = ia;
+        c->parent = a->parent;
+        a->parent = ic;
+        child_replace(tree, c->parent, ia, ic);
+        if (f->height > g->height) {
+            c->child_b = i_f;
+            a->child_b = ig;
+            g->parent = ia;
+            a->bounds = extents_3d_merge(b->bounds, g->bounds);
+            c->bounds = extents_3d_merge(a->bounds, f->bounds);
+            a->height = 1 + KMAX(b->height, g->height);
+            c->height = 1 + KMAX(a->height, f->height);
+        } else {
+            c->child_b = ig;
+            a->child_b = i_f;
+            f->parent = ia;
+            a->bounds = extents_3d_merge(b->bounds, f->bounds);
+            c->bounds = extents_3d_merge(a->bounds, g->bounds);
+            a->height = 1 + KMAX(b->height, f->height);
+            c->height = 1 + KMAX(a->height, g->height);
+        }
+        return ic;
+    }
+
+    if (difference < -1) {
+        // b takes the place of a, which takes the place of b's shorter child.
+        u32 id = b->child_a;
+        u32 ie = b->child_b;
+        bvh_node* d = &nodes[id];
+        bvh_node* e = &nodes[ie];
+        b->child_a = ia;
+        b->parent = a->parent;
+        a->parent = ib;
+        child_replace(tree, b->parent, ia, ib);
+        if (d->height > e->height) {
+            b->child_b = id;
+            a->child_a = ie;
+            e->parent = ia;
+            a->bounds = extents_3d_merge(c->bounds, e->bounds);
+            b->bounds = extents_3d_merge(a->bounds, d->bounds);
+            a->height = 1 + KMAX(c->height, e->height);
+            b->height = 1 + KMAX(a->height, d->height);
+        } else {
+            b->child_b = ie;
+            a->child_a = id;
+            d->parent = ia;
+            a->bounds = extents_3d_merge(c->bounds, d->bounds);
+            b->bounds = extents_3d_merge(a->bounds, e->bounds);
+            a->height = 1 + KMAX(c->height, d->height);
+            b->height = 1 + KMAX(a->height, e->height);
+        }
+        return ib;
+    }
+
+    return ia;
+}
+
+// Rebalances and refits every node from the given one up to the root.
+static void ancestors_refit(bvh* tree, u32 index) {
+    while (index != INVALID_ID) {
+        index = balance(tree, index);
+        bvh_node* node = &tree->nodes[index];
+        const bvh_node* a = &tree->nodes[node->child_a];
+        const bvh_node* b = &tree->nodes[node->child_b];
+        node->height = 1 + KMAX(a->height, b->height);
+        node->bounds = extents_3d_merge(a->bounds, b->bounds);
+        index = node->parent;
+    }
+}
+
+static void leaf_insert(bvh* tree, u32 leaf) {
+    if (tree->root == INVALID_ID) {
+        tree->root = leaf;
+        tree->nodes[leaf].parent = INVALID_ID;
+        return;
+    }
+
+    // Walk down to the sibling which grows the total surface area of the tree least.
+    extents_3d leaf_bounds = tree->nodes[leaf].bounds;
+    u32 index = tree->root;
+    while (!is_leaf(&tree->nodes[index])) {
+        const bvh_node* node = &tree->nodes[index];
+        f32 area = surface_area(node->bounds);
+        f32 combined_area = surface_area(extents_3d_merge(node->bounds, leaf_bounds));
+
+        // Pairing with this node makes a new parent, and grows every ancestor.
+        f32 cost = 2.0f * combined_area;
+        f32 inheritance_cost = 2.0f * (combined_area - area);
+
+        // Descending makes a new parent lower down, growing this node and the child.
+        f32 child_costs[2];
+        u32 children[2] = {node->child_a, node->child_b};
+        for (u32 i = 0; i < 2; ++i) {
+            const bvh_node* child = &tree->nodes[children[i]];
+            f32 merged_area = surface_area(extents_3d_merge(child->bounds, leaf_bounds));
+            child_costs[i] = (is_leaf(child) ? merged_area : merged_area - surface_area(child->bounds)) + inheritance_cost;
+        }
+
+        if (cost < child_costs[0] && cost < child_costs[1]) {
+            break;
+        }
+        index = child_costs[0] < child_costs[1] ? children[0] : children[1];
+    }
+
+    // A new parent of the sibling and the leaf, in the sibling's place.
+    u32 sibling = index;
+    u32 old_parent = tree->nodes[sibling].parent;
+    u32 new_parent = node_allocate(tree);
+    bvh_node* parent = &tree->nodes[new_parent];
+    parent->parent = old_parent;
+    parent->bounds = extents_3d_merge(tree->nodes[sibling].bounds, leaf_bounds);
+    parent->height = tree->nodes[sibling].height + 1;
+    parent->child_a = sibling;
+    parent->child_b = leaf;
+    child_replace(tree, old_parent, sibling, new_parent);
+    tree->nodes[sibling].parent = new_parent;
+    tree->nodes[leaf].parent = new_parent;
+
+    ancestors_refit(tree, new_parent);
+}
+
+static void leaf_detach(bvh* tree, u32 leaf) {
+    if (leaf == tree->root) {
+        tree->root = INVALID_ID;
+        return;
+    }
+
+    // The sibling takes the place of the parent, which is no longer needed.
+    u32 parent = tree->nodes[leaf].parent;
+    u32 grandparent = tree->nodes[parent].parent;
+    u32 sibling = tree->nodes[parent].child_a == leaf ? tree->nodes[parent].child_b : tree->nodes[parent].child_a;
+    child_replace(tree, grandparent, parent, sibling);
+    tree->nodes[sibling].parent = grandparent;
+    node_free(tree, parent);
+    ancestors_refit(tree, grandparent);
+}
+
+static extents_3d extents_fatten(extents_3d e, f32 margin) {
+    vec3 m = {margin, margin, margin};
+    e.min = vec3_sub(e.min, m);
+    e.max = vec3_add(e.max, m);
+    return e;
+}
+
+b8 bvh_create(u32 leaf_capacity, f32 margin, u64* memory_requirement, void* memory, bvh* out_bvh) {
+    if (leaf_capacity == 0 || leaf_capacity >= (STACK_INSIDE >> 1)) {
+        KERROR("bvh_create requires a valid, non-zero leaf capacity. Create failed.");
+        return false;
+    }
+    if (!memory_requirement) {
+        KERROR("bvh_create requires memory_requirement to exist. Create failed.");
+        return false;
+    }
+
+    // Every leaf but the first brings a parent with it.
+    u32 node_capacity = leaf_capacity * 2;
+    *memory_requirement = sizeof(bvh_node) * node_capacity;
+
+    // If only obtaining requirement, boot out.
+    if (!memory) {
+        return true;
+    }
+    if (!out_bvh) {
+        KERROR("bvh_create requires a pointer to hold the bvh. Create failed.");
+        return false;
+    }
+
+    kzero_memory(out_bvh, sizeof(bvh));
+    out_bvh->leaf_capacity = leaf_capacity;
+    out_bvh->node_capacity = node_capacity;
+    out_bvh->margin = margin < 0.0f ? 0.0f : margin;
+    out_bvh->nodes = memory;
+    out_bvh->root = INVALID_ID;
+
+    // Every node starts out free, chained in order.
+    for (u32 i = 0; i < node_capacity; ++i) {
+        out_bvh->nodes[i].parent = i + 1 < node_capacity ? i + 1 : INVALID_ID;
+        out_bvh->nodes[i].height = -1;
+    }
+    out_bvh->free_head = 0;
+    return true;
+}
+
+void bvh_destroy(bvh* tree) {
+    if (tree) {
+        kzero_memory(tree, sizeof(bvh));
+    }
+}
+
+u32 bvh_insert(bvh* tree, extents_3d bounds, u32 value) {
+    if (!tree || !tree->nodes) {
+        KERROR("bvh_insert requires an initialized bvh.");
+        return INVALID_ID;
+    }
+    if (tree->leaf_count == tree->leaf_capacity) {
+        KERROR("bvh_insert - bvh of %u leaves is full.", tree->leaf_capacity);
+        return INVALID_ID;
+    }
+
+    u32 leaf = node_allocate(tree);
+    bvh_node* node = &tree->nodes[leaf];
+    node->tight = bounds;
+    node->bounds = extents_fatten(bounds, tree->margin);
+    node->value = value;
+    leaf_insert(tree, leaf);
+    tree->leaf_count++;
+    return leaf;
+}
+
+b8 bvh_remove(bvh* tree, u32 leaf_id) {
+    if (!leaf_exists(tree, leaf_id)) {
+        KERROR("bvh_remove - leaf %u does not exist.", leaf_id);
+        return false;
+    }
+
+    leaf_detach(tree, leaf_id);
+    node_free(tree, leaf_id);
+    tree->leaf_count--;
+    return true;
+}
+
+b8 bvh_move(bvh* tree, u32 leaf_id, extents_3d bounds) {
+    if (!leaf_exists(tree, leaf_id)) {
+        return false;
+    }
+
+    bvh_node* node = &tree->nodes[leaf_id];
+    node->tight = bounds;
+    if (extents_contain(node->bounds, bounds)) {
+        // Still within its fattened bounds, so the tree need not change.
+        return false;
+    }
+
+    leaf_detach(tree, leaf_id);
+    node->bounds = extents_fatten(bounds, tree->margin);
+    leaf_insert(tree, leaf_id);
+    return true;
+}
+
+u32 bvh_value_get(const bvh* tree, u32 leaf_id) {
+    return leaf_exists(tree, leaf_id) ? tree->nodes[leaf_id].value : INVALID_ID;
+}
+
+void bvh_query_frustum(const bvh* tree, const frustum* f, pfn_bvh_query callback, void* user_data) {
+    if (!tree || !tree->nodes || !f || !callback || tree->root == INVALID_ID) {
+        return;
+    }
+
+    u32 stack[STACK_CAPACITY];
+    u32 stack_count = 0;
+    stack[stack_count++] = tree->root;
+    while (stack_count) {
+        u32 entry = stack[--stack_count];
+        u32 index = entry & ~STACK_INSIDE;
+        b8 inside = (entry & STACK_INSIDE) != 0;
+        const bvh_node* node = &tree->nodes[index];
+
+        if (!inside) {
+            // Outside any plane culls the node; inside every one means its descendants need no testing.
+            extents_3d bounds = is_leaf(node) ? node->tight : node->bounds;
+            vec3 center = extents_3d_center(bounds);
+            vec3 half_extents = extents_3d_half_extents(bounds);
+            b8 outside = false;
+            inside = true;
+            for (u32 i = 0; i < 6; ++i) {
+                const plane_3d* p = &f->sides[i];
+                f32 r = half_extents.x * kabs(p->normal.x) + half_extents.y * kabs(p->normal.y) + half_extents.z * kabs(p->normal.z);
+                f32 d = plane_signed_distance(p, &center);
+                if (d < -r) {
+                    outside = true;
+                    break;
+                }
+                if (d < r) {
+                    inside = false;
+                }
+            }
+            if (outside) {
+                continue;
+            }
+        }
+
+        if (is_leaf(node)) {
+            if (!callback(index, node->value, user_data)) {
+                return;
+            }
+        } else if (stack_count + 2 <= STACK_CAPACITY) {
+            u32 flag = inside ? STACK_INSIDE : 0;
+            stack[stack_count++] = node->child_a | flag;
+            stack[stack_count++] = node->child_b | flag;
+        }
+    }
+}
+
+void bvh_query_extents(const bvh* tree, extents_3d bounds, pfn_bvh_query callback, void* user_data) {
+    if (!tree || !tree->nodes || !callback || tree->root == INVALID_ID) {
+        return;
+    }
+
+    u32 stack[STACK_CAPACITY];
+    u32 stack_count = 0;
+    stack[stack_count++] = tree->root;
+    while (stack_count) {
+        u32 index = stack[--stack_count];
+        const bvh_node* node = &tree->nodes[index];
+        if (!extents_overlap(is_leaf(node) ? node->tight : node->bounds, bounds)) {
+            continue;
+        }
+        if (is_leaf(node)) {
+            if (!callback(index, node->value, user_data)) {
+                return;
+            }
+        } else if (stack_count + 2 <= STACK_CAPACITY) {
+            stack[stack_count++] = node->child_a;
+            stack[stack_count++] = node->child_b;
+        }
+    }
+}
+
+void bvh_query_ray(const bvh* tree, ray r, f32 max_distance, pfn_bvh_query callback, void* user_data) {
+    if (!tree || !tree->nodes || !callback || tree->root == INVALID_ID) {
+        return;
+    }
+
+    u32 stack[STACK_CAPACITY];
+    u32 stack_count = 0;
+    stack[stack_count++] = tree->root;
+    while (stack_count) {
+        u32 index = stack[--stack_count];
+        const bvh_node* node = &tree->nodes[index];
+        f32 distance = 0.0f;
+        // Leaves are hit by their boxes as given, which lie within their fattened bounds.
+        if (!ray_intersects_extents(r, is_leaf(node) ? node->tight : node->bounds, &distance) || distance > max_distance) {
+            continue;
+        }
+        if (is_leaf(node)) {
+            if (!callback(index, node->value, user_data)) {
+                return;
+            }
+        } else if (stack_count + 2 <= STACK_CAPACITY) {
+            stack[stack_count++] = node->child_a;
+            stack[stack_count++] = node->child_b;
+        }
+    }
+}
+
+u32 bvh_raycast(const bvh* tree, ray r, f32 max_distance, f32* out_distance) {
+    if (!tree || !tree->nodes || tree->root == INVALID_ID) {
+        return INVALID_ID;
+    }
+
+    u32 nearest = INVALID_ID;
+    f32 nearest_distance = max_distance;
+    u32 stack[STACK_CAPACITY];
+    u32 stack_count = 0;
+    stack[stack_count++] = tree->root;
+    while (stack_count) {
+        u32 index = stack[--stack_count];
+        const bvh_node* node = &tree->nodes[index];
+        f32 distance = 0.0f;
+        if (!ray_intersects_extents(r, is_leaf(node) ? node->tight : node->bounds, &distance) || distance > nearest_distance) {
+            continue;
+        }
+        if (is_leaf(node)) {
+            nearest = index;
+            nearest_distance = distance;
+            continue;
+        }
+        if (stack_count + 2 > STACK_CAPACITY) {
+            continue;
+        }
+
+        // The nearer child is visited first, so the farther is more often skipped.
+        f32 distance_a = 0.0f;
+        f32 distance_b = 0.0f;
+        b8 hit_a = ray_intersects_extents(r, tree->nodes[node->child_a].bounds, &distance_a);
+        b8 hit_b = ray_intersects_extents(r, tree->nodes[node->child_b].bounds, &distance_b);
+        if (hit_a && hit_b && distance_a < distance_b) {
+            stack[stack_count++] = node->child_b;
+            stack[stack_count++] = node->child_a;
+        } else {
+            if (hit_a) {
+                stack[stack_count++] = node->child_a;
+            }
+            if (hit_b) {
+                stack[stack_count++] = node->child_b;
+            }
+        }
+    }
+
+    if (nearest != INVALID_ID && out_distance) {
+        *out_distance = nearest_distance;
+    }
+    return nearest;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file bvh.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief A dynamic bounding volume hierarchy of axis-aligned boxes, for finding what is in a
+ * frustum, hit by a ray or within a box without testing every box.
+ * @details Each leaf holds a box and a value, such as the id of what the box bounds, and is stored
+ * fattened by a margin so small moves need not change the tree. Leaves are inserted where they
+ * grow the surface area of the tree least, and the tree is kept balanced by rotations as leaves
+ * come and go, so queries visit a number of nodes roughly logarithmic in the number of leaves.
+ * Leaf ids stay valid until removed. Queries may run from several threads at once, but nothing may
+ * change the tree while they do.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "math_types.h"
+
+/**
+ * @brief Called by queries for each leaf found.
+ *
+ * @param leaf_id The id of the leaf.
+ * @param value The value of the leaf.
+ * @param user_data The user data passed to the query.
+ * @return True to carry on; false to end the query.
+ */
+typedef b8 (*pfn_bvh_query)(u32 leaf_id, u32 value, void* user_data);
+
+/** @brief A node of a bvh: a leaf, or the parent of two nodes bounding both of them. */
+typedef struct bvh_node {
+    /** @brief The bounds of the node. For leaves, the stored box fattened by the margin. */
+    extents_3d bounds;
+    /** @brief For leaves, the box as last given, which queries test leaves against. */
+    extents_3d tight;
+    /** @brief The parent of the node, or INVALID_ID for the root. For free nodes, the next free node. */
+    u32 parent;
+    /** @brief The first child, or INVALID_ID for leaves. */
+    u32 child_a;
+    /** @brief The second child, or INVALID_ID for leaves. */
+    u32 child_b;
+    /** @brief For leaves, the value given at insertion. */
+    u32 value;
+    /** @brief The height of the node above its deepest leaf, being 0 for leaves, or -1 if it is free. */
+    i32 height;
+} bvh_node;
+
+/** @brief The bvh structure. */
+typedef struct bvh {
+    /** @brief The most leaves the bvh can hold. */
+    u32 leaf_capacity;
+    /** @brief The number of leaves. */
+    u32 leaf_count;
+    /** @brief The number of nodes, enough for leaf_capacity leaves and their parents. */
+    u32 node_capacity;
+    /** @brief The root node, or INVALID_ID if empty. */
+    u32 root;
+    /** @brief The first free node, or INVALID_ID if there is none. */
+    u32 free_head;
+    /** @brief The distance leaf boxes are fattened by on every side, so they may move as far before being reinserted. */
+    f32 margin;
+    /** @brief The nodes. */
+    bvh_node* nodes;
+} bvh;
+
+/**
+ * @brief Creates a new bvh. Should be called twice; once to obtain the memory amount required
+ * (passing memory=0), and a second time with memory being set to an allocated block.
+ *
+ * @param leaf_capacity The most leaves the bvh should hold.
+ * @param margin The distance boxes are fattened by on every side. Leaves moving less than this need not be reinserted.
+ * @param memory_requirement A pointer to hold the required memory for the bvh.
+ * @param memory An allocated block of memory, or 0 if just obtaining the requirement.
+ * @param out_bvh A pointer to hold the bvh.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 bvh_create(u32 leaf_capacity, f32 margin, u64* memory_requirement, void* memory, bvh* out_bvh);
+
+/**
+ * @brief Destroys the given bvh. The memory passed at creation is not freed.
+ *
+ * @param tree A pointer to the bvh to be destroyed.
+ */
+KAPI void bvh_destroy(bvh* tree);
+
+/**
+ * @brief Inserts a leaf with the given box and value.
+ *
+ * @param tree A pointer to the bvh.
+ * @param bounds The box of the leaf.
+ * @param value The value of the leaf, passed back by queries.
+ * @return The id of the new leaf, or INVALID_ID if the bvh is full.
+ */
+KAPI u32 bvh_insert(bvh* tree, extents_3d bounds, u32 value);
+
+/**
+ * @brief Removes the given leaf. Its id may be reused by the next leaf inserted.
+ *
+ * @param tree A pointer to the bvh.
+ * @param leaf_id The id of the leaf.
+ * @return True on success; false if the id is not of a leaf.
+ */
+KAPI b8 bvh_remove(bvh* tree, u32 leaf_id);
+
+/**
+ * @brief Gives the given leaf a new box. The leaf is only reinserted if the box leaves its fattened
+ * bounds; otherwise only the box queries test it against changes.
+ *
+ * @param tree A pointer to the bvh.
+ * @param leaf_id The id of the leaf.
+ * @param bounds The new box of the leaf.
+ * @return True if the leaf was reinserted; false if it stayed where it was, or the id is not of a leaf.
+ */
+KAPI b8 bvh_move(bvh* tree, u32 leaf_id, extents_3d bounds);
+
+/**
+ * @brief Obtains the value of the given leaf.
+ *
+ * @param tree A constant pointer to the bvh.
+ * @param leaf_id The id of the leaf.
+ * @return The value of the leaf, or INVALID_ID if the id is not of a leaf.
+ */
+KAPI u32 bvh_value_get(const bvh* tree, u32 leaf_id);
+
+/**
+ * @brief Finds every leaf whose box, as last given, intersects the given frustum. Leaves in nodes
+ * wholly inside the frustum are found without being tested.
+ *
+ * @param tree A constant pointer to the bvh.
+ * @param f A constant pointer to the frustum.
+ * @param callback Called for each leaf found.
+ * @param user_data Passed to the callback.
+ */
+KAPI void bvh_query_frustum(const bvh* tree, const frustum* f, pfn_bvh_query callback, void* user_data);
+
+/**
+ * @brief Finds every leaf whose box, as last given, overlaps the given box.
+ *
+ * @param tree A constant pointer to the bvh.
+ * @param bounds The box to search.
+ * @param callback Called for each leaf found.
+ * @param user_data Passed to the callback.
+ */
+KAPI void bvh_query_extents(const bvh* tree, extents_3d bounds, pfn_bvh_query callback, void* user_data);
+
+/**
+ * @brief Finds every leaf whose box, as last given, is hit by the given ray within the given distance,
+ * in no particular order.
+ *
+ * @param tree A constant pointer to the bvh.
+ * @param r The ray.
+ * @param max_distance The farthest along the ray to search.
+ * @param callback Called for each leaf found.
+ * @param user_data Passed to the callback.
+ */
+KAPI void bvh_query_ray(const bvh* tree, ray r, f32 max_distance, pfn_bvh_query callback, void* user_data);
+
+/**
+ * @brief Finds the leaf whose box, as last given, the given ray hits first within the given distance.
+ * Nodes farther than the nearest hit so far are not visited.
+ *
+ * @param tree A constant pointer to the bvh.
+ * @param r The ray.
+ * @param max_distance The farthest along the ray to search.
+ * @param out_distance A pointer to hold the distance along the ray to the hit. Optional.
+ * @return The id of the leaf hit, or INVALID_ID if none is.
+ */
+KAPI u32 bvh_raycast(const bvh* tree, ray r, f32 max_distance, f32* out_distance);
@@ -1,113 +1,1272 @@
 #include "geometry_utils.h"
 
 #include "kmath.h"
+#include "core/kmemory.h"
 #include "core/logger.h"
+#include "systems/job_system.h"
+
+// The number of triangles or vertices processed per batch of a parallel-for. Smaller meshes are done on the calling thread.
+#define GEOMETRY_PARALLEL_BATCH_SIZE 4096
+
+// The vectors of one triangle which its vertices' normals and tangents are built from.
+typedef struct triangle_frame {
+    // The cross product of the triangle's edges, as long as twice its area.
+    vec3 normal;
+    // The direction of increasing u, not normalized, with the sign of det folded out.
+    vec3 tangent;
+    // The direction of increasing v, not normalized, with the sign of det folded out.
+    vec3 bitangent;
+    // The determinant of the texture coordinate edges, negative if the texture is mirrored.
+    f32 det;
+} triangle_frame;
+
+// The triangles using each vertex, grouped by vertex.
+typedef struct vertex_adjacency {
+    // Where each vertex's triangles start in triangles, with one extra holding the total.
+    u32* offsets;
+    u32* triangles;
+} vertex_adjacency;
+
+typedef struct geometry_frames_context {
+    vertex_3d* vertices;
+    const u32* indices;
+    triangle_frame* frames;
+    vertex_adjacency adjacency;
+} geometry_frames_context;
+
+static void triangle_frames_compute(const vertex_3d* vertices, const u32* indices, u32 start, u32 end, triangle_frame* frames) {
+    for (u32 t = start; t < end; ++t) {
+        const vertex_3d* v0 = &vertices[indices[t * 3 + 0]];
+        const vertex_3d* v1 = &vertices[indices[t * 3 + 1]];
+        const vertex_3d* v2 = &vertices[indices[t * 3 + 2]];
+
+        vec3 edge1 = vec3_sub(v1->position, v0->position);
+        vec3 edge2 = vec3_sub(v2->position, v0->position);
+        f32 delta_u1 = v1->texcoord.x - v0->texcoord.x;
+        f32 delta_v1 = v1->texcoord.y - v0->texcoord.y;
+        f32 delta_u2 = v2->texcoord.x - v0->texcoord.x;
+        f32 delta_v2 = v2->texcoord.y - v0->texcoord.y;
+
+        triangle_frame* frame = &frames[t];
+        frame->normal = vec3_cross(edge1, edge2);
+        frame->det = delta_u1 * delta_v2 - delta_u2 * delta_v1;
+        f32 sign = frame->det < 0.0f ? -1.0f : 1.0f;
+        frame->tangent = vec3_mul_scalar(vec3_sub(vec3_mul_scalar(edge1, delta_v2), vec3_mul_scalar(edge2, delta_v1)), sign);
+        frame->bitangent = vec3_mul_scalar(vec3_sub(vec3_mul_scalar(edge2, delta_u1), vec3_mul_scalar(edge1, delta_u2)), sign);
+    }
+}
+
+#if defined(KSIMD_ENABLED)
+// The same as triangle_frames_compute, four triangles at a time with each lane holding one triangle.
+static void triangle_frames_compute_x4(const vertex_3d* vertices, const u32* indices, u32 start, u32 end, triangle_frame* frames) {
+    u32 t = start;
+    for (; t + 4 <= end; t += 4) {
+        // Gather each component of the three corners into lanes.
+        f32 gathered[3][5][4];
+        for (u32 lane = 0; lane < 4; ++lane) {
+            for (u32 corner = 0; corner < 3; ++corner) {
+                const vertex_3d* v = &vertices[indices[(t + lane) * 3 + corner]];
+                gathered[corner][0][lane] = v->position.x;
+                gathered[corner][1][lane] = v->position.y;
+                gathered[corner][2][lane] = v->position.z;
+                gathered[corner][3][lane] = v->texcoord.x;
+                gathered[corner][4][lane] = v->texcoord.y;
+            }
+        }
+        ksimd_f32x4 e1[5], e2[5];
+        for (u32 c = 0; c < 5; ++c) {
+            ksimd_f32x4 c0 = ksimd_load(gathered[0][c]);
+            e1[c] = ksimd_sub(ksimd_load(gathered[1][c]), c0);
+            e2[c] = ksimd_sub(ksimd_load(gathered[2][c]), c0);
+        }
+        // e1[3], e1[4] are the first edge's u and v, and likewise for e2.
+        ksimd_f32x4 det = ksimd_sub(ksimd_mul(e1[3], e2[4]), ksimd_mul(e2[3], e1[4]));
+        f32 dets[4];
+        f32 signs[4];
+        ksimd_store(dets, det);
+        for (u32 lane = 0; lane < 4; ++lane) {
+            signs[lane] = dets[lane] < 0.0f ? -1.0f : 1.0f;
+        }
+        ksimd_f32x4 sign = ksimd_load(signs);
+        ksimd_f32x4 du1 = ksimd_mul(e1[3], sign);
+        ksimd_f32x4 dv1 = ksimd_mul(e1[4], sign);
+        ksimd_f32x4 du2 = ksimd_mul(e2[3], sign);
+        ksimd_f32x4 dv2 = ksimd_mul(e2[4], sign);
+
+        f32 out[9][4];
+        ksimd_store(out[0], ksimd_sub(ksimd_mul(e1[1], e2[2]), ksimd_mul(e1[2], e2[1])));
+        ksimd_store(out[1], ksimd_sub(ksimd_mul(e1[2], e2[0]), ksimd_mul(e1[0], e2[2])));
+        ksimd_store(out[2], ksimd_sub(ksimd_mul(e1[0], e2[1]), ksimd_mul(e1[1], e2[0])));
+        for (u32 c = 0; c < 3; ++c) {
+            ksimd_store(out[3 + c], ksimd_sub(ksimd_mul(e1[c], dv2), ksimd_mul(e2[c], dv1)));
+            ksimd_store(out[6 + c], ksimd_sub(ksimd_mul(e2[c], du1), ksimd_mul(e1[c], du2)));
+        }
+        for (u32 lane = 0; lane < 4; ++lane) {
+            triangle_frame* frame = &frames[t + lane];
+            frame->normal = (vec3){out[0][lane], out[1][lane], out[2][lane]};
+            frame->tangent = (vec3){out[3][lane], out[4][lane], out[5][lane]};
+            frame->bitangent = (vec3){out[6][lane], out[7][lane], out[8][lane]};
+            frame->det = dets[lane];
+        }
+    }
+    triangle_frames_compute(vertices, indices, t, end, frames);
+}
+#endif
+
+static void triangle_frames_batch(u32 start, u32 end, void* user_data) {
+    geometry_frames_context* context = user_data;
+#if defined(KSIMD_ENABLED)
+    triangle_frames_compute_x4(context->vertices, context->indices, start, end, context->frames);
+#else
+    triangle_frames_compute(context->vertices, context->indices, start, end, context->frames);
+#endif
+}
+
+// Groups the triangles by the vertices they use, with a counting sort. Indices must be within vertex_count.
+static void vertex_adjacency_build(u32 vertex_count, u32 index_count, const u32* indices, vertex_adjacency* out_adjacency) {
+    u32 triangle_count = index_count / 3;
+    out_adjacency->offsets = kallocate(sizeof(u32) * (vertex_count + 1), MEMORY_TAG_ARRAY);
+    out_adjacency->triangles = kallocate(sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+
+    u32* offsets = out_adjacency->offsets;
+    kzero_memory(offsets, sizeof(u32) * (vertex_count + 1));
+    for (u32 i = 0; i < triangle_count * 3; ++i) {
+        offsets[indices[i] + 1]++;
+    }
+    for (u32 v = 0; v < vertex_count; ++v) {
+        offsets[v + 1] += offsets[v];
+    }
+    for (u32 i = 0; i < triangle_count * 3; ++i) {
+        out_adjacency->triangles[offsets[indices[i]]++] = i / 3;
+    }
+    // Filling moved each offset to where the next vertex starts, so move them back.
+    for (u32 v = vertex_count; v > 0; --v) {
+        offsets[v] = offsets[v - 1];
+    }
+    offsets[0] = 0;
+}
+
+static void vertex_adjacency_free(u32 vertex_count, u32 index_count, vertex_adjacency* adjacency) {
+    kfree(adjacency->offsets, sizeof(u32) * (vertex_count + 1), MEMORY_TAG_ARRAY);
+    kfree(adjacency->triangles, sizeof(u32) * (index_count / 3) * 3, MEMORY_TAG_ARRAY);
+}
+
+static b8 indices_validate(u32 vertex_count, u32 index_count, const u32* indices) {
+    for (u32 i = 0; i < index_count; ++i) {
+        if (indices[i] >= vertex_count) {
+            KERROR("Index %u refers to vertex %u of only %u.", i, indices[i], vertex_count);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Computes the frame of every triangle, and which triangles use each vertex.
+static b8 geometry_frames_begin(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices, geometry_frames_context* out_context) {
+    if (!indices_validate(vertex_count, index_count, indices)) {
+        KERROR("Normals and tangents not generated.");
+        return false;
+    }
+
+    u32 triangle_count = index_count / 3;
+    out_context->vertices = vertices;
+    out_context->indices = indices;
+    out_context->frames = kallocate(sizeof(triangle_frame) * triangle_count, MEMORY_TAG_ARRAY);
+
+    job_system_parallel_for(triangle_count, GEOMETRY_PARALLEL_BATCH_SIZE, triangle_frames_batch, out_context);
+
+    vertex_adjacency_build(vertex_count, index_count, indices, &out_context->adjacency);
+    return true;
+}
+
+static void geometry_frames_end(u32 vertex_count, u32 index_count, geometry_frames_context* context) {
+    kfree(context->frames, sizeof(triangle_frame) * (index_count / 3), MEMORY_TAG_ARRAY);
+    vertex_adjacency_free(vertex_count, index_count, &context->adjacency);
+}
+
+// The sum of the normals of the triangles using the vertex, so weighted by their area.
+static vec3 vertex_face_normal_sum(const geometry_frames_context* context, u32 v) {
+    vec3 sum = vec3_zero();
+    for (u32 i = context->adjacency.offsets[v]; i < context->adjacency.offsets[v + 1]; ++i) {
+        sum = vec3_add(sum, context->frames[context->adjacency.triangles[i]].normal);
+    }
+    return sum;
+}
+
+static void vertex_normals_batch(u32 start, u32 end, void* user_data) {
+    geometry_frames_context* context = user_data;
+    for (u32 v = start; v < end; ++v) {
+        vec3 sum = vertex_face_normal_sum(context, v);
+        if (vec3_length_squared(sum) > 0.0f) {
+            context->vertices[v].normal = vec3_normalized(sum);
+        }
+    }
+}
 
 void geometry_generate_normals(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices) {
-    for (u32 i = 0; i < index_count; i += 3) {
-        u32 i0 = indices[i + 0];
-        u32 i1 = indices[i + 1];
-        u32 i2 = indices[i + 2];
+    geometry_frames_context context;
+    if (!geometry_frames_begin(vertex_count, vertices, index_count, indices, &context)) {
+        return;
+    }
+    job_system_parallel_for(vertex_count, GEOMETRY_PARALLEL_BATCH_SIZE, vertex_normals_batch, &context);
+    geometry_frames_end(vertex_count, index_count, &context);
+}
 
-        vec3 edge1 = vec3_sub(vertices[i1].position, vertices[i0].position);
-        vec3 edge2 = vec3_sub(vertices[i2].position, vertices[i0].position);
+static void vertex_tangents_batch(u32 start, u32 end, void* user_data) {
+    geometry_frames_context* context = user_data;
+    for (u32 v = start; v < end; ++v) {
+        vertex_3d* vertex = &context->vertices[v];
+        vec3 normal = vertex->normal;
+        if (vec3_length_squared(normal) <= K_FLOAT_EPSILON) {
+            normal = vertex_face_normal_sum(context, v);
+        }
+        normal = vec3_normalized(normal);
 
-        vec3 normal = vec3_normalized(vec3_cross(edge1, edge2));
+        // Average the unit tangents and bitangents of the triangles, weighted by their area.
+        vec3 tangent = vec3_zero();
+        vec3 bitangent = vec3_zero();
+        for (u32 i = context->adjacency.offsets[v]; i < context->adjacency.offsets[v + 1]; ++i) {
+            const triangle_frame* frame = &context->frames[context->adjacency.triangles[i]];
+            f32 tangent_length = vec3_length(frame->tangent);
+            f32 bitangent_length = vec3_length(frame->bitangent);
+            if (kabs(frame->det) <= K_FLOAT_EPSILON || tangent_length <= K_FLOAT_EPSILON || bitangent_length <= K_FLOAT_EPSILON) {
+                // Degenerate texture coordinates say nothing about the direction.
+                continue;
+            }
+            f32 area = vec3_length(frame->normal);
+            tangent = vec3_add(tangent, vec3_mul_scalar(frame->tangent, area / tangent_length));
+            bitangent = vec3_add(bitangent, vec3_mul_scalar(frame->bitangent, area / bitangent_length));
+        }
+
+        // Make it perpendicular to the normal.
+        tangent = vec3_sub(tangent, vec3_mul_scalar(normal, vec3_dot(normal, tangent)));
+        if (vec3_length_squared(tangent) <= K_FLOAT_EPSILON) {
+            // No usable texture coordinates, so any perpendicular direction will do.
+            vec3 axis = kabs(normal.x) < 0.9f ? (vec3){1, 0, 0} : (vec3){0, 1, 0};
+            tangent = vec3_cross(axis, normal);
+        }
+        tangent = vec3_normalized(tangent);
 
-        // NOTE: This just generates a face normal. Smoothing out should be done in a separate pass if desired.
-        vertices[i0].normal = normal;
-        vertices[i1].normal = normal;
-        vertices[i2].normal = normal;
+        // Mirrored textures flip the bitangent relative to the normal and tangent. The shaders take
+        // the bitangent as cross(normal, tangent), so the handedness is folded into the tangent,
+        // negated as the shaders expect.
+        f32 handedness = vec3_dot(vec3_cross(normal, tangent), bitangent) < 0.0f ? -1.0f : 1.0f;
+        vertex->tangent = vec3_mul_scalar(tangent, -handedness);
     }
 }
 
 void geometry_generate_tangents(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices) {
-    for (u32 i = 0; i < index_count; i += 3) {
-        u32 i0 = indices[i + 0];
-        u32 i1 = indices[i + 1];
-        u32 i2 = indices[i + 2];
+    geometry_frames_context context;
+    if (!geometry_frames_begin(vertex_count, vertices, index_count, indices, &context)) {
+        return;
+    }
+    job_system_parallel_for(vertex_count, GEOMETRY_PARALLEL_BATCH_SIZE, vertex_tangents_batch, &context);
+    geometry_frames_end(vertex_count, index_count, &context);
+}
 
-        vec3 edge1 = vec3_sub(vertices[i1].position, vertices[i0].position);
-        vec3 edge2 = vec3_sub(vertices[i2].position, vertices[i0].position);
+// The number of words in the key vertices are welded by: position, normal, texcoord, colour and tangent.
+#define WELD_KEY_SIZE 15
 
-        f32 deltaU1 = vertices[i1].texcoord.x - vertices[i0].texcoord.x;
-        f32 deltaV1 = vertices[i1].texcoord.y - vertices[i0].texcoord.y;
+// The cell of a grid with cells 1/scale across which the value falls in.
+static u32 weld_quantize(f32 value, f32 scale) {
+    f32 scaled = value * scale;
+    i32 cell = (i32)scaled;
+    if ((f32)cell > scaled) {
+        cell--;
+    }
+    return (u32)cell;
+}
 
-        f32 deltaU2 = vertices[i2].texcoord.x - vertices[i0].texcoord.x;
-        f32 deltaV2 = vertices[i2].texcoord.y - vertices[i0].texcoord.y;
+// The bits of the value, with negative zero made positive so that it matches zero.
+static u32 weld_exact(f32 value) {
+    union {
+        f32 f;
+        u32 u;
+    } bits;
+    bits.f = value + 0.0f;
+    return bits.u;
+}
 
-        f32 dividend = (deltaU1 * deltaV2 - deltaU2 * deltaV1);
-        f32 fc = 1.0f / dividend;
+// The key a vertex is welded by. Positions and normals fall into grid cells when given a non-zero scale.
+static void vertex_weld_key(const vertex_3d* vertex, f32 position_scale, f32 normal_scale, u32* out_key) {
+    for (u32 i = 0; i < 3; ++i) {
+        out_key[i] = position_scale > 0.0f ? weld_quantize(vertex->position.elements[i], position_scale) : weld_exact(vertex->position.elements[i]);
+        out_key[3 + i] = normal_scale > 0.0f ? weld_quantize(vertex->normal.elements[i], normal_scale) : weld_exact(vertex->normal.elements[i]);
+        out_key[12 + i] = weld_exact(vertex->tangent.elements[i]);
+    }
+    out_key[6] = weld_exact(vertex->texcoord.x);
+    out_key[7] = weld_exact(vertex->texcoord.y);
+    for (u32 i = 0; i < 4; ++i) {
+        out_key[8 + i] = weld_exact(vertex->colour.elements[i]);
+    }
+}
 
-        vec3 tangent = (vec3){
-            (fc * (deltaV2 * edge1.x - deltaV1 * edge2.x)),
-            (fc * (deltaV2 * edge1.y - deltaV1 * edge2.y)),
-            (fc * (deltaV2 * edge1.z - deltaV1 * edge2.z))};
+// FNV-1a over the words of the key.
+static u32 weld_key_hash(const u32* key) {
+    u32 hash = 2166136261u;
+    for (u32 i = 0; i < WELD_KEY_SIZE; ++i) {
+        hash = (hash ^ key[i]) * 16777619u;
+    }
+    return hash;
+}
 
-        tangent = vec3_normalized(tangent);
+static b8 weld_keys_equal(const u32* a, const u32* b) {
+    for (u32 i = 0; i < WELD_KEY_SIZE; ++i) {
+        if (a[i] != b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void geometry_weld_vertices(u32 vertex_count, const vertex_3d* vertices, u32 index_count, u32* indices, f32 position_epsilon, f32 normal_epsilon, u32* out_vertex_count, vertex_3d** out_vertices) {
+    *out_vertex_count = 0;
+    *out_vertices = 0;
+    if (vertex_count == 0) {
+        return;
+    }
+
+    f32 position_scale = position_epsilon > 0.0f ? 1.0f / position_epsilon : 0.0f;
+    f32 normal_scale = normal_epsilon > 0.0f ? 1.0f / normal_epsilon : 0.0f;
 
-        f32 sx = deltaU1, sy = deltaU2;
-        f32 tx = deltaV1, ty = deltaV2;
-        f32 handedness = ((tx * sy - ty * sx) < 0.0f) ? -1.0f : 1.0f;
+    // An open-addressed table of unique vertices, at most half full. Slots hold the unique index plus one, or 0 when empty.
+    u32 capacity = 16;
+    while (capacity < vertex_count * 2) {
+        capacity *= 2;
+    }
+    u32* slots = kallocate(sizeof(u32) * capacity, MEMORY_TAG_ARRAY);
+    u32* slot_hashes = kallocate(sizeof(u32) * capacity, MEMORY_TAG_ARRAY);
+    u32* unique_keys = kallocate(sizeof(u32) * WELD_KEY_SIZE * vertex_count, MEMORY_TAG_ARRAY);
+    u32* unique_sources = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    u32* remap = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    kzero_memory(slots, sizeof(u32) * capacity);
+
+    u32 unique_count = 0;
+    for (u32 v = 0; v < vertex_count; ++v) {
+        u32* key = &unique_keys[unique_count * WELD_KEY_SIZE];
+        vertex_weld_key(&vertices[v], position_scale, normal_scale, key);
+        u32 hash = weld_key_hash(key);
+        u32 slot = hash & (capacity - 1);
+        while (slots[slot]) {
+            u32 existing = slots[slot] - 1;
+            if (slot_hashes[slot] == hash && weld_keys_equal(&unique_keys[existing * WELD_KEY_SIZE], key)) {
+                break;
+            }
+            slot = (slot + 1) & (capacity - 1);
+        }
+        if (slots[slot]) {
+            remap[v] = slots[slot] - 1;
+        } else {
+            // New, so keep the key where it was built.
+            slots[slot] = unique_count + 1;
+            slot_hashes[slot] = hash;
+            unique_sources[unique_count] = v;
+            remap[v] = unique_count;
+            unique_count++;
+        }
+    }
+
+    for (u32 i = 0; i < index_count; ++i) {
+        indices[i] = remap[indices[i]];
+    }
 
-        vec3 t4 = vec3_mul_scalar(tangent, handedness);
-        vertices[i0].tangent = t4;
-        vertices[i1].tangent = t4;
-        vertices[i2].tangent = t4;
+    *out_vertex_count = unique_count;
+    *out_vertices = kallocate(sizeof(vertex_3d) * unique_count, MEMORY_TAG_ARRAY);
+    for (u32 u = 0; u < unique_count; ++u) {
+        (*out_vertices)[u] = vertices[unique_sources[u]];
     }
+
+    kfree(slots, sizeof(u32) * capacity, MEMORY_TAG_ARRAY);
+    kfree(slot_hashes, sizeof(u32) * capacity, MEMORY_TAG_ARRAY);
+    kfree(unique_keys, sizeof(u32) * WELD_KEY_SIZE * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(unique_sources, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(remap, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+
+    u32 removed_count = vertex_count - unique_count;
+    KDEBUG("geometry_weld_vertices: removed %d vertices, orig/now %d/%d.", removed_count, vertex_count, unique_count);
+}
+
+void geometry_deduplicate_vertices(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices, u32* out_vertex_count, vertex_3d** out_vertices) {
+    geometry_weld_vertices(vertex_count, vertices, index_count, indices, 0.0f, 0.0f, out_vertex_count, out_vertices);
 }
 
-b8 vertex3d_equal(vertex_3d vert_0, vertex_3d vert_1) {
-    return vec3_compare(vert_0.position, vert_1.position, K_FLOAT_EPSILON) &&
-           vec3_compare(vert_0.normal, vert_1.normal, K_FLOAT_EPSILON) &&
-           vec2_compare(vert_0.texcoord, vert_1.texcoord, K_FLOAT_EPSILON) &&
-           vec4_compare(vert_0.colour, vert_1.colour, K_FLOAT_EPSILON) &&
-           vec3_compare(vert_0.tangent, vert_1.tangent, K_FLOAT_EPSILON);
+f32 geometry_acmr(u32 vertex_count, u32 index_count, const u32* indices, u32 cache_size) {
+    u32 triangle_count = index_count / 3;
+    if (triangle_count == 0) {
+        return 0.0f;
+    }
+    // A vertex is in the cache if fewer than cache_size misses have happened since it was added.
+    u32* cache_times = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    kzero_memory(cache_times, sizeof(u32) * vertex_count);
+    u32 time = cache_size + 1;
+    u32 miss_count = 0;
+    for (u32 i = 0; i < triangle_count * 3; ++i) {
+        u32 v = indices[i];
+        if (v < vertex_count && time - cache_times[v] > cache_size) {
+            cache_times[v] = time++;
+            miss_count++;
+        }
+    }
+    kfree(cache_times, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    return (f32)miss_count / triangle_count;
 }
 
-void reassign_index(u32 index_count, u32* indices, u32 from, u32 to) {
+// Picks the candidate vertex to fan around next, which is the one longest in the cache that will
+// still be there after its remaining triangles are emitted, or INVALID_ID if there are none.
+static u32 tipsify_next_candidate(const u32* candidates, u32 candidate_count, const u32* live_counts, const u32* cache_times, u32 time, u32 cache_size) {
+    u32 best = INVALID_ID;
+    i64 best_priority = -1;
+    for (u32 i = 0; i < candidate_count; ++i) {
+        u32 v = candidates[i];
+        if (!live_counts[v]) {
+            continue;
+        }
+        i64 priority = 0;
+        if ((i64)time - cache_times[v] + 2 * (i64)live_counts[v] <= cache_size) {
+            priority = (i64)time - cache_times[v];
+        }
+        if (priority > best_priority) {
+            best_priority = priority;
+            best = v;
+        }
+    }
+    return best;
+}
+
+void geometry_optimize_vertex_cache(u32 vertex_count, u32 index_count, u32* indices, u32 cache_size) {
+    u32 triangle_count = index_count / 3;
+    if (triangle_count == 0 || !indices_validate(vertex_count, index_count, indices)) {
+        return;
+    }
+
+    vertex_adjacency adjacency;
+    vertex_adjacency_build(vertex_count, index_count, indices, &adjacency);
+
+    u32* live_counts = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    u32* cache_times = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    u8* emitted = kallocate(sizeof(u8) * triangle_count, MEMORY_TAG_ARRAY);
+    // Every vertex of every emitted triangle, so that a dead end can back up to a recent vertex.
+    u32* dead_end_stack = kallocate(sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+    u32* output = kallocate(sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+    for (u32 v = 0; v < vertex_count; ++v) {
+        live_counts[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+    }
+    kzero_memory(cache_times, sizeof(u32) * vertex_count);
+    kzero_memory(emitted, sizeof(u8) * triangle_count);
+
+    u32 output_count = 0;
+    u32 dead_end_count = 0;
+    u32 time = cache_size + 1;
+    u32 cursor = 0;
+    u32 fanning = indices[0];
+    while (fanning != INVALID_ID) {
+        // Emit every remaining triangle around the fanning vertex. The vertices pushed are the candidates for the next one.
+        u32 candidates_start = dead_end_count;
+        for (u32 i = adjacency.offsets[fanning]; i < adjacency.offsets[fanning + 1]; ++i) {
+            u32 t = adjacency.triangles[i];
+            if (emitted[t]) {
+                continue;
+            }
+            emitted[t] = true;
+            for (u32 c = 0; c < 3; ++c) {
+                u32 v = indices[t * 3 + c];
+                output[output_count++] = v;
+                dead_end_stack[dead_end_count++] = v;
+                live_counts[v]--;
+                if (time - cache_times[v] > cache_size) {
+                    cache_times[v] = time++;
+                }
+            }
+        }
+
+        fanning = tipsify_next_candidate(&dead_end_stack[candidates_start], dead_end_count - candidates_start, live_counts, cache_times, time, cache_size);
+        if (fanning == INVALID_ID) {
+            // A dead end, so back up to the most recent vertex with triangles left, or failing that the next in order.
+            while (dead_end_count && fanning == INVALID_ID) {
+                u32 v = dead_end_stack[--dead_end_count];
+                if (live_counts[v]) {
+                    fanning = v;
+                }
+            }
+            while (cursor < vertex_count && fanning == INVALID_ID) {
+                if (live_counts[cursor]) {
+                    fanning = cursor;
+                }
+                cursor++;
+            }
+        }
+    }
+    kcopy_memory(indices, output, sizeof(u32) * triangle_count * 3);
+
+    kfree(live_counts, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(cache_times, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(emitted, sizeof(u8) * triangle_count, MEMORY_TAG_ARRAY);
+    kfree(dead_end_stack, sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+    kfree(output, sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+    vertex_adjacency_free(vertex_count, index_count, &adjacency);
+}
+
+typedef struct overdraw_cluster {
+    // How much the cluster faces away from the center of the mesh. Clusters facing further out are drawn first.
+    f32 sort_key;
+    u32 first_triangle;
+    u32 triangle_count;
+} overdraw_cluster;
+
+// Stably sorts clusters by descending sort key, merging through scratch.
+static void overdraw_clusters_sort(overdraw_cluster* clusters, overdraw_cluster* scratch, u32 count) {
+    for (u32 width = 1; width < count; width *= 2) {
+        for (u32 left = 0; left < count; left += width * 2) {
+            u32 middle = KMIN(left + width, count);
+            u32 right = KMIN(left + width * 2, count);
+            u32 a = left, b = middle, out = left;
+            while (a < middle && b < right) {
+                scratch[out++] = clusters[b].sort_key > clusters[a].sort_key ? clusters[b++] : clusters[a++];
+            }
+            while (a < middle) {
+                scratch[out++] = clusters[a++];
+            }
+            while (b < right) {
+                scratch[out++] = clusters[b++];
+            }
+        }
+        kcopy_memory(clusters, scratch, sizeof(overdraw_cluster) * count);
+    }
+}
+
+void geometry_optimize_overdraw(u32 vertex_count, const vertex_3d* vertices, u32 index_count, u32* indices, u32 cache_size) {
+    u32 triangle_count = index_count / 3;
+    if (triangle_count < 2 || !indices_validate(vertex_count, index_count, indices)) {
+        return;
+    }
+
+    // Split where a triangle misses the cache for all of its vertices, as the vertex cache pass does when
+    // it has to jump elsewhere. Reordering the clusters then costs little more than the jumps did already.
+    overdraw_cluster* clusters = kallocate(sizeof(overdraw_cluster) * triangle_count, MEMORY_TAG_ARRAY);
+    u32* cache_times = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    kzero_memory(cache_times, sizeof(u32) * vertex_count);
+    u32 cluster_count = 0;
+    u32 time = cache_size + 1;
+    for (u32 t = 0; t < triangle_count; ++t) {
+        u32 miss_count = 0;
+        for (u32 c = 0; c < 3; ++c) {
+            u32 v = indices[t * 3 + c];
+            if (time - cache_times[v] > cache_size) {
+                cache_times[v] = time++;
+                miss_count++;
+            }
+        }
+        if (t == 0 || miss_count == 3) {
+            clusters[cluster_count++] = (overdraw_cluster){0.0f, t, 0};
+        }
+        clusters[cluster_count - 1].triangle_count++;
+    }
+    kfree(cache_times, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+
+    if (cluster_count > 1) {
+        // Area-weighted centroid of the mesh, and of each cluster along with which way it faces.
+        vec3* cluster_centroids = kallocate(sizeof(vec3) * cluster_count, MEMORY_TAG_ARRAY);
+        vec3* cluster_normals = kallocate(sizeof(vec3) * cluster_count, MEMORY_TAG_ARRAY);
+        vec3 mesh_centroid = vec3_zero();
+        f32 mesh_area = 0.0f;
+        for (u32 k = 0; k < cluster_count; ++k) {
+            vec3 centroid = vec3_zero();
+            vec3 normal = vec3_zero();
+            f32 area = 0.0f;
+            for (u32 t = clusters[k].first_triangle; t < clusters[k].first_triangle + clusters[k].triangle_count; ++t) {
+                vec3 p0 = vertices[indices[t * 3 + 0]].position;
+                vec3 p1 = vertices[indices[t * 3 + 1]].position;
+                vec3 p2 = vertices[indices[t * 3 + 2]].position;
+                vec3 cross = vec3_cross(vec3_sub(p1, p0), vec3_sub(p2, p0));
+                f32 triangle_area = vec3_length(cross);
+                centroid = vec3_add(centroid, vec3_mul_scalar(vec3_add(vec3_add(p0, p1), p2), triangle_area / 3.0f));
+                normal = vec3_add(normal, cross);
+                area += triangle_area;
+            }
+            mesh_centroid = vec3_add(mesh_centroid, centroid);
+            mesh_area += area;
+            cluster_centroids[k] = area > 0.0f ? vec3_mul_scalar(centroid, 1.0f / area) : vertices[indices[clusters[k].first_triangle * 3]].position;
+            cluster_normals[k] = normal;
+        }
+        if (mesh_area > 0.0f) {
+            mesh_centroid = vec3_mul_scalar(mesh_centroid, 1.0f / mesh_area);
+        }
+        for (u32 k = 0; k < cluster_count; ++k) {
+            f32 normal_length = vec3_length(cluster_normals[k]);
+            clusters[k].sort_key = normal_length > 0.0f ? vec3_dot(vec3_sub(cluster_centroids[k], mesh_centroid), cluster_normals[k]) / normal_length : 0.0f;
+        }
+        kfree(cluster_centroids, sizeof(vec3) * cluster_count, MEMORY_TAG_ARRAY);
+        kfree(cluster_normals, sizeof(vec3) * cluster_count, MEMORY_TAG_ARRAY);
+
+        overdraw_cluster* scratch = kallocate(sizeof(overdraw_cluster) * cluster_count, MEMORY_TAG_ARRAY);
+        overdraw_clusters_sort(clusters, scratch, cluster_count);
+        kfree(scratch, sizeof(overdraw_cluster) * cluster_count, MEMORY_TAG_ARRAY);
+
+        u32* output = kallocate(sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+        u32 output_count = 0;
+        for (u32 k = 0; k < cluster_count; ++k) {
+            kcopy_memory(&output[output_count], &indices[clusters[k].first_triangle * 3], sizeof(u32) * clusters[k].triangle_count * 3);
+            output_count += clusters[k].triangle_count * 3;
+        }
+        kcopy_memory(indices, output, sizeof(u32) * triangle_count * 3);
+        kfree(output, sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+    }
+    kfree(clusters, sizeof(overdraw_cluster) * triangle_count, MEMORY_TAG_ARRAY);
+}
+
+void geometry_optimize_vertex_fetch(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices) {
+    if (vertex_count == 0 || !indices_validate(vertex_count, index_count, indices)) {
+        return;
+    }
+
+    // Number vertices in the order they are first used, with any unused ones last.
+    u32* remap = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    kset_memory(remap, 0xFF, sizeof(u32) * vertex_count);
+    u32 next = 0;
     for (u32 i = 0; i < index_count; ++i) {
-        if (indices[i] == from) {
-            indices[i] = to;
-        } else if (indices[i] > from) {
-            // Pull in all indicies higher than 'from' by 1.
-            indices[i]--;
+        if (remap[indices[i]] == INVALID_ID) {
+            remap[indices[i]] = next++;
         }
+        indices[i] = remap[indices[i]];
     }
+    for (u32 v = 0; v < vertex_count; ++v) {
+        if (remap[v] == INVALID_ID) {
+            remap[v] = next++;
+        }
+    }
+
+    vertex_3d* original = kallocate(sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    kcopy_memory(original, vertices, sizeof(vertex_3d) * vertex_count);
+    for (u32 v = 0; v < vertex_count; ++v) {
+        vertices[remap[v]] = original[v];
+    }
+    kfree(original, sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(remap, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
 }
 
-void geometry_deduplicate_vertices(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices, u32* out_vertex_count, vertex_3d** out_vertices) {
-    // Create new arrays for the collection to sit in.
-    vertex_3d* unique_verts = kallocate(sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
-    *out_vertex_count = 0;
+// A quadric measuring the sum of squared distances to a set of planes, as the symmetric matrix of (a, b, c, d)(a, b, c, d)^T.
+typedef struct simplify_quadric {
+    f32 a2, b2, c2, ab, ac, bc, ad, bd, cd, d2;
+    // The total area of the planes, by which the error is divided to make it a mean squared distance.
+    f32 weight;
+} simplify_quadric;
 
-    u32 found_count = 0;
+// An edge which may be collapsed by moving the from vertex onto the to vertex.
+typedef struct simplify_collapse {
+    f32 cost;
+    u32 from;
+    u32 to;
+} simplify_collapse;
+
+static void quadric_add_plane(simplify_quadric* q, vec3 n, f32 d, f32 weight) {
+    q->a2 += n.x * n.x * weight;
+    q->b2 += n.y * n.y * weight;
+    q->c2 += n.z * n.z * weight;
+    q->ab += n.x * n.y * weight;
+    q->ac += n.x * n.z * weight;
+    q->bc += n.y * n.z * weight;
+    q->ad += n.x * d * weight;
+    q->bd += n.y * d * weight;
+    q->cd += n.z * d * weight;
+    q->d2 += d * d * weight;
+    q->weight += weight;
+}
+
+static void quadric_add(simplify_quadric* q, const simplify_quadric* other) {
+    f32* dest = &q->a2;
+    const f32* source = &other->a2;
+    for (u32 i = 0; i < sizeof(simplify_quadric) / sizeof(f32); ++i) {
+        dest[i] += source[i];
+    }
+}
+
+// The mean squared distance of the point from the planes of the quadric.
+static f32 quadric_error(const simplify_quadric* q, vec3 p) {
+    f32 e = q->a2 * p.x * p.x + q->b2 * p.y * p.y + q->c2 * p.z * p.z +
+            2.0f * (q->ab * p.x * p.y + q->ac * p.x * p.z + q->bc * p.y * p.z) +
+            2.0f * (q->ad * p.x + q->bd * p.y + q->cd * p.z) + q->d2;
+    return q->weight > 0.0f ? kabs(e) / q->weight : 0.0f;
+}
+
+// Stably sorts collapses by ascending cost, merging through scratch.
+static void simplify_collapses_sort(simplify_collapse* collapses, simplify_collapse* scratch, u32 count) {
+    for (u32 width = 1; width < count; width *= 2) {
+        for (u32 left = 0; left < count; left += width * 2) {
+            u32 middle = KMIN(left + width, count);
+            u32 right = KMIN(left + width * 2, count);
+            u32 a = left, b = middle, out = left;
+            while (a < middle && b < right) {
+                scratch[out++] = collapses[b].cost < collapses[a].cost ? collapses[b++] : collapses[a++];
+            }
+            while (a < middle) {
+                scratch[out++] = collapses[a++];
+            }
+            while (b < right) {
+                scratch[out++] = collapses[b++];
+            }
+        }
+        kcopy_memory(collapses, scratch, sizeof(simplify_collapse) * count);
+    }
+}
+
+// Finds a vertex at the same position as each one, the same for all of them, using a hash table of positions.
+static void simplify_position_classes(u32 vertex_count, const vertex_3d* vertices, u32* out_classes) {
+    u32 capacity = 16;
+    while (capacity < vertex_count * 2) {
+        capacity *= 2;
+    }
+    u32* slots = kallocate(sizeof(u32) * capacity, MEMORY_TAG_ARRAY);
+    kset_memory(slots, 0xFF, sizeof(u32) * capacity);
     for (u32 v = 0; v < vertex_count; ++v) {
-        b8 found = false;
-        for (u32 u = 0; u < *out_vertex_count; ++u) {
-            if (vertex3d_equal(vertices[v], unique_verts[u])) {
-                // Reassign indices, do _not_ copy
-                reassign_index(index_count, indices, v - found_count, u);
-                found = true;
-                found_count++;
+        u32 key[3];
+        for (u32 i = 0; i < 3; ++i) {
+            key[i] = weld_exact(vertices[v].position.elements[i]);
+        }
+        u32 hash = 2166136261u;
+        for (u32 i = 0; i < 3; ++i) {
+            hash = (hash ^ key[i]) * 16777619u;
+        }
+        u32 slot = hash & (capacity - 1);
+        while (slots[slot] != INVALID_ID && !vec3_compare(vertices[slots[slot]].position, vertices[v].position, 0.0f)) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        if (slots[slot] == INVALID_ID) {
+            slots[slot] = v;
+        }
+        out_classes[v] = slots[slot];
+    }
+    kfree(slots, sizeof(u32) * capacity, MEMORY_TAG_ARRAY);
+}
+
+// The corner of triangle t which is vertex v, or 3 if it is not used.
+static u32 triangle_corner_of(const u32* indices, u32 t, u32 v) {
+    for (u32 c = 0; c < 3; ++c) {
+        if (indices[t * 3 + c] == v) {
+            return c;
+        }
+    }
+    return 3;
+}
+
+// Locks vertices which have to stay where they are so the mesh does not open up: those on a texture
+// or normal seam, where others share their position, and those on the border of the mesh.
+static void simplify_lock_vertices(u32 vertex_count, const u32* classes, u32 index_count, const u32* indices, const vertex_adjacency* adjacency, b8* out_locked) {
+    u32* class_sizes = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    kzero_memory(class_sizes, sizeof(u32) * vertex_count);
+    for (u32 v = 0; v < vertex_count; ++v) {
+        class_sizes[classes[v]]++;
+    }
+    for (u32 v = 0; v < vertex_count; ++v) {
+        out_locked[v] = class_sizes[classes[v]] > 1;
+        if (out_locked[v]) {
+            continue;
+        }
+        // Every edge leaving the vertex should be matched by one coming back in another triangle.
+        for (u32 i = adjacency->offsets[v]; i < adjacency->offsets[v + 1] && !out_locked[v]; ++i) {
+            u32 t = adjacency->triangles[i];
+            u32 next = classes[indices[t * 3 + (triangle_corner_of(indices, t, v) + 1) % 3]];
+            b8 matched = false;
+            for (u32 j = adjacency->offsets[v]; j < adjacency->offsets[v + 1] && !matched; ++j) {
+                u32 other = adjacency->triangles[j];
+                u32 previous = classes[indices[other * 3 + (triangle_corner_of(indices, other, v) + 2) % 3]];
+                matched = other != t && previous == next;
+            }
+            out_locked[v] = !matched;
+        }
+    }
+    kfree(class_sizes, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+}
+
+// Indicates if moving vertex from onto vertex to would turn any of the triangles around it over.
+static b8 simplify_collapse_flips(const vertex_3d* vertices, const u32* indices, const vertex_adjacency* adjacency, u32 from, u32 to) {
+    vec3 target = vertices[to].position;
+    for (u32 i = adjacency->offsets[from]; i < adjacency->offsets[from + 1]; ++i) {
+        u32 t = adjacency->triangles[i];
+        if (triangle_corner_of(indices, t, to) != 3) {
+            // Removed by the collapse.
+            continue;
+        }
+        u32 corner = triangle_corner_of(indices, t, from);
+        vec3 p1 = vertices[indices[t * 3 + (corner + 1) % 3]].position;
+        vec3 p2 = vertices[indices[t * 3 + (corner + 2) % 3]].position;
+        vec3 before = vec3_cross(vec3_sub(p1, vertices[from].position), vec3_sub(p2, vertices[from].position));
+        vec3 after = vec3_cross(vec3_sub(p1, target), vec3_sub(p2, target));
+        if (vec3_dot(before, after) <= 0.0f) {
+            return true;
+        }
+    }
+    return false;
+}
+
+u32 geometry_simplify(u32 vertex_count, const vertex_3d* vertices, u32 index_count, const u32* indices, u32 target_index_count, f32 target_error, u32* out_indices, f32* out_error) {
+    if (out_error) {
+        *out_error = 0.0f;
+    }
+    u32 triangle_count = index_count / 3;
+    if (triangle_count == 0 || !indices_validate(vertex_count, index_count, indices)) {
+        return 0;
+    }
+    kcopy_memory(out_indices, indices, sizeof(u32) * triangle_count * 3);
+    u32 target_triangle_count = target_index_count / 3;
+    if (triangle_count <= target_triangle_count) {
+        return triangle_count * 3;
+    }
+
+    // Errors are measured relative to the radius of the sphere around the extents.
+    extents_3d extents = {vertices[0].position, vertices[0].position};
+    for (u32 v = 1; v < vertex_count; ++v) {
+        extents = extents_3d_merge(extents, (extents_3d){vertices[v].position, vertices[v].position});
+    }
+    f32 scale = vec3_length(extents_3d_half_extents(extents));
+    if (scale <= 0.0f) {
+        return triangle_count * 3;
+    }
+    f32 max_error_squared = target_error * scale * target_error * scale;
+
+    simplify_quadric* quadrics = kallocate(sizeof(simplify_quadric) * vertex_count, MEMORY_TAG_ARRAY);
+    kzero_memory(quadrics, sizeof(simplify_quadric) * vertex_count);
+    for (u32 t = 0; t < triangle_count; ++t) {
+        vec3 p0 = vertices[indices[t * 3 + 0]].position;
+        vec3 normal = vec3_cross(vec3_sub(vertices[indices[t * 3 + 1]].position, p0), vec3_sub(vertices[indices[t * 3 + 2]].position, p0));
+        f32 length = vec3_length(normal);
+        if (length <= 0.0f) {
+            continue;
+        }
+        normal = vec3_mul_scalar(normal, 1.0f / length);
+        for (u32 c = 0; c < 3; ++c) {
+            quadric_add_plane(&quadrics[indices[t * 3 + c]], normal, -vec3_dot(normal, p0), length * 0.5f);
+        }
+    }
+
+    u32* classes = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    b8* locked = kallocate(sizeof(b8) * vertex_count, MEMORY_TAG_ARRAY);
+    b8* touched = kallocate(sizeof(b8) * vertex_count, MEMORY_TAG_ARRAY);
+    u32* remap = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    simplify_collapse* collapses = kallocate(sizeof(simplify_collapse) * triangle_count * 6, MEMORY_TAG_ARRAY);
+    simplify_collapse* scratch = kallocate(sizeof(simplify_collapse) * triangle_count * 6, MEMORY_TAG_ARRAY);
+    simplify_position_classes(vertex_count, vertices, classes);
+    {
+        vertex_adjacency adjacency;
+        vertex_adjacency_build(vertex_count, triangle_count * 3, out_indices, &adjacency);
+        simplify_lock_vertices(vertex_count, classes, triangle_count * 3, out_indices, &adjacency, locked);
+        vertex_adjacency_free(vertex_count, triangle_count * 3, &adjacency);
+    }
+    for (u32 v = 0; v < vertex_count; ++v) {
+        remap[v] = v;
+    }
+
+    // Collapse in passes, cheapest first, with each vertex moved or moved onto at most once a pass.
+    u32 current_count = triangle_count;
+    f32 result_error_squared = 0.0f;
+    while (current_count > target_triangle_count) {
+        vertex_adjacency adjacency;
+        vertex_adjacency_build(vertex_count, current_count * 3, out_indices, &adjacency);
+
+        u32 collapse_count = 0;
+        for (u32 t = 0; t < current_count; ++t) {
+            for (u32 c = 0; c < 3; ++c) {
+                u32 a = out_indices[t * 3 + c];
+                u32 b = out_indices[t * 3 + (c + 1) % 3];
+                if (!locked[a]) {
+                    collapses[collapse_count++] = (simplify_collapse){quadric_error(&quadrics[a], vertices[b].position), a, b};
+                }
+                if (!locked[b]) {
+                    collapses[collapse_count++] = (simplify_collapse){quadric_error(&quadrics[b], vertices[a].position), b, a};
+                }
+            }
+        }
+        simplify_collapses_sort(collapses, scratch, collapse_count);
+
+        kzero_memory(touched, sizeof(b8) * vertex_count);
+        u32 removed_count = 0;
+        u32 applied_count = 0;
+        for (u32 i = 0; i < collapse_count && current_count - removed_count > target_triangle_count; ++i) {
+            simplify_collapse* collapse = &collapses[i];
+            if (collapse->cost > max_error_squared) {
                 break;
             }
+            if (touched[collapse->from] || touched[collapse->to] || simplify_collapse_flips(vertices, out_indices, &adjacency, collapse->from, collapse->to)) {
+                continue;
+            }
+            remap[collapse->from] = collapse->to;
+            quadric_add(&quadrics[collapse->to], &quadrics[collapse->from]);
+            result_error_squared = KMAX(result_error_squared, collapse->cost);
+            // Nothing around the moved vertex may change again this pass, as its neighbourhood is now out of date.
+            for (u32 j = adjacency.offsets[collapse->from]; j < adjacency.offsets[collapse->from + 1]; ++j) {
+                u32 t = adjacency.triangles[j];
+                if (triangle_corner_of(out_indices, t, collapse->to) != 3) {
+                    removed_count++;
+                }
+                for (u32 c = 0; c < 3; ++c) {
+                    touched[out_indices[t * 3 + c]] = true;
+                }
+            }
+            applied_count++;
+        }
+        vertex_adjacency_free(vertex_count, current_count * 3, &adjacency);
+        if (applied_count == 0) {
+            break;
+        }
+
+        // Apply the collapses, dropping the triangles which have lost an edge.
+        u32 kept_count = 0;
+        for (u32 t = 0; t < current_count; ++t) {
+            u32 a = remap[out_indices[t * 3 + 0]];
+            u32 b = remap[out_indices[t * 3 + 1]];
+            u32 c = remap[out_indices[t * 3 + 2]];
+            if (a != b && b != c && a != c) {
+                out_indices[kept_count * 3 + 0] = a;
+                out_indices[kept_count * 3 + 1] = b;
+                out_indices[kept_count * 3 + 2] = c;
+                kept_count++;
+            }
+        }
+        current_count = kept_count;
+    }
+
+    kfree(quadrics, sizeof(simplify_quadric) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(classes, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(locked, sizeof(b8) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(touched, sizeof(b8) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(remap, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(collapses, sizeof(simplify_collapse) * triangle_count * 6, MEMORY_TAG_ARRAY);
+    kfree(scratch, sizeof(simplify_collapse) * triangle_count * 6, MEMORY_TAG_ARRAY);
+
+    if (out_error) {
+        *out_error = ksqrt(result_error_squared) / scale;
+    }
+    return current_count * 3;
+}
+
+// The cross product of the edges of the given triangle, as long as twice its area.
+static vec3 triangle_normal_get(const vertex_3d* vertices, const u32* indices, u32 t) {
+    vec3 p0 = vertices[indices[t * 3]].position;
+    vec3 p1 = vertices[indices[t * 3 + 1]].position;
+    vec3 p2 = vertices[indices[t * 3 + 2]].position;
+    return vec3_cross(vec3_sub(p1, p0), vec3_sub(p2, p0));
+}
+
+// Counts the different vertices of the given triangle which are not yet in the given meshlet.
+static u32 meshlet_new_vertex_count(const u32* triangle, const u32* vertex_meshlets, u32 meshlet) {
+    u32 count = 0;
+    for (u32 c = 0; c < 3; ++c) {
+        b8 repeated = (c > 0 && triangle[c] == triangle[0]) || (c > 1 && triangle[c] == triangle[1]);
+        if (!repeated && vertex_meshlets[triangle[c]] != meshlet) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// Works out the extents and normal cone of the given meshlet, once its triangles are known.
+static void meshlet_bounds_compute(const vertex_3d* vertices, const u32* indices, geometry_meshlet* meshlet) {
+    const u32* meshlet_indices = indices + meshlet->index_offset;
+    meshlet->extents.min = vertices[meshlet_indices[0]].position;
+    meshlet->extents.max = meshlet->extents.min;
+    for (u32 i = 1; i < meshlet->index_count; ++i) {
+        vec3 p = vertices[meshlet_indices[i]].position;
+        meshlet->extents.min = vec3_create(KMIN(meshlet->extents.min.x, p.x), KMIN(meshlet->extents.min.y, p.y), KMIN(meshlet->extents.min.z, p.z));
+        meshlet->extents.max = vec3_create(KMAX(meshlet->extents.max.x, p.x), KMAX(meshlet->extents.max.y, p.y), KMAX(meshlet->extents.max.z, p.z));
+    }
+
+    // The axis is the average of the triangles' normals, each of unit length so large ones do not dominate.
+    u32 triangle_count = meshlet->index_count / 3;
+    vec3 axis = vec3_zero();
+    for (u32 t = 0; t < triangle_count; ++t) {
+        vec3 n = triangle_normal_get(vertices, meshlet_indices, t);
+        f32 length = vec3_length(n);
+        if (length > K_FLOAT_EPSILON) {
+            axis = vec3_add(axis, vec3_mul_scalar(n, 1.0f / length));
+        }
+    }
+    f32 axis_length = vec3_length(axis);
+    meshlet->cone_axis = vec3_zero();
+    meshlet->cone_cutoff = 1.0f;
+    if (axis_length <= K_FLOAT_EPSILON) {
+        return;
+    }
+    axis = vec3_mul_scalar(axis, 1.0f / axis_length);
+
+    // Cones of more than about 84 degrees either side are too wide to be worth testing.
+    f32 min_dot = 1.0f;
+    for (u32 t = 0; t < triangle_count; ++t) {
+        vec3 n = triangle_normal_get(vertices, meshlet_indices, t);
+        f32 length = vec3_length(n);
+        if (length > K_FLOAT_EPSILON) {
+            min_dot = KMIN(min_dot, vec3_dot(axis, n) / length);
+        }
+    }
+    meshlet->cone_axis = axis;
+    if (min_dot > 0.1f) {
+        meshlet->cone_cutoff = ksqrt(1.0f - min_dot * min_dot);
+    }
+}
+
+u32 geometry_build_meshlets(u32 vertex_count, const vertex_3d* vertices, u32 index_count, const u32* indices, u32 max_vertices, u32 max_triangles, geometry_meshlet** out_meshlets) {
+    *out_meshlets = 0;
+    u32 triangle_count = index_count / 3;
+    if (triangle_count == 0 || max_vertices < 3 || max_triangles == 0 || !indices_validate(vertex_count, index_count, indices)) {
+        return 0;
+    }
+
+    // At most one meshlet per triangle, trimmed to size at the end.
+    geometry_meshlet* meshlets = kallocate(sizeof(geometry_meshlet) * triangle_count, MEMORY_TAG_ARRAY);
+    // The meshlet each vertex was last added to, so membership of the current one is a single compare.
+    u32* vertex_meshlets = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    for (u32 v = 0; v < vertex_count; ++v) {
+        vertex_meshlets[v] = INVALID_ID;
+    }
+
+    u32 meshlet_count = 0;
+    geometry_meshlet* current = &meshlets[0];
+    kzero_memory(current, sizeof(geometry_meshlet));
+    for (u32 t = 0; t < triangle_count; ++t) {
+        const u32* triangle = &indices[t * 3];
+        u32 new_vertices = meshlet_new_vertex_count(triangle, vertex_meshlets, meshlet_count);
+
+        // Start another meshlet if this triangle does not fit in the current one.
+        if (current->index_count > 0 && (current->vertex_count + new_vertices > max_vertices || current->index_count / 3 >= max_triangles)) {
+            meshlet_bounds_compute(vertices, indices, current);
+            meshlet_count++;
+            current = &meshlets[meshlet_count];
+            kzero_memory(current, sizeof(geometry_meshlet));
+            current->index_offset = t * 3;
+            new_vertices = meshlet_new_vertex_count(triangle, vertex_meshlets, meshlet_count);
         }
 
-        if (!found) {
-            // Copy over to unique.
-            unique_verts[*out_vertex_count] = vertices[v];
-            (*out_vertex_count)++;
+        for (u32 c = 0; c < 3; ++c) {
+            vertex_meshlets[triangle[c]] = meshlet_count;
         }
+        current->vertex_count += new_vertices;
+        current->index_count += 3;
     }
+    meshlet_bounds_compute(vertices, indices, current);
+    meshlet_count++;
 
-    // Allocate new vertices array
-    *out_vertices = kallocate(sizeof(vertex_3d) * (*out_vertex_count), MEMORY_TAG_ARRAY);
-    // Copy over unique
-    kcopy_memory(*out_vertices, unique_verts, sizeof(vertex_3d) * (*out_vertex_count));
-    // Destroy temp array
-    kfree(unique_verts, sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    *out_meshlets = kallocate(sizeof(geometry_meshlet) * meshlet_count, MEMORY_TAG_ARRAY);
+    kcopy_memory(*out_meshlets, meshlets, sizeof(geometry_meshlet) * meshlet_count);
+    kfree(meshlets, sizeof(geometry_meshlet) * triangle_count, MEMORY_TAG_ARRAY);
+    kfree(vertex_meshlets, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    return meshlet_count;
+}
+
+vertex_3d_packed vertex_3d_pack(const vertex_3d* vertex) {
+    vertex_3d_packed packed;
+    packed.position = vertex->position;
+    packed.normal = vec3_to_octahedral_snorm16(vertex->normal);
+    packed.texcoord[0] = f32_to_half(vertex->texcoord.x);
+    packed.texcoord[1] = f32_to_half(vertex->texcoord.y);
+    packed.colour = vec4_to_unorm8(vertex->colour);
+    packed.tangent = vec3_to_octahedral_snorm16(vertex->tangent);
+    return packed;
+}
+
+vertex_3d vertex_3d_unpack(const vertex_3d_packed* packed) {
+    vertex_3d vertex;
+    vertex.position = packed->position;
+    vertex.normal = octahedral_snorm16_to_vec3(packed->normal);
+    vertex.texcoord.x = half_to_f32(packed->texcoord[0]);
+    vertex.texcoord.y = half_to_f32(packed->texcoord[1]);
+    vertex.colour = unorm8_to_vec4(packed->colour);
+    vertex.tangent = octahedral_snorm16_to_vec3(packed->tangent);
+    return vertex;
+}
+
+void geometry_pack_vertices(u32 vertex_count, const vertex_3d* vertices, vertex_3d_packed* out_vertices) {
+    for (u32 i = 0; i < vertex_count; ++i) {
+        out_vertices[i] = vertex_3d_pack(&vertices[i]);
+    }
+}
+
+vertex_3d_skinned vertex_3d_skinned_pack(const vertex_3d* vertex, u32 influence_count, const u32* joints, const f32* weights) {
+    vertex_3d_skinned skinned;
+    kzero_memory(&skinned, sizeof(vertex_3d_skinned));
+    skinned.vertex = vertex_3d_pack(vertex);
+
+    // The heaviest influences, heaviest first.
+    u32 kept_joints[VERTEX_MAX_JOINT_INFLUENCES] = {0};
+    f32 kept_weights[VERTEX_MAX_JOINT_INFLUENCES] = {0};
+    u32 kept_count = 0;
+    for (u32 i = 0; i < influence_count; ++i) {
+        f32 weight = KMAX(weights[i], 0.0f);
+        u32 slot = kept_count;
+        while (slot > 0 && kept_weights[slot - 1] < weight) {
+            slot--;
+        }
+        if (slot >= VERTEX_MAX_JOINT_INFLUENCES) {
+            continue;
+        }
+        u32 last = KMIN(kept_count, VERTEX_MAX_JOINT_INFLUENCES - 1);
+        for (u32 j = last; j > slot; --j) {
+            kept_joints[j] = kept_joints[j - 1];
+            kept_weights[j] = kept_weights[j - 1];
+        }
+        kept_joints[slot] = joints[i];
+        kept_weights[slot] = weight;
+        kept_count = KMIN(kept_count + 1, VERTEX_MAX_JOINT_INFLUENCES);
+    }
+
+    f32 total = 0.0f;
+    for (u32 i = 0; i < kept_count; ++i) {
+        total += kept_weights[i];
+    }
+    if (total <= 0.0f) {
+        skinned.joints[0] = influence_count ? (u8)joints[0] : 0;
+        skinned.weights[0] = 255;
+        return skinned;
+    }
+
+    // Rounding may leave the sum off by a little, which the heaviest takes up.
+    u32 quantized_total = 0;
+    for (u32 i = 0; i < kept_count; ++i) {
+        skinned.joints[i] = (u8)kept_joints[i];
+        skinned.weights[i] = (u8)(kept_weights[i] / total * 255.0f + 0.5f);
+        quantized_total += skinned.weights[i];
+    }
+    skinned.weights[0] = (u8)((i32)skinned.weights[0] + 255 - (i32)quantized_total);
+    return skinned;
+}
 
-    u32 removed_count = vertex_count - *out_vertex_count;
-    KDEBUG("geometry_deduplicate_vertices: removed %d vertices, orig/now %d/%d.", removed_count, vertex_count, *out_vertex_count);
+vec3 extents_3d_center(extents_3d extents) {
+    return vec3_mul_scalar(vec3_add(extents.min, extents.max), 0.5f);
+}
+
+vec3 extents_3d_half_extents(extents_3d extents) {
+    return vec3_mul_scalar(vec3_sub(extents.max, extents.min), 0.5f);
+}
+
+extents_3d extents_3d_merge(extents_3d a, extents_3d b) {
+    extents_3d merged;
+    for (u32 i = 0; i < 3; ++i) {
+        merged.min.elements[i] = KMIN(a.min.elements[i], b.min.elements[i]);
+        merged.max.elements[i] = KMAX(a.max.elements[i], b.max.elements[i]);
+    }
+    return merged;
+}
+
+extents_3d extents_3d_from_points(u32 point_count, const vec3* points) {
+    extents_3d extents = {points[0], points[0]};
+    for (u32 p = 1; p < point_count; ++p) {
+        for (u32 i = 0; i < 3; ++i) {
+            extents.min.elements[i] = KMIN(extents.min.elements[i], points[p].elements[i]);
+            extents.max.elements[i] = KMAX(extents.max.elements[i], points[p].elements[i]);
+        }
+    }
+    return extents;
+}
+
+extents_3d extents_3d_transform(extents_3d extents, mat4 m) {
+    vec3 center = vec3_mul_mat4(extents_3d_center(extents), m);
+    vec3 half_extents = extents_3d_half_extents(extents);
+
+    // Each world axis gets the local half-extents projected onto it, all taken as positive.
+    vec3 world_half_extents;
+    for (u32 j = 0; j < 3; ++j) {
+        world_half_extents.elements[j] =
+            half_extents.x * kabs(m.data[0 + j]) +
+            half_extents.y * kabs(m.data[4 + j]) +
+            half_extents.z * kabs(m.data[8 + j]);
+    }
+    return (extents_3d){vec3_sub(center, world_half_extents), vec3_add(center, world_half_extents)};
+}
+
+oriented_box oriented_box_from_extents(extents_3d extents, mat4 m) {
+    oriented_box box;
+    box.center = vec3_mul_mat4(extents_3d_center(extents), m);
+    vec3 half_extents = extents_3d_half_extents(extents);
+    for (u32 i = 0; i < 3; ++i) {
+        // The rows of the matrix are the transformed local axes, with the scale as their length.
+        vec3 axis = (vec3){m.data[i * 4 + 0], m.data[i * 4 + 1], m.data[i * 4 + 2]};
+        f32 scale = vec3_length(axis);
+        box.axes[i] = scale > K_FLOAT_EPSILON ? vec3_mul_scalar(axis, 1.0f / scale) : vec3_zero();
+        box.half_extents.elements[i] = half_extents.elements[i] * scale;
+    }
+    return box;
+}
+
+extents_3d oriented_box_extents(const oriented_box* box) {
+    vec3 world_half_extents;
+    for (u32 j = 0; j < 3; ++j) {
+        world_half_extents.elements[j] =
+            box->half_extents.x * kabs(box->axes[0].elements[j]) +
+            box->half_extents.y * kabs(box->axes[1].elements[j]) +
+            box->half_extents.z * kabs(box->axes[2].elements[j]);
+    }
+    return (extents_3d){vec3_sub(box->center, world_half_extents), vec3_add(box->center, world_half_extents)};
+}
+
+bounding_sphere bounding_sphere_from_extents(extents_3d extents) {
+    return (bounding_sphere){extents_3d_center(extents), vec3_length(extents_3d_half_extents(extents))};
+}
+
+bounding_sphere bounding_sphere_transform(bounding_sphere sphere, mat4 m) {
+    f32 scale_squared = 0;
+    for (u32 i = 0; i < 3; ++i) {
+        vec3 axis = (vec3){m.data[i * 4 + 0], m.data[i * 4 + 1], m.data[i * 4 + 2]};
+        scale_squared = KMAX(scale_squared, vec3_length_squared(axis));
+    }
+    return (bounding_sphere){vec3_mul_mat4(sphere.center, m), sphere.radius * ksqrt(scale_squared)};
+}
+
+bounding_sphere bounding_sphere_merge(bounding_sphere a, bounding_sphere b) {
+    vec3 offset = vec3_sub(b.center, a.center);
+    f32 distance = vec3_length(offset);
+    // One already contains the other.
+    if (distance + b.radius <= a.radius) {
+        return a;
+    }
+    if (distance + a.radius <= b.radius) {
+        return b;
+    }
+    f32 radius = (distance + a.radius + b.radius) * 0.5f;
+    // Move from a's center towards b's, so that the far sides of both lie on the new sphere.
+    vec3 center = vec3_add(a.center, vec3_mul_scalar(offset, (radius - a.radius) / distance));
+    return (bounding_sphere){center, radius};
+}
+
+ray ray_from_screen(f32 screen_x, f32 screen_y, f32 width, f32 height, mat4 view, mat4 projection) {
+    // The viewport is flipped, so the top of the screen is at +1 in normalized device coordinates.
+    f32 ndc_x = (2.0f * screen_x) / width - 1.0f;
+    f32 ndc_y = 1.0f - (2.0f * screen_y) / height;
+    mat4 inverse = mat4_inverse(mat4_mul(view, projection));
+    vec4 near_point = vec4_mul_mat4((vec4){ndc_x, ndc_y, -1.0f, 1.0f}, inverse);
+    vec4 far_point = vec4_mul_mat4((vec4){ndc_x, ndc_y, 1.0f, 1.0f}, inverse);
+    vec3 origin = vec3_mul_scalar(vec3_from_vec4(near_point), 1.0f / near_point.w);
+    vec3 end = vec3_mul_scalar(vec3_from_vec4(far_point), 1.0f / far_point.w);
+    return (ray){origin, vec3_normalized(vec3_sub(end, origin))};
+}
+
+b8 ray_intersects_extents(ray r, extents_3d extents, f32* out_distance) {
+    f32 t_min = 0.0f;
+    f32 t_max = K_INFINITY;
+    for (u32 axis = 0; axis < 3; ++axis) {
+        f32 origin = r.origin.elements[axis];
+        f32 direction = r.direction.elements[axis];
+        f32 min = extents.min.elements[axis];
+        f32 max = extents.max.elements[axis];
+        if (kabs(direction) < K_FLOAT_EPSILON) {
+            // Parallel to the slab, so must start within it.
+            if (origin < min || origin > max) {
+                return false;
+            }
+            continue;
+        }
+        f32 inverse_direction = 1.0f / direction;
+        f32 t0 = (min - origin) * inverse_direction;
+        f32 t1 = (max - origin) * inverse_direction;
+        if (t0 > t1) {
+            f32 temp = t0;
+            t0 = t1;
+            t1 = temp;
+        }
+        t_min = KMAX(t_min, t0);
+        t_max = KMIN(t_max, t1);
+        if (t_min > t_max) {
+            return false;
+        }
+    }
+    if (out_distance) {
+        *out_distance = t_min;
+    }
+    return true;
 }
@@ -4,6 +4,8 @@
 
 /**
  * @brief Calculates normals for the given vertex and index data. Modifies vertices in place.
+ * Vertices shared by several triangles get the average of their normals, weighted by area.
+ * Large meshes are processed in parallel on the job system.
  *
  * @param vertex_count The number of vertices.
  * @param vertices An array of vertices.
@@ -14,6 +16,9 @@ void geometry_generate_normals(u32 vertex_count, vertex_3d* vertices, u32 index_
 
 /**
  * @brief Calculates tangents for the given vertex and index data. Modifies vertices in place.
+ * As with MikkTSpace, the tangents of the triangles sharing a vertex are averaged, weighted by area,
+ * made perpendicular to the vertex normal, and given the handedness of the texture mapping, held here
+ * in the tangent's sign. Large meshes are processed in parallel on the job system.
  *
  * @param vertex_count The number of vertices.
  * @param vertices An array of vertices.
@@ -25,7 +30,8 @@ void geometry_generate_tangents(u32 vertex_count, vertex_3d* vertices, u32 index
 /**
  * @brief De-duplicates vertices, leaving only unique ones. Leaves the original vertices array intact.
  * Allocates a new array in out_vertices. Modifies indices in-place. Original
- * vertex array should be freed by caller.
+ * vertex array should be freed by caller. The same as geometry_weld_vertices with no epsilons,
+ * so only vertices with identical attributes are merged.
  *
  * @param vertex_count The number of vertices in the array.
  * @param vertices The original array of vertices to be de-duplicated. Not modified.
@@ -35,3 +41,273 @@ void geometry_generate_tangents(u32 vertex_count, vertex_3d* vertices, u32 index
  * @param out_vertices A pointer to hold the array of de-duplicated vertices.
  */
 void geometry_deduplicate_vertices(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices, u32* out_vertex_count, vertex_3d** out_vertices);
+
+/**
+ * @brief Welds vertices together, leaving only unique ones, in O(n) time using a hash table.
+ * Leaves the original vertices array intact. Allocates a new array in out_vertices, which holds
+ * the unique vertices in the order they first appear. Modifies indices in-place.
+ * Original vertex array should be freed by caller.
+ *
+ * Vertices are merged when their texture coordinates, colours and tangents are identical, and their
+ * positions and normals are either identical or, for a non-zero epsilon, fall into the same cell of
+ * a grid with cells epsilon across. Merged vertices take the attributes of the first of them.
+ *
+ * @param vertex_count The number of vertices in the array.
+ * @param vertices The original array of vertices to be welded. Not modified.
+ * @param index_count The number of indices in the array.
+ * @param indices The array of indices. Modified in-place to refer to the unique vertices.
+ * @param position_epsilon The size of the grid cells positions are merged within, or 0 to only merge identical positions.
+ * @param normal_epsilon The size of the grid cells normals are merged within, or 0 to only merge identical normals.
+ * @param out_vertex_count A pointer to hold the final vertex count.
+ * @param out_vertices A pointer to hold the array of welded vertices.
+ */
+KAPI void geometry_weld_vertices(u32 vertex_count, const vertex_3d* vertices, u32 index_count, u32* indices, f32 position_epsilon, f32 normal_epsilon, u32* out_vertex_count, vertex_3d** out_vertices);
+
+/** @brief The number of vertices in the post-transform cache that index buffers are optimized for. */
+#define GEOMETRY_VERTEX_CACHE_SIZE 16
+
+/**
+ * @brief Obtains the average cache miss ratio (ACMR) of the given index buffer, which is the number of
+ * vertices shaded per triangle with a first-in-first-out post-transform cache of the given size.
+ * Lies between 0.5 for the best possible ordering of a large mesh and 3 for the worst.
+ *
+ * @param vertex_count The number of vertices.
+ * @param index_count The number of indices in the array.
+ * @param indices The array of indices.
+ * @param cache_size The number of vertices the cache holds, such as GEOMETRY_VERTEX_CACHE_SIZE.
+ * @return The average cache miss ratio.
+ */
+KAPI f32 geometry_acmr(u32 vertex_count, u32 index_count, const u32* indices, u32 cache_size);
+
+/**
+ * @brief Reorders triangles to make better use of the post-transform vertex cache, using Tipsify.
+ * Triangles are emitted in fans around vertices chosen to still be in the cache, in O(n) time.
+ * Modifies indices in-place.
+ *
+ * @param vertex_count The number of vertices.
+ * @param index_count The number of indices in the array.
+ * @param indices The array of indices. Modified in-place.
+ * @param cache_size The number of vertices the cache holds, such as GEOMETRY_VERTEX_CACHE_SIZE.
+ */
+KAPI void geometry_optimize_vertex_cache(u32 vertex_count, u32 index_count, u32* indices, u32 cache_size);
+
+/**
+ * @brief Reorders clusters of triangles so that those facing outwards from the middle of the mesh are
+ * drawn first, so that they hide more of the rest from being shaded. Clusters are split where the
+ * triangle order already misses the cache entirely, so this should be run after
+ * geometry_optimize_vertex_cache, and costs it little. Modifies indices in-place.
+ *
+ * @param vertex_count The number of vertices.
+ * @param vertices The array of vertices. Not modified.
+ * @param index_count The number of indices in the array.
+ * @param indices The array of indices. Modified in-place.
+ * @param cache_size The number of vertices the cache holds, such as GEOMETRY_VERTEX_CACHE_SIZE.
+ */
+KAPI void geometry_optimize_overdraw(u32 vertex_count, const vertex_3d* vertices, u32 index_count, u32* indices, u32 cache_size);
+
+/**
+ * @brief Reorders vertices into the order the index buffer first uses them, so that they are fetched
+ * in order from memory. Unused vertices are moved to the end. Should be run after the index buffer
+ * is reordered. Modifies vertices and indices in-place.
+ *
+ * @param vertex_count The number of vertices.
+ * @param vertices The array of vertices. Modified in-place.
+ * @param index_count The number of indices in the array.
+ * @param indices The array of indices. Modified in-place.
+ */
+KAPI void geometry_optimize_vertex_fetch(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices);
+
+/**
+ * @brief Simplifies the given triangles by collapsing edges, cheapest first by quadric error, until at
+ * most target_index_count indices remain or no collapse stays within target_error. Vertices only move onto
+ * others, so the result uses the same vertex array. Vertices on the border of the mesh, or on a seam
+ * where another vertex shares their position, are never moved, so the result has no new holes or cracks.
+ *
+ * @param vertex_count The number of vertices.
+ * @param vertices The array of vertices. Not modified.
+ * @param index_count The number of indices in the array.
+ * @param indices The array of indices. Not modified.
+ * @param target_index_count The number of indices to reduce to.
+ * @param target_error The largest distance any part of the surface may move, relative to the radius of the sphere around it.
+ * @param out_indices An array of at least index_count indices to hold the simplified triangles.
+ * @param out_error A pointer to hold the largest distance the surface moved, relative in the same way. Optional.
+ * @return The number of indices written to out_indices.
+ */
+KAPI u32 geometry_simplify(u32 vertex_count, const vertex_3d* vertices, u32 index_count, const u32* indices, u32 target_index_count, f32 target_error, u32* out_indices, f32* out_error);
+
+/** @brief The most vertices a meshlet built by geometry_build_meshlets uses, as many as a mesh shader typically emits. */
+#define GEOMETRY_MESHLET_MAX_VERTICES 64
+/** @brief The most triangles a meshlet built by geometry_build_meshlets holds. */
+#define GEOMETRY_MESHLET_MAX_TRIANGLES 124
+
+/**
+ * @brief Splits the given triangles into meshlets, each using at most max_vertices vertices and holding
+ * at most max_triangles triangles. Triangles are taken in order, so each meshlet is a range of the
+ * indices, and those ordered by geometry_optimize_vertex_cache make meshlets which are close together
+ * and share most of their vertices. Each meshlet gets its extents and the cone its triangles face within.
+ *
+ * @param vertex_count The number of vertices.
+ * @param vertices The array of vertices. Not modified.
+ * @param index_count The number of indices, such as those of the full level of detail only.
+ * @param indices The array of indices. Not modified.
+ * @param max_vertices The most vertices of a meshlet, such as GEOMETRY_MESHLET_MAX_VERTICES. At least 3.
+ * @param max_triangles The most triangles of a meshlet, such as GEOMETRY_MESHLET_MAX_TRIANGLES. At least 1.
+ * @param out_meshlets A pointer to hold the array of meshlets, to be freed by the caller with kfree and MEMORY_TAG_ARRAY. 0 if there are none.
+ * @return The number of meshlets.
+ */
+KAPI u32 geometry_build_meshlets(u32 vertex_count, const vertex_3d* vertices, u32 index_count, const u32* indices, u32 max_vertices, u32 max_triangles, geometry_meshlet** out_meshlets);
+
+/**
+ * @brief Packs a vertex into the compact form uploaded to the GPU. Texture coordinates
+ * become half precision floats, so lose precision beyond a few hundred repeats of a texture.
+ *
+ * @param vertex A constant pointer to the vertex to be packed.
+ * @return The packed vertex.
+ */
+KAPI vertex_3d_packed vertex_3d_pack(const vertex_3d* vertex);
+
+/**
+ * @brief Unpacks a vertex packed by vertex_3d_pack.
+ *
+ * @param packed A constant pointer to the packed vertex.
+ * @return The unpacked vertex, with normalized normal and tangent.
+ */
+KAPI vertex_3d vertex_3d_unpack(const vertex_3d_packed* packed);
+
+/**
+ * @brief Packs an array of vertices into the compact form uploaded to the GPU.
+ *
+ * @param vertex_count The number of vertices.
+ * @param vertices The array of vertices to be packed.
+ * @param out_vertices An array of at least vertex_count packed vertices to hold the result.
+ */
+KAPI void geometry_pack_vertices(u32 vertex_count, const vertex_3d* vertices, vertex_3d_packed* out_vertices);
+
+/**
+ * @brief Packs a vertex and the joints influencing it into the form read by the skinning shader.
+ * Only the VERTEX_MAX_JOINT_INFLUENCES heaviest influences are kept, and their weights are
+ * normalized and quantized to unorm8 values summing exactly to 255. A vertex with no weight is
+ * bound wholly to its first joint, or to joint 0 if it has none.
+ *
+ * @param vertex A constant pointer to the vertex to be packed, in the bind pose.
+ * @param influence_count The number of joints influencing the vertex.
+ * @param joints The indices of the joints influencing the vertex, each below 256.
+ * @param weights The weight of each joint. Need not be normalized.
+ * @return The packed vertex.
+ */
+KAPI vertex_3d_skinned vertex_3d_skinned_pack(const vertex_3d* vertex, u32 influence_count, const u32* joints, const f32* weights);
+
+/**
+ * @brief Obtains the center of the given extents.
+ *
+ * @param extents The extents.
+ * @return The center.
+ */
+KAPI vec3 extents_3d_center(extents_3d extents);
+
+/**
+ * @brief Obtains the half-size of the given extents along each axis.
+ *
+ * @param extents The extents.
+ * @return The half-extents.
+ */
+KAPI vec3 extents_3d_half_extents(extents_3d extents);
+
+/**
+ * @brief Obtains the smallest extents containing both of the given ones.
+ *
+ * @param a The first extents.
+ * @param b The second extents.
+ * @return The merged extents.
+ */
+KAPI extents_3d extents_3d_merge(extents_3d a, extents_3d b);
+
+/**
+ * @brief Obtains the smallest extents containing the given points.
+ *
+ * @param point_count The number of points. Must be at least 1.
+ * @param points The array of points.
+ * @return The extents of the points.
+ */
+KAPI extents_3d extents_3d_from_points(u32 point_count, const vec3* points);
+
+/**
+ * @brief Obtains the axis-aligned extents containing the given ones after they are transformed by
+ * the given matrix. Transforms the center and half-extents separately, using the absolute values of
+ * the matrix for the latter, so that all eight corners are enclosed without transforming each of them.
+ *
+ * @param extents The extents in local space.
+ * @param m The matrix to transform by, such as a world matrix.
+ * @return The transformed extents.
+ */
+KAPI extents_3d extents_3d_transform(extents_3d extents, mat4 m);
+
+/**
+ * @brief Transforms the given extents by the given matrix, keeping the box the extents describe
+ * rather than enclosing it in a new axis-aligned one. The matrix should have no shear.
+ *
+ * @param extents The extents in local space.
+ * @param m The matrix to transform by, such as a world matrix.
+ * @return The transformed box.
+ */
+KAPI oriented_box oriented_box_from_extents(extents_3d extents, mat4 m);
+
+/**
+ * @brief Obtains the axis-aligned extents containing the given box.
+ *
+ * @param box A constant pointer to the box.
+ * @return The extents of the box.
+ */
+KAPI extents_3d oriented_box_extents(const oriented_box* box);
+
+/**
+ * @brief Obtains the sphere passing through the corners of the given extents.
+ *
+ * @param extents The extents.
+ * @return The bounding sphere.
+ */
+KAPI bounding_sphere bounding_sphere_from_extents(extents_3d extents);
+
+/**
+ * @brief Transforms the given sphere by the given matrix. The radius is scaled by the largest scale
+ * in the matrix, so the result encloses the transformed sphere even when the scale is not uniform.
+ *
+ * @param sphere The sphere in local space.
+ * @param m The matrix to transform by, such as a world matrix.
+ * @return The transformed sphere.
+ */
+KAPI bounding_sphere bounding_sphere_transform(bounding_sphere sphere, mat4 m);
+
+/**
+ * @brief Obtains the smallest sphere containing both of the given ones.
+ *
+ * @param a The first sphere.
+ * @param b The second sphere.
+ * @return The merged sphere.
+ */
+KAPI bounding_sphere bounding_sphere_merge(bounding_sphere a, bounding_sphere b);
+
+/**
+ * @brief Obtains the ray through the given point on the screen, from the near clip plane away from
+ * the camera. Screen coordinates start at the top left, as window and mouse coordinates do.
+ *
+ * @param screen_x The x-coordinate of the point in pixels.
+ * @param screen_y The y-coordinate of the point in pixels.
+ * @param width The width of the screen in pixels.
+ * @param height The height of the screen in pixels.
+ * @param view The view matrix the scene is drawn with.
+ * @param projection The projection matrix the scene is drawn with.
+ * @return The ray in world space.
+ */
+KAPI ray ray_from_screen(f32 screen_x, f32 screen_y, f32 width, f32 height, mat4 view, mat4 projection);
+
+/**
+ * @brief Tests whether the given ray passes through the given extents, using the slab method.
+ *
+ * @param r The ray.
+ * @param extents The extents, in the same space as the ray.
+ * @param out_distance A pointer to hold the distance along the ray to where it enters the extents, or 0 if
+ * it starts inside them. Optional.
+ * @return True if the ray hits the extents; otherwise false.
+ */
+KAPI b8 ray_intersects_extents(ray r, extents_3d extents, f32* out_distance);
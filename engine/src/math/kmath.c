@@ -1,10 +1,8 @@
 #include "kmath.h"
+#include "core/asserts.h"
 #include "platform/platform.h"
 
 #include <math.h>
-#include <stdlib.h>
-
-static b8 rand_seeded = false;
 
 /**
  * Note that these are here in order to prevent having to import the
@@ -34,28 +32,261 @@ f32 kabs(f32 x) {
     return fabsf(x);
 }
 
+f32 klog(f32 x) {
+    return logf(x);
+}
+
+f32 kexp(f32 x) {
+    return expf(x);
+}
+
+// Seeded from the time the first time each thread uses it.
+static _Thread_local krandom_state thread_random;
+static _Thread_local b8 thread_random_seeded;
+
 i32 krandom() {
-    if (!rand_seeded) {
-        srand((u32)platform_get_absolute_time());
-        rand_seeded = true;
-    }
-    return rand();
+    return (i32)(krandom_state_u32(krandom_thread_state()) >> 1);
 }
 
 i32 krandom_in_range(i32 min, i32 max) {
-    if (!rand_seeded) {
-        srand((u32)platform_get_absolute_time());
-        rand_seeded = true;
-    }
-    return (rand() % (max - min + 1)) + min;
+    return krandom_state_in_range(krandom_thread_state(), min, max);
 }
 
 f32 fkrandom() {
-    return (float)krandom() / (f32)RAND_MAX;
+    return krandom_state_f32(krandom_thread_state());
 }
 
 f32 fkrandom_in_range(f32 min, f32 max) {
-    return min + ((float)krandom() / ((f32)RAND_MAX / (max - min)));
+    return krandom_state_f32_in_range(krandom_thread_state(), min, max);
+}
+
+// splitmix64, which spreads any seed over the generator's state.
+static u64 krandom_splitmix(u64* x) {
+    u64 z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+void krandom_state_seed(krandom_state* state, u64 seed) {
+    for (u32 i = 0; i < 4; ++i) {
+        state->s[i] = krandom_splitmix(&seed);
+    }
+}
+
+void krandom_state_jump(krandom_state* state) {
+    static const u64 jump[4] = {0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull, 0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull};
+    u64 s[4] = {0};
+    for (u32 i = 0; i < 4; ++i) {
+        for (u32 b = 0; b < 64; ++b) {
+            if (jump[i] & (1ull << b)) {
+                s[0] ^= state->s[0];
+                s[1] ^= state->s[1];
+                s[2] ^= state->s[2];
+                s[3] ^= state->s[3];
+            }
+            krandom_state_next(state);
+        }
+    }
+    for (u32 i = 0; i < 4; ++i) {
+        state->s[i] = s[i];
+    }
+}
+
+i32 krandom_state_in_range(krandom_state* state, i32 min, i32 max) {
+    u64 range = (u64)((i64)max - (i64)min) + 1;
+    if (range > 0xFFFFFFFFull) {
+        return (i32)krandom_state_u32(state);
+    }
+    // Scale into the range by multiplying, rejecting the few products which would make some values more likely.
+    u64 product = (u64)krandom_state_u32(state) * range;
+    if ((u32)product < (u32)range) {
+        u32 threshold = (u32)(0x100000000ull % range);
+        while ((u32)product < threshold) {
+            product = (u64)krandom_state_u32(state) * range;
+        }
+    }
+    return (i32)((i64)min + (i64)(product >> 32));
+}
+
+void krandom_state_fill_u32(krandom_state* state, u32 count, u32* out_values) {
+    // Work on a copy, so that the state stays in registers rather than being stored after each value.
+    krandom_state local = *state;
+    for (u32 i = 0; i < count; ++i) {
+        out_values[i] = krandom_state_u32(&local);
+    }
+    *state = local;
+}
+
+void krandom_state_fill_f32(krandom_state* state, u32 count, f32 min, f32 max, f32* out_values) {
+    krandom_state local = *state;
+    for (u32 i = 0; i < count; ++i) {
+        out_values[i] = krandom_state_f32_in_range(&local, min, max);
+    }
+    *state = local;
+}
+
+krandom_state* krandom_thread_state(void) {
+    if (!thread_random_seeded) {
+        // Mix in the state's address, which differs between threads, so threads starting together differ.
+        union {
+            f64 f;
+            u64 u;
+        } time = {platform_get_absolute_time()};
+        krandom_state_seed(&thread_random, time.u ^ (u64)&thread_random);
+        thread_random_seeded = true;
+    }
+    return &thread_random;
+}
+
+// A well-mixed hash of a lattice point.
+static u32 noise_hash(i32 x, i32 y, i32 z, u32 seed) {
+    u32 h = seed ^ ((u32)x * 0x8DA6B343u) ^ ((u32)y * 0xD8163841u) ^ ((u32)z * 0xCB1AB31Fu);
+    h ^= h >> 16;
+    h *= 0x7FEB352Du;
+    h ^= h >> 15;
+    h *= 0x846CA68Bu;
+    h ^= h >> 16;
+    return h;
+}
+
+// The directions to the middles of a cube's edges, with four repeated to make 16.
+static const f32 noise_gradients[16][3] = {
+    {1, 1, 0}, {-1, 1, 0}, {1, -1, 0}, {-1, -1, 0}, {1, 0, 1}, {-1, 0, 1}, {1, 0, -1}, {-1, 0, -1},
+    {0, 1, 1}, {0, -1, 1}, {0, 1, -1}, {0, -1, -1}, {1, 1, 0}, {-1, 1, 0}, {0, -1, 1}, {0, -1, -1}};
+
+static f32 noise_lattice_value(u32 hash) {
+    return (f32)(hash >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+// The quintic which blends between lattice points, so that the noise has smooth derivatives.
+static f32 noise_fade(f32 t) {
+    return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+static f32 noise_lerp(f32 a, f32 b, f32 t) {
+    return a + (b - a) * t;
+}
+
+// Blends the values at a cell's corners, numbered with x in bit 0, y in bit 1 and z in bit 2.
+static f32 noise_blend(const f32 corners[8], f32 u, f32 v, f32 w) {
+    f32 x00 = noise_lerp(corners[0], corners[1], u);
+    f32 x10 = noise_lerp(corners[2], corners[3], u);
+    f32 x01 = noise_lerp(corners[4], corners[5], u);
+    f32 x11 = noise_lerp(corners[6], corners[7], u);
+    return noise_lerp(noise_lerp(x00, x10, v), noise_lerp(x01, x11, v), w);
+}
+
+f32 noise_perlin_3d(f32 x, f32 y, f32 z, u32 seed) {
+    f32 fx = floorf(x), fy = floorf(y), fz = floorf(z);
+    i32 ix = (i32)fx, iy = (i32)fy, iz = (i32)fz;
+    f32 tx = x - fx, ty = y - fy, tz = z - fz;
+    f32 corners[8];
+    for (u32 c = 0; c < 8; ++c) {
+        u32 dx = c & 1, dy = (c >> 1) & 1, dz = c >> 2;
+        const f32* g = noise_gradients[noise_hash(ix + (i32)dx, iy + (i32)dy, iz + (i32)dz, seed) & 15];
+        corners[c] = g[0] * (tx - (f32)dx) + g[1] * (ty - (f32)dy) + g[2] * (tz - (f32)dz);
+    }
+    return noise_blend(corners, noise_fade(tx), noise_fade(ty), noise_fade(tz));
+}
+
+f32 noise_value_3d(f32 x, f32 y, f32 z, u32 seed) {
+    f32 fx = floorf(x), fy = floorf(y), fz = floorf(z);
+    i32 ix = (i32)fx, iy = (i32)fy, iz = (i32)fz;
+    f32 corners[8];
+    for (u32 c = 0; c < 8; ++c) {
+        corners[c] = noise_lattice_value(noise_hash(ix + (i32)(c & 1), iy + (i32)((c >> 1) & 1), iz + (i32)(c >> 2), seed));
+    }
+    return noise_blend(corners, noise_fade(x - fx), noise_fade(y - fy), noise_fade(z - fz));
+}
+
+#if defined(KSIMD_ENABLED)
+static KINLINE ksimd_f32x4 noise_fade_x4(ksimd_f32x4 t) {
+    ksimd_f32x4 inner = ksimd_madd(ksimd_splat(-15.0f), t, ksimd_splat(6.0f));
+    inner = ksimd_madd(ksimd_splat(10.0f), t, inner);
+    return ksimd_mul(ksimd_mul(ksimd_mul(t, t), t), inner);
+}
+
+static KINLINE ksimd_f32x4 noise_lerp_x4(ksimd_f32x4 a, ksimd_f32x4 b, ksimd_f32x4 t) {
+    return ksimd_madd(a, ksimd_sub(b, a), t);
+}
+
+static KINLINE ksimd_f32x4 noise_blend_x4(const ksimd_f32x4 corners[8], ksimd_f32x4 u, ksimd_f32x4 v, ksimd_f32x4 w) {
+    ksimd_f32x4 x00 = noise_lerp_x4(corners[0], corners[1], u);
+    ksimd_f32x4 x10 = noise_lerp_x4(corners[2], corners[3], u);
+    ksimd_f32x4 x01 = noise_lerp_x4(corners[4], corners[5], u);
+    ksimd_f32x4 x11 = noise_lerp_x4(corners[6], corners[7], u);
+    return noise_lerp_x4(noise_lerp_x4(x00, x10, v), noise_lerp_x4(x01, x11, v), w);
+}
+
+// Splits four points into their cells and their positions within them. Hashing stays scalar, as there are no integer lanes.
+static KINLINE void noise_cells_x4(const f32* x, const f32* y, const f32* z, ksimd_f32x4 t[3], i32 cells[3][4]) {
+    const f32* source[3] = {x, y, z};
+    for (u32 axis = 0; axis < 3; ++axis) {
+        ksimd_f32x4 p = ksimd_load(source[axis]);
+        ksimd_f32x4 floored = ksimd_floor(p);
+        t[axis] = ksimd_sub(p, floored);
+        f32 lanes[4];
+        ksimd_store(lanes, floored);
+        for (u32 lane = 0; lane < 4; ++lane) {
+            cells[axis][lane] = (i32)lanes[lane];
+        }
+    }
+}
+#endif
+
+void noise_perlin_3d_batch(u32 count, const f32* x, const f32* y, const f32* z, u32 seed, f32* out_values) {
+    u32 i = 0;
+#if defined(KSIMD_ENABLED)
+    ksimd_f32x4 one = ksimd_splat(1.0f);
+    for (; i + 4 <= count; i += 4) {
+        ksimd_f32x4 t[3];
+        i32 cells[3][4];
+        noise_cells_x4(x + i, y + i, z + i, t, cells);
+        ksimd_f32x4 corners[8];
+        for (u32 c = 0; c < 8; ++c) {
+            u32 dx = c & 1, dy = (c >> 1) & 1, dz = c >> 2;
+            f32 g[3][4];
+            for (u32 lane = 0; lane < 4; ++lane) {
+                const f32* gradient = noise_gradients[noise_hash(cells[0][lane] + (i32)dx, cells[1][lane] + (i32)dy, cells[2][lane] + (i32)dz, seed) & 15];
+                g[0][lane] = gradient[0];
+                g[1][lane] = gradient[1];
+                g[2][lane] = gradient[2];
+            }
+            ksimd_f32x4 ox = dx ? ksimd_sub(t[0], one) : t[0];
+            ksimd_f32x4 oy = dy ? ksimd_sub(t[1], one) : t[1];
+            ksimd_f32x4 oz = dz ? ksimd_sub(t[2], one) : t[2];
+            corners[c] = ksimd_madd(ksimd_madd(ksimd_mul(ksimd_load(g[0]), ox), ksimd_load(g[1]), oy), ksimd_load(g[2]), oz);
+        }
+        ksimd_store(out_values + i, noise_blend_x4(corners, noise_fade_x4(t[0]), noise_fade_x4(t[1]), noise_fade_x4(t[2])));
+    }
+#endif
+    for (; i < count; ++i) {
+        out_values[i] = noise_perlin_3d(x[i], y[i], z[i], seed);
+    }
+}
+
+void noise_value_3d_batch(u32 count, const f32* x, const f32* y, const f32* z, u32 seed, f32* out_values) {
+    u32 i = 0;
+#if defined(KSIMD_ENABLED)
+    for (; i + 4 <= count; i += 4) {
+        ksimd_f32x4 t[3];
+        i32 cells[3][4];
+        noise_cells_x4(x + i, y + i, z + i, t, cells);
+        ksimd_f32x4 corners[8];
+        for (u32 c = 0; c < 8; ++c) {
+            f32 values[4];
+            for (u32 lane = 0; lane < 4; ++lane) {
+                values[lane] = noise_lattice_value(noise_hash(cells[0][lane] + (i32)(c & 1), cells[1][lane] + (i32)((c >> 1) & 1), cells[2][lane] + (i32)(c >> 2), seed));
+            }
+            corners[c] = ksimd_load(values);
+        }
+        ksimd_store(out_values + i, noise_blend_x4(corners, noise_fade_x4(t[0]), noise_fade_x4(t[1]), noise_fade_x4(t[2])));
+    }
+#endif
+    for (; i < count; ++i) {
+        out_values[i] = noise_value_3d(x[i], y[i], z[i], seed);
+    }
 }
 
 plane_3d plane_3d_create(vec3 p1, vec3 norm) {
@@ -117,3 +348,194 @@ b8 frustum_intersects_aabb(const frustum* f, const vec3* center, const vec3* ext
     }
     return true;
 }
+
+static b8 frustum_intersects_aabb_at(const frustum* f, const aabb_soa* boxes, u32 index) {
+    vec3 center = {boxes->center_x[index], boxes->center_y[index], boxes->center_z[index]};
+    vec3 extents = {boxes->extents_x[index], boxes->extents_y[index], boxes->extents_z[index]};
+    return frustum_intersects_aabb(f, &center, &extents);
+}
+
+#if defined(KSIMD_ENABLED)
+// A plane's normal, absolute normal and distance, each copied across all lanes.
+typedef ksimd_f32x4 plane_x4[7];
+
+static KINLINE ksimd_mask4 plane_intersects_aabb_x4(const plane_x4 plane, ksimd_f32x4 cx, ksimd_f32x4 cy, ksimd_f32x4 cz, ksimd_f32x4 ex, ksimd_f32x4 ey, ksimd_f32x4 ez, ksimd_f32x4 zero) {
+    ksimd_f32x4 distance = ksimd_madd(ksimd_madd(ksimd_mul(plane[0], cx), plane[1], cy), plane[2], cz);
+    distance = ksimd_sub(distance, plane[6]);
+    ksimd_f32x4 radius = ksimd_madd(ksimd_madd(ksimd_mul(plane[3], ex), plane[4], ey), plane[5], ez);
+    return ksimd_cmpge(distance, ksimd_sub(zero, radius));
+}
+#endif
+
+void frustum_intersects_aabb_batch(const frustum* f, const aabb_soa* boxes, u32 start, u32 end, u64* out_visibility) {
+    KASSERT_MSG((start % 64) == 0, "frustum_intersects_aabb_batch - start must be a multiple of 64.");
+
+#if defined(KSIMD_ENABLED)
+    plane_x4 planes[6];
+    for (u32 p = 0; p < 6; ++p) {
+        const plane_3d* plane = &f->sides[p];
+        planes[p][0] = ksimd_splat(plane->normal.x);
+        planes[p][1] = ksimd_splat(plane->normal.y);
+        planes[p][2] = ksimd_splat(plane->normal.z);
+        planes[p][3] = ksimd_splat(kabs(plane->normal.x));
+        planes[p][4] = ksimd_splat(kabs(plane->normal.y));
+        planes[p][5] = ksimd_splat(kabs(plane->normal.z));
+        planes[p][6] = ksimd_splat(plane->distance);
+    }
+    ksimd_f32x4 zero = ksimd_splat(0.0f);
+#endif
+
+    u32 i = start;
+    while (i < end) {
+        u32 word_end = (i - i % 64) + 64;
+        word_end = KMIN(word_end, end);
+        u64 word = 0;
+#if defined(KSIMD_ENABLED)
+        // Four boxes at a time. Like plane_intersects_aabb, a box is outside a plane
+        // if its center is further behind it than the box's projected radius.
+        for (; i + 4 <= word_end; i += 4) {
+            ksimd_f32x4 cx = ksimd_load(boxes->center_x + i);
+            ksimd_f32x4 cy = ksimd_load(boxes->center_y + i);
+            ksimd_f32x4 cz = ksimd_load(boxes->center_z + i);
+            ksimd_f32x4 ex = ksimd_load(boxes->extents_x + i);
+            ksimd_f32x4 ey = ksimd_load(boxes->extents_y + i);
+            ksimd_f32x4 ez = ksimd_load(boxes->extents_z + i);
+            ksimd_mask4 visible = plane_intersects_aabb_x4(planes[0], cx, cy, cz, ex, ey, ez, zero);
+            for (u32 p = 1; p < 6; ++p) {
+                visible = ksimd_mask_and(visible, plane_intersects_aabb_x4(planes[p], cx, cy, cz, ex, ey, ez, zero));
+            }
+            word |= (u64)ksimd_mask_bits(visible) << (i % 64);
+        }
+#endif
+        for (; i < word_end; ++i) {
+            if (frustum_intersects_aabb_at(f, boxes, i)) {
+                word |= 1ull << (i % 64);
+            }
+        }
+        out_visibility[(i - 1) / 64] = word;
+    }
+}
+
+// Rounds to the nearest of the 16-bit signed normalized values, which a shader reads as value / 32767.
+static u32 snorm16_from_f32(f32 value) {
+    value = KCLAMP(value, -1.0f, 1.0f);
+    return (u16)(i16)(value * 32767.0f + (value >= 0.0f ? 0.5f : -0.5f));
+}
+
+static f32 snorm16_to_f32(u32 value) {
+    f32 result = (i16)(u16)value / 32767.0f;
+    return KMAX(result, -1.0f);
+}
+
+u32 vec3_to_octahedral_snorm16(vec3 v) {
+    // Project onto the octahedron |x| + |y| + |z| = 1, then fold the lower half over the upper.
+    f32 length = kabs(v.x) + kabs(v.y) + kabs(v.z);
+    if (length == 0.0f) {
+        return 0;
+    }
+    f32 x = v.x / length;
+    f32 y = v.y / length;
+    if (v.z < 0.0f) {
+        f32 folded_x = (1.0f - kabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        y = (1.0f - kabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = folded_x;
+    }
+    return snorm16_from_f32(x) | (snorm16_from_f32(y) << 16);
+}
+
+vec3 octahedral_snorm16_to_vec3(u32 encoded) {
+    f32 x = snorm16_to_f32(encoded & 0xFFFF);
+    f32 y = snorm16_to_f32(encoded >> 16);
+    vec3 v = {x, y, 1.0f - kabs(x) - kabs(y)};
+    if (v.z < 0.0f) {
+        v.x = (1.0f - kabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        v.y = (1.0f - kabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return vec3_normalized(v);
+}
+
+u16 f32_to_half(f32 value) {
+    union {
+        f32 f;
+        u32 u;
+    } bits = {value};
+    u32 sign = (bits.u >> 16) & 0x8000;
+    u32 exponent = (bits.u >> 23) & 0xFF;
+    u32 mantissa = bits.u & 0x7FFFFF;
+
+    // Infinity and NaN, keeping NaNs quiet.
+    if (exponent == 0xFF) {
+        return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+    }
+
+    i32 half_exponent = (i32)exponent - 127 + 15;
+    if (half_exponent >= 0x1F) {
+        return sign | 0x7C00;
+    }
+    if (half_exponent <= 0) {
+        // Too small for a normal half, so a subnormal one or zero.
+        if (half_exponent < -10) {
+            return sign;
+        }
+        mantissa |= 0x800000;
+        u32 shift = 14 - half_exponent;
+        u32 half_mantissa = mantissa >> shift;
+        u32 remainder = mantissa & ((1u << shift) - 1);
+        u32 halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half_mantissa & 1))) {
+            half_mantissa++;
+        }
+        return sign | half_mantissa;
+    }
+
+    // Round to nearest even. A carry out of the mantissa correctly bumps the exponent.
+    u32 half = sign | ((u32)half_exponent << 10) | (mantissa >> 13);
+    u32 remainder = mantissa & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) {
+        half++;
+    }
+    return (u16)half;
+}
+
+f32 half_to_f32(u16 value) {
+    u32 sign = (u32)(value & 0x8000) << 16;
+    u32 exponent = (value >> 10) & 0x1F;
+    u32 mantissa = value & 0x3FF;
+    union {
+        u32 u;
+        f32 f;
+    } bits;
+    if (exponent == 0x1F) {
+        bits.u = sign | 0x7F800000 | (mantissa << 13);
+    } else if (exponent) {
+        bits.u = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    } else if (mantissa) {
+        // Subnormal halves are normal floats, so normalize the mantissa.
+        exponent = 113;
+        while (!(mantissa & 0x400)) {
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits.u = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+    } else {
+        bits.u = sign;
+    }
+    return bits.f;
+}
+
+u32 vec4_to_unorm8(vec4 v) {
+    u32 result = 0;
+    for (u32 i = 0; i < 4; ++i) {
+        f32 value = KCLAMP(v.elements[i], 0.0f, 1.0f);
+        result |= (u32)(value * 255.0f + 0.5f) << (i * 8);
+    }
+    return result;
+}
+
+vec4 unorm8_to_vec4(u32 encoded) {
+    vec4 result;
+    for (u32 i = 0; i < 4; ++i) {
+        result.elements[i] = ((encoded >> (i * 8)) & 0xFF) / 255.0f;
+    }
+    return result;
+}
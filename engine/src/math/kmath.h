@@ -14,6 +14,7 @@
 
 #include "defines.h"
 #include "math_types.h"
+#include "ksimd.h"
 #include "core/kmemory.h"
 
 /** @brief An approximate representation of PI. */
@@ -116,6 +117,22 @@ KAPI f32 ksqrt(f32 x);
  */
 KAPI f32 kabs(f32 x);
 
+/**
+ * @brief Calculates the natural logarithm of x.
+ * 
+ * @param x The number to calculate the logarithm of. Must be positive.
+ * @return The natural logarithm of x.
+ */
+KAPI f32 klog(f32 x);
+
+/**
+ * @brief Calculates e raised to the power of x.
+ * 
+ * @param x The power.
+ * @return e raised to the power of x.
+ */
+KAPI f32 kexp(f32 x);
+
 /**
  * @brief Indicates if the value is a power of 2. 0 is considered _not_ a power of 2.
  * @param value The value to be interpreted.
@@ -126,14 +143,14 @@ KINLINE b8 is_power_of_2(u64 value) {
 }
 
 /**
- * @brief Returns a random integer.
+ * @brief Returns a random non-negative integer, from the calling thread's generator.
  * 
  * @return A random integer.
  */
 KAPI i32 krandom();
 
 /**
- * @brief Returns a random integer that is within the given range (inclusive).
+ * @brief Returns a random integer that is within the given range (inclusive), from the calling thread's generator.
  * 
  * @param min The minimum of the range.
  * @param max The maximum of the range.
@@ -142,14 +159,14 @@ KAPI i32 krandom();
 KAPI i32 krandom_in_range(i32 min, i32 max);
 
 /**
- * @brief Returns a random floating-point number.
+ * @brief Returns a random floating-point number in [0, 1), from the calling thread's generator.
  * 
  * @return A random floating-point number.
  */
 KAPI f32 fkrandom();
 
 /**
- * @brief Returns a random floating-point number that is within the given range (inclusive).
+ * @brief Returns a random floating-point number that is within the given range, from the calling thread's generator.
  * 
  * @param min The minimum of the range.
  * @param max The maximum of the range.
@@ -157,6 +174,168 @@ KAPI f32 fkrandom();
  */
 KAPI f32 fkrandom_in_range(f32 min, f32 max);
 
+/**
+ * @brief Seeds a random number generator. The same seed always gives the same sequence.
+ *
+ * @param state A pointer to the generator to seed.
+ * @param seed The seed. Any value, including 0, is valid.
+ */
+KAPI void krandom_state_seed(krandom_state* state, u64 seed);
+
+/**
+ * @brief Advances a generator as if it had been called 2^128 times. Generators seeded alike
+ * and then jumped a different number of times give sequences which cannot overlap in practice,
+ * such as for giving each job thread its own stream from one seed.
+ *
+ * @param state A pointer to the generator to advance.
+ */
+KAPI void krandom_state_jump(krandom_state* state);
+
+/**
+ * @brief Returns the next 64 random bits of the given generator.
+ *
+ * @param state A pointer to the generator.
+ * @return A random 64-bit integer.
+ */
+KINLINE u64 krandom_state_next(krandom_state* state) {
+    u64* s = state->s;
+    u64 x = s[1] * 5;
+    u64 result = ((x << 7) | (x >> 57)) * 9;
+    u64 t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 45) | (s[3] >> 19);
+    return result;
+}
+
+/**
+ * @brief Returns a random 32-bit integer from the given generator.
+ *
+ * @param state A pointer to the generator.
+ * @return A random 32-bit integer.
+ */
+KINLINE u32 krandom_state_u32(krandom_state* state) {
+    return (u32)(krandom_state_next(state) >> 32);
+}
+
+/**
+ * @brief Returns a random floating-point number in [0, 1) from the given generator.
+ * Every one of the 2^24 evenly spaced values is equally likely.
+ *
+ * @param state A pointer to the generator.
+ * @return A random floating-point number.
+ */
+KINLINE f32 krandom_state_f32(krandom_state* state) {
+    return (f32)(krandom_state_next(state) >> 40) * (1.0f / 16777216.0f);
+}
+
+/**
+ * @brief Returns a random floating-point number in [min, max) from the given generator.
+ *
+ * @param state A pointer to the generator.
+ * @param min The minimum of the range.
+ * @param max The maximum of the range.
+ * @return A random floating-point number.
+ */
+KINLINE f32 krandom_state_f32_in_range(krandom_state* state, f32 min, f32 max) {
+    return min + (max - min) * krandom_state_f32(state);
+}
+
+/**
+ * @brief Returns a random integer within the given range (inclusive) from the given
+ * generator. Unlike taking a remainder, every value is equally likely.
+ *
+ * @param state A pointer to the generator.
+ * @param min The minimum of the range.
+ * @param max The maximum of the range. Must not be less than min.
+ * @return A random integer.
+ */
+KAPI i32 krandom_state_in_range(krandom_state* state, i32 min, i32 max);
+
+/**
+ * @brief Fills an array with random 32-bit integers from the given generator, the same
+ * values as count calls to krandom_state_u32 would give.
+ *
+ * @param state A pointer to the generator.
+ * @param count The number of values to write.
+ * @param out_values A pointer to an array of at least count values.
+ */
+KAPI void krandom_state_fill_u32(krandom_state* state, u32 count, u32* out_values);
+
+/**
+ * @brief Fills an array with random floating-point numbers in [min, max) from the given
+ * generator, the same values as count calls to krandom_state_f32_in_range would give.
+ *
+ * @param state A pointer to the generator.
+ * @param count The number of values to write.
+ * @param min The minimum of the range.
+ * @param max The maximum of the range.
+ * @param out_values A pointer to an array of at least count values.
+ */
+KAPI void krandom_state_fill_f32(krandom_state* state, u32 count, f32 min, f32 max, f32* out_values);
+
+/**
+ * @brief Obtains the calling thread's own generator, which krandom and the functions like it
+ * use. It is seeded from the time the first time each thread asks for it, so its sequence
+ * differs from run to run; seed one with krandom_state_seed where it needs to be repeatable.
+ *
+ * @return A pointer to the calling thread's generator, valid for the life of the thread.
+ */
+KAPI krandom_state* krandom_thread_state(void);
+
+/**
+ * @brief Returns gradient (Perlin) noise at the given point. It is 0 at every whole-numbered
+ * point and varies smoothly between them, within roughly [-1, 1].
+ *
+ * @param x The x coordinate. Coordinates must be within the range of an i32.
+ * @param y The y coordinate.
+ * @param z The z coordinate. Pass a constant for 2D noise.
+ * @param seed Selects one of many unrelated noise fields.
+ * @return The noise value.
+ */
+KAPI f32 noise_perlin_3d(f32 x, f32 y, f32 z, u32 seed);
+
+/**
+ * @brief Returns value noise at the given point, which interpolates random values in
+ * [-1, 1) at the whole-numbered points. Cheaper and blockier than noise_perlin_3d.
+ *
+ * @param x The x coordinate. Coordinates must be within the range of an i32.
+ * @param y The y coordinate.
+ * @param z The z coordinate. Pass a constant for 2D noise.
+ * @param seed Selects one of many unrelated noise fields.
+ * @return The noise value.
+ */
+KAPI f32 noise_value_3d(f32 x, f32 y, f32 z, u32 seed);
+
+/**
+ * @brief Evaluates noise_perlin_3d at many points, four at a time where SIMD is available.
+ * Results match noise_perlin_3d other than in the last bits.
+ *
+ * @param count The number of points.
+ * @param x A constant pointer to the x coordinate of each point.
+ * @param y A constant pointer to the y coordinate of each point.
+ * @param z A constant pointer to the z coordinate of each point.
+ * @param seed Selects one of many unrelated noise fields.
+ * @param out_values A pointer to an array of at least count values to hold the noise.
+ */
+KAPI void noise_perlin_3d_batch(u32 count, const f32* x, const f32* y, const f32* z, u32 seed, f32* out_values);
+
+/**
+ * @brief Evaluates noise_value_3d at many points, four at a time where SIMD is available.
+ * Results match noise_value_3d other than in the last bits.
+ *
+ * @param count The number of points.
+ * @param x A constant pointer to the x coordinate of each point.
+ * @param y A constant pointer to the y coordinate of each point.
+ * @param z A constant pointer to the z coordinate of each point.
+ * @param seed Selects one of many unrelated noise fields.
+ * @param out_values A pointer to an array of at least count values to hold the noise.
+ */
+KAPI void noise_value_3d_batch(u32 count, const f32* x, const f32* y, const f32* z, u32 seed, f32* out_values);
+
 // ------------------------------------------
 // Vector 2
 // ------------------------------------------
@@ -624,6 +803,22 @@ KINLINE f32 vec3_distance(vec3 vector_0, vec3 vector_1) {
     return vec3_length(d);
 }
 
+/**
+ * @brief Returns the squared distance between vector_0 and vector_1. Cheaper than
+ * vec3_distance, and orders distances the same way.
+ *
+ * @param vector_0 The first vector.
+ * @param vector_1 The second vector.
+ * @return The squared distance between vector_0 and vector_1.
+ */
+KINLINE f32 vec3_distance_squared(vec3 vector_0, vec3 vector_1) {
+    vec3 d = (vec3){
+        vector_0.x - vector_1.x,
+        vector_0.y - vector_1.y,
+        vector_0.z - vector_1.z};
+    return vec3_length_squared(d);
+}
+
 /**
  * @brief Transform v by m. NOTE: It is assumed by this function that the
  * vector v is a point, not a direction, and is calculated as if a w component
@@ -634,11 +829,21 @@ KINLINE f32 vec3_distance(vec3 vector_0, vec3 vector_1) {
  * @return A transformed copy of v.
  */
 KINLINE vec3 vec3_transform(vec3 v, mat4 m) {
+#if defined(KSIMD_ENABLED)
+    // The same as v * m, with the rows of m scaled by the elements of v.
+    f32 result[4];
+    ksimd_f32x4 row = ksimd_madd(ksimd_load(m.data + 12), ksimd_load(m.data), ksimd_splat(v.x));
+    row = ksimd_madd(row, ksimd_load(m.data + 4), ksimd_splat(v.y));
+    row = ksimd_madd(row, ksimd_load(m.data + 8), ksimd_splat(v.z));
+    ksimd_store(result, row);
+    return (vec3){result[0], result[1], result[2]};
+#else
     vec3 out;
     out.x = v.x * m.data[0 + 0] + v.y * m.data[4 + 0] + v.z * m.data[8 + 0] + 1.0f * m.data[12 + 0];
     out.y = v.x * m.data[0 + 1] + v.y * m.data[4 + 1] + v.z * m.data[8 + 1] + 1.0f * m.data[12 + 1];
     out.z = v.x * m.data[0 + 2] + v.y * m.data[4 + 2] + v.z * m.data[8 + 2] + 1.0f * m.data[12 + 2];
     return out;
+#endif
 }
 
 // ------------------------------------------
@@ -656,14 +861,10 @@ KINLINE vec3 vec3_transform(vec3 v, mat4 m) {
  */
 KINLINE vec4 vec4_create(f32 x, f32 y, f32 z, f32 w) {
     vec4 out_vector;
-#if defined(KUSE_SIMD)
-    out_vector.data = _mm_setr_ps(x, y, z, w);
-#else
     out_vector.x = x;
     out_vector.y = y;
     out_vector.z = z;
     out_vector.w = w;
-#endif
     return out_vector;
 }
 
@@ -686,13 +887,7 @@ KINLINE vec3 vec4_to_vec3(vec4 vector) {
  * @return A new vec4 
  */
 KINLINE vec4 vec4_from_vec3(vec3 vector, f32 w) {
-#if defined(KUSE_SIMD)
-    vec4 out_vector;
-    out_vector.data = _mm_setr_ps(x, y, z, w);
-    return out_vector;
-#else
     return (vec4){vector.x, vector.y, vector.z, w};
-#endif
 }
 
 /**
@@ -718,9 +913,13 @@ KINLINE vec4 vec4_one() {
  */
 KINLINE vec4 vec4_add(vec4 vector_0, vec4 vector_1) {
     vec4 result;
+#if defined(KSIMD_ENABLED)
+    ksimd_store(result.elements, ksimd_add(ksimd_load(vector_0.elements), ksimd_load(vector_1.elements)));
+#else
     for (u64 i = 0; i < 4; ++i) {
         result.elements[i] = vector_0.elements[i] + vector_1.elements[i];
     }
+#endif
     return result;
 }
 
@@ -733,9 +932,13 @@ KINLINE vec4 vec4_add(vec4 vector_0, vec4 vector_1) {
  */
 KINLINE vec4 vec4_sub(vec4 vector_0, vec4 vector_1) {
     vec4 result;
+#if defined(KSIMD_ENABLED)
+    ksimd_store(result.elements, ksimd_sub(ksimd_load(vector_0.elements), ksimd_load(vector_1.elements)));
+#else
     for (u64 i = 0; i < 4; ++i) {
         result.elements[i] = vector_0.elements[i] - vector_1.elements[i];
     }
+#endif
     return result;
 }
 
@@ -748,9 +951,13 @@ KINLINE vec4 vec4_sub(vec4 vector_0, vec4 vector_1) {
  */
 KINLINE vec4 vec4_mul(vec4 vector_0, vec4 vector_1) {
     vec4 result;
+#if defined(KSIMD_ENABLED)
+    ksimd_store(result.elements, ksimd_mul(ksimd_load(vector_0.elements), ksimd_load(vector_1.elements)));
+#else
     for (u64 i = 0; i < 4; ++i) {
         result.elements[i] = vector_0.elements[i] * vector_1.elements[i];
     }
+#endif
     return result;
 }
 
@@ -763,9 +970,13 @@ KINLINE vec4 vec4_mul(vec4 vector_0, vec4 vector_1) {
  */
 KINLINE vec4 vec4_div(vec4 vector_0, vec4 vector_1) {
     vec4 result;
+#if defined(KSIMD_ENABLED)
+    ksimd_store(result.elements, ksimd_div(ksimd_load(vector_0.elements), ksimd_load(vector_1.elements)));
+#else
     for (u64 i = 0; i < 4; ++i) {
         result.elements[i] = vector_0.elements[i] / vector_1.elements[i];
     }
+#endif
     return result;
 }
 
@@ -897,6 +1108,23 @@ KINLINE mat4 mat4_identity() {
  * @return The result of the matrix multiplication.
  */
 KINLINE mat4 mat4_mul(mat4 matrix_0, mat4 matrix_1) {
+#if defined(KSIMD_ENABLED)
+    // Each row of the result is the rows of matrix_1 scaled by the elements of that row of matrix_0.
+    mat4 out_matrix;
+    ksimd_f32x4 row_0 = ksimd_load(matrix_1.data);
+    ksimd_f32x4 row_1 = ksimd_load(matrix_1.data + 4);
+    ksimd_f32x4 row_2 = ksimd_load(matrix_1.data + 8);
+    ksimd_f32x4 row_3 = ksimd_load(matrix_1.data + 12);
+    for (u32 i = 0; i < 16; i += 4) {
+        ksimd_f32x4 a = ksimd_load(matrix_0.data + i);
+        ksimd_f32x4 row = ksimd_mul(row_0, ksimd_splat_lane(a, 0));
+        row = ksimd_madd(row, row_1, ksimd_splat_lane(a, 1));
+        row = ksimd_madd(row, row_2, ksimd_splat_lane(a, 2));
+        row = ksimd_madd(row, row_3, ksimd_splat_lane(a, 3));
+        ksimd_store(out_matrix.data + i, row);
+    }
+    return out_matrix;
+#else
     mat4 out_matrix = mat4_identity();
 
     const f32* m1_ptr = matrix_0.data;
@@ -915,6 +1143,7 @@ KINLINE mat4 mat4_mul(mat4 matrix_0, mat4 matrix_1) {
         m1_ptr += 4;
     }
     return out_matrix;
+#endif
 }
 
 /**
@@ -1014,6 +1243,19 @@ KINLINE mat4 mat4_look_at(vec3 position, vec3 target, vec3 up) {
  * @return A transposed copy of of the provided matrix.
  */
 KINLINE mat4 mat4_transposed(mat4 matrix) {
+#if defined(KSIMD_ENABLED)
+    mat4 out_matrix;
+    ksimd_f32x4 row_0 = ksimd_load(matrix.data);
+    ksimd_f32x4 row_1 = ksimd_load(matrix.data + 4);
+    ksimd_f32x4 row_2 = ksimd_load(matrix.data + 8);
+    ksimd_f32x4 row_3 = ksimd_load(matrix.data + 12);
+    ksimd_transpose(row_0, row_1, row_2, row_3);
+    ksimd_store(out_matrix.data, row_0);
+    ksimd_store(out_matrix.data + 4, row_1);
+    ksimd_store(out_matrix.data + 8, row_2);
+    ksimd_store(out_matrix.data + 12, row_3);
+    return out_matrix;
+#else
     mat4 out_matrix = mat4_identity();
     out_matrix.data[0] = matrix.data[0];
     out_matrix.data[1] = matrix.data[4];
@@ -1032,6 +1274,7 @@ KINLINE mat4 mat4_transposed(mat4 matrix) {
     out_matrix.data[14] = matrix.data[11];
     out_matrix.data[15] = matrix.data[15];
     return out_matrix;
+#endif
 }
 
 /**
@@ -1041,6 +1284,55 @@ KINLINE mat4 mat4_transposed(mat4 matrix) {
  * @return A inverted copy of the provided matrix. 
  */
 KINLINE mat4 mat4_inverse(mat4 matrix) {
+#if defined(KSIMD_SSE)
+    // Inverts by splitting the matrix into four 2x2 blocks and working with their adjugates,
+    // which needs far fewer multiplies than expanding every cofactor.
+    ksimd_f32x4 row_0 = ksimd_load(matrix.data);
+    ksimd_f32x4 row_1 = ksimd_load(matrix.data + 4);
+    ksimd_f32x4 row_2 = ksimd_load(matrix.data + 8);
+    ksimd_f32x4 row_3 = ksimd_load(matrix.data + 12);
+    ksimd_f32x4 a = _mm_movelh_ps(row_0, row_1);
+    ksimd_f32x4 b = _mm_movehl_ps(row_1, row_0);
+    ksimd_f32x4 c = _mm_movelh_ps(row_2, row_3);
+    ksimd_f32x4 d = _mm_movehl_ps(row_3, row_2);
+
+    // The determinants of each block, as (|A|, |B|, |C|, |D|).
+    ksimd_f32x4 det_sub = ksimd_sub(
+        ksimd_mul(ksimd_shuffle(row_0, row_2, 0, 2, 0, 2), ksimd_shuffle(row_1, row_3, 1, 3, 1, 3)),
+        ksimd_mul(ksimd_shuffle(row_0, row_2, 1, 3, 1, 3), ksimd_shuffle(row_1, row_3, 0, 2, 0, 2)));
+    ksimd_f32x4 det_a = ksimd_splat_lane(det_sub, 0);
+    ksimd_f32x4 det_b = ksimd_splat_lane(det_sub, 1);
+    ksimd_f32x4 det_c = ksimd_splat_lane(det_sub, 2);
+    ksimd_f32x4 det_d = ksimd_splat_lane(det_sub, 3);
+
+    ksimd_f32x4 d_c = ksimd_mat2_adj_mul(d, c);
+    ksimd_f32x4 a_b = ksimd_mat2_adj_mul(a, b);
+    ksimd_f32x4 x = ksimd_sub(ksimd_mul(det_d, a), ksimd_mat2_mul(b, d_c));
+    ksimd_f32x4 w = ksimd_sub(ksimd_mul(det_a, d), ksimd_mat2_mul(c, a_b));
+    ksimd_f32x4 y = ksimd_sub(ksimd_mul(det_b, c), ksimd_mat2_mul_adj(d, a_b));
+    ksimd_f32x4 z = ksimd_sub(ksimd_mul(det_c, b), ksimd_mat2_mul_adj(a, d_c));
+
+    // |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+    ksimd_f32x4 trace = ksimd_mul(a_b, ksimd_swizzle(d_c, 0, 2, 1, 3));
+    trace = ksimd_add(trace, ksimd_swizzle(trace, 1, 0, 3, 2));
+    trace = ksimd_add(trace, ksimd_swizzle(trace, 2, 3, 0, 1));
+    ksimd_f32x4 det_m = ksimd_sub(ksimd_add(ksimd_mul(det_a, det_d), ksimd_mul(det_b, det_c)), trace);
+
+    // The signs of the adjugates, folded into the reciprocal of the determinant.
+    ksimd_f32x4 reciprocal_det = ksimd_div(ksimd_set(1.0f, -1.0f, -1.0f, 1.0f), det_m);
+    x = ksimd_mul(x, reciprocal_det);
+    y = ksimd_mul(y, reciprocal_det);
+    z = ksimd_mul(z, reciprocal_det);
+    w = ksimd_mul(w, reciprocal_det);
+
+    // Take the adjugates and put the blocks back into rows.
+    mat4 out_matrix;
+    ksimd_store(out_matrix.data, ksimd_shuffle(x, y, 3, 1, 3, 1));
+    ksimd_store(out_matrix.data + 4, ksimd_shuffle(x, y, 2, 0, 2, 0));
+    ksimd_store(out_matrix.data + 8, ksimd_shuffle(z, w, 3, 1, 3, 1));
+    ksimd_store(out_matrix.data + 12, ksimd_shuffle(z, w, 2, 0, 2, 0));
+    return out_matrix;
+#else
     const f32* m = matrix.data;
 
     f32 t0 = m[10] * m[15];
@@ -1096,6 +1388,7 @@ KINLINE mat4 mat4_inverse(mat4 matrix) {
     o[15] = d * ((t22 * m[10] + t16 * m[2] + t21 * m[6]) - (t20 * m[6] + t23 * m[10] + t17 * m[2]));
 
     return out_matrix;
+#endif
 }
 
 /**
@@ -1310,10 +1603,14 @@ KINLINE vec3 mat4_mul_vec3(mat4 m, vec3 v) {
  * @return The transformed vector.
  */
 KINLINE vec3 vec3_mul_mat4(vec3 v, mat4 m) {
+#if defined(KSIMD_ENABLED)
+    return vec3_transform(v, m);
+#else
     return (vec3){
         v.x * m.data[0] + v.y * m.data[4] + v.z * m.data[8] + m.data[12],
         v.x * m.data[1] + v.y * m.data[5] + v.z * m.data[9] + m.data[13],
         v.x * m.data[2] + v.y * m.data[6] + v.z * m.data[10] + m.data[14]};
+#endif
 }
 
 /**
@@ -1324,11 +1621,28 @@ KINLINE vec3 vec3_mul_mat4(vec3 v, mat4 m) {
  * @return The transformed vector.
  */
 KINLINE vec4 mat4_mul_vec4(mat4 m, vec4 v) {
+#if defined(KSIMD_ENABLED)
+    // The same as v * transpose(m).
+    vec4 result;
+    ksimd_f32x4 row_0 = ksimd_load(m.data);
+    ksimd_f32x4 row_1 = ksimd_load(m.data + 4);
+    ksimd_f32x4 row_2 = ksimd_load(m.data + 8);
+    ksimd_f32x4 row_3 = ksimd_load(m.data + 12);
+    ksimd_transpose(row_0, row_1, row_2, row_3);
+    ksimd_f32x4 vector = ksimd_load(v.elements);
+    ksimd_f32x4 out = ksimd_mul(row_0, ksimd_splat_lane(vector, 0));
+    out = ksimd_madd(out, row_1, ksimd_splat_lane(vector, 1));
+    out = ksimd_madd(out, row_2, ksimd_splat_lane(vector, 2));
+    out = ksimd_madd(out, row_3, ksimd_splat_lane(vector, 3));
+    ksimd_store(result.elements, out);
+    return result;
+#else
     return (vec4){
         v.x * m.data[0] + v.y * m.data[1] + v.z * m.data[2] + v.w * m.data[3],
         v.x * m.data[4] + v.y * m.data[5] + v.z * m.data[6] + v.w * m.data[7],
         v.x * m.data[8] + v.y * m.data[9] + v.z * m.data[10] + v.w * m.data[11],
         v.x * m.data[12] + v.y * m.data[13] + v.z * m.data[14] + v.w * m.data[15]};
+#endif
 }
 
 /**
@@ -1339,11 +1653,22 @@ KINLINE vec4 mat4_mul_vec4(mat4 m, vec4 v) {
  * @return The transformed vector.
  */
 KINLINE vec4 vec4_mul_mat4(vec4 v, mat4 m) {
+#if defined(KSIMD_ENABLED)
+    vec4 result;
+    ksimd_f32x4 vector = ksimd_load(v.elements);
+    ksimd_f32x4 out = ksimd_mul(ksimd_load(m.data), ksimd_splat_lane(vector, 0));
+    out = ksimd_madd(out, ksimd_load(m.data + 4), ksimd_splat_lane(vector, 1));
+    out = ksimd_madd(out, ksimd_load(m.data + 8), ksimd_splat_lane(vector, 2));
+    out = ksimd_madd(out, ksimd_load(m.data + 12), ksimd_splat_lane(vector, 3));
+    ksimd_store(result.elements, out);
+    return result;
+#else
     return (vec4){
         v.x * m.data[0] + v.y * m.data[4] + v.z * m.data[8] + v.w * m.data[12],
         v.x * m.data[1] + v.y * m.data[5] + v.z * m.data[9] + v.w * m.data[13],
         v.x * m.data[2] + v.y * m.data[6] + v.z * m.data[10] + v.w * m.data[14],
         v.x * m.data[3] + v.y * m.data[7] + v.z * m.data[11] + v.w * m.data[15]};
+#endif
 }
 
 // ------------------------------------------
@@ -1422,6 +1747,16 @@ KINLINE quat quat_inverse(quat q) {
  */
 KINLINE quat quat_mul(quat q_0, quat q_1) {
     quat out_quaternion;
+#if defined(KSIMD_ENABLED)
+    // q_0.w * q_1, plus q_1 swizzled and sign-flipped for each of q_0's x, y and z.
+    ksimd_f32x4 a = ksimd_load(q_0.elements);
+    ksimd_f32x4 b = ksimd_load(q_1.elements);
+    ksimd_f32x4 out = ksimd_mul(ksimd_splat_lane(a, 3), b);
+    out = ksimd_madd(out, ksimd_splat_lane(a, 0), ksimd_mul(ksimd_swizzle_wzyx(b), ksimd_set(1.0f, -1.0f, 1.0f, -1.0f)));
+    out = ksimd_madd(out, ksimd_splat_lane(a, 1), ksimd_mul(ksimd_swizzle_zwxy(b), ksimd_set(1.0f, 1.0f, -1.0f, -1.0f)));
+    out = ksimd_madd(out, ksimd_splat_lane(a, 2), ksimd_mul(ksimd_swizzle_yxwz(b), ksimd_set(-1.0f, 1.0f, 1.0f, -1.0f)));
+    ksimd_store(out_quaternion.elements, out);
+#else
 
     out_quaternion.x = q_0.x * q_1.w +
                        q_0.y * q_1.z -
@@ -1442,6 +1777,7 @@ KINLINE quat quat_mul(quat q_0, quat q_1) {
                        q_0.y * q_1.y -
                        q_0.z * q_1.z +
                        q_0.w * q_1.w;
+#endif
 
     return out_quaternion;
 }
@@ -1690,6 +2026,58 @@ KINLINE void vec3_to_rgb_u32(vec3 v, u32* out_r, u32* out_g, u32* out_b) {
     *out_b = v.b * 255;
 }
 
+/**
+ * @brief Encodes a unit vector as two 16-bit signed normalized values, using an octahedral
+ * mapping. The x value is held in the low 16 bits, to be read by a shader as a snorm16x2
+ * attribute and decoded with the inverse mapping. Accurate to within about 0.005 degrees.
+ *
+ * @param v The unit vector to be encoded.
+ * @return The encoded vector.
+ */
+KAPI u32 vec3_to_octahedral_snorm16(vec3 v);
+
+/**
+ * @brief Decodes a unit vector encoded by vec3_to_octahedral_snorm16.
+ *
+ * @param encoded The encoded vector.
+ * @return The decoded, normalized vector.
+ */
+KAPI vec3 octahedral_snorm16_to_vec3(u32 encoded);
+
+/**
+ * @brief Converts a 32-bit float to the nearest 16-bit (half precision) float. Values too
+ * large to represent become infinity, and NaNs stay NaNs.
+ *
+ * @param value The value to be converted.
+ * @return The bits of the half precision float.
+ */
+KAPI u16 f32_to_half(f32 value);
+
+/**
+ * @brief Converts a 16-bit (half precision) float to a 32-bit float. The conversion is exact.
+ *
+ * @param value The bits of the half precision float.
+ * @return The converted value.
+ */
+KAPI f32 half_to_f32(u16 value);
+
+/**
+ * @brief Encodes a vec4 of values [0.0-1.0] as four 8-bit unsigned normalized values,
+ * with x in the low byte. Values outside the range are clamped.
+ *
+ * @param v The vector to be encoded.
+ * @return The encoded vector.
+ */
+KAPI u32 vec4_to_unorm8(vec4 v);
+
+/**
+ * @brief Decodes a vec4 encoded by vec4_to_unorm8.
+ *
+ * @param encoded The encoded vector.
+ * @return The decoded vector, with values [0.0-1.0].
+ */
+KAPI vec4 unorm8_to_vec4(u32 encoded);
+
 KAPI plane_3d plane_3d_create(vec3 p1, vec3 norm);
 
 /**
@@ -1756,3 +2144,21 @@ KAPI b8 plane_intersects_aabb(const plane_3d* p, const vec3* center, const vec3*
  * @return True if the axis-aligned bounding box is intersected by or contained within the frustum f; otherwise false.  
  */
 KAPI b8 frustum_intersects_aabb(const frustum* f, const vec3* center, const vec3* extents);
+
+/**
+ * @brief Tests the boxes in the range [start, end) against frustum f, several at a time,
+ * setting bit i of out_visibility (bit i % 64 of word i / 64) if box i is intersected
+ * by or contained within the frustum, and clearing it otherwise. Gives the same results
+ * as frustum_intersects_aabb, other than for boxes within rounding of a plane.
+ * @details Whole words of out_visibility are written, so start must be a multiple of 64,
+ * and bits past end in the last word are cleared. Ranges which meet at multiples of 64
+ * touch different words, so this can be called from a parallel-for with a batch size
+ * that is a multiple of 64. out_visibility can be the words of a bitset.
+ *
+ * @param f A constant pointer to a frustum.
+ * @param boxes A constant pointer to the boxes' centers and half-extents.
+ * @param start The index of the first box to test. Must be a multiple of 64.
+ * @param end One past the index of the last box to test.
+ * @param out_visibility A pointer to the bitmask words to write, indexed from box 0.
+ */
+KAPI void frustum_intersects_aabb_batch(const frustum* f, const aabb_soa* boxes, u32 start, u32 end, u64* out_visibility);
@@ -0,0 +1,254 @@
+/**
+ * @file ksimd.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief A thin layer over 4-wide f32 SIMD instructions, used by kmath to implement
+ * vector, matrix and quaternion operations, along with a few 16-wide u8 operations for
+ * scanning pixel data. SSE is used on x86, NEON on ARM, and a scalar fallback everywhere
+ * else, chosen at compile time. The u8 operations have no fallback, so callers provide their
+ * own when KSIMD_ENABLED is not defined.
+ * @details Values are loaded from and stored to the existing math types with unaligned
+ * loads and stores, so those types keep their size and alignment, and so their layout in
+ * vertex and uniform data. Define KSIMD_DISABLE to force the scalar fallback. Fused
+ * multiply-adds are used where the target supports them (such as when building with -mfma),
+ * so results may differ from the scalar fallback in the last bits.
+ * @version 1.0
+ *
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+#if !defined(KSIMD_DISABLE) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+/** @brief Indicates SSE instructions are used. */
+#define KSIMD_SSE 1
+#include <immintrin.h>
+#elif !defined(KSIMD_DISABLE) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+/** @brief Indicates NEON instructions are used. */
+#define KSIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(KSIMD_SSE) || defined(KSIMD_NEON)
+/** @brief Indicates a SIMD implementation is in use, rather than the scalar fallback. */
+#define KSIMD_ENABLED 1
+#endif
+
+#if defined(KSIMD_SSE)
+
+/** @brief Four f32 values in a SIMD register. */
+typedef __m128 ksimd_f32x4;
+
+/** @brief Loads four f32 values from ptr, which need not be aligned. */
+#define ksimd_load(ptr) _mm_loadu_ps(ptr)
+/** @brief Stores four f32 values to ptr, which need not be aligned. */
+#define ksimd_store(ptr, v) _mm_storeu_ps(ptr, v)
+/** @brief Creates a value from its four lanes. */
+#define ksimd_set(x, y, z, w) _mm_setr_ps(x, y, z, w)
+/** @brief Returns value copied into all four lanes. */
+#define ksimd_splat(value) _mm_set1_ps(value)
+/** @brief Returns a + b, lane by lane. */
+#define ksimd_add(a, b) _mm_add_ps(a, b)
+/** @brief Returns a - b, lane by lane. */
+#define ksimd_sub(a, b) _mm_sub_ps(a, b)
+/** @brief Returns a * b, lane by lane. */
+#define ksimd_mul(a, b) _mm_mul_ps(a, b)
+/** @brief Returns a / b, lane by lane. */
+#define ksimd_div(a, b) _mm_div_ps(a, b)
+/** @brief Returns the given lane, which must be a constant, copied into all four lanes. */
+#define ksimd_splat_lane(v, lane) _mm_shuffle_ps(v, v, _MM_SHUFFLE(lane, lane, lane, lane))
+/** @brief Returns (v.y, v.x, v.w, v.z). */
+#define ksimd_swizzle_yxwz(v) _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1))
+/** @brief Returns (v.z, v.w, v.x, v.y). */
+#define ksimd_swizzle_zwxy(v) _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2))
+/** @brief Returns (v.w, v.z, v.y, v.x). */
+#define ksimd_swizzle_wzyx(v) _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3))
+
+/** @brief Returns a + b * c, lane by lane. */
+#if defined(__FMA__)
+#define ksimd_madd(a, b, c) _mm_fmadd_ps(b, c, a)
+#else
+#define ksimd_madd(a, b, c) _mm_add_ps(a, _mm_mul_ps(b, c))
+#endif
+
+/** @brief Transposes the 4x4 matrix held in rows r0 to r3 in place. */
+#define ksimd_transpose(r0, r1, r2, r3) _MM_TRANSPOSE4_PS(r0, r1, r2, r3)
+
+/** @brief Returns the largest whole number not greater than each lane, which must be within the range of an i32. */
+#if defined(__SSE4_1__)
+#define ksimd_floor(v) _mm_floor_ps(v)
+#else
+KINLINE ksimd_f32x4 ksimd_floor(ksimd_f32x4 v) {
+    // Truncate towards zero, then step down the lanes which were negative with a fraction.
+    __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(v));
+    return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, v), _mm_set1_ps(1.0f)));
+}
+#endif
+
+/** @brief The result of a lane by lane comparison, with each lane either all set or all clear. */
+typedef __m128 ksimd_mask4;
+
+/** @brief Returns a mask of the lanes where a >= b. */
+#define ksimd_cmpge(a, b) _mm_cmpge_ps(a, b)
+/** @brief Returns a mask of the lanes set in both a and b. */
+#define ksimd_mask_and(a, b) _mm_and_ps(a, b)
+/** @brief Returns the lanes of a mask as the low four bits of a u32, lane 0 in bit 0. */
+#define ksimd_mask_bits(m) ((u32)_mm_movemask_ps(m))
+
+/** @brief Sixteen u8 values in a SIMD register. */
+typedef __m128i ksimd_u8x16;
+
+/** @brief Loads sixteen u8 values from ptr, which need not be aligned. */
+#define ksimd_u8_load(ptr) _mm_loadu_si128((const __m128i*)(ptr))
+/** @brief Returns the four bytes of value, lowest first, repeated across all sixteen lanes. */
+#define ksimd_u8_splat_u32(value) _mm_set1_epi32((i32)(value))
+/** @brief Returns a & b, bit by bit. */
+#define ksimd_u8_and(a, b) _mm_and_si128(a, b)
+/** @brief Returns a | b, bit by bit. */
+#define ksimd_u8_or(a, b) _mm_or_si128(a, b)
+/** @brief Returns true if every lane of v is 255. */
+#define ksimd_u8_all_set(v) (_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(-1))) == 0xFFFF)
+
+/** @brief Returns the lanes of a given by x and y followed by the lanes of b given by z and w. */
+#define ksimd_shuffle(a, b, x, y, z, w) _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+/** @brief Returns the lanes of v given by x, y, z and w. */
+#define ksimd_swizzle(v, x, y, z, w) ksimd_shuffle(v, v, x, y, z, w)
+
+// Helpers for inverting a 4x4 matrix by its 2x2 blocks, each held row by row in one register.
+
+/** @brief Returns the product of the 2x2 matrices a * b. */
+KINLINE ksimd_f32x4 ksimd_mat2_mul(ksimd_f32x4 a, ksimd_f32x4 b) {
+    return _mm_add_ps(_mm_mul_ps(a, ksimd_swizzle(b, 0, 3, 0, 3)), _mm_mul_ps(ksimd_swizzle(a, 1, 0, 3, 2), ksimd_swizzle(b, 2, 1, 2, 1)));
+}
+
+/** @brief Returns the product of the adjugate of the 2x2 matrix a with b. */
+KINLINE ksimd_f32x4 ksimd_mat2_adj_mul(ksimd_f32x4 a, ksimd_f32x4 b) {
+    return _mm_sub_ps(_mm_mul_ps(ksimd_swizzle(a, 3, 3, 0, 0), b), _mm_mul_ps(ksimd_swizzle(a, 1, 1, 2, 2), ksimd_swizzle(b, 2, 3, 0, 1)));
+}
+
+/** @brief Returns the product of the 2x2 matrix a with the adjugate of b. */
+KINLINE ksimd_f32x4 ksimd_mat2_mul_adj(ksimd_f32x4 a, ksimd_f32x4 b) {
+    return _mm_sub_ps(_mm_mul_ps(a, ksimd_swizzle(b, 3, 0, 3, 0)), _mm_mul_ps(ksimd_swizzle(a, 1, 0, 3, 2), ksimd_swizzle(b, 2, 1, 2, 1)));
+}
+
+#elif defined(KSIMD_NEON)
+
+/** @brief Four f32 values in a SIMD register. */
+typedef float32x4_t ksimd_f32x4;
+
+/** @brief Loads four f32 values from ptr, which need not be aligned. */
+#define ksimd_load(ptr) vld1q_f32(ptr)
+/** @brief Stores four f32 values to ptr, which need not be aligned. */
+#define ksimd_store(ptr, v) vst1q_f32(ptr, v)
+/** @brief Returns a + b, lane by lane. */
+#define ksimd_add(a, b) vaddq_f32(a, b)
+/** @brief Returns a - b, lane by lane. */
+#define ksimd_sub(a, b) vsubq_f32(a, b)
+/** @brief Returns a * b, lane by lane. */
+#define ksimd_mul(a, b) vmulq_f32(a, b)
+/** @brief Returns value copied into all four lanes. */
+#define ksimd_splat(value) vdupq_n_f32(value)
+/** @brief Returns the given lane, which must be a constant, copied into all four lanes. */
+#define ksimd_splat_lane(v, lane) vdupq_n_f32(vgetq_lane_f32(v, lane))
+/** @brief Returns (v.y, v.x, v.w, v.z). */
+#define ksimd_swizzle_yxwz(v) vrev64q_f32(v)
+/** @brief Returns (v.z, v.w, v.x, v.y). */
+#define ksimd_swizzle_zwxy(v) vextq_f32(v, v, 2)
+/** @brief Returns (v.w, v.z, v.y, v.x). */
+#define ksimd_swizzle_wzyx(v) vrev64q_f32(vextq_f32(v, v, 2))
+
+/** @brief Creates a value from its four lanes. */
+KINLINE ksimd_f32x4 ksimd_set(f32 x, f32 y, f32 z, f32 w) {
+    f32 values[4] = {x, y, z, w};
+    return vld1q_f32(values);
+}
+
+/** @brief Returns a / b, lane by lane. */
+#if defined(__aarch64__)
+#define ksimd_div(a, b) vdivq_f32(a, b)
+#else
+KINLINE ksimd_f32x4 ksimd_div(ksimd_f32x4 a, ksimd_f32x4 b) {
+    // 32-bit ARM has no vector divide, so refine a reciprocal estimate with two Newton-Raphson steps.
+    float32x4_t reciprocal = vrecpeq_f32(b);
+    reciprocal = vmulq_f32(vrecpsq_f32(b, reciprocal), reciprocal);
+    reciprocal = vmulq_f32(vrecpsq_f32(b, reciprocal), reciprocal);
+    return vmulq_f32(a, reciprocal);
+}
+#endif
+
+/** @brief Returns a + b * c, lane by lane. */
+#if defined(__ARM_FEATURE_FMA)
+#define ksimd_madd(a, b, c) vfmaq_f32(a, b, c)
+#else
+#define ksimd_madd(a, b, c) vmlaq_f32(a, b, c)
+#endif
+
+/** @brief Returns the largest whole number not greater than each lane, which must be within the range of an i32. */
+#if defined(__aarch64__)
+#define ksimd_floor(v) vrndmq_f32(v)
+#else
+KINLINE ksimd_f32x4 ksimd_floor(ksimd_f32x4 v) {
+    // Truncate towards zero, then step down the lanes which were negative with a fraction.
+    float32x4_t truncated = vcvtq_f32_s32(vcvtq_s32_f32(v));
+    uint32x4_t step = vandq_u32(vcgtq_f32(truncated, v), vreinterpretq_u32_f32(vdupq_n_f32(1.0f)));
+    return vsubq_f32(truncated, vreinterpretq_f32_u32(step));
+}
+#endif
+
+/** @brief Transposes the 4x4 matrix held in rows r0 to r3 in place. */
+#define ksimd_transpose(r0, r1, r2, r3)                                              \
+    do {                                                                             \
+        float32x4x2_t ksimd_t01 = vtrnq_f32(r0, r1);                                 \
+        float32x4x2_t ksimd_t23 = vtrnq_f32(r2, r3);                                 \
+        r0 = vcombine_f32(vget_low_f32(ksimd_t01.val[0]), vget_low_f32(ksimd_t23.val[0]));   \
+        r1 = vcombine_f32(vget_low_f32(ksimd_t01.val[1]), vget_low_f32(ksimd_t23.val[1]));   \
+        r2 = vcombine_f32(vget_high_f32(ksimd_t01.val[0]), vget_high_f32(ksimd_t23.val[0])); \
+        r3 = vcombine_f32(vget_high_f32(ksimd_t01.val[1]), vget_high_f32(ksimd_t23.val[1])); \
+    } while (0)
+
+/** @brief The result of a lane by lane comparison, with each lane either all set or all clear. */
+typedef uint32x4_t ksimd_mask4;
+
+/** @brief Returns a mask of the lanes where a >= b. */
+#define ksimd_cmpge(a, b) vcgeq_f32(a, b)
+/** @brief Returns a mask of the lanes set in both a and b. */
+#define ksimd_mask_and(a, b) vandq_u32(a, b)
+
+/** @brief Returns the lanes of a mask as the low four bits of a u32, lane 0 in bit 0. */
+KINLINE u32 ksimd_mask_bits(ksimd_mask4 m) {
+    const u32 lane_bits[4] = {1, 2, 4, 8};
+    uint32x4_t bits = vandq_u32(m, vld1q_u32(lane_bits));
+#if defined(__aarch64__)
+    return vaddvq_u32(bits);
+#else
+    uint32x2_t sum = vpadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+    return vget_lane_u32(vpadd_u32(sum, sum), 0);
+#endif
+}
+
+/** @brief Sixteen u8 values in a SIMD register. */
+typedef uint8x16_t ksimd_u8x16;
+
+/** @brief Loads sixteen u8 values from ptr, which need not be aligned. */
+#define ksimd_u8_load(ptr) vld1q_u8((const u8*)(ptr))
+/** @brief Returns the four bytes of value, lowest first, repeated across all sixteen lanes. */
+#define ksimd_u8_splat_u32(value) vreinterpretq_u8_u32(vdupq_n_u32(value))
+/** @brief Returns a & b, bit by bit. */
+#define ksimd_u8_and(a, b) vandq_u8(a, b)
+/** @brief Returns a | b, bit by bit. */
+#define ksimd_u8_or(a, b) vorrq_u8(a, b)
+
+/** @brief Returns true if every lane of v is 255. */
+KINLINE b8 ksimd_u8_all_set(ksimd_u8x16 v) {
+#if defined(__aarch64__)
+    return vminvq_u8(v) == 0xFF;
+#else
+    uint8x8_t both = vand_u8(vget_low_u8(v), vget_high_u8(v));
+    return vget_lane_u64(vreinterpret_u64_u8(both), 0) == ~0ull;
+#endif
+}
+
+#endif
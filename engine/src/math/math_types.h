@@ -172,6 +172,41 @@ typedef struct vertex_3d {
     vec3 tangent;
 } vertex_3d;
 
+/**
+ * @brief Represents a single vertex in 3D space in the compact form it is uploaded to
+ * the GPU in, at 28 bytes rather than the 64 of vertex_3d. The fields are in the same order
+ * as vertex_3d's, so attribute locations are the same. Use vertex_3d_pack to create one.
+ */
+typedef struct vertex_3d_packed {
+    /** @brief The position of the vertex. */
+    vec3 position;
+    /** @brief The normal of the vertex, octahedral-encoded as two snorm16 values. */
+    u32 normal;
+    /** @brief The texture coordinate of the vertex, as two half precision floats. */
+    u16 texcoord[2];
+    /** @brief The colour of the vertex, as four unorm8 values. */
+    u32 colour;
+    /** @brief The tangent of the vertex, octahedral-encoded as two snorm16 values. */
+    u32 tangent;
+} vertex_3d_packed;
+
+/** @brief The most joints a vertex of a skinned geometry is influenced by. */
+#define VERTEX_MAX_JOINT_INFLUENCES 4
+
+/**
+ * @brief Represents a single vertex of a skinned geometry in its bind pose, as read by the skinning
+ * shader. A vertex_3d_packed followed by the joints influencing it, with their weights. Use
+ * vertex_3d_skinned_pack to create one.
+ */
+typedef struct vertex_3d_skinned {
+    /** @brief The vertex in the bind pose, as it is drawn. */
+    vertex_3d_packed vertex;
+    /** @brief The indices of the joints influencing the vertex, in the skeleton. */
+    u8 joints[VERTEX_MAX_JOINT_INFLUENCES];
+    /** @brief The weight of each joint, as unorm8 values summing to 255. */
+    u8 weights[VERTEX_MAX_JOINT_INFLUENCES];
+} vertex_3d_skinned;
+
 /**
  * @brief Represents a single vertex in 2D space.
  */
@@ -220,3 +255,85 @@ typedef struct frustum {
     // Top, bottom, right, left, far, near
     plane_3d sides[6];
 } frustum;
+
+/**
+ * @brief Represents a sphere enclosing an object.
+ */
+typedef struct bounding_sphere {
+    /** @brief The center of the sphere. */
+    vec3 center;
+    /** @brief The radius of the sphere. */
+    f32 radius;
+} bounding_sphere;
+
+/**
+ * @brief Represents a box enclosing an object, which may be rotated.
+ */
+typedef struct oriented_box {
+    /** @brief The center of the box. */
+    vec3 center;
+    /** @brief The half-size of the box along each of its axes. */
+    vec3 half_extents;
+    /** @brief The axes of the box, of unit length. */
+    vec3 axes[3];
+} oriented_box;
+
+/**
+ * @brief Represents a ray, such as one cast from the camera through the cursor.
+ */
+typedef struct ray {
+    /** @brief The point the ray starts at. */
+    vec3 origin;
+    /** @brief The direction of the ray, of unit length. */
+    vec3 direction;
+} ray;
+
+/**
+ * @brief A cluster of the triangles of a geometry, small enough to be culled on its own. Its
+ * triangles are a range of the geometry's index buffer.
+ */
+typedef struct geometry_meshlet {
+    /** @brief The first index of the meshlet in the geometry's index buffer. */
+    u32 index_offset;
+    /** @brief The number of indices of the meshlet, three per triangle. */
+    u32 index_count;
+    /** @brief The number of different vertices the triangles of the meshlet use. */
+    u32 vertex_count;
+    /** @brief The extents of the meshlet's triangles, in the geometry's space. */
+    extents_3d extents;
+    /** @brief The average direction the meshlet's triangles face, of unit length, or zero if they face every way. */
+    vec3 cone_axis;
+    /**
+     * @brief The sine of the widest angle between the cone axis and a triangle's normal, or 1 if the
+     * triangles are spread too widely for the meshlet ever to be facing away as a whole.
+     */
+    f32 cone_cutoff;
+} geometry_meshlet;
+
+/**
+ * @brief A set of axis-aligned bounding boxes held as a structure of arrays,
+ * one array per component, so that several boxes can be tested at once.
+ */
+typedef struct aabb_soa {
+    /** @brief The x component of each box's center. */
+    const f32* center_x;
+    /** @brief The y component of each box's center. */
+    const f32* center_y;
+    /** @brief The z component of each box's center. */
+    const f32* center_z;
+    /** @brief The x component of each box's half-extents. */
+    const f32* extents_x;
+    /** @brief The y component of each box's half-extents. */
+    const f32* extents_y;
+    /** @brief The z component of each box's half-extents. */
+    const f32* extents_z;
+} aabb_soa;
+
+/**
+ * @brief The state of a xoshiro256** random number generator. Not thread-safe, so each
+ * thread which needs random numbers should have its own, seeded with krandom_state_seed.
+ */
+typedef struct krandom_state {
+    /** @brief The generator's 256 bits of state, which must not all be zero. */
+    u64 s[4];
+} krandom_state;
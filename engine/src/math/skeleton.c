@@ -0,0 +1,86 @@
+#include "skeleton.h"
+
+#include "kmath.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "systems/job_system.h"
+
+// The number of poses computed per batch when computing in parallel.
+#define PARALLEL_BATCH_SIZE 16
+
+b8 skeleton_create(u32 joint_count, const u32* parents, const mat4* inverse_binds, u64* memory_requirement, void* memory, skeleton* out_skeleton) {
+    if (joint_count == 0 || joint_count > SKELETON_MAX_JOINTS) {
+        KERROR("skeleton_create requires between 1 and %u joints, but was given %u.", SKELETON_MAX_JOINTS, joint_count);
+        return false;
+    }
+    if (!memory_requirement) {
+        KERROR("skeleton_create requires memory_requirement to exist.");
+        return false;
+    }
+
+    // The inverse bind matrices first, so they keep the alignment of the block.
+    u64 inverse_binds_size = sizeof(mat4) * joint_count;
+    *memory_requirement = inverse_binds_size + sizeof(u32) * joint_count;
+    if (!memory) {
+        return true;
+    }
+    if (!parents || !inverse_binds || !out_skeleton) {
+        KERROR("skeleton_create requires parents, inverse_binds and out_skeleton to exist.");
+        return false;
+    }
+
+    // Palettes are computed in one pass, which relies on every parent being computed first.
+    for (u32 i = 0; i < joint_count; ++i) {
+        if (parents[i] != INVALID_ID && parents[i] >= i) {
+            KERROR("skeleton_create - joint %u has parent %u, which does not come before it.", i, parents[i]);
+            return false;
+        }
+    }
+
+    out_skeleton->joint_count = joint_count;
+    out_skeleton->inverse_binds = memory;
+    out_skeleton->parents = (u32*)((u8*)memory + inverse_binds_size);
+    kcopy_memory(out_skeleton->inverse_binds, inverse_binds, inverse_binds_size);
+    kcopy_memory(out_skeleton->parents, parents, sizeof(u32) * joint_count);
+    return true;
+}
+
+void skeleton_destroy(skeleton* s) {
+    if (s) {
+        kzero_memory(s, sizeof(skeleton));
+    }
+}
+
+void skeleton_palette_compute(const skeleton_pose* pose) {
+    const skeleton* s = pose->skeleton;
+    mat4* palette = pose->palette;
+
+    // The world matrices go in the palette first, so are at hand for the children.
+    for (u32 i = 0; i < s->joint_count; ++i) {
+        u32 parent = s->parents[i];
+        palette[i] = parent == INVALID_ID ? pose->locals[i] : mat4_mul(pose->locals[i], palette[parent]);
+    }
+    // Then each becomes the bind pose undone, then the pose applied.
+    for (u32 i = 0; i < s->joint_count; ++i) {
+        palette[i] = mat4_mul(s->inverse_binds[i], palette[i]);
+    }
+}
+
+static void palettes_compute_batch(u32 start, u32 end, void* user_data) {
+    const skeleton_pose* poses = user_data;
+    for (u32 i = start; i < end; ++i) {
+        skeleton_palette_compute(&poses[i]);
+    }
+}
+
+void skeleton_palettes_compute(u32 pose_count, const skeleton_pose* poses, b8 parallel) {
+    if (!pose_count || !poses) {
+        return;
+    }
+    if (parallel && pose_count >= SKELETON_PARALLEL_MIN) {
+        // The poses only read their own skeletons and locals, so need no synchronising.
+        job_system_parallel_for(pose_count, PARALLEL_BATCH_SIZE, palettes_compute_batch, (void*)poses);
+    } else {
+        palettes_compute_batch(0, pose_count, (void*)poses);
+    }
+}
@@ -0,0 +1,86 @@
+/**
+ * @file skeleton.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Contains skeletons, and the joint palettes skinned geometry is drawn with.
+ * @details A skeleton holds the parent of each of its joints, with every parent before its
+ * children, and the inverse of each joint's world matrix in the bind pose. A pose of it is given
+ * as the local matrix of each joint, from which the joint palette is computed in a single linear
+ * pass: each joint's world matrix from its parent's, then the matrix taking a vertex from the bind
+ * pose to the pose. The palettes of many posed instances are computed once per frame, optionally
+ * in parallel on the job system, and handed to the renderer, which skins the vertices on the GPU.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "math_types.h"
+
+/** @brief The most joints a skeleton can have, as vertices refer to them by 8-bit indices. */
+#define SKELETON_MAX_JOINTS 256
+
+/** @brief The fewest poses whose palettes are computed in parallel, when asked to. */
+#define SKELETON_PARALLEL_MIN 32
+
+/** @brief A skeleton, shared by every geometry skinned to it. */
+typedef struct skeleton {
+    /** @brief The number of joints. */
+    u32 joint_count;
+    /** @brief The index of each joint's parent, which is always lower than its own, or INVALID_ID for roots. */
+    u32* parents;
+    /** @brief The inverse of each joint's world matrix in the bind pose. */
+    mat4* inverse_binds;
+} skeleton;
+
+/** @brief A posed instance of a skeleton, whose palette is computed from its local matrices. */
+typedef struct skeleton_pose {
+    /** @brief A constant pointer to the skeleton posed. */
+    const skeleton* skeleton;
+    /** @brief The local matrix of each joint, relative to its parent. */
+    const mat4* locals;
+    /** @brief An array of a matrix for each joint, to hold the palette. */
+    mat4* palette;
+} skeleton_pose;
+
+/**
+ * @brief Creates a new skeleton. Should be called twice; once to obtain the memory amount required
+ * (passing memory=0), and a second time with memory being set to an allocated block.
+ *
+ * @param joint_count The number of joints, between 1 and SKELETON_MAX_JOINTS.
+ * @param parents The index of each joint's parent, lower than its own, or INVALID_ID for roots. Copied.
+ * @param inverse_binds The inverse of each joint's world matrix in the bind pose. Copied.
+ * @param memory_requirement A pointer to hold the required memory for the skeleton.
+ * @param memory An allocated block of memory, or 0 if just obtaining the requirement.
+ * @param out_skeleton A pointer to hold the skeleton.
+ * @return True on success; otherwise false, including if a parent does not come before its child.
+ */
+KAPI b8 skeleton_create(u32 joint_count, const u32* parents, const mat4* inverse_binds, u64* memory_requirement, void* memory, skeleton* out_skeleton);
+
+/**
+ * @brief Destroys the given skeleton. The memory passed at creation is not freed.
+ *
+ * @param s A pointer to the skeleton to be destroyed.
+ */
+KAPI void skeleton_destroy(skeleton* s);
+
+/**
+ * @brief Computes the joint palette of the given pose: for each joint, the matrix taking a vertex
+ * from the bind pose to the pose, in model space.
+ *
+ * @param pose A constant pointer to the pose.
+ */
+KAPI void skeleton_palette_compute(const skeleton_pose* pose);
+
+/**
+ * @brief Computes the joint palettes of the given poses, as skeleton_palette_compute does for each.
+ *
+ * @param pose_count The number of poses.
+ * @param poses An array of the poses.
+ * @param parallel True to spread the poses across the job system, when there are at least
+ * SKELETON_PARALLEL_MIN of them; otherwise they are computed on the calling thread.
+ */
+KAPI void skeleton_palettes_compute(u32 pose_count, const skeleton_pose* poses, b8 parallel);
@@ -0,0 +1,411 @@
+#include "transform_hierarchy.h"
+
+#include "kmath.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "systems/job_system.h"
+
+// The transform at a position is live rather than removed.
+#define NODE_FLAG_LIVE 0x1
+// The transform was changed, so its local and world matrices need recomputing.
+#define NODE_FLAG_DIRTY 0x2
+// The world matrix changed in the last update.
+#define NODE_FLAG_WORLD_CHANGED 0x4
+
+// Marks a depth not yet worked out while reordering.
+#define DEPTH_UNKNOWN 0xFF
+
+// Set in the sparse entries of free ids, which hold the next free id rather than a position.
+#define SPARSE_FREE 0x80000000u
+
+// The number of transforms updated per batch when updating in parallel.
+#define PARALLEL_BATCH_SIZE 256
+
+typedef struct nodes_update_context {
+    transform_hierarchy* hierarchy;
+    u32 first;
+} nodes_update_context;
+
+// The position of the given id in the arrays, or INVALID_ID if the id is not in use.
+static u32 position_of(const transform_hierarchy* hierarchy, u32 id) {
+    if (!hierarchy || !hierarchy->sparse || id >= hierarchy->capacity || (hierarchy->sparse[id] & SPARSE_FREE)) {
+        return INVALID_ID;
+    }
+    return hierarchy->sparse[id];
+}
+
+// The number of ancestors of the transform at the given position.
+static u32 depth_of(const transform_hierarchy* hierarchy, u32 index) {
+    u32 depth = 0;
+    for (u32 p = hierarchy->parents[index]; p != INVALID_ID; p = hierarchy->parents[p]) {
+        depth++;
+    }
+    return depth;
+}
+
+// Moves each live element of the array to its new position, as given by remap.
+static void array_reorder(transform_hierarchy* hierarchy, void* array, u64 element_size) {
+    u8* source = array;
+    u8* destination = hierarchy->scratch;
+    for (u32 i = 0; i < hierarchy->used_count; ++i) {
+        if (hierarchy->flags[i] & NODE_FLAG_LIVE) {
+            kcopy_memory(destination + element_size * hierarchy->remap[i], source + element_size * i, element_size);
+        }
+    }
+    kcopy_memory(array, destination, element_size * hierarchy->count);
+}
+
+// Sorts the live transforms by depth, keeping their order within each depth, and drops removed ones.
+static void hierarchy_reorder(transform_hierarchy* hierarchy) {
+    u32 used_count = hierarchy->used_count;
+    u32* parents = hierarchy->parents;
+    u8* depths = hierarchy->depths;
+
+    // Work out each depth by walking up to the nearest transform whose depth is already known.
+    for (u32 i = 0; i < used_count; ++i) {
+        depths[i] = DEPTH_UNKNOWN;
+    }
+    u32 level_counts[TRANSFORM_HIERARCHY_MAX_DEPTH + 1] = {0};
+    hierarchy->level_count = 0;
+    for (u32 i = 0; i < used_count; ++i) {
+        if (!(hierarchy->flags[i] & NODE_FLAG_LIVE)) {
+            continue;
+        }
+        u32 steps = 0;
+        u32 p = i;
+        while (p != INVALID_ID && depths[p] == DEPTH_UNKNOWN) {
+            p = parents[p];
+            steps++;
+        }
+        u32 depth = p == INVALID_ID ? steps - 1 : depths[p] + steps;
+        for (u32 q = i; q != INVALID_ID && depths[q] == DEPTH_UNKNOWN; q = parents[q]) {
+            depths[q] = (u8)depth--;
+        }
+        level_counts[depths[i]]++;
+        hierarchy->level_count = KMAX(hierarchy->level_count, (u32)depths[i] + 1);
+    }
+
+    // Each depth is a contiguous run, shallowest first, so every parent comes before its children.
+    u32 cursors[TRANSFORM_HIERARCHY_MAX_DEPTH + 1];
+    hierarchy->level_starts[0] = 0;
+    for (u32 l = 0; l < hierarchy->level_count; ++l) {
+        cursors[l] = hierarchy->level_starts[l];
+        hierarchy->level_starts[l + 1] = hierarchy->level_starts[l] + level_counts[l];
+    }
+    for (u32 i = 0; i < used_count; ++i) {
+        if (hierarchy->flags[i] & NODE_FLAG_LIVE) {
+            hierarchy->remap[i] = cursors[depths[i]]++;
+        }
+    }
+
+    // Parents are positions too, so are remapped as well as moved.
+    u32* new_parents = hierarchy->scratch;
+    for (u32 i = 0; i < used_count; ++i) {
+        if (hierarchy->flags[i] & NODE_FLAG_LIVE) {
+            new_parents[hierarchy->remap[i]] = parents[i] == INVALID_ID ? INVALID_ID : hierarchy->remap[parents[i]];
+        }
+    }
+    kcopy_memory(parents, new_parents, sizeof(u32) * hierarchy->count);
+
+    array_reorder(hierarchy, hierarchy->locals, sizeof(mat4));
+    array_reorder(hierarchy, hierarchy->worlds, sizeof(mat4));
+    array_reorder(hierarchy, hierarchy->rotations, sizeof(quat));
+    array_reorder(hierarchy, hierarchy->positions, sizeof(vec3));
+    array_reorder(hierarchy, hierarchy->scales, sizeof(vec3));
+    array_reorder(hierarchy, hierarchy->ids, sizeof(u32));
+    array_reorder(hierarchy, hierarchy->depths, sizeof(u8));
+    // Last, as the others rely on the flags to know which transforms are live.
+    array_reorder(hierarchy, hierarchy->flags, sizeof(u8));
+
+    hierarchy->used_count = hierarchy->count;
+    for (u32 i = 0; i < hierarchy->count; ++i) {
+        hierarchy->sparse[hierarchy->ids[i]] = i;
+    }
+    hierarchy->order_dirty = false;
+}
+
+b8 transform_hierarchy_create(u32 capacity, u64* memory_requirement, void* memory, transform_hierarchy* out_hierarchy) {
+    if (capacity == 0 || capacity >= SPARSE_FREE) {
+        KERROR("transform_hierarchy_create requires a valid, non-zero capacity. Create failed.");
+        return false;
+    }
+    if (!memory_requirement) {
+        KERROR("transform_hierarchy_create requires memory_requirement to exist. Create failed.");
+        return false;
+    }
+
+    // The matrices and scratch space first, so they keep the alignment of the block, then the smaller arrays.
+    u64 per_transform = sizeof(mat4) * 3 + sizeof(quat) + sizeof(vec3) * 2 + sizeof(u32) * 4 + sizeof(u8) * 2;
+    *memory_requirement = per_transform * capacity;
+
+    // If only obtaining requirement, boot out.
+    if (!memory) {
+        return true;
+    }
+    if (!out_hierarchy) {
+        KERROR("transform_hierarchy_create requires a pointer to hold the hierarchy. Create failed.");
+        return false;
+    }
+
+    kzero_memory(out_hierarchy, sizeof(transform_hierarchy));
+    out_hierarchy->capacity = capacity;
+    out_hierarchy->locals = memory;
+    out_hierarchy->worlds = out_hierarchy->locals + capacity;
+    out_hierarchy->scratch = out_hierarchy->worlds + capacity;
+    out_hierarchy->rotations = (quat*)((mat4*)out_hierarchy->scratch + capacity);
+    out_hierarchy->positions = (vec3*)(out_hierarchy->rotations + capacity);
+    out_hierarchy->scales = out_hierarchy->positions + capacity;
+    out_hierarchy->parents = (u32*)(out_hierarchy->scales + capacity);
+    out_hierarchy->ids = out_hierarchy->parents + capacity;
+    out_hierarchy->sparse = out_hierarchy->ids + capacity;
+    out_hierarchy->remap = out_hierarchy->sparse + capacity;
+    out_hierarchy->depths = (u8*)(out_hierarchy->remap + capacity);
+    out_hierarchy->flags = out_hierarchy->depths + capacity;
+
+    // Every id starts out free, chained in order.
+    for (u32 i = 0; i < capacity; ++i) {
+        out_hierarchy->sparse[i] = i + 1 < capacity ? (i + 1) | SPARSE_FREE : INVALID_ID;
+    }
+    out_hierarchy->free_head = 0;
+    return true;
+}
+
+void transform_hierarchy_destroy(transform_hierarchy* hierarchy) {
+    if (hierarchy) {
+        kzero_memory(hierarchy, sizeof(transform_hierarchy));
+    }
+}
+
+u32 transform_hierarchy_add(transform_hierarchy* hierarchy, const transform* t, u32 parent_id) {
+    if (!hierarchy || !hierarchy->sparse || !t) {
+        KERROR("transform_hierarchy_add requires an initialized hierarchy and a transform.");
+        return INVALID_ID;
+    }
+
+    u32 parent = INVALID_ID;
+    if (parent_id != INVALID_ID) {
+        parent = position_of(hierarchy, parent_id);
+        if (parent == INVALID_ID) {
+            KERROR("transform_hierarchy_add - parent %u does not exist.", parent_id);
+            return INVALID_ID;
+        }
+        if (depth_of(hierarchy, parent) + 1 > TRANSFORM_HIERARCHY_MAX_DEPTH) {
+            KERROR("transform_hierarchy_add - transforms may be nested at most %u deep.", TRANSFORM_HIERARCHY_MAX_DEPTH);
+            return INVALID_ID;
+        }
+    }
+    if (hierarchy->free_head == INVALID_ID) {
+        KERROR("transform_hierarchy_add - hierarchy of %u transforms is full.", hierarchy->capacity);
+        return INVALID_ID;
+    }
+    if (hierarchy->used_count == hierarchy->capacity) {
+        // The positions of removed transforms are only reclaimed by reordering.
+        hierarchy_reorder(hierarchy);
+        parent = parent_id == INVALID_ID ? INVALID_ID : position_of(hierarchy, parent_id);
+    }
+
+    u32 id = hierarchy->free_head;
+    hierarchy->free_head = hierarchy->sparse[id] == INVALID_ID ? INVALID_ID : hierarchy->sparse[id] & ~SPARSE_FREE;
+
+    u32 index = hierarchy->used_count++;
+    hierarchy->sparse[id] = index;
+    hierarchy->ids[index] = id;
+    hierarchy->positions[index] = t->position;
+    hierarchy->rotations[index] = t->rotation;
+    hierarchy->scales[index] = t->scale;
+    hierarchy->locals[index] = mat4_identity();
+    hierarchy->worlds[index] = mat4_identity();
+    hierarchy->parents[index] = parent;
+    hierarchy->flags[index] = NODE_FLAG_LIVE | NODE_FLAG_DIRTY;
+    hierarchy->count++;
+    hierarchy->order_dirty = true;
+    return id;
+}
+
+b8 transform_hierarchy_remove(transform_hierarchy* hierarchy, u32 id) {
+    u32 index = position_of(hierarchy, id);
+    if (index == INVALID_ID) {
+        return false;
+    }
+
+    // Children move up to the removed transform's parent.
+    u32 parent = hierarchy->parents[index];
+    for (u32 i = 0; i < hierarchy->used_count; ++i) {
+        if ((hierarchy->flags[i] & NODE_FLAG_LIVE) && hierarchy->parents[i] == index) {
+            hierarchy->parents[i] = parent;
+            hierarchy->flags[i] |= NODE_FLAG_DIRTY;
+        }
+    }
+
+    hierarchy->flags[index] = 0;
+    hierarchy->sparse[id] = hierarchy->free_head == INVALID_ID ? INVALID_ID : hierarchy->free_head | SPARSE_FREE;
+    hierarchy->free_head = id;
+    hierarchy->count--;
+    hierarchy->order_dirty = true;
+    return true;
+}
+
+b8 transform_hierarchy_set_parent(transform_hierarchy* hierarchy, u32 id, u32 parent_id) {
+    u32 index = position_of(hierarchy, id);
+    if (index == INVALID_ID) {
+        KERROR("transform_hierarchy_set_parent - transform %u does not exist.", id);
+        return false;
+    }
+
+    u32 parent = INVALID_ID;
+    u32 depth = 0;
+    if (parent_id != INVALID_ID) {
+        parent = position_of(hierarchy, parent_id);
+        if (parent == INVALID_ID) {
+            KERROR("transform_hierarchy_set_parent - parent %u does not exist.", parent_id);
+            return false;
+        }
+        // Refuse to move a transform under itself or one of its descendants.
+        for (u32 p = parent; p != INVALID_ID; p = hierarchy->parents[p]) {
+            if (p == index) {
+                KERROR("transform_hierarchy_set_parent - transform %u cannot be moved under itself or a descendant.", id);
+                return false;
+            }
+            depth++;
+        }
+    }
+
+    // The deepest descendant must still fit.
+    u32 height = 0;
+    for (u32 i = 0; i < hierarchy->used_count; ++i) {
+        if (!(hierarchy->flags[i] & NODE_FLAG_LIVE)) {
+            continue;
+        }
+        u32 steps = 0;
+        for (u32 p = i; p != INVALID_ID; p = hierarchy->parents[p], ++steps) {
+            if (p == index) {
+                height = KMAX(height, steps);
+                break;
+            }
+        }
+    }
+    if (depth + height > TRANSFORM_HIERARCHY_MAX_DEPTH) {
+        KERROR("transform_hierarchy_set_parent - transforms may be nested at most %u deep.", TRANSFORM_HIERARCHY_MAX_DEPTH);
+        return false;
+    }
+
+    hierarchy->parents[index] = parent;
+    hierarchy->flags[index] |= NODE_FLAG_DIRTY;
+    hierarchy->order_dirty = true;
+    return true;
+}
+
+u32 transform_hierarchy_parent_get(const transform_hierarchy* hierarchy, u32 id) {
+    u32 index = position_of(hierarchy, id);
+    if (index == INVALID_ID || hierarchy->parents[index] == INVALID_ID) {
+        return INVALID_ID;
+    }
+    return hierarchy->ids[hierarchy->parents[index]];
+}
+
+void transform_hierarchy_set_position_rotation_scale(transform_hierarchy* hierarchy, u32 id, vec3 position, quat rotation, vec3 scale) {
+    u32 index = position_of(hierarchy, id);
+    if (index != INVALID_ID) {
+        hierarchy->positions[index] = position;
+        hierarchy->rotations[index] = rotation;
+        hierarchy->scales[index] = scale;
+        hierarchy->flags[index] |= NODE_FLAG_DIRTY;
+    }
+}
+
+void transform_hierarchy_set_position(transform_hierarchy* hierarchy, u32 id, vec3 position) {
+    u32 index = position_of(hierarchy, id);
+    if (index != INVALID_ID) {
+        hierarchy->positions[index] = position;
+        hierarchy->flags[index] |= NODE_FLAG_DIRTY;
+    }
+}
+
+void transform_hierarchy_set_rotation(transform_hierarchy* hierarchy, u32 id, quat rotation) {
+    u32 index = position_of(hierarchy, id);
+    if (index != INVALID_ID) {
+        hierarchy->rotations[index] = rotation;
+        hierarchy->flags[index] |= NODE_FLAG_DIRTY;
+    }
+}
+
+void transform_hierarchy_set_scale(transform_hierarchy* hierarchy, u32 id, vec3 scale) {
+    u32 index = position_of(hierarchy, id);
+    if (index != INVALID_ID) {
+        hierarchy->scales[index] = scale;
+        hierarchy->flags[index] |= NODE_FLAG_DIRTY;
+    }
+}
+
+void transform_hierarchy_translate(transform_hierarchy* hierarchy, u32 id, vec3 translation) {
+    u32 index = position_of(hierarchy, id);
+    if (index != INVALID_ID) {
+        hierarchy->positions[index] = vec3_add(hierarchy->positions[index], translation);
+        hierarchy->flags[index] |= NODE_FLAG_DIRTY;
+    }
+}
+
+void transform_hierarchy_rotate(transform_hierarchy* hierarchy, u32 id, quat rotation) {
+    u32 index = position_of(hierarchy, id);
+    if (index != INVALID_ID) {
+        hierarchy->rotations[index] = quat_mul(hierarchy->rotations[index], rotation);
+        hierarchy->flags[index] |= NODE_FLAG_DIRTY;
+    }
+}
+
+// Updates the transforms in the range [start, end), whose parents must already be up to date.
+static void nodes_update(transform_hierarchy* hierarchy, u32 start, u32 end) {
+    for (u32 i = start; i < end; ++i) {
+        u8 flags = hierarchy->flags[i];
+        u32 parent = hierarchy->parents[i];
+        b8 changed = (flags & NODE_FLAG_DIRTY) || (parent != INVALID_ID && (hierarchy->flags[parent] & NODE_FLAG_WORLD_CHANGED));
+        if (flags & NODE_FLAG_DIRTY) {
+            // The same composition as transform_get_local.
+            mat4 local = mat4_mul(quat_to_mat4(hierarchy->rotations[i]), mat4_translation(hierarchy->positions[i]));
+            hierarchy->locals[i] = mat4_mul(mat4_scale(hierarchy->scales[i]), local);
+        }
+        if (changed) {
+            hierarchy->worlds[i] = parent != INVALID_ID ? mat4_mul(hierarchy->locals[i], hierarchy->worlds[parent]) : hierarchy->locals[i];
+        }
+        hierarchy->flags[i] = NODE_FLAG_LIVE | (changed ? NODE_FLAG_WORLD_CHANGED : 0);
+    }
+}
+
+static void nodes_update_batch(u32 start, u32 end, void* user_data) {
+    nodes_update_context* context = user_data;
+    nodes_update(context->hierarchy, context->first + start, context->first + end);
+}
+
+void transform_hierarchy_update(transform_hierarchy* hierarchy, b8 parallel) {
+    if (!hierarchy || !hierarchy->sparse) {
+        return;
+    }
+    if (hierarchy->order_dirty) {
+        hierarchy_reorder(hierarchy);
+    }
+
+    // One depth at a time, as each only reads the world matrices of the depth before it.
+    for (u32 l = 0; l < hierarchy->level_count; ++l) {
+        u32 start = hierarchy->level_starts[l];
+        u32 end = hierarchy->level_starts[l + 1];
+        if (parallel && end - start >= TRANSFORM_HIERARCHY_PARALLEL_MIN) {
+            nodes_update_context context = {hierarchy, start};
+            job_system_parallel_for(end - start, PARALLEL_BATCH_SIZE, nodes_update_batch, &context);
+        } else {
+            nodes_update(hierarchy, start, end);
+        }
+    }
+}
+
+mat4 transform_hierarchy_world_get(const transform_hierarchy* hierarchy, u32 id) {
+    u32 index = position_of(hierarchy, id);
+    if (index == INVALID_ID) {
+        return mat4_identity();
+    }
+    return hierarchy->worlds[index];
+}
+
+b8 transform_hierarchy_world_changed(const transform_hierarchy* hierarchy, u32 id) {
+    u32 index = position_of(hierarchy, id);
+    return index != INVALID_ID && (hierarchy->flags[index] & NODE_FLAG_WORLD_CHANGED);
+}
@@ -0,0 +1,219 @@
+/**
+ * @file transform_hierarchy.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Contains the implementation of the transform hierarchy.
+ * @details A transform hierarchy holds a fixed number of transforms, each addressed by an id,
+ * along with their local and world matrices. Transforms are stored in flat arrays ordered by
+ * their depth in the hierarchy, so every parent comes before its children, and world matrices
+ * are brought up to date in a single linear pass per frame by transform_hierarchy_update.
+ * Changing a transform marks it dirty, and world matrices are only recomputed for dirty
+ * transforms and their descendants. Each depth can optionally be updated in parallel on the
+ * job system. Adding, removing or reparenting transforms reorders the arrays at the next
+ * update, so ids stay valid but their positions do not. Not thread-safe.
+ * @version 1.0
+ *
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "math_types.h"
+
+/** @brief The deepest a transform can be nested, with roots at depth 0. */
+#define TRANSFORM_HIERARCHY_MAX_DEPTH 31
+
+/** @brief The fewest transforms at one depth which are updated in parallel, when asked to. */
+#define TRANSFORM_HIERARCHY_PARALLEL_MIN 1024
+
+/** @brief The transform hierarchy structure. */
+typedef struct transform_hierarchy {
+    /** @brief The most transforms the hierarchy can hold. */
+    u32 capacity;
+    /** @brief The number of live transforms. */
+    u32 count;
+    /** @brief The number of positions in use in the arrays, including those of removed transforms. */
+    u32 used_count;
+    /** @brief The first free id, or INVALID_ID if every id is in use. */
+    u32 free_head;
+    /** @brief Indicates the arrays need reordering by depth before the next update. */
+    b8 order_dirty;
+    /** @brief The number of depths in use, as of the last reordering. */
+    u32 level_count;
+    /** @brief The position in the arrays each depth starts at, with one past the last depth's end. */
+    u32 level_starts[TRANSFORM_HIERARCHY_MAX_DEPTH + 2];
+
+    /** @brief The local matrix of each transform. */
+    mat4* locals;
+    /** @brief The world matrix of each transform, as of the last update. */
+    mat4* worlds;
+    /** @brief The rotation of each transform. */
+    quat* rotations;
+    /** @brief The position of each transform. */
+    vec3* positions;
+    /** @brief The scale of each transform. */
+    vec3* scales;
+    /** @brief The position in the arrays of each transform's parent, or INVALID_ID for roots. */
+    u32* parents;
+    /** @brief The id of the transform at each position. */
+    u32* ids;
+    /** @brief The depth of each transform. */
+    u8* depths;
+    /** @brief Flags for each transform, indicating if it is live, dirty or had its world matrix change. */
+    u8* flags;
+    /** @brief For ids in use, the position of the transform in the arrays. For free ids, the next free id. */
+    u32* sparse;
+    /** @brief The new position of each transform while reordering. */
+    u32* remap;
+    /** @brief Space to reorder one array through. */
+    void* scratch;
+} transform_hierarchy;
+
+/**
+ * @brief Creates a new transform hierarchy. Should be called twice; once to obtain the memory
+ * amount required (passing memory=0), and a second time with memory being set to an allocated block.
+ *
+ * @param capacity The most transforms the hierarchy should hold.
+ * @param memory_requirement A pointer to hold the required memory for the hierarchy.
+ * @param memory An allocated block of memory, or 0 if just obtaining the requirement.
+ * @param out_hierarchy A pointer to hold the transform hierarchy.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 transform_hierarchy_create(u32 capacity, u64* memory_requirement, void* memory, transform_hierarchy* out_hierarchy);
+
+/**
+ * @brief Destroys the given transform hierarchy. The memory passed at creation is not freed.
+ *
+ * @param hierarchy A pointer to the hierarchy to be destroyed.
+ */
+KAPI void transform_hierarchy_destroy(transform_hierarchy* hierarchy);
+
+/**
+ * @brief Adds a transform with the position, rotation and scale of the given one. Its parent is
+ * not copied, and it is instead placed under parent_id. Its world matrix is valid after the next update.
+ *
+ * @param hierarchy A pointer to the hierarchy.
+ * @param t A constant pointer to the transform to copy.
+ * @param parent_id The id of the parent transform, or INVALID_ID to add a root.
+ * @return The id of the new transform, or INVALID_ID if the hierarchy is full, the parent
+ * does not exist or the transform would be nested too deeply.
+ */
+KAPI u32 transform_hierarchy_add(transform_hierarchy* hierarchy, const transform* t, u32 parent_id);
+
+/**
+ * @brief Removes a transform. Its children are moved to its parent, keeping their
+ * local transforms. The id may be reused by a later add. O(n) in the number of transforms.
+ *
+ * @param hierarchy A pointer to the hierarchy.
+ * @param id The id of the transform to remove.
+ * @return True if the transform was removed; false if the id is not in use.
+ */
+KAPI b8 transform_hierarchy_remove(transform_hierarchy* hierarchy, u32 id);
+
+/**
+ * @brief Moves a transform, along with its descendants, under a new parent, keeping its local transform.
+ *
+ * @param hierarchy A pointer to the hierarchy.
+ * @param id The id of the transform to move.
+ * @param parent_id The id of the new parent, or INVALID_ID to make it a root.
+ * @return True on success; false if either id is not in use, the parent is the transform or one
+ * of its descendants, or the move would nest transforms too deeply.
+ */
+KAPI b8 transform_hierarchy_set_parent(transform_hierarchy* hierarchy, u32 id, u32 parent_id);
+
+/**
+ * @brief Obtains the id of the parent of the given transform.
+ *
+ * @param hierarchy A pointer to the hierarchy.
+ * @param id The id of the transform.
+ * @return The id of the parent, or INVALID_ID if it is a root or the id is not in use.
+ */
+KAPI u32 transform_hierarchy_parent_get(const transform_hierarchy* hierarchy, u32 id);
+
+/**
+ * @brief Sets the position, rotation and scale of the given transform.
+ *
+ * @param hierarchy A pointer to the hierarchy.
+ * @param id The id of the transform.
+ * @param position The position to be used.
+ * @param rotation The rotation to be used.
+ * @param scale The scale to be used.
+ */
+KAPI void transform_hierarchy_set_position_rotation_scale(transform_hierarchy* hierarchy, u32 id, vec3 position, quat rotation, vec3 scale);
+
+/**
+ * @brief Sets the position of the given transform.
+ *
+ * @param hierarchy A pointer to the hierarchy.
+ * @param id The id of the transform.
+ * @param position The position to be used.
+ */
+KAPI void transform_hierarchy_set_position(transform_hierarchy* hierarchy, u32 id, vec3 position);
+
+/**
+ * @brief Sets the rotation of the given transform.
+ *
+ * @param hierarchy A pointer to the hierarchy.
+ * @param id The id of the transform.
+ * @param rotation The rotation to be used.
+ */
+KAPI void transform_hierarchy_set_rotation(transform_hierarchy* hierarchy, u32 id, quat rotation);
+
+/**
+ * @brief Sets the scale of the given transform.
+ *
+ * @param hierarchy A pointer to the hierarchy.
+ * @param id The id of the transform.
+ * @param scale The scale to be used.
+ */
+KAPI void transform_hierarchy_set_scale(transform_hierarchy* hierarchy, u32 id, vec3 scale);
+
+/**
+ * @brief Applies a translation to the given transform.
+ *
+ * @param hierarchy A pointer to the hierarchy.
+ * @param id The id of the transform.
+ * @param translation The translation to be applied.
+ */
+KAPI void transform_hierarchy_translate(transform_hierarchy* hierarchy, u32 id, vec3 translation);
+
+/**
+ * @brief Applies a rotation to the given transform.
+ *
+ * @param hierarchy A pointer to the hierarchy.
+ * @param id The id of the transform.
+ * @param rotation The rotation to be applied.
+ */
+KAPI void transform_hierarchy_rotate(transform_hierarchy* hierarchy, u32 id, quat rotation);
+
+/**
+ * @brief Brings the local and world matrices of every dirty transform, and the world matrices
+ * of their descendants, up to date. Should be called once per frame, after transforms are changed
+ * and before their world matrices are used.
+ *
+ * @param hierarchy A pointer to the hierarchy.
+ * @param parallel Indicates if depths holding at least TRANSFORM_HIERARCHY_PARALLEL_MIN transforms should be
+ * updated in parallel on the job system. Must not be set while anything else uses the hierarchy.
+ */
+KAPI void transform_hierarchy_update(transform_hierarchy* hierarchy, b8 parallel);
+
+/**
+ * @brief Obtains the world matrix of the given transform, as of the last update.
+ *
+ * @param hierarchy A pointer to the hierarchy.
+ * @param id The id of the transform.
+ * @return The world matrix, or an identity matrix if the id is not in use.
+ */
+KAPI mat4 transform_hierarchy_world_get(const transform_hierarchy* hierarchy, u32 id);
+
+/**
+ * @brief Indicates if the world matrix of the given transform changed in the last update,
+ * such as for skipping work which depends on it when it did not.
+ *
+ * @param hierarchy A pointer to the hierarchy.
+ * @param id The id of the transform.
+ * @return True if the world matrix changed; otherwise false.
+ */
+KAPI b8 transform_hierarchy_world_changed(const transform_hierarchy* hierarchy, u32 id);
@@ -124,6 +124,56 @@ void* dynamic_allocator_allocate_aligned(dynamic_allocator* allocator, u64 size,
     return 0;
 }
 
+void* dynamic_allocator_reallocate(dynamic_allocator* allocator, void* block, u64 new_size) {
+    if (!allocator || !block || !new_size) {
+        KERROR("dynamic_allocator_reallocate requires a valid allocator, block and size.");
+        return 0;
+    }
+
+    dynamic_allocator_state* state = allocator->memory;
+    if (block < state->memory_block || block > state->memory_block + state->total_size) {
+        void* end_of_block = (void*)(state->memory_block + state->total_size);
+        KERROR("dynamic_allocator_reallocate trying to resize block (0x%p) outside of allocator range (0x%p)-(0x%p)", block, state->memory_block, end_of_block);
+        return 0;
+    }
+
+    u32* block_size = (u32*)((u64)block - KSIZE_STORAGE);
+    u64 old_size = *block_size;
+    if (new_size == old_size) {
+        return block;
+    }
+    alloc_header* header = (alloc_header*)((u64)block + old_size);
+    void* start = header->start;
+    u16 alignment = header->alignment;
+    u64 overhead = alignment + sizeof(alloc_header) + KSIZE_STORAGE;
+    KASSERT_MSG(overhead + new_size < 4294967295U, "dynamic_allocator_reallocate called with required size > 4 GiB. Don't do that.");
+    u64 offset = (u64)start - (u64)state->memory_block;
+
+    // Both in-place cases change the tail end of the block, so only the size and header need updating.
+    b8 in_place = false;
+    if (new_size < old_size) {
+        in_place = freelist_free_block(&state->list, old_size - new_size, offset + overhead + new_size);
+    } else {
+        in_place = freelist_extend_block(&state->list, offset, overhead + old_size, new_size - old_size);
+    }
+    if (in_place) {
+        *block_size = (u32)new_size;
+        header = (alloc_header*)((u64)block + new_size);
+        header->start = start;
+        header->alignment = alignment;
+        return block;
+    }
+
+    // Can't be done in place, so move it.
+    void* new_block = dynamic_allocator_allocate_aligned(allocator, new_size, alignment);
+    if (!new_block) {
+        return 0;
+    }
+    kcopy_memory(new_block, block, KMIN(old_size, new_size));
+    dynamic_allocator_free_aligned(allocator, block);
+    return new_block;
+}
+
 b8 dynamic_allocator_free(dynamic_allocator* allocator, void* block, u64 size) {
     return dynamic_allocator_free_aligned(allocator, block);
 }
@@ -171,6 +221,11 @@ u64 dynamic_allocator_total_space(dynamic_allocator* allocator) {
     return state->total_size;
 }
 
+f32 dynamic_allocator_fragmentation(dynamic_allocator* allocator) {
+    dynamic_allocator_state* state = allocator->memory;
+    return freelist_fragmentation(&state->list);
+}
+
 u64 dynamic_allocator_header_size() {
     // Enough space for a header and size storage.
     return sizeof(alloc_header) + KSIZE_STORAGE;
@@ -58,6 +58,18 @@ KAPI void* dynamic_allocator_allocate(dynamic_allocator* allocator, u64 size);
  */
 KAPI void* dynamic_allocator_allocate_aligned(dynamic_allocator* allocator, u64 size, u16 alignment);
 
+/**
+ * @brief Resizes the given block of memory, keeping its alignment. The block is grown or shrunk in
+ * place where possible. Otherwise, a new block is allocated, the contents are copied over and the
+ * old block is freed.
+ *
+ * @param allocator A pointer to the allocator the block belongs to.
+ * @param block The block to be resized. Must have been allocated by the provided allocator.
+ * @param new_size The new size of the block in bytes.
+ * @return The resized block, which may have moved. If this fails, 0 is returned and block is left untouched.
+ */
+KAPI void* dynamic_allocator_reallocate(dynamic_allocator* allocator, void* block, u64 new_size);
+
 /**
  * @brief Frees the given block of memory.
  *
@@ -105,5 +117,14 @@ KAPI u64 dynamic_allocator_free_space(dynamic_allocator* allocator);
  */
 KAPI u64 dynamic_allocator_total_space(dynamic_allocator* allocator);
 
+/**
+ * @brief Obtains the fragmentation of the free space left in the provided allocator.
+ * See freelist_fragmentation for details.
+ *
+ * @param allocator A pointer to the allocator to be examined.
+ * @return The fragmentation, from 0 (one contiguous range) towards 1 (many small ranges).
+ */
+KAPI f32 dynamic_allocator_fragmentation(dynamic_allocator* allocator);
+
 /** Obtains the size of the internal allocation header. This is really only used for unit testing purposes. */
 KAPI u64 dynamic_allocator_header_size();
@@ -0,0 +1,53 @@
+#include "frame_arena.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+b8 frame_arena_create(u64 buffer_size, u8 buffer_count, frame_arena* out_arena) {
+    if (!out_arena || buffer_size == 0) {
+        KERROR("frame_arena_create requires a nonzero buffer_size and a valid pointer to hold the arena.");
+        return false;
+    }
+    if (buffer_count < 1 || buffer_count > FRAME_ARENA_MAX_BUFFER_COUNT) {
+        KERROR("frame_arena_create - buffer_count must be between 1 and %u.", FRAME_ARENA_MAX_BUFFER_COUNT);
+        return false;
+    }
+
+    kzero_memory(out_arena, sizeof(frame_arena));
+    out_arena->buffer_count = buffer_count;
+    out_arena->current_index = 0;
+    for (u8 i = 0; i < buffer_count; ++i) {
+        if (!linear_allocator_create_reserved(buffer_size, &out_arena->buffers[i])) {
+            KERROR("frame_arena_create - failed to reserve buffer %u.", i);
+            out_arena->buffer_count = i;
+            frame_arena_destroy(out_arena);
+            return false;
+        }
+    }
+    return true;
+}
+
+void frame_arena_destroy(frame_arena* arena) {
+    if (arena) {
+        for (u8 i = 0; i < arena->buffer_count; ++i) {
+            linear_allocator_destroy(&arena->buffers[i]);
+        }
+        arena->buffer_count = 0;
+        arena->current_index = 0;
+    }
+}
+
+void frame_arena_begin_frame(frame_arena* arena) {
+    if (arena && arena->buffer_count) {
+        arena->current_index = (arena->current_index + 1) % arena->buffer_count;
+        linear_allocator_free_all(&arena->buffers[arena->current_index]);
+    }
+}
+
+linear_allocator* frame_arena_allocator(frame_arena* arena) {
+    return &arena->buffers[arena->current_index];
+}
+
+void* frame_arena_allocate(frame_arena* arena, u64 size) {
+    return linear_allocator_allocate(&arena->buffers[arena->current_index], size);
+}
@@ -0,0 +1,79 @@
+/**
+ * @file frame_arena.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Contains the implementation of the frame arena.
+ * @details A frame arena holds one linear allocator per frame in flight, and rotates
+ * between them at the start of each frame. Data allocated during a frame therefore stays
+ * valid until the same buffer comes around again, which allows it to be consumed while
+ * the next frame is being built. Combined with darray_create_with_allocator, this allows
+ * per-frame growable arrays to be built without touching the heap. Buffers are reserved
+ * ranges of virtual memory, so they can be sized for the worst frame while only committing
+ * what is actually used.
+ * @version 1.0
+ *
+ * 
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ * 
+ */
+
+#pragma once
+
+#include "memory/linear_allocator.h"
+
+/** @brief The maximum number of buffers a frame arena can rotate between. */
+#define FRAME_ARENA_MAX_BUFFER_COUNT 3
+
+/** @brief The data structure for a frame arena. */
+typedef struct frame_arena {
+    /** @brief The number of buffers in use. */
+    u8 buffer_count;
+    /** @brief The index of the buffer used for the current frame. */
+    u8 current_index;
+    /** @brief The buffers, one per frame in flight. */
+    linear_allocator buffers[FRAME_ARENA_MAX_BUFFER_COUNT];
+} frame_arena;
+
+/**
+ * @brief Creates a frame arena with the given number of buffers, each of the given size.
+ *
+ * @param buffer_size The maximum size in bytes of each buffer. This is reserved up front, but
+ * only committed as it is used.
+ * @param buffer_count The number of buffers, which should match the number of frames in flight.
+ * Must be between 1 and FRAME_ARENA_MAX_BUFFER_COUNT.
+ * @param out_arena A pointer to hold the created arena.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 frame_arena_create(u64 buffer_size, u8 buffer_count, frame_arena* out_arena);
+
+/**
+ * @brief Destroys the given arena, freeing the memory of all of its buffers.
+ *
+ * @param arena A pointer to the arena to be destroyed.
+ */
+KAPI void frame_arena_destroy(frame_arena* arena);
+
+/**
+ * @brief Moves the arena on to its next buffer and frees everything within it. Should be
+ * called once at the start of each frame, before anything is allocated for that frame.
+ *
+ * @param arena A pointer to the arena.
+ */
+KAPI void frame_arena_begin_frame(frame_arena* arena);
+
+/**
+ * @brief Obtains the linear allocator for the current frame, which may be passed to
+ * anything that needs to allocate per-frame data.
+ *
+ * @param arena A pointer to the arena.
+ * @return A pointer to the current frame's allocator.
+ */
+KAPI linear_allocator* frame_arena_allocator(frame_arena* arena);
+
+/**
+ * @brief Allocates the given amount from the current frame's buffer.
+ *
+ * @param arena A pointer to the arena to allocate from.
+ * @param size The size to be allocated.
+ * @return A pointer to a block of memory as allocated. If this fails, 0 is returned.
+ */
+KAPI void* frame_arena_allocate(frame_arena* arena, u64 size);
@@ -0,0 +1,237 @@
+#include "host_allocator.h"
+
+#include "core/katomic.h"
+#include "core/logger.h"
+
+// The smallest size class, as a shift.
+#define HOST_ALLOCATOR_MIN_CLASS_SHIFT 6
+
+// Where a block came from.
+#define HOST_BLOCK_SOURCE_HEAP 0xFE
+#define HOST_BLOCK_SOURCE_ARENA 0xFF
+
+// The alignment blocks, and so headers, start at.
+#define HOST_BLOCK_BASE_ALIGNMENT 16
+
+// Kept just before every block handed out.
+typedef struct host_block_header {
+    // The size asked for.
+    u64 size;
+    u16 alignment;
+    // The size class of a pooled block, or one of the sources above.
+    u8 source;
+    // The arena of a transient block.
+    u8 arena;
+    // The distance back from the block to the start of the memory holding it.
+    u32 offset;
+} host_block_header;
+
+STATIC_ASSERT(sizeof(host_block_header) == HOST_BLOCK_BASE_ALIGNMENT, "The host block header must be as large as the alignment blocks start at.");
+
+static host_block_header* header_get(const void* block) {
+    return (host_block_header*)((u8*)block - sizeof(host_block_header));
+}
+
+// The memory needed to hold a block of the given size and alignment, along with its header.
+static u64 block_footprint(u64 size, u16 alignment) {
+    return size + sizeof(host_block_header) + (alignment > HOST_BLOCK_BASE_ALIGNMENT ? alignment - HOST_BLOCK_BASE_ALIGNMENT : 0);
+}
+
+// The size class holding the given footprint, or HOST_BLOCK_SOURCE_HEAP if none does.
+static u8 class_get(u64 footprint) {
+    for (u8 i = 0; i < HOST_ALLOCATOR_CLASS_COUNT; ++i) {
+        if (footprint <= (1ull << (HOST_ALLOCATOR_MIN_CLASS_SHIFT + i))) {
+            return i;
+        }
+    }
+    return HOST_BLOCK_SOURCE_HEAP;
+}
+
+static u64 class_size(u8 size_class) {
+    return 1ull << (HOST_ALLOCATOR_MIN_CLASS_SHIFT + size_class);
+}
+
+// Places a block of the given size and alignment within the given memory, writing its header.
+static void* block_place(u8* memory, u64 size, u16 alignment, u8 source, u8 arena) {
+    u64 address = (u64)(memory + sizeof(host_block_header));
+    address = (address + alignment - 1) & ~((u64)alignment - 1);
+    u8* block = (u8*)address;
+    host_block_header* header = header_get(block);
+    header->size = size;
+    header->alignment = alignment;
+    header->source = source;
+    header->arena = arena;
+    header->offset = (u32)(block - memory);
+    return block;
+}
+
+b8 host_allocator_create(u64 arena_size, u8 arena_count, memory_tag tag, host_allocator* out_allocator) {
+    if (!out_allocator) {
+        KERROR("host_allocator_create requires a pointer to hold the allocator. Create failed.");
+        return false;
+    }
+    if (arena_size && (arena_count < 2 || arena_count > HOST_ALLOCATOR_MAX_ARENA_COUNT)) {
+        KERROR("host_allocator_create requires between 2 and %u arenas. Create failed.", HOST_ALLOCATOR_MAX_ARENA_COUNT);
+        return false;
+    }
+
+    kzero_memory(out_allocator, sizeof(host_allocator));
+    out_allocator->tag = tag;
+    for (u8 i = 0; i < HOST_ALLOCATOR_CLASS_COUNT; ++i) {
+        if (!mpmc_queue_create(sizeof(void*), HOST_ALLOCATOR_POOL_CAPACITY, 0, &out_allocator->pools[i])) {
+            KERROR("host_allocator_create failed to create the pool of size class %u. Create failed.", i);
+            host_allocator_destroy(out_allocator);
+            return false;
+        }
+    }
+    if (arena_size) {
+        out_allocator->arena_size = (arena_size + HOST_BLOCK_BASE_ALIGNMENT - 1) & ~(u64)(HOST_BLOCK_BASE_ALIGNMENT - 1);
+        out_allocator->arena_count = arena_count;
+        for (u8 i = 0; i < arena_count; ++i) {
+            out_allocator->arenas[i].memory = kallocate_aligned(out_allocator->arena_size, HOST_BLOCK_BASE_ALIGNMENT, tag);
+        }
+    }
+    return true;
+}
+
+void host_allocator_destroy(host_allocator* allocator) {
+    if (!allocator) {
+        return;
+    }
+    for (u8 i = 0; i < HOST_ALLOCATOR_CLASS_COUNT; ++i) {
+        if (!allocator->pools[i].block) {
+            continue;
+        }
+        void* memory;
+        while (mpmc_queue_try_pop(&allocator->pools[i], &memory)) {
+            kfree_aligned(memory, class_size(i), HOST_BLOCK_BASE_ALIGNMENT, allocator->tag);
+        }
+        mpmc_queue_destroy(&allocator->pools[i]);
+    }
+    for (u8 i = 0; i < allocator->arena_count; ++i) {
+        if (allocator->arenas[i].outstanding) {
+            KWARN("host_allocator_destroy - %u transient allocations of arena %u were never freed.", allocator->arenas[i].outstanding, i);
+        }
+        kfree_aligned(allocator->arenas[i].memory, allocator->arena_size, HOST_BLOCK_BASE_ALIGNMENT, allocator->tag);
+    }
+    kzero_memory(allocator, sizeof(host_allocator));
+}
+
+void host_allocator_frame_begin(host_allocator* allocator) {
+    if (!allocator || allocator->arena_count == 0) {
+        return;
+    }
+
+    // The next arena is only emptied if nothing taken from it is still in use. A thread which read
+    // it as current long ago backs off if it sees it is not current once counted as outstanding, so
+    // nothing is taken from it between the check and it becoming current.
+    u8 next = (allocator->current_arena + 1) % allocator->arena_count;
+    host_allocator_arena* arena = &allocator->arenas[next];
+    if (katomic_load(&arena->outstanding) == 0) {
+        katomic_store(&arena->offset, 0);
+    }
+    katomic_store(&allocator->current_arena, next);
+}
+
+// Takes a transient block from the current arena, or 0 if it is full.
+static void* arena_allocate(host_allocator* allocator, u64 size, u16 alignment) {
+    u8 index = katomic_load(&allocator->current_arena);
+    host_allocator_arena* arena = &allocator->arenas[index];
+    katomic_fetch_add(&arena->outstanding, 1);
+    if (katomic_load(&allocator->current_arena) != index) {
+        // Moved on to another arena meanwhile, which may have emptied this one unseen.
+        katomic_fetch_sub(&arena->outstanding, 1);
+        return 0;
+    }
+
+    u64 footprint = (block_footprint(size, alignment) + HOST_BLOCK_BASE_ALIGNMENT - 1) & ~(u64)(HOST_BLOCK_BASE_ALIGNMENT - 1);
+    u64 offset = katomic_fetch_add(&arena->offset, footprint);
+    if (offset + footprint > allocator->arena_size) {
+        katomic_fetch_sub(&arena->outstanding, 1);
+        return 0;
+    }
+    return block_place(arena->memory + offset, size, alignment, HOST_BLOCK_SOURCE_ARENA, index);
+}
+
+void* host_allocator_allocate(host_allocator* allocator, u64 size, u16 alignment, b8 transient) {
+    // Null MUST be returned for these.
+    if (!allocator || size == 0) {
+        return 0;
+    }
+    alignment = KMAX(alignment, 1);
+
+    if (transient && allocator->arena_count) {
+        void* block = arena_allocate(allocator, size, alignment);
+        if (block) {
+            return block;
+        }
+    }
+
+    u64 footprint = block_footprint(size, alignment);
+    u8 size_class = class_get(footprint);
+    u8* memory = 0;
+    if (size_class == HOST_BLOCK_SOURCE_HEAP) {
+        katomic_fetch_add_relaxed(&allocator->heap_allocation_count, 1);
+        memory = kallocate_aligned(footprint, HOST_BLOCK_BASE_ALIGNMENT, allocator->tag);
+    } else if (!mpmc_queue_try_pop(&allocator->pools[size_class], &memory)) {
+        katomic_fetch_add_relaxed(&allocator->heap_allocation_count, 1);
+        memory = kallocate_aligned(class_size(size_class), HOST_BLOCK_BASE_ALIGNMENT, allocator->tag);
+    }
+    if (!memory) {
+        return 0;
+    }
+    return block_place(memory, size, alignment, size_class, 0);
+}
+
+void host_allocator_free(host_allocator* allocator, void* block) {
+    if (!allocator || !block) {
+        return;
+    }
+
+    host_block_header* header = header_get(block);
+    u8* memory = (u8*)block - header->offset;
+    if (header->source == HOST_BLOCK_SOURCE_ARENA) {
+        // Arena memory is only reclaimed along with the whole arena.
+        katomic_fetch_sub(&allocator->arenas[header->arena].outstanding, 1);
+    } else if (header->source == HOST_BLOCK_SOURCE_HEAP) {
+        kfree_aligned(memory, block_footprint(header->size, header->alignment), HOST_BLOCK_BASE_ALIGNMENT, allocator->tag);
+    } else if (!mpmc_queue_try_push(&allocator->pools[header->source], &memory)) {
+        // The pool is full, so the heap takes it back.
+        kfree_aligned(memory, class_size(header->source), HOST_BLOCK_BASE_ALIGNMENT, allocator->tag);
+    }
+}
+
+void* host_allocator_reallocate(host_allocator* allocator, void* block, u64 size, u16 alignment, b8 transient) {
+    if (!block) {
+        return host_allocator_allocate(allocator, size, alignment, transient);
+    }
+    if (size == 0) {
+        host_allocator_free(allocator, block);
+        return 0;
+    }
+
+    host_block_header* header = header_get(block);
+    alignment = KMAX(alignment, 1);
+    if (alignment != header->alignment) {
+        KERROR("host_allocator_reallocate - Attempted to reallocate with an alignment of %u instead of the original %u.", alignment, header->alignment);
+        return 0;
+    }
+
+    // A pooled block which still holds the new size is kept.
+    if (header->source < HOST_ALLOCATOR_CLASS_COUNT && block_footprint(size, alignment) <= class_size(header->source)) {
+        header->size = size;
+        return block;
+    }
+
+    void* result = host_allocator_allocate(allocator, size, alignment, transient);
+    if (result) {
+        kcopy_memory(result, block, KMIN(size, header->size));
+        // Free the original memory only if the new allocation was successful.
+        host_allocator_free(allocator, block);
+    }
+    return result;
+}
+
+u64 host_allocator_block_size(const void* block) {
+    return block ? header_get(block)->size : 0;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file host_allocator.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief An allocator for the host memory a graphics driver asks for through its allocation
+ * callbacks, kept apart from the engine's heap so driver allocations do not contend with it.
+ * @details Driver allocations come from any thread the driver is called on, and are many, small
+ * and short-lived, so they are served without a lock:
+ * - Transient allocations, those which live no longer than the driver call which makes them, are
+ *   bumped from a per-frame arena. An arena is emptied once every allocation taken from it has
+ *   been freed and it comes around again, a frame or more later.
+ * - Other allocations come from pools of blocks, one pool per power-of-two size class, each a
+ *   lock-free queue of freed blocks. A pool which runs dry takes a block from the heap, and one
+ *   which is full hands a freed block back to it, so the heap is only reached while warming up.
+ * - Those too large for any pool go to the heap.
+ * Every allocation remembers its size and alignment, so reallocating and freeing need no lookup.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "containers/mpmc_queue.h"
+#include "core/kmemory.h"
+
+/** @brief The number of pooled size classes, from 64 bytes up to 64 KiB. */
+#define HOST_ALLOCATOR_CLASS_COUNT 11
+
+/** @brief The most freed blocks each pool keeps. */
+#define HOST_ALLOCATOR_POOL_CAPACITY 256
+
+/** @brief The maximum number of transient arenas the allocator can rotate between. */
+#define HOST_ALLOCATOR_MAX_ARENA_COUNT 3
+
+/** @brief A transient arena, bumped from by any thread. */
+typedef struct host_allocator_arena {
+    /** @brief The arena's memory. */
+    u8* memory;
+    /** @brief The offset of the next allocation. Past the size once full. */
+    u64 offset;
+    /** @brief The number of allocations taken from the arena which are not yet freed. */
+    u32 outstanding;
+} host_allocator_arena;
+
+/** @brief The host allocator structure. */
+typedef struct host_allocator {
+    /** @brief The tag heap allocations are made with. */
+    memory_tag tag;
+    /** @brief A queue of freed blocks for each size class. */
+    mpmc_queue pools[HOST_ALLOCATOR_CLASS_COUNT];
+    /** @brief The size of each transient arena, or 0 if transient allocations are pooled too. */
+    u64 arena_size;
+    /** @brief The number of transient arenas. */
+    u8 arena_count;
+    /** @brief The index of the arena transient allocations are taken from this frame. */
+    u8 current_arena;
+    /** @brief The transient arenas. */
+    host_allocator_arena arenas[HOST_ALLOCATOR_MAX_ARENA_COUNT];
+    /** @brief The number of allocations served by the heap instead of an arena or pool. */
+    u64 heap_allocation_count;
+} host_allocator;
+
+/**
+ * @brief Creates a host allocator.
+ *
+ * @param arena_size The size in bytes of each transient arena, or 0 to pool transient allocations too.
+ * @param arena_count The number of transient arenas, between 2 and HOST_ALLOCATOR_MAX_ARENA_COUNT if
+ * arena_size is not 0, so one may be emptied while another is in use.
+ * @param tag The tag heap allocations are made with.
+ * @param out_allocator A pointer to hold the allocator.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 host_allocator_create(u64 arena_size, u8 arena_count, memory_tag tag, host_allocator* out_allocator);
+
+/**
+ * @brief Destroys the given allocator, handing every pooled block back to the heap. Every
+ * allocation must have been freed.
+ *
+ * @param allocator A pointer to the allocator.
+ */
+KAPI void host_allocator_destroy(host_allocator* allocator);
+
+/**
+ * @brief Moves transient allocations on to the next arena, emptying it first if nothing taken from
+ * it is still in use. Should be called once at the start of each frame. Not thread-safe with itself.
+ *
+ * @param allocator A pointer to the allocator.
+ */
+KAPI void host_allocator_frame_begin(host_allocator* allocator);
+
+/**
+ * @brief Allocates a block. Thread-safe.
+ *
+ * @param allocator A pointer to the allocator.
+ * @param size The size of the block in bytes.
+ * @param alignment The alignment of the block. Must be a power of two.
+ * @param transient Indicates if the block is freed before the end of the driver call it is allocated for.
+ * @return The block, or 0 if size was 0 or the allocation failed.
+ */
+KAPI void* host_allocator_allocate(host_allocator* allocator, u64 size, u16 alignment, b8 transient);
+
+/**
+ * @brief Resizes a block, in place if it fits, or otherwise by moving it to a new one. Thread-safe.
+ *
+ * @param allocator A pointer to the allocator.
+ * @param block The block to resize, or 0 to allocate a new one.
+ * @param size The new size of the block in bytes. If 0, the block is freed.
+ * @param alignment The alignment of the block, which must be the one it was allocated with.
+ * @param transient Indicates if a new block, should one be needed, is transient.
+ * @return The resized block, or 0 if size was 0 or the allocation failed, leaving the block as it was.
+ */
+KAPI void* host_allocator_reallocate(host_allocator* allocator, void* block, u64 size, u16 alignment, b8 transient);
+
+/**
+ * @brief Frees a block. Thread-safe.
+ *
+ * @param allocator A pointer to the allocator.
+ * @param block The block to free. May be 0.
+ */
+KAPI void host_allocator_free(host_allocator* allocator, void* block);
+
+/**
+ * @brief Obtains the size a block was allocated or last resized with.
+ *
+ * @param block The block.
+ * @return The size in bytes.
+ */
+KAPI u64 host_allocator_block_size(const void* block);
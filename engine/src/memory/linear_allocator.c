@@ -2,12 +2,15 @@
 
 #include "core/kmemory.h"
 #include "core/logger.h"
+#include "platform/platform.h"
 
 void linear_allocator_create(u64 total_size, void* memory, linear_allocator* out_allocator) {
     if (out_allocator) {
         out_allocator->total_size = total_size;
         out_allocator->allocated = 0;
         out_allocator->owns_memory = memory == 0;
+        out_allocator->reserved = false;
+        out_allocator->committed = total_size;
         if (memory) {
             out_allocator->memory = memory;
         } else {
@@ -15,15 +18,40 @@ void linear_allocator_create(u64 total_size, void* memory, linear_allocator* out
         }
     }
 }
+
+b8 linear_allocator_create_reserved(u64 total_size, linear_allocator* out_allocator) {
+    if (!out_allocator || total_size == 0) {
+        KERROR("linear_allocator_create_reserved requires a nonzero total_size and a valid pointer to hold the allocator.");
+        return false;
+    }
+    total_size = get_aligned(total_size, LINEAR_ALLOCATOR_COMMIT_GRANULARITY);
+    void* memory = platform_reserve_memory(total_size);
+    if (!memory) {
+        KERROR("linear_allocator_create_reserved - failed to reserve %llu bytes.", total_size);
+        return false;
+    }
+    out_allocator->total_size = total_size;
+    out_allocator->allocated = 0;
+    out_allocator->memory = memory;
+    out_allocator->owns_memory = true;
+    out_allocator->reserved = true;
+    out_allocator->committed = 0;
+    return true;
+}
+
 void linear_allocator_destroy(linear_allocator* allocator) {
     if (allocator) {
         allocator->allocated = 0;
-        if (allocator->owns_memory && allocator->memory) {
+        if (allocator->reserved) {
+            platform_release_memory(allocator->memory, allocator->total_size);
+        } else if (allocator->owns_memory && allocator->memory) {
             kfree(allocator->memory, allocator->total_size, MEMORY_TAG_LINEAR_ALLOCATOR);
-        } 
+        }
         allocator->memory = 0;
         allocator->total_size = 0;
+        allocator->committed = 0;
         allocator->owns_memory = false;
+        allocator->reserved = false;
     }
 }
 
@@ -35,6 +63,16 @@ void* linear_allocator_allocate(linear_allocator* allocator, u64 size) {
             return 0;
         }
 
+        if (allocator->allocated + size > allocator->committed) {
+            // Commit enough of the reserved range to cover the allocation.
+            u64 new_committed = get_aligned(allocator->allocated + size, LINEAR_ALLOCATOR_COMMIT_GRANULARITY);
+            if (!platform_commit_memory((u8*)allocator->memory + allocator->committed, new_committed - allocator->committed)) {
+                KERROR("linear_allocator_allocate - Failed to commit memory for an allocation of %lluB.", size);
+                return 0;
+            }
+            allocator->committed = new_committed;
+        }
+
         void* block = ((u8*)allocator->memory) + allocator->allocated;
         allocator->allocated += size;
         return block;
@@ -44,9 +82,45 @@ void* linear_allocator_allocate(linear_allocator* allocator, u64 size) {
     return 0;
 }
 
+b8 linear_allocator_extend(linear_allocator* allocator, void* block, u64 size, u64 new_size) {
+    if (!allocator || !allocator->memory || new_size < size) {
+        return false;
+    }
+    // Only the last allocation ends at the current position.
+    u8* end = (u8*)allocator->memory + allocator->allocated;
+    if ((u8*)block + size != end || allocator->allocated - size + new_size > allocator->total_size) {
+        return false;
+    }
+    if (allocator->allocated - size + new_size > allocator->committed) {
+        u64 new_committed = get_aligned(allocator->allocated - size + new_size, LINEAR_ALLOCATOR_COMMIT_GRANULARITY);
+        if (!platform_commit_memory((u8*)allocator->memory + allocator->committed, new_committed - allocator->committed)) {
+            return false;
+        }
+        allocator->committed = new_committed;
+    }
+    allocator->allocated += new_size - size;
+    return true;
+}
+
+linear_allocator_marker linear_allocator_get_marker(linear_allocator* allocator) {
+    return allocator ? allocator->allocated : 0;
+}
+
+void linear_allocator_free_to_marker(linear_allocator* allocator, linear_allocator_marker marker) {
+    if (allocator && allocator->memory && marker <= allocator->allocated) {
+        kzero_memory((u8*)allocator->memory + marker, allocator->allocated - marker);
+        allocator->allocated = marker;
+    }
+}
+
 void linear_allocator_free_all(linear_allocator* allocator) {
     if (allocator && allocator->memory) {
+        if (allocator->reserved) {
+            // Only memory that has been handed out can be dirty; the rest is zero from being committed.
+            kzero_memory(allocator->memory, allocator->allocated);
+        } else {
+            kzero_memory(allocator->memory, allocator->total_size);
+        }
         allocator->allocated = 0;
-        kzero_memory(allocator->memory, allocator->total_size);
     }
 }
\ No newline at end of file
@@ -8,6 +8,14 @@
  * not stored, and thus allocations made in this way are not individually freeable.
  * Only the entire thing can be freed. This comes with the benefit of speed at a cost
  * of flexibility.
+ *
+ * A linear allocator can also be created over a reserved range of virtual memory, in which
+ * case it commits pages as they are needed. This allows it to be sized for the worst case
+ * without paying for the physical memory up front, while never moving what it has handed out.
+ *
+ * Markers allow a linear allocator to be used as a stack. Taking a marker, allocating and then
+ * freeing back to the marker releases everything allocated in between, which suits nested
+ * temporary work such as the intermediate data of a resource import.
  * @version 1.0
  *
  * 
@@ -34,8 +42,21 @@ typedef struct linear_allocator {
      * performed the allocation itself) or whether it was provided by an outside source.
      */
     b8 owns_memory;
+    /**
+     * @brief Indicates if the memory is a reserved range of virtual memory, committed on
+     * demand, instead of a single up-front allocation.
+     */
+    b8 reserved;
+    /** @brief The amount of a reserved range that has been committed. Equal to total_size otherwise. */
+    u64 committed;
 } linear_allocator;
 
+/** @brief A position within a linear allocator, used to free everything allocated after it. */
+typedef u64 linear_allocator_marker;
+
+/** @brief The granularity in bytes at which a reserved linear allocator commits memory. */
+#define LINEAR_ALLOCATOR_COMMIT_GRANULARITY KIBIBYTES(64)
+
 /**
  * @brief Creates a linear allocator of the given size.
  * 
@@ -46,6 +67,17 @@ typedef struct linear_allocator {
  */
 KAPI void linear_allocator_create(u64 total_size, void* memory, linear_allocator* out_allocator);
 
+/**
+ * @brief Creates a linear allocator over a reserved range of virtual memory of the given size.
+ * Memory is committed as allocations reach it, and allocations never move. The allocator always
+ * owns this memory.
+ *
+ * @param total_size The total amount in bytes the allocator may grow to. Rounded up to LINEAR_ALLOCATOR_COMMIT_GRANULARITY.
+ * @param out_allocator A pointer to hold the new allocator.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 linear_allocator_create_reserved(u64 total_size, linear_allocator* out_allocator);
+
 /**
  * @brief Destroys the given allocator. If the allocator owns its memory, it is freed at this time.
  * 
@@ -62,6 +94,35 @@ KAPI void linear_allocator_destroy(linear_allocator* allocator);
  */
 KAPI void* linear_allocator_allocate(linear_allocator* allocator, u64 size);
 
+/**
+ * @brief Attempts to grow a block in place. This is only possible for the most recent allocation,
+ * and if there is enough space left. Unlike allocation, failure is not an error.
+ *
+ * @param allocator A pointer to the allocator the block came from.
+ * @param block The block to be grown.
+ * @param size The current size of the block.
+ * @param new_size The size to grow the block to.
+ * @return True if the block was grown; otherwise false.
+ */
+KAPI b8 linear_allocator_extend(linear_allocator* allocator, void* block, u64 size, u64 new_size);
+
+/**
+ * @brief Obtains a marker for the current position of the allocator.
+ *
+ * @param allocator A pointer to the allocator.
+ * @return A marker which can be passed to linear_allocator_free_to_marker.
+ */
+KAPI linear_allocator_marker linear_allocator_get_marker(linear_allocator* allocator);
+
+/**
+ * @brief Frees everything allocated since the given marker was obtained, zeroing it. Markers must
+ * be freed to in the reverse order they were obtained in, and none obtained since are valid afterward.
+ *
+ * @param allocator A pointer to the allocator.
+ * @param marker A marker obtained from linear_allocator_get_marker.
+ */
+KAPI void linear_allocator_free_to_marker(linear_allocator* allocator, linear_allocator_marker marker);
+
 /**
  * @brief Frees everything in the allocator, effectively moving its pointer back to the beginning.
  * Does not free internal memory, if owned. Only resets the pointer.
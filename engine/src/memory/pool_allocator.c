@@ -0,0 +1,108 @@
+#include "pool_allocator.h"
+
+#include "core/logger.h"
+
+static u64 pool_block_size(u64 block_size, u16 alignment) {
+    // Each free block holds a pointer to the next one, so must be large enough to do so.
+    return get_aligned(KMAX(block_size, sizeof(void*)), alignment);
+}
+
+b8 pool_allocator_create(u64 block_size, u16 alignment, u32 block_count, u64* memory_requirement, void* memory, pool_allocator* out_allocator) {
+    if (block_size == 0 || block_count == 0) {
+        KERROR("pool_allocator_create requires a non-zero block_size and block_count. Create failed.");
+        return false;
+    }
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        KERROR("pool_allocator_create requires the alignment to be a power of 2. Create failed.");
+        return false;
+    }
+    if (!memory_requirement) {
+        KERROR("pool_allocator_create requires memory_requirement to exist. Create failed.");
+        return false;
+    }
+
+    u64 aligned_block_size = pool_block_size(block_size, alignment);
+    // Leave room to align the first block, as the memory provided may not be aligned.
+    *memory_requirement = aligned_block_size * block_count + alignment - 1;
+
+    // If only obtaining requirement, boot out.
+    if (!memory) {
+        return true;
+    }
+    if (!out_allocator) {
+        KERROR("pool_allocator_create requires a pointer to hold the allocator. Create failed.");
+        return false;
+    }
+
+    out_allocator->block_size = aligned_block_size;
+    out_allocator->block_count = block_count;
+    out_allocator->blocks = (void*)get_aligned((u64)memory, alignment);
+    pool_allocator_free_all(out_allocator);
+    return true;
+}
+
+void pool_allocator_destroy(pool_allocator* allocator) {
+    if (allocator) {
+        allocator->block_size = 0;
+        allocator->block_count = 0;
+        allocator->free_count = 0;
+        allocator->used_count = 0;
+        allocator->blocks = 0;
+        allocator->free_head = 0;
+    }
+}
+
+void* pool_allocator_allocate(pool_allocator* allocator) {
+    if (!allocator || !allocator->blocks) {
+        KERROR("pool_allocator_allocate - provided allocator not initialized.");
+        return 0;
+    }
+
+    void* block = 0;
+    if (allocator->free_head) {
+        // Reuse the most recently freed block.
+        block = allocator->free_head;
+        allocator->free_head = *(void**)block;
+    } else if (allocator->used_count < allocator->block_count) {
+        // Blocks are handed out in order the first time around, so the free list never
+        // has to be built up front.
+        block = (u8*)allocator->blocks + allocator->block_size * allocator->used_count;
+        allocator->used_count++;
+    } else {
+        KERROR("pool_allocator_allocate - pool of %u blocks is exhausted.", allocator->block_count);
+        return 0;
+    }
+
+    allocator->free_count--;
+    return block;
+}
+
+b8 pool_allocator_free(pool_allocator* allocator, void* block) {
+    if (!allocator || !allocator->blocks || !block) {
+        KERROR("pool_allocator_free requires both a valid allocator (0x%p) and a block (0x%p) to be freed.", allocator, block);
+        return false;
+    }
+
+    u64 offset = (u64)block - (u64)allocator->blocks;
+    if ((u8*)block < (u8*)allocator->blocks || offset >= allocator->block_size * allocator->used_count || offset % allocator->block_size != 0) {
+        KERROR("pool_allocator_free - block (0x%p) was not allocated from this pool.", block);
+        return false;
+    }
+
+    *(void**)block = allocator->free_head;
+    allocator->free_head = block;
+    allocator->free_count++;
+    return true;
+}
+
+void pool_allocator_free_all(pool_allocator* allocator) {
+    if (allocator) {
+        allocator->free_count = allocator->block_count;
+        allocator->used_count = 0;
+        allocator->free_head = 0;
+    }
+}
+
+u32 pool_allocator_free_count(pool_allocator* allocator) {
+    return allocator ? allocator->free_count : 0;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file pool_allocator.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Contains the implementation of the pool allocator.
+ * @details A pool allocator hands out blocks of a single, fixed size from its internal block
+ * of memory. Free blocks are kept in a list threaded through the blocks themselves, so both
+ * allocating and freeing a block are O(1), and the pool never fragments. Well suited to
+ * objects which are created and destroyed often. Not thread-safe.
+ * @version 1.0
+ *
+ * 
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ * 
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief The pool allocator structure. */
+typedef struct pool_allocator {
+    /** @brief The size of each block in bytes, rounded up to the alignment. */
+    u64 block_size;
+    /** @brief The total number of blocks in the pool. */
+    u32 block_count;
+    /** @brief The number of blocks currently free. */
+    u32 free_count;
+    /** @brief The number of blocks from the start of the pool which have been handed out at least once. */
+    u32 used_count;
+    /** @brief The first block of the pool, aligned to the requested alignment. */
+    void* blocks;
+    /** @brief The most recently freed block, which is the next to be handed out. */
+    void* free_head;
+} pool_allocator;
+
+/**
+ * @brief Creates a new pool allocator. Should be called twice; once to obtain the memory
+ * amount required (passing memory=0), and a second time with memory being set to an allocated block.
+ *
+ * @param block_size The size in bytes of each block. Rounded up to at least the size of a pointer and to the alignment.
+ * @param alignment The alignment of each block in bytes. Must be a power of 2.
+ * @param block_count The total number of blocks the pool should hold.
+ * @param memory_requirement A pointer to hold the required memory for the blocks, including space for alignment.
+ * @param memory An allocated block of memory, or 0 if just obtaining the requirement.
+ * @param out_allocator A pointer to hold the allocator.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 pool_allocator_create(u64 block_size, u16 alignment, u32 block_count, u64* memory_requirement, void* memory, pool_allocator* out_allocator);
+
+/**
+ * @brief Destroys the given allocator. The memory passed at creation is not freed.
+ *
+ * @param allocator A pointer to the allocator to be destroyed.
+ */
+KAPI void pool_allocator_destroy(pool_allocator* allocator);
+
+/**
+ * @brief Allocates a block from the provided allocator.
+ *
+ * @param allocator A pointer to the allocator to allocate from.
+ * @return The allocated block of memory, or 0 if the pool is exhausted.
+ */
+KAPI void* pool_allocator_allocate(pool_allocator* allocator);
+
+/**
+ * @brief Frees the given block, making it available to be allocated again.
+ *
+ * @param allocator A pointer to the allocator to free from.
+ * @param block The block to be freed. Must have been allocated by the provided allocator.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 pool_allocator_free(pool_allocator* allocator, void* block);
+
+/**
+ * @brief Frees every block in the allocator at once.
+ *
+ * @param allocator A pointer to the allocator to free.
+ */
+KAPI void pool_allocator_free_all(pool_allocator* allocator);
+
+/**
+ * @brief Obtains the number of blocks available to be allocated from the provided allocator.
+ *
+ * @param allocator A pointer to the allocator to be examined.
+ * @return The number of free blocks.
+ */
+KAPI u32 pool_allocator_free_count(pool_allocator* allocator);
@@ -0,0 +1,24 @@
+#include "scratch_allocator.h"
+
+#include "core/logger.h"
+
+static _Thread_local linear_allocator thread_scratch;
+
+linear_allocator* scratch_allocator_get() {
+    if (!thread_scratch.memory) {
+        if (!linear_allocator_create_reserved(SCRATCH_ALLOCATOR_RESERVE_SIZE, &thread_scratch)) {
+            KERROR("scratch_allocator_get - failed to create the scratch allocator for this thread.");
+            return 0;
+        }
+    }
+    return &thread_scratch;
+}
+
+void scratch_allocator_release() {
+    if (thread_scratch.memory) {
+        if (thread_scratch.allocated) {
+            KWARN("scratch_allocator_release - %llu bytes were not freed back to a marker.", thread_scratch.allocated);
+        }
+        linear_allocator_destroy(&thread_scratch);
+    }
+}
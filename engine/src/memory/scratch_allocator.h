@@ -0,0 +1,37 @@
+/**
+ * @file scratch_allocator.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Contains per-thread scratch allocators for temporary work.
+ * @details Each thread gets its own linear allocator over a large reserved range of virtual
+ * memory, which is only committed as it is used. It is meant to be used as a stack: take a
+ * marker, allocate temporary data (such as darrays via darray_create_with_allocator) and free
+ * back to the marker when done. This releases all of it at once without touching or
+ * fragmenting the global heap, and since each thread has its own, no locking is needed.
+ * @version 1.0
+ *
+ * 
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ * 
+ */
+
+#pragma once
+
+#include "memory/linear_allocator.h"
+
+/** @brief The size in bytes of address space reserved for each thread's scratch allocator. */
+#define SCRATCH_ALLOCATOR_RESERVE_SIZE GIBIBYTES(1)
+
+/**
+ * @brief Obtains the calling thread's scratch allocator, creating it on first use.
+ * Anything allocated from it must be freed back to a marker before the calling scope returns.
+ *
+ * @return A pointer to the scratch allocator, or 0 if it could not be created. Since darrays
+ * given an allocator of 0 are placed on the heap, this may be passed on without checking.
+ */
+KAPI linear_allocator* scratch_allocator_get();
+
+/**
+ * @brief Releases the calling thread's scratch allocator, if it has one. Should be called
+ * by threads which used it before they exit.
+ */
+KAPI void scratch_allocator_release();
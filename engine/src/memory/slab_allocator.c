@@ -0,0 +1,239 @@
+#include "slab_allocator.h"
+
+#include "core/logger.h"
+
+// Marks a slab which is not assigned to a size class.
+#define SLAB_CLASS_NONE INVALID_ID_U16
+
+typedef struct slab_record {
+    // The most recently freed block in the slab.
+    void* free_head;
+    // Links for the partial list of the slab's class, or the free slab list.
+    u32 prev;
+    u32 next;
+    u16 class_index;
+    // The number of blocks the slab holds for its class.
+    u16 capacity;
+    // The number of blocks currently free.
+    u16 free_count;
+    // The number of blocks carved from the start of the slab so far.
+    u16 carved_count;
+} slab_record;
+
+typedef struct slab_allocator_state {
+    u32 slab_count;
+    u32 free_slab_count;
+    // The first slab with free blocks for each size class.
+    u32 partial_heads[SLAB_ALLOCATOR_CLASS_COUNT];
+    // The first slab not assigned to a size class.
+    u32 free_slab_head;
+    slab_record* records;
+    u8* slabs;
+} slab_allocator_state;
+
+static u64 class_block_size(u16 class_index) {
+    return (u64)SLAB_ALLOCATOR_MIN_BLOCK_SIZE << class_index;
+}
+
+static u16 class_for_size(u64 size) {
+    u16 class_index = 0;
+    while (class_block_size(class_index) < size) {
+        class_index++;
+    }
+    return class_index;
+}
+
+static void list_push(slab_allocator_state* state, u32* head, u32 index) {
+    slab_record* record = &state->records[index];
+    record->prev = INVALID_ID;
+    record->next = *head;
+    if (*head != INVALID_ID) {
+        state->records[*head].prev = index;
+    }
+    *head = index;
+}
+
+static void list_remove(slab_allocator_state* state, u32* head, u32 index) {
+    slab_record* record = &state->records[index];
+    if (record->prev != INVALID_ID) {
+        state->records[record->prev].next = record->next;
+    } else {
+        *head = record->next;
+    }
+    if (record->next != INVALID_ID) {
+        state->records[record->next].prev = record->prev;
+    }
+    record->prev = INVALID_ID;
+    record->next = INVALID_ID;
+}
+
+b8 slab_allocator_create(u64 total_size, u64* memory_requirement, void* memory, slab_allocator* out_allocator) {
+    if (total_size < 1) {
+        KERROR("slab_allocator_create cannot have a total_size of 0. Create failed.");
+        return false;
+    }
+    if (!memory_requirement) {
+        KERROR("slab_allocator_create requires memory_requirement to exist. Create failed.");
+        return false;
+    }
+
+    u64 slab_count = (total_size + SLAB_ALLOCATOR_SLAB_SIZE - 1) / SLAB_ALLOCATOR_SLAB_SIZE;
+    if (slab_count >= INVALID_ID) {
+        KERROR("slab_allocator_create - total_size of %llu requires too many slabs. Create failed.", total_size);
+        return false;
+    }
+
+    // Memory layout:
+    // state
+    // slab records
+    // padding to align the slabs
+    // slabs
+    u64 header_size = sizeof(slab_allocator_state) + sizeof(slab_record) * slab_count;
+    *memory_requirement = header_size + SLAB_ALLOCATOR_MIN_BLOCK_SIZE - 1 + SLAB_ALLOCATOR_SLAB_SIZE * slab_count;
+
+    // If only obtaining requirement, boot out.
+    if (!memory) {
+        return true;
+    }
+
+    out_allocator->memory = memory;
+    slab_allocator_state* state = out_allocator->memory;
+    state->slab_count = (u32)slab_count;
+    state->records = (slab_record*)((u8*)memory + sizeof(slab_allocator_state));
+    state->slabs = (u8*)get_aligned((u64)memory + header_size, SLAB_ALLOCATOR_MIN_BLOCK_SIZE);
+    for (u32 i = 0; i < SLAB_ALLOCATOR_CLASS_COUNT; ++i) {
+        state->partial_heads[i] = INVALID_ID;
+    }
+
+    // Every slab starts out free. Push in reverse so the lowest slabs are used first.
+    state->free_slab_head = INVALID_ID;
+    state->free_slab_count = state->slab_count;
+    for (u32 i = state->slab_count; i > 0; --i) {
+        slab_record* record = &state->records[i - 1];
+        record->free_head = 0;
+        record->class_index = SLAB_CLASS_NONE;
+        record->capacity = 0;
+        record->free_count = 0;
+        record->carved_count = 0;
+        list_push(state, &state->free_slab_head, i - 1);
+    }
+    return true;
+}
+
+b8 slab_allocator_destroy(slab_allocator* allocator) {
+    if (allocator) {
+        allocator->memory = 0;
+        return true;
+    }
+
+    KWARN("slab_allocator_destroy requires a pointer to an allocator. Destroy failed.");
+    return false;
+}
+
+void* slab_allocator_allocate(slab_allocator* allocator, u64 size) {
+    if (!allocator || !allocator->memory || size == 0) {
+        KERROR("slab_allocator_allocate requires a valid allocator and size.");
+        return 0;
+    }
+    if (size > SLAB_ALLOCATOR_MAX_BLOCK_SIZE) {
+        KERROR("slab_allocator_allocate - size of %llu exceeds the largest size class of %u bytes.", size, SLAB_ALLOCATOR_MAX_BLOCK_SIZE);
+        return 0;
+    }
+
+    slab_allocator_state* state = allocator->memory;
+    u16 class_index = class_for_size(size);
+    u64 block_size = class_block_size(class_index);
+
+    u32 slab_index = state->partial_heads[class_index];
+    if (slab_index == INVALID_ID) {
+        // No slab of this class has room, so assign a free one to it.
+        slab_index = state->free_slab_head;
+        if (slab_index == INVALID_ID) {
+            KERROR("slab_allocator_allocate - no slabs left to serve an allocation of %llu bytes.", size);
+            return 0;
+        }
+        list_remove(state, &state->free_slab_head, slab_index);
+        state->free_slab_count--;
+
+        slab_record* record = &state->records[slab_index];
+        record->class_index = class_index;
+        record->capacity = (u16)(SLAB_ALLOCATOR_SLAB_SIZE / block_size);
+        record->free_count = record->capacity;
+        record->carved_count = 0;
+        record->free_head = 0;
+        list_push(state, &state->partial_heads[class_index], slab_index);
+    }
+
+    slab_record* record = &state->records[slab_index];
+    void* block = 0;
+    if (record->free_head) {
+        block = record->free_head;
+        record->free_head = *(void**)block;
+    } else {
+        // Blocks are carved from the slab in order the first time around.
+        block = state->slabs + SLAB_ALLOCATOR_SLAB_SIZE * slab_index + block_size * record->carved_count;
+        record->carved_count++;
+    }
+
+    record->free_count--;
+    if (record->free_count == 0) {
+        // Full slabs are taken off the partial list until a block is freed.
+        list_remove(state, &state->partial_heads[class_index], slab_index);
+    }
+    return block;
+}
+
+b8 slab_allocator_free(slab_allocator* allocator, void* block) {
+    if (!allocator || !allocator->memory || !block) {
+        KERROR("slab_allocator_free requires both a valid allocator (0x%p) and a block (0x%p) to be freed.", allocator, block);
+        return false;
+    }
+
+    slab_allocator_state* state = allocator->memory;
+    u8* slab_start = state->slabs;
+    u8* slab_end = slab_start + SLAB_ALLOCATOR_SLAB_SIZE * state->slab_count;
+    if ((u8*)block < slab_start || (u8*)block >= slab_end) {
+        KERROR("slab_allocator_free - block (0x%p) was not allocated from this allocator.", block);
+        return false;
+    }
+
+    u64 offset = (u8*)block - slab_start;
+    u32 slab_index = (u32)(offset / SLAB_ALLOCATOR_SLAB_SIZE);
+    u64 slab_offset = offset % SLAB_ALLOCATOR_SLAB_SIZE;
+    slab_record* record = &state->records[slab_index];
+    if (record->class_index == SLAB_CLASS_NONE) {
+        KERROR("slab_allocator_free - block (0x%p) belongs to a slab which is not in use.", block);
+        return false;
+    }
+    u64 block_size = class_block_size(record->class_index);
+    if (slab_offset % block_size != 0 || slab_offset / block_size >= record->carved_count) {
+        KERROR("slab_allocator_free - block (0x%p) is not the start of an allocated block.", block);
+        return false;
+    }
+
+    *(void**)block = record->free_head;
+    record->free_head = block;
+    if (record->free_count == 0) {
+        // The slab was full, so it has room again.
+        list_push(state, &state->partial_heads[record->class_index], slab_index);
+    }
+    record->free_count++;
+
+    if (record->free_count == record->capacity) {
+        // The slab is empty, so hand it back for use by any size class.
+        list_remove(state, &state->partial_heads[record->class_index], slab_index);
+        record->class_index = SLAB_CLASS_NONE;
+        record->free_head = 0;
+        record->carved_count = 0;
+        list_push(state, &state->free_slab_head, slab_index);
+        state->free_slab_count++;
+    }
+    return true;
+}
+
+u32 slab_allocator_free_slab_count(slab_allocator* allocator) {
+    if (!allocator || !allocator->memory) {
+        return 0;
+    }
+    return ((slab_allocator_state*)allocator->memory)->free_slab_count;
+}
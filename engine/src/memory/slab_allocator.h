@@ -0,0 +1,84 @@
+/**
+ * @file slab_allocator.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Contains the implementation of the slab allocator.
+ * @details A slab allocator divides its internal block of memory into fixed-size slabs,
+ * each of which is carved into blocks of a single size class when first needed. Requests
+ * are rounded up to the nearest size class, so allocating and freeing are O(1) and small
+ * allocations never fragment the rest of the memory. Slabs which become empty are returned
+ * for use by any size class. Not thread-safe.
+ * @version 1.0
+ *
+ * 
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ * 
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief The size in bytes of a single slab. */
+#define SLAB_ALLOCATOR_SLAB_SIZE KIBIBYTES(64)
+
+/** @brief The smallest size class, in bytes. Size classes double from here. */
+#define SLAB_ALLOCATOR_MIN_BLOCK_SIZE 16
+
+/** @brief The number of size classes. */
+#define SLAB_ALLOCATOR_CLASS_COUNT 8
+
+/** @brief The largest allocation, in bytes, which can be served by a slab allocator. */
+#define SLAB_ALLOCATOR_MAX_BLOCK_SIZE (SLAB_ALLOCATOR_MIN_BLOCK_SIZE << (SLAB_ALLOCATOR_CLASS_COUNT - 1))
+
+/** @brief The slab allocator structure. */
+typedef struct slab_allocator {
+    /** @brief The allocated memory block for this allocator to use. */
+    void* memory;
+} slab_allocator;
+
+/**
+ * @brief Creates a new slab allocator. Should be called twice; once to obtain the memory
+ * amount required (passing memory=0), and a second time with memory being set to an allocated block.
+ *
+ * @param total_size The total size in bytes the allocator should hold. Rounded up to a whole number of slabs.
+ * @param memory_requirement A pointer to hold the required memory for the internal state, slab table and slabs.
+ * @param memory An allocated block of memory, or 0 if just obtaining the requirement.
+ * @param out_allocator A pointer to hold the allocator.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 slab_allocator_create(u64 total_size, u64* memory_requirement, void* memory, slab_allocator* out_allocator);
+
+/**
+ * @brief Destroys the given allocator. The memory passed at creation is not freed.
+ *
+ * @param allocator A pointer to the allocator to be destroyed.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 slab_allocator_destroy(slab_allocator* allocator);
+
+/**
+ * @brief Allocates a block of at least the given size from the provided allocator.
+ * Blocks are aligned to SLAB_ALLOCATOR_MIN_BLOCK_SIZE.
+ *
+ * @param allocator A pointer to the allocator to allocate from.
+ * @param size The size in bytes to be allocated. Must not exceed SLAB_ALLOCATOR_MAX_BLOCK_SIZE.
+ * @return The allocated block of memory, or 0 if the request could not be served.
+ */
+KAPI void* slab_allocator_allocate(slab_allocator* allocator, u64 size);
+
+/**
+ * @brief Frees the given block of memory.
+ *
+ * @param allocator A pointer to the allocator to free from.
+ * @param block The block to be freed. Must have been allocated by the provided allocator.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 slab_allocator_free(slab_allocator* allocator, void* block);
+
+/**
+ * @brief Obtains the number of slabs which are not in use by any size class.
+ *
+ * @param allocator A pointer to the allocator to be examined.
+ * @return The number of empty slabs.
+ */
+KAPI u32 slab_allocator_free_slab_count(slab_allocator* allocator);
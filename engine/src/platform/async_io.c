@@ -0,0 +1,669 @@
+#include "async_io.h"
+
+#include "core/katomic.h"
+#include "core/kmutex.h"
+#include "core/ksemaphore.h"
+#include "core/kthread.h"
+#include "core/logger.h"
+#include "platform/platform.h"
+#include "systems/job_system.h"
+
+#include <stddef.h>  // offsetof
+#include <stdint.h>  // intptr_t
+
+#if KPLATFORM_WINDOWS
+#define ASYNC_IO_IOCP 1
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if KPLATFORM_LINUX && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define ASYNC_IO_URING 1
+#endif
+#endif
+#endif
+#endif
+
+// The largest single read, which every platform can do in one call.
+#define ASYNC_IO_MAX_READ_SIZE (1024ull * 1024ull * 1024ull)
+
+typedef enum async_io_backend {
+    ASYNC_IO_BACKEND_WORKERS,
+    ASYNC_IO_BACKEND_URING,
+    ASYNC_IO_BACKEND_IOCP
+} async_io_backend;
+
+typedef struct async_io_state {
+    async_io_backend backend;
+    b8 running;
+    // The number of reads submitted and not yet completed.
+    u32 in_flight;
+    // Set while a thread is collecting completions, which only one thread may do at a time.
+    u32 collecting;
+
+#if ASYNC_IO_IOCP
+    HANDLE port;
+#else
+    // Reads waiting for a reading thread, guarded by queue_mutex.
+    kmutex queue_mutex;
+    async_read* queue_head;
+    async_read* queue_tail;
+    // Signalled once per queued read, and to wake the reading threads for shutdown.
+    ksemaphore work_semaphore;
+    // Signalled once per completed read, for blocking waits.
+    ksemaphore done_semaphore;
+    u32 worker_count;
+    // The number of reading threads which have not exited yet.
+    u32 live_workers;
+#endif
+
+#if ASYNC_IO_URING
+    int ring_fd;
+    // Guards the submission ring, which only one thread may add to at a time.
+    kmutex submit_mutex;
+    void* sq_ring;
+    u64 sq_ring_size;
+    void* cq_ring;
+    u64 cq_ring_size;
+    struct io_uring_sqe* sqes;
+    u64 sqes_size;
+    u32* sq_tail;
+    u32* sq_mask;
+    u32* sq_array;
+    u32* cq_head;
+    u32* cq_tail;
+    u32* cq_mask;
+    struct io_uring_cqe* cqes;
+#endif
+} async_io_state;
+
+static async_io_state* state_ptr;
+
+/**
+ * Marks the given read as finished, with the number of bytes read or a negative result
+ * if it failed. The read may be reused by its owner as soon as this returns.
+ */
+static void read_finish(async_read* read, i64 result) {
+    katomic_fetch_sub(&state_ptr->in_flight, 1);
+    if (result >= 0) {
+        read->bytes_read = (u64)result;
+        katomic_store_release(&read->status, ASYNC_READ_STATUS_COMPLETE);
+    } else {
+        katomic_store_release(&read->status, ASYNC_READ_STATUS_FAILED);
+    }
+}
+
+static b8 read_is_pending(async_read* read) {
+    return katomic_load_acquire(&read->status) == ASYNC_READ_STATUS_PENDING;
+}
+
+#if ASYNC_IO_URING
+static b8 uring_create(void) {
+    struct io_uring_params params = {0};
+    int fd = (int)syscall(__NR_io_uring_setup, ASYNC_IO_QUEUE_DEPTH, &params);
+    if (fd < 0) {
+        KWARN("io_uring is unavailable (errno=%i). Falling back to reading threads.", errno);
+        return false;
+    }
+
+    state_ptr->ring_fd = fd;
+    state_ptr->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+    state_ptr->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    // Newer kernels map both rings at once.
+    b8 single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        state_ptr->sq_ring_size = KMAX(state_ptr->sq_ring_size, state_ptr->cq_ring_size);
+        state_ptr->cq_ring_size = state_ptr->sq_ring_size;
+    }
+    state_ptr->sq_ring = mmap(0, state_ptr->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    state_ptr->cq_ring = single_mmap ? state_ptr->sq_ring : mmap(0, state_ptr->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    state_ptr->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    state_ptr->sqes = mmap(0, state_ptr->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (state_ptr->sq_ring == MAP_FAILED || state_ptr->cq_ring == MAP_FAILED || state_ptr->sqes == MAP_FAILED) {
+        KWARN("Unable to map io_uring rings. Falling back to reading threads.");
+        if (state_ptr->sq_ring != MAP_FAILED) {
+            munmap(state_ptr->sq_ring, state_ptr->sq_ring_size);
+        }
+        if (!single_mmap && state_ptr->cq_ring != MAP_FAILED) {
+            munmap(state_ptr->cq_ring, state_ptr->cq_ring_size);
+        }
+        if (state_ptr->sqes != MAP_FAILED) {
+            munmap(state_ptr->sqes, state_ptr->sqes_size);
+        }
+        close(fd);
+        return false;
+    }
+
+    u8* sq = state_ptr->sq_ring;
+    state_ptr->sq_tail = (u32*)(sq + params.sq_off.tail);
+    state_ptr->sq_mask = (u32*)(sq + params.sq_off.ring_mask);
+    state_ptr->sq_array = (u32*)(sq + params.sq_off.array);
+    u8* cq = state_ptr->cq_ring;
+    state_ptr->cq_head = (u32*)(cq + params.cq_off.head);
+    state_ptr->cq_tail = (u32*)(cq + params.cq_off.tail);
+    state_ptr->cq_mask = (u32*)(cq + params.cq_off.ring_mask);
+    state_ptr->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    if (!kmutex_create(&state_ptr->submit_mutex)) {
+        KERROR("Failed to create io_uring submission mutex.");
+        return false;
+    }
+    return true;
+}
+
+static void uring_destroy(void) {
+    munmap(state_ptr->sqes, state_ptr->sqes_size);
+    if (state_ptr->cq_ring != state_ptr->sq_ring) {
+        munmap(state_ptr->cq_ring, state_ptr->cq_ring_size);
+    }
+    munmap(state_ptr->sq_ring, state_ptr->sq_ring_size);
+    close(state_ptr->ring_fd);
+    kmutex_destroy(&state_ptr->submit_mutex);
+}
+
+static b8 uring_submit(async_read* read) {
+    // The vector the read goes into is kept with the read, as the kernel may look at it after submission.
+    STATIC_ASSERT(sizeof(struct iovec) <= sizeof(((async_read*)0)->platform_data), "async_read platform data is too small for an iovec.");
+    struct iovec* vector = (struct iovec*)read->platform_data;
+    vector->iov_base = read->buffer;
+    vector->iov_len = read->size;
+
+    kmutex_lock(&state_ptr->submit_mutex);
+    u32 tail = *state_ptr->sq_tail;
+    u32 index = tail & *state_ptr->sq_mask;
+    struct io_uring_sqe* sqe = &state_ptr->sqes[index];
+    kzero_memory(sqe, sizeof(struct io_uring_sqe));
+    // Vectored reads are supported by every kernel with io_uring, unlike plain reads.
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = (int)(intptr_t)read->file->handle;
+    sqe->addr = (u64)(uintptr_t)vector;
+    sqe->len = 1;
+    sqe->off = read->offset;
+    sqe->user_data = (u64)(uintptr_t)read;
+    state_ptr->sq_array[index] = index;
+    katomic_store_release(state_ptr->sq_tail, tail + 1);
+
+    long submitted;
+    do {
+        submitted = syscall(__NR_io_uring_enter, state_ptr->ring_fd, 1, 0, 0, 0, 0);
+    } while (submitted < 0 && (errno == EINTR || errno == EAGAIN));
+    if (submitted != 1) {
+        // Nothing was taken from the ring, so take the entry back rather than leave it for the next submission.
+        katomic_store_release(state_ptr->sq_tail, tail);
+        kmutex_unlock(&state_ptr->submit_mutex);
+        KERROR("io_uring submission failed (errno=%i).", errno);
+        return false;
+    }
+    kmutex_unlock(&state_ptr->submit_mutex);
+    return true;
+}
+
+static void uring_collect(async_read* waiting) {
+    u32 head = *state_ptr->cq_head;
+    if (waiting && head == katomic_load_acquire(state_ptr->cq_tail)) {
+        // Nothing has finished, so sleep in the kernel until something does.
+        syscall(__NR_io_uring_enter, state_ptr->ring_fd, 0, 1, IORING_ENTER_GETEVENTS, 0, 0);
+    }
+    u32 tail = katomic_load_acquire(state_ptr->cq_tail);
+    u32 mask = *state_ptr->cq_mask;
+    while (head != tail) {
+        struct io_uring_cqe* cqe = &state_ptr->cqes[head & mask];
+        read_finish((async_read*)(uintptr_t)cqe->user_data, cqe->res);
+        head++;
+    }
+    katomic_store_release(state_ptr->cq_head, head);
+}
+#endif
+
+#if ASYNC_IO_IOCP
+STATIC_ASSERT(sizeof(OVERLAPPED) <= sizeof(((async_read*)0)->platform_data), "async_read platform data is too small for an OVERLAPPED.");
+
+// The status of a read which stopped at the end of the file.
+#define ASYNC_IO_STATUS_END_OF_FILE 0xC0000011L
+
+static b8 iocp_submit(async_read* read) {
+    OVERLAPPED* overlapped = (OVERLAPPED*)read->platform_data;
+    kzero_memory(overlapped, sizeof(OVERLAPPED));
+    overlapped->Offset = (DWORD)read->offset;
+    overlapped->OffsetHigh = (DWORD)(read->offset >> 32);
+    if (!ReadFile((HANDLE)read->file->handle, read->buffer, (DWORD)read->size, 0, overlapped)) {
+        DWORD error = GetLastError();
+        if (error == ERROR_HANDLE_EOF) {
+            // Nothing is posted to the port for a read starting at the end of the file.
+            read_finish(read, 0);
+            return true;
+        }
+        if (error != ERROR_IO_PENDING) {
+            KERROR("ReadFile failed (error=%u).", error);
+            return false;
+        }
+    }
+    // Reads which finish at once are still posted to the port.
+    return true;
+}
+
+static void iocp_collect(async_read* waiting) {
+    OVERLAPPED_ENTRY entries[64];
+    ULONG count = 0;
+    // Blocking waits time out now and then, in case another thread takes the completion being waited on.
+    if (!GetQueuedCompletionStatusEx(state_ptr->port, entries, 64, &count, waiting ? 1 : 0, FALSE)) {
+        return;
+    }
+    for (ULONG i = 0; i < count; ++i) {
+        OVERLAPPED* overlapped = entries[i].lpOverlapped;
+        async_read* read = (async_read*)((u8*)overlapped - offsetof(async_read, platform_data));
+        if (overlapped->Internal == 0 || overlapped->Internal == (ULONG_PTR)ASYNC_IO_STATUS_END_OF_FILE) {
+            read_finish(read, (i64)entries[i].dwNumberOfBytesTransferred);
+        } else {
+            read_finish(read, -1);
+        }
+    }
+}
+#else
+static i64 read_at(int fd, u64 offset, u64 size, void* buffer) {
+    u64 total = 0;
+    while (total < size) {
+        ssize_t result = pread(fd, (u8*)buffer + total, size - total, (off_t)(offset + total));
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (result == 0) {
+            // The end of the file.
+            break;
+        }
+        total += (u64)result;
+    }
+    return (i64)total;
+}
+
+static u32 async_io_worker_run(void* params) {
+    while (true) {
+        ksemaphore_wait(&state_ptr->work_semaphore, KSEMAPHORE_WAIT_INFINITE);
+        if (!katomic_load(&state_ptr->running)) {
+            break;
+        }
+
+        kmutex_lock(&state_ptr->queue_mutex);
+        async_read* read = state_ptr->queue_head;
+        if (read) {
+            state_ptr->queue_head = read->next;
+            if (!state_ptr->queue_head) {
+                state_ptr->queue_tail = 0;
+            }
+        }
+        kmutex_unlock(&state_ptr->queue_mutex);
+        if (!read) {
+            continue;
+        }
+
+        read_finish(read, read_at((int)(intptr_t)read->file->handle, read->offset, read->size, read->buffer));
+        ksemaphore_signal(&state_ptr->done_semaphore);
+    }
+    katomic_fetch_sub(&state_ptr->live_workers, 1);
+    return 0;
+}
+
+static b8 workers_create(void) {
+    if (!kmutex_create(&state_ptr->queue_mutex) ||
+        !ksemaphore_create(&state_ptr->work_semaphore, 65535, 0) ||
+        !ksemaphore_create(&state_ptr->done_semaphore, 65535, 0)) {
+        KERROR("Failed to create async I/O reading thread synchronization.");
+        return false;
+    }
+    for (u32 i = 0; i < ASYNC_IO_WORKER_COUNT; ++i) {
+        // Detached, as the threads exit by themselves on shutdown.
+        kthread thread;
+        katomic_fetch_add(&state_ptr->live_workers, 1);
+        if (!kthread_create(async_io_worker_run, 0, true, &thread)) {
+            katomic_fetch_sub(&state_ptr->live_workers, 1);
+            KERROR("Failed to create async I/O reading thread.");
+            break;
+        }
+        state_ptr->worker_count++;
+    }
+    return state_ptr->worker_count > 0;
+}
+
+static void workers_destroy(void) {
+    // Wake each thread to see the system has stopped, and wait for them before destroying what they use.
+    for (u32 i = 0; i < state_ptr->worker_count; ++i) {
+        ksemaphore_signal(&state_ptr->work_semaphore);
+    }
+    while (katomic_load(&state_ptr->live_workers) > 0) {
+        platform_sleep(1);
+    }
+    ksemaphore_destroy(&state_ptr->done_semaphore);
+    ksemaphore_destroy(&state_ptr->work_semaphore);
+    kmutex_destroy(&state_ptr->queue_mutex);
+}
+
+static void workers_submit(async_read* read) {
+    kmutex_lock(&state_ptr->queue_mutex);
+    if (state_ptr->queue_tail) {
+        state_ptr->queue_tail->next = read;
+    } else {
+        state_ptr->queue_head = read;
+    }
+    state_ptr->queue_tail = read;
+    kmutex_unlock(&state_ptr->queue_mutex);
+    ksemaphore_signal(&state_ptr->work_semaphore);
+}
+#endif
+
+/**
+ * Collects the completions of finished reads. If waiting is given and still pending,
+ * blocks for a short while or until some read completes.
+ * @returns False if another thread was already collecting, so nothing was done.
+ */
+static b8 collect_completions(async_read* waiting) {
+    u32 expected = 0;
+    if (!katomic_compare_exchange(&state_ptr->collecting, &expected, 1)) {
+        return false;
+    }
+    if (waiting && !read_is_pending(waiting)) {
+        waiting = 0;
+    }
+    switch (state_ptr->backend) {
+#if ASYNC_IO_URING
+        case ASYNC_IO_BACKEND_URING:
+            uring_collect(waiting);
+            break;
+#endif
+#if ASYNC_IO_IOCP
+        case ASYNC_IO_BACKEND_IOCP:
+            iocp_collect(waiting);
+            break;
+#else
+        case ASYNC_IO_BACKEND_WORKERS:
+            // Reading threads finish reads themselves, so there is only waiting to do.
+            if (waiting) {
+                ksemaphore_wait(&state_ptr->done_semaphore, 1);
+            }
+            break;
+#endif
+        default:
+            break;
+    }
+    katomic_store(&state_ptr->collecting, 0);
+    return true;
+}
+
+b8 async_io_system_initialize(u64* memory_requirement, void* state, async_io_system_config config) {
+    *memory_requirement = sizeof(async_io_state);
+    if (state == 0) {
+        return true;
+    }
+
+    state_ptr = state;
+    kzero_memory(state_ptr, sizeof(async_io_state));
+
+#if ASYNC_IO_IOCP
+    // Windows always reads through a completion port, so has no use for reading threads.
+    (void)config;
+    state_ptr->port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, 0, 0, 0);
+    if (!state_ptr->port) {
+        KERROR("Failed to create I/O completion port (error=%u).", GetLastError());
+        state_ptr = 0;
+        return false;
+    }
+    state_ptr->backend = ASYNC_IO_BACKEND_IOCP;
+    state_ptr->running = true;
+    KDEBUG("Async I/O is using an I/O completion port.");
+#else
+    state_ptr->running = true;
+#if ASYNC_IO_URING
+    if (!config.force_worker_threads && uring_create()) {
+        state_ptr->backend = ASYNC_IO_BACKEND_URING;
+        KDEBUG("Async I/O is using io_uring.");
+        return true;
+    }
+#endif
+    state_ptr->backend = ASYNC_IO_BACKEND_WORKERS;
+    if (!workers_create()) {
+        state_ptr->running = false;
+        state_ptr = 0;
+        return false;
+    }
+    KDEBUG("Async I/O is using %u reading threads.", state_ptr->worker_count);
+#endif
+    return true;
+}
+
+void async_io_system_shutdown(void* state) {
+    if (!state_ptr) {
+        return;
+    }
+    if (katomic_load(&state_ptr->in_flight) > 0) {
+        KWARN("Async I/O shutting down with %u reads still in flight.", katomic_load(&state_ptr->in_flight));
+    }
+    katomic_store(&state_ptr->running, false);
+
+    switch (state_ptr->backend) {
+#if ASYNC_IO_URING
+        case ASYNC_IO_BACKEND_URING:
+            uring_destroy();
+            break;
+#endif
+#if ASYNC_IO_IOCP
+        case ASYNC_IO_BACKEND_IOCP:
+            CloseHandle(state_ptr->port);
+            break;
+#else
+        case ASYNC_IO_BACKEND_WORKERS:
+            workers_destroy();
+            break;
+#endif
+        default:
+            break;
+    }
+    state_ptr = 0;
+}
+
+b8 async_io_system_is_running() {
+    return state_ptr && katomic_load(&state_ptr->running);
+}
+
+b8 async_io_open(const char* path, async_file* out_file) {
+    out_file->handle = 0;
+    out_file->size = 0;
+    out_file->is_valid = false;
+    if (!state_ptr) {
+        KERROR("async_io_open called before the async I/O system was initialized.");
+        return false;
+    }
+
+#if ASYNC_IO_IOCP
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, 0);
+    if (file == INVALID_HANDLE_VALUE) {
+        KERROR("Error opening file for async reading: '%s'", path);
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || !CreateIoCompletionPort(file, state_ptr->port, 0, 0)) {
+        KERROR("Unable to prepare file for async reading: '%s'", path);
+        CloseHandle(file);
+        return false;
+    }
+    out_file->handle = file;
+    out_file->size = (u64)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        KERROR("Error opening file for async reading: '%s'", path);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        KERROR("Unable to get size of file for async reading: '%s'", path);
+        close(fd);
+        return false;
+    }
+    out_file->handle = (void*)(intptr_t)fd;
+    out_file->size = (u64)info.st_size;
+#endif
+    out_file->is_valid = true;
+    return true;
+}
+
+void async_io_close(async_file* file) {
+    if (file->is_valid) {
+#if ASYNC_IO_IOCP
+        CloseHandle((HANDLE)file->handle);
+#else
+        close((int)(intptr_t)file->handle);
+#endif
+    }
+    file->handle = 0;
+    file->size = 0;
+    file->is_valid = false;
+}
+
+b8 async_io_read(const async_file* file, u64 offset, u64 size, void* buffer, async_read* out_read) {
+    if (!state_ptr || !file || !file->is_valid || !out_read || (!buffer && size > 0)) {
+        KERROR("async_io_read requires a running async I/O system, a valid file, buffer and read.");
+        return false;
+    }
+    if (size > ASYNC_IO_MAX_READ_SIZE) {
+        KERROR("async_io_read - size (%llu) exceeds the max of %llu bytes.", size, ASYNC_IO_MAX_READ_SIZE);
+        return false;
+    }
+    out_read->status = ASYNC_READ_STATUS_PENDING;
+    out_read->bytes_read = 0;
+    out_read->file = file;
+    out_read->offset = offset;
+    out_read->size = size;
+    out_read->buffer = buffer;
+    out_read->next = 0;
+
+    // Claim a place among the reads in flight, waiting for one to finish if there are none.
+    while (katomic_fetch_add(&state_ptr->in_flight, 1) >= ASYNC_IO_QUEUE_DEPTH) {
+        katomic_fetch_sub(&state_ptr->in_flight, 1);
+        collect_completions(0);
+        if (job_system_in_fiber_job()) {
+            job_system_yield();
+        } else {
+            platform_sleep(0);
+        }
+    }
+
+    b8 submitted = false;
+    switch (state_ptr->backend) {
+#if ASYNC_IO_URING
+        case ASYNC_IO_BACKEND_URING:
+            submitted = uring_submit(out_read);
+            break;
+#endif
+#if ASYNC_IO_IOCP
+        case ASYNC_IO_BACKEND_IOCP:
+            submitted = iocp_submit(out_read);
+            break;
+#else
+        case ASYNC_IO_BACKEND_WORKERS:
+            workers_submit(out_read);
+            submitted = true;
+            break;
+#endif
+        default:
+            break;
+    }
+    if (!submitted) {
+        katomic_fetch_sub(&state_ptr->in_flight, 1);
+        out_read->status = ASYNC_READ_STATUS_FAILED;
+        return false;
+    }
+    return true;
+}
+
+b8 async_io_is_complete(async_read* read) {
+    if (!read_is_pending(read)) {
+        return true;
+    }
+    if (state_ptr) {
+        collect_completions(0);
+    }
+    return !read_is_pending(read);
+}
+
+static b8 async_read_wait_condition(void* user_data) {
+    return async_io_is_complete(user_data);
+}
+
+b8 async_io_wait(async_read* read) {
+    if (read_is_pending(read)) {
+        if (job_system_in_fiber_job()) {
+            job_system_wait_for(async_read_wait_condition, read);
+        } else {
+            while (read_is_pending(read)) {
+                if (!collect_completions(read)) {
+                    // Another thread is collecting, and will pick this read up along with its own.
+                    platform_sleep(0);
+                }
+            }
+        }
+    }
+    return katomic_load_acquire(&read->status) == ASYNC_READ_STATUS_COMPLETE;
+}
+
+b8 async_io_read_file(const char* path, memory_tag tag, void** out_data, u64* out_size) {
+    *out_data = 0;
+    *out_size = 0;
+    async_file file;
+    if (!async_io_open(path, &file)) {
+        return false;
+    }
+    if (file.size == 0) {
+        async_io_close(&file);
+        return true;
+    }
+
+    u8* data = kallocate(file.size, tag);
+    u64 chunk_count = (file.size + ASYNC_IO_FILE_CHUNK_SIZE - 1) / ASYNC_IO_FILE_CHUNK_SIZE;
+    u32 window = (u32)KMIN(chunk_count, ASYNC_IO_FILE_READS_IN_FLIGHT);
+    async_read reads[ASYNC_IO_FILE_READS_IN_FLIGHT];
+
+    // Keep a window of chunks in flight. Each time the oldest finishes, its place goes to the next chunk.
+    b8 success = true;
+    u64 next_chunk = 0;
+    for (; next_chunk < window; ++next_chunk) {
+        u64 offset = next_chunk * ASYNC_IO_FILE_CHUNK_SIZE;
+        if (!async_io_read(&file, offset, KMIN(ASYNC_IO_FILE_CHUNK_SIZE, file.size - offset), data + offset, &reads[next_chunk])) {
+            success = false;
+            break;
+        }
+    }
+    // Every chunk submitted is waited on, even after a failure, as they read into data.
+    for (u64 done = 0; done < next_chunk; ++done) {
+        async_read* read = &reads[done % window];
+        success = async_io_wait(read) && read->bytes_read == read->size && success;
+        if (success && next_chunk < chunk_count) {
+            u64 offset = next_chunk * ASYNC_IO_FILE_CHUNK_SIZE;
+            if (async_io_read(&file, offset, KMIN(ASYNC_IO_FILE_CHUNK_SIZE, file.size - offset), data + offset, read)) {
+                next_chunk++;
+            } else {
+                success = false;
+            }
+        }
+    }
+
+    u64 size = file.size;
+    async_io_close(&file);
+    if (!success) {
+        KERROR("Unable to read file asynchronously: '%s'", path);
+        kfree(data, size, tag);
+        return false;
+    }
+    *out_data = data;
+    *out_size = size;
+    return true;
+}
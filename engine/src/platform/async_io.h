@@ -0,0 +1,160 @@
+/**
+ * @file async_io.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief This file contains structures and functions for reading files asynchronously,
+ * so that many reads can be in flight at once.
+ * @details Reads use io_uring on Linux, overlapped reads on an I/O completion port on
+ * Windows, and a small pool of reading threads elsewhere, or where io_uring is unavailable
+ * (such as when a sandbox blocks it). Completions are not delivered by callback; they are
+ * collected by whichever thread next asks about a read, so any thread can wait on any read.
+ * Fiber jobs waiting on a read are suspended (see job_system_wait_for), so a single job
+ * thread can keep the reads of many jobs in flight while it runs other work.
+ * @version 1.0
+ *
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "core/kmemory.h"
+
+/** @brief The most reads which can be in flight at once. Further reads wait for one to complete. */
+#define ASYNC_IO_QUEUE_DEPTH 256
+
+/** @brief The number of reading threads used where the platform has no asynchronous reads. */
+#define ASYNC_IO_WORKER_COUNT 4
+
+/** @brief The size of each of the reads async_io_read_file splits a file into, in bytes. */
+#define ASYNC_IO_FILE_CHUNK_SIZE (1024 * 1024)
+
+/** @brief The most reads async_io_read_file keeps in flight for one file. */
+#define ASYNC_IO_FILE_READS_IN_FLIGHT 8
+
+/** @brief The status of an asynchronous read. */
+typedef enum async_read_status {
+    /** @brief The read has been submitted and has not completed yet. */
+    ASYNC_READ_STATUS_PENDING,
+    /** @brief The read completed, and bytes_read bytes were read. */
+    ASYNC_READ_STATUS_COMPLETE,
+    /** @brief The read failed. */
+    ASYNC_READ_STATUS_FAILED
+} async_read_status;
+
+/** @brief A file opened for asynchronous reading. */
+typedef struct async_file {
+    /** @brief Opaque handle to the platform's file handle. */
+    void* handle;
+    /** @brief The size of the file in bytes, as of when it was opened. */
+    u64 size;
+    /** @brief Indicates if this handle is valid. */
+    b8 is_valid;
+} async_file;
+
+/**
+ * @brief A single asynchronous read. Must not be moved, and must outlive the read,
+ * until it has been waited on or found complete.
+ */
+typedef struct async_read {
+    /** @brief The status of the read, an async_read_status. Updated by the async I/O system. */
+    u32 status;
+    /** @brief The number of bytes read, once complete. May be fewer than were asked for at the end of the file. */
+    u64 bytes_read;
+    /** @brief The file being read from. */
+    const async_file* file;
+    /** @brief The offset in the file the read starts at. */
+    u64 offset;
+    /** @brief The number of bytes to read. */
+    u64 size;
+    /** @brief The memory being read into. */
+    void* buffer;
+    /** @brief The next read waiting for a reading thread, where those are used. */
+    struct async_read* next;
+    /** @brief Reserved for the platform's use while the read is in flight. */
+    u64 platform_data[4];
+} async_read;
+
+/** @brief The configuration for the async I/O system. */
+typedef struct async_io_system_config {
+    /** @brief Indicates if reading threads should be used even where the platform has asynchronous reads. */
+    b8 force_worker_threads;
+} async_io_system_config;
+
+/**
+ * @brief Initializes the async I/O system. Should be called twice; once to get the memory
+ * requirement (passing state=0), and a second time passing an allocated block of memory.
+ * @param memory_requirement A pointer to hold the memory requirement in bytes.
+ * @param state A block of memory to hold the state, or 0 if just obtaining the requirement.
+ * @param config The configuration for the system.
+ * @returns True on success; otherwise false.
+ */
+KAPI b8 async_io_system_initialize(u64* memory_requirement, void* state, async_io_system_config config);
+
+/**
+ * @brief Shuts the async I/O system down. Reads must not be in flight.
+ * @param state The state block of memory.
+ */
+KAPI void async_io_system_shutdown(void* state);
+
+/**
+ * @brief Indicates if the async I/O system is running, and so if reads can be submitted.
+ * @returns True if running; otherwise false.
+ */
+KAPI b8 async_io_system_is_running();
+
+/**
+ * @brief Opens the file at path for asynchronous reading.
+ * @param path The path of the file to be opened.
+ * @param out_file A pointer to hold the file.
+ * @returns True if opened successfully; otherwise false.
+ */
+KAPI b8 async_io_open(const char* path, async_file* out_file);
+
+/**
+ * @brief Closes a file opened by async_io_open. Reads from it must not be in flight.
+ * @param file A pointer to the file to be closed.
+ */
+KAPI void async_io_close(async_file* file);
+
+/**
+ * @brief Submits a read of size bytes at offset in the given file into buffer, returning
+ * without waiting for it. If ASYNC_IO_QUEUE_DEPTH reads are already in flight, waits for one
+ * of them to complete first.
+ * @param file A constant pointer to the file to read from, which must stay open until the read completes.
+ * @param offset The offset in the file to start reading at.
+ * @param size The number of bytes to read. Must be no more than 1 GiB.
+ * @param buffer The memory to read into, which must stay valid until the read completes.
+ * @param out_read A pointer to the read, which must stay valid until the read completes.
+ * @returns True if the read was submitted; otherwise false.
+ */
+KAPI b8 async_io_read(const async_file* file, u64 offset, u64 size, void* buffer, async_read* out_read);
+
+/**
+ * @brief Indicates if the given read has completed, successfully or not. Also collects the
+ * completions of any other reads which have finished, without blocking.
+ * @param read A pointer to the read.
+ * @returns True if the read has completed; otherwise false.
+ */
+KAPI b8 async_io_is_complete(async_read* read);
+
+/**
+ * @brief Waits for the given read to complete. Fiber jobs are suspended while they wait,
+ * leaving their job thread free; other callers block.
+ * @param read A pointer to the read.
+ * @returns True if the read succeeded; otherwise false.
+ */
+KAPI b8 async_io_wait(async_read* read);
+
+/**
+ * @brief Reads the whole file at path, split into several reads in flight at once, and waits
+ * for them as async_io_wait does. Allocates *out_data, which must be freed by the caller with
+ * the given tag. An empty file succeeds with no data.
+ * @param path The path of the file to be read.
+ * @param tag The memory tag to allocate the data with.
+ * @param out_data A pointer to hold the data.
+ * @param out_size A pointer to hold the size of the data in bytes.
+ * @returns True if the whole file was read; otherwise false.
+ */
+KAPI b8 async_io_read_file(const char* path, memory_tag tag, void** out_data, u64* out_size);
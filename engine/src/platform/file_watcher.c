@@ -0,0 +1,350 @@
+#include "file_watcher.h"
+
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+
+#if KPLATFORM_WINDOWS
+#include <windows.h>
+#elif KPLATFORM_LINUX
+#include "containers/darray.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if KPLATFORM_WINDOWS
+
+// The size of the buffer changes are read into. Changes beyond this between polls are lost.
+#define FILE_WATCHER_BUFFER_SIZE (64 * 1024)
+
+typedef struct file_watcher_internal {
+    char root[FILE_WATCHER_MAX_PATH_LENGTH];
+    HANDLE directory;
+    OVERLAPPED overlapped;
+    // Indicates if the buffer holds completed changes not yet taken, starting at offset.
+    b8 has_changes;
+    DWORD offset;
+    // DWORD-aligned, as ReadDirectoryChangesW requires.
+    DWORD buffer[FILE_WATCHER_BUFFER_SIZE / sizeof(DWORD)];
+} file_watcher_internal;
+
+static b8 watch_issue_read(file_watcher_internal* internal) {
+    internal->has_changes = false;
+    internal->offset = 0;
+    ResetEvent(internal->overlapped.hEvent);
+    DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME;
+    if (!ReadDirectoryChangesW(internal->directory, internal->buffer, sizeof(internal->buffer), TRUE, filter, 0, &internal->overlapped, 0)) {
+        KERROR("file_watcher - ReadDirectoryChangesW failed for '%s' with error %lu.", internal->root, GetLastError());
+        return false;
+    }
+    return true;
+}
+
+b8 file_watcher_create(const char* path, file_watcher* out_watcher) {
+    out_watcher->internal_data = 0;
+    out_watcher->is_valid = false;
+
+    HANDLE directory = CreateFileA(path, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 0, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, 0);
+    if (directory == INVALID_HANDLE_VALUE) {
+        KERROR("file_watcher_create - unable to open directory '%s' for watching.", path);
+        return false;
+    }
+
+    file_watcher_internal* internal = kallocate(sizeof(file_watcher_internal), MEMORY_TAG_APPLICATION);
+    string_ncopy(internal->root, path, FILE_WATCHER_MAX_PATH_LENGTH - 1);
+    internal->directory = directory;
+    internal->overlapped.hEvent = CreateEventA(0, TRUE, FALSE, 0);
+    if (!internal->overlapped.hEvent || !watch_issue_read(internal)) {
+        if (internal->overlapped.hEvent) {
+            CloseHandle(internal->overlapped.hEvent);
+        }
+        CloseHandle(directory);
+        kfree(internal, sizeof(file_watcher_internal), MEMORY_TAG_APPLICATION);
+        return false;
+    }
+
+    out_watcher->internal_data = internal;
+    out_watcher->is_valid = true;
+    return true;
+}
+
+void file_watcher_destroy(file_watcher* watcher) {
+    if (!watcher || !watcher->is_valid) {
+        return;
+    }
+    file_watcher_internal* internal = watcher->internal_data;
+    // The read must be finished before its buffer is freed.
+    CancelIoEx(internal->directory, &internal->overlapped);
+    DWORD bytes = 0;
+    GetOverlappedResult(internal->directory, &internal->overlapped, &bytes, TRUE);
+    CloseHandle(internal->overlapped.hEvent);
+    CloseHandle(internal->directory);
+    kfree(internal, sizeof(file_watcher_internal), MEMORY_TAG_APPLICATION);
+    watcher->internal_data = 0;
+    watcher->is_valid = false;
+}
+
+b8 file_watcher_next_change(file_watcher* watcher, char* out_path, u64 max_length) {
+    if (!watcher || !watcher->is_valid || max_length < 2) {
+        return false;
+    }
+    file_watcher_internal* internal = watcher->internal_data;
+
+    while (true) {
+        if (!internal->has_changes) {
+            DWORD bytes = 0;
+            if (!GetOverlappedResult(internal->directory, &internal->overlapped, &bytes, FALSE)) {
+                if (GetLastError() != ERROR_IO_INCOMPLETE) {
+                    KWARN("file_watcher - reading changes in '%s' failed with error %lu.", internal->root, GetLastError());
+                    watch_issue_read(internal);
+                }
+                return false;
+            }
+            if (bytes == 0) {
+                // The changes did not fit in the buffer.
+                KWARN("file_watcher - too many changes in '%s' at once; some were missed.", internal->root);
+                watch_issue_read(internal);
+                return false;
+            }
+            internal->has_changes = true;
+        }
+
+        FILE_NOTIFY_INFORMATION* info = (FILE_NOTIFY_INFORMATION*)((u8*)internal->buffer + internal->offset);
+        DWORD action = info->Action;
+        i32 length = WideCharToMultiByte(CP_UTF8, 0, info->FileName, (i32)(info->FileNameLength / sizeof(WCHAR)), out_path, (i32)max_length - 1, 0, 0);
+
+        // Move on to the next change, or start waiting for more once all have been taken. The
+        // system keeps collecting changes in the meantime.
+        if (info->NextEntryOffset) {
+            internal->offset += info->NextEntryOffset;
+        } else {
+            watch_issue_read(internal);
+        }
+
+        if (length <= 0 || (action != FILE_ACTION_MODIFIED && action != FILE_ACTION_ADDED && action != FILE_ACTION_RENAMED_NEW_NAME)) {
+            continue;
+        }
+        out_path[length] = 0;
+        for (i32 i = 0; i < length; ++i) {
+            if (out_path[i] == '\\') {
+                out_path[i] = '/';
+            }
+        }
+
+        // Directories are reported as modified when files in them change.
+        char full_path[FILE_WATCHER_MAX_PATH_LENGTH * 2];
+        string_format(full_path, "%s/%s", internal->root, out_path);
+        DWORD attributes = GetFileAttributesA(full_path);
+        if (attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY)) {
+            continue;
+        }
+        return true;
+    }
+}
+
+#elif KPLATFORM_LINUX
+
+typedef struct watched_directory {
+    i32 wd;
+    // Relative to the root, or empty for the root itself.
+    char path[FILE_WATCHER_MAX_PATH_LENGTH];
+} watched_directory;
+
+typedef struct file_watcher_internal {
+    char root[FILE_WATCHER_MAX_PATH_LENGTH];
+    i32 fd;
+    // darray
+    watched_directory* directories;
+    // Events read but not yet taken, from offset to size.
+    u32 offset;
+    u32 size;
+    u8 buffer[16 * 1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+} file_watcher_internal;
+
+// Watches the given directory, relative to the root, and every directory beneath it.
+static void watch_directory_tree(file_watcher_internal* internal, const char* relative_path) {
+    char full_path[FILE_WATCHER_MAX_PATH_LENGTH * 2];
+    if (relative_path[0]) {
+        string_format(full_path, "%s/%s", internal->root, relative_path);
+    } else {
+        string_ncopy(full_path, internal->root, sizeof(full_path) - 1);
+    }
+
+    i32 wd = inotify_add_watch(internal->fd, full_path, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (wd < 0) {
+        KWARN("file_watcher - unable to watch '%s' (errno %d).", full_path, errno);
+        return;
+    }
+    watched_directory directory = {};
+    directory.wd = wd;
+    string_ncopy(directory.path, relative_path, FILE_WATCHER_MAX_PATH_LENGTH - 1);
+    darray_push(internal->directories, directory);
+
+    DIR* dir = opendir(full_path);
+    if (!dir) {
+        return;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir))) {
+        if (strings_equal(entry->d_name, ".") || strings_equal(entry->d_name, "..")) {
+            continue;
+        }
+        char child_path[FILE_WATCHER_MAX_PATH_LENGTH * 2];
+        if (relative_path[0]) {
+            string_format(child_path, "%s/%s", relative_path, entry->d_name);
+        } else {
+            string_ncopy(child_path, entry->d_name, sizeof(child_path) - 1);
+        }
+        if (string_length(child_path) >= FILE_WATCHER_MAX_PATH_LENGTH) {
+            continue;
+        }
+
+        b8 is_directory = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN) {
+            char child_full_path[FILE_WATCHER_MAX_PATH_LENGTH * 3];
+            string_format(child_full_path, "%s/%s", full_path, entry->d_name);
+            struct stat info;
+            is_directory = stat(child_full_path, &info) == 0 && S_ISDIR(info.st_mode);
+        }
+        if (is_directory) {
+            watch_directory_tree(internal, child_path);
+        }
+    }
+    closedir(dir);
+}
+
+b8 file_watcher_create(const char* path, file_watcher* out_watcher) {
+    out_watcher->internal_data = 0;
+    out_watcher->is_valid = false;
+
+    i32 fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        KERROR("file_watcher_create - inotify_init1 failed (errno %d).", errno);
+        return false;
+    }
+
+    file_watcher_internal* internal = kallocate(sizeof(file_watcher_internal), MEMORY_TAG_APPLICATION);
+    string_ncopy(internal->root, path, FILE_WATCHER_MAX_PATH_LENGTH - 1);
+    internal->fd = fd;
+    internal->directories = darray_create(watched_directory);
+    watch_directory_tree(internal, "");
+    if (darray_length(internal->directories) == 0) {
+        KERROR("file_watcher_create - unable to watch directory '%s'.", path);
+        darray_destroy(internal->directories);
+        close(fd);
+        kfree(internal, sizeof(file_watcher_internal), MEMORY_TAG_APPLICATION);
+        return false;
+    }
+
+    out_watcher->internal_data = internal;
+    out_watcher->is_valid = true;
+    return true;
+}
+
+void file_watcher_destroy(file_watcher* watcher) {
+    if (!watcher || !watcher->is_valid) {
+        return;
+    }
+    file_watcher_internal* internal = watcher->internal_data;
+    // Closing releases every watch.
+    close(internal->fd);
+    darray_destroy(internal->directories);
+    kfree(internal, sizeof(file_watcher_internal), MEMORY_TAG_APPLICATION);
+    watcher->internal_data = 0;
+    watcher->is_valid = false;
+}
+
+b8 file_watcher_next_change(file_watcher* watcher, char* out_path, u64 max_length) {
+    if (!watcher || !watcher->is_valid) {
+        return false;
+    }
+    file_watcher_internal* internal = watcher->internal_data;
+
+    while (true) {
+        if (internal->offset >= internal->size) {
+            ssize_t bytes = read(internal->fd, internal->buffer, sizeof(internal->buffer));
+            if (bytes <= 0) {
+                // EAGAIN when there is nothing waiting.
+                return false;
+            }
+            internal->offset = 0;
+            internal->size = (u32)bytes;
+        }
+
+        const struct inotify_event* event = (const struct inotify_event*)(internal->buffer + internal->offset);
+        internal->offset += sizeof(struct inotify_event) + event->len;
+
+        if (event->mask & IN_Q_OVERFLOW) {
+            KWARN("file_watcher - too many changes in '%s' at once; some were missed.", internal->root);
+            continue;
+        }
+
+        // Find the directory the event is in.
+        u32 directory_count = darray_length(internal->directories);
+        u32 index = INVALID_ID;
+        for (u32 i = 0; i < directory_count; ++i) {
+            if (internal->directories[i].wd == event->wd) {
+                index = i;
+                break;
+            }
+        }
+        if (index == INVALID_ID) {
+            continue;
+        }
+        if (event->mask & IN_IGNORED) {
+            // The directory was removed.
+            darray_pop_at(internal->directories, index, 0);
+            continue;
+        }
+        if (!event->len) {
+            continue;
+        }
+
+        char path[FILE_WATCHER_MAX_PATH_LENGTH * 2];
+        if (internal->directories[index].path[0]) {
+            string_format(path, "%s/%s", internal->directories[index].path, event->name);
+        } else {
+            string_ncopy(path, event->name, sizeof(path) - 1);
+        }
+        u64 length = string_length(path);
+        if (length >= FILE_WATCHER_MAX_PATH_LENGTH) {
+            continue;
+        }
+
+        if (event->mask & IN_ISDIR) {
+            // New directories are watched too.
+            if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                watch_directory_tree(internal, path);
+            }
+            continue;
+        }
+        // Created files are reported once written and closed.
+        if (!(event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) || length + 1 > max_length) {
+            continue;
+        }
+        kcopy_memory(out_path, path, length + 1);
+        return true;
+    }
+}
+
+#else
+
+b8 file_watcher_create(const char* path, file_watcher* out_watcher) {
+    out_watcher->internal_data = 0;
+    out_watcher->is_valid = false;
+    KWARN("file_watcher_create - watching files is not supported on this platform.");
+    return false;
+}
+
+void file_watcher_destroy(file_watcher* watcher) {
+}
+
+b8 file_watcher_next_change(file_watcher* watcher, char* out_path, u64 max_length) {
+    return false;
+}
+
+#endif
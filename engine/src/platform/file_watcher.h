@@ -0,0 +1,56 @@
+/**
+ * @file file_watcher.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief This file contains structures and functions for watching a directory tree for
+ * changed files.
+ * @details Changes are not delivered by callback; they are queued by the platform and
+ * collected by polling, so they can be handled at a convenient point such as between frames.
+ * Uses inotify on Linux and ReadDirectoryChangesW on Windows. Watching is not supported
+ * on other platforms, where creating a watcher fails.
+ * @version 1.0
+ *
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief The longest path, relative to the watched directory, a change can be reported for. */
+#define FILE_WATCHER_MAX_PATH_LENGTH 512
+
+/** @brief A watch on a directory and everything beneath it. */
+typedef struct file_watcher {
+    /** @brief Opaque handle to the platform's watch state. */
+    void* internal_data;
+    /** @brief Indicates if this watcher is valid. */
+    b8 is_valid;
+} file_watcher;
+
+/**
+ * @brief Starts watching the directory at path, and every directory beneath it, including
+ * ones created later, for files being written, created or moved in.
+ * @param path The path of the directory to be watched.
+ * @param out_watcher A pointer to hold the watcher.
+ * @returns True if watching; otherwise false.
+ */
+KAPI b8 file_watcher_create(const char* path, file_watcher* out_watcher);
+
+/**
+ * @brief Stops watching and releases the watcher.
+ * @param watcher A pointer to the watcher to be destroyed.
+ */
+KAPI void file_watcher_destroy(file_watcher* watcher);
+
+/**
+ * @brief Takes the next changed file, if any, without blocking. A file written several times
+ * may be reported several times.
+ * @param watcher A pointer to the watcher.
+ * @param out_path A buffer to hold the path of the changed file, relative to the watched
+ * directory and using '/' as the separator.
+ * @param max_length The size of out_path, including the terminator. Longer paths are skipped.
+ * @returns True if a change was taken; false if there are none waiting.
+ */
+KAPI b8 file_watcher_next_change(file_watcher* watcher, char* out_path, u64 max_length);
@@ -7,6 +7,14 @@
 #include <string.h>
 #include <sys/stat.h>
 
+#if KPLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 b8 filesystem_exists(const char* path) {
 #ifdef _MSC_VER
     struct _stat buffer;
@@ -140,3 +148,76 @@ b8 filesystem_write(file_handle* handle, u64 data_size, const void* data, u64* o
     }
     return false;
 }
+
+b8 filesystem_map(const char* path, file_mapping* out_mapping) {
+    out_mapping->data = 0;
+    out_mapping->size = 0;
+
+#if KPLATFORM_WINDOWS
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (file == INVALID_HANDLE_VALUE) {
+        KERROR("Error opening file for mapping: '%s'", path);
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        KERROR("Unable to get size of file for mapping: '%s'", path);
+        CloseHandle(file);
+        return false;
+    }
+    if (size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+        void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : 0;
+        // The view keeps the mapping and the file open.
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        if (!data) {
+            KERROR("Unable to map file: '%s'", path);
+            CloseHandle(file);
+            return false;
+        }
+        out_mapping->data = data;
+    }
+    CloseHandle(file);
+    out_mapping->size = (u64)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        KERROR("Error opening file for mapping: '%s'", path);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        KERROR("Unable to get size of file for mapping: '%s'", path);
+        close(fd);
+        return false;
+    }
+    if (info.st_size > 0) {
+        void* data = mmap(0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            KERROR("Unable to map file: '%s'", path);
+            close(fd);
+            return false;
+        }
+        out_mapping->data = data;
+    }
+    // The mapping keeps the file open.
+    close(fd);
+    out_mapping->size = (u64)info.st_size;
+#endif
+
+    return true;
+}
+
+void filesystem_unmap(file_mapping* mapping) {
+    if (mapping->data) {
+#if KPLATFORM_WINDOWS
+        UnmapViewOfFile(mapping->data);
+#else
+        munmap((void*)mapping->data, mapping->size);
+#endif
+    }
+    mapping->data = 0;
+    mapping->size = 0;
+}
@@ -22,6 +22,17 @@ typedef struct file_handle {
     b8 is_valid;
 } file_handle;
 
+/**
+ * @brief A read-only view of a whole file, mapped into memory. Pages are read in
+ * from the file as they are first touched, rather than copied up front.
+ */
+typedef struct file_mapping {
+    /** @brief The contents of the file, or 0 if it is empty. Must not be written to. */
+    const void* data;
+    /** @brief The size of the file in bytes. */
+    u64 size;
+} file_mapping;
+
 /** @brief File open modes. Can be combined. */
 typedef enum file_modes {
     /** Read mode */
@@ -133,3 +144,20 @@ KAPI b8 filesystem_read_all_text(file_handle* handle, char* out_text, u64* out_b
  * @returns True if successful; otherwise false.
  */
 KAPI b8 filesystem_write(file_handle* handle, u64 data_size, const void* data, u64* out_bytes_written);
+
+/**
+ * @brief Maps the whole file at path into memory for reading, using mmap on POSIX
+ * platforms and a file mapping on Windows. The view stays valid until unmapped,
+ * and does not need the file to be kept open. Mapping an empty file succeeds with
+ * no data.
+ * @param path The path of the file to be mapped.
+ * @param out_mapping A pointer to hold the mapping.
+ * @returns True if mapped successfully; otherwise false.
+ */
+KAPI b8 filesystem_map(const char* path, file_mapping* out_mapping);
+
+/**
+ * @brief Unmaps a view created by filesystem_map. Its data must not be used afterward.
+ * @param mapping A pointer to the mapping to be unmapped.
+ */
+KAPI void filesystem_unmap(file_mapping* mapping);
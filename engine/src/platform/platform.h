@@ -70,6 +70,76 @@ void* platform_allocate(u64 size, b8 aligned);
  */
 void platform_free(void* block, b8 aligned);
 
+/** @brief Flags controlling how a block of pages is obtained by platform_allocate_pages. */
+typedef enum platform_page_flags {
+    PLATFORM_PAGE_FLAG_NONE = 0x0,
+    /**
+     * @brief Back the block with 2MiB pages where possible. Falls back to regular pages
+     * (with a transparent huge page hint, where supported) if none are available.
+     */
+    PLATFORM_PAGE_FLAG_HUGE_2MB = 0x1,
+    /** @brief Back the block with 1GiB pages where possible. Falls back as per PLATFORM_PAGE_FLAG_HUGE_2MB. */
+    PLATFORM_PAGE_FLAG_HUGE_1GB = 0x2,
+    /** @brief Place the block on the NUMA node of the calling thread, where supported. */
+    PLATFORM_PAGE_FLAG_NODE_LOCAL = 0x4
+} platform_page_flags;
+
+/** @brief A block of pages obtained directly from the OS. */
+typedef struct platform_page_block {
+    /** @brief The start of the block. Always aligned to page_size. */
+    void* memory;
+    /** @brief The size of the block in bytes, rounded up to a whole number of pages. */
+    u64 size;
+    /** @brief The size in bytes of the pages backing the block. */
+    u64 page_size;
+} platform_page_block;
+
+/**
+ * @brief Obtains a block of zeroed pages directly from the OS, for large and long-lived
+ * allocations such as the engine heap. If the requested page size is unavailable, smaller
+ * pages are used instead; the page size actually used is reported in out_block.
+ *
+ * @param size The size of the block in bytes.
+ * @param flags platform_page_flags controlling how the block is backed.
+ * @param out_block A pointer to hold the block.
+ * @return True on success; otherwise false.
+ */
+b8 platform_allocate_pages(u64 size, u32 flags, platform_page_block* out_block);
+
+/**
+ * @brief Returns a block of pages obtained by platform_allocate_pages to the OS.
+ *
+ * @param block A pointer to the block to be freed.
+ */
+void platform_free_pages(platform_page_block* block);
+
+/**
+ * @brief Reserves a range of virtual address space without backing it with physical memory.
+ * The range is inaccessible until committed with platform_commit_memory.
+ *
+ * @param size The size of the range in bytes. Should be a multiple of 64KiB.
+ * @return The start of the range on success; otherwise 0.
+ */
+void* platform_reserve_memory(u64 size);
+
+/**
+ * @brief Commits a part of a range reserved with platform_reserve_memory, making it readable
+ * and writable. Committed memory is zeroed, and is only backed physically once it is touched.
+ *
+ * @param memory The start of the part to be committed. Should be aligned to 64KiB.
+ * @param size The size of the part in bytes. Should be a multiple of 64KiB.
+ * @return True on success; otherwise false.
+ */
+b8 platform_commit_memory(void* memory, u64 size);
+
+/**
+ * @brief Releases a range reserved with platform_reserve_memory, including any committed parts.
+ *
+ * @param memory The start of the range, as returned by platform_reserve_memory.
+ * @param size The size of the range in bytes, as passed to platform_reserve_memory.
+ */
+void platform_release_memory(void* memory, u64 size);
+
 /**
  * @brief Performs platform-specific zeroing out of the given block of memory.
  *
@@ -89,6 +159,17 @@ void* platform_zero_memory(void* block, u64 size);
  */
 void* platform_copy_memory(void* dest, const void* source, u64 size);
 
+/**
+ * @brief Copies the bytes of memory in source to dest, of the given size. Unlike
+ * platform_copy_memory, the blocks may overlap.
+ *
+ * @param dest The destination memory block.
+ * @param source The source memory block.
+ * @param size The size of data to be copied.
+ * @return A pointer to the destination block of memory.
+ */
+void* platform_move_memory(void* dest, const void* source, u64 size);
+
 /**
  * @brief Sets the bytes of memory to the given value.
  *
@@ -119,10 +200,42 @@ void platform_console_write_error(const char* message, u8 colour);
 
 /**
  * @brief Gets the absolute time since the application started.
+ * Read from the platform's highest-resolution monotonic clock.
  *
  * @return The absolute time since the application started.
  */
-f64 platform_get_absolute_time();
+KAPI f64 platform_get_absolute_time();
+
+/**
+ * @brief Blocks the calling thread until the given absolute time, as returned by
+ * platform_get_absolute_time. Sleeps on a high-resolution timer for most of the wait and
+ * spins for the last fraction of a millisecond, so that it returns close to the target
+ * rather than a scheduler tick late. Returns immediately if the time has already passed.
+ *
+ * @param target_time The absolute time to wait until, in seconds.
+ */
+KAPI void platform_wait_until(f64 target_time);
+
+/** @brief When and how the most recent frame reached the display, as reported by the compositor. */
+typedef struct platform_present_timing {
+    /** @brief The time the frame was first shown, on the same clock as platform_get_absolute_time. */
+    f64 present_time;
+    /** @brief The display's refresh interval in seconds, or 0 if it is not known. */
+    f64 refresh_interval;
+    /** @brief The display's vertical retrace counter at present_time, or 0 if it is not known. */
+    u64 sequence;
+    /** @brief Indicates if the frame was scanned out directly, without being composited. */
+    b8 zero_copy;
+} platform_present_timing;
+
+/**
+ * @brief Obtains the timing of the most recently presented frame. Only available where the
+ * window system reports it, currently Wayland compositors with the presentation-time protocol.
+ *
+ * @param out_timing A pointer to hold the timing.
+ * @return True if timing is available and a frame has been presented; otherwise false.
+ */
+KAPI b8 platform_get_present_timing(platform_present_timing* out_timing);
 
 /**
  * @brief Sleep on the thread for the provided milliseconds. This blocks the main thread.
@@ -138,4 +251,73 @@ void platform_sleep(u64 ms);
  *
  * @return The number of logical processor cores.
  */
-i32 platform_get_processor_count();
+KAPI i32 platform_get_processor_count();
+
+/** @brief The maximum number of logical processors described by a platform_cpu_topology. */
+#define PLATFORM_MAX_PROCESSORS 128
+
+/** @brief Describes a single logical processor. */
+typedef struct platform_processor_info {
+    /** @brief The OS index of the logical processor. Bit n of a thread affinity mask refers to index n. */
+    u32 index;
+    /** @brief The index of the physical core this processor belongs to. SMT siblings share a core index. */
+    u32 core_index;
+    /** @brief The NUMA node this processor belongs to. */
+    u32 numa_node;
+    /** @brief Indicates if this is the first logical processor of its physical core. */
+    b8 is_primary;
+    /** @brief Indicates if this processor is an efficiency core on a hybrid CPU. */
+    b8 is_efficiency;
+} platform_processor_info;
+
+/** @brief Describes the layout of the processors in the system. */
+typedef struct platform_cpu_topology {
+    /** @brief The number of logical processors described. Capped at PLATFORM_MAX_PROCESSORS. */
+    u32 logical_count;
+    /** @brief The number of physical cores. */
+    u32 physical_count;
+    /** @brief The number of physical performance cores. Equal to physical_count on non-hybrid CPUs. */
+    u32 performance_count;
+    /** @brief The number of NUMA nodes. */
+    u32 numa_node_count;
+    /** @brief Indicates if the CPU mixes performance and efficiency cores. */
+    b8 is_hybrid;
+    /** @brief Indicates if processors can be described individually, and threads pinned to them. */
+    b8 has_processor_info;
+    /** @brief Information about each logical processor, if has_processor_info is true. */
+    platform_processor_info processors[PLATFORM_MAX_PROCESSORS];
+} platform_cpu_topology;
+
+/**
+ * @brief Obtains the layout of the processors in the system, including SMT siblings,
+ * performance/efficiency cores and NUMA nodes where the platform reports them.
+ *
+ * @param out_topology A pointer to hold the topology.
+ * @return True on success; otherwise false.
+ */
+b8 platform_get_cpu_topology(platform_cpu_topology* out_topology);
+
+/** @brief The maximum number of frames captured by platform_stack_capture. */
+#define PLATFORM_MAX_STACK_FRAMES 32
+
+/**
+ * @brief Captures the return addresses of the calling thread's stack, innermost first.
+ * Meant for diagnostics only, as it is far too slow for regular use.
+ *
+ * @param skip The number of frames to skip above the caller, which is itself never included.
+ * @param max_frames The maximum number of frames to capture. Capped at PLATFORM_MAX_STACK_FRAMES.
+ * @param out_frames An array of at least max_frames to hold the addresses.
+ * @return The number of frames captured, or 0 if the platform cannot capture stacks.
+ */
+u32 platform_stack_capture(u32 skip, u32 max_frames, void** out_frames);
+
+/**
+ * @brief Describes the given address captured by platform_stack_capture, as the symbol or module
+ * and offset it falls within, where the platform can tell.
+ *
+ * @param address The address to describe.
+ * @param out_buffer A buffer to hold the description.
+ * @param buffer_size The size of the buffer in bytes.
+ * @return True on success; otherwise false.
+ */
+b8 platform_stack_frame_describe(void* address, char* out_buffer, u32 buffer_size);
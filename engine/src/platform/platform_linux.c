@@ -1,17 +1,24 @@
 #include "platform.h"
+#include "platform_linux_wayland.h"
 
 // Linux platform layer.
 #if KPLATFORM_LINUX
 
+// NOTE: Required for pthread_setaffinity_np and the CPU_* macros. Must be defined before any system header.
+#define _GNU_SOURCE
+
 #include "core/logger.h"
 #include "core/event.h"
 #include "core/input.h"
 #include "core/kthread.h"
 #include "core/kmutex.h"
+#include "core/ksemaphore.h"
+#include "core/kfiber.h"
 
 #include "containers/darray.h"
 
 #include <xcb/xcb.h>
+#include <xcb/xinput.h>  // sudo apt-get install libxcb-xinput-dev
 #include <X11/keysym.h>
 #include <X11/XKBlib.h>  // sudo apt-get install libx11-dev
 #include <X11/Xlib.h>
@@ -27,6 +34,12 @@
 #include <pthread.h>
 #include <errno.h>        // For error reporting
 #include <sys/sysinfo.h>  // Processor info
+#include <semaphore.h>
+#include <ucontext.h>
+#include <sys/mman.h>     // Page allocation
+#include <sys/syscall.h>  // mbind and getcpu
+#include <unistd.h>       // sysconf and syscall
+#include <execinfo.h>     // Stack capture
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -45,12 +58,34 @@ typedef struct platform_state {
     xcb_atom_t wm_protocols;
     xcb_atom_t wm_delete_win;
     VkSurfaceKHR surface;
+    // The XInput extension's opcode, if raw motion is available; otherwise 0.
+    u8 xinput_opcode;
+    // Raw motion is reported for the whole screen, so is only used while the window has focus.
+    b8 has_focus;
+    // Indicates if the window is mapped (unmapped windows are minimized or hidden), and if it is entirely covered.
+    b8 is_mapped;
+    b8 is_obscured;
+    // What was last reported with EVENT_CODE_WINDOW_VISIBILITY_CHANGED.
+    b8 reported_visible;
+    b8 reported_focus;
+    // Indicates if the window is on the native Wayland backend, whose state follows this one, rather than XCB.
+    b8 is_wayland;
 } platform_state;
 
 static platform_state* state_ptr;
 
-// Key translation
-keys translate_keycode(u32 x_keycode);
+/**
+ * Chooses the window system. Native Wayland is preferred whenever a compositor is running, as
+ * going through XWayland adds a compositing pass. Setting IGNIS_WINDOW_SYSTEM to "x11" or
+ * "wayland" overrides the choice.
+ */
+static b8 linux_prefer_wayland() {
+    const char* requested = getenv("IGNIS_WINDOW_SYSTEM");
+    if (requested && requested[0]) {
+        return strcmp(requested, "wayland") == 0;
+    }
+    return getenv("WAYLAND_DISPLAY") != 0;
+}
 
 b8 platform_system_startup(
     u64* memory_requirement,
@@ -60,15 +95,31 @@ b8 platform_system_startup(
     i32 y,
     i32 width,
     i32 height) {
-    *memory_requirement = sizeof(platform_state);
+    u64 wayland_requirement = 0;
+    wayland_platform_startup(&wayland_requirement, 0, 0, 0, 0);
+    *memory_requirement = sizeof(platform_state) + wayland_requirement;
     if (state == 0) {
         return true;
     }
 
     state_ptr = state;
+    state_ptr->is_wayland = false;
+
+    if (linux_prefer_wayland()) {
+        if (wayland_platform_startup(&wayland_requirement, (u8*)state + sizeof(platform_state), application_name, width, height)) {
+            KINFO("Using the native Wayland window system.");
+            state_ptr->is_wayland = true;
+            return true;
+        }
+        KWARN("Unable to start on Wayland, falling back to X11.");
+    }
 
     // Connect to X
     state_ptr->display = XOpenDisplay(NULL);
+    if (!state_ptr->display) {
+        KFATAL("Failed to open the X display.");
+        return false;
+    }
 
     // Turn off key repeats.
     XAutoRepeatOff(state_ptr->display);
@@ -106,7 +157,8 @@ b8 platform_system_startup(
     u32 event_values = XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE |
                        XCB_EVENT_MASK_KEY_PRESS | XCB_EVENT_MASK_KEY_RELEASE |
                        XCB_EVENT_MASK_EXPOSURE | XCB_EVENT_MASK_POINTER_MOTION |
-                       XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+                       XCB_EVENT_MASK_STRUCTURE_NOTIFY | XCB_EVENT_MASK_FOCUS_CHANGE |
+                       XCB_EVENT_MASK_VISIBILITY_CHANGE;
 
     // Values to be sent over XCB (bg colour, events)
     u32 value_list[] = {state_ptr->screen->black_pixel, event_values};
@@ -171,8 +223,38 @@ b8 platform_system_startup(
         1,
         &wm_delete_reply->atom);
 
+    // Raw mouse motion through XInput 2, for the unaccelerated, full-rate deltas of high polling rate mice.
+    state_ptr->xinput_opcode = 0;
+    const xcb_query_extension_reply_t* xinput = xcb_get_extension_data(state_ptr->connection, &xcb_input_id);
+    if (xinput && xinput->present) {
+        xcb_input_xi_query_version_reply_t* version = xcb_input_xi_query_version_reply(
+            state_ptr->connection,
+            xcb_input_xi_query_version(state_ptr->connection, 2, 0),
+            NULL);
+        if (version && version->major_version >= 2) {
+            struct {
+                xcb_input_event_mask_t header;
+                u32 mask;
+            } raw_mask;
+            raw_mask.header.deviceid = XCB_INPUT_DEVICE_ALL_MASTER;
+            raw_mask.header.mask_len = 1;
+            raw_mask.mask = XCB_INPUT_XI_EVENT_MASK_RAW_MOTION;
+            // Raw events are only delivered to the root window.
+            xcb_input_xi_select_events(state_ptr->connection, state_ptr->screen->root, 1, &raw_mask.header);
+            state_ptr->xinput_opcode = xinput->major_opcode;
+        }
+        free(version);
+    }
+    if (!state_ptr->xinput_opcode) {
+        KINFO("XInput 2 is not available; raw mouse motion will not be reported.");
+    }
+
     // Map the window to the screen
     xcb_map_window(state_ptr->connection, state_ptr->window);
+    // The application starts out treating the window as visible and focused. Focus is only
+    // reported once it changes, as the window has none until the window manager hands it over.
+    state_ptr->is_mapped = true;
+    state_ptr->reported_visible = true;
 
     // Flush the stream
     i32 stream_result = xcb_flush(state_ptr->connection);
@@ -185,7 +267,9 @@ b8 platform_system_startup(
 }
 
 void platform_system_shutdown(void* plat_state) {
-    if (state_ptr) {
+    if (state_ptr && state_ptr->is_wayland) {
+        wayland_platform_shutdown();
+    } else if (state_ptr) {
         // Turn key repeats back on since this is global for the OS... just... wow.
         XAutoRepeatOn(state_ptr->display);
 
@@ -193,7 +277,24 @@ void platform_system_shutdown(void* plat_state) {
     }
 }
 
+// Posts EVENT_CODE_WINDOW_VISIBILITY_CHANGED if the window's visibility or focus has changed since last reported.
+static void visibility_report() {
+    b8 visible = state_ptr->is_mapped && !state_ptr->is_obscured;
+    if (visible == state_ptr->reported_visible && state_ptr->has_focus == state_ptr->reported_focus) {
+        return;
+    }
+    state_ptr->reported_visible = visible;
+    state_ptr->reported_focus = state_ptr->has_focus;
+    event_context context = {0};
+    context.data.u8[0] = visible;
+    context.data.u8[1] = state_ptr->has_focus;
+    event_post(EVENT_CODE_WINDOW_VISIBILITY_CHANGED, 0, context);
+}
+
 b8 platform_pump_messages() {
+    if (state_ptr && state_ptr->is_wayland) {
+        return wayland_platform_pump_messages();
+    }
     if (state_ptr) {
         xcb_generic_event_t* event;
         xcb_client_message_event_t* cm;
@@ -256,15 +357,56 @@ b8 platform_pump_messages() {
                     // The application layer can decide what to do with this.
                     xcb_configure_notify_event_t* configure_event = (xcb_configure_notify_event_t*)event;
 
-                    // Fire the event. The application layer should pick this up, but not handle it
-                    // as it shouldn be visible to other parts of the application.
+                    // Post the event. The application layer should pick this up, but not handle it
+                    // as it shouldn be visible to other parts of the application. Posted so that a
+                    // drag, which sends many of these, only resizes once per frame.
                     event_context context;
                     context.data.u16[0] = configure_event->width;
                     context.data.u16[1] = configure_event->height;
-                    event_fire(EVENT_CODE_RESIZED, 0, context);
+                    event_post(EVENT_CODE_RESIZED, 0, context);
 
                 } break;
 
+                case XCB_FOCUS_IN:
+                case XCB_FOCUS_OUT: {
+                    state_ptr->has_focus = (event->response_type & ~0x80) == XCB_FOCUS_IN;
+                    visibility_report();
+                } break;
+                case XCB_MAP_NOTIFY:
+                case XCB_UNMAP_NOTIFY: {
+                    // Window managers unmap windows as they are minimized, or moved to another workspace.
+                    state_ptr->is_mapped = (event->response_type & ~0x80) == XCB_MAP_NOTIFY;
+                    visibility_report();
+                } break;
+                case XCB_VISIBILITY_NOTIFY: {
+                    // Only reported without a compositor, which otherwise keeps every window drawn.
+                    xcb_visibility_notify_event_t* visibility_event = (xcb_visibility_notify_event_t*)event;
+                    state_ptr->is_obscured = visibility_event->state == XCB_VISIBILITY_FULLY_OBSCURED;
+                    visibility_report();
+                } break;
+                case XCB_GE_GENERIC: {
+                    xcb_ge_generic_event_t* generic_event = (xcb_ge_generic_event_t*)event;
+                    if (!state_ptr->xinput_opcode || generic_event->extension != state_ptr->xinput_opcode ||
+                        generic_event->event_type != XCB_INPUT_RAW_MOTION || !state_ptr->has_focus) {
+                        break;
+                    }
+                    // Raw motion shares its layout with raw button events. Only the axes that moved are
+                    // present, in order, as flagged in the valuator mask.
+                    xcb_input_raw_button_press_event_t* raw_event = (xcb_input_raw_button_press_event_t*)event;
+                    const u32* mask = xcb_input_raw_button_press_valuator_mask(raw_event);
+                    i32 mask_length = xcb_input_raw_button_press_valuator_mask_length(raw_event);
+                    const xcb_input_fp3232_t* values = xcb_input_raw_button_press_axisvalues_raw(raw_event);
+                    f64 deltas[2] = {0, 0};
+                    u32 value_index = 0;
+                    for (i32 axis = 0; axis < mask_length * 32 && axis < 2; ++axis) {
+                        if (mask[axis / 32] & (1u << (axis % 32))) {
+                            deltas[axis] = values[value_index].integral + values[value_index].frac / 4294967296.0;
+                            value_index++;
+                        }
+                    }
+                    input_process_mouse_raw_move((i32)deltas[0], (i32)deltas[1]);
+                } break;
+
                 case XCB_CLIENT_MESSAGE: {
                     cm = (xcb_client_message_event_t*)event;
 
@@ -291,12 +433,131 @@ void* platform_allocate(u64 size, b8 aligned) {
 void platform_free(void* block, b8 aligned) {
     free(block);
 }
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+// The MPOL_PREFERRED memory policy, from linux/mempolicy.h.
+#define LINUX_MPOL_PREFERRED 1
+
+static void* linux_map_huge(u64 size, u32 page_shift) {
+#ifdef MAP_HUGETLB
+    void* memory = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (page_shift << MAP_HUGE_SHIFT), -1, 0);
+    return memory == MAP_FAILED ? 0 : memory;
+#else
+    return 0;
+#endif
+}
+
+b8 platform_allocate_pages(u64 size, u32 flags, platform_page_block* out_block) {
+    if (!out_block || size == 0) {
+        return false;
+    }
+    out_block->memory = 0;
+
+    // Explicit huge pages only succeed if the system has reserved some (see /proc/sys/vm/nr_hugepages).
+    if (flags & PLATFORM_PAGE_FLAG_HUGE_1GB) {
+        out_block->page_size = GIBIBYTES(1);
+        out_block->size = get_aligned(size, out_block->page_size);
+        out_block->memory = linux_map_huge(out_block->size, 30);
+    }
+    if (!out_block->memory && (flags & (PLATFORM_PAGE_FLAG_HUGE_1GB | PLATFORM_PAGE_FLAG_HUGE_2MB))) {
+        out_block->page_size = MEBIBYTES(2);
+        out_block->size = get_aligned(size, out_block->page_size);
+        out_block->memory = linux_map_huge(out_block->size, 21);
+    }
+
+    if (!out_block->memory) {
+        out_block->page_size = (u64)sysconf(_SC_PAGESIZE);
+        out_block->size = get_aligned(size, out_block->page_size);
+        if (flags & (PLATFORM_PAGE_FLAG_HUGE_1GB | PLATFORM_PAGE_FLAG_HUGE_2MB)) {
+            // Fall back to transparent huge pages. These need 2MiB-aligned ranges, so over-map
+            // and trim the ends off to align the block.
+            u64 huge_size = MEBIBYTES(2);
+            u64 mapped_size = out_block->size + huge_size;
+            u8* mapped = mmap(0, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mapped == MAP_FAILED) {
+                KERROR("platform_allocate_pages - mmap of %llu bytes failed with errno %i.", mapped_size, errno);
+                return false;
+            }
+            u8* aligned = (u8*)get_aligned((u64)mapped, huge_size);
+            if (aligned > mapped) {
+                munmap(mapped, aligned - mapped);
+            }
+            u8* end = aligned + out_block->size;
+            if (end < mapped + mapped_size) {
+                munmap(end, (mapped + mapped_size) - end);
+            }
+            out_block->memory = aligned;
+#ifdef MADV_HUGEPAGE
+            madvise(out_block->memory, out_block->size, MADV_HUGEPAGE);
+#endif
+        } else {
+            void* memory = mmap(0, out_block->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (memory == MAP_FAILED) {
+                KERROR("platform_allocate_pages - mmap of %llu bytes failed with errno %i.", out_block->size, errno);
+                return false;
+            }
+            out_block->memory = memory;
+        }
+    }
+
+    if (flags & PLATFORM_PAGE_FLAG_NODE_LOCAL) {
+        // Prefer the node of the calling thread. This is called directly, since glibc does not wrap mbind.
+        u32 cpu = 0;
+        u32 node = 0;
+        if (syscall(SYS_getcpu, &cpu, &node, 0) == 0 && node < 64) {
+            u64 node_mask = 1ULL << node;
+            if (syscall(SYS_mbind, out_block->memory, out_block->size, LINUX_MPOL_PREFERRED, &node_mask, 64, 0) != 0) {
+                KWARN("platform_allocate_pages - unable to bind block to NUMA node %u (errno %i).", node, errno);
+            }
+        }
+    }
+
+    return true;
+}
+
+void platform_free_pages(platform_page_block* block) {
+    if (block && block->memory) {
+        munmap(block->memory, block->size);
+        block->memory = 0;
+        block->size = 0;
+    }
+}
+
+void* platform_reserve_memory(u64 size) {
+    // NOTE: MAP_NORESERVE keeps large reservations from counting against the overcommit limit.
+    void* memory = mmap(0, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (memory == MAP_FAILED) {
+        KERROR("platform_reserve_memory - mmap of %llu bytes failed with errno %i.", size, errno);
+        return 0;
+    }
+    return memory;
+}
+
+b8 platform_commit_memory(void* memory, u64 size) {
+    if (mprotect(memory, size, PROT_READ | PROT_WRITE) != 0) {
+        KERROR("platform_commit_memory - mprotect of %llu bytes failed with errno %i.", size, errno);
+        return false;
+    }
+    return true;
+}
+
+void platform_release_memory(void* memory, u64 size) {
+    if (memory) {
+        munmap(memory, size);
+    }
+}
 void* platform_zero_memory(void* block, u64 size) {
     return memset(block, 0, size);
 }
 void* platform_copy_memory(void* dest, const void* source, u64 size) {
     return memcpy(dest, source, size);
 }
+void* platform_move_memory(void* dest, const void* source, u64 size) {
+    return memmove(dest, source, size);
+}
 void* platform_set_memory(void* dest, i32 value, u64 size) {
     return memset(dest, value, size);
 }
@@ -313,11 +574,34 @@ void platform_console_write_error(const char* message, u8 colour) {
 }
 
 f64 platform_get_absolute_time() {
+    // CLOCK_MONOTONIC rather than _RAW, as it is the one clock_nanosleep can wait on.
     struct timespec now;
-    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+    clock_gettime(CLOCK_MONOTONIC, &now);
     return now.tv_sec + now.tv_nsec * 0.000000001;
 }
 
+// How far ahead of the target to stop sleeping and start spinning, in seconds. Covers the
+// timer slack and wake-up latency of an absolute clock_nanosleep.
+#define WAIT_SPIN_SECONDS 0.0005
+
+void platform_wait_until(f64 target_time) {
+    f64 sleep_until = target_time - WAIT_SPIN_SECONDS;
+    if (sleep_until > platform_get_absolute_time()) {
+        struct timespec ts;
+        ts.tv_sec = (time_t)sleep_until;
+        ts.tv_nsec = (long)((sleep_until - (f64)ts.tv_sec) * 1000000000.0);
+        if (ts.tv_nsec >= 1000000000L) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        // An absolute deadline, so signals interrupting the sleep do not stretch it.
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, 0) == EINTR) {
+        }
+    }
+    while (platform_get_absolute_time() < target_time) {
+    }
+}
+
 void platform_sleep(u64 ms) {
 #if _POSIX_C_SOURCE >= 199309L
     struct timespec ts;
@@ -340,6 +624,167 @@ i32 platform_get_processor_count() {
     return processors_available;
 }
 
+static b8 linux_read_u32(const char* path, u32* out_value) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+    u32 value;
+    b8 success = fscanf(file, "%u", &value) == 1;
+    fclose(file);
+    if (success) {
+        *out_value = value;
+    }
+    return success;
+}
+
+/**
+ * Reads a list of processors in the format used by sysfs (i.e. "0-3,8,10-11"),
+ * setting the flag for each processor in the list.
+ */
+static b8 linux_read_processor_list(const char* path, b8* out_flags, u32 count) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+    u32 first, last;
+    while (fscanf(file, "%u", &first) == 1) {
+        last = first;
+        i32 c = fgetc(file);
+        if (c == '-') {
+            if (fscanf(file, "%u", &last) != 1) {
+                break;
+            }
+            c = fgetc(file);
+        }
+        for (u32 i = first; i <= last && i < count; ++i) {
+            out_flags[i] = true;
+        }
+        if (c != ',') {
+            break;
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+b8 platform_get_cpu_topology(platform_cpu_topology* out_topology) {
+    if (!out_topology) {
+        return false;
+    }
+    platform_zero_memory(out_topology, sizeof(platform_cpu_topology));
+
+    u32 count = (u32)get_nprocs_conf();
+    if (count > PLATFORM_MAX_PROCESSORS) {
+        KWARN("%u processors detected, but only the first %u will be described.", count, PLATFORM_MAX_PROCESSORS);
+        count = PLATFORM_MAX_PROCESSORS;
+    }
+    out_topology->logical_count = count;
+    out_topology->has_processor_info = true;
+
+    char path[256];
+    // Capacity of each processor, used to tell performance and efficiency cores apart.
+    u32 capacities[PLATFORM_MAX_PROCESSORS] = {0};
+    u32 max_capacity = 0;
+    // A key identifying the physical core of each processor.
+    u32 core_keys[PLATFORM_MAX_PROCESSORS];
+    for (u32 i = 0; i < count; ++i) {
+        platform_processor_info* info = &out_topology->processors[i];
+        info->index = i;
+
+        u32 package_id = 0;
+        u32 core_id = i;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/physical_package_id", i);
+        linux_read_u32(path, &package_id);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/core_id", i);
+        linux_read_u32(path, &core_id);
+        core_keys[i] = (package_id << 16) | (core_id & 0xFFFF);
+
+        // Processors sharing a core with an earlier one are SMT siblings.
+        info->is_primary = true;
+        for (u32 j = 0; j < i; ++j) {
+            if (core_keys[j] == core_keys[i]) {
+                info->core_index = out_topology->processors[j].core_index;
+                info->is_primary = false;
+                break;
+            }
+        }
+        if (info->is_primary) {
+            info->core_index = out_topology->physical_count++;
+        }
+
+        // Prefer the scheduler's capacity (ARM), and fall back to the max frequency.
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cpu_capacity", i);
+        if (!linux_read_u32(path, &capacities[i])) {
+            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cpufreq/cpuinfo_max_freq", i);
+            linux_read_u32(path, &capacities[i]);
+        }
+        max_capacity = KMAX(max_capacity, capacities[i]);
+    }
+
+    // Intel hybrid CPUs list their efficiency cores explicitly. Otherwise, treat cores well below
+    // the highest capacity as efficiency cores, allowing some leeway for favoured cores which boost higher.
+    b8 efficiency[PLATFORM_MAX_PROCESSORS] = {0};
+    if (!linux_read_processor_list("/sys/devices/cpu_atom/cpus", efficiency, count)) {
+        for (u32 i = 0; i < count; ++i) {
+            efficiency[i] = capacities[i] > 0 && capacities[i] < max_capacity * 0.85f;
+        }
+    }
+    for (u32 i = 0; i < count; ++i) {
+        platform_processor_info* info = &out_topology->processors[i];
+        info->is_efficiency = efficiency[i];
+        if (info->is_efficiency) {
+            out_topology->is_hybrid = true;
+        } else if (info->is_primary) {
+            out_topology->performance_count++;
+        }
+    }
+
+    // NUMA nodes list their processors. Systems without NUMA support have a single node.
+    out_topology->numa_node_count = 1;
+    for (u32 node = 0; node < 64; ++node) {
+        b8 in_node[PLATFORM_MAX_PROCESSORS] = {0};
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+        if (!linux_read_processor_list(path, in_node, count)) {
+            continue;
+        }
+        out_topology->numa_node_count = KMAX(out_topology->numa_node_count, node + 1);
+        for (u32 i = 0; i < count; ++i) {
+            if (in_node[i]) {
+                out_topology->processors[i].numa_node = node;
+            }
+        }
+    }
+
+    return true;
+}
+
+u32 platform_stack_capture(u32 skip, u32 max_frames, void** out_frames) {
+    void* frames[PLATFORM_MAX_STACK_FRAMES + 1];
+    // One more frame is captured, and skipped, for this function.
+    i32 count = backtrace(frames, PLATFORM_MAX_STACK_FRAMES + 1);
+    u32 first = skip + 1;
+    if (count <= (i32)first) {
+        return 0;
+    }
+    u32 captured = KMIN((u32)count - first, KMIN(max_frames, PLATFORM_MAX_STACK_FRAMES));
+    for (u32 i = 0; i < captured; ++i) {
+        out_frames[i] = frames[first + i];
+    }
+    return captured;
+}
+
+b8 platform_stack_frame_describe(void* address, char* out_buffer, u32 buffer_size) {
+    // NOTE: Only exported symbols are named; others are given as the module and an offset.
+    char** symbols = backtrace_symbols(&address, 1);
+    if (!symbols) {
+        return false;
+    }
+    snprintf(out_buffer, buffer_size, "%s", symbols[0]);
+    free(symbols);
+    return true;
+}
+
 // NOTE: Begin threads.
 
 b8 kthread_create(pfn_thread_start start_function_ptr, void* params, b8 auto_detach, kthread* out_thread) {
@@ -442,6 +887,26 @@ void kthread_sleep(kthread* thread, u64 ms) {
     platform_sleep(ms);
 }
 
+b8 kthread_set_affinity(kthread* thread, u64 affinity_mask) {
+    if (!thread || !thread->thread_id || affinity_mask == 0) {
+        return false;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (u32 i = 0; i < 64; ++i) {
+        if (affinity_mask & (1ULL << i)) {
+            CPU_SET(i, &set);
+        }
+    }
+    i32 result = pthread_setaffinity_np((pthread_t)thread->thread_id, sizeof(cpu_set_t), &set);
+    if (result != 0) {
+        KERROR("Failed to set thread affinity: errno=%i", result);
+        return false;
+    }
+    return true;
+}
+
 u64 get_thread_id() {
     return (u64)pthread_self();
 }
@@ -547,7 +1012,163 @@ b8 kmutex_unlock(kmutex* mutex) {
 }
 // NOTE: End mutexes
 
+// NOTE: Begin semaphores
+b8 ksemaphore_create(ksemaphore* out_semaphore, u32 max_count, u32 start_count) {
+    if (!out_semaphore) {
+        return false;
+    }
+
+    // NOTE: POSIX semaphores do not have a max count, so it is ignored here.
+    sem_t* semaphore = platform_allocate(sizeof(sem_t), false);
+    if (sem_init(semaphore, 0, start_count) != 0) {
+        KERROR("Semaphore creation failure! errno=%i", errno);
+        platform_free(semaphore, false);
+        return false;
+    }
+
+    out_semaphore->internal_data = semaphore;
+    return true;
+}
+
+void ksemaphore_destroy(ksemaphore* semaphore) {
+    if (semaphore && semaphore->internal_data) {
+        if (sem_destroy((sem_t*)semaphore->internal_data) != 0) {
+            KERROR("Unable to destroy semaphore: errno=%i", errno);
+        }
+        platform_free(semaphore->internal_data, false);
+        semaphore->internal_data = 0;
+    }
+}
+
+b8 ksemaphore_signal(ksemaphore* semaphore) {
+    if (!semaphore || !semaphore->internal_data) {
+        return false;
+    }
+    if (sem_post((sem_t*)semaphore->internal_data) != 0) {
+        KERROR("Unable to signal semaphore: errno=%i", errno);
+        return false;
+    }
+    return true;
+}
+
+b8 ksemaphore_wait(ksemaphore* semaphore, u64 timeout_ms) {
+    if (!semaphore || !semaphore->internal_data) {
+        return false;
+    }
+
+    sem_t* sem = (sem_t*)semaphore->internal_data;
+    i32 result = 0;
+    if (timeout_ms == KSEMAPHORE_WAIT_INFINITE) {
+        // Retry if interrupted by a signal handler.
+        do {
+            result = sem_wait(sem);
+        } while (result != 0 && errno == EINTR);
+    } else {
+        // sem_timedwait takes an absolute time against the realtime clock.
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += timeout_ms / 1000;
+        ts.tv_nsec += (timeout_ms % 1000) * 1000 * 1000;
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+        do {
+            result = sem_timedwait(sem, &ts);
+        } while (result != 0 && errno == EINTR);
+    }
+
+    if (result != 0) {
+        if (errno != ETIMEDOUT) {
+            KERROR("Unable to wait on semaphore: errno=%i", errno);
+        }
+        return false;
+    }
+    return true;
+}
+// NOTE: End semaphores
+
+// NOTE: Begin fibers
+typedef struct linux_fiber {
+    ucontext_t context;
+    // The fiber's stack. 0 for fibers created from a thread.
+    void* stack;
+    pfn_fiber_start start_function_ptr;
+    void* params;
+} linux_fiber;
+
+// makecontext only passes int arguments, so the fiber pointer is split into two halves.
+static void linux_fiber_start(u32 high, u32 low) {
+    linux_fiber* fiber = (linux_fiber*)(((u64)high << 32) | (u64)low);
+    fiber->start_function_ptr(fiber->params);
+    // NOTE: Returning here would exit the thread, as there is no linked context.
+    KFATAL("Fiber start function returned, which is not allowed.");
+}
+
+b8 kfiber_create(pfn_fiber_start start_function_ptr, void* params, u64 stack_size, kfiber* out_fiber) {
+    if (!start_function_ptr || !out_fiber || stack_size == 0) {
+        return false;
+    }
+
+    linux_fiber* fiber = platform_allocate(sizeof(linux_fiber), false);
+    platform_zero_memory(fiber, sizeof(linux_fiber));
+    if (getcontext(&fiber->context) != 0) {
+        KERROR("Fiber creation failure! errno=%i", errno);
+        platform_free(fiber, false);
+        return false;
+    }
+    fiber->stack = platform_allocate(stack_size, false);
+    fiber->start_function_ptr = start_function_ptr;
+    fiber->params = params;
+    fiber->context.uc_stack.ss_sp = fiber->stack;
+    fiber->context.uc_stack.ss_size = stack_size;
+    fiber->context.uc_link = 0;
+    u64 address = (u64)fiber;
+    makecontext(&fiber->context, (void (*)(void))linux_fiber_start, 2, (u32)(address >> 32), (u32)address);
+
+    out_fiber->internal_data = fiber;
+    return true;
+}
+
+b8 kfiber_create_from_thread(kfiber* out_fiber) {
+    if (!out_fiber) {
+        return false;
+    }
+
+    // The context is filled in the first time the thread switches away.
+    linux_fiber* fiber = platform_allocate(sizeof(linux_fiber), false);
+    platform_zero_memory(fiber, sizeof(linux_fiber));
+    out_fiber->internal_data = fiber;
+    return true;
+}
+
+void kfiber_destroy(kfiber* fiber) {
+    if (fiber && fiber->internal_data) {
+        linux_fiber* internal = (linux_fiber*)fiber->internal_data;
+        if (internal->stack) {
+            platform_free(internal->stack, false);
+        }
+        platform_free(internal, false);
+        fiber->internal_data = 0;
+    }
+}
+
+void kfiber_switch(kfiber* current, kfiber* target) {
+    if (!current || !current->internal_data || !target || !target->internal_data) {
+        KERROR("kfiber_switch requires two valid fibers.");
+        return;
+    }
+    if (swapcontext(&((linux_fiber*)current->internal_data)->context, &((linux_fiber*)target->internal_data)->context) != 0) {
+        KERROR("Unable to switch fibers: errno=%i", errno);
+    }
+}
+// NOTE: End fibers
+
 void platform_get_required_extension_names(const char*** names_darray) {
+    if (state_ptr && state_ptr->is_wayland) {
+        wayland_platform_get_required_extension_names(names_darray);
+        return;
+    }
     darray_push(*names_darray, &"VK_KHR_xcb_surface");  // VK_KHR_xlib_surface?
 }
 
@@ -556,6 +1177,9 @@ b8 platform_create_vulkan_surface(vulkan_context* context) {
     if (!state_ptr) {
         return false;
     }
+    if (state_ptr->is_wayland) {
+        return wayland_platform_create_vulkan_surface(context);
+    }
 
     VkXcbSurfaceCreateInfoKHR create_info = {VK_STRUCTURE_TYPE_XCB_SURFACE_CREATE_INFO_KHR};
     create_info.connection = state_ptr->connection;
@@ -0,0 +1,504 @@
+#include "platform_linux_wayland.h"
+
+// Native Wayland window backend for the Linux platform layer.
+#if KPLATFORM_LINUX
+
+#include "platform.h"
+#include "core/logger.h"
+#include "core/event.h"
+#include "core/input.h"
+#include "containers/darray.h"
+
+// NOTE: The client protocol headers are generated from the system's wayland-protocols by the build.
+#include <wayland-client.h>                  // sudo apt-get install libwayland-dev wayland-protocols
+#include "xdg-shell-client-protocol.h"
+#include "presentation-time-client-protocol.h"
+#include <xkbcommon/xkbcommon.h>             // sudo apt-get install libxkbcommon-dev
+#include <linux/input-event-codes.h>         // BTN_*
+
+#include <poll.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include <string.h>
+
+// For surface creation
+#define VK_USE_PLATFORM_WAYLAND_KHR
+#include <vulkan/vulkan.h>
+#include "renderer/vulkan/vulkan_types.inl"
+
+typedef struct wayland_state {
+    struct wl_display* display;
+    struct wl_registry* registry;
+    struct wl_compositor* compositor;
+    struct xdg_wm_base* wm_base;
+    struct wl_seat* seat;
+    struct wl_keyboard* keyboard;
+    struct wl_pointer* pointer;
+    struct wp_presentation* presentation;
+
+    struct wl_surface* surface;
+    struct xdg_surface* xdg_surface;
+    struct xdg_toplevel* toplevel;
+    VkSurfaceKHR vulkan_surface;
+
+    struct xkb_context* xkb_context;
+    struct xkb_keymap* keymap;
+
+    // The current size of the window, and the size asked for by the latest configure.
+    i32 width;
+    i32 height;
+    i32 pending_width;
+    i32 pending_height;
+    b8 quit_requested;
+
+    // The clock presentation timestamps are reported against, which is only usable if CLOCK_MONOTONIC.
+    u32 presentation_clock_id;
+    // Feedback requested for the next commit, made by the next present; 0 if none is outstanding.
+    struct wp_presentation_feedback* feedback;
+    b8 has_present_timing;
+    platform_present_timing present_timing;
+} wayland_state;
+
+static wayland_state* state_ptr;
+
+// NOTE: Begin compositor listeners
+
+static void wm_base_ping(void* data, struct xdg_wm_base* wm_base, u32 serial) {
+    xdg_wm_base_pong(wm_base, serial);
+}
+
+static const struct xdg_wm_base_listener wm_base_listener = {
+    .ping = wm_base_ping,
+};
+
+static void toplevel_configure(void* data, struct xdg_toplevel* toplevel, i32 width, i32 height, struct wl_array* states) {
+    // A size of 0 leaves the choice to the client, so keeps the current one.
+    if (width > 0 && height > 0) {
+        state_ptr->pending_width = width;
+        state_ptr->pending_height = height;
+    }
+}
+
+static void toplevel_close(void* data, struct xdg_toplevel* toplevel) {
+    state_ptr->quit_requested = true;
+}
+
+static const struct xdg_toplevel_listener toplevel_listener = {
+    .configure = toplevel_configure,
+    .close = toplevel_close,
+};
+
+static void xdg_surface_configure(void* data, struct xdg_surface* xdg_surface, u32 serial) {
+    xdg_surface_ack_configure(xdg_surface, serial);
+
+    if (state_ptr->pending_width != state_ptr->width || state_ptr->pending_height != state_ptr->height) {
+        state_ptr->width = state_ptr->pending_width;
+        state_ptr->height = state_ptr->pending_height;
+
+        // Posted, as on XCB, so that an interactive resize only recreates the swapchain once per frame.
+        event_context context;
+        context.data.u16[0] = (u16)state_ptr->width;
+        context.data.u16[1] = (u16)state_ptr->height;
+        event_post(EVENT_CODE_RESIZED, 0, context);
+    }
+}
+
+static const struct xdg_surface_listener xdg_surface_listener = {
+    .configure = xdg_surface_configure,
+};
+
+static void keyboard_keymap(void* data, struct wl_keyboard* keyboard, u32 format, i32 fd, u32 size) {
+    if (format != WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1) {
+        close(fd);
+        return;
+    }
+
+    char* map = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        KERROR("Unable to map the Wayland keymap.");
+        return;
+    }
+    struct xkb_keymap* keymap = xkb_keymap_new_from_string(state_ptr->xkb_context, map, XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS);
+    munmap(map, size);
+    if (!keymap) {
+        KERROR("Unable to compile the Wayland keymap.");
+        return;
+    }
+
+    if (state_ptr->keymap) {
+        xkb_keymap_unref(state_ptr->keymap);
+    }
+    state_ptr->keymap = keymap;
+}
+
+static void keyboard_enter(void* data, struct wl_keyboard* keyboard, u32 serial, struct wl_surface* surface, struct wl_array* pressed_keys) {
+}
+
+static void keyboard_leave(void* data, struct wl_keyboard* keyboard, u32 serial, struct wl_surface* surface) {
+}
+
+static void keyboard_key(void* data, struct wl_keyboard* keyboard, u32 serial, u32 time, u32 key, u32 key_state) {
+    if (!state_ptr->keymap) {
+        return;
+    }
+
+    // Evdev codes are offset by 8 from xkb keycodes. As on XCB, the unshifted symbol is used, so
+    // modifiers do not change which key is reported. Compositors do not repeat keys for clients.
+    const xkb_keysym_t* syms = 0;
+    i32 sym_count = xkb_keymap_key_get_syms_by_level(state_ptr->keymap, key + 8, 0, 0, &syms);
+    if (sym_count < 1) {
+        return;
+    }
+
+    keys translated = translate_keycode(syms[0]);
+    input_process_key(translated, key_state == WL_KEYBOARD_KEY_STATE_PRESSED);
+}
+
+static void keyboard_modifiers(void* data, struct wl_keyboard* keyboard, u32 serial, u32 depressed, u32 latched, u32 locked, u32 group) {
+}
+
+static void keyboard_repeat_info(void* data, struct wl_keyboard* keyboard, i32 rate, i32 delay) {
+}
+
+static const struct wl_keyboard_listener keyboard_listener = {
+    .keymap = keyboard_keymap,
+    .enter = keyboard_enter,
+    .leave = keyboard_leave,
+    .key = keyboard_key,
+    .modifiers = keyboard_modifiers,
+    .repeat_info = keyboard_repeat_info,
+};
+
+static void pointer_enter(void* data, struct wl_pointer* pointer, u32 serial, struct wl_surface* surface, wl_fixed_t x, wl_fixed_t y) {
+    input_process_mouse_move((i16)wl_fixed_to_int(x), (i16)wl_fixed_to_int(y));
+}
+
+static void pointer_leave(void* data, struct wl_pointer* pointer, u32 serial, struct wl_surface* surface) {
+}
+
+static void pointer_motion(void* data, struct wl_pointer* pointer, u32 time, wl_fixed_t x, wl_fixed_t y) {
+    input_process_mouse_move((i16)wl_fixed_to_int(x), (i16)wl_fixed_to_int(y));
+}
+
+static void pointer_button(void* data, struct wl_pointer* pointer, u32 serial, u32 time, u32 button, u32 button_state) {
+    buttons mouse_button = BUTTON_MAX_BUTTONS;
+    switch (button) {
+        case BTN_LEFT:
+            mouse_button = BUTTON_LEFT;
+            break;
+        case BTN_MIDDLE:
+            mouse_button = BUTTON_MIDDLE;
+            break;
+        case BTN_RIGHT:
+            mouse_button = BUTTON_RIGHT;
+            break;
+    }
+
+    if (mouse_button != BUTTON_MAX_BUTTONS) {
+        input_process_button(mouse_button, button_state == WL_POINTER_BUTTON_STATE_PRESSED);
+    }
+}
+
+static void pointer_axis(void* data, struct wl_pointer* pointer, u32 time, u32 axis, wl_fixed_t value) {
+    // Positive values scroll down, the opposite of the engine's wheel direction.
+    if (axis == WL_POINTER_AXIS_VERTICAL_SCROLL && value != 0) {
+        input_process_mouse_wheel(value < 0 ? 1 : -1);
+    }
+}
+
+static void pointer_frame(void* data, struct wl_pointer* pointer) {
+}
+
+static void pointer_axis_source(void* data, struct wl_pointer* pointer, u32 axis_source) {
+}
+
+static void pointer_axis_stop(void* data, struct wl_pointer* pointer, u32 time, u32 axis) {
+}
+
+static void pointer_axis_discrete(void* data, struct wl_pointer* pointer, u32 axis, i32 discrete) {
+}
+
+static const struct wl_pointer_listener pointer_listener = {
+    .enter = pointer_enter,
+    .leave = pointer_leave,
+    .motion = pointer_motion,
+    .button = pointer_button,
+    .axis = pointer_axis,
+    .frame = pointer_frame,
+    .axis_source = pointer_axis_source,
+    .axis_stop = pointer_axis_stop,
+    .axis_discrete = pointer_axis_discrete,
+};
+
+static void seat_capabilities(void* data, struct wl_seat* seat, u32 capabilities) {
+    b8 has_keyboard = (capabilities & WL_SEAT_CAPABILITY_KEYBOARD) != 0;
+    if (has_keyboard && !state_ptr->keyboard) {
+        state_ptr->keyboard = wl_seat_get_keyboard(seat);
+        wl_keyboard_add_listener(state_ptr->keyboard, &keyboard_listener, 0);
+    } else if (!has_keyboard && state_ptr->keyboard) {
+        wl_keyboard_release(state_ptr->keyboard);
+        state_ptr->keyboard = 0;
+    }
+
+    b8 has_pointer = (capabilities & WL_SEAT_CAPABILITY_POINTER) != 0;
+    if (has_pointer && !state_ptr->pointer) {
+        state_ptr->pointer = wl_seat_get_pointer(seat);
+        wl_pointer_add_listener(state_ptr->pointer, &pointer_listener, 0);
+    } else if (!has_pointer && state_ptr->pointer) {
+        wl_pointer_release(state_ptr->pointer);
+        state_ptr->pointer = 0;
+    }
+}
+
+static void seat_name(void* data, struct wl_seat* seat, const char* name) {
+}
+
+static const struct wl_seat_listener seat_listener = {
+    .capabilities = seat_capabilities,
+    .name = seat_name,
+};
+
+static void presentation_clock_id(void* data, struct wp_presentation* presentation, u32 clock_id) {
+    state_ptr->presentation_clock_id = clock_id;
+}
+
+static const struct wp_presentation_listener presentation_listener = {
+    .clock_id = presentation_clock_id,
+};
+
+static void feedback_sync_output(void* data, struct wp_presentation_feedback* feedback, struct wl_output* output) {
+}
+
+static void feedback_presented(
+    void* data,
+    struct wp_presentation_feedback* feedback,
+    u32 tv_sec_hi,
+    u32 tv_sec_lo,
+    u32 tv_nsec,
+    u32 refresh,
+    u32 seq_hi,
+    u32 seq_lo,
+    u32 flags) {
+    // Timestamps on any other clock can not be compared with platform_get_absolute_time.
+    if (state_ptr->presentation_clock_id == CLOCK_MONOTONIC) {
+        u64 seconds = ((u64)tv_sec_hi << 32) | tv_sec_lo;
+        state_ptr->present_timing.present_time = (f64)seconds + (f64)tv_nsec * 0.000000001;
+        state_ptr->present_timing.refresh_interval = (f64)refresh * 0.000000001;
+        state_ptr->present_timing.sequence = ((u64)seq_hi << 32) | seq_lo;
+        state_ptr->present_timing.zero_copy = (flags & WP_PRESENTATION_FEEDBACK_KIND_ZERO_COPY) != 0;
+        state_ptr->has_present_timing = true;
+    }
+
+    wp_presentation_feedback_destroy(feedback);
+    state_ptr->feedback = 0;
+}
+
+static void feedback_discarded(void* data, struct wp_presentation_feedback* feedback) {
+    wp_presentation_feedback_destroy(feedback);
+    state_ptr->feedback = 0;
+}
+
+static const struct wp_presentation_feedback_listener feedback_listener = {
+    .sync_output = feedback_sync_output,
+    .presented = feedback_presented,
+    .discarded = feedback_discarded,
+};
+
+static void registry_global(void* data, struct wl_registry* registry, u32 name, const char* interface, u32 version) {
+    if (strcmp(interface, wl_compositor_interface.name) == 0) {
+        state_ptr->compositor = wl_registry_bind(registry, name, &wl_compositor_interface, KMIN(version, 4));
+    } else if (strcmp(interface, xdg_wm_base_interface.name) == 0) {
+        state_ptr->wm_base = wl_registry_bind(registry, name, &xdg_wm_base_interface, 1);
+        xdg_wm_base_add_listener(state_ptr->wm_base, &wm_base_listener, 0);
+    } else if (strcmp(interface, wl_seat_interface.name) == 0 && !state_ptr->seat) {
+        // Only the first seat is used. Versions past 5 add pointer events that are not handled.
+        state_ptr->seat = wl_registry_bind(registry, name, &wl_seat_interface, KMIN(version, 5));
+        wl_seat_add_listener(state_ptr->seat, &seat_listener, 0);
+    } else if (strcmp(interface, wp_presentation_interface.name) == 0) {
+        state_ptr->presentation = wl_registry_bind(registry, name, &wp_presentation_interface, 1);
+        wp_presentation_add_listener(state_ptr->presentation, &presentation_listener, 0);
+    }
+}
+
+static void registry_global_remove(void* data, struct wl_registry* registry, u32 name) {
+}
+
+static const struct wl_registry_listener registry_listener = {
+    .global = registry_global,
+    .global_remove = registry_global_remove,
+};
+
+// NOTE: End compositor listeners
+
+b8 wayland_platform_startup(u64* memory_requirement, void* state, const char* application_name, i32 width, i32 height) {
+    *memory_requirement = sizeof(wayland_state);
+    if (state == 0) {
+        return true;
+    }
+
+    state_ptr = state;
+    platform_zero_memory(state_ptr, sizeof(wayland_state));
+    state_ptr->width = width;
+    state_ptr->height = height;
+    state_ptr->pending_width = width;
+    state_ptr->pending_height = height;
+    // Until the compositor says otherwise.
+    state_ptr->presentation_clock_id = CLOCK_REALTIME;
+
+    state_ptr->display = wl_display_connect(0);
+    if (!state_ptr->display) {
+        KWARN("Unable to connect to a Wayland compositor.");
+        state_ptr = 0;
+        return false;
+    }
+
+    state_ptr->xkb_context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+
+    // Bind the globals, then wait a second time for the events they send on binding, such as the seat's
+    // capabilities and the presentation clock.
+    state_ptr->registry = wl_display_get_registry(state_ptr->display);
+    wl_registry_add_listener(state_ptr->registry, &registry_listener, 0);
+    wl_display_roundtrip(state_ptr->display);
+    wl_display_roundtrip(state_ptr->display);
+
+    if (!state_ptr->compositor || !state_ptr->wm_base || !state_ptr->xkb_context) {
+        KWARN("The Wayland compositor does not support xdg-shell windows.");
+        wayland_platform_shutdown();
+        return false;
+    }
+    if (!state_ptr->presentation) {
+        KINFO("The Wayland compositor does not report presentation timing.");
+    }
+
+    state_ptr->surface = wl_compositor_create_surface(state_ptr->compositor);
+    state_ptr->xdg_surface = xdg_wm_base_get_xdg_surface(state_ptr->wm_base, state_ptr->surface);
+    xdg_surface_add_listener(state_ptr->xdg_surface, &xdg_surface_listener, 0);
+    state_ptr->toplevel = xdg_surface_get_toplevel(state_ptr->xdg_surface);
+    xdg_toplevel_add_listener(state_ptr->toplevel, &toplevel_listener, 0);
+    xdg_toplevel_set_title(state_ptr->toplevel, application_name);
+    xdg_toplevel_set_app_id(state_ptr->toplevel, application_name);
+
+    // An empty commit asks for the initial configure, which must be acknowledged before anything is presented.
+    wl_surface_commit(state_ptr->surface);
+    wl_display_roundtrip(state_ptr->display);
+
+    return true;
+}
+
+void wayland_platform_shutdown() {
+    if (!state_ptr) {
+        return;
+    }
+
+    if (state_ptr->feedback) {
+        wp_presentation_feedback_destroy(state_ptr->feedback);
+    }
+    if (state_ptr->toplevel) {
+        xdg_toplevel_destroy(state_ptr->toplevel);
+    }
+    if (state_ptr->xdg_surface) {
+        xdg_surface_destroy(state_ptr->xdg_surface);
+    }
+    if (state_ptr->surface) {
+        wl_surface_destroy(state_ptr->surface);
+    }
+    if (state_ptr->keyboard) {
+        wl_keyboard_release(state_ptr->keyboard);
+    }
+    if (state_ptr->pointer) {
+        wl_pointer_release(state_ptr->pointer);
+    }
+    if (state_ptr->seat) {
+        wl_seat_destroy(state_ptr->seat);
+    }
+    if (state_ptr->presentation) {
+        wp_presentation_destroy(state_ptr->presentation);
+    }
+    if (state_ptr->wm_base) {
+        xdg_wm_base_destroy(state_ptr->wm_base);
+    }
+    if (state_ptr->compositor) {
+        wl_compositor_destroy(state_ptr->compositor);
+    }
+    if (state_ptr->registry) {
+        wl_registry_destroy(state_ptr->registry);
+    }
+    if (state_ptr->keymap) {
+        xkb_keymap_unref(state_ptr->keymap);
+    }
+    if (state_ptr->xkb_context) {
+        xkb_context_unref(state_ptr->xkb_context);
+    }
+    wl_display_disconnect(state_ptr->display);
+    state_ptr = 0;
+}
+
+b8 wayland_platform_pump_messages() {
+    if (!state_ptr) {
+        return true;
+    }
+
+    // Ask to be told when the next commit, made by the next present, reaches the display.
+    if (state_ptr->presentation && !state_ptr->feedback) {
+        state_ptr->feedback = wp_presentation_feedback(state_ptr->presentation, state_ptr->surface);
+        wp_presentation_feedback_add_listener(state_ptr->feedback, &feedback_listener, 0);
+    }
+
+    // Read whatever has arrived without blocking, then dispatch it.
+    while (wl_display_prepare_read(state_ptr->display) != 0) {
+        wl_display_dispatch_pending(state_ptr->display);
+    }
+    wl_display_flush(state_ptr->display);
+    struct pollfd poll_fd = {wl_display_get_fd(state_ptr->display), POLLIN, 0};
+    if (poll(&poll_fd, 1, 0) > 0) {
+        wl_display_read_events(state_ptr->display);
+    } else {
+        wl_display_cancel_read(state_ptr->display);
+    }
+    if (wl_display_dispatch_pending(state_ptr->display) < 0) {
+        KERROR("The connection to the Wayland compositor was lost.");
+        return false;
+    }
+
+    return !state_ptr->quit_requested;
+}
+
+void wayland_platform_get_required_extension_names(const char*** names_darray) {
+    darray_push(*names_darray, &"VK_KHR_wayland_surface");
+}
+
+b8 wayland_platform_create_vulkan_surface(vulkan_context* context) {
+    if (!state_ptr) {
+        return false;
+    }
+
+    VkWaylandSurfaceCreateInfoKHR create_info = {VK_STRUCTURE_TYPE_WAYLAND_SURFACE_CREATE_INFO_KHR};
+    create_info.display = state_ptr->display;
+    create_info.surface = state_ptr->surface;
+
+    VkResult result = vkCreateWaylandSurfaceKHR(
+        context->instance,
+        &create_info,
+        context->allocator,
+        &state_ptr->vulkan_surface);
+    if (result != VK_SUCCESS) {
+        KFATAL("Vulkan surface creation failed.");
+        return false;
+    }
+
+    context->surface = state_ptr->vulkan_surface;
+    return true;
+}
+
+b8 wayland_platform_get_present_timing(platform_present_timing* out_timing) {
+    if (!state_ptr || !state_ptr->has_present_timing || !out_timing) {
+        return false;
+    }
+
+    *out_timing = state_ptr->present_timing;
+    return true;
+}
+
+#endif  // KPLATFORM_LINUX
@@ -0,0 +1,77 @@
+/**
+ * @file platform_linux_wayland.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief This file contains the native Wayland window backend of the Linux platform layer.
+ * @details Used by platform_linux.c in place of XCB when running under a Wayland compositor,
+ * which avoids the extra frame or two of latency added by compositing through XWayland.
+ * Internal to the platform layer.
+ * @version 1.0
+ *
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "core/input.h"
+
+struct vulkan_context;
+struct platform_present_timing;
+
+/**
+ * @brief Connects to the Wayland compositor and creates the main window. Should be called
+ * twice, once to obtain the memory requirement (with state=0), then a second time passing
+ * an allocated block of memory to state.
+ *
+ * @param memory_requirement A pointer to hold the memory requirement in bytes.
+ * @param state A pointer to a block of memory to hold state. If obtaining memory requirement only, pass 0.
+ * @param application_name The name of the application.
+ * @param width The initial width of the main window.
+ * @param height The initial height of the main window.
+ * @return True on success; false if there is no usable compositor.
+ */
+b8 wayland_platform_startup(u64* memory_requirement, void* state, const char* application_name, i32 width, i32 height);
+
+/** @brief Destroys the main window and disconnects from the compositor. */
+void wayland_platform_shutdown();
+
+/**
+ * @brief Dispatches any events waiting from the compositor, without blocking.
+ *
+ * @return False if the window was closed or the connection lost; otherwise true.
+ */
+b8 wayland_platform_pump_messages();
+
+/**
+ * @brief Appends the names of the Vulkan instance extensions needed for a Wayland surface.
+ *
+ * @param names_darray A pointer to the darray of extension names.
+ */
+void wayland_platform_get_required_extension_names(const char*** names_darray);
+
+/**
+ * @brief Creates a Vulkan surface for the main window.
+ *
+ * @param context A pointer to the Vulkan context, which holds the surface.
+ * @return True on success; otherwise false.
+ */
+b8 wayland_platform_create_vulkan_surface(struct vulkan_context* context);
+
+/**
+ * @brief Obtains the timing of the most recently presented frame.
+ *
+ * @param out_timing A pointer to hold the timing.
+ * @return True if the compositor reports timing and a frame has been presented; otherwise false.
+ */
+b8 wayland_platform_get_present_timing(struct platform_present_timing* out_timing);
+
+/**
+ * @brief Translates a keysym into the engine's keys. Shared with the XCB backend, as X and
+ * xkbcommon keysyms are the same values.
+ *
+ * @param x_keycode The keysym to translate.
+ * @return The translated key, or 0 if unmapped.
+ */
+keys translate_keycode(u32 x_keycode);
@@ -7,6 +7,8 @@
 #include "core/input.h"
 #include "core/kthread.h"
 #include "core/kmutex.h"
+#include "core/ksemaphore.h"
+#include "core/kfiber.h"
 
 #include "containers/darray.h"
 
@@ -18,7 +20,15 @@
 #import <QuartzCore/QuartzCore.h>
 
 #include <pthread.h>
+#include <unistd.h>
 #include <errno.h>        // For error reporting
+#include <dispatch/dispatch.h>
+#include <sys/sysctl.h>
+#include <sys/mman.h>
+#include <mach/vm_statistics.h>
+#include <execinfo.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 // For surface creation
 #define VK_USE_PLATFORM_METAL_EXT
@@ -461,6 +471,68 @@ void platform_free(void *block, b8 aligned) {
     free(block);
 }
 
+b8 platform_allocate_pages(u64 size, u32 flags, platform_page_block* out_block) {
+    if (!out_block || size == 0) {
+        return false;
+    }
+    out_block->memory = 0;
+
+    // NOTE: macOS has no NUMA control, and only offers 2MiB superpages on Intel.
+#if defined(VM_FLAGS_SUPERPAGE_SIZE_2MB)
+    if (flags & (PLATFORM_PAGE_FLAG_HUGE_1GB | PLATFORM_PAGE_FLAG_HUGE_2MB)) {
+        out_block->page_size = MEBIBYTES(2);
+        out_block->size = get_aligned(size, out_block->page_size);
+        void* memory = mmap(0, out_block->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, VM_FLAGS_SUPERPAGE_SIZE_2MB, 0);
+        out_block->memory = memory == MAP_FAILED ? 0 : memory;
+    }
+#endif
+
+    if (!out_block->memory) {
+        out_block->page_size = (u64)getpagesize();
+        out_block->size = get_aligned(size, out_block->page_size);
+        void* memory = mmap(0, out_block->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        if (memory == MAP_FAILED) {
+            KERROR("platform_allocate_pages - mmap of %llu bytes failed with errno %i.", out_block->size, errno);
+            return false;
+        }
+        out_block->memory = memory;
+    }
+
+    return true;
+}
+
+void platform_free_pages(platform_page_block* block) {
+    if (block && block->memory) {
+        munmap(block->memory, block->size);
+        block->memory = 0;
+        block->size = 0;
+    }
+}
+
+void* platform_reserve_memory(u64 size) {
+    // NOTE: MAP_NORESERVE keeps large reservations from counting against the overcommit limit.
+    void* memory = mmap(0, size, PROT_NONE, MAP_PRIVATE | MAP_ANON | MAP_NORESERVE, -1, 0);
+    if (memory == MAP_FAILED) {
+        KERROR("platform_reserve_memory - mmap of %llu bytes failed with errno %i.", size, errno);
+        return 0;
+    }
+    return memory;
+}
+
+b8 platform_commit_memory(void* memory, u64 size) {
+    if (mprotect(memory, size, PROT_READ | PROT_WRITE) != 0) {
+        KERROR("platform_commit_memory - mprotect of %llu bytes failed with errno %i.", size, errno);
+        return false;
+    }
+    return true;
+}
+
+void platform_release_memory(void* memory, u64 size) {
+    if (memory) {
+        munmap(memory, size);
+    }
+}
+
 void* platform_zero_memory(void *block, u64 size) {
     return memset(block, 0, size);
 }
@@ -469,6 +541,10 @@ void* platform_copy_memory(void *dest, const void *source, u64 size) {
     return memcpy(dest, source, size);
 }
 
+void* platform_move_memory(void *dest, const void *source, u64 size) {
+    return memmove(dest, source, size);
+}
+
 void* platform_set_memory(void *dest, i32 value, u64 size) {
     return memset(dest, value, size);
 }
@@ -485,14 +561,36 @@ void platform_console_write_error(const char *message, u8 colour) {
     printf("\033[%sm%s\033[0m", colour_strings[colour], message);
 }
 
-f64 platform_get_absolute_time() {
+// The length of a mach time unit in seconds, queried once.
+static f64 mach_seconds_per_tick = 0;
+
+static void mach_clock_setup() {
     mach_timebase_info_data_t clock_timebase;
     mach_timebase_info(&clock_timebase);
+    mach_seconds_per_tick = ((f64)clock_timebase.numer / (f64)clock_timebase.denom) / 1.0e9;
+}
+
+f64 platform_get_absolute_time() {
+    if (!mach_seconds_per_tick) {
+        mach_clock_setup();
+    }
+    // Converted as a float, so that scaling the tick count cannot overflow.
+    return (f64)mach_absolute_time() * mach_seconds_per_tick;
+}
 
-    u64 mach_absolute = mach_absolute_time();
+// How far ahead of the target to stop sleeping and start spinning, in seconds.
+#define WAIT_SPIN_SECONDS 0.0005
 
-    u64 nanos = (f64)(mach_absolute * (u64)clock_timebase.numer) / (f64)clock_timebase.denom;
-    return nanos / 1.0e9; // Convert to seconds
+void platform_wait_until(f64 target_time) {
+    if (!mach_seconds_per_tick) {
+        mach_clock_setup();
+    }
+    f64 sleep_until = target_time - WAIT_SPIN_SECONDS;
+    if (sleep_until > platform_get_absolute_time()) {
+        mach_wait_until((u64)(sleep_until / mach_seconds_per_tick));
+    }
+    while (platform_get_absolute_time() < target_time) {
+    }
 }
 
 void platform_sleep(u64 ms) {
@@ -509,10 +607,69 @@ void platform_sleep(u64 ms) {
 #endif
 }
 
+b8 platform_get_present_timing(platform_present_timing* out_timing) {
+    // Not reported by this platform.
+    return false;
+}
+
 i32 platform_get_processor_count() {
     return [[NSProcessInfo processInfo] processorCount];
 }
 
+static u32 macos_sysctl_u32(const char* name, u32 default_value) {
+    i32 value = 0;
+    size_t size = sizeof(value);
+    if (sysctlbyname(name, &value, &size, 0, 0) != 0) {
+        return default_value;
+    }
+    return (u32)value;
+}
+
+b8 platform_get_cpu_topology(platform_cpu_topology* out_topology) {
+    if (!out_topology) {
+        return false;
+    }
+    platform_zero_memory(out_topology, sizeof(platform_cpu_topology));
+
+    // NOTE: macOS does not expose which logical processor is which, nor allow pinning
+    // threads to them, so only the counts are provided.
+    out_topology->logical_count = macos_sysctl_u32("hw.logicalcpu", platform_get_processor_count());
+    out_topology->physical_count = macos_sysctl_u32("hw.physicalcpu", out_topology->logical_count);
+    // Apple silicon reports performance cores as perf level 0 and efficiency cores as perf level 1.
+    u32 perf_levels = macos_sysctl_u32("hw.nperflevels", 1);
+    out_topology->performance_count = perf_levels > 1 ? macos_sysctl_u32("hw.perflevel0.physicalcpu", out_topology->physical_count) : out_topology->physical_count;
+    out_topology->is_hybrid = perf_levels > 1;
+    out_topology->numa_node_count = 1;
+    out_topology->has_processor_info = false;
+    return true;
+}
+
+u32 platform_stack_capture(u32 skip, u32 max_frames, void** out_frames) {
+    void* frames[PLATFORM_MAX_STACK_FRAMES + 1];
+    // One more frame is captured, and skipped, for this function.
+    i32 count = backtrace(frames, PLATFORM_MAX_STACK_FRAMES + 1);
+    u32 first = skip + 1;
+    if (count <= (i32)first) {
+        return 0;
+    }
+    u32 captured = KMIN((u32)count - first, KMIN(max_frames, PLATFORM_MAX_STACK_FRAMES));
+    for (u32 i = 0; i < captured; ++i) {
+        out_frames[i] = frames[first + i];
+    }
+    return captured;
+}
+
+b8 platform_stack_frame_describe(void* address, char* out_buffer, u32 buffer_size) {
+    // NOTE: Only exported symbols are named; others are given as the module and an offset.
+    char** symbols = backtrace_symbols(&address, 1);
+    if (!symbols) {
+        return false;
+    }
+    snprintf(out_buffer, buffer_size, "%s", symbols[0]);
+    free(symbols);
+    return true;
+}
+
 // NOTE: Begin threads.
 
 b8 kthread_create(pfn_thread_start start_function_ptr, void* params, b8 auto_detach, kthread* out_thread) {
@@ -615,6 +772,11 @@ void kthread_sleep(kthread* thread, u64 ms) {
     platform_sleep(ms);
 }
 
+b8 kthread_set_affinity(kthread* thread, u64 affinity_mask) {
+    // NOTE: macOS has no way to pin threads to processors, only affinity hints between threads.
+    return false;
+}
+
 u64 get_thread_id() {
     return (u64)pthread_self();
 }
@@ -720,6 +882,72 @@ b8 kmutex_unlock(kmutex* mutex) {
 }
 // NOTE: End mutexes
 
+// NOTE: Begin semaphores
+b8 ksemaphore_create(ksemaphore* out_semaphore, u32 max_count, u32 start_count) {
+    if (!out_semaphore) {
+        return false;
+    }
+
+    // NOTE: Unnamed POSIX semaphores are not supported on macOS, so use a dispatch semaphore.
+    // Dispatch semaphores do not have a max count, so it is ignored here.
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(start_count);
+    if (!semaphore) {
+        KERROR("Semaphore creation failure!");
+        return false;
+    }
+
+    out_semaphore->internal_data = (void*)semaphore;
+    return true;
+}
+
+void ksemaphore_destroy(ksemaphore* semaphore) {
+    if (semaphore && semaphore->internal_data) {
+        dispatch_release((dispatch_semaphore_t)semaphore->internal_data);
+        semaphore->internal_data = 0;
+    }
+}
+
+b8 ksemaphore_signal(ksemaphore* semaphore) {
+    if (!semaphore || !semaphore->internal_data) {
+        return false;
+    }
+    dispatch_semaphore_signal((dispatch_semaphore_t)semaphore->internal_data);
+    return true;
+}
+
+b8 ksemaphore_wait(ksemaphore* semaphore, u64 timeout_ms) {
+    if (!semaphore || !semaphore->internal_data) {
+        return false;
+    }
+    dispatch_time_t timeout = timeout_ms == KSEMAPHORE_WAIT_INFINITE ? DISPATCH_TIME_FOREVER : dispatch_time(DISPATCH_TIME_NOW, (i64)timeout_ms * NSEC_PER_MSEC);
+    // Non-zero means the timeout elapsed.
+    return dispatch_semaphore_wait((dispatch_semaphore_t)semaphore->internal_data, timeout) == 0;
+}
+// NOTE: End semaphores
+
+// NOTE: Begin fibers
+// NOTE: ucontext is deprecated on macOS and requires _XOPEN_SOURCE, which Cocoa does not
+// build with. Fibers are therefore not supported yet, and creating one always fails. The
+// job system handles this by running fiber jobs directly on the job thread instead.
+b8 kfiber_create(pfn_fiber_start start_function_ptr, void* params, u64 stack_size, kfiber* out_fiber) {
+    return false;
+}
+
+b8 kfiber_create_from_thread(kfiber* out_fiber) {
+    return false;
+}
+
+void kfiber_destroy(kfiber* fiber) {
+    if (fiber) {
+        fiber->internal_data = 0;
+    }
+}
+
+void kfiber_switch(kfiber* current, kfiber* target) {
+    KERROR("kfiber_switch - fibers are not supported on this platform.");
+}
+// NOTE: End fibers
+
 
 
 void platform_get_required_extension_names(const char ***names_darray) {
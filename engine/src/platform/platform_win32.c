@@ -8,12 +8,16 @@
 #include "core/event.h"
 #include "core/kthread.h"
 #include "core/kmutex.h"
+#include "core/ksemaphore.h"
+#include "core/kfiber.h"
 
 #include "containers/darray.h"
 
 #include <windows.h>
 #include <windowsx.h>  // param input extraction
+#include <timeapi.h>   // timeBeginPeriod
 #include <stdlib.h>
+#include <stdio.h>
 
 // For surface creation
 #include <vulkan/vulkan.h>
@@ -24,7 +28,9 @@ typedef struct platform_state {
     HINSTANCE h_instance;
     HWND hwnd;
     VkSurfaceKHR surface;
-
+    // Indicates if the window is shown and not minimized, and if it has focus.
+    b8 is_visible;
+    b8 has_focus;
 } platform_state;
 
 static platform_state *state_ptr;
@@ -56,6 +62,9 @@ b8 platform_system_startup(
     }
     state_ptr = state;
     state_ptr->h_instance = GetModuleHandleA(0);
+    // The application starts out treating the window as visible and focused.
+    state_ptr->is_visible = true;
+    state_ptr->has_focus = true;
 
     // Setup and register window class.
     HICON icon = LoadIcon(state_ptr->h_instance, IDI_APPLICATION);
@@ -127,6 +136,16 @@ b8 platform_system_startup(
     // If initially maximized, use SW_SHOWMAXIMIZED : SW_MAXIMIZE
     ShowWindow(state_ptr->hwnd, show_window_command_flags);
 
+    // Raw mouse motion (WM_INPUT), for the unaccelerated, full-rate deltas of high polling rate mice.
+    // Delivered only while the window is in the foreground.
+    RAWINPUTDEVICE mouse_device = {};
+    mouse_device.usUsagePage = 0x01;  // Generic desktop controls
+    mouse_device.usUsage = 0x02;      // Mouse
+    mouse_device.hwndTarget = state_ptr->hwnd;
+    if (!RegisterRawInputDevices(&mouse_device, 1, sizeof(RAWINPUTDEVICE))) {
+        KINFO("Raw input is not available; raw mouse motion will not be reported.");
+    }
+
     // Clock setup
     clock_setup();
 
@@ -159,6 +178,101 @@ void platform_free(void *block, b8 aligned) {
     free(block);
 }
 
+// Large pages require the lock memory privilege, which must first be granted to the user by policy.
+static b8 win32_enable_lock_memory_privilege() {
+    HANDLE token;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+        return false;
+    }
+    TOKEN_PRIVILEGES privileges = {0};
+    privileges.PrivilegeCount = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    b8 result = false;
+    if (LookupPrivilegeValueA(0, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid)) {
+        // AdjustTokenPrivileges succeeds even if the privilege is not held, so check the error too.
+        result = AdjustTokenPrivileges(token, FALSE, &privileges, 0, 0, 0) && GetLastError() == ERROR_SUCCESS;
+    }
+    CloseHandle(token);
+    return result;
+}
+
+b8 platform_allocate_pages(u64 size, u32 flags, platform_page_block *out_block) {
+    if (!out_block || size == 0) {
+        return false;
+    }
+    out_block->memory = 0;
+
+    b8 node_local = (flags & PLATFORM_PAGE_FLAG_NODE_LOCAL) != 0;
+    USHORT node = 0;
+    if (node_local) {
+        PROCESSOR_NUMBER processor;
+        GetCurrentProcessorNumberEx(&processor);
+        if (!GetNumaProcessorNodeEx(&processor, &node)) {
+            node_local = false;
+        }
+    }
+
+    // NOTE: Windows large pages are 2MiB. 1GiB pages are only available to drivers, so 2MiB is used for both.
+    if (flags & (PLATFORM_PAGE_FLAG_HUGE_1GB | PLATFORM_PAGE_FLAG_HUGE_2MB)) {
+        SIZE_T large_page_size = GetLargePageMinimum();
+        if (large_page_size && win32_enable_lock_memory_privilege()) {
+            out_block->page_size = large_page_size;
+            out_block->size = get_aligned(size, large_page_size);
+            DWORD type = MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES;
+            out_block->memory = node_local
+                                    ? VirtualAllocExNuma(GetCurrentProcess(), 0, out_block->size, type, PAGE_READWRITE, node)
+                                    : VirtualAlloc(0, out_block->size, type, PAGE_READWRITE);
+        }
+    }
+
+    if (!out_block->memory) {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        out_block->page_size = info.dwPageSize;
+        out_block->size = get_aligned(size, out_block->page_size);
+        DWORD type = MEM_RESERVE | MEM_COMMIT;
+        out_block->memory = node_local
+                                ? VirtualAllocExNuma(GetCurrentProcess(), 0, out_block->size, type, PAGE_READWRITE, node)
+                                : VirtualAlloc(0, out_block->size, type, PAGE_READWRITE);
+        if (!out_block->memory) {
+            KERROR("platform_allocate_pages - VirtualAlloc of %llu bytes failed with error %u.", out_block->size, GetLastError());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void platform_free_pages(platform_page_block *block) {
+    if (block && block->memory) {
+        VirtualFree(block->memory, 0, MEM_RELEASE);
+        block->memory = 0;
+        block->size = 0;
+    }
+}
+
+void *platform_reserve_memory(u64 size) {
+    void *memory = VirtualAlloc(0, size, MEM_RESERVE, PAGE_NOACCESS);
+    if (!memory) {
+        KERROR("platform_reserve_memory - VirtualAlloc of %llu bytes failed with error %u.", size, GetLastError());
+    }
+    return memory;
+}
+
+b8 platform_commit_memory(void *memory, u64 size) {
+    if (!VirtualAlloc(memory, size, MEM_COMMIT, PAGE_READWRITE)) {
+        KERROR("platform_commit_memory - VirtualAlloc of %llu bytes failed with error %u.", size, GetLastError());
+        return false;
+    }
+    return true;
+}
+
+void platform_release_memory(void *memory, u64 size) {
+    if (memory) {
+        VirtualFree(memory, 0, MEM_RELEASE);
+    }
+}
+
 void *platform_zero_memory(void *block, u64 size) {
     return memset(block, 0, size);
 }
@@ -167,6 +281,10 @@ void *platform_copy_memory(void *dest, const void *source, u64 size) {
     return memcpy(dest, source, size);
 }
 
+void *platform_move_memory(void *dest, const void *source, u64 size) {
+    return memmove(dest, source, size);
+}
+
 void *platform_set_memory(void *dest, i32 value, u64 size) {
     return memset(dest, value, size);
 }
@@ -207,6 +325,55 @@ void platform_sleep(u64 ms) {
     Sleep(ms);
 }
 
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+// A high-resolution waitable timer for platform_wait_until, where supported (Windows 10 1803+).
+static HANDLE wait_timer = 0;
+static b8 wait_timer_setup_done = false;
+
+static void wait_timer_setup() {
+    wait_timer_setup_done = true;
+    wait_timer = CreateWaitableTimerExW(0, 0, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!wait_timer) {
+        // Older systems; raise the scheduler resolution to 1ms for Sleep instead.
+        timeBeginPeriod(1);
+        KDEBUG("High-resolution waitable timers are not available; waits use 1ms sleeps.");
+    }
+}
+
+void platform_wait_until(f64 target_time) {
+    if (!wait_timer_setup_done) {
+        wait_timer_setup();
+    }
+
+    // How far ahead of the target to stop sleeping and start spinning. Sleep at 1ms resolution can wake
+    // up to a full period late, so spins for longer.
+    f64 spin_seconds = wait_timer ? 0.001 : 0.002;
+    f64 remaining = target_time - platform_get_absolute_time() - spin_seconds;
+    if (remaining > 0) {
+        if (wait_timer) {
+            // Relative due time, in 100ns units.
+            LARGE_INTEGER due_time;
+            due_time.QuadPart = -(LONGLONG)(remaining * 10000000.0);
+            if (SetWaitableTimerEx(wait_timer, &due_time, 0, 0, 0, 0, 0)) {
+                WaitForSingleObject(wait_timer, INFINITE);
+            }
+        } else {
+            Sleep((DWORD)(remaining * 1000.0));
+        }
+    }
+    while (platform_get_absolute_time() < target_time) {
+        YieldProcessor();
+    }
+}
+
+b8 platform_get_present_timing(platform_present_timing *out_timing) {
+    // Not reported by this platform.
+    return false;
+}
+
 i32 platform_get_processor_count() {
     SYSTEM_INFO sysinfo;
     GetSystemInfo(&sysinfo);
@@ -214,6 +381,98 @@ i32 platform_get_processor_count() {
     return sysinfo.dwNumberOfProcessors;
 }
 
+b8 platform_get_cpu_topology(platform_cpu_topology *out_topology) {
+    if (!out_topology) {
+        return false;
+    }
+    platform_zero_memory(out_topology, sizeof(platform_cpu_topology));
+
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationAll, 0, &length);
+    if (GetLastError() != ERROR_INSUFFICIENT_BUFFER) {
+        KERROR("Unable to query processor information.");
+        return false;
+    }
+    u8 *buffer = platform_allocate(length, false);
+    if (!GetLogicalProcessorInformationEx(RelationAll, (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)buffer, &length)) {
+        KERROR("Unable to query processor information.");
+        platform_free(buffer, false);
+        return false;
+    }
+
+    // NOTE: Only processor group 0 is described, which covers up to 64 logical processors.
+    u8 max_efficiency_class = 0;
+    u8 efficiency_classes[PLATFORM_MAX_PROCESSORS] = {0};
+    for (DWORD offset = 0; offset < length;) {
+        PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX entry = (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)(buffer + offset);
+        if (entry->Relationship == RelationProcessorCore && entry->Processor.GroupMask[0].Group == 0) {
+            u32 core_index = out_topology->physical_count++;
+            b8 primary = true;
+            KAFFINITY mask = entry->Processor.GroupMask[0].Mask;
+            for (u32 i = 0; i < 64 && i < PLATFORM_MAX_PROCESSORS; ++i) {
+                if (mask & ((KAFFINITY)1 << i)) {
+                    platform_processor_info *info = &out_topology->processors[i];
+                    info->index = i;
+                    info->core_index = core_index;
+                    info->is_primary = primary;
+                    primary = false;
+                    efficiency_classes[i] = entry->Processor.EfficiencyClass;
+                    out_topology->logical_count = KMAX(out_topology->logical_count, i + 1);
+                }
+            }
+            max_efficiency_class = KMAX(max_efficiency_class, entry->Processor.EfficiencyClass);
+        } else if (entry->Relationship == RelationNumaNode && entry->NumaNode.GroupMask.Group == 0) {
+            u32 node = entry->NumaNode.NodeNumber;
+            out_topology->numa_node_count = KMAX(out_topology->numa_node_count, node + 1);
+            KAFFINITY mask = entry->NumaNode.GroupMask.Mask;
+            for (u32 i = 0; i < 64 && i < PLATFORM_MAX_PROCESSORS; ++i) {
+                if (mask & ((KAFFINITY)1 << i)) {
+                    out_topology->processors[i].numa_node = node;
+                }
+            }
+        }
+        offset += entry->Size;
+    }
+    platform_free(buffer, false);
+
+    // On hybrid CPUs, performance cores report a higher efficiency class than efficiency cores.
+    out_topology->is_hybrid = max_efficiency_class > 0;
+    for (u32 i = 0; i < out_topology->logical_count; ++i) {
+        platform_processor_info *info = &out_topology->processors[i];
+        info->is_efficiency = efficiency_classes[i] < max_efficiency_class;
+        if (!info->is_efficiency && info->is_primary) {
+            out_topology->performance_count++;
+        }
+    }
+    out_topology->numa_node_count = KMAX(out_topology->numa_node_count, 1);
+    out_topology->has_processor_info = true;
+    return true;
+}
+
+u32 platform_stack_capture(u32 skip, u32 max_frames, void **out_frames) {
+    // One more frame is skipped, for this function.
+    return CaptureStackBackTrace(skip + 1, KMIN(max_frames, PLATFORM_MAX_STACK_FRAMES), out_frames, 0);
+}
+
+b8 platform_stack_frame_describe(void *address, char *out_buffer, u32 buffer_size) {
+    // NOTE: Without debug symbols loaded, frames are given as the module and an offset into it.
+    HMODULE module = 0;
+    if (!GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT, (LPCSTR)address, &module)) {
+        snprintf(out_buffer, buffer_size, "%p", address);
+        return true;
+    }
+    char path[MAX_PATH];
+    DWORD length = GetModuleFileNameA(module, path, MAX_PATH);
+    const char *name = path;
+    for (DWORD i = 0; i < length; ++i) {
+        if (path[i] == '\\' || path[i] == '/') {
+            name = &path[i + 1];
+        }
+    }
+    snprintf(out_buffer, buffer_size, "%s+0x%llx", length ? name : "<unknown>", (u64)((u8 *)address - (u8 *)module));
+    return true;
+}
+
 // NOTE: Begin threads
 b8 kthread_create(pfn_thread_start start_function_ptr, void *params, b8 auto_detach, kthread *out_thread) {
     if (!start_function_ptr) {
@@ -278,6 +537,17 @@ void kthread_sleep(kthread *thread, u64 ms) {
     platform_sleep(ms);
 }
 
+b8 kthread_set_affinity(kthread *thread, u64 affinity_mask) {
+    if (!thread || !thread->internal_data || affinity_mask == 0) {
+        return false;
+    }
+    if (SetThreadAffinityMask(thread->internal_data, (DWORD_PTR)affinity_mask) == 0) {
+        KERROR("Failed to set thread affinity.");
+        return false;
+    }
+    return true;
+}
+
 u64 get_thread_id() {
     return (u64)GetCurrentThreadId();
 }
@@ -339,6 +609,116 @@ b8 kmutex_unlock(kmutex *mutex) {
 
 // NOTE: End mutexes.
 
+// NOTE: Begin semaphores
+b8 ksemaphore_create(ksemaphore *out_semaphore, u32 max_count, u32 start_count) {
+    if (!out_semaphore) {
+        return false;
+    }
+
+    out_semaphore->internal_data = CreateSemaphore(0, start_count, max_count, 0);
+    if (!out_semaphore->internal_data) {
+        KERROR("Unable to create semaphore.");
+        return false;
+    }
+    return true;
+}
+
+void ksemaphore_destroy(ksemaphore *semaphore) {
+    if (semaphore && semaphore->internal_data) {
+        CloseHandle(semaphore->internal_data);
+        semaphore->internal_data = 0;
+    }
+}
+
+b8 ksemaphore_signal(ksemaphore *semaphore) {
+    if (!semaphore || !semaphore->internal_data) {
+        return false;
+    }
+    // NOTE: Fails if the max count would be exceeded.
+    return ReleaseSemaphore(semaphore->internal_data, 1, 0) != 0;
+}
+
+b8 ksemaphore_wait(ksemaphore *semaphore, u64 timeout_ms) {
+    if (!semaphore || !semaphore->internal_data) {
+        return false;
+    }
+
+    DWORD result = WaitForSingleObject(semaphore->internal_data, timeout_ms == KSEMAPHORE_WAIT_INFINITE ? INFINITE : (DWORD)timeout_ms);
+    switch (result) {
+        case WAIT_OBJECT_0:
+            return true;
+        case WAIT_TIMEOUT:
+            return false;
+        default:
+            KERROR("Semaphore wait failed.");
+            return false;
+    }
+}
+// NOTE: End semaphores.
+
+// NOTE: Begin fibers
+typedef struct win32_fiber {
+    LPVOID handle;
+    // Indicates the fiber was converted from a thread, rather than created.
+    b8 from_thread;
+} win32_fiber;
+
+b8 kfiber_create(pfn_fiber_start start_function_ptr, void *params, u64 stack_size, kfiber *out_fiber) {
+    if (!start_function_ptr || !out_fiber || stack_size == 0) {
+        return false;
+    }
+
+    LPVOID handle = CreateFiber((SIZE_T)stack_size, (LPFIBER_START_ROUTINE)start_function_ptr, params);
+    if (!handle) {
+        KERROR("Unable to create fiber.");
+        return false;
+    }
+    win32_fiber *fiber = platform_allocate(sizeof(win32_fiber), false);
+    fiber->handle = handle;
+    fiber->from_thread = false;
+    out_fiber->internal_data = fiber;
+    return true;
+}
+
+b8 kfiber_create_from_thread(kfiber *out_fiber) {
+    if (!out_fiber) {
+        return false;
+    }
+
+    LPVOID handle = ConvertThreadToFiber(0);
+    if (!handle) {
+        KERROR("Unable to convert thread to fiber.");
+        return false;
+    }
+    win32_fiber *fiber = platform_allocate(sizeof(win32_fiber), false);
+    fiber->handle = handle;
+    fiber->from_thread = true;
+    out_fiber->internal_data = fiber;
+    return true;
+}
+
+void kfiber_destroy(kfiber *fiber) {
+    if (fiber && fiber->internal_data) {
+        win32_fiber *internal = (win32_fiber *)fiber->internal_data;
+        if (internal->from_thread) {
+            ConvertFiberToThread();
+        } else {
+            DeleteFiber(internal->handle);
+        }
+        platform_free(internal, false);
+        fiber->internal_data = 0;
+    }
+}
+
+void kfiber_switch(kfiber *current, kfiber *target) {
+    if (!current || !current->internal_data || !target || !target->internal_data) {
+        KERROR("kfiber_switch requires two valid fibers.");
+        return;
+    }
+    SwitchToFiber(((win32_fiber *)target->internal_data)->handle);
+}
+// NOTE: End fibers.
+
 void platform_get_required_extension_names(const char ***names_darray) {
     darray_push(*names_darray, &"VK_KHR_win32_surface");
 }
@@ -362,6 +742,19 @@ b8 platform_create_vulkan_surface(vulkan_context *context) {
     return true;
 }
 
+// Fires EVENT_CODE_WINDOW_VISIBILITY_CHANGED if the window's visibility or focus differs from what was last reported.
+static void win32_visibility_report(b8 visible, b8 focus) {
+    if (!state_ptr || (visible == state_ptr->is_visible && focus == state_ptr->has_focus)) {
+        return;
+    }
+    state_ptr->is_visible = visible;
+    state_ptr->has_focus = focus;
+    event_context context = {};
+    context.data.u8[0] = visible;
+    context.data.u8[1] = focus;
+    event_fire(EVENT_CODE_WINDOW_VISIBILITY_CHANGED, 0, context);
+}
+
 LRESULT CALLBACK win32_process_message(HWND hwnd, u32 msg, WPARAM w_param, LPARAM l_param) {
     switch (msg) {
         case WM_ERASEBKGND:
@@ -388,7 +781,21 @@ LRESULT CALLBACK win32_process_message(HWND hwnd, u32 msg, WPARAM w_param, LPARA
             context.data.u16[0] = (u16)width;
             context.data.u16[1] = (u16)height;
             event_fire(EVENT_CODE_RESIZED, 0, context);
+
+            if (state_ptr) {
+                win32_visibility_report(w_param != SIZE_MINIMIZED, state_ptr->has_focus);
+            }
         } break;
+        case WM_SHOWWINDOW:
+            if (state_ptr) {
+                win32_visibility_report(w_param != FALSE, state_ptr->has_focus);
+            }
+            break;
+        case WM_ACTIVATEAPP:
+            if (state_ptr) {
+                win32_visibility_report(state_ptr->is_visible, w_param != FALSE);
+            }
+            break;
         case WM_KEYDOWN:
         case WM_SYSKEYDOWN:
         case WM_KEYUP:
@@ -426,6 +833,14 @@ LRESULT CALLBACK win32_process_message(HWND hwnd, u32 msg, WPARAM w_param, LPARA
             // Pass over to the input subsystem.
             input_process_mouse_move(x_position, y_position);
         } break;
+        case WM_INPUT: {
+            RAWINPUT raw;
+            UINT size = sizeof(RAWINPUT);
+            if (GetRawInputData((HRAWINPUT)l_param, RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) != (UINT)-1 &&
+                raw.header.dwType == RIM_TYPEMOUSE && !(raw.data.mouse.usFlags & MOUSE_MOVE_ABSOLUTE)) {
+                input_process_mouse_raw_move(raw.data.mouse.lLastX, raw.data.mouse.lLastY);
+            }
+        } break;
         case WM_MOUSEWHEEL: {
             i32 z_delta = GET_WHEEL_DELTA_WPARAM(w_param);
             if (z_delta != 0) {
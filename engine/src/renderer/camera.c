@@ -12,8 +12,15 @@ void camera_reset(camera* c) {
     if (c) {
         c->euler_rotation = vec3_zero();
         c->position = vec3_zero();
-        c->is_dirty = false;
         c->view_matrix = mat4_identity();
+        c->fov = CAMERA_DEFAULT_FOV;
+        c->aspect_ratio = 16.0f / 9.0f;
+        c->near_clip = CAMERA_DEFAULT_NEAR_CLIP;
+        c->far_clip = CAMERA_DEFAULT_FAR_CLIP;
+        // Built on first use.
+        c->is_dirty = true;
+        c->projection_dirty = true;
+        c->generation = 0;
     }
 }
 
@@ -45,22 +52,82 @@ void camera_rotation_euler_set(camera* c, vec3 rotation) {
     }
 }
 
+// Rebuilds whatever changed along with everything derived from it.
+static void camera_update(camera* c) {
+    if (!c->is_dirty && !c->projection_dirty) {
+        return;
+    }
+
+    if (c->is_dirty) {
+        mat4 rotation = mat4_euler_xyz(c->euler_rotation.x, c->euler_rotation.y, c->euler_rotation.z);
+        mat4 translation = mat4_translation(c->position);
+
+        c->view_matrix = mat4_mul(rotation, translation);
+        c->view_matrix = mat4_inverse(c->view_matrix);
+    }
+    if (c->projection_dirty) {
+        c->projection_matrix = mat4_perspective(c->fov, c->aspect_ratio, c->near_clip, c->far_clip);
+    }
+
+    c->view_projection = mat4_mul(c->view_matrix, c->projection_matrix);
+    vec3 forward = mat4_forward(c->view_matrix);
+    vec3 right = mat4_right(c->view_matrix);
+    vec3 up = mat4_up(c->view_matrix);
+    c->view_frustum = frustom_create(&c->position, &forward, &right, &up, c->aspect_ratio, c->fov, c->near_clip, c->far_clip);
+
+    c->is_dirty = false;
+    c->projection_dirty = false;
+    c->generation++;
+}
+
 mat4 camera_view_get(camera* c) {
     if (c) {
-        if (c->is_dirty) {
-            mat4 rotation = mat4_euler_xyz(c->euler_rotation.x, c->euler_rotation.y, c->euler_rotation.z);
-            mat4 translation = mat4_translation(c->position);
+        camera_update(c);
+        return c->view_matrix;
+    }
+    return mat4_identity();
+}
 
-            c->view_matrix = mat4_mul(rotation, translation);
-            c->view_matrix = mat4_inverse(c->view_matrix);
+void camera_perspective_set(camera* c, f32 fov, f32 near_clip, f32 far_clip) {
+    if (c) {
+        c->fov = fov;
+        c->near_clip = near_clip;
+        c->far_clip = far_clip;
+        c->projection_dirty = true;
+    }
+}
 
-            c->is_dirty = false;
-        }
-        return c->view_matrix;
+void camera_aspect_set(camera* c, f32 aspect_ratio) {
+    if (c && c->aspect_ratio != aspect_ratio) {
+        c->aspect_ratio = aspect_ratio;
+        c->projection_dirty = true;
+    }
+}
+
+mat4 camera_projection_get(camera* c) {
+    if (c) {
+        camera_update(c);
+        return c->projection_matrix;
     }
     return mat4_identity();
 }
 
+mat4 camera_view_projection_get(camera* c) {
+    if (c) {
+        camera_update(c);
+        return c->view_projection;
+    }
+    return mat4_identity();
+}
+
+const frustum* camera_frustum_get(camera* c) {
+    if (c) {
+        camera_update(c);
+        return &c->view_frustum;
+    }
+    return 0;
+}
+
 vec3 camera_forward(camera* c) {
     if (c) {
         mat4 view = camera_view_get(c);
@@ -1,7 +1,10 @@
 /**
  * @file camera.h
  * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
- * @brief 
+ * @brief A camera, with its view, projection and frustum cached.
+ * @details The view, projection, view-projection and frustum of a camera are rebuilt together, and
+ * only when the camera has moved or its projection changed since they were last obtained, so every
+ * view of a camera and the culling done for it share one set of up-to-date values.
  * @version 1.0
  * @date 2026-01-30
  * 
@@ -33,15 +36,46 @@ typedef struct camera {
     vec3 euler_rotation;
     /** @brief Internal flag used to determine when the view matrix needs to be rebuilt. */
     b8 is_dirty;
+    /** @brief Internal flag used to determine when the projection matrix needs to be rebuilt. */
+    b8 projection_dirty;
+
+    /**
+     * @brief The vertical field of view of this camera, in radians.
+     * NOTE: Do not set this directly, use camera_perspective_set() instead
+     * so the projection matrix is recalculated when needed.
+     */
+    f32 fov;
+    /** @brief The aspect ratio of this camera. Set with camera_aspect_set(). */
+    f32 aspect_ratio;
+    /** @brief The distance to the near clipping plane. Set with camera_perspective_set(). */
+    f32 near_clip;
+    /** @brief The distance to the far clipping plane. Set with camera_perspective_set(). */
+    f32 far_clip;
+
+    /** @brief Advanced every time the view or projection is rebuilt, so anything derived from them can tell when to follow. */
+    u32 generation;
 
     /**
      * @brief The view matrix of this camera.
      * NOTE: IMPORTANT: Do not get this directly, use camera_view_get() instead
-     * so the view matrix is recalculated when needed.
+     * so the view matrix is recalculated when needed. The same goes for the cached values below.
      */
     mat4 view_matrix;
+    /** @brief The projection matrix of this camera. Use camera_projection_get(). */
+    mat4 projection_matrix;
+    /** @brief The view matrix multiplied by the projection matrix. Use camera_view_projection_get(). */
+    mat4 view_projection;
+    /** @brief The frustum of this camera in world space. Use camera_frustum_get(). */
+    frustum view_frustum;
 } camera;
 
+/** @brief The default vertical field of view of a camera, in radians (45 degrees). */
+#define CAMERA_DEFAULT_FOV 0.785398163f
+/** @brief The default distance to the near clipping plane of a camera. */
+#define CAMERA_DEFAULT_NEAR_CLIP 0.1f
+/** @brief The default distance to the far clipping plane of a camera. */
+#define CAMERA_DEFAULT_FAR_CLIP 1000.0f
+
 /**
  * @brief Creates a new camera with default zero position
  * and rotation, and view identity matrix. Ideally, the
@@ -54,7 +88,8 @@ KAPI camera camera_create();
 
 /**
  * @brief Defaults the provided camera to default zero
- * rotation and position, and view matrix to identity.
+ * rotation and position, view matrix to identity, and the
+ * default perspective with a 16:9 aspect ratio.
  *
  * @param c A pointer to the camera to be reset.
  */
@@ -101,6 +136,50 @@ KAPI void camera_rotation_euler_set(camera* c, vec3 rotation);
  */
 KAPI mat4 camera_view_get(camera* c);
 
+/**
+ * @brief Sets the provided camera's perspective projection.
+ *
+ * @param c A pointer to a camera.
+ * @param fov The vertical field of view, in radians.
+ * @param near_clip The distance to the near clipping plane.
+ * @param far_clip The distance to the far clipping plane.
+ */
+KAPI void camera_perspective_set(camera* c, f32 fov, f32 near_clip, f32 far_clip);
+
+/**
+ * @brief Sets the provided camera's aspect ratio, typically when what it is viewed in is resized.
+ * Nothing is rebuilt if it is unchanged.
+ *
+ * @param c A pointer to a camera.
+ * @param aspect_ratio The aspect ratio, width over height.
+ */
+KAPI void camera_aspect_set(camera* c, f32 aspect_ratio);
+
+/**
+ * @brief Obtains a copy of the camera's projection matrix, rebuilt first if it changed.
+ *
+ * @param c A pointer to a camera.
+ * @return A copy of the up-to-date projection matrix.
+ */
+KAPI mat4 camera_projection_get(camera* c);
+
+/**
+ * @brief Obtains a copy of the camera's view matrix multiplied by its projection matrix,
+ * rebuilt first if the camera changed.
+ *
+ * @param c A pointer to a camera.
+ * @return A copy of the up-to-date view-projection matrix.
+ */
+KAPI mat4 camera_view_projection_get(camera* c);
+
+/**
+ * @brief Obtains the camera's frustum in world space, rebuilt first if the camera changed.
+ *
+ * @param c A pointer to a camera.
+ * @return A constant pointer to the up-to-date frustum, valid until the camera next changes.
+ */
+KAPI const frustum* camera_frustum_get(camera* c);
+
 /**
  * @brief Returns a copy of the camera's forward vector.
  *
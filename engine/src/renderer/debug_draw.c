@@ -0,0 +1,198 @@
+#include "debug_draw.h"
+
+#if defined(KDEBUG_DRAW_ENABLED)
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "math/kmath.h"
+#include "memory/linear_allocator.h"
+
+typedef struct debug_draw_state {
+    b8 enabled;
+    // The most vertices of each kind of primitive.
+    u32 vertex_capacity;
+    // The vertices of each kind, each of vertex_capacity.
+    debug_vertex* vertices[DEBUG_DRAW_PRIMITIVE_COUNT];
+    u32 vertex_counts[DEBUG_DRAW_PRIMITIVE_COUNT];
+    u32 dropped_count;
+} debug_draw_state;
+
+static debug_draw_state* state_ptr;
+
+b8 debug_draw_initialize(u32 vertex_capacity, u64* memory_requirement, void* state) {
+    if (vertex_capacity == 0) {
+        KERROR("debug_draw_initialize requires a non-zero vertex capacity.");
+        return false;
+    }
+    if (!memory_requirement) {
+        KERROR("debug_draw_initialize requires memory_requirement to exist.");
+        return false;
+    }
+
+    // The state, then the vertices of each kind of primitive.
+    u64 vertices_requirement = sizeof(debug_vertex) * vertex_capacity;
+    *memory_requirement = sizeof(debug_draw_state) + vertices_requirement * DEBUG_DRAW_PRIMITIVE_COUNT;
+
+    if (!state) {
+        return true;
+    }
+
+    state_ptr = state;
+    kzero_memory(state_ptr, sizeof(debug_draw_state));
+    state_ptr->vertex_capacity = vertex_capacity;
+    for (u32 i = 0; i < DEBUG_DRAW_PRIMITIVE_COUNT; ++i) {
+        state_ptr->vertices[i] = (debug_vertex*)((u8*)state + sizeof(debug_draw_state) + vertices_requirement * i);
+    }
+    return true;
+}
+
+void debug_draw_shutdown(void* state) {
+    if (state) {
+        kzero_memory(state, sizeof(debug_draw_state));
+    }
+    state_ptr = 0;
+}
+
+void debug_draw_enabled_set(b8 enabled) {
+    if (!state_ptr) {
+        return;
+    }
+    state_ptr->enabled = enabled;
+    if (!enabled) {
+        kzero_memory(state_ptr->vertex_counts, sizeof(state_ptr->vertex_counts));
+        state_ptr->dropped_count = 0;
+    }
+}
+
+b8 debug_draw_enabled(void) {
+    return state_ptr && state_ptr->enabled;
+}
+
+// Makes room for the given number of vertices of the given kind, returning them, or 0 if drawing is
+// off or they do not fit, in which case the primitive is dropped whole.
+static debug_vertex* vertices_add(debug_draw_primitive type, u32 count) {
+    if (!state_ptr || !state_ptr->enabled) {
+        return 0;
+    }
+    u32 first = state_ptr->vertex_counts[type];
+    if (first + count > state_ptr->vertex_capacity) {
+        state_ptr->dropped_count++;
+        return 0;
+    }
+    state_ptr->vertex_counts[type] = first + count;
+    return &state_ptr->vertices[type][first];
+}
+
+static void segment_write(debug_vertex* vertices, vec3 start, vec3 end, vec4 colour) {
+    vertices[0].position = start;
+    vertices[0].colour = colour;
+    vertices[1].position = end;
+    vertices[1].colour = colour;
+}
+
+// Writes the 12 edges between the given corners, indexed by their bits: x in the first, y in the second and z in the third.
+static void box_edges_write(debug_vertex* vertices, const vec3 corners[8], vec4 colour) {
+    u32 segment = 0;
+    for (u32 c = 0; c < 8; ++c) {
+        for (u32 axis = 1; axis < 8; axis <<= 1) {
+            if (!(c & axis)) {
+                segment_write(&vertices[segment * 2], corners[c], corners[c | axis], colour);
+                segment++;
+            }
+        }
+    }
+}
+
+void debug_draw_line(vec3 start, vec3 end, vec4 colour) {
+    debug_vertex* vertices = vertices_add(DEBUG_DRAW_PRIMITIVE_LINE, 2);
+    if (vertices) {
+        segment_write(vertices, start, end, colour);
+    }
+}
+
+void debug_draw_aabb(extents_3d extents, vec4 colour) {
+    debug_vertex* vertices = vertices_add(DEBUG_DRAW_PRIMITIVE_BOX, 24);
+    if (!vertices) {
+        return;
+    }
+    vec3 corners[8];
+    for (u32 c = 0; c < 8; ++c) {
+        corners[c] = (vec3){
+            (c & 1) ? extents.max.x : extents.min.x,
+            (c & 2) ? extents.max.y : extents.min.y,
+            (c & 4) ? extents.max.z : extents.min.z};
+    }
+    box_edges_write(vertices, corners, colour);
+}
+
+void debug_draw_sphere(bounding_sphere sphere, vec4 colour) {
+    debug_vertex* vertices = vertices_add(DEBUG_DRAW_PRIMITIVE_SPHERE, DEBUG_DRAW_SPHERE_SEGMENTS * 2 * 3);
+    if (!vertices) {
+        return;
+    }
+    vec3 c = sphere.center;
+    f32 r = sphere.radius;
+    f32 step = K_PI_2 / DEBUG_DRAW_SPHERE_SEGMENTS;
+    for (u32 i = 0; i < DEBUG_DRAW_SPHERE_SEGMENTS; ++i) {
+        f32 s0 = ksin(step * i) * r;
+        f32 c0 = kcos(step * i) * r;
+        f32 s1 = ksin(step * (i + 1)) * r;
+        f32 c1 = kcos(step * (i + 1)) * r;
+        // Around z, then y, then x.
+        segment_write(&vertices[i * 6], (vec3){c.x + c0, c.y + s0, c.z}, (vec3){c.x + c1, c.y + s1, c.z}, colour);
+        segment_write(&vertices[i * 6 + 2], (vec3){c.x + c0, c.y, c.z + s0}, (vec3){c.x + c1, c.y, c.z + s1}, colour);
+        segment_write(&vertices[i * 6 + 4], (vec3){c.x, c.y + c0, c.z + s0}, (vec3){c.x, c.y + c1, c.z + s1}, colour);
+    }
+}
+
+void debug_draw_frustum(mat4 view_projection, vec4 colour) {
+    debug_vertex* vertices = vertices_add(DEBUG_DRAW_PRIMITIVE_FRUSTUM, 24);
+    if (!vertices) {
+        return;
+    }
+    // The corners of clip space, taken back to world space.
+    mat4 inverse = mat4_inverse(view_projection);
+    vec3 corners[8];
+    for (u32 c = 0; c < 8; ++c) {
+        vec4 clip = {(c & 1) ? 1.0f : -1.0f, (c & 2) ? 1.0f : -1.0f, (c & 4) ? 1.0f : -1.0f, 1.0f};
+        vec4 world = vec4_mul_mat4(clip, inverse);
+        corners[c] = (vec3){world.x / world.w, world.y / world.w, world.z / world.w};
+    }
+    box_edges_write(vertices, corners, colour);
+}
+
+b8 debug_draw_take(struct linear_allocator* allocator, debug_draw_packet_data* out_data) {
+    kzero_memory(out_data, sizeof(debug_draw_packet_data));
+    if (!state_ptr) {
+        return true;
+    }
+
+    u32 total = 0;
+    for (u32 i = 0; i < DEBUG_DRAW_PRIMITIVE_COUNT; ++i) {
+        total += state_ptr->vertex_counts[i];
+    }
+    out_data->dropped_count = state_ptr->dropped_count;
+    state_ptr->dropped_count = 0;
+    if (total == 0) {
+        return true;
+    }
+
+    b8 result = true;
+    out_data->vertices = linear_allocator_allocate(allocator, sizeof(debug_vertex) * total);
+    if (out_data->vertices) {
+        for (u32 i = 0; i < DEBUG_DRAW_PRIMITIVE_COUNT; ++i) {
+            u32 count = state_ptr->vertex_counts[i];
+            out_data->first_vertex[i] = out_data->vertex_count;
+            out_data->vertex_counts[i] = count;
+            kcopy_memory(out_data->vertices + out_data->vertex_count, state_ptr->vertices[i], sizeof(debug_vertex) * count);
+            out_data->vertex_count += count;
+        }
+    } else {
+        KWARN("debug_draw_take - failed to allocate %u vertices. Dropping them.", total);
+        result = false;
+    }
+    kzero_memory(state_ptr->vertex_counts, sizeof(state_ptr->vertex_counts));
+    return result;
+}
+
+#endif
@@ -0,0 +1,153 @@
+/**
+ * @file debug_draw.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Immediate mode drawing of lines, boxes, spheres and frusta, for seeing such things as the
+ * bounds geometry is culled by, without adding geometry to the world.
+ * @details What is drawn is gathered as lines, from wherever on the main thread, into one array of
+ * vertices for each kind of primitive, and drawn by the debug view the next frame, with one draw for
+ * each kind, depth tested against the world. Everything gathered is dropped once drawn, so is drawn
+ * again each frame it is wanted. Drawing may be turned on and off while running; while off, nothing
+ * is gathered, so calls cost next to nothing. Only compiled into debug builds, where
+ * KDEBUG_DRAW_ENABLED is defined; elsewhere the calls are compiled out, along with their arguments.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "math/math_types.h"
+
+struct linear_allocator;
+
+#if defined(_DEBUG)
+/** @brief Defined where debug drawing is compiled in. */
+#define KDEBUG_DRAW_ENABLED
+#endif
+
+/** @brief The kinds of primitive drawn, each with its own draw. */
+typedef enum debug_draw_primitive {
+    DEBUG_DRAW_PRIMITIVE_LINE,
+    DEBUG_DRAW_PRIMITIVE_BOX,
+    DEBUG_DRAW_PRIMITIVE_SPHERE,
+    DEBUG_DRAW_PRIMITIVE_FRUSTUM,
+    DEBUG_DRAW_PRIMITIVE_COUNT
+} debug_draw_primitive;
+
+/** @brief The number of segments of each of the three circles a sphere is drawn with. */
+#define DEBUG_DRAW_SPHERE_SEGMENTS 24
+
+/** @brief A vertex of a debug line. */
+typedef struct debug_vertex {
+    /** @brief The position, in world space. */
+    vec3 position;
+    /** @brief The colour. */
+    vec4 colour;
+} debug_vertex;
+
+/** @brief The packet data of the debug view: what was gathered for a frame, every kind one after another. */
+typedef struct debug_draw_packet_data {
+    /** @brief The number of vertices. */
+    u32 vertex_count;
+    /** @brief The vertices of every kind of primitive, in the order of debug_draw_primitive. */
+    debug_vertex* vertices;
+    /** @brief The first vertex of each kind of primitive. */
+    u32 first_vertex[DEBUG_DRAW_PRIMITIVE_COUNT];
+    /** @brief The number of vertices of each kind of primitive. */
+    u32 vertex_counts[DEBUG_DRAW_PRIMITIVE_COUNT];
+    /** @brief The number of primitives dropped, as the vertices of their kind were full. */
+    u32 dropped_count;
+} debug_draw_packet_data;
+
+#if defined(KDEBUG_DRAW_ENABLED)
+
+/**
+ * @brief Initializes debug drawing, turned off. Should be called twice; once to obtain the memory
+ * amount required (passing state=0), and a second time with state being set to an allocated block.
+ *
+ * @param vertex_capacity The most vertices gathered for each kind of primitive each frame.
+ * @param memory_requirement A pointer to hold the required memory.
+ * @param state An allocated block of memory, or 0 if just obtaining the requirement.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 debug_draw_initialize(u32 vertex_capacity, u64* memory_requirement, void* state);
+
+/**
+ * @brief Shuts debug drawing down. The memory passed at initialization is not freed. Anything drawn
+ * after is dropped.
+ *
+ * @param state The block of memory passed at initialization.
+ */
+KAPI void debug_draw_shutdown(void* state);
+
+/**
+ * @brief Turns debug drawing on or off. Anything gathered is dropped when turned off.
+ *
+ * @param enabled True to draw; false to not.
+ */
+KAPI void debug_draw_enabled_set(b8 enabled);
+
+/**
+ * @brief Indicates if debug drawing is initialized and turned on.
+ *
+ * @return True if what is drawn is gathered; otherwise false.
+ */
+KAPI b8 debug_draw_enabled(void);
+
+/**
+ * @brief Draws a line.
+ *
+ * @param start The start of the line, in world space.
+ * @param end The end of the line, in world space.
+ * @param colour The colour.
+ */
+KAPI void debug_draw_line(vec3 start, vec3 end, vec4 colour);
+
+/**
+ * @brief Draws the edges of an axis-aligned box.
+ *
+ * @param extents The box, in world space.
+ * @param colour The colour.
+ */
+KAPI void debug_draw_aabb(extents_3d extents, vec4 colour);
+
+/**
+ * @brief Draws a sphere, as a circle around each of its axes.
+ *
+ * @param sphere The sphere, in world space.
+ * @param colour The colour.
+ */
+KAPI void debug_draw_sphere(bounding_sphere sphere, vec4 colour);
+
+/**
+ * @brief Draws the edges of the frustum of the given view and projection, as where its near and far
+ * planes meet its sides.
+ *
+ * @param view_projection The view matrix multiplied by the projection matrix of the frustum.
+ * @param colour The colour.
+ */
+KAPI void debug_draw_frustum(mat4 view_projection, vec4 colour);
+
+/**
+ * @brief Copies what was gathered since the last call into a block taken from the given allocator,
+ * and starts gathering the next frame.
+ *
+ * @param allocator The allocator the vertices are taken from.
+ * @param out_data A pointer to hold what was gathered. Empty when turned off.
+ * @return True on success; false if the vertices could not be allocated, in which case they are dropped.
+ */
+KAPI b8 debug_draw_take(struct linear_allocator* allocator, debug_draw_packet_data* out_data);
+
+#else
+
+#define debug_draw_enabled_set(enabled) ((void)0)
+#define debug_draw_enabled() (false)
+#define debug_draw_line(start, end, colour) ((void)0)
+#define debug_draw_aabb(extents, colour) ((void)0)
+#define debug_draw_sphere(sphere, colour) ((void)0)
+#define debug_draw_frustum(view_projection, colour) ((void)0)
+
+#endif
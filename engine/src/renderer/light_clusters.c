@@ -0,0 +1,229 @@
+#include "light_clusters.h"
+
+#include "core/kmemory.h"
+#include "math/kmath.h"
+#include "systems/job_system.h"
+
+/** @brief The state shared by the jobs filling the clusters of each depth slice. */
+typedef struct light_cluster_job_data {
+    const light_clusters_view* view;
+    light_clusters* clusters;
+    u32 light_count;
+    // Indicates if the lists are filled, rather than the lights of each cluster being counted.
+    b8 fill;
+} light_cluster_job_data;
+
+// The column, row or slice a coordinate from 0 to 1 across the grid lies in, clamped to the grid.
+static u8 cell_get(f32 coordinate, u32 cell_count) {
+    f32 cell = coordinate * cell_count;
+    if (cell < 0.0f) {
+        return 0;
+    }
+    return cell >= (f32)cell_count ? (u8)(cell_count - 1) : (u8)cell;
+}
+
+// The depth slice of a view depth.
+static u8 slice_get(const light_cluster_data* data, f32 depth) {
+    f32 slice = klog(depth) * data->depth_slicing.z + data->depth_slicing.w;
+    if (slice < 0.0f) {
+        return 0;
+    }
+    return slice >= LIGHT_CLUSTERS_Z ? LIGHT_CLUSTERS_Z - 1 : (u8)slice;
+}
+
+// The view depth at which the given slice begins.
+static f32 slice_depth(const light_cluster_data* data, u32 slice) {
+    if (slice == 0) {
+        return data->depth_slicing.x;
+    }
+    if (slice == LIGHT_CLUSTERS_Z) {
+        return data->depth_slicing.y;
+    }
+    return kexp((slice - data->depth_slicing.w) / data->depth_slicing.z);
+}
+
+// The extent along one axis, in view space, of the box around the part of the frustum between two
+// positions on screen and two view depths, given the projection's scale of the axis.
+static void cell_extent(f32 ndc_min, f32 ndc_max, f32 near_depth, f32 far_depth, f32 scale, f32* out_min, f32* out_max) {
+    f32 a = ndc_min * near_depth / scale;
+    f32 b = ndc_min * far_depth / scale;
+    f32 c = ndc_max * near_depth / scale;
+    f32 d = ndc_max * far_depth / scale;
+    *out_min = KMIN(KMIN(a, b), KMIN(c, d));
+    *out_max = KMAX(KMAX(a, b), KMAX(c, d));
+}
+
+// The columns or rows the part of a sphere between two view depths covers on screen, given its
+// centre and radius along the axis and the projection's scale of it. False if none are covered.
+static b8 cells_covered(f32 centre, f32 radius, f32 near_depth, f32 far_depth, f32 scale, u32 cell_count, u8* out_min, u8* out_max) {
+    // The box around the sphere covers the least of position / depth at its nearest depth if the
+    // position is negative there, and at its farthest if not; the most likewise.
+    f32 low = centre - radius;
+    f32 high = centre + radius;
+    f32 low_ndc = scale * low / (low <= 0.0f ? near_depth : far_depth);
+    f32 high_ndc = scale * high / (high >= 0.0f ? near_depth : far_depth);
+    f32 min_ndc = KMIN(low_ndc, high_ndc);
+    f32 max_ndc = KMAX(low_ndc, high_ndc);
+    if (max_ndc < -1.0f || min_ndc > 1.0f) {
+        return false;
+    }
+    *out_min = cell_get(min_ndc * 0.5f + 0.5f, cell_count);
+    *out_max = cell_get(max_ndc * 0.5f + 0.5f, cell_count);
+    return true;
+}
+
+// Works out the clusters the given light may reach.
+static void range_compute(const light_clusters_view* view, const light_cluster_data* data, const point_light* light, light_cluster_range* out_range) {
+    vec3 centre = vec3_transform(light->position, view->view);
+    out_range->sphere = vec4_from_vec3(centre, light->radius);
+    out_range->culled = true;
+
+    // Depth is along -z in view space.
+    f32 depth = -centre.z;
+    if (depth + light->radius < view->near_clip || depth - light->radius > view->far_clip) {
+        return;
+    }
+    f32 near_depth = KMAX(depth - light->radius, view->near_clip);
+    f32 far_depth = KMIN(depth + light->radius, view->far_clip);
+    if (!cells_covered(centre.x, light->radius, near_depth, far_depth, view->projection.data[0], LIGHT_CLUSTERS_X, &out_range->min_x, &out_range->max_x) ||
+        !cells_covered(centre.y, light->radius, near_depth, far_depth, view->projection.data[5], LIGHT_CLUSTERS_Y, &out_range->min_y, &out_range->max_y)) {
+        return;
+    }
+    out_range->min_z = slice_get(data, near_depth);
+    out_range->max_z = slice_get(data, far_depth);
+    out_range->culled = false;
+}
+
+// Indicates if a sphere touches the box of the given bounds.
+static b8 sphere_touches_box(vec4 sphere, vec3 min, vec3 max) {
+    f32 dx = sphere.x < min.x ? min.x - sphere.x : (sphere.x > max.x ? sphere.x - max.x : 0.0f);
+    f32 dy = sphere.y < min.y ? min.y - sphere.y : (sphere.y > max.y ? sphere.y - max.y : 0.0f);
+    f32 dz = sphere.z < min.z ? min.z - sphere.z : (sphere.z > max.z ? sphere.z - max.z : 0.0f);
+    return dx * dx + dy * dy + dz * dz <= sphere.w * sphere.w;
+}
+
+// Counts the lights of, or fills the lists of, the clusters of each slice in the given range. Each
+// slice is its own, so safe to run for several ranges at once.
+static void slices_build(u32 start, u32 end, void* user_data) {
+    light_cluster_job_data* job_data = user_data;
+    light_clusters* clusters = job_data->clusters;
+    light_cluster_data* data = &clusters->data;
+    f32 scale_x = job_data->view->projection.data[0];
+    f32 scale_y = job_data->view->projection.data[5];
+    for (u32 z = start; z < end; ++z) {
+        // The number of lights written to each cluster of the slice so far.
+        u32 written[LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y] = {0};
+        u32* slice_clusters = data->clusters[z * LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y];
+        f32 near_depth = slice_depth(data, z);
+        f32 far_depth = slice_depth(data, z + 1);
+
+        // The box around each cluster in view space, which spans it at both of its depths, is made
+        // of the extents of its column and row. Those are the same for every light, so worked out once.
+        f32 column_extents[LIGHT_CLUSTERS_X][2];
+        f32 row_extents[LIGHT_CLUSTERS_Y][2];
+        for (u32 x = 0; x < LIGHT_CLUSTERS_X; ++x) {
+            cell_extent((f32)x / LIGHT_CLUSTERS_X * 2.0f - 1.0f, (f32)(x + 1) / LIGHT_CLUSTERS_X * 2.0f - 1.0f, near_depth, far_depth, scale_x, &column_extents[x][0], &column_extents[x][1]);
+        }
+        for (u32 y = 0; y < LIGHT_CLUSTERS_Y; ++y) {
+            cell_extent((f32)y / LIGHT_CLUSTERS_Y * 2.0f - 1.0f, (f32)(y + 1) / LIGHT_CLUSTERS_Y * 2.0f - 1.0f, near_depth, far_depth, scale_y, &row_extents[y][0], &row_extents[y][1]);
+        }
+
+        for (u32 i = 0; i < job_data->light_count; ++i) {
+            const light_cluster_range* range = &clusters->ranges[i];
+            if (range->culled || z < range->min_z || z > range->max_z) {
+                continue;
+            }
+            for (u32 y = range->min_y; y <= range->max_y; ++y) {
+                vec3 box_min = {0.0f, row_extents[y][0], -far_depth};
+                vec3 box_max = {0.0f, row_extents[y][1], -near_depth};
+                for (u32 x = range->min_x; x <= range->max_x; ++x) {
+                    box_min.x = column_extents[x][0];
+                    box_max.x = column_extents[x][1];
+                    if (!sphere_touches_box(range->sphere, box_min, box_max)) {
+                        continue;
+                    }
+
+                    u32 tile = y * LIGHT_CLUSTERS_X + x;
+                    u32* cluster = slice_clusters + tile * 2;
+                    if (!job_data->fill) {
+                        cluster[1]++;
+                    } else if (written[tile] < cluster[1]) {
+                        data->indices[cluster[0] + written[tile]++] = i;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Runs a pass over every slice, across job threads if there are enough lights to be worth it.
+static void slices_run(light_cluster_job_data* job_data) {
+    if (job_data->light_count >= LIGHT_CLUSTERS_PARALLEL_MIN_LIGHTS) {
+        job_system_parallel_for(LIGHT_CLUSTERS_Z, 1, slices_build, job_data);
+    } else {
+        slices_build(0, LIGHT_CLUSTERS_Z, job_data);
+    }
+}
+
+void light_clusters_build(const light_clusters_view* view, const directional_light* directional, u32 point_light_count, const point_light* point_lights, light_clusters* out_clusters) {
+    light_cluster_data* data = &out_clusters->data;
+    u32 light_count = KMIN(point_light_count, LIGHT_CLUSTERS_MAX_LIGHTS);
+    out_clusters->dropped_light_count = point_light_count - light_count;
+    out_clusters->dropped_index_count = 0;
+
+    data->dimensions[0] = LIGHT_CLUSTERS_X;
+    data->dimensions[1] = LIGHT_CLUSTERS_Y;
+    data->dimensions[2] = LIGHT_CLUSTERS_Z;
+    data->dimensions[3] = light_count;
+    f32 log_depth_ratio = klog(view->far_clip / view->near_clip);
+    data->depth_slicing.x = view->near_clip;
+    data->depth_slicing.y = view->far_clip;
+    data->depth_slicing.z = LIGHT_CLUSTERS_Z / log_depth_ratio;
+    data->depth_slicing.w = -LIGHT_CLUSTERS_Z * klog(view->near_clip) / log_depth_ratio;
+    data->directional_direction = vec4_from_vec3(directional->direction, 0.0f);
+    data->directional_colour = directional->colour;
+
+    for (u32 i = 0; i < light_count; ++i) {
+        const point_light* light = &point_lights[i];
+        light_cluster_point_light* target = &data->point_lights[i];
+        target->position_radius = vec4_from_vec3(light->position, light->radius);
+        target->colour = light->colour;
+        target->attenuation = (vec4){light->constant_f, light->linear, light->quadratic, 0.0f};
+        range_compute(view, data, light, &out_clusters->ranges[i]);
+    }
+
+    // The lights of each cluster are counted, the lists laid out one after another, then filled.
+    kzero_memory(data->clusters, sizeof(data->clusters));
+    light_cluster_job_data job_data = {view, out_clusters, light_count, false};
+    slices_run(&job_data);
+
+    u32 offset = 0;
+    for (u32 i = 0; i < LIGHT_CLUSTERS_COUNT; ++i) {
+        u32 count = data->clusters[i][1];
+        u32 kept = KMIN(count, LIGHT_CLUSTERS_MAX_INDICES - offset);
+        out_clusters->dropped_index_count += count - kept;
+        data->clusters[i][0] = offset;
+        data->clusters[i][1] = kept;
+        offset += kept;
+    }
+    out_clusters->index_count = offset;
+
+    job_data.fill = true;
+    slices_run(&job_data);
+}
+
+u32 light_clusters_index(const light_cluster_data* data, const light_clusters_view* view, vec3 view_position) {
+    vec4 clip = vec4_mul_mat4(vec4_from_vec3(view_position, 1.0f), view->projection);
+    u32 x = cell_get((clip.x / clip.w) * 0.5f + 0.5f, LIGHT_CLUSTERS_X);
+    u32 y = cell_get((clip.y / clip.w) * 0.5f + 0.5f, LIGHT_CLUSTERS_Y);
+    u32 z = slice_get(data, KMAX(-view_position.z, data->depth_slicing.x));
+    return (z * LIGHT_CLUSTERS_Y + y) * LIGHT_CLUSTERS_X + x;
+}
+
+u64 light_clusters_lights_size(const light_cluster_data* data) {
+    return (u64)((const u8*)&data->point_lights[data->dimensions[3]] - (const u8*)data);
+}
+
+u64 light_clusters_lists_size(const light_clusters* clusters) {
+    return (u64)((const u8*)&clusters->data.indices[clusters->index_count] - (const u8*)clusters->data.clusters);
+}
@@ -0,0 +1,156 @@
+/**
+ * @file light_clusters.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Assignment of point lights to the clusters of a view frustum, so that each fragment is
+ * lit only by the lights which reach the cluster it lies in.
+ * @details The frustum is split into a grid of clusters: evenly across the screen, and in slices
+ * whose depth grows exponentially from the near clip to the far, so clusters are about as deep as
+ * they are wide. Each light is tested against the clusters its bounding sphere covers on screen and
+ * in depth, and listed in every one it touches. The lists, the lights and the directional light
+ * are laid out as the material shaders read them, in one storage buffer, so the result is uploaded
+ * as it is. The cost of a fragment then grows with the lights near it, not the lights in the scene.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "math/math_types.h"
+#include "systems/light_system.h"
+
+/** @brief The number of clusters across the screen. */
+#define LIGHT_CLUSTERS_X 16
+/** @brief The number of clusters down the screen. */
+#define LIGHT_CLUSTERS_Y 9
+/** @brief The number of depth slices from the near clip to the far. */
+#define LIGHT_CLUSTERS_Z 24
+/** @brief The number of clusters. */
+#define LIGHT_CLUSTERS_COUNT (LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y * LIGHT_CLUSTERS_Z)
+/** @brief The most point lights which are drawn. Any more are left out. */
+#define LIGHT_CLUSTERS_MAX_LIGHTS 1024
+/** @brief The most light indices the lists of all clusters hold together, 32 for each on average. */
+#define LIGHT_CLUSTERS_MAX_INDICES (LIGHT_CLUSTERS_COUNT * 32)
+
+/** @brief The fewest lights for which the clusters are filled across job threads. */
+#define LIGHT_CLUSTERS_PARALLEL_MIN_LIGHTS 64
+
+/** @brief A point light as the shaders read it. */
+typedef struct light_cluster_point_light {
+    /** @brief The position of the light in world space in xyz, and its radius in w. */
+    vec4 position_radius;
+    /** @brief The colour of the light. */
+    vec4 colour;
+    /** @brief The constant, linear and quadratic attenuation of the light in xyz. */
+    vec4 attenuation;
+} light_cluster_point_light;
+
+/**
+ * @brief The lights of a view and the clusters they reach, laid out as an std430 storage buffer,
+ * as the material shaders read them. Only the lights which are used and the indices in the lists
+ * need be uploaded.
+ */
+typedef struct light_cluster_data {
+    /** @brief The number of clusters across, down and in depth, and the number of point lights. */
+    u32 dimensions[4];
+    /**
+     * @brief The near and far clip, then the scale and bias which make the depth slice of a view
+     * depth d: log(d) * scale + bias.
+     */
+    vec4 depth_slicing;
+    /** @brief The direction of the directional light in xyz. */
+    vec4 directional_direction;
+    /** @brief The colour of the directional light. */
+    vec4 directional_colour;
+    /** @brief The point lights. */
+    light_cluster_point_light point_lights[LIGHT_CLUSTERS_MAX_LIGHTS];
+    /**
+     * @brief The offset into indices of the list of each cluster, and the number of lights in it.
+     * Clusters are ordered across, then down, then in depth.
+     */
+    u32 clusters[LIGHT_CLUSTERS_COUNT][2];
+    /** @brief The lists of the clusters: the indices of the point lights in each. */
+    u32 indices[LIGHT_CLUSTERS_MAX_INDICES];
+} light_cluster_data;
+
+/** @brief The clusters a light may reach, worked out from its bounding sphere. Inclusive. */
+typedef struct light_cluster_range {
+    /** @brief The centre of the light in view space in xyz, and its radius in w. */
+    vec4 sphere;
+    u8 min_x, max_x;
+    u8 min_y, max_y;
+    u8 min_z, max_z;
+    /** @brief Indicates if the light is outside the frustum, so reaches no cluster. */
+    b8 culled;
+} light_cluster_range;
+
+/** @brief The lights of a view assigned to its clusters, along with what building them took. */
+typedef struct light_clusters {
+    /** @brief The data read by the shaders. */
+    light_cluster_data data;
+    /** @brief The number of indices used, across the lists of every cluster. */
+    u32 index_count;
+    /** @brief The number of times a light reached a cluster but was left out, as the lists were full. */
+    u32 dropped_index_count;
+    /** @brief The number of point lights left out, beyond LIGHT_CLUSTERS_MAX_LIGHTS. */
+    u32 dropped_light_count;
+    /** @brief The range of clusters each light may reach. */
+    light_cluster_range ranges[LIGHT_CLUSTERS_MAX_LIGHTS];
+} light_clusters;
+
+/** @brief The view the lights are clustered for. */
+typedef struct light_clusters_view {
+    /** @brief The view matrix. */
+    mat4 view;
+    /** @brief The perspective projection matrix, as made by mat4_perspective. */
+    mat4 projection;
+    /** @brief The distance to the near clipping plane. */
+    f32 near_clip;
+    /** @brief The distance to the far clipping plane. */
+    f32 far_clip;
+} light_clusters_view;
+
+/**
+ * @brief Assigns the given lights to the clusters of the given view, filling the lists across job
+ * threads if there are many lights. Each cluster lists its lights in the order they are given. The
+ * lights beyond LIGHT_CLUSTERS_MAX_LIGHTS are left out, as are the lights of clusters whose lists
+ * no longer fit in LIGHT_CLUSTERS_MAX_INDICES, from the last clusters first.
+ *
+ * @param view A pointer to the view.
+ * @param directional A pointer to the directional light.
+ * @param point_light_count The number of point lights.
+ * @param point_lights The point lights.
+ * @param out_clusters A pointer to hold the clusters. Large, so best not kept on the stack.
+ */
+KAPI void light_clusters_build(const light_clusters_view* view, const directional_light* directional, u32 point_light_count, const point_light* point_lights, light_clusters* out_clusters);
+
+/**
+ * @brief Gets the cluster a point in view space lies in, as the shaders work it out.
+ *
+ * @param data A pointer to the clustered data.
+ * @param view A pointer to the view the data was built for.
+ * @param view_position The point in view space, in front of the near clip.
+ * @return The index of the cluster.
+ */
+KAPI u32 light_clusters_index(const light_cluster_data* data, const light_clusters_view* view, vec3 view_position);
+
+/**
+ * @brief Gets the size of the part of the data holding the header and the lights which are used,
+ * which is uploaded from the start of the data.
+ *
+ * @param data A pointer to the clustered data.
+ * @return The size in bytes.
+ */
+KAPI u64 light_clusters_lights_size(const light_cluster_data* data);
+
+/**
+ * @brief Gets the size of the part of the data holding the clusters and the indices which are
+ * used, which is uploaded from the offset of the clusters.
+ *
+ * @param clusters A pointer to the clusters.
+ * @return The size in bytes.
+ */
+KAPI u64 light_clusters_lists_size(const light_clusters* clusters);
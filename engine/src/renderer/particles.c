@@ -0,0 +1,165 @@
+#include "particles.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "memory/linear_allocator.h"
+
+STATIC_ASSERT(sizeof(particle_emitter_data) == 96, "particle_emitter_data must match the std430 layout of the emission shader.");
+
+typedef struct particle_emitter {
+    b8 active;
+    particle_emitter_config config;
+    // The part of a particle its rate has spawned and not yet handed on.
+    f32 accumulator;
+    // Particles asked for on top of its rate, spawned next frame.
+    u32 burst_count;
+} particle_emitter;
+
+typedef struct particles_state {
+    u32 capacity;
+    // Moved on for each emitter spawning, so no two spawn alike.
+    u32 seed;
+    particle_emitter emitters[PARTICLE_MAX_EMITTERS];
+} particles_state;
+
+static particles_state* state_ptr;
+
+b8 particles_initialize(u32 capacity, u64* memory_requirement, void* state) {
+    if (capacity == 0) {
+        KERROR("particles_initialize requires a non-zero capacity.");
+        return false;
+    }
+    if (!memory_requirement) {
+        KERROR("particles_initialize requires memory_requirement to exist.");
+        return false;
+    }
+
+    *memory_requirement = sizeof(particles_state);
+    if (!state) {
+        return true;
+    }
+
+    state_ptr = state;
+    kzero_memory(state_ptr, sizeof(particles_state));
+    state_ptr->capacity = capacity;
+    return true;
+}
+
+void particles_shutdown(void* state) {
+    if (state) {
+        kzero_memory(state, sizeof(particles_state));
+    }
+    state_ptr = 0;
+}
+
+// Returns the given emitter if it exists; otherwise 0.
+static particle_emitter* emitter_get(u32 emitter) {
+    if (!state_ptr || emitter >= PARTICLE_MAX_EMITTERS || !state_ptr->emitters[emitter].active) {
+        return 0;
+    }
+    return &state_ptr->emitters[emitter];
+}
+
+u32 particle_emitter_create(const particle_emitter_config* config) {
+    if (!state_ptr || !config) {
+        KERROR("particle_emitter_create requires particles to be initialized and a valid pointer to a config.");
+        return INVALID_ID;
+    }
+    if (config->lifetime <= 0.0f) {
+        KERROR("particle_emitter_create requires a positive lifetime.");
+        return INVALID_ID;
+    }
+    for (u32 i = 0; i < PARTICLE_MAX_EMITTERS; ++i) {
+        particle_emitter* e = &state_ptr->emitters[i];
+        if (!e->active) {
+            kzero_memory(e, sizeof(particle_emitter));
+            e->active = true;
+            e->config = *config;
+            return i;
+        }
+    }
+    KERROR("particle_emitter_create - no room for more than %u emitters.", PARTICLE_MAX_EMITTERS);
+    return INVALID_ID;
+}
+
+void particle_emitter_destroy(u32 emitter) {
+    particle_emitter* e = emitter_get(emitter);
+    if (e) {
+        kzero_memory(e, sizeof(particle_emitter));
+    }
+}
+
+void particle_emitter_position_set(u32 emitter, vec3 position) {
+    particle_emitter* e = emitter_get(emitter);
+    if (e) {
+        e->config.position = position;
+    }
+}
+
+void particle_emitter_burst(u32 emitter, u32 count) {
+    particle_emitter* e = emitter_get(emitter);
+    if (e) {
+        e->burst_count += count;
+    }
+}
+
+b8 particles_take(f32 delta_time, struct linear_allocator* allocator, particles_packet_data* out_data) {
+    kzero_memory(out_data, sizeof(particles_packet_data));
+    out_data->delta_time = delta_time;
+    if (!state_ptr) {
+        return true;
+    }
+
+    // What each emitter spawns, with the whole frame kept within the capacity.
+    u32 spawn_counts[PARTICLE_MAX_EMITTERS];
+    u32 total = 0;
+    u32 spawning = 0;
+    for (u32 i = 0; i < PARTICLE_MAX_EMITTERS; ++i) {
+        particle_emitter* e = &state_ptr->emitters[i];
+        spawn_counts[i] = 0;
+        if (!e->active) {
+            continue;
+        }
+        if (e->config.rate > 0.0f && delta_time > 0.0f) {
+            e->accumulator += e->config.rate * delta_time;
+        }
+        // Only the fraction of a particle is carried on, so what a long frame drops is not spawned later.
+        u32 whole = (u32)KMIN(e->accumulator, (f32)state_ptr->capacity);
+        e->accumulator -= (f32)(u64)e->accumulator;
+        u32 count = KMIN(whole + e->burst_count, state_ptr->capacity - total);
+        e->burst_count = 0;
+        spawn_counts[i] = count;
+        total += count;
+        spawning += count ? 1 : 0;
+    }
+    if (total == 0) {
+        return true;
+    }
+
+    out_data->emitters = linear_allocator_allocate(allocator, sizeof(particle_emitter_data) * spawning);
+    if (!out_data->emitters) {
+        KWARN("particles_take - failed to allocate %u emitters. Nothing spawns this frame.", spawning);
+        return false;
+    }
+    for (u32 i = 0; i < PARTICLE_MAX_EMITTERS; ++i) {
+        if (!spawn_counts[i]) {
+            continue;
+        }
+        const particle_emitter_config* config = &state_ptr->emitters[i].config;
+        particle_emitter_data* data = &out_data->emitters[out_data->emitter_count++];
+        data->position = config->position;
+        data->spawn_count = spawn_counts[i];
+        data->velocity = config->velocity;
+        data->spread = config->spread;
+        data->acceleration = config->acceleration;
+        data->lifetime = config->lifetime;
+        data->colour_start = config->colour_start;
+        data->colour_end = config->colour_end;
+        data->size_start = config->size_start;
+        data->size_end = config->size_end;
+        data->first_spawn = out_data->spawn_count;
+        data->seed = state_ptr->seed++;
+        out_data->spawn_count += spawn_counts[i];
+    }
+    return true;
+}
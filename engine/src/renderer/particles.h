@@ -0,0 +1,145 @@
+/**
+ * @file particles.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief GPU particles: emitters placed from the CPU, with every particle they emit spawned, simulated,
+ * sorted and drawn on the GPU.
+ * @details The CPU only keeps the emitters, and each frame works out how many particles each of them
+ * spawns, from its rate and any bursts asked for. That is all the particles view is handed. The
+ * particles themselves live in one persistent pool on the GPU, shared by every emitter, which compute
+ * shaders spawn into from a list of free slots, move, and sort back to front for alpha blending, before
+ * they are drawn with a single indirect draw whose count the simulation writes. So however many
+ * particles are alive, none of them costs any CPU time. Emitters are made and moved from the main thread.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "math/math_types.h"
+
+struct linear_allocator;
+
+/** @brief The most emitters which may exist at once. */
+#define PARTICLE_MAX_EMITTERS 64
+
+/** @brief The configuration of an emitter. */
+typedef struct particle_emitter_config {
+    /** @brief The position particles are spawned at, in world space. */
+    vec3 position;
+    /** @brief The velocity particles are spawned with, in world units per second. */
+    vec3 velocity;
+    /** @brief The most each particle's velocity is randomly moved from the velocity, in any direction. */
+    f32 spread;
+    /** @brief The acceleration applied to each particle, such as gravity, in world units per second squared. */
+    vec3 acceleration;
+    /** @brief The number of particles spawned each second. */
+    f32 rate;
+    /** @brief How long each particle lives, in seconds. */
+    f32 lifetime;
+    /** @brief The size of each particle as it is spawned, in world units. */
+    f32 size_start;
+    /** @brief The size of each particle as it dies, in world units. */
+    f32 size_end;
+    /** @brief The colour of each particle as it is spawned. */
+    vec4 colour_start;
+    /** @brief The colour of each particle as it dies. */
+    vec4 colour_end;
+} particle_emitter_config;
+
+/**
+ * @brief An emitter spawning in a frame, as read by the particle emission shader. Laid out to
+ * match its std430 layout.
+ */
+typedef struct particle_emitter_data {
+    vec3 position;
+    /** @brief The number of particles spawned this frame. */
+    u32 spawn_count;
+    vec3 velocity;
+    f32 spread;
+    vec3 acceleration;
+    f32 lifetime;
+    vec4 colour_start;
+    vec4 colour_end;
+    f32 size_start;
+    f32 size_end;
+    /** @brief The number of particles spawned this frame by the emitters before this one. */
+    u32 first_spawn;
+    /** @brief What the randomness of the particles spawned is seeded with, different each frame. */
+    u32 seed;
+} particle_emitter_data;
+
+/** @brief The packet data of the particles view: what is spawned in a frame, and how far it moves on. */
+typedef struct particles_packet_data {
+    /** @brief The time since the last frame, in seconds. */
+    f32 delta_time;
+    /** @brief The number of emitters spawning this frame. */
+    u32 emitter_count;
+    /** @brief The emitters spawning this frame. */
+    particle_emitter_data* emitters;
+    /** @brief The number of particles spawned this frame, by every emitter. */
+    u32 spawn_count;
+} particles_packet_data;
+
+/**
+ * @brief Initializes particles. Should be called twice; once to obtain the memory amount required
+ * (passing state=0), and a second time with state being set to an allocated block.
+ *
+ * @param capacity The most particles alive at once, which caps how many are spawned in a single frame.
+ * @param memory_requirement A pointer to hold the required memory.
+ * @param state An allocated block of memory, or 0 if just obtaining the requirement.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 particles_initialize(u32 capacity, u64* memory_requirement, void* state);
+
+/**
+ * @brief Shuts particles down. The memory passed at initialization is not freed.
+ *
+ * @param state The block of memory passed at initialization.
+ */
+KAPI void particles_shutdown(void* state);
+
+/**
+ * @brief Creates an emitter, which spawns from the next frame on.
+ *
+ * @param config A constant pointer to the configuration of the emitter.
+ * @return The identifier of the emitter; INVALID_ID if there is no room for it.
+ */
+KAPI u32 particle_emitter_create(const particle_emitter_config* config);
+
+/**
+ * @brief Destroys the given emitter. The particles it spawned live out their lifetimes.
+ *
+ * @param emitter The identifier of the emitter.
+ */
+KAPI void particle_emitter_destroy(u32 emitter);
+
+/**
+ * @brief Moves the given emitter. Particles already spawned are not moved.
+ *
+ * @param emitter The identifier of the emitter.
+ * @param position The position particles are spawned at, in world space.
+ */
+KAPI void particle_emitter_position_set(u32 emitter, vec3 position);
+
+/**
+ * @brief Spawns the given number of particles from the given emitter next frame, on top of its rate.
+ *
+ * @param emitter The identifier of the emitter.
+ * @param count The number of particles.
+ */
+KAPI void particle_emitter_burst(u32 emitter, u32 count);
+
+/**
+ * @brief Works out what every emitter spawns over the given time, into a block taken from the given
+ * allocator. Particles which would take the frame past the capacity are dropped.
+ *
+ * @param delta_time The time since the last call, in seconds.
+ * @param allocator The allocator the emitters are taken from.
+ * @param out_data A pointer to hold what is spawned.
+ * @return True on success; false if the emitters could not be allocated, in which case nothing spawns.
+ */
+KAPI b8 particles_take(f32 delta_time, struct linear_allocator* allocator, particles_packet_data* out_data);
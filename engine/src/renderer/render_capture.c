@@ -0,0 +1,606 @@
+#include "render_capture.h"
+
+#include "containers/darray.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+#include "math/kmath.h"
+#include "math/transform.h"
+#include "memory/linear_allocator.h"
+#include "platform/filesystem.h"
+#include "renderer/light_clusters.h"
+#include "resources/mesh.h"
+#include "systems/geometry_system.h"
+#include "systems/render_view_system.h"
+
+// The longest path a capture is written to.
+#define RENDER_CAPTURE_PATH_LENGTH 512
+
+typedef struct krc_header {
+    u32 magic;
+    u32 version;
+    u32 mesh_count;
+    u32 reserved;
+} krc_header;
+
+typedef struct krc_frame_header {
+    f32 delta_time;
+    u32 view_count;
+} krc_frame_header;
+
+typedef struct krc_view {
+    mat4 view_matrix;
+    mat4 projection_matrix;
+    vec4 view_position;
+    vec4 ambient_colour;
+    u32 has_lights;
+    u32 geometry_count;
+} krc_view;
+
+typedef struct krc_lights {
+    f32 near_clip;
+    f32 far_clip;
+    u32 point_light_count;
+    u32 reserved;
+    vec4 directional_direction;
+    vec4 directional_colour;
+} krc_lights;
+
+typedef struct krc_draw {
+    mat4 model;
+    u32 unique_id;
+    u32 lod;
+} krc_draw;
+
+// The bytes of a frame, gathered so that each is written at once.
+typedef struct capture_buffer {
+    u8* data;
+    u64 length;
+    u64 capacity;
+} capture_buffer;
+
+typedef struct render_capture_state {
+    file_handle file;
+    // The frames left to capture, 0 when no capture is running.
+    u32 frames_remaining;
+    u32 frames_written;
+    capture_buffer buffer;
+    char path[RENDER_CAPTURE_PATH_LENGTH];
+} render_capture_state;
+
+typedef struct capture_reader {
+    const u8* data;
+    u64 size;
+    u64 offset;
+} capture_reader;
+
+static render_capture_state capture;
+
+static void buffer_append(capture_buffer* buffer, const void* data, u64 size) {
+    if (buffer->length + size > buffer->capacity) {
+        u64 capacity = KMAX(buffer->capacity * 2, KMAX(buffer->length + size, KIBIBYTES(64)));
+        u8* grown = kallocate(capacity, MEMORY_TAG_RENDERER);
+        if (buffer->data) {
+            kcopy_memory(grown, buffer->data, buffer->length);
+            kfree(buffer->data, buffer->capacity, MEMORY_TAG_RENDERER);
+        }
+        buffer->data = grown;
+        buffer->capacity = capacity;
+    }
+    kcopy_memory(buffer->data + buffer->length, data, size);
+    buffer->length += size;
+}
+
+static void buffer_append_string(capture_buffer* buffer, const char* str) {
+    u16 length = str ? (u16)KMIN(string_length(str), 0xFFFF) : 0;
+    buffer_append(buffer, &length, sizeof(u16));
+    buffer_append(buffer, str, length);
+}
+
+// Writes the buffer to the capture's file and empties it.
+static b8 buffer_flush(void) {
+    u64 written = 0;
+    b8 result = filesystem_write(&capture.file, capture.buffer.length, capture.buffer.data, &written) && written == capture.buffer.length;
+    capture.buffer.length = 0;
+    return result;
+}
+
+static void capture_end(void) {
+    filesystem_close(&capture.file);
+    if (capture.buffer.data) {
+        kfree(capture.buffer.data, capture.buffer.capacity, MEMORY_TAG_RENDERER);
+    }
+    kzero_memory(&capture.buffer, sizeof(capture_buffer));
+    capture.frames_remaining = 0;
+}
+
+b8 render_capture_frames(u32 frame_count, const char* path, u32 mesh_count, const char** mesh_names) {
+    if (capture.frames_remaining || frame_count == 0 || !path) {
+        return false;
+    }
+    if (!filesystem_open(path, FILE_MODE_WRITE, true, &capture.file)) {
+        KERROR("render_capture_frames - Unable to open '%s' for writing.", path);
+        return false;
+    }
+    string_ncopy(capture.path, path, RENDER_CAPTURE_PATH_LENGTH - 1);
+    capture.path[RENDER_CAPTURE_PATH_LENGTH - 1] = 0;
+    capture.frames_remaining = frame_count;
+    capture.frames_written = 0;
+
+    mesh_count = KMIN(mesh_count, RENDER_CAPTURE_MAX_MESHES);
+    krc_header header = {RENDER_CAPTURE_MAGIC, RENDER_CAPTURE_VERSION, mesh_count, 0};
+    buffer_append(&capture.buffer, &header, sizeof(krc_header));
+    for (u32 i = 0; i < mesh_count; ++i) {
+        buffer_append_string(&capture.buffer, mesh_names[i]);
+    }
+    if (!buffer_flush()) {
+        KERROR("render_capture_frames - Failed to write '%s'.", path);
+        capture_end();
+        return false;
+    }
+    return true;
+}
+
+b8 render_capture_running(void) {
+    return capture.frames_remaining != 0;
+}
+
+void render_capture_frame(const render_packet* packet) {
+    if (!capture.frames_remaining || !packet) {
+        return;
+    }
+
+    krc_frame_header frame = {packet->delta_time, packet->view_count};
+    buffer_append(&capture.buffer, &frame, sizeof(krc_frame_header));
+    for (u32 v = 0; v < packet->view_count; ++v) {
+        const render_view_packet* view_packet = &packet->views[v];
+        // The clusters of world views are built from the lights, which are far smaller, so those are held instead.
+        const light_clusters* clusters = 0;
+        if (view_packet->view && view_packet->view->type == RENDERER_VIEW_KNOWN_TYPE_WORLD) {
+            clusters = view_packet->extended_data;
+        }
+
+        krc_view view = {0};
+        view.view_matrix = view_packet->view_matrix;
+        view.projection_matrix = view_packet->projection_matrix;
+        view.view_position = vec4_from_vec3(view_packet->view_position, 1.0f);
+        view.ambient_colour = view_packet->ambient_colour;
+        view.has_lights = clusters != 0;
+        view.geometry_count = view_packet->geometries ? view_packet->geometry_count : 0;
+        buffer_append_string(&capture.buffer, view_packet->view ? view_packet->view->name : 0);
+        buffer_append(&capture.buffer, &view, sizeof(krc_view));
+
+        if (clusters) {
+            const light_cluster_data* data = &clusters->data;
+            krc_lights lights = {data->depth_slicing.x, data->depth_slicing.y, data->dimensions[3], 0, data->directional_direction, data->directional_colour};
+            buffer_append(&capture.buffer, &lights, sizeof(krc_lights));
+            buffer_append(&capture.buffer, data->point_lights, sizeof(light_cluster_point_light) * lights.point_light_count);
+        }
+
+        for (u32 i = 0; i < view.geometry_count; ++i) {
+            const geometry_render_data* g_data = &view_packet->geometries[i];
+            krc_draw draw = {g_data->model, g_data->unique_id, g_data->lod};
+            buffer_append(&capture.buffer, &draw, sizeof(krc_draw));
+            buffer_append_string(&capture.buffer, g_data->geometry ? g_data->geometry->name : 0);
+            buffer_append_string(&capture.buffer, g_data->geometry && g_data->geometry->material ? g_data->geometry->material->name : 0);
+        }
+    }
+
+    if (!buffer_flush()) {
+        KERROR("render_capture_frame - Failed to write '%s'. Capture stopped after %u frames.", capture.path, capture.frames_written);
+        capture_end();
+        return;
+    }
+    capture.frames_written++;
+    capture.frames_remaining--;
+    if (capture.frames_remaining == 0) {
+        KINFO("Wrote a capture of %u frames to '%s'.", capture.frames_written, capture.path);
+        capture_end();
+    }
+}
+
+void render_replay_config_parse(i32 argc, char** argv, render_replay_config* out_config) {
+    out_config->path = 0;
+    out_config->loop_count = RENDER_REPLAY_DEFAULT_LOOP_COUNT;
+
+    for (i32 i = 1; i < argc; ++i) {
+        if (strings_nequal(argv[i], "--replay=", 9)) {
+            if (argv[i][9]) {
+                out_config->path = argv[i] + 9;
+            }
+        } else if (strings_nequal(argv[i], "--replay-loops=", 15)) {
+            if (!string_to_u32(argv[i] + 15, &out_config->loop_count) || out_config->loop_count == 0) {
+                KWARN("Invalid replay loop count '%s', using %u.", argv[i] + 15, RENDER_REPLAY_DEFAULT_LOOP_COUNT);
+                out_config->loop_count = RENDER_REPLAY_DEFAULT_LOOP_COUNT;
+            }
+        }
+    }
+}
+
+static b8 reader_read(capture_reader* reader, u64 size, void* out_data) {
+    if (reader->size - reader->offset < size) {
+        return false;
+    }
+    kcopy_memory(out_data, reader->data + reader->offset, size);
+    reader->offset += size;
+    return true;
+}
+
+static b8 reader_read_string(capture_reader* reader, char** out_str) {
+    u16 length = 0;
+    if (!reader_read(reader, sizeof(u16), &length) || reader->size - reader->offset < length) {
+        return false;
+    }
+    *out_str = string_view_duplicate(string_view_from((const char*)reader->data + reader->offset, length));
+    reader->offset += length;
+    return true;
+}
+
+// Finds the geometry of the given names in the replay, adding it if it is not there.
+static u32 replay_geometry_index(render_replay* replay, char* name, char* material_name) {
+    u32 count = (u32)darray_length(replay->geometries);
+    for (u32 i = 0; i < count; ++i) {
+        if (strings_equal(replay->geometries[i].name, name) && strings_equal(replay->geometries[i].material_name, material_name)) {
+            string_free(name);
+            string_free(material_name);
+            return i;
+        }
+    }
+    render_replay_geometry g = {name, material_name, 0};
+    darray_push(replay->geometries, g);
+    return count;
+}
+
+static b8 replay_view_read(capture_reader* reader, render_replay* replay, render_replay_view* out_view) {
+    krc_view view;
+    if (!reader_read_string(reader, &out_view->name) || !reader_read(reader, sizeof(krc_view), &view)) {
+        return false;
+    }
+    out_view->view_matrix = view.view_matrix;
+    out_view->projection_matrix = view.projection_matrix;
+    out_view->view_position = vec3_from_vec4(view.view_position);
+    out_view->ambient_colour = view.ambient_colour;
+    out_view->has_lights = view.has_lights != 0;
+
+    if (out_view->has_lights) {
+        krc_lights lights;
+        if (!reader_read(reader, sizeof(krc_lights), &lights) || lights.point_light_count > LIGHT_CLUSTERS_MAX_LIGHTS) {
+            return false;
+        }
+        out_view->near_clip = lights.near_clip;
+        out_view->far_clip = lights.far_clip;
+        out_view->directional.direction = vec3_from_vec4(lights.directional_direction);
+        out_view->directional.colour = lights.directional_colour;
+        if (lights.point_light_count) {
+            out_view->point_lights = kallocate(sizeof(point_light) * lights.point_light_count, MEMORY_TAG_RENDERER);
+            out_view->point_light_count = lights.point_light_count;
+        }
+        for (u32 i = 0; i < lights.point_light_count; ++i) {
+            light_cluster_point_light captured;
+            if (!reader_read(reader, sizeof(light_cluster_point_light), &captured)) {
+                return false;
+            }
+            point_light* light = &out_view->point_lights[i];
+            light->position = vec3_from_vec4(captured.position_radius);
+            light->radius = captured.position_radius.w;
+            light->colour = captured.colour;
+            light->constant_f = captured.attenuation.x;
+            light->linear = captured.attenuation.y;
+            light->quadratic = captured.attenuation.z;
+        }
+    }
+
+    // Each draw takes at least its fixed part, so a corrupt count is caught before anything is allocated for it.
+    if (view.geometry_count > (reader->size - reader->offset) / sizeof(krc_draw)) {
+        return false;
+    }
+    if (view.geometry_count) {
+        out_view->draws = kallocate(sizeof(render_replay_draw) * view.geometry_count, MEMORY_TAG_RENDERER);
+        out_view->draw_count = view.geometry_count;
+    }
+    for (u32 i = 0; i < view.geometry_count; ++i) {
+        krc_draw draw;
+        char* name = 0;
+        char* material_name = 0;
+        if (!reader_read(reader, sizeof(krc_draw), &draw) || !reader_read_string(reader, &name)) {
+            return false;
+        }
+        if (!reader_read_string(reader, &material_name)) {
+            string_free(name);
+            return false;
+        }
+        render_replay_draw* out_draw = &out_view->draws[i];
+        out_draw->model = draw.model;
+        out_draw->unique_id = draw.unique_id;
+        out_draw->lod = (u8)draw.lod;
+        out_draw->geometry_index = replay_geometry_index(replay, name, material_name);
+    }
+    return true;
+}
+
+b8 render_replay_read(const void* data, u64 size, const char* path, u32 loop_count, render_replay* out_replay) {
+    kzero_memory(out_replay, sizeof(render_replay));
+    out_replay->frames = darray_create(render_replay_frame);
+    out_replay->geometries = darray_create(render_replay_geometry);
+    out_replay->loop_count = loop_count ? loop_count : RENDER_REPLAY_DEFAULT_LOOP_COUNT;
+    for (u32 i = 0; i < RENDER_CAPTURE_MAX_MESHES; ++i) {
+        out_replay->meshes[i].generation = INVALID_ID_U8;
+    }
+
+    capture_reader reader = {data, size, 0};
+    krc_header header = {0};
+    reader_read(&reader, sizeof(krc_header), &header);
+    if (header.magic != RENDER_CAPTURE_MAGIC) {
+        KERROR("'%s' is not a render capture.", path);
+        return false;
+    }
+    if (header.version != RENDER_CAPTURE_VERSION) {
+        KERROR("'%s' is render capture version %u, but only version %u is supported. Capture it again.", path, header.version, RENDER_CAPTURE_VERSION);
+        return false;
+    }
+    if (header.mesh_count > RENDER_CAPTURE_MAX_MESHES) {
+        KERROR("'%s' names %u meshes, more than the max of %u.", path, header.mesh_count, RENDER_CAPTURE_MAX_MESHES);
+        return false;
+    }
+    for (u32 i = 0; i < header.mesh_count; ++i) {
+        if (!reader_read_string(&reader, &out_replay->mesh_names[i])) {
+            KERROR("'%s' is cut short in its mesh names.", path);
+            return false;
+        }
+        out_replay->mesh_count++;
+    }
+
+    // Frames run to the end of the file. One cut short ends the capture, as if it had been stopped there.
+    while (reader.offset < reader.size) {
+        krc_frame_header frame_header;
+        if (!reader_read(&reader, sizeof(krc_frame_header), &frame_header)) {
+            break;
+        }
+        render_replay_frame frame = {0};
+        frame.delta_time = frame_header.delta_time;
+        // Each view takes at least its fixed part.
+        if (frame_header.view_count > (reader.size - reader.offset) / sizeof(krc_view)) {
+            break;
+        }
+        if (frame_header.view_count) {
+            frame.views = kallocate(sizeof(render_replay_view) * frame_header.view_count, MEMORY_TAG_RENDERER);
+            frame.view_count = frame_header.view_count;
+        }
+        // Pushed before it is read, so that whatever it holds is destroyed with the replay.
+        darray_push(out_replay->frames, frame);
+        b8 complete = true;
+        for (u32 v = 0; v < frame.view_count && complete; ++v) {
+            complete = replay_view_read(&reader, out_replay, &frame.views[v]);
+        }
+        if (!complete) {
+            KWARN("'%s' is cut short in frame %u, which is left out.", path, out_replay->frame_count);
+            break;
+        }
+        out_replay->frame_count++;
+    }
+
+    if (out_replay->frame_count == 0) {
+        KERROR("'%s' holds no frames.", path);
+        return false;
+    }
+    return true;
+}
+
+b8 render_replay_load(const render_replay_config* config, render_replay* out_replay) {
+    file_handle f;
+    if (!filesystem_open(config->path, FILE_MODE_READ, true, &f)) {
+        KERROR("render_replay_load - Unable to open '%s'.", config->path);
+        return false;
+    }
+    u64 size = 0;
+    if (!filesystem_size(&f, &size) || size == 0) {
+        KERROR("render_replay_load - Unable to read the size of '%s'.", config->path);
+        filesystem_close(&f);
+        return false;
+    }
+    u8* data = kallocate(size, MEMORY_TAG_RENDERER);
+    u64 read = 0;
+    b8 result = filesystem_read_all_bytes(&f, data, &read) && read == size;
+    filesystem_close(&f);
+    if (!result) {
+        KERROR("render_replay_load - Unable to read '%s'.", config->path);
+    } else {
+        result = render_replay_read(data, size, config->path, config->loop_count, out_replay);
+        if (!result) {
+            render_replay_destroy(out_replay);
+        }
+    }
+    kfree(data, size, MEMORY_TAG_RENDERER);
+    if (result) {
+        KINFO("Replaying %u frames from '%s' %u times, drawing %u geometries from %u meshes.", out_replay->frame_count, config->path, out_replay->loop_count, (u32)darray_length(out_replay->geometries), out_replay->mesh_count);
+    }
+    return result;
+}
+
+void render_replay_destroy(render_replay* replay) {
+    if (!replay) {
+        return;
+    }
+    if (replay->frames) {
+        u32 frame_count = (u32)darray_length(replay->frames);
+        for (u32 f = 0; f < frame_count; ++f) {
+            render_replay_frame* frame = &replay->frames[f];
+            for (u32 v = 0; v < frame->view_count; ++v) {
+                render_replay_view* view = &frame->views[v];
+                if (view->name) {
+                    string_free(view->name);
+                }
+                if (view->point_lights) {
+                    kfree(view->point_lights, sizeof(point_light) * view->point_light_count, MEMORY_TAG_RENDERER);
+                }
+                if (view->draws) {
+                    kfree(view->draws, sizeof(render_replay_draw) * view->draw_count, MEMORY_TAG_RENDERER);
+                }
+            }
+            if (frame->views) {
+                kfree(frame->views, sizeof(render_replay_view) * frame->view_count, MEMORY_TAG_RENDERER);
+            }
+        }
+        darray_destroy(replay->frames);
+    }
+    if (replay->geometries) {
+        u32 geometry_count = (u32)darray_length(replay->geometries);
+        for (u32 i = 0; i < geometry_count; ++i) {
+            render_replay_geometry* g = &replay->geometries[i];
+            if (g->resolved) {
+                geometry_system_release(g->resolved);
+            }
+            string_free(g->name);
+            string_free(g->material_name);
+        }
+        darray_destroy(replay->geometries);
+    }
+    for (u32 i = 0; i < replay->mesh_count; ++i) {
+        if (replay->meshes_loading && replay->meshes[i].generation != INVALID_ID_U8) {
+            mesh_unload(&replay->meshes[i]);
+        } else if (replay->meshes_loading) {
+            KWARN("render_replay_destroy - mesh '%s' is still loading, and will not be unloaded.", replay->mesh_names[i]);
+        }
+        string_free(replay->mesh_names[i]);
+    }
+    kzero_memory(replay, sizeof(render_replay));
+}
+
+static void replay_resolve(render_replay* replay) {
+    u32 missing_count = 0;
+    u32 mismatched_count = 0;
+    u32 geometry_count = (u32)darray_length(replay->geometries);
+    for (u32 i = 0; i < geometry_count; ++i) {
+        render_replay_geometry* g = &replay->geometries[i];
+        g->resolved = geometry_system_acquire_by_name(g->name);
+        if (!g->resolved) {
+            missing_count++;
+        } else if (g->material_name[0] && (!g->resolved->material || !strings_equali(g->resolved->material->name, g->material_name))) {
+            mismatched_count++;
+        }
+    }
+    if (missing_count) {
+        KWARN("%u of the %u geometries captured are not loaded, and will not be drawn.", missing_count, geometry_count);
+    }
+    if (mismatched_count) {
+        KWARN("%u of the geometries captured have a different material now, which they are drawn with.", mismatched_count);
+    }
+
+    u32 skipped_count = 0;
+    for (u32 f = 0; f < replay->frame_count; ++f) {
+        render_replay_frame* frame = &replay->frames[f];
+        for (u32 v = 0; v < frame->view_count; ++v) {
+            render_replay_view* view = &frame->views[v];
+            const render_view* found = view->name[0] ? render_view_system_get(view->name) : 0;
+            if (found && found->type == RENDERER_VIEW_KNOWN_TYPE_WORLD) {
+                view->view = found;
+            } else if (f == 0) {
+                skipped_count++;
+            }
+        }
+    }
+    if (skipped_count) {
+        KINFO("%u views of each frame are not replayed, as only world views are.", skipped_count);
+    }
+    replay->resolved = true;
+}
+
+b8 render_replay_ready(render_replay* replay) {
+    if (replay->resolved) {
+        return true;
+    }
+    if (!replay->meshes_loading) {
+        replay->meshes_loading = true;
+        for (u32 i = 0; i < replay->mesh_count; ++i) {
+            replay->meshes[i].transform = transform_create();
+            if (!mesh_load_from_resource(replay->mesh_names[i], &replay->meshes[i])) {
+                KERROR("render_replay_ready - failed to start loading mesh '%s'.", replay->mesh_names[i]);
+                // Counted as loaded, with nothing in it.
+                replay->meshes[i].generation = 0;
+            }
+        }
+    }
+    for (u32 i = 0; i < replay->mesh_count; ++i) {
+        if (replay->meshes[i].generation == INVALID_ID_U8) {
+            return false;
+        }
+    }
+    replay_resolve(replay);
+    return true;
+}
+
+b8 render_replay_packet_build(render_replay* replay, struct linear_allocator* frame_allocator, render_packet* out_packet) {
+    render_replay_frame* frame = &replay->frames[replay->frames_replayed % replay->frame_count];
+    out_packet->delta_time = frame->delta_time;
+    out_packet->view_count = 0;
+    out_packet->views = linear_allocator_allocate(frame_allocator, sizeof(render_view_packet) * KMAX(frame->view_count, 1));
+    if (!out_packet->views) {
+        KERROR("render_replay_packet_build - out of frame memory for the views.");
+        return false;
+    }
+
+    for (u32 v = 0; v < frame->view_count; ++v) {
+        const render_replay_view* view = &frame->views[v];
+        if (!view->view) {
+            continue;
+        }
+        render_view_packet* out_view = &out_packet->views[out_packet->view_count++];
+        kzero_memory(out_view, sizeof(render_view_packet));
+        out_view->view = view->view;
+        out_view->view_matrix = view->view_matrix;
+        out_view->projection_matrix = view->projection_matrix;
+        out_view->view_position = view->view_position;
+        out_view->ambient_colour = view->ambient_colour;
+
+        // Drawn in the order captured, which is that the view sorted them into.
+        out_view->geometries = darray_reserve_with_allocator(geometry_render_data, view->draw_count, frame_allocator);
+        for (u32 i = 0; i < view->draw_count; ++i) {
+            const render_replay_draw* draw = &view->draws[i];
+            geometry* g = replay->geometries[draw->geometry_index].resolved;
+            if (!g) {
+                continue;
+            }
+            geometry_render_data g_data = {draw->model, g, draw->unique_id, draw->lod};
+            darray_push(out_view->geometries, g_data);
+            out_view->geometry_count++;
+        }
+
+        if (view->has_lights) {
+            light_clusters* clusters = linear_allocator_allocate(frame_allocator, sizeof(light_clusters));
+            if (clusters) {
+                light_clusters_view lights_view = {view->view_matrix, view->projection_matrix, view->near_clip, view->far_clip};
+                light_clusters_build(&lights_view, &view->directional, view->point_light_count, view->point_lights, clusters);
+            }
+            out_view->extended_data = clusters;
+        }
+    }
+    return true;
+}
+
+b8 render_replay_frame_end(render_replay* replay, f64 frame_time) {
+    render_replay_frame* frame = &replay->frames[replay->frames_replayed % replay->frame_count];
+    frame->total_time += frame_time;
+    frame->max_time = KMAX(frame->max_time, frame_time);
+    replay->frames_replayed++;
+    if (replay->frames_replayed < replay->frame_count * replay->loop_count) {
+        return false;
+    }
+
+    KINFO("Replayed %u frames %u times:", replay->frame_count, replay->loop_count);
+    u32 slowest = 0;
+    f64 total = 0;
+    for (u32 f = 0; f < replay->frame_count; ++f) {
+        const render_replay_frame* replayed = &replay->frames[f];
+        u32 draw_count = 0;
+        for (u32 v = 0; v < replayed->view_count; ++v) {
+            draw_count += replayed->views[v].view ? replayed->views[v].draw_count : 0;
+        }
+        KINFO("  Frame %u: avg %.3fms, max %.3fms, %u draws.", f, replayed->total_time * 1000.0 / replay->loop_count, replayed->max_time * 1000.0, draw_count);
+        total += replayed->total_time;
+        if (replayed->total_time > replay->frames[slowest].total_time) {
+            slowest = f;
+        }
+    }
+    KINFO("Average frame %.3fms. The slowest was frame %u, at %.3fms on average.", total * 1000.0 / replay->frames_replayed, slowest, replay->frames[slowest].total_time * 1000.0 / replay->loop_count);
+    return true;
+}
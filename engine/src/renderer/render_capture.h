@@ -0,0 +1,234 @@
+/**
+ * @file render_capture.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Captures the render packets of a number of frames to a file, and replays them later in a
+ * timed loop, so that a slow frame can be reproduced and measured outside the live game.
+ * @details A capture holds, for every frame, each view's matrices, ambient colour and the
+ * geometries it draws, in the order they were built, with their model matrices, levels of detail
+ * and the names of their geometries and materials. The lights of world views are held too, as
+ * their clusters are built from them. Geometries are known by name, so a capture holds the names
+ * of the meshes they came from, given when it is started, which a replay loads.
+ *
+ * A replay takes the place of the game's render routine once the meshes it loads are ready, and
+ * redraws the captured frames over and over, logging the average time of each once done through
+ * every loop. Only world views are replayed, as the data the other views build their packets from
+ * is not a list of geometries. Captures are written as they go, so one cut short holds the frames
+ * written before it was.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "renderer/renderer_types.inl"
+#include "resources/resource_types.h"
+#include "systems/light_system.h"
+
+/** @brief The magic number of a capture file, "KRC1". */
+#define RENDER_CAPTURE_MAGIC 0x3143524B
+/** @brief The version of the capture file format. */
+#define RENDER_CAPTURE_VERSION 1
+/** @brief The most meshes a capture can name. */
+#define RENDER_CAPTURE_MAX_MESHES 32
+/** @brief The number of times the captured frames are replayed when not given a loop count. */
+#define RENDER_REPLAY_DEFAULT_LOOP_COUNT 10
+
+struct linear_allocator;
+
+/** @brief Configuration for a replay run. */
+typedef struct render_replay_config {
+    /** @brief The path of the capture to replay, or 0 to run normally. */
+    const char* path;
+    /** @brief The number of times every captured frame is replayed. */
+    u32 loop_count;
+} render_replay_config;
+
+/** @brief A geometry drawn by a captured frame, known by name. */
+typedef struct render_replay_geometry {
+    /** @brief The name of the geometry. */
+    char* name;
+    /** @brief The name of the material it was drawn with, or an empty string. */
+    char* material_name;
+    /** @brief The geometry, once resolved, or 0 if none by its name is loaded. */
+    geometry* resolved;
+} render_replay_geometry;
+
+/** @brief A geometry drawn by a captured view. */
+typedef struct render_replay_draw {
+    /** @brief The model matrix. */
+    mat4 model;
+    /** @brief The unique identifier of the object drawn. */
+    u32 unique_id;
+    /** @brief The index of the geometry in the replay's geometries. */
+    u32 geometry_index;
+    /** @brief The level of detail drawn. */
+    u8 lod;
+} render_replay_draw;
+
+/** @brief A captured view. */
+typedef struct render_replay_view {
+    /** @brief The name of the view. */
+    char* name;
+    /** @brief The view, once resolved, or 0 if it is not replayed. */
+    const render_view* view;
+    /** @brief The view matrix. */
+    mat4 view_matrix;
+    /** @brief The projection matrix. */
+    mat4 projection_matrix;
+    /** @brief The position the view was drawn from. */
+    vec3 view_position;
+    /** @brief The ambient colour. */
+    vec4 ambient_colour;
+    /** @brief Indicates if the view's lights were captured. */
+    b8 has_lights;
+    /** @brief The near clip its lights were clustered with. */
+    f32 near_clip;
+    /** @brief The far clip its lights were clustered with. */
+    f32 far_clip;
+    /** @brief The directional light. */
+    directional_light directional;
+    /** @brief The number of point lights. */
+    u32 point_light_count;
+    /** @brief The point lights. */
+    point_light* point_lights;
+    /** @brief The number of geometries drawn. */
+    u32 draw_count;
+    /** @brief The geometries drawn, in the order they were. */
+    render_replay_draw* draws;
+} render_replay_view;
+
+/** @brief A captured frame. */
+typedef struct render_replay_frame {
+    /** @brief The delta time the frame was built with. */
+    f32 delta_time;
+    /** @brief The number of views. */
+    u32 view_count;
+    /** @brief The views. */
+    render_replay_view* views;
+    /** @brief The total time spent replaying the frame, in seconds. */
+    f64 total_time;
+    /** @brief The longest time spent replaying the frame, in seconds. */
+    f64 max_time;
+} render_replay_frame;
+
+/** @brief A capture loaded to be replayed. */
+typedef struct render_replay {
+    /** @brief The number of meshes the capture names. */
+    u32 mesh_count;
+    /** @brief The names of the meshes. */
+    char* mesh_names[RENDER_CAPTURE_MAX_MESHES];
+    /** @brief The meshes loaded for the replay. */
+    mesh meshes[RENDER_CAPTURE_MAX_MESHES];
+    /** @brief Indicates if the meshes have been asked to load. */
+    b8 meshes_loading;
+    /** @brief Indicates if the geometries and views have been resolved. */
+    b8 resolved;
+    /** @brief The number of frames. */
+    u32 frame_count;
+    /** @brief The frames, a darray. */
+    render_replay_frame* frames;
+    /** @brief The geometries drawn by every frame between them, each once, a darray. */
+    render_replay_geometry* geometries;
+    /** @brief The number of times every frame is replayed. */
+    u32 loop_count;
+    /** @brief The number of frames replayed so far, across every loop. */
+    u32 frames_replayed;
+} render_replay;
+
+/**
+ * @brief Starts capturing the packets of the next frames to the given file, replacing it. Does
+ * nothing if a capture is already running.
+ *
+ * @param frame_count The number of frames to capture.
+ * @param path The path of the file to write.
+ * @param mesh_count The number of meshes the geometries drawn come from. No more than RENDER_CAPTURE_MAX_MESHES are kept.
+ * @param mesh_names The names of the mesh resources the geometries drawn come from, for a replay to load.
+ * @return True if the capture was started; otherwise false.
+ */
+KAPI b8 render_capture_frames(u32 frame_count, const char* path, u32 mesh_count, const char** mesh_names);
+
+/**
+ * @brief Indicates if a capture is running.
+ *
+ * @return True if a capture is running; otherwise false.
+ */
+KAPI b8 render_capture_running(void);
+
+/**
+ * @brief Writes the given packet to the running capture, if there is one, ending the capture once
+ * it has all its frames. Called with each packet once it is built.
+ *
+ * @param packet A constant pointer to the packet.
+ */
+KAPI void render_capture_frame(const render_packet* packet);
+
+/**
+ * @brief Fills out a replay configuration from command line arguments. Recognizes
+ * --replay=path and --replay-loops=count. Without --replay, path is 0 and no replay is run.
+ *
+ * @param argc The number of arguments, as given to main.
+ * @param argv The arguments, as given to main. Must outlive the replay, as the path is not copied.
+ * @param out_config A pointer to hold the configuration.
+ */
+KAPI void render_replay_config_parse(i32 argc, char** argv, render_replay_config* out_config);
+
+/**
+ * @brief Reads a replay from the contents of a capture file.
+ *
+ * @param data The contents of the file.
+ * @param size The size of the contents in bytes.
+ * @param path The path of the file, for messages.
+ * @param loop_count The number of times every frame is replayed. 0 uses RENDER_REPLAY_DEFAULT_LOOP_COUNT.
+ * @param out_replay A pointer to hold the replay. Should be destroyed whether or not this succeeds.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 render_replay_read(const void* data, u64 size, const char* path, u32 loop_count, render_replay* out_replay);
+
+/**
+ * @brief Loads a replay from a capture file.
+ *
+ * @param config The configuration of the replay.
+ * @param out_replay A pointer to hold the replay.
+ * @return True on success; otherwise false, with nothing left to destroy.
+ */
+KAPI b8 render_replay_load(const render_replay_config* config, render_replay* out_replay);
+
+/**
+ * @brief Destroys the given replay, releasing the geometries it acquired and unloading its meshes.
+ *
+ * @param replay A pointer to the replay.
+ */
+KAPI void render_replay_destroy(render_replay* replay);
+
+/**
+ * @brief Starts loading the replay's meshes the first time it is called, then indicates once they
+ * have all loaded, resolving the geometries and views the replay draws with. Geometries are drawn
+ * with the materials they have, which are only checked against those captured.
+ *
+ * @param replay A pointer to the replay.
+ * @return True once the replay is ready to be drawn; otherwise false.
+ */
+KAPI b8 render_replay_ready(render_replay* replay);
+
+/**
+ * @brief Builds the packet of the next frame to replay. The replay must be ready.
+ *
+ * @param replay A pointer to the replay.
+ * @param frame_allocator The allocator the packet's views and their data are taken from.
+ * @param out_packet A pointer to hold the packet. Its delta time is set to that captured.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 render_replay_packet_build(render_replay* replay, struct linear_allocator* frame_allocator, render_packet* out_packet);
+
+/**
+ * @brief Records the time taken by the frame last built, moving on to the next. Once every frame
+ * has been replayed the configured number of times, the average and longest times of each are logged.
+ *
+ * @param replay A pointer to the replay.
+ * @param frame_time The time taken by the frame, in seconds.
+ * @return True once the replay is done; otherwise false.
+ */
+KAPI b8 render_replay_frame_end(render_replay* replay, f64 frame_time);
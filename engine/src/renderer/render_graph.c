@@ -0,0 +1,211 @@
+#include "render_graph.h"
+
+#include "containers/darray.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+// The clear flag which clears the contents of the given type of attachment.
+static u8 clear_flag_get(render_target_attachment_type type) {
+    switch (type) {
+        case RENDER_TARGET_ATTACHMENT_TYPE_COLOUR:
+            return RENDERPASS_CLEAR_COLOUR_BUFFER_FLAG;
+        case RENDER_TARGET_ATTACHMENT_TYPE_DEPTH:
+            return RENDERPASS_CLEAR_DEPTH_BUFFER_FLAG;
+        case RENDER_TARGET_ATTACHMENT_TYPE_STENCIL:
+            return RENDERPASS_CLEAR_STENCIL_BUFFER_FLAG;
+    }
+    return RENDERPASS_CLEAR_NONE_FLAG;
+}
+
+// Resources whose images come from the view or are shared may share one image if they are alike.
+static b8 resources_alias_compatible(const render_graph_resource* a, const render_graph_resource* b) {
+    return a->type == b->type && a->source == b->source && a->width == b->width && a->height == b->height;
+}
+
+void render_graph_create(render_graph* out_graph) {
+    kzero_memory(out_graph, sizeof(render_graph));
+}
+
+u32 render_graph_resource_add(render_graph* graph, const char* name, render_target_attachment_type type, render_target_attachment_source source, u32 width, u32 height, u32 flags) {
+    if (graph->resource_count >= RENDER_GRAPH_MAX_RESOURCES) {
+        KERROR("render_graph_resource_add - Unable to add resource '%s', as the graph already has the maximum of %u.", name, RENDER_GRAPH_MAX_RESOURCES);
+        return INVALID_ID;
+    }
+    if (flags & RENDER_GRAPH_RESOURCE_FLAG_PRESENT) {
+        flags |= RENDER_GRAPH_RESOURCE_FLAG_EXTERNAL;
+    }
+
+    render_graph_resource* resource = &graph->resources[graph->resource_count];
+    kzero_memory(resource, sizeof(render_graph_resource));
+    resource->name = name;
+    resource->type = type;
+    resource->source = source;
+    resource->width = width;
+    resource->height = height;
+    resource->flags = flags;
+    resource->first_pass = INVALID_ID;
+    resource->last_pass = INVALID_ID;
+    resource->alias_slot = INVALID_ID;
+    return graph->resource_count++;
+}
+
+u32 render_graph_pass_add(render_graph* graph, const char* name, u8 clear_flags) {
+    if (graph->pass_count >= RENDER_GRAPH_MAX_PASSES) {
+        KERROR("render_graph_pass_add - Unable to add pass '%s', as the graph already has the maximum of %u.", name, RENDER_GRAPH_MAX_PASSES);
+        return INVALID_ID;
+    }
+
+    render_graph_pass* pass = &graph->passes[graph->pass_count];
+    kzero_memory(pass, sizeof(render_graph_pass));
+    pass->name = name;
+    pass->clear_flags = clear_flags;
+    return graph->pass_count++;
+}
+
+b8 render_graph_pass_use(render_graph* graph, u32 pass, u32 resource, render_graph_access access) {
+    if (pass >= graph->pass_count || resource >= graph->resource_count) {
+        KERROR("render_graph_pass_use - Invalid pass (%u) or resource (%u).", pass, resource);
+        return false;
+    }
+    render_graph_pass* p = &graph->passes[pass];
+    if (p->use_count >= RENDER_GRAPH_MAX_PASS_USES) {
+        KERROR("render_graph_pass_use - Pass '%s' already uses the maximum of %u resources.", p->name, RENDER_GRAPH_MAX_PASS_USES);
+        return false;
+    }
+    for (u32 i = 0; i < p->use_count; ++i) {
+        if (p->uses[i].resource == resource) {
+            KERROR("render_graph_pass_use - Pass '%s' already uses resource '%s'.", p->name, graph->resources[resource].name);
+            return false;
+        }
+    }
+
+    render_graph_use* use = &p->uses[p->use_count++];
+    kzero_memory(use, sizeof(render_graph_use));
+    use->resource = resource;
+    use->access = access;
+    return true;
+}
+
+b8 render_graph_compile(render_graph* graph) {
+    // The lifetime of each resource, from the first pass using it to the last.
+    for (u32 r = 0; r < graph->resource_count; ++r) {
+        graph->resources[r].first_pass = INVALID_ID;
+        graph->resources[r].last_pass = INVALID_ID;
+        graph->resources[r].transient = false;
+        graph->resources[r].alias_slot = INVALID_ID;
+    }
+    for (u32 p = 0; p < graph->pass_count; ++p) {
+        for (u32 u = 0; u < graph->passes[p].use_count; ++u) {
+            render_graph_resource* resource = &graph->resources[graph->passes[p].uses[u].resource];
+            if (resource->first_pass == INVALID_ID) {
+                resource->first_pass = p;
+            }
+            resource->last_pass = p;
+        }
+    }
+
+    // The operations of each use follow from the uses before and after it.
+    b8 written[RENDER_GRAPH_MAX_RESOURCES] = {0};
+    b8 loaded_or_stored[RENDER_GRAPH_MAX_RESOURCES] = {0};
+    for (u32 p = 0; p < graph->pass_count; ++p) {
+        render_graph_pass* pass = &graph->passes[p];
+        for (u32 u = 0; u < pass->use_count; ++u) {
+            render_graph_use* use = &pass->uses[u];
+            render_graph_resource* resource = &graph->resources[use->resource];
+
+            if (use->access == RENDER_GRAPH_ACCESS_SAMPLED) {
+                if (!written[use->resource]) {
+                    KERROR("render_graph_compile - Pass '%s' samples resource '%s' before any pass writes it.", pass->name, resource->name);
+                    return false;
+                }
+                loaded_or_stored[use->resource] = true;
+                continue;
+            }
+
+            // Loaded only if there is something to keep which the pass does not clear.
+            b8 cleared = (pass->clear_flags & clear_flag_get(resource->type)) != 0;
+            b8 load = written[use->resource] && !cleared;
+            use->load_operation = load ? RENDER_TARGET_ATTACHMENT_LOAD_OPERATION_LOAD : RENDER_TARGET_ATTACHMENT_LOAD_OPERATION_DONT_CARE;
+
+            // Stored only if something reads what this pass writes.
+            b8 store = p < resource->last_pass || (resource->flags & RENDER_GRAPH_RESOURCE_FLAG_EXTERNAL);
+            use->store_operation = store ? RENDER_TARGET_ATTACHMENT_STORE_OPERATION_STORE : RENDER_TARGET_ATTACHMENT_STORE_OPERATION_DONT_CARE;
+
+            use->present_after = (resource->flags & RENDER_GRAPH_RESOURCE_FLAG_PRESENT) && p == resource->last_pass;
+
+            written[use->resource] = true;
+            loaded_or_stored[use->resource] |= load || store;
+        }
+    }
+
+    // Resources whose contents never leave the pass using them need no memory outside of it.
+    for (u32 r = 0; r < graph->resource_count; ++r) {
+        render_graph_resource* resource = &graph->resources[r];
+        resource->transient = resource->first_pass != INVALID_ID && !loaded_or_stored[r] && !(resource->flags & RENDER_GRAPH_RESOURCE_FLAG_EXTERNAL);
+    }
+
+    // Alias slots, assigned greedily in order of first use. A slot is reused by a resource first
+    // used after the last use of the one holding it. External resources and those from the window
+    // are never aliased.
+    graph->alias_slot_count = 0;
+    u32 slot_last_pass[RENDER_GRAPH_MAX_RESOURCES];
+    u32 slot_owner[RENDER_GRAPH_MAX_RESOURCES];
+    for (u32 p = 0; p < graph->pass_count; ++p) {
+        for (u32 r = 0; r < graph->resource_count; ++r) {
+            render_graph_resource* resource = &graph->resources[r];
+            if (resource->first_pass != p) {
+                continue;
+            }
+            b8 aliasable = resource->source != RENDER_TARGET_ATTACHMENT_SOURCE_DEFAULT && !(resource->flags & RENDER_GRAPH_RESOURCE_FLAG_EXTERNAL);
+            if (aliasable) {
+                for (u32 s = 0; s < graph->alias_slot_count; ++s) {
+                    const render_graph_resource* owner = &graph->resources[slot_owner[s]];
+                    if (slot_last_pass[s] < p && resources_alias_compatible(owner, resource) && !(owner->flags & RENDER_GRAPH_RESOURCE_FLAG_EXTERNAL)) {
+                        resource->alias_slot = s;
+                        slot_last_pass[s] = resource->last_pass;
+                        slot_owner[s] = r;
+                        break;
+                    }
+                }
+            }
+            if (resource->alias_slot == INVALID_ID) {
+                resource->alias_slot = graph->alias_slot_count;
+                slot_last_pass[graph->alias_slot_count] = resource->last_pass;
+                slot_owner[graph->alias_slot_count] = r;
+                graph->alias_slot_count++;
+            }
+        }
+    }
+
+    return true;
+}
+
+b8 render_graph_pass_attachments_get(const render_graph* graph, u32 pass, renderpass_config* config) {
+    if (pass >= graph->pass_count) {
+        KERROR("render_graph_pass_attachments_get - Invalid pass index %u.", pass);
+        return false;
+    }
+    if (!config->target.attachments) {
+        config->target.attachments = darray_create(render_target_attachment_config);
+    }
+
+    const render_graph_pass* p = &graph->passes[pass];
+    for (u32 u = 0; u < p->use_count; ++u) {
+        const render_graph_use* use = &p->uses[u];
+        if (use->access != RENDER_GRAPH_ACCESS_ATTACHMENT) {
+            continue;
+        }
+        const render_graph_resource* resource = &graph->resources[use->resource];
+        render_target_attachment_config attachment = {0};
+        attachment.type = resource->type;
+        attachment.source = resource->source;
+        attachment.load_operation = use->load_operation;
+        attachment.store_operation = use->store_operation;
+        attachment.present_after = use->present_after;
+        attachment.transient = resource->transient;
+        attachment.alias_slot = resource->alias_slot;
+        darray_push(config->target.attachments, attachment);
+    }
+    config->target.attachment_count = darray_length(config->target.attachments);
+    return true;
+}
@@ -0,0 +1,181 @@
+/**
+ * @file render_graph.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief A render graph, in which passes declare the attachments they render to and the images
+ * they sample instead of setting load and store operations by hand. Compiling the graph derives
+ * the operations of every attachment from what the passes before and after it do, which in turn
+ * decide the layout transitions and barriers between passes. Attachments whose contents never
+ * leave the one pass using them are marked transient, so may live in lazily-allocated memory,
+ * and attachments whose lifetimes do not overlap are assigned the same alias slot, so may share
+ * one image. Shared attachments do, taken from the render view system by their slot.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "renderer_types.inl"
+
+/** @brief The maximum number of resources in a render graph. */
+#define RENDER_GRAPH_MAX_RESOURCES 16
+/** @brief The maximum number of passes in a render graph. */
+#define RENDER_GRAPH_MAX_PASSES 16
+/** @brief The maximum number of resources used by one pass. */
+#define RENDER_GRAPH_MAX_PASS_USES 8
+
+typedef enum render_graph_resource_flag {
+    RENDER_GRAPH_RESOURCE_FLAG_NONE = 0x0,
+    /**
+     * @brief The resource is used outside the graph, such as read back on the CPU or read by the
+     * next frame, so what the last pass wrote to it is kept.
+     */
+    RENDER_GRAPH_RESOURCE_FLAG_EXTERNAL = 0x1,
+    /** @brief The resource is presented after the last pass writing it. Implies external. */
+    RENDER_GRAPH_RESOURCE_FLAG_PRESENT = 0x2
+} render_graph_resource_flag;
+
+typedef enum render_graph_access {
+    /** @brief Rendered to as an attachment. */
+    RENDER_GRAPH_ACCESS_ATTACHMENT,
+    /** @brief Sampled by shaders, which requires it to have been written earlier in the graph. */
+    RENDER_GRAPH_ACCESS_SAMPLED
+} render_graph_access;
+
+/** @brief An image passes of the graph render to or sample. */
+typedef struct render_graph_resource {
+    /** @brief The name of the resource, for logging. */
+    const char* name;
+    /** @brief The type of attachment the resource is. */
+    render_target_attachment_type type;
+    /** @brief Where the image of the resource comes from. */
+    render_target_attachment_source source;
+    /** @brief The width of the resource, or 0 for the size of the window. */
+    u32 width;
+    /** @brief The height of the resource, or 0 for the size of the window. */
+    u32 height;
+    /** @brief The render_graph_resource_flag bits of the resource. */
+    u32 flags;
+
+    /** @brief The index of the first pass using the resource. Set by compiling. */
+    u32 first_pass;
+    /** @brief The index of the last pass using the resource. Set by compiling. */
+    u32 last_pass;
+    /**
+     * @brief True if the contents of the resource are neither loaded nor stored by any pass, so it
+     * needs no backing memory outside of the pass using it. Set by compiling.
+     */
+    b8 transient;
+    /**
+     * @brief The alias slot of the resource. Resources with the same slot are never in use at the
+     * same time, so may share one image. Set by compiling.
+     */
+    u32 alias_slot;
+} render_graph_resource;
+
+/** @brief The use of a resource by a pass. */
+typedef struct render_graph_use {
+    /** @brief The index of the resource used. */
+    u32 resource;
+    /** @brief How the resource is used. */
+    render_graph_access access;
+    /** @brief The load operation of the attachment. Set by compiling. */
+    render_target_attachment_load_operation load_operation;
+    /** @brief The store operation of the attachment. Set by compiling. */
+    render_target_attachment_store_operation store_operation;
+    /** @brief True if the attachment is presented after the pass. Set by compiling. */
+    b8 present_after;
+} render_graph_use;
+
+/** @brief A pass of the graph, which runs in the order it was added. */
+typedef struct render_graph_pass {
+    /** @brief The name of the pass, for logging. */
+    const char* name;
+    /** @brief The renderpass_clear_flag bits of the pass. */
+    u8 clear_flags;
+    /** @brief The number of resources used by the pass. */
+    u32 use_count;
+    /** @brief The resources used by the pass, with attachments in the order they are bound. */
+    render_graph_use uses[RENDER_GRAPH_MAX_PASS_USES];
+} render_graph_pass;
+
+/** @brief A render graph. Zero-initialise, or use render_graph_create, before adding to it. */
+typedef struct render_graph {
+    /** @brief The number of resources. */
+    u32 resource_count;
+    /** @brief The resources. */
+    render_graph_resource resources[RENDER_GRAPH_MAX_RESOURCES];
+    /** @brief The number of passes. */
+    u32 pass_count;
+    /** @brief The passes, in the order they are run. */
+    render_graph_pass passes[RENDER_GRAPH_MAX_PASSES];
+    /** @brief The number of alias slots the resources were assigned. Set by compiling. */
+    u32 alias_slot_count;
+} render_graph;
+
+/**
+ * @brief Creates an empty render graph.
+ *
+ * @param out_graph A pointer to hold the graph.
+ */
+KAPI void render_graph_create(render_graph* out_graph);
+
+/**
+ * @brief Adds a resource to the graph.
+ *
+ * @param graph A pointer to the graph.
+ * @param name The name of the resource, for logging. Must outlive the graph.
+ * @param type The type of attachment the resource is.
+ * @param source Where the image of the resource comes from.
+ * @param width The width of the resource, or 0 for the size of the window.
+ * @param height The height of the resource, or 0 for the size of the window.
+ * @param flags The render_graph_resource_flag bits of the resource.
+ * @return The index of the resource, or INVALID_ID if the graph is full.
+ */
+KAPI u32 render_graph_resource_add(render_graph* graph, const char* name, render_target_attachment_type type, render_target_attachment_source source, u32 width, u32 height, u32 flags);
+
+/**
+ * @brief Adds a pass to the graph, to be run after those already added.
+ *
+ * @param graph A pointer to the graph.
+ * @param name The name of the pass, for logging. Must outlive the graph.
+ * @param clear_flags The renderpass_clear_flag bits of the pass.
+ * @return The index of the pass, or INVALID_ID if the graph is full.
+ */
+KAPI u32 render_graph_pass_add(render_graph* graph, const char* name, u8 clear_flags);
+
+/**
+ * @brief Declares the use of a resource by a pass.
+ *
+ * @param graph A pointer to the graph.
+ * @param pass The index of the pass.
+ * @param resource The index of the resource.
+ * @param access How the pass uses the resource.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 render_graph_pass_use(render_graph* graph, u32 pass, u32 resource, render_graph_access access);
+
+/**
+ * @brief Compiles the graph, deriving the load and store operations of every attachment, which
+ * resources are transient, and the alias slot of each. An attachment is loaded only if an earlier
+ * pass wrote it and this pass does not clear it, and stored only if a later pass uses it or it is
+ * used outside the graph.
+ *
+ * @param graph A pointer to the graph.
+ * @return True on success; false if a resource is sampled before any pass writes it.
+ */
+KAPI b8 render_graph_compile(render_graph* graph);
+
+/**
+ * @brief Appends the attachments of the given compiled pass to the attachments of a renderpass
+ * configuration, in the order they were declared.
+ *
+ * @param graph A pointer to the compiled graph.
+ * @param pass The index of the pass.
+ * @param config A pointer to the renderpass configuration, whose target.attachments darray is
+ * appended to and attachment_count set.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 render_graph_pass_attachments_get(const render_graph* graph, u32 pass, renderpass_config* config);
@@ -0,0 +1,99 @@
+#include "render_queue.h"
+
+#include "core/kmemory.h"
+
+#define RENDER_QUEUE_FIELD_MASK(bits) ((1ull << (bits)) - 1)
+
+u64 render_queue_key(u8 pass, u16 pipeline, u32 material, f32 depth, b8 back_to_front) {
+    depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+    u64 quantized_depth = (u64)(depth * (f32)RENDER_QUEUE_FIELD_MASK(RENDER_QUEUE_DEPTH_BITS));
+
+    u64 key = (u64)pass & RENDER_QUEUE_FIELD_MASK(RENDER_QUEUE_PASS_BITS);
+    u64 pipeline_bits = (u64)pipeline & RENDER_QUEUE_FIELD_MASK(RENDER_QUEUE_PIPELINE_BITS);
+    u64 material_bits = (u64)material & RENDER_QUEUE_FIELD_MASK(RENDER_QUEUE_MATERIAL_BITS);
+    if (back_to_front) {
+        // Farthest first, then the state.
+        key = (key << RENDER_QUEUE_DEPTH_BITS) | (RENDER_QUEUE_FIELD_MASK(RENDER_QUEUE_DEPTH_BITS) - quantized_depth);
+        key = (key << RENDER_QUEUE_PIPELINE_BITS) | pipeline_bits;
+        key = (key << RENDER_QUEUE_MATERIAL_BITS) | material_bits;
+    } else {
+        // The state, then nearest first, so later draws are hidden by earlier ones.
+        key = (key << RENDER_QUEUE_PIPELINE_BITS) | pipeline_bits;
+        key = (key << RENDER_QUEUE_MATERIAL_BITS) | material_bits;
+        key = (key << RENDER_QUEUE_DEPTH_BITS) | quantized_depth;
+    }
+    return key;
+}
+
+void render_queue_sort(u32 count, render_queue_entry* entries, render_queue_entry* scratch) {
+    if (count < 2) {
+        return;
+    }
+
+    // Only bytes which differ between keys are sorted by.
+    u64 first_key = entries[0].key;
+    u64 differing = 0;
+    for (u32 i = 1; i < count; ++i) {
+        differing |= entries[i].key ^ first_key;
+    }
+
+    // Stable radix sort, least significant byte first, ending with the entries back in place.
+    render_queue_entry* from = entries;
+    render_queue_entry* to = scratch;
+    for (u32 shift = 0; shift < 64; shift += 8) {
+        if (((differing >> shift) & 0xFF) == 0) {
+            continue;
+        }
+        u32 offsets[256] = {0};
+        for (u32 i = 0; i < count; ++i) {
+            offsets[(from[i].key >> shift) & 0xFF]++;
+        }
+        u32 total = 0;
+        for (u32 b = 0; b < 256; ++b) {
+            u32 bucket_count = offsets[b];
+            offsets[b] = total;
+            total += bucket_count;
+        }
+        for (u32 i = 0; i < count; ++i) {
+            to[offsets[(from[i].key >> shift) & 0xFF]++] = from[i];
+        }
+        render_queue_entry* temp = from;
+        from = to;
+        to = temp;
+    }
+    if (from != entries) {
+        kcopy_memory(entries, from, sizeof(render_queue_entry) * count);
+    }
+}
+
+void render_queue_group_instances(u32 count, render_queue_entry* entries, const u64* instance_keys, render_queue_entry* scratch, render_queue_entry* groups) {
+    // Groups are ranked by the position of their first entry, which must fit where the depth was.
+    if (count < 2 || count > RENDER_QUEUE_FIELD_MASK(RENDER_QUEUE_DEPTH_BITS)) {
+        return;
+    }
+
+    // Sorted by instance key, the entries of an instance are together in the order they were, and so
+    // are those of it sharing the rest of the key before the depth.
+    for (u32 i = 0; i < count; ++i) {
+        groups[i].key = instance_keys[entries[i].index];
+        groups[i].index = i;
+    }
+    render_queue_sort(count, groups, scratch);
+
+    // Every entry takes the position of the first of its group in place of its depth.
+    u32 first = 0;
+    for (u32 g = 0; g < count; ++g) {
+        u32 position = groups[g].index;
+        u64 prefix = entries[position].key >> RENDER_QUEUE_DEPTH_BITS;
+        b8 same_group = g > 0 && groups[g].key != RENDER_QUEUE_NO_INSTANCE && groups[g].key == groups[g - 1].key &&
+                        prefix == (entries[groups[g - 1].index].key >> RENDER_QUEUE_DEPTH_BITS);
+        if (!same_group) {
+            first = position;
+        }
+        scratch[position].key = (prefix << RENDER_QUEUE_DEPTH_BITS) | first;
+    }
+    for (u32 i = 0; i < count; ++i) {
+        entries[i].key = scratch[i].key;
+    }
+    render_queue_sort(count, entries, scratch);
+}
@@ -0,0 +1,75 @@
+/**
+ * @file render_queue.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Sort keys for draws, which order them to change the least pipeline and material
+ * state between one and the next, and sorting of draws by them.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief The number of bits of the pass, the most significant part of every key. */
+#define RENDER_QUEUE_PASS_BITS 4
+/** @brief The number of bits of the pipeline, typically the shader id. */
+#define RENDER_QUEUE_PIPELINE_BITS 12
+/** @brief The number of bits of the material id. */
+#define RENDER_QUEUE_MATERIAL_BITS 24
+/** @brief The number of bits of the depth, quantized from 0 to 1. */
+#define RENDER_QUEUE_DEPTH_BITS 24
+
+/** @brief The instance key of a draw which is never drawn as an instance of another. */
+#define RENDER_QUEUE_NO_INSTANCE 0xFFFFFFFFFFFFFFFFull
+
+/** @brief A draw to be sorted: its sort key, and the index of what it draws. */
+typedef struct render_queue_entry {
+    /** @brief The sort key, lowest drawn first. */
+    u64 key;
+    /** @brief The index of the draw, in whatever list the caller keeps. */
+    u32 index;
+} render_queue_entry;
+
+/**
+ * @brief Makes the sort key of a draw. Draws are ordered by pass first. Opaque draws are then
+ * grouped by pipeline and material, so each is bound once, and drawn front to back within a
+ * material. Translucent draws must be drawn back to front, so are ordered by depth before pipeline
+ * and material. Ids are truncated to the bits the key has for them.
+ *
+ * @param pass The pass of the draw, such as 0 for opaque and 1 for translucent geometry.
+ * @param pipeline The pipeline the draw uses, typically the shader id.
+ * @param material The id of the material the draw uses.
+ * @param depth The depth of the draw, from 0 at the camera to 1 at the far clip. Clamped.
+ * @param back_to_front True if the draw is translucent, so must be sorted by depth first, farthest first.
+ * @return The sort key.
+ */
+KAPI u64 render_queue_key(u8 pass, u16 pipeline, u32 material, f32 depth, b8 back_to_front);
+
+/**
+ * @brief Sorts the given entries by key, lowest first, keeping the order of those with equal keys.
+ * Parts of the key which are the same for every entry cost nothing to sort by.
+ *
+ * @param count The number of entries.
+ * @param entries The entries to be sorted. Sorted in place.
+ * @param scratch Space for as many entries, overwritten by the sort.
+ */
+KAPI void render_queue_sort(u32 count, render_queue_entry* entries, render_queue_entry* scratch);
+
+/**
+ * @brief Reorders sorted entries so those with the same pass, pipeline and material which also have the
+ * same instance key, such as the same geometry, are next to each other, to be drawn as instances of one
+ * draw. Each group takes the place of its first entry, and keeps the order of its entries, so opaque
+ * draws stay roughly front to back. Entries whose instance key is RENDER_QUEUE_NO_INSTANCE keep their
+ * places, as translucent ones must. The keys of the entries are changed.
+ *
+ * @param count The number of entries.
+ * @param entries The entries, sorted by render_queue_sort. Reordered in place.
+ * @param instance_keys The instance key of each entry, indexed by the index of the entry.
+ * @param scratch Space for as many entries, overwritten.
+ * @param groups Space for as many entries again, overwritten.
+ */
+KAPI void render_queue_group_instances(u32 count, render_queue_entry* entries, const u64* instance_keys, render_queue_entry* scratch, render_queue_entry* groups);
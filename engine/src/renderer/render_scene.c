@@ -0,0 +1,290 @@
+#include "render_scene.h"
+
+#include "containers/darray.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "math/geometry_utils.h"
+#include "math/kmath.h"
+#include "math/transform_hierarchy.h"
+
+// The id is of a live proxy rather than a free one.
+#define PROXY_FLAG_LIVE 0x1
+// The model and bounds need recomputing at the next update, whether or not the transform moved.
+#define PROXY_FLAG_DIRTY 0x2
+
+static b8 proxy_live(const render_scene* scene, u32 id) {
+    return scene && scene->flags && id < scene->used_count && (scene->flags[id] & PROXY_FLAG_LIVE);
+}
+
+static b8 frustum_equal(const frustum* a, const frustum* b) {
+    for (u32 i = 0; i < 6; ++i) {
+        const plane_3d* pa = &a->sides[i];
+        const plane_3d* pb = &b->sides[i];
+        if (pa->distance != pb->distance || pa->normal.x != pb->normal.x || pa->normal.y != pb->normal.y || pa->normal.z != pb->normal.z) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static b8 visibility_mark(u32 leaf_id, u32 value, void* user_data) {
+    u64* visibility = user_data;
+    visibility[value / 64] |= 1ull << (value % 64);
+    return true;
+}
+
+typedef struct ray_query_data {
+    const render_scene* scene;
+    geometry_render_data** hits;
+} ray_query_data;
+
+static b8 ray_query_hit(u32 leaf_id, u32 value, void* user_data) {
+    ray_query_data* query = user_data;
+    const render_scene* scene = query->scene;
+    if ((scene->flags[value] & PROXY_FLAG_LIVE) && (scene->visibility[value / 64] & (1ull << (value % 64)))) {
+        geometry_render_data data = {0};
+        data.model = scene->models[value];
+        data.geometry = scene->geometries[value];
+        data.unique_id = scene->unique_ids[value];
+        darray_push(*query->hits, data);
+    }
+    return true;
+}
+
+b8 render_scene_create(u32 capacity, u64* memory_requirement, void* memory, render_scene* out_scene) {
+    if (capacity == 0) {
+        KERROR("render_scene_create requires a valid, non-zero capacity. Create failed.");
+        return false;
+    }
+    if (!memory_requirement) {
+        KERROR("render_scene_create requires memory_requirement to exist. Create failed.");
+        return false;
+    }
+
+    // The matrices first, so they keep the alignment of the block, then the smaller arrays.
+    u32 visibility_words = (capacity + 63) / 64;
+    u64 per_proxy = sizeof(mat4) + sizeof(geometry*) + sizeof(f32) * 6 + sizeof(u32) * 4 + sizeof(u8);
+    u64 tree_requirement = 0;
+    bvh_create(capacity, RENDER_SCENE_BVH_MARGIN, &tree_requirement, 0, 0);
+    u64 arrays_requirement = per_proxy * capacity + sizeof(u64) * visibility_words;
+    // The bvh last, after padding to keep its nodes aligned.
+    arrays_requirement = (arrays_requirement + 15) & ~15ull;
+    *memory_requirement = arrays_requirement + tree_requirement;
+
+    // If only obtaining requirement, boot out.
+    if (!memory) {
+        return true;
+    }
+    if (!out_scene) {
+        KERROR("render_scene_create requires a pointer to hold the scene. Create failed.");
+        return false;
+    }
+
+    kzero_memory(out_scene, sizeof(render_scene));
+    out_scene->capacity = capacity;
+    out_scene->models = memory;
+    out_scene->geometries = (geometry**)(out_scene->models + capacity);
+    out_scene->visibility = (u64*)(out_scene->geometries + capacity);
+    out_scene->bounds = (f32*)(out_scene->visibility + visibility_words);
+    out_scene->transform_ids = (u32*)(out_scene->bounds + capacity * 6);
+    out_scene->unique_ids = out_scene->transform_ids + capacity;
+    out_scene->next_free = out_scene->unique_ids + capacity;
+    out_scene->leaf_ids = out_scene->next_free + capacity;
+    out_scene->flags = (u8*)(out_scene->leaf_ids + capacity);
+    kzero_memory(out_scene->flags, sizeof(u8) * capacity);
+    if (!bvh_create(capacity, RENDER_SCENE_BVH_MARGIN, &tree_requirement, (u8*)memory + arrays_requirement, &out_scene->tree)) {
+        KERROR("render_scene_create failed to create its bvh. Create failed.");
+        return false;
+    }
+
+    // Every id starts out free, chained in order.
+    for (u32 i = 0; i < capacity; ++i) {
+        out_scene->next_free[i] = i + 1 < capacity ? i + 1 : INVALID_ID;
+    }
+    out_scene->free_head = 0;
+    out_scene->visible = darray_reserve(geometry_render_data, capacity < 512 ? capacity : 512);
+    return true;
+}
+
+void render_scene_destroy(render_scene* scene) {
+    if (scene) {
+        if (scene->visible) {
+            darray_destroy(scene->visible);
+        }
+        kzero_memory(scene, sizeof(render_scene));
+    }
+}
+
+u32 render_scene_proxy_add(render_scene* scene, geometry* g, u32 transform_id, u32 unique_id) {
+    if (!scene || !scene->flags || !g) {
+        KERROR("render_scene_proxy_add requires an initialized scene and a geometry.");
+        return INVALID_ID;
+    }
+    if (scene->free_head == INVALID_ID) {
+        KERROR("render_scene_proxy_add - scene of %u proxies is full.", scene->capacity);
+        return INVALID_ID;
+    }
+
+    u32 id = scene->free_head;
+    scene->free_head = scene->next_free[id];
+    scene->next_free[id] = INVALID_ID;
+    if (id >= scene->used_count) {
+        scene->used_count = id + 1;
+    }
+
+    scene->geometries[id] = g;
+    scene->transform_ids[id] = transform_id;
+    scene->unique_ids[id] = unique_id;
+    scene->models[id] = mat4_identity();
+    scene->leaf_ids[id] = INVALID_ID;
+    scene->flags[id] = PROXY_FLAG_LIVE | PROXY_FLAG_DIRTY;
+    scene->count++;
+    scene->visible_dirty = true;
+    return id;
+}
+
+b8 render_scene_proxy_remove(render_scene* scene, u32 id) {
+    if (!proxy_live(scene, id)) {
+        KERROR("render_scene_proxy_remove - proxy %u does not exist.", id);
+        return false;
+    }
+
+    if (scene->leaf_ids[id] != INVALID_ID) {
+        bvh_remove(&scene->tree, scene->leaf_ids[id]);
+    }
+    scene->flags[id] = 0;
+    scene->geometries[id] = 0;
+    scene->next_free[id] = scene->free_head;
+    scene->free_head = id;
+    scene->count--;
+    scene->visible_dirty = true;
+    return true;
+}
+
+void render_scene_proxy_dirty(render_scene* scene, u32 id) {
+    if (proxy_live(scene, id)) {
+        scene->flags[id] |= PROXY_FLAG_DIRTY;
+    }
+}
+
+void render_scene_clear(render_scene* scene) {
+    if (!scene || !scene->flags) {
+        return;
+    }
+    kzero_memory(scene->flags, sizeof(u8) * scene->capacity);
+    for (u32 i = 0; i < scene->capacity; ++i) {
+        scene->geometries[i] = 0;
+        scene->next_free[i] = i + 1 < scene->capacity ? i + 1 : INVALID_ID;
+    }
+    scene->free_head = 0;
+    scene->count = 0;
+    scene->used_count = 0;
+
+    // Emptied by making it again in the same memory.
+    u64 tree_requirement = 0;
+    bvh_create(scene->capacity, RENDER_SCENE_BVH_MARGIN, &tree_requirement, scene->tree.nodes, &scene->tree);
+    scene->visible_dirty = true;
+}
+
+b8 render_scene_update(render_scene* scene, const transform_hierarchy* transforms, const frustum* f) {
+    if (!scene || !scene->flags || !transforms || !f) {
+        return false;
+    }
+
+    u32 capacity = scene->capacity;
+    f32* center_x = scene->bounds;
+    f32* center_y = scene->bounds + capacity;
+    f32* center_z = scene->bounds + capacity * 2;
+    f32* extents_x = scene->bounds + capacity * 3;
+    f32* extents_y = scene->bounds + capacity * 4;
+    f32* extents_z = scene->bounds + capacity * 5;
+
+    // Only proxies which moved, or were just added, have their models and bounds recomputed.
+    for (u32 i = 0; i < scene->used_count; ++i) {
+        u8 flags = scene->flags[i];
+        if (!(flags & PROXY_FLAG_LIVE)) {
+            continue;
+        }
+        if (!(flags & PROXY_FLAG_DIRTY) && !transform_hierarchy_world_changed(transforms, scene->transform_ids[i])) {
+            continue;
+        }
+        mat4 model = transform_hierarchy_world_get(transforms, scene->transform_ids[i]);
+        extents_3d world_extents = extents_3d_transform(scene->geometries[i]->extents, model);
+        vec3 center = extents_3d_center(world_extents);
+        vec3 half_extents = extents_3d_half_extents(world_extents);
+        scene->models[i] = model;
+        center_x[i] = center.x;
+        center_y[i] = center.y;
+        center_z[i] = center.z;
+        extents_x[i] = half_extents.x;
+        extents_y[i] = half_extents.y;
+        extents_z[i] = half_extents.z;
+        if (scene->leaf_ids[i] == INVALID_ID) {
+            scene->leaf_ids[i] = bvh_insert(&scene->tree, world_extents, i);
+        } else {
+            bvh_move(&scene->tree, scene->leaf_ids[i], world_extents);
+        }
+        scene->flags[i] = PROXY_FLAG_LIVE;
+        scene->visible_dirty = true;
+    }
+
+    // Nothing moved and the view is the same, so what is visible is too.
+    if (!scene->visible_dirty && scene->frustum_valid && frustum_equal(&scene->last_frustum, f)) {
+        return false;
+    }
+
+    darray_clear(scene->visible);
+    if (scene->used_count) {
+        u32 word_count = (scene->used_count + 63) / 64;
+        if (scene->count >= RENDER_SCENE_BVH_MIN_PROXIES) {
+            // Only the nodes the frustum reaches are visited, and only their proxies marked.
+            kzero_memory(scene->visibility, sizeof(u64) * word_count);
+            bvh_query_frustum(&scene->tree, f, visibility_mark, scene->visibility);
+        } else {
+            // Free ids are culled along with the rest, and skipped after.
+            aabb_soa boxes = {center_x, center_y, center_z, extents_x, extents_y, extents_z};
+            frustum_intersects_aabb_batch(f, &boxes, 0, scene->used_count, scene->visibility);
+        }
+
+        for (u32 i = 0; i < scene->used_count; ++i) {
+            if (!scene->visibility[i / 64]) {
+                // None of the 64 are visible.
+                i |= 63;
+                continue;
+            }
+            if ((scene->flags[i] & PROXY_FLAG_LIVE) && (scene->visibility[i / 64] & (1ull << (i % 64)))) {
+                geometry_render_data data = {0};
+                data.model = scene->models[i];
+                data.geometry = scene->geometries[i];
+                data.unique_id = scene->unique_ids[i];
+                darray_push(scene->visible, data);
+            }
+        }
+    }
+
+    scene->last_frustum = *f;
+    scene->frustum_valid = true;
+    scene->visible_dirty = false;
+    return true;
+}
+
+u32 render_scene_raycast(const render_scene* scene, ray r, f32 max_distance, f32* out_distance) {
+    if (!scene || !scene->flags) {
+        return INVALID_ID;
+    }
+    return bvh_value_get(&scene->tree, bvh_raycast(&scene->tree, r, max_distance, out_distance));
+}
+
+u32 render_scene_ray_query(const render_scene* scene, ray r, f32 max_distance, geometry_render_data** out_hits) {
+    if (!scene || !scene->flags || !out_hits || !*out_hits) {
+        return 0;
+    }
+    u32 start = darray_length(*out_hits);
+    ray_query_data query = {scene, out_hits};
+    bvh_query_ray(&scene->tree, r, max_distance, ray_query_hit, &query);
+    return darray_length(*out_hits) - start;
+}
+
+geometry_render_data* render_scene_visible_get(render_scene* scene) {
+    return scene ? scene->visible : 0;
+}
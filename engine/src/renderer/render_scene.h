@@ -0,0 +1,178 @@
+/**
+ * @file render_scene.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief A retained scene of render proxies, one per geometry to be drawn.
+ * @details A render scene keeps what it takes to draw each geometry from one frame to the next:
+ * the geometry, the transform it follows in a transform hierarchy, its model matrix and its
+ * world-space bounds, held as an aabb_soa so they are culled several at a time. Each update only
+ * recomputes the models and bounds of proxies whose transforms moved, and only culls again and
+ * rebuilds the list of visible geometries if a proxy moved or the frustum changed. A scene in
+ * which nothing moves, viewed from where it was last frame, therefore costs little more than a
+ * check of each proxy's transform. The bounds are also kept in a bvh, which culls scenes of many
+ * proxies without testing each one, and finds what a ray hits for picking on the CPU. Proxy ids
+ * stay valid until removed. Not thread-safe.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "math/bvh.h"
+#include "math/math_types.h"
+#include "renderer/renderer_types.inl"
+
+struct transform_hierarchy;
+
+/** @brief Scenes of at least this many proxies are culled through the bvh rather than box by box. */
+#define RENDER_SCENE_BVH_MIN_PROXIES 1024
+
+/** @brief The distance the bvh fattens bounds by, so proxies moving less need not be reinserted. */
+#define RENDER_SCENE_BVH_MARGIN 0.1f
+
+/** @brief The render scene structure. */
+typedef struct render_scene {
+    /** @brief The most proxies the scene can hold. */
+    u32 capacity;
+    /** @brief The number of live proxies. */
+    u32 count;
+    /** @brief One past the highest id ever in use, so the ids which must be looked at. */
+    u32 used_count;
+    /** @brief The first free id, or INVALID_ID if the scene is full. */
+    u32 free_head;
+
+    /** @brief The geometry of each proxy. */
+    geometry** geometries;
+    /** @brief The model matrix of each proxy, as of the last update. */
+    mat4* models;
+    /** @brief The id of the transform each proxy follows. */
+    u32* transform_ids;
+    /** @brief The unique id of each proxy, such as of the object it belongs to, for picking. */
+    u32* unique_ids;
+    /** @brief For free ids, the next free id. */
+    u32* next_free;
+    /** @brief Flags for each proxy, indicating if it is live or needs its bounds recomputing. */
+    u8* flags;
+    /** @brief The world-space centre and half-extents of each proxy, as the six arrays of an aabb_soa. */
+    f32* bounds;
+    /** @brief One bit per proxy, set if it was inside the frustum at the last cull. */
+    u64* visibility;
+    /** @brief The bvh holding the bounds of every proxy updated since it was added. */
+    bvh tree;
+    /** @brief The id of each proxy's leaf in tree, or INVALID_ID if it has not been updated yet. */
+    u32* leaf_ids;
+
+    /** @brief Indicates if a proxy was added, removed or moved since the visible list was built. */
+    b8 visible_dirty;
+    /** @brief Indicates if last_frustum holds the frustum of the last cull. */
+    b8 frustum_valid;
+    /** @brief The frustum of the last cull. */
+    frustum last_frustum;
+    /** @brief The render data of every live proxy inside the frustum, as of the last update. Darray. */
+    geometry_render_data* visible;
+} render_scene;
+
+/**
+ * @brief Creates a new render scene. Should be called twice; once to obtain the memory amount
+ * required (passing memory=0), and a second time with memory being set to an allocated block.
+ *
+ * @param capacity The most proxies the scene should hold.
+ * @param memory_requirement A pointer to hold the required memory for the scene.
+ * @param memory An allocated block of memory, or 0 if just obtaining the requirement.
+ * @param out_scene A pointer to hold the render scene.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 render_scene_create(u32 capacity, u64* memory_requirement, void* memory, render_scene* out_scene);
+
+/**
+ * @brief Destroys the given render scene. The memory passed at creation is not freed.
+ *
+ * @param scene A pointer to the scene to be destroyed.
+ */
+KAPI void render_scene_destroy(render_scene* scene);
+
+/**
+ * @brief Adds a proxy drawing the given geometry wherever the given transform is. Its model and
+ * bounds are worked out at the next update.
+ *
+ * @param scene A pointer to the scene.
+ * @param g A pointer to the geometry to be drawn.
+ * @param transform_id The id of the transform the proxy follows, in the hierarchy passed to updates.
+ * @param unique_id The unique id of the proxy, such as of the object it belongs to.
+ * @return The id of the new proxy, or INVALID_ID if the scene is full.
+ */
+KAPI u32 render_scene_proxy_add(render_scene* scene, geometry* g, u32 transform_id, u32 unique_id);
+
+/**
+ * @brief Removes the given proxy. Its id may be reused by the next proxy added.
+ *
+ * @param scene A pointer to the scene.
+ * @param id The id of the proxy.
+ * @return True on success; false if the id is not in use.
+ */
+KAPI b8 render_scene_proxy_remove(render_scene* scene, u32 id);
+
+/**
+ * @brief Marks the given proxy to have its model and bounds recomputed at the next update, even
+ * if its transform did not move, such as after its geometry changed shape.
+ *
+ * @param scene A pointer to the scene.
+ * @param id The id of the proxy.
+ */
+KAPI void render_scene_proxy_dirty(render_scene* scene, u32 id);
+
+/**
+ * @brief Removes every proxy from the scene.
+ *
+ * @param scene A pointer to the scene.
+ */
+KAPI void render_scene_clear(render_scene* scene);
+
+/**
+ * @brief Brings the scene up to date. Recomputes the model and bounds of each proxy whose transform's
+ * world matrix changed in the last update of the hierarchy, and then, only if anything moved or the
+ * frustum differs from the last one, culls the proxies and rebuilds the visible list. Scenes of
+ * RENDER_SCENE_BVH_MIN_PROXIES or more are culled through the bvh. Should be
+ * called once after each update of the hierarchy, so no change is missed.
+ *
+ * @param scene A pointer to the scene.
+ * @param transforms A constant pointer to the hierarchy holding the transforms the proxies follow.
+ * @param f A constant pointer to the frustum to cull against.
+ * @return True if the visible list was rebuilt; false if it is as it was.
+ */
+KAPI b8 render_scene_update(render_scene* scene, const struct transform_hierarchy* transforms, const frustum* f);
+
+/**
+ * @brief Finds the proxy whose bounds, as of the last update, the given ray hits first.
+ *
+ * @param scene A constant pointer to the scene.
+ * @param r The ray, such as from ray_from_screen.
+ * @param max_distance The farthest along the ray to search.
+ * @param out_distance A pointer to hold the distance along the ray to the hit. Optional.
+ * @return The id of the proxy hit, or INVALID_ID if none is.
+ */
+KAPI u32 render_scene_raycast(const render_scene* scene, ray r, f32 max_distance, f32* out_distance);
+
+/**
+ * @brief Finds every proxy inside the frustum at the last cull whose bounds, as of the last update,
+ * the given ray hits, such as the few which may be under the cursor, in no particular order.
+ *
+ * @param scene A constant pointer to the scene.
+ * @param r The ray, such as from ray_from_screen.
+ * @param max_distance The farthest along the ray to search.
+ * @param out_hits A pointer to a darray the render data of each proxy hit is pushed onto.
+ * @return The number of proxies hit.
+ */
+KAPI u32 render_scene_ray_query(const render_scene* scene, ray r, f32 max_distance, geometry_render_data** out_hits);
+
+/**
+ * @brief Obtains the render data of every live proxy inside the frustum, as of the last update.
+ * Stays valid, and owned by the scene, until the next update.
+ *
+ * @param scene A pointer to the scene.
+ * @return A darray of render data, in order of proxy id.
+ */
+KAPI geometry_render_data* render_scene_visible_get(render_scene* scene);
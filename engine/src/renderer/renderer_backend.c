@@ -9,34 +9,54 @@ b8 renderer_backend_create(renderer_backend_type type, renderer_backend* out_ren
         out_renderer_backend->shutdown = vulkan_renderer_backend_shutdown;
         out_renderer_backend->begin_frame = vulkan_renderer_backend_begin_frame;
         out_renderer_backend->end_frame = vulkan_renderer_backend_end_frame;
+        out_renderer_backend->latency_wait = vulkan_renderer_backend_latency_wait;
         out_renderer_backend->viewport_set = vulkan_renderer_viewport_set;
         out_renderer_backend->viewport_reset = vulkan_renderer_viewport_reset;
         out_renderer_backend->scissor_set = vulkan_renderer_scissor_set;
         out_renderer_backend->scissor_reset = vulkan_renderer_scissor_reset;
+        out_renderer_backend->resolution_scale_supported = vulkan_renderer_resolution_scale_supported;
+        out_renderer_backend->resolution_scale_begin = vulkan_renderer_resolution_scale_begin;
+        out_renderer_backend->resolution_scale_end = vulkan_renderer_resolution_scale_end;
         out_renderer_backend->renderpass_begin = vulkan_renderer_renderpass_begin;
         out_renderer_backend->renderpass_end = vulkan_renderer_renderpass_end;
+        out_renderer_backend->renderpass_begin_parallel = vulkan_renderer_renderpass_begin_parallel;
+        out_renderer_backend->parallel_recording_supported = vulkan_renderer_parallel_recording_supported;
         out_renderer_backend->resized = vulkan_renderer_backend_on_resized;
         out_renderer_backend->draw_geometry = vulkan_renderer_draw_geometry;
+        out_renderer_backend->draw_geometry_batch = vulkan_renderer_draw_geometry_batch;
+        out_renderer_backend->draw_geometry_batches = vulkan_renderer_draw_geometry_batches;
+        out_renderer_backend->draw_batch_cull_set = vulkan_renderer_draw_batch_cull_set;
+        out_renderer_backend->dispatch = vulkan_renderer_dispatch;
+        out_renderer_backend->barrier = vulkan_renderer_barrier;
         out_renderer_backend->texture_create = vulkan_renderer_texture_create;
+        out_renderer_backend->texture_create_staged = vulkan_renderer_texture_create_staged;
+        out_renderer_backend->texture_format_supported = vulkan_renderer_texture_format_supported;
         out_renderer_backend->texture_destroy = vulkan_renderer_texture_destroy;
         out_renderer_backend->texture_create_writeable = vulkan_renderer_texture_create_writeable;
         out_renderer_backend->texture_resize = vulkan_renderer_texture_resize;
         out_renderer_backend->texture_write_data = vulkan_renderer_texture_write_data;
+        out_renderer_backend->texture_write_region = vulkan_renderer_texture_write_region;
         out_renderer_backend->texture_read_data = vulkan_renderer_texture_read_data;
         out_renderer_backend->texture_read_pixel = vulkan_renderer_texture_read_pixel;
+        out_renderer_backend->texture_read_pixel_async = vulkan_renderer_texture_read_pixel_async;
         out_renderer_backend->create_geometry = vulkan_renderer_create_geometry;
         out_renderer_backend->destroy_geometry = vulkan_renderer_destroy_geometry;
+        out_renderer_backend->geometry_skin_create = vulkan_renderer_geometry_skin_create;
+        out_renderer_backend->geometry_skin_destroy = vulkan_renderer_geometry_skin_destroy;
+        out_renderer_backend->geometry_skins_update = vulkan_renderer_geometry_skins_update;
 
         out_renderer_backend->shader_create = vulkan_renderer_shader_create;
         out_renderer_backend->shader_destroy = vulkan_renderer_shader_destroy;
         out_renderer_backend->shader_set_uniform = vulkan_renderer_set_uniform;
         out_renderer_backend->shader_initialize = vulkan_renderer_shader_initialize;
+        out_renderer_backend->shader_reload = vulkan_renderer_shader_reload;
         out_renderer_backend->shader_use = vulkan_renderer_shader_use;
         out_renderer_backend->shader_bind_globals = vulkan_renderer_shader_bind_globals;
         out_renderer_backend->shader_bind_instance = vulkan_renderer_shader_bind_instance;
 
         out_renderer_backend->shader_apply_globals = vulkan_renderer_shader_apply_globals;
         out_renderer_backend->shader_apply_instance = vulkan_renderer_shader_apply_instance;
+        out_renderer_backend->shader_apply_local = vulkan_renderer_shader_apply_local;
         out_renderer_backend->shader_acquire_instance_resources = vulkan_renderer_shader_acquire_instance_resources;
         out_renderer_backend->shader_release_instance_resources = vulkan_renderer_shader_release_instance_resources;
 
@@ -53,6 +73,7 @@ b8 renderer_backend_create(renderer_backend_type type, renderer_backend* out_ren
         out_renderer_backend->window_attachment_index_get = vulkan_renderer_window_attachment_index_get;
         out_renderer_backend->window_attachment_count_get = vulkan_renderer_window_attachment_count_get;
         out_renderer_backend->is_multithreaded = vulkan_renderer_is_multithreaded;
+        out_renderer_backend->bindless_supported = vulkan_renderer_bindless_supported;
 
         out_renderer_backend->renderbuffer_create_internal = vulkan_buffer_create_internal;
         out_renderer_backend->renderbuffer_destroy_internal = vulkan_buffer_destroy_internal;
@@ -66,6 +87,7 @@ b8 renderer_backend_create(renderer_backend_type type, renderer_backend* out_ren
         out_renderer_backend->renderbuffer_load_range = vulkan_buffer_load_range;
         out_renderer_backend->renderbuffer_copy_range = vulkan_buffer_copy_range;
         out_renderer_backend->renderbuffer_draw = vulkan_buffer_draw;
+        out_renderer_backend->renderbuffer_draw_indirect = vulkan_buffer_draw_indirect;
 
         return true;
     }
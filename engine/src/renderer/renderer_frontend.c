@@ -1,10 +1,18 @@
 #include "renderer_frontend.h"
 
 #include "renderer_backend.h"
+#include "resolution_scale.h"
 
+#include "core/counters.h"
+#include "core/katomic.h"
 #include "core/logger.h"
+#include "core/profiler.h"
+#include "core/metrics.h"
 #include "core/kmemory.h"
+#include "core/ksemaphore.h"
+#include "core/kthread.h"
 #include "containers/freelist.h"
+#include "containers/mpmc_queue.h"
 #include "math/kmath.h"
 #include "platform/platform.h"
 
@@ -15,6 +23,7 @@
 #include "systems/shader_system.h"
 #include "systems/camera_system.h"
 #include "systems/render_view_system.h"
+#include "systems/job_system.h"
 
 // TODO: temporary
 #include "core/kstring.h"
@@ -22,6 +31,23 @@
 
 // TODO: end temporary
 
+/** @brief The most commands which can wait for the render thread at once. Must be a power of 2. */
+#define RENDER_COMMAND_QUEUE_CAPACITY 256
+
+typedef b8 (*pfn_render_command)(void* args);
+
+// Work for the render thread, from any other thread. The issuer waits for it to be run, so the
+// command and its arguments live on the issuer's stack.
+typedef struct render_command {
+    // Runs the command, or 0 to stop the render thread.
+    pfn_render_command run;
+    void* args;
+    // Signalled once the command has run, or 0 to set done instead.
+    ksemaphore* signal;
+    b8 result;
+    b8 done;
+} render_command;
+
 typedef struct renderer_system_state {
     renderer_backend backend;
     // The number of render targets. Typically lines up with the amount of swapchain images.
@@ -36,11 +62,85 @@ typedef struct renderer_system_state {
     // The current number of frames since the last resize operation.'
     // Only set if resizing = true. Otherwise 0.
     u8 frames_since_resize;
+
+    // Counter ids for geometry draws and renderpasses begun.
+    u32 draw_calls_counter;
+    u32 renderpasses_counter;
+
+    // Indicates if frames are drawn, and the backend is used, only on the render thread.
+    b8 render_thread_running;
+    // The commands for the render thread to run, in the order issued. Lock-free, as any thread may
+    // issue them.
+    mpmc_queue commands;
+    // Counts the commands not yet taken by the render thread, which waits on it.
+    ksemaphore commands_pending;
+    // Signalled once a command issued by the thread frames are submitted from has run.
+    ksemaphore command_done;
+    // Signalled by the render thread once it has drawn a frame, or started or stopped.
+    ksemaphore frame_drawn;
+    // The command drawing the frame on the render thread, if one is in flight. Its arguments are the packet.
+    render_command frame_command;
+    // Indicates if a frame was submitted to the render thread and not yet waited on.
+    b8 frame_in_flight;
+    // Whether the last frame drawn on the render thread succeeded.
+    b8 frame_result;
+
+    // Picks the scale the views marked resolution_scaled render at, from the GPU time of the frames before.
+    resolution_scale_controller resolution;
+    // The scale the next frame is drawn at. Written once a frame is done, so never while one is drawn.
+    f32 resolution_scale;
 } renderer_system_state;
 
 static renderer_system_state* state_ptr;
 
-b8 renderer_system_initialize(u64* memory_requirement, void* state, const char* application_name) {
+// Set on the thread frames are submitted from, the only one which waits on the render thread's frames.
+static _Thread_local b8 is_submit_thread;
+// Set on the render thread, which runs commands as they are issued.
+static _Thread_local b8 is_render_thread;
+
+static b8 frame_finish(void);
+
+// Waits for the frame on the render thread, if called from the thread frames are submitted from
+// while one is in flight. Called before anything changes what a frame may be drawing with. The
+// render thread itself, and job threads recording for it, go straight on.
+static void frame_sync(void) {
+    if (state_ptr && state_ptr->frame_in_flight && is_submit_thread) {
+        frame_finish();
+    }
+}
+
+// Hands the given command to the render thread, waiting for room in the queue if it is full.
+static void command_push(render_command* command) {
+    while (!mpmc_queue_try_push(&state_ptr->commands, &command)) {
+        platform_sleep(0);
+    }
+    ksemaphore_signal(&state_ptr->commands_pending);
+}
+
+static b8 command_is_done(void* user_data) {
+    return katomic_load_acquire(&((render_command*)user_data)->done);
+}
+
+// Runs the given command on the render thread, after anything issued before it, and waits for it.
+// Run right away if there is no render thread, or this is it. Other threads run jobs while they
+// wait, so a job issuing commands never holds up one the render thread is waiting on.
+static b8 command_execute(pfn_render_command run, void* args) {
+    if (!state_ptr || is_render_thread || !katomic_load_acquire(&state_ptr->render_thread_running)) {
+        return run(args);
+    }
+    render_command command = {run, args, 0, false, false};
+    if (is_submit_thread) {
+        command.signal = &state_ptr->command_done;
+        command_push(&command);
+        ksemaphore_wait(&state_ptr->command_done, KSEMAPHORE_WAIT_INFINITE);
+    } else {
+        command_push(&command);
+        job_system_wait_for(command_is_done, &command);
+    }
+    return command.result;
+}
+
+b8 renderer_system_initialize(u64* memory_requirement, void* state, const char* application_name, const renderer_swapchain_config* swapchain, const renderer_resolution_config* resolution) {
     *memory_requirement = sizeof(renderer_system_state);
     if (state == 0) {
         return true;
@@ -52,6 +152,8 @@ b8 renderer_system_initialize(u64* memory_requirement, void* state, const char*
     state_ptr->framebuffer_height = 720;
     state_ptr->resizing = false;
     state_ptr->frames_since_resize = 0;
+    state_ptr->draw_calls_counter = counter_register("renderer.draw_calls", COUNTER_TYPE_COUNTER);
+    state_ptr->renderpasses_counter = counter_register("renderer.renderpasses", COUNTER_TYPE_COUNTER);
 
     // TODO: make this configurable.
     renderer_backend_create(RENDERER_BACKEND_TYPE_VULKAN, &state_ptr->backend);
@@ -59,6 +161,7 @@ b8 renderer_system_initialize(u64* memory_requirement, void* state, const char*
 
     renderer_backend_config renderer_config = {};
     renderer_config.application_name = application_name;
+    renderer_config.swapchain = *swapchain;
 
     // Initialize the backend.
     if (!state_ptr->backend.initialize(&state_ptr->backend, &renderer_config, &state_ptr->window_render_target_count)) {
@@ -66,11 +169,23 @@ b8 renderer_system_initialize(u64* memory_requirement, void* state, const char*
         return false;
     }
 
+    renderer_resolution_config resolution_config = *resolution;
+    if (resolution_config.enabled && !state_ptr->backend.resolution_scale_supported()) {
+        KWARN("The renderer backend cannot upscale the window, so dynamic resolution is disabled.");
+        resolution_config.enabled = false;
+    }
+    resolution_scale_controller_create(&resolution_config, &state_ptr->resolution);
+    state_ptr->resolution_scale = 1.0f;
+    if (resolution_config.enabled) {
+        KINFO("Dynamic resolution scales to between %.2f and 1 to keep frames within %.2fms on the GPU.", state_ptr->resolution.config.min_scale, state_ptr->resolution.config.target_frame_ms);
+    }
+
     return true;
 }
 
 void renderer_system_shutdown(void* state) {
     if (state_ptr) {
+        renderer_render_thread_stop();
         state_ptr->backend.shutdown(&state_ptr->backend);
     }
     state_ptr = 0;
@@ -89,9 +204,19 @@ void renderer_on_resized(u16 width, u16 height) {
     }
 }
 
-b8 renderer_draw_frame(render_packet* packet) {
-    state_ptr->backend.frame_number++;
+static b8 latency_wait_command(void* args) {
+    state_ptr->backend.latency_wait(&state_ptr->backend);
+    return true;
+}
+
+void renderer_latency_wait(void) {
+    frame_sync();
+    command_execute(latency_wait_command, 0);
+}
 
+// Applies a resize once enough frames have passed since the last one. Returns false if the frame
+// should be skipped while waiting for the resize to settle.
+static b8 frame_resize_apply(void) {
     // Make sure the window is not currently being resized by waiting a designated
     // number of frames after the last resize operation before performing the backend updates.
     if (state_ptr->resizing) {
@@ -113,21 +238,45 @@ b8 renderer_draw_frame(render_packet* packet) {
             // Skip rendering the frame and try again next time.
             // NOTE: Simulate a frame being "drawn" at 60 FPS.
             platform_sleep(16);
-            return true;
+            return false;
         }
     }
+    return true;
+}
 
+// Records and submits a frame. Touches nothing but the backend and the views of the packet.
+static b8 frame_draw(render_packet* packet) {
+    KPROFILE_ZONE("renderer_draw_frame");
     // If the begin frame returned successfully, mid-frame operations may continue.
     if (state_ptr->backend.begin_frame(&state_ptr->backend, packet->delta_time)) {
         u8 attachment_index = state_ptr->backend.window_attachment_index_get();
 
-        // Render each view.
+        // Skinned geometries take this frame's pose before any view draws them.
+        if (packet->skin_count) {
+            state_ptr->backend.geometry_skins_update(packet->skin_count, packet->skins);
+        }
+
+        // Render each view. Runs of views at the resolution scale are upscaled before the next which is not.
+        f32 scale = state_ptr->resolution_scale;
+        b8 scaling = false;
         for (u32 i = 0; i < packet->view_count; ++i) {
+            b8 scaled = packet->views[i].view->resolution_scaled && scale < 1.0f;
+            if (scaled != scaling) {
+                if (scaled) {
+                    state_ptr->backend.resolution_scale_begin(scale);
+                } else {
+                    state_ptr->backend.resolution_scale_end();
+                }
+                scaling = scaled;
+            }
             if (!render_view_system_on_render(packet->views[i].view, &packet->views[i], state_ptr->backend.frame_number, attachment_index)) {
                 KERROR("Error rendering view index %i.", i);
                 return false;
             }
         }
+        if (scaling) {
+            state_ptr->backend.resolution_scale_end();
+        }
 
         // End the frame. If this fails, it is likely unrecoverable.
         b8 result = state_ptr->backend.end_frame(&state_ptr->backend, packet->delta_time);
@@ -137,10 +286,170 @@ b8 renderer_draw_frame(render_packet* packet) {
             return false;
         }
     }
+    return true;
+}
+
+// Reports the GPU time of each view of the given packet, as of the last frame to have completed,
+// and picks the resolution scale of the next frame from it.
+static void frame_gpu_times_record(const render_packet* packet) {
+    f64 scaled_ms = 0;
+    f64 other_ms = 0;
+    for (u32 i = 0; i < packet->view_count; ++i) {
+        const render_view* view = packet->views[i].view;
+        f64 gpu_time = renderer_view_gpu_time_get(view);
+        metrics_gpu_time_record(view->name, gpu_time);
+        if (view->resolution_scaled) {
+            scaled_ms += gpu_time;
+        } else {
+            other_ms += gpu_time;
+        }
+    }
+    state_ptr->resolution_scale = resolution_scale_update(&state_ptr->resolution, scaled_ms, other_ms);
+}
+
+// Counts the frame and applies any resize, returning false if the frame should be skipped.
+static b8 frame_prepare_command(void* args) {
+    state_ptr->backend.frame_number++;
+    return frame_resize_apply();
+}
+
+b8 renderer_draw_frame(render_packet* packet) {
+    frame_sync();
+    if (!command_execute(frame_prepare_command, 0)) {
+        return true;
+    }
+    if (!frame_draw(packet)) {
+        return false;
+    }
+    frame_gpu_times_record(packet);
+    return true;
+}
+
+static b8 frame_draw_command(void* args) {
+    return frame_draw(args);
+}
+
+static u32 render_thread_run(void* params) {
+    is_render_thread = true;
+    // Started.
+    ksemaphore_signal(&state_ptr->frame_drawn);
+    while (true) {
+        ksemaphore_wait(&state_ptr->commands_pending, KSEMAPHORE_WAIT_INFINITE);
+        render_command* command;
+        if (!mpmc_queue_try_pop(&state_ptr->commands, &command)) {
+            // Every command is counted once pushed, so should never be here.
+            continue;
+        }
+        if (!command->run) {
+            break;
+        }
+        // Nothing is touched once done is set, as the issuer may have moved on.
+        ksemaphore* signal = command->signal;
+        command->result = command->run(command->args);
+        if (signal) {
+            ksemaphore_signal(signal);
+        } else {
+            katomic_store_release(&command->done, true);
+        }
+    }
+    // Stopped.
+    ksemaphore_signal(&state_ptr->frame_drawn);
+    return 0;
+}
 
+b8 renderer_render_thread_start(void) {
+    if (!state_ptr || state_ptr->render_thread_running) {
+        return state_ptr != 0;
+    }
+    if (!mpmc_queue_create(sizeof(render_command*), RENDER_COMMAND_QUEUE_CAPACITY, 0, &state_ptr->commands)) {
+        KERROR("renderer_render_thread_start failed to create the command queue.");
+        return false;
+    }
+    if (!ksemaphore_create(&state_ptr->commands_pending, RENDER_COMMAND_QUEUE_CAPACITY, 0) ||
+        !ksemaphore_create(&state_ptr->command_done, 1, 0) ||
+        !ksemaphore_create(&state_ptr->frame_drawn, 1, 0)) {
+        KERROR("renderer_render_thread_start failed to create the render thread semaphores.");
+        return false;
+    }
+    kthread thread;
+    if (!kthread_create(render_thread_run, 0, true, &thread)) {
+        KERROR("renderer_render_thread_start failed to create the render thread. Frames are drawn on the calling thread.");
+        ksemaphore_destroy(&state_ptr->commands_pending);
+        ksemaphore_destroy(&state_ptr->command_done);
+        ksemaphore_destroy(&state_ptr->frame_drawn);
+        mpmc_queue_destroy(&state_ptr->commands);
+        return false;
+    }
+    ksemaphore_wait(&state_ptr->frame_drawn, KSEMAPHORE_WAIT_INFINITE);
+    is_submit_thread = true;
+    state_ptr->frame_result = true;
+    katomic_store_release(&state_ptr->render_thread_running, true);
+    KINFO("Frames are drawn, and renderer resources created, on a render thread.");
     return true;
 }
 
+void renderer_render_thread_stop(void) {
+    if (!state_ptr || !state_ptr->render_thread_running) {
+        return;
+    }
+    frame_sync();
+    // Stops once everything issued before it has run.
+    render_command stop = {0};
+    command_push(&stop);
+    ksemaphore_wait(&state_ptr->frame_drawn, KSEMAPHORE_WAIT_INFINITE);
+    katomic_store_release(&state_ptr->render_thread_running, false);
+    ksemaphore_destroy(&state_ptr->commands_pending);
+    ksemaphore_destroy(&state_ptr->command_done);
+    ksemaphore_destroy(&state_ptr->frame_drawn);
+    mpmc_queue_destroy(&state_ptr->commands);
+}
+
+b8 renderer_frame_submit(render_packet* packet) {
+    if (!state_ptr->render_thread_running) {
+        return renderer_draw_frame(packet);
+    }
+
+    frame_sync();
+    if (!command_execute(frame_prepare_command, 0)) {
+        return true;
+    }
+    state_ptr->frame_command = (render_command){frame_draw_command, packet, &state_ptr->frame_drawn, false, false};
+    state_ptr->frame_in_flight = true;
+    command_push(&state_ptr->frame_command);
+    return true;
+}
+
+static b8 frame_finish(void) {
+    KPROFILE_ZONE("renderer_frame_wait");
+    ksemaphore_wait(&state_ptr->frame_drawn, KSEMAPHORE_WAIT_INFINITE);
+    state_ptr->frame_in_flight = false;
+    // A failure is kept for renderer_frame_wait to report.
+    b8 result = state_ptr->frame_command.result;
+    if (result) {
+        frame_gpu_times_record(state_ptr->frame_command.args);
+    } else {
+        state_ptr->frame_result = false;
+    }
+    return result;
+}
+
+b8 renderer_frame_wait(void) {
+    if (!state_ptr || !state_ptr->render_thread_running) {
+        return true;
+    }
+    if (state_ptr->frame_in_flight) {
+        frame_finish();
+    }
+    // A failure is reported once, to whoever waits next.
+    b8 result = state_ptr->frame_result;
+    state_ptr->frame_result = true;
+    return result;
+}
+
+void renderer_frame_sync(void) {
+    frame_sync();
+}
+
 void renderer_viewport_set(vec4 rect) {
     state_ptr->backend.viewport_set(rect);
 }
@@ -157,47 +466,289 @@ void renderer_scissor_reset() {
     state_ptr->backend.scissor_reset();
 }
 
+typedef struct texture_create_args {
+    const u8* pixels;
+    struct texture* texture;
+} texture_create_args;
+
+static b8 texture_create_command(void* params) {
+    texture_create_args* args = params;
+    state_ptr->backend.texture_create(args->pixels, args->texture);
+    return true;
+}
+
 void renderer_texture_create(const u8* pixels, struct texture* texture) {
-    state_ptr->backend.texture_create(pixels, texture);
+    texture_create_args args = {pixels, texture};
+    command_execute(texture_create_command, &args);
+}
+
+typedef struct texture_create_staged_args {
+    renderbuffer* staging;
+    struct texture* texture;
+} texture_create_staged_args;
+
+static b8 texture_create_staged_command(void* params) {
+    texture_create_staged_args* args = params;
+    state_ptr->backend.texture_create_staged(args->staging, args->texture);
+    return true;
+}
+
+void renderer_texture_create_staged(renderbuffer* staging, struct texture* texture) {
+    texture_create_staged_args args = {staging, texture};
+    command_execute(texture_create_staged_command, &args);
+}
+
+b8 renderer_texture_format_supported(texture_format format) {
+    if (format == TEXTURE_FORMAT_UNCOMPRESSED) {
+        return true;
+    }
+    return state_ptr && state_ptr->backend.texture_format_supported(format);
+}
+
+typedef struct texture_destroy_args {
+    struct texture* texture;
+} texture_destroy_args;
+
+static b8 texture_destroy_command(void* params) {
+    texture_destroy_args* args = params;
+    state_ptr->backend.texture_destroy(args->texture);
+    return true;
 }
 
 void renderer_texture_destroy(struct texture* texture) {
-    state_ptr->backend.texture_destroy(texture);
+    texture_destroy_args args = {texture};
+    command_execute(texture_destroy_command, &args);
+}
+
+typedef struct texture_create_writeable_args {
+    texture* t;
+} texture_create_writeable_args;
+
+static b8 texture_create_writeable_command(void* params) {
+    texture_create_writeable_args* args = params;
+    state_ptr->backend.texture_create_writeable(args->t);
+    return true;
 }
 
 void renderer_texture_create_writeable(texture* t) {
-    state_ptr->backend.texture_create_writeable(t);
+    texture_create_writeable_args args = {t};
+    command_execute(texture_create_writeable_command, &args);
+}
+
+typedef struct texture_write_data_args {
+    texture* t;
+    u32 offset;
+    u32 size;
+    const u8* pixels;
+} texture_write_data_args;
+
+static b8 texture_write_data_command(void* params) {
+    texture_write_data_args* args = params;
+    state_ptr->backend.texture_write_data(args->t, args->offset, args->size, args->pixels);
+    return true;
 }
 
 void renderer_texture_write_data(texture* t, u32 offset, u32 size, const u8* pixels) {
-    state_ptr->backend.texture_write_data(t, offset, size, pixels);
+    texture_write_data_args args = {t, offset, size, pixels};
+    command_execute(texture_write_data_command, &args);
+}
+
+typedef struct texture_write_region_args {
+    texture* t;
+    u32 x;
+    u32 y;
+    u32 width;
+    u32 height;
+    const u8* pixels;
+} texture_write_region_args;
+
+static b8 texture_write_region_command(void* params) {
+    texture_write_region_args* args = params;
+    state_ptr->backend.texture_write_region(args->t, args->x, args->y, args->width, args->height, args->pixels);
+    return true;
+}
+
+void renderer_texture_write_region(texture* t, u32 x, u32 y, u32 width, u32 height, const u8* pixels) {
+    texture_write_region_args args = {t, x, y, width, height, pixels};
+    command_execute(texture_write_region_command, &args);
+}
+
+typedef struct texture_read_data_args {
+    texture* t;
+    u32 offset;
+    u32 size;
+    void** out_memory;
+} texture_read_data_args;
+
+static b8 texture_read_data_command(void* params) {
+    texture_read_data_args* args = params;
+    state_ptr->backend.texture_read_data(args->t, args->offset, args->size, args->out_memory);
+    return true;
 }
 
 void renderer_texture_read_data(texture* t, u32 offset, u32 size, void** out_memory) {
-    state_ptr->backend.texture_read_data(t, offset, size, out_memory);
+    texture_read_data_args args = {t, offset, size, out_memory};
+    command_execute(texture_read_data_command, &args);
+}
+
+typedef struct texture_read_pixel_args {
+    texture* t;
+    u32 x;
+    u32 y;
+    u8** out_rgba;
+} texture_read_pixel_args;
+
+static b8 texture_read_pixel_command(void* params) {
+    texture_read_pixel_args* args = params;
+    state_ptr->backend.texture_read_pixel(args->t, args->x, args->y, args->out_rgba);
+    return true;
 }
 
 void renderer_texture_read_pixel(texture* t, u32 x, u32 y, u8** out_rgba) {
-    state_ptr->backend.texture_read_pixel(t, x, y, out_rgba);
+    texture_read_pixel_args args = {t, x, y, out_rgba};
+    command_execute(texture_read_pixel_command, &args);
+}
+
+typedef struct texture_read_pixel_async_args {
+    texture* t;
+    u32 x;
+    u32 y;
+    u8* out_rgba;
+} texture_read_pixel_async_args;
+
+static b8 texture_read_pixel_async_command(void* params) {
+    texture_read_pixel_async_args* args = params;
+    return state_ptr->backend.texture_read_pixel_async(args->t, args->x, args->y, args->out_rgba);
+}
+
+b8 renderer_texture_read_pixel_async(texture* t, u32 x, u32 y, u8* out_rgba) {
+    texture_read_pixel_async_args args = {t, x, y, out_rgba};
+    return command_execute(texture_read_pixel_async_command, &args);
+}
+
+typedef struct texture_resize_args {
+    texture* t;
+    u32 new_width;
+    u32 new_height;
+} texture_resize_args;
+
+static b8 texture_resize_command(void* params) {
+    texture_resize_args* args = params;
+    state_ptr->backend.texture_resize(args->t, args->new_width, args->new_height);
+    return true;
 }
 
 void renderer_texture_resize(texture* t, u32 new_width, u32 new_height) {
-    state_ptr->backend.texture_resize(t, new_width, new_height);
+    texture_resize_args args = {t, new_width, new_height};
+    command_execute(texture_resize_command, &args);
+}
+
+typedef struct create_geometry_args {
+    geometry* geometry;
+    u32 vertex_size;
+    u32 vertex_count;
+    const void* vertices;
+    u32 index_size;
+    u32 index_count;
+    const void* indices;
+} create_geometry_args;
+
+static b8 create_geometry_command(void* params) {
+    create_geometry_args* args = params;
+    return state_ptr->backend.create_geometry(args->geometry, args->vertex_size, args->vertex_count, args->vertices, args->index_size, args->index_count, args->indices);
 }
 
 b8 renderer_create_geometry(geometry* geometry, u32 vertex_size, u32 vertex_count, const void* vertices, u32 index_size, u32 index_count, const void* indices) {
-    return state_ptr->backend.create_geometry(geometry, vertex_size, vertex_count, vertices, index_size, index_count, indices);
+    create_geometry_args args = {geometry, vertex_size, vertex_count, vertices, index_size, index_count, indices};
+    return command_execute(create_geometry_command, &args);
+}
+
+typedef struct destroy_geometry_args {
+    geometry* geometry;
+} destroy_geometry_args;
+
+static b8 destroy_geometry_command(void* params) {
+    destroy_geometry_args* args = params;
+    state_ptr->backend.destroy_geometry(args->geometry);
+    return true;
 }
 
 void renderer_destroy_geometry(geometry* geometry) {
-    state_ptr->backend.destroy_geometry(geometry);
+    destroy_geometry_args args = {geometry};
+    command_execute(destroy_geometry_command, &args);
+}
+
+typedef struct geometry_skin_create_args {
+    geometry* geometry;
+    u32 vertex_count;
+    const vertex_3d_skinned* vertices;
+} geometry_skin_create_args;
+
+static b8 geometry_skin_create_command(void* params) {
+    geometry_skin_create_args* args = params;
+    return state_ptr->backend.geometry_skin_create(args->geometry, args->vertex_count, args->vertices);
+}
+
+b8 renderer_geometry_skin_create(geometry* geometry, u32 vertex_count, const vertex_3d_skinned* vertices) {
+    geometry_skin_create_args args = {geometry, vertex_count, vertices};
+    return command_execute(geometry_skin_create_command, &args);
+}
+
+typedef struct geometry_skin_destroy_args {
+    geometry* geometry;
+} geometry_skin_destroy_args;
+
+static b8 geometry_skin_destroy_command(void* params) {
+    geometry_skin_destroy_args* args = params;
+    state_ptr->backend.geometry_skin_destroy(args->geometry);
+    return true;
+}
+
+void renderer_geometry_skin_destroy(geometry* geometry) {
+    geometry_skin_destroy_args args = {geometry};
+    command_execute(geometry_skin_destroy_command, &args);
 }
 
 void renderer_draw_geometry(geometry_render_data* data) {
+    counter_add(state_ptr->draw_calls_counter, 1);
     state_ptr->backend.draw_geometry(data);
 }
 
+void renderer_draw_geometry_batch(u32 count, const geometry_render_data* data, const u32* highlights) {
+    if (!count) {
+        return;
+    }
+    // Counted as the one draw call it is on the host.
+    counter_add(state_ptr->draw_calls_counter, 1);
+    state_ptr->backend.draw_geometry_batch(count, data, highlights);
+}
+
+void renderer_draw_geometry_batches(u32 run_count, const renderer_batch_run* runs) {
+    if (!run_count) {
+        return;
+    }
+    // Each run is counted as the one draw call it would be on its own.
+    counter_add(state_ptr->draw_calls_counter, run_count);
+    state_ptr->backend.draw_geometry_batches(run_count, runs);
+}
+
+void renderer_draw_batch_cull_set(mat4 projection, mat4 view) {
+    state_ptr->backend.draw_batch_cull_set(projection, view);
+}
+
+void renderer_dispatch(u32 group_count_x, u32 group_count_y, u32 group_count_z) {
+    if (!group_count_x || !group_count_y || !group_count_z) {
+        return;
+    }
+    state_ptr->backend.dispatch(group_count_x, group_count_y, group_count_z);
+}
+
+void renderer_barrier(renderer_barrier_type type) {
+    state_ptr->backend.barrier(type);
+}
+
 b8 renderer_renderpass_begin(renderpass* pass, render_target* target) {
+    counter_add(state_ptr->renderpasses_counter, 1);
     return state_ptr->backend.renderpass_begin(pass, target);
 }
 
@@ -205,16 +756,89 @@ b8 renderer_renderpass_end(renderpass* pass) {
     return state_ptr->backend.renderpass_end(pass);
 }
 
+b8 renderer_renderpass_begin_parallel(renderpass* pass, render_target* target) {
+    counter_add(state_ptr->renderpasses_counter, 1);
+    return state_ptr->backend.renderpass_begin_parallel(pass, target);
+}
+
+b8 renderer_parallel_recording_supported() {
+    return state_ptr->backend.parallel_recording_supported();
+}
+
+f32 renderer_resolution_scale_get(void) {
+    return state_ptr ? state_ptr->resolution_scale : 1.0f;
+}
+
+f64 renderer_view_gpu_time_get(const render_view* view) {
+    f64 total = 0;
+    if (view) {
+        for (u32 i = 0; i < view->renderpass_count; ++i) {
+            total += view->passes[i].gpu_time_ms;
+        }
+    }
+    return total;
+}
+
+typedef struct shader_create_args {
+    shader* s;
+    const shader_config* config;
+    renderpass* pass;
+    u8 stage_count;
+    const char** stage_filenames;
+    shader_stage* stages;
+} shader_create_args;
+
+static b8 shader_create_command(void* params) {
+    shader_create_args* args = params;
+    return state_ptr->backend.shader_create(args->s, args->config, args->pass, args->stage_count, args->stage_filenames, args->stages);
+}
+
 b8 renderer_shader_create(shader* s, const shader_config* config, renderpass* pass, u8 stage_count, const char** stage_filenames, shader_stage* stages) {
-    return state_ptr->backend.shader_create(s, config, pass, stage_count, stage_filenames, stages);
+    shader_create_args args = {s, config, pass, stage_count, stage_filenames, stages};
+    return command_execute(shader_create_command, &args);
+}
+
+typedef struct shader_destroy_args {
+    shader* s;
+} shader_destroy_args;
+
+static b8 shader_destroy_command(void* params) {
+    shader_destroy_args* args = params;
+    state_ptr->backend.shader_destroy(args->s);
+    return true;
 }
 
 void renderer_shader_destroy(shader* s) {
-    state_ptr->backend.shader_destroy(s);
+    shader_destroy_args args = {s};
+    command_execute(shader_destroy_command, &args);
+}
+
+typedef struct shader_initialize_args {
+    shader* s;
+} shader_initialize_args;
+
+static b8 shader_initialize_command(void* params) {
+    shader_initialize_args* args = params;
+    return state_ptr->backend.shader_initialize(args->s);
 }
 
 b8 renderer_shader_initialize(shader* s) {
-    return state_ptr->backend.shader_initialize(s);
+    shader_initialize_args args = {s};
+    return command_execute(shader_initialize_command, &args);
+}
+
+typedef struct shader_reload_args {
+    shader* s;
+} shader_reload_args;
+
+static b8 shader_reload_command(void* params) {
+    shader_reload_args* args = params;
+    return state_ptr->backend.shader_reload(args->s);
+}
+
+b8 renderer_shader_reload(shader* s) {
+    shader_reload_args args = {s};
+    return command_execute(shader_reload_command, &args);
 }
 
 b8 renderer_shader_use(shader* s) {
@@ -237,36 +861,112 @@ b8 renderer_shader_apply_instance(shader* s, b8 needs_update) {
     return state_ptr->backend.shader_apply_instance(s, needs_update);
 }
 
+b8 renderer_shader_apply_local(shader* s) {
+    return state_ptr->backend.shader_apply_local(s);
+}
+
+typedef struct shader_acquire_instance_resources_args {
+    shader* s;
+    texture_map** maps;
+    u32* out_instance_id;
+} shader_acquire_instance_resources_args;
+
+static b8 shader_acquire_instance_resources_command(void* params) {
+    shader_acquire_instance_resources_args* args = params;
+    return state_ptr->backend.shader_acquire_instance_resources(args->s, args->maps, args->out_instance_id);
+}
+
 b8 renderer_shader_acquire_instance_resources(shader* s, texture_map** maps, u32* out_instance_id) {
-    return state_ptr->backend.shader_acquire_instance_resources(s, maps, out_instance_id);
+    shader_acquire_instance_resources_args args = {s, maps, out_instance_id};
+    return command_execute(shader_acquire_instance_resources_command, &args);
+}
+
+typedef struct shader_release_instance_resources_args {
+    shader* s;
+    u32 instance_id;
+} shader_release_instance_resources_args;
+
+static b8 shader_release_instance_resources_command(void* params) {
+    shader_release_instance_resources_args* args = params;
+    return state_ptr->backend.shader_release_instance_resources(args->s, args->instance_id);
 }
 
 b8 renderer_shader_release_instance_resources(shader* s, u32 instance_id) {
-    return state_ptr->backend.shader_release_instance_resources(s, instance_id);
+    shader_release_instance_resources_args args = {s, instance_id};
+    return command_execute(shader_release_instance_resources_command, &args);
 }
 
 b8 renderer_set_uniform(shader* s, shader_uniform* uniform, const void* value) {
     return state_ptr->backend.shader_set_uniform(s, uniform, value);
 }
 
+typedef struct texture_map_acquire_resources_args {
+    struct texture_map* map;
+} texture_map_acquire_resources_args;
+
+static b8 texture_map_acquire_resources_command(void* params) {
+    texture_map_acquire_resources_args* args = params;
+    return state_ptr->backend.texture_map_acquire_resources(args->map);
+}
+
 b8 renderer_texture_map_acquire_resources(struct texture_map* map) {
-    return state_ptr->backend.texture_map_acquire_resources(map);
+    texture_map_acquire_resources_args args = {map};
+    return command_execute(texture_map_acquire_resources_command, &args);
+}
+
+typedef struct texture_map_release_resources_args {
+    struct texture_map* map;
+} texture_map_release_resources_args;
+
+static b8 texture_map_release_resources_command(void* params) {
+    texture_map_release_resources_args* args = params;
+    state_ptr->backend.texture_map_release_resources(args->map);
+    return true;
 }
 
 void renderer_texture_map_release_resources(struct texture_map* map) {
-    state_ptr->backend.texture_map_release_resources(map);
+    texture_map_release_resources_args args = {map};
+    command_execute(texture_map_release_resources_command, &args);
+}
+
+typedef struct render_target_create_args {
+    u8 attachment_count;
+    render_target_attachment* attachments;
+    renderpass* pass;
+    u32 width;
+    u32 height;
+    render_target* out_target;
+} render_target_create_args;
+
+static b8 render_target_create_command(void* params) {
+    render_target_create_args* args = params;
+    state_ptr->backend.render_target_create(args->attachment_count, args->attachments, args->pass, args->width, args->height, args->out_target);
+    return true;
 }
 
 void renderer_render_target_create(u8 attachment_count, render_target_attachment* attachments, renderpass* pass, u32 width, u32 height, render_target* out_target) {
-    state_ptr->backend.render_target_create(attachment_count, attachments, pass, width, height, out_target);
+    render_target_create_args args = {attachment_count, attachments, pass, width, height, out_target};
+    command_execute(render_target_create_command, &args);
 }
 
-void renderer_render_target_destroy(render_target* target, b8 free_internal_memory) {
-    state_ptr->backend.render_target_destroy(target, free_internal_memory);
+typedef struct render_target_destroy_args {
+    render_target* target;
+    b8 free_internal_memory;
+} render_target_destroy_args;
+
+static b8 render_target_destroy_command(void* params) {
+    render_target_destroy_args* args = params;
+    state_ptr->backend.render_target_destroy(args->target, args->free_internal_memory);
 
-    if (free_internal_memory) {
-        kzero_memory(target, sizeof(render_target));
+    if (args->free_internal_memory) {
+        kzero_memory(args->target, sizeof(render_target));
     }
+    return true;
+}
+
+void renderer_render_target_destroy(render_target* target, b8 free_internal_memory) {
+    render_target_destroy_args args = {target, free_internal_memory};
+    command_execute(render_target_destroy_command, &args);
 }
 
 texture* renderer_window_attachment_get(u8 index) {
@@ -285,78 +985,117 @@ u8 renderer_window_attachment_count_get() {
     return state_ptr->backend.window_attachment_count_get();
 }
 
-b8 renderer_renderpass_create(const renderpass_config* config, renderpass* out_renderpass) {
-    if (!config) {
+typedef struct renderpass_create_args {
+    const renderpass_config* config;
+    renderpass* out_renderpass;
+} renderpass_create_args;
+
+static b8 renderpass_create_command(void* params) {
+    renderpass_create_args* args = params;
+    if (!args->config) {
         KERROR("Renderpass config is required.");
         return false;
     }
 
-    if (config->render_target_count == 0) {
+    if (args->config->render_target_count == 0) {
         KERROR("Cannot have a renderpass target count of 0, ya dingus.");
         return false;
     }
 
-    out_renderpass->render_target_count = config->render_target_count;
-    out_renderpass->targets = kallocate(sizeof(render_target) * out_renderpass->render_target_count, MEMORY_TAG_ARRAY);
-    out_renderpass->clear_flags = config->clear_flags;
-    out_renderpass->clear_colour = config->clear_colour;
-    out_renderpass->render_area = config->render_area;
+    args->out_renderpass->render_target_count = args->config->render_target_count;
+    args->out_renderpass->targets = kallocate(sizeof(render_target) * args->out_renderpass->render_target_count, MEMORY_TAG_ARRAY);
+    args->out_renderpass->clear_flags = args->config->clear_flags;
+    args->out_renderpass->clear_colour = args->config->clear_colour;
+    args->out_renderpass->render_area = args->config->render_area;
 
     // Copy over config for each target.
-    for (u32 t = 0; t < out_renderpass->render_target_count; ++t) {
-        render_target* target = &out_renderpass->targets[t];
-        target->attachment_count = config->target.attachment_count;
+    for (u32 t = 0; t < args->out_renderpass->render_target_count; ++t) {
+        render_target* target = &args->out_renderpass->targets[t];
+        target->attachment_count = args->config->target.attachment_count;
         target->attachments = kallocate(sizeof(render_target_attachment) * target->attachment_count, MEMORY_TAG_ARRAY);
 
         // Each attachment for the target.
         for (u32 a = 0; a < target->attachment_count; ++a) {
             render_target_attachment* attachment = &target->attachments[a];
-            render_target_attachment_config* attachment_config = &config->target.attachments[a];
+            render_target_attachment_config* attachment_config = &args->config->target.attachments[a];
 
             attachment->source = attachment_config->source;
             attachment->type = attachment_config->type;
             attachment->load_operation = attachment_config->load_operation;
             attachment->store_operation = attachment_config->store_operation;
+            attachment->present_after = attachment_config->present_after;
+            attachment->transient = attachment_config->transient;
+            attachment->alias_slot = attachment_config->alias_slot;
             attachment->texture = 0;
         }
     }
 
-    return state_ptr->backend.renderpass_create(config, out_renderpass);
+    return state_ptr->backend.renderpass_create(args->config, args->out_renderpass);
 }
 
-void renderer_renderpass_destroy(renderpass* pass) {
+b8 renderer_renderpass_create(const renderpass_config* config, renderpass* out_renderpass) {
+    renderpass_create_args args = {config, out_renderpass};
+    return command_execute(renderpass_create_command, &args);
+}
+
+typedef struct renderpass_destroy_args {
+    renderpass* pass;
+} renderpass_destroy_args;
+
+static b8 renderpass_destroy_command(void* params) {
+    renderpass_destroy_args* args = params;
     // Destroy its rendertargets.
-    for (u32 i = 0; i < pass->render_target_count; ++i) {
-        renderer_render_target_destroy(&pass->targets[i], true);
+    for (u32 i = 0; i < args->pass->render_target_count; ++i) {
+        renderer_render_target_destroy(&args->pass->targets[i], true);
     }
     
-    state_ptr->backend.renderpass_destroy(pass);
+    state_ptr->backend.renderpass_destroy(args->pass);
+    return true;
+}
+
+void renderer_renderpass_destroy(renderpass* pass) {
+    renderpass_destroy_args args = {pass};
+    command_execute(renderpass_destroy_command, &args);
 }
 
 b8 renderer_is_multithreaded() {
-    return state_ptr->backend.is_multithreaded();
+    // With a render thread, resource functions may be called from any thread, as they run there.
+    return state_ptr->backend.is_multithreaded() || katomic_load_acquire(&state_ptr->render_thread_running);
 }
 
-b8 renderer_renderbuffer_create(renderbuffer_type type, u64 total_size, b8 use_freelist, renderbuffer* out_buffer) {
-    if (!out_buffer) {
+b8 renderer_bindless_supported() {
+    return state_ptr->backend.bindless_supported();
+}
+
+typedef struct renderbuffer_create_args {
+    renderbuffer_type type;
+    u64 total_size;
+    b8 use_freelist;
+    renderbuffer* out_buffer;
+} renderbuffer_create_args;
+
+static b8 renderbuffer_create_command(void* params) {
+    renderbuffer_create_args* args = params;
+    if (!args->out_buffer) {
         KERROR("renderer_renderbuffer_create requires a valid pointer to hold the created buffer.");
         return false;
     }
 
-    kzero_memory(out_buffer, sizeof(renderbuffer));
+    kzero_memory(args->out_buffer, sizeof(renderbuffer));
 
-    out_buffer->type = type;
-    out_buffer->total_size = total_size;
+    args->out_buffer->type = args->type;
+    args->out_buffer->total_size = args->total_size;
 
     // Create the freelist, if needed.
-    if (use_freelist) {
-        freelist_create(total_size, &out_buffer->freelist_memory_requirement, 0, 0);
-        out_buffer->freelist_block = kallocate(out_buffer->freelist_memory_requirement, MEMORY_TAG_RENDERER);
-        freelist_create(total_size, &out_buffer->freelist_memory_requirement, out_buffer->freelist_block, &out_buffer->buffer_freelist);
+    if (args->use_freelist) {
+        // Segregated fit keeps allocation fast as the number of geometries and shader instances grows.
+        freelist_create_with_mode(args->total_size, FREELIST_MODE_SEGREGATED_FIT, &args->out_buffer->freelist_memory_requirement, 0, 0);
+        args->out_buffer->freelist_block = kallocate(args->out_buffer->freelist_memory_requirement, MEMORY_TAG_RENDERER);
+        freelist_create_with_mode(args->total_size, FREELIST_MODE_SEGREGATED_FIT, &args->out_buffer->freelist_memory_requirement, args->out_buffer->freelist_block, &args->out_buffer->buffer_freelist);
     }
 
     // Create the internal buffer from the backend.
-    if (!state_ptr->backend.renderbuffer_create_internal(out_buffer)) {
+    if (!state_ptr->backend.renderbuffer_create_internal(args->out_buffer)) {
         KFATAL("Unable to create backing buffer for renderbuffer. Application cannot continue.");
         return false;
     }
@@ -364,118 +1103,274 @@ b8 renderer_renderbuffer_create(renderbuffer_type type, u64 total_size, b8 use_f
     return true;
 }
 
-void renderer_renderbuffer_destroy(renderbuffer* buffer) {
-    if (buffer) {
-        if (buffer->freelist_memory_requirement > 0) {
-            freelist_destroy(&buffer->buffer_freelist);
-            kfree(buffer->freelist_block, buffer->freelist_memory_requirement, MEMORY_TAG_RENDERER);
-            buffer->freelist_memory_requirement = 0;
+b8 renderer_renderbuffer_create(renderbuffer_type type, u64 total_size, b8 use_freelist, renderbuffer* out_buffer) {
+    renderbuffer_create_args args = {type, total_size, use_freelist, out_buffer};
+    return command_execute(renderbuffer_create_command, &args);
+}
+
+typedef struct renderbuffer_destroy_args {
+    renderbuffer* buffer;
+} renderbuffer_destroy_args;
+
+static b8 renderbuffer_destroy_command(void* params) {
+    renderbuffer_destroy_args* args = params;
+    if (args->buffer) {
+        if (args->buffer->freelist_memory_requirement > 0) {
+            freelist_destroy(&args->buffer->buffer_freelist);
+            kfree(args->buffer->freelist_block, args->buffer->freelist_memory_requirement, MEMORY_TAG_RENDERER);
+            args->buffer->freelist_memory_requirement = 0;
         }
 
         // Free up the backend resources.
-        state_ptr->backend.renderbuffer_destroy_internal(buffer);
-        buffer->internal_data = 0;
+        state_ptr->backend.renderbuffer_destroy_internal(args->buffer);
+        args->buffer->internal_data = 0;
     }
+    return true;
 }
 
-b8 renderer_renderbuffer_bind(renderbuffer* buffer, u64 offset) {
-    if (!buffer) {
+void renderer_renderbuffer_destroy(renderbuffer* buffer) {
+    renderbuffer_destroy_args args = {buffer};
+    command_execute(renderbuffer_destroy_command, &args);
+}
+
+typedef struct renderbuffer_bind_args {
+    renderbuffer* buffer;
+    u64 offset;
+} renderbuffer_bind_args;
+
+static b8 renderbuffer_bind_command(void* params) {
+    renderbuffer_bind_args* args = params;
+    if (!args->buffer) {
         KERROR("renderer_renderbuffer_bind requires a valid pointer to a buffer.");
         return false;
     }
 
-    return state_ptr->backend.renderbuffer_bind(buffer, offset);
+    return state_ptr->backend.renderbuffer_bind(args->buffer, args->offset);
+}
+
+b8 renderer_renderbuffer_bind(renderbuffer* buffer, u64 offset) {
+    renderbuffer_bind_args args = {buffer, offset};
+    return command_execute(renderbuffer_bind_command, &args);
+}
+
+typedef struct renderbuffer_unbind_args {
+    renderbuffer* buffer;
+} renderbuffer_unbind_args;
+
+static b8 renderbuffer_unbind_command(void* params) {
+    renderbuffer_unbind_args* args = params;
+    return state_ptr->backend.renderbuffer_unbind(args->buffer);
 }
 
 b8 renderer_renderbuffer_unbind(renderbuffer* buffer) {
-    return state_ptr->backend.renderbuffer_unbind(buffer);
+    renderbuffer_unbind_args args = {buffer};
+    return command_execute(renderbuffer_unbind_command, &args);
+}
+
+typedef struct renderbuffer_map_memory_args {
+    renderbuffer* buffer;
+    u64 offset;
+    u64 size;
+    void* result;
+} renderbuffer_map_memory_args;
+
+static b8 renderbuffer_map_memory_command(void* params) {
+    renderbuffer_map_memory_args* args = params;
+    args->result = state_ptr->backend.renderbuffer_map_memory(args->buffer, args->offset, args->size);
+    return true;
 }
 
 void* renderer_renderbuffer_map_memory(renderbuffer* buffer, u64 offset, u64 size) {
-    return state_ptr->backend.renderbuffer_map_memory(buffer, offset, size);
+    renderbuffer_map_memory_args args = {buffer, offset, size};
+    command_execute(renderbuffer_map_memory_command, &args);
+    return args.result;
+}
+
+typedef struct renderbuffer_unmap_memory_args {
+    renderbuffer* buffer;
+    u64 offset;
+    u64 size;
+} renderbuffer_unmap_memory_args;
+
+static b8 renderbuffer_unmap_memory_command(void* params) {
+    renderbuffer_unmap_memory_args* args = params;
+    state_ptr->backend.renderbuffer_unmap_memory(args->buffer, args->offset, args->size);
+    return true;
 }
 
 void renderer_renderbuffer_unmap_memory(renderbuffer* buffer, u64 offset, u64 size) {
-    state_ptr->backend.renderbuffer_unmap_memory(buffer, offset, size);
+    renderbuffer_unmap_memory_args args = {buffer, offset, size};
+    command_execute(renderbuffer_unmap_memory_command, &args);
+}
+
+typedef struct renderbuffer_flush_args {
+    renderbuffer* buffer;
+    u64 offset;
+    u64 size;
+} renderbuffer_flush_args;
+
+static b8 renderbuffer_flush_command(void* params) {
+    renderbuffer_flush_args* args = params;
+    return state_ptr->backend.renderbuffer_flush(args->buffer, args->offset, args->size);
 }
 
 b8 renderer_renderbuffer_flush(renderbuffer* buffer, u64 offset, u64 size) {
-    return state_ptr->backend.renderbuffer_flush(buffer, offset, size);
+    renderbuffer_flush_args args = {buffer, offset, size};
+    return command_execute(renderbuffer_flush_command, &args);
+}
+
+typedef struct renderbuffer_read_args {
+    renderbuffer* buffer;
+    u64 offset;
+    u64 size;
+    void** out_memory;
+} renderbuffer_read_args;
+
+static b8 renderbuffer_read_command(void* params) {
+    renderbuffer_read_args* args = params;
+    return state_ptr->backend.renderbuffer_read(args->buffer, args->offset, args->size, args->out_memory);
 }
 
 b8 renderer_renderbuffer_read(renderbuffer* buffer, u64 offset, u64 size, void** out_memory) {
-    return state_ptr->backend.renderbuffer_read(buffer, offset, size, out_memory);
+    renderbuffer_read_args args = {buffer, offset, size, out_memory};
+    return command_execute(renderbuffer_read_command, &args);
 }
 
-b8 renderer_renderbuffer_resize(renderbuffer* buffer, u64 new_total_size) {
+typedef struct renderbuffer_resize_args {
+    renderbuffer* buffer;
+    u64 new_total_size;
+} renderbuffer_resize_args;
+
+static b8 renderbuffer_resize_command(void* params) {
+    renderbuffer_resize_args* args = params;
     // Sanity check.
-    if (new_total_size <= buffer->total_size) {
+    if (args->new_total_size <= args->buffer->total_size) {
         KERROR("renderer_renderbuffer_resize requires that new size be larger than the old. Not doing this could lead to data loss.");
         return false;
     }
 
-    if (buffer->freelist_memory_requirement > 0) {
+    if (args->buffer->freelist_memory_requirement > 0) {
         // Resize the freelist first, if used.
         u64 new_memory_requirement = 0;
-        freelist_resize(&buffer->buffer_freelist, &new_memory_requirement, 0, 0, 0);
+        freelist_resize(&args->buffer->buffer_freelist, &new_memory_requirement, 0, args->new_total_size, 0);
         void* new_block = kallocate(new_memory_requirement, MEMORY_TAG_RENDERER);
         void* old_block = 0;
-        if (!freelist_resize(&buffer->buffer_freelist, &new_memory_requirement, new_block, new_total_size, &old_block)) {
+        if (!freelist_resize(&args->buffer->buffer_freelist, &new_memory_requirement, new_block, args->new_total_size, &old_block)) {
             KERROR("renderer_renderbuffer_resize failed to resize internal free list.");
             kfree(new_block, new_memory_requirement, MEMORY_TAG_RENDERER);
             return false;
         }
 
         // Clean up the old memory, then assign the new properties over.
-        kfree(old_block, buffer->freelist_memory_requirement, MEMORY_TAG_RENDERER);
-        buffer->freelist_memory_requirement = new_memory_requirement;
-        buffer->freelist_block = new_block;
+        kfree(old_block, args->buffer->freelist_memory_requirement, MEMORY_TAG_RENDERER);
+        args->buffer->freelist_memory_requirement = new_memory_requirement;
+        args->buffer->freelist_block = new_block;
     }
 
-    b8 result = state_ptr->backend.renderbuffer_resize(buffer, new_total_size);
+    b8 result = state_ptr->backend.renderbuffer_resize(args->buffer, args->new_total_size);
     if (result) {
-        buffer->total_size = new_total_size;
+        args->buffer->total_size = args->new_total_size;
     } else {
         KERROR("Failed to resize internal renderbuffer resources.");
     }
     return result;
 }
 
-b8 renderer_renderbuffer_allocate(renderbuffer* buffer, u64 size, u64* out_offset) {
-    if (!buffer || !size || !out_offset) {
+b8 renderer_renderbuffer_resize(renderbuffer* buffer, u64 new_total_size) {
+    renderbuffer_resize_args args = {buffer, new_total_size};
+    return command_execute(renderbuffer_resize_command, &args);
+}
+
+typedef struct renderbuffer_allocate_args {
+    renderbuffer* buffer;
+    u64 size;
+    u64* out_offset;
+} renderbuffer_allocate_args;
+
+static b8 renderbuffer_allocate_command(void* params) {
+    renderbuffer_allocate_args* args = params;
+    if (!args->buffer || !args->size || !args->out_offset) {
         KERROR("vulkan_buffer_allocate requires valid buffer, a nonzero size and valid pointer to hold offset.");
         return false;
     }
 
-    if (buffer->freelist_memory_requirement == 0) {
+    if (args->buffer->freelist_memory_requirement == 0) {
         KWARN("vulkan_buffer_allocate called on a buffer not using freelists. Offset will not be valid. Call renderer_renderbuffer_load_range instead.");
-        *out_offset = 0;
+        *args->out_offset = 0;
         return true;
     }
-    return freelist_allocate_block(&buffer->buffer_freelist, size, out_offset);
+    return freelist_allocate_block(&args->buffer->buffer_freelist, args->size, args->out_offset);
 }
 
-b8 renderer_renderbuffer_free(renderbuffer* buffer, u64 size, u64 offset) {
-    if (!buffer || !size) {
+b8 renderer_renderbuffer_allocate(renderbuffer* buffer, u64 size, u64* out_offset) {
+    renderbuffer_allocate_args args = {buffer, size, out_offset};
+    return command_execute(renderbuffer_allocate_command, &args);
+}
+
+typedef struct renderbuffer_free_args {
+    renderbuffer* buffer;
+    u64 size;
+    u64 offset;
+} renderbuffer_free_args;
+
+static b8 renderbuffer_free_command(void* params) {
+    renderbuffer_free_args* args = params;
+    if (!args->buffer || !args->size) {
         KERROR("vulkan_buffer_free requires valid buffer and a nonzero size.");
         return false;
     }
 
-    if (buffer->freelist_memory_requirement == 0) {
+    if (args->buffer->freelist_memory_requirement == 0) {
         KWARN("vulkan_buffer_allocate called on a buffer not using freelists. Nothing was done.");
         return true;
     }
-    return freelist_free_block(&buffer->buffer_freelist, size, offset);
+    return freelist_free_block(&args->buffer->buffer_freelist, args->size, args->offset);
+}
+
+b8 renderer_renderbuffer_free(renderbuffer* buffer, u64 size, u64 offset) {
+    renderbuffer_free_args args = {buffer, size, offset};
+    return command_execute(renderbuffer_free_command, &args);
+}
+
+typedef struct renderbuffer_load_range_args {
+    renderbuffer* buffer;
+    u64 offset;
+    u64 size;
+    const void* data;
+} renderbuffer_load_range_args;
+
+static b8 renderbuffer_load_range_command(void* params) {
+    renderbuffer_load_range_args* args = params;
+    return state_ptr->backend.renderbuffer_load_range(args->buffer, args->offset, args->size, args->data);
 }
 
 b8 renderer_renderbuffer_load_range(renderbuffer* buffer, u64 offset, u64 size, const void* data) {
-    return state_ptr->backend.renderbuffer_load_range(buffer, offset, size, data);
+    renderbuffer_load_range_args args = {buffer, offset, size, data};
+    return command_execute(renderbuffer_load_range_command, &args);
+}
+
+typedef struct renderbuffer_copy_range_args {
+    renderbuffer* source;
+    u64 source_offset;
+    renderbuffer* dest;
+    u64 dest_offset;
+    u64 size;
+} renderbuffer_copy_range_args;
+
+static b8 renderbuffer_copy_range_command(void* params) {
+    renderbuffer_copy_range_args* args = params;
+    return state_ptr->backend.renderbuffer_copy_range(args->source, args->source_offset, args->dest, args->dest_offset, args->size);
 }
 
 b8 renderer_renderbuffer_copy_range(renderbuffer* source, u64 source_offset, renderbuffer* dest, u64 dest_offset, u64 size) {
-    return state_ptr->backend.renderbuffer_copy_range(source, source_offset, dest, dest_offset, size);
+    renderbuffer_copy_range_args args = {source, source_offset, dest, dest_offset, size};
+    return command_execute(renderbuffer_copy_range_command, &args);
 }
 
 b8 renderer_renderbuffer_draw(renderbuffer* buffer, u64 offset, u32 element_count, b8 bind_only) {
     return state_ptr->backend.renderbuffer_draw(buffer, offset, element_count, bind_only);
 }
+
+b8 renderer_renderbuffer_draw_indirect(renderbuffer* buffer, u64 offset) {
+    return state_ptr->backend.renderbuffer_draw_indirect(buffer, offset);
+}
@@ -26,9 +26,11 @@ struct shader_uniform;
  * @param memory_requirement A pointer to hold the memory requirement for this system.
  * @param state A block of memory to hold state data, or 0 if obtaining memory requirement.
  * @param application_name The name of the application.
+ * @param swapchain A pointer to the swapchain configuration. Its present mode must not be RENDERER_PRESENT_MODE_DEFAULT.
+ * @param resolution A pointer to the dynamic resolution configuration.
  * @return True on success; otherwise false.
  */
-b8 renderer_system_initialize(u64* memory_requirement, void* state, const char* application_name);
+b8 renderer_system_initialize(u64* memory_requirement, void* state, const char* application_name, const renderer_swapchain_config* swapchain, const renderer_resolution_config* resolution);
 
 /**
  * @brief Shuts the renderer system/frontend down.
@@ -53,6 +55,51 @@ void renderer_on_resized(u16 width, u16 height);
  */
 b8 renderer_draw_frame(render_packet* packet);
 
+/**
+ * @brief Starts drawing frames on a render thread of their own, so the thread submitting them can
+ * go on to the next frame while one is recorded and submitted. From then on, resource functions
+ * are queued for the render thread to run between frames, in the order they are called, and wait
+ * for it, so they may be called from any thread. Must be called from the thread frames are
+ * submitted from, which is the only one to wait on the render thread's frames, once the job system
+ * is running, as other threads run jobs while they wait.
+ * @return True if the render thread is running; otherwise false, and frames are drawn on the calling thread.
+ */
+b8 renderer_render_thread_start(void);
+
+/** @brief Waits for the frame and commands on the render thread, then stops it. Frames are drawn on the calling thread after. */
+void renderer_render_thread_stop(void);
+
+/**
+ * @brief Submits the frame described by the given packet. With a render thread, the frame is
+ * handed to it to draw, and the packet and everything it refers to must be left as they are until
+ * renderer_frame_wait returns. Otherwise, draws the frame as renderer_draw_frame does.
+ *
+ * @param packet A pointer to the render packet, which contains data on what should be rendered.
+ * @return True on success; otherwise false.
+ */
+b8 renderer_frame_submit(render_packet* packet);
+
+/**
+ * @brief Waits for the last frame submitted to the render thread to be drawn. Returns at once if
+ * there is no render thread or no frame in flight.
+ * @return True if the frame was drawn, or there was none; otherwise false.
+ */
+b8 renderer_frame_wait(void);
+
+/**
+ * @brief Waits for the frame on the render thread, if there is one, before changing anything it may
+ * be drawing with outside of the renderer, such as what views read while rendering. Renderer
+ * resource functions do this themselves. Does nothing on any thread but the one frames are
+ * submitted from, or when called while rendering.
+ */
+KAPI void renderer_frame_sync(void);
+
+/**
+ * @brief In low-latency mode, waits for the last frame to finish rendering, or to reach the
+ * display where supported. Does nothing otherwise. Should be called before input is gathered.
+ */
+void renderer_latency_wait(void);
+
 /**
  * @brief Sets the renderer viewport to the given rectangle. Must be done within a renderpass.
  *
@@ -87,6 +134,25 @@ void renderer_scissor_reset();
  */
 void renderer_texture_create(const u8* pixels, struct texture* texture);
 
+/**
+ * @brief Creates a new texture from pixels already written to the given staging buffer, such as
+ * by decoding into it, which saves copying them there. The texture takes the buffer, which is
+ * destroyed once the upload is done with it.
+ *
+ * @param staging A pointer to a bound staging buffer, holding the pixels from its start.
+ * @param texture A pointer to the texture to be loaded.
+ */
+void renderer_texture_create_staged(renderbuffer* staging, struct texture* texture);
+
+/**
+ * @brief Indicates if textures can be created in the given format. Uncompressed textures
+ * always can; compressed formats depend on the GPU. Safe to call from any thread.
+ *
+ * @param format The format to check.
+ * @return True if supported; otherwise false, including if the renderer is not running.
+ */
+b8 renderer_texture_format_supported(texture_format format);
+
 /**
  * @brief Destroys the given texture, releasing internal resources from the GPU.
  *
@@ -122,6 +188,18 @@ void renderer_texture_resize(texture* t, u32 new_width, u32 new_height);
  */
 void renderer_texture_write_data(texture* t, u32 offset, u32 size, const u8* pixels);
 
+/**
+ * @brief Writes the given pixels to a rectangle of the provided texture, leaving the rest as it was.
+ *
+ * @param t A pointer to the texture to be written to. NOTE: Must be a writeable texture, written whole at least once.
+ * @param x The first column of the rectangle.
+ * @param y The first row of the rectangle.
+ * @param width The width of the rectangle in pixels.
+ * @param height The height of the rectangle in pixels.
+ * @param pixels The pixels of the rectangle, row by row with no gaps between rows.
+ */
+void renderer_texture_write_region(texture* t, u32 x, u32 y, u32 width, u32 height, const u8* pixels);
+
 /**
  * @brief Reads the given data from the provided texture.
  *
@@ -142,6 +220,19 @@ void renderer_texture_read_data(texture* t, u32 offset, u32 size, void** out_mem
  */
 void renderer_texture_read_pixel(texture* t, u32 x, u32 y, u8** out_rgba);
 
+/**
+ * @brief Copies a pixel from the provided colour attachment texture at the given x/y coordinate
+ * without waiting for it, handing back the pixel copied the last time the current frame slot was in
+ * flight. Must be called outside a renderpass, after the pass rendering to the texture.
+ *
+ * @param t A pointer to the texture to be read from.
+ * @param x The pixel x-coordinate.
+ * @param y The pixel y-coordinate.
+ * @param out_rgba An array of 4 u8s to hold the pixel copied frames earlier, if there is one.
+ * @return True if a pixel copied frames earlier was written to out_rgba; otherwise false.
+ */
+b8 renderer_texture_read_pixel_async(texture* t, u32 x, u32 y, u8* out_rgba);
+
 /**
  * @brief Acquiores GPU resources and uploads geometry data.
  *
@@ -163,6 +254,26 @@ b8 renderer_create_geometry(geometry* geometry, u32 vertex_size, u32 vertex_coun
  */
 void renderer_destroy_geometry(geometry* geometry);
 
+/**
+ * @brief Gives the given geometry a skin, so it is drawn as posed by the palettes of the render
+ * packets it is in. Its vertices are skinned on the GPU each frame it is posed, into its own vertex
+ * range, so it is drawn by any shader as it would be otherwise. It is drawn in the bind pose until
+ * first posed.
+ *
+ * @param geometry A pointer to the geometry, already created with as many vertex_3d_packed vertices.
+ * @param vertex_count The number of vertices.
+ * @param vertices An array of the vertices in the bind pose, with the joints influencing them.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 renderer_geometry_skin_create(geometry* geometry, u32 vertex_count, const vertex_3d_skinned* vertices);
+
+/**
+ * @brief Removes the skin of the given geometry, if it has one. Destroying the geometry removes it too.
+ *
+ * @param geometry A pointer to the geometry.
+ */
+KAPI void renderer_geometry_skin_destroy(geometry* geometry);
+
 /**
  * @brief Draws the given geometry. Should only be called inside a renderpass, within a frame.
  *
@@ -170,6 +281,59 @@ void renderer_destroy_geometry(geometry* geometry);
  */
 void renderer_draw_geometry(geometry_render_data* data);
 
+/**
+ * @brief Draws the given geometries with as few commands as possible, each with its own model matrix
+ * and highlight value, which the bound shader reads from its draw data rather than from push constants.
+ * Should only be called inside a renderpass, within a frame, with a shader using draw data bound.
+ *
+ * @param count The number of geometries to be drawn.
+ * @param data An array of the render data of the geometries to be drawn.
+ * @param highlights An array of the highlight value of each geometry. Optional; all are 0 if not provided.
+ */
+void renderer_draw_geometry_batch(u32 count, const geometry_render_data* data, const u32* highlights);
+
+/**
+ * @brief Draws the given runs of geometries in batches, each run with its own instance of the shader
+ * in use, which must use draw data and have its globals and the instance of each run applied. Within
+ * a renderpass begun with renderer_renderpass_begin_parallel(), the runs are recorded on several threads.
+ * The globals are bound with the draws, so several shaders may draw within one renderpass, such as a
+ * depth prepass before the materials, as long as all were applied before it began. Consecutive runs
+ * of the same instance, such as one material split across batches, bind it once.
+ *
+ * @param run_count The number of runs.
+ * @param runs An array of the runs, drawn in order.
+ */
+void renderer_draw_geometry_batches(u32 run_count, const renderer_batch_run* runs);
+
+/**
+ * @brief Sets the view which geometry drawn in batches this frame is culled against, on the GPU,
+ * where supported: against its frustum, and against the depth of the last frame. Geometry is not
+ * culled in frames where it is not set. Should be called within a frame, before drawing.
+ *
+ * @param projection The projection matrix.
+ * @param view The view matrix.
+ */
+void renderer_draw_batch_cull_set(mat4 projection, mat4 view);
+
+/**
+ * @brief Dispatches the compute shader in use, with its storage bindings. Should only be called
+ * outside of a renderpass, within a frame. What it writes is only seen by later dispatches and
+ * draws once a barrier has been recorded with renderer_barrier().
+ *
+ * @param group_count_x The number of work groups in x.
+ * @param group_count_y The number of work groups in y.
+ * @param group_count_z The number of work groups in z.
+ */
+KAPI void renderer_dispatch(u32 group_count_x, u32 group_count_y, u32 group_count_z);
+
+/**
+ * @brief Records a barrier between compute dispatches and draws, so that what is written before it
+ * is seen after it. Should only be called outside of a renderpass, within a frame.
+ *
+ * @param type The kind of barrier.
+ */
+KAPI void renderer_barrier(renderer_barrier_type type);
+
 /**
  * @brief Begins the given renderpass.
  *
@@ -187,6 +351,43 @@ b8 renderer_renderpass_begin(renderpass* pass, render_target* target);
  */
 b8 renderer_renderpass_end(renderpass* pass);
 
+/**
+ * @brief Begins the given renderpass, for draws made only with renderer_draw_geometry_batches(),
+ * which may then be recorded on several threads. Should only be used if
+ * renderer_parallel_recording_supported().
+ *
+ * @param pass A pointer to the renderpass to begin.
+ * @param target A pointer to the render target to be used.
+ * @return True on success; otherwise false.
+ */
+b8 renderer_renderpass_begin_parallel(renderpass* pass, render_target* target);
+
+/**
+ * @brief Indicates if draws may be recorded on several threads, within renderpasses begun with
+ * renderer_renderpass_begin_parallel().
+ *
+ * @return True if supported; otherwise false.
+ */
+b8 renderer_parallel_recording_supported();
+
+/**
+ * @brief Returns the time the GPU spent on the given view's renderpasses in the most recent frame
+ * to have completed, in milliseconds. This lags the current frame by the number of frames in flight.
+ * Running averages per view are available from metrics_gpu_time.
+ *
+ * @param view A pointer to the view.
+ * @return The time in milliseconds, or 0 if the backend can't time renderpasses.
+ */
+KAPI f64 renderer_view_gpu_time_get(const struct render_view* view);
+
+/**
+ * @brief Returns the fraction of the window's width and height the views marked resolution_scaled
+ * are rendered at in the next frame. Changes only between frames.
+ *
+ * @return The scale, up to 1. Always 1 if dynamic resolution is disabled.
+ */
+KAPI f32 renderer_resolution_scale_get(void);
+
 /**
  * @brief Creates internal shader resources using the provided parameters.
  *
@@ -215,6 +416,16 @@ void renderer_shader_destroy(struct shader* s);
  */
 b8 renderer_shader_initialize(struct shader* s);
 
+/**
+ * @brief Reloads the stage files of an initialized shader and rebuilds its pipeline. The
+ * shader is left as it was if any stage fails. Uniforms, attributes and layouts are kept,
+ * so the new stages must match them.
+ *
+ * @param s A pointer to the shader to be reloaded.
+ * @return True on success; otherwise false.
+ */
+b8 renderer_shader_reload(struct shader* s);
+
 /**
  * @brief Uses the given shader, activating it for updates to attributes, uniforms and such,
  * and for use in draw calls.
@@ -258,6 +469,14 @@ b8 renderer_shader_apply_globals(struct shader* s);
  */
 b8 renderer_shader_apply_instance(struct shader* s, b8 needs_update);
 
+/**
+ * @brief Applies the local data set since the last draw.
+ *
+ * @param s A pointer to the shader to apply the local data for.
+ * @return True on success; otherwise false.
+ */
+b8 renderer_shader_apply_local(struct shader* s);
+
 /**
  * @brief Acquires internal instance-level resources and provides an instance id.
  *
@@ -364,10 +583,17 @@ b8 renderer_renderpass_create(const renderpass_config* config, renderpass* out_r
 void renderer_renderpass_destroy(renderpass* pass);
 
 /**
- * @brief Indicates if the renderer is capable of multi-threading.
+ * @brief Indicates if the renderer is capable of multi-threading, so resource functions may be
+ * called from job threads. True if the backend is, or frames are drawn on a render thread.
  */
 b8 renderer_is_multithreaded();
 
+/**
+ * @brief Indicates if shaders flagged bindless can be created, sampling their instance
+ * textures from the renderer's texture table by index.
+ */
+b8 renderer_bindless_supported();
+
 /**
  * @brief Creates a new renderbuffer to hold data for a given purpose/use. Backed by a
  * renderer-backend-specific buffer resource.
@@ -508,3 +734,14 @@ b8 renderer_renderbuffer_copy_range(renderbuffer* source, u64 source_offset, ren
  * @return True on success; otherwise false.
  */
 b8 renderer_renderbuffer_draw(renderbuffer* buffer, u64 offset, u32 element_count, b8 bind_only);
+
+/**
+ * @brief Draws with the command held in the provided indirect buffer at the given offset, whose counts
+ * may have been written by a compute shader, with a barrier recorded between. No vertex or index buffer
+ * is bound, so the shader in use finds its vertices itself, such as from storage buffers.
+ *
+ * @param buffer A pointer to the indirect buffer holding a renderer_draw_indirect_command.
+ * @param offset The offset in bytes of the command from the beginning of the buffer.
+ * @return True on success; otherwise false.
+ */
+b8 renderer_renderbuffer_draw_indirect(renderbuffer* buffer, u64 offset);
@@ -18,8 +18,22 @@ typedef struct geometry_render_data {
     mat4 model;
     geometry* geometry;
     u32 unique_id;
+    // The level of detail of the geometry to draw, with 0 being the full geometry.
+    u8 lod;
 } geometry_render_data;
 
+/** @brief A run of geometries drawn in a batch with the same shader instance, such as a material. */
+typedef struct renderer_batch_run {
+    /** @brief The id of the instance of the shader in use the geometries are drawn with. */
+    u32 instance_id;
+    /** @brief The number of geometries. */
+    u32 count;
+    /** @brief An array of the render data of the geometries. */
+    const geometry_render_data* geometries;
+    /** @brief An array of the highlight value of each geometry. Optional; all are 0 if not provided. */
+    const u32* highlights;
+} renderer_batch_run;
+
 typedef enum renderer_debug_view_mode {
     RENDERER_VIEW_MODE_DEFAULT = 0,
     RENDERER_VIEW_MODE_LIGHTING = 1,
@@ -34,7 +48,13 @@ typedef enum render_target_attachment_type {
 
 typedef enum render_target_attachment_source {
     RENDER_TARGET_ATTACHMENT_SOURCE_DEFAULT = 0x1,
-    RENDER_TARGET_ATTACHMENT_SOURCE_VIEW = 0x2
+    RENDER_TARGET_ATTACHMENT_SOURCE_VIEW = 0x2,
+    /**
+     * @brief An image of the render view system, shared by every attachment of the same alias slot, so
+     * by passes of different views whose uses of it never overlap. Created when the first view using
+     * it first needs its targets.
+     */
+    RENDER_TARGET_ATTACHMENT_SOURCE_SHARED = 0x4
 } render_target_attachment_source;
 
 typedef enum render_target_attachment_load_operation {
@@ -53,6 +73,10 @@ typedef struct render_target_attachment_config {
     render_target_attachment_load_operation load_operation;
     render_target_attachment_store_operation store_operation;
     b8 present_after;
+    /** @brief True if the contents of the attachment never leave the pass, so it may be lazily allocated. */
+    b8 transient;
+    /** @brief For shared attachments, the alias slot of the image, as assigned by a render graph. */
+    u32 alias_slot;
 } render_target_attachment_config;
 
 typedef struct render_target_config {
@@ -66,6 +90,10 @@ typedef struct render_target_attachment {
     render_target_attachment_load_operation load_operation;
     render_target_attachment_store_operation store_operation;
     b8 present_after;
+    /** @brief True if the contents of the attachment never leave the pass, so it may be lazily allocated. */
+    b8 transient;
+    /** @brief For shared attachments, the alias slot of the image, as assigned by a render graph. */
+    u32 alias_slot;
     struct texture* texture;
 } render_target_attachment;
 
@@ -133,10 +161,29 @@ typedef struct renderpass {
     /** @brief An array of render targets used by this renderpass. */
     render_target* targets;
 
+    /**
+     * @brief The time the GPU spent on this renderpass, in milliseconds, in the most recent frame
+     * to have completed, summed over every time it was begun. 0 if the backend can't time it.
+     */
+    f64 gpu_time_ms;
+
     /** @brief Internal renderpass data */
     void* internal_data;
 } renderpass;
 
+/**
+ * @brief The kinds of execution and memory barrier recorded between compute dispatches and draws,
+ * so that what one writes is seen by the next.
+ */
+typedef enum renderer_barrier_type {
+    /** @brief Storage written by earlier dispatches is read or written by later dispatches. */
+    RENDERER_BARRIER_COMPUTE_TO_COMPUTE,
+    /** @brief Storage written by earlier dispatches is read by later draws, including as vertex, index and indirect data. */
+    RENDERER_BARRIER_COMPUTE_TO_GRAPHICS,
+    /** @brief Storage and attachments written by earlier draws are read or written by later dispatches. */
+    RENDERER_BARRIER_GRAPHICS_TO_COMPUTE
+} renderer_barrier_type;
+
 typedef enum renderbuffer_type {
     /** @brief Buffer is use is unknown. Default, but usually invalid. */
     RENDERBUFFER_TYPE_UNKNOWN,
@@ -148,10 +195,17 @@ typedef enum renderbuffer_type {
     RENDERBUFFER_TYPE_UNIFORM,
     /** @brief Buffer is used for staging purposes (i.e. from host-visible to device-local memory) */
     RENDERBUFFER_TYPE_STAGING,
+    /**
+     * @brief Buffer is used for staging data which the host also reads as it writes it, such as images
+     * decoded in place. Cached for the host where the device allows.
+     */
+    RENDERBUFFER_TYPE_STAGING_CACHED,
     /** @brief Buffer is used for reading purposes (i.e copy to from device local, then read) */
     RENDERBUFFER_TYPE_READ,
     /** @brief Buffer is used for data storage. */
-    RENDERBUFFER_TYPE_STORAGE
+    RENDERBUFFER_TYPE_STORAGE,
+    /** @brief Buffer is used for indirect draw commands, written by the host and by compute shaders. */
+    RENDERBUFFER_TYPE_INDIRECT
 } renderbuffer_type;
 
 typedef struct renderbuffer {
@@ -169,12 +223,97 @@ typedef struct renderbuffer {
     void* internal_data;
 } renderbuffer;
 
+/**
+ * @brief A non-indexed draw read from an indirect buffer, such as one whose counts a compute
+ * shader writes. Laid out to match the commands read by the GPU.
+ */
+typedef struct renderer_draw_indirect_command {
+    /** @brief The number of vertices drawn of each instance. */
+    u32 vertex_count;
+    /** @brief The number of instances drawn. */
+    u32 instance_count;
+    /** @brief The first vertex index. */
+    u32 first_vertex;
+    /** @brief The first instance index. */
+    u32 first_instance;
+} renderer_draw_indirect_command;
+
 /** @brief The generic configuration for a renderer backend. */
+/** @brief How rendered frames are handed to the display. */
+typedef enum renderer_present_mode {
+    /** @brief Follows the application's frame pacing: FIFO when presentation paces frames, otherwise mailbox. */
+    RENDERER_PRESENT_MODE_DEFAULT = 0,
+    /** @brief Waits for each vertical blank, queueing frames. Never tears and draws the least power. Always supported. */
+    RENDERER_PRESENT_MODE_FIFO,
+    /** @brief Replaces the queued frame with each newer one, showing the latest at each vertical blank. Never tears. Falls back to FIFO. */
+    RENDERER_PRESENT_MODE_MAILBOX,
+    /** @brief Presents at once, which may tear, for the lowest latency. Falls back to mailbox, then FIFO. */
+    RENDERER_PRESENT_MODE_IMMEDIATE
+} renderer_present_mode;
+
+/** @brief Configuration of the swapchain, trading latency against throughput and power. */
+typedef struct renderer_swapchain_config {
+    /** @brief How frames are presented. */
+    renderer_present_mode present_mode;
+    /** @brief The number of swapchain images. 0 uses one more than the least the display allows. Clamped to what it allows. */
+    u8 image_count;
+    /** @brief The number of frames which may be in flight at once. 0 uses one less than the image count. Clamped to the backend's limit. */
+    u8 frames_in_flight;
+    /**
+     * @brief Indicates if each frame waits, before gathering input, for the last to finish, or to
+     * reach the display where presents can be waited on. Input is then as fresh as possible when
+     * drawn, at the cost of the CPU and GPU no longer overlapping across frames.
+     */
+    b8 low_latency;
+} renderer_swapchain_config;
+
+/**
+ * @brief The configuration of dynamic resolution, which renders the views marked resolution_scaled
+ * at a fraction of the window's resolution, adjusted from their GPU time to keep frames within a
+ * budget, and upscales them to the window before the views after them are rendered.
+ */
+typedef struct renderer_resolution_config {
+    /** @brief Indicates if the resolution is scaled. Ignored where the backend cannot upscale. */
+    b8 enabled;
+    /** @brief The GPU time each frame should take, in milliseconds. 0 uses 1000 / 60. */
+    f32 target_frame_ms;
+    /** @brief The least the resolution is scaled to, along each axis. 0 uses 0.5. */
+    f32 min_scale;
+} renderer_resolution_config;
+
+/**
+ * @brief How close the device is to running out of the memory it has to give, judged from the
+ * use and budget of its device-local heaps.
+ */
+typedef enum renderer_memory_pressure {
+    /** @brief There is room to spare. */
+    RENDERER_MEMORY_PRESSURE_NONE = 0,
+    /** @brief Most of the budget is in use, so what is not needed should be given back. */
+    RENDERER_MEMORY_PRESSURE_MODERATE,
+    /** @brief Nearly all of the budget is in use, so allocations may soon fail. */
+    RENDERER_MEMORY_PRESSURE_CRITICAL
+} renderer_memory_pressure;
+
 typedef struct renderer_backend_config {
     /** @brief The name of the application */
     const char* application_name;
+    /** @brief The swapchain configuration. The present mode is never RENDERER_PRESENT_MODE_DEFAULT. */
+    renderer_swapchain_config swapchain;
 } renderer_backend_config;
 
+/**
+ * @brief The pose of a skinned geometry for one frame, whose vertices are skinned with it on the GPU
+ * before the frame's views are rendered. Geometries not posed in a frame keep their last pose.
+ */
+typedef struct renderer_skin_update {
+    /** @brief A pointer to the geometry, which must have a skin. */
+    geometry* geometry;
+    /** @brief The number of joints in the palette. */
+    u32 joint_count;
+    /** @brief The joint palette, as computed by skeleton_palette_compute. Must live until the frame is drawn. */
+    const mat4* palette;
+} renderer_skin_update;
+
 /**
  * @brief A generic "interface" for the backend. The renderer backend
  * is what is responsible for making calls to the graphics API such as
@@ -233,6 +372,14 @@ typedef struct renderer_backend {
      */
     b8 (*end_frame)(struct renderer_backend* backend, f32 delta_time);
 
+    /**
+     * @brief In low-latency mode, waits for the last frame to finish rendering, or to reach the
+     * display where presents can be waited on. Does nothing otherwise. Called before input is gathered.
+     *
+     * @param backend A pointer to the generic backend interface.
+     */
+    void (*latency_wait)(struct renderer_backend* backend);
+
     /**
      * @brief Sets the renderer viewport to the given rectangle. Must be done within a renderpass.
      *
@@ -259,6 +406,28 @@ typedef struct renderer_backend {
      */
     void (*scissor_reset)();
 
+    /**
+     * @brief Indicates if what is rendered to part of the window can be upscaled to the whole of it.
+     *
+     * @return True if supported; otherwise false.
+     */
+    b8 (*resolution_scale_supported)();
+
+    /**
+     * @brief Makes the viewport, scissor and their defaults cover the given fraction of the window,
+     * from its top left, for the renderpasses which follow. Must be done outside of a renderpass.
+     *
+     * @param scale The fraction of the window's width and height rendered to, up to 1.
+     */
+    void (*resolution_scale_begin)(f32 scale);
+
+    /**
+     * @brief Upscales the part of the window's colour attachment rendered to since resolution_scale_begin
+     * to the whole of it, and makes the viewport and scissor cover the window again. Must be done
+     * outside of a renderpass.
+     */
+    void (*resolution_scale_end)();
+
     /**
      * @brief Begins a renderpass with the given id.
      *
@@ -276,6 +445,24 @@ typedef struct renderer_backend {
      */
     b8 (*renderpass_end)(renderpass* pass);
 
+    /**
+     * @brief Begins a renderpass whose draws are all made with draw_geometry_batches, which may
+     * record them on several threads.
+     *
+     * @param pass A pointer to the renderpass to begin.
+     * @param target A pointer to the render target to be used.
+     * @return True on success; otherwise false.
+     */
+    b8 (*renderpass_begin_parallel)(renderpass* pass, render_target* target);
+
+    /**
+     * @brief Indicates if draws may be recorded on several threads, within renderpasses begun with
+     * renderpass_begin_parallel.
+     *
+     * @return True if supported; otherwise false.
+     */
+    b8 (*parallel_recording_supported)();
+
     /**
      * @brief Draws the given geometry. Should only be called inside a renderpass, within a frame.
      *
@@ -283,6 +470,54 @@ typedef struct renderer_backend {
      */
     void (*draw_geometry)(geometry_render_data* data);
 
+    /**
+     * @brief Draws the given geometries with as few commands as possible, each with its own model matrix
+     * and highlight value, which the bound shader reads from its draw data rather than from push constants.
+     * Should only be called inside a renderpass, within a frame, with a shader using draw data bound.
+     *
+     * @param count The number of geometries to be drawn.
+     * @param data An array of the render data of the geometries to be drawn.
+     * @param highlights An array of the highlight value of each geometry. Optional; all are 0 if not provided.
+     */
+    void (*draw_geometry_batch)(u32 count, const geometry_render_data* data, const u32* highlights);
+
+    /**
+     * @brief Draws the given runs of geometries in batches, each run with its own instance of the
+     * shader in use, which must use draw data and have its globals and instances applied. Within a
+     * renderpass begun with renderpass_begin_parallel, the runs are recorded on several threads.
+     *
+     * @param run_count The number of runs.
+     * @param runs An array of the runs, drawn in order.
+     */
+    void (*draw_geometry_batches)(u32 run_count, const renderer_batch_run* runs);
+
+    /**
+     * @brief Sets the view which geometry drawn in batches this frame is culled against, on the GPU,
+     * where supported. Geometry is not culled in frames where it is not set.
+     *
+     * @param projection The projection matrix.
+     * @param view The view matrix.
+     */
+    void (*draw_batch_cull_set)(mat4 projection, mat4 view);
+
+    /**
+     * @brief Dispatches the compute shader in use, with its storage bindings. Should only be called
+     * outside of a renderpass, within a frame.
+     *
+     * @param group_count_x The number of work groups in x.
+     * @param group_count_y The number of work groups in y.
+     * @param group_count_z The number of work groups in z.
+     */
+    void (*dispatch)(u32 group_count_x, u32 group_count_y, u32 group_count_z);
+
+    /**
+     * @brief Records a barrier between compute dispatches and draws. Should only be called outside of
+     * a renderpass, within a frame.
+     *
+     * @param type The kind of barrier.
+     */
+    void (*barrier)(renderer_barrier_type type);
+
     /**
      * @brief Creates a Vulkan-specific texture, acquiring internal resources as needed.
      *
@@ -291,6 +526,23 @@ typedef struct renderer_backend {
      */
     void (*texture_create)(const u8* pixels, struct texture* texture);
 
+    /**
+     * @brief Creates a texture from pixels already written to the given staging buffer, which the
+     * texture takes, destroying it once the upload is done with it.
+     *
+     * @param staging A pointer to the staging buffer holding the pixels from its start.
+     * @param texture A pointer to the texture to hold the resources.
+     */
+    void (*texture_create_staged)(renderbuffer* staging, struct texture* texture);
+
+    /**
+     * @brief Indicates if textures can be created in the given format.
+     *
+     * @param format The format to check.
+     * @return True if supported; otherwise false.
+     */
+    b8 (*texture_format_supported)(texture_format format);
+
     /**
      * @brief Destroys the given texture, releasing internal resources.
      *
@@ -329,6 +581,19 @@ typedef struct renderer_backend {
      */
     void (*texture_write_data)(texture* t, u32 offset, u32 size, const u8* pixels);
 
+    /**
+     * @brief Writes the given pixels to a rectangle of the provided texture, leaving the rest as it was.
+     * The texture must have been written whole at least once.
+     *
+     * @param t A pointer to the texture to be written to.
+     * @param x The first column of the rectangle.
+     * @param y The first row of the rectangle.
+     * @param width The width of the rectangle in pixels.
+     * @param height The height of the rectangle in pixels.
+     * @param pixels The pixels of the rectangle, row by row with no gaps between rows.
+     */
+    void (*texture_write_region)(texture* t, u32 x, u32 y, u32 width, u32 height, const u8* pixels);
+
     /**
      * @brief Reads the given data from the provided texture.
      *
@@ -349,6 +614,20 @@ typedef struct renderer_backend {
      */
     void (*texture_read_pixel)(texture* t, u32 x, u32 y, u8** out_rgba);
 
+    /**
+     * @brief Copies a pixel of the provided colour attachment texture at the given x/y coordinate in the
+     * current frame, without waiting for the copy. What lands is handed back by the call in the same
+     * frame slot, once its fence has signalled, so results trail requests by the frames in flight.
+     * Must be called outside a renderpass, after the pass rendering to the texture.
+     *
+     * @param t A pointer to the texture to be read from.
+     * @param x The pixel x-coordinate.
+     * @param y The pixel y-coordinate.
+     * @param out_rgba An array of 4 u8s to hold the pixel copied frames earlier, if there is one.
+     * @return True if a pixel copied frames earlier was written to out_rgba; otherwise false.
+     */
+    b8 (*texture_read_pixel_async)(texture* t, u32 x, u32 y, u8* out_rgba);
+
     /**
      * @brief Creates Vulkan-specific internal resources for the given geometry using
      * the data provided.
@@ -371,6 +650,33 @@ typedef struct renderer_backend {
      */
     void (*destroy_geometry)(geometry* geometry);
 
+    /**
+     * @brief Gives the given geometry a skin, from its vertices in the bind pose and the joints
+     * influencing them. The geometry must already be created, with as many vertex_3d_packed vertices.
+     *
+     * @param geometry A pointer to the geometry.
+     * @param vertex_count The number of vertices.
+     * @param vertices An array of the vertices.
+     * @return True on success; otherwise false.
+     */
+    b8 (*geometry_skin_create)(geometry* geometry, u32 vertex_count, const vertex_3d_skinned* vertices);
+
+    /**
+     * @brief Removes the skin of the given geometry, if it has one. Destroying the geometry removes it too.
+     *
+     * @param geometry A pointer to the geometry.
+     */
+    void (*geometry_skin_destroy)(geometry* geometry);
+
+    /**
+     * @brief Skins the given geometries with their poses of the current frame. Should only be called
+     * outside of a renderpass, within a frame, before they are drawn.
+     *
+     * @param count The number of geometries.
+     * @param updates An array of the geometries and their poses.
+     */
+    void (*geometry_skins_update)(u32 count, const renderer_skin_update* updates);
+
     /**
      * @brief Creates internal shader resources using the provided parameters.
      *
@@ -399,6 +705,16 @@ typedef struct renderer_backend {
      */
     b8 (*shader_initialize)(struct shader* shader);
 
+    /**
+     * @brief Reloads the stage files of an initialized shader and rebuilds its pipeline. The
+     * shader is left as it was if any stage fails. Uniforms, attributes and layouts are kept,
+     * so the new stages must match them.
+     *
+     * @param s A pointer to the shader to be reloaded.
+     * @return True on success; otherwise false.
+     */
+    b8 (*shader_reload)(struct shader* shader);
+
     /**
      * @brief Uses the given shader, activating it for updates to attributes, uniforms and such,
      * and for use in draw calls.
@@ -442,6 +758,14 @@ typedef struct renderer_backend {
      */
     b8 (*shader_apply_instance)(struct shader* s, b8 needs_update);
 
+    /**
+     * @brief Applies the local data set since the last draw.
+     *
+     * @param s A pointer to the shader to apply the local data for.
+     * @return True on success; otherwise false.
+     */
+    b8 (*shader_apply_local)(struct shader* s);
+
     /**
      * @brief Acquires internal instance-level resources and provides an instance id.
      *
@@ -551,6 +875,12 @@ typedef struct renderer_backend {
      */
     b8 (*is_multithreaded)();
 
+    /**
+     * @brief Indicates if shaders flagged bindless can be created, sampling their instance
+     * textures from the renderer's texture table by index.
+     */
+    b8 (*bindless_supported)();
+
     /**
      * @brief Creates and assigns the renderer-backend-specific buffer.
      *
@@ -665,6 +995,16 @@ typedef struct renderer_backend {
      */
     b8 (*renderbuffer_draw)(renderbuffer* buffer, u64 offset, u32 element_count, b8 bind_only);
 
+    /**
+     * @brief Draws with the command held in the provided indirect buffer at the given offset, with
+     * no vertex or index buffer bound, so the shader in use finds its vertices itself.
+     *
+     * @param buffer A pointer to the indirect buffer holding a renderer_draw_indirect_command.
+     * @param offset The offset in bytes of the command from the beginning of the buffer.
+     * @return True on success; otherwise false.
+     */
+    b8 (*renderbuffer_draw_indirect)(renderbuffer* buffer, u64 offset);
+
 } renderer_backend;
 
 /** @brief Known render view types, which have logic associated with them. */
@@ -677,6 +1017,10 @@ typedef enum render_view_known_type {
     RENDERER_VIEW_KNOWN_TYPE_SKYBOX = 0x03,
     /** @brief A view which only renders ui and world objects to be picked. */
     RENDERER_VIEW_KNOWN_TYPE_PICK = 0x04,
+    /** @brief A view which only renders what was drawn with debug_draw. Only in debug builds. */
+    RENDERER_VIEW_KNOWN_TYPE_DEBUG = 0x05,
+    /** @brief A view which simulates and renders the particles of every emitter, alpha blended over the world. */
+    RENDERER_VIEW_KNOWN_TYPE_PARTICLES = 0x06,
 } render_view_known_type;
 
 /** @brief Known view matrix sources. */
@@ -720,6 +1064,17 @@ typedef struct render_view_config {
     u8 pass_count;
     /** @brief The configuration of renderpasses used in this view. */
     renderpass_config* passes;
+    /**
+     * @brief Indicates if the view renders to the window at the renderer's dynamic resolution scale.
+     * Consecutive scaled views are upscaled together before the next view which is not, so must leave
+     * the window to be rendered to by a view after them, rather than present it.
+     */
+    b8 resolution_scaled;
+    /**
+     * @brief Indicates if the render targets of the view are only created once a packet of it first
+     * renders to them, rather than with the view, so a view which may never have work allocates nothing.
+     */
+    b8 lazy_render_targets;
 } render_view_config;
 
 struct render_view_packet;
@@ -750,6 +1105,17 @@ typedef struct render_view {
     const char* custom_shader_name;
     /** @brief The internal, view-specific data for this view. */
     void* internal_data;
+    /**
+     * @brief True if on_build_packet touches nothing another view's build also writes, so may be
+     * called on a job thread alongside the builds of other views.
+     */
+    b8 build_thread_safe;
+    /** @brief Indicates if the view renders at the renderer's dynamic resolution scale. */
+    b8 resolution_scaled;
+    /** @brief Indicates if the render targets of the view are only created once a packet of it first renders to them. */
+    b8 lazy_render_targets;
+    /** @brief Indicates if the render targets of the view have been created. */
+    b8 render_targets_generated;
 
     /**
      * @brief A pointer to a function to be called when this view is created.
@@ -837,6 +1203,11 @@ typedef struct render_view_packet {
     const char* custom_shader_name;
     /** @brief Holds a pointer to freeform data, typically understood both by the object and consuming view. */
     void* extended_data;
+    /**
+     * @brief Set by views whose packet renders nothing to their targets, so lazily created targets are
+     * not created for it. A view rendering anyway must check its targets were generated.
+     */
+    b8 targets_unused;
 } render_view_packet;
 
 typedef struct mesh_packet_data {
@@ -844,17 +1215,37 @@ typedef struct mesh_packet_data {
     mesh** meshes;
 } mesh_packet_data;
 
+/** @brief A textured quad of UI, drawn in a batch with the text and other quads of the frame. */
+typedef struct ui_quad {
+    /** @brief The material to draw the quad with. */
+    material* m;
+    /** @brief The quad in screen space: its position in xy and its size in zw. */
+    vec4 rect;
+    /** @brief The part of the material's diffuse map drawn: its offset in xy and its size in zw. */
+    vec4 uv_rect;
+    /** @brief The rectangle in screen space the quad is clipped to, as for rect. Unclipped if of no size. */
+    vec4 clip_rect;
+} ui_quad;
+
 struct ui_text;
 typedef struct ui_packet_data {
     mesh_packet_data mesh_data;
     // TODO: temp
     u32 text_count;
     struct ui_text** texts;
+    /** @brief The number of quads. */
+    u32 quad_count;
+    /** @brief The quads, drawn after the meshes and before the texts. */
+    ui_quad* quads;
 } ui_packet_data;
 
 typedef struct pick_packet_data {
     // Copy of frame data darray ptr
     geometry_render_data* world_mesh_data;
+    // The number of world geometries, counted as the packet is built, as the darray may have changed by the time it is drawn.
+    u32 world_geometry_count;
+    // The scene world_mesh_data is the visible list of, searched through its bvh for what is under the cursor. Optional.
+    const struct render_scene* world_scene;
     mesh_packet_data ui_mesh_data;
     u32 ui_geometry_count;
     // TODO: temp
@@ -880,4 +1271,9 @@ typedef struct render_packet {
     u16 view_count;
     /** An array of views to be rendered. */
     render_view_packet* views;
+
+    /** The number of skinned geometries posed this frame. */
+    u32 skin_count;
+    /** An array of the skinned geometries posed this frame, skinned before any view is rendered. */
+    renderer_skin_update* skins;
 } render_packet;
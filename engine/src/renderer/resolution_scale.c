@@ -0,0 +1,70 @@
+#include "resolution_scale.h"
+
+#include "core/kmemory.h"
+#include "math/kmath.h"
+
+/** @brief The weight of each new timing in the smoothed ones. */
+#define RESOLUTION_SCALE_SMOOTHING 0.25f
+/** @brief The fraction of the budget a change of scale aims the scaled views at, between the headroom and all of it. */
+#define RESOLUTION_SCALE_AIM ((RESOLUTION_SCALE_HEADROOM + 1.0f) * 0.5f)
+
+void resolution_scale_controller_create(const renderer_resolution_config* config, resolution_scale_controller* out_controller) {
+    kzero_memory(out_controller, sizeof(resolution_scale_controller));
+    out_controller->config = *config;
+    if (out_controller->config.target_frame_ms <= 0.0f) {
+        out_controller->config.target_frame_ms = 1000.0f / 60.0f;
+    }
+    if (out_controller->config.min_scale <= 0.0f) {
+        out_controller->config.min_scale = 0.5f;
+    }
+    out_controller->config.min_scale = KMIN(out_controller->config.min_scale, 1.0f);
+    out_controller->scale = 1.0f;
+}
+
+f32 resolution_scale_update(resolution_scale_controller* controller, f64 scaled_ms, f64 other_ms) {
+    if (!controller->config.enabled) {
+        return 1.0f;
+    }
+    if (scaled_ms <= 0.0) {
+        // Nothing to judge by.
+        return controller->scale;
+    }
+    if (controller->settle_frames) {
+        controller->settle_frames--;
+        return controller->scale;
+    }
+
+    if (controller->scaled_ms <= 0.0f) {
+        controller->scaled_ms = (f32)scaled_ms;
+        controller->other_ms = (f32)other_ms;
+    } else {
+        controller->scaled_ms += ((f32)scaled_ms - controller->scaled_ms) * RESOLUTION_SCALE_SMOOTHING;
+        controller->other_ms += ((f32)other_ms - controller->other_ms) * RESOLUTION_SCALE_SMOOTHING;
+    }
+
+    // What the views which are not scaled leave of the budget, though never less than a little of it.
+    f32 target = controller->config.target_frame_ms;
+    f32 budget = KMAX(target - controller->other_ms, target * 0.1f);
+    f32 load = controller->scaled_ms / budget;
+    if (load <= 1.0f && load >= RESOLUTION_SCALE_HEADROOM) {
+        return controller->scale;
+    }
+
+    // The time goes with the pixels shaded, so with the square of the scale.
+    f32 wanted = controller->scale * ksqrt(RESOLUTION_SCALE_AIM / load);
+    wanted = KMIN(wanted, controller->scale + RESOLUTION_SCALE_MAX_RISE);
+    // Rounded down, so a change never lands over budget, nor rises by less than a step.
+    wanted = (f32)(u32)(wanted / RESOLUTION_SCALE_STEP + 0.001f) * RESOLUTION_SCALE_STEP;
+    wanted = KCLAMP(wanted, controller->config.min_scale, 1.0f);
+    if (wanted != controller->scale) {
+        controller->scale = wanted;
+        controller->settle_frames = RESOLUTION_SCALE_SETTLE_FRAMES;
+        controller->scaled_ms = 0.0f;
+    }
+    return controller->scale;
+}
+
+u32 resolution_scale_extent(f32 scale, u32 extent) {
+    u32 scaled = (u32)(extent * KCLAMP(scale, 0.0f, 1.0f) + 0.5f);
+    return KCLAMP(scaled, 1, KMAX(extent, 1));
+}
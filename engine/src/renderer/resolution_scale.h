@@ -0,0 +1,71 @@
+/**
+ * @file resolution_scale.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Picks the dynamic resolution scale of each frame from the GPU time of the frames before it.
+ * @details The time of the scaled views is taken to grow with the pixels they shade, so with the
+ * square of the scale, while the views which are not scaled take what they take. The scale is
+ * changed only once the scaled views leave a band under what the budget leaves them, straight to
+ * the scale which brings them back into the middle of it. It drops as far as needed at once, but
+ * rises a little at a time, as a frame over budget is worse than one under. Timings arrive frames
+ * late, so after each change the controller waits for frames drawn at the new scale before
+ * judging it again.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "renderer_types.inl"
+
+/** @brief The step scales are rounded down to, so the resolution does not change by a pixel at a time. */
+#define RESOLUTION_SCALE_STEP 0.05f
+/** @brief The most the scale rises in one change. */
+#define RESOLUTION_SCALE_MAX_RISE 0.1f
+/** @brief The frames the controller waits after a change before judging the new scale. */
+#define RESOLUTION_SCALE_SETTLE_FRAMES 4
+/** @brief The fraction of the budget below which the scaled views are given more resolution. */
+#define RESOLUTION_SCALE_HEADROOM 0.85f
+
+/** @brief The state of the controller picking the resolution scale. */
+typedef struct resolution_scale_controller {
+    /** @brief The configuration, with defaults filled in. */
+    renderer_resolution_config config;
+    /** @brief The current scale, from config.min_scale to 1. */
+    f32 scale;
+    /** @brief The smoothed GPU time of the scaled views, in milliseconds, or 0 if none is measured yet. */
+    f32 scaled_ms;
+    /** @brief The smoothed GPU time of the other views, in milliseconds. */
+    f32 other_ms;
+    /** @brief The frames still to wait before the timings reflect the current scale. */
+    u32 settle_frames;
+} resolution_scale_controller;
+
+/**
+ * @brief Creates a controller from the given configuration, starting at full resolution.
+ *
+ * @param config A pointer to the configuration.
+ * @param out_controller A pointer to hold the controller.
+ */
+KAPI void resolution_scale_controller_create(const renderer_resolution_config* config, resolution_scale_controller* out_controller);
+
+/**
+ * @brief Takes the GPU time of a frame and picks the scale of the next.
+ *
+ * @param controller A pointer to the controller.
+ * @param scaled_ms The GPU time of the views rendered at the scale, in milliseconds. 0 if not measured.
+ * @param other_ms The GPU time of the views rendered at full resolution, in milliseconds.
+ * @return The scale to render the next frame at. Always 1 if the controller is disabled.
+ */
+KAPI f32 resolution_scale_update(resolution_scale_controller* controller, f64 scaled_ms, f64 other_ms);
+
+/**
+ * @brief Gets the extent rendered to, along one axis, at the given scale.
+ *
+ * @param scale The scale.
+ * @param extent The extent at full resolution, in pixels.
+ * @return The scaled extent, in pixels. At least 1 and at most the full extent.
+ */
+KAPI u32 resolution_scale_extent(f32 scale, u32 extent);
@@ -0,0 +1,181 @@
+#include "ui_batch.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "math/kmath.h"
+#include "math/transform.h"
+#include "resources/ui_text.h"
+
+b8 ui_batch_create(u32 vertex_capacity, u32 index_capacity, u32 draw_capacity, u64* memory_requirement, void* memory, ui_batch* out_batch) {
+    if (vertex_capacity == 0 || index_capacity == 0 || draw_capacity == 0) {
+        KERROR("ui_batch_create requires non-zero capacities. Create failed.");
+        return false;
+    }
+    if (!memory_requirement) {
+        KERROR("ui_batch_create requires memory_requirement to exist. Create failed.");
+        return false;
+    }
+
+    // The draws first, then the vertices, then the indices.
+    u64 draws_requirement = sizeof(ui_batch_draw) * draw_capacity;
+    u64 vertices_requirement = sizeof(vertex_2d) * vertex_capacity;
+    *memory_requirement = draws_requirement + vertices_requirement + sizeof(u32) * index_capacity;
+
+    // If only obtaining requirement, boot out.
+    if (!memory) {
+        return true;
+    }
+    if (!out_batch) {
+        KERROR("ui_batch_create requires a pointer to hold the batch. Create failed.");
+        return false;
+    }
+
+    kzero_memory(out_batch, sizeof(ui_batch));
+    out_batch->draw_capacity = draw_capacity;
+    out_batch->draws = memory;
+    out_batch->vertex_capacity = vertex_capacity;
+    out_batch->vertices = (vertex_2d*)((u8*)memory + draws_requirement);
+    out_batch->index_capacity = index_capacity;
+    out_batch->indices = (u32*)((u8*)memory + draws_requirement + vertices_requirement);
+    ui_batch_mark_unloaded(out_batch);
+    return true;
+}
+
+void ui_batch_destroy(ui_batch* batch) {
+    if (batch) {
+        kzero_memory(batch, sizeof(ui_batch));
+    }
+}
+
+void ui_batch_reset(ui_batch* batch) {
+    if (batch) {
+        batch->vertex_count = 0;
+        batch->index_count = 0;
+        batch->draw_count = 0;
+        batch->clip_rect = vec4_zero();
+    }
+}
+
+void ui_batch_clip_set(ui_batch* batch, vec4 clip_rect) {
+    if (batch) {
+        batch->clip_rect = clip_rect;
+    }
+}
+
+void ui_batch_mark_loaded(ui_batch* batch) {
+    if (batch) {
+        batch->loaded_vertex_count = KMAX(batch->loaded_vertex_count, batch->vertex_count);
+        batch->loaded_index_count = KMAX(batch->loaded_index_count, batch->index_count);
+        batch->dirty_vertex_first = INVALID_ID;
+        batch->dirty_vertex_last = 0;
+        batch->dirty_index_first = INVALID_ID;
+        batch->dirty_index_last = 0;
+    }
+}
+
+void ui_batch_mark_unloaded(ui_batch* batch) {
+    if (batch) {
+        ui_batch_mark_loaded(batch);
+        batch->loaded_vertex_count = 0;
+        batch->loaded_index_count = 0;
+    }
+}
+
+// Grows the given dirty span to hold the given element.
+static void dirty_add(u32* first, u32* last, u32 element) {
+    if (*first == INVALID_ID || element < *first) {
+        *first = element;
+    }
+    if (element > *last) {
+        *last = element;
+    }
+}
+
+// Appends the given vertices, transformed by model if given, and their indices, offset to follow the
+// vertices already added, to the last draw if it has the same bindings or otherwise to a new one.
+static b8 batch_add(ui_batch* batch, material* m, ui_text* text, texture_map* atlas, const mat4* model, u32 vertex_count, const vertex_2d* vertices, u32 index_count, const u32* indices) {
+    if (batch->vertex_count + vertex_count > batch->vertex_capacity || batch->index_count + index_count > batch->index_capacity) {
+        return false;
+    }
+    ui_batch_draw* draw = batch->draw_count ? &batch->draws[batch->draw_count - 1] : 0;
+    vec4 clip = batch->clip_rect;
+    if (!draw || draw->m != m || draw->atlas != atlas || draw->clip_rect.x != clip.x || draw->clip_rect.y != clip.y ||
+        draw->clip_rect.z != clip.z || draw->clip_rect.w != clip.w) {
+        if (batch->draw_count == batch->draw_capacity) {
+            return false;
+        }
+        draw = &batch->draws[batch->draw_count++];
+        draw->m = m;
+        draw->text = text;
+        draw->atlas = atlas;
+        draw->first_index = batch->index_count;
+        draw->index_count = 0;
+        draw->clip_rect = clip;
+    }
+
+    // Only what differs from what is there, or is past what was loaded, is written and made dirty.
+    for (u32 i = 0; i < vertex_count; ++i) {
+        vertex_2d v = vertices[i];
+        if (model) {
+            vec3 position = vec3_mul_mat4((vec3){v.position.x, v.position.y, 0.0f}, *model);
+            v.position = (vec2){position.x, position.y};
+        }
+        u32 element = batch->vertex_count + i;
+        vertex_2d* dest = &batch->vertices[element];
+        if (element >= batch->loaded_vertex_count || dest->position.x != v.position.x || dest->position.y != v.position.y ||
+            dest->texcoord.x != v.texcoord.x || dest->texcoord.y != v.texcoord.y) {
+            *dest = v;
+            dirty_add(&batch->dirty_vertex_first, &batch->dirty_vertex_last, element);
+        }
+    }
+
+    for (u32 i = 0; i < index_count; ++i) {
+        u32 element = batch->index_count + i;
+        u32 index = batch->vertex_count + indices[i];
+        if (element >= batch->loaded_index_count || batch->indices[element] != index) {
+            batch->indices[element] = index;
+            dirty_add(&batch->dirty_index_first, &batch->dirty_index_last, element);
+        }
+    }
+
+    batch->vertex_count += vertex_count;
+    batch->index_count += index_count;
+    draw->index_count += index_count;
+    return true;
+}
+
+b8 ui_batch_quad_add(ui_batch* batch, material* m, vec4 rect, vec4 uv_rect) {
+    if (!batch || !m) {
+        KERROR("ui_batch_quad_add requires a valid pointer to a batch and a material.");
+        return false;
+    }
+
+    // Laid out as the quads of text are, so both wind the same way.
+    f32 minx = rect.x;
+    f32 miny = rect.y;
+    f32 maxx = rect.x + rect.z;
+    f32 maxy = rect.y + rect.w;
+    f32 tminx = uv_rect.x;
+    f32 tminy = uv_rect.y;
+    f32 tmaxx = uv_rect.x + uv_rect.z;
+    f32 tmaxy = uv_rect.y + uv_rect.w;
+    vertex_2d vertices[4] = {
+        {{minx, miny}, {tminx, tminy}},
+        {{maxx, maxy}, {tmaxx, tmaxy}},
+        {{minx, maxy}, {tminx, tmaxy}},
+        {{maxx, miny}, {tmaxx, tminy}}};
+    static const u32 indices[6] = {2, 1, 0, 3, 0, 1};
+    return batch_add(batch, m, 0, 0, 0, 4, vertices, 6, indices);
+}
+
+b8 ui_batch_text_add(ui_batch* batch, ui_text* text) {
+    if (!batch || !text || !text->data) {
+        KERROR("ui_batch_text_add requires a valid pointer to a batch and a text with a font.");
+        return false;
+    }
+    if (text->quad_count == 0) {
+        return true;
+    }
+    mat4 model = transform_get_world(&text->transform);
+    return batch_add(batch, 0, text, &text->data->atlas, &model, text->quad_count * 4, text->vertices, text->quad_count * 6, text->indices);
+}
@@ -0,0 +1,149 @@
+/**
+ * @file ui_batch.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Gathers the vertices of a frame's UI text and quads into one vertex and index array,
+ * so the UI can be drawn from a single buffer in a handful of draws.
+ * @details Vertices are transformed to screen space as they are added. Each addition continues
+ * the last draw if it uses the same material, or for text the same font atlas, and is clipped to
+ * the same rectangle; otherwise it starts a new draw. Draws keep the order they were added in, so later UI is drawn over earlier
+ * UI as it was when drawn one by one. Indices index the whole vertex array. The batch holds no
+ * renderer resources; uploading and drawing it is up to its owner. The arrays are kept between
+ * frames, and the span of each that differs from what was last loaded is tracked, so UI that
+ * barely changes from frame to frame needs barely anything loaded. Not thread-safe.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "math/math_types.h"
+#include "resources/resource_types.h"
+
+struct ui_text;
+
+/** @brief A range of the batch's indices drawn with the same bindings. */
+typedef struct ui_batch_draw {
+    /** @brief The material drawn with, or 0 for text. */
+    material* m;
+    /** @brief For text, the first text of the draw, whose shader instance holds the font atlas. */
+    struct ui_text* text;
+    /** @brief For text, the font atlas every text of the draw is drawn from. */
+    texture_map* atlas;
+    /** @brief The first index of the draw. */
+    u32 first_index;
+    /** @brief The number of indices of the draw. */
+    u32 index_count;
+    /** @brief The rectangle in screen space the draw is clipped to: its position in xy and its size in zw. Unclipped if of no size. */
+    vec4 clip_rect;
+} ui_batch_draw;
+
+/** @brief The ui batch structure. */
+typedef struct ui_batch {
+    /** @brief The most vertices the batch can hold. */
+    u32 vertex_capacity;
+    /** @brief The number of vertices added. */
+    u32 vertex_count;
+    /** @brief The vertices, in screen space. */
+    vertex_2d* vertices;
+    /** @brief The most indices the batch can hold. */
+    u32 index_capacity;
+    /** @brief The number of indices added. */
+    u32 index_count;
+    /** @brief The indices, into the whole vertex array. */
+    u32* indices;
+    /** @brief The number of vertices, from the first, known to be loaded as they are now, apart from any dirty. */
+    u32 loaded_vertex_count;
+    /** @brief The first vertex changed since the batch was last loaded, or INVALID_ID if none has. */
+    u32 dirty_vertex_first;
+    /** @brief The last vertex changed since the batch was last loaded. */
+    u32 dirty_vertex_last;
+    /** @brief The number of indices, from the first, known to be loaded as they are now, apart from any dirty. */
+    u32 loaded_index_count;
+    /** @brief The first index changed since the batch was last loaded, or INVALID_ID if none has. */
+    u32 dirty_index_first;
+    /** @brief The last index changed since the batch was last loaded. */
+    u32 dirty_index_last;
+    /** @brief The most draws the batch can hold. */
+    u32 draw_capacity;
+    /** @brief The number of draws. */
+    u32 draw_count;
+    /** @brief The draws, in the order they are to be drawn. */
+    ui_batch_draw* draws;
+    /** @brief The rectangle additions are clipped to, as set by ui_batch_clip_set. */
+    vec4 clip_rect;
+} ui_batch;
+
+/**
+ * @brief Creates a new ui batch. Should be called twice; once to obtain the memory amount
+ * required (passing memory=0), and a second time with memory being set to an allocated block.
+ *
+ * @param vertex_capacity The most vertices the batch should hold.
+ * @param index_capacity The most indices the batch should hold.
+ * @param draw_capacity The most draws the batch should hold.
+ * @param memory_requirement A pointer to hold the required memory for the batch.
+ * @param memory An allocated block of memory, or 0 if just obtaining the requirement.
+ * @param out_batch A pointer to hold the batch.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 ui_batch_create(u32 vertex_capacity, u32 index_capacity, u32 draw_capacity, u64* memory_requirement, void* memory, ui_batch* out_batch);
+
+/**
+ * @brief Destroys the given batch. The memory passed at creation is not freed.
+ *
+ * @param batch A pointer to the batch to be destroyed.
+ */
+KAPI void ui_batch_destroy(ui_batch* batch);
+
+/**
+ * @brief Empties the batch, ready for the next frame. What was added stays, to find what changes.
+ *
+ * @param batch A pointer to the batch.
+ */
+KAPI void ui_batch_reset(ui_batch* batch);
+
+/**
+ * @brief Clips the additions made from now on to the given rectangle, until it is set again or the batch is reset.
+ *
+ * @param batch A pointer to the batch.
+ * @param clip_rect The rectangle in screen space: its position in xy and its size in zw. Of no size to not clip.
+ */
+KAPI void ui_batch_clip_set(ui_batch* batch, vec4 clip_rect);
+
+/**
+ * @brief Records that the dirty spans of the batch have been loaded, leaving no span dirty.
+ *
+ * @param batch A pointer to the batch.
+ */
+KAPI void ui_batch_mark_loaded(ui_batch* batch);
+
+/**
+ * @brief Records that nothing of the batch is known to be loaded, such as after a failed load,
+ * so everything added from now on is dirty.
+ *
+ * @param batch A pointer to the batch.
+ */
+KAPI void ui_batch_mark_unloaded(ui_batch* batch);
+
+/**
+ * @brief Adds a textured quad drawn with the given material.
+ *
+ * @param batch A pointer to the batch.
+ * @param m A pointer to the material to draw the quad with.
+ * @param rect The quad in screen space: its position in xy and its size in zw.
+ * @param uv_rect The part of the material's diffuse map drawn: its offset in xy and its size in zw.
+ * @return True on success; false if the batch is full.
+ */
+KAPI b8 ui_batch_quad_add(ui_batch* batch, material* m, vec4 rect, vec4 uv_rect);
+
+/**
+ * @brief Adds the glyphs of the given text, placed by its transform.
+ *
+ * @param batch A pointer to the batch.
+ * @param text A pointer to the text.
+ * @return True on success; false if the batch is full.
+ */
+KAPI b8 ui_batch_text_add(ui_batch* batch, struct ui_text* text);
@@ -0,0 +1,223 @@
+#include "render_view_debug.h"
+
+#if defined(KDEBUG_DRAW_ENABLED)
+
+#include "core/logger.h"
+#include "core/profiler.h"
+#include "core/kmemory.h"
+#include "core/event.h"
+#include "math/kmath.h"
+#include "memory/linear_allocator.h"
+#include "systems/resource_system.h"
+#include "systems/shader_system.h"
+#include "systems/camera_system.h"
+#include "systems/render_view_system.h"
+#include "renderer/renderer_frontend.h"
+
+/** @brief The most vertices of each kind of primitive drawn each frame. */
+#define DEBUG_VIEW_MAX_VERTICES 65536
+
+/**
+ * @brief The number of buffers the vertices are uploaded to, one after another each frame. One more
+ * than the frames which may be in flight, so none is written while drawn from.
+ */
+#define DEBUG_VIEW_BUFFER_COUNT 3
+
+typedef struct render_view_debug_internal_data {
+    shader* s;
+    // The camera holds the projection, shared with the other views of it.
+    camera* world_camera;
+    u16 projection_location;
+    u16 view_location;
+    // The memory debug drawing gathers into, held by the view for as long as it lives.
+    u64 state_memory_size;
+    void* state_memory;
+    renderbuffer vertex_buffers[DEBUG_VIEW_BUFFER_COUNT];
+} render_view_debug_internal_data;
+
+static b8 render_view_on_event(u16 code, void* sender, void* listener_inst, event_context context) {
+    render_view* self = (render_view*)listener_inst;
+    if (!self) {
+        return false;
+    }
+
+    switch (code) {
+        case EVENT_CODE_DEFAULT_RENDERTARGET_REFRESH_REQUIRED:
+            render_view_system_regenerate_render_targets(self);
+            // This needs to be consumed by other views, so consider it _not_ handled.
+            return false;
+    }
+
+    return false;
+}
+
+b8 render_view_debug_on_create(struct render_view* self) {
+    if (self) {
+        self->internal_data = kallocate(sizeof(render_view_debug_internal_data), MEMORY_TAG_RENDERER);
+        render_view_debug_internal_data* data = self->internal_data;
+
+        // Builtin debug shader.
+        const char* shader_name = "Shader.Builtin.Debug";
+        resource config_resource;
+        if (!resource_system_load(shader_name, RESOURCE_TYPE_SHADER, 0, &config_resource)) {
+            KERROR("Failed to load builtin debug shader.");
+            return false;
+        }
+        shader_config* config = (shader_config*)config_resource.data;
+        // NOTE: Assuming the first pass since that's all this view has.
+        if (!shader_system_create(&self->passes[0], config)) {
+            KERROR("Failed to load builtin debug shader.");
+            return false;
+        }
+        resource_system_unload(&config_resource);
+
+        data->s = shader_system_get(self->custom_shader_name ? self->custom_shader_name : shader_name);
+        data->projection_location = shader_system_uniform_index(data->s, "projection");
+        data->view_location = shader_system_uniform_index(data->s, "view");
+
+        data->world_camera = camera_system_get_default();
+
+        // What is drawn is gathered from now on, once turned on.
+        debug_draw_initialize(DEBUG_VIEW_MAX_VERTICES, &data->state_memory_size, 0);
+        data->state_memory = kallocate(data->state_memory_size, MEMORY_TAG_RENDERER);
+        if (!debug_draw_initialize(DEBUG_VIEW_MAX_VERTICES, &data->state_memory_size, data->state_memory)) {
+            KERROR("Failed to initialize debug drawing.");
+            return false;
+        }
+
+        // Each buffer holds every kind of primitive at once.
+        u64 buffer_size = sizeof(debug_vertex) * DEBUG_VIEW_MAX_VERTICES * DEBUG_DRAW_PRIMITIVE_COUNT;
+        for (u32 i = 0; i < DEBUG_VIEW_BUFFER_COUNT; ++i) {
+            if (!renderer_renderbuffer_create(RENDERBUFFER_TYPE_VERTEX, buffer_size, false, &data->vertex_buffers[i]) ||
+                !renderer_renderbuffer_bind(&data->vertex_buffers[i], 0)) {
+                KERROR("Failed to create debug vertex buffer.");
+                return false;
+            }
+        }
+
+        if (!event_register(EVENT_CODE_DEFAULT_RENDERTARGET_REFRESH_REQUIRED, self, render_view_on_event)) {
+            KERROR("Unable to listen for refresh required event, creation failed.");
+            return false;
+        }
+        return true;
+    }
+    KERROR("render_view_debug_on_create - Requires a valid pointer to a view.");
+    return false;
+}
+
+void render_view_debug_on_destroy(struct render_view* self) {
+    if (self && self->internal_data) {
+        event_unregister(EVENT_CODE_DEFAULT_RENDERTARGET_REFRESH_REQUIRED, self, render_view_on_event);
+
+        render_view_debug_internal_data* data = self->internal_data;
+        for (u32 i = 0; i < DEBUG_VIEW_BUFFER_COUNT; ++i) {
+            renderer_renderbuffer_destroy(&data->vertex_buffers[i]);
+        }
+        debug_draw_shutdown(data->state_memory);
+        kfree(data->state_memory, data->state_memory_size, MEMORY_TAG_RENDERER);
+
+        kfree(self->internal_data, sizeof(render_view_debug_internal_data), MEMORY_TAG_RENDERER);
+        self->internal_data = 0;
+    }
+}
+
+void render_view_debug_on_resize(struct render_view* self, u32 width, u32 height) {
+    if (width != self->width || height != self->height) {
+        self->width = width;
+        self->height = height;
+
+        for (u32 i = 0; i < self->renderpass_count; ++i) {
+            self->passes[i].render_area.x = 0;
+            self->passes[i].render_area.y = 0;
+            self->passes[i].render_area.z = width;
+            self->passes[i].render_area.w = height;
+        }
+    }
+}
+
+b8 render_view_debug_on_build_packet(const struct render_view* self, struct linear_allocator* frame_allocator, void* data, struct render_view_packet* out_packet) {
+    KPROFILE_ZONE("render_view_debug_on_build_packet");
+    if (!self || !out_packet) {
+        KWARN("render_view_debug_on_build_packet requires valid pointer to view and packet.");
+        return false;
+    }
+
+    render_view_debug_internal_data* internal_data = (render_view_debug_internal_data*)self->internal_data;
+
+    out_packet->view = self;
+    out_packet->projection_matrix = camera_projection_get(internal_data->world_camera);
+    out_packet->view_matrix = camera_view_get(internal_data->world_camera);
+    out_packet->view_position = camera_position_get(internal_data->world_camera);
+
+    // What was drawn since the last packet, which the view holds no data of itself. Needs no data passed in.
+    debug_draw_packet_data* packet_data = linear_allocator_allocate(frame_allocator, sizeof(debug_draw_packet_data));
+    if (!packet_data) {
+        KERROR("Failed to allocate the debug view's packet data.");
+        return false;
+    }
+    debug_draw_take(frame_allocator, packet_data);
+    if (packet_data->dropped_count) {
+        KWARN("Debug drawing left out %u primitives, which did not fit.", packet_data->dropped_count);
+    }
+    out_packet->extended_data = packet_data;
+    return true;
+}
+
+void render_view_debug_on_destroy_packet(const struct render_view* self, struct render_view_packet* packet) {
+    // Everything of it came from the frame allocator.
+    kzero_memory(packet, sizeof(render_view_packet));
+}
+
+b8 render_view_debug_on_render(const struct render_view* self, const struct render_view_packet* packet, u64 frame_number, u64 render_target_index) {
+    KPROFILE_ZONE("render_view_debug_on_render");
+    render_view_debug_internal_data* data = self->internal_data;
+    const debug_draw_packet_data* packet_data = packet->extended_data;
+
+    // Everything of the frame is uploaded at once, ahead of the frame.
+    renderbuffer* buffer = &data->vertex_buffers[frame_number % DEBUG_VIEW_BUFFER_COUNT];
+    b8 drawing = packet_data && packet_data->vertex_count;
+    if (drawing && !renderer_renderbuffer_load_range(buffer, 0, sizeof(debug_vertex) * packet_data->vertex_count, packet_data->vertices)) {
+        KERROR("Failed to upload debug vertices. Skipping debug drawing this frame.");
+        drawing = false;
+    }
+
+    for (u32 p = 0; p < self->renderpass_count; ++p) {
+        renderpass* pass = &self->passes[p];
+        // Begun even with nothing to draw, as the passes after it expect the attachments as it leaves them.
+        if (!renderer_renderpass_begin(pass, &pass->targets[render_target_index])) {
+            KERROR("render_view_debug_on_render pass index %u failed to start.", p);
+            return false;
+        }
+
+        if (drawing) {
+            if (!shader_system_use_by_id(data->s->id)) {
+                KERROR("Failed to use debug shader. Render frame failed.");
+                return false;
+            }
+            renderer_shader_bind_globals(data->s);
+            if (!shader_system_uniform_set_by_index(data->projection_location, &packet->projection_matrix) ||
+                !shader_system_uniform_set_by_index(data->view_location, &packet->view_matrix)) {
+                KERROR("Failed to apply debug shader globals.");
+                return false;
+            }
+            shader_system_apply_global();
+
+            // One draw for each kind of primitive.
+            for (u32 i = 0; i < DEBUG_DRAW_PRIMITIVE_COUNT; ++i) {
+                if (packet_data->vertex_counts[i] &&
+                    !renderer_renderbuffer_draw(buffer, sizeof(debug_vertex) * packet_data->first_vertex[i], packet_data->vertex_counts[i], false)) {
+                    KERROR("Failed to draw debug primitives of kind %u.", i);
+                }
+            }
+        }
+
+        if (!renderer_renderpass_end(pass)) {
+            KERROR("render_view_debug_on_render pass index %u failed to end.", p);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "defines.h"
+#include "renderer/renderer_types.inl"
+#include "renderer/debug_draw.h"
+
+#if defined(KDEBUG_DRAW_ENABLED)
+
+struct linear_allocator;
+
+b8 render_view_debug_on_create(struct render_view* self);
+void render_view_debug_on_destroy(struct render_view* self);
+void render_view_debug_on_resize(struct render_view* self, u32 width, u32 height);
+b8 render_view_debug_on_build_packet(const struct render_view* self, struct linear_allocator* frame_allocator, void* data, struct render_view_packet* out_packet);
+void render_view_debug_on_destroy_packet(const struct render_view* self, struct render_view_packet* packet);
+b8 render_view_debug_on_render(const struct render_view* self, const struct render_view_packet* packet, u64 frame_number, u64 render_target_index);
+
+#endif
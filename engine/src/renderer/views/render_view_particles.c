@@ -0,0 +1,427 @@
+#include "render_view_particles.h"
+
+#include "core/logger.h"
+#include "core/profiler.h"
+#include "core/kmemory.h"
+#include "core/event.h"
+#include "memory/linear_allocator.h"
+#include "systems/resource_system.h"
+#include "systems/shader_system.h"
+#include "systems/camera_system.h"
+#include "systems/render_view_system.h"
+#include "renderer/renderer_frontend.h"
+#include "renderer/particles.h"
+
+/** @brief The most particles alive at once. A power of two, and a multiple of the sort's block, so the pool sorts whole. */
+#define PARTICLES_VIEW_CAPACITY 65536
+
+/** @brief The size of a particle in the pool, matching the particle of the particle shaders. */
+#define PARTICLES_VIEW_PARTICLE_SIZE 96
+
+/** @brief The size of a sort entry, a key then the index of its particle. */
+#define PARTICLES_VIEW_SORT_ENTRY_SIZE 8
+
+/** @brief The invocations of each workgroup of the emission and simulation shaders. */
+#define PARTICLES_VIEW_WORKGROUP_SIZE 64
+
+/** @brief The entries sorted together in shared memory by each workgroup of the sort shader, which has half as many invocations. */
+#define PARTICLES_VIEW_SORT_BLOCK_SIZE 512
+
+/**
+ * @brief The number of buffers the emitters are uploaded to, one after another each frame. One more
+ * than the frames which may be in flight, so none is written while read from.
+ */
+#define PARTICLES_VIEW_EMITTER_BUFFER_COUNT 3
+
+STATIC_ASSERT((PARTICLES_VIEW_CAPACITY & (PARTICLES_VIEW_CAPACITY - 1)) == 0 && PARTICLES_VIEW_CAPACITY >= PARTICLES_VIEW_SORT_BLOCK_SIZE, "The particle capacity must be a power of two of at least a sort block.");
+
+typedef struct particles_emit_shader {
+    shader* s;
+    u16 particles_location;
+    u16 free_list_location;
+    u16 emitters_location;
+    u16 draw_location;
+    u16 spawn_count_location;
+    u16 emitter_count_location;
+} particles_emit_shader;
+
+typedef struct particles_simulate_shader {
+    shader* s;
+    u16 particles_location;
+    u16 free_list_location;
+    u16 sort_entries_location;
+    u16 draw_location;
+    u16 view_location;
+    u16 delta_time_location;
+    u16 capacity_location;
+} particles_simulate_shader;
+
+typedef struct particles_sort_shader {
+    shader* s;
+    u16 sort_entries_location;
+    u16 k_location;
+    u16 j_location;
+    u16 local_steps_location;
+} particles_sort_shader;
+
+typedef struct particles_draw_shader {
+    shader* s;
+    u16 projection_location;
+    u16 view_location;
+    u16 particles_location;
+    u16 sort_entries_location;
+} particles_draw_shader;
+
+typedef struct render_view_particles_internal_data {
+    particles_emit_shader emit;
+    particles_simulate_shader simulate;
+    particles_sort_shader sort;
+    particles_draw_shader draw;
+    // The camera holds the projection, shared with the other views of it.
+    camera* world_camera;
+    // The memory the emitters are kept in, held by the view for as long as it lives.
+    u64 state_memory_size;
+    void* state_memory;
+    // The pool, which lives on the GPU from frame to frame, with the list of its free slots.
+    renderbuffer particle_buffer;
+    renderbuffer free_list_buffer;
+    // An entry for each slot of the pool, sorted each frame.
+    renderbuffer sort_buffer;
+    // The draw of the living, counted by the simulation.
+    renderbuffer draw_buffer;
+    renderbuffer emitter_buffers[PARTICLES_VIEW_EMITTER_BUFFER_COUNT];
+} render_view_particles_internal_data;
+
+static b8 render_view_on_event(u16 code, void* sender, void* listener_inst, event_context context) {
+    render_view* self = (render_view*)listener_inst;
+    if (!self) {
+        return false;
+    }
+
+    switch (code) {
+        case EVENT_CODE_DEFAULT_RENDERTARGET_REFRESH_REQUIRED:
+            render_view_system_regenerate_render_targets(self);
+            // This needs to be consumed by other views, so consider it _not_ handled.
+            return false;
+    }
+
+    return false;
+}
+
+// Loads and creates the shader of the given name, with the given pass, or none for compute shaders.
+static shader* shader_load(const char* shader_name, renderpass* pass) {
+    resource config_resource;
+    if (!resource_system_load(shader_name, RESOURCE_TYPE_SHADER, 0, &config_resource)) {
+        KERROR("Failed to load builtin shader '%s'.", shader_name);
+        return 0;
+    }
+    b8 result = shader_system_create(pass, (shader_config*)config_resource.data);
+    resource_system_unload(&config_resource);
+    if (!result) {
+        KERROR("Failed to create builtin shader '%s'.", shader_name);
+        return 0;
+    }
+    return shader_system_get(shader_name);
+}
+
+static b8 storage_buffer_create(renderbuffer_type type, u64 size, renderbuffer* out_buffer) {
+    if (!renderer_renderbuffer_create(type, size, false, out_buffer) || !renderer_renderbuffer_bind(out_buffer, 0)) {
+        KERROR("Failed to create a particle buffer of %llu bytes.", size);
+        return false;
+    }
+    return true;
+}
+
+// Fills the pool with dead particles, every slot of it free.
+static b8 pool_initialize(render_view_particles_internal_data* data) {
+    u64 particles_size = (u64)PARTICLES_VIEW_PARTICLE_SIZE * PARTICLES_VIEW_CAPACITY;
+    u64 free_list_size = sizeof(i32) + sizeof(u32) * PARTICLES_VIEW_CAPACITY;
+    u64 block_size = KMAX(particles_size, free_list_size);
+    u8* block = kallocate(block_size, MEMORY_TAG_RENDERER);
+
+    // A life of zero is dead.
+    b8 result = renderer_renderbuffer_load_range(&data->particle_buffer, 0, particles_size, block);
+
+    i32* count = (i32*)block;
+    u32* slots = (u32*)(block + sizeof(i32));
+    *count = PARTICLES_VIEW_CAPACITY;
+    for (u32 i = 0; i < PARTICLES_VIEW_CAPACITY; ++i) {
+        slots[i] = i;
+    }
+    result = result && renderer_renderbuffer_load_range(&data->free_list_buffer, 0, free_list_size, block);
+
+    renderer_draw_indirect_command command = {6, 0, 0, 0};
+    result = result && renderer_renderbuffer_load_range(&data->draw_buffer, 0, sizeof(renderer_draw_indirect_command), &command);
+
+    kfree(block, block_size, MEMORY_TAG_RENDERER);
+    if (!result) {
+        KERROR("Failed to initialize the particle pool.");
+    }
+    return result;
+}
+
+b8 render_view_particles_on_create(struct render_view* self) {
+    if (self) {
+        self->internal_data = kallocate(sizeof(render_view_particles_internal_data), MEMORY_TAG_RENDERER);
+        render_view_particles_internal_data* data = self->internal_data;
+
+        // The compute shaders need no pass. NOTE: Assuming the first pass for drawing since that's all this view has.
+        data->emit.s = shader_load("Shader.Builtin.ParticleEmit", 0);
+        data->simulate.s = shader_load("Shader.Builtin.ParticleSimulate", 0);
+        data->sort.s = shader_load("Shader.Builtin.ParticleSort", 0);
+        data->draw.s = shader_load("Shader.Builtin.Particle", &self->passes[0]);
+        if (!data->emit.s || !data->simulate.s || !data->sort.s || !data->draw.s) {
+            return false;
+        }
+        if (self->custom_shader_name) {
+            data->draw.s = shader_system_get(self->custom_shader_name);
+        }
+
+        data->emit.particles_location = shader_system_uniform_index(data->emit.s, "particles");
+        data->emit.free_list_location = shader_system_uniform_index(data->emit.s, "free_list");
+        data->emit.emitters_location = shader_system_uniform_index(data->emit.s, "emitters");
+        data->emit.draw_location = shader_system_uniform_index(data->emit.s, "draw");
+        data->emit.spawn_count_location = shader_system_uniform_index(data->emit.s, "spawn_count");
+        data->emit.emitter_count_location = shader_system_uniform_index(data->emit.s, "emitter_count");
+
+        data->simulate.particles_location = shader_system_uniform_index(data->simulate.s, "particles");
+        data->simulate.free_list_location = shader_system_uniform_index(data->simulate.s, "free_list");
+        data->simulate.sort_entries_location = shader_system_uniform_index(data->simulate.s, "sort_entries");
+        data->simulate.draw_location = shader_system_uniform_index(data->simulate.s, "draw");
+        data->simulate.view_location = shader_system_uniform_index(data->simulate.s, "view");
+        data->simulate.delta_time_location = shader_system_uniform_index(data->simulate.s, "delta_time");
+        data->simulate.capacity_location = shader_system_uniform_index(data->simulate.s, "capacity");
+
+        data->sort.sort_entries_location = shader_system_uniform_index(data->sort.s, "sort_entries");
+        data->sort.k_location = shader_system_uniform_index(data->sort.s, "k");
+        data->sort.j_location = shader_system_uniform_index(data->sort.s, "j");
+        data->sort.local_steps_location = shader_system_uniform_index(data->sort.s, "local_steps");
+
+        data->draw.projection_location = shader_system_uniform_index(data->draw.s, "projection");
+        data->draw.view_location = shader_system_uniform_index(data->draw.s, "view");
+        data->draw.particles_location = shader_system_uniform_index(data->draw.s, "particles");
+        data->draw.sort_entries_location = shader_system_uniform_index(data->draw.s, "sort_entries");
+
+        data->world_camera = camera_system_get_default();
+
+        // Emitters are made from now on.
+        particles_initialize(PARTICLES_VIEW_CAPACITY, &data->state_memory_size, 0);
+        data->state_memory = kallocate(data->state_memory_size, MEMORY_TAG_RENDERER);
+        if (!particles_initialize(PARTICLES_VIEW_CAPACITY, &data->state_memory_size, data->state_memory)) {
+            KERROR("Failed to initialize particles.");
+            return false;
+        }
+
+        // The draw is written by the compute shaders too, so is bound to them as storage.
+        if (!storage_buffer_create(RENDERBUFFER_TYPE_STORAGE, (u64)PARTICLES_VIEW_PARTICLE_SIZE * PARTICLES_VIEW_CAPACITY, &data->particle_buffer) ||
+            !storage_buffer_create(RENDERBUFFER_TYPE_STORAGE, sizeof(i32) + sizeof(u32) * PARTICLES_VIEW_CAPACITY, &data->free_list_buffer) ||
+            !storage_buffer_create(RENDERBUFFER_TYPE_STORAGE, (u64)PARTICLES_VIEW_SORT_ENTRY_SIZE * PARTICLES_VIEW_CAPACITY, &data->sort_buffer) ||
+            !storage_buffer_create(RENDERBUFFER_TYPE_INDIRECT, sizeof(renderer_draw_indirect_command), &data->draw_buffer)) {
+            return false;
+        }
+        for (u32 i = 0; i < PARTICLES_VIEW_EMITTER_BUFFER_COUNT; ++i) {
+            if (!storage_buffer_create(RENDERBUFFER_TYPE_STORAGE, sizeof(particle_emitter_data) * PARTICLE_MAX_EMITTERS, &data->emitter_buffers[i])) {
+                return false;
+            }
+        }
+        if (!pool_initialize(data)) {
+            return false;
+        }
+
+        if (!event_register(EVENT_CODE_DEFAULT_RENDERTARGET_REFRESH_REQUIRED, self, render_view_on_event)) {
+            KERROR("Unable to listen for refresh required event, creation failed.");
+            return false;
+        }
+        return true;
+    }
+    KERROR("render_view_particles_on_create - Requires a valid pointer to a view.");
+    return false;
+}
+
+void render_view_particles_on_destroy(struct render_view* self) {
+    if (self && self->internal_data) {
+        event_unregister(EVENT_CODE_DEFAULT_RENDERTARGET_REFRESH_REQUIRED, self, render_view_on_event);
+
+        render_view_particles_internal_data* data = self->internal_data;
+        renderer_renderbuffer_destroy(&data->particle_buffer);
+        renderer_renderbuffer_destroy(&data->free_list_buffer);
+        renderer_renderbuffer_destroy(&data->sort_buffer);
+        renderer_renderbuffer_destroy(&data->draw_buffer);
+        for (u32 i = 0; i < PARTICLES_VIEW_EMITTER_BUFFER_COUNT; ++i) {
+            renderer_renderbuffer_destroy(&data->emitter_buffers[i]);
+        }
+        if (data->state_memory) {
+            particles_shutdown(data->state_memory);
+            kfree(data->state_memory, data->state_memory_size, MEMORY_TAG_RENDERER);
+        }
+
+        kfree(self->internal_data, sizeof(render_view_particles_internal_data), MEMORY_TAG_RENDERER);
+        self->internal_data = 0;
+    }
+}
+
+void render_view_particles_on_resize(struct render_view* self, u32 width, u32 height) {
+    if (width != self->width || height != self->height) {
+        self->width = width;
+        self->height = height;
+
+        for (u32 i = 0; i < self->renderpass_count; ++i) {
+            self->passes[i].render_area.x = 0;
+            self->passes[i].render_area.y = 0;
+            self->passes[i].render_area.z = width;
+            self->passes[i].render_area.w = height;
+        }
+    }
+}
+
+b8 render_view_particles_on_build_packet(const struct render_view* self, struct linear_allocator* frame_allocator, void* data, struct render_view_packet* out_packet) {
+    KPROFILE_ZONE("render_view_particles_on_build_packet");
+    if (!self || !out_packet || !data) {
+        KWARN("render_view_particles_on_build_packet requires valid pointer to view, packet, and data.");
+        return false;
+    }
+
+    render_view_particles_internal_data* internal_data = (render_view_particles_internal_data*)self->internal_data;
+
+    out_packet->view = self;
+    out_packet->projection_matrix = camera_projection_get(internal_data->world_camera);
+    out_packet->view_matrix = camera_view_get(internal_data->world_camera);
+    out_packet->view_position = camera_position_get(internal_data->world_camera);
+
+    // Only what the emitters spawn is handed on. The particles stay on the GPU.
+    particles_packet_data* packet_data = linear_allocator_allocate(frame_allocator, sizeof(particles_packet_data));
+    if (!packet_data) {
+        KERROR("Failed to allocate the particles view's packet data.");
+        return false;
+    }
+    particles_take(*(const f32*)data, frame_allocator, packet_data);
+    out_packet->extended_data = packet_data;
+    return true;
+}
+
+void render_view_particles_on_destroy_packet(const struct render_view* self, struct render_view_packet* packet) {
+    // Everything of it came from the frame allocator.
+    kzero_memory(packet, sizeof(render_view_packet));
+}
+
+// Records spawning into the pool, moving the pool on, and sorting it, ready to be drawn.
+static b8 particles_update(render_view_particles_internal_data* data, const struct render_view_packet* packet, u64 frame_number) {
+    const particles_packet_data* packet_data = packet->extended_data;
+
+    renderbuffer* emitter_buffer = &data->emitter_buffers[frame_number % PARTICLES_VIEW_EMITTER_BUFFER_COUNT];
+    u32 spawn_count = packet_data ? packet_data->spawn_count : 0;
+    u32 emitter_count = packet_data ? packet_data->emitter_count : 0;
+    f32 delta_time = packet_data ? packet_data->delta_time : 0.0f;
+    if (spawn_count && !renderer_renderbuffer_load_range(emitter_buffer, 0, sizeof(particle_emitter_data) * emitter_count, packet_data->emitters)) {
+        KERROR("Failed to upload particle emitters. Nothing spawns this frame.");
+        spawn_count = 0;
+        emitter_count = 0;
+    }
+
+    // The last frame drew from what is written from here on.
+    renderer_barrier(RENDERER_BARRIER_GRAPHICS_TO_COMPUTE);
+
+    // Spawning also starts the frame's draw, so is dispatched even with nothing to spawn.
+    particles_emit_shader* emit = &data->emit;
+    if (!shader_system_use_by_id(emit->s->id) ||
+        !shader_system_uniform_set_by_index(emit->particles_location, &data->particle_buffer) ||
+        !shader_system_uniform_set_by_index(emit->free_list_location, &data->free_list_buffer) ||
+        !shader_system_uniform_set_by_index(emit->emitters_location, emitter_buffer) ||
+        !shader_system_uniform_set_by_index(emit->draw_location, &data->draw_buffer) ||
+        !shader_system_uniform_set_by_index(emit->spawn_count_location, &spawn_count) ||
+        !shader_system_uniform_set_by_index(emit->emitter_count_location, &emitter_count)) {
+        KERROR("Failed to apply the particle emission shader.");
+        return false;
+    }
+    renderer_dispatch(KMAX((spawn_count + PARTICLES_VIEW_WORKGROUP_SIZE - 1) / PARTICLES_VIEW_WORKGROUP_SIZE, 1), 1, 1);
+    renderer_barrier(RENDERER_BARRIER_COMPUTE_TO_COMPUTE);
+
+    particles_simulate_shader* simulate = &data->simulate;
+    u32 capacity = PARTICLES_VIEW_CAPACITY;
+    if (!shader_system_use_by_id(simulate->s->id) ||
+        !shader_system_uniform_set_by_index(simulate->particles_location, &data->particle_buffer) ||
+        !shader_system_uniform_set_by_index(simulate->free_list_location, &data->free_list_buffer) ||
+        !shader_system_uniform_set_by_index(simulate->sort_entries_location, &data->sort_buffer) ||
+        !shader_system_uniform_set_by_index(simulate->draw_location, &data->draw_buffer) ||
+        !shader_system_uniform_set_by_index(simulate->view_location, &packet->view_matrix) ||
+        !shader_system_uniform_set_by_index(simulate->delta_time_location, &delta_time) ||
+        !shader_system_uniform_set_by_index(simulate->capacity_location, &capacity)) {
+        KERROR("Failed to apply the particle simulation shader.");
+        return false;
+    }
+    renderer_dispatch(PARTICLES_VIEW_CAPACITY / PARTICLES_VIEW_WORKGROUP_SIZE, 1, 1);
+    renderer_barrier(RENDERER_BARRIER_COMPUTE_TO_COMPUTE);
+
+    // A bitonic sort of the whole pool. Every sequence up to a block long is sorted by one dispatch of
+    // local steps, then each longer sequence merged by a dispatch for each step comparing entries at
+    // least a block apart, and one of local steps for the rest.
+    particles_sort_shader* sort = &data->sort;
+    if (!shader_system_use_by_id(sort->s->id) || !shader_system_uniform_set_by_index(sort->sort_entries_location, &data->sort_buffer)) {
+        KERROR("Failed to apply the particle sort shader.");
+        return false;
+    }
+    u32 block_count = PARTICLES_VIEW_CAPACITY / PARTICLES_VIEW_SORT_BLOCK_SIZE;
+    u32 local_steps = 1;
+    u32 global_steps = 0;
+    for (u32 k = PARTICLES_VIEW_SORT_BLOCK_SIZE; k <= PARTICLES_VIEW_CAPACITY; k <<= 1) {
+        for (u32 j = k >> 1; j >= PARTICLES_VIEW_SORT_BLOCK_SIZE; j >>= 1) {
+            shader_system_uniform_set_by_index(sort->k_location, &k);
+            shader_system_uniform_set_by_index(sort->j_location, &j);
+            shader_system_uniform_set_by_index(sort->local_steps_location, &global_steps);
+            renderer_dispatch(block_count, 1, 1);
+            renderer_barrier(RENDERER_BARRIER_COMPUTE_TO_COMPUTE);
+        }
+        u32 j = PARTICLES_VIEW_SORT_BLOCK_SIZE >> 1;
+        shader_system_uniform_set_by_index(sort->k_location, &k);
+        shader_system_uniform_set_by_index(sort->j_location, &j);
+        shader_system_uniform_set_by_index(sort->local_steps_location, &local_steps);
+        renderer_dispatch(block_count, 1, 1);
+        renderer_barrier(k == PARTICLES_VIEW_CAPACITY ? RENDERER_BARRIER_COMPUTE_TO_GRAPHICS : RENDERER_BARRIER_COMPUTE_TO_COMPUTE);
+    }
+    return true;
+}
+
+b8 render_view_particles_on_render(const struct render_view* self, const struct render_view_packet* packet, u64 frame_number, u64 render_target_index) {
+    KPROFILE_ZONE("render_view_particles_on_render");
+    render_view_particles_internal_data* data = self->internal_data;
+
+    // Compute is recorded outside of the passes.
+    if (!particles_update(data, packet, frame_number)) {
+        return false;
+    }
+
+    for (u32 p = 0; p < self->renderpass_count; ++p) {
+        renderpass* pass = &self->passes[p];
+        // Begun even with nothing alive, as the passes after it expect the attachments as it leaves them.
+        if (!renderer_renderpass_begin(pass, &pass->targets[render_target_index])) {
+            KERROR("render_view_particles_on_render pass index %u failed to start.", p);
+            return false;
+        }
+
+        // How many are alive is only known to the GPU, which draws that many.
+        particles_draw_shader* draw = &data->draw;
+        if (!shader_system_use_by_id(draw->s->id)) {
+            KERROR("Failed to use particle shader. Render frame failed.");
+            return false;
+        }
+        renderer_shader_bind_globals(draw->s);
+        if (!shader_system_uniform_set_by_index(draw->projection_location, &packet->projection_matrix) ||
+            !shader_system_uniform_set_by_index(draw->view_location, &packet->view_matrix) ||
+            !shader_system_uniform_set_by_index(draw->particles_location, &data->particle_buffer) ||
+            !shader_system_uniform_set_by_index(draw->sort_entries_location, &data->sort_buffer)) {
+            KERROR("Failed to apply particle shader globals.");
+            return false;
+        }
+        shader_system_apply_global();
+        if (!renderer_renderbuffer_draw_indirect(&data->draw_buffer, 0)) {
+            KERROR("Failed to draw particles.");
+        }
+
+        if (!renderer_renderpass_end(pass)) {
+            KERROR("render_view_particles_on_render pass index %u failed to end.", p);
+            return false;
+        }
+    }
+
+    return true;
+}
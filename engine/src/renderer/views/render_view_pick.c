@@ -1,19 +1,24 @@
 #include "render_view_pick.h"
 
 #include "core/logger.h"
+#include "core/profiler.h"
 #include "core/kmemory.h"
 #include "core/event.h"
 #include "core/kstring.h"
 #include "core/uuid.h"
+#include "core/identifier.h"
 #include "math/kmath.h"
 #include "math/transform.h"
+#include "math/geometry_utils.h"
 #include "memory/linear_allocator.h"
+#include "containers/bitset.h"
 #include "containers/darray.h"
 #include "systems/resource_system.h"
 #include "systems/shader_system.h"
 #include "systems/camera_system.h"
 #include "systems/render_view_system.h"
 #include "renderer/renderer_frontend.h"
+#include "renderer/render_scene.h"
 #include "resources/ui_text.h"
 
 typedef struct render_view_pick_shader_info {
@@ -34,29 +39,125 @@ typedef struct render_view_pick_internal_data {
     render_view_pick_shader_info ui_shader_info;
     render_view_pick_shader_info world_shader_info;
 
-    // Used as the colour attachment for both renderpasses.
+    // Used as the colour attachment for both renderpasses. Only PICK_TARGET_SIZE square, around the cursor.
     texture colour_target_attachment_texture;
     // The depth attachment.
     texture depth_target_attachment_texture;
 
     i32 instance_count;
-    b8* instance_updated;
+    // One bit per instance, set once its instance data has been applied this frame.
+    bitset instance_updated;
 
     i16 mouse_x, mouse_y;
-    // u32 render_mode;
+    render_view_pick_mode mode;
+    // The frames left to pick in outside of every-frame mode, counted down after each change.
+    u8 frames_to_render;
+    // The generation of the camera as of the last packet, to notice it moving.
+    u32 last_camera_generation;
+    // The cursor position as of the last mouse move, taken up by the next packet, as the last frame
+    // may still be reading the current one.
+    i16 moved_mouse_x, moved_mouse_y;
+    // The id last reported, so the same one read back frame after frame is only reported once.
+    u32 reported_id;
 } render_view_pick_internal_data;
 
+// Readbacks come back a frame in flight late, so after a change the pick is rendered this many
+// frames, one more than the most frames there may be in flight, to read back a render made after it.
+#define PICK_FRAMES_PER_CHANGE 3
+
+// The size in pixels of the square pick target, centred on the cursor. Odd, so a pixel is its centre.
+#define PICK_TARGET_SIZE 1
+
+// Reports the id under the cursor, or INVALID_ID for none, unless it is the one last reported.
+// Posted, as it may be obtained on the render thread, to be fired on the main thread.
+static void hover_id_report(render_view_pick_internal_data* data, u32 id) {
+    if (id == data->reported_id) {
+        return;
+    }
+    data->reported_id = id;
+    event_context context;
+    context.data.u32[0] = id;
+    event_post(EVENT_CODE_OBJECT_HOVER_ID_CHANGED, 0, context);
+}
+
+// The colour an id is picked by: the id in rgb, and its generation in alpha, so a pick read back after
+// the id was released and acquired again is not taken for the new owner. Generations stop short of the
+// alpha of the cleared target.
+static vec4 id_colour_get(u32 id) {
+    vec3 rgb;
+    u32 r, g, b;
+    u32_to_rgb(id, &r, &g, &b);
+    rgb_u32_to_vec3(r, g, b, &rgb);
+    u32 generation = identifier_generation_get(id);
+    return (vec4){rgb.r, rgb.g, rgb.b, (generation == INVALID_ID ? 0 : generation % 255) / 255.0f};
+}
+
+// Obtains the id a read back pixel was picked by, or INVALID_ID if none or one since released.
+static u32 pixel_id_get(const u8 pixel[4]) {
+    u32 id = INVALID_ID;
+    rgbu_to_u32(pixel[0], pixel[1], pixel[2], &id);
+    if (id == 0x00FFFFFF || pixel[3] == 255) {
+        // This is the cleared target.
+        return INVALID_ID;
+    }
+    u32 generation = identifier_generation_get(id);
+    if (!identifier_owner_get(id) || generation == INVALID_ID || generation % 255 != pixel[3]) {
+        return INVALID_ID;
+    }
+    return id;
+}
+
+// The ray through the centre of the pixel under the cursor.
+static ray cursor_ray_get(const render_view* self) {
+    render_view_pick_internal_data* data = self->internal_data;
+    return ray_from_screen(data->mouse_x + 0.5f, data->mouse_y + 0.5f, (f32)self->width, (f32)self->height, data->world_shader_info.view, data->world_shader_info.projection);
+}
+
+// Applied after a projection, scales up the pixels around the cursor so the PICK_TARGET_SIZE square of
+// them centred on it fills the pick target, which the rest are clipped from before they are rasterized.
+static mat4 cursor_matrix_get(const render_view* self) {
+    render_view_pick_internal_data* data = self->internal_data;
+    f32 width = (f32)self->width;
+    f32 height = (f32)self->height;
+    // The centre of the pixel under the cursor in normalized device coordinates, kept within the window.
+    f32 ndc_x = 2.0f * (KCLAMP(data->mouse_x, 0, self->width - 1) + 0.5f) / width - 1.0f;
+    f32 ndc_y = 1.0f - 2.0f * (KCLAMP(data->mouse_y, 0, self->height - 1) + 0.5f) / height;
+    mat4 m = mat4_identity();
+    m.data[0] = width / PICK_TARGET_SIZE;
+    m.data[5] = height / PICK_TARGET_SIZE;
+    m.data[12] = -ndc_x * m.data[0];
+    m.data[13] = -ndc_y * m.data[5];
+    return m;
+}
+
+// Picks the world geometry under the cursor without rendering, by casting a ray through it against
+// the bounds of each candidate geometry and taking the nearest hit.
+static u32 cpu_pick(const render_view* self, const render_view_packet* packet) {
+    pick_packet_data* packet_data = (pick_packet_data*)packet->extended_data;
+    ray r = cursor_ray_get(self);
+
+    u32 id = INVALID_ID;
+    f32 nearest = K_INFINITY;
+    u32 world_geometry_count = packet_data->world_geometry_count;
+    for (u32 i = 0; i < world_geometry_count; ++i) {
+        const geometry_render_data* geo = &packet->geometries[i];
+        f32 distance;
+        if (ray_intersects_extents(r, extents_3d_transform(geo->geometry->extents, geo->model), &distance) && distance < nearest) {
+            nearest = distance;
+            id = geo->unique_id;
+        }
+    }
+    return id;
+}
+
 b8 on_mouse_moved(u16 code, void* sender, void* listener_inst, event_context event_data) {
     if (code == EVENT_CODE_MOUSE_MOVED) {
         render_view* self = (render_view*)listener_inst;
         render_view_pick_internal_data* data = (render_view_pick_internal_data*)self->internal_data;
 
-        // Update position and regenerate the projection matrix.
-        i16 y = event_data.data.i16[1];
-        i16 x = event_data.data.i16[0];
-
-        data->mouse_x = x;
-        data->mouse_y = y;
+        // Taken up by the next packet.
+        data->moved_mouse_x = event_data.data.i16[0];
+        data->moved_mouse_y = event_data.data.i16[1];
 
         return true;
     }
@@ -95,7 +196,7 @@ void acquire_shader_instances(const struct render_view* self) {
         return;
     }
     data->instance_count++;
-    darray_push(data->instance_updated, false);
+    bitset_resize(&data->instance_updated, data->instance_count);
 }
 
 void release_shader_instances(const struct render_view* self) {
@@ -112,7 +213,7 @@ void release_shader_instances(const struct render_view* self) {
             KWARN("Failed to release shader resources.");
         }
     }
-    darray_destroy(data->instance_updated);
+    bitset_destroy(&data->instance_updated);
 }
 
 b8 render_view_pick_on_create(struct render_view* self) {
@@ -120,7 +221,7 @@ b8 render_view_pick_on_create(struct render_view* self) {
         self->internal_data = kallocate(sizeof(render_view_pick_internal_data), MEMORY_TAG_RENDERER);
         render_view_pick_internal_data* data = self->internal_data;
 
-        data->instance_updated = darray_create(b8);
+        bitset_create(0, 0, &data->instance_updated);
 
         // NOTE: In this heavily-customized view, the exact number of passes is known, so
         // these index assumptions are fine.
@@ -175,18 +276,28 @@ b8 render_view_pick_on_create(struct render_view* self) {
         data->world_shader_info.projection_location = shader_system_uniform_index(data->world_shader_info.s, "projection");
         data->world_shader_info.view_location = shader_system_uniform_index(data->world_shader_info.s, "view");
 
-        // Default World properties
-        data->world_shader_info.near_clip = 0.1f;
-        data->world_shader_info.far_clip = 1000.0f;
-        data->world_shader_info.fov = deg_to_rad(45.0f);
-        data->world_shader_info.projection = mat4_perspective(data->world_shader_info.fov, 1280 / 720.0f, data->world_shader_info.near_clip, data->world_shader_info.far_clip);
+        // Default World properties. The projection and view come from the camera each frame.
+        data->world_shader_info.projection = mat4_identity();
         data->world_shader_info.view = mat4_identity();
+        data->last_camera_generation = INVALID_ID;
 
         data->instance_count = 0;
 
+        data->mode = RENDER_VIEW_PICK_MODE_ON_DEMAND;
+        data->frames_to_render = PICK_FRAMES_PER_CHANGE;
+        data->reported_id = INVALID_ID;
+
+        // Only the pixels around the cursor are ever rendered, whatever the size of the window.
+        for (u32 i = 0; i < self->renderpass_count; ++i) {
+            self->passes[i].render_area = (vec4){0, 0, PICK_TARGET_SIZE, PICK_TARGET_SIZE};
+        }
+
         kzero_memory(&data->colour_target_attachment_texture, sizeof(texture));
         kzero_memory(&data->depth_target_attachment_texture, sizeof(texture));
 
+        // Only the latest pick posted before a dispatch matters.
+        event_set_coalesced(EVENT_CODE_OBJECT_HOVER_ID_CHANGED, true);
+
         // Register for mouse move event.
         if (!event_register(EVENT_CODE_MOUSE_MOVED, self, on_mouse_moved)) {
             KERROR("Unable to listen for mouse move event, creation failed.");
@@ -232,18 +343,15 @@ void render_view_pick_on_resize(struct render_view* self, u32 width, u32 height)
     data->ui_shader_info.projection = mat4_orthographic(0.0f, (f32)width, (f32)height, 0.0f, data->ui_shader_info.near_clip, data->ui_shader_info.far_clip);
 
     // World
-    f32 aspect = (f32)self->width / self->height;
-    data->world_shader_info.projection = mat4_perspective(data->world_shader_info.fov, aspect, data->world_shader_info.near_clip, data->world_shader_info.far_clip);
+    // TODO: Get active camera.
+    camera_aspect_set(camera_system_get_default(), (f32)self->width / self->height);
 
-    for (u32 i = 0; i < self->renderpass_count; ++i) {
-        self->passes[i].render_area.x = 0;
-        self->passes[i].render_area.y = 0;
-        self->passes[i].render_area.z = width;
-        self->passes[i].render_area.w = height;
-    }
+    // The pick targets stay the same size, but what is under the cursor may have moved.
+    data->frames_to_render = PICK_FRAMES_PER_CHANGE;
 }
 
 b8 render_view_pick_on_build_packet(const struct render_view* self, struct linear_allocator* frame_allocator, void* data, struct render_view_packet* out_packet) {
+    KPROFILE_ZONE("render_view_pick_on_build_packet");
     if (!self || !data || !out_packet) {
         KWARN("render_view_pick_on_build_packet requires valid pointer to view, packet, and data.");
         return false;
@@ -252,27 +360,54 @@ b8 render_view_pick_on_build_packet(const struct render_view* self, struct linea
     pick_packet_data* packet_data = (pick_packet_data*)data;
     render_view_pick_internal_data* internal_data = (render_view_pick_internal_data*)self->internal_data;
 
-    out_packet->geometries = darray_create(geometry_render_data);
     out_packet->view = self;
 
     // TODO: Get active camera.
     camera* world_camera = camera_system_get_default();
     internal_data->world_shader_info.view = camera_view_get(world_camera);
+    internal_data->world_shader_info.projection = camera_projection_get(world_camera);
+    if (world_camera->generation != internal_data->last_camera_generation) {
+        internal_data->last_camera_generation = world_camera->generation;
+        internal_data->frames_to_render = PICK_FRAMES_PER_CHANGE;
+    }
+    if (internal_data->moved_mouse_x != internal_data->mouse_x || internal_data->moved_mouse_y != internal_data->mouse_y) {
+        internal_data->mouse_x = internal_data->moved_mouse_x;
+        internal_data->mouse_y = internal_data->moved_mouse_y;
+        internal_data->frames_to_render = PICK_FRAMES_PER_CHANGE;
+    }
+    // Nothing is rendered while there is nothing to pick again, or when picking on the CPU, so the
+    // targets are not created until it is.
+    out_packet->targets_unused = internal_data->mode == RENDER_VIEW_PICK_MODE_CPU || (internal_data->mode == RENDER_VIEW_PICK_MODE_ON_DEMAND && internal_data->frames_to_render == 0);
+
+    // Only the world geometries whose bounds the ray through the cursor hits can be under it, so only
+    // those few are drawn, found through the scene's bvh if there is one. The depth test among them
+    // leaves the nearest. The ui is drawn whole, as there is little of it.
+    out_packet->geometries = darray_create_with_allocator(geometry_render_data, frame_allocator);
+    ray r = cursor_ray_get(self);
+    if (packet_data->world_scene) {
+        render_scene_ray_query(packet_data->world_scene, r, world_camera->far_clip, &out_packet->geometries);
+    } else {
+        u32 world_mesh_count = darray_length(packet_data->world_mesh_data);
+        for (u32 i = 0; i < world_mesh_count; ++i) {
+            const geometry_render_data* geo = &packet_data->world_mesh_data[i];
+            f32 distance;
+            if (geo->geometry && ray_intersects_extents(r, extents_3d_transform(geo->geometry->extents, geo->model), &distance)) {
+                darray_push(out_packet->geometries, *geo);
+            }
+        }
+    }
+    u32 world_geometry_count = darray_length(out_packet->geometries);
 
     // Set the pick packet data to extended data.
+    packet_data->world_geometry_count = world_geometry_count;
     packet_data->ui_geometry_count = 0;
     out_packet->extended_data = linear_allocator_allocate(frame_allocator, sizeof(pick_packet_data));
 
-    u32 world_geometry_count = darray_length(packet_data->world_mesh_data);
-
     i32 highest_instance_id = 0;
-    // Iterate all geometries in world data.
     for (u32 i = 0; i < world_geometry_count; ++i) {
-       darray_push(out_packet->geometries, packet_data->world_mesh_data[i]);
-
         // Count all geometries as a single id.
-        if (packet_data->world_mesh_data[i].unique_id > highest_instance_id) {
-            highest_instance_id = packet_data->world_mesh_data[i].unique_id;
+        if (out_packet->geometries[i].unique_id > highest_instance_id) {
+            highest_instance_id = out_packet->geometries[i].unique_id;
         }
     }
 
@@ -319,196 +454,224 @@ b8 render_view_pick_on_build_packet(const struct render_view* self, struct linea
 }
 
 void render_view_pick_on_destroy_packet(const struct render_view* self, struct render_view_packet* packet) {
+    // NOTE: Only frees anything if the frame allocator ran out and the heap was used instead.
     darray_destroy(packet->geometries);
     kzero_memory(packet, sizeof(render_view_packet));
 }
 
 b8 render_view_pick_on_render(const struct render_view* self, const struct render_view_packet* packet, u64 frame_number, u64 render_target_index) {
+    KPROFILE_ZONE("render_view_pick_on_render");
     render_view_pick_internal_data* data = self->internal_data;
 
-    u32 p = 0;
-    renderpass* pass = &self->passes[p];  // First pass
+    if (data->mode != RENDER_VIEW_PICK_MODE_CPU && !self->render_targets_generated) {
+        // Asked for after the packet was built, so picked once the next packet creates the targets.
+        return true;
+    }
 
-    if (render_target_index == 0) {
-        // Reset.
-        u64 count = darray_length(data->instance_updated);
-        for (u64 i = 0; i < count; ++i) {
-            data->instance_updated[i] = false;
+    if (data->mode != RENDER_VIEW_PICK_MODE_EVERY_FRAME) {
+        // Nothing under the cursor can have changed since the last pick came back.
+        if (data->frames_to_render == 0) {
+            return true;
         }
-
-        if (!renderer_renderpass_begin(pass, &pass->targets[render_target_index])) {
-            KERROR("render_view_ui_on_render pass index %u failed to start.", p);
-            return false;
+        data->frames_to_render--;
+        if (data->mode == RENDER_VIEW_PICK_MODE_CPU) {
+            data->frames_to_render = 0;
+            hover_id_report(data, cpu_pick(self, packet));
+            return true;
         }
+    }
 
-        pick_packet_data* packet_data = (pick_packet_data*)packet->extended_data;
+    // The passes have one target each, however many images the window has.
+    u32 target_index = 0;
+    // Both passes draw into the small target around the cursor, through projections zoomed in on it.
+    vec4 target_viewport = {0, PICK_TARGET_SIZE, PICK_TARGET_SIZE, -PICK_TARGET_SIZE};
+    vec4 target_scissor = {0, 0, PICK_TARGET_SIZE, PICK_TARGET_SIZE};
+    mat4 cursor_matrix = cursor_matrix_get(self);
+    mat4 world_projection = mat4_mul(data->world_shader_info.projection, cursor_matrix);
+    mat4 ui_projection = mat4_mul(data->ui_shader_info.projection, cursor_matrix);
 
-        i32 current_instance_id = 0;
+    u32 p = 0;
+    renderpass* pass = &self->passes[p];  // First pass
 
-        // World
-        if (!shader_system_use_by_id(data->world_shader_info.s->id)) {
-            KERROR("Failed to use world pick shader. Render frame failed.");
-            return false;
-        }
+    // Reset.
+    bitset_clear_all(&data->instance_updated);
 
-        // Apply globals
-        if (!shader_system_uniform_set_by_index(data->world_shader_info.projection_location, &data->world_shader_info.projection)) {
-            KERROR("Failed to apply projection matrix");
-        }
-        if (!shader_system_uniform_set_by_index(data->world_shader_info.view_location, &data->world_shader_info.view)) {
-            KERROR("Failed to apply view matrix");
-        }
-        shader_system_apply_global();
-
-        // Draw geometries. Start from 0 since world geometries are added first, and stop at the world geometry count.
-        u32 world_geometry_count = darray_length(packet_data->world_mesh_data);
-        for (u32 i = 0; i < world_geometry_count; ++i) {
-            geometry_render_data* geo = &packet->geometries[i];
-            current_instance_id = geo->unique_id;
-
-            shader_system_bind_instance(current_instance_id);
-
-            // Get colour based on id
-            vec3 id_colour;
-            u32 r, g, b;
-            u32_to_rgb(geo->unique_id, &r, &g, &b);
-            rgb_u32_to_vec3(r, g, b, &id_colour);
-            if (!shader_system_uniform_set_by_index(data->world_shader_info.id_colour_location, &id_colour)) {
-                KERROR("Failed to apply id colour uniform.");
-                return false;
-            }
+    if (!renderer_renderpass_begin(pass, &pass->targets[target_index])) {
+        KERROR("render_view_ui_on_render pass index %u failed to start.", p);
+        return false;
+    }
+    renderer_viewport_set(target_viewport);
+    renderer_scissor_set(target_scissor);
 
-            b8 needs_update = !data->instance_updated[current_instance_id];
-            shader_system_apply_instance(needs_update);
-            data->instance_updated[current_instance_id] = true;
+    pick_packet_data* packet_data = (pick_packet_data*)packet->extended_data;
 
-            // Apply the locals
-            if (!shader_system_uniform_set_by_index(data->world_shader_info.model_location, &geo->model)) {
-                KERROR("Failed to apply model matrix for world geometry.");
-            }
+    i32 current_instance_id = 0;
 
-            // Draw it.
-            renderer_draw_geometry(&packet->geometries[i]);
-        }
+    // World
+    if (!shader_system_use_by_id(data->world_shader_info.s->id)) {
+        KERROR("Failed to use world pick shader. Render frame failed.");
+        return false;
+    }
 
-        if (!renderer_renderpass_end(pass)) {
-            KERROR("render_view_ui_on_render pass index %u failed to end.", p);
-            return false;
-        }
+    // Apply globals
+    if (!shader_system_uniform_set_by_index(data->world_shader_info.projection_location, &world_projection)) {
+        KERROR("Failed to apply projection matrix");
+    }
+    if (!shader_system_uniform_set_by_index(data->world_shader_info.view_location, &data->world_shader_info.view)) {
+        KERROR("Failed to apply view matrix");
+    }
+    shader_system_apply_global();
 
-        p++;
-        pass = &self->passes[p];  // Second pass
+    // Draw geometries. Start from 0 since world geometries are added first, and stop at the world geometry count.
+    u32 world_geometry_count = packet_data->world_geometry_count;
+    for (u32 i = 0; i < world_geometry_count; ++i) {
+        geometry_render_data* geo = &packet->geometries[i];
+        current_instance_id = geo->unique_id;
 
-        if (!renderer_renderpass_begin(pass, &pass->targets[render_target_index])) {
-            KERROR("render_view_ui_on_render pass index %u failed to start.", p);
-            return false;
-        }
+        shader_system_bind_instance(current_instance_id);
 
-        // UI
-        if (!shader_system_use_by_id(data->ui_shader_info.s->id)) {
-            KERROR("Failed to use material shader. Render frame failed.");
+        // Get colour based on id
+        vec4 id_colour = id_colour_get(geo->unique_id);
+        if (!shader_system_uniform_set_by_index(data->world_shader_info.id_colour_location, &id_colour)) {
+            KERROR("Failed to apply id colour uniform.");
             return false;
         }
 
-        // Apply globals
-        if (!shader_system_uniform_set_by_index(data->ui_shader_info.projection_location, &data->ui_shader_info.projection)) {
-            KERROR("Failed to apply projection matrix");
-        }
-        if (!shader_system_uniform_set_by_index(data->ui_shader_info.view_location, &data->ui_shader_info.view)) {
-            KERROR("Failed to apply view matrix");
+        b8 needs_update = !bitset_test(&data->instance_updated, current_instance_id);
+        shader_system_apply_instance(needs_update);
+        bitset_set(&data->instance_updated, current_instance_id);
+
+        // Apply the locals
+        if (!shader_system_uniform_set_by_index(data->world_shader_info.model_location, &geo->model)) {
+            KERROR("Failed to apply model matrix for world geometry.");
         }
-        shader_system_apply_global();
-
-        // Draw geometries. Start off where world geometries left off.
-        for (u32 i = world_geometry_count; i < packet->geometry_count; ++i) {
-            geometry_render_data* geo = &packet->geometries[i];
-            current_instance_id = geo->unique_id;
-
-            shader_system_bind_instance(current_instance_id);
-
-            // Get colour based on id
-            vec3 id_colour;
-            u32 r, g, b;
-            u32_to_rgb(geo->unique_id, &r, &g, &b);
-            rgb_u32_to_vec3(r, g, b, &id_colour);
-            if (!shader_system_uniform_set_by_index(data->ui_shader_info.id_colour_location, &id_colour)) {
-                KERROR("Failed to apply id colour uniform.");
-                return false;
-            }
+        shader_system_apply_local();
+
+        // Draw it.
+        renderer_draw_geometry(&packet->geometries[i]);
+    }
 
-            b8 needs_update = !data->instance_updated[current_instance_id];
-            shader_system_apply_instance(needs_update);
-            data->instance_updated[current_instance_id] = true;
+    renderer_viewport_reset();
+    renderer_scissor_reset();
+    if (!renderer_renderpass_end(pass)) {
+        KERROR("render_view_ui_on_render pass index %u failed to end.", p);
+        return false;
+    }
 
-            // Apply the locals
-            if (!shader_system_uniform_set_by_index(data->ui_shader_info.model_location, &geo->model)) {
-                KERROR("Failed to apply model matrix for text");
-            }
+    p++;
+    pass = &self->passes[p];  // Second pass
 
-            // Draw it.
-            renderer_draw_geometry(&packet->geometries[i]);
-        }
+    if (!renderer_renderpass_begin(pass, &pass->targets[target_index])) {
+        KERROR("render_view_ui_on_render pass index %u failed to start.", p);
+        return false;
+    }
+    renderer_viewport_set(target_viewport);
+    renderer_scissor_set(target_scissor);
 
-        // Draw bitmap text
-        for (u32 i = 0; i < packet_data->text_count; ++i) {
-            ui_text* text = packet_data->texts[i];
-            current_instance_id = text->unique_id;
-            shader_system_bind_instance(current_instance_id);
-
-            // Get colour based on id
-            vec3 id_colour;
-            u32 r, g, b;
-            u32_to_rgb(text->unique_id, &r, &g, &b);
-            rgb_u32_to_vec3(r, g, b, &id_colour);
-            if (!shader_system_uniform_set_by_index(data->ui_shader_info.id_colour_location, &id_colour)) {
-                KERROR("Failed to apply id colour uniform.");
-                return false;
-            }
+    // UI
+    if (!shader_system_use_by_id(data->ui_shader_info.s->id)) {
+        KERROR("Failed to use material shader. Render frame failed.");
+        return false;
+    }
 
-            shader_system_apply_instance(true);
+    // Apply globals
+    if (!shader_system_uniform_set_by_index(data->ui_shader_info.projection_location, &ui_projection)) {
+        KERROR("Failed to apply projection matrix");
+    }
+    if (!shader_system_uniform_set_by_index(data->ui_shader_info.view_location, &data->ui_shader_info.view)) {
+        KERROR("Failed to apply view matrix");
+    }
+    shader_system_apply_global();
 
-            // Apply the locals
-            mat4 model = transform_get_world(&text->transform);
-            if (!shader_system_uniform_set_by_index(data->ui_shader_info.model_location, &model)) {
-                KERROR("Failed to apply model matrix for text");
-            }
+    // Draw geometries. Start off where world geometries left off.
+    for (u32 i = world_geometry_count; i < packet->geometry_count; ++i) {
+        geometry_render_data* geo = &packet->geometries[i];
+        current_instance_id = geo->unique_id;
+
+        shader_system_bind_instance(current_instance_id);
 
-            ui_text_draw(text);
+        // Get colour based on id
+        vec4 id_colour = id_colour_get(geo->unique_id);
+        if (!shader_system_uniform_set_by_index(data->ui_shader_info.id_colour_location, &id_colour)) {
+            KERROR("Failed to apply id colour uniform.");
+            return false;
+        }
+
+        b8 needs_update = !bitset_test(&data->instance_updated, current_instance_id);
+        shader_system_apply_instance(needs_update);
+        bitset_set(&data->instance_updated, current_instance_id);
+
+        // Apply the locals
+        if (!shader_system_uniform_set_by_index(data->ui_shader_info.model_location, &geo->model)) {
+            KERROR("Failed to apply model matrix for text");
         }
+        shader_system_apply_local();
 
-        if (!renderer_renderpass_end(pass)) {
-            KERROR("render_view_ui_on_render pass index %u failed to end.", p);
+        // Draw it.
+        renderer_draw_geometry(&packet->geometries[i]);
+    }
+
+    // Draw bitmap text
+    for (u32 i = 0; i < packet_data->text_count; ++i) {
+        ui_text* text = packet_data->texts[i];
+        current_instance_id = text->unique_id;
+        shader_system_bind_instance(current_instance_id);
+
+        // Get colour based on id
+        vec4 id_colour = id_colour_get(text->unique_id);
+        if (!shader_system_uniform_set_by_index(data->ui_shader_info.id_colour_location, &id_colour)) {
+            KERROR("Failed to apply id colour uniform.");
             return false;
         }
+
+        shader_system_apply_instance(true);
+
+        // Apply the locals
+        mat4 model = transform_get_world(&text->transform);
+        if (!shader_system_uniform_set_by_index(data->ui_shader_info.model_location, &model)) {
+            KERROR("Failed to apply model matrix for text");
+        }
+        shader_system_apply_local();
+
+        ui_text_draw(text);
+    }
+
+    renderer_viewport_reset();
+    renderer_scissor_reset();
+    if (!renderer_renderpass_end(pass)) {
+        KERROR("render_view_ui_on_render pass index %u failed to end.", p);
+        return false;
     }
 
     // Read pixel data.
     texture* t = &data->colour_target_attachment_texture;
 
-    // Read the pixel at the mouse coordinate.
-    u8 pixel_rgba[4] = {0};
-    u8* pixel = &pixel_rgba[0];
-
-    // Clamp to image size
-    u16 x_coord = KCLAMP(data->mouse_x, 0, self->width - 1);
-    u16 y_coord = KCLAMP(data->mouse_y, 0, self->height - 1);
-    renderer_texture_read_pixel(t, x_coord, y_coord, &pixel);
-
-    // Extract the id from the sampled colour.
-    u32 id = INVALID_ID;
-    rgbu_to_u32(pixel[0], pixel[1], pixel[2], &id);
-    if (id == 0x00FFFFFF) {
-        // This is pure white.
-        id = INVALID_ID;
+    // Read the pixel under the mouse, at the centre of the target. The copy is not waited for, so what
+    // comes back is the pixel asked for a few frames ago, and nothing does for the first frames.
+    u8 pixel[4] = {0};
+    if (!renderer_texture_read_pixel_async(t, PICK_TARGET_SIZE / 2, PICK_TARGET_SIZE / 2, pixel)) {
+        return true;
     }
 
-    event_context context;
-    context.data.u32[0] = id;
-    event_fire(EVENT_CODE_OBJECT_HOVER_ID_CHANGED, 0, context);
+    // Extract the id from the sampled colour.
+    hover_id_report(data, pixel_id_get(pixel));
 
     return true;
 }
 
+void render_view_pick_mode_set(struct render_view* self, render_view_pick_mode mode) {
+    renderer_frame_sync();
+    render_view_pick_internal_data* data = self->internal_data;
+    data->mode = mode;
+    data->frames_to_render = PICK_FRAMES_PER_CHANGE;
+}
+
+void render_view_pick_request(struct render_view* self) {
+    renderer_frame_sync();
+    render_view_pick_internal_data* data = self->internal_data;
+    data->frames_to_render = PICK_FRAMES_PER_CHANGE;
+}
+
 b8 render_view_pick_regenerate_attachment_target(struct render_view* self, u32 pass_index, struct render_target_attachment* attachment) {
     render_view_pick_internal_data* data = self->internal_data;
 
@@ -553,6 +716,9 @@ b8 render_view_pick_regenerate_attachment_target(struct render_view* self, u32 p
     if (attachment->type == RENDER_TARGET_ATTACHMENT_TYPE_DEPTH) {
         attachment->texture->flags |= TEXTURE_FLAG_DEPTH;
     }
+    if (attachment->transient) {
+        attachment->texture->flags |= TEXTURE_FLAG_TRANSIENT;
+    }
     attachment->texture->internal_data = 0;
 
     renderer_texture_create_writeable(attachment->texture);
@@ -5,6 +5,26 @@
 
 struct linear_allocator;
 
+/**
+ * @brief How the pick view finds what is under the cursor. However it renders, only the world geometry
+ * whose bounds the ray through the cursor hits is drawn, with the ui, into a target of a few pixels
+ * around the cursor, so picking costs the same however large the scene or window.
+ */
+typedef enum render_view_pick_mode {
+    /** @brief The pick target is rendered every frame. */
+    RENDER_VIEW_PICK_MODE_EVERY_FRAME,
+    /**
+     * @brief Rendered only after the cursor or camera moves, the window is resized or a pick is
+     * requested. The default.
+     */
+    RENDER_VIEW_PICK_MODE_ON_DEMAND,
+    /**
+     * @brief Nothing is rendered. World geometry is picked on the CPU, by casting a ray through the
+     * cursor against the bounds of each candidate, when on demand would render. UI is not picked.
+     */
+    RENDER_VIEW_PICK_MODE_CPU
+} render_view_pick_mode;
+
 b8 render_view_pick_on_create(struct render_view* self);
 void render_view_pick_on_destroy(struct render_view* self);
 void render_view_pick_on_resize(struct render_view* self, u32 width, u32 height);
@@ -14,3 +34,19 @@ b8 render_view_pick_on_render(const struct render_view* self, const struct rende
 
 void render_view_pick_get_matrices(const struct render_view* self, mat4* out_view, mat4* out_projection);
 b8 render_view_pick_regenerate_attachment_target(struct render_view* self, u32 pass_index, struct render_target_attachment* attachment);
+
+/**
+ * @brief Sets how the given pick view finds what is under the cursor, picking again straight away.
+ *
+ * @param self A pointer to the pick view.
+ * @param mode The mode to pick with.
+ */
+KAPI void render_view_pick_mode_set(struct render_view* self, render_view_pick_mode mode);
+
+/**
+ * @brief Requests the given pick view picks again, such as when what is under the cursor moved
+ * without the cursor or camera doing so. Only needed outside of RENDER_VIEW_PICK_MODE_EVERY_FRAME.
+ *
+ * @param self A pointer to the pick view.
+ */
+KAPI void render_view_pick_request(struct render_view* self);
@@ -1,6 +1,7 @@
 #include "render_view_skybox.h"
 
 #include "core/logger.h"
+#include "core/profiler.h"
 #include "core/kmemory.h"
 #include "core/event.h"
 #include "math/kmath.h"
@@ -16,10 +17,7 @@
 
 typedef struct render_view_skybox_internal_data {
     shader* s;
-    f32 fov;
-    f32 near_clip;
-    f32 far_clip;
-    mat4 projection_matrix;
+    // The camera holds the projection, shared with the other views of it.
     camera* world_camera;
     // uniform locations
     u16 projection_location;
@@ -69,13 +67,6 @@ b8 render_view_skybox_on_create(struct render_view* self) {
         data->view_location = shader_system_uniform_index(data->s, "view");
         data->cube_map_location = shader_system_uniform_index(data->s, "cube_texture");
 
-        // TODO: Set from configuration.
-        data->near_clip = 0.1f;
-        data->far_clip = 1000.0f;
-        data->fov = deg_to_rad(45.0f);
-
-        // Default
-        data->projection_matrix = mat4_perspective(data->fov, 1280 / 720.0f, data->near_clip, data->far_clip);
         data->world_camera = camera_system_get_default();
 
         if(!event_register(EVENT_CODE_DEFAULT_RENDERTARGET_REFRESH_REQUIRED, self, render_view_on_event)) {
@@ -105,8 +96,7 @@ void render_view_skybox_on_resize(struct render_view* self, u32 width, u32 heigh
 
         self->width = width;
         self->height = height;
-        f32 aspect = (f32)self->width / self->height;
-        data->projection_matrix = mat4_perspective(data->fov, aspect, data->near_clip, data->far_clip);
+        camera_aspect_set(data->world_camera, (f32)self->width / self->height);
 
         for (u32 i = 0; i < self->renderpass_count; ++i) {
             self->passes[i].render_area.x = 0;
@@ -118,6 +108,7 @@ void render_view_skybox_on_resize(struct render_view* self, u32 width, u32 heigh
 }
 
 b8 render_view_skybox_on_build_packet(const struct render_view* self, struct linear_allocator* frame_allocator, void* data, struct render_view_packet* out_packet) {
+    KPROFILE_ZONE("render_view_skybox_on_build_packet");
     if (!self || !data || !out_packet) {
         KWARN("render_view_skybox_on_build_packet requires valid pointer to view, packet, and data.");
         return false;
@@ -129,7 +120,7 @@ b8 render_view_skybox_on_build_packet(const struct render_view* self, struct lin
     out_packet->view = self;
 
     // Set matrices, etc.
-    out_packet->projection_matrix = internal_data->projection_matrix;
+    out_packet->projection_matrix = camera_projection_get(internal_data->world_camera);
     out_packet->view_matrix = camera_view_get(internal_data->world_camera);
     out_packet->view_position = camera_position_get(internal_data->world_camera);
 
@@ -144,6 +135,7 @@ void render_view_skybox_on_destroy_packet(const struct render_view* self, struct
 }
 
 b8 render_view_skybox_on_render(const struct render_view* self, const struct render_view_packet* packet, u64 frame_number, u64 render_target_index) {
+    KPROFILE_ZONE("render_view_skybox_on_render");
     render_view_skybox_internal_data* data = self->internal_data;
     u32 shader_id = data->s->id;
 
@@ -1,6 +1,7 @@
 #include "render_view_ui.h"
 
 #include "core/logger.h"
+#include "core/profiler.h"
 #include "core/kmemory.h"
 #include "core/event.h"
 #include "math/kmath.h"
@@ -12,8 +13,13 @@
 #include "systems/render_view_system.h"
 #include "systems/shader_system.h"
 #include "renderer/renderer_frontend.h"
+#include "renderer/ui_batch.h"
 #include "resources/ui_text.h"
 
+// The most quads of text and UI batched each frame, and the most draws they may take.
+#define UI_BATCH_MAX_QUADS 16384
+#define UI_BATCH_MAX_DRAWS 256
+
 typedef struct render_view_ui_internal_data {
     shader* s;
     f32 near_clip;
@@ -23,9 +29,36 @@ typedef struct render_view_ui_internal_data {
     u16 diffuse_map_location;
     u16 diffuse_colour_location;
     u16 model_location;
+    // The variant drawing distance field text, or INVALID_ID_U8 if the shader has none.
+    u8 sdf_variant;
     // u32 render_mode;
+    // The text and quads of the frame, uploaded to the buffers below before it is drawn.
+    ui_batch batch;
+    u64 batch_memory_size;
+    void* batch_memory;
+    renderbuffer vertex_buffer;
+    renderbuffer index_buffer;
+    // What the batch was last built from. While the quads and texts of a frame are the same, the
+    // batch is kept as it is, so static UI is neither batched nor uploaded again.
+    b8 retained;
+    // darray
+    ui_quad* retained_quads;
+    // darray
+    struct ui_text_signature* retained_texts;
 } render_view_ui_internal_data;
 
+// What of a text its batched quads depend on.
+typedef struct ui_text_signature {
+    ui_text* text;
+    u32 revision;
+    mat4 world;
+    vec4 clip_rect;
+} ui_text_signature;
+
+static b8 rect_equal(vec4 a, vec4 b) {
+    return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w;
+}
+
 static b8 render_view_on_event(u16 code, void* sender, void* listener_inst, event_context context) {
     render_view* self = (render_view*)listener_inst;
     if (!self) {
@@ -67,6 +100,7 @@ b8 render_view_ui_on_create(struct render_view* self) {
         data->diffuse_map_location = shader_system_uniform_index(data->s, "diffuse_texture");
         data->diffuse_colour_location = shader_system_uniform_index(data->s, "diffuse_colour");
         data->model_location = shader_system_uniform_index(data->s, "model");
+        data->sdf_variant = shader_system_variant_index(data->s, "sdf");
         // TODO: Set from configuration.
         data->near_clip = -100.0f;
         data->far_clip = 100.0f;
@@ -75,6 +109,28 @@ b8 render_view_ui_on_create(struct render_view* self) {
         data->projection_matrix = mat4_orthographic(0.0f, 1280.0f, 720.0f, 0.0f, data->near_clip, data->far_clip);
         data->view_matrix = mat4_identity();
 
+        // The batch, and the buffers it is drawn from.
+        u32 vertex_capacity = UI_BATCH_MAX_QUADS * 4;
+        u32 index_capacity = UI_BATCH_MAX_QUADS * 6;
+        ui_batch_create(vertex_capacity, index_capacity, UI_BATCH_MAX_DRAWS, &data->batch_memory_size, 0, 0);
+        data->batch_memory = kallocate(data->batch_memory_size, MEMORY_TAG_RENDERER);
+        if (!ui_batch_create(vertex_capacity, index_capacity, UI_BATCH_MAX_DRAWS, &data->batch_memory_size, data->batch_memory, &data->batch)) {
+            KERROR("Failed to create UI batch.");
+            return false;
+        }
+        data->retained_quads = darray_create(ui_quad);
+        data->retained_texts = darray_create(ui_text_signature);
+        if (!renderer_renderbuffer_create(RENDERBUFFER_TYPE_VERTEX, sizeof(vertex_2d) * vertex_capacity, false, &data->vertex_buffer) ||
+            !renderer_renderbuffer_bind(&data->vertex_buffer, 0)) {
+            KERROR("Failed to create UI batch vertex buffer.");
+            return false;
+        }
+        if (!renderer_renderbuffer_create(RENDERBUFFER_TYPE_INDEX, sizeof(u32) * index_capacity, false, &data->index_buffer) ||
+            !renderer_renderbuffer_bind(&data->index_buffer, 0)) {
+            KERROR("Failed to create UI batch index buffer.");
+            return false;
+        }
+
         if (!event_register(EVENT_CODE_DEFAULT_RENDERTARGET_REFRESH_REQUIRED, self, render_view_on_event)) {
             KERROR("Unable to listen for refresh required event, creation failed.");
             return false;
@@ -91,6 +147,14 @@ void render_view_ui_on_destroy(struct render_view* self) {
         // Unregister from the event.
         event_unregister(EVENT_CODE_DEFAULT_RENDERTARGET_REFRESH_REQUIRED, self, render_view_on_event);
 
+        render_view_ui_internal_data* data = self->internal_data;
+        renderer_renderbuffer_destroy(&data->vertex_buffer);
+        renderer_renderbuffer_destroy(&data->index_buffer);
+        ui_batch_destroy(&data->batch);
+        kfree(data->batch_memory, data->batch_memory_size, MEMORY_TAG_RENDERER);
+        darray_destroy(data->retained_quads);
+        darray_destroy(data->retained_texts);
+
         kfree(self->internal_data, sizeof(render_view_ui_internal_data), MEMORY_TAG_RENDERER);
         self->internal_data = 0;
     }
@@ -114,7 +178,45 @@ void render_view_ui_on_resize(struct render_view* self, u32 width, u32 height) {
     }
 }
 
+// Indicates if the batch was last built from the same quads and texts as those of the given packet.
+static b8 ui_batch_is_retained(render_view_ui_internal_data* data, const ui_packet_data* packet_data) {
+    if (!data->retained || darray_length(data->retained_quads) != packet_data->quad_count || darray_length(data->retained_texts) != packet_data->text_count) {
+        return false;
+    }
+    for (u32 i = 0; i < packet_data->quad_count; ++i) {
+        const ui_quad* a = &data->retained_quads[i];
+        const ui_quad* b = &packet_data->quads[i];
+        if (a->m != b->m || !rect_equal(a->rect, b->rect) || !rect_equal(a->uv_rect, b->uv_rect) || !rect_equal(a->clip_rect, b->clip_rect)) {
+            return false;
+        }
+    }
+    for (u32 i = 0; i < packet_data->text_count; ++i) {
+        const ui_text_signature* signature = &data->retained_texts[i];
+        ui_text* text = packet_data->texts[i];
+        if (signature->text != text || signature->revision != text->revision || !rect_equal(signature->clip_rect, text->clip_rect)) {
+            return false;
+        }
+        mat4 world = transform_get_world(&text->transform);
+        for (u32 j = 0; j < 16; ++j) {
+            if (world.data[j] != signature->world.data[j]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// The given clip rectangle, within the view, as a scissor rectangle.
+static vec4 clip_scissor_get(const render_view* self, vec4 clip_rect) {
+    f32 left = KMAX(clip_rect.x, 0.0f);
+    f32 top = KMAX(clip_rect.y, 0.0f);
+    f32 right = KMIN(clip_rect.x + clip_rect.z, (f32)self->width);
+    f32 bottom = KMIN(clip_rect.y + clip_rect.w, (f32)self->height);
+    return (vec4){left, top, KMAX(right - left, 0.0f), KMAX(bottom - top, 0.0f)};
+}
+
 b8 render_view_ui_on_build_packet(const struct render_view* self, struct linear_allocator* frame_allocator, void* data, struct render_view_packet* out_packet) {
+    KPROFILE_ZONE("render_view_ui_on_build_packet");
     if (!self || !data || !out_packet) {
         KWARN("render_view_ui_on_build_packet requires valid pointer to view, packet, and data.");
         return false;
@@ -123,7 +225,7 @@ b8 render_view_ui_on_build_packet(const struct render_view* self, struct linear_
     ui_packet_data* packet_data = (ui_packet_data*)data;
     render_view_ui_internal_data* internal_data = (render_view_ui_internal_data*)self->internal_data;
 
-    out_packet->geometries = darray_create(geometry_render_data);
+    out_packet->geometries = darray_create_with_allocator(geometry_render_data, frame_allocator);
     out_packet->view = self;
 
     // Set matrices, etc.
@@ -147,18 +249,77 @@ b8 render_view_ui_on_build_packet(const struct render_view* self, struct linear_
         }
     }
 
+    // Keep the batch if it was built from the same quads and texts.
+    if (ui_batch_is_retained(internal_data, packet_data)) {
+        return true;
+    }
+
+    // Batch the quads, then the texts over them.
+    ui_batch* batch = &internal_data->batch;
+    ui_batch_reset(batch);
+    for (u32 i = 0; i < packet_data->quad_count; ++i) {
+        const ui_quad* quad = &packet_data->quads[i];
+        ui_batch_clip_set(batch, quad->clip_rect);
+        if (!ui_batch_quad_add(batch, quad->m, quad->rect, quad->uv_rect)) {
+            KWARN("UI batch is full. Skipping the remaining %u quads.", packet_data->quad_count - i);
+            break;
+        }
+    }
+    for (u32 i = 0; i < packet_data->text_count; ++i) {
+        ui_batch_clip_set(batch, packet_data->texts[i]->clip_rect);
+        if (!ui_batch_text_add(batch, packet_data->texts[i])) {
+            KWARN("UI batch is full. Skipping the remaining %u texts.", packet_data->text_count - i);
+            break;
+        }
+    }
+
+    // Remember what it was built from.
+    darray_clear(internal_data->retained_quads);
+    if (packet_data->quad_count) {
+        darray_push_range(internal_data->retained_quads, packet_data->quads, packet_data->quad_count);
+    }
+    darray_clear(internal_data->retained_texts);
+    for (u32 i = 0; i < packet_data->text_count; ++i) {
+        ui_text* text = packet_data->texts[i];
+        ui_text_signature signature = {text, text->revision, transform_get_world(&text->transform), text->clip_rect};
+        darray_push(internal_data->retained_texts, signature);
+    }
+    internal_data->retained = true;
+
     return true;
 }
 
 void render_view_ui_on_destroy_packet(const struct render_view* self, struct render_view_packet* packet) {
+    // NOTE: Only frees anything if the frame allocator ran out and the heap was used instead.
     darray_destroy(packet->geometries);
     kzero_memory(packet, sizeof(render_view_packet));
 }
 
 b8 render_view_ui_on_render(const struct render_view* self, const struct render_view_packet* packet, u64 frame_number, u64 render_target_index) {
+    KPROFILE_ZONE("render_view_ui_on_render");
     render_view_ui_internal_data* data = self->internal_data;
     u32 shader_id = data->s->id;
 
+    // Upload what changed of the batch since it was last uploaded, copied ahead of the frame.
+    ui_batch* batch = &data->batch;
+    b8 uploaded = true;
+    if (batch->dirty_vertex_first != INVALID_ID) {
+        u32 first = batch->dirty_vertex_first;
+        uploaded = renderer_renderbuffer_load_range(&data->vertex_buffer, sizeof(vertex_2d) * first, sizeof(vertex_2d) * (batch->dirty_vertex_last - first + 1), batch->vertices + first);
+    }
+    if (uploaded && batch->dirty_index_first != INVALID_ID) {
+        u32 first = batch->dirty_index_first;
+        uploaded = renderer_renderbuffer_load_range(&data->index_buffer, sizeof(u32) * first, sizeof(u32) * (batch->dirty_index_last - first + 1), batch->indices + first);
+    }
+    if (uploaded) {
+        ui_batch_mark_loaded(batch);
+    } else {
+        KERROR("Failed to upload UI batch. Skipping batched UI this frame.");
+        ui_batch_mark_unloaded(batch);
+        ui_batch_reset(batch);
+        data->retained = false;
+    }
+
     for (u32 p = 0; p < self->renderpass_count; ++p) {
         renderpass* pass = &self->passes[p];
         if (!renderer_renderpass_begin(pass, &pass->targets[render_target_index])) {
@@ -170,6 +331,11 @@ b8 render_view_ui_on_render(const struct render_view* self, const struct render_
             KERROR("Failed to use material shader. Render frame failed.");
             return false;
         }
+        // Everything but distance field text draws with the default variant.
+        if (!shader_system_variant_use(0)) {
+            KERROR("Failed to use the default UI shader variant. Render frame failed.");
+            return false;
+        }
 
         // Apply globals
         if (!material_system_apply_global(shader_id, frame_number, &packet->projection_matrix, &packet->view_matrix, 0, 0, 0, 0.0f)) {
@@ -179,6 +345,7 @@ b8 render_view_ui_on_render(const struct render_view* self, const struct render_
 
         // Draw geometries.
         u32 count = packet->geometry_count;
+        material* bound_material = 0;
         for (u32 i = 0; i < count; ++i) {
             material* m = 0;
             if (packet->geometries[i].geometry->material) {
@@ -191,13 +358,17 @@ b8 render_view_ui_on_render(const struct render_view* self, const struct render_
             // same material from being updated multiple times. It still needs to be bound
             // either way, so this check result gets passed to the backend which either
             // updates the internal shader bindings and binds them, or only binds them.
-            b8 needs_update = m->render_frame_number != frame_number;
-            if (!material_system_apply_instance(m, needs_update)) {
-                KWARN("Failed to apply material '%s'. Skipping draw.", m->name);
-                continue;
-            } else {
+            // Draws of the material just drawn, such as of UI sharing the texture atlas, bind nothing.
+            if (m != bound_material) {
+                b8 needs_update = m->render_frame_number != frame_number;
+                if (!material_system_apply_instance(m, needs_update)) {
+                    KWARN("Failed to apply material '%s'. Skipping draw.", m->name);
+                    bound_material = 0;
+                    continue;
+                }
                 // Sync the frame number.
                 m->render_frame_number = frame_number;
+                bound_material = m;
             }
 
             // Apply the locals
@@ -207,36 +378,85 @@ b8 render_view_ui_on_render(const struct render_view* self, const struct render_
             renderer_draw_geometry(&packet->geometries[i]);
         }
 
-        // Draw bitmap text
-        ui_packet_data* packet_data = (ui_packet_data*)packet->extended_data;  // array of texts
-        for (u32 i = 0; i < packet_data->text_count; ++i) {
-            ui_text* text = packet_data->texts[i];
-            shader_system_bind_instance(text->instance_id);
-
-            if (!shader_system_uniform_set_by_index(data->diffuse_map_location, &text->data->atlas)) {
-                KERROR("Failed to apply bitmap font diffuse map uniform.");
-                return false;
+        // Draw the batched quads and text, all from the one vertex buffer. Vertices are already in screen space.
+        if (batch->index_count && !renderer_renderbuffer_draw(&data->vertex_buffer, 0, batch->vertex_count, true)) {
+            KERROR("Failed to bind UI batch vertex buffer.");
+            return false;
+        }
+        mat4 identity = mat4_identity();
+        // Clipping is by scissor, changed only between draws clipped differently.
+        vec4 clip_rect = vec4_zero();
+        for (u32 i = 0; i < batch->draw_count; ++i) {
+            ui_batch_draw* draw = &batch->draws[i];
+            if (!rect_equal(draw->clip_rect, clip_rect)) {
+                clip_rect = draw->clip_rect;
+                if (clip_rect.z > 0.0f && clip_rect.w > 0.0f) {
+                    vec4 scissor = clip_scissor_get(self, clip_rect);
+                    if (scissor.z <= 0.0f || scissor.w <= 0.0f) {
+                        // Clipped to outside the view, so nothing of it is drawn.
+                        clip_rect = vec4_zero();
+                        renderer_scissor_reset();
+                        continue;
+                    }
+                    renderer_scissor_set(scissor);
+                } else {
+                    renderer_scissor_reset();
+                }
             }
-
-            // TODO: font colour.
-            static vec4 white_colour = (vec4){1.0f, 1.0f, 1.0f, 1.0f};  // white
-            if (!shader_system_uniform_set_by_index(data->diffuse_colour_location, &white_colour)) {
-                KERROR("Failed to apply bitmap font diffuse colour uniform.");
-                return false;
+            u8 variant = (!draw->m && draw->text->data->sdf && data->sdf_variant != INVALID_ID_U8) ? data->sdf_variant : 0;
+            if (!shader_system_variant_use(variant)) {
+                KWARN("Failed to use UI shader variant %u. Skipping draw.", variant);
+                continue;
             }
-            b8 needs_update = text->render_frame_number != frame_number;
-            shader_system_apply_instance(needs_update);
+            if (draw->m) {
+                material* m = draw->m;
+                if (m != bound_material) {
+                    b8 needs_update = m->render_frame_number != frame_number;
+                    if (!material_system_apply_instance(m, needs_update)) {
+                        KWARN("Failed to apply material '%s'. Skipping draw.", m->name);
+                        bound_material = 0;
+                        continue;
+                    }
+                    m->render_frame_number = frame_number;
+                    bound_material = m;
+                }
+                material_system_apply_local(m, &identity);
+            } else {
+                // Text, drawn with the shader instance of the first text of the draw, holding their shared atlas.
+                ui_text* text = draw->text;
+                shader_system_bind_instance(text->instance_id);
+                bound_material = 0;
+
+                if (!shader_system_uniform_set_by_index(data->diffuse_map_location, draw->atlas)) {
+                    KERROR("Failed to apply bitmap font diffuse map uniform.");
+                    return false;
+                }
+
+                // TODO: font colour.
+                static vec4 white_colour = (vec4){1.0f, 1.0f, 1.0f, 1.0f};  // white
+                if (!shader_system_uniform_set_by_index(data->diffuse_colour_location, &white_colour)) {
+                    KERROR("Failed to apply bitmap font diffuse colour uniform.");
+                    return false;
+                }
+                b8 needs_update = text->render_frame_number != frame_number;
+                shader_system_apply_instance(needs_update);
 
-            // Sync the frame number.
-            text->render_frame_number = frame_number;
+                // Sync the frame number.
+                text->render_frame_number = frame_number;
 
-            // Apply the locals
-            mat4 model = transform_get_world(&text->transform);
-            if(!shader_system_uniform_set_by_index(data->model_location, &model)) {
-                KERROR("Failed to apply model matrix for text");
+                // Apply the locals
+                if (!shader_system_uniform_set_by_index(data->model_location, &identity)) {
+                    KERROR("Failed to apply model matrix for text");
+                }
+                shader_system_apply_local();
             }
 
-            ui_text_draw(text);
+            if (!renderer_renderbuffer_draw(&data->index_buffer, sizeof(u32) * draw->first_index, draw->index_count, false)) {
+                KERROR("Failed to draw UI batch.");
+            }
+        }
+        if (clip_rect.z > 0.0f && clip_rect.w > 0.0f) {
+            renderer_scissor_reset();
         }
 
         if (!renderer_renderpass_end(pass)) {
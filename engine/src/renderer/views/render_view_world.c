@@ -1,12 +1,14 @@
 #include "render_view_world.h"
 
 #include "core/logger.h"
+#include "core/profiler.h"
 #include "core/kmemory.h"
 #include "core/event.h"
 #include "defines.h"
 #include "platform/platform.h"
 #include "math/kmath.h"
 #include "math/transform.h"
+#include "math/geometry_utils.h"
 #include "memory/linear_allocator.h"
 #include "containers/darray.h"
 #include "systems/resource_system.h"
@@ -14,38 +16,68 @@
 #include "systems/render_view_system.h"
 #include "systems/shader_system.h"
 #include "systems/camera_system.h"
+#include "systems/texture_system.h"
+#include "systems/job_system.h"
+#include "systems/light_system.h"
 #include "renderer/renderer_frontend.h"
+#include "renderer/render_queue.h"
+#include "renderer/light_clusters.h"
+
+#include <stddef.h>  // offsetof
+
+/**
+ * @brief The number of buffers the lights are uploaded to, one after another each frame. One more
+ * than the frames which may be in flight, so none is written while drawn from.
+ */
+#define WORLD_LIGHT_BUFFER_COUNT 3
 
 typedef struct render_view_world_internal_data {
     shader* s;
-    f32 fov;
-    f32 near_clip;
-    f32 far_clip;
-    mat4 projection_matrix;
+    // The camera holds the projection, shared with the other views of it and with culling.
     camera* world_camera;
     vec4 ambient_colour;
     u32 render_mode;
     u32 hovered_object_id;
-    u16 highlight_location;
+    // The runs of geometries sharing a material which are drawn, and the highlight of each geometry. darrays.
+    renderer_batch_run* runs;
+    u32* highlights;
+    // The depth-only shader which draws the opaque geometries before their materials, if the prepass is on.
+    shader* depth_shader;
+    u16 depth_projection_location;
+    u16 depth_view_location;
+    b8 depth_prepass;
+    // The runs of opaque geometries the prepass draws. darray.
+    renderer_batch_run* prepass_runs;
+    // The buffers the lights and their clusters are uploaded to, and the material shader's uniform of them.
+    renderbuffer light_buffers[WORLD_LIGHT_BUFFER_COUNT];
+    u16 lights_location;
 } render_view_world_internal_data;
 
-/** @brief A private structure used to sort geometry by distance from the camera. */
-typedef struct geometry_distance {
-    /** @brief The geometry render data. */
-    geometry_render_data g;
-    /** @brief The distance from the camera. */
-    f32 distance;
-} geometry_distance;
+/** @brief The most a level of detail may differ from the full geometry on screen, in pixels, for it to be drawn instead. */
+#define WORLD_LOD_MAX_SCREEN_ERROR 1.0f
 
-/**
- * @brief A private, recursive, in-place sort function for geometry_distance structures.
- *
- * @param arr The array of geometry_distance structures to be sorted.
- * @param low_index The low index to start the sort from (typically 0)
- * @param high_index The high index to end with (typically the array length - 1)
- * @param ascending True to sort in ascending order; otherwise descending.
- */
-static void quick_sort(geometry_distance arr[], i32 low_index, i32 high_index, b8 ascending);
+/** @brief The most geometries drawn in one batch. Longer runs of a material are split. */
+#define WORLD_BATCH_MAX_DRAWS 512
+
+/** @brief The fewest geometries for which the keys of a packet are worked out across job threads. */
+#define WORLD_PARALLEL_KEY_MIN_GEOMETRIES 2048
+/** @brief The number of geometries keyed by each job when keying in parallel. */
+#define WORLD_PARALLEL_KEY_BATCH_SIZE 256
+
+/** @brief The state shared by the jobs keying the geometries of a packet. */
+typedef struct world_key_job_data {
+    const struct render_view* self;
+    const render_view_world_internal_data* internal_data;
+    geometry_render_data* geometry_data;
+    render_queue_entry* entries;
+    u64* instance_keys;
+} world_key_job_data;
+
+/** @brief Gets the material a geometry is drawn with, which is the default material if it has none or it is still loading. */
+static material* world_material_get(const geometry_render_data* g_data);
+
+/** @brief Indicates if geometry drawn with the given material is see-through, so drawn after the rest, back to front. */
+static b8 world_material_translucent(const material* m);
 
 static b8 render_view_world_on_hover_event(u16 code, void* sender, void* listener_inst, event_context context) {
     render_view* self = (render_view*)listener_inst;
@@ -68,6 +100,8 @@ static b8 render_view_on_event(u16 code, void* sender, void* listener_inst, even
 
     switch (code) {
         case EVENT_CODE_SET_RENDER_MODE: {
+            // Read while rendering, so not changed under a frame being drawn.
+            renderer_frame_sync();
             i32 mode = context.data.i32[0];
             switch (mode) {
                 default:
@@ -86,6 +120,16 @@ static b8 render_view_on_event(u16 code, void* sender, void* listener_inst, even
             }
             return true;
         }
+        case EVENT_CODE_SET_DEPTH_PREPASS: {
+            if (!data->depth_shader) {
+                KWARN("The depth prepass is unavailable, as its shader failed to load.");
+                return true;
+            }
+            renderer_frame_sync();
+            data->depth_prepass = context.data.u8[0] != 0;
+            KDEBUG("Depth prepass %s.", data->depth_prepass ? "enabled" : "disabled");
+            return true;
+        }
         case EVENT_CODE_DEFAULT_RENDERTARGET_REFRESH_REQUIRED:
             render_view_system_regenerate_render_targets(self);
             // This needs to be consumed by other views, so consider it _not_ handled.
@@ -104,8 +148,10 @@ b8 render_view_world_on_create(struct render_view* self) {
         // TODO: move to material system and get a reference here instead.
         // Builtin material shader.
         const char* shader_name = "Shader.Builtin.Material";
+        // Where the renderer supports it, the same shader samples its textures from the bindless texture table.
+        const char* config_name = renderer_bindless_supported() ? "Shader.Builtin.MaterialBindless" : shader_name;
         resource config_resource;
-        if (!resource_system_load(shader_name, RESOURCE_TYPE_SHADER, 0, &config_resource)) {
+        if (!resource_system_load(config_name, RESOURCE_TYPE_SHADER, 0, &config_resource)) {
             KERROR("Failed to load builtin material shader.");
             return false;
         }
@@ -119,14 +165,34 @@ b8 render_view_world_on_create(struct render_view* self) {
 
         // Get either the custom shader override or the defined default.
         data->s = shader_system_get(self->custom_shader_name ? self->custom_shader_name : shader_name);
-        // TODO: Set from configuration.
-        data->near_clip = 0.1f;
-        data->far_clip = 1000.0f;
-        data->fov = deg_to_rad(45.0f);
 
-        // Default
-        data->projection_matrix = mat4_perspective(data->fov, 1280 / 720.0f, data->near_clip, data->far_clip);
+        // The lights are read from storage buffers, whole, so each holds all that may be uploaded.
+        data->lights_location = shader_system_uniform_index(data->s, "lights");
+        for (u32 i = 0; i < WORLD_LIGHT_BUFFER_COUNT; ++i) {
+            if (!renderer_renderbuffer_create(RENDERBUFFER_TYPE_STORAGE, sizeof(light_cluster_data), false, &data->light_buffers[i]) ||
+                !renderer_renderbuffer_bind(&data->light_buffers[i], 0)) {
+                KERROR("Failed to create world light buffer.");
+                return false;
+            }
+        }
+
+        // The depth prepass is optional, so the view goes on without it if its shader fails to load.
+        const char* depth_shader_name = "Shader.Builtin.DepthPrepass";
+        if (resource_system_load(depth_shader_name, RESOURCE_TYPE_SHADER, 0, &config_resource)) {
+            if (shader_system_create(&self->passes[0], (shader_config*)config_resource.data)) {
+                data->depth_shader = shader_system_get(depth_shader_name);
+                data->depth_projection_location = shader_system_uniform_index(data->depth_shader, "projection");
+                data->depth_view_location = shader_system_uniform_index(data->depth_shader, "view");
+            }
+            resource_system_unload(&config_resource);
+        }
+        if (!data->depth_shader) {
+            KWARN("Failed to load the depth prepass shader. The world view will draw without a depth prepass.");
+        }
+        data->depth_prepass = false;
+        data->prepass_runs = darray_create(renderer_batch_run);
 
+        // TODO: Set the perspective of the camera from configuration.
         data->world_camera = camera_system_get_default();
 
         // TODO: Obtain from scene
@@ -134,7 +200,8 @@ b8 render_view_world_on_create(struct render_view* self) {
 
         // Initialise hover tracking.
         data->hovered_object_id = INVALID_ID;
-        data->highlight_location = shader_system_uniform_index(data->s, "highlight");
+        data->runs = darray_create(renderer_batch_run);
+        data->highlights = darray_create(u32);
 
         // Listen for mode changes.
         if (!event_register(EVENT_CODE_SET_RENDER_MODE, self, render_view_on_event)) {
@@ -147,6 +214,11 @@ b8 render_view_world_on_create(struct render_view* self) {
             return false;
         }
 
+        if (!event_register(EVENT_CODE_SET_DEPTH_PREPASS, self, render_view_on_event)) {
+            KERROR("Unable to listen for depth prepass set event, creation failed.");
+            return false;
+        }
+
         if (!event_register(EVENT_CODE_OBJECT_HOVER_ID_CHANGED, self, render_view_world_on_hover_event)) {
             KERROR("Unable to listen for object hover id changed event, creation failed.");
             return false;
@@ -162,8 +234,16 @@ void render_view_world_on_destroy(struct render_view* self) {
     if (self && self->internal_data) {
         event_unregister(EVENT_CODE_SET_RENDER_MODE, self, render_view_on_event);
         event_unregister(EVENT_CODE_DEFAULT_RENDERTARGET_REFRESH_REQUIRED, self, render_view_on_event);
+        event_unregister(EVENT_CODE_SET_DEPTH_PREPASS, self, render_view_on_event);
         event_unregister(EVENT_CODE_OBJECT_HOVER_ID_CHANGED, self, render_view_world_on_hover_event);
 
+        render_view_world_internal_data* data = self->internal_data;
+        for (u32 i = 0; i < WORLD_LIGHT_BUFFER_COUNT; ++i) {
+            renderer_renderbuffer_destroy(&data->light_buffers[i]);
+        }
+        darray_destroy(data->runs);
+        darray_destroy(data->highlights);
+        darray_destroy(data->prepass_runs);
         kfree(self->internal_data, sizeof(render_view_world_internal_data), MEMORY_TAG_RENDERER);
         self->internal_data = 0;
     }
@@ -176,8 +256,7 @@ void render_view_world_on_resize(struct render_view* self, u32 width, u32 height
 
         self->width = width;
         self->height = height;
-        f32 aspect = (f32)self->width / self->height;
-        data->projection_matrix = mat4_perspective(data->fov, aspect, data->near_clip, data->far_clip);
+        camera_aspect_set(data->world_camera, (f32)self->width / self->height);
 
         for (u32 i = 0; i < self->renderpass_count; ++i) {
             self->passes[i].render_area.x = 0;
@@ -188,7 +267,83 @@ void render_view_world_on_resize(struct render_view* self, u32 width, u32 height
     }
 }
 
+/**
+ * @brief Gets the size the sphere around the given geometry covers on screen, across, in pixels.
+ * Effectively unbounded when the camera is at or inside it.
+ */
+static f32 world_screen_size(const struct render_view* self, const render_view_world_internal_data* data, const geometry_render_data* g_data) {
+    bounding_sphere sphere = bounding_sphere_transform(bounding_sphere_from_extents(g_data->geometry->extents), g_data->model);
+    f32 distance = vec3_distance(sphere.center, data->world_camera->position) - sphere.radius;
+    if (distance <= data->world_camera->near_clip) {
+        return K_INFINITY;
+    }
+    // The number of pixels a world unit covers at that distance, at the resolution the view is drawn at.
+    f32 height = self->height * (self->resolution_scaled ? renderer_resolution_scale_get() : 1.0f);
+    f32 pixels_per_unit = height * 0.5f / (distance * ktan(data->world_camera->fov * 0.5f));
+    return 2.0f * sphere.radius * pixels_per_unit;
+}
+
+/**
+ * @brief Picks the coarsest level of detail of the given geometry whose error covers no more than
+ * WORLD_LOD_MAX_SCREEN_ERROR pixels, given the size the geometry covers on screen.
+ */
+static u8 world_lod_select(const geometry* g, f32 screen_size) {
+    if (g->lod_count <= 1) {
+        return 0;
+    }
+    for (u8 l = g->lod_count - 1; l > 0; --l) {
+        if (g->lods[l].error * screen_size * 0.5f <= WORLD_LOD_MAX_SCREEN_ERROR) {
+            return l;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Picks the level of detail of each geometry in the given range, reports the sizes its
+ * textures are drawn at, and works out its sort and instance keys, each written at the index of
+ * the geometry. Geometries with nothing to draw are given an entry index of INVALID_ID. Safe to
+ * run for several ranges at once.
+ */
+static void world_keys_compute(u32 start, u32 end, void* user_data) {
+    world_key_job_data* job_data = user_data;
+    const struct render_view* self = job_data->self;
+    const render_view_world_internal_data* internal_data = job_data->internal_data;
+    f32 far_clip_squared = internal_data->world_camera->far_clip * internal_data->world_camera->far_clip;
+    for (u32 i = start; i < end; ++i) {
+        geometry_render_data* g_data = &job_data->geometry_data[i];
+        if (!g_data->geometry) {
+            job_data->entries[i].index = INVALID_ID;
+            continue;
+        }
+        f32 screen_size = world_screen_size(self, internal_data, g_data);
+        g_data->lod = world_lod_select(g_data->geometry, screen_size);
+
+        // Each map is taken to span the geometry once, so needs about as many texels as the pixels it covers.
+        material* m = world_material_get(g_data);
+        texture_system_report_usage(m->diffuse_map.texture, screen_size);
+        texture_system_report_usage(m->specular_map.texture, screen_size);
+        texture_system_report_usage(m->normal_map.texture, screen_size);
+
+        // Get the center, extract the global position from the model matrix and add it to the center,
+        // then calculate the distance between it and the camera. Squared, as only the order matters.
+        // NOTE: This isn't perfect for translucent meshes that intersect, but is enough for our purposes now.
+        vec3 center = vec3_transform(g_data->geometry->center, g_data->model);
+        f32 depth = vec3_distance_squared(center, internal_data->world_camera->position) / far_clip_squared;
+
+        // Meshes _with_ transparency are drawn after the rest, back to front. Those without may be
+        // drawn in any order, so are grouped by material to be drawn in batches, front to back.
+        b8 translucent = world_material_translucent(m);
+        job_data->entries[i].key = render_queue_key(translucent ? 1 : 0, (u16)internal_data->s->id, m->id, depth, translucent);
+        job_data->entries[i].index = i;
+
+        // Opaque draws of the same geometry at the same level of detail may be drawn as instances of one.
+        job_data->instance_keys[i] = translucent ? RENDER_QUEUE_NO_INSTANCE : (((u64)g_data->geometry->id << 8) | g_data->lod);
+    }
+}
+
 b8 render_view_world_on_build_packet(const struct render_view* self, struct linear_allocator* frame_allocator, void* data, struct render_view_packet* out_packet) {
+    KPROFILE_ZONE("render_view_world_on_build_packet");
     if (!self || !data || !out_packet) {
         KWARN("render_view_world_on_build_packet requires valid pointer to view, packet, and data.");
         return false;
@@ -197,84 +352,138 @@ b8 render_view_world_on_build_packet(const struct render_view* self, struct line
     geometry_render_data* geometry_data = (geometry_render_data*)data;
     render_view_world_internal_data* internal_data = (render_view_world_internal_data*)self->internal_data;
 
-    out_packet->geometries = darray_create(geometry_render_data);
+    // Both lists are taken from the frame allocator, and reserved up front so they never need to grow.
+    u32 geometry_data_count = darray_length(geometry_data);
+    out_packet->geometries = darray_reserve_with_allocator(geometry_render_data, geometry_data_count, frame_allocator);
     out_packet->view = self;
 
     // Set matrices, etc.
-    out_packet->projection_matrix = internal_data->projection_matrix;
+    out_packet->projection_matrix = camera_projection_get(internal_data->world_camera);
     out_packet->view_matrix = camera_view_get(internal_data->world_camera);
     out_packet->view_position = camera_position_get(internal_data->world_camera);
     out_packet->ambient_colour = internal_data->ambient_colour;
 
-    // Obtain all geometries from the current scene.
-
-    geometry_distance* geometry_distances = darray_create(geometry_distance);
+    // The lights are assigned to the clusters of the view here, off the render thread, laid out to
+    // be uploaded as they are.
+    light_clusters* clusters = linear_allocator_allocate(frame_allocator, sizeof(light_clusters));
+    if (clusters) {
+        light_clusters_view lights_view;
+        lights_view.view = out_packet->view_matrix;
+        lights_view.projection = out_packet->projection_matrix;
+        lights_view.near_clip = internal_data->world_camera->near_clip;
+        lights_view.far_clip = internal_data->world_camera->far_clip;
+        directional_light directional = light_system_directional_get();
+        const point_light* point_lights = 0;
+        u32 point_light_count = light_system_point_lights_get(&point_lights);
+        light_clusters_build(&lights_view, &directional, point_light_count, point_lights, clusters);
+        if (clusters->dropped_light_count || clusters->dropped_index_count) {
+            KWARN("The world view left out %u point lights, and %u lights of clusters, which did not fit.", clusters->dropped_light_count, clusters->dropped_index_count);
+        }
+    }
+    out_packet->extended_data = clusters;
+
+    // Obtain all geometries from the current scene, keyed to be drawn with the fewest state changes.
+    render_queue_entry* entries = darray_reserve_with_allocator(render_queue_entry, geometry_data_count, frame_allocator);
+    u64* instance_keys = darray_reserve_with_allocator(u64, geometry_data_count, frame_allocator);
+    world_key_job_data job_data = {self, internal_data, geometry_data, entries, instance_keys};
+    if (geometry_data_count >= WORLD_PARALLEL_KEY_MIN_GEOMETRIES) {
+        job_system_parallel_for(geometry_data_count, WORLD_PARALLEL_KEY_BATCH_SIZE, world_keys_compute, &job_data);
+    } else {
+        world_keys_compute(0, geometry_data_count, &job_data);
+    }
 
-    u32 geometry_data_count = darray_length(geometry_data);
+    // Geometries with nothing to draw are dropped, keeping the order of the rest.
+    u32 entry_count = 0;
     for (u32 i = 0; i < geometry_data_count; ++i) {
-        geometry_render_data* g_data = &geometry_data[i];
-        if(!g_data->geometry) {
-            continue;
-        }
-        
-        // TODO: Add something to material to check for transparency.
-        if ((g_data->geometry->material->diffuse_map.texture->flags & TEXTURE_FLAG_HAS_TRANSPARENCY) == 0) {
-            // Only add meshes with _no_ transparency.
-            darray_push(out_packet->geometries, geometry_data[i]);
-            out_packet->geometry_count++;
-        } else {
-            // For meshes _with_ transparency, add them to a separate list to be sorted by distance later.
-            // Get the center, extract the global position from the model matrix and add it to the center,
-            // then calculate the distance between it and the camera, and finally save it to a list to be sorted.
-            // NOTE: This isn't perfect for translucent meshes that intersect, but is enough for our purposes now.
-            vec3 center = vec3_transform(g_data->geometry->center, g_data->model);
-            f32 distance = vec3_distance(center, internal_data->world_camera->position);
-
-            geometry_distance gdist;
-            gdist.distance = kabs(distance);
-            gdist.g = geometry_data[i];
-
-            darray_push(geometry_distances, gdist);
+        if (entries[i].index != INVALID_ID) {
+            entries[entry_count++] = entries[i];
         }
     }
 
-    // Sort the distances
-    u32 geometry_count = darray_length(geometry_distances);
-    quick_sort(geometry_distances, 0, geometry_count - 1, false);
+    render_queue_entry* scratch = darray_reserve_with_allocator(render_queue_entry, entry_count, frame_allocator);
+    render_queue_sort(entry_count, entries, scratch);
+    render_queue_entry* groups = darray_reserve_with_allocator(render_queue_entry, entry_count, frame_allocator);
+    render_queue_group_instances(entry_count, entries, instance_keys, scratch, groups);
 
-    // Add them to the packet geometry.
-    for (u32 i = 0; i < geometry_count; ++i) {
-        darray_push(out_packet->geometries, geometry_distances[i].g);
+    // Add them to the packet geometry in order.
+    for (u32 i = 0; i < entry_count; ++i) {
+        darray_push(out_packet->geometries, geometry_data[entries[i].index]);
         out_packet->geometry_count++;
     }
 
     // Clean up.
-    darray_destroy(geometry_distances);
+    darray_destroy(groups);
+    darray_destroy(scratch);
+    darray_destroy(instance_keys);
+    darray_destroy(entries);
 
     return true;
 }
 
 void render_view_world_on_destroy_packet(const struct render_view* self, struct render_view_packet* packet) {
+    // NOTE: Only frees anything if the frame allocator ran out and the heap was used instead.
     darray_destroy(packet->geometries);
     kzero_memory(packet, sizeof(render_view_packet));
 }
 
+// Gets the material a geometry is drawn with.
+static material* world_material_get(const geometry_render_data* g_data) {
+    material* m = g_data->geometry->material;
+    return material_system_is_loaded(m) ? m : material_system_get_default();
+}
+
+static b8 world_material_translucent(const material* m) {
+    // TODO: Add something to material to check for transparency.
+    return (m->diffuse_map.texture->flags & TEXTURE_FLAG_HAS_TRANSPARENCY) != 0;
+}
+
+// Uploads the lights of the packet to the buffer of the frame and sets it on the material shader,
+// which must be in use. Only the lights and the parts of the lists which are used are uploaded.
+static b8 world_lights_apply(render_view_world_internal_data* data, const light_clusters* clusters, u64 frame_number) {
+    if (!clusters || data->lights_location == INVALID_ID_U16) {
+        return true;
+    }
+    renderbuffer* buffer = &data->light_buffers[frame_number % WORLD_LIGHT_BUFFER_COUNT];
+    if (!renderer_renderbuffer_load_range(buffer, 0, light_clusters_lights_size(&clusters->data), &clusters->data) ||
+        !renderer_renderbuffer_load_range(buffer, offsetof(light_cluster_data, clusters), light_clusters_lists_size(clusters), clusters->data.clusters)) {
+        KERROR("Failed to upload the lights of the world view.");
+        return false;
+    }
+    return shader_system_uniform_set_by_index(data->lights_location, buffer);
+}
+
 b8 render_view_world_on_render(const struct render_view* self, const struct render_view_packet* packet, u64 frame_number, u64 render_target_index) {
+    KPROFILE_ZONE("render_view_world_on_render");
     render_view_world_internal_data* data = self->internal_data;
     u32 shader_id = data->s->id;
 
+    // The batched draws are culled on the GPU against this view, and against the depth it was drawn to last frame.
+    renderer_draw_batch_cull_set(packet->projection_matrix, packet->view_matrix);
+
+    // The highlight of each geometry goes with its draw.
+    u32 count = packet->geometry_count;
+    darray_length_set(data->highlights, 0);
+    for (u32 i = 0; i < count; ++i) {
+        u32 highlight = (data->hovered_object_id != INVALID_ID && packet->geometries[i].unique_id == data->hovered_object_id) ? 1 : 0;
+        darray_push(data->highlights, highlight);
+    }
+
     for (u32 p = 0; p < self->renderpass_count; ++p) {
         renderpass* pass = &self->passes[p];
-        if (!renderer_renderpass_begin(pass, &pass->targets[render_target_index])) {
-            KERROR("render_view_world_on_render pass index %u failed to start.", p);
-            return false;
-        }
 
+        // Everything the draws need is bound and applied before the pass begins, so the draws
+        // themselves may be recorded on several threads.
         if (!shader_system_use_by_id(shader_id)) {
             KERROR("Failed to use material shader. Render frame failed.");
             return false;
         }
 
+        // The lights go with the globals, so are set first, once a frame.
+        if (p == 0 && !world_lights_apply(data, packet->extended_data, frame_number)) {
+            KERROR("Failed to apply the lights of the material shader. Render frame failed.");
+            return false;
+        }
+
         // Apply globals
         // TODO: Find a generic way to request data such as ambient colour (which should be from a scene),
         // and mode (from the renderer)
@@ -284,83 +493,89 @@ b8 render_view_world_on_render(const struct render_view* self, const struct rend
             return false;
         }
 
-        // Draw geometries.
-        u32 count = packet->geometry_count;
-        for (u32 i = 0; i < count; ++i) {
-            material* m = 0;
-            if (packet->geometries[i].geometry->material) {
-                m = packet->geometries[i].geometry->material;
-            } else {
-                m = material_system_get_default();
+        // Gather the runs of geometries sharing a material. Opaque geometries are sorted before the rest,
+        // so are those before the first translucent one.
+        darray_length_set(data->runs, 0);
+        u32 opaque_count = count;
+        u32 i = 0;
+        while (i < count) {
+            material* m = world_material_get(&packet->geometries[i]);
+            if (opaque_count == count && world_material_translucent(m)) {
+                opaque_count = i;
+            }
+            u32 run_count = 1;
+            while (i + run_count < count && run_count < WORLD_BATCH_MAX_DRAWS && world_material_get(&packet->geometries[i + run_count]) == m) {
+                run_count++;
             }
 
-            // Update the material if it hasn't already been this frame. This keeps the
-            // same material from being updated multiple times. It still needs to be bound
-            // either way, so this check result gets passed to the backend which either
-            // updates the internal shader bindings and binds them, or only binds them.
-            b8 needs_update = m->render_frame_number != frame_number;
-            if (!material_system_apply_instance(m, needs_update)) {
-                KWARN("Failed to apply material '%s'. Skipping draw.", m->name);
-                continue;
-            } else {
+            // Each material is applied once a frame, however many runs or passes use it, as the
+            // draws bind the instance of each run themselves.
+            if (m->render_frame_number != frame_number) {
+                if (!material_system_apply_instance(m, true)) {
+                    KWARN("Failed to apply material '%s'. Skipping draw.", m->name);
+                    i += run_count;
+                    continue;
+                }
                 // Sync the frame number.
                 m->render_frame_number = frame_number;
             }
 
-            // Apply the locals — model matrix + highlight flag
-            u32 highlight = (data->hovered_object_id != INVALID_ID &&
-                             packet->geometries[i].unique_id == data->hovered_object_id) ? 1 : 0;
-            shader_system_uniform_set_by_index(data->highlight_location, &highlight);
-            material_system_apply_local(m, &packet->geometries[i].model);
+            renderer_batch_run run;
+            run.instance_id = m->internal_id;
+            run.count = run_count;
+            run.geometries = &packet->geometries[i];
+            run.highlights = &data->highlights[i];
+            darray_push(data->runs, run);
+            i += run_count;
+        }
 
-            // Draw it.
-            renderer_draw_geometry(&packet->geometries[i]);
+        // The prepass draws the depth of the opaque geometries first, so each pixel is shaded only by the
+        // nearest. Its shader draws no material, so takes runs as long as batches allow. Its globals are
+        // applied here, as nothing may be applied once a pass begun for parallel recording is.
+        b8 prepass = data->depth_prepass && data->depth_shader && opaque_count > 0;
+        if (prepass) {
+            darray_length_set(data->prepass_runs, 0);
+            for (u32 first = 0; first < opaque_count; first += WORLD_BATCH_MAX_DRAWS) {
+                renderer_batch_run run = {0};
+                run.count = KMIN(opaque_count - first, WORLD_BATCH_MAX_DRAWS);
+                run.geometries = &packet->geometries[first];
+                darray_push(data->prepass_runs, run);
+            }
+            if (!shader_system_use_by_id(data->depth_shader->id) ||
+                !shader_system_uniform_set_by_index(data->depth_projection_location, &packet->projection_matrix) ||
+                !shader_system_uniform_set_by_index(data->depth_view_location, &packet->view_matrix) ||
+                !shader_system_apply_global()) {
+                KERROR("Failed to apply the globals of the depth prepass shader. Drawing without the prepass.");
+                prepass = false;
+            }
+            // The materials are drawn with their own shader again.
+            if (!shader_system_use_by_id(shader_id)) {
+                KERROR("Failed to use material shader. Render frame failed.");
+                return false;
+            }
         }
 
-        if (!renderer_renderpass_end(pass)) {
-            KERROR("render_view_world_on_render pass index %u failed to end.", p);
+        b8 parallel = renderer_parallel_recording_supported();
+        b8 begun = parallel ? renderer_renderpass_begin_parallel(pass, &pass->targets[render_target_index]) : renderer_renderpass_begin(pass, &pass->targets[render_target_index]);
+        if (!begun) {
+            KERROR("render_view_world_on_render pass index %u failed to start.", p);
             return false;
         }
-    }
-
-    return true;
-}
-
-// Quicksort for geometry_distance
 
-static void swap(geometry_distance* a, geometry_distance* b) {
-    geometry_distance temp = *a;
-    *a = *b;
-    *b = temp;
-}
+        if (prepass) {
+            shader_system_use_by_id(data->depth_shader->id);
+            renderer_draw_geometry_batches((u32)darray_length(data->prepass_runs), data->prepass_runs);
+            shader_system_use_by_id(shader_id);
+        }
 
-static i32 partition(geometry_distance arr[], i32 low_index, i32 high_index, b8 ascending) {
-    geometry_distance pivot = arr[high_index];
-    i32 i = (low_index - 1);
+        // Draw them, each run with its material.
+        renderer_draw_geometry_batches((u32)darray_length(data->runs), data->runs);
 
-    for (i32 j = low_index; j <= high_index - 1; ++j) {
-        if (ascending) {
-            if (arr[j].distance < pivot.distance) {
-                ++i;
-                swap(&arr[i], &arr[j]);
-            }
-        } else {
-            if (arr[j].distance > pivot.distance) {
-                ++i;
-                swap(&arr[i], &arr[j]);
-            }
+        if (!renderer_renderpass_end(pass)) {
+            KERROR("render_view_world_on_render pass index %u failed to end.", p);
+            return false;
         }
     }
-    swap(&arr[i + 1], &arr[high_index]);
-    return i + 1;
-}
-
-static void quick_sort(geometry_distance arr[], i32 low_index, i32 high_index, b8 ascending) {
-    if (low_index < high_index) {
-        i32 partition_index = partition(arr, low_index, high_index, ascending);
 
-        // Independently sort elements before and after the partition index.
-        quick_sort(arr, low_index, partition_index - 1, ascending);
-        quick_sort(arr, partition_index + 1, high_index, ascending);
-    }
+    return true;
 }
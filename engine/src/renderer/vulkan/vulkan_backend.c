@@ -8,7 +8,11 @@
 #include "vulkan_utils.h"
 #include "vulkan_image.h"
 #include "vulkan_pipeline.h"
+#include "vulkan_memory.h"
+#include "vulkan_cull.h"
+#include "vulkan_skinning.h"
 
+#include "core/counters.h"
 #include "core/logger.h"
 #include "core/kstring.h"
 #include "core/kmemory.h"
@@ -19,12 +23,17 @@
 #include "math/math_types.h"
 
 #include "renderer/renderer_frontend.h"
+#include "renderer/resolution_scale.h"
 
 #include "platform/platform.h"
+#include "platform/filesystem.h"
+
+#include "resources/texture_container.h"
 
 #include "systems/shader_system.h"
 #include "systems/material_system.h"
 #include "systems/texture_system.h"
+#include "systems/job_system.h"
 #include "systems/resource_system.h"
 
 // NOTE: If wanting to trace allocations, uncomment this.
@@ -37,6 +46,25 @@
 #define KVULKAN_USE_CUSTOM_ALLOCATOR 1
 #endif
 
+// NOTE: Driver host allocations are served by a dedicated allocator, pooled and kept apart from the
+// engine's heap. Set to 0 to have the custom allocator take them from the engine's heap instead.
+#ifndef KVULKAN_USE_HOST_ALLOCATOR
+#define KVULKAN_USE_HOST_ALLOCATOR 1
+#endif
+
+// NOTE: Geometry compaction moves what is left in sparsely used blocks of the geometry heap to the others in
+// the background, so they can be released. Set to 0 to keep every block once it has been chained.
+#ifndef KVULKAN_GEOMETRY_COMPACTION
+#define KVULKAN_GEOMETRY_COMPACTION 1
+#endif
+
+// The size of each arena of the dedicated host allocator, which allocations lasting only for the
+// Vulkan command which makes them are taken from.
+#define VULKAN_HOST_ALLOCATOR_ARENA_SIZE KIBIBYTES(256)
+
+// Where compiled pipelines are kept between runs, relative to the working directory.
+#define VULKAN_PIPELINE_CACHE_PATH "vulkan_pipeline_cache.bin"
+
 // static Vulkan context
 static vulkan_context context;
 
@@ -51,7 +79,58 @@ i32 find_memory_index(u32 type_filter, u32 property_flags);
 void create_command_buffers(renderer_backend* backend);
 b8 recreate_swapchain(renderer_backend* backend);
 b8 create_module(vulkan_shader* shader, vulkan_shader_stage_config config, vulkan_shader_stage* shader_stage);
-b8 vulkan_buffer_copy_range_internal(VkBuffer source, u64 source_offset, VkBuffer dest, u64 dest_offset, u64 size);
+b8 vulkan_buffer_copy_range_internal(VkBuffer source, u64 source_offset, VkBuffer dest, u64 dest_offset, u64 size, b8 wait);
+static void timestamp_queries_create();
+static void timestamp_queries_destroy();
+static void timestamp_queries_resolve(vulkan_timestamp_frame* frame);
+static void pipeline_cache_create();
+static void pipeline_cache_destroy();
+static void geometry_uploads_update(b8 wait);
+static u32 geometry_block_create(u64 min_vertex_size, u64 min_index_size, u64 min_index_16_size);
+static void geometry_block_destroy(u32 index);
+#if KVULKAN_GEOMETRY_COMPACTION == 1
+static void geometry_compaction_update();
+#endif
+static b8 upload_batches_create();
+static vulkan_upload_batch* upload_batch_begin();
+static void upload_batches_destroy();
+static void upload_batches_submit();
+static b8 draw_batch_create();
+static void draw_batch_destroy();
+static b8 frame_uniform_arena_create();
+static void frame_uniform_arena_destroy();
+static b8 transient_descriptors_create();
+static b8 vertex_sets_create();
+static void vertex_sets_destroy();
+static void transient_descriptors_destroy();
+static void transient_descriptors_reset();
+static b8 recorders_create();
+static void recorders_destroy();
+static b8 pixel_readback_create();
+static void pixel_readback_destroy();
+static vulkan_pipeline* shader_variant_pipeline(shader* s);
+static void shader_storage_set_bind(VkCommandBuffer command_buffer, vulkan_shader* internal);
+static void shader_bindless_set_bind(VkCommandBuffer command_buffer, vulkan_shader* internal);
+static void instance_set_bind(VkCommandBuffer command_buffer, vulkan_shader* internal, vulkan_shader_instance_state* instance_state);
+static b8 instance_set_needs_bind(const vulkan_shader* internal, u32 bound_instance_id, u32 instance_id);
+static u32 instance_material_index(const vulkan_shader* internal, u32 instance_id);
+static void uniform_shadow_write(vulkan_shader* internal, u64 offset, const void* value, u64 size);
+static void uniform_shadow_flush(vulkan_shader* internal);
+static void bindless_textures_create();
+static void bindless_textures_destroy();
+static void sampler_cache_destroy();
+static b8 staging_ring_create();
+static void staging_ring_destroy();
+static void staging_ring_region_end(vulkan_staging_region* region);
+static void staging_ring_flush();
+static void deferred_delete(vulkan_deferred_deletion* deletion);
+static void deferred_deletions_update(b8 all);
+static VkSemaphore timeline_semaphore_create();
+static VkResult timeline_wait(VkSemaphore timeline, u64 value, u64 timeout);
+static void frames_completed_poll();
+static VkResult frame_wait(u32 frame);
+static VkResult frame_serial_wait(u64 serial);
+static void buffer_internal_destroy(vulkan_buffer* internal_buffer);
 
 #if KVULKAN_USE_CUSTOM_ALLOCATOR == 1
 /**
@@ -70,7 +149,12 @@ void* vulkan_alloc_allocation(void* user_data, size_t size, size_t alignment, Vk
         return 0;
     }
 
+#if KVULKAN_USE_HOST_ALLOCATOR == 1
+    // Command scope allocations last only as long as the call which makes them.
+    void* result = host_allocator_allocate(user_data, size, (u16)alignment, allocation_scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+#else
     void* result = kallocate_aligned(size, (u16)alignment, MEMORY_TAG_VULKAN);
+#endif
 #ifdef KVULKAN_ALLOCATOR_TRACE
     KTRACE("Allocated block %p. Size=%llu, Alignment=%llu", result, size, alignment);
 #endif
@@ -95,6 +179,9 @@ void vulkan_alloc_free(void* user_data, void* memory) {
 #ifdef KVULKAN_ALLOCATOR_TRACE
     KTRACE("Attempting to free block %p...", memory);
 #endif
+#if KVULKAN_USE_HOST_ALLOCATOR == 1
+    host_allocator_free(user_data, memory);
+#else
     u64 size;
     u16 alignment;
     b8 result = kmemory_get_size_alignment(memory, &size, &alignment);
@@ -106,6 +193,7 @@ void vulkan_alloc_free(void* user_data, void* memory) {
     } else {
         KERROR("vulkan_alloc_free failed to get alignment lookup for block %p.", memory);
     }
+#endif
 }
 
 /**
@@ -124,6 +212,10 @@ void* vulkan_alloc_reallocation(void* user_data, void* original, size_t size, si
         return vulkan_alloc_allocation(user_data, size, alignment, allocation_scope);
     }
 
+#if KVULKAN_USE_HOST_ALLOCATOR == 1
+    // The size and alignment are kept with the block, so no lookup is needed.
+    return host_allocator_reallocate(user_data, original, size, (u16)alignment, allocation_scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+#else
     if (size == 0) {
         return 0;
     }
@@ -166,6 +258,7 @@ void* vulkan_alloc_reallocation(void* user_data, void* original, size_t size, si
     }
 
     return result;
+#endif
 }
 
 /**
@@ -216,7 +309,14 @@ b8 create_vulkan_allocator(VkAllocationCallbacks* callbacks) {
         callbacks->pfnFree = vulkan_alloc_free;
         callbacks->pfnInternalAllocation = vulkan_alloc_internal_alloc;
         callbacks->pfnInternalFree = vulkan_alloc_internal_free;
+#if KVULKAN_USE_HOST_ALLOCATOR == 1
+        if (!host_allocator_create(VULKAN_HOST_ALLOCATOR_ARENA_SIZE, 2, MEMORY_TAG_VULKAN, &context.host_allocator)) {
+            return false;
+        }
+        callbacks->pUserData = &context.host_allocator;
+#else
         callbacks->pUserData = &context;
+#endif
         return true;
     }
 
@@ -227,6 +327,7 @@ b8 create_vulkan_allocator(VkAllocationCallbacks* callbacks) {
 b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const renderer_backend_config* config, u8* out_window_render_target_count) {
     // Function pointers
     context.find_memory_index = find_memory_index;
+    context.deferred_delete = deferred_delete;
 
     // NOTE: Custom allocator.
 #if KVULKAN_USE_CUSTOM_ALLOCATOR == 1
@@ -246,6 +347,21 @@ b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const renderer_
     // overridden, but are needed for swapchain creation.
     context.framebuffer_width = 800;
     context.framebuffer_height = 600;
+    context.swapchain_config = config->swapchain;
+
+    context.descriptor_writes_counter = counter_register("vulkan.descriptor_writes", COUNTER_TYPE_COUNTER);
+    context.redundant_binds_counter = counter_register("vulkan.redundant_binds", COUNTER_TYPE_COUNTER);
+    context.staged_uploads_counter = counter_register("vulkan.staged_uploads", COUNTER_TYPE_COUNTER);
+    context.staged_bytes_counter = counter_register("vulkan.staged_bytes", COUNTER_TYPE_COUNTER);
+    context.geometry_blocks_counter = counter_register("vulkan.geometry_blocks", COUNTER_TYPE_GAUGE);
+    context.geometry_compacted_bytes_counter = counter_register("vulkan.geometry_compacted_bytes", COUNTER_TYPE_COUNTER);
+    context.textures_resident_counter = counter_register("vulkan.textures_resident", COUNTER_TYPE_GAUGE);
+    context.draw_batch.batched_draws_counter = counter_register("vulkan.batched_draws", COUNTER_TYPE_COUNTER);
+    context.draw_batch.instanced_draws_counter = counter_register("vulkan.instanced_draws", COUNTER_TYPE_COUNTER);
+    context.draw_batch.meshlet_draws_counter = counter_register("vulkan.meshlet_draws", COUNTER_TYPE_COUNTER);
+    context.frame_uniforms.bytes_counter = counter_register("vulkan.frame_uniform_bytes", COUNTER_TYPE_COUNTER);
+    context.transient_descriptors.sets_counter = counter_register("vulkan.transient_descriptor_sets", COUNTER_TYPE_COUNTER);
+    context.secondary_command_buffers_counter = counter_register("vulkan.secondary_command_buffers", COUNTER_TYPE_COUNTER);
 
     // Setup Vulkan instance.
     VkApplicationInfo app_info = {VK_STRUCTURE_TYPE_APPLICATION_INFO};
@@ -400,6 +516,14 @@ b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const renderer_
         return false;
     }
 
+    // Device memory allocator, which every buffer and image is allocated from.
+    if (!vulkan_memory_allocator_create(&context)) {
+        KERROR("Failed to create device memory allocator!");
+        return false;
+    }
+    // Only the latest change of pressure matters to those acting on it.
+    event_set_coalesced(EVENT_CODE_GPU_MEMORY_PRESSURE, true);
+
     // Swapchain
     vulkan_swapchain_create(
         &context,
@@ -430,35 +554,92 @@ b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const renderer_
         VK_CHECK(vkCreateFence(context.device.logical_device, &fence_create_info, context.allocator, &context.in_flight_fences[i]));
     }
 
-    // In flight fences should not yet exist at this point, so clear the list. These are stored in pointers
-    // because the initial state should be 0, and will be 0 when not in use. Acutal fences are not owned
-    // by this list.
+    // Where supported, frames signal a timeline rather than their fences, so how far the GPU has got is one value.
+    if (context.device.supports_timeline_semaphores) {
+        context.graphics_timeline = timeline_semaphore_create();
+    }
+
+    // No images are in flight yet.
     for (u32 i = 0; i < context.swapchain.image_count; ++i) {
-        context.images_in_flight[i] = 0;
+        context.image_frame_serials[i] = 0;
+    }
+
+    // Timestamp queries, for timing renderpasses on the GPU.
+    timestamp_queries_create();
+
+    // The pipeline cache, loaded from the last run so that pipelines need not be compiled again.
+    pipeline_cache_create();
+
+    // The staging ring, which uploads are staged through.
+    if (!staging_ring_create()) {
+        return false;
     }
 
     // Create buffers
 
-    // Geometry vertex buffer
-    const u64 vertex_buffer_size = sizeof(vertex_3d) * 1024 * 1024;
-    if (!renderer_renderbuffer_create(RENDERBUFFER_TYPE_VERTEX, vertex_buffer_size, true, &context.object_vertex_buffer)) {
-        KERROR("Error creating vertex buffer.");
+    // The geometry heap, starting with one block. More are chained as it fills.
+    context.geometry_compaction_block = INVALID_ID;
+    if (geometry_block_create(0, 0, 0) == INVALID_ID) {
+        KERROR("Error creating the geometry buffers.");
+        return false;
+    }
+
+    // The sets shaders pulling their vertices read vertex buffers through. Must exist before those shaders are created.
+    if (!vertex_sets_create()) {
+        KERROR("Error creating the vertex sets.");
+        return false;
+    }
+
+    // Draw data and indirect commands for batched draws. Must exist before shaders taking draw data are created.
+    if (!draw_batch_create()) {
+        KERROR("Error creating the draw batch buffers.");
+        return false;
+    }
+
+    // Per-draw local uniforms of shaders not taking them as push constants. Must exist before those shaders are created.
+    if (!frame_uniform_arena_create()) {
+        KERROR("Error creating the frame uniform arena.");
+        return false;
+    }
+
+    // Descriptor sets of instances which change every frame, allocated afresh each frame.
+    if (!transient_descriptors_create()) {
+        KERROR("Error creating the transient descriptor pools.");
         return false;
     }
-    renderer_renderbuffer_bind(&context.object_vertex_buffer, 0);
 
-    // Geometry index buffer
-    const u64 index_buffer_size = sizeof(u32) * 1024 * 1024;
-    if (!renderer_renderbuffer_create(RENDERBUFFER_TYPE_INDEX, index_buffer_size, true, &context.object_index_buffer)) {
-        KERROR("Error creating index buffer.");
+    // Pixels read back a few frames later, so reading them never waits for the GPU.
+    if (!pixel_readback_create()) {
+        KERROR("Error creating the pixel readback buffer.");
         return false;
     }
-    renderer_renderbuffer_bind(&context.object_index_buffer, 0);
+
+    // Secondary command buffers batched draws may be recorded into on several threads.
+    if (!recorders_create()) {
+        KERROR("Error creating the command buffer recorders.");
+        return false;
+    }
+
+    // GPU culling of batched draws, where it can run.
+    vulkan_cull_create(&context);
+
+    // GPU skinning of geometries, where it can run. Writes through the vertex sets of the geometry blocks.
+    vulkan_skinning_create(&context);
+
+    // The texture table of bindless shaders, where the device supports it. Must exist before they are created.
+    bindless_textures_create();
 
     // Mark all geometries as invalid
     for (u32 i = 0; i < VULKAN_MAX_GEOMETRY_COUNT; ++i) {
         context.geometries[i].id = INVALID_ID;
+        context.geometries[i].skin_index = INVALID_ID;
+    }
+    context.geometry_uploads = darray_create(vulkan_geometry_upload);
+    if (!upload_batches_create()) {
+        KERROR("Failed to create the geometry upload batches.");
+        return false;
     }
+    context.deferred_deletions = darray_create(vulkan_deferred_deletion);
 
     KINFO("Vulkan renderer initialized successfully.");
     return true;
@@ -468,9 +649,32 @@ void vulkan_renderer_backend_shutdown(renderer_backend* backend) {
     vkDeviceWaitIdle(context.device.logical_device);
 
     // Destroy in the opposite order of creation.
+    geometry_uploads_update(true);
+    darray_destroy(context.geometry_uploads);
+    context.geometry_uploads = 0;
+    upload_batches_destroy();
+
+    staging_ring_flush();
+    staging_ring_destroy();
+
+    bindless_textures_destroy();
+    vulkan_skinning_destroy(&context);
+    vulkan_cull_destroy(&context);
+    recorders_destroy();
+    pixel_readback_destroy();
+    transient_descriptors_destroy();
+    frame_uniform_arena_destroy();
+    draw_batch_destroy();
+
     // Destroy buffers
-    renderer_renderbuffer_destroy(&context.object_vertex_buffer);
-    renderer_renderbuffer_destroy(&context.object_index_buffer);
+    for (u32 i = 0; i < VULKAN_MAX_GEOMETRY_BLOCKS; ++i) {
+        geometry_block_destroy(i);
+    }
+    vertex_sets_destroy();
+
+    timestamp_queries_destroy();
+
+    pipeline_cache_destroy();
 
     // Sync objects
     for (u8 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
@@ -490,6 +694,10 @@ void vulkan_renderer_backend_shutdown(renderer_backend* backend) {
         }
         vkDestroyFence(context.device.logical_device, context.in_flight_fences[i], context.allocator);
     }
+    if (context.graphics_timeline) {
+        vkDestroySemaphore(context.device.logical_device, context.graphics_timeline, context.allocator);
+        context.graphics_timeline = 0;
+    }
     darray_destroy(context.image_available_semaphores);
     context.image_available_semaphores = 0;
 
@@ -512,6 +720,14 @@ void vulkan_renderer_backend_shutdown(renderer_backend* backend) {
     // Swapchain
     vulkan_swapchain_destroy(&context, &context.swapchain);
 
+    // The device is idle, so everything awaiting deletion can go.
+    deferred_deletions_update(true);
+    darray_destroy(context.deferred_deletions);
+    context.deferred_deletions = 0;
+    sampler_cache_destroy();
+
+    vulkan_memory_allocator_destroy(&context);
+
     KDEBUG("Destroying Vulkan device...");
     vulkan_device_destroy(&context);
 
@@ -537,6 +753,9 @@ void vulkan_renderer_backend_shutdown(renderer_backend* backend) {
     if (context.allocator) {
         kfree(context.allocator, sizeof(VkAllocationCallbacks), MEMORY_TAG_RENDERER);
         context.allocator = 0;
+#if KVULKAN_USE_CUSTOM_ALLOCATOR == 1 && KVULKAN_USE_HOST_ALLOCATOR == 1
+        host_allocator_destroy(&context.host_allocator);
+#endif
     }
 }
 
@@ -552,27 +771,16 @@ void vulkan_renderer_backend_on_resized(renderer_backend* backend, u16 width, u1
 
 b8 vulkan_renderer_backend_begin_frame(renderer_backend* backend, f32 delta_time) {
     context.frame_delta_time = delta_time;
-    vulkan_device* device = &context.device;
 
     // Check if recreating swap chain and boot out.
     if (context.recreating_swapchain) {
-        VkResult result = vkDeviceWaitIdle(device->logical_device);
-        if (!vulkan_result_is_success(result)) {
-            KERROR("vulkan_renderer_backend_begin_frame vkDeviceWaitIdle (1) failed: '%s'", vulkan_result_string(result, true));
-            return false;
-        }
         KINFO("Recreating swapchain, booting.");
         return false;
     }
 
     // Check if the framebuffer has been resized. If so, a new swapchain must be created.
+    // Frames still in flight keep the old one, which is retired once they complete.
     if (context.framebuffer_size_generation != context.framebuffer_size_last_generation) {
-        VkResult result = vkDeviceWaitIdle(device->logical_device);
-        if (!vulkan_result_is_success(result)) {
-            KERROR("vulkan_renderer_backend_begin_frame vkDeviceWaitIdle (2) failed: '%s'", vulkan_result_string(result, true));
-            return false;
-        }
-
         // If the swapchain recreation failed (because, for example, the window was minimized),
         // boot out before unsetting the flag.
         if (!recreate_swapchain(backend)) {
@@ -583,13 +791,73 @@ b8 vulkan_renderer_backend_begin_frame(renderer_backend* backend, f32 delta_time
         return false;
     }
 
-    // Wait for the execution of the current frame to complete. The fence being free will allow this one to move on.
-    VkResult result = vkWaitForFences(context.device.logical_device, 1, &context.in_flight_fences[context.current_frame], true, UINT64_MAX);
+    // Wait for the execution of the current frame to complete, which allows this one to move on.
+    VkResult result = frame_wait(context.current_frame);
     if (!vulkan_result_is_success(result)) {
-        KFATAL("In-flight fence wait failure! error: %s", vulkan_result_string(result, true));
+        KFATAL("In-flight frame wait failure! error: %s", vulkan_result_string(result, true));
         return false;
     }
 
+    // Everything submitted along with the frames known to be complete is done with.
+    deferred_deletions_update(false);
+
+    // With what those deletions gave back, see how close the device is to running out of memory. Changes are
+    // posted rather than fired, so memory is given back between frames rather than in the middle of one.
+    if (vulkan_memory_budget_update(&context)) {
+        if (context.memory_allocator.pressure != RENDERER_MEMORY_PRESSURE_NONE) {
+            KWARN("GPU memory pressure is now %s, with %.1f%% of the budget of a device-local heap in use.",
+                  context.memory_allocator.pressure == RENDERER_MEMORY_PRESSURE_CRITICAL ? "critical" : "moderate", context.memory_allocator.pressure_used * 100.0f);
+        } else {
+            KINFO("GPU memory pressure has eased.");
+        }
+        event_context pressure_context = {0};
+        pressure_context.data.u8[0] = (u8)context.memory_allocator.pressure;
+        pressure_context.data.f32[1] = context.memory_allocator.pressure_used;
+        event_post(EVENT_CODE_GPU_MEMORY_PRESSURE, 0, pressure_context);
+    }
+
+#if KVULKAN_USE_CUSTOM_ALLOCATOR == 1 && KVULKAN_USE_HOST_ALLOCATOR == 1
+    // Command scope driver allocations move on to the other arena, emptying it if they all have been freed.
+    if (context.allocator) {
+        host_allocator_frame_begin(&context.host_allocator);
+    }
+#endif
+
+    // This frame's region of the draw batch buffers and the frame uniform arena is free to be filled again.
+    context.draw_batch.used = 0;
+    context.frame_uniforms.used = 0;
+
+    // The transient descriptor sets it wrote are all given back at once.
+    transient_descriptors_reset();
+
+    // As are the secondary command buffers recorded by that frame.
+    for (u32 i = 0; i < VULKAN_MAX_RECORDERS; ++i) {
+        vulkan_recorder* recorder = &context.recorders[i];
+        if (recorder->pools[context.current_frame]) {
+            VK_CHECK(vkResetCommandPool(context.device.logical_device, recorder->pools[context.current_frame], 0));
+        }
+        recorder->used = 0;
+    }
+
+    // Geometry which has finished uploading is drawn from this frame on.
+    geometry_uploads_update(false);
+
+#if KVULKAN_GEOMETRY_COMPACTION == 1
+    // Before anything is recorded, so a block it releases is bound in nothing.
+    geometry_compaction_update();
+#endif
+
+    // The uploads submitted with the last frame to use this staging region are complete, so it can be reused.
+    vulkan_staging_region* staging_region = &context.staging_ring.regions[context.current_frame];
+    if (staging_region->submitted) {
+        staging_region->used = 0;
+        staging_region->submitted = false;
+    }
+
+    // The last frame to use this frame's timestamp queries is now complete, so collect its renderpass times.
+    vulkan_timestamp_frame* timestamp_frame = &context.timestamp_frames[context.current_frame];
+    timestamp_queries_resolve(timestamp_frame);
+
     // Acquire the next image from the swap chain. Pass along the semaphore that should signaled when this completes.
     // This same semaphore will later be waited on by the queue submission to ensure this image is available.
     if (!vulkan_swapchain_acquire_next_image_index(
@@ -608,7 +876,23 @@ b8 vulkan_renderer_backend_begin_frame(renderer_backend* backend, f32 delta_time
     vulkan_command_buffer_reset(command_buffer);
     vulkan_command_buffer_begin(command_buffer, false, false, false);
 
+    // Nothing is bound in the new command buffer yet.
+    context.bound_shader = 0;
+    context.bound_graphics_pipeline = 0;
+    context.draw_batch.bound_layout = 0;
+    context.parallel_renderpass = 0;
+    context.parallel_framebuffer = 0;
+
+    if (context.timestamps_supported) {
+        vkCmdResetQueryPool(command_buffer->handle, timestamp_frame->pool, 0, VULKAN_MAX_TIMED_RENDERPASSES * 2);
+    }
+
+    // Cull the frame's batched draws, before any renderpass begins.
+    vulkan_cull_record(&context, command_buffer);
+    vulkan_skinning_frame_begin(&context);
+
     // Dynamic state
+    context.resolution_scale = 1.0f;
     context.viewport_rect = (vec4){0.0f, (f32)context.framebuffer_height, (f32)context.framebuffer_width, -(f32)context.framebuffer_height};
     vulkan_renderer_viewport_set(context.viewport_rect);
 
@@ -623,31 +907,51 @@ b8 vulkan_renderer_backend_end_frame(renderer_backend* backend, f32 delta_time)
 
     vulkan_command_buffer_end(command_buffer);
 
-    // Make sure the previous frame is not using this image (i.e. its fence is being waited on)
-    if (context.images_in_flight[context.image_index] != VK_NULL_HANDLE) {  // was frame
-        VkResult result = vkWaitForFences(context.device.logical_device, 1, &context.images_in_flight[context.image_index], true, UINT64_MAX);
-        if (!vulkan_result_is_success(result)) {
-            KFATAL("vkWaitForFences error: %s", vulkan_result_string(result, true));
-        }
+    // The frame's batched draws are all known, so can be counted for culling.
+    vulkan_cull_frame_end(&context);
+
+    // Make sure the previous frame is not using this image.
+    VkResult image_result = frame_serial_wait(context.image_frame_serials[context.image_index]);
+    if (!vulkan_result_is_success(image_result)) {
+        KFATAL("Swapchain image wait error: %s", vulkan_result_string(image_result, true));
     }
 
-    // Mark the image fence as in-use by this frame.
-    context.images_in_flight[context.image_index] = context.in_flight_fences[context.current_frame];
+    // Reset the fence for use on the next frame, unless the frame signals the timeline instead.
+    if (!context.graphics_timeline) {
+        VK_CHECK(vkResetFences(context.device.logical_device, 1, &context.in_flight_fences[context.current_frame]));
+    }
 
-    // Reset the fence for use on the next frame
-    VK_CHECK(vkResetFences(context.device.logical_device, 1, &context.in_flight_fences[context.current_frame]));
+    // Geometry uploaded during the frame goes to the transfer queue in one submission.
+    upload_batches_submit();
 
     // Submit the queue and wait for the operation to complete.
     // Begin queue submission
     VkSubmitInfo submit_info = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
 
-    // Command buffer(s) to be executed.
-    submit_info.commandBufferCount = 1;
-    submit_info.pCommandBuffers = &command_buffer->handle;
-
-    // The semaphore(s) to be signaled when the queue is complete.
-    submit_info.signalSemaphoreCount = 1;
-    submit_info.pSignalSemaphores = &context.queue_complete_semaphores[context.current_frame];
+    // Command buffer(s) to be executed. Uploads staged for this frame run first.
+    VkCommandBuffer command_buffers[2];
+    u32 command_buffer_count = 0;
+    vulkan_staging_region* staging_region = &context.staging_ring.regions[context.current_frame];
+    if (staging_region->recording) {
+        staging_ring_region_end(staging_region);
+        command_buffers[command_buffer_count++] = staging_region->command_buffer.handle;
+    }
+    command_buffers[command_buffer_count++] = command_buffer->handle;
+    submit_info.commandBufferCount = command_buffer_count;
+    submit_info.pCommandBuffers = command_buffers;
+
+    // The semaphore(s) to be signaled when the queue is complete. The binary one is for presentation,
+    // which cannot wait on a timeline.
+    VkSemaphore signal_semaphores[2] = {context.queue_complete_semaphores[context.current_frame], context.graphics_timeline};
+    uint64_t signal_values[2] = {0, context.graphics_timeline_value + 1};
+    VkTimelineSemaphoreSubmitInfo timeline_info = {VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+    timeline_info.signalSemaphoreValueCount = 2;
+    timeline_info.pSignalSemaphoreValues = signal_values;
+    submit_info.signalSemaphoreCount = context.graphics_timeline ? 2 : 1;
+    submit_info.pSignalSemaphores = signal_semaphores;
+    if (context.graphics_timeline) {
+        submit_info.pNext = &timeline_info;
+    }
 
     // Wait semaphore ensures that the operation cannot begin until the image is available.
     submit_info.waitSemaphoreCount = 1;
@@ -663,13 +967,26 @@ b8 vulkan_renderer_backend_end_frame(renderer_backend* backend, f32 delta_time)
         context.device.graphics_queue,
         1,
         &submit_info,
-        context.in_flight_fences[context.current_frame]);
+        context.graphics_timeline ? VK_NULL_HANDLE : context.in_flight_fences[context.current_frame]);
     if (result != VK_SUCCESS) {
         KERROR("vkQueueSubmit failed with result: %s", vulkan_result_string(result, true));
         return false;
     }
 
     vulkan_command_buffer_update_submitted(command_buffer);
+    if (command_buffer_count > 1) {
+        vulkan_command_buffer_update_submitted(&staging_region->command_buffer);
+        staging_region->submitted = true;
+    }
+
+    // Objects deleted up to now are released once this frame completes.
+    context.frame_serial++;
+    context.submitted_frame_counts[context.current_frame] = context.frame_serial;
+    if (context.graphics_timeline) {
+        context.graphics_timeline_value = signal_values[1];
+        context.submitted_timeline_values[context.current_frame] = context.graphics_timeline_value;
+    }
+    context.image_frame_serials[context.image_index] = context.frame_serial;
     // End queue submission
 
     // Give the image back to the swapchain.
@@ -683,8 +1000,29 @@ b8 vulkan_renderer_backend_end_frame(renderer_backend* backend, f32 delta_time)
     return true;
 }
 
-void vulkan_renderer_viewport_set(vec4 rect) {
-    // Dynamic state
+void vulkan_renderer_backend_latency_wait(renderer_backend* backend) {
+    if (!context.swapchain_config.low_latency || context.recreating_swapchain || !context.swapchain.handle) {
+        return;
+    }
+
+    if (context.device.supports_present_wait && context.present_id) {
+        // Wait for the last frame to reach the display. Bounded, so a hidden window does not stall forever.
+        VkResult result = context.device.wait_for_present(context.device.logical_device, context.swapchain.handle, context.present_id, 100 * 1000 * 1000);
+        if (result != VK_SUCCESS && result != VK_TIMEOUT && result != VK_SUBOPTIMAL_KHR && result != VK_ERROR_OUT_OF_DATE_KHR) {
+            KWARN("Waiting for present failed: %s", vulkan_result_string(result, true));
+        }
+        return;
+    }
+
+    // Otherwise, wait for the last frame submitted to finish rendering.
+    VkResult result = frame_serial_wait(context.frame_serial);
+    if (!vulkan_result_is_success(result)) {
+        KWARN("Waiting for the last frame failed: %s", vulkan_result_string(result, true));
+    }
+}
+
+// Records the given viewport rectangle in the given command buffer.
+static void viewport_record(VkCommandBuffer command_buffer, vec4 rect) {
     VkViewport viewport;
     viewport.x = rect.x;
     viewport.y = rect.y;
@@ -693,26 +1031,34 @@ void vulkan_renderer_viewport_set(vec4 rect) {
     viewport.minDepth = 0.0f;
     viewport.maxDepth = 1.0f;
 
-    vulkan_command_buffer* command_buffer = &context.graphics_command_buffers[context.image_index];
-
-    vkCmdSetViewport(command_buffer->handle, 0, 1, &viewport);
-}
-
-void vulkan_renderer_viewport_reset() {
-    // Just set the current viewport rect.
-    vulkan_renderer_viewport_set(context.viewport_rect);
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
 }
 
-void vulkan_renderer_scissor_set(vec4 rect) {
+// Records the given scissor rectangle in the given command buffer.
+static void scissor_record(VkCommandBuffer command_buffer, vec4 rect) {
     VkRect2D scissor;
     scissor.offset.x = rect.x;
     scissor.offset.y = rect.y;
     scissor.extent.width = rect.z;
     scissor.extent.height = rect.w;
 
-    vulkan_command_buffer* command_buffer = &context.graphics_command_buffers[context.image_index];
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+}
+
+void vulkan_renderer_viewport_set(vec4 rect) {
+    // Dynamic state, which secondary command buffers set again.
+    context.current_viewport_rect = rect;
+    viewport_record(context.graphics_command_buffers[context.image_index].handle, rect);
+}
+
+void vulkan_renderer_viewport_reset() {
+    // Just set the current viewport rect.
+    vulkan_renderer_viewport_set(context.viewport_rect);
+}
 
-    vkCmdSetScissor(command_buffer->handle, 0, 1, &scissor);
+void vulkan_renderer_scissor_set(vec4 rect) {
+    context.current_scissor_rect = rect;
+    scissor_record(context.graphics_command_buffers[context.image_index].handle, rect);
 }
 
 void vulkan_renderer_scissor_reset() {
@@ -720,7 +1066,224 @@ void vulkan_renderer_scissor_reset() {
     vulkan_renderer_scissor_set(context.scissor_rect);
 }
 
-b8 vulkan_renderer_renderpass_begin(renderpass* pass, render_target* target) {
+b8 vulkan_renderer_resolution_scale_supported() {
+    return context.swapchain.upscale_supported;
+}
+
+// Gets the size of the part of the window rendered to at the current resolution scale.
+static void resolution_scale_extent_get(u32* out_width, u32* out_height) {
+    *out_width = resolution_scale_extent(context.resolution_scale, context.framebuffer_width);
+    *out_height = resolution_scale_extent(context.resolution_scale, context.framebuffer_height);
+}
+
+void vulkan_renderer_resolution_scale_begin(f32 scale) {
+    if (!context.swapchain.upscale_supported) {
+        return;
+    }
+    context.resolution_scale = scale;
+    u32 width;
+    u32 height;
+    resolution_scale_extent_get(&width, &height);
+
+    // The top left of the window, flipped as the full viewport is. The defaults change too, so
+    // views resetting them stay within it.
+    context.viewport_rect = (vec4){0.0f, (f32)height, (f32)width, -(f32)height};
+    vulkan_renderer_viewport_set(context.viewport_rect);
+    context.scissor_rect = (vec4){0, 0, width, height};
+    vulkan_renderer_scissor_set(context.scissor_rect);
+}
+
+// Makes a barrier transitioning the given colour image between layouts, after the given access.
+static VkImageMemoryBarrier colour_barrier_make(VkImage image, VkImageLayout old_layout, VkImageLayout new_layout, VkAccessFlags src_access, VkAccessFlags dst_access) {
+    VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = new_layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.srcAccessMask = src_access;
+    barrier.dstAccessMask = dst_access;
+    return barrier;
+}
+
+void vulkan_renderer_resolution_scale_end() {
+    if (!context.swapchain.upscale_supported || context.resolution_scale >= 1.0f) {
+        return;
+    }
+    VkCommandBuffer handle = context.graphics_command_buffers[context.image_index].handle;
+    VkImage window_image = ((vulkan_image*)context.swapchain.render_textures[context.image_index].internal_data)->handle;
+    VkImage upscale_image = context.swapchain.upscale_image.handle;
+    u32 width;
+    u32 height;
+    resolution_scale_extent_get(&width, &height);
+
+    // A blit may not read and write overlapping parts of one image, so the part rendered to is
+    // copied out first, then blitted back over the whole window. The scaled views leave the window
+    // image as a colour attachment, for the views after them.
+    VkImageMemoryBarrier barriers[2];
+    barriers[0] = colour_barrier_make(window_image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+    barriers[1] = colour_barrier_make(upscale_image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
+    vkCmdPipelineBarrier(handle, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, 0, 0, 0, 2, barriers);
+
+    VkImageCopy copy = {0};
+    copy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    copy.srcSubresource.layerCount = 1;
+    copy.dstSubresource = copy.srcSubresource;
+    copy.extent.width = width;
+    copy.extent.height = height;
+    copy.extent.depth = 1;
+    vkCmdCopyImage(handle, window_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, upscale_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+
+    barriers[0] = colour_barrier_make(window_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
+    barriers[1] = colour_barrier_make(upscale_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+    vkCmdPipelineBarrier(handle, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, 0, 0, 0, 2, barriers);
+
+    VkImageBlit blit = {0};
+    blit.srcSubresource = copy.srcSubresource;
+    blit.srcOffsets[1] = (VkOffset3D){(i32)width, (i32)height, 1};
+    blit.dstSubresource = copy.srcSubresource;
+    blit.dstOffsets[1] = (VkOffset3D){(i32)context.framebuffer_width, (i32)context.framebuffer_height, 1};
+    vkCmdBlitImage(handle, upscale_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, window_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+    barriers[0] = colour_barrier_make(window_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+    vkCmdPipelineBarrier(handle, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0, 0, 0, 0, 1, barriers);
+
+    // The views after render to the whole window again.
+    context.viewport_rect = (vec4){0.0f, (f32)context.framebuffer_height, (f32)context.framebuffer_width, -(f32)context.framebuffer_height};
+    vulkan_renderer_viewport_set(context.viewport_rect);
+    context.scissor_rect = (vec4){0, 0, context.framebuffer_width, context.framebuffer_height};
+    vulkan_renderer_scissor_set(context.scissor_rect);
+}
+
+// Gets the stages an attachment is used in while rendered to, and its accesses in them.
+static void attachment_usage_get(const vulkan_renderpass_attachment* attachment, VkPipelineStageFlags* out_stages, VkAccessFlags* out_write_access, VkAccessFlags* out_access) {
+    if (attachment->is_depth) {
+        *out_stages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        *out_write_access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        *out_access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    } else {
+        *out_stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        *out_write_access = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        *out_access = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    }
+}
+
+// Makes a barrier transitioning the given attachment image between layouts.
+static VkImageMemoryBarrier attachment_barrier_make(const vulkan_renderpass_attachment* attachment, const vulkan_image* image, VkImageLayout old_layout, VkImageLayout new_layout) {
+    VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = new_layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image->handle;
+    barrier.subresourceRange.aspectMask = attachment->is_depth ? vulkan_depth_aspect_get(attachment->format) : VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    return barrier;
+}
+
+// Begins rendering the given renderpass dynamically. The attachments are first transitioned from the
+// layouts the renderpass expects them in to those they are rendered in, after what last wrote them,
+// as the subpass dependency and layouts of a render pass object would have.
+static void rendering_begin(vulkan_command_buffer* command_buffer, renderpass* pass, render_target* target, VkSubpassContents contents) {
+    vulkan_renderpass* internal_data = pass->internal_data;
+    internal_data->current_target = target;
+
+    VkImageMemoryBarrier barriers[VULKAN_RENDERPASS_MAX_ATTACHMENTS];
+    VkRenderingAttachmentInfoKHR colour_infos[VULKAN_RENDERPASS_MAX_ATTACHMENTS];
+    VkRenderingAttachmentInfoKHR depth_info = {VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR};
+    b8 has_depth = false;
+    u32 colour_count = 0;
+    VkPipelineStageFlags stages = 0;
+    for (u32 i = 0; i < internal_data->attachment_count; ++i) {
+        const vulkan_renderpass_attachment* attachment = &internal_data->attachments[i];
+        const vulkan_image* image = target->attachments[i].texture->internal_data;
+        VkImageLayout layout = attachment->is_depth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        VkPipelineStageFlags attachment_stages;
+        VkAccessFlags write_access;
+        VkAccessFlags access;
+        attachment_usage_get(attachment, &attachment_stages, &write_access, &access);
+        barriers[i] = attachment_barrier_make(attachment, image, attachment->initial_layout, layout);
+        barriers[i].srcAccessMask = write_access;
+        barriers[i].dstAccessMask = access;
+        stages |= attachment_stages;
+
+        VkRenderingAttachmentInfoKHR info = {VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR};
+        info.imageView = image->view;
+        info.imageLayout = layout;
+        info.loadOp = attachment->load_op;
+        info.storeOp = attachment->store_op;
+        if (attachment->is_depth) {
+            info.clearValue.depthStencil.depth = internal_data->depth;
+            b8 do_clear_stencil = (pass->clear_flags & RENDERPASS_CLEAR_STENCIL_BUFFER_FLAG) != 0;
+            info.clearValue.depthStencil.stencil = do_clear_stencil ? internal_data->stencil : 0;
+            depth_info = info;
+            has_depth = true;
+        } else {
+            kcopy_memory(info.clearValue.color.float32, pass->clear_colour.elements, sizeof(f32) * 4);
+            colour_infos[colour_count++] = info;
+        }
+    }
+    if (internal_data->attachment_count) {
+        vkCmdPipelineBarrier(command_buffer->handle, stages, stages, 0, 0, 0, 0, 0, internal_data->attachment_count, barriers);
+    }
+
+    VkRenderingInfoKHR rendering_info = {VK_STRUCTURE_TYPE_RENDERING_INFO_KHR};
+    rendering_info.flags = contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR : 0;
+    rendering_info.renderArea.offset.x = pass->render_area.x;
+    rendering_info.renderArea.offset.y = pass->render_area.y;
+    rendering_info.renderArea.extent.width = pass->render_area.z;
+    rendering_info.renderArea.extent.height = pass->render_area.w;
+    rendering_info.layerCount = 1;
+    rendering_info.colorAttachmentCount = colour_count;
+    rendering_info.pColorAttachments = colour_count ? colour_infos : 0;
+    rendering_info.pDepthAttachment = has_depth ? &depth_info : 0;
+    context.device.cmd_begin_rendering(command_buffer->handle, &rendering_info);
+}
+
+// Ends rendering the given renderpass dynamically, then transitions the attachments which are to be
+// left in other layouts than they were rendered in, such as for presenting.
+static void rendering_end(vulkan_command_buffer* command_buffer, renderpass* pass) {
+    vulkan_renderpass* internal_data = pass->internal_data;
+    context.device.cmd_end_rendering(command_buffer->handle);
+
+    VkImageMemoryBarrier barriers[VULKAN_RENDERPASS_MAX_ATTACHMENTS];
+    u32 barrier_count = 0;
+    VkPipelineStageFlags stages = 0;
+    for (u32 i = 0; i < internal_data->attachment_count; ++i) {
+        const vulkan_renderpass_attachment* attachment = &internal_data->attachments[i];
+        VkImageLayout layout = attachment->is_depth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        if (attachment->final_layout == layout) {
+            continue;
+        }
+        VkPipelineStageFlags attachment_stages;
+        VkAccessFlags write_access;
+        VkAccessFlags access;
+        attachment_usage_get(attachment, &attachment_stages, &write_access, &access);
+        const vulkan_image* image = internal_data->current_target->attachments[i].texture->internal_data;
+        VkImageMemoryBarrier* barrier = &barriers[barrier_count++];
+        *barrier = attachment_barrier_make(attachment, image, layout, attachment->final_layout);
+        // Presenting waits on the semaphore signalled when the frame completes, so needs no access.
+        barrier->srcAccessMask = write_access;
+        barrier->dstAccessMask = 0;
+        stages |= attachment_stages;
+    }
+    if (barrier_count) {
+        vkCmdPipelineBarrier(command_buffer->handle, stages, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, 0, 0, 0, barrier_count, barriers);
+    }
+    internal_data->current_target = 0;
+}
+
+// Begins the given renderpass, with its commands recorded in the frame's command buffer, or in secondary command buffers.
+static void renderpass_begin(renderpass* pass, render_target* target, VkSubpassContents contents) {
     vulkan_command_buffer* command_buffer = &context.graphics_command_buffers[context.image_index];
 
     // Begin the render pass.
@@ -767,20 +1330,239 @@ b8 vulkan_renderer_renderpass_begin(renderpass* pass, render_target* target) {
 
     begin_info.pClearValues = begin_info.clearValueCount > 0 ? clear_values : 0;
 
-    vkCmdBeginRenderPass(command_buffer->handle, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+    // Time the renderpass, if there is room left this frame.
+    internal_data->timestamp_index = INVALID_ID;
+    vulkan_timestamp_frame* timestamp_frame = &context.timestamp_frames[context.current_frame];
+    if (context.timestamps_supported && timestamp_frame->pass_count < VULKAN_MAX_TIMED_RENDERPASSES) {
+        internal_data->timestamp_index = timestamp_frame->pass_count++;
+        timestamp_frame->passes[internal_data->timestamp_index] = pass;
+        vkCmdWriteTimestamp(command_buffer->handle, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestamp_frame->pool, internal_data->timestamp_index * 2);
+    }
+
+    if (internal_data->handle) {
+        vkCmdBeginRenderPass(command_buffer->handle, &begin_info, contents);
+    } else {
+        rendering_begin(command_buffer, pass, target, contents);
+    }
     command_buffer->state = COMMAND_BUFFER_STATE_IN_RENDER_PASS;
+}
+
+b8 vulkan_renderer_renderpass_begin(renderpass* pass, render_target* target) {
+    renderpass_begin(pass, target, VK_SUBPASS_CONTENTS_INLINE);
+    return true;
+}
 
+b8 vulkan_renderer_renderpass_begin_parallel(renderpass* pass, render_target* target) {
+    renderpass_begin(pass, target, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    context.parallel_renderpass = pass->internal_data;
+    context.parallel_framebuffer = target->internal_framebuffer;
     return true;
 }
 
+b8 vulkan_renderer_parallel_recording_supported() {
+    return context.recorders[0].pools[0] != 0;
+}
+
 b8 vulkan_renderer_renderpass_end(renderpass* pass) {
     vulkan_command_buffer* command_buffer = &context.graphics_command_buffers[context.image_index];
     // End the renderpass.
-    vkCmdEndRenderPass(command_buffer->handle);
+    vulkan_renderpass* internal_data = pass->internal_data;
+    if (internal_data->handle) {
+        vkCmdEndRenderPass(command_buffer->handle);
+    } else {
+        rendering_end(command_buffer, pass);
+    }
     command_buffer->state = COMMAND_BUFFER_STATE_RECORDING;
+
+    if (context.parallel_renderpass) {
+        // Dynamic state is undefined after secondary command buffers are executed, so is set again.
+        context.parallel_renderpass = 0;
+        context.parallel_framebuffer = 0;
+        viewport_record(command_buffer->handle, context.current_viewport_rect);
+        scissor_record(command_buffer->handle, context.current_scissor_rect);
+    }
+
+    if (internal_data->timestamp_index != INVALID_ID) {
+        VkQueryPool pool = context.timestamp_frames[context.current_frame].pool;
+        vkCmdWriteTimestamp(command_buffer->handle, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pool, internal_data->timestamp_index * 2 + 1);
+        internal_data->timestamp_index = INVALID_ID;
+    }
     return true;
 }
 
+static void timestamp_queries_create() {
+    kzero_memory(context.timestamp_frames, sizeof(context.timestamp_frames));
+    context.timestamps_supported = false;
+
+    // Timestamps must be supported by the graphics queue itself.
+    u32 queue_family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(context.device.physical_device, &queue_family_count, 0);
+    VkQueueFamilyProperties* queue_families = kallocate(sizeof(VkQueueFamilyProperties) * queue_family_count, MEMORY_TAG_RENDERER);
+    vkGetPhysicalDeviceQueueFamilyProperties(context.device.physical_device, &queue_family_count, queue_families);
+    u32 valid_bits = queue_families[context.device.graphics_queue_index].timestampValidBits;
+    kfree(queue_families, sizeof(VkQueueFamilyProperties) * queue_family_count, MEMORY_TAG_RENDERER);
+
+    context.timestamp_period = context.device.properties.limits.timestampPeriod;
+    if (valid_bits == 0 || context.timestamp_period <= 0) {
+        KINFO("GPU timestamps are not supported by the graphics queue; renderpasses will not be timed.");
+        return;
+    }
+    context.timestamp_mask = valid_bits >= 64 ? ~0ull : ((1ull << valid_bits) - 1);
+
+    VkQueryPoolCreateInfo pool_info = {VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+    pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    pool_info.queryCount = VULKAN_MAX_TIMED_RENDERPASSES * 2;
+    for (u8 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
+        VkResult result = vkCreateQueryPool(context.device.logical_device, &pool_info, context.allocator, &context.timestamp_frames[i].pool);
+        if (!vulkan_result_is_success(result)) {
+            KWARN("Failed to create a timestamp query pool: '%s'. Renderpasses will not be timed.", vulkan_result_string(result, true));
+            timestamp_queries_destroy();
+            return;
+        }
+    }
+    context.timestamps_supported = true;
+}
+
+static void timestamp_queries_destroy() {
+    for (u8 i = 0; i < 2; ++i) {
+        if (context.timestamp_frames[i].pool) {
+            vkDestroyQueryPool(context.device.logical_device, context.timestamp_frames[i].pool, context.allocator);
+        }
+    }
+    kzero_memory(context.timestamp_frames, sizeof(context.timestamp_frames));
+    context.timestamps_supported = false;
+}
+
+// Reads the cache saved by the last run, if it was saved by this same device and driver. Drivers are
+// meant to reject caches which are not theirs, but not all do so safely, so the header is checked here.
+static void* pipeline_cache_read(u64* out_size) {
+    *out_size = 0;
+    file_handle f;
+    if (!filesystem_exists(VULKAN_PIPELINE_CACHE_PATH) || !filesystem_open(VULKAN_PIPELINE_CACHE_PATH, FILE_MODE_READ, true, &f)) {
+        return 0;
+    }
+    u64 size = 0;
+    u8* data = 0;
+    u64 read = 0;
+    if (filesystem_size(&f, &size) && size > 0) {
+        data = kallocate(size, MEMORY_TAG_RENDERER);
+        if (!filesystem_read_all_bytes(&f, data, &read) || read != size) {
+            kfree(data, size, MEMORY_TAG_RENDERER);
+            data = 0;
+        }
+    }
+    filesystem_close(&f);
+    if (!data) {
+        return 0;
+    }
+
+    // The header is the header size, header version, vendor id, device id and cache UUID.
+    u32 header[4] = {0, 0, 0, 0};
+    const u64 header_size = sizeof(header) + VK_UUID_SIZE;
+    b8 uuid_matches = size >= header_size;
+    if (uuid_matches) {
+        kcopy_memory(header, data, sizeof(header));
+        for (u32 i = 0; i < VK_UUID_SIZE; ++i) {
+            uuid_matches = uuid_matches && data[sizeof(header) + i] == context.device.properties.pipelineCacheUUID[i];
+        }
+    }
+    if (!uuid_matches || header[0] < header_size || header[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        header[2] != context.device.properties.vendorID || header[3] != context.device.properties.deviceID) {
+        KINFO("The saved pipeline cache is from another device or driver, so pipelines will be compiled again.");
+        kfree(data, size, MEMORY_TAG_RENDERER);
+        return 0;
+    }
+    *out_size = size;
+    return data;
+}
+
+static void pipeline_cache_create() {
+    u64 size = 0;
+    void* data = pipeline_cache_read(&size);
+
+    VkPipelineCacheCreateInfo cache_info = {VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+    cache_info.initialDataSize = size;
+    cache_info.pInitialData = data;
+    VkResult result = vkCreatePipelineCache(context.device.logical_device, &cache_info, context.allocator, &context.pipeline_cache);
+    if (!vulkan_result_is_success(result) && data) {
+        KWARN("The saved pipeline cache was rejected: '%s'. Starting with an empty one.", vulkan_result_string(result, true));
+        cache_info.initialDataSize = 0;
+        cache_info.pInitialData = 0;
+        result = vkCreatePipelineCache(context.device.logical_device, &cache_info, context.allocator, &context.pipeline_cache);
+    }
+    if (!vulkan_result_is_success(result)) {
+        // Pipelines are still created without one, only more slowly.
+        KWARN("Failed to create a pipeline cache: '%s'.", vulkan_result_string(result, true));
+        context.pipeline_cache = VK_NULL_HANDLE;
+    } else if (data) {
+        KDEBUG("Loaded %llu bytes of saved pipelines.", size);
+    }
+    if (data) {
+        kfree(data, size, MEMORY_TAG_RENDERER);
+    }
+}
+
+// Saves the cache for the next run, then destroys it.
+static void pipeline_cache_destroy() {
+    if (!context.pipeline_cache) {
+        return;
+    }
+    size_t size = 0;
+    VkResult result = vkGetPipelineCacheData(context.device.logical_device, context.pipeline_cache, &size, 0);
+    if (vulkan_result_is_success(result) && size > 0) {
+        void* data = kallocate(size, MEMORY_TAG_RENDERER);
+        result = vkGetPipelineCacheData(context.device.logical_device, context.pipeline_cache, &size, data);
+        file_handle f;
+        if (result == VK_SUCCESS && filesystem_open(VULKAN_PIPELINE_CACHE_PATH, FILE_MODE_WRITE, true, &f)) {
+            u64 written = 0;
+            if (!filesystem_write(&f, size, data, &written) || written != size) {
+                KWARN("Unable to write all of the pipeline cache to '%s'.", VULKAN_PIPELINE_CACHE_PATH);
+            }
+            filesystem_close(&f);
+        } else {
+            KWARN("Unable to save the pipeline cache; pipelines will be compiled again next run.");
+        }
+        kfree(data, size, MEMORY_TAG_RENDERER);
+    }
+    vkDestroyPipelineCache(context.device.logical_device, context.pipeline_cache, context.allocator);
+    context.pipeline_cache = VK_NULL_HANDLE;
+}
+
+static void timestamp_queries_resolve(vulkan_timestamp_frame* frame) {
+    if (!context.timestamps_supported || frame->pass_count == 0) {
+        return;
+    }
+
+    u64 timestamps[VULKAN_MAX_TIMED_RENDERPASSES * 2];
+    u32 query_count = frame->pass_count * 2;
+    VkResult result = vkGetQueryPoolResults(
+        context.device.logical_device,
+        frame->pool,
+        0,
+        query_count,
+        sizeof(u64) * query_count,
+        timestamps,
+        sizeof(u64),
+        VK_QUERY_RESULT_64_BIT);
+    if (result == VK_SUCCESS) {
+        // A renderpass may have been begun more than once, so clear every one before summing.
+        for (u32 i = 0; i < frame->pass_count; ++i) {
+            if (frame->passes[i]) {
+                frame->passes[i]->gpu_time_ms = 0;
+            }
+        }
+        for (u32 i = 0; i < frame->pass_count; ++i) {
+            if (frame->passes[i]) {
+                u64 ticks = ((timestamps[i * 2 + 1] - timestamps[i * 2]) & context.timestamp_mask);
+                frame->passes[i]->gpu_time_ms += (ticks * (f64)context.timestamp_period) / 1000000.0;
+            }
+        }
+    } else if (result != VK_NOT_READY) {
+        KWARN("Failed to read renderpass timestamps: '%s'.", vulkan_result_string(result, true));
+    }
+    frame->pass_count = 0;
+}
+
 VKAPI_ATTR VkBool32 VKAPI_CALL vk_debug_callback(
     VkDebugUtilsMessageSeverityFlagBitsEXT message_severity,
     VkDebugUtilsMessageTypeFlagsEXT message_types,
@@ -861,13 +1643,15 @@ b8 recreate_swapchain(renderer_backend* backend) {
     // Mark as recreating if the dimensions are valid.
     context.recreating_swapchain = true;
 
-    // Wait for any operations to complete.
-    vkDeviceWaitIdle(context.device.logical_device);
+    // Submit staged uploads, since the frame they were staged for is restarted at the first region.
+    staging_ring_flush();
 
-    // Clear these out just in case.
-    for (u32 i = 0; i < context.swapchain.image_count; ++i) {
-        context.images_in_flight[i] = 0;
+    // Nothing is waited for here. What the frames in flight may still use is retired through deferred deletion.
+    // Clear these out, since the images of the new swapchain are not in flight yet.
+    for (u32 i = 0; i < VULKAN_MAX_SWAPCHAIN_IMAGES; ++i) {
+        context.image_frame_serials[i] = 0;
     }
+    u32 previous_image_count = context.swapchain.image_count;
 
     // Requery support
     vulkan_device_query_swapchain_support(
@@ -885,9 +1669,23 @@ b8 recreate_swapchain(renderer_backend* backend) {
     // Update framebuffer size generation.
     context.framebuffer_size_last_generation = context.framebuffer_size_generation;
 
-    // cleanup swapchain
-    for (u32 i = 0; i < context.swapchain.image_count; ++i) {
-        vulkan_command_buffer_free(&context, context.device.graphics_command_pool, &context.graphics_command_buffers[i]);
+    // The depth pyramid follows the size of the depth textures.
+    vulkan_cull_targets_destroy(&context);
+    vulkan_cull_targets_create(&context);
+
+    // The command buffers may still be executing, so are retired and fresh ones allocated in their place.
+    for (u32 i = 0; i < previous_image_count; ++i) {
+        if (context.graphics_command_buffers[i].handle) {
+            vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_COMMAND_BUFFER};
+            deletion.command_buffer.pool = context.device.graphics_command_pool;
+            deletion.command_buffer.handle = context.graphics_command_buffers[i].handle;
+            deferred_delete(&deletion);
+        }
+        kzero_memory(&context.graphics_command_buffers[i], sizeof(vulkan_command_buffer));
+    }
+    if (previous_image_count != context.swapchain.image_count) {
+        darray_destroy(context.graphics_command_buffers);
+        context.graphics_command_buffers = 0;
     }
 
     // Indicate to listeners that a render target refresh is required.
@@ -902,85 +1700,671 @@ b8 recreate_swapchain(renderer_backend* backend) {
     return true;
 }
 
-void vulkan_renderer_texture_create(const u8* pixels, texture* t) {
-    // Internal data creation.
-    // TODO: Use an allocator for this.
-    t->internal_data = (vulkan_image*)kallocate(sizeof(vulkan_image), MEMORY_TAG_TEXTURE);
-    vulkan_image* image = (vulkan_image*)t->internal_data;
-    u32 size = t->width * t->height * t->channel_count * (t->type == TEXTURE_TYPE_CUBE ? 6 : 1);
-
-    // NOTE: Assumes 8 bits per channel.
-    VkFormat image_format = VK_FORMAT_R8G8B8A8_UNORM;
+// The number of levels in a full mip chain for an image of the given size.
+// Queues an object for deletion once the frames which may still use it have completed.
+static void deferred_delete(vulkan_deferred_deletion* deletion) {
+    deletion->frame_serial = context.frame_serial;
+    darray_push(context.deferred_deletions, *deletion);
+}
 
-    // NOTE: Lots of assumptions here, different texture types will require
+static void deferred_deletion_run(vulkan_deferred_deletion* deletion) {
+    VkDevice device = context.device.logical_device;
+    switch (deletion->type) {
+        case VULKAN_DEFERRED_DELETION_TYPE_BUFFER:
+            buffer_internal_destroy(&deletion->buffer);
+            break;
+        case VULKAN_DEFERRED_DELETION_TYPE_IMAGE:
+            vulkan_image_destroy(&context, &deletion->image);
+            break;
+        case VULKAN_DEFERRED_DELETION_TYPE_SAMPLER:
+            vkDestroySampler(device, deletion->sampler, context.allocator);
+            break;
+        case VULKAN_DEFERRED_DELETION_TYPE_PIPELINE:
+            vulkan_pipeline_destroy(&context, &deletion->pipeline);
+            break;
+        case VULKAN_DEFERRED_DELETION_TYPE_DESCRIPTOR_SETS: {
+            VkResult result = vkFreeDescriptorSets(device, deletion->descriptor_sets.pool, deletion->descriptor_sets.count, deletion->descriptor_sets.sets);
+            if (!vulkan_result_is_success(result)) {
+                KERROR("Error freeing descriptor sets: %s", vulkan_result_string(result, true));
+            }
+        } break;
+        case VULKAN_DEFERRED_DELETION_TYPE_DESCRIPTOR_POOL:
+            vkDestroyDescriptorPool(device, deletion->descriptor_pool, context.allocator);
+            break;
+        case VULKAN_DEFERRED_DELETION_TYPE_DESCRIPTOR_SET_LAYOUT:
+            vkDestroyDescriptorSetLayout(device, deletion->descriptor_set_layout, context.allocator);
+            break;
+        case VULKAN_DEFERRED_DELETION_TYPE_COMMAND_BUFFER:
+            vkFreeCommandBuffers(device, deletion->command_buffer.pool, 1, &deletion->command_buffer.handle);
+            break;
+        case VULKAN_DEFERRED_DELETION_TYPE_IMAGE_VIEW:
+            vkDestroyImageView(device, deletion->image_view, context.allocator);
+            break;
+        case VULKAN_DEFERRED_DELETION_TYPE_FRAMEBUFFER:
+            vkDestroyFramebuffer(device, deletion->framebuffer, context.allocator);
+            break;
+        case VULKAN_DEFERRED_DELETION_TYPE_SWAPCHAIN:
+            vkDestroySwapchainKHR(device, deletion->swapchain, context.allocator);
+            break;
+        case VULKAN_DEFERRED_DELETION_TYPE_RANGE:
+            if (!renderer_renderbuffer_free(deletion->range.buffer, deletion->range.size, deletion->range.offset)) {
+                KERROR("Failed to free a renderbuffer range whose deletion was deferred.");
+            }
+            break;
+        case VULKAN_DEFERRED_DELETION_TYPE_BINDLESS_SLOT:
+            if (context.bindless.free_slots) {
+                darray_push(context.bindless.free_slots, deletion->bindless_slot);
+            }
+            break;
+    }
+}
+
+// Deletes the queued objects whose frames have completed, or all of them if the device is known to be idle.
+// Deletions run in the order they were queued, so descriptor sets are freed before their pool is destroyed.
+static void deferred_deletions_update(b8 all) {
+    if (!context.deferred_deletions) {
+        return;
+    }
+    u32 count = darray_length(context.deferred_deletions);
+    u32 done = 0;
+    while (done < count && (all || context.deferred_deletions[done].frame_serial < context.frames_completed)) {
+        deferred_deletion_run(&context.deferred_deletions[done]);
+        done++;
+    }
+    if (done) {
+        kmove_memory(context.deferred_deletions, context.deferred_deletions + done, sizeof(vulkan_deferred_deletion) * (count - done));
+        darray_length_set(context.deferred_deletions, count - done);
+    }
+}
+
+// Creates a timeline semaphore starting at 0. Returns VK_NULL_HANDLE on failure.
+static VkSemaphore timeline_semaphore_create() {
+    VkSemaphoreTypeCreateInfo type_info = {VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO};
+    type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    type_info.initialValue = 0;
+    VkSemaphoreCreateInfo semaphore_info = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+    semaphore_info.pNext = &type_info;
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    VkResult result = vkCreateSemaphore(context.device.logical_device, &semaphore_info, context.allocator, &semaphore);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("Unable to create a timeline semaphore, so fences are used instead: '%s'.", vulkan_result_string(result, true));
+        return VK_NULL_HANDLE;
+    }
+    return semaphore;
+}
+
+// Waits for the given timeline to reach the given value. A timeout of 0 only checks, returning VK_TIMEOUT if not reached.
+static VkResult timeline_wait(VkSemaphore timeline, u64 value, u64 timeout) {
+    // NOTE: Vulkan takes uint64_t values, which on some platforms is a different type than u64.
+    uint64_t wait_value = value;
+    VkSemaphoreWaitInfo wait_info = {VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO};
+    wait_info.semaphoreCount = 1;
+    wait_info.pSemaphores = &timeline;
+    wait_info.pValues = &wait_value;
+    return vkWaitSemaphores(context.device.logical_device, &wait_info, timeout);
+}
+
+// Moves frames_completed up to the frames the graphics timeline has passed, without waiting. Without a
+// timeline, frames are only known to be complete once their fences are waited for.
+static void frames_completed_poll() {
+    if (!context.graphics_timeline) {
+        return;
+    }
+    uint64_t value = 0;
+    if (vkGetSemaphoreCounterValue(context.device.logical_device, context.graphics_timeline, &value) != VK_SUCCESS) {
+        return;
+    }
+    for (u32 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
+        if (context.submitted_timeline_values[i] <= value) {
+            context.frames_completed = KMAX(context.frames_completed, context.submitted_frame_counts[i]);
+        }
+    }
+}
+
+// Waits for the last submission of the given frame in flight to complete, and everything before it.
+static VkResult frame_wait(u32 frame) {
+    VkResult result;
+    if (context.graphics_timeline) {
+        result = timeline_wait(context.graphics_timeline, context.submitted_timeline_values[frame], UINT64_MAX);
+    } else {
+        result = vkWaitForFences(context.device.logical_device, 1, &context.in_flight_fences[frame], true, UINT64_MAX);
+    }
+    if (vulkan_result_is_success(result)) {
+        context.frames_completed = KMAX(context.frames_completed, context.submitted_frame_counts[frame]);
+        frames_completed_poll();
+    }
+    return result;
+}
+
+// Waits for the frame of the given serial to complete, if it is not already known to have. 0 is taken as none.
+static VkResult frame_serial_wait(u64 serial) {
+    if (serial <= context.frames_completed) {
+        return VK_SUCCESS;
+    }
+    for (u32 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
+        if (context.submitted_frame_counts[i] == serial) {
+            return frame_wait(i);
+        }
+    }
+    // Its frame in flight has been submitted again since, which waited for it first.
+    return VK_SUCCESS;
+}
+
+// Drops the queued range frees of the given renderbuffer, for when the whole buffer is going away.
+static void deferred_ranges_forget(renderbuffer* buffer) {
+    u32 count = darray_length(context.deferred_deletions);
+    for (u32 i = count; i > 0; --i) {
+        vulkan_deferred_deletion* deletion = &context.deferred_deletions[i - 1];
+        if (deletion->type == VULKAN_DEFERRED_DELETION_TYPE_RANGE && deletion->range.buffer == buffer) {
+            darray_pop_at(context.deferred_deletions, i - 1, 0);
+        }
+    }
+}
+
+// Ends and submits a single-use command buffer without waiting for it. It is freed once the frame being
+// recorded completes, which the submission is ahead of on the queue.
+static void single_use_submit(vulkan_command_buffer* command_buffer, VkCommandPool pool, VkQueue queue) {
+    vulkan_command_buffer_end(command_buffer);
+    VkSubmitInfo submit_info = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &command_buffer->handle;
+    VK_CHECK(vkQueueSubmit(queue, 1, &submit_info, 0));
+    vulkan_command_buffer_update_submitted(command_buffer);
+
+    vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_COMMAND_BUFFER};
+    deletion.command_buffer.pool = pool;
+    deletion.command_buffer.handle = command_buffer->handle;
+    deferred_delete(&deletion);
+    command_buffer->handle = 0;
+}
+
+/** @brief The size of each frame's region of the staging ring. Larger uploads use a staging buffer of their own. */
+#define VULKAN_STAGING_REGION_SIZE MEBIBYTES(32)
+/** @brief The smallest texture upload made on a transfer queue of its own family, rather than staged through the ring. */
+#define VULKAN_TRANSFER_UPLOAD_MIN_SIZE KIBIBYTES(256)
+
+static b8 staging_ring_create() {
+    vulkan_staging_ring* ring = &context.staging_ring;
+    ring->region_size = VULKAN_STAGING_REGION_SIZE;
+    if (!renderer_renderbuffer_create(RENDERBUFFER_TYPE_STAGING, ring->region_size * context.swapchain.max_frames_in_flight, false, &ring->buffer)) {
+        KERROR("Failed to create the staging ring buffer.");
+        return false;
+    }
+    renderer_renderbuffer_bind(&ring->buffer, 0);
+
+    for (u32 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
+        vulkan_staging_region* region = &ring->regions[i];
+        region->offset = ring->region_size * i;
+        vulkan_command_buffer_allocate(&context, context.device.graphics_command_pool, true, &region->command_buffer);
+    }
+    return true;
+}
+
+static void staging_ring_destroy() {
+    vulkan_staging_ring* ring = &context.staging_ring;
+    if (!ring->buffer.internal_data) {
+        return;
+    }
+    for (u32 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
+        if (ring->regions[i].command_buffer.handle) {
+            vulkan_command_buffer_free(&context, context.device.graphics_command_pool, &ring->regions[i].command_buffer);
+        }
+    }
+    renderer_renderbuffer_unbind(&ring->buffer);
+    renderer_renderbuffer_destroy(&ring->buffer);
+    kzero_memory(ring, sizeof(vulkan_staging_ring));
+}
+
+// Takes size bytes of the current frame's region for an upload, and returns the command buffer to record
+// its copies into. Returns 0 if the upload is too large for the ring, in which case it is staged on its own.
+static vulkan_command_buffer* staging_ring_begin(u64 size, u64* out_offset) {
+    vulkan_staging_ring* ring = &context.staging_ring;
+    if (!ring->buffer.internal_data || size > ring->region_size) {
+        return 0;
+    }
+
+    vulkan_staging_region* region = &ring->regions[context.current_frame];
+    if (region->submitted) {
+        // Recycle the region once the frame it was submitted with is done with it.
+        VkResult result = frame_wait(context.current_frame);
+        if (!vulkan_result_is_success(result)) {
+            KERROR("Staging ring frame wait failure! error: %s", vulkan_result_string(result, true));
+            return 0;
+        }
+        region->used = 0;
+        region->submitted = false;
+    }
+
+    // Copies out of the staging buffer must start on a texel block for compressed images.
+    u64 offset = get_aligned(region->used, 16);
+    if (offset + size > ring->region_size) {
+        // Out of room this frame, so submit what is there and wait for it.
+        staging_ring_flush();
+        offset = 0;
+    }
+
+    if (!region->recording) {
+        vulkan_command_buffer_begin(&region->command_buffer, true, false, false);
+        region->recording = true;
+    }
+
+    // Wait for earlier work to be done with what this upload writes, including earlier uploads to it.
+    VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(region->command_buffer.handle, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, 0, 0, 0);
+
+    region->used = offset + size;
+    *out_offset = region->offset + offset;
+    return &region->command_buffer;
+}
+
+// Ends the recording of a region's copies, making what they write visible to whatever runs after them.
+static void staging_ring_region_end(vulkan_staging_region* region) {
+    VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    vkCmdPipelineBarrier(region->command_buffer.handle, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, 0, 0, 0);
+    vulkan_command_buffer_end(&region->command_buffer);
+    region->recording = false;
+}
+
+// Submits any copies not yet submitted and waits for them, for work which must see them before the next frame.
+// Every region is recycled, since everything submitted before them is then complete too.
+static void staging_ring_flush() {
+    // Images still being uploaded on the transfer queue must be acquired before anything else uses them.
+    upload_batches_submit();
+
+    vulkan_staging_ring* ring = &context.staging_ring;
+    VkCommandBuffer command_buffers[2];
+    u32 command_buffer_count = 0;
+    for (u32 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
+        if (ring->regions[i].recording) {
+            staging_ring_region_end(&ring->regions[i]);
+            command_buffers[command_buffer_count++] = ring->regions[i].command_buffer.handle;
+        }
+    }
+    if (!command_buffer_count) {
+        return;
+    }
+
+    VkSubmitInfo submit_info = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    submit_info.commandBufferCount = command_buffer_count;
+    submit_info.pCommandBuffers = command_buffers;
+    if (context.graphics_timeline) {
+        // Signal the timeline past every frame submitted, and wait for just that.
+        uint64_t value = context.graphics_timeline_value + 1;
+        VkTimelineSemaphoreSubmitInfo timeline_info = {VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+        timeline_info.signalSemaphoreValueCount = 1;
+        timeline_info.pSignalSemaphoreValues = &value;
+        submit_info.pNext = &timeline_info;
+        submit_info.signalSemaphoreCount = 1;
+        submit_info.pSignalSemaphores = &context.graphics_timeline;
+        VK_CHECK(vkQueueSubmit(context.device.graphics_queue, 1, &submit_info, 0));
+        context.graphics_timeline_value = value;
+        VK_CHECK(timeline_wait(context.graphics_timeline, value, UINT64_MAX));
+        frames_completed_poll();
+    } else {
+        VK_CHECK(vkQueueSubmit(context.device.graphics_queue, 1, &submit_info, 0));
+        VK_CHECK(vkQueueWaitIdle(context.device.graphics_queue));
+    }
+
+    for (u32 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
+        ring->regions[i].used = 0;
+        ring->regions[i].submitted = false;
+    }
+}
+
+static u32 mip_chain_length(u32 width, u32 height) {
+    u32 levels = 1;
+    for (u32 size = KMAX(width, height); size > 1; size >>= 1) {
+        levels++;
+    }
+    return levels;
+}
+
+// Indicates if mip levels can be generated for images of the given format, by blitting with linear filtering.
+static b8 format_can_generate_mips(VkFormat format) {
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(context.device.physical_device, format, &properties);
+    VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (properties.optimalTilingFeatures & required) == required;
+}
+
+// Records the copies of the first data_level_count mip levels of a texture, which follow one another in
+// source from source_offset, leaving the image in the transfer destination layout.
+static void texture_data_copy(texture* t, vulkan_command_buffer* command_buffer, VkBuffer source, u64 source_offset, u32 data_level_count) {
+    vulkan_image* image = (vulkan_image*)t->internal_data;
+    VkFormat image_format = vulkan_texture_format_to_vk(t->format, t->channel_count);
+
+    // Transition the layout from whatever it is currently to optimal for recieving data.
+    vulkan_image_transition_layout(
+        &context,
+        t->type,
+        command_buffer,
+        image,
+        image_format,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+    // Copy the data from the buffer, a level at a time.
+    u64 offset = source_offset;
+    u32 face_count = t->type == TEXTURE_TYPE_CUBE ? 6 : 1;
+    for (u32 i = 0; i < data_level_count && i < image->mip_levels; ++i) {
+        vulkan_image_copy_from_buffer(&context, t->type, image, source, offset, i, command_buffer);
+        offset += texture_format_size(t->format, KMAX(t->width >> i, 1), KMAX(t->height >> i, 1), t->channel_count) * face_count;
+    }
+}
+
+// Records generating the levels not given, leaving the image ready to be read by shaders. Must be on the graphics queue.
+static void texture_data_finish(texture* t, vulkan_command_buffer* command_buffer, u32 data_level_count) {
+    vulkan_image* image = (vulkan_image*)t->internal_data;
+    VkFormat image_format = vulkan_texture_format_to_vk(t->format, t->channel_count);
+
+    if (image->mip_levels > data_level_count) {
+        // Also leaves the image ready to be read by shaders.
+        vulkan_image_mipmaps_generate(&context, t->type, image, command_buffer);
+    } else {
+        // Transition from optimal for data reciept to shader-read-only optimal layout.
+        vulkan_image_transition_layout(
+            &context,
+            t->type,
+            command_buffer,
+            image,
+            image_format,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+}
+
+// Uploads the first data_level_count mip levels of a texture, which follow one another in pixels,
+// then generates any further levels the image has. The copies are staged through the staging ring
+// and run ahead of the next frame, unless the data is too large for it.
+// Copies the levels given on the transfer queue, with the upload batch, then hands the image to the graphics
+// queue to finish. Returns false without recording anything if the upload cannot be made this way.
+// The pixels are given either in memory, or already staged in a buffer of their own, which is taken.
+static b8 texture_data_transfer(texture* t, u32 size, const u8* pixels, renderbuffer* staged, u32 data_level_count) {
+    u32 transfer_family = (u32)context.device.transfer_queue_index;
+    u32 graphics_family = (u32)context.device.graphics_queue_index;
+    vulkan_upload_batch* batch = upload_batch_begin();
+    if (!batch) {
+        return false;
+    }
+
+    // The staging ring belongs to the graphics queue, so the data gets a staging buffer of its own.
+    renderbuffer staging;
+    if (staged) {
+        staging = *staged;
+    } else {
+        if (!renderer_renderbuffer_create(RENDERBUFFER_TYPE_STAGING, size, false, &staging)) {
+            return false;
+        }
+        renderer_renderbuffer_bind(&staging, 0);
+        vulkan_buffer_load_range(&staging, 0, size, pixels);
+    }
+
+    vulkan_image* image = (vulkan_image*)t->internal_data;
+    texture_data_copy(t, &batch->command_buffer, ((vulkan_buffer*)staging.internal_data)->handle, 0, data_level_count);
+    vulkan_image_ownership_transfer(&context, t->type, &batch->command_buffer, image, transfer_family, graphics_family, true);
+
+    if (!batch->acquire_command_buffer.handle) {
+        vulkan_command_buffer_allocate_and_begin_single_use(&context, context.device.graphics_command_pool, &batch->acquire_command_buffer);
+    }
+    vulkan_image_ownership_transfer(&context, t->type, &batch->acquire_command_buffer, image, transfer_family, graphics_family, false);
+    texture_data_finish(t, &batch->acquire_command_buffer, data_level_count);
+
+    // Destroyed once the frame the batch is submitted ahead of completes.
+    renderer_renderbuffer_unbind(&staging);
+    renderer_renderbuffer_destroy(&staging);
+    return true;
+}
+
+// Uploads the levels given, generating the rest. new_image is set if the image has never been used, so
+// nothing on the graphics queue can still be reading it.
+static void texture_data_upload(texture* t, u32 size, const u8* pixels, u32 data_level_count, b8 new_image) {
+    counter_add(context.staged_uploads_counter, 1);
+    counter_add(context.staged_bytes_counter, size);
+
+    // Large uploads of new images go to a transfer queue of another family, where they may overlap with rendering.
+    b8 separate_transfer_family = context.device.transfer_queue_index != context.device.graphics_queue_index;
+    if (new_image && separate_transfer_family && size >= VULKAN_TRANSFER_UPLOAD_MIN_SIZE && texture_data_transfer(t, size, pixels, 0, data_level_count)) {
+        t->generation++;
+        return;
+    }
+
+    u64 staging_offset;
+    vulkan_command_buffer* ring_command_buffer = staging_ring_begin(size, &staging_offset);
+    if (ring_command_buffer) {
+        vulkan_buffer* ring_buffer = (vulkan_buffer*)context.staging_ring.buffer.internal_data;
+        kcopy_memory(vulkan_memory_map(&ring_buffer->allocation, staging_offset), pixels, size);
+        texture_data_copy(t, ring_command_buffer, ring_buffer->handle, staging_offset, data_level_count);
+        texture_data_finish(t, ring_command_buffer, data_level_count);
+        t->generation++;
+        return;
+    }
+
+    // Create a staging buffer and load data into it.
+    renderbuffer staging;
+    if (!renderer_renderbuffer_create(RENDERBUFFER_TYPE_STAGING, size, false, &staging)) {
+        KERROR("Failed to create staging buffer for texture write.");
+        return;
+    }
+    renderer_renderbuffer_bind(&staging, 0);
+
+    vulkan_buffer_load_range(&staging, 0, size, pixels);
+
+    // Anything already in the ring may write to this image, so must go first.
+    staging_ring_flush();
+
+    vulkan_command_buffer temp_buffer;
+    VkCommandPool pool = context.device.graphics_command_pool;
+    VkQueue queue = context.device.graphics_queue;
+    vulkan_command_buffer_allocate_and_begin_single_use(&context, pool, &temp_buffer);
+    texture_data_copy(t, &temp_buffer, ((vulkan_buffer*)staging.internal_data)->handle, 0, data_level_count);
+    texture_data_finish(t, &temp_buffer, data_level_count);
+    single_use_submit(&temp_buffer, pool, queue);
+
+    renderer_renderbuffer_unbind(&staging);
+    renderer_renderbuffer_destroy(&staging);
+
+    t->generation++;
+}
+
+// Creates the image of a texture to be uploaded, returning the size of the levels its data holds, and how many it holds.
+static u64 texture_image_create(texture* t, u32* out_data_level_count) {
+    // Internal data creation.
+    // TODO: Use an allocator for this.
+    t->internal_data = (vulkan_image*)kallocate(sizeof(vulkan_image), MEMORY_TAG_TEXTURE);
+    vulkan_image* image = (vulkan_image*)t->internal_data;
+    counter_add(context.textures_resident_counter, 1);
+    VkFormat image_format = vulkan_texture_format_to_vk(t->format, t->channel_count);
+
+    // Levels given in the data are uploaded as they are. Given only the first, the rest of the chain
+    // is generated where the format can be blitted, which compressed formats can not.
+    u32 chain_length = mip_chain_length(t->width, t->height);
+    u32 data_level_count = KMIN(KMAX(t->mip_levels, 1), chain_length);
+    u32 mip_levels = data_level_count;
+    if (data_level_count == 1 && format_can_generate_mips(image_format)) {
+        mip_levels = chain_length;
+    }
+
+    u64 size = 0;
+    for (u32 i = 0; i < data_level_count; ++i) {
+        size += texture_format_size(t->format, KMAX(t->width >> i, 1), KMAX(t->height >> i, 1), t->channel_count);
+    }
+    size *= t->type == TEXTURE_TYPE_CUBE ? 6 : 1;
+
+    // Compressed images can only be written by copies, not rendered to.
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (t->format == TEXTURE_FORMAT_UNCOMPRESSED) {
+        usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    }
+
+    // NOTE: Lots of assumptions here, different texture types will require
     // different options here.
     vulkan_image_create(
         &context,
         t->type,
         t->width,
         t->height,
+        mip_levels,
         image_format,
         VK_IMAGE_TILING_OPTIMAL,
-        VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+        usage,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
         true,
         VK_IMAGE_ASPECT_COLOR_BIT,
         image);
+    t->mip_levels = mip_levels;
+    *out_data_level_count = data_level_count;
+    return size;
+}
+
+void vulkan_renderer_texture_create(const u8* pixels, texture* t) {
+    u32 data_level_count;
+    u64 size = texture_image_create(t, &data_level_count);
 
     // Load the data.
-    vulkan_renderer_texture_write_data(t, 0, size, pixels);
+    texture_data_upload(t, (u32)size, pixels, data_level_count, true);
 
     t->generation++;
 }
 
-void vulkan_renderer_texture_destroy(struct texture* texture) {
-    vkDeviceWaitIdle(context.device.logical_device);
+// As texture_data_upload, for a new image, copying from a staging buffer holding the pixels already, which is taken.
+static void texture_data_upload_staged(texture* t, u32 size, renderbuffer* staging, u32 data_level_count) {
+    counter_add(context.staged_uploads_counter, 1);
+    counter_add(context.staged_bytes_counter, size);
+
+    b8 separate_transfer_family = context.device.transfer_queue_index != context.device.graphics_queue_index;
+    if (separate_transfer_family && size >= VULKAN_TRANSFER_UPLOAD_MIN_SIZE && texture_data_transfer(t, size, 0, staging, data_level_count)) {
+        kzero_memory(staging, sizeof(renderbuffer));
+        t->generation++;
+        return;
+    }
+
+    // Otherwise the copies run with the ring's, ahead of the next frame. None of the ring itself is taken.
+    u64 staging_offset;
+    VkBuffer source = ((vulkan_buffer*)staging->internal_data)->handle;
+    vulkan_command_buffer* ring_command_buffer = staging_ring_begin(0, &staging_offset);
+    if (ring_command_buffer) {
+        texture_data_copy(t, ring_command_buffer, source, 0, data_level_count);
+        texture_data_finish(t, ring_command_buffer, data_level_count);
+    } else {
+        vulkan_command_buffer temp_buffer;
+        VkCommandPool pool = context.device.graphics_command_pool;
+        vulkan_command_buffer_allocate_and_begin_single_use(&context, pool, &temp_buffer);
+        texture_data_copy(t, &temp_buffer, source, 0, data_level_count);
+        texture_data_finish(t, &temp_buffer, data_level_count);
+        single_use_submit(&temp_buffer, pool, context.device.graphics_queue);
+    }
+
+    // Destroyed once the frame the copies run ahead of completes.
+    renderer_renderbuffer_unbind(staging);
+    renderer_renderbuffer_destroy(staging);
+    t->generation++;
+}
+
+void vulkan_renderer_texture_create_staged(renderbuffer* staging, texture* t) {
+    u32 data_level_count;
+    u64 size = texture_image_create(t, &data_level_count);
+
+    // Load the data, from where it already is.
+    texture_data_upload_staged(t, (u32)size, staging, data_level_count);
+
+    t->generation++;
+}
+
+b8 vulkan_renderer_texture_format_supported(texture_format format) {
+    return format < TEXTURE_FORMAT_COUNT && context.device.texture_format_support[format];
+}
 
+void vulkan_renderer_texture_destroy(struct texture* texture) {
     vulkan_image* image = (vulkan_image*)texture->internal_data;
     if (image) {
-        vulkan_image_destroy(&context, image);
+        // Frames in flight, and uploads staged for the next frame, may still refer to the image.
+        vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_IMAGE};
+        deletion.image = *image;
+        deferred_delete(&deletion);
         kzero_memory(image, sizeof(vulkan_image));
 
         kfree(texture->internal_data, sizeof(vulkan_image), MEMORY_TAG_TEXTURE);
+        counter_add(context.textures_resident_counter, -1);
     }
     kzero_memory(texture, sizeof(struct texture));
 }
 
-VkFormat channel_count_to_format(u8 channel_count, VkFormat default_format) {
-    switch (channel_count) {
-        case 1:
-            return VK_FORMAT_R8_UNORM;
-        case 2:
-            return VK_FORMAT_R8G8_UNORM;
-        case 3:
-            return VK_FORMAT_R8G8B8_UNORM;
-        case 4:
-            return VK_FORMAT_R8G8B8A8_UNORM;
-        default:
-            return default_format;
+// Gets the usage of a writeable colour texture, adding storage if it is flagged as such and its format
+// allows it. The flag is cleared where the format does not.
+static VkImageUsageFlags writeable_usage_get(texture* t, VkFormat format) {
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    if (t->flags & TEXTURE_FLAG_IS_STORAGE) {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(context.device.physical_device, format, &properties);
+        if (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT) {
+            usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+        } else {
+            KERROR("The format of texture '%s' can't be used for storage images, so it can't be bound as one.", t->name);
+            t->flags &= ~TEXTURE_FLAG_IS_STORAGE;
+        }
+    }
+    return usage;
+}
+
+// Moves the newly-created image of a storage texture to the general layout it is kept in.
+static void storage_texture_layout_set(texture* t, VkFormat format) {
+    vulkan_command_buffer temp_buffer;
+    VkCommandPool pool = context.device.graphics_command_pool;
+    vulkan_command_buffer_allocate_and_begin_single_use(&context, pool, &temp_buffer);
+    vulkan_image_transition_layout(&context, t->type, &temp_buffer, (vulkan_image*)t->internal_data, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+    single_use_submit(&temp_buffer, pool, context.device.graphics_queue);
+}
+
+// The memory properties of an attachment whose contents never leave the pass rendering to it.
+// Lazily-allocated memory, where the device has it, need never be backed outside of on-chip storage.
+static VkMemoryPropertyFlags transient_memory_flags_get(void) {
+    VkMemoryPropertyFlags lazy = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+    for (u32 i = 0; i < context.device.memory.memoryTypeCount; ++i) {
+        if ((context.device.memory.memoryTypes[i].propertyFlags & lazy) == lazy) {
+            return lazy;
+        }
     }
+    return VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 }
 
 void vulkan_renderer_texture_create_writeable(texture* t) {
     // Internal data creation.
     t->internal_data = (vulkan_image*)kallocate(sizeof(vulkan_image), MEMORY_TAG_TEXTURE);
     vulkan_image* image = (vulkan_image*)t->internal_data;
+    counter_add(context.textures_resident_counter, 1);
 
-    VkImageUsageFlagBits usage;
+    VkImageUsageFlags usage;
     VkImageAspectFlagBits aspect;
     VkFormat image_format;
     if (t->flags & TEXTURE_FLAG_DEPTH) {
         usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
         aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
         image_format = context.device.depth_format;
+        t->flags &= ~TEXTURE_FLAG_IS_STORAGE;
     } else {
-        usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        image_format = vulkan_texture_format_to_vk(t->format, t->channel_count);
+        usage = writeable_usage_get(t, image_format);
         aspect = VK_IMAGE_ASPECT_COLOR_BIT;
-        image_format = channel_count_to_format(t->channel_count, VK_FORMAT_R8G8B8A8_UNORM);
     }
 
-    vulkan_image_create(&context, t->type, t->width, t->height, image_format, VK_IMAGE_TILING_OPTIMAL, usage,
-                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true, aspect, image);
+    VkMemoryPropertyFlags memory_flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    if (t->flags & TEXTURE_FLAG_TRANSIENT) {
+        // Only ever rendered to within a pass, so never copied, sampled or stored.
+        usage = (t->flags & TEXTURE_FLAG_DEPTH) ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+        memory_flags = transient_memory_flags_get();
+        t->flags &= ~TEXTURE_FLAG_IS_STORAGE;
+    }
+
+    vulkan_image_create(&context, t->type, t->width, t->height, 1, image_format, VK_IMAGE_TILING_OPTIMAL, usage,
+                        memory_flags, true, aspect, image);
+    if (t->flags & TEXTURE_FLAG_IS_STORAGE) {
+        storage_texture_layout_set(t, image_format);
+    }
 
     t->generation++;
 }
@@ -991,9 +2375,12 @@ void vulkan_renderer_texture_resize(texture* t, u32 new_width, u32 new_height) {
         // Data is not preserved because there's no reliable way to map the old data to the new
         // since the amount of data differs.
         vulkan_image* image = (vulkan_image*)t->internal_data;
-        vulkan_image_destroy(&context, image);
+        vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_IMAGE};
+        deletion.image = *image;
+        deferred_delete(&deletion);
+        kzero_memory(image, sizeof(vulkan_image));
 
-        VkFormat image_format = channel_count_to_format(t->channel_count, VK_FORMAT_R8G8B8A8_UNORM);
+        VkFormat image_format = vulkan_texture_format_to_vk(t->format, t->channel_count);
 
         // TODO: Lots of assumptions here, different texture types will require
         // different options here.
@@ -1002,65 +2389,71 @@ void vulkan_renderer_texture_resize(texture* t, u32 new_width, u32 new_height) {
             t->type,
             new_width,
             new_height,
+            1,
             image_format,
             VK_IMAGE_TILING_OPTIMAL,
-            VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+            writeable_usage_get(t, image_format),
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
             true,
             VK_IMAGE_ASPECT_COLOR_BIT,
             image);
+        if (t->flags & TEXTURE_FLAG_IS_STORAGE) {
+            storage_texture_layout_set(t, image_format);
+        }
 
         t->generation++;
     }
 }
 
 void vulkan_renderer_texture_write_data(texture* t, u32 offset, u32 size, const u8* pixels) {
+    texture_data_upload(t, size, pixels, 1, false);
+}
+
+// Records the copy of a rectangle into an image already read by shaders, keeping the rest of it.
+static void texture_region_copy(texture* t, vulkan_command_buffer* command_buffer, VkBuffer source, u64 source_offset, u32 x, u32 y, u32 width, u32 height) {
     vulkan_image* image = (vulkan_image*)t->internal_data;
+    VkFormat image_format = vulkan_texture_format_to_vk(t->format, t->channel_count);
+    vulkan_image_transition_layout(&context, t->type, command_buffer, image, image_format, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    vulkan_image_copy_region_from_buffer(&context, image, source, source_offset, x, y, width, height, command_buffer);
+    vulkan_image_transition_layout(&context, t->type, command_buffer, image, image_format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
 
-    VkFormat image_format = channel_count_to_format(t->channel_count, VK_FORMAT_R8G8B8A8_UNORM);
+void vulkan_renderer_texture_write_region(texture* t, u32 x, u32 y, u32 width, u32 height, const u8* pixels) {
+    u32 size = (u32)texture_format_size(t->format, width, height, t->channel_count);
+    counter_add(context.staged_uploads_counter, 1);
+    counter_add(context.staged_bytes_counter, size);
+
+    u64 staging_offset;
+    vulkan_command_buffer* ring_command_buffer = staging_ring_begin(size, &staging_offset);
+    if (ring_command_buffer) {
+        vulkan_buffer* ring_buffer = (vulkan_buffer*)context.staging_ring.buffer.internal_data;
+        kcopy_memory(vulkan_memory_map(&ring_buffer->allocation, staging_offset), pixels, size);
+        texture_region_copy(t, ring_command_buffer, ring_buffer->handle, staging_offset, x, y, width, height);
+        t->generation++;
+        return;
+    }
 
-    // Create a staging buffer and load data into it.
+    // Too large for the ring, so staged on its own.
     renderbuffer staging;
     if (!renderer_renderbuffer_create(RENDERBUFFER_TYPE_STAGING, size, false, &staging)) {
-        KERROR("Failed to create staging buffer for texture write.");
+        KERROR("Failed to create staging buffer for texture region write.");
         return;
     }
     renderer_renderbuffer_bind(&staging, 0);
-
     vulkan_buffer_load_range(&staging, 0, size, pixels);
 
+    // Anything already in the ring may write to this image, so must go first.
+    staging_ring_flush();
+
     vulkan_command_buffer temp_buffer;
     VkCommandPool pool = context.device.graphics_command_pool;
     VkQueue queue = context.device.graphics_queue;
     vulkan_command_buffer_allocate_and_begin_single_use(&context, pool, &temp_buffer);
+    texture_region_copy(t, &temp_buffer, ((vulkan_buffer*)staging.internal_data)->handle, 0, x, y, width, height);
+    single_use_submit(&temp_buffer, pool, queue);
 
-    // Transition the layout from whatever it is currently to optimal for recieving data.
-    vulkan_image_transition_layout(
-        &context,
-        t->type,
-        &temp_buffer,
-        image,
-        image_format,
-        VK_IMAGE_LAYOUT_UNDEFINED,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-    // Copy the data from the buffer.
-    vulkan_image_copy_from_buffer(&context, t->type, image, ((vulkan_buffer*)staging.internal_data)->handle, &temp_buffer);
-
-    // Transition from optimal for data reciept to shader-read-only optimal layout.
-    vulkan_image_transition_layout(
-        &context,
-        t->type,
-        &temp_buffer,
-        image,
-        image_format,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-    vulkan_command_buffer_end_single_use(&context, pool, &temp_buffer, queue);
-
-    renderer_renderbuffer_unbind(&staging);
-    renderer_renderbuffer_destroy(&staging);
+    renderer_renderbuffer_unbind(&staging);
+    renderer_renderbuffer_destroy(&staging);
 
     t->generation++;
 }
@@ -1068,7 +2461,10 @@ void vulkan_renderer_texture_write_data(texture* t, u32 offset, u32 size, const
 void vulkan_renderer_texture_read_data(texture* t, u32 offset, u32 size, void** out_memory) {
     vulkan_image* image = (vulkan_image*)t->internal_data;
 
-    VkFormat image_format = channel_count_to_format(t->channel_count, VK_FORMAT_R8G8B8A8_UNORM);
+    // Uploads staged for the next frame may write to the image, so must be seen first.
+    staging_ring_flush();
+
+    VkFormat image_format = vulkan_texture_format_to_vk(t->format, t->channel_count);
 
     // Create a staging buffer and load data into it.
     renderbuffer staging;
@@ -1120,7 +2516,10 @@ void vulkan_renderer_texture_read_data(texture* t, u32 offset, u32 size, void**
 void vulkan_renderer_texture_read_pixel(texture* t, u32 x, u32 y, u8** out_rgba) {
     vulkan_image* image = (vulkan_image*)t->internal_data;
 
-    VkFormat image_format = channel_count_to_format(t->channel_count, VK_FORMAT_R8G8B8A8_UNORM);
+    // Uploads staged for the next frame may write to the image, so must be seen first.
+    staging_ring_flush();
+
+    VkFormat image_format = vulkan_texture_format_to_vk(t->format, t->channel_count);
 
     // TODO: creating a buffer every time isn't great. Could optimize this by creating a buffer once
     // and just reusing it.
@@ -1151,7 +2550,7 @@ void vulkan_renderer_texture_read_pixel(texture* t, u32 x, u32 y, u8** out_rgba)
 
     // Copy the data to the buffer.
     // vulkan_image_copy_to_buffer(&context, t->type, image, ((vulkan_buffer*)staging.internal_data)->handle, &temp_buffer);
-    vulkan_image_copy_pixel_to_buffer(&context, t->type, image, ((vulkan_buffer*)staging.internal_data)->handle, x, y, &temp_buffer);
+    vulkan_image_copy_pixel_to_buffer(&context, t->type, image, ((vulkan_buffer*)staging.internal_data)->handle, 0, x, y, &temp_buffer);
 
     // Transition from optimal for data reading to shader-read-only optimal layout.
     vulkan_image_transition_layout(
@@ -1173,33 +2572,684 @@ void vulkan_renderer_texture_read_pixel(texture* t, u32 x, u32 y, u8** out_rgba)
     renderer_renderbuffer_destroy(&staging);
 }
 
+b8 vulkan_renderer_texture_read_pixel_async(texture* t, u32 x, u32 y, u8* out_rgba) {
+    vulkan_pixel_readback* readback = &context.pixel_readback;
+    u32 frame = context.current_frame;
+    u64 slot_offset = sizeof(u8) * 4 * frame;
+
+    // This frame was waited for as it began, so the copy made the last time it was in flight has landed.
+    b8 has_result = readback->serials[frame] && readback->serials[frame] <= context.frames_completed;
+    if (has_result) {
+        kcopy_memory(out_rgba, readback->mapped + slot_offset, sizeof(u8) * 4);
+    }
+
+    vulkan_image* image = (vulkan_image*)t->internal_data;
+    vulkan_command_buffer* command_buffer = &context.graphics_command_buffers[context.image_index];
+
+    // The texture is read where the pass rendering to it left it, and put back for the next.
+    VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image->handle;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer->handle, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, 0, 0, 0, 1, &barrier);
+
+    vulkan_image_copy_pixel_to_buffer(&context, t->type, image, ((vulkan_buffer*)readback->buffer.internal_data)->handle, slot_offset, x, y, command_buffer);
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    VkBufferMemoryBarrier host_barrier = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+    host_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    host_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    host_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    host_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    host_barrier.buffer = ((vulkan_buffer*)readback->buffer.internal_data)->handle;
+    host_barrier.offset = slot_offset;
+    host_barrier.size = sizeof(u8) * 4;
+    vkCmdPipelineBarrier(command_buffer->handle, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0, 0, 0, 0, 1, &barrier);
+    vkCmdPipelineBarrier(command_buffer->handle, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, 0, 1, &host_barrier, 0, 0);
+
+    // Lands once the frame being recorded, the next to be submitted, completes.
+    readback->serials[frame] = context.frame_serial + 1;
+    return has_result;
+}
+
+// The index buffer of the given geometry block holding indices of the given size.
+static renderbuffer* geometry_index_buffer_get(u32 block, u32 index_size) {
+    vulkan_geometry_block* geometry_block = &context.geometry_blocks[block];
+    return index_size == sizeof(u16) ? &geometry_block->index_buffer_16 : &geometry_block->index_buffer;
+}
+
+// Indicates if the given buffer is the 16-bit index buffer of a geometry block.
+static b8 geometry_index_buffer_is_16(const renderbuffer* buffer) {
+    for (u32 i = 0; i < VULKAN_MAX_GEOMETRY_BLOCKS; ++i) {
+        if (buffer == &context.geometry_blocks[i].index_buffer_16) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Creates a geometry block in a free slot of the heap, with buffers of their usual sizes, or of the given
+// ones where larger. Returns the index of the block, or INVALID_ID if it cannot be created.
+static b8 vertex_sets_create() {
+    VkDescriptorSetLayoutBinding binding = {0};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    binding.descriptorCount = 1;
+    // Also written by the skinning shader.
+    binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+    VkDescriptorSetLayoutCreateInfo layout_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    layout_info.bindingCount = 1;
+    layout_info.pBindings = &binding;
+    VkResult result = vkCreateDescriptorSetLayout(context.device.logical_device, &layout_info, context.allocator, &context.vertex_set_layout);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("Failed to create the vertex set layout: '%s'", vulkan_result_string(result, true));
+        return false;
+    }
+
+    // Room for the sets of destroyed blocks to wait out the frames in flight alongside those of their replacements.
+    VkDescriptorPoolSize pool_size = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VULKAN_MAX_GEOMETRY_BLOCKS * 2};
+    VkDescriptorPoolCreateInfo pool_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+    pool_info.maxSets = VULKAN_MAX_GEOMETRY_BLOCKS * 2;
+    pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    result = vkCreateDescriptorPool(context.device.logical_device, &pool_info, context.allocator, &context.vertex_set_pool);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("Failed to create the vertex set pool: '%s'", vulkan_result_string(result, true));
+        return false;
+    }
+    return true;
+}
+
+// Destroyed after the sets of the geometry blocks are freed, which may be waiting on frames in flight.
+static void vertex_sets_destroy() {
+    if (context.vertex_set_pool) {
+        vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_DESCRIPTOR_POOL};
+        deletion.descriptor_pool = context.vertex_set_pool;
+        deferred_delete(&deletion);
+        context.vertex_set_pool = 0;
+    }
+    if (context.vertex_set_layout) {
+        vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_DESCRIPTOR_SET_LAYOUT};
+        deletion.descriptor_set_layout = context.vertex_set_layout;
+        deferred_delete(&deletion);
+        context.vertex_set_layout = 0;
+    }
+}
+
+static u32 geometry_block_create(u64 min_vertex_size, u64 min_index_size, u64 min_index_16_size) {
+    u32 index = INVALID_ID;
+    for (u32 i = 0; i < VULKAN_MAX_GEOMETRY_BLOCKS; ++i) {
+        if (!context.geometry_blocks[i].vertex_buffer.internal_data) {
+            index = i;
+            break;
+        }
+    }
+    if (index == INVALID_ID) {
+        KERROR("The geometry heap has no room for another block. Increase VULKAN_MAX_GEOMETRY_BLOCKS.");
+        return INVALID_ID;
+    }
+
+    // An index buffer for each index size, as an index buffer is read with a single index type. Most
+    // geometries have few enough vertices for 16-bit indices, so that one holds more.
+    vulkan_geometry_block* block = &context.geometry_blocks[index];
+    renderbuffer* buffers[3] = {&block->vertex_buffer, &block->index_buffer, &block->index_buffer_16};
+    u64 sizes[3] = {
+        KMAX(VULKAN_GEOMETRY_BLOCK_VERTEX_BUFFER_SIZE, min_vertex_size),
+        KMAX(VULKAN_GEOMETRY_BLOCK_INDEX_BUFFER_SIZE, min_index_size),
+        KMAX(VULKAN_GEOMETRY_BLOCK_INDEX_BUFFER_16_SIZE, min_index_16_size)};
+    for (u32 i = 0; i < 3; ++i) {
+        if (!renderer_renderbuffer_create(i == 0 ? RENDERBUFFER_TYPE_VERTEX : RENDERBUFFER_TYPE_INDEX, sizes[i], true, buffers[i])) {
+            KERROR("Failed to create the buffers of geometry block %u.", index);
+            for (u32 j = 0; j < i; ++j) {
+                renderer_renderbuffer_destroy(buffers[j]);
+            }
+            kzero_memory(block, sizeof(vulkan_geometry_block));
+            return INVALID_ID;
+        }
+        renderer_renderbuffer_bind(buffers[i], 0);
+    }
+
+    // Shaders pulling their vertices read the vertex buffer through a set of its own.
+    VkDescriptorSetAllocateInfo alloc_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    alloc_info.descriptorPool = context.vertex_set_pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &context.vertex_set_layout;
+    VkResult result = vkAllocateDescriptorSets(context.device.logical_device, &alloc_info, &block->vertex_set);
+    if (vulkan_result_is_success(result)) {
+        VkDescriptorBufferInfo buffer_info;
+        buffer_info.buffer = ((vulkan_buffer*)block->vertex_buffer.internal_data)->handle;
+        buffer_info.offset = 0;
+        buffer_info.range = VK_WHOLE_SIZE;
+        VkWriteDescriptorSet write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+        write.dstSet = block->vertex_set;
+        write.dstBinding = 0;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.descriptorCount = 1;
+        write.pBufferInfo = &buffer_info;
+        vkUpdateDescriptorSets(context.device.logical_device, 1, &write, 0, 0);
+    } else {
+        KWARN("Failed to allocate the vertex set of geometry block %u, which cannot be drawn by shaders pulling their vertices: '%s'", index, vulkan_result_string(result, true));
+        block->vertex_set = VK_NULL_HANDLE;
+    }
+
+    context.geometry_block_count++;
+    counter_add(context.geometry_blocks_counter, 1);
+    return index;
+}
+
+// Destroys the given geometry block, if it is in use. Frames in flight may still be drawing from its buffers,
+// which are deleted once they are finished.
+static void geometry_block_destroy(u32 index) {
+    vulkan_geometry_block* block = &context.geometry_blocks[index];
+    if (!block->vertex_buffer.internal_data) {
+        return;
+    }
+    renderer_renderbuffer_destroy(&block->vertex_buffer);
+    renderer_renderbuffer_destroy(&block->index_buffer);
+    renderer_renderbuffer_destroy(&block->index_buffer_16);
+    if (block->vertex_set) {
+        vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_DESCRIPTOR_SETS};
+        deletion.descriptor_sets.pool = context.vertex_set_pool;
+        deletion.descriptor_sets.count = 1;
+        deletion.descriptor_sets.sets[0] = block->vertex_set;
+        deferred_delete(&deletion);
+    }
+    kzero_memory(block, sizeof(vulkan_geometry_block));
+    context.geometry_block_count--;
+    counter_add(context.geometry_blocks_counter, -1);
+}
+
+// The fraction of the given geometry block which is allocated, from 0 to 1.
+static f32 geometry_block_use(vulkan_geometry_block* block) {
+    u64 total = block->vertex_buffer.total_size + block->index_buffer.total_size + block->index_buffer_16.total_size;
+    u64 free = freelist_free_space(&block->vertex_buffer.buffer_freelist) +
+               freelist_free_space(&block->index_buffer.buffer_freelist) +
+               freelist_free_space(&block->index_buffer_16.buffer_freelist);
+    return (f32)(total - free) / (f32)total;
+}
+
+// Allocates the vertex range and, if it is indexed, the index range of the given geometry range from the
+// given block, filling in the block and offsets. Returns false, allocating nothing, if the block lacks room.
+static b8 geometry_block_allocate(u32 index, vulkan_geometry_data* range) {
+    vulkan_geometry_block* block = &context.geometry_blocks[index];
+    u64 index_data_size = (u64)range->index_count * range->index_element_size;
+    renderbuffer* index_buffer = index_data_size ? geometry_index_buffer_get(index, range->index_element_size) : 0;
+    // Blocks too full are passed over without trying them, which would warn.
+    if (freelist_free_space(&block->vertex_buffer.buffer_freelist) < range->vertex_allocation_size ||
+        (index_buffer && freelist_free_space(&index_buffer->buffer_freelist) < index_data_size)) {
+        return false;
+    }
+    if (!renderer_renderbuffer_allocate(&block->vertex_buffer, range->vertex_allocation_size, &range->vertex_allocation_offset)) {
+        return false;
+    }
+    if (index_buffer && !renderer_renderbuffer_allocate(index_buffer, index_data_size, &range->index_buffer_offset)) {
+        renderer_renderbuffer_free(&block->vertex_buffer, range->vertex_allocation_size, range->vertex_allocation_offset);
+        return false;
+    }
+    // The vertices start at a multiple of their size, so that batched draws can address them by vertex
+    // offset from the start of the buffer.
+    u32 vertex_size = range->vertex_element_size;
+    range->vertex_buffer_offset = ((range->vertex_allocation_offset + vertex_size - 1) / vertex_size) * vertex_size;
+    range->block = index;
+    return true;
+}
+
+// Allocates the ranges of the given geometry range from the first geometry block with room for them, passing
+// over the one given to skip, which may be INVALID_ID. If none has room and chain is set, the skipped block is
+// tried after all, then another block is chained to the heap for them. Returns false if there is nowhere for them.
+static b8 geometry_ranges_allocate(vulkan_geometry_data* range, u32 skip_block, b8 chain) {
+    for (u32 i = 0; i < VULKAN_MAX_GEOMETRY_BLOCKS; ++i) {
+        if (i != skip_block && context.geometry_blocks[i].vertex_buffer.internal_data && geometry_block_allocate(i, range)) {
+            return true;
+        }
+    }
+    if (!chain) {
+        return false;
+    }
+    if (skip_block != INVALID_ID && geometry_block_allocate(skip_block, range)) {
+        return true;
+    }
+    // Chained rather than resizing a full block, which would have to wait for the device to be idle.
+    u64 index_data_size = (u64)range->index_count * range->index_element_size;
+    u32 block = geometry_block_create(
+        range->vertex_allocation_size,
+        range->index_element_size == sizeof(u32) ? index_data_size : 0,
+        range->index_element_size == sizeof(u16) ? index_data_size : 0);
+    return block != INVALID_ID && geometry_block_allocate(block, range);
+}
+
+// Frees the ranges of a geometry once the frames in flight, which may be drawing it, are finished.
+static void geometry_ranges_free(const vulkan_geometry_data* internal_data) {
+    vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_RANGE};
+    deletion.range.buffer = &context.geometry_blocks[internal_data->block].vertex_buffer;
+    deletion.range.size = internal_data->vertex_allocation_size;
+    deletion.range.offset = internal_data->vertex_allocation_offset;
+    deferred_delete(&deletion);
+
+    // Index data, if applicable
+    if (internal_data->index_element_size > 0) {
+        deletion.range.buffer = geometry_index_buffer_get(internal_data->block, internal_data->index_element_size);
+        deletion.range.size = internal_data->index_element_size * internal_data->index_count;
+        deletion.range.offset = internal_data->index_buffer_offset;
+        deferred_delete(&deletion);
+    }
+}
+
+// Gives the geometry the given ranges, freeing those it had if asked to.
+static void geometry_range_apply(vulkan_geometry_data* internal_data, const vulkan_geometry_data* range, b8 free_old) {
+    if (free_old) {
+        geometry_ranges_free(internal_data);
+    }
+    internal_data->vertex_count = range->vertex_count;
+    internal_data->vertex_element_size = range->vertex_element_size;
+    internal_data->block = range->block;
+    internal_data->vertex_buffer_offset = range->vertex_buffer_offset;
+    internal_data->vertex_allocation_offset = range->vertex_allocation_offset;
+    internal_data->vertex_allocation_size = range->vertex_allocation_size;
+    internal_data->index_count = range->index_count;
+    internal_data->index_element_size = range->index_element_size;
+    internal_data->index_buffer_offset = range->index_buffer_offset;
+}
+
+static b8 upload_batches_create() {
+    // Batches signal the transfer timeline where supported, rather than fences and semaphores of their own.
+    if (context.device.supports_timeline_semaphores) {
+        context.transfer_timeline = timeline_semaphore_create();
+    }
+    VkFenceCreateInfo fence_info = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+    for (u32 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
+        vulkan_upload_batch* batch = &context.upload_batches[i];
+        if (context.transfer_timeline) {
+            vulkan_command_buffer_allocate(&context, context.device.transfer_command_pool, true, &batch->command_buffer);
+            continue;
+        }
+        VkResult result = vkCreateFence(context.device.logical_device, &fence_info, context.allocator, &batch->fence);
+        if (!vulkan_result_is_success(result)) {
+            KERROR("Unable to create a geometry upload fence: '%s'.", vulkan_result_string(result, true));
+            return false;
+        }
+        VkSemaphoreCreateInfo semaphore_info = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+        result = vkCreateSemaphore(context.device.logical_device, &semaphore_info, context.allocator, &batch->semaphore);
+        if (!vulkan_result_is_success(result)) {
+            KERROR("Unable to create a geometry upload semaphore: '%s'.", vulkan_result_string(result, true));
+            return false;
+        }
+        vulkan_command_buffer_allocate(&context, context.device.transfer_command_pool, true, &batch->command_buffer);
+    }
+    return true;
+}
+
+static void upload_batches_destroy() {
+    for (u32 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
+        vulkan_upload_batch* batch = &context.upload_batches[i];
+        if (batch->command_buffer.handle) {
+            vulkan_command_buffer_free(&context, context.device.transfer_command_pool, &batch->command_buffer);
+        }
+        if (batch->acquire_command_buffer.handle) {
+            vulkan_command_buffer_free(&context, context.device.graphics_command_pool, &batch->acquire_command_buffer);
+        }
+        if (batch->fence) {
+            vkDestroyFence(context.device.logical_device, batch->fence, context.allocator);
+        }
+        if (batch->semaphore) {
+            vkDestroySemaphore(context.device.logical_device, batch->semaphore, context.allocator);
+        }
+        kzero_memory(batch, sizeof(vulkan_upload_batch));
+    }
+    if (context.transfer_timeline) {
+        vkDestroySemaphore(context.device.logical_device, context.transfer_timeline, context.allocator);
+        context.transfer_timeline = 0;
+    }
+}
+
+// Waits for the copies the batch last submitted to complete. A timeout of 0 only checks, returning
+// VK_NOT_READY or VK_TIMEOUT if they have not.
+static VkResult upload_batch_wait(vulkan_upload_batch* batch, u64 timeout) {
+    if (context.transfer_timeline) {
+        return timeline_wait(context.transfer_timeline, batch->timeline_value, timeout);
+    }
+    if (!timeout) {
+        return vkGetFenceStatus(context.device.logical_device, batch->fence);
+    }
+    return vkWaitForFences(context.device.logical_device, 1, &batch->fence, true, timeout);
+}
+
+// Gets the current frame's upload batch, ready to record copies into, or 0 if there is none.
+static vulkan_upload_batch* upload_batch_begin() {
+    vulkan_upload_batch* batch = &context.upload_batches[context.current_frame];
+    if (!batch->command_buffer.handle) {
+        return 0;
+    }
+    if (batch->submitted) {
+        // Still in flight from two frames ago, which is about to be waited on anyway.
+        VkResult result = upload_batch_wait(batch, UINT64_MAX);
+        if (!vulkan_result_is_success(result)) {
+            KWARN("Geometry upload batch wait failed: '%s'.", vulkan_result_string(result, true));
+            return 0;
+        }
+        geometry_uploads_update(false);
+    }
+    if (!batch->recording) {
+        vulkan_command_buffer_begin(&batch->command_buffer, true, false, false);
+        batch->recording = true;
+    }
+    return batch;
+}
+
+// Submits the copies of every batch being recorded, one submission each, followed on the graphics
+// queue by the acquisition of any images they upload.
+static void upload_batches_submit() {
+    for (u32 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
+        vulkan_upload_batch* batch = &context.upload_batches[i];
+        if (!batch->recording) {
+            continue;
+        }
+        vulkan_command_buffer_end(&batch->command_buffer);
+        batch->recording = false;
+        b8 acquiring = batch->acquire_command_buffer.handle != 0;
+
+        VkSubmitInfo submit_info = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers = &batch->command_buffer.handle;
+        uint64_t timeline_value = context.transfer_timeline_value + 1;
+        VkTimelineSemaphoreSubmitInfo timeline_info = {VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+        if (context.transfer_timeline) {
+            timeline_info.signalSemaphoreValueCount = 1;
+            timeline_info.pSignalSemaphoreValues = &timeline_value;
+            submit_info.pNext = &timeline_info;
+            submit_info.signalSemaphoreCount = 1;
+            submit_info.pSignalSemaphores = &context.transfer_timeline;
+        } else {
+            submit_info.signalSemaphoreCount = acquiring ? 1 : 0;
+            submit_info.pSignalSemaphores = &batch->semaphore;
+        }
+        VkResult result = vkQueueSubmit(context.device.transfer_queue, 1, &submit_info, batch->fence);
+        if (!vulkan_result_is_success(result)) {
+            KERROR("Unable to submit uploads: '%s'.", vulkan_result_string(result, true));
+            if (acquiring) {
+                vulkan_command_buffer_end(&batch->acquire_command_buffer);
+                vulkan_command_buffer_free(&context, context.device.graphics_command_pool, &batch->acquire_command_buffer);
+            }
+            continue;
+        }
+        vulkan_command_buffer_update_submitted(&batch->command_buffer);
+        batch->submitted = true;
+        if (context.transfer_timeline) {
+            context.transfer_timeline_value = timeline_value;
+            batch->timeline_value = timeline_value;
+        }
+
+        if (acquiring) {
+            // Anything submitted to the graphics queue after this is ordered after the acquisitions.
+            vulkan_command_buffer_end(&batch->acquire_command_buffer);
+            VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            VkSubmitInfo acquire_info = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+            VkTimelineSemaphoreSubmitInfo acquire_timeline_info = {VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+            acquire_timeline_info.waitSemaphoreValueCount = 1;
+            acquire_timeline_info.pWaitSemaphoreValues = &batch->timeline_value;
+            if (context.transfer_timeline) {
+                acquire_info.pNext = &acquire_timeline_info;
+            }
+            acquire_info.waitSemaphoreCount = 1;
+            acquire_info.pWaitSemaphores = context.transfer_timeline ? &context.transfer_timeline : &batch->semaphore;
+            acquire_info.pWaitDstStageMask = &wait_stage;
+            acquire_info.commandBufferCount = 1;
+            acquire_info.pCommandBuffers = &batch->acquire_command_buffer.handle;
+            VK_CHECK(vkQueueSubmit(context.device.graphics_queue, 1, &acquire_info, 0));
+            vulkan_command_buffer_update_submitted(&batch->acquire_command_buffer);
+
+            // Freed once the frame being recorded, which follows it on the queue, completes.
+            vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_COMMAND_BUFFER};
+            deletion.command_buffer.pool = context.device.graphics_command_pool;
+            deletion.command_buffer.handle = batch->acquire_command_buffer.handle;
+            deferred_delete(&deletion);
+            batch->acquire_command_buffer.handle = 0;
+        }
+    }
+}
+
+// Records copying the data into the ranges on the transfer queue, submitted with the frame's upload batch
+// and finishing later in geometry_uploads_update. Returns false without recording anything if the upload
+// cannot be made this way.
+static b8 geometry_upload_submit(u32 geometry_id, const vulkan_geometry_data* range, const void* vertices, u32 index_size, const void* indices) {
+    u64 vertex_data_size = (u64)range->vertex_count * range->vertex_element_size;
+    u64 index_data_size = range->index_count ? (u64)range->index_count * index_size : 0;
+
+    vulkan_upload_batch* batch = upload_batch_begin();
+    if (!batch) {
+        return false;
+    }
+
+    vulkan_geometry_upload upload = {};
+    upload.geometry_id = geometry_id;
+    upload.range = *range;
+    upload.batch_index = (u32)(batch - context.upload_batches);
+    if (!renderer_renderbuffer_create(RENDERBUFFER_TYPE_STAGING, vertex_data_size + index_data_size, false, &upload.staging)) {
+        return false;
+    }
+    renderer_renderbuffer_bind(&upload.staging, 0);
+    vulkan_buffer_load_range(&upload.staging, 0, vertex_data_size, vertices);
+    if (index_data_size) {
+        vulkan_buffer_load_range(&upload.staging, vertex_data_size, index_data_size, indices);
+    }
+
+    VkBuffer staging_handle = ((vulkan_buffer*)upload.staging.internal_data)->handle;
+    VkBufferCopy copy_region;
+    copy_region.srcOffset = 0;
+    copy_region.dstOffset = range->vertex_buffer_offset;
+    copy_region.size = vertex_data_size;
+    vkCmdCopyBuffer(batch->command_buffer.handle, staging_handle, ((vulkan_buffer*)context.geometry_blocks[range->block].vertex_buffer.internal_data)->handle, 1, &copy_region);
+    if (index_data_size) {
+        copy_region.srcOffset = vertex_data_size;
+        copy_region.dstOffset = range->index_buffer_offset;
+        copy_region.size = index_data_size;
+        vkCmdCopyBuffer(batch->command_buffer.handle, staging_handle, ((vulkan_buffer*)geometry_index_buffer_get(range->block, index_size)->internal_data)->handle, 1, &copy_region);
+    }
+    counter_add(context.staged_uploads_counter, 1);
+    counter_add(context.staged_bytes_counter, (i64)(vertex_data_size + index_data_size));
+
+    darray_push(context.geometry_uploads, upload);
+    return true;
+}
+
+// Finishes the geometry uploads which are complete, handing their ranges to their geometries so they
+// are drawn. Submits and waits for every upload if wait is set.
+static void geometry_uploads_update(b8 wait) {
+    if (wait) {
+        upload_batches_submit();
+    }
+
+    b8 batch_complete[2] = {false, false};
+    for (u32 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
+        vulkan_upload_batch* batch = &context.upload_batches[i];
+        if (!batch->submitted) {
+            continue;
+        }
+        VkResult status = upload_batch_wait(batch, wait ? UINT64_MAX : 0);
+        if (status != VK_SUCCESS) {
+            if (status != VK_NOT_READY && status != VK_TIMEOUT) {
+                KERROR("Geometry upload failed: '%s'.", vulkan_result_string(status, true));
+            }
+            continue;
+        }
+        if (!context.transfer_timeline) {
+            VK_CHECK(vkResetFences(context.device.logical_device, 1, &batch->fence));
+        }
+        batch->submitted = false;
+        batch_complete[i] = true;
+    }
+
+    u32 i = 0;
+    while (context.geometry_uploads && i < darray_length(context.geometry_uploads)) {
+        vulkan_geometry_upload* upload = &context.geometry_uploads[i];
+        if (!batch_complete[upload->batch_index]) {
+            ++i;
+            continue;
+        }
+
+        vulkan_geometry_data* internal_data = &context.geometries[upload->geometry_id];
+        if (upload->staging.internal_data) {
+            geometry_range_apply(internal_data, &upload->range, false);
+            internal_data->upload_pending = false;
+
+            renderer_renderbuffer_unbind(&upload->staging);
+            renderer_renderbuffer_destroy(&upload->staging);
+        } else {
+            // Moved by compaction. The ranges it was moved from are freed once the frames in flight are done
+            // drawing from them.
+            geometry_range_apply(internal_data, &upload->range, true);
+            internal_data->move_pending = false;
+        }
+        darray_swap_remove(context.geometry_uploads, i, 0);
+    }
+}
+
+#if KVULKAN_GEOMETRY_COMPACTION == 1
+// Records copying the given geometry to ranges in another block than its own, on the transfer queue with the
+// frame's upload batch. It is drawn from where it is until the copies complete, when geometry_uploads_update
+// moves it over. Returns false without recording anything if no other block has room for it.
+static b8 geometry_move_submit(vulkan_geometry_data* internal_data) {
+    vulkan_upload_batch* batch = upload_batch_begin();
+    if (!batch) {
+        return false;
+    }
+    vulkan_geometry_data range = *internal_data;
+    if (!geometry_ranges_allocate(&range, internal_data->block, false)) {
+        return false;
+    }
+
+    vulkan_geometry_block* source = &context.geometry_blocks[internal_data->block];
+    vulkan_geometry_block* destination = &context.geometry_blocks[range.block];
+    VkBufferCopy copy_region;
+    copy_region.srcOffset = internal_data->vertex_buffer_offset;
+    copy_region.dstOffset = range.vertex_buffer_offset;
+    copy_region.size = (u64)internal_data->vertex_count * internal_data->vertex_element_size;
+    vkCmdCopyBuffer(
+        batch->command_buffer.handle,
+        ((vulkan_buffer*)source->vertex_buffer.internal_data)->handle,
+        ((vulkan_buffer*)destination->vertex_buffer.internal_data)->handle,
+        1, &copy_region);
+    u64 moved_size = copy_region.size;
+    if (internal_data->index_count) {
+        copy_region.srcOffset = internal_data->index_buffer_offset;
+        copy_region.dstOffset = range.index_buffer_offset;
+        copy_region.size = (u64)internal_data->index_count * internal_data->index_element_size;
+        vkCmdCopyBuffer(
+            batch->command_buffer.handle,
+            ((vulkan_buffer*)geometry_index_buffer_get(internal_data->block, internal_data->index_element_size)->internal_data)->handle,
+            ((vulkan_buffer*)geometry_index_buffer_get(range.block, internal_data->index_element_size)->internal_data)->handle,
+            1, &copy_region);
+        moved_size += copy_region.size;
+    }
+    counter_add(context.geometry_compacted_bytes_counter, (i64)moved_size);
+
+    vulkan_geometry_upload upload = {};
+    upload.geometry_id = internal_data->id;
+    upload.range = range;
+    upload.batch_index = (u32)(batch - context.upload_batches);
+    darray_push(context.geometry_uploads, upload);
+    internal_data->move_pending = true;
+    return true;
+}
+
+// Moves what is left in a sparsely used block of the geometry heap to the others, a little each frame, and
+// releases the block once nothing is left in it. Streaming fragments blocks until geometries no longer fit
+// and more are chained, which this hands back as what they hold is unloaded.
+static void geometry_compaction_update() {
+    if (context.geometry_compaction_block == INVALID_ID) {
+        // Only looked for now and again, or every frame while memory is short, and only while there are other blocks to move to.
+        b8 pressured = context.memory_allocator.pressure != RENDERER_MEMORY_PRESSURE_NONE;
+        if (context.geometry_block_count < 2 || (!pressured && context.frame_serial < context.geometry_compaction_next_frame)) {
+            return;
+        }
+        context.geometry_compaction_next_frame = context.frame_serial + VULKAN_GEOMETRY_COMPACTION_INTERVAL;
+        f32 least_use = VULKAN_GEOMETRY_COMPACTION_MAX_USE;
+        for (u32 i = 0; i < VULKAN_MAX_GEOMETRY_BLOCKS; ++i) {
+            vulkan_geometry_block* block = &context.geometry_blocks[i];
+            if (block->vertex_buffer.internal_data) {
+                f32 use = geometry_block_use(block);
+                if (use < least_use) {
+                    least_use = use;
+                    context.geometry_compaction_block = i;
+                }
+            }
+        }
+        if (context.geometry_compaction_block == INVALID_ID) {
+            return;
+        }
+    }
+
+    u32 block = context.geometry_compaction_block;
+    u64 moved_size = 0;
+    b8 occupied = false;
+    for (u32 i = 0; i < VULKAN_MAX_GEOMETRY_COUNT && moved_size < VULKAN_GEOMETRY_COMPACTION_FRAME_BYTES; ++i) {
+        vulkan_geometry_data* internal_data = &context.geometries[i];
+        if (internal_data->id == INVALID_ID || internal_data->upload_pending || internal_data->block != block) {
+            continue;
+        }
+        occupied = true;
+        // Not while it is being moved already, nor until the frames which may have written it are complete.
+        if (internal_data->move_pending || internal_data->upload_serial >= context.frames_completed) {
+            continue;
+        }
+        if (!geometry_move_submit(internal_data)) {
+            // The others are too full to take it, so the block is kept.
+            context.geometry_compaction_block = INVALID_ID;
+            return;
+        }
+        moved_size += internal_data->vertex_allocation_size + (u64)internal_data->index_count * internal_data->index_element_size;
+    }
+
+    // Released once every geometry has moved out, and the frames drawing them from it have freed their ranges,
+    // along with those of any upload to it which was already under way.
+    if (!occupied && geometry_block_use(&context.geometry_blocks[block]) == 0.0f) {
+        KDEBUG("Releasing geometry block %u, whose geometries were moved to the others.", block);
+        geometry_block_destroy(block);
+        context.geometry_compaction_block = INVALID_ID;
+    }
+}
+#endif
+
 b8 vulkan_renderer_create_geometry(geometry* geometry, u32 vertex_size, u32 vertex_count, const void* vertices, u32 index_size, u32 index_count, const void* indices) {
     if (!vertex_count || !vertices) {
         KERROR("vulkan_renderer_create_geometry requires vertex data, and none was supplied. vertex_count=%d, vertices=%p", vertex_count, vertices);
         return false;
     }
+    if (index_count && indices && index_size != sizeof(u16) && index_size != sizeof(u32)) {
+        KERROR("vulkan_renderer_create_geometry requires 16 or 32-bit indices, but was given an index size of %u.", index_size);
+        return false;
+    }
 
     // Check if this is a re-upload. If it is, need to free old data afterward.
     b8 is_reupload = geometry->internal_id != INVALID_ID;
-    vulkan_geometry_data old_range;
 
     vulkan_geometry_data* internal_data = 0;
     if (is_reupload) {
         internal_data = &context.geometries[geometry->internal_id];
-
-        // Take a copy of the old range.
-        old_range.index_buffer_offset = internal_data->index_buffer_offset;
-        old_range.index_count = internal_data->index_count;
-        old_range.index_element_size = internal_data->index_element_size;
-        old_range.vertex_buffer_offset = internal_data->vertex_buffer_offset;
-        old_range.vertex_count = internal_data->vertex_count;
-        old_range.vertex_element_size = internal_data->vertex_element_size;
+        // The first upload, or a move by compaction, must have landed before it is replaced.
+        if (internal_data->upload_pending || internal_data->move_pending) {
+            geometry_uploads_update(true);
+        }
     } else {
         for (u32 i = 0; i < VULKAN_MAX_GEOMETRY_COUNT; ++i) {
             if (context.geometries[i].id == INVALID_ID) {
                 // Found a free index.
                 geometry->internal_id = i;
                 context.geometries[i].id = i;
+                context.geometries[i].skin_index = INVALID_ID;
                 internal_data = &context.geometries[i];
                 break;
             }
@@ -1210,37 +3260,47 @@ b8 vulkan_renderer_create_geometry(geometry* geometry, u32 vertex_size, u32 vert
         return false;
     }
 
-    // Vertex data.
-    internal_data->vertex_count = vertex_count;
-    internal_data->vertex_element_size = sizeof(vertex_3d);
+    // The ranges the data goes to, which the geometry takes once it is uploaded.
+    vulkan_geometry_data range = {};
+    range.vertex_count = vertex_count;
+    range.vertex_element_size = vertex_size;
     u32 total_size = vertex_count * vertex_size;
-    // Allocate space in the buffer.
-    if (!renderer_renderbuffer_allocate(&context.object_vertex_buffer, total_size, &internal_data->vertex_buffer_offset)) {
-        KERROR("vulkan_renderer_create_geometry failed to allocate from the vertex buffer!");
-        return false;
+    // The vertices start at a multiple of their size within their range, so one more is allowed for.
+    range.vertex_allocation_size = total_size + vertex_size;
+    // Index data, if applicable, in the index buffer for its size.
+    if (index_count && indices) {
+        range.index_count = index_count;
+        range.index_element_size = index_size;
     }
-
-    // Load the data.
-    if (!renderer_renderbuffer_load_range(&context.object_vertex_buffer, internal_data->vertex_buffer_offset, total_size, vertices)) {
-        KERROR("vulkan_renderer_create_geometry failed to upload to the vertex buffer!");
+    // Both from the same block of the geometry heap, preferring any other to one being emptied by compaction.
+    if (!geometry_ranges_allocate(&range, context.geometry_compaction_block, true)) {
+        KERROR("vulkan_renderer_create_geometry failed to allocate from the geometry buffers!");
         return false;
     }
+    renderbuffer* vertex_buffer = &context.geometry_blocks[range.block].vertex_buffer;
+    renderbuffer* index_buffer = geometry_index_buffer_get(range.block, index_size);
 
-    // Index data, if applicable
-    if (index_count && indices) {
-        internal_data->index_count = index_count;
-        internal_data->index_element_size = sizeof(u32);
-        total_size = index_count * index_size;
-        if (!renderer_renderbuffer_allocate(&context.object_index_buffer, total_size, &internal_data->index_buffer_offset)) {
-            KERROR("vulkan_renderer_create_geometry failed to allocate from the index buffer!");
+    // New geometries are uploaded on the transfer queue without waiting, and are not drawn until the
+    // upload completes. Reuploads replace data which is being drawn, and whose ranges cannot be freed
+    // until frames in flight are done with them, so they are uploaded in place as before.
+    if (!is_reupload && geometry_upload_submit(internal_data->id, &range, vertices, index_size, indices)) {
+        internal_data->upload_pending = true;
+    } else {
+        // Load the data.
+        if (!renderer_renderbuffer_load_range(vertex_buffer, range.vertex_buffer_offset, total_size, vertices)) {
+            KERROR("vulkan_renderer_create_geometry failed to upload to the vertex buffer!");
             return false;
         }
-
-        if (!renderer_renderbuffer_load_range(&context.object_index_buffer, internal_data->index_buffer_offset, total_size, indices)) {
-            KERROR("vulkan_renderer_create_geometry failed to upload to the index buffer!");
-            return false;
+        if (range.index_count) {
+            if (!renderer_renderbuffer_load_range(index_buffer, range.index_buffer_offset, index_count * index_size, indices)) {
+                KERROR("vulkan_renderer_create_geometry failed to upload to the index buffer!");
+                return false;
+            }
         }
+        // The old ranges are freed once the frames in flight are done with them.
+        geometry_range_apply(internal_data, &range, is_reupload);
     }
+    internal_data->upload_serial = context.frame_serial;
 
     if (internal_data->generation == INVALID_ID) {
         internal_data->generation = 0;
@@ -1248,68 +3308,1073 @@ b8 vulkan_renderer_create_geometry(geometry* geometry, u32 vertex_size, u32 vert
         internal_data->generation++;
     }
 
-    if (is_reupload) {
-        // Free vertex data
-        if (!renderer_renderbuffer_free(&context.object_vertex_buffer, old_range.vertex_element_size * old_range.vertex_count, old_range.vertex_buffer_offset)) {
-            KERROR("vulkan_renderer_create_geometry free operation failed during reupload of vertex data.");
-            return false;
+    return true;
+}
+
+void vulkan_renderer_destroy_geometry(geometry* geometry) {
+    if (geometry && geometry->internal_id != INVALID_ID) {
+        // An upload or move still in flight is finished first, so its ranges are the ones freed.
+        if (context.geometries[geometry->internal_id].upload_pending || context.geometries[geometry->internal_id].move_pending) {
+            geometry_uploads_update(true);
+        }
+        vulkan_geometry_data* internal_data = &context.geometries[geometry->internal_id];
+
+        // Free vertex and index data once the frames in flight are done drawing it, along with any skin.
+        geometry_ranges_free(internal_data);
+        vulkan_skinning_skin_destroy(&context, internal_data);
+
+        // Clean up data.
+        kzero_memory(internal_data, sizeof(vulkan_geometry_data));
+        internal_data->id = INVALID_ID;
+        internal_data->generation = INVALID_ID;
+        internal_data->skin_index = INVALID_ID;
+    }
+}
+
+b8 vulkan_renderer_geometry_skin_create(geometry* geometry, u32 vertex_count, const vertex_3d_skinned* vertices) {
+    if (!geometry || geometry->internal_id == INVALID_ID) {
+        KERROR("vulkan_renderer_geometry_skin_create requires a geometry which has been created.");
+        return false;
+    }
+    return vulkan_skinning_skin_create(&context, &context.geometries[geometry->internal_id], vertex_count, vertices);
+}
+
+void vulkan_renderer_geometry_skin_destroy(geometry* geometry) {
+    if (geometry && geometry->internal_id != INVALID_ID) {
+        vulkan_skinning_skin_destroy(&context, &context.geometries[geometry->internal_id]);
+    }
+}
+
+void vulkan_renderer_geometry_skins_update(u32 count, const renderer_skin_update* updates) {
+    vulkan_command_buffer* command_buffer = &context.graphics_command_buffers[context.image_index];
+    if (command_buffer->state == COMMAND_BUFFER_STATE_IN_RENDER_PASS) {
+        KERROR("vulkan_renderer_geometry_skins_update cannot be called within a renderpass.");
+        return;
+    }
+    vulkan_skinning_record(&context, command_buffer, count, updates);
+}
+
+// The bound shader, if it pulls its vertices from the vertex buffer; otherwise 0.
+static vulkan_shader* vertex_pulling_shader_get() {
+    shader* s = context.bound_shader;
+    return s && (s->flags & SHADER_FLAG_VERTEX_PULLING) ? s->internal_data : 0;
+}
+
+// Indicates if the buffers the given geometry is drawn from are those bound in the given command buffer, and
+// for a bound shader pulling its vertices, if its block's vertex set is bound for that shader.
+static b8 geometry_buffers_bound(const vulkan_command_buffer* command_buffer, const vulkan_geometry_data* buffer_data) {
+    const vulkan_shader* pulling = vertex_pulling_shader_get();
+    return command_buffer->bound_geometry_block == buffer_data->block &&
+           (!buffer_data->index_count || command_buffer->bound_index_size == buffer_data->index_element_size) &&
+           (!pulling || command_buffer->bound_vertex_set_layout == pulling->pipeline.pipeline_layout);
+}
+
+// Records binding the buffers the given geometry is drawn from at their start in the given command buffer,
+// unless they already are: the vertex buffer of its block and, if it is indexed, the block's index buffer of
+// its index size. Geometries in the same block are drawn from where they are in those buffers.
+static void geometry_buffers_bind(vulkan_command_buffer* command_buffer, const vulkan_geometry_data* buffer_data) {
+    if (geometry_buffers_bound(command_buffer, buffer_data)) {
+        counter_add(context.redundant_binds_counter, 1);
+        return;
+    }
+    if (command_buffer->bound_geometry_block != buffer_data->block) {
+        VkDeviceSize offsets[1] = {0};
+        vkCmdBindVertexBuffers(command_buffer->handle, 0, 1, &((vulkan_buffer*)context.geometry_blocks[buffer_data->block].vertex_buffer.internal_data)->handle, offsets);
+        command_buffer->bound_geometry_block = buffer_data->block;
+        // The index buffers and vertex set bound are those of the block before.
+        command_buffer->bound_index_size = 0;
+        command_buffer->bound_vertex_set_layout = 0;
+    }
+    // Shaders pulling their vertices read them through the block's vertex set, which the vertex buffer is bound
+    // alongside, as it costs little and serves shaders with attributes drawn next.
+    vulkan_shader* pulling = vertex_pulling_shader_get();
+    if (pulling && command_buffer->bound_vertex_set_layout != pulling->pipeline.pipeline_layout) {
+        VkDescriptorSet vertex_set = context.geometry_blocks[buffer_data->block].vertex_set;
+        vkCmdBindDescriptorSets(command_buffer->handle, VK_PIPELINE_BIND_POINT_GRAPHICS, pulling->pipeline.pipeline_layout, pulling->vertex_set_index, 1, &vertex_set, 0, 0);
+        command_buffer->bound_vertex_set_layout = pulling->pipeline.pipeline_layout;
+    }
+    if (buffer_data->index_count && command_buffer->bound_index_size != buffer_data->index_element_size) {
+        VkIndexType index_type = buffer_data->index_element_size == sizeof(u16) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+        renderbuffer* index_buffer = geometry_index_buffer_get(buffer_data->block, buffer_data->index_element_size);
+        vkCmdBindIndexBuffer(command_buffer->handle, ((vulkan_buffer*)index_buffer->internal_data)->handle, 0, index_type);
+        command_buffer->bound_index_size = buffer_data->index_element_size;
+    }
+}
+
+void vulkan_renderer_draw_geometry(geometry_render_data* data) {
+    // Ignore non-uploaded geometries.
+    if (data->geometry && data->geometry->internal_id == INVALID_ID) {
+        return;
+    }
+
+    vulkan_geometry_data* buffer_data = &context.geometries[data->geometry->internal_id];
+    // Nor those whose data is still on its way.
+    if (buffer_data->upload_pending) {
+        return;
+    }
+    if (context.parallel_renderpass) {
+        KERROR("vulkan_renderer_draw_geometry cannot be called within a renderpass begun for parallel recording.");
+        return;
+    }
+    vulkan_command_buffer* command_buffer = &context.graphics_command_buffers[context.image_index];
+    geometry_buffers_bind(command_buffer, buffer_data);
+
+    // Drawn from where the geometry is in its block's buffers, so they needn't be bound for each one.
+    u32 first_vertex = (u32)(buffer_data->vertex_buffer_offset / buffer_data->vertex_element_size);
+    if (!buffer_data->index_count) {
+        vkCmdDraw(command_buffer->handle, buffer_data->vertex_count, 1, first_vertex, 0);
+        return;
+    }
+
+    // Draw only the indices of the requested level of detail, if the geometry has it.
+    u64 index_offset = buffer_data->index_buffer_offset;
+    u32 index_count = buffer_data->index_count;
+    if (data->lod < data->geometry->lod_count) {
+        const geometry_lod* lod = &data->geometry->lods[data->lod];
+        index_offset += (u64)lod->index_offset * buffer_data->index_element_size;
+        index_count = lod->index_count;
+    }
+    vkCmdDrawIndexed(command_buffer->handle, index_count, 1, (u32)(index_offset / buffer_data->index_element_size), (i32)first_vertex, 0);
+}
+
+static b8 draw_batch_create() {
+    vulkan_draw_batch* batch = &context.draw_batch;
+    batch->capacity = VULKAN_MAX_BATCHED_DRAWS;
+    // Many draws at a time need both features, since each starts at the instance its draw data is at.
+    batch->multi_draw_indirect = context.device.features.multiDrawIndirect && context.device.features.drawIndirectFirstInstance;
+    batch->run_slots = darray_create(u32);
+
+    u32 frame_count = context.swapchain.max_frames_in_flight;
+    u64 draw_data_size = sizeof(vulkan_draw_data) * batch->capacity;
+    u64 storage_alignment = context.device.properties.limits.minStorageBufferOffsetAlignment;
+    if (storage_alignment && draw_data_size % storage_alignment) {
+        KERROR("The draw data region size %llu is not a multiple of the storage buffer offset alignment %llu.", draw_data_size, storage_alignment);
+        return false;
+    }
+    if (!renderer_renderbuffer_create(RENDERBUFFER_TYPE_STORAGE, draw_data_size * frame_count, false, &batch->draw_data_buffer)) {
+        KERROR("Failed to create the draw data buffer.");
+        return false;
+    }
+    renderer_renderbuffer_bind(&batch->draw_data_buffer, 0);
+    if (!renderer_renderbuffer_create(RENDERBUFFER_TYPE_INDIRECT, sizeof(VkDrawIndexedIndirectCommand) * batch->capacity * frame_count, false, &batch->indirect_buffer)) {
+        KERROR("Failed to create the indirect draw buffer.");
+        return false;
+    }
+    renderer_renderbuffer_bind(&batch->indirect_buffer, 0);
+    batch->draw_data = vulkan_buffer_map_memory(&batch->draw_data_buffer, 0, VK_WHOLE_SIZE);
+    batch->commands = vulkan_buffer_map_memory(&batch->indirect_buffer, 0, VK_WHOLE_SIZE);
+
+    // One set per frame in flight, each pointing at the frame's region of the draw data.
+    VkDescriptorSetLayoutBinding binding = {0};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    VkDescriptorSetLayoutCreateInfo layout_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    layout_info.bindingCount = 1;
+    layout_info.pBindings = &binding;
+    VkResult result = vkCreateDescriptorSetLayout(context.device.logical_device, &layout_info, context.allocator, &batch->set_layout);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("Failed to create the draw data set layout: '%s'", vulkan_result_string(result, true));
+        return false;
+    }
+
+    VkDescriptorPoolSize pool_size = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frame_count};
+    VkDescriptorPoolCreateInfo pool_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+    pool_info.maxSets = frame_count;
+    result = vkCreateDescriptorPool(context.device.logical_device, &pool_info, context.allocator, &batch->descriptor_pool);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("Failed to create the draw data descriptor pool: '%s'", vulkan_result_string(result, true));
+        return false;
+    }
+
+    VkDescriptorSetLayout set_layouts[2] = {batch->set_layout, batch->set_layout};
+    VkDescriptorSetAllocateInfo alloc_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    alloc_info.descriptorPool = batch->descriptor_pool;
+    alloc_info.descriptorSetCount = frame_count;
+    alloc_info.pSetLayouts = set_layouts;
+    VK_CHECK(vkAllocateDescriptorSets(context.device.logical_device, &alloc_info, batch->descriptor_sets));
+
+    for (u32 i = 0; i < frame_count; ++i) {
+        VkDescriptorBufferInfo buffer_info;
+        buffer_info.buffer = ((vulkan_buffer*)batch->draw_data_buffer.internal_data)->handle;
+        buffer_info.offset = draw_data_size * i;
+        buffer_info.range = draw_data_size;
+
+        VkWriteDescriptorSet write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+        write.dstSet = batch->descriptor_sets[i];
+        write.dstBinding = 0;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.descriptorCount = 1;
+        write.pBufferInfo = &buffer_info;
+        vkUpdateDescriptorSets(context.device.logical_device, 1, &write, 0, 0);
+    }
+    return true;
+}
+
+static void draw_batch_destroy() {
+    vulkan_draw_batch* batch = &context.draw_batch;
+    if (batch->descriptor_pool) {
+        vkDestroyDescriptorPool(context.device.logical_device, batch->descriptor_pool, context.allocator);
+    }
+    if (batch->set_layout) {
+        vkDestroyDescriptorSetLayout(context.device.logical_device, batch->set_layout, context.allocator);
+    }
+    if (batch->draw_data_buffer.internal_data) {
+        renderer_renderbuffer_unbind(&batch->draw_data_buffer);
+        renderer_renderbuffer_destroy(&batch->draw_data_buffer);
+    }
+    if (batch->indirect_buffer.internal_data) {
+        renderer_renderbuffer_unbind(&batch->indirect_buffer);
+        renderer_renderbuffer_destroy(&batch->indirect_buffer);
+    }
+    if (batch->run_slots) {
+        darray_destroy(batch->run_slots);
+    }
+    u32 counter = batch->batched_draws_counter;
+    u32 instanced_counter = batch->instanced_draws_counter;
+    u32 meshlet_counter = batch->meshlet_draws_counter;
+    kzero_memory(batch, sizeof(vulkan_draw_batch));
+    batch->batched_draws_counter = counter;
+    batch->instanced_draws_counter = instanced_counter;
+    batch->meshlet_draws_counter = meshlet_counter;
+}
+
+static b8 frame_uniform_arena_create() {
+    vulkan_frame_uniform_arena* arena = &context.frame_uniforms;
+    u32 frame_count = context.swapchain.max_frames_in_flight;
+    arena->alignment = KMAX(context.device.properties.limits.minUniformBufferOffsetAlignment, 16);
+    arena->region_size = get_aligned(VULKAN_FRAME_UNIFORM_ARENA_SIZE, arena->alignment);
+    arena->used = 0;
+    if (!renderer_renderbuffer_create(RENDERBUFFER_TYPE_UNIFORM, arena->region_size * frame_count, false, &arena->buffer)) {
+        KERROR("Failed to create the frame uniform arena buffer.");
+        return false;
+    }
+    renderer_renderbuffer_bind(&arena->buffer, 0);
+    arena->mapped = vulkan_buffer_map_memory(&arena->buffer, 0, VK_WHOLE_SIZE);
+
+    // One set per frame in flight, each pointing at the start of the frame's region, with every
+    // allocation bound at its dynamic offset from there.
+    VkDescriptorSetLayoutBinding binding = {0};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    VkDescriptorSetLayoutCreateInfo layout_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    layout_info.bindingCount = 1;
+    layout_info.pBindings = &binding;
+    VkResult result = vkCreateDescriptorSetLayout(context.device.logical_device, &layout_info, context.allocator, &arena->set_layout);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("Failed to create the frame uniform arena set layout: '%s'", vulkan_result_string(result, true));
+        return false;
+    }
+
+    VkDescriptorPoolSize pool_size = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, frame_count};
+    VkDescriptorPoolCreateInfo pool_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+    pool_info.maxSets = frame_count;
+    result = vkCreateDescriptorPool(context.device.logical_device, &pool_info, context.allocator, &arena->descriptor_pool);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("Failed to create the frame uniform arena descriptor pool: '%s'", vulkan_result_string(result, true));
+        return false;
+    }
+
+    VkDescriptorSetLayout set_layouts[2] = {arena->set_layout, arena->set_layout};
+    VkDescriptorSetAllocateInfo alloc_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    alloc_info.descriptorPool = arena->descriptor_pool;
+    alloc_info.descriptorSetCount = frame_count;
+    alloc_info.pSetLayouts = set_layouts;
+    VK_CHECK(vkAllocateDescriptorSets(context.device.logical_device, &alloc_info, arena->descriptor_sets));
+
+    for (u32 i = 0; i < frame_count; ++i) {
+        VkDescriptorBufferInfo buffer_info;
+        buffer_info.buffer = ((vulkan_buffer*)arena->buffer.internal_data)->handle;
+        buffer_info.offset = arena->region_size * i;
+        buffer_info.range = VULKAN_SHADER_MAX_LOCAL_UBO_SIZE;
+
+        VkWriteDescriptorSet write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+        write.dstSet = arena->descriptor_sets[i];
+        write.dstBinding = 0;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        write.descriptorCount = 1;
+        write.pBufferInfo = &buffer_info;
+        vkUpdateDescriptorSets(context.device.logical_device, 1, &write, 0, 0);
+    }
+    return true;
+}
+
+static b8 pixel_readback_create() {
+    vulkan_pixel_readback* readback = &context.pixel_readback;
+    kzero_memory(readback, sizeof(vulkan_pixel_readback));
+    if (!renderer_renderbuffer_create(RENDERBUFFER_TYPE_READ, sizeof(u8) * 4 * VULKAN_MAX_FRAMES_IN_FLIGHT, false, &readback->buffer)) {
+        KERROR("Failed to create the pixel readback buffer.");
+        return false;
+    }
+    renderer_renderbuffer_bind(&readback->buffer, 0);
+    readback->mapped = vulkan_buffer_map_memory(&readback->buffer, 0, VK_WHOLE_SIZE);
+    return true;
+}
+
+static void pixel_readback_destroy() {
+    vulkan_pixel_readback* readback = &context.pixel_readback;
+    if (readback->buffer.internal_data) {
+        vulkan_buffer_unmap_memory(&readback->buffer, 0, VK_WHOLE_SIZE);
+        renderer_renderbuffer_unbind(&readback->buffer);
+        renderer_renderbuffer_destroy(&readback->buffer);
+    }
+    kzero_memory(readback, sizeof(vulkan_pixel_readback));
+}
+
+static void frame_uniform_arena_destroy() {
+    vulkan_frame_uniform_arena* arena = &context.frame_uniforms;
+    if (arena->descriptor_pool) {
+        vkDestroyDescriptorPool(context.device.logical_device, arena->descriptor_pool, context.allocator);
+    }
+    if (arena->set_layout) {
+        vkDestroyDescriptorSetLayout(context.device.logical_device, arena->set_layout, context.allocator);
+    }
+    if (arena->buffer.internal_data) {
+        vulkan_buffer_unmap_memory(&arena->buffer, 0, VK_WHOLE_SIZE);
+        renderer_renderbuffer_unbind(&arena->buffer);
+        renderer_renderbuffer_destroy(&arena->buffer);
+    }
+    u32 counter = arena->bytes_counter;
+    kzero_memory(arena, sizeof(vulkan_frame_uniform_arena));
+    arena->bytes_counter = counter;
+}
+
+// Creates a pool of transient descriptor sets, holding enough descriptors for its sets to be those of instances.
+static VkDescriptorPool transient_descriptor_pool_create() {
+    VkDescriptorPoolSize pool_sizes[2] = {
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VULKAN_TRANSIENT_DESCRIPTOR_POOL_SETS},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VULKAN_TRANSIENT_DESCRIPTOR_POOL_SETS * 8}};
+    VkDescriptorPoolCreateInfo pool_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    pool_info.poolSizeCount = 2;
+    pool_info.pPoolSizes = pool_sizes;
+    pool_info.maxSets = VULKAN_TRANSIENT_DESCRIPTOR_POOL_SETS;
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkResult result = vkCreateDescriptorPool(context.device.logical_device, &pool_info, context.allocator, &pool);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("Failed to create a transient descriptor pool: '%s'", vulkan_result_string(result, true));
+        return VK_NULL_HANDLE;
+    }
+    return pool;
+}
+
+static b8 transient_descriptors_create() {
+    vulkan_transient_descriptors* transient = &context.transient_descriptors;
+    for (u32 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
+        transient->pools[i] = darray_create(VkDescriptorPool);
+        transient->current_pools[i] = 0;
+        VkDescriptorPool pool = transient_descriptor_pool_create();
+        if (!pool) {
+            return false;
+        }
+        darray_push(transient->pools[i], pool);
+    }
+    return true;
+}
+
+static void transient_descriptors_destroy() {
+    vulkan_transient_descriptors* transient = &context.transient_descriptors;
+    for (u32 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
+        if (!transient->pools[i]) {
+            continue;
+        }
+        u32 pool_count = darray_length(transient->pools[i]);
+        for (u32 p = 0; p < pool_count; ++p) {
+            vkDestroyDescriptorPool(context.device.logical_device, transient->pools[i][p], context.allocator);
+        }
+        darray_destroy(transient->pools[i]);
+    }
+    u32 counter = transient->sets_counter;
+    kzero_memory(transient, sizeof(vulkan_transient_descriptors));
+    transient->sets_counter = counter;
+}
+
+// Gives back every transient set of the current frame in flight, which has been waited for.
+static void transient_descriptors_reset() {
+    vulkan_transient_descriptors* transient = &context.transient_descriptors;
+    u32 frame = context.current_frame;
+    if (!transient->pools[frame]) {
+        return;
+    }
+    u32 used_count = KMIN(transient->current_pools[frame] + 1, (u32)darray_length(transient->pools[frame]));
+    for (u32 p = 0; p < used_count; ++p) {
+        VK_CHECK(vkResetDescriptorPool(context.device.logical_device, transient->pools[frame][p], 0));
+    }
+    transient->current_pools[frame] = 0;
+}
+
+// Allocates a set of the given layout which lives until the current frame in flight comes round again.
+// Moves on to the frame's next pool as each fills, creating one if need be. Returns VK_NULL_HANDLE on failure.
+static VkDescriptorSet transient_descriptor_set_allocate(VkDescriptorSetLayout layout) {
+    vulkan_transient_descriptors* transient = &context.transient_descriptors;
+    u32 frame = context.current_frame;
+    while (true) {
+        b8 created = false;
+        if (transient->current_pools[frame] == darray_length(transient->pools[frame])) {
+            VkDescriptorPool pool = transient_descriptor_pool_create();
+            if (!pool) {
+                return VK_NULL_HANDLE;
+            }
+            darray_push(transient->pools[frame], pool);
+            created = true;
+        }
+
+        VkDescriptorSetAllocateInfo alloc_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+        alloc_info.descriptorPool = transient->pools[frame][transient->current_pools[frame]];
+        alloc_info.descriptorSetCount = 1;
+        alloc_info.pSetLayouts = &layout;
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        VkResult result = vkAllocateDescriptorSets(context.device.logical_device, &alloc_info, &set);
+        if (result == VK_SUCCESS) {
+            counter_add(transient->sets_counter, 1);
+            return set;
+        }
+        // A pool which is new and still cannot hold the set never will.
+        if (created || (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL)) {
+            KERROR("Failed to allocate a transient descriptor set: '%s'", vulkan_result_string(result, true));
+            return VK_NULL_HANDLE;
+        }
+        transient->current_pools[frame]++;
+    }
+}
+
+// Copies the given data to the current frame's region of the frame uniform arena, returning its dynamic
+// offset from the start of the region, or INVALID_ID if the region is full.
+static u32 frame_uniform_arena_push(const void* data, u64 size) {
+    vulkan_frame_uniform_arena* arena = &context.frame_uniforms;
+    // Each allocation is read as a whole descriptor range, which must stay within the region.
+    if (arena->used + VULKAN_SHADER_MAX_LOCAL_UBO_SIZE > arena->region_size) {
+        KERROR("The frame uniform arena is full. Increase VULKAN_FRAME_UNIFORM_ARENA_SIZE.");
+        return INVALID_ID;
+    }
+    u64 offset = arena->used;
+    kcopy_memory(arena->mapped + (arena->region_size * context.current_frame) + offset, data, size);
+    arena->used = get_aligned(offset + size, arena->alignment);
+    counter_add(arena->bytes_counter, size);
+    return (u32)offset;
+}
+
+void vulkan_renderer_draw_batch_cull_set(mat4 projection, mat4 view) {
+    vulkan_cull_view_set(&context, projection, view);
+}
+
+// Issues the indexed draws of the current frame's batch commands from first up to end.
+static void draw_batch_flush(vulkan_command_buffer* command_buffer, u32 first, u32 end) {
+    vulkan_draw_batch* batch = &context.draw_batch;
+    if (first >= end) {
+        return;
+    }
+    counter_add(batch->batched_draws_counter, end - first);
+    u32 frame_base = context.current_frame * batch->capacity;
+    if (batch->multi_draw_indirect) {
+        VkBuffer handle = ((vulkan_buffer*)batch->indirect_buffer.internal_data)->handle;
+        u32 max_count = KMAX(context.device.properties.limits.maxDrawIndirectCount, 1);
+        while (first < end) {
+            u32 draw_count = KMIN(end - first, max_count);
+            vkCmdDrawIndexedIndirect(
+                command_buffer->handle,
+                handle,
+                (u64)(frame_base + first) * sizeof(VkDrawIndexedIndirectCommand),
+                draw_count,
+                sizeof(VkDrawIndexedIndirectCommand));
+            first += draw_count;
+        }
+    } else {
+        // Without multi-draw, the same commands are issued directly, still finding their draw data by instance.
+        // Those of later instances of a draw are empty.
+        for (; first < end; ++first) {
+            const VkDrawIndexedIndirectCommand* command = &batch->commands[frame_base + first];
+            if (!command->instanceCount) {
+                continue;
+            }
+            vkCmdDrawIndexed(command_buffer->handle, command->indexCount, command->instanceCount, command->firstIndex, command->vertexOffset, command->firstInstance);
+        }
+    }
+}
+
+// Gets the buffer data of the given geometry if it can be drawn in a batch, or 0 if it is not uploaded
+// or its data is still on its way.
+static const vulkan_geometry_data* batch_geometry_get(const geometry_render_data* g_data) {
+    if (!g_data->geometry || g_data->geometry->internal_id == INVALID_ID) {
+        return 0;
+    }
+    const vulkan_geometry_data* buffer_data = &context.geometries[g_data->geometry->internal_id];
+    return buffer_data->upload_pending ? 0 : buffer_data;
+}
+
+// Indicates if the given geometry is drawn as its meshlets, each culled on its own. Only the full level of
+// detail has meshlets, and they are only worth drawing apart if they are culled.
+static b8 batch_draws_meshlets(const geometry_render_data* g_data, const vulkan_geometry_data* buffer_data) {
+    return context.cull.enabled && buffer_data->index_count && g_data->lod == 0 && g_data->geometry->meshlet_count > 1;
+}
+
+// Counts the batch slots the given geometries which can be drawn in a batch need, one for each meshlet of those drawn as them.
+static u32 batch_draw_count(u32 count, const geometry_render_data* data) {
+    u32 draw_count = 0;
+    for (u32 i = 0; i < count; ++i) {
+        const vulkan_geometry_data* buffer_data = batch_geometry_get(&data[i]);
+        if (buffer_data) {
+            draw_count += batch_draws_meshlets(&data[i], buffer_data) ? data[i].geometry->meshlet_count : 1;
+        }
+    }
+    return draw_count;
+}
+
+// Fills the draw data of a batch slot with the given instance of a geometry, which has no normal cone.
+static void draw_data_fill(vulkan_draw_data* draw_data, const geometry_render_data* instance, u32 highlight, u32 material) {
+    draw_data->model = instance->model;
+    draw_data->highlight = highlight;
+    draw_data->material = material;
+    draw_data->vertex_stride = context.geometries[instance->geometry->internal_id].vertex_element_size;
+    draw_data->extents_min = instance->geometry->extents.min;
+    draw_data->extents_max = instance->geometry->extents.max;
+    draw_data->cone = (vec4){0.0f, 0.0f, 0.0f, 1.0f};
+}
+
+// Fills the draw data and commands of the batch slots from first_slot on with the given geometries which can be
+// drawn, up to slot_count of them, each with the given material table entry, and records their draws in the
+// given command buffer. Geometries next to each other which are the same, at the same level of detail, are
+// drawn as instances of one draw. Geometries with meshlets are drawn as a draw for each, with its own slot, so
+// the cull shader culls them apart. Runs of draws are split where the geometry block or index size changes, to
+// bind the other buffers. Touches only those slots, so may be called on several threads at once for different slots.
+static void draw_batch_record(vulkan_command_buffer* command_buffer, u32 first_slot, u32 slot_count, u32 count, const geometry_render_data* data, const u32* highlights, u32 material) {
+    vulkan_draw_batch* batch = &context.draw_batch;
+    u32 frame_base = context.current_frame * batch->capacity;
+    u32 end_slot = first_slot + slot_count;
+    u32 slot = first_slot;
+    u32 run_start = first_slot;
+    u32 i = 0;
+    while (i < count && slot < end_slot) {
+        const geometry_render_data* g_data = &data[i];
+        const vulkan_geometry_data* buffer_data = batch_geometry_get(g_data);
+        if (!buffer_data) {
+            i++;
+            continue;
+        }
+
+        // Each meshlet is drawn on its own, with the geometry's draw data but for its bounds and cone. Those which
+        // do not all fit are drawn whole.
+        u32 meshlet_count = g_data->geometry->meshlet_count;
+        if (batch_draws_meshlets(g_data, buffer_data) && meshlet_count <= end_slot - slot) {
+            // The draws so far are flushed with their buffers before others are bound.
+            if (!geometry_buffers_bound(command_buffer, buffer_data)) {
+                draw_batch_flush(command_buffer, run_start, slot);
+                geometry_buffers_bind(command_buffer, buffer_data);
+                run_start = slot;
+            }
+            u32 first_index = (u32)(buffer_data->index_buffer_offset / buffer_data->index_element_size);
+            u32 first_vertex = (u32)(buffer_data->vertex_buffer_offset / buffer_data->vertex_element_size);
+            for (u32 m = 0; m < meshlet_count; ++m, ++slot) {
+                const geometry_meshlet* meshlet = &g_data->geometry->meshlets[m];
+                vulkan_draw_data* draw_data = &batch->draw_data[frame_base + slot];
+                draw_data_fill(draw_data, g_data, highlights ? highlights[i] : 0, material);
+                draw_data->extents_min = meshlet->extents.min;
+                draw_data->extents_max = meshlet->extents.max;
+                draw_data->cone = (vec4){meshlet->cone_axis.x, meshlet->cone_axis.y, meshlet->cone_axis.z, meshlet->cone_cutoff};
+
+                VkDrawIndexedIndirectCommand* command = &batch->commands[frame_base + slot];
+                command->indexCount = meshlet->index_count;
+                command->instanceCount = 1;
+                command->firstIndex = first_index + meshlet->index_offset;
+                command->vertexOffset = (i32)first_vertex;
+                command->firstInstance = slot;
+            }
+            counter_add(batch->meshlet_draws_counter, meshlet_count);
+            i++;
+            continue;
+        }
+
+        u32 instance_count = 1;
+        while (i + instance_count < count && slot + instance_count < end_slot && data[i + instance_count].geometry == g_data->geometry && data[i + instance_count].lod == g_data->lod) {
+            instance_count++;
+        }
+
+        // The data of each instance is found by the shader at its instance, in the slots from the draw's on.
+        // The commands of the slots after the draw's are left empty.
+        u32 draw_index = slot;
+        for (u32 n = 0; n < instance_count; ++n, ++slot) {
+            draw_data_fill(&batch->draw_data[frame_base + slot], &data[i + n], highlights ? highlights[i + n] : 0, material);
+            kzero_memory(&batch->commands[frame_base + slot], sizeof(VkDrawIndexedIndirectCommand));
+        }
+        i += instance_count;
+        if (instance_count > 1) {
+            counter_add(batch->instanced_draws_counter, instance_count);
+        }
+
+        u32 first_vertex = (u32)(buffer_data->vertex_buffer_offset / buffer_data->vertex_element_size);
+        if (!buffer_data->index_count) {
+            // Not indexed, so drawn directly between the runs of indexed draws.
+            draw_batch_flush(command_buffer, run_start, draw_index);
+            geometry_buffers_bind(command_buffer, buffer_data);
+            vkCmdDraw(command_buffer->handle, buffer_data->vertex_count, instance_count, first_vertex, draw_index);
+            run_start = slot;
+            continue;
+        }
+
+        // Draw only the indices of the requested level of detail, if the geometry has it.
+        u64 index_offset = buffer_data->index_buffer_offset;
+        u32 index_count = buffer_data->index_count;
+        if (g_data->lod < g_data->geometry->lod_count) {
+            const geometry_lod* lod = &g_data->geometry->lods[g_data->lod];
+            index_offset += (u64)lod->index_offset * buffer_data->index_element_size;
+            index_count = lod->index_count;
+        }
+        if (!geometry_buffers_bound(command_buffer, buffer_data)) {
+            draw_batch_flush(command_buffer, run_start, draw_index);
+            geometry_buffers_bind(command_buffer, buffer_data);
+            run_start = draw_index;
+        }
+        VkDrawIndexedIndirectCommand* command = &batch->commands[frame_base + draw_index];
+        command->indexCount = index_count;
+        command->instanceCount = instance_count;
+        command->firstIndex = (u32)(index_offset / buffer_data->index_element_size);
+        command->vertexOffset = (i32)first_vertex;
+        command->firstInstance = draw_index;
+    }
+    draw_batch_flush(command_buffer, run_start, slot);
+}
+
+// Reserves slots in the current frame's batch for the given number of draws, as many as are left.
+static u32 draw_batch_reserve(u32 draw_count) {
+    vulkan_draw_batch* batch = &context.draw_batch;
+    if (draw_count > batch->capacity - batch->used) {
+        KWARN("Batched draws ran out this frame. Increase VULKAN_MAX_BATCHED_DRAWS.");
+        draw_count = batch->capacity - batch->used;
+    }
+    u32 first_slot = batch->used;
+    batch->used += draw_count;
+    return first_slot;
+}
+
+// Binds the draw data set of the given shader in the frame's command buffer, unless it already is. The geometry
+// buffers are bound along with the draws, as those of each geometry's block are needed.
+static void draw_batch_bind(vulkan_command_buffer* command_buffer, vulkan_shader* internal) {
+    vulkan_draw_batch* batch = &context.draw_batch;
+    if (batch->bound_layout == internal->pipeline.pipeline_layout) {
+        counter_add(context.redundant_binds_counter, 1);
+        return;
+    }
+    vkCmdBindDescriptorSets(
+        command_buffer->handle,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        internal->pipeline.pipeline_layout,
+        internal->config.descriptor_set_count,
+        1,
+        &batch->descriptor_sets[context.current_frame],
+        0, 0);
+    batch->bound_layout = internal->pipeline.pipeline_layout;
+}
+
+void vulkan_renderer_draw_geometry_batch(u32 count, const geometry_render_data* data, const u32* highlights) {
+    shader* s = context.bound_shader;
+    if (!s || !(s->flags & SHADER_FLAG_DRAW_DATA)) {
+        KERROR("vulkan_renderer_draw_geometry_batch requires the bound shader to take draw data.");
+        return;
+    }
+    if (context.parallel_renderpass) {
+        KERROR("vulkan_renderer_draw_geometry_batch cannot be called within a renderpass begun for parallel recording.");
+        return;
+    }
+    vulkan_command_buffer* command_buffer = &context.graphics_command_buffers[context.image_index];
+    draw_batch_bind(command_buffer, s->internal_data);
+
+    u32 slot_count = batch_draw_count(count, data);
+    u32 first_slot = draw_batch_reserve(slot_count);
+    slot_count = context.draw_batch.used - first_slot;
+    draw_batch_record(command_buffer, first_slot, slot_count, count, data, highlights, instance_material_index(s->internal_data, s->bound_instance_id));
+}
+
+static b8 recorders_create() {
+    kzero_memory(context.recorders, sizeof(context.recorders));
+    for (u32 i = 0; i < VULKAN_MAX_RECORDERS; ++i) {
+        vulkan_recorder* recorder = &context.recorders[i];
+        for (u32 frame = 0; frame < 2; ++frame) {
+            // Reset as a whole each frame, so their command buffers need not be resettable on their own.
+            VkCommandPoolCreateInfo pool_create_info = {VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+            pool_create_info.queueFamilyIndex = context.device.graphics_queue_index;
+            pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            VkResult result = vkCreateCommandPool(context.device.logical_device, &pool_create_info, context.allocator, &recorder->pools[frame]);
+            if (!vulkan_result_is_success(result)) {
+                KERROR("Failed to create a recorder command pool: '%s'", vulkan_result_string(result, true));
+                return false;
+            }
+            recorder->command_buffers[frame] = darray_create(vulkan_command_buffer);
+        }
+    }
+    return true;
+}
+
+static void recorders_destroy() {
+    for (u32 i = 0; i < VULKAN_MAX_RECORDERS; ++i) {
+        vulkan_recorder* recorder = &context.recorders[i];
+        for (u32 frame = 0; frame < 2; ++frame) {
+            // Destroying the pool frees its command buffers.
+            if (recorder->pools[frame]) {
+                vkDestroyCommandPool(context.device.logical_device, recorder->pools[frame], context.allocator);
+            }
+            if (recorder->command_buffers[frame]) {
+                darray_destroy(recorder->command_buffers[frame]);
+            }
+        }
+    }
+    kzero_memory(context.recorders, sizeof(context.recorders));
+}
+
+// Gets the next secondary command buffer of the given recorder for the current frame, allocating it if
+// there are no more yet. The returned pointer is only valid until the next call for the same recorder.
+static vulkan_command_buffer* recorder_acquire(vulkan_recorder* recorder) {
+    u32 frame = context.current_frame;
+    if (recorder->used == darray_length(recorder->command_buffers[frame])) {
+        vulkan_command_buffer command_buffer;
+        vulkan_command_buffer_allocate(&context, recorder->pools[frame], false, &command_buffer);
+        darray_push(recorder->command_buffers[frame], command_buffer);
+    }
+    counter_add(context.secondary_command_buffers_counter, 1);
+    return &recorder->command_buffers[frame][recorder->used++];
+}
+
+// Binds the global, storage and texture table sets of the given shader in the given command buffer. The
+// globals were written when they were applied, so are only bound here.
+static void shader_global_sets_bind(VkCommandBuffer command_buffer, vulkan_shader* internal) {
+    if (internal->global_uniform_count > 0 || internal->global_uniform_sampler_count > 0) {
+        VkDescriptorSet global_descriptor = internal->global_descriptor_sets[context.image_index];
+        vkCmdBindDescriptorSets(command_buffer, internal->bind_point, internal->pipeline.pipeline_layout, 0, 1, &global_descriptor, 0, 0);
+    }
+    shader_storage_set_bind(command_buffer, internal);
+    shader_bindless_set_bind(command_buffer, internal);
+}
+
+/** @brief The runs of batches one recorder records into one secondary command buffer. */
+typedef struct batch_record_chunk {
+    vulkan_command_buffer* command_buffer;
+    u32 first_run;
+    u32 run_end;
+} batch_record_chunk;
+
+/** @brief What the threads recording batches share. */
+typedef struct batch_record_context {
+    shader* s;
+    const renderer_batch_run* runs;
+    // The first slot and slot count of each run.
+    const u32* run_slots;
+    batch_record_chunk* chunks;
+} batch_record_context;
+
+// Records each of the given chunks into its own secondary command buffer, with all of the state it needs,
+// as secondary command buffers inherit none. Runs on any thread.
+static void batch_chunks_record(u32 start, u32 end, void* user_data) {
+    batch_record_context* record_context = user_data;
+    shader* s = record_context->s;
+    vulkan_shader* internal = s->internal_data;
+    for (u32 c = start; c < end; ++c) {
+        batch_record_chunk* chunk = &record_context->chunks[c];
+        vulkan_command_buffer* command_buffer = chunk->command_buffer;
+        VkCommandBuffer handle = command_buffer->handle;
+        vulkan_command_buffer_begin_secondary(command_buffer, context.parallel_renderpass, context.parallel_framebuffer);
+        viewport_record(handle, context.current_viewport_rect);
+        scissor_record(handle, context.current_scissor_rect);
+
+        vulkan_pipeline_bind(command_buffer, internal->bind_point, shader_variant_pipeline(s));
+        shader_global_sets_bind(handle, internal);
+        vkCmdBindDescriptorSets(
+            handle,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            internal->pipeline.pipeline_layout,
+            internal->config.descriptor_set_count,
+            1,
+            &context.draw_batch.descriptor_sets[context.current_frame],
+            0, 0);
+
+        // Runs of one material split across batches bind it once, and bindless instances share one set.
+        u32 bound_instance_id = INVALID_ID;
+        for (u32 r = chunk->first_run; r < chunk->run_end; ++r) {
+            const renderer_batch_run* run = &record_context->runs[r];
+            u32 first_slot = record_context->run_slots[r * 2];
+            u32 slot_count = record_context->run_slots[r * 2 + 1];
+            if (!slot_count) {
+                continue;
+            }
+            if (instance_set_needs_bind(internal, bound_instance_id, run->instance_id)) {
+                instance_set_bind(handle, internal, &internal->instance_states[run->instance_id]);
+                bound_instance_id = run->instance_id;
+            }
+            draw_batch_record(command_buffer, first_slot, slot_count, run->count, run->geometries, run->highlights, instance_material_index(internal, run->instance_id));
+        }
+    }
+}
+
+void vulkan_renderer_draw_geometry_batches(u32 run_count, const renderer_batch_run* runs) {
+    shader* s = context.bound_shader;
+    if (!s || !(s->flags & SHADER_FLAG_DRAW_DATA)) {
+        KERROR("vulkan_renderer_draw_geometry_batches requires the bound shader to take draw data.");
+        return;
+    }
+    vulkan_shader* internal = s->internal_data;
+    vulkan_command_buffer* command_buffer = &context.graphics_command_buffers[context.image_index];
+
+    if (!context.parallel_renderpass) {
+        // Recorded here, in order, into the frame's command buffer. The globals are bound with the draws, as
+        // another shader may have been used since they were applied, such as for a depth prepass.
+        shader_global_sets_bind(command_buffer->handle, internal);
+        draw_batch_bind(command_buffer, internal);
+        u32 bound_instance_id = INVALID_ID;
+        for (u32 r = 0; r < run_count; ++r) {
+            const renderer_batch_run* run = &runs[r];
+            u32 slot_count = batch_draw_count(run->count, run->geometries);
+            u32 first_slot = draw_batch_reserve(slot_count);
+            slot_count = context.draw_batch.used - first_slot;
+            if (!slot_count) {
+                continue;
+            }
+            if (instance_set_needs_bind(internal, bound_instance_id, run->instance_id)) {
+                instance_set_bind(command_buffer->handle, internal, &internal->instance_states[run->instance_id]);
+                bound_instance_id = run->instance_id;
+            }
+            draw_batch_record(command_buffer, first_slot, slot_count, run->count, run->geometries, run->highlights, instance_material_index(internal, run->instance_id));
+        }
+        return;
+    }
+
+    // Slots are reserved for every run up front, so each thread fills only its own.
+    vulkan_draw_batch* batch = &context.draw_batch;
+    darray_length_set(batch->run_slots, 0);
+    u32 total_draws = 0;
+    for (u32 r = 0; r < run_count; ++r) {
+        u32 slot_count = batch_draw_count(runs[r].count, runs[r].geometries);
+        u32 first_slot = draw_batch_reserve(slot_count);
+        slot_count = batch->used - first_slot;
+        darray_push(batch->run_slots, first_slot);
+        darray_push(batch->run_slots, slot_count);
+        total_draws += slot_count;
+    }
+    if (!total_draws) {
+        return;
+    }
+
+    // Split the runs into chunks of about as many draws, none too small to be worth a thread of its own.
+    u32 chunk_count = KMAX(KMIN(total_draws / VULKAN_RECORDER_MIN_DRAWS, VULKAN_MAX_RECORDERS), 1);
+    u32 draws_per_chunk = (total_draws + chunk_count - 1) / chunk_count;
+    batch_record_chunk chunks[VULKAN_MAX_RECORDERS];
+    u32 used_chunks = 0;
+    u32 chunk_draws = 0;
+    for (u32 r = 0; r < run_count; ++r) {
+        if (chunk_draws == 0) {
+            chunks[used_chunks].first_run = r;
         }
-
-        // Free index data, if applicable
-        if (old_range.index_element_size > 0) {
-            if (!renderer_renderbuffer_free(&context.object_index_buffer, old_range.index_element_size * old_range.index_count, old_range.index_buffer_offset)) {
-                KERROR("vulkan_renderer_create_geometry free operation failed during reupload of index data.");
-                return false;
-            }
+        chunk_draws += batch->run_slots[r * 2 + 1];
+        if ((chunk_draws >= draws_per_chunk && used_chunks < chunk_count - 1) || r == run_count - 1) {
+            chunks[used_chunks].run_end = r + 1;
+            // Each chunk has a recorder of its own, so no pool is used by two threads at once.
+            chunks[used_chunks].command_buffer = recorder_acquire(&context.recorders[used_chunks]);
+            used_chunks++;
+            chunk_draws = 0;
         }
     }
 
-    return true;
+    batch_record_context record_context;
+    record_context.s = s;
+    record_context.runs = runs;
+    record_context.run_slots = batch->run_slots;
+    record_context.chunks = chunks;
+    job_system_parallel_for(used_chunks, 1, batch_chunks_record, &record_context);
+
+    // Executed in order, so the draws are as if recorded here.
+    VkCommandBuffer handles[VULKAN_MAX_RECORDERS];
+    for (u32 c = 0; c < used_chunks; ++c) {
+        vulkan_command_buffer_end(chunks[c].command_buffer);
+        handles[c] = chunks[c].command_buffer->handle;
+    }
+    vkCmdExecuteCommands(command_buffer->handle, used_chunks, handles);
+
+    // The frame's command buffer's bindings are undefined after executing others.
+    context.bound_graphics_pipeline = 0;
+    command_buffer->bound_geometry_block = INVALID_ID;
+    command_buffer->bound_index_size = 0;
+    command_buffer->bound_vertex_set_layout = 0;
+    batch->bound_layout = 0;
 }
 
-void vulkan_renderer_destroy_geometry(geometry* geometry) {
-    if (geometry && geometry->internal_id != INVALID_ID) {
-        vkDeviceWaitIdle(context.device.logical_device);
-        vulkan_geometry_data* internal_data = &context.geometries[geometry->internal_id];
+static void bindless_textures_create() {
+    vulkan_bindless_textures* table = &context.bindless;
+    table->capacity = 0;
+    if (!context.device.supports_bindless) {
+        return;
+    }
 
-        // Free vertex data
-        if (!renderer_renderbuffer_free(&context.object_vertex_buffer, internal_data->vertex_element_size * internal_data->vertex_count, internal_data->vertex_buffer_offset)) {
-            KERROR("vulkan_renderer_destroy_geometry failed to free vertex buffer range.");
-        }
+    // As many entries as the device allows bound at once, up to the maximum.
+    VkPhysicalDeviceDescriptorIndexingProperties indexing_properties = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES};
+    VkPhysicalDeviceProperties2 properties2 = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
+    properties2.pNext = &indexing_properties;
+    vkGetPhysicalDeviceProperties2(context.device.physical_device, &properties2);
+    u32 capacity = VULKAN_BINDLESS_MAX_TEXTURES;
+    capacity = KMIN(capacity, indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages);
+    capacity = KMIN(capacity, indexing_properties.maxDescriptorSetUpdateAfterBindSamplers);
+    // Some of the per-stage budget is left to the shader's own samplers.
+    capacity = KMIN(capacity, indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages - VULKAN_SHADER_MAX_GLOBAL_TEXTURES);
+    capacity = KMIN(capacity, indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers - VULKAN_SHADER_MAX_GLOBAL_TEXTURES);
+
+    VkDescriptorSetLayoutBinding binding = {0};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = capacity;
+    binding.stageFlags = VK_SHADER_STAGE_ALL;
+    // Entries not used by frames in flight are written while the set is bound, and only those
+    // referenced by an instance are ever valid.
+    VkDescriptorBindingFlags binding_flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+    VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO};
+    binding_flags_info.bindingCount = 1;
+    binding_flags_info.pBindingFlags = &binding_flags;
+    VkDescriptorSetLayoutCreateInfo layout_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    layout_info.pNext = &binding_flags_info;
+    layout_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    layout_info.bindingCount = 1;
+    layout_info.pBindings = &binding;
+    VkResult result = vkCreateDescriptorSetLayout(context.device.logical_device, &layout_info, context.allocator, &table->layout);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("Failed to create the bindless texture set layout: '%s'. Bindless shaders are not available.", vulkan_result_string(result, true));
+        return;
+    }
 
-        // Free index data, if applicable
-        if (internal_data->index_element_size > 0) {
-            if (!renderer_renderbuffer_free(&context.object_index_buffer, internal_data->index_element_size * internal_data->index_count, internal_data->index_buffer_offset)) {
-                KERROR("vulkan_renderer_destroy_geometry failed to free index buffer range.");
-            }
-        }
+    VkDescriptorPoolSize pool_size = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, capacity};
+    VkDescriptorPoolCreateInfo pool_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+    pool_info.maxSets = 1;
+    result = vkCreateDescriptorPool(context.device.logical_device, &pool_info, context.allocator, &table->pool);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("Failed to create the bindless texture descriptor pool: '%s'. Bindless shaders are not available.", vulkan_result_string(result, true));
+        bindless_textures_destroy();
+        return;
+    }
 
-        // Clean up data.
-        kzero_memory(internal_data, sizeof(vulkan_geometry_data));
-        internal_data->id = INVALID_ID;
-        internal_data->generation = INVALID_ID;
+    VkDescriptorSetAllocateInfo alloc_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    alloc_info.descriptorPool = table->pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &table->layout;
+    result = vkAllocateDescriptorSets(context.device.logical_device, &alloc_info, &table->set);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("Failed to allocate the bindless texture set: '%s'. Bindless shaders are not available.", vulkan_result_string(result, true));
+        bindless_textures_destroy();
+        return;
+    }
+
+    table->capacity = capacity;
+    table->used_count = 0;
+    table->free_slots = darray_create(u32);
+    KINFO("Bindless texture table created with %u entries.", capacity);
+}
+
+static void bindless_textures_destroy() {
+    vulkan_bindless_textures* table = &context.bindless;
+    if (table->pool) {
+        vkDestroyDescriptorPool(context.device.logical_device, table->pool, context.allocator);
+    }
+    if (table->layout) {
+        vkDestroyDescriptorSetLayout(context.device.logical_device, table->layout, context.allocator);
     }
+    if (table->free_slots) {
+        darray_destroy(table->free_slots);
+    }
+    kzero_memory(table, sizeof(vulkan_bindless_textures));
 }
 
-void vulkan_renderer_draw_geometry(geometry_render_data* data) {
-    // Ignore non-uploaded geometries.
-    if (data->geometry && data->geometry->internal_id == INVALID_ID) {
+// Sets the given bytes of a shader's copy of its uniform buffer, marking them to be copied over if they changed.
+static void uniform_shadow_write(vulkan_shader* internal, u64 offset, const void* value, u64 size) {
+    if (!internal->uniform_shadow || offset + size > internal->uniform_shadow_size) {
+        KERROR("uniform_shadow_write - Uniform out of range of the uniform buffer. Nothing was set.");
         return;
     }
-
-    vulkan_geometry_data* buffer_data = &context.geometries[data->geometry->internal_id];
-    b8 includes_index_data = buffer_data->index_count > 0;
-    if (!vulkan_buffer_draw(&context.object_vertex_buffer, buffer_data->vertex_buffer_offset, buffer_data->vertex_count, includes_index_data)) {
-        KERROR("vulkan_renderer_draw_geometry failed to draw vertex buffer;");
+    u8* dest = internal->uniform_shadow + offset;
+    const u8* source = value;
+    u64 first = 0;
+    while (first < size && dest[first] == source[first]) {
+        first++;
+    }
+    if (first == size) {
+        // Unchanged, so nothing need be copied.
         return;
     }
+    u64 last = size;
+    while (dest[last - 1] == source[last - 1]) {
+        last--;
+    }
+    kcopy_memory(dest + first, source + first, last - first);
 
-    if (includes_index_data) {
-        if (!vulkan_buffer_draw(&context.object_index_buffer, buffer_data->index_buffer_offset, buffer_data->index_count, !includes_index_data)) {
-            KERROR("vulkan_renderer_draw_geometry failed to draw index buffer;");
-            return;
-        }
+    u64 start = offset + first;
+    u64 end = offset + last;
+    if (internal->uniform_dirty_start == internal->uniform_dirty_end) {
+        internal->uniform_dirty_start = start;
+        internal->uniform_dirty_end = end;
+    } else {
+        internal->uniform_dirty_start = KMIN(internal->uniform_dirty_start, start);
+        internal->uniform_dirty_end = KMAX(internal->uniform_dirty_end, end);
+    }
+}
+
+// Copies the bytes of a shader's uniforms changed since last time over to its uniform buffer, in one copy.
+static void uniform_shadow_flush(vulkan_shader* internal) {
+    if (internal->uniform_dirty_start == internal->uniform_dirty_end) {
+        return;
     }
+    u64 start = internal->uniform_dirty_start;
+    kcopy_memory((u8*)internal->mapped_uniform_buffer_block + start, internal->uniform_shadow + start, internal->uniform_dirty_end - start);
+    internal->uniform_dirty_start = 0;
+    internal->uniform_dirty_end = 0;
+}
+
+b8 vulkan_renderer_bindless_supported() {
+    return context.bindless.capacity > 0;
+}
+
+// Writes the given view and sampler into an unused entry of the texture table, returning its index,
+// or INVALID_ID if the table is full.
+static u32 bindless_slot_write(VkImageView view, VkSampler sampler, VkImageLayout layout) {
+    vulkan_bindless_textures* table = &context.bindless;
+    u32 index = INVALID_ID;
+    u32 free_count = darray_length(table->free_slots);
+    if (free_count > 0) {
+        darray_pop(table->free_slots, &index);
+    } else if (table->used_count < table->capacity) {
+        index = table->used_count++;
+    } else {
+        KERROR("The bindless texture table is full. Increase VULKAN_BINDLESS_MAX_TEXTURES, if the device allows it.");
+        return INVALID_ID;
+    }
+
+    VkDescriptorImageInfo image_info;
+    image_info.sampler = sampler;
+    image_info.imageView = view;
+    image_info.imageLayout = layout;
+    VkWriteDescriptorSet write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+    write.dstSet = table->set;
+    write.dstBinding = 0;
+    write.dstArrayElement = index;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.descriptorCount = 1;
+    write.pImageInfo = &image_info;
+    vkUpdateDescriptorSets(context.device.logical_device, 1, &write, 0, 0);
+    counter_add(context.descriptor_writes_counter, 1);
+    return index;
+}
+
+// Frees the given texture table entry once the frames in flight which may sample it complete.
+static void bindless_slot_release(vulkan_bindless_slot* slot) {
+    if (slot->index != INVALID_ID) {
+        vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_BINDLESS_SLOT};
+        deletion.bindless_slot = slot->index;
+        deferred_delete(&deletion);
+    }
+    slot->index = INVALID_ID;
+    slot->view = 0;
+    slot->sampler = 0;
+    slot->generation = INVALID_ID;
 }
 
 // The index of the global descriptor set.
@@ -1335,7 +4400,6 @@ b8 vulkan_renderer_shader_create(shader* s, const shader_config* config, renderp
                 vk_stages[i] = VK_SHADER_STAGE_GEOMETRY_BIT;
                 break;
             case SHADER_STAGE_COMPUTE:
-                KWARN("vulkan_renderer_shader_create: SHADER_STAGE_COMPUTE is set but not yet supported.");
                 vk_stages[i] = VK_SHADER_STAGE_COMPUTE_BIT;
                 break;
             default:
@@ -1344,17 +4408,23 @@ b8 vulkan_renderer_shader_create(shader* s, const shader_config* config, renderp
         }
     }
 
-    // TODO: configurable max descriptor allocate count.
-
-    u32 max_descriptor_allocate_count = 1024;
-
     // Take a copy of the pointer to the context.
     vulkan_shader* internal_shader = (vulkan_shader*)s->internal_data;
 
-    internal_shader->renderpass = pass->internal_data;
+    // Bindless instances take no descriptor sets of their own, so there can be many more of them.
+    b8 is_bindless = (s->flags & SHADER_FLAG_BINDLESS) != 0;
+    if (is_bindless && !vulkan_renderer_bindless_supported()) {
+        KERROR("vulkan_renderer_shader_create: shader '%s' is bindless, which this device does not support.", s->name);
+        return false;
+    }
+    internal_shader->instance_capacity = is_bindless ? VULKAN_BINDLESS_MAX_MATERIAL_COUNT : VULKAN_MAX_MATERIAL_COUNT;
+    internal_shader->instance_states = kallocate(sizeof(vulkan_shader_instance_state) * internal_shader->instance_capacity, MEMORY_TAG_RENDERER);
 
-    // Build out the configuration.
-    internal_shader->config.max_descriptor_set_count = max_descriptor_allocate_count;
+    // Compute shaders are used outside of renderpasses, so have none.
+    b8 is_compute = (s->flags & SHADER_FLAG_COMPUTE) != 0;
+    internal_shader->renderpass = is_compute ? 0 : pass->internal_data;
+    internal_shader->bind_point = is_compute ? VK_PIPELINE_BIND_POINT_COMPUTE : VK_PIPELINE_BIND_POINT_GRAPHICS;
+    internal_shader->stage_flags = is_compute ? VK_SHADER_STAGE_COMPUTE_BIT : (VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
 
     // Shader stages. Parse out the flags.
     kzero_memory(internal_shader->config.stages, sizeof(vulkan_shader_stage_config) * VULKAN_SHADER_MAX_STAGES);
@@ -1376,6 +4446,9 @@ b8 vulkan_renderer_shader_create(shader* s, const shader_config* config, renderp
             case SHADER_STAGE_FRAGMENT:
                 stage_flag = VK_SHADER_STAGE_FRAGMENT_BIT;
                 break;
+            case SHADER_STAGE_COMPUTE:
+                stage_flag = VK_SHADER_STAGE_COMPUTE_BIT;
+                break;
             default:
                 // Go to the next type.
                 KERROR("vulkan_shader_create: Unsupported shader stage flagged: %d. Stage ignored.", stages[i]);
@@ -1389,9 +4462,10 @@ b8 vulkan_renderer_shader_create(shader* s, const shader_config* config, renderp
     }
 
     // Zero out arrays and counts.
-    kzero_memory(internal_shader->config.descriptor_sets, sizeof(vulkan_descriptor_set_config) * 2);
-    internal_shader->config.descriptor_sets[0].sampler_binding_index = INVALID_ID_U8;
-    internal_shader->config.descriptor_sets[1].sampler_binding_index = INVALID_ID_U8;
+    kzero_memory(internal_shader->config.descriptor_sets, sizeof(vulkan_descriptor_set_config) * VULKAN_SHADER_MAX_DESCRIPTOR_SETS);
+    for (u32 i = 0; i < VULKAN_SHADER_MAX_DESCRIPTOR_SETS; ++i) {
+        internal_shader->config.descriptor_sets[i].sampler_binding_index = INVALID_ID_U8;
+    }
 
     // Attributes array.
     kzero_memory(internal_shader->config.attributes, sizeof(VkVertexInputAttributeDescription) * VULKAN_SHADER_MAX_ATTRIBUTES);
@@ -1402,8 +4476,14 @@ b8 vulkan_renderer_shader_create(shader* s, const shader_config* config, renderp
     internal_shader->instance_uniform_count = 0;
     internal_shader->instance_uniform_sampler_count = 0;
     internal_shader->local_uniform_count = 0;
+    u32 storage_binding_count = 0;
     u32 total_count = darray_length(config->uniforms);
     for (u32 i = 0; i < total_count; ++i) {
+        if (config->uniforms[i].type == SHADER_UNIFORM_TYPE_STORAGE_BUFFER || config->uniforms[i].type == SHADER_UNIFORM_TYPE_STORAGE_IMAGE) {
+            // Storage bindings have a set of their own, whatever their scope.
+            storage_binding_count++;
+            continue;
+        }
         switch (config->uniforms[i].scope) {
             case SHADER_SCOPE_GLOBAL:
                 if (config->uniforms[i].type == SHADER_UNIFORM_TYPE_SAMPLER) {
@@ -1425,9 +4505,35 @@ b8 vulkan_renderer_shader_create(shader* s, const shader_config* config, renderp
         }
     }
 
-    // For now, shaders will only ever have these 2 types of descriptor pools.
-    internal_shader->config.pool_sizes[0] = (VkDescriptorPoolSize){VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1024};          // HACK: max number of ubo descriptor sets.
-    internal_shader->config.pool_sizes[1] = (VkDescriptorPoolSize){VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4096};  // HACK: max number of image sampler descriptor sets.
+    if (storage_binding_count > VULKAN_SHADER_MAX_STORAGE_BINDINGS) {
+        KERROR("Shaders may have a maximum of %d storage buffers and images combined.", VULKAN_SHADER_MAX_STORAGE_BINDINGS);
+        return false;
+    }
+
+    // The pool holds the global and storage sets, one per frame, and the instance sets: one per frame for each
+    // instance, or a single one shared by every instance of a bindless shader.
+    b8 has_instance_ubo = internal_shader->instance_uniform_count > 0 || (is_bindless && internal_shader->instance_uniform_sampler_count > 0);
+    b8 has_instance_samplers = !is_bindless && internal_shader->instance_uniform_sampler_count > 0;
+    u32 instance_set_count = is_bindless ? 1 : 3 * internal_shader->instance_capacity;
+    u32 ubo_count = (internal_shader->global_uniform_count > 0 ? 3 : 0) + (!is_bindless && has_instance_ubo ? instance_set_count : 0);
+    u32 sampler_count = 3 * internal_shader->global_uniform_sampler_count + (has_instance_samplers ? instance_set_count * internal_shader->instance_uniform_sampler_count : 0);
+    VkDescriptorPoolSize* pool_sizes = internal_shader->config.pool_sizes;
+    u8 pool_size_count = 0;
+    if (ubo_count > 0) {
+        pool_sizes[pool_size_count++] = (VkDescriptorPoolSize){VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, ubo_count};
+    }
+    if (is_bindless && has_instance_ubo) {
+        pool_sizes[pool_size_count++] = (VkDescriptorPoolSize){VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1};
+    }
+    if (sampler_count > 0) {
+        pool_sizes[pool_size_count++] = (VkDescriptorPoolSize){VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, sampler_count};
+    }
+    if (storage_binding_count > 0) {
+        pool_sizes[pool_size_count++] = (VkDescriptorPoolSize){VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * storage_binding_count};
+        pool_sizes[pool_size_count++] = (VkDescriptorPoolSize){VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 3 * storage_binding_count};
+    }
+    internal_shader->config.pool_size_count = pool_size_count;
+    internal_shader->config.max_descriptor_set_count = 3 + 3 + instance_set_count;
 
     // Global descriptor set config.
     if (internal_shader->global_uniform_count > 0 || internal_shader->global_uniform_sampler_count > 0) {
@@ -1440,7 +4546,7 @@ b8 vulkan_renderer_shader_create(shader* s, const shader_config* config, renderp
             set_config->bindings[binding_index].binding = binding_index;
             set_config->bindings[binding_index].descriptorCount = 1;
             set_config->bindings[binding_index].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            set_config->bindings[binding_index].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+            set_config->bindings[binding_index].stageFlags = internal_shader->stage_flags;
             set_config->binding_count++;
         }
 
@@ -1450,7 +4556,7 @@ b8 vulkan_renderer_shader_create(shader* s, const shader_config* config, renderp
             set_config->bindings[binding_index].binding = binding_index;
             set_config->bindings[binding_index].descriptorCount = internal_shader->global_uniform_sampler_count;  // One descriptor per sampler.
             set_config->bindings[binding_index].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            set_config->bindings[binding_index].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+            set_config->bindings[binding_index].stageFlags = internal_shader->stage_flags;
             set_config->sampler_binding_index = binding_index;
             set_config->binding_count++;
         }
@@ -1461,25 +4567,27 @@ b8 vulkan_renderer_shader_create(shader* s, const shader_config* config, renderp
 
     // If using instance uniforms, add a UBO descriptor set.
     if (internal_shader->instance_uniform_count > 0 || internal_shader->instance_uniform_sampler_count > 0) {
-        // In that set, add a binding for UBO if used.
+        // In that set, add a binding for UBO if used. Bindless samplers are indices in it too. Bindless
+        // instances share the set, which holds the whole uniform buffer as a storage table of materials,
+        // each found by the draw data of its draws.
         vulkan_descriptor_set_config* set_config = &internal_shader->config.descriptor_sets[internal_shader->config.descriptor_set_count];
 
-        if (internal_shader->instance_uniform_count > 0) {
+        if (has_instance_ubo) {
             u8 binding_index = set_config->binding_count;
             set_config->bindings[binding_index].binding = binding_index;
             set_config->bindings[binding_index].descriptorCount = 1;
-            set_config->bindings[binding_index].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            set_config->bindings[binding_index].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+            set_config->bindings[binding_index].descriptorType = is_bindless ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            set_config->bindings[binding_index].stageFlags = internal_shader->stage_flags;
             set_config->binding_count++;
         }
 
         // Add a binding for Samplers if used.
-        if (internal_shader->instance_uniform_sampler_count > 0) {
+        if (has_instance_samplers) {
             u8 binding_index = set_config->binding_count;
             set_config->bindings[binding_index].binding = binding_index;
             set_config->bindings[binding_index].descriptorCount = internal_shader->instance_uniform_sampler_count;  // One descriptor per sampler.
             set_config->bindings[binding_index].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            set_config->bindings[binding_index].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+            set_config->bindings[binding_index].stageFlags = internal_shader->stage_flags;
             set_config->sampler_binding_index = binding_index;
             set_config->binding_count++;
         }
@@ -1488,9 +4596,46 @@ b8 vulkan_renderer_shader_create(shader* s, const shader_config* config, renderp
         internal_shader->config.descriptor_set_count++;
     }
 
+    // Storage buffers and images follow in a set of their own, a binding each, in configured order.
+    internal_shader->storage_set_index = INVALID_ID_U8;
+    if (storage_binding_count > 0) {
+        internal_shader->storage_set_index = internal_shader->config.descriptor_set_count;
+        vulkan_descriptor_set_config* set_config = &internal_shader->config.descriptor_sets[internal_shader->config.descriptor_set_count];
+        for (u32 i = 0; i < total_count; ++i) {
+            shader_uniform_type type = config->uniforms[i].type;
+            if (type != SHADER_UNIFORM_TYPE_STORAGE_BUFFER && type != SHADER_UNIFORM_TYPE_STORAGE_IMAGE) {
+                continue;
+            }
+            u8 binding_index = set_config->binding_count;
+            set_config->bindings[binding_index].binding = binding_index;
+            set_config->bindings[binding_index].descriptorCount = 1;
+            set_config->bindings[binding_index].descriptorType = type == SHADER_UNIFORM_TYPE_STORAGE_BUFFER ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            set_config->bindings[binding_index].stageFlags = internal_shader->stage_flags;
+            set_config->binding_count++;
+        }
+        internal_shader->config.descriptor_set_count++;
+    }
+
+    // The texture table of bindless shaders follows their own sets and the draw data set.
+    internal_shader->bindless_set_index = INVALID_ID_U8;
+    if (is_bindless) {
+        internal_shader->bindless_set_index = internal_shader->config.descriptor_set_count + ((s->flags & SHADER_FLAG_DRAW_DATA) ? 1 : 0);
+    }
+
+    // The frame uniform arena set of shaders with local uniform buffers follows all others.
+    internal_shader->local_set_index = INVALID_ID_U8;
+    if (s->flags & SHADER_FLAG_LOCAL_UBO) {
+        internal_shader->local_set_index = internal_shader->config.descriptor_set_count + ((s->flags & SHADER_FLAG_DRAW_DATA) ? 1 : 0) + (is_bindless ? 1 : 0);
+    }
+
+    // The vertex set of shaders pulling their vertices follows every other.
+    internal_shader->vertex_set_index = INVALID_ID_U8;
+    if (s->flags & SHADER_FLAG_VERTEX_PULLING) {
+        internal_shader->vertex_set_index = internal_shader->config.descriptor_set_count + ((s->flags & SHADER_FLAG_DRAW_DATA) ? 1 : 0) + (is_bindless ? 1 : 0) + ((s->flags & SHADER_FLAG_LOCAL_UBO) ? 1 : 0);
+    }
+
     // Invalidate all instance states.
-    // TODO: dynamic
-    for (u32 i = 0; i < 1024; ++i) {
+    for (u32 i = 0; i < internal_shader->instance_capacity; ++i) {
         internal_shader->instance_states[i].id = INVALID_ID;
     }
 
@@ -1508,35 +4653,64 @@ void vulkan_renderer_shader_destroy(shader* s) {
             return;
         }
 
-        VkDevice logical_device = context.device.logical_device;
-        VkAllocationCallbacks* vk_allocator = context.allocator;
+        // Frames in flight may still be using the shader, so its objects are destroyed once they finish,
+        // with any descriptor sets released before the pool they came from.
+        vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_DESCRIPTOR_SET_LAYOUT};
 
         // Descriptor set layouts.
         for (u32 i = 0; i < shader->config.descriptor_set_count; ++i) {
             if (shader->descriptor_set_layouts[i]) {
-                vkDestroyDescriptorSetLayout(logical_device, shader->descriptor_set_layouts[i], vk_allocator);
+                deletion.descriptor_set_layout = shader->descriptor_set_layouts[i];
+                deferred_delete(&deletion);
                 shader->descriptor_set_layouts[i] = 0;
             }
         }
 
         // Descriptor pool
         if (shader->descriptor_pool) {
-            vkDestroyDescriptorPool(logical_device, shader->descriptor_pool, vk_allocator);
+            deletion.type = VULKAN_DEFERRED_DELETION_TYPE_DESCRIPTOR_POOL;
+            deletion.descriptor_pool = shader->descriptor_pool;
+            deferred_delete(&deletion);
+            shader->descriptor_pool = 0;
         }
 
-        // Uniform buffer.
-        vulkan_buffer_unmap_memory(&shader->uniform_buffer, 0, VK_WHOLE_SIZE);
-        shader->mapped_uniform_buffer_block = 0;
-        renderer_renderbuffer_destroy(&shader->uniform_buffer);
+        // Uniform buffer, which shaders with no uniform buffer objects don't have.
+        if (shader->uniform_buffer.internal_data) {
+            vulkan_buffer_unmap_memory(&shader->uniform_buffer, 0, VK_WHOLE_SIZE);
+            shader->mapped_uniform_buffer_block = 0;
+            renderer_renderbuffer_destroy(&shader->uniform_buffer);
+        }
+        if (shader->uniform_shadow) {
+            kfree(shader->uniform_shadow, shader->uniform_shadow_size, MEMORY_TAG_RENDERER);
+            shader->uniform_shadow = 0;
+            shader->uniform_shadow_size = 0;
+        }
 
-        // Pipeline
-        vulkan_pipeline_destroy(&context, &shader->pipeline);
+        // Pipelines
+        deletion.type = VULKAN_DEFERRED_DELETION_TYPE_PIPELINE;
+        deletion.pipeline = shader->pipeline;
+        deferred_delete(&deletion);
+        for (u32 i = 1; i < s->variant_count; ++i) {
+            deletion.pipeline = shader->variant_pipelines[i];
+            deferred_delete(&deletion);
+        }
 
         // Shader modules
         for (u32 i = 0; i < shader->config.stage_count; ++i) {
             vkDestroyShaderModule(context.device.logical_device, shader->stages[i].handle, context.allocator);
         }
 
+        if (shader->local_block) {
+            kfree(shader->local_block, s->local_ubo_size, MEMORY_TAG_RENDERER);
+            shader->local_block = 0;
+        }
+
+        // Instance states. The instance sets go with the pool.
+        if (shader->instance_states) {
+            kfree(shader->instance_states, sizeof(vulkan_shader_instance_state) * shader->instance_capacity, MEMORY_TAG_RENDERER);
+            shader->instance_states = 0;
+        }
+
         // Destroy the configuration.
         kzero_memory(&shader->config, sizeof(vulkan_shader_config));
 
@@ -1546,11 +4720,134 @@ void vulkan_renderer_shader_destroy(shader* s) {
     }
 }
 
+// Creates the graphics or compute pipeline for the given variant of the given shader from the given stage modules.
+static b8 shader_pipeline_create(shader* s, const vulkan_shader_stage* stages, u32 variant, vulkan_pipeline* out_pipeline) {
+    vulkan_shader* internal_shader = (vulkan_shader*)s->internal_data;
+
+    if (s->flags & SHADER_FLAG_COMPUTE) {
+        return vulkan_compute_pipeline_create(
+            &context,
+            &stages[0].shader_stage_create_info,
+            internal_shader->config.descriptor_set_count,
+            internal_shader->descriptor_set_layouts,
+            (u32)s->push_constant_size,
+            out_pipeline);
+    }
+
+    // TODO: This feels wrong to have these here, at least in this fashion. Should probably
+    // Be configured to pull from someplace instead.
+    // Viewport.
+    VkViewport viewport;
+    viewport.x = 0.0f;
+    viewport.y = (f32)context.framebuffer_height;
+    viewport.width = (f32)context.framebuffer_width;
+    viewport.height = -(f32)context.framebuffer_height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+
+    // Scissor
+    VkRect2D scissor;
+    scissor.offset.x = scissor.offset.y = 0;
+    scissor.extent.width = context.framebuffer_width;
+    scissor.extent.height = context.framebuffer_height;
+
+    // The variant is specialization constant 0 of every stage, which those not declaring it ignore.
+    VkSpecializationMapEntry variant_entry = {0, 0, sizeof(u32)};
+    VkSpecializationInfo specialization_info = {0};
+    specialization_info.mapEntryCount = 1;
+    specialization_info.pMapEntries = &variant_entry;
+    specialization_info.dataSize = sizeof(u32);
+    specialization_info.pData = &variant;
+
+    VkPipelineShaderStageCreateInfo stage_create_infos[VULKAN_SHADER_MAX_STAGES];
+    kzero_memory(stage_create_infos, sizeof(VkPipelineShaderStageCreateInfo) * VULKAN_SHADER_MAX_STAGES);
+    for (u32 i = 0; i < internal_shader->config.stage_count; ++i) {
+        stage_create_infos[i] = stages[i].shader_stage_create_info;
+        if (s->variant_count) {
+            stage_create_infos[i].pSpecializationInfo = &specialization_info;
+        }
+    }
+
+    vulkan_pipeline_config pipeline_config = {0};
+    pipeline_config.renderpass = internal_shader->renderpass;
+    pipeline_config.stride = s->attribute_stride;
+    pipeline_config.attribute_count = darray_length(s->attributes);
+    pipeline_config.attributes = internal_shader->config.attributes;  // shader->attributes,
+    // Shaders taking draw data read it from the draw batch's set, which follows their own global and instance sets.
+    VkDescriptorSetLayout set_layouts[VULKAN_SHADER_MAX_DESCRIPTOR_SETS + 4];
+    u32 set_layout_count = internal_shader->config.descriptor_set_count;
+    kcopy_memory(set_layouts, internal_shader->descriptor_set_layouts, sizeof(VkDescriptorSetLayout) * set_layout_count);
+    if (s->flags & SHADER_FLAG_DRAW_DATA) {
+        set_layouts[set_layout_count++] = context.draw_batch.set_layout;
+    }
+    // Bindless shaders read their instance textures from the texture table, which follows.
+    if (s->flags & SHADER_FLAG_BINDLESS) {
+        set_layouts[set_layout_count++] = context.bindless.layout;
+    }
+    // Shaders with local uniform buffers read them from the frame uniform arena, after all others.
+    if (s->flags & SHADER_FLAG_LOCAL_UBO) {
+        set_layouts[set_layout_count++] = context.frame_uniforms.set_layout;
+    }
+    // Shaders pulling their vertices read them from the vertex set, last of all.
+    if (s->flags & SHADER_FLAG_VERTEX_PULLING) {
+        set_layouts[set_layout_count++] = context.vertex_set_layout;
+    }
+    pipeline_config.descriptor_set_layout_count = set_layout_count;
+    pipeline_config.descriptor_set_layouts = set_layouts;
+    pipeline_config.stage_count = internal_shader->config.stage_count;
+    pipeline_config.stages = stage_create_infos;
+    pipeline_config.viewport = viewport;
+    pipeline_config.scissor = scissor;
+    pipeline_config.cull_mode = internal_shader->config.cull_mode;
+    pipeline_config.is_wireframe = false;
+    pipeline_config.shader_flags = s->flags;
+    pipeline_config.push_constant_range_count = s->push_constant_range_count;
+    pipeline_config.push_constant_ranges = s->push_constant_ranges;
+
+    return vulkan_graphics_pipeline_create(&context, &pipeline_config, out_pipeline);
+}
+
+// Creates the pipeline of every variant of the given shader from the given stage modules, through the
+// pipeline cache. If any fails, those already created are destroyed.
+static b8 shader_pipelines_create(shader* s, const vulkan_shader_stage* stages, vulkan_pipeline* out_pipeline, vulkan_pipeline* out_variant_pipelines) {
+    if (!shader_pipeline_create(s, stages, 0, out_pipeline)) {
+        return false;
+    }
+    for (u32 i = 1; i < s->variant_count; ++i) {
+        if (!shader_pipeline_create(s, stages, i, &out_variant_pipelines[i])) {
+            KERROR("Failed to create the pipeline of variant '%s' of shader '%s'.", s->variant_names[i], s->name);
+            for (u32 j = 1; j < i; ++j) {
+                vulkan_pipeline_destroy(&context, &out_variant_pipelines[j]);
+            }
+            vulkan_pipeline_destroy(&context, out_pipeline);
+            return false;
+        }
+    }
+    return true;
+}
+
+// The pipeline of the variant the given shader draws with.
+static vulkan_pipeline* shader_variant_pipeline(shader* s) {
+    vulkan_shader* internal = s->internal_data;
+    return s->variant ? &internal->variant_pipelines[s->variant] : &internal->pipeline;
+}
+
 b8 vulkan_renderer_shader_initialize(shader* s) {
     VkDevice logical_device = context.device.logical_device;
     VkAllocationCallbacks* vk_allocator = context.allocator;
     vulkan_shader* internal_shader = (vulkan_shader*)s->internal_data;
 
+    // Locals, once all are added, are held until applied if the shader takes them in a uniform buffer.
+    if (s->flags & SHADER_FLAG_LOCAL_UBO) {
+        if (s->local_ubo_size > VULKAN_SHADER_MAX_LOCAL_UBO_SIZE) {
+            KERROR("The locals of shader '%s' take %llu bytes, but at most %u are supported.", s->name, s->local_ubo_size, VULKAN_SHADER_MAX_LOCAL_UBO_SIZE);
+            return false;
+        }
+        if (s->local_ubo_size) {
+            internal_shader->local_block = kallocate(s->local_ubo_size, MEMORY_TAG_RENDERER);
+        }
+    }
+
     // Create a module for each stage.
     kzero_memory(internal_shader->stages, sizeof(vulkan_shader_stage) * VULKAN_SHADER_MAX_STAGES);
     for (u32 i = 0; i < internal_shader->config.stage_count; ++i) {
@@ -1562,7 +4859,7 @@ b8 vulkan_renderer_shader_initialize(shader* s) {
 
     // Static lookup table for our types->Vulkan ones.
     static VkFormat* types = 0;
-    static VkFormat t[11];
+    static VkFormat t[14];
     if (!types) {
         t[SHADER_ATTRIB_TYPE_FLOAT32] = VK_FORMAT_R32_SFLOAT;
         t[SHADER_ATTRIB_TYPE_FLOAT32_2] = VK_FORMAT_R32G32_SFLOAT;
@@ -1574,6 +4871,9 @@ b8 vulkan_renderer_shader_initialize(shader* s) {
         t[SHADER_ATTRIB_TYPE_UINT16] = VK_FORMAT_R16_UINT;
         t[SHADER_ATTRIB_TYPE_INT32] = VK_FORMAT_R32_SINT;
         t[SHADER_ATTRIB_TYPE_UINT32] = VK_FORMAT_R32_UINT;
+        t[SHADER_ATTRIB_TYPE_SNORM16_2] = VK_FORMAT_R16G16_SNORM;
+        t[SHADER_ATTRIB_TYPE_FLOAT16_2] = VK_FORMAT_R16G16_SFLOAT;
+        t[SHADER_ATTRIB_TYPE_UNORM8_4] = VK_FORMAT_R8G8B8A8_UNORM;
         types = t;
     }
 
@@ -1594,18 +4894,21 @@ b8 vulkan_renderer_shader_initialize(shader* s) {
         offset += s->attributes[i].size;
     }
 
-    // Descriptor pool.
-    VkDescriptorPoolCreateInfo pool_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
-    pool_info.poolSizeCount = 2;
-    pool_info.pPoolSizes = internal_shader->config.pool_sizes;
-    pool_info.maxSets = internal_shader->config.max_descriptor_set_count;
-    pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    // Descriptor pool, unless the shader has no descriptors at all.
+    VkResult result = VK_SUCCESS;
+    if (internal_shader->config.pool_size_count > 0) {
+        VkDescriptorPoolCreateInfo pool_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+        pool_info.poolSizeCount = internal_shader->config.pool_size_count;
+        pool_info.pPoolSizes = internal_shader->config.pool_sizes;
+        pool_info.maxSets = internal_shader->config.max_descriptor_set_count;
+        pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
 
-    // Create descriptor pool.
-    VkResult result = vkCreateDescriptorPool(logical_device, &pool_info, vk_allocator, &internal_shader->descriptor_pool);
-    if (!vulkan_result_is_success(result)) {
-        KERROR("vulkan_shader_initialize failed creating descriptor pool: '%s'", vulkan_result_string(result, true));
-        return false;
+        // Create descriptor pool.
+        result = vkCreateDescriptorPool(logical_device, &pool_info, vk_allocator, &internal_shader->descriptor_pool);
+        if (!vulkan_result_is_success(result)) {
+            KERROR("vulkan_shader_initialize failed creating descriptor pool: '%s'", vulkan_result_string(result, true));
+            return false;
+        }
     }
 
     // Create descriptor set layouts.
@@ -1621,50 +4924,10 @@ b8 vulkan_renderer_shader_initialize(shader* s) {
         }
     }
 
-    // TODO: This feels wrong to have these here, at least in this fashion. Should probably
-    // Be configured to pull from someplace instead.
-    // Viewport.
-    VkViewport viewport;
-    viewport.x = 0.0f;
-    viewport.y = (f32)context.framebuffer_height;
-    viewport.width = (f32)context.framebuffer_width;
-    viewport.height = -(f32)context.framebuffer_height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    // Scissor
-    VkRect2D scissor;
-    scissor.offset.x = scissor.offset.y = 0;
-    scissor.extent.width = context.framebuffer_width;
-    scissor.extent.height = context.framebuffer_height;
-
-    VkPipelineShaderStageCreateInfo stage_create_infos[VULKAN_SHADER_MAX_STAGES];
-    kzero_memory(stage_create_infos, sizeof(VkPipelineShaderStageCreateInfo) * VULKAN_SHADER_MAX_STAGES);
-    for (u32 i = 0; i < internal_shader->config.stage_count; ++i) {
-        stage_create_infos[i] = internal_shader->stages[i].shader_stage_create_info;
-    }
-
-    vulkan_pipeline_config pipeline_config = {0};
-    pipeline_config.renderpass = internal_shader->renderpass;
-    pipeline_config.stride = s->attribute_stride;
-    pipeline_config.attribute_count = darray_length(s->attributes);
-    pipeline_config.attributes = internal_shader->config.attributes;  // shader->attributes,
-    pipeline_config.descriptor_set_layout_count = internal_shader->config.descriptor_set_count;
-    pipeline_config.descriptor_set_layouts = internal_shader->descriptor_set_layouts;
-    pipeline_config.stage_count = internal_shader->config.stage_count;
-    pipeline_config.stages = stage_create_infos;
-    pipeline_config.viewport = viewport;
-    pipeline_config.scissor = scissor;
-    pipeline_config.cull_mode = internal_shader->config.cull_mode;
-    pipeline_config.is_wireframe = false;
-    pipeline_config.shader_flags = s->flags;
-    pipeline_config.push_constant_range_count = s->push_constant_range_count;
-    pipeline_config.push_constant_ranges = s->push_constant_ranges;
-
-    b8 pipeline_result = vulkan_graphics_pipeline_create(&context, &pipeline_config, &internal_shader->pipeline);
+    b8 pipeline_result = shader_pipelines_create(s, internal_shader->stages, &internal_shader->pipeline, internal_shader->variant_pipelines);
 
     if (!pipeline_result) {
-        KERROR("Failed to load graphics pipeline for object shader.");
+        KERROR("Failed to load the pipeline for shader '%s'.", s->name);
         return false;
     }
 
@@ -1675,9 +4938,28 @@ b8 vulkan_renderer_shader_initialize(shader* s) {
     s->global_ubo_stride = get_aligned(s->global_ubo_size, s->required_ubo_alignment);
     s->ubo_stride = get_aligned(s->ubo_size, s->required_ubo_alignment);
 
+    // Storage sets, one per frame, written as their bindings are set.
+    VkDescriptorSetAllocateInfo alloc_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    alloc_info.descriptorPool = internal_shader->descriptor_pool;
+    alloc_info.descriptorSetCount = 3;
+    if (internal_shader->storage_set_index != INVALID_ID_U8) {
+        VkDescriptorSetLayout storage_layouts[3] = {
+            internal_shader->descriptor_set_layouts[internal_shader->storage_set_index],
+            internal_shader->descriptor_set_layouts[internal_shader->storage_set_index],
+            internal_shader->descriptor_set_layouts[internal_shader->storage_set_index]};
+        alloc_info.pSetLayouts = storage_layouts;
+        VK_CHECK(vkAllocateDescriptorSets(context.device.logical_device, &alloc_info, internal_shader->storage_descriptor_sets));
+    }
+
+    // Shaders with only storage bindings and push constants, as compute shaders may be, need nothing more.
+    if (internal_shader->global_uniform_count == 0 && internal_shader->global_uniform_sampler_count == 0 &&
+        internal_shader->instance_uniform_count == 0 && internal_shader->instance_uniform_sampler_count == 0) {
+        return true;
+    }
+
     // Uniform  buffer.
     // TODO: max count should be configurable, or perhaps long term support of buffer resizing.
-    u64 total_buffer_size = s->global_ubo_stride + (s->ubo_stride * VULKAN_MAX_MATERIAL_COUNT);  // global + (locals)
+    u64 total_buffer_size = s->global_ubo_stride + (s->ubo_stride * internal_shader->instance_capacity);  // global + (locals)
     if (!renderer_renderbuffer_create(RENDERBUFFER_TYPE_UNIFORM, total_buffer_size, true, &internal_shader->uniform_buffer)) {
         KERROR("Vulkan buffer creation failed for object shader.");
         return false;
@@ -1693,18 +4975,104 @@ b8 vulkan_renderer_shader_initialize(shader* s) {
     // Map the entire buffer's memory.
     internal_shader->mapped_uniform_buffer_block = vulkan_buffer_map_memory(&internal_shader->uniform_buffer, 0, VK_WHOLE_SIZE);
 
+    // Uniforms are set in a copy of the buffer, and only the bytes that changed are copied over when applied.
+    // Both start zeroed so they agree from the start.
+    internal_shader->uniform_shadow_size = total_buffer_size;
+    internal_shader->uniform_shadow = kallocate(total_buffer_size, MEMORY_TAG_RENDERER);
+    kzero_memory(internal_shader->mapped_uniform_buffer_block, total_buffer_size);
+    internal_shader->uniform_dirty_start = 0;
+    internal_shader->uniform_dirty_end = 0;
+
     // Allocate global descriptor sets, one per frame. Global is always the first set.
     VkDescriptorSetLayout global_layouts[3] = {
         internal_shader->descriptor_set_layouts[DESC_SET_INDEX_GLOBAL],
         internal_shader->descriptor_set_layouts[DESC_SET_INDEX_GLOBAL],
         internal_shader->descriptor_set_layouts[DESC_SET_INDEX_GLOBAL]};
 
-    VkDescriptorSetAllocateInfo alloc_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
-    alloc_info.descriptorPool = internal_shader->descriptor_pool;
-    alloc_info.descriptorSetCount = 3;
     alloc_info.pSetLayouts = global_layouts;
     VK_CHECK(vkAllocateDescriptorSets(context.device.logical_device, &alloc_info, internal_shader->global_descriptor_sets));
 
+    // Bindless instances share one set pointing at the whole uniform buffer, bound once for all of them.
+    if ((s->flags & SHADER_FLAG_BINDLESS) && s->ubo_stride > 0) {
+        alloc_info.descriptorSetCount = 1;
+        alloc_info.pSetLayouts = &internal_shader->descriptor_set_layouts[DESC_SET_INDEX_INSTANCE];
+        VK_CHECK(vkAllocateDescriptorSets(context.device.logical_device, &alloc_info, &internal_shader->bindless_instance_set));
+
+        VkDescriptorBufferInfo buffer_info;
+        buffer_info.buffer = ((vulkan_buffer*)internal_shader->uniform_buffer.internal_data)->handle;
+        buffer_info.offset = 0;
+        buffer_info.range = VK_WHOLE_SIZE;
+        VkWriteDescriptorSet write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+        write.dstSet = internal_shader->bindless_instance_set;
+        write.dstBinding = 0;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.descriptorCount = 1;
+        write.pBufferInfo = &buffer_info;
+        vkUpdateDescriptorSets(context.device.logical_device, 1, &write, 0, 0);
+        counter_add(context.descriptor_writes_counter, 1);
+
+        // Where each instance sampler's table index goes in the instance uniforms.
+        u32 uniform_count = darray_length(s->uniforms);
+        for (u32 i = 0; i < uniform_count; ++i) {
+            const shader_uniform* uniform = &s->uniforms[i];
+            if (uniform->type == SHADER_UNIFORM_TYPE_SAMPLER && uniform->scope == SHADER_SCOPE_INSTANCE) {
+                internal_shader->bindless_index_offsets[uniform->location] = (u16)uniform->offset;
+            }
+        }
+    }
+
+    return true;
+}
+
+b8 vulkan_renderer_shader_reload(shader* s) {
+    vulkan_shader* internal_shader = (vulkan_shader*)s->internal_data;
+    if (!internal_shader || s->state != SHADER_STATE_INITIALIZED) {
+        return false;
+    }
+
+    // Build the new modules and pipeline first, so that a bad stage leaves the shader as it was.
+    vulkan_shader_stage stages[VULKAN_SHADER_MAX_STAGES];
+    kzero_memory(stages, sizeof(vulkan_shader_stage) * VULKAN_SHADER_MAX_STAGES);
+    u32 created_count = 0;
+    b8 success = true;
+    for (u32 i = 0; i < internal_shader->config.stage_count; ++i) {
+        if (!create_module(internal_shader, internal_shader->config.stages[i], &stages[i])) {
+            KERROR("Unable to create %s shader module for '%s' while reloading.", internal_shader->config.stages[i].file_name, s->name);
+            success = false;
+            break;
+        }
+        created_count++;
+    }
+
+    vulkan_pipeline pipeline = {};
+    vulkan_pipeline variant_pipelines[SHADER_MAX_VARIANTS] = {};
+    if (success && !shader_pipelines_create(s, stages, &pipeline, variant_pipelines)) {
+        KERROR("Failed to create the graphics pipeline for '%s' while reloading.", s->name);
+        success = false;
+    }
+
+    if (!success) {
+        for (u32 i = 0; i < created_count; ++i) {
+            vkDestroyShaderModule(context.device.logical_device, stages[i].handle, context.allocator);
+        }
+        return false;
+    }
+
+    // The old pipelines may still be in use by frames in flight, so are destroyed once they finish.
+    vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_PIPELINE};
+    deletion.pipeline = internal_shader->pipeline;
+    deferred_delete(&deletion);
+    for (u32 i = 1; i < s->variant_count; ++i) {
+        deletion.pipeline = internal_shader->variant_pipelines[i];
+        deferred_delete(&deletion);
+    }
+    for (u32 i = 0; i < internal_shader->config.stage_count; ++i) {
+        vkDestroyShaderModule(context.device.logical_device, internal_shader->stages[i].handle, context.allocator);
+    }
+    kcopy_memory(internal_shader->stages, stages, sizeof(vulkan_shader_stage) * VULKAN_SHADER_MAX_STAGES);
+    internal_shader->pipeline = pipeline;
+    kcopy_memory(internal_shader->variant_pipelines, variant_pipelines, sizeof(vulkan_pipeline) * SHADER_MAX_VARIANTS);
+
     return true;
 }
 
@@ -1717,10 +5085,44 @@ b8 vulkan_renderer_shader_initialize(shader* s) {
 #define SHADER_VERIFY_SHADER_ID(shader_id)  // do nothing
 #endif
 
-b8 vulkan_renderer_shader_use(shader* shader) {
-    vulkan_shader* s = shader->internal_data;
-    vulkan_pipeline_bind(&context.graphics_command_buffers[context.image_index], VK_PIPELINE_BIND_POINT_GRAPHICS, &s->pipeline);
-    return true;
+b8 vulkan_renderer_shader_use(shader* shader) {
+    vulkan_shader* s = shader->internal_data;
+    context.bound_shader = shader;
+    // Nothing but secondary command buffers may be recorded within a renderpass begun for parallel
+    // recording. Batched draws bind the pipeline of the shader in use in their own.
+    if (context.parallel_renderpass) {
+        return true;
+    }
+    // Graphics pipelines stay bound across renderpasses, so one already bound needn't be again.
+    vulkan_pipeline* pipeline = shader_variant_pipeline(shader);
+    if (s->bind_point == VK_PIPELINE_BIND_POINT_GRAPHICS) {
+        if (context.bound_graphics_pipeline == pipeline->handle) {
+            counter_add(context.redundant_binds_counter, 1);
+            return true;
+        }
+        context.bound_graphics_pipeline = pipeline->handle;
+        // Sets the last pipeline bound may have replaced.
+        context.draw_batch.bound_layout = 0;
+    }
+    vulkan_pipeline_bind(&context.graphics_command_buffers[context.image_index], s->bind_point, pipeline);
+    return true;
+}
+
+// Binds the current frame's storage set of the given shader in the given command buffer, if it has one.
+static void shader_storage_set_bind(VkCommandBuffer command_buffer, vulkan_shader* internal) {
+    if (internal->storage_set_index == INVALID_ID_U8) {
+        return;
+    }
+    VkDescriptorSet storage_descriptor = internal->storage_descriptor_sets[context.image_index];
+    vkCmdBindDescriptorSets(command_buffer, internal->bind_point, internal->pipeline.pipeline_layout, internal->storage_set_index, 1, &storage_descriptor, 0, 0);
+}
+
+// Binds the bindless texture table for the given shader in the given command buffer, if it is bindless.
+static void shader_bindless_set_bind(VkCommandBuffer command_buffer, vulkan_shader* internal) {
+    if (internal->bindless_set_index == INVALID_ID_U8) {
+        return;
+    }
+    vkCmdBindDescriptorSets(command_buffer, internal->bind_point, internal->pipeline.pipeline_layout, internal->bindless_set_index, 1, &context.bindless.set, 0, 0);
 }
 
 b8 vulkan_renderer_shader_bind_globals(shader* s) {
@@ -1728,6 +5130,9 @@ b8 vulkan_renderer_shader_bind_globals(shader* s) {
         return false;
     }
 
+    // Whatever was set for the block bound before is copied over before another is bound.
+    uniform_shadow_flush(s->internal_data);
+
     // Global UBO is always at the beginning, but use this anyway.
     s->bound_ubo_offset = s->global_ubo_offset;
     return true;
@@ -1739,6 +5144,7 @@ b8 vulkan_renderer_shader_bind_instance(shader* s, u32 instance_id) {
         return false;
     }
     vulkan_shader* internal = s->internal_data;
+    uniform_shadow_flush(internal);
 
     s->bound_instance_id = instance_id;
     vulkan_shader_instance_state* object_state = &internal->instance_states[instance_id];
@@ -1749,6 +5155,14 @@ b8 vulkan_renderer_shader_bind_instance(shader* s, u32 instance_id) {
 b8 vulkan_renderer_shader_apply_globals(shader* s) {
     u32 image_index = context.image_index;
     vulkan_shader* internal = s->internal_data;
+    uniform_shadow_flush(internal);
+    if (internal->global_uniform_count < 1 && internal->global_uniform_sampler_count < 1) {
+        // No global set, but storage bindings and the texture table are applied with the globals.
+        VkCommandBuffer command_buffer = context.graphics_command_buffers[image_index].handle;
+        shader_storage_set_bind(command_buffer, internal);
+        shader_bindless_set_bind(command_buffer, internal);
+        return true;
+    }
     VkCommandBuffer command_buffer = context.graphics_command_buffers[image_index].handle;
     VkDescriptorSet global_descriptor = internal->global_descriptor_sets[image_index];
 
@@ -1781,9 +5195,206 @@ b8 vulkan_renderer_shader_apply_globals(shader* s) {
     }
 
     vkUpdateDescriptorSets(context.device.logical_device, global_set_binding_count, descriptor_writes, 0, 0);
+    counter_add(context.descriptor_writes_counter, global_set_binding_count);
 
     // Bind the global descriptor set to be updated.
-    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, internal->pipeline.pipeline_layout, 0, 1, &global_descriptor, 0, 0);
+    vkCmdBindDescriptorSets(command_buffer, internal->bind_point, internal->pipeline.pipeline_layout, 0, 1, &global_descriptor, 0, 0);
+    shader_storage_set_bind(command_buffer, internal);
+    shader_bindless_set_bind(command_buffer, internal);
+    return true;
+}
+
+// Gets the texture an instance texture map samples: its own, or a default for its use while that is not loaded.
+static texture* instance_texture_resolve(const texture_map* map) {
+    texture* t = map->texture;
+    if (t->generation != INVALID_ID) {
+        return t;
+    }
+    switch (map->use) {
+        case TEXTURE_USE_MAP_DIFFUSE:
+            return texture_system_get_default_diffuse_texture();
+        case TEXTURE_USE_MAP_SPECULAR:
+            return texture_system_get_default_specular_texture();
+        case TEXTURE_USE_MAP_NORMAL:
+            return texture_system_get_default_normal_texture();
+        case TEXTURE_USE_MAP_CUBEMAP:
+            return texture_system_get_default_cube_texture();
+        default:
+            KWARN("Undefined texture use %d", map->use);
+            return texture_system_get_default_texture();
+    }
+}
+
+// Storage textures are sampled in the general layout they are kept in.
+static VkImageLayout sampled_layout_get(const texture* t) {
+    return (t->flags & TEXTURE_FLAG_IS_STORAGE) ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+}
+
+// Points the bound instance's texture table entries at its textures, writing new entries only for those
+// which changed, and stores their indices in the instance uniforms.
+static void bindless_instance_update(shader* s, vulkan_shader_instance_state* instance_state) {
+    vulkan_shader* internal = s->internal_data;
+    for (u32 i = 0; i < s->instance_texture_count; ++i) {
+        texture_map* map = instance_state->instance_texture_maps[i];
+        texture* t = instance_texture_resolve(map);
+        VkImageView view = ((vulkan_image*)t->internal_data)->view;
+        VkSampler sampler = (VkSampler)map->internal_data;
+        vulkan_bindless_slot* slot = &instance_state->bindless_slots[i];
+        if (slot->index != INVALID_ID && slot->view == view && slot->sampler == sampler && slot->generation == t->generation) {
+            continue;
+        }
+
+        // The old entry may still be sampled by frames in flight, so the texture goes in a new one.
+        bindless_slot_release(slot);
+        u32 index = bindless_slot_write(view, sampler, sampled_layout_get(t));
+        if (index == INVALID_ID) {
+            continue;
+        }
+        slot->index = index;
+        slot->view = view;
+        slot->sampler = sampler;
+        slot->generation = t->generation;
+        uniform_shadow_write(internal, instance_state->offset + internal->bindless_index_offsets[i], &index, sizeof(u32));
+    }
+}
+
+// Binds the set of the given instance in the given command buffer, as it was last written.
+// Indicates if drawing the given instance after the bound one needs its set bound. Bindless instances share
+// one, so only the first needs it.
+static b8 instance_set_needs_bind(const vulkan_shader* internal, u32 bound_instance_id, u32 instance_id) {
+    if (bound_instance_id == INVALID_ID) {
+        return true;
+    }
+    return internal->bindless_set_index == INVALID_ID_U8 && instance_id != bound_instance_id;
+}
+
+// The entry of the given instance in the material table of a bindless shader, which is where its uniforms
+// start in the uniform buffer, in 16-byte units. 0 for other shaders, which bind the uniforms of each instance.
+static u32 instance_material_index(const vulkan_shader* internal, u32 instance_id) {
+    if (internal->bindless_set_index == INVALID_ID_U8 || instance_id == INVALID_ID || instance_id >= internal->instance_capacity) {
+        return 0;
+    }
+    u64 offset = internal->instance_states[instance_id].offset;
+    return offset == INVALID_ID ? 0 : (u32)(offset / 16);
+}
+
+static void instance_set_bind(VkCommandBuffer command_buffer, vulkan_shader* internal, vulkan_shader_instance_state* instance_state) {
+    if (internal->instance_uniform_count < 1 && internal->instance_uniform_sampler_count < 1) {
+        return;
+    }
+    // Bindless instances share one set, holding all of their uniforms.
+    if (internal->bindless_set_index != INVALID_ID_U8) {
+        vkCmdBindDescriptorSets(command_buffer, internal->bind_point, internal->pipeline.pipeline_layout, DESC_SET_INDEX_INSTANCE, 1, &internal->bindless_instance_set, 0, 0);
+        return;
+    }
+    VkDescriptorSet instance_descriptor_set = instance_state->descriptor_set_state.descriptor_sets[context.image_index];
+    if (instance_state->transient && instance_state->transient_set && instance_state->transient_serial == context.frame_serial) {
+        instance_descriptor_set = instance_state->transient_set;
+    }
+    vkCmdBindDescriptorSets(command_buffer, internal->bind_point, internal->pipeline.pipeline_layout, DESC_SET_INDEX_INSTANCE, 1, &instance_descriptor_set, 0, 0);
+}
+
+// Fills out the image infos of the instance's samplers, updating the sampler states of the given index
+// to match. Returns true if any of them differed.
+static b8 instance_image_infos_update(vulkan_shader* internal, vulkan_shader_instance_state* instance_state, u32 state_index, VkDescriptorImageInfo* out_image_infos, u32* out_count) {
+    u8 sampler_binding_index = internal->config.descriptor_sets[DESC_SET_INDEX_INSTANCE].sampler_binding_index;
+    u32 total_sampler_count = internal->config.descriptor_sets[DESC_SET_INDEX_INSTANCE].bindings[sampler_binding_index].descriptorCount;
+    b8 samplers_changed = false;
+    for (u32 i = 0; i < total_sampler_count; ++i) {
+        texture_map* map = instance_state->instance_texture_maps[i];
+        texture* t = instance_texture_resolve(map);
+
+        vulkan_image* image = (vulkan_image*)t->internal_data;
+        out_image_infos[i].imageLayout = sampled_layout_get(t);
+        out_image_infos[i].imageView = image->view;
+        out_image_infos[i].sampler = (VkSampler)map->internal_data;
+
+        vulkan_descriptor_state* sampler_state = &instance_state->sampler_states[i];
+        if (sampler_state->ids[state_index] != t->id || sampler_state->generations[state_index] != t->generation || sampler_state->samplers[state_index] != out_image_infos[i].sampler) {
+            sampler_state->ids[state_index] = t->id;
+            sampler_state->generations[state_index] = t->generation;
+            sampler_state->samplers[state_index] = out_image_infos[i].sampler;
+            samplers_changed = true;
+        }
+    }
+    *out_count = total_sampler_count;
+    return samplers_changed;
+}
+
+// Forgets what the instance's own sets were written with, so that all of them are written again.
+static void instance_descriptor_states_invalidate(vulkan_shader* internal, vulkan_shader_instance_state* instance_state, u32 texture_count) {
+    u32 binding_count = internal->config.descriptor_sets[DESC_SET_INDEX_INSTANCE].binding_count;
+    for (u32 i = 0; i < binding_count; ++i) {
+        for (u32 j = 0; j < 3; ++j) {
+            instance_state->descriptor_set_state.descriptor_states[i].generations[j] = INVALID_ID;
+            instance_state->descriptor_set_state.descriptor_states[i].ids[j] = INVALID_ID;
+        }
+    }
+    for (u32 i = 0; instance_state->sampler_states && i < texture_count; ++i) {
+        for (u32 j = 0; j < 3; ++j) {
+            instance_state->sampler_states[i].generations[j] = INVALID_ID;
+            instance_state->sampler_states[i].ids[j] = INVALID_ID;
+        }
+    }
+}
+
+// Writes every descriptor of a transient instance to a new transient set, for the current frame. Its
+// sampler states are kept at index 0, so that an instance which stops changing goes back to its own sets.
+static b8 transient_instance_set_write(shader* s, vulkan_shader_instance_state* instance_state) {
+    vulkan_shader* internal = s->internal_data;
+    VkDescriptorSet set = transient_descriptor_set_allocate(internal->descriptor_set_layouts[DESC_SET_INDEX_INSTANCE]);
+    if (!set) {
+        return false;
+    }
+
+    VkWriteDescriptorSet descriptor_writes[2];
+    kzero_memory(descriptor_writes, sizeof(VkWriteDescriptorSet) * 2);
+    u32 descriptor_count = 0;
+    u32 descriptor_index = 0;
+
+    VkDescriptorBufferInfo buffer_info;
+    if (internal->instance_uniform_count > 0) {
+        buffer_info.buffer = ((vulkan_buffer*)internal->uniform_buffer.internal_data)->handle;
+        buffer_info.offset = instance_state->offset;
+        buffer_info.range = s->ubo_stride;
+
+        VkWriteDescriptorSet* ubo_descriptor = &descriptor_writes[descriptor_count++];
+        ubo_descriptor->sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        ubo_descriptor->dstSet = set;
+        ubo_descriptor->dstBinding = descriptor_index;
+        ubo_descriptor->descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        ubo_descriptor->descriptorCount = 1;
+        ubo_descriptor->pBufferInfo = &buffer_info;
+        descriptor_index++;
+    }
+
+    b8 samplers_changed = false;
+    VkDescriptorImageInfo image_infos[VULKAN_SHADER_MAX_INSTANCE_TEXTURES];
+    if (internal->instance_uniform_sampler_count > 0) {
+        u32 total_sampler_count = 0;
+        samplers_changed = instance_image_infos_update(internal, instance_state, 0, image_infos, &total_sampler_count);
+
+        VkWriteDescriptorSet* sampler_descriptor = &descriptor_writes[descriptor_count++];
+        sampler_descriptor->sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        sampler_descriptor->dstSet = set;
+        sampler_descriptor->dstBinding = descriptor_index;
+        sampler_descriptor->descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        sampler_descriptor->descriptorCount = total_sampler_count;
+        sampler_descriptor->pImageInfo = image_infos;
+    }
+
+    vkUpdateDescriptorSets(context.device.logical_device, descriptor_count, descriptor_writes, 0, 0);
+    counter_add(context.descriptor_writes_counter, descriptor_count);
+    instance_state->transient_set = set;
+    instance_state->transient_serial = context.frame_serial;
+
+    // Once it has stopped changing for a while, it goes back to its own sets, every one of them written afresh.
+    instance_state->streak = samplers_changed ? 0 : instance_state->streak + 1;
+    if (instance_state->streak >= VULKAN_TRANSIENT_SET_STREAK) {
+        instance_state->transient = false;
+        instance_state->streak = 0;
+        instance_descriptor_states_invalidate(internal, instance_state, s->instance_texture_count);
+    }
     return true;
 }
 
@@ -1798,6 +5409,31 @@ b8 vulkan_renderer_shader_apply_instance(shader* s, b8 needs_update) {
 
     // Obtain instance data.
     vulkan_shader_instance_state* object_state = &internal->instance_states[s->bound_instance_id];
+
+    // Bindless instances write no descriptors of their own, and share one set bound at their offset.
+    if (internal->bindless_set_index != INVALID_ID_U8) {
+        if (needs_update) {
+            bindless_instance_update(s, object_state);
+        }
+        uniform_shadow_flush(internal);
+        instance_set_bind(command_buffer, internal, object_state);
+        return true;
+    }
+
+    uniform_shadow_flush(internal);
+
+    // Instances which change every frame are written to a transient set once a frame instead of their own.
+    if (object_state->transient) {
+        if (needs_update || !object_state->transient_set || object_state->transient_serial != context.frame_serial) {
+            if (!transient_instance_set_write(s, object_state)) {
+                KERROR("Failed to write the transient descriptor set of an instance.");
+                return false;
+            }
+        }
+        instance_set_bind(command_buffer, internal, object_state);
+        return true;
+    }
+
     VkDescriptorSet object_descriptor_set = object_state->descriptor_set_state.descriptor_sets[image_index];
 
     if (needs_update) {
@@ -1810,10 +5446,9 @@ b8 vulkan_renderer_shader_apply_instance(shader* s, b8 needs_update) {
 
         // Descriptor 0 - Uniform buffer
         if (internal->instance_uniform_count > 0) {
-            // Only do this if the descriptor has not yet been updated.
-            u8* instance_ubo_generation = &(object_state->descriptor_set_state.descriptor_states[descriptor_index].generations[image_index]);
-            // TODO: determine if update is required.
-            if (*instance_ubo_generation == INVALID_ID_U8 /*|| *global_ubo_generation != material->generation*/) {
+            // Only do this if the descriptor has not yet been updated. The buffer range never changes.
+            u32* instance_ubo_generation = &(object_state->descriptor_set_state.descriptor_states[descriptor_index].generations[image_index]);
+            if (*instance_ubo_generation == INVALID_ID) {
                 buffer_info.buffer = ((vulkan_buffer*)internal->uniform_buffer.internal_data)->handle;
                 buffer_info.offset = object_state->offset;
                 buffer_info.range = s->ubo_stride;
@@ -1829,77 +5464,121 @@ b8 vulkan_renderer_shader_apply_instance(shader* s, b8 needs_update) {
                 descriptor_count++;
 
                 // Update the frame generation. In this case it is only needed once since this is a buffer.
-                *instance_ubo_generation = 1;  // material->generation; TODO: some generation from... somewhere
+                *instance_ubo_generation = 1;
             }
             descriptor_index++;
         }
 
-        // Iterate samplers.
+        // Iterate samplers. The binding is only written if one of them changed since this frame's set was last written.
         if (internal->instance_uniform_sampler_count > 0) {
-            u8 sampler_binding_index = internal->config.descriptor_sets[DESC_SET_INDEX_INSTANCE].sampler_binding_index;
-            u32 total_sampler_count = internal->config.descriptor_sets[DESC_SET_INDEX_INSTANCE].bindings[sampler_binding_index].descriptorCount;
-            u32 update_sampler_count = 0;
-            VkDescriptorImageInfo image_infos[VULKAN_SHADER_MAX_GLOBAL_TEXTURES];
-            for (u32 i = 0; i < total_sampler_count; ++i) {
-                // TODO: only update in the list if actually needing an update.
-                texture_map* map = internal->instance_states[s->bound_instance_id].instance_texture_maps[i];
-                texture* t = map->texture;
-
-                // Ensure the texture is valid.
-                if (t->generation == INVALID_ID) {
-                    switch (map->use) {
-                        case TEXTURE_USE_MAP_DIFFUSE:
-                            t = texture_system_get_default_diffuse_texture();
-                            break;
-                        case TEXTURE_USE_MAP_SPECULAR:
-                            t = texture_system_get_default_specular_texture();
-                            break;
-                        case TEXTURE_USE_MAP_NORMAL:
-                            t = texture_system_get_default_normal_texture();
-                            break;
-                        default:
-                            KWARN("Undefined texture use %d", map->use);
-                            t = texture_system_get_default_texture();
-                            break;
-                    }
+            u32 total_sampler_count = 0;
+            VkDescriptorImageInfo image_infos[VULKAN_SHADER_MAX_INSTANCE_TEXTURES];
+            b8 samplers_changed = instance_image_infos_update(internal, object_state, image_index, image_infos, &total_sampler_count);
+
+            if (samplers_changed) {
+                // Samplers rewritten frame after frame change every frame, so are moved to transient sets from the next.
+                object_state->streak = object_state->last_rewrite_serial + 1 == context.frame_serial ? object_state->streak + 1 : 1;
+                object_state->last_rewrite_serial = context.frame_serial;
+                if (object_state->streak >= VULKAN_TRANSIENT_SET_STREAK) {
+                    object_state->transient = true;
+                    object_state->streak = 0;
                 }
 
-                vulkan_image* image = (vulkan_image*)t->internal_data;
-                image_infos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                image_infos[i].imageView = image->view;
-                image_infos[i].sampler = (VkSampler)map->internal_data;
+                VkWriteDescriptorSet sampler_descriptor = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+                sampler_descriptor.dstSet = object_descriptor_set;
+                sampler_descriptor.dstBinding = descriptor_index;
+                sampler_descriptor.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                sampler_descriptor.descriptorCount = total_sampler_count;
+                sampler_descriptor.pImageInfo = image_infos;
 
-                // TODO: change up descriptor state to handle this properly.
-                // Sync frame generation if not using a default texture.
-                // if (t->generation != INVALID_ID) {
-                //     *descriptor_generation = t->generation;
-                //     *descriptor_id = t->id;
-                // }
-
-                update_sampler_count++;
+                descriptor_writes[descriptor_count] = sampler_descriptor;
+                descriptor_count++;
             }
-
-            VkWriteDescriptorSet sampler_descriptor = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-            sampler_descriptor.dstSet = object_descriptor_set;
-            sampler_descriptor.dstBinding = descriptor_index;
-            sampler_descriptor.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            sampler_descriptor.descriptorCount = update_sampler_count;
-            sampler_descriptor.pImageInfo = image_infos;
-
-            descriptor_writes[descriptor_count] = sampler_descriptor;
-            descriptor_count++;
         }
 
         if (descriptor_count > 0) {
             vkUpdateDescriptorSets(context.device.logical_device, descriptor_count, descriptor_writes, 0, 0);
+            counter_add(context.descriptor_writes_counter, descriptor_count);
         }
     }
 
     // Bind the descriptor set to be updated, or in case the shader changed.
-    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, internal->pipeline.pipeline_layout, 1, 1, &object_descriptor_set, 0, 0);
+    instance_set_bind(command_buffer, internal, object_state);
+    return true;
+}
+
+b8 vulkan_renderer_shader_apply_local(shader* s) {
+    vulkan_shader* internal = s->internal_data;
+    if (!internal->local_block) {
+        // Push constants are applied as they are set.
+        return true;
+    }
+
+    u32 dynamic_offset = frame_uniform_arena_push(internal->local_block, s->local_ubo_size);
+    if (dynamic_offset == INVALID_ID) {
+        return false;
+    }
+    VkCommandBuffer command_buffer = context.graphics_command_buffers[context.image_index].handle;
+    vulkan_frame_uniform_arena* arena = &context.frame_uniforms;
+    vkCmdBindDescriptorSets(command_buffer, internal->bind_point, internal->pipeline.pipeline_layout, internal->local_set_index, 1, &arena->descriptor_sets[context.current_frame], 1, &dynamic_offset);
     return true;
 }
 
+void vulkan_renderer_dispatch(u32 group_count_x, u32 group_count_y, u32 group_count_z) {
+    shader* s = context.bound_shader;
+    if (!s || !(s->flags & SHADER_FLAG_COMPUTE)) {
+        KERROR("vulkan_renderer_dispatch requires a compute shader in use.");
+        return;
+    }
+    vulkan_command_buffer* command_buffer = &context.graphics_command_buffers[context.image_index];
+    if (command_buffer->state == COMMAND_BUFFER_STATE_IN_RENDER_PASS) {
+        KERROR("vulkan_renderer_dispatch cannot be called within a renderpass.");
+        return;
+    }
+
+    shader_storage_set_bind(command_buffer->handle, s->internal_data);
+    vkCmdDispatch(command_buffer->handle, group_count_x, group_count_y, group_count_z);
+}
+
+void vulkan_renderer_barrier(renderer_barrier_type type) {
+    vulkan_command_buffer* command_buffer = &context.graphics_command_buffers[context.image_index];
+    if (command_buffer->state == COMMAND_BUFFER_STATE_IN_RENDER_PASS) {
+        KERROR("vulkan_renderer_barrier cannot be called within a renderpass.");
+        return;
+    }
+
+    // A global memory barrier covers every buffer and image. Storage images are kept in the general
+    // layout, so none need transitions.
+    VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    VkPipelineStageFlags source_stage;
+    VkPipelineStageFlags dest_stage;
+    switch (type) {
+        case RENDERER_BARRIER_COMPUTE_TO_COMPUTE:
+            barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            source_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+            dest_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+            break;
+        case RENDERER_BARRIER_COMPUTE_TO_GRAPHICS:
+            barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+            source_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+            dest_stage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            break;
+        case RENDERER_BARRIER_GRAPHICS_TO_COMPUTE:
+            barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            source_stage = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+            dest_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+            break;
+        default:
+            KERROR("vulkan_renderer_barrier: unknown barrier type %d.", type);
+            return;
+    }
+
+    vkCmdPipelineBarrier(command_buffer->handle, source_stage, dest_stage, 0, 1, &barrier, 0, 0, 0, 0);
+}
+
 VkSamplerAddressMode convert_repeat_type(const char* axis, texture_repeat repeat) {
     switch (repeat) {
         case TEXTURE_REPEAT_REPEAT:
@@ -1928,52 +5607,116 @@ VkFilter convert_filter_type(const char* op, texture_filter filter) {
     }
 }
 
-b8 vulkan_renderer_texture_map_acquire_resources(texture_map* map) {
-    // Create a sampler for the texture
-    VkSamplerCreateInfo sampler_info = {VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
-
-    sampler_info.minFilter = convert_filter_type("min", map->filter_minify);
-    sampler_info.magFilter = convert_filter_type("mag", map->filter_magnify);
-
-    sampler_info.addressModeU = convert_repeat_type("U", map->repeat_u);
-    sampler_info.addressModeV = convert_repeat_type("V", map->repeat_v);
-    sampler_info.addressModeW = convert_repeat_type("W", map->repeat_w);
+static b8 sampler_key_equal(const vulkan_sampler_key* a, const vulkan_sampler_key* b) {
+    return a->min_filter == b->min_filter && a->mag_filter == b->mag_filter &&
+           a->address_u == b->address_u && a->address_v == b->address_v && a->address_w == b->address_w &&
+           a->mipmap_mode == b->mipmap_mode && a->border_color == b->border_color &&
+           a->max_anisotropy == b->max_anisotropy;
+}
 
+b8 vulkan_renderer_texture_map_acquire_resources(texture_map* map) {
+    vulkan_sampler_key key = {0};
+    key.min_filter = convert_filter_type("min", map->filter_minify);
+    key.mag_filter = convert_filter_type("mag", map->filter_magnify);
+    key.address_u = convert_repeat_type("U", map->repeat_u);
+    key.address_v = convert_repeat_type("V", map->repeat_v);
+    key.address_w = convert_repeat_type("W", map->repeat_w);
     // TODO: Configurable
+    key.mipmap_mode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    key.border_color = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    key.max_anisotropy = 16;
+
+    // Share the sampler of any map with the same state.
+    vulkan_sampler_cache* cache = &context.samplers;
+    vulkan_sampler_entry* free_entry = 0;
+    for (u32 i = 0; i < VULKAN_MAX_SAMPLERS; ++i) {
+        vulkan_sampler_entry* entry = &cache->entries[i];
+        if (!entry->sampler) {
+            if (!free_entry) {
+                free_entry = entry;
+            }
+        } else if (sampler_key_equal(&entry->key, &key)) {
+            entry->reference_count++;
+            map->internal_data = entry->sampler;
+            return true;
+        }
+    }
+    if (!free_entry) {
+        KERROR("vulkan_renderer_texture_map_acquire_resources - No room for another sampler. Increase VULKAN_MAX_SAMPLERS.");
+        return false;
+    }
+
+    VkSamplerCreateInfo sampler_info = {VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+    sampler_info.minFilter = key.min_filter;
+    sampler_info.magFilter = key.mag_filter;
+    sampler_info.addressModeU = key.address_u;
+    sampler_info.addressModeV = key.address_v;
+    sampler_info.addressModeW = key.address_w;
     sampler_info.anisotropyEnable = VK_TRUE;
-    sampler_info.maxAnisotropy = 16;
-    sampler_info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    sampler_info.maxAnisotropy = key.max_anisotropy;
+    sampler_info.borderColor = key.border_color;
     sampler_info.unnormalizedCoordinates = VK_FALSE;
     sampler_info.compareEnable = VK_FALSE;
     sampler_info.compareOp = VK_COMPARE_OP_ALWAYS;
-    sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    sampler_info.mipmapMode = key.mipmap_mode;
     sampler_info.mipLodBias = 0.0f;
     sampler_info.minLod = 0.0f;
-    sampler_info.maxLod = 0.0f;
+    // The whole of whatever chain the texture has, as the view limits it to the levels there are.
+    sampler_info.maxLod = VK_LOD_CLAMP_NONE;
 
-    VkResult result = vkCreateSampler(context.device.logical_device, &sampler_info, context.allocator, (VkSampler*)&map->internal_data);
-    if (!vulkan_result_is_success(VK_SUCCESS)) {
+    VkResult result = vkCreateSampler(context.device.logical_device, &sampler_info, context.allocator, &free_entry->sampler);
+    if (!vulkan_result_is_success(result)) {
         KERROR("Error creating texture sampler: %s", vulkan_result_string(result, true));
+        free_entry->sampler = 0;
         return false;
     }
-
+    free_entry->key = key;
+    free_entry->reference_count = 1;
+    cache->count++;
+    map->internal_data = free_entry->sampler;
     return true;
 }
 
 void vulkan_renderer_texture_map_release_resources(texture_map* map) {
-    if (map) {
-        // Make sure there's no way this is in use.
-        vkDeviceWaitIdle(context.device.logical_device);
-        vkDestroySampler(context.device.logical_device, map->internal_data, context.allocator);
-        map->internal_data = 0;
+    if (!map || !map->internal_data) {
+        return;
     }
+    vulkan_sampler_cache* cache = &context.samplers;
+    VkSampler sampler = (VkSampler)map->internal_data;
+    map->internal_data = 0;
+    for (u32 i = 0; i < VULKAN_MAX_SAMPLERS; ++i) {
+        vulkan_sampler_entry* entry = &cache->entries[i];
+        if (entry->sampler != sampler) {
+            continue;
+        }
+        if (--entry->reference_count == 0) {
+            // Frames in flight may still be sampling with it.
+            vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_SAMPLER};
+            deletion.sampler = entry->sampler;
+            deferred_delete(&deletion);
+            kzero_memory(entry, sizeof(vulkan_sampler_entry));
+            cache->count--;
+        }
+        return;
+    }
+    KWARN("vulkan_renderer_texture_map_release_resources - The map's sampler was not acquired through the cache. Nothing was released.");
+}
+
+// Destroys the samplers of maps never released. The device must be idle.
+static void sampler_cache_destroy() {
+    vulkan_sampler_cache* cache = &context.samplers;
+    for (u32 i = 0; i < VULKAN_MAX_SAMPLERS; ++i) {
+        if (cache->entries[i].sampler) {
+            vkDestroySampler(context.device.logical_device, cache->entries[i].sampler, context.allocator);
+        }
+    }
+    kzero_memory(cache, sizeof(vulkan_sampler_cache));
 }
 
 b8 vulkan_renderer_shader_acquire_instance_resources(shader* s, texture_map** maps, u32* out_instance_id) {
     vulkan_shader* internal = s->internal_data;
-    // TODO: dynamic
     *out_instance_id = INVALID_ID;
-    for (u32 i = 0; i < 1024; ++i) {
+    for (u32 i = 0; i < internal->instance_capacity; ++i) {
         if (internal->instance_states[i].id == INVALID_ID) {
             internal->instance_states[i].id = i;
             *out_instance_id = i;
@@ -1986,8 +5729,12 @@ b8 vulkan_renderer_shader_acquire_instance_resources(shader* s, texture_map** ma
     }
 
     vulkan_shader_instance_state* instance_state = &internal->instance_states[*out_instance_id];
-    u8 sampler_binding_index = internal->config.descriptor_sets[DESC_SET_INDEX_INSTANCE].sampler_binding_index;
-    u32 instance_texture_count = internal->config.descriptor_sets[DESC_SET_INDEX_INSTANCE].bindings[sampler_binding_index].descriptorCount;
+    b8 is_bindless = internal->bindless_set_index != INVALID_ID_U8;
+    instance_state->transient = false;
+    instance_state->streak = 0;
+    instance_state->last_rewrite_serial = 0;
+    instance_state->transient_set = VK_NULL_HANDLE;
+    u32 instance_texture_count = s->instance_texture_count;
     // Only setup if the shader actually requires it.
     if (s->instance_texture_count > 0) {
         // Wipe out the memory for the entire array, even if it isn't all used.
@@ -2000,6 +5747,23 @@ b8 vulkan_renderer_shader_acquire_instance_resources(shader* s, texture_map** ma
                 instance_state->instance_texture_maps[i]->texture = default_texture;
             }
         }
+
+        // Nothing is written to the sets or the texture table yet.
+        if (is_bindless) {
+            instance_state->bindless_slots = kallocate(sizeof(vulkan_bindless_slot) * instance_texture_count, MEMORY_TAG_ARRAY);
+            for (u32 i = 0; i < instance_texture_count; ++i) {
+                instance_state->bindless_slots[i].index = INVALID_ID;
+                instance_state->bindless_slots[i].generation = INVALID_ID;
+            }
+        } else {
+            instance_state->sampler_states = kallocate(sizeof(vulkan_descriptor_state) * instance_texture_count, MEMORY_TAG_ARRAY);
+            for (u32 i = 0; i < instance_texture_count; ++i) {
+                for (u32 j = 0; j < 3; ++j) {
+                    instance_state->sampler_states[i].generations[j] = INVALID_ID;
+                    instance_state->sampler_states[i].ids[j] = INVALID_ID;
+                }
+            }
+        }
     }
 
     // Allocate some space in the UBO - by the stride, not the size.
@@ -2011,6 +5775,11 @@ b8 vulkan_renderer_shader_acquire_instance_resources(shader* s, texture_map** ma
         }
     }
 
+    // Bindless instances use the shader's shared instance set, so need no sets of their own.
+    if (is_bindless) {
+        return true;
+    }
+
     vulkan_shader_descriptor_set_state* set_state = &instance_state->descriptor_set_state;
 
     // Each descriptor binding in the set
@@ -2018,7 +5787,7 @@ b8 vulkan_renderer_shader_acquire_instance_resources(shader* s, texture_map** ma
     kzero_memory(set_state->descriptor_states, sizeof(vulkan_descriptor_state) * VULKAN_SHADER_MAX_BINDINGS);
     for (u32 i = 0; i < binding_count; ++i) {
         for (u32 j = 0; j < 3; ++j) {
-            set_state->descriptor_states[i].generations[j] = INVALID_ID_U8;
+            set_state->descriptor_states[i].generations[j] = INVALID_ID;
             set_state->descriptor_states[i].ids[j] = INVALID_ID;
         }
     }
@@ -2049,32 +5818,47 @@ b8 vulkan_renderer_shader_release_instance_resources(shader* s, u32 instance_id)
     vulkan_shader* internal = s->internal_data;
     vulkan_shader_instance_state* instance_state = &internal->instance_states[instance_id];
 
-    // Wait for any pending operations using the descriptor set to finish.
-    vkDeviceWaitIdle(context.device.logical_device);
-
-    // Free 3 descriptor sets (one per frame)
-    VkResult result = vkFreeDescriptorSets(
-        context.device.logical_device,
-        internal->descriptor_pool,
-        3,
-        instance_state->descriptor_set_state.descriptor_sets);
-    if (result != VK_SUCCESS) {
-        KERROR("Error freeing object shader descriptor sets!");
+    if (internal->bindless_set_index != INVALID_ID_U8) {
+        // Texture table entries are freed once the frames in flight which may sample them are finished.
+        if (instance_state->bindless_slots) {
+            for (u32 i = 0; i < s->instance_texture_count; ++i) {
+                bindless_slot_release(&instance_state->bindless_slots[i]);
+            }
+            kfree(instance_state->bindless_slots, sizeof(vulkan_bindless_slot) * s->instance_texture_count, MEMORY_TAG_ARRAY);
+            instance_state->bindless_slots = 0;
+        }
+    } else {
+        // Free 3 descriptor sets (one per frame) once the frames in flight which may bind them are finished.
+        vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_DESCRIPTOR_SETS};
+        deletion.descriptor_sets.pool = internal->descriptor_pool;
+        deletion.descriptor_sets.count = 3;
+        kcopy_memory(deletion.descriptor_sets.sets, instance_state->descriptor_set_state.descriptor_sets, sizeof(VkDescriptorSet) * 3);
+        deferred_delete(&deletion);
     }
 
     // Destroy descriptor states.
     kzero_memory(instance_state->descriptor_set_state.descriptor_states, sizeof(vulkan_descriptor_state) * VULKAN_SHADER_MAX_BINDINGS);
+    if (instance_state->sampler_states) {
+        kfree(instance_state->sampler_states, sizeof(vulkan_descriptor_state) * s->instance_texture_count, MEMORY_TAG_ARRAY);
+        instance_state->sampler_states = 0;
+    }
 
     if (instance_state->instance_texture_maps) {
         kfree(instance_state->instance_texture_maps, sizeof(texture_map*) * s->instance_texture_count, MEMORY_TAG_ARRAY);
         instance_state->instance_texture_maps = 0;
     }
 
-    if (!renderer_renderbuffer_free(&internal->uniform_buffer, s->ubo_stride, instance_state->offset)) {
-        KERROR("vulkan_renderer_shader_release_instance_resources failed to free range from renderbuffer.");
-    }
+    // The uniform range may still be read by frames in flight too.
+    vulkan_deferred_deletion range_deletion = {VULKAN_DEFERRED_DELETION_TYPE_RANGE};
+    range_deletion.range.buffer = &internal->uniform_buffer;
+    range_deletion.range.size = s->ubo_stride;
+    range_deletion.range.offset = instance_state->offset;
+    deferred_delete(&range_deletion);
     instance_state->offset = INVALID_ID;
     instance_state->id = INVALID_ID;
+    // A transient set goes back with the rest of its frame's.
+    instance_state->transient = false;
+    instance_state->transient_set = VK_NULL_HANDLE;
 
     return true;
 }
@@ -2087,18 +5871,53 @@ b8 vulkan_renderer_set_uniform(shader* s, shader_uniform* uniform, const void* v
         } else {
             internal->instance_states[s->bound_instance_id].instance_texture_maps[uniform->location] = (texture_map*)value;
         }
+    } else if (uniform->type == SHADER_UNIFORM_TYPE_STORAGE_BUFFER || uniform->type == SHADER_UNIFORM_TYPE_STORAGE_IMAGE) {
+        // Written to the current frame's storage set right away. It is bound when the shader is applied or dispatched.
+        VkWriteDescriptorSet storage_write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+        storage_write.dstSet = internal->storage_descriptor_sets[context.image_index];
+        storage_write.dstBinding = uniform->location;
+        storage_write.dstArrayElement = 0;
+        storage_write.descriptorCount = 1;
+
+        VkDescriptorBufferInfo buffer_info;
+        VkDescriptorImageInfo image_info;
+        if (uniform->type == SHADER_UNIFORM_TYPE_STORAGE_BUFFER) {
+            const renderbuffer* buffer = (const renderbuffer*)value;
+            if (!buffer || !buffer->internal_data || (buffer->type != RENDERBUFFER_TYPE_STORAGE && buffer->type != RENDERBUFFER_TYPE_INDIRECT)) {
+                KERROR("Shader '%s' can only bind a storage or indirect renderbuffer as a storage buffer.", s->name);
+                return false;
+            }
+            buffer_info.buffer = ((vulkan_buffer*)buffer->internal_data)->handle;
+            buffer_info.offset = 0;
+            buffer_info.range = VK_WHOLE_SIZE;
+            storage_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            storage_write.pBufferInfo = &buffer_info;
+        } else {
+            const texture* t = (const texture*)value;
+            if (!t || !t->internal_data || !(t->flags & TEXTURE_FLAG_IS_STORAGE)) {
+                KERROR("Shader '%s' can only bind a texture created with TEXTURE_FLAG_IS_STORAGE as a storage image.", s->name);
+                return false;
+            }
+            image_info.sampler = 0;
+            image_info.imageView = ((vulkan_image*)t->internal_data)->view;
+            image_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+            storage_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            storage_write.pImageInfo = &image_info;
+        }
+
+        vkUpdateDescriptorSets(context.device.logical_device, 1, &storage_write, 0, 0);
+        counter_add(context.descriptor_writes_counter, 1);
     } else {
-        if (uniform->scope == SHADER_SCOPE_LOCAL) {
+        if (uniform->scope == SHADER_SCOPE_LOCAL && internal->local_block) {
+            // Kept until applied, so the draw's locals are written to the frame uniform arena once.
+            kcopy_memory(internal->local_block + uniform->offset, value, uniform->size);
+        } else if (uniform->scope == SHADER_SCOPE_LOCAL) {
             // Is local, using push constants. Do this immediately.
             VkCommandBuffer command_buffer = context.graphics_command_buffers[context.image_index].handle;
-            vkCmdPushConstants(command_buffer, internal->pipeline.pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, uniform->offset, uniform->size, value);
+            vkCmdPushConstants(command_buffer, internal->pipeline.pipeline_layout, internal->stage_flags, uniform->offset, uniform->size, value);
         } else {
-            // Map the appropriate memory location and copy the data over.
-            u64 addr = (u64)internal->mapped_uniform_buffer_block;
-            addr += s->bound_ubo_offset + uniform->offset;
-            kcopy_memory((void*)addr, value, uniform->size);
-            if (addr) {
-            }
+            // Set in the copy of the buffer, which is copied over when the block is applied.
+            uniform_shadow_write(internal, s->bound_ubo_offset + uniform->offset, value, uniform->size);
         }
     }
     return true;
@@ -2107,7 +5926,7 @@ b8 vulkan_renderer_set_uniform(shader* s, shader_uniform* uniform, const void* v
 b8 create_module(vulkan_shader* shader, vulkan_shader_stage_config config, vulkan_shader_stage* shader_stage) {
     // Read the resource.
     resource binary_resource;
-    if (!resource_system_load(config.file_name, RESOURCE_TYPE_BINARY, 0, &binary_resource)) {
+    if (!resource_system_acquire(config.file_name, RESOURCE_TYPE_BINARY, 0, &binary_resource)) {
         KERROR("Unable to read shader module: %s.", config.file_name);
         return false;
     }
@@ -2125,7 +5944,7 @@ b8 create_module(vulkan_shader* shader, vulkan_shader_stage_config config, vulka
         &shader_stage->handle));
 
     // Release the resource.
-    resource_system_unload(&binary_resource);
+    resource_system_release(&binary_resource);
 
     // Shader stage info
     kzero_memory(&shader_stage->shader_stage_create_info, sizeof(VkPipelineShaderStageCreateInfo));
@@ -2140,18 +5959,27 @@ b8 create_module(vulkan_shader* shader, vulkan_shader_stage_config config, vulka
 b8 vulkan_renderpass_create(const renderpass_config* config, renderpass* out_renderpass) {
     out_renderpass->internal_data = kallocate(sizeof(vulkan_renderpass), MEMORY_TAG_RENDERER);
     vulkan_renderpass* internal_data = (vulkan_renderpass*)out_renderpass->internal_data;
+    internal_data->timestamp_index = INVALID_ID;
 
     internal_data->depth = config->depth;
     internal_data->stencil = config->stencil;
+    internal_data->depth_format = VK_FORMAT_UNDEFINED;
+    if (config->target.attachment_count > VULKAN_RENDERPASS_MAX_ATTACHMENTS) {
+        KERROR("Renderpass '%s' has %u attachments, more than the %u supported.", config->name, config->target.attachment_count, VULKAN_RENDERPASS_MAX_ATTACHMENTS);
+        return false;
+    }
 
     // Main subpass
     VkSubpassDescription subpass = {};
     subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 
-    // Attachments.
-    VkAttachmentDescription* attachment_descriptions = darray_create(VkAttachmentDescription);
-    VkAttachmentDescription* colour_attachment_descs = darray_create(VkAttachmentDescription);
-    VkAttachmentDescription* depth_attachment_descs = darray_create(VkAttachmentDescription);
+    // Attachments. Passes only ever have a handful, so these live on the stack unless they outgrow it.
+    darray_buffer(attachment_buffer, VkAttachmentDescription, 8);
+    darray_buffer(colour_attachment_buffer, VkAttachmentDescription, 8);
+    darray_buffer(depth_attachment_buffer, VkAttachmentDescription, 2);
+    VkAttachmentDescription* attachment_descriptions = darray_create_in_buffer(VkAttachmentDescription, attachment_buffer);
+    VkAttachmentDescription* colour_attachment_descs = darray_create_in_buffer(VkAttachmentDescription, colour_attachment_buffer);
+    VkAttachmentDescription* depth_attachment_descs = darray_create_in_buffer(VkAttachmentDescription, depth_attachment_buffer);
 
     // Can always just look at the first target since they are all the same (one per frame).
     // render_target* target = &out_renderpass->targets[0];
@@ -2214,6 +6042,7 @@ b8 vulkan_renderpass_create(const renderpass_config* config, renderpass* out_ren
 
             // Push to colour attachments array.
             darray_push(colour_attachment_descs, attachment_desc);
+            internal_data->colour_formats[internal_data->colour_attachment_count++] = attachment_desc.format;
         } else if (attachment_config->type == RENDER_TARGET_ATTACHMENT_TYPE_DEPTH) {
             // Depth attachment.
             b8 do_clear_depth = (out_renderpass->clear_flags & RENDERPASS_CLEAR_DEPTH_BUFFER_FLAG) != 0;
@@ -2265,9 +6094,19 @@ b8 vulkan_renderpass_create(const renderpass_config* config, renderpass* out_ren
 
             // Push to colour attachments array.
             darray_push(depth_attachment_descs, attachment_desc);
+            internal_data->depth_format = attachment_desc.format;
         }
         // Push to general array.
         darray_push(attachment_descriptions, attachment_desc);
+
+        // Kept for rendering dynamically, which transitions the attachments itself.
+        vulkan_renderpass_attachment* attachment = &internal_data->attachments[internal_data->attachment_count++];
+        attachment->format = attachment_desc.format;
+        attachment->load_op = attachment_desc.loadOp;
+        attachment->store_op = attachment_desc.storeOp;
+        attachment->initial_layout = attachment_desc.initialLayout;
+        attachment->final_layout = attachment_desc.finalLayout;
+        attachment->is_depth = attachment_config->type == RENDER_TARGET_ATTACHMENT_TYPE_DEPTH;
     }
 
     // Setup the attachment references.
@@ -2341,7 +6180,10 @@ b8 vulkan_renderpass_create(const renderpass_config* config, renderpass* out_ren
     render_pass_create_info.pNext = 0;
     render_pass_create_info.flags = 0;
 
-    VK_CHECK(vkCreateRenderPass(context.device.logical_device, &render_pass_create_info, context.allocator, &internal_data->handle));
+    // Rendering dynamically needs no render pass object, nor framebuffers for it.
+    if (!context.device.supports_dynamic_rendering) {
+        VK_CHECK(vkCreateRenderPass(context.device.logical_device, &render_pass_create_info, context.allocator, &internal_data->handle));
+    }
 
     // Cleanup
     if (attachment_descriptions) {
@@ -2368,7 +6210,18 @@ b8 vulkan_renderpass_create(const renderpass_config* config, renderpass* out_ren
 void vulkan_renderpass_destroy(renderpass* pass) {
     if (pass && pass->internal_data) {
         vulkan_renderpass* internal_data = pass->internal_data;
-        vkDestroyRenderPass(context.device.logical_device, internal_data->handle, context.allocator);
+        // Forget any timings still to be collected for the renderpass.
+        for (u8 i = 0; i < 2; ++i) {
+            vulkan_timestamp_frame* frame = &context.timestamp_frames[i];
+            for (u32 q = 0; q < frame->pass_count; ++q) {
+                if (frame->passes[q] == pass) {
+                    frame->passes[q] = 0;
+                }
+            }
+        }
+        if (internal_data->handle) {
+            vkDestroyRenderPass(context.device.logical_device, internal_data->handle, context.allocator);
+        }
         internal_data->handle = 0;
         kfree(internal_data, sizeof(vulkan_renderpass), MEMORY_TAG_RENDERER);
         pass->internal_data = 0;
@@ -2383,6 +6236,12 @@ b8 vulkan_renderer_render_target_create(u8 attachment_count, render_target_attac
     }
     kcopy_memory(out_target->attachments, attachments, sizeof(render_target_attachment) * attachment_count);
 
+    // Rendering dynamically, the attachments are rendered to directly.
+    if (!((vulkan_renderpass*)pass->internal_data)->handle) {
+        out_target->internal_framebuffer = 0;
+        return true;
+    }
+
     VkFramebufferCreateInfo framebuffer_create_info = {VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
     framebuffer_create_info.renderPass = ((vulkan_renderpass*)pass->internal_data)->handle;
     framebuffer_create_info.attachmentCount = attachment_count;
@@ -2396,14 +6255,20 @@ b8 vulkan_renderer_render_target_create(u8 attachment_count, render_target_attac
 }
 
 void vulkan_renderer_render_target_destroy(render_target* target, b8 free_internal_memory) {
-    if (target && target->internal_framebuffer) {
-        vkDestroyFramebuffer(context.device.logical_device, (VkFramebuffer)target->internal_framebuffer, context.allocator);
+    if (!target) {
+        return;
+    }
+    // Targets rendered to dynamically have no framebuffer. Frames in flight may still render to it.
+    if (target->internal_framebuffer) {
+        vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_FRAMEBUFFER};
+        deletion.framebuffer = (VkFramebuffer)target->internal_framebuffer;
+        deferred_delete(&deletion);
         target->internal_framebuffer = 0;
-        if (free_internal_memory) {
-            kfree(target->attachments, sizeof(render_target_attachment) * target->attachment_count, MEMORY_TAG_ARRAY);
-            target->attachments = 0;
-            target->attachment_count = 0;
-        }
+    }
+    if (free_internal_memory && target->attachments) {
+        kfree(target->attachments, sizeof(render_target_attachment) * target->attachment_count, MEMORY_TAG_ARRAY);
+        target->attachments = 0;
+        target->attachment_count = 0;
     }
 }
 
@@ -2452,6 +6317,34 @@ b8 vulkan_buffer_is_host_coherent(vulkan_buffer* buffer) {
     return (buffer->memory_property_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) == VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 }
 
+// Vertex and index buffers are written on the transfer queue and read on the graphics queue, so they
+// are shared between both families when those differ, rather than transferring ownership each upload.
+// Everything else is only used on one queue.
+// Indicates if any memory type the host can see is also cached for it.
+static b8 host_cached_memory_supported() {
+    VkPhysicalDeviceMemoryProperties memory_properties;
+    vkGetPhysicalDeviceMemoryProperties(context.device.physical_device, &memory_properties);
+    VkMemoryPropertyFlags flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+    for (u32 i = 0; i < memory_properties.memoryTypeCount; ++i) {
+        if ((memory_properties.memoryTypes[i].propertyFlags & flags) == flags) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void buffer_sharing_set(VkBufferCreateInfo* buffer_info, renderbuffer_type type, u32* out_family_indices) {
+    out_family_indices[0] = (u32)context.device.graphics_queue_index;
+    out_family_indices[1] = (u32)context.device.transfer_queue_index;
+    if ((type == RENDERBUFFER_TYPE_VERTEX || type == RENDERBUFFER_TYPE_INDEX) && out_family_indices[0] != out_family_indices[1]) {
+        buffer_info->sharingMode = VK_SHARING_MODE_CONCURRENT;
+        buffer_info->queueFamilyIndexCount = 2;
+        buffer_info->pQueueFamilyIndices = out_family_indices;
+    } else {
+        buffer_info->sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    }
+}
+
 b8 vulkan_buffer_create_internal(renderbuffer* buffer) {
     if (!buffer) {
         KERROR("vulkan_buffer_create_internal requires a valid pointer to a buffer.");
@@ -2462,7 +6355,8 @@ b8 vulkan_buffer_create_internal(renderbuffer* buffer) {
 
     switch (buffer->type) {
         case RENDERBUFFER_TYPE_VERTEX:
-            internal_buffer.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+            // Also read as a storage buffer by shaders pulling their vertices.
+            internal_buffer.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
             internal_buffer.memory_property_flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
             break;
         case RENDERBUFFER_TYPE_INDEX:
@@ -2471,20 +6365,37 @@ b8 vulkan_buffer_create_internal(renderbuffer* buffer) {
             break;
         case RENDERBUFFER_TYPE_UNIFORM: {
             u32 device_local_bits = context.device.supports_device_local_host_visible ? VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT : 0;
-            internal_buffer.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            // Also read as storage, as bindless shaders read their instance uniforms as a table.
+            internal_buffer.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
             internal_buffer.memory_property_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | device_local_bits;
         } break;
         case RENDERBUFFER_TYPE_STAGING:
             internal_buffer.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
             internal_buffer.memory_property_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
             break;
+        case RENDERBUFFER_TYPE_STAGING_CACHED:
+            // Without cached memory, reads by the host go straight to the memory, which makes them very slow.
+            internal_buffer.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+            internal_buffer.memory_property_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+            if (host_cached_memory_supported()) {
+                internal_buffer.memory_property_flags |= VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+            }
+            break;
         case RENDERBUFFER_TYPE_READ:
             internal_buffer.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
             internal_buffer.memory_property_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
             break;
-        case RENDERBUFFER_TYPE_STORAGE:
-            KERROR("Storage buffer not yet supported.");
-            return false;
+        case RENDERBUFFER_TYPE_STORAGE: {
+            u32 device_local_bits = context.device.supports_device_local_host_visible ? VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT : 0;
+            internal_buffer.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+            internal_buffer.memory_property_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | device_local_bits;
+        } break;
+        case RENDERBUFFER_TYPE_INDIRECT: {
+            u32 device_local_bits = context.device.supports_device_local_host_visible ? VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT : 0;
+            // Also a storage buffer, since culling rewrites the commands.
+            internal_buffer.usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+            internal_buffer.memory_property_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | device_local_bits;
+        } break;
         default:
             KERROR("Unsupported buffer type: %i", buffer->type);
             return false;
@@ -2493,25 +6404,19 @@ b8 vulkan_buffer_create_internal(renderbuffer* buffer) {
     VkBufferCreateInfo buffer_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
     buffer_info.size = buffer->total_size;
     buffer_info.usage = internal_buffer.usage;
-    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;  // NOTE: Only used in one queue.
+    u32 family_indices[2];
+    buffer_sharing_set(&buffer_info, buffer->type, family_indices);
 
     VK_CHECK(vkCreateBuffer(context.device.logical_device, &buffer_info, context.allocator, &internal_buffer.handle));
 
-    // Gather memory requirements.
-    vkGetBufferMemoryRequirements(context.device.logical_device, internal_buffer.handle, &internal_buffer.memory_requirements);
-    internal_buffer.memory_index = context.find_memory_index(internal_buffer.memory_requirements.memoryTypeBits, internal_buffer.memory_property_flags);
-    if (internal_buffer.memory_index == -1) {
-        KERROR("Unable to create vulkan buffer because the required memory type index was not found.");
+    // Allocate memory. Staging and read buffers are short-lived, so come from transient blocks.
+    b8 transient = buffer->type == RENDERBUFFER_TYPE_STAGING || buffer->type == RENDERBUFFER_TYPE_STAGING_CACHED || buffer->type == RENDERBUFFER_TYPE_READ;
+    if (!vulkan_memory_allocate_buffer(&context, internal_buffer.handle, internal_buffer.memory_property_flags, transient, &internal_buffer.memory_requirements, &internal_buffer.allocation)) {
+        KERROR("Unable to create vulkan buffer because the required memory allocation failed.");
+        vkDestroyBuffer(context.device.logical_device, internal_buffer.handle, context.allocator);
         return false;
     }
-
-    // Allocate memory info
-    VkMemoryAllocateInfo allocate_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
-    allocate_info.allocationSize = internal_buffer.memory_requirements.size;
-    allocate_info.memoryTypeIndex = (u32)internal_buffer.memory_index;
-
-    // Allocate the memory.
-    VkResult result = vkAllocateMemory(context.device.logical_device, &allocate_info, context.allocator, &internal_buffer.memory);
+    internal_buffer.memory_index = (i32)internal_buffer.allocation.memory_type;
 
     // Determine if memory is on a device heap.
     b8 is_device_memory = (internal_buffer.memory_property_flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) == VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
@@ -2519,11 +6424,6 @@ b8 vulkan_buffer_create_internal(renderbuffer* buffer) {
     // Report memory as in-use.
     kallocate_report(internal_buffer.memory_requirements.size, is_device_memory ? MEMORY_TAG_GPU_LOCAL : MEMORY_TAG_VULKAN);
 
-    if (result != VK_SUCCESS) {
-        KERROR("Unable to create vulkan buffer because the required memory allocation failed. Error: %i", result);
-        return false;
-    }
-
     // Allocate the internal state block of memory at the end once we are sure everything was created successfully.
     buffer->internal_data = kallocate(sizeof(vulkan_buffer), MEMORY_TAG_VULKAN);
     *((vulkan_buffer*)buffer->internal_data) = internal_buffer;
@@ -2531,26 +6431,34 @@ b8 vulkan_buffer_create_internal(renderbuffer* buffer) {
     return true;
 }
 
+// Destroys a buffer and frees its memory.
+static void buffer_internal_destroy(vulkan_buffer* internal_buffer) {
+    if (internal_buffer->handle) {
+        vkDestroyBuffer(context.device.logical_device, internal_buffer->handle, context.allocator);
+        internal_buffer->handle = 0;
+    }
+    vulkan_memory_free(&context, &internal_buffer->allocation);
+
+    // Report the free memory.
+    b8 is_device_memory = (internal_buffer->memory_property_flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) == VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    kfree_report(internal_buffer->memory_requirements.size, is_device_memory ? MEMORY_TAG_GPU_LOCAL : MEMORY_TAG_VULKAN);
+    kzero_memory(&internal_buffer->memory_requirements, sizeof(VkMemoryRequirements));
+
+    internal_buffer->usage = 0;
+    internal_buffer->is_locked = false;
+}
+
 void vulkan_buffer_destroy_internal(renderbuffer* buffer) {
     if (buffer) {
         vulkan_buffer* internal_buffer = (vulkan_buffer*)buffer->internal_data;
         if (internal_buffer) {
-            if (internal_buffer->memory) {
-                vkFreeMemory(context.device.logical_device, internal_buffer->memory, context.allocator);
-                internal_buffer->memory = 0;
-            }
-            if (internal_buffer->handle) {
-                vkDestroyBuffer(context.device.logical_device, internal_buffer->handle, context.allocator);
-                internal_buffer->handle = 0;
-            }
+            // Ranges of the buffer still waiting to be freed go with it.
+            deferred_ranges_forget(buffer);
 
-            // Report the free memory.
-            b8 is_device_memory = (internal_buffer->memory_property_flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) == VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-            kfree_report(internal_buffer->memory_requirements.size, is_device_memory ? MEMORY_TAG_GPU_LOCAL : MEMORY_TAG_VULKAN);
-            kzero_memory(&internal_buffer->memory_requirements, sizeof(VkMemoryRequirements));
-
-            internal_buffer->usage = 0;
-            internal_buffer->is_locked = false;
+            // Frames in flight, and copies staged or submitted for them, may still use the buffer.
+            vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_BUFFER};
+            deletion.buffer = *internal_buffer;
+            deferred_delete(&deletion);
 
             // Free up the internal buffer.
             kfree(buffer->internal_data, sizeof(vulkan_buffer), MEMORY_TAG_VULKAN);
@@ -2570,57 +6478,42 @@ b8 vulkan_buffer_resize(renderbuffer* buffer, u64 new_size) {
     VkBufferCreateInfo buffer_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
     buffer_info.size = new_size;
     buffer_info.usage = internal_buffer->usage;
-    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;  // NOTE: Only used in one queue.
+    u32 family_indices[2];
+    buffer_sharing_set(&buffer_info, buffer->type, family_indices);
 
     VkBuffer new_buffer;
     VK_CHECK(vkCreateBuffer(context.device.logical_device, &buffer_info, context.allocator, &new_buffer));
 
-    // Gather memory requirements.
+    // Allocate memory for it.
     VkMemoryRequirements requirements;
-    vkGetBufferMemoryRequirements(context.device.logical_device, new_buffer, &requirements);
-
-    // Allocate memory info
-    VkMemoryAllocateInfo allocate_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
-    allocate_info.allocationSize = requirements.size;
-    allocate_info.memoryTypeIndex = (u32)internal_buffer->memory_index;
-
-    // Allocate the memory.
-    VkDeviceMemory new_memory;
-    VkResult result = vkAllocateMemory(context.device.logical_device, &allocate_info, context.allocator, &new_memory);
-    if (result != VK_SUCCESS) {
-        KERROR("Unable to resize vulkan buffer because the required memory allocation failed. Error: %i", result);
+    vulkan_memory_allocation new_allocation;
+    b8 transient = buffer->type == RENDERBUFFER_TYPE_STAGING || buffer->type == RENDERBUFFER_TYPE_STAGING_CACHED || buffer->type == RENDERBUFFER_TYPE_READ;
+    if (!vulkan_memory_allocate_buffer(&context, new_buffer, internal_buffer->memory_property_flags, transient, &requirements, &new_allocation)) {
+        KERROR("Unable to resize vulkan buffer because the required memory allocation failed.");
+        vkDestroyBuffer(context.device.logical_device, new_buffer, context.allocator);
         return false;
     }
 
     // Bind the new buffer's memory
-    VK_CHECK(vkBindBufferMemory(context.device.logical_device, new_buffer, new_memory, 0));
+    VK_CHECK(vkBindBufferMemory(context.device.logical_device, new_buffer, new_allocation.memory, new_allocation.offset));
 
-    // Copy over the data.
-    vulkan_buffer_copy_range_internal(internal_buffer->handle, 0, new_buffer, 0, buffer->total_size);
-
-    // Make sure anything potentially using these is finished.
-    // NOTE: We could use vkQueueWaitIdle here if we knew what queue this buffer would be used with...
-    vkDeviceWaitIdle(context.device.logical_device);
+    // Copy over the data, once nothing is still being copied into it on another queue.
+    geometry_uploads_update(true);
+    vulkan_buffer_copy_range_internal(internal_buffer->handle, 0, new_buffer, 0, buffer->total_size, true);
 
-    // Destroy the old
-    if (internal_buffer->memory) {
-        vkFreeMemory(context.device.logical_device, internal_buffer->memory, context.allocator);
-        internal_buffer->memory = 0;
-    }
-    if (internal_buffer->handle) {
-        vkDestroyBuffer(context.device.logical_device, internal_buffer->handle, context.allocator);
-        internal_buffer->handle = 0;
-    }
+    // Frames in flight may still use the old buffer, so destroy it once they are finished.
+    vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_BUFFER};
+    deletion.buffer = *internal_buffer;
+    deferred_delete(&deletion);
 
-    // Report free of the old, allocate of the new.
+    // Report allocate of the new. The free of the old is reported when it is destroyed.
     b8 is_device_memory = (internal_buffer->memory_property_flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) == VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
-    kfree_report(internal_buffer->memory_requirements.size, is_device_memory ? MEMORY_TAG_GPU_LOCAL : MEMORY_TAG_VULKAN);
     internal_buffer->memory_requirements = requirements;
     kallocate_report(internal_buffer->memory_requirements.size, is_device_memory ? MEMORY_TAG_GPU_LOCAL : MEMORY_TAG_VULKAN);
 
     // Set new properties
-    internal_buffer->memory = new_memory;
+    internal_buffer->allocation = new_allocation;
     internal_buffer->handle = new_buffer;
 
     return true;
@@ -2632,7 +6525,7 @@ b8 vulkan_buffer_bind(renderbuffer* buffer, u64 offset) {
         return false;
     }
     vulkan_buffer* internal_buffer = (vulkan_buffer*)buffer->internal_data;
-    VK_CHECK(vkBindBufferMemory(context.device.logical_device, internal_buffer->handle, internal_buffer->memory, offset));
+    VK_CHECK(vkBindBufferMemory(context.device.logical_device, internal_buffer->handle, internal_buffer->allocation.memory, internal_buffer->allocation.offset + offset));
     return true;
 }
 
@@ -2653,9 +6546,8 @@ void* vulkan_buffer_map_memory(renderbuffer* buffer, u64 offset, u64 size) {
         return 0;
     }
     vulkan_buffer* internal_buffer = (vulkan_buffer*)buffer->internal_data;
-    void* data;
-    VK_CHECK(vkMapMemory(context.device.logical_device, internal_buffer->memory, offset, size, 0, &data));
-    return data;
+    // NOTE: Host-visible memory stays mapped while allocated, since a block is shared by many buffers.
+    return vulkan_memory_map(&internal_buffer->allocation, offset);
 }
 
 void vulkan_buffer_unmap_memory(renderbuffer* buffer, u64 offset, u64 size) {
@@ -2663,8 +6555,7 @@ void vulkan_buffer_unmap_memory(renderbuffer* buffer, u64 offset, u64 size) {
         KERROR("vulkan_buffer_unmap_memory requires a valid pointer to a buffer.");
         return;
     }
-    vulkan_buffer* internal_buffer = (vulkan_buffer*)buffer->internal_data;
-    vkUnmapMemory(context.device.logical_device, internal_buffer->memory);
+    // NOTE: Does nothing, as the memory stays mapped while it is allocated.
 }
 
 b8 vulkan_buffer_flush(renderbuffer* buffer, u64 offset, u64 size) {
@@ -2675,11 +6566,7 @@ b8 vulkan_buffer_flush(renderbuffer* buffer, u64 offset, u64 size) {
     // NOTE: If not host-coherent, flush the mapped memory range.
     vulkan_buffer* internal_buffer = (vulkan_buffer*)buffer->internal_data;
     if (!vulkan_buffer_is_host_coherent(internal_buffer)) {
-        VkMappedMemoryRange range = {VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE};
-        range.memory = internal_buffer->memory;
-        range.offset = offset;
-        range.size = size;
-        VK_CHECK(vkFlushMappedMemoryRanges(context.device.logical_device, 1, &range));
+        vulkan_memory_flush(&context, &internal_buffer->allocation, offset, size);
     }
 
     return true;
@@ -2708,21 +6595,15 @@ b8 vulkan_buffer_read(renderbuffer* buffer, u64 offset, u64 size, void** out_mem
         // Perform the copy from device local to the read buffer.
         vulkan_buffer_copy_range(buffer, offset, &read, 0, size);
 
-        // Map/copy/unmap
-        void* mapped_data;
-        VK_CHECK(vkMapMemory(context.device.logical_device, read_internal->memory, 0, size, 0, &mapped_data));
-        kcopy_memory(*out_memory, mapped_data, size);
-        vkUnmapMemory(context.device.logical_device, read_internal->memory);
+        // Copy out of the mapped memory.
+        kcopy_memory(*out_memory, vulkan_memory_map(&read_internal->allocation, 0), size);
 
         // Clean up the read buffer.
         renderer_renderbuffer_unbind(&read);
         renderer_renderbuffer_destroy(&read);
     } else {
-        // If no staging buffer is needed, map/copy/unmap.
-        void* data_ptr;
-        VK_CHECK(vkMapMemory(context.device.logical_device, internal_buffer->memory, offset, size, 0, &data_ptr));
-        kcopy_memory(*out_memory, data_ptr, size);
-        vkUnmapMemory(context.device.logical_device, internal_buffer->memory);
+        // If no staging buffer is needed, copy out of the mapped memory.
+        kcopy_memory(*out_memory, vulkan_memory_map(&internal_buffer->allocation, offset), size);
     }
 
     return true;
@@ -2739,6 +6620,23 @@ b8 vulkan_buffer_load_range(renderbuffer* buffer, u64 offset, u64 size, const vo
         // NOTE: If a staging buffer is needed (i.e.) the target buffer's memory is not host visible but is device-local,
         // create a staging buffer to load the data into first. Then copy from it to the target buffer.
 
+        counter_add(context.staged_uploads_counter, 1);
+        counter_add(context.staged_bytes_counter, (i64)size);
+
+        // Stage through the staging ring, with the copy running ahead of the next frame, if there is room.
+        u64 staging_offset;
+        vulkan_command_buffer* ring_command_buffer = staging_ring_begin(size, &staging_offset);
+        if (ring_command_buffer) {
+            vulkan_buffer* ring_buffer = (vulkan_buffer*)context.staging_ring.buffer.internal_data;
+            kcopy_memory(vulkan_memory_map(&ring_buffer->allocation, staging_offset), data, size);
+            VkBufferCopy copy_region;
+            copy_region.srcOffset = staging_offset;
+            copy_region.dstOffset = offset;
+            copy_region.size = size;
+            vkCmdCopyBuffer(ring_command_buffer->handle, ring_buffer->handle, internal_buffer->handle, 1, &copy_region);
+            return true;
+        }
+
         // Create a host-visible staging buffer to upload to. Mark it as the source of the transfer.
         renderbuffer staging;
         if (!renderer_renderbuffer_create(RENDERBUFFER_TYPE_STAGING, size, false, &staging)) {
@@ -2750,31 +6648,36 @@ b8 vulkan_buffer_load_range(renderbuffer* buffer, u64 offset, u64 size, const vo
         // Load the data into the staging buffer.
         vulkan_buffer_load_range(&staging, 0, size, data);
 
-        // Perform the copy from staging to the device local buffer.
-        vulkan_buffer_copy_range(&staging, 0, buffer, offset, size);
+        // Perform the copy from staging to the device local buffer, without waiting for it.
+        vulkan_buffer_copy_range_internal(((vulkan_buffer*)staging.internal_data)->handle, 0, internal_buffer->handle, offset, size, false);
 
-        // Clean up the staging buffer.
+        // Clean up the staging buffer. It is destroyed once the copy is complete.
         renderer_renderbuffer_unbind(&staging);
         renderer_renderbuffer_destroy(&staging);
     } else {
-        // If no staging buffer is needed, map/copy/unmap.
-        void* data_ptr;
-        VK_CHECK(vkMapMemory(context.device.logical_device, internal_buffer->memory, offset, size, 0, &data_ptr));
-        kcopy_memory(data_ptr, data, size);
-        vkUnmapMemory(context.device.logical_device, internal_buffer->memory);
+        // If no staging buffer is needed, copy into the mapped memory.
+        kcopy_memory(vulkan_memory_map(&internal_buffer->allocation, offset), data, size);
     }
 
     return true;
 }
 
-b8 vulkan_buffer_copy_range_internal(VkBuffer source, u64 source_offset, VkBuffer dest, u64 dest_offset, u64 size) {
+b8 vulkan_buffer_copy_range_internal(VkBuffer source, u64 source_offset, VkBuffer dest, u64 dest_offset, u64 size, b8 wait) {
+    // Uploads staged for the next frame may write to either buffer, so must go first.
+    staging_ring_flush();
+
     // TODO: Assuming queue and pool usage here. Might want dedicated queue.
     VkQueue queue = context.device.graphics_queue;
-    vkQueueWaitIdle(queue);
     // Create a one-time-use command buffer.
     vulkan_command_buffer temp_command_buffer;
     vulkan_command_buffer_allocate_and_begin_single_use(&context, context.device.graphics_command_pool, &temp_command_buffer);
 
+    // Earlier work on the queue may still be writing the source or using the destination.
+    VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(temp_command_buffer.handle, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, 0, 0, 0);
+
     // Prepare the copy command and add it to the command buffer.
     VkBufferCopy copy_region;
     copy_region.srcOffset = source_offset;
@@ -2782,12 +6685,21 @@ b8 vulkan_buffer_copy_range_internal(VkBuffer source, u64 source_offset, VkBuffe
     copy_region.size = size;
     vkCmdCopyBuffer(temp_command_buffer.handle, source, dest, 1, &copy_region);
 
-    // Submit the buffer for execution and wait for it to complete.
-    vulkan_command_buffer_end_single_use(&context, context.device.graphics_command_pool, &temp_command_buffer, queue);
+    // Make the copied data visible to whatever is submitted after it.
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    vkCmdPipelineBarrier(temp_command_buffer.handle, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, 0, 0, 0);
+
+    if (wait) {
+        // Submit the buffer for execution and wait for it to complete.
+        vulkan_command_buffer_end_single_use(&context, context.device.graphics_command_pool, &temp_command_buffer, queue);
+    } else {
+        // Submit the buffer ahead of the frame being recorded, which is ordered after it on the queue.
+        single_use_submit(&temp_command_buffer, context.device.graphics_command_pool, queue);
+    }
 
     return true;
 }
-
 b8 vulkan_buffer_copy_range(renderbuffer* source, u64 source_offset, renderbuffer* dest, u64 dest_offset, u64 size) {
     if (!source || !source->internal_data || !dest || !dest->internal_data || !size) {
         KERROR("vulkan_buffer_copy_range requires a valid pointers to source and destination buffers as well as a nonzero size.");
@@ -2799,12 +6711,14 @@ b8 vulkan_buffer_copy_range(renderbuffer* source, u64 source_offset, renderbuffe
         source_offset,
         ((vulkan_buffer*)dest->internal_data)->handle,
         dest_offset,
-        size);
-    return true;
+        size,
+        true);
 }
 
 b8 vulkan_buffer_draw(renderbuffer* buffer, u64 offset, u32 element_count, b8 bind_only) {
     vulkan_command_buffer* command_buffer = &context.graphics_command_buffers[context.image_index];
+    // Whichever buffer this binds replaces the geometry buffers.
+    command_buffer->bound_geometry_block = INVALID_ID;
 
     if (buffer->type == RENDERBUFFER_TYPE_VERTEX) {
         // Bind vertex buffer at offset.
@@ -2815,8 +6729,10 @@ b8 vulkan_buffer_draw(renderbuffer* buffer, u64 offset, u32 element_count, b8 bi
         }
         return true;
     } else if (buffer->type == RENDERBUFFER_TYPE_INDEX) {
-        // Bind index buffer at offset.
-        vkCmdBindIndexBuffer(command_buffer->handle, ((vulkan_buffer*)buffer->internal_data)->handle, offset, VK_INDEX_TYPE_UINT32);
+        // Bind index buffer at offset. Only the 16-bit geometry index buffers hold anything but 32-bit indices.
+        VkIndexType index_type = geometry_index_buffer_is_16(buffer) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+        vkCmdBindIndexBuffer(command_buffer->handle, ((vulkan_buffer*)buffer->internal_data)->handle, offset, index_type);
+        command_buffer->bound_index_size = 0;
         if (!bind_only) {
             vkCmdDrawIndexed(command_buffer->handle, element_count, 1, 0, 0, 0);
         }
@@ -2826,3 +6742,23 @@ b8 vulkan_buffer_draw(renderbuffer* buffer, u64 offset, u32 element_count, b8 bi
         return false;
     }
 }
+
+STATIC_ASSERT(sizeof(renderer_draw_indirect_command) == sizeof(VkDrawIndirectCommand), "renderer_draw_indirect_command must match VkDrawIndirectCommand.");
+
+b8 vulkan_buffer_draw_indirect(renderbuffer* buffer, u64 offset) {
+    if (!buffer || !buffer->internal_data || buffer->type != RENDERBUFFER_TYPE_INDIRECT) {
+        KERROR("vulkan_buffer_draw_indirect requires a valid pointer to an indirect buffer.");
+        return false;
+    }
+    if (offset + sizeof(VkDrawIndirectCommand) > buffer->total_size) {
+        KERROR("vulkan_buffer_draw_indirect - the command at offset %llu is past the end of the buffer.", offset);
+        return false;
+    }
+    vulkan_command_buffer* command_buffer = &context.graphics_command_buffers[context.image_index];
+    if (command_buffer->state != COMMAND_BUFFER_STATE_IN_RENDER_PASS) {
+        KERROR("vulkan_buffer_draw_indirect must be called within a renderpass.");
+        return false;
+    }
+    vkCmdDrawIndirect(command_buffer->handle, ((vulkan_buffer*)buffer->internal_data)->handle, offset, 1, sizeof(VkDrawIndirectCommand));
+    return true;
+}
@@ -24,33 +24,53 @@ void vulkan_renderer_backend_shutdown(renderer_backend* backend);
 void vulkan_renderer_backend_on_resized(renderer_backend* backend, u16 width, u16 height);
 b8 vulkan_renderer_backend_begin_frame(renderer_backend* backend, f32 delta_time);
 b8 vulkan_renderer_backend_end_frame(renderer_backend* backend, f32 delta_time);
+void vulkan_renderer_backend_latency_wait(renderer_backend* backend);
 void vulkan_renderer_viewport_set(vec4 rect);
 void vulkan_renderer_viewport_reset();
 void vulkan_renderer_scissor_set(vec4 rect);
 void vulkan_renderer_scissor_reset();
+b8 vulkan_renderer_resolution_scale_supported();
+void vulkan_renderer_resolution_scale_begin(f32 scale);
+void vulkan_renderer_resolution_scale_end();
 b8 vulkan_renderer_renderpass_begin(renderpass* pass, render_target* target);
 b8 vulkan_renderer_renderpass_end(renderpass* pass);
+b8 vulkan_renderer_renderpass_begin_parallel(renderpass* pass, render_target* target);
+b8 vulkan_renderer_parallel_recording_supported();
 
 void vulkan_renderer_draw_geometry(geometry_render_data* data);
+void vulkan_renderer_draw_geometry_batch(u32 count, const geometry_render_data* data, const u32* highlights);
+void vulkan_renderer_draw_geometry_batches(u32 run_count, const renderer_batch_run* runs);
+void vulkan_renderer_draw_batch_cull_set(mat4 projection, mat4 view);
+void vulkan_renderer_dispatch(u32 group_count_x, u32 group_count_y, u32 group_count_z);
+void vulkan_renderer_barrier(renderer_barrier_type type);
 void vulkan_renderer_texture_create(const u8* pixels, texture* texture);
+void vulkan_renderer_texture_create_staged(renderbuffer* staging, texture* texture);
+b8 vulkan_renderer_texture_format_supported(texture_format format);
 void vulkan_renderer_texture_destroy(texture* texture);
 void vulkan_renderer_texture_create_writeable(texture* t);
 void vulkan_renderer_texture_resize(texture* t, u32 new_width, u32 new_height);
 void vulkan_renderer_texture_write_data(texture* t, u32 offset, u32 size, const u8* pixels);
+void vulkan_renderer_texture_write_region(texture* t, u32 x, u32 y, u32 width, u32 height, const u8* pixels);
 void vulkan_renderer_texture_read_data(texture* t, u32 offset, u32 size, void** out_memory);
 void vulkan_renderer_texture_read_pixel(texture* t, u32 x, u32 y, u8** out_rgba);
+b8 vulkan_renderer_texture_read_pixel_async(texture* t, u32 x, u32 y, u8* out_rgba);
 b8 vulkan_renderer_create_geometry(geometry* geometry, u32 vertex_size, u32 vertex_count, const void* vertices, u32 index_size, u32 index_count, const void* indices);
 void vulkan_renderer_destroy_geometry(geometry* geometry);
+b8 vulkan_renderer_geometry_skin_create(geometry* geometry, u32 vertex_count, const vertex_3d_skinned* vertices);
+void vulkan_renderer_geometry_skin_destroy(geometry* geometry);
+void vulkan_renderer_geometry_skins_update(u32 count, const renderer_skin_update* updates);
 
 b8 vulkan_renderer_shader_create(struct shader* shader, const shader_config* config, renderpass* pass, u8 stage_count, const char** stage_filenames, shader_stage* stages);
 void vulkan_renderer_shader_destroy(struct shader* shader);
 
 b8 vulkan_renderer_shader_initialize(struct shader* shader);
+b8 vulkan_renderer_shader_reload(struct shader* shader);
 b8 vulkan_renderer_shader_use(struct shader* shader);
 b8 vulkan_renderer_shader_bind_globals(struct shader* s);
 b8 vulkan_renderer_shader_bind_instance(struct shader* s, u32 instance_id);
 b8 vulkan_renderer_shader_apply_globals(struct shader* s);
 b8 vulkan_renderer_shader_apply_instance(struct shader* s, b8 needs_update);
+b8 vulkan_renderer_shader_apply_local(struct shader* s);
 b8 vulkan_renderer_shader_acquire_instance_resources(struct shader* s, texture_map** maps, u32* out_instance_id);
 b8 vulkan_renderer_shader_release_instance_resources(struct shader* s, u32 instance_id);
 b8 vulkan_renderer_set_uniform(struct shader* frontend_shader, struct shader_uniform* uniform, const void* value);
@@ -70,6 +90,7 @@ u8 vulkan_renderer_window_attachment_index_get();
 u8 vulkan_renderer_window_attachment_count_get();
 
 b8 vulkan_renderer_is_multithreaded();
+b8 vulkan_renderer_bindless_supported();
 
 b8 vulkan_buffer_create_internal(renderbuffer* buffer);
 void vulkan_buffer_destroy_internal(renderbuffer* buffer);
@@ -83,3 +104,4 @@ b8 vulkan_buffer_read(renderbuffer* buffer, u64 offset, u64 size, void** out_mem
 b8 vulkan_buffer_load_range(renderbuffer* buffer, u64 offset, u64 size, const void* data);
 b8 vulkan_buffer_copy_range(renderbuffer* source, u64 source_offset, renderbuffer* dest, u64 dest_offset, u64 size);
 b8 vulkan_buffer_draw(renderbuffer* buffer, u64 offset, u32 element_count, b8 bind_only);
+b8 vulkan_buffer_draw_indirect(renderbuffer* buffer, u64 offset);
@@ -2,6 +2,7 @@
 
 #include "vulkan_device.h"
 #include "vulkan_command_buffer.h"
+#include "vulkan_memory.h"
 #include "vulkan_utils.h"
 
 #include "core/logger.h"
@@ -48,37 +49,18 @@ b8 vulkan_buffer_create(
 
     VK_CHECK(vkCreateBuffer(context->device.logical_device, &buffer_info, context->allocator, &out_buffer->handle));
 
-    // Gather memory requirements.
+    // Allocate memory.
     VkMemoryRequirements requirements;
-    vkGetBufferMemoryRequirements(context->device.logical_device, out_buffer->handle, &requirements);
-    out_buffer->memory_index = context->find_memory_index(requirements.memoryTypeBits, out_buffer->memory_property_flags);
-    if (out_buffer->memory_index == -1) {
-        KERROR("Unable to create vulkan buffer because the required memory type index was not found.");
-
-        // Make sure to destroy the freelist.
-        cleanup_freelist(out_buffer);
-        return false;
-    }
-
-    // Allocate memory info
-    VkMemoryAllocateInfo allocate_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
-    allocate_info.allocationSize = requirements.size;
-    allocate_info.memoryTypeIndex = (u32)out_buffer->memory_index;
-
-    // Allocate the memory.
-    VkResult result = vkAllocateMemory(
-        context->device.logical_device,
-        &allocate_info,
-        context->allocator,
-        &out_buffer->memory);
-
-    if (result != VK_SUCCESS) {
-        KERROR("Unable to create vulkan buffer because the required memory allocation failed. Error: %i", result);
+    if (!vulkan_memory_allocate_buffer(context, out_buffer->handle, out_buffer->memory_property_flags, false, &requirements, &out_buffer->allocation)) {
+        KERROR("Unable to create vulkan buffer because the required memory allocation failed.");
 
         // Make sure to destroy the freelist.
         cleanup_freelist(out_buffer);
+        vkDestroyBuffer(context->device.logical_device, out_buffer->handle, context->allocator);
+        out_buffer->handle = 0;
         return false;
     }
+    out_buffer->memory_index = (i32)out_buffer->allocation.memory_type;
 
     if (bind_on_create) {
         vulkan_buffer_bind(context, out_buffer, 0);
@@ -92,14 +74,11 @@ void vulkan_buffer_destroy(vulkan_context* context, vulkan_buffer* buffer) {
         // Make sure to destroy the freelist.
         cleanup_freelist(buffer);
     }
-    if (buffer->memory) {
-        vkFreeMemory(context->device.logical_device, buffer->memory, context->allocator);
-        buffer->memory = 0;
-    }
     if (buffer->handle) {
         vkDestroyBuffer(context->device.logical_device, buffer->handle, context->allocator);
         buffer->handle = 0;
     }
+    vulkan_memory_free(context, &buffer->allocation);
     buffer->total_size = 0;
     buffer->usage = 0;
     buffer->is_locked = false;
@@ -107,17 +86,16 @@ void vulkan_buffer_destroy(vulkan_context* context, vulkan_buffer* buffer) {
 
 
 static void vulkan_buffer_bind(vulkan_context* context, vulkan_buffer* buffer, u64 offset) {
-    VK_CHECK(vkBindBufferMemory(context->device.logical_device, buffer->handle, buffer->memory, offset));
+    VK_CHECK(vkBindBufferMemory(context->device.logical_device, buffer->handle, buffer->allocation.memory, buffer->allocation.offset + offset));
 }
 
 void* vulkan_buffer_lock_memory(vulkan_context* context, vulkan_buffer* buffer, u64 offset, u64 size, u32 flags) {
-    void* data;
-    VK_CHECK(vkMapMemory(context->device.logical_device, buffer->memory, offset, size, flags, &data));
-    return data;
+    // NOTE: Host-visible memory stays mapped while allocated, since a block is shared by many buffers.
+    return vulkan_memory_map(&buffer->allocation, offset);
 }
 
 void vulkan_buffer_unlock_memory(vulkan_context* context, vulkan_buffer* buffer) {
-    vkUnmapMemory(context->device.logical_device, buffer->memory);
+    // NOTE: Does nothing, as the memory stays mapped while it is allocated.
 }
 
 b8 vulkan_buffer_allocate(vulkan_buffer* buffer, u64 size, u64* out_offset) {
@@ -148,10 +126,7 @@ b8 vulkan_buffer_free(vulkan_buffer* buffer, u64 size, u64 offset) {
 }
 
 void vulkan_buffer_load_data(vulkan_context* context, vulkan_buffer* buffer, u64 offset, u64 size, u32 flags, const void* data) {
-    void* data_ptr;
-    VK_CHECK(vkMapMemory(context->device.logical_device, buffer->memory, offset, size, flags, &data_ptr));
-    kcopy_memory(data_ptr, data, size);
-    vkUnmapMemory(context->device.logical_device, buffer->memory);
+    kcopy_memory(vulkan_memory_map(&buffer->allocation, offset), data, size);
 }
 
 void vulkan_buffer_copy_to(
@@ -58,6 +58,41 @@ void vulkan_command_buffer_begin(
 
     VK_CHECK(vkBeginCommandBuffer(command_buffer->handle, &begin_info));
     command_buffer->state = COMMAND_BUFFER_STATE_RECORDING;
+    command_buffer->bound_geometry_block = INVALID_ID;
+    command_buffer->bound_index_size = 0;
+    command_buffer->bound_vertex_set_layout = 0;
+}
+
+void vulkan_command_buffer_begin_secondary(
+    vulkan_command_buffer* command_buffer,
+    const vulkan_renderpass* renderpass,
+    VkFramebuffer framebuffer) {
+
+    VkCommandBufferInheritanceInfo inheritance_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
+    inheritance_info.renderPass = renderpass->handle;
+    inheritance_info.subpass = 0;
+    inheritance_info.framebuffer = renderpass->handle ? framebuffer : 0;
+
+    // Without a render pass object, what is rendered to is described by its formats.
+    VkCommandBufferInheritanceRenderingInfoKHR rendering_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR};
+    if (!renderpass->handle) {
+        rendering_info.colorAttachmentCount = renderpass->colour_attachment_count;
+        rendering_info.pColorAttachmentFormats = renderpass->colour_formats;
+        rendering_info.depthAttachmentFormat = renderpass->depth_format;
+        rendering_info.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+        rendering_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+        inheritance_info.pNext = &rendering_info;
+    }
+
+    VkCommandBufferBeginInfo begin_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    begin_info.pInheritanceInfo = &inheritance_info;
+
+    VK_CHECK(vkBeginCommandBuffer(command_buffer->handle, &begin_info));
+    command_buffer->state = COMMAND_BUFFER_STATE_IN_RENDER_PASS;
+    command_buffer->bound_geometry_block = INVALID_ID;
+    command_buffer->bound_index_size = 0;
+    command_buffer->bound_vertex_set_layout = 0;
 }
 
 void vulkan_command_buffer_end(vulkan_command_buffer* command_buffer) {
@@ -90,14 +125,19 @@ void vulkan_command_buffer_end_single_use(
     // End the command buffer.
     vulkan_command_buffer_end(command_buffer);
 
-    // Submit the queue
+    // Submit the queue, with a fence to wait on for just this submission.
+    VkFenceCreateInfo fence_info = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+    VkFence fence;
+    VK_CHECK(vkCreateFence(context->device.logical_device, &fence_info, context->allocator, &fence));
+
     VkSubmitInfo submit_info = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
     submit_info.commandBufferCount = 1;
     submit_info.pCommandBuffers = &command_buffer->handle;
-    VK_CHECK(vkQueueSubmit(queue, 1, &submit_info, 0));
+    VK_CHECK(vkQueueSubmit(queue, 1, &submit_info, fence));
 
     // Wait for it to finish
-    VK_CHECK(vkQueueWaitIdle(queue));
+    VK_CHECK(vkWaitForFences(context->device.logical_device, 1, &fence, true, UINT64_MAX));
+    vkDestroyFence(context->device.logical_device, fence, context->allocator);
 
     // Free the command buffer.
     vulkan_command_buffer_free(context, pool, command_buffer);
@@ -53,6 +53,19 @@ void vulkan_command_buffer_begin(
     b8 is_renderpass_continue,
     b8 is_simultaneous_use);
 
+/**
+ * @brief Begins the provided secondary command buffer to be executed within the first subpass of
+ * a renderpass, which must have been begun for secondary command buffers.
+ * 
+ * @param command_buffer A pointer to the secondary command buffer to begin.
+ * @param renderpass A pointer to the renderpass the command buffer is executed within.
+ * @param framebuffer The framebuffer the renderpass was begun with. Optional, and unused when rendering dynamically.
+ */
+void vulkan_command_buffer_begin_secondary(
+    vulkan_command_buffer* command_buffer,
+    const vulkan_renderpass* renderpass,
+    VkFramebuffer framebuffer);
+
 /**
  * @brief Ends the given command buffer.
  * 
@@ -87,7 +100,8 @@ void vulkan_command_buffer_allocate_and_begin_single_use(
     vulkan_command_buffer* out_command_buffer);
 
 /**
- * @brief Ends recording, submits to and waits for queue operation and frees the provided command buffer.
+ * @brief Ends recording, submits to the queue, waits on a fence for the submission to complete and frees
+ * the provided command buffer.
  * 
  * @param context A pointer to the Vulkan context.
  * @param pool The pool to return a command buffer to.
@@ -0,0 +1,489 @@
+#include "vulkan_cull.h"
+
+#include "vulkan_backend.h"
+#include "vulkan_image.h"
+#include "vulkan_pipeline.h"
+#include "vulkan_shader_utils.h"
+#include "vulkan_utils.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+#include "renderer/renderer_frontend.h"
+
+/** @brief The workgroup size of the cull shader. */
+#define CULL_GROUP_SIZE 64
+/** @brief The workgroup width and height of the depth pyramid shader. */
+#define PYRAMID_GROUP_SIZE 8
+
+// Gets the parameters of the current frame.
+static vulkan_cull_params* cull_params_get(vulkan_context* context) {
+    vulkan_cull_state* cull = &context->cull;
+    return (vulkan_cull_params*)(cull->params + cull->params_stride * context->current_frame);
+}
+
+// Creates a compute pipeline from the given compiled shader, with a single set.
+static b8 compute_pipeline_create(vulkan_context* context, const char* name, VkDescriptorSetLayout set_layout, vulkan_pipeline* out_pipeline) {
+    vulkan_shader_stage stage;
+    if (!create_shader_module(context, name, "comp", VK_SHADER_STAGE_COMPUTE_BIT, 0, &stage)) {
+        return false;
+    }
+    b8 result = vulkan_compute_pipeline_create(context, &stage.shader_stage_create_info, 1, &set_layout, 0, out_pipeline);
+    vkDestroyShaderModule(context->device.logical_device, stage.handle, context->allocator);
+    return result;
+}
+
+// Creates a set layout of bindings of the given types, in order, for the compute stage.
+static b8 compute_set_layout_create(vulkan_context* context, u32 binding_count, const VkDescriptorType* types, VkDescriptorSetLayout* out_layout) {
+    VkDescriptorSetLayoutBinding bindings[4];
+    kzero_memory(bindings, sizeof(VkDescriptorSetLayoutBinding) * 4);
+    for (u32 i = 0; i < binding_count; ++i) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = types[i];
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo layout_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    layout_info.bindingCount = binding_count;
+    layout_info.pBindings = bindings;
+    VkResult result = vkCreateDescriptorSetLayout(context->device.logical_device, &layout_info, context->allocator, out_layout);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("Failed to create a cull set layout: '%s'", vulkan_result_string(result, true));
+        return false;
+    }
+    return true;
+}
+
+// Writes a buffer binding of a cull set.
+static void buffer_binding_write(vulkan_context* context, VkDescriptorSet set, u32 binding, renderbuffer* buffer, u64 offset, u64 size) {
+    VkDescriptorBufferInfo buffer_info;
+    buffer_info.buffer = ((vulkan_buffer*)buffer->internal_data)->handle;
+    buffer_info.offset = offset;
+    buffer_info.range = size;
+
+    VkWriteDescriptorSet write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+    write.dstSet = set;
+    write.dstBinding = binding;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.descriptorCount = 1;
+    write.pBufferInfo = &buffer_info;
+    vkUpdateDescriptorSets(context->device.logical_device, 1, &write, 0, 0);
+}
+
+// Writes an image binding of a set, sampled or storage.
+static void image_binding_write(vulkan_context* context, VkDescriptorSet set, u32 binding, VkDescriptorType type, VkImageView view, VkImageLayout layout) {
+    VkDescriptorImageInfo image_info;
+    image_info.sampler = type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER ? context->cull.sampler : 0;
+    image_info.imageView = view;
+    image_info.imageLayout = layout;
+
+    VkWriteDescriptorSet write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+    write.dstSet = set;
+    write.dstBinding = binding;
+    write.descriptorType = type;
+    write.descriptorCount = 1;
+    write.pImageInfo = &image_info;
+    vkUpdateDescriptorSets(context->device.logical_device, 1, &write, 0, 0);
+}
+
+b8 vulkan_cull_create(vulkan_context* context) {
+    vulkan_cull_state* cull = &context->cull;
+    vulkan_draw_batch* batch = &context->draw_batch;
+    VkDevice device = context->device.logical_device;
+    u32 frame_count = context->swapchain.max_frames_in_flight;
+
+    // Culled draws are skipped by the GPU reading their instance count, which only happens when drawn indirectly.
+    if (!batch->multi_draw_indirect) {
+        KINFO("Batched draws are not drawn indirectly, so are not culled on the GPU.");
+        return false;
+    }
+
+    // The regions bound of the batch buffers must be aligned as storage buffers.
+    u64 storage_alignment = KMAX(context->device.properties.limits.minStorageBufferOffsetAlignment, 1);
+    u64 command_region_size = sizeof(VkDrawIndexedIndirectCommand) * batch->capacity;
+    if (command_region_size % storage_alignment) {
+        KWARN("The indirect draw region size %llu is not a multiple of the storage buffer offset alignment %llu. Draws are not culled on the GPU.", command_region_size, storage_alignment);
+        return false;
+    }
+
+    // The depth of the last frame needs to be sampled to cull against it.
+    VkFormatProperties format_properties;
+    vkGetPhysicalDeviceFormatProperties(context->device.physical_device, context->device.depth_format, &format_properties);
+    cull->occlusion_supported = (format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+    if (!cull->occlusion_supported) {
+        KINFO("The depth format cannot be sampled, so draws are only culled against the frustum.");
+    }
+
+    // Set layouts.
+    VkDescriptorType cull_types[4] = {
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER};
+    VkDescriptorType pyramid_types[2] = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE};
+    if (!compute_set_layout_create(context, 4, cull_types, &cull->cull_set_layout) ||
+        !compute_set_layout_create(context, 2, pyramid_types, &cull->pyramid_set_layout)) {
+        vulkan_cull_destroy(context);
+        return false;
+    }
+
+    // Pipelines. Missing shaders leave culling disabled rather than failing the renderer.
+    if (!compute_pipeline_create(context, "Builtin.CullShader", cull->cull_set_layout, &cull->cull_pipeline) ||
+        !compute_pipeline_create(context, "Builtin.DepthPyramidShader", cull->pyramid_set_layout, &cull->pyramid_pipeline)) {
+        KWARN("Failed to create the cull pipelines. Draws are not culled on the GPU.");
+        vulkan_cull_destroy(context);
+        return false;
+    }
+
+    // The sampler, which only ever fetches texels.
+    VkSamplerCreateInfo sampler_info = {VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+    sampler_info.magFilter = VK_FILTER_NEAREST;
+    sampler_info.minFilter = VK_FILTER_NEAREST;
+    sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.maxLod = VK_LOD_CLAMP_NONE;
+    VkResult result = vkCreateSampler(device, &sampler_info, context->allocator, &cull->sampler);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("Failed to create the cull sampler: '%s'", vulkan_result_string(result, true));
+        vulkan_cull_destroy(context);
+        return false;
+    }
+
+    // Parameters, one aligned region per frame in flight.
+    cull->params_stride = get_aligned(sizeof(vulkan_cull_params), storage_alignment);
+    if (!renderer_renderbuffer_create(RENDERBUFFER_TYPE_INDIRECT, cull->params_stride * frame_count, false, &cull->params_buffer)) {
+        KERROR("Failed to create the cull parameters buffer.");
+        vulkan_cull_destroy(context);
+        return false;
+    }
+    renderer_renderbuffer_bind(&cull->params_buffer, 0);
+    cull->params = vulkan_buffer_map_memory(&cull->params_buffer, 0, VK_WHOLE_SIZE);
+    kzero_memory(cull->params, cull->params_stride * frame_count);
+
+    cull->enabled = true;
+    vulkan_cull_targets_create(context);
+    return true;
+}
+
+void vulkan_cull_destroy(vulkan_context* context) {
+    vulkan_cull_state* cull = &context->cull;
+    VkDevice device = context->device.logical_device;
+
+    vulkan_cull_targets_destroy(context);
+    if (cull->params_buffer.internal_data) {
+        renderer_renderbuffer_unbind(&cull->params_buffer);
+        renderer_renderbuffer_destroy(&cull->params_buffer);
+    }
+    if (cull->sampler) {
+        vkDestroySampler(device, cull->sampler, context->allocator);
+    }
+    vulkan_pipeline_destroy(context, &cull->cull_pipeline);
+    vulkan_pipeline_destroy(context, &cull->pyramid_pipeline);
+    if (cull->pyramid_set_layout) {
+        vkDestroyDescriptorSetLayout(device, cull->pyramid_set_layout, context->allocator);
+    }
+    if (cull->cull_set_layout) {
+        vkDestroyDescriptorSetLayout(device, cull->cull_set_layout, context->allocator);
+    }
+    kzero_memory(cull, sizeof(vulkan_cull_state));
+}
+
+void vulkan_cull_targets_create(vulkan_context* context) {
+    vulkan_cull_state* cull = &context->cull;
+    if (!cull->enabled) {
+        return;
+    }
+    VkDevice device = context->device.logical_device;
+    vulkan_draw_batch* batch = &context->draw_batch;
+    u32 frame_count = context->swapchain.max_frames_in_flight;
+    u32 image_count = context->swapchain.image_count;
+
+    // A pool of its own, so the sets of the last swapchain can be deleted with it once no frame uses them.
+    u32 image_set_count = image_count + VULKAN_MAX_DEPTH_PYRAMID_LEVELS;
+    VkDescriptorPoolSize pool_sizes[3] = {
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * frame_count},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, frame_count + image_set_count},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, image_set_count}};
+    VkDescriptorPoolCreateInfo pool_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    pool_info.poolSizeCount = 3;
+    pool_info.pPoolSizes = pool_sizes;
+    pool_info.maxSets = frame_count + image_set_count;
+    VkResult result = vkCreateDescriptorPool(device, &pool_info, context->allocator, &cull->pyramid_descriptor_pool);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("Failed to create the depth pyramid descriptor pool: '%s'. Draws are not culled on the GPU.", vulkan_result_string(result, true));
+        cull->enabled = false;
+        return;
+    }
+
+    // The first level is half the size of the depth, rounded up, and each after it half the last.
+    texture* depth = &context->swapchain.depth_textures[0];
+    u32 width = KMAX((depth->width + 1) / 2, 1);
+    u32 height = KMAX((depth->height + 1) / 2, 1);
+    u32 level_count = 1;
+    for (u32 size = KMAX(width, height); size > 1 && level_count < VULKAN_MAX_DEPTH_PYRAMID_LEVELS; size = (size + 1) / 2) {
+        level_count++;
+    }
+
+    vulkan_image_create(
+        context,
+        TEXTURE_TYPE_2D,
+        width,
+        height,
+        level_count,
+        VK_FORMAT_R32_SFLOAT,
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        true,
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        &cull->pyramid);
+
+    for (u32 i = 0; i < level_count; ++i) {
+        VkImageViewCreateInfo view_info = {VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+        view_info.image = cull->pyramid.handle;
+        view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        view_info.format = VK_FORMAT_R32_SFLOAT;
+        view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        view_info.subresourceRange.baseMipLevel = i;
+        view_info.subresourceRange.levelCount = 1;
+        view_info.subresourceRange.baseArrayLayer = 0;
+        view_info.subresourceRange.layerCount = 1;
+        VK_CHECK(vkCreateImageView(device, &view_info, context->allocator, &cull->level_views[i]));
+    }
+
+    // A cull set per frame in flight, over the frame's regions of the batch buffers and the pyramid.
+    u64 command_region_size = sizeof(VkDrawIndexedIndirectCommand) * batch->capacity;
+    u64 draw_data_region_size = sizeof(vulkan_draw_data) * batch->capacity;
+    VkDescriptorSetLayout cull_layouts[VULKAN_MAX_FRAMES_IN_FLIGHT];
+    for (u32 i = 0; i < frame_count; ++i) {
+        cull_layouts[i] = cull->cull_set_layout;
+    }
+    VkDescriptorSetAllocateInfo alloc_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    alloc_info.descriptorPool = cull->pyramid_descriptor_pool;
+    alloc_info.descriptorSetCount = frame_count;
+    alloc_info.pSetLayouts = cull_layouts;
+    VK_CHECK(vkAllocateDescriptorSets(device, &alloc_info, cull->cull_sets));
+    for (u32 i = 0; i < frame_count; ++i) {
+        buffer_binding_write(context, cull->cull_sets[i], 0, &batch->draw_data_buffer, draw_data_region_size * i, draw_data_region_size);
+        buffer_binding_write(context, cull->cull_sets[i], 1, &batch->indirect_buffer, command_region_size * i, command_region_size);
+        buffer_binding_write(context, cull->cull_sets[i], 2, &cull->params_buffer, cull->params_stride * i, sizeof(vulkan_cull_params));
+        image_binding_write(context, cull->cull_sets[i], 3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, cull->pyramid.view, VK_IMAGE_LAYOUT_GENERAL);
+    }
+
+    // The first level is built from whichever depth texture the last frame drew to.
+    VkDescriptorSetLayout set_layouts[VULKAN_MAX_SWAPCHAIN_IMAGES + VULKAN_MAX_DEPTH_PYRAMID_LEVELS];
+    for (u32 i = 0; i < image_set_count; ++i) {
+        set_layouts[i] = cull->pyramid_set_layout;
+    }
+    if (cull->occlusion_supported) {
+        alloc_info.descriptorSetCount = image_count;
+        alloc_info.pSetLayouts = set_layouts;
+        VK_CHECK(vkAllocateDescriptorSets(device, &alloc_info, cull->depth_sets));
+        for (u32 i = 0; i < image_count; ++i) {
+            vulkan_image* depth_image = (vulkan_image*)context->swapchain.depth_textures[i].internal_data;
+            image_binding_write(context, cull->depth_sets[i], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, depth_image->view, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+            image_binding_write(context, cull->depth_sets[i], 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, cull->level_views[0], VK_IMAGE_LAYOUT_GENERAL);
+        }
+    }
+
+    // Each level after is built from the one before it.
+    if (level_count > 1) {
+        alloc_info.descriptorSetCount = level_count - 1;
+        alloc_info.pSetLayouts = set_layouts;
+        VK_CHECK(vkAllocateDescriptorSets(device, &alloc_info, &cull->level_sets[1]));
+        for (u32 i = 1; i < level_count; ++i) {
+            image_binding_write(context, cull->level_sets[i], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, cull->level_views[i - 1], VK_IMAGE_LAYOUT_GENERAL);
+            image_binding_write(context, cull->level_sets[i], 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, cull->level_views[i], VK_IMAGE_LAYOUT_GENERAL);
+        }
+    }
+
+    cull->pyramid_ready = false;
+    cull->previous_depth_valid = false;
+}
+
+void vulkan_cull_targets_destroy(vulkan_context* context) {
+    vulkan_cull_state* cull = &context->cull;
+
+    // Frames in flight may still be culling with these, so they are deleted once those complete.
+    for (u32 i = 0; i < VULKAN_MAX_DEPTH_PYRAMID_LEVELS; ++i) {
+        if (cull->level_views[i]) {
+            vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_IMAGE_VIEW};
+            deletion.image_view = cull->level_views[i];
+            context->deferred_delete(&deletion);
+            cull->level_views[i] = 0;
+        }
+    }
+    if (cull->pyramid.handle) {
+        vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_IMAGE};
+        deletion.image = cull->pyramid;
+        context->deferred_delete(&deletion);
+        kzero_memory(&cull->pyramid, sizeof(vulkan_image));
+    }
+    if (cull->pyramid_descriptor_pool) {
+        vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_DESCRIPTOR_POOL};
+        deletion.descriptor_pool = cull->pyramid_descriptor_pool;
+        context->deferred_delete(&deletion);
+        cull->pyramid_descriptor_pool = 0;
+    }
+    kzero_memory(cull->cull_sets, sizeof(cull->cull_sets));
+    kzero_memory(cull->depth_sets, sizeof(cull->depth_sets));
+    kzero_memory(cull->level_sets, sizeof(VkDescriptorSet) * VULKAN_MAX_DEPTH_PYRAMID_LEVELS);
+    cull->pyramid_ready = false;
+    cull->previous_depth_valid = false;
+}
+
+// Records the building of the depth pyramid from the depth the last frame drew to.
+static void pyramid_build(vulkan_context* context, VkCommandBuffer command_buffer) {
+    vulkan_cull_state* cull = &context->cull;
+    vulkan_image* depth_image = (vulkan_image*)context->swapchain.depth_textures[cull->previous_depth_index].internal_data;
+
+    // The depth is read once the last frame is done writing it.
+    VkImageMemoryBarrier depth_barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    depth_barrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depth_barrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+    depth_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    depth_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    depth_barrier.image = depth_image->handle;
+    depth_barrier.subresourceRange.aspectMask = vulkan_depth_aspect_get(context->device.depth_format);
+    depth_barrier.subresourceRange.baseMipLevel = 0;
+    depth_barrier.subresourceRange.levelCount = 1;
+    depth_barrier.subresourceRange.baseArrayLayer = 0;
+    depth_barrier.subresourceRange.layerCount = 1;
+    depth_barrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    depth_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(
+        command_buffer,
+        VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 0, 0, 0, 0, 1, &depth_barrier);
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, cull->pyramid_pipeline.handle);
+    VkMemoryBarrier level_barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    level_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    level_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    u32 width = cull->pyramid.width;
+    u32 height = cull->pyramid.height;
+    for (u32 i = 0; i < cull->pyramid.mip_levels; ++i) {
+        VkDescriptorSet set = i == 0 ? cull->depth_sets[cull->previous_depth_index] : cull->level_sets[i];
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, cull->pyramid_pipeline.pipeline_layout, 0, 1, &set, 0, 0);
+        vkCmdDispatch(command_buffer, (width + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE, (height + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE, 1);
+
+        // Each level is read building the next, then by the cull shader.
+        vkCmdPipelineBarrier(
+            command_buffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &level_barrier, 0, 0, 0, 0);
+        width = KMAX((width + 1) / 2, 1);
+        height = KMAX((height + 1) / 2, 1);
+    }
+
+    // The depth goes back to being an attachment, for this frame's passes.
+    depth_barrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+    depth_barrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depth_barrier.srcAccessMask = 0;
+    depth_barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    vkCmdPipelineBarrier(
+        command_buffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        0, 0, 0, 0, 0, 1, &depth_barrier);
+}
+
+void vulkan_cull_record(vulkan_context* context, vulkan_command_buffer* command_buffer) {
+    vulkan_cull_state* cull = &context->cull;
+    if (!cull->enabled) {
+        return;
+    }
+    VkCommandBuffer handle = command_buffer->handle;
+
+    // The draw count and view are written as the frame is recorded.
+    vulkan_cull_params* params = cull_params_get(context);
+    kzero_memory(params, sizeof(vulkan_cull_params));
+    cull->view_set = false;
+
+    // The pyramid is written once the last frame's culling is done reading it. Its first use moves it
+    // to the general layout, which it stays in.
+    VkImageMemoryBarrier pyramid_barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    pyramid_barrier.oldLayout = cull->pyramid_ready ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_UNDEFINED;
+    pyramid_barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    pyramid_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    pyramid_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    pyramid_barrier.image = cull->pyramid.handle;
+    pyramid_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    pyramid_barrier.subresourceRange.baseMipLevel = 0;
+    pyramid_barrier.subresourceRange.levelCount = cull->pyramid.mip_levels;
+    pyramid_barrier.subresourceRange.baseArrayLayer = 0;
+    pyramid_barrier.subresourceRange.layerCount = 1;
+    pyramid_barrier.srcAccessMask = 0;
+    pyramid_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(
+        handle,
+        cull->pyramid_ready ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 0, 0, 0, 0, 1, &pyramid_barrier);
+    cull->pyramid_ready = true;
+
+    // Cull against the last frame's depth, as it was drawn, if there is one.
+    b8 occlusion = cull->occlusion_supported && cull->previous_depth_valid;
+    if (occlusion) {
+        pyramid_build(context, handle);
+    }
+    params->occlusion_enabled = occlusion ? 1 : 0;
+    params->occlusion_projection = cull->previous_projection;
+    params->occlusion_view = cull->previous_view;
+    params->occlusion_scale = cull->previous_scale;
+    params->pyramid_size[0] = (f32)cull->pyramid.width;
+    params->pyramid_size[1] = (f32)cull->pyramid.height;
+    params->pyramid_level_count = cull->pyramid.mip_levels;
+
+    vkCmdBindPipeline(handle, VK_PIPELINE_BIND_POINT_COMPUTE, cull->cull_pipeline.handle);
+    vkCmdBindDescriptorSets(handle, VK_PIPELINE_BIND_POINT_COMPUTE, cull->cull_pipeline.pipeline_layout, 0, 1, &cull->cull_sets[context->current_frame], 0, 0);
+    vkCmdDispatchIndirect(handle, ((vulkan_buffer*)cull->params_buffer.internal_data)->handle, cull->params_stride * context->current_frame);
+
+    // Draws read their commands once culling is done with them.
+    VkMemoryBarrier cull_barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    cull_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    cull_barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(
+        handle,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+        0, 1, &cull_barrier, 0, 0, 0, 0);
+}
+
+void vulkan_cull_view_set(vulkan_context* context, mat4 projection, mat4 view) {
+    vulkan_cull_state* cull = &context->cull;
+    if (!cull->enabled) {
+        return;
+    }
+    vulkan_cull_params* params = cull_params_get(context);
+    params->projection = projection;
+    params->view = view;
+    cull->view_set = true;
+}
+
+void vulkan_cull_frame_end(vulkan_context* context) {
+    vulkan_cull_state* cull = &context->cull;
+    if (!cull->enabled) {
+        return;
+    }
+
+    // Only frames which set a view are culled, and only their depth can be culled against next frame.
+    vulkan_cull_params* params = cull_params_get(context);
+    u32 draw_count = cull->view_set ? context->draw_batch.used : 0;
+    params->draw_count = draw_count;
+    params->dispatch[0] = (draw_count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE;
+    params->dispatch[1] = 1;
+    params->dispatch[2] = 1;
+
+    cull->previous_depth_valid = cull->view_set;
+    cull->previous_depth_index = context->image_index;
+    if (cull->view_set) {
+        cull->previous_projection = params->projection;
+        cull->previous_view = params->view;
+        cull->previous_scale = context->resolution_scale;
+    }
+}
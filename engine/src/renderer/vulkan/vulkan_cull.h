@@ -0,0 +1,79 @@
+/**
+ * @file vulkan_cull.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief This file contains GPU culling of batched draws, against the view frustum and against a
+ * depth pyramid built from the depth of the last frame.
+ * @details Culling is recorded at the start of each frame, before any renderpass, and covers every
+ * draw batched in the frame: its dispatch is indirect, and its count is written once the frame's draws
+ * are known, before the frame is submitted. Draws found hidden keep their place in the indirect buffer
+ * with an instance count of zero, since each run of a material is drawn from its own range of it.
+ * Culling needs batches drawn indirectly; without them it is disabled and every draw is drawn.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "vulkan_types.inl"
+
+/**
+ * @brief Creates the pipelines, sets and buffers used for culling. Must be called once the draw
+ * batch exists. Culling is left disabled if it cannot run.
+ *
+ * @param context A pointer to the Vulkan context.
+ * @returns True if culling is enabled; otherwise false.
+ */
+b8 vulkan_cull_create(vulkan_context* context);
+
+/**
+ * @brief Destroys everything used for culling.
+ *
+ * @param context A pointer to the Vulkan context.
+ */
+void vulkan_cull_destroy(vulkan_context* context);
+
+/**
+ * @brief Creates the depth pyramid for the current swapchain size, and the sets which build it from
+ * each of the swapchain's depth textures.
+ *
+ * @param context A pointer to the Vulkan context.
+ */
+void vulkan_cull_targets_create(vulkan_context* context);
+
+/**
+ * @brief Destroys the depth pyramid and its sets. The device must be idle.
+ *
+ * @param context A pointer to the Vulkan context.
+ */
+void vulkan_cull_targets_destroy(vulkan_context* context);
+
+/**
+ * @brief Records the culling of the current frame into the given command buffer: building the depth
+ * pyramid from the last frame's depth, if there is one, then the cull dispatch. Must be recorded
+ * outside of any renderpass, before the frame's batched draws.
+ *
+ * @param context A pointer to the Vulkan context.
+ * @param command_buffer A pointer to the command buffer to record into.
+ */
+void vulkan_cull_record(vulkan_context* context, vulkan_command_buffer* command_buffer);
+
+/**
+ * @brief Sets the view the batched draws of the current frame are culled against. Draws are only
+ * culled in frames where it is set.
+ *
+ * @param context A pointer to the Vulkan context.
+ * @param projection The projection matrix.
+ * @param view The view matrix.
+ */
+void vulkan_cull_view_set(vulkan_context* context, mat4 projection, mat4 view);
+
+/**
+ * @brief Writes the number of draws to cull this frame, now they are known. Must be called before
+ * the frame is submitted.
+ *
+ * @param context A pointer to the Vulkan context.
+ */
+void vulkan_cull_frame_end(vulkan_context* context);
@@ -1,8 +1,10 @@
 #include "vulkan_device.h"
+#include "vulkan_utils.h"
 #include "core/logger.h"
 #include "core/kstring.h"
 #include "core/kmemory.h"
 #include "containers/darray.h"
+#include "resources/texture_container.h"
 
 typedef struct vulkan_physical_device_requirements {
     b8 graphics;
@@ -78,8 +80,54 @@ b8 vulkan_device_create(vulkan_context* context) {
     // TODO: should be config driven
     VkPhysicalDeviceFeatures device_features = {};
     device_features.samplerAnisotropy = VK_TRUE;  // Request anistrophy
+    // Block-compressed textures, where available.
+    device_features.textureCompressionBC = context->device.features.textureCompressionBC;
+    device_features.textureCompressionASTC_LDR = context->device.features.textureCompressionASTC_LDR;
+    // Drawing many geometries from one indirect buffer, where available.
+    device_features.multiDrawIndirect = context->device.features.multiDrawIndirect;
+    device_features.drawIndirectFirstInstance = context->device.features.drawIndirectFirstInstance;
+
+    // Descriptor indexing, core since Vulkan 1.2, for the bindless texture table, where available.
+    VkPhysicalDeviceDescriptorIndexingFeatures indexing_features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES};
+    context->device.supports_bindless = false;
+    if (context->device.properties.apiVersion >= VK_API_VERSION_1_2) {
+        VkPhysicalDeviceFeatures2 features2 = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
+        features2.pNext = &indexing_features;
+        vkGetPhysicalDeviceFeatures2(context->device.physical_device, &features2);
+        context->device.supports_bindless = indexing_features.runtimeDescriptorArray &&
+                                            indexing_features.descriptorBindingPartiallyBound &&
+                                            indexing_features.descriptorBindingSampledImageUpdateAfterBind &&
+                                            indexing_features.descriptorBindingUpdateUnusedWhilePending;
+    }
+    // Only what the table uses is enabled.
+    VkPhysicalDeviceDescriptorIndexingFeatures enabled_indexing_features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES};
+    if (context->device.supports_bindless) {
+        enabled_indexing_features.runtimeDescriptorArray = VK_TRUE;
+        enabled_indexing_features.descriptorBindingPartiallyBound = VK_TRUE;
+        enabled_indexing_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        enabled_indexing_features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    }
+    KINFO("Bindless textures %s supported.", context->device.supports_bindless ? "are" : "are not");
+
+    // Timeline semaphores, core since Vulkan 1.2, so the progress of each queue is one counter.
+    VkPhysicalDeviceTimelineSemaphoreFeatures timeline_features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES};
+    context->device.supports_timeline_semaphores = false;
+    if (context->device.properties.apiVersion >= VK_API_VERSION_1_2) {
+        VkPhysicalDeviceFeatures2 features2 = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
+        features2.pNext = &timeline_features;
+        vkGetPhysicalDeviceFeatures2(context->device.physical_device, &features2);
+        context->device.supports_timeline_semaphores = timeline_features.timelineSemaphore;
+    }
+    VkPhysicalDeviceTimelineSemaphoreFeatures enabled_timeline_features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES};
+    enabled_timeline_features.timelineSemaphore = VK_TRUE;
+    KINFO("Timeline semaphores %s supported.", context->device.supports_timeline_semaphores ? "are" : "are not");
 
     b8 portability_required = false;
+    b8 dynamic_rendering_available = false;
+    b8 present_id_available = false;
+    b8 present_wait_available = false;
+    b8 memory_budget_available = false;
+    context->device.mesh_shader_available = false;
     u32 available_extension_count = 0;
     VkExtensionProperties* available_extensions = 0;
     VK_CHECK(vkEnumerateDeviceExtensionProperties(context->device.physical_device, 0, &available_extension_count, 0));
@@ -90,22 +138,96 @@ b8 vulkan_device_create(vulkan_context* context) {
             if (strings_equal(available_extensions[i].extensionName, "VK_KHR_portability_subset")) {
                 KINFO("Adding required extension 'VK_KHR_portability_subset'.");
                 portability_required = true;
-                break;
+            } else if (strings_equal(available_extensions[i].extensionName, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)) {
+                dynamic_rendering_available = true;
+            } else if (strings_equal(available_extensions[i].extensionName, VK_KHR_PRESENT_ID_EXTENSION_NAME)) {
+                present_id_available = true;
+            } else if (strings_equal(available_extensions[i].extensionName, VK_KHR_PRESENT_WAIT_EXTENSION_NAME)) {
+                present_wait_available = true;
+            } else if (strings_equal(available_extensions[i].extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)) {
+                memory_budget_available = true;
+            } else if (strings_equal(available_extensions[i].extensionName, "VK_EXT_mesh_shader")) {
+                context->device.mesh_shader_available = true;
             }
         }
     }
     kfree(available_extensions, sizeof(VkExtensionProperties) * available_extension_count, MEMORY_TAG_RENDERER);
 
-    u32 extension_count = portability_required ? 2 : 1;
-    const char** extension_names = portability_required
-                                       ? (const char* [2]){VK_KHR_SWAPCHAIN_EXTENSION_NAME, "VK_KHR_portability_subset"}
-                                       : (const char* [1]){VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    // Dynamic rendering, where available, so renderpasses need no render pass or framebuffer objects.
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamic_rendering_features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR};
+    context->device.supports_dynamic_rendering = false;
+    if (dynamic_rendering_available && context->device.properties.apiVersion >= VK_API_VERSION_1_2) {
+        VkPhysicalDeviceFeatures2 features2 = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
+        features2.pNext = &dynamic_rendering_features;
+        vkGetPhysicalDeviceFeatures2(context->device.physical_device, &features2);
+        context->device.supports_dynamic_rendering = dynamic_rendering_features.dynamicRendering;
+    }
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR enabled_dynamic_rendering_features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR};
+    enabled_dynamic_rendering_features.dynamicRendering = VK_TRUE;
+
+    // Present wait, where available, so the CPU can wait for a frame to reach the display.
+    VkPhysicalDevicePresentIdFeaturesKHR present_id_features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR};
+    VkPhysicalDevicePresentWaitFeaturesKHR present_wait_features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR};
+    context->device.supports_present_wait = false;
+    if (present_id_available && present_wait_available) {
+        VkPhysicalDeviceFeatures2 features2 = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
+        features2.pNext = &present_id_features;
+        present_id_features.pNext = &present_wait_features;
+        vkGetPhysicalDeviceFeatures2(context->device.physical_device, &features2);
+        context->device.supports_present_wait = present_id_features.presentId && present_wait_features.presentWait;
+    }
+    VkPhysicalDevicePresentIdFeaturesKHR enabled_present_id_features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR};
+    enabled_present_id_features.presentId = VK_TRUE;
+    VkPhysicalDevicePresentWaitFeaturesKHR enabled_present_wait_features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR};
+    enabled_present_wait_features.presentWait = VK_TRUE;
+
+    // Memory budgets, where available, so the backend knows how close each heap is to full. Queried
+    // through vkGetPhysicalDeviceMemoryProperties2, so Vulkan 1.1 is needed as well.
+    context->device.supports_memory_budget = memory_budget_available && context->device.properties.apiVersion >= VK_API_VERSION_1_1;
+
+    u32 extension_count = 0;
+    const char* extension_names[6];
+    extension_names[extension_count++] = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+    if (portability_required) {
+        extension_names[extension_count++] = "VK_KHR_portability_subset";
+    }
+    if (context->device.supports_dynamic_rendering) {
+        extension_names[extension_count++] = VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME;
+    }
+    if (context->device.supports_present_wait) {
+        extension_names[extension_count++] = VK_KHR_PRESENT_ID_EXTENSION_NAME;
+        extension_names[extension_count++] = VK_KHR_PRESENT_WAIT_EXTENSION_NAME;
+    }
+    if (context->device.supports_memory_budget) {
+        extension_names[extension_count++] = VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+    }
+
+    // Chain the optional features which are enabled.
+    void* enabled_features_chain = 0;
+    if (context->device.supports_dynamic_rendering) {
+        enabled_dynamic_rendering_features.pNext = enabled_features_chain;
+        enabled_features_chain = &enabled_dynamic_rendering_features;
+    }
+    if (context->device.supports_present_wait) {
+        enabled_present_wait_features.pNext = enabled_features_chain;
+        enabled_present_id_features.pNext = &enabled_present_wait_features;
+        enabled_features_chain = &enabled_present_id_features;
+    }
+    if (context->device.supports_bindless) {
+        enabled_indexing_features.pNext = enabled_features_chain;
+        enabled_features_chain = &enabled_indexing_features;
+    }
+    if (context->device.supports_timeline_semaphores) {
+        enabled_timeline_features.pNext = enabled_features_chain;
+        enabled_features_chain = &enabled_timeline_features;
+    }
     VkDeviceCreateInfo device_create_info = {VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
     device_create_info.queueCreateInfoCount = index_count;
     device_create_info.pQueueCreateInfos = queue_create_infos;
     device_create_info.pEnabledFeatures = &device_features;
     device_create_info.enabledExtensionCount = extension_count;
     device_create_info.ppEnabledExtensionNames = extension_names;
+    device_create_info.pNext = enabled_features_chain;
 
     // Deprecated and ignored, so pass nothing.
     device_create_info.enabledLayerCount = 0;
@@ -120,6 +242,31 @@ b8 vulkan_device_create(vulkan_context* context) {
 
     KINFO("Logical device created.");
 
+    if (context->device.supports_dynamic_rendering) {
+        context->device.cmd_begin_rendering = (PFN_vkCmdBeginRenderingKHR)vkGetDeviceProcAddr(context->device.logical_device, "vkCmdBeginRenderingKHR");
+        context->device.cmd_end_rendering = (PFN_vkCmdEndRenderingKHR)vkGetDeviceProcAddr(context->device.logical_device, "vkCmdEndRenderingKHR");
+        context->device.supports_dynamic_rendering = context->device.cmd_begin_rendering && context->device.cmd_end_rendering;
+    }
+    KINFO("Dynamic rendering %s supported.", context->device.supports_dynamic_rendering ? "is" : "is not");
+
+    if (context->device.supports_present_wait) {
+        context->device.wait_for_present = (PFN_vkWaitForPresentKHR)vkGetDeviceProcAddr(context->device.logical_device, "vkWaitForPresentKHR");
+        context->device.supports_present_wait = context->device.wait_for_present != 0;
+    }
+    KINFO("Present wait %s supported.", context->device.supports_present_wait ? "is" : "is not");
+    KINFO("Memory budgets %s supported.", context->device.supports_memory_budget ? "are" : "are not, so they are estimated from heap sizes");
+    KINFO("Mesh shaders %s available. Meshlets are culled in compute and drawn indirectly.", context->device.mesh_shader_available ? "are" : "are not");
+
+    // Work out which compressed texture formats can be sampled, for loaders to pick from.
+    context->device.texture_format_support[TEXTURE_FORMAT_UNCOMPRESSED] = true;
+    for (u32 i = TEXTURE_FORMAT_UNCOMPRESSED + 1; i < TEXTURE_FORMAT_COUNT; ++i) {
+        b8 feature = i == TEXTURE_FORMAT_ASTC_4X4 ? device_features.textureCompressionASTC_LDR : device_features.textureCompressionBC;
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(context->device.physical_device, vulkan_texture_format_to_vk(i, 4), &properties);
+        context->device.texture_format_support[i] = feature && (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+        KINFO("%s textures %s supported.", texture_format_name(i), context->device.texture_format_support[i] ? "are" : "are not");
+    }
+
     // Get queues.
     vkGetDeviceQueue(
         context->device.logical_device,
@@ -151,6 +298,15 @@ b8 vulkan_device_create(vulkan_context* context) {
         &context->device.graphics_command_pool));
     KINFO("Graphics command pool created.");
 
+    // And one for the transfer queue, which may be the same family.
+    pool_create_info.queueFamilyIndex = context->device.transfer_queue_index;
+    VK_CHECK(vkCreateCommandPool(
+        context->device.logical_device,
+        &pool_create_info,
+        context->allocator,
+        &context->device.transfer_command_pool));
+    KINFO("Transfer command pool created.");
+
     return true;
 }
 
@@ -165,6 +321,10 @@ void vulkan_device_destroy(vulkan_context* context) {
         context->device.logical_device,
         context->device.graphics_command_pool,
         context->allocator);
+    vkDestroyCommandPool(
+        context->device.logical_device,
+        context->device.transfer_command_pool,
+        context->allocator);
 
     // Destroy logical device
     KINFO("Destroying logical device...");
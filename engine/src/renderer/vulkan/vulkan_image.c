@@ -1,6 +1,7 @@
 #include "vulkan_image.h"
 
 #include "vulkan_device.h"
+#include "vulkan_memory.h"
 
 #include "core/kmemory.h"
 #include "core/logger.h"
@@ -10,6 +11,7 @@ void vulkan_image_create(
     texture_type type,
     u32 width,
     u32 height,
+    u32 mip_levels,
     VkFormat format,
     VkImageTiling tiling,
     VkImageUsageFlags usage,
@@ -20,6 +22,7 @@ void vulkan_image_create(
     // Copy params
     out_image->width = width;
     out_image->height = height;
+    out_image->mip_levels = KMAX(mip_levels, 1);
     out_image->memory_flags = memory_flags;
 
     // Creation info.
@@ -35,7 +38,7 @@ void vulkan_image_create(
     image_create_info.extent.width = width;
     image_create_info.extent.height = height;
     image_create_info.extent.depth = 1;                                 // TODO: Support configurable depth.
-    image_create_info.mipLevels = 4;                                    // TODO: Support mip mapping
+    image_create_info.mipLevels = out_image->mip_levels;
     image_create_info.arrayLayers = type == TEXTURE_TYPE_CUBE ? 6 : 1;  // TODO: Support number of layers in the image.
     image_create_info.format = format;
     image_create_info.tiling = tiling;
@@ -49,22 +52,15 @@ void vulkan_image_create(
 
     VK_CHECK(vkCreateImage(context->device.logical_device, &image_create_info, context->allocator, &out_image->handle));
 
-    // Query memory requirements.
-    vkGetImageMemoryRequirements(context->device.logical_device, out_image->handle, &out_image->memory_requirements);
-
-    i32 memory_type = context->find_memory_index(out_image->memory_requirements.memoryTypeBits, memory_flags);
-    if (memory_type == -1) {
-        KERROR("Required memory type not found. Image not valid.");
+    // Allocate memory, from a block shared with other images unless it is large.
+    if (!vulkan_memory_allocate_image(context, out_image->handle, tiling, memory_flags, &out_image->memory_requirements, &out_image->allocation)) {
+        KERROR("Failed to allocate memory for image. Image not valid.");
+        kzero_memory(&out_image->memory_requirements, sizeof(VkMemoryRequirements));
+        return;
     }
 
-    // Allocate memory
-    VkMemoryAllocateInfo memory_allocate_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
-    memory_allocate_info.allocationSize = out_image->memory_requirements.size;
-    memory_allocate_info.memoryTypeIndex = memory_type;
-    VK_CHECK(vkAllocateMemory(context->device.logical_device, &memory_allocate_info, context->allocator, &out_image->memory));
-
     // Bind the memory
-    VK_CHECK(vkBindImageMemory(context->device.logical_device, out_image->handle, out_image->memory, 0));  // TODO: configurable memory offset.
+    VK_CHECK(vkBindImageMemory(context->device.logical_device, out_image->handle, out_image->allocation.memory, out_image->allocation.offset));
 
     // Report the memory as in-use.
     b8 is_device_memory = (out_image->memory_flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) == VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
@@ -97,9 +93,17 @@ void vulkan_image_view_create(
     view_create_info.format = format;
     view_create_info.subresourceRange.aspectMask = aspect_flags;
 
+    // Single-channel images, such as font atlases, read as that channel in every component.
+    if (format == VK_FORMAT_R8_UNORM) {
+        view_create_info.components.r = VK_COMPONENT_SWIZZLE_R;
+        view_create_info.components.g = VK_COMPONENT_SWIZZLE_R;
+        view_create_info.components.b = VK_COMPONENT_SWIZZLE_R;
+        view_create_info.components.a = VK_COMPONENT_SWIZZLE_R;
+    }
+
     // TODO: Make configurable
     view_create_info.subresourceRange.baseMipLevel = 0;
-    view_create_info.subresourceRange.levelCount = 1;
+    view_create_info.subresourceRange.levelCount = KMAX(image->mip_levels, 1);
     view_create_info.subresourceRange.baseArrayLayer = 0;
     view_create_info.subresourceRange.layerCount = type == TEXTURE_TYPE_CUBE ? 6 : 1;
 
@@ -122,7 +126,7 @@ void vulkan_image_transition_layout(
     barrier.image = image->handle;
     barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.levelCount = KMAX(image->mip_levels, 1);
     barrier.subresourceRange.baseArrayLayer = 0;
     barrier.subresourceRange.layerCount = type == TEXTURE_TYPE_CUBE ? 6 : 1;
 
@@ -149,6 +153,16 @@ void vulkan_image_transition_layout(
 
         // The fragment stage.
         dest_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    } else if (old_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && new_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+        // Transitioning from a shader-readonly layout to a transfer destination layout, keeping the contents.
+        barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        // Once the fragment stage is done reading...
+        source_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+        // Used for copying
+        dest_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
     } else if (old_layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL && new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
         // Transitioning from a transfer source layout to a shader-readonly layout.
         barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
@@ -168,6 +182,13 @@ void vulkan_image_transition_layout(
 
         // Used for copying
         dest_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    } else if (old_layout == VK_IMAGE_LAYOUT_UNDEFINED && new_layout == VK_IMAGE_LAYOUT_GENERAL) {
+        // Storage images stay in the general layout, to be written and sampled by shaders.
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        source_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        dest_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
     } else {
         KFATAL("unsupported layout transition!");
         return;
@@ -182,26 +203,104 @@ void vulkan_image_transition_layout(
         1, &barrier);
 }
 
+void vulkan_image_ownership_transfer(
+    vulkan_context* context,
+    texture_type type,
+    vulkan_command_buffer* command_buffer,
+    vulkan_image* image,
+    u32 source_family,
+    u32 dest_family,
+    b8 release) {
+    VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = source_family;
+    barrier.dstQueueFamilyIndex = dest_family;
+    barrier.image = image->handle;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = KMAX(image->mip_levels, 1);
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = type == TEXTURE_TYPE_CUBE ? 6 : 1;
+
+    // The release makes the copies available, and the acquire makes them visible to what follows.
+    // Access masks of the other side are ignored.
+    VkPipelineStageFlags source_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    VkPipelineStageFlags dest_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    if (release) {
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        dest_stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    } else {
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    }
+
+    vkCmdPipelineBarrier(
+        command_buffer->handle,
+        source_stage, dest_stage,
+        0,
+        0, 0,
+        0, 0,
+        1, &barrier);
+}
+
 void vulkan_image_copy_from_buffer(
     vulkan_context* context,
     texture_type type,
     vulkan_image* image,
     VkBuffer buffer,
+    u64 offset,
+    u32 mip_level,
     vulkan_command_buffer* command_buffer) {
     // Region to copy
     VkBufferImageCopy region;
     kzero_memory(&region, sizeof(VkBufferImageCopy));
-    region.bufferOffset = 0;
+    region.bufferOffset = offset;
     region.bufferRowLength = 0;
     region.bufferImageHeight = 0;
 
     region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.mipLevel = mip_level;
     region.imageSubresource.baseArrayLayer = 0;
     region.imageSubresource.layerCount = type == TEXTURE_TYPE_CUBE ? 6 : 1;
 
-    region.imageExtent.width = image->width;
-    region.imageExtent.height = image->height;
+    region.imageExtent.width = KMAX(image->width >> mip_level, 1);
+    region.imageExtent.height = KMAX(image->height >> mip_level, 1);
+    region.imageExtent.depth = 1;
+
+    vkCmdCopyBufferToImage(
+        command_buffer->handle,
+        buffer,
+        image->handle,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        1,
+        &region);
+}
+
+void vulkan_image_copy_region_from_buffer(
+    vulkan_context* context,
+    vulkan_image* image,
+    VkBuffer buffer,
+    u64 offset,
+    u32 x,
+    u32 y,
+    u32 width,
+    u32 height,
+    vulkan_command_buffer* command_buffer) {
+    VkBufferImageCopy region;
+    kzero_memory(&region, sizeof(VkBufferImageCopy));
+    region.bufferOffset = offset;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+
+    region.imageOffset.x = (i32)x;
+    region.imageOffset.y = (i32)y;
+    region.imageExtent.width = width;
+    region.imageExtent.height = height;
     region.imageExtent.depth = 1;
 
     vkCmdCopyBufferToImage(
@@ -213,6 +312,70 @@ void vulkan_image_copy_from_buffer(
         &region);
 }
 
+void vulkan_image_mipmaps_generate(
+    vulkan_context* context,
+    texture_type type,
+    vulkan_image* image,
+    vulkan_command_buffer* command_buffer) {
+    u32 layer_count = type == TEXTURE_TYPE_CUBE ? 6 : 1;
+    VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    barrier.srcQueueFamilyIndex = context->device.graphics_queue_index;
+    barrier.dstQueueFamilyIndex = context->device.graphics_queue_index;
+    barrier.image = image->handle;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = layer_count;
+
+    i32 width = (i32)image->width;
+    i32 height = (i32)image->height;
+    for (u32 i = 1; i < image->mip_levels; ++i) {
+        // The level before, just written, becomes the source of this one.
+        barrier.subresourceRange.baseMipLevel = i - 1;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(command_buffer->handle, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, 0, 0, 0, 1, &barrier);
+
+        i32 next_width = width > 1 ? width / 2 : 1;
+        i32 next_height = height > 1 ? height / 2 : 1;
+        VkImageBlit blit = {};
+        blit.srcOffsets[1] = (VkOffset3D){width, height, 1};
+        blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.srcSubresource.mipLevel = i - 1;
+        blit.srcSubresource.layerCount = layer_count;
+        blit.dstOffsets[1] = (VkOffset3D){next_width, next_height, 1};
+        blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.dstSubresource.mipLevel = i;
+        blit.dstSubresource.layerCount = layer_count;
+        vkCmdBlitImage(
+            command_buffer->handle,
+            image->handle, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            image->handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1, &blit,
+            VK_FILTER_LINEAR);
+
+        // The level before is finished with.
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(command_buffer->handle, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, 0, 0, 0, 1, &barrier);
+
+        width = next_width;
+        height = next_height;
+    }
+
+    // The last level was only ever written.
+    barrier.subresourceRange.baseMipLevel = image->mip_levels - 1;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer->handle, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, 0, 0, 0, 1, &barrier);
+}
+
 void vulkan_image_copy_to_buffer(
     vulkan_context* context,
     texture_type type,
@@ -247,11 +410,12 @@ void vulkan_image_copy_pixel_to_buffer(
     texture_type type,
     vulkan_image* image,
     VkBuffer buffer,
+    u64 buffer_offset,
     u32 x,
     u32 y,
     vulkan_command_buffer* command_buffer) {
     VkBufferImageCopy region = {};
-    region.bufferOffset = 0;
+    region.bufferOffset = buffer_offset;
     region.bufferRowLength = 0;
     region.bufferImageHeight = 0;
 
@@ -280,14 +444,11 @@ void vulkan_image_destroy(vulkan_context* context, vulkan_image* image) {
         vkDestroyImageView(context->device.logical_device, image->view, context->allocator);
         image->view = 0;
     }
-    if (image->memory) {
-        vkFreeMemory(context->device.logical_device, image->memory, context->allocator);
-        image->memory = 0;
-    }
     if (image->handle) {
         vkDestroyImage(context->device.logical_device, image->handle, context->allocator);
         image->handle = 0;
     }
+    vulkan_memory_free(context, &image->allocation);
 
     // Report the memory as no longer in-use.
     b8 is_device_memory = (image->memory_flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) == VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
@@ -20,6 +20,7 @@
  * @param type The type of texture. Provides hints to creation.
  * @param width The width of the image. For cubemaps, this is for each side of the cube.
  * @param height The height of the image. For cubemaps, this is for each side of the cube.
+ * @param mip_levels The number of mip levels, at least 1.
  * @param format The format of the image.
  * @param tiling The image tiling mode.
  * @param usage The image usage.
@@ -33,6 +34,7 @@ void vulkan_image_create(
     texture_type type,
     u32 width,
     u32 height,
+    u32 mip_levels,
     VkFormat format,
     VkImageTiling tiling,
     VkImageUsageFlags usage,
@@ -58,7 +60,7 @@ void vulkan_image_view_create(
     VkImageAspectFlags aspect_flags);
 
 /**
- * @brief Transitions the provided image from old_layout to new_layout.
+ * @brief Transitions every mip level of the provided image from old_layout to new_layout.
  * 
  * @param context A pointer to the Vulkan context.
  * @param type The type of texture. Provides hints to creation.
@@ -78,17 +80,85 @@ void vulkan_image_transition_layout(
     VkImageLayout new_layout);
 
 /**
- * @brief Copies data in buffer to provided image.
+ * @brief Records one half of moving every mip level of the provided image, in the transfer
+ * destination layout, from one queue family to another. The same barrier must be recorded on a
+ * queue of each family: the release after the copies on the source, and the acquire before anything
+ * else on the destination, once the release is known to have executed.
+ *
+ * @param context A pointer to the Vulkan context.
+ * @param type The type of texture. Provides hints to creation.
+ * @param command_buffer A pointer to the command buffer to be used.
+ * @param image A pointer to the image being moved.
+ * @param source_family The index of the queue family releasing the image.
+ * @param dest_family The index of the queue family acquiring the image.
+ * @param release True to record the release, on the source family; false for the acquire.
+ */
+void vulkan_image_ownership_transfer(
+    vulkan_context* context,
+    texture_type type,
+    vulkan_command_buffer* command_buffer,
+    vulkan_image* image,
+    u32 source_family,
+    u32 dest_family,
+    b8 release);
+
+/**
+ * @brief Copies data in buffer to one mip level of the provided image.
  * @param context The Vulkan context.
  * @param type The type of texture. Provides hints to creation.
  * @param image The image to copy the buffer's data to.
  * @param buffer The buffer whose data will be copied.
+ * @param offset The offset in the buffer of the level's data. For cubemaps, each side follows the one before.
+ * @param mip_level The mip level to copy to.
+ * @param command_buffer The command buffer to be used for the copy.
  */
 void vulkan_image_copy_from_buffer(
     vulkan_context* context,
     texture_type type,
     vulkan_image* image,
     VkBuffer buffer,
+    u64 offset,
+    u32 mip_level,
+    vulkan_command_buffer* command_buffer);
+
+/**
+ * @brief Copies data in the provided buffer to a rectangle of the first mip level of the given
+ * 2D image, which is expected to be in the transfer destination layout.
+ * @param context The Vulkan context.
+ * @param image The image to copy the buffer's data to.
+ * @param buffer The buffer whose data will be copied, the rectangle's rows with no gaps between them.
+ * @param offset The offset in bytes from the beginning of the buffer.
+ * @param x The first column of the rectangle.
+ * @param y The first row of the rectangle.
+ * @param width The width of the rectangle in pixels.
+ * @param height The height of the rectangle in pixels.
+ * @param command_buffer The command buffer to be used for the copy.
+ */
+void vulkan_image_copy_region_from_buffer(
+    vulkan_context* context,
+    vulkan_image* image,
+    VkBuffer buffer,
+    u64 offset,
+    u32 x,
+    u32 y,
+    u32 width,
+    u32 height,
+    vulkan_command_buffer* command_buffer);
+
+/**
+ * @brief Generates every mip level of the provided image after the first by blitting each
+ * from the one before. The whole image is expected to be in the transfer destination layout,
+ * with the first level written, and is left in the shader read-only layout.
+ *
+ * @param context The Vulkan context.
+ * @param type The type of texture. Provides hints to layer count.
+ * @param image The image to generate the mip levels of.
+ * @param command_buffer The command buffer to be used for the blits.
+ */
+void vulkan_image_mipmaps_generate(
+    vulkan_context* context,
+    texture_type type,
+    vulkan_image* image,
     vulkan_command_buffer* command_buffer);
 
 /**
@@ -114,6 +184,7 @@ void vulkan_image_copy_to_buffer(
  * @param type The type of texture. Provides hints to layer count.
  * @param image The image to copy the image's data from.
  * @param buffer The buffer to copy to.
+ * @param buffer_offset The offset in bytes into the buffer to copy to.
  * @param x The x-coordinate of the pixel to copy.
  * @param y The y-coordinate of the pixel to copy.
  * @param command_buffer The command buffer to be used for the copy.
@@ -123,6 +194,7 @@ void vulkan_image_copy_pixel_to_buffer(
     texture_type type,
     vulkan_image* image,
     VkBuffer buffer,
+    u64 buffer_offset,
     u32 x,
     u32 y,
     vulkan_command_buffer* command_buffer);
@@ -0,0 +1,449 @@
+#include "vulkan_memory.h"
+
+#include "vulkan_utils.h"
+
+#include "containers/darray.h"
+#include "core/counters.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+
+/**
+ * @brief The unit block freelists track space in. Block offsets are always aligned to it, which
+ * covers the alignment of most buffers and the largest nonCoherentAtomSize allowed. It also keeps
+ * the freelists small, since they size themselves by the units they track.
+ */
+#define VULKAN_MEMORY_GRANULE 256
+/** @brief The size of the blocks of memory types in heaps larger than VULKAN_MEMORY_SMALL_HEAP_SIZE. */
+#define VULKAN_MEMORY_BLOCK_SIZE MEBIBYTES(64)
+/** @brief Heaps up to this size, such as the host-visible window of device memory, get blocks of an eighth of their size. */
+#define VULKAN_MEMORY_SMALL_HEAP_SIZE GIBIBYTES(1)
+/** @brief The largest size of transient blocks. */
+#define VULKAN_MEMORY_TRANSIENT_BLOCK_SIZE MEBIBYTES(16)
+/** @brief Without VK_EXT_memory_budget, the fraction of each heap taken as its budget, leaving the rest to other processes. */
+#define VULKAN_MEMORY_ESTIMATED_BUDGET 0.8f
+/** @brief The fractions of its budget a device-local heap must use for the pressure to become moderate and critical. */
+#define VULKAN_MEMORY_PRESSURE_MODERATE 0.85f
+#define VULKAN_MEMORY_PRESSURE_CRITICAL 0.95f
+/** @brief How far use must fall back under a threshold for the pressure to ease, so it does not flicker around one. */
+#define VULKAN_MEMORY_PRESSURE_HYSTERESIS 0.05f
+
+static u64 pool_block_size(const vulkan_memory_allocator* allocator, u32 memory_type, vulkan_memory_pool_kind kind) {
+    u64 size = allocator->block_sizes[memory_type];
+    return kind == VULKAN_MEMORY_POOL_KIND_TRANSIENT ? KMIN(size, VULKAN_MEMORY_TRANSIENT_BLOCK_SIZE) : size;
+}
+
+static vulkan_memory_heap_usage* heap_usage(vulkan_context* context, u32 memory_type) {
+    return &context->memory_allocator.heaps[context->device.memory.memoryTypes[memory_type].heapIndex];
+}
+
+static void heap_usage_report(vulkan_memory_heap_usage* heap) {
+    counter_set(heap->allocated_counter, (i64)heap->allocated_size);
+    counter_set(heap->used_counter, (i64)heap->used_size);
+}
+
+static b8 device_memory_allocate(vulkan_context* context, u32 memory_type, u64 size, VkImage dedicated_image, VkBuffer dedicated_buffer, VkDeviceMemory* out_memory, void** out_mapped) {
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+    if (allocator->device_allocation_count >= context->device.properties.limits.maxMemoryAllocationCount) {
+        KERROR("Unable to allocate device memory: the device allows no more than %u allocations.", context->device.properties.limits.maxMemoryAllocationCount);
+        return false;
+    }
+
+    VkMemoryAllocateInfo allocate_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocate_info.allocationSize = size;
+    allocate_info.memoryTypeIndex = memory_type;
+
+    VkMemoryDedicatedAllocateInfo dedicated_info = {VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO};
+    if (dedicated_image || dedicated_buffer) {
+        dedicated_info.image = dedicated_image;
+        dedicated_info.buffer = dedicated_buffer;
+        allocate_info.pNext = &dedicated_info;
+    }
+
+    VkResult result = vkAllocateMemory(context->device.logical_device, &allocate_info, context->allocator, out_memory);
+    if (result != VK_SUCCESS) {
+        KERROR("Unable to allocate %llu bytes of device memory: %s", size, vulkan_result_string(result, true));
+        return false;
+    }
+
+    *out_mapped = 0;
+    if (context->device.memory.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        result = vkMapMemory(context->device.logical_device, *out_memory, 0, VK_WHOLE_SIZE, 0, out_mapped);
+        if (result != VK_SUCCESS) {
+            KERROR("Unable to map host-visible device memory: %s", vulkan_result_string(result, true));
+            vkFreeMemory(context->device.logical_device, *out_memory, context->allocator);
+            *out_memory = 0;
+            return false;
+        }
+    }
+
+    allocator->device_allocation_count++;
+    counter_set(allocator->device_allocations_counter, allocator->device_allocation_count);
+    vulkan_memory_heap_usage* heap = heap_usage(context, memory_type);
+    heap->allocated_size += size;
+    heap->allocation_count++;
+    heap_usage_report(heap);
+    return true;
+}
+
+static void device_memory_free(vulkan_context* context, u32 memory_type, u64 size, VkDeviceMemory memory, void* mapped) {
+    if (mapped) {
+        vkUnmapMemory(context->device.logical_device, memory);
+    }
+    vkFreeMemory(context->device.logical_device, memory, context->allocator);
+
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+    allocator->device_allocation_count--;
+    counter_set(allocator->device_allocations_counter, allocator->device_allocation_count);
+    vulkan_memory_heap_usage* heap = heap_usage(context, memory_type);
+    heap->allocated_size -= size;
+    heap->allocation_count--;
+    heap_usage_report(heap);
+}
+
+static vulkan_memory_block* block_create(vulkan_context* context, u32 memory_type, vulkan_memory_pool_kind kind) {
+    u64 size = pool_block_size(&context->memory_allocator, memory_type, kind);
+    VkDeviceMemory memory;
+    void* mapped;
+    if (!device_memory_allocate(context, memory_type, size, 0, 0, &memory, &mapped)) {
+        return 0;
+    }
+
+    vulkan_memory_block* block = kallocate(sizeof(vulkan_memory_block), MEMORY_TAG_VULKAN);
+    block->memory = memory;
+    block->size = size;
+    block->memory_type = memory_type;
+    block->kind = kind;
+    block->mapped = mapped;
+    if (kind != VULKAN_MEMORY_POOL_KIND_TRANSIENT) {
+        u64 granule_count = size / VULKAN_MEMORY_GRANULE;
+        freelist_create_with_mode(granule_count, FREELIST_MODE_SEGREGATED_FIT, &block->freelist_memory_requirement, 0, 0);
+        block->freelist_memory = kallocate(block->freelist_memory_requirement, MEMORY_TAG_VULKAN);
+        freelist_create_with_mode(granule_count, FREELIST_MODE_SEGREGATED_FIT, &block->freelist_memory_requirement, block->freelist_memory, &block->granules);
+    }
+
+    darray_push(context->memory_allocator.blocks[memory_type][kind], block);
+    return block;
+}
+
+static void block_destroy(vulkan_context* context, vulkan_memory_block* block) {
+    if (block->freelist_memory) {
+        freelist_destroy(&block->granules);
+        kfree(block->freelist_memory, block->freelist_memory_requirement, MEMORY_TAG_VULKAN);
+    }
+    device_memory_free(context, block->memory_type, block->size, block->memory, block->mapped);
+    kfree(block, sizeof(vulkan_memory_block), MEMORY_TAG_VULKAN);
+}
+
+static b8 block_suballocate(vulkan_memory_block* block, u64 size, u64 alignment, vulkan_memory_allocation* out_allocation) {
+    alignment = KMAX(alignment, VULKAN_MEMORY_GRANULE);
+    u64 offset;
+    if (block->kind == VULKAN_MEMORY_POOL_KIND_TRANSIENT) {
+        offset = get_aligned(block->linear_offset, alignment);
+        if (offset + size > block->size) {
+            return false;
+        }
+        out_allocation->reserved_offset = block->linear_offset;
+        out_allocation->reserved_size = offset + size - block->linear_offset;
+        block->linear_offset = offset + size;
+    } else {
+        // Reserve enough granules that an aligned range of the size fits in them wherever they start.
+        u64 granule_count = (size + (alignment - VULKAN_MEMORY_GRANULE) + VULKAN_MEMORY_GRANULE - 1) / VULKAN_MEMORY_GRANULE;
+        u64 first_granule;
+        if (!freelist_allocate_block(&block->granules, granule_count, &first_granule)) {
+            return false;
+        }
+        out_allocation->reserved_offset = first_granule * VULKAN_MEMORY_GRANULE;
+        out_allocation->reserved_size = granule_count * VULKAN_MEMORY_GRANULE;
+        offset = get_aligned(out_allocation->reserved_offset, alignment);
+    }
+
+    out_allocation->memory = block->memory;
+    out_allocation->offset = offset;
+    out_allocation->size = size;
+    out_allocation->mapped = block->mapped ? (u8*)block->mapped + offset : 0;
+    out_allocation->memory_type = block->memory_type;
+    out_allocation->block = block;
+    block->allocation_count++;
+    return true;
+}
+
+static b8 allocate(
+    vulkan_context* context,
+    const VkMemoryRequirements* requirements,
+    VkMemoryPropertyFlags property_flags,
+    vulkan_memory_pool_kind kind,
+    b8 prefers_dedicated,
+    VkImage image,
+    VkBuffer buffer,
+    vulkan_memory_allocation* out_allocation) {
+    kzero_memory(out_allocation, sizeof(vulkan_memory_allocation));
+    i32 memory_type = context->find_memory_index(requirements->memoryTypeBits, property_flags);
+    if (memory_type == -1) {
+        KERROR("Unable to allocate device memory because the required memory type was not found.");
+        return false;
+    }
+
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+    kmutex_lock(&allocator->lock);
+
+    b8 allocated = false;
+    u64 block_size = pool_block_size(allocator, (u32)memory_type, kind);
+    if (!prefers_dedicated && requirements->size <= block_size / 2) {
+        vulkan_memory_block** blocks = allocator->blocks[memory_type][kind];
+        u32 block_count = darray_length(blocks);
+        for (u32 i = 0; i < block_count && !allocated; ++i) {
+            allocated = block_suballocate(blocks[i], requirements->size, requirements->alignment, out_allocation);
+        }
+        if (!allocated) {
+            vulkan_memory_block* block = block_create(context, (u32)memory_type, kind);
+            allocated = block && block_suballocate(block, requirements->size, requirements->alignment, out_allocation);
+        }
+    }
+
+    // Dedicated memory, for resources that should not share, or if no block could be made.
+    if (!allocated) {
+        void* mapped;
+        VkDeviceMemory memory;
+        if (device_memory_allocate(context, (u32)memory_type, requirements->size, prefers_dedicated ? image : 0, prefers_dedicated ? buffer : 0, &memory, &mapped)) {
+            out_allocation->memory = memory;
+            out_allocation->size = requirements->size;
+            out_allocation->mapped = mapped;
+            out_allocation->memory_type = (u32)memory_type;
+            allocated = true;
+        }
+    }
+
+    if (allocated) {
+        vulkan_memory_heap_usage* heap = heap_usage(context, (u32)memory_type);
+        heap->used_size += out_allocation->size;
+        heap_usage_report(heap);
+    }
+
+    kmutex_unlock(&allocator->lock);
+    return allocated;
+}
+
+b8 vulkan_memory_allocator_create(vulkan_context* context) {
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+    kzero_memory(allocator, sizeof(vulkan_memory_allocator));
+    if (!kmutex_create(&allocator->lock)) {
+        KERROR("Failed to create the device memory allocator's mutex.");
+        return false;
+    }
+
+    const VkPhysicalDeviceMemoryProperties* properties = &context->device.memory;
+    for (u32 i = 0; i < properties->memoryTypeCount; ++i) {
+        u64 heap_size = properties->memoryHeaps[properties->memoryTypes[i].heapIndex].size;
+        u64 block_size = heap_size <= VULKAN_MEMORY_SMALL_HEAP_SIZE ? heap_size / 8 : VULKAN_MEMORY_BLOCK_SIZE;
+        allocator->block_sizes[i] = get_aligned(KMAX(block_size, (u64)VULKAN_MEMORY_GRANULE), VULKAN_MEMORY_GRANULE);
+        for (u32 kind = 0; kind < VULKAN_MEMORY_POOL_KIND_COUNT; ++kind) {
+            allocator->blocks[i][kind] = darray_create(vulkan_memory_block*);
+        }
+    }
+
+    for (u32 i = 0; i < properties->memoryHeapCount; ++i) {
+        char name[64];
+        string_format(name, "vulkan.heap%u.allocated", i);
+        allocator->heaps[i].allocated_counter = counter_register(name, COUNTER_TYPE_GAUGE);
+        string_format(name, "vulkan.heap%u.used", i);
+        allocator->heaps[i].used_counter = counter_register(name, COUNTER_TYPE_GAUGE);
+        string_format(name, "vulkan.heap%u.usage", i);
+        allocator->heaps[i].usage_counter = counter_register(name, COUNTER_TYPE_GAUGE);
+        string_format(name, "vulkan.heap%u.budget", i);
+        allocator->heaps[i].budget_counter = counter_register(name, COUNTER_TYPE_GAUGE);
+    }
+    allocator->device_allocations_counter = counter_register("vulkan.device_allocations", COUNTER_TYPE_GAUGE);
+
+    return true;
+}
+
+void vulkan_memory_allocator_destroy(vulkan_context* context) {
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+    const VkPhysicalDeviceMemoryProperties* properties = &context->device.memory;
+
+    for (u32 i = 0; i < properties->memoryHeapCount; ++i) {
+        const vulkan_memory_heap_usage* heap = &allocator->heaps[i];
+        if (heap->used_size) {
+            KWARN("Device memory heap %u still has %llu bytes in use at shutdown.", i, heap->used_size);
+        }
+    }
+
+    for (u32 i = 0; i < properties->memoryTypeCount; ++i) {
+        for (u32 kind = 0; kind < VULKAN_MEMORY_POOL_KIND_COUNT; ++kind) {
+            vulkan_memory_block** blocks = allocator->blocks[i][kind];
+            if (!blocks) {
+                continue;
+            }
+            u32 block_count = darray_length(blocks);
+            for (u32 b = 0; b < block_count; ++b) {
+                block_destroy(context, blocks[b]);
+            }
+            darray_destroy(blocks);
+            allocator->blocks[i][kind] = 0;
+        }
+    }
+
+    kmutex_destroy(&allocator->lock);
+}
+
+b8 vulkan_memory_allocate_buffer(
+    vulkan_context* context,
+    VkBuffer buffer,
+    VkMemoryPropertyFlags property_flags,
+    b8 transient,
+    VkMemoryRequirements* out_requirements,
+    vulkan_memory_allocation* out_allocation) {
+    b8 prefers_dedicated = false;
+    if (context->device.properties.apiVersion >= VK_API_VERSION_1_1) {
+        VkBufferMemoryRequirementsInfo2 info = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2};
+        info.buffer = buffer;
+        VkMemoryDedicatedRequirements dedicated = {VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS};
+        VkMemoryRequirements2 requirements = {VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2};
+        requirements.pNext = &dedicated;
+        vkGetBufferMemoryRequirements2(context->device.logical_device, &info, &requirements);
+        *out_requirements = requirements.memoryRequirements;
+        prefers_dedicated = dedicated.prefersDedicatedAllocation || dedicated.requiresDedicatedAllocation;
+    } else {
+        vkGetBufferMemoryRequirements(context->device.logical_device, buffer, out_requirements);
+    }
+
+    vulkan_memory_pool_kind kind = transient ? VULKAN_MEMORY_POOL_KIND_TRANSIENT : VULKAN_MEMORY_POOL_KIND_LINEAR;
+    return allocate(context, out_requirements, property_flags, kind, prefers_dedicated, 0, buffer, out_allocation);
+}
+
+b8 vulkan_memory_allocate_image(
+    vulkan_context* context,
+    VkImage image,
+    VkImageTiling tiling,
+    VkMemoryPropertyFlags property_flags,
+    VkMemoryRequirements* out_requirements,
+    vulkan_memory_allocation* out_allocation) {
+    b8 prefers_dedicated = false;
+    if (context->device.properties.apiVersion >= VK_API_VERSION_1_1) {
+        VkImageMemoryRequirementsInfo2 info = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2};
+        info.image = image;
+        VkMemoryDedicatedRequirements dedicated = {VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS};
+        VkMemoryRequirements2 requirements = {VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2};
+        requirements.pNext = &dedicated;
+        vkGetImageMemoryRequirements2(context->device.logical_device, &info, &requirements);
+        *out_requirements = requirements.memoryRequirements;
+        prefers_dedicated = dedicated.prefersDedicatedAllocation || dedicated.requiresDedicatedAllocation;
+    } else {
+        vkGetImageMemoryRequirements(context->device.logical_device, image, out_requirements);
+    }
+
+    vulkan_memory_pool_kind kind = tiling == VK_IMAGE_TILING_OPTIMAL ? VULKAN_MEMORY_POOL_KIND_OPTIMAL : VULKAN_MEMORY_POOL_KIND_LINEAR;
+    return allocate(context, out_requirements, property_flags, kind, prefers_dedicated, image, 0, out_allocation);
+}
+
+void vulkan_memory_free(vulkan_context* context, vulkan_memory_allocation* allocation) {
+    if (!allocation->memory) {
+        return;
+    }
+
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+    kmutex_lock(&allocator->lock);
+
+    vulkan_memory_heap_usage* heap = heap_usage(context, allocation->memory_type);
+    heap->used_size -= allocation->size;
+    heap_usage_report(heap);
+
+    vulkan_memory_block* block = allocation->block;
+    if (!block) {
+        device_memory_free(context, allocation->memory_type, allocation->size, allocation->memory, allocation->mapped);
+    } else {
+        block->allocation_count--;
+        if (block->kind == VULKAN_MEMORY_POOL_KIND_TRANSIENT) {
+            // Space in a transient block is only reused once all of it is free.
+            if (block->allocation_count == 0) {
+                block->linear_offset = 0;
+            }
+        } else if (!freelist_free_block(&block->granules, allocation->reserved_size / VULKAN_MEMORY_GRANULE, allocation->reserved_offset / VULKAN_MEMORY_GRANULE)) {
+            KERROR("Failed to return device memory to its block. The block's freelist is inconsistent.");
+        }
+
+        // Keep one empty block per pool around, so that a resource being recreated does not cost a device allocation.
+        vulkan_memory_block** blocks = allocator->blocks[block->memory_type][block->kind];
+        u32 block_count = darray_length(blocks);
+        if (block->allocation_count == 0 && block_count > 1) {
+            for (u32 i = 0; i < block_count; ++i) {
+                if (blocks[i] == block) {
+                    darray_swap_remove(blocks, i, 0);
+                    break;
+                }
+            }
+            block_destroy(context, block);
+        }
+    }
+
+    kmutex_unlock(&allocator->lock);
+    kzero_memory(allocation, sizeof(vulkan_memory_allocation));
+}
+
+b8 vulkan_memory_budget_update(vulkan_context* context) {
+    const VkPhysicalDeviceMemoryProperties* properties = &context->device.memory;
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT};
+    if (context->device.supports_memory_budget) {
+        VkPhysicalDeviceMemoryProperties2 properties2 = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2};
+        properties2.pNext = &budget;
+        vkGetPhysicalDeviceMemoryProperties2(context->device.physical_device, &properties2);
+    }
+
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+    kmutex_lock(&allocator->lock);
+    f32 most_used = 0.0f;
+    for (u32 i = 0; i < properties->memoryHeapCount; ++i) {
+        vulkan_memory_heap_usage* heap = &allocator->heaps[i];
+        if (context->device.supports_memory_budget) {
+            heap->usage_size = budget.heapUsage[i];
+            heap->budget_size = budget.heapBudget[i];
+        } else {
+            // Only what this process allocated is known, against a guess at what it may have.
+            heap->usage_size = heap->allocated_size;
+            heap->budget_size = (u64)(properties->memoryHeaps[i].size * VULKAN_MEMORY_ESTIMATED_BUDGET);
+        }
+        counter_set(heap->usage_counter, (i64)heap->usage_size);
+        counter_set(heap->budget_counter, (i64)heap->budget_size);
+
+        if ((properties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) && heap->budget_size) {
+            most_used = KMAX(most_used, (f32)((f64)heap->usage_size / (f64)heap->budget_size));
+        }
+    }
+    kmutex_unlock(&allocator->lock);
+
+    // Rises as soon as a threshold is crossed, but eases only once well back under it.
+    renderer_memory_pressure pressure = RENDERER_MEMORY_PRESSURE_NONE;
+    if (most_used >= VULKAN_MEMORY_PRESSURE_CRITICAL ||
+        (allocator->pressure == RENDERER_MEMORY_PRESSURE_CRITICAL && most_used >= VULKAN_MEMORY_PRESSURE_CRITICAL - VULKAN_MEMORY_PRESSURE_HYSTERESIS)) {
+        pressure = RENDERER_MEMORY_PRESSURE_CRITICAL;
+    } else if (most_used >= VULKAN_MEMORY_PRESSURE_MODERATE ||
+               (allocator->pressure != RENDERER_MEMORY_PRESSURE_NONE && most_used >= VULKAN_MEMORY_PRESSURE_MODERATE - VULKAN_MEMORY_PRESSURE_HYSTERESIS)) {
+        pressure = RENDERER_MEMORY_PRESSURE_MODERATE;
+    }
+    allocator->pressure_used = most_used;
+    if (pressure == allocator->pressure) {
+        return false;
+    }
+    allocator->pressure = pressure;
+    return true;
+}
+
+void* vulkan_memory_map(const vulkan_memory_allocation* allocation, u64 offset) {
+    return allocation->mapped ? (u8*)allocation->mapped + offset : 0;
+}
+
+void vulkan_memory_flush(vulkan_context* context, const vulkan_memory_allocation* allocation, u64 offset, u64 size) {
+    // Flushed ranges must be aligned to nonCoherentAtomSize, and end either on it or at the end of the memory.
+    u64 atom_size = KMAX(context->device.properties.limits.nonCoherentAtomSize, 1);
+    u64 memory_size = allocation->block ? allocation->block->size : allocation->size;
+    u64 start = allocation->offset + offset;
+    u64 aligned_start = start - (start % atom_size);
+    u64 aligned_end = get_aligned(start + size, atom_size);
+
+    VkMappedMemoryRange range = {VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE};
+    range.memory = allocation->memory;
+    range.offset = aligned_start;
+    range.size = aligned_end >= memory_size ? VK_WHOLE_SIZE : aligned_end - aligned_start;
+    VK_CHECK(vkFlushMappedMemoryRanges(context->device.logical_device, 1, &range));
+}
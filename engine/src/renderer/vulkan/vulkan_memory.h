@@ -0,0 +1,118 @@
+/**
+ * @file vulkan_memory.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief This file contains the device memory allocator, which gives buffers and images ranges
+ * of large blocks of device memory rather than a device allocation each.
+ * @details Each memory type has its own blocks, kept apart by pool kind. Buffers and optimally-tiled
+ * images are suballocated from a freelist over their blocks, while staging and readback buffers are
+ * bumped through transient blocks, which are reused once emptied. Resources the driver prefers to
+ * keep apart, and those too large to share a block, get dedicated device memory. Host-visible
+ * memory is mapped once, for its whole lifetime. The bytes allocated from and used in each heap are
+ * reported as "vulkan.heap<N>.allocated" and "vulkan.heap<N>.used" gauges, and the usage and budget of
+ * each heap, from VK_EXT_memory_budget where supported, as "vulkan.heap<N>.usage" and
+ * "vulkan.heap<N>.budget". From those the pressure on device-local memory is judged.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "vulkan_types.inl"
+
+/**
+ * @brief Creates the device memory allocator of the given context. Must be called once the
+ * device exists, before any buffer or image is created.
+ *
+ * @param context A pointer to the Vulkan context.
+ * @returns True on success; otherwise false.
+ */
+b8 vulkan_memory_allocator_create(vulkan_context* context);
+
+/**
+ * @brief Destroys the device memory allocator of the given context, freeing its blocks.
+ * Allocations still outstanding are reported as leaks.
+ *
+ * @param context A pointer to the Vulkan context.
+ */
+void vulkan_memory_allocator_destroy(vulkan_context* context);
+
+/**
+ * @brief Allocates memory for the given buffer. The buffer is not bound to it.
+ *
+ * @param context A pointer to the Vulkan context.
+ * @param buffer The buffer to allocate memory for.
+ * @param property_flags The properties the memory must have.
+ * @param transient Indicates if the buffer is short-lived, such as a staging buffer.
+ * @param out_requirements A pointer to hold the memory requirements of the buffer.
+ * @param out_allocation A pointer to hold the allocation.
+ * @returns True on success; otherwise false.
+ */
+b8 vulkan_memory_allocate_buffer(
+    vulkan_context* context,
+    VkBuffer buffer,
+    VkMemoryPropertyFlags property_flags,
+    b8 transient,
+    VkMemoryRequirements* out_requirements,
+    vulkan_memory_allocation* out_allocation);
+
+/**
+ * @brief Allocates memory for the given image. The image is not bound to it.
+ *
+ * @param context A pointer to the Vulkan context.
+ * @param image The image to allocate memory for.
+ * @param tiling The tiling the image was created with.
+ * @param property_flags The properties the memory must have.
+ * @param out_requirements A pointer to hold the memory requirements of the image.
+ * @param out_allocation A pointer to hold the allocation.
+ * @returns True on success; otherwise false.
+ */
+b8 vulkan_memory_allocate_image(
+    vulkan_context* context,
+    VkImage image,
+    VkImageTiling tiling,
+    VkMemoryPropertyFlags property_flags,
+    VkMemoryRequirements* out_requirements,
+    vulkan_memory_allocation* out_allocation);
+
+/**
+ * @brief Frees the given allocation and zeroes it. Does nothing if it holds no memory.
+ *
+ * @param context A pointer to the Vulkan context.
+ * @param allocation A pointer to the allocation to free.
+ */
+void vulkan_memory_free(vulkan_context* context, vulkan_memory_allocation* allocation);
+
+/**
+ * @brief Queries the usage and budget of each heap, reports them and judges the pressure on
+ * device-local memory from the fullest device-local heap. Where VK_EXT_memory_budget is not
+ * supported, usage is what this process allocated and the budget a fraction of the heap.
+ * Cheap enough to be called every frame.
+ *
+ * @param context A pointer to the Vulkan context.
+ * @returns True if the pressure changed, in which case the allocator's pressure holds the new one; otherwise false.
+ */
+b8 vulkan_memory_budget_update(vulkan_context* context);
+
+/**
+ * @brief Gets a pointer to the given offset of an allocation of host-visible memory. The memory
+ * stays mapped for as long as it is allocated, so there is nothing to unmap.
+ *
+ * @param allocation A pointer to the allocation.
+ * @param offset The offset within the allocation.
+ * @returns A pointer to the memory, or 0 if it is not host visible.
+ */
+void* vulkan_memory_map(const vulkan_memory_allocation* allocation, u64 offset);
+
+/**
+ * @brief Flushes a range of an allocation of host-visible memory written by the host, so that it
+ * is seen by the device. Not needed for host-coherent memory.
+ *
+ * @param context A pointer to the Vulkan context.
+ * @param allocation A pointer to the allocation.
+ * @param offset The offset of the range within the allocation.
+ * @param size The size of the range.
+ */
+void vulkan_memory_flush(vulkan_context* context, const vulkan_memory_allocation* allocation, u64 offset, u64 size);
@@ -59,7 +59,8 @@ b8 vulkan_graphics_pipeline_create(vulkan_context* context, const vulkan_pipelin
         if (config->shader_flags & SHADER_FLAG_DEPTH_WRITE) {
             depth_stencil.depthWriteEnable = VK_TRUE;
         }
-        depth_stencil.depthCompareOp = VK_COMPARE_OP_LESS;
+        // Less or equal, so draws after a depth prepass pass where it wrote their own depth.
+        depth_stencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
         depth_stencil.depthBoundsTestEnable = VK_FALSE;
         depth_stencil.stencilTestEnable = VK_FALSE;
     }
@@ -77,6 +78,16 @@ b8 vulkan_graphics_pipeline_create(vulkan_context* context, const vulkan_pipelin
     color_blend_attachment_state.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
                                                   VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
 
+    // Without a fragment stage only depth is written, such as by a depth prepass, and the colour is left as it is.
+    b8 has_fragment_stage = false;
+    for (u32 i = 0; i < config->stage_count; ++i) {
+        has_fragment_stage |= config->stages[i].stage == VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+    if (!has_fragment_stage) {
+        color_blend_attachment_state.blendEnable = VK_FALSE;
+        color_blend_attachment_state.colorWriteMask = 0;
+    }
+
     VkPipelineColorBlendStateCreateInfo color_blend_state_create_info = {VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO};
     color_blend_state_create_info.logicOpEnable = VK_FALSE;
     color_blend_state_create_info.logicOp = VK_LOGIC_OP_COPY;
@@ -100,16 +111,18 @@ b8 vulkan_graphics_pipeline_create(vulkan_context* context, const vulkan_pipelin
     binding_description.stride = config->stride;
     binding_description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;  // Move to next data entry for each vertex.
 
-    // Attributes
+    // Attributes. Shaders pulling their vertices from the vertex buffer have none.
     VkPipelineVertexInputStateCreateInfo vertex_input_info = {VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
-    vertex_input_info.vertexBindingDescriptionCount = 1;
-    vertex_input_info.pVertexBindingDescriptions = &binding_description;
-    vertex_input_info.vertexAttributeDescriptionCount = config->attribute_count;
-    vertex_input_info.pVertexAttributeDescriptions = config->attributes;
+    if (!(config->shader_flags & SHADER_FLAG_VERTEX_PULLING)) {
+        vertex_input_info.vertexBindingDescriptionCount = 1;
+        vertex_input_info.pVertexBindingDescriptions = &binding_description;
+        vertex_input_info.vertexAttributeDescriptionCount = config->attribute_count;
+        vertex_input_info.pVertexAttributeDescriptions = config->attributes;
+    }
 
     // Input assembly
     VkPipelineInputAssemblyStateCreateInfo input_assembly = {VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO};
-    input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    input_assembly.topology = (config->shader_flags & SHADER_FLAG_LINES) ? VK_PRIMITIVE_TOPOLOGY_LINE_LIST : VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
     input_assembly.primitiveRestartEnable = VK_FALSE;
 
     // Pipeline layout
@@ -171,12 +184,22 @@ b8 vulkan_graphics_pipeline_create(vulkan_context* context, const vulkan_pipelin
 
     pipeline_create_info.renderPass = config->renderpass->handle;
     pipeline_create_info.subpass = 0;
+
+    // Without a render pass object, the pipeline is made for the formats of the renderpass's attachments.
+    VkPipelineRenderingCreateInfoKHR rendering_create_info = {VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR};
+    if (!config->renderpass->handle) {
+        rendering_create_info.colorAttachmentCount = config->renderpass->colour_attachment_count;
+        rendering_create_info.pColorAttachmentFormats = config->renderpass->colour_formats;
+        rendering_create_info.depthAttachmentFormat = config->renderpass->depth_format;
+        rendering_create_info.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+        pipeline_create_info.pNext = &rendering_create_info;
+    }
     pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
     pipeline_create_info.basePipelineIndex = -1;
 
     VkResult result = vkCreateGraphicsPipelines(
         context->device.logical_device,
-        VK_NULL_HANDLE,
+        context->pipeline_cache,
         1,
         &pipeline_create_info,
         context->allocator,
@@ -191,6 +214,58 @@ b8 vulkan_graphics_pipeline_create(vulkan_context* context, const vulkan_pipelin
     return false;
 }
 
+b8 vulkan_compute_pipeline_create(
+    vulkan_context* context,
+    const VkPipelineShaderStageCreateInfo* stage,
+    u32 descriptor_set_layout_count,
+    const VkDescriptorSetLayout* descriptor_set_layouts,
+    u32 push_constant_size,
+    vulkan_pipeline* out_pipeline) {
+    VkPipelineLayoutCreateInfo pipeline_layout_create_info = {VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    pipeline_layout_create_info.setLayoutCount = descriptor_set_layout_count;
+    pipeline_layout_create_info.pSetLayouts = descriptor_set_layouts;
+
+    // Push constants, if any, are a single range from the start.
+    VkPushConstantRange push_constant_range = {VK_SHADER_STAGE_COMPUTE_BIT, 0, push_constant_size};
+    if (push_constant_size > 0) {
+        pipeline_layout_create_info.pushConstantRangeCount = 1;
+        pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+    }
+    VkResult result = vkCreatePipelineLayout(
+        context->device.logical_device,
+        &pipeline_layout_create_info,
+        context->allocator,
+        &out_pipeline->pipeline_layout);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("vkCreatePipelineLayout failed with %s.", vulkan_result_string(result, true));
+        return false;
+    }
+
+    VkComputePipelineCreateInfo pipeline_create_info = {VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+    pipeline_create_info.stage = *stage;
+    pipeline_create_info.layout = out_pipeline->pipeline_layout;
+    pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
+    pipeline_create_info.basePipelineIndex = -1;
+
+    result = vkCreateComputePipelines(
+        context->device.logical_device,
+        context->pipeline_cache,
+        1,
+        &pipeline_create_info,
+        context->allocator,
+        &out_pipeline->handle);
+
+    if (vulkan_result_is_success(result)) {
+        KDEBUG("Compute pipeline created!");
+        return true;
+    }
+
+    KERROR("vkCreateComputePipelines failed with %s.", vulkan_result_string(result, true));
+    vkDestroyPipelineLayout(context->device.logical_device, out_pipeline->pipeline_layout, context->allocator);
+    out_pipeline->pipeline_layout = 0;
+    return false;
+}
+
 void vulkan_pipeline_destroy(vulkan_context* context, vulkan_pipeline* pipeline) {
     if (pipeline) {
         // Destroy pipeline
@@ -25,6 +25,25 @@
  */
 b8 vulkan_graphics_pipeline_create(vulkan_context* context, const vulkan_pipeline_config* config, vulkan_pipeline* out_pipeline);
 
+/**
+ * @brief Creates a new Vulkan compute pipeline.
+ *
+ * @param context A pointer to the Vulkan context.
+ * @param stage A constant pointer to the compute stage.
+ * @param descriptor_set_layout_count The number of descriptor set layouts.
+ * @param descriptor_set_layouts An array of descriptor set layouts.
+ * @param push_constant_size The size in bytes of the push constant range, starting at 0. 0 if push constants are not used.
+ * @param out_pipeline A pointer to hold the newly-created pipeline.
+ * @return True on success; otherwise false.
+ */
+b8 vulkan_compute_pipeline_create(
+    vulkan_context* context,
+    const VkPipelineShaderStageCreateInfo* stage,
+    u32 descriptor_set_layout_count,
+    const VkDescriptorSetLayout* descriptor_set_layouts,
+    u32 push_constant_size,
+    vulkan_pipeline* out_pipeline);
+
 /**
  * @brief Destroys the given pipeline.
  *
@@ -34,7 +53,7 @@ b8 vulkan_graphics_pipeline_create(vulkan_context* context, const vulkan_pipelin
 void vulkan_pipeline_destroy(vulkan_context* context, vulkan_pipeline* pipeline);
 
 /**
- * @brief Binds the given pipeline for use. This must be done within a renderpass.
+ * @brief Binds the given pipeline for use. Graphics pipelines must be bound within a renderpass.
  *
  * @param command_buffer The command buffer to assign the bind command to.
  * @param bind_point The pipeline bind point (typically bind_point_graphics)
@@ -19,7 +19,7 @@ b8 create_shader_module(
 
     // Read the resource.
     resource binary_resource;
-    if (!resource_system_load(file_name, RESOURCE_TYPE_BINARY, 0, &binary_resource)) {
+    if (!resource_system_acquire(file_name, RESOURCE_TYPE_BINARY, 0, &binary_resource)) {
         KERROR("Unable to read shader module: %s.", file_name);
         return false;
     }
@@ -37,7 +37,7 @@ b8 create_shader_module(
         &shader_stages[stage_index].handle));
 
     // Release the resource.
-    resource_system_unload(&binary_resource);
+    resource_system_release(&binary_resource);
 
     // Shader stage info
     kzero_memory(&shader_stages[stage_index].shader_stage_create_info, sizeof(VkPipelineShaderStageCreateInfo));
@@ -0,0 +1,299 @@
+#include "vulkan_skinning.h"
+
+#include "vulkan_backend.h"
+#include "vulkan_pipeline.h"
+#include "vulkan_shader_utils.h"
+#include "vulkan_utils.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+#include "renderer/renderer_frontend.h"
+
+/** @brief The workgroup size of the skinning shader. */
+#define SKINNING_GROUP_SIZE 64
+
+// Writes a buffer binding of a skin's set.
+static void buffer_binding_write(vulkan_context* context, VkDescriptorSet set, u32 binding, renderbuffer* buffer) {
+    VkDescriptorBufferInfo buffer_info;
+    buffer_info.buffer = ((vulkan_buffer*)buffer->internal_data)->handle;
+    buffer_info.offset = 0;
+    buffer_info.range = VK_WHOLE_SIZE;
+
+    VkWriteDescriptorSet write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+    write.dstSet = set;
+    write.dstBinding = binding;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.descriptorCount = 1;
+    write.pBufferInfo = &buffer_info;
+    vkUpdateDescriptorSets(context->device.logical_device, 1, &write, 0, 0);
+}
+
+b8 vulkan_skinning_create(vulkan_context* context) {
+    vulkan_skinning_state* skinning = &context->skinning;
+    VkDevice device = context->device.logical_device;
+    u32 frame_count = context->swapchain.max_frames_in_flight;
+
+    for (u32 i = 0; i < VULKAN_MAX_SKINS; ++i) {
+        skinning->skins[i].geometry_id = INVALID_ID;
+    }
+
+    // The vertices skinned are written through the vertex set of their block.
+    if (!context->vertex_set_layout) {
+        KWARN("There are no vertex sets to skin geometries through. Geometries are not skinned.");
+        return false;
+    }
+
+    // The set of each skin: its vertices in the bind pose, then the palettes.
+    VkDescriptorSetLayoutBinding bindings[2];
+    kzero_memory(bindings, sizeof(VkDescriptorSetLayoutBinding) * 2);
+    for (u32 i = 0; i < 2; ++i) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo layout_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    layout_info.bindingCount = 2;
+    layout_info.pBindings = bindings;
+    VkResult result = vkCreateDescriptorSetLayout(device, &layout_info, context->allocator, &skinning->set_layout);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("Failed to create the skinning set layout: '%s'", vulkan_result_string(result, true));
+        vulkan_skinning_destroy(context);
+        return false;
+    }
+
+    // The pipeline. A missing shader leaves skinning disabled rather than failing the renderer.
+    vulkan_shader_stage stage;
+    b8 created = create_shader_module(context, "Builtin.SkinningShader", "comp", VK_SHADER_STAGE_COMPUTE_BIT, 0, &stage);
+    if (created) {
+        VkDescriptorSetLayout set_layouts[2] = {skinning->set_layout, context->vertex_set_layout};
+        created = vulkan_compute_pipeline_create(context, &stage.shader_stage_create_info, 2, set_layouts, sizeof(vulkan_skinning_push_constants), &skinning->pipeline);
+        vkDestroyShaderModule(device, stage.handle, context->allocator);
+    }
+    if (!created) {
+        KWARN("Failed to create the skinning pipeline. Geometries are not skinned.");
+        vulkan_skinning_destroy(context);
+        return false;
+    }
+
+    // Room for the sets of removed skins to wait out the frames in flight alongside those of their replacements.
+    VkDescriptorPoolSize pool_size = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VULKAN_MAX_SKINS * 2 * 2};
+    VkDescriptorPoolCreateInfo pool_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+    pool_info.maxSets = VULKAN_MAX_SKINS * 2;
+    pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    result = vkCreateDescriptorPool(device, &pool_info, context->allocator, &skinning->descriptor_pool);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("Failed to create the skinning descriptor pool: '%s'", vulkan_result_string(result, true));
+        vulkan_skinning_destroy(context);
+        return false;
+    }
+
+    // Palettes, one region per frame in flight. Each skin's set covers them all, and is given where its
+    // palette starts as it is skinned.
+    u64 region_size = sizeof(mat4) * VULKAN_MAX_SKIN_JOINTS_PER_FRAME;
+    if (!renderer_renderbuffer_create(RENDERBUFFER_TYPE_STORAGE, region_size * frame_count, false, &skinning->palette_buffer)) {
+        KERROR("Failed to create the skinning palette buffer.");
+        vulkan_skinning_destroy(context);
+        return false;
+    }
+    renderer_renderbuffer_bind(&skinning->palette_buffer, 0);
+    skinning->palettes = vulkan_buffer_map_memory(&skinning->palette_buffer, 0, VK_WHOLE_SIZE);
+
+    skinning->enabled = true;
+    return true;
+}
+
+void vulkan_skinning_destroy(vulkan_context* context) {
+    vulkan_skinning_state* skinning = &context->skinning;
+    VkDevice device = context->device.logical_device;
+
+    for (u32 i = 0; i < VULKAN_MAX_SKINS; ++i) {
+        u32 geometry_id = skinning->skins[i].geometry_id;
+        if (geometry_id != INVALID_ID && geometry_id < VULKAN_MAX_GEOMETRY_COUNT) {
+            vulkan_skinning_skin_destroy(context, &context->geometries[geometry_id]);
+        }
+    }
+    if (skinning->palette_buffer.internal_data) {
+        renderer_renderbuffer_unbind(&skinning->palette_buffer);
+        renderer_renderbuffer_destroy(&skinning->palette_buffer);
+    }
+    // The sets of removed skins go with the pool, once the frames which may use them complete.
+    if (skinning->descriptor_pool) {
+        vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_DESCRIPTOR_POOL};
+        deletion.descriptor_pool = skinning->descriptor_pool;
+        context->deferred_delete(&deletion);
+    }
+    vulkan_pipeline_destroy(context, &skinning->pipeline);
+    if (skinning->set_layout) {
+        vkDestroyDescriptorSetLayout(device, skinning->set_layout, context->allocator);
+    }
+    kzero_memory(skinning, sizeof(vulkan_skinning_state));
+    for (u32 i = 0; i < VULKAN_MAX_SKINS; ++i) {
+        skinning->skins[i].geometry_id = INVALID_ID;
+    }
+}
+
+b8 vulkan_skinning_skin_create(vulkan_context* context, vulkan_geometry_data* geometry, u32 vertex_count, const vertex_3d_skinned* vertices) {
+    vulkan_skinning_state* skinning = &context->skinning;
+    if (!skinning->enabled) {
+        KERROR("vulkan_skinning_skin_create - skinning is not available, so geometry %u cannot be skinned.", geometry->id);
+        return false;
+    }
+    if (!vertex_count || !vertices) {
+        KERROR("vulkan_skinning_skin_create requires vertices, and none were supplied.");
+        return false;
+    }
+    // The skinned vertices are written over the geometry's own, so must be laid out exactly as they are.
+    if (geometry->vertex_element_size != sizeof(vertex_3d_packed) || geometry->vertex_count != vertex_count) {
+        KERROR("vulkan_skinning_skin_create - geometry %u has %u vertices of %u bytes, but a skin needs %u of %u bytes.",
+               geometry->id, geometry->vertex_count, geometry->vertex_element_size, vertex_count, (u32)sizeof(vertex_3d_packed));
+        return false;
+    }
+
+    vulkan_skinning_skin_destroy(context, geometry);
+    u32 index = INVALID_ID;
+    for (u32 i = 0; i < VULKAN_MAX_SKINS; ++i) {
+        if (skinning->skins[i].geometry_id == INVALID_ID) {
+            index = i;
+            break;
+        }
+    }
+    if (index == INVALID_ID) {
+        KERROR("vulkan_skinning_skin_create - there is no room for another skin. Increase VULKAN_MAX_SKINS.");
+        return false;
+    }
+
+    vulkan_skin* skin = &skinning->skins[index];
+    u64 size = sizeof(vertex_3d_skinned) * vertex_count;
+    if (!renderer_renderbuffer_create(RENDERBUFFER_TYPE_STORAGE, size, false, &skin->source_buffer)) {
+        KERROR("vulkan_skinning_skin_create - failed to create the buffer of the vertices in the bind pose.");
+        return false;
+    }
+    renderer_renderbuffer_bind(&skin->source_buffer, 0);
+    if (!renderer_renderbuffer_load_range(&skin->source_buffer, 0, size, vertices)) {
+        KERROR("vulkan_skinning_skin_create - failed to upload the vertices in the bind pose.");
+        renderer_renderbuffer_destroy(&skin->source_buffer);
+        return false;
+    }
+
+    VkDescriptorSetAllocateInfo alloc_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    alloc_info.descriptorPool = skinning->descriptor_pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &skinning->set_layout;
+    VkResult result = vkAllocateDescriptorSets(context->device.logical_device, &alloc_info, &skin->set);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("vulkan_skinning_skin_create - failed to allocate the skin's set: '%s'", vulkan_result_string(result, true));
+        renderer_renderbuffer_destroy(&skin->source_buffer);
+        return false;
+    }
+    buffer_binding_write(context, skin->set, 0, &skin->source_buffer);
+    buffer_binding_write(context, skin->set, 1, &skinning->palette_buffer);
+
+    skin->geometry_id = geometry->id;
+    skin->vertex_count = vertex_count;
+    geometry->skin_index = index;
+    return true;
+}
+
+void vulkan_skinning_skin_destroy(vulkan_context* context, vulkan_geometry_data* geometry) {
+    if (geometry->skin_index == INVALID_ID) {
+        return;
+    }
+    vulkan_skin* skin = &context->skinning.skins[geometry->skin_index];
+
+    // Frames in flight may still be skinning with these.
+    renderer_renderbuffer_destroy(&skin->source_buffer);
+    if (skin->set) {
+        vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_DESCRIPTOR_SETS};
+        deletion.descriptor_sets.pool = context->skinning.descriptor_pool;
+        deletion.descriptor_sets.count = 1;
+        deletion.descriptor_sets.sets[0] = skin->set;
+        context->deferred_delete(&deletion);
+    }
+    kzero_memory(skin, sizeof(vulkan_skin));
+    skin->geometry_id = INVALID_ID;
+    geometry->skin_index = INVALID_ID;
+}
+
+void vulkan_skinning_frame_begin(vulkan_context* context) {
+    context->skinning.joints_used = 0;
+}
+
+void vulkan_skinning_record(vulkan_context* context, vulkan_command_buffer* command_buffer, u32 count, const renderer_skin_update* updates) {
+    vulkan_skinning_state* skinning = &context->skinning;
+    if (!skinning->enabled || !count) {
+        return;
+    }
+    VkCommandBuffer handle = command_buffer->handle;
+    mat4* frame_palettes = skinning->palettes + (u64)VULKAN_MAX_SKIN_JOINTS_PER_FRAME * context->current_frame;
+    b8 recorded = false;
+
+    for (u32 i = 0; i < count; ++i) {
+        const renderer_skin_update* update = &updates[i];
+        if (!update->geometry || update->geometry->internal_id == INVALID_ID || !update->palette || !update->joint_count) {
+            continue;
+        }
+        vulkan_geometry_data* geometry = &context->geometries[update->geometry->internal_id];
+        if (geometry->skin_index == INVALID_ID) {
+            KWARN("vulkan_skinning_record - geometry '%s' has no skin, so cannot be posed.", update->geometry->name);
+            continue;
+        }
+        // Not written while the transfer queue or compaction may be copying to its vertices, nor once
+        // they are reuploaded with another count.
+        vulkan_skin* skin = &skinning->skins[geometry->skin_index];
+        vulkan_geometry_block* block = &context->geometry_blocks[geometry->block];
+        if (geometry->upload_pending || geometry->move_pending || skin->vertex_count != geometry->vertex_count || !block->vertex_set) {
+            continue;
+        }
+        if (skinning->joints_used + update->joint_count > VULKAN_MAX_SKIN_JOINTS_PER_FRAME) {
+            KWARN("vulkan_skinning_record - the frame's palettes are full, so the rest keep their last pose. Increase VULKAN_MAX_SKIN_JOINTS_PER_FRAME.");
+            break;
+        }
+
+        if (!recorded) {
+            // The vertices are written once the frames before are done drawing them.
+            VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+            barrier.srcAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            vkCmdPipelineBarrier(
+                handle,
+                VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                0, 1, &barrier, 0, 0, 0, 0);
+            vkCmdBindPipeline(handle, VK_PIPELINE_BIND_POINT_COMPUTE, skinning->pipeline.handle);
+            recorded = true;
+        }
+
+        // The palette is in place by the time the frame is submitted, as the memory is coherent.
+        kcopy_memory(frame_palettes + skinning->joints_used, update->palette, sizeof(mat4) * update->joint_count);
+        vulkan_skinning_push_constants push;
+        push.vertex_count = skin->vertex_count;
+        push.first_joint = VULKAN_MAX_SKIN_JOINTS_PER_FRAME * context->current_frame + skinning->joints_used;
+        push.first_word = (u32)(geometry->vertex_buffer_offset / sizeof(u32));
+        push.joint_count = update->joint_count;
+        skinning->joints_used += update->joint_count;
+
+        VkDescriptorSet sets[2] = {skin->set, block->vertex_set};
+        vkCmdBindDescriptorSets(handle, VK_PIPELINE_BIND_POINT_COMPUTE, skinning->pipeline.pipeline_layout, 0, 2, sets, 0, 0);
+        vkCmdPushConstants(handle, skinning->pipeline.pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(vulkan_skinning_push_constants), &push);
+        vkCmdDispatch(handle, (skin->vertex_count + SKINNING_GROUP_SIZE - 1) / SKINNING_GROUP_SIZE, 1, 1);
+
+        // Compaction moves it only once the frames writing it complete.
+        geometry->upload_serial = context->frame_serial;
+    }
+
+    if (recorded) {
+        // Draws read the vertices once they are skinned, as attributes or pulled.
+        VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(
+            handle,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+            0, 1, &barrier, 0, 0, 0, 0);
+    }
+}
@@ -0,0 +1,75 @@
+/**
+ * @file vulkan_skinning.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief This file contains GPU skinning of geometries, from their vertices in the bind pose and the
+ * joint palettes they are posed with each frame.
+ * @details A skinned geometry keeps its vertices in the bind pose, with the joints influencing them,
+ * in a storage buffer of its own. Each frame it is posed in, its palette is written to a mapped region
+ * of the frame, and a compute shader skins its vertices into its own range of its block's vertex
+ * buffer, recorded at the start of the frame before any renderpass. Every shader then draws it as it
+ * draws any other geometry, batched, culled and pulled alike. Geometries still uploading, or being
+ * moved by compaction, are skinned once they land. Culling uses the extents of the geometry, which
+ * should be made to cover every pose it takes.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "vulkan_types.inl"
+
+/**
+ * @brief Creates the pipeline, set layout, pool and palette buffer used for skinning. Must be called
+ * once the vertex sets of the geometry blocks exist. Skinning is left disabled if it cannot run.
+ *
+ * @param context A pointer to the Vulkan context.
+ * @returns True if skinning is enabled; otherwise false.
+ */
+b8 vulkan_skinning_create(vulkan_context* context);
+
+/**
+ * @brief Destroys every skin, and everything used for skinning.
+ *
+ * @param context A pointer to the Vulkan context.
+ */
+void vulkan_skinning_destroy(vulkan_context* context);
+
+/**
+ * @brief Gives the given geometry a skin, replacing any it has.
+ *
+ * @param context A pointer to the Vulkan context.
+ * @param geometry A pointer to the internal data of the geometry, which must have as many vertex_3d_packed vertices.
+ * @param vertex_count The number of vertices.
+ * @param vertices An array of the vertices in the bind pose.
+ * @returns True on success; otherwise false.
+ */
+b8 vulkan_skinning_skin_create(vulkan_context* context, vulkan_geometry_data* geometry, u32 vertex_count, const vertex_3d_skinned* vertices);
+
+/**
+ * @brief Removes the skin of the given geometry, if it has one, once the frames in flight are done with it.
+ *
+ * @param context A pointer to the Vulkan context.
+ * @param geometry A pointer to the internal data of the geometry.
+ */
+void vulkan_skinning_skin_destroy(vulkan_context* context, vulkan_geometry_data* geometry);
+
+/**
+ * @brief Starts the palettes of the current frame. Must be called as the frame begins.
+ *
+ * @param context A pointer to the Vulkan context.
+ */
+void vulkan_skinning_frame_begin(vulkan_context* context);
+
+/**
+ * @brief Records the skinning of the given geometries with their poses into the given command buffer.
+ * Must be recorded outside of any renderpass, before the geometries are drawn.
+ *
+ * @param context A pointer to the Vulkan context.
+ * @param command_buffer A pointer to the command buffer to record into.
+ * @param count The number of geometries.
+ * @param updates An array of the geometries and their poses.
+ */
+void vulkan_skinning_record(vulkan_context* context, vulkan_command_buffer* command_buffer, u32 count, const renderer_skin_update* updates);
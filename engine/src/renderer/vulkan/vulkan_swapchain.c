@@ -10,6 +10,31 @@
 void create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* swapchain);
 void destroy(vulkan_context* context, vulkan_swapchain* swapchain);
 
+// Indicates if the surface can present with the given mode.
+static b8 present_mode_supported(vulkan_context* context, VkPresentModeKHR mode) {
+    for (u32 i = 0; i < context->device.swapchain_support.present_mode_count; ++i) {
+        if (context->device.swapchain_support.present_modes[i] == mode) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The present mode to use for the given configured one, falling back to the nearest supported.
+// FIFO is always supported.
+static VkPresentModeKHR present_mode_choose(vulkan_context* context, renderer_present_mode mode) {
+    if (mode == RENDERER_PRESENT_MODE_IMMEDIATE) {
+        if (present_mode_supported(context, VK_PRESENT_MODE_IMMEDIATE_KHR)) {
+            return VK_PRESENT_MODE_IMMEDIATE_KHR;
+        }
+        mode = RENDERER_PRESENT_MODE_MAILBOX;
+    }
+    if (mode == RENDERER_PRESENT_MODE_MAILBOX && present_mode_supported(context, VK_PRESENT_MODE_MAILBOX_KHR)) {
+        return VK_PRESENT_MODE_MAILBOX_KHR;
+    }
+    return VK_PRESENT_MODE_FIFO_KHR;
+}
+
 void vulkan_swapchain_create(
     vulkan_context* context,
     u32 width,
@@ -19,14 +44,44 @@ void vulkan_swapchain_create(
     create(context, width, height, out_swapchain);
 }
 
+// Queues the image views and depth images of the swapchain for deletion once the frames which may use them complete.
+static void retire(vulkan_context* context, vulkan_swapchain* swapchain) {
+    for (u32 i = 0; i < swapchain->image_count; ++i) {
+        vulkan_image* image = (vulkan_image*)swapchain->render_textures[i].internal_data;
+        if (image->view) {
+            vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_IMAGE_VIEW};
+            deletion.image_view = image->view;
+            context->deferred_delete(&deletion);
+            image->view = 0;
+        }
+
+        vulkan_image* depth_image = (vulkan_image*)swapchain->depth_textures[i].internal_data;
+        if (depth_image) {
+            vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_IMAGE};
+            deletion.image = *depth_image;
+            context->deferred_delete(&deletion);
+            kfree(depth_image, sizeof(vulkan_image), MEMORY_TAG_TEXTURE);
+            swapchain->depth_textures[i].internal_data = 0;
+        }
+    }
+}
+
 void vulkan_swapchain_recreate(
     vulkan_context* context,
     u32 width,
     u32 height,
     vulkan_swapchain* swapchain) {
-    // Destroy the old and create a new one.
-    destroy(context, swapchain);
+    // The old swapchain is handed to the new one rather than destroyed first, so presentation carries
+    // on across the switch. It and what was made for it go once the frames using them complete,
+    // without waiting for the device to idle.
+    retire(context, swapchain);
+    VkSwapchainKHR old_handle = swapchain->handle;
     create(context, width, height, swapchain);
+    if (old_handle) {
+        vulkan_deferred_deletion deletion = {VULKAN_DEFERRED_DELETION_TYPE_SWAPCHAIN};
+        deletion.swapchain = old_handle;
+        context->deferred_delete(&deletion);
+    }
 }
 
 void vulkan_swapchain_destroy(
@@ -77,6 +132,15 @@ void vulkan_swapchain_present(
     present_info.pImageIndices = &present_image_index;
     present_info.pResults = 0;
 
+    // Identify the present, so that it can be waited on to reach the display.
+    VkPresentIdKHR present_id = {VK_STRUCTURE_TYPE_PRESENT_ID_KHR};
+    if (context->device.supports_present_wait) {
+        context->present_id++;
+        present_id.swapchainCount = 1;
+        present_id.pPresentIds = &context->present_id;
+        present_info.pNext = &present_id;
+    }
+
     VkResult result = vkQueuePresentKHR(present_queue, &present_info);
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
         // Swapchain is out of date, suboptimal or a framebuffer resize has occurred. Trigger swapchain recreation.
@@ -110,21 +174,15 @@ void create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* sw
         swapchain->image_format = context->device.swapchain_support.formats[0];
     }
 
-    VkPresentModeKHR present_mode = VK_PRESENT_MODE_FIFO_KHR;
-    for (u32 i = 0; i < context->device.swapchain_support.present_mode_count; ++i) {
-        VkPresentModeKHR mode = context->device.swapchain_support.present_modes[i];
-        if (mode == VK_PRESENT_MODE_MAILBOX_KHR) {
-            present_mode = mode;
-            break;
-        }
-    }
-
     // Requery swapchain support.
     vulkan_device_query_swapchain_support(
         context->device.physical_device,
         context->surface,
         &context->device.swapchain_support);
 
+    const renderer_swapchain_config* config = &context->swapchain_config;
+    VkPresentModeKHR present_mode = present_mode_choose(context, config->present_mode);
+
     // Swapchain extent
     if (context->device.swapchain_support.capabilities.currentExtent.width != UINT32_MAX) {
         swapchain_extent = context->device.swapchain_support.capabilities.currentExtent;
@@ -136,12 +194,22 @@ void create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* sw
     swapchain_extent.width = KCLAMP(swapchain_extent.width, min.width, max.width);
     swapchain_extent.height = KCLAMP(swapchain_extent.height, min.height, max.height);
 
-    u32 image_count = context->device.swapchain_support.capabilities.minImageCount + 1;
-    if (context->device.swapchain_support.capabilities.maxImageCount > 0 && image_count > context->device.swapchain_support.capabilities.maxImageCount) {
-        image_count = context->device.swapchain_support.capabilities.maxImageCount;
+    // One more image than the least allowed by default, so one can be rendered to while another waits to be shown.
+    u32 min_image_count = context->device.swapchain_support.capabilities.minImageCount;
+    u32 max_image_count = context->device.swapchain_support.capabilities.maxImageCount;
+    u32 image_count = config->image_count ? config->image_count : min_image_count + 1;
+    image_count = KMAX(image_count, min_image_count);
+    if (max_image_count > 0 && image_count > max_image_count) {
+        image_count = max_image_count;
     }
+    image_count = KMIN(image_count, VULKAN_MAX_SWAPCHAIN_IMAGES);
 
-    swapchain->max_frames_in_flight = image_count - 1;
+    // Kept once chosen, since the per-frame synchronisation objects are made for it.
+    if (!swapchain->max_frames_in_flight) {
+        u32 frames_in_flight = config->frames_in_flight ? config->frames_in_flight : image_count - 1;
+        swapchain->max_frames_in_flight = (u8)KCLAMP(frames_in_flight, 1, VULKAN_MAX_FRAMES_IN_FLIGHT);
+        KINFO("Swapchain using %u images, %u frames in flight and present mode %u.", image_count, swapchain->max_frames_in_flight, present_mode);
+    }
 
     // Swapchain create info
     VkSwapchainCreateInfoKHR swapchain_create_info = {VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR};
@@ -153,6 +221,17 @@ void create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* sw
     swapchain_create_info.imageArrayLayers = 1;
     swapchain_create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
+    // The images are also copied from and blitted to where allowed, to upscale what is rendered at a lower resolution.
+    VkImageUsageFlags transfer_usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    VkFormatFeatureFlags blit_features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    VkFormatProperties image_format_properties;
+    vkGetPhysicalDeviceFormatProperties(context->device.physical_device, swapchain->image_format.format, &image_format_properties);
+    swapchain->upscale_supported = (context->device.swapchain_support.capabilities.supportedUsageFlags & transfer_usage) == transfer_usage &&
+                                   (image_format_properties.optimalTilingFeatures & blit_features) == blit_features;
+    if (swapchain->upscale_supported) {
+        swapchain_create_info.imageUsage |= transfer_usage;
+    }
+
     // Setup the queue family indices
     if (context->device.graphics_queue_index != context->device.present_queue_index) {
         u32 queueFamilyIndices[] = {
@@ -171,7 +250,7 @@ void create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* sw
     swapchain_create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     swapchain_create_info.presentMode = present_mode;
     swapchain_create_info.clipped = VK_TRUE;
-    swapchain_create_info.oldSwapchain = 0;
+    swapchain_create_info.oldSwapchain = swapchain->handle;
 
     VK_CHECK(vkCreateSwapchainKHR(context->device.logical_device, &swapchain_create_info, context->allocator, &swapchain->handle));
 
@@ -181,6 +260,10 @@ void create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* sw
     // Images
     swapchain->image_count = 0;
     VK_CHECK(vkGetSwapchainImagesKHR(context->device.logical_device, swapchain->handle, &swapchain->image_count, 0));
+    if (swapchain->image_count > VULKAN_MAX_SWAPCHAIN_IMAGES) {
+        KFATAL("The swapchain has %u images, more than the most supported (%u).", swapchain->image_count, VULKAN_MAX_SWAPCHAIN_IMAGES);
+        return;
+    }
     if (!swapchain->render_textures) {
         swapchain->render_textures = (texture*)kallocate(sizeof(texture) * swapchain->image_count, MEMORY_TAG_RENDERER);
         // If creating the array, then the internal texture objects aren't created yet either.
@@ -211,7 +294,7 @@ void create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* sw
             texture_system_resize(&swapchain->render_textures[i], swapchain_extent.width, swapchain_extent.height, false);
         }
     }
-    VkImage swapchain_images[32];
+    VkImage swapchain_images[VULKAN_MAX_SWAPCHAIN_IMAGES];
     VK_CHECK(vkGetSwapchainImagesKHR(context->device.logical_device, swapchain->handle, &swapchain->image_count, swapchain_images));
     for (u32 i = 0; i < swapchain->image_count; ++i) {
         // Update the internal image for each.
@@ -248,6 +331,14 @@ void create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* sw
         swapchain->depth_textures = (texture*)kallocate(sizeof(texture) * swapchain->image_count, MEMORY_TAG_RENDERER);
     }
 
+    // Depth is also sampled where the format allows, to cull against on the next frame.
+    VkImageUsageFlags depth_usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    VkFormatProperties depth_format_properties;
+    vkGetPhysicalDeviceFormatProperties(context->device.physical_device, context->device.depth_format, &depth_format_properties);
+    if (depth_format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) {
+        depth_usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+    }
+
     for (u32 i = 0; i < context->swapchain.image_count; ++i) {
         // Create depth image and its view.
         vulkan_image* image = kallocate(sizeof(vulkan_image), MEMORY_TAG_TEXTURE);
@@ -256,9 +347,10 @@ void create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* sw
             TEXTURE_TYPE_2D,
             swapchain_extent.width,
             swapchain_extent.height,
+            1,
             context->device.depth_format,
             VK_IMAGE_TILING_OPTIMAL,
-            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+            depth_usage,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
             true,
             VK_IMAGE_ASPECT_DEPTH_BIT,
@@ -277,6 +369,22 @@ void create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* sw
             &context->swapchain.depth_textures[i]);
     }
 
+    if (swapchain->upscale_supported) {
+        vulkan_image_create(
+            context,
+            TEXTURE_TYPE_2D,
+            swapchain_extent.width,
+            swapchain_extent.height,
+            1,
+            swapchain->image_format.format,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            false,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            &swapchain->upscale_image);
+    }
+
     KINFO("Swapchain created successfully.");
 }
 
@@ -287,6 +395,9 @@ void destroy(vulkan_context* context, vulkan_swapchain* swapchain) {
         vulkan_image_destroy(context, (vulkan_image*)swapchain->depth_textures[i].internal_data);
         swapchain->depth_textures[i].internal_data = 0;
     }
+    if (swapchain->upscale_image.handle) {
+        vulkan_image_destroy(context, &swapchain->upscale_image);
+    }
 
     // Only destroy the views, not the images, since those are owned by the swapchain and are thus
     // destroyed when it is.
@@ -17,6 +17,8 @@
 #include "renderer/renderer_types.inl"
 #include "containers/freelist.h"
 #include "containers/hashtable.h"
+#include "core/kmutex.h"
+#include "memory/host_allocator.h"
 
 #include <vulkan/vulkan.h>
 
@@ -31,6 +33,113 @@
 
 struct vulkan_context;
 
+/**
+ * @brief The kinds of pool device memory is suballocated from. Buffers and images are kept
+ * in separate blocks, so that bufferImageGranularity never has to be accounted for.
+ */
+typedef enum vulkan_memory_pool_kind {
+    /** @brief Buffers and linearly-tiled images, suballocated from a freelist. */
+    VULKAN_MEMORY_POOL_KIND_LINEAR,
+    /** @brief Optimally-tiled images, suballocated from a freelist. */
+    VULKAN_MEMORY_POOL_KIND_OPTIMAL,
+    /**
+     * @brief Short-lived buffers such as staging buffers, allocated by bumping an offset.
+     * A block's space is reused once everything allocated from it has been freed.
+     */
+    VULKAN_MEMORY_POOL_KIND_TRANSIENT,
+    /** @brief The number of pool kinds. */
+    VULKAN_MEMORY_POOL_KIND_COUNT
+} vulkan_memory_pool_kind;
+
+/** @brief A large block of device memory which allocations are carved out of. */
+typedef struct vulkan_memory_block {
+    /** @brief The device memory of the block. */
+    VkDeviceMemory memory;
+    /** @brief The size of the block in bytes. */
+    u64 size;
+    /** @brief The index of the memory type the block was allocated from. */
+    u32 memory_type;
+    /** @brief The kind of pool the block belongs to. */
+    vulkan_memory_pool_kind kind;
+    /** @brief The block, mapped for its whole lifetime if its memory is host visible; otherwise 0. */
+    void* mapped;
+    /** @brief The number of allocations currently made from the block. */
+    u32 allocation_count;
+    /** @brief For transient blocks, the offset the next allocation may start at. */
+    u64 linear_offset;
+    /** @brief For other blocks, the free ranges of the block, in granules. */
+    freelist granules;
+    /** @brief The memory backing the freelist. */
+    void* freelist_memory;
+    /** @brief The size of the memory backing the freelist. */
+    u64 freelist_memory_requirement;
+} vulkan_memory_block;
+
+/** @brief A range of device memory given to a buffer or image. */
+typedef struct vulkan_memory_allocation {
+    /** @brief The device memory holding the range. Shared with other allocations unless dedicated. */
+    VkDeviceMemory memory;
+    /** @brief The offset of the range within the memory, which resources are bound at. */
+    u64 offset;
+    /** @brief The size of the range in bytes. */
+    u64 size;
+    /** @brief The range, mapped, if its memory is host visible; otherwise 0. */
+    void* mapped;
+    /** @brief The index of the memory type the range was allocated from. */
+    u32 memory_type;
+    /** @brief The block the range was carved out of, or 0 if it has device memory of its own. */
+    vulkan_memory_block* block;
+    /** @brief The offset of the space reserved for the range in its block, including alignment padding. */
+    u64 reserved_offset;
+    /** @brief The size of the space reserved for the range in its block, including alignment padding. */
+    u64 reserved_size;
+} vulkan_memory_allocation;
+
+/** @brief How much of a memory heap is in use. */
+typedef struct vulkan_memory_heap_usage {
+    /** @brief The bytes of device memory allocated from the heap. */
+    u64 allocated_size;
+    /** @brief The bytes given to buffers and images, out of those allocated. */
+    u64 used_size;
+    /** @brief The number of device memory allocations made from the heap. */
+    u32 allocation_count;
+    /** @brief The id of the gauge of allocated bytes. */
+    u32 allocated_counter;
+    /** @brief The id of the gauge of used bytes. */
+    u32 used_counter;
+    /** @brief The bytes of the heap in use by this and every other process, as last queried. */
+    u64 usage_size;
+    /** @brief The bytes of the heap this process can use without harm to performance or stability, as last queried. */
+    u64 budget_size;
+    /** @brief The id of the gauge of bytes in use by every process. */
+    u32 usage_counter;
+    /** @brief The id of the gauge of budgeted bytes. */
+    u32 budget_counter;
+} vulkan_memory_heap_usage;
+
+/**
+ * @brief Suballocates buffers and images from large blocks of device memory, one set of
+ * blocks per memory type and pool kind, so that few device allocations are made.
+ */
+typedef struct vulkan_memory_allocator {
+    /** @brief Guards the blocks and usage. */
+    kmutex lock;
+    /** @brief The blocks of each memory type and pool kind. @note darrays of pointers, so allocations can keep them. */
+    vulkan_memory_block** blocks[VK_MAX_MEMORY_TYPES][VULKAN_MEMORY_POOL_KIND_COUNT];
+    /** @brief The size of the blocks of each memory type. */
+    u64 block_sizes[VK_MAX_MEMORY_TYPES];
+    /** @brief The usage of each memory heap. */
+    vulkan_memory_heap_usage heaps[VK_MAX_MEMORY_HEAPS];
+    /** @brief The number of device memory allocations, which must stay under maxMemoryAllocationCount. */
+    u32 device_allocation_count;
+    /** @brief The id of the gauge of device memory allocations. */
+    u32 device_allocations_counter;
+    /** @brief The pressure on device-local memory, as of the last budget update. */
+    renderer_memory_pressure pressure;
+    /** @brief The fraction of its budget the fullest device-local heap used, as of the last budget update. */
+    f32 pressure_used;
+} vulkan_memory_allocator;
+
 /**
  * @brief Represents a Vulkan-specific buffer.
  * Used to load data onto the GPU.
@@ -43,7 +152,7 @@ typedef struct vulkan_buffer {
     /** @brief Indicates if the buffer's memory is currently locked. */
     b8 is_locked;
     /** @brief The memory used by the buffer. */
-    VkDeviceMemory memory;
+    vulkan_memory_allocation allocation;
     /** @brief The memory requirements for this buffer. */
     VkMemoryRequirements memory_requirements;
     /** @brief The index of the memory used by the buffer. */
@@ -97,6 +206,27 @@ typedef struct vulkan_device {
     i32 transfer_queue_index;
     /** @brief Indicates if the device supports a memory type that is both host visible and device local. */
     b8 supports_device_local_host_visible;
+    /** @brief Indicates if the descriptor indexing features the bindless texture table needs are supported and enabled. */
+    b8 supports_bindless;
+    /** @brief Indicates if timeline semaphores are supported and enabled, so queue progress is waited on by value rather than with fences. */
+    b8 supports_timeline_semaphores;
+    /** @brief Indicates if VK_KHR_dynamic_rendering is supported and enabled, so renderpasses need no render pass or framebuffer objects. */
+    b8 supports_dynamic_rendering;
+    /** @brief Begins dynamic rendering. Only set if supported. */
+    PFN_vkCmdBeginRenderingKHR cmd_begin_rendering;
+    /** @brief Ends dynamic rendering. Only set if supported. */
+    PFN_vkCmdEndRenderingKHR cmd_end_rendering;
+    /** @brief Indicates if VK_KHR_present_id and VK_KHR_present_wait are supported and enabled, so the CPU can wait for a presented frame to reach the display. */
+    b8 supports_present_wait;
+    /** @brief Waits for a present to reach the display. Only set if supported. */
+    PFN_vkWaitForPresentKHR wait_for_present;
+    /** @brief Indicates if VK_EXT_memory_budget is supported and enabled, so the budget and usage of each heap can be queried. */
+    b8 supports_memory_budget;
+    /**
+     * @brief Indicates if VK_EXT_mesh_shader is available. Not yet enabled, as shaders have no task or
+     * mesh stages, so meshlets are culled by the cull shader and drawn indirectly instead.
+     */
+    b8 mesh_shader_available;
 
     /** @brief A handle to a graphics queue. */
     VkQueue graphics_queue;
@@ -107,6 +237,8 @@ typedef struct vulkan_device {
 
     /** @brief A handle to a command pool for graphics operations. */
     VkCommandPool graphics_command_pool;
+    /** @brief A handle to a command pool for transfer operations, used by uploads which complete asynchronously. */
+    VkCommandPool transfer_command_pool;
 
     /** @brief The physical device properties. */
     VkPhysicalDeviceProperties properties;
@@ -119,6 +251,9 @@ typedef struct vulkan_device {
     VkFormat depth_format;
     /** @brief The chosen depth format's number of channels.*/
     u8 depth_channel_count;
+
+    /** @brief Indicates, for each texture format, if textures can be sampled in it. */
+    b8 texture_format_support[TEXTURE_FORMAT_COUNT];
 } vulkan_device;
 
 /**
@@ -130,7 +265,7 @@ typedef struct vulkan_image {
     /** @brief The handle to the internal image object. */
     VkImage handle;
     /** @brief The memory used by the image. */
-    VkDeviceMemory memory;
+    vulkan_memory_allocation allocation;
     /** @brief The view for the image, which is used to access the image. */
     VkImageView view;
     /** @brief The GPU memory requirements for this image. */
@@ -141,6 +276,8 @@ typedef struct vulkan_image {
     u32 width;
     /** @brief The image height. */
     u32 height;
+    /** @brief The number of mip levels in the image. */
+    u32 mip_levels;
 } vulkan_image;
 
 /** @brief Represents the possible states of a renderpass. */
@@ -159,12 +296,46 @@ typedef enum vulkan_render_pass_state {
     NOT_ALLOCATED
 } vulkan_render_pass_state;
 
+/** @brief The most attachments a renderpass may have. */
+#define VULKAN_RENDERPASS_MAX_ATTACHMENTS 8
+
+/**
+ * @brief How a renderpass uses one of its attachments, from which the attachment's layout
+ * transitions are recorded when rendering dynamically.
+ */
+typedef struct vulkan_renderpass_attachment {
+    /** @brief The format of the attachment. */
+    VkFormat format;
+    /** @brief What happens to the attachment's contents when the renderpass begins. */
+    VkAttachmentLoadOp load_op;
+    /** @brief What happens to the attachment's contents when the renderpass ends. */
+    VkAttachmentStoreOp store_op;
+    /** @brief The layout the attachment is in when the renderpass begins. */
+    VkImageLayout initial_layout;
+    /** @brief The layout the attachment is left in when the renderpass ends. */
+    VkImageLayout final_layout;
+    /** @brief Indicates if this is the depth attachment, rather than a colour attachment. */
+    b8 is_depth;
+} vulkan_renderpass_attachment;
+
 /**
  * @brief A representation of the Vulkan renderpass.
  */
 typedef struct vulkan_renderpass {
-    /** @brief The internal renderpass handle. */
+    /** @brief The internal renderpass handle. 0 if rendering dynamically. */
     VkRenderPass handle;
+    /** @brief The number of attachments, in the order of the render target's. */
+    u32 attachment_count;
+    /** @brief How each attachment is used. */
+    vulkan_renderpass_attachment attachments[VULKAN_RENDERPASS_MAX_ATTACHMENTS];
+    /** @brief The number of colour attachments. */
+    u32 colour_attachment_count;
+    /** @brief The formats of the colour attachments, which pipelines drawing in the renderpass are created for. */
+    VkFormat colour_formats[VULKAN_RENDERPASS_MAX_ATTACHMENTS];
+    /** @brief The format of the depth attachment, or VK_FORMAT_UNDEFINED if there is none. */
+    VkFormat depth_format;
+    /** @brief The render target the renderpass is currently rendering to, if rendering dynamically. */
+    struct render_target* current_target;
     /** @brief The current render area of the renderpass. */
 
     /** @brief The depth clear value. */
@@ -174,8 +345,32 @@ typedef struct vulkan_renderpass {
 
     /** @brief Indicates renderpass state. */
     vulkan_render_pass_state state;
+
+    /** @brief The index of the timestamp query pair timing the current execution of this renderpass, or INVALID_ID if it is not being timed. */
+    u32 timestamp_index;
 } vulkan_renderpass;
 
+/** @brief The most renderpass executions which can be timed on the GPU in a single frame. */
+#define VULKAN_MAX_TIMED_RENDERPASSES 32
+
+/**
+ * @brief The GPU timestamp queries for the renderpasses recorded in one frame in flight.
+ */
+typedef struct vulkan_timestamp_frame {
+    /** @brief The pool holding a begin and an end timestamp for each timed renderpass execution. */
+    VkQueryPool pool;
+    /** @brief The renderpass each pair of timestamps belongs to. Cleared when that renderpass is destroyed. */
+    renderpass* passes[VULKAN_MAX_TIMED_RENDERPASSES];
+    /** @brief The number of renderpass executions timed in the frame. */
+    u32 pass_count;
+} vulkan_timestamp_frame;
+
+/** @brief The most frames which may be in flight at once. Resources kept per frame in flight have this many copies. */
+#define VULKAN_MAX_FRAMES_IN_FLIGHT 2
+
+/** @brief The most images a swapchain may have. */
+#define VULKAN_MAX_SWAPCHAIN_IMAGES 8
+
 /**
  * @brief Representation of the Vulkan swapchain.
  */
@@ -184,7 +379,7 @@ typedef struct vulkan_swapchain {
     VkSurfaceFormatKHR image_format;
     /**
      * @brief The maximum number of "images in flight" (images simultaneously being rendered to).
-     * Typically one less than the total number of images available.
+     * Configurable; by default one less than the total number of images, up to VULKAN_MAX_FRAMES_IN_FLIGHT.
      */
     u8 max_frames_in_flight;
 
@@ -203,6 +398,14 @@ typedef struct vulkan_swapchain {
      * The images contained in these are created and owned by the swapchain.
      * */
     render_target render_targets[3];
+
+    /**
+     * @brief Indicates if the images can be copied from and blitted to with linear filtering, so what
+     * is rendered at a lower resolution to part of one can be upscaled to the whole of it.
+     */
+    b8 upscale_supported;
+    /** @brief The image the part of a swapchain image being upscaled is copied to first, as it is the size of the swapchain. */
+    vulkan_image upscale_image;
 } vulkan_swapchain;
 
 /**
@@ -235,6 +438,13 @@ typedef struct vulkan_command_buffer {
 
     /** @brief Command buffer state. */
     vulkan_command_buffer_state state;
+
+    /** @brief The geometry heap block whose vertex buffer is bound in it, or INVALID_ID if none is. */
+    u32 bound_geometry_block;
+    /** @brief The index size of the index buffer of that block bound in it, or 0 if none is. */
+    u32 bound_index_size;
+    /** @brief The pipeline layout the vertex set of that block was bound with, for vertex pulling, or 0 if it is not bound. */
+    VkPipelineLayout bound_vertex_set_layout;
 } vulkan_command_buffer;
 
 /**
@@ -300,6 +510,25 @@ typedef struct vulkan_pipeline {
  * @todo TODO: make configurable
  */
 #define VULKAN_MAX_MATERIAL_COUNT 1024
+/** @brief The max number of instances of a bindless shader, which need no descriptor sets of their own. */
+#define VULKAN_BINDLESS_MAX_MATERIAL_COUNT 16384
+/** @brief The max number of textures in the bindless texture table, if the device allows that many. */
+#define VULKAN_BINDLESS_MAX_TEXTURES 65536
+/** @brief The size in bytes of each frame's region of the frame uniform arena, which per-draw local uniforms are written to. */
+#define VULKAN_FRAME_UNIFORM_ARENA_SIZE (4 * 1024 * 1024)
+/** @brief The max size in bytes of a shader's local uniform buffer object, which is the range of the arena each draw sees. */
+#define VULKAN_SHADER_MAX_LOCAL_UBO_SIZE 1024
+/** @brief The number of sets each pool of transient descriptor sets holds. */
+#define VULKAN_TRANSIENT_DESCRIPTOR_POOL_SETS 256
+/**
+ * @brief The number of frames in a row an instance's samplers must be rewritten for it to be taken to
+ * change every frame, and drawn with transient sets. More than the sets of its own which one change
+ * rewrites, one frame after another. Also the number of frames in a row without changes for it to
+ * go back to its own sets.
+ */
+#define VULKAN_TRANSIENT_SET_STREAK 8
+/** @brief The max number of distinct samplers shared between texture maps. */
+#define VULKAN_MAX_SAMPLERS 256
 
 /**
  * @brief Max number of simultaneously uploaded geometries
@@ -307,6 +536,24 @@ typedef struct vulkan_pipeline {
  */
 #define VULKAN_MAX_GEOMETRY_COUNT 4096
 
+/** @brief The most blocks the geometry heap chains, each with a vertex buffer and an index buffer for each index size. */
+#define VULKAN_MAX_GEOMETRY_BLOCKS 8
+/** @brief The size in bytes of the vertex buffer of each geometry block, unless a geometry needs more. */
+#define VULKAN_GEOMETRY_BLOCK_VERTEX_BUFFER_SIZE (sizeof(vertex_3d) * 1024 * 1024)
+/** @brief The size in bytes of the 32-bit index buffer of each geometry block, unless a geometry needs more. */
+#define VULKAN_GEOMETRY_BLOCK_INDEX_BUFFER_SIZE (sizeof(u32) * 1024 * 1024)
+/** @brief The size in bytes of the 16-bit index buffer of each geometry block, unless a geometry needs more. */
+#define VULKAN_GEOMETRY_BLOCK_INDEX_BUFFER_16_SIZE (sizeof(u16) * 2 * 1024 * 1024)
+/** @brief The most bytes of geometry compaction moves each frame. */
+#define VULKAN_GEOMETRY_COMPACTION_FRAME_BYTES MEBIBYTES(4)
+/** @brief The fraction of a geometry block in use below which compaction moves what is left in it to the others. */
+#define VULKAN_GEOMETRY_COMPACTION_MAX_USE 0.5f
+/** @brief The frames between looks for a geometry block to compact. */
+#define VULKAN_GEOMETRY_COMPACTION_INTERVAL 60
+
+/** @brief The most geometries each frame may draw through batches. */
+#define VULKAN_MAX_BATCHED_DRAWS 16384
+
 /**
  * @brief Internal buffer data for geometry. This data gets loaded
  * directly into a buffer.
@@ -320,16 +567,324 @@ typedef struct vulkan_geometry_data {
     u32 vertex_count;
     /** @brief The size of each vertex. */
     u32 vertex_element_size;
-    /** @brief The offset in bytes in the vertex buffer. */
+    /** @brief The block of the geometry heap whose buffers hold both the vertices and the indices. */
+    u32 block;
+    /** @brief The offset in bytes in the vertex buffer, which is a multiple of the vertex size. */
     u64 vertex_buffer_offset;
+    /** @brief The offset of the range allocated from the vertex buffer, which the vertices are aligned within. */
+    u64 vertex_allocation_offset;
+    /** @brief The size of the range allocated from the vertex buffer. */
+    u64 vertex_allocation_size;
     /** @brief The index count. */
     u32 index_count;
-    /** @brief The size of each index. */
+    /** @brief The size of each index, which is also which of the index buffers they are in. */
     u32 index_element_size;
     /** @brief The offset in bytes in the index buffer. */
     u64 index_buffer_offset;
+    /** @brief Indicates if the data is still being uploaded on the transfer queue, in which case the geometry is not drawn. */
+    b8 upload_pending;
+    /** @brief Indicates if compaction is copying the data to another block, from which it is drawn once the copies complete. */
+    b8 move_pending;
+    /** @brief The serial of the frame the data was last written in. Compaction moves it only once that frame completes. */
+    u64 upload_serial;
+    /** @brief The index of the geometry's skin, whose vertices are skinned into its own, or INVALID_ID if it has none. */
+    u32 skin_index;
 } vulkan_geometry_data;
 
+/**
+ * @brief A block of the geometry heap, which geometries are allocated from. The vertices and indices of a
+ * geometry are always in the same block, so it is drawn with that block's buffers bound.
+ */
+typedef struct vulkan_geometry_block {
+    /** @brief The vertex buffer. Has no internal data if the block is not in use. */
+    renderbuffer vertex_buffer;
+    /** @brief The index buffer used to hold the 32-bit indices of geometries with too many vertices for 16-bit ones. */
+    renderbuffer index_buffer;
+    /** @brief The index buffer used to hold 16-bit geometry indices. */
+    renderbuffer index_buffer_16;
+    /** @brief The set holding the vertex buffer as a storage buffer, for shaders pulling their vertices from it. */
+    VkDescriptorSet vertex_set;
+} vulkan_geometry_block;
+
+/** @brief The data of one draw of a batch, read by shaders from the draw data buffer by instance index. Matches std430 layout. */
+typedef struct vulkan_draw_data {
+    /** @brief The model matrix. */
+    mat4 model;
+    /** @brief Non-zero if the geometry is highlighted. */
+    u32 highlight;
+    /**
+     * @brief Where the uniforms of the draw's instance start in its shader's uniform buffer, in 16-byte units.
+     * Bindless shaders read them from there, as a material table. 0 for other shaders.
+     */
+    u32 material;
+    /** @brief The stride of the geometry's vertices in bytes, for shaders pulling them from the vertex buffer. */
+    u32 vertex_stride;
+    /** @brief Pads the extents to 16 bytes, as vec3 is aligned in std430. */
+    u32 padding;
+    /** @brief The minimum extents of the geometry, in model space. Read by the cull shader. */
+    vec3 extents_min;
+    /** @brief Pads the extents to 16 bytes. */
+    f32 extents_min_padding;
+    /** @brief The maximum extents of the geometry, in model space. Read by the cull shader. */
+    vec3 extents_max;
+    /** @brief Pads the cone to 16 bytes. */
+    f32 extents_max_padding;
+    /**
+     * @brief The normal cone of a meshlet, in model space: its axis, then its cutoff, as in geometry_meshlet.
+     * Read by the cull shader. A cutoff of 1 for draws which are never facing away as a whole.
+     */
+    vec4 cone;
+} vulkan_draw_data;
+
+/**
+ * @brief The state for drawing geometries in batches. Each frame in flight has a region of the draw
+ * data and indirect buffers, filled from the start of the frame, and a descriptor set pointing at its
+ * region of the draw data buffer.
+ */
+typedef struct vulkan_draw_batch {
+    /** @brief The most draws each frame may batch. */
+    u32 capacity;
+    /** @brief The number of draws batched so far this frame. */
+    u32 used;
+    /** @brief Holds draw data for each frame in flight, one region after another. */
+    renderbuffer draw_data_buffer;
+    /** @brief Holds indirect draw commands for each frame in flight, one region after another. */
+    renderbuffer indirect_buffer;
+    /** @brief The mapped draw data buffer. */
+    vulkan_draw_data* draw_data;
+    /** @brief The mapped indirect buffer. */
+    VkDrawIndexedIndirectCommand* commands;
+    /** @brief The layout of the draw data set, appended to the sets of shaders taking draw data. */
+    VkDescriptorSetLayout set_layout;
+    /** @brief The pool the draw data sets come from. */
+    VkDescriptorPool descriptor_pool;
+    /** @brief The draw data set of each frame in flight. */
+    VkDescriptorSet descriptor_sets[2];
+    /** @brief The pipeline layout the current frame's draw data set was last bound with, so it is not bound again. 0 if not yet. */
+    VkPipelineLayout bound_layout;
+    /** @brief Indicates if draws can be issued from the indirect buffer many at a time, starting at any instance. */
+    b8 multi_draw_indirect;
+    /** @brief The id of the counter of draws issued in batches. */
+    u32 batched_draws_counter;
+    /** @brief The id of the counter of geometries drawn as instances of draws of more than one. */
+    u32 instanced_draws_counter;
+    /** @brief The id of the counter of meshlets drawn, each as a draw of its own. */
+    u32 meshlet_draws_counter;
+    /** @brief The first slot and slot count of each run of the batches being recorded in parallel. darray. */
+    u32* run_slots;
+} vulkan_draw_batch;
+
+/**
+ * @brief The parameters the cull shader reads for one frame, starting with the dispatch which runs it.
+ * Matches std430 layout.
+ */
+typedef struct vulkan_cull_params {
+    /** @brief The workgroup counts of the indirect dispatch of the cull shader. */
+    u32 dispatch[3];
+    /** @brief The number of batched draws to cull. */
+    u32 draw_count;
+    /** @brief The projection the draws are culled against the frustum of. */
+    mat4 projection;
+    /** @brief The view the draws are culled against the frustum of. */
+    mat4 view;
+    /** @brief The projection the depth pyramid was drawn with, which was the last frame's. */
+    mat4 occlusion_projection;
+    /** @brief The view the depth pyramid was drawn with, which was the last frame's. */
+    mat4 occlusion_view;
+    /** @brief The size of the first level of the depth pyramid, in texels. */
+    f32 pyramid_size[2];
+    /** @brief The number of levels of the depth pyramid. */
+    u32 pyramid_level_count;
+    /** @brief Non-zero if draws are also culled against the depth pyramid. */
+    u32 occlusion_enabled;
+    /** @brief The fraction of the depth's width and height, from its top left, the last frame was rendered to. */
+    f32 occlusion_scale;
+} vulkan_cull_params;
+
+/** @brief The most levels a depth pyramid may have. */
+#define VULKAN_MAX_DEPTH_PYRAMID_LEVELS 16
+
+/**
+ * @brief GPU culling of batched draws. At the start of each frame, a depth pyramid is built from the
+ * depth of the last frame, then a compute shader clears the instance count of each batched draw of
+ * the frame which is outside the frustum or behind the pyramid. The draws are recorded after it, but
+ * written to mapped memory before the frame is submitted, so are in place by the time it runs.
+ */
+typedef struct vulkan_cull_state {
+    /** @brief Indicates if culling runs. It needs batches drawn indirectly, and its shaders. */
+    b8 enabled;
+    /** @brief Indicates if the depth format can be sampled, without which draws are only culled against the frustum. */
+    b8 occlusion_supported;
+    /** @brief The pipeline of the cull shader. */
+    vulkan_pipeline cull_pipeline;
+    /** @brief The pipeline building a level of the depth pyramid. */
+    vulkan_pipeline pyramid_pipeline;
+    /** @brief The layout of the cull shader's set. */
+    VkDescriptorSetLayout cull_set_layout;
+    /** @brief The layout of the depth pyramid shader's set. */
+    VkDescriptorSetLayout pyramid_set_layout;
+    /**
+     * @brief The pool of the cull and depth pyramid sets, which refer to the pyramid and so are remade
+     * with the swapchain. The old pool is deleted once the frames which may use its sets complete.
+     */
+    VkDescriptorPool pyramid_descriptor_pool;
+    /** @brief The cull set of each frame in flight. */
+    VkDescriptorSet cull_sets[VULKAN_MAX_FRAMES_IN_FLIGHT];
+    /** @brief The sets building the first level of the pyramid from each depth texture of the swapchain. */
+    VkDescriptorSet depth_sets[VULKAN_MAX_SWAPCHAIN_IMAGES];
+    /** @brief The sets building each level of the pyramid after the first, from the level before it. */
+    VkDescriptorSet level_sets[VULKAN_MAX_DEPTH_PYRAMID_LEVELS];
+    /** @brief The sampler the pyramid and depth are read with. */
+    VkSampler sampler;
+    /** @brief The depth pyramid, which stays in the general layout. Its view covers every level. */
+    vulkan_image pyramid;
+    /** @brief A view of each level of the pyramid. */
+    VkImageView level_views[VULKAN_MAX_DEPTH_PYRAMID_LEVELS];
+    /** @brief Indicates if the pyramid has been moved to the general layout since it was created. */
+    b8 pyramid_ready;
+    /** @brief Holds the parameters of each frame in flight, one aligned region after another. */
+    renderbuffer params_buffer;
+    /** @brief The size of each frame's region of the parameters buffer. */
+    u64 params_stride;
+    /** @brief The mapped parameters buffer. */
+    u8* params;
+    /** @brief Indicates if the view to cull against was set this frame. */
+    b8 view_set;
+    /** @brief Indicates if the depth of the last frame can be culled against. */
+    b8 previous_depth_valid;
+    /** @brief The index of the depth texture of the last frame. */
+    u32 previous_depth_index;
+    /** @brief The projection of the last frame. */
+    mat4 previous_projection;
+    /** @brief The view of the last frame. */
+    mat4 previous_view;
+    /** @brief The resolution scale of the last frame. */
+    f32 previous_scale;
+} vulkan_cull_state;
+
+/** @brief The most geometries which may have skins at once. */
+#define VULKAN_MAX_SKINS 1024
+/** @brief The most joints of every palette of a frame, across all of its skinned geometries. */
+#define VULKAN_MAX_SKIN_JOINTS_PER_FRAME 16384
+
+/** @brief The skin of a geometry: its vertices in the bind pose, which are skinned into its own each frame it is posed. */
+typedef struct vulkan_skin {
+    /** @brief The internal id of the geometry, or INVALID_ID if the skin is free. */
+    u32 geometry_id;
+    /** @brief The number of vertices. */
+    u32 vertex_count;
+    /** @brief Holds the vertices in the bind pose, as vertex_3d_skinned. */
+    renderbuffer source_buffer;
+    /** @brief The set of the source vertices and the palette buffer. */
+    VkDescriptorSet set;
+} vulkan_skin;
+
+/** @brief The push constants of the skinning shader. */
+typedef struct vulkan_skinning_push_constants {
+    /** @brief The number of vertices. */
+    u32 vertex_count;
+    /** @brief The first joint of the geometry's palette in the palette buffer. */
+    u32 first_joint;
+    /** @brief The first 4-byte word of the geometry's vertices in the vertex buffer of its block. */
+    u32 first_word;
+    /** @brief The number of joints in the palette. */
+    u32 joint_count;
+} vulkan_skinning_push_constants;
+
+/**
+ * @brief GPU skinning of geometries. Each frame, the palettes of the geometries posed in it are written
+ * to mapped memory, and a compute shader skins each one's vertices from the bind pose into its own
+ * range of its block's vertex buffer, before any renderpass. Skinned geometries are then drawn by every
+ * shader as any other.
+ */
+typedef struct vulkan_skinning_state {
+    /** @brief Indicates if skinning runs. It needs its shader. */
+    b8 enabled;
+    /** @brief The pipeline of the skinning shader. Its sets are a skin's, then the vertex set of the block. */
+    vulkan_pipeline pipeline;
+    /** @brief The layout of the set of each skin. */
+    VkDescriptorSetLayout set_layout;
+    /** @brief The pool the sets of skins come from. */
+    VkDescriptorPool descriptor_pool;
+    /** @brief The skins. */
+    vulkan_skin skins[VULKAN_MAX_SKINS];
+    /** @brief Holds the palettes of each frame in flight, one region after another. */
+    renderbuffer palette_buffer;
+    /** @brief The mapped palette buffer. */
+    mat4* palettes;
+    /** @brief The number of joints written to the current frame's region. */
+    u32 joints_used;
+} vulkan_skinning_state;
+
+/**
+ * @brief A geometry upload on the transfer queue, or a move of a geometry to another block by compaction,
+ * which is finished once the fence of its batch is signalled.
+ */
+typedef struct vulkan_geometry_upload {
+    /** @brief The internal id of the geometry being uploaded. */
+    u32 geometry_id;
+    /** @brief The ranges being uploaded to, which the geometry takes once the upload is complete. */
+    vulkan_geometry_data range;
+    /** @brief The index of the upload batch holding the copies. */
+    u32 batch_index;
+    /**
+     * @brief The staging buffer holding the vertex data, followed by the index data. Has no internal data
+     * for a move, which copies from the ranges the geometry has.
+     */
+    renderbuffer staging;
+} vulkan_geometry_upload;
+
+/**
+ * @brief The uploads recorded during one frame, whose copies are submitted to the transfer queue
+ * together, as one command buffer. Images copied there are handed over to the graphics queue, which
+ * acquires them in a command buffer of its own waiting on the copies. With timeline semaphores, the
+ * submission signals the transfer timeline with the batch's value; otherwise, its fence and semaphore.
+ */
+typedef struct vulkan_upload_batch {
+    /** @brief The command buffer the uploads' copies are recorded into. */
+    vulkan_command_buffer command_buffer;
+    /** @brief Signalled when the copies are complete. Only created without timeline semaphores. */
+    VkFence fence;
+    /** @brief Signalled when the copies are complete, for the graphics queue to acquire images after. Only created without timeline semaphores. */
+    VkSemaphore semaphore;
+    /** @brief The value the transfer timeline reaches once the copies last submitted are complete. */
+    uint64_t timeline_value;
+    /** @brief The graphics command buffer acquiring the batch's images and finishing them, if any are being uploaded. */
+    vulkan_command_buffer acquire_command_buffer;
+    /** @brief Indicates if copies have been recorded which are not yet submitted. */
+    b8 recording;
+    /** @brief Indicates if the copies were submitted and have not yet been seen to complete. */
+    b8 submitted;
+} vulkan_upload_batch;
+
+/** @brief The part of the staging ring used by one frame in flight. */
+typedef struct vulkan_staging_region {
+    /** @brief The offset of the region within the ring's buffer. */
+    u64 offset;
+    /** @brief The bytes of the region taken by uploads since it was last recycled. */
+    u64 used;
+    /** @brief The command buffer the uploads' copies are recorded into. */
+    vulkan_command_buffer command_buffer;
+    /** @brief Indicates if copies have been recorded which are not yet submitted. */
+    b8 recording;
+    /** @brief Indicates if the copies were submitted with a frame whose fence has not yet been seen. */
+    b8 submitted;
+} vulkan_staging_region;
+
+/**
+ * @brief A persistently-mapped staging buffer, split into one region per frame in flight. Uploads
+ * take space in the current frame's region and record their copies for submission ahead of the
+ * frame's commands. A region is recycled once the frame it was submitted with has completed.
+ */
+typedef struct vulkan_staging_ring {
+    /** @brief The staging buffer holding every region. */
+    renderbuffer buffer;
+    /** @brief The size of each region. */
+    u64 region_size;
+    /** @brief The regions, one per frame in flight. */
+    vulkan_staging_region regions[2];
+} vulkan_staging_ring;
+
 /**
  * @brief Max number of UI control instances
  * @todo TODO: make configurable
@@ -357,8 +912,12 @@ typedef struct vulkan_geometry_data {
  */
 #define VULKAN_SHADER_MAX_UNIFORMS 128
 
-/** @brief The maximum number of bindings per descriptor set. */
+/** @brief The maximum number of bindings per uniform descriptor set: a uniform buffer and samplers. */
 #define VULKAN_SHADER_MAX_BINDINGS 2
+/** @brief The maximum number of bindings in the storage descriptor set, one per storage buffer or image. */
+#define VULKAN_SHADER_MAX_STORAGE_BINDINGS 8
+/** @brief The maximum number of descriptor sets of a shader: global, instance and storage. */
+#define VULKAN_SHADER_MAX_DESCRIPTOR_SETS 3
 /** @brief The maximum number of push constant ranges for a shader. */
 #define VULKAN_SHADER_MAX_PUSH_CONST_RANGES 32
 
@@ -379,8 +938,8 @@ typedef struct vulkan_shader_stage_config {
 typedef struct vulkan_descriptor_set_config {
     /** @brief The number of bindings in this set. */
     u8 binding_count;
-    /** @brief An array of binding layouts for this set. */
-    VkDescriptorSetLayoutBinding bindings[VULKAN_SHADER_MAX_BINDINGS];
+    /** @brief An array of binding layouts for this set. The storage set may use all of them; the others, the first two. */
+    VkDescriptorSetLayoutBinding bindings[VULKAN_SHADER_MAX_STORAGE_BINDINGS];
     /** @brief The index of the sampler binding. */
     u8 sampler_binding_index;
 } vulkan_descriptor_set_config;
@@ -391,21 +950,20 @@ typedef struct vulkan_shader_config {
     u8 stage_count;
     /** @brief  The configuration for every stage of this shader. */
     vulkan_shader_stage_config stages[VULKAN_SHADER_MAX_STAGES];
-    /** @brief An array of descriptor pool sizes. */
-    VkDescriptorPoolSize pool_sizes[2];
-    /**
-     * @brief The max number of descriptor sets that can be allocated from this shader.
-     * Should typically be a decently high number.
-     */
-    u16 max_descriptor_set_count;
+    /** @brief The number of descriptor pool sizes, one per descriptor type the shader uses. */
+    u8 pool_size_count;
+    /** @brief An array of descriptor pool sizes, enough for the global, storage and instance sets of every instance. */
+    VkDescriptorPoolSize pool_sizes[5];
+    /** @brief The max number of descriptor sets that can be allocated from this shader. */
+    u32 max_descriptor_set_count;
 
     /**
      * @brief The total number of descriptor sets configured for this shader.
-     * Is 1 if only using global uniforms/samplers; otherwise 2.
+     * Is 1 if only using global uniforms/samplers; otherwise 2, plus 1 if it has storage bindings.
      */
     u8 descriptor_set_count;
-    /** @brief Descriptor sets, max of 2. Index 0=global, 1=instance */
-    vulkan_descriptor_set_config descriptor_sets[2];
+    /** @brief Descriptor sets, max of 3. Index 0=global, 1=instance, then the storage set. */
+    vulkan_descriptor_set_config descriptor_sets[VULKAN_SHADER_MAX_DESCRIPTOR_SETS];
 
     /** @brief An array of attribute descriptions for this shader. */
     VkVertexInputAttributeDescription attributes[VULKAN_SHADER_MAX_ATTRIBUTES];
@@ -421,12 +979,157 @@ typedef struct vulkan_shader_config {
  * per frame (with a max of 3).
  */
 typedef struct vulkan_descriptor_state {
-    /** @brief The descriptor generation, per frame. */
-    u8 generations[3];
+    /** @brief The descriptor generation, per frame. Typically the generation of the texture written. */
+    u32 generations[3];
     /** @brief The identifier, per frame. Typically used for texture ids. */
     u32 ids[3];
+    /** @brief The sampler written, per frame, for sampler descriptors. */
+    VkSampler samplers[3];
 } vulkan_descriptor_state;
 
+/**
+ * @brief An entry of the bindless texture table written for an instance texture. The entry
+ * is never rewritten, as frames in flight may be sampling it; a changed texture or sampler
+ * is written to a new entry instead, and the old one freed once those frames complete.
+ */
+typedef struct vulkan_bindless_slot {
+    /** @brief The index of the entry in the table, or INVALID_ID if none is written yet. */
+    u32 index;
+    /** @brief The view of the texture written. */
+    VkImageView view;
+    /** @brief The sampler written. */
+    VkSampler sampler;
+    /** @brief The generation of the texture written. */
+    u32 generation;
+} vulkan_bindless_slot;
+
+/**
+ * @brief The bindless texture table: one large, partially bound array of combined image samplers
+ * shared by every bindless shader, indexed by entries of their instance uniform buffers.
+ * Entries are written while the set is bound, as update-after-bind allows for those not in use.
+ */
+typedef struct vulkan_bindless_textures {
+    /** @brief The number of entries in the table. 0 if the device does not support bindless textures. */
+    u32 capacity;
+    /** @brief The number of entries ever handed out. Entries past this have never been used. */
+    u32 used_count;
+    /** @brief Entries freed for reuse. @note darray */
+    u32* free_slots;
+    /** @brief The pool the set is allocated from. */
+    VkDescriptorPool pool;
+    /** @brief The layout of the set, which bindless shaders' pipeline layouts include. */
+    VkDescriptorSetLayout layout;
+    /** @brief The set holding the table, in binding 0. */
+    VkDescriptorSet set;
+} vulkan_bindless_textures;
+
+/** @brief The state a sampler is created with, which texture maps asking for the same state share a sampler by. */
+typedef struct vulkan_sampler_key {
+    VkFilter min_filter;
+    VkFilter mag_filter;
+    VkSamplerAddressMode address_u;
+    VkSamplerAddressMode address_v;
+    VkSamplerAddressMode address_w;
+    VkSamplerMipmapMode mipmap_mode;
+    VkBorderColor border_color;
+    f32 max_anisotropy;
+} vulkan_sampler_key;
+
+/** @brief A sampler shared by every texture map created with its state. */
+typedef struct vulkan_sampler_entry {
+    /** @brief The state the sampler was created with. */
+    vulkan_sampler_key key;
+    /** @brief The sampler, or 0 if the entry is free. */
+    VkSampler sampler;
+    /** @brief The number of texture maps using the sampler. */
+    u32 reference_count;
+} vulkan_sampler_entry;
+
+/**
+ * @brief The samplers of texture maps, one for each distinct state in use. Maps are given the sampler
+ * of an entry with their state if there is one, so most maps share a handful of samplers.
+ */
+typedef struct vulkan_sampler_cache {
+    /** @brief The number of entries holding a sampler. */
+    u32 count;
+    /** @brief The entries. */
+    vulkan_sampler_entry entries[VULKAN_MAX_SAMPLERS];
+} vulkan_sampler_cache;
+
+/**
+ * @brief Descriptor sets which only live for a frame, for instances whose descriptors change every
+ * frame. Each frame in flight allocates from pools of its own, reset wholesale once the frame comes
+ * round again rather than freed set by set, and adds another pool whenever those it has are full.
+ */
+typedef struct vulkan_transient_descriptors {
+    /** @brief The pools of each frame in flight. @note darray */
+    VkDescriptorPool* pools[2];
+    /** @brief The index of the pool each frame in flight is allocating from. */
+    u32 current_pools[2];
+    /** @brief The id of the counter of transient sets allocated. */
+    u32 sets_counter;
+} vulkan_transient_descriptors;
+
+/**
+ * @brief A linear allocator of uniform data which only lives for a frame, such as the local uniforms
+ * of each draw. Each frame in flight has a region of the buffer, filled from the start when the frame
+ * begins, and a set pointing at it which is bound at the dynamic offset of each allocation.
+ */
+typedef struct vulkan_frame_uniform_arena {
+    /** @brief Holds the region of each frame in flight, one after another. */
+    renderbuffer buffer;
+    /** @brief The mapped buffer. */
+    u8* mapped;
+    /** @brief The size in bytes of each frame's region. */
+    u64 region_size;
+    /** @brief The offset in bytes of the next allocation in the current frame's region. */
+    u64 used;
+    /** @brief The alignment of allocations, as required of dynamic uniform buffer offsets. */
+    u64 alignment;
+    /** @brief The layout of the arena set, appended to the sets of shaders with local uniform buffers. */
+    VkDescriptorSetLayout set_layout;
+    /** @brief The pool the arena sets come from. */
+    VkDescriptorPool descriptor_pool;
+    /** @brief The arena set of each frame in flight. */
+    VkDescriptorSet descriptor_sets[2];
+    /** @brief The id of the counter of bytes allocated from the arena. */
+    u32 bytes_counter;
+} vulkan_frame_uniform_arena;
+
+/**
+ * @brief Pixels copied out of textures without waiting for the copy. Each frame in flight has a slot of
+ * the buffer, which a copy made in the frame lands in, and which is read once the frame has completed,
+ * the next time the frame begins.
+ */
+typedef struct vulkan_pixel_readback {
+    /** @brief Holds the slot of each frame in flight, one after another. */
+    renderbuffer buffer;
+    /** @brief The mapped buffer. */
+    u8* mapped;
+    /** @brief For each frame in flight, the serial of the frame whose copy is in its slot, or 0 if none was made. */
+    u64 serials[VULKAN_MAX_FRAMES_IN_FLIGHT];
+} vulkan_pixel_readback;
+
+/** @brief The most threads which may record a renderpass's batched draws at once, each into its own secondary command buffers. */
+#define VULKAN_MAX_RECORDERS 8
+
+/** @brief The fewest batched draws worth recording on a thread of their own. */
+#define VULKAN_RECORDER_MIN_DRAWS 128
+
+/**
+ * @brief Records secondary command buffers on one thread at a time. Command pools may only be used
+ * by one thread at once, so each recorder has its own for each frame in flight, reset when the frame
+ * begins. Secondary command buffers are kept once allocated and reused from frame to frame.
+ */
+typedef struct vulkan_recorder {
+    /** @brief The command pool of each frame in flight. */
+    VkCommandPool pools[2];
+    /** @brief The secondary command buffers allocated from the pool of each frame in flight. darray. */
+    vulkan_command_buffer* command_buffers[2];
+    /** @brief The number of the current frame's command buffers recorded so far. */
+    u32 used;
+} vulkan_recorder;
+
 /**
  * @brief Represents the state for a descriptor set. This is used to track
  * generations and updates, potentially for optimization via skipping
@@ -457,6 +1160,23 @@ typedef struct vulkan_shader_instance_state {
      * are set by calls to set_sampler.
      */
     struct texture_map** instance_texture_maps;
+
+    /** @brief The state of each instance sampler descriptor, so unchanged ones are not written again. Not used by bindless shaders. */
+    vulkan_descriptor_state* sampler_states;
+
+    /** @brief The texture table entry of each instance texture, for bindless shaders. */
+    vulkan_bindless_slot* bindless_slots;
+
+    /** @brief Indicates if the instance changes every frame, so is drawn with a transient set written each frame rather than its own. */
+    b8 transient;
+    /** @brief The number of frames in a row which rewrote its samplers, or while transient, which left them unchanged. */
+    u32 streak;
+    /** @brief The serial of the last frame which rewrote its samplers. */
+    u64 last_rewrite_serial;
+    /** @brief The transient set written for the frame of transient_serial. */
+    VkDescriptorSet transient_set;
+    /** @brief The serial of the frame transient_set was written for. */
+    u64 transient_serial;
 } vulkan_shader_instance_state;
 
 /**
@@ -483,19 +1203,55 @@ typedef struct vulkan_shader {
     /** @brief The descriptor pool used for this shader. */
     VkDescriptorPool descriptor_pool;
 
-    /** @brief Descriptor set layouts, max of 2. Index 0=global, 1=instance. */
-    VkDescriptorSetLayout descriptor_set_layouts[2];
+    /** @brief Descriptor set layouts, max of 3. Index 0=global, 1=instance, then the storage set. */
+    VkDescriptorSetLayout descriptor_set_layouts[VULKAN_SHADER_MAX_DESCRIPTOR_SETS];
     /** @brief Global descriptor sets, one per frame. */
     VkDescriptorSet global_descriptor_sets[3];
+    /** @brief The index of the storage set, following the uniform sets, or INVALID_ID_U8 if there are no storage bindings. */
+    u8 storage_set_index;
+    /** @brief Storage descriptor sets, one per frame, holding the storage buffers and images in configured order. */
+    VkDescriptorSet storage_descriptor_sets[3];
+    /** @brief The bind point of the pipeline: compute for compute shaders, otherwise graphics. */
+    VkPipelineBindPoint bind_point;
+    /** @brief The stages descriptor bindings and push constants are visible to. */
+    VkShaderStageFlags stage_flags;
     /** @brief The uniform buffer used by this shader. */
     renderbuffer uniform_buffer;
 
-    /** @brief The pipeline associated with this shader. */
+    /** @brief The pipeline associated with this shader, which is that of its first variant. */
     vulkan_pipeline pipeline;
-
-    /** @brief The instance states for all instances. @todo TODO: make dynamic */
-    u32 instance_count;
-    vulkan_shader_instance_state instance_states[VULKAN_MAX_MATERIAL_COUNT];
+    /**
+     * @brief The pipelines of the shader's other variants, indexed by variant, so the first is unused.
+     * Their layouts are made the same as that of pipeline, so sets bound with one stay bound for all.
+     */
+    vulkan_pipeline variant_pipelines[SHADER_MAX_VARIANTS];
+
+    /** @brief The instance set of a bindless shader, shared by every instance, whose uniform buffer is bound at each one's dynamic offset. */
+    VkDescriptorSet bindless_instance_set;
+    /** @brief The index of the bindless texture table set, following the shader's own and the draw data set. INVALID_ID_U8 if not bindless. */
+    u8 bindless_set_index;
+    /** @brief The offset in the instance uniform buffer of the texture table index of each instance sampler, for bindless shaders. */
+    u16 bindless_index_offsets[VULKAN_SHADER_MAX_INSTANCE_TEXTURES];
+
+    /** @brief The index of the frame uniform arena set, following all others but the vertex set, or INVALID_ID_U8 if locals are push constants. */
+    u8 local_set_index;
+    /** @brief The index of the vertex set of shaders pulling their vertices, following all others, or INVALID_ID_U8 if they have attributes. */
+    u8 vertex_set_index;
+    /** @brief Holds the local uniforms set since the last draw, copied to the frame uniform arena when applied. */
+    u8* local_block;
+    /** @brief A copy of the uniform buffer, which global and instance uniforms are set in before being copied to it. */
+    u8* uniform_shadow;
+    /** @brief The size in bytes of the uniform buffer and its copy. */
+    u64 uniform_shadow_size;
+    /** @brief The first byte of the copy changed since it was last copied to the buffer. */
+    u64 uniform_dirty_start;
+    /** @brief One past the last byte of the copy changed since it was last copied to the buffer. Equal to the start if none was. */
+    u64 uniform_dirty_end;
+
+    /** @brief The number of instance states: VULKAN_BINDLESS_MAX_MATERIAL_COUNT for bindless shaders, otherwise VULKAN_MAX_MATERIAL_COUNT. */
+    u32 instance_capacity;
+    /** @brief The instance states for all instances. */
+    vulkan_shader_instance_state* instance_states;
 
     /** @brief The number of global non-sampler uniforms. */
     u8 global_uniform_count;
@@ -510,6 +1266,83 @@ typedef struct vulkan_shader {
 
 } vulkan_shader;
 
+/** @brief The kinds of object which may be queued for deferred deletion. */
+typedef enum vulkan_deferred_deletion_type {
+    /** @brief A buffer and its memory. */
+    VULKAN_DEFERRED_DELETION_TYPE_BUFFER,
+    /** @brief An image, its view and its memory. */
+    VULKAN_DEFERRED_DELETION_TYPE_IMAGE,
+    /** @brief A sampler. */
+    VULKAN_DEFERRED_DELETION_TYPE_SAMPLER,
+    /** @brief A pipeline and its layout. */
+    VULKAN_DEFERRED_DELETION_TYPE_PIPELINE,
+    /** @brief Descriptor sets, returned to their pool. */
+    VULKAN_DEFERRED_DELETION_TYPE_DESCRIPTOR_SETS,
+    /** @brief A descriptor pool. */
+    VULKAN_DEFERRED_DELETION_TYPE_DESCRIPTOR_POOL,
+    /** @brief A descriptor set layout. */
+    VULKAN_DEFERRED_DELETION_TYPE_DESCRIPTOR_SET_LAYOUT,
+    /** @brief A command buffer, returned to its pool. */
+    VULKAN_DEFERRED_DELETION_TYPE_COMMAND_BUFFER,
+    /** @brief A range of a renderbuffer, returned to its freelist. */
+    VULKAN_DEFERRED_DELETION_TYPE_RANGE,
+    /** @brief An entry of the bindless texture table, returned for reuse. */
+    VULKAN_DEFERRED_DELETION_TYPE_BINDLESS_SLOT,
+    /** @brief An image view, without its image. */
+    VULKAN_DEFERRED_DELETION_TYPE_IMAGE_VIEW,
+    /** @brief A framebuffer. */
+    VULKAN_DEFERRED_DELETION_TYPE_FRAMEBUFFER,
+    /** @brief A swapchain retired by the one replacing it, and so its images. */
+    VULKAN_DEFERRED_DELETION_TYPE_SWAPCHAIN
+} vulkan_deferred_deletion_type;
+
+/** @brief An object released while frames which may use it were still in flight, to be deleted once they finish. */
+typedef struct vulkan_deferred_deletion {
+    /** @brief The kind of object. */
+    vulkan_deferred_deletion_type type;
+    /** @brief The serial of the frame being recorded when the object was released. It is deleted once that frame completes. */
+    u64 frame_serial;
+    union {
+        /** @brief The buffer, for VULKAN_DEFERRED_DELETION_TYPE_BUFFER. */
+        vulkan_buffer buffer;
+        /** @brief The image, for VULKAN_DEFERRED_DELETION_TYPE_IMAGE. */
+        vulkan_image image;
+        /** @brief The sampler, for VULKAN_DEFERRED_DELETION_TYPE_SAMPLER. */
+        VkSampler sampler;
+        /** @brief The pipeline, for VULKAN_DEFERRED_DELETION_TYPE_PIPELINE. */
+        vulkan_pipeline pipeline;
+        /** @brief The descriptor sets, for VULKAN_DEFERRED_DELETION_TYPE_DESCRIPTOR_SETS. */
+        struct {
+            VkDescriptorPool pool;
+            u32 count;
+            VkDescriptorSet sets[3];
+        } descriptor_sets;
+        /** @brief The descriptor pool, for VULKAN_DEFERRED_DELETION_TYPE_DESCRIPTOR_POOL. */
+        VkDescriptorPool descriptor_pool;
+        /** @brief The descriptor set layout, for VULKAN_DEFERRED_DELETION_TYPE_DESCRIPTOR_SET_LAYOUT. */
+        VkDescriptorSetLayout descriptor_set_layout;
+        /** @brief The command buffer, for VULKAN_DEFERRED_DELETION_TYPE_COMMAND_BUFFER. */
+        struct {
+            VkCommandPool pool;
+            VkCommandBuffer handle;
+        } command_buffer;
+        /** @brief The range, for VULKAN_DEFERRED_DELETION_TYPE_RANGE. */
+        struct {
+            renderbuffer* buffer;
+            u64 size;
+            u64 offset;
+        } range;
+        /** @brief The index of the table entry, for VULKAN_DEFERRED_DELETION_TYPE_BINDLESS_SLOT. */
+        u32 bindless_slot;
+        /** @brief The image view, for VULKAN_DEFERRED_DELETION_TYPE_IMAGE_VIEW. */
+        VkImageView image_view;
+        /** @brief The framebuffer, for VULKAN_DEFERRED_DELETION_TYPE_FRAMEBUFFER. */
+        VkFramebuffer framebuffer;
+        /** @brief The swapchain, for VULKAN_DEFERRED_DELETION_TYPE_SWAPCHAIN. */
+        VkSwapchainKHR swapchain;
+    };
+} vulkan_deferred_deletion;
+
 /**
  * @brief The overall Vulkan context for the backend. Holds and maintains
  * global renderer backend state, Vulkan instance, etc.
@@ -536,10 +1369,15 @@ typedef struct vulkan_context {
     /** @brief The scissor rectangle. */
     vec4 scissor_rect;
 
+    /** @brief The fraction of the window the depth was rendered to at this frame, as culling next frame needs to know. */
+    f32 resolution_scale;
+
     /** @brief The handle to the internal Vulkan instance. */
     VkInstance instance;
     /** @brief The internal Vulkan allocator. */
     VkAllocationCallbacks* allocator;
+    /** @brief The allocator which serves the host allocations of the internal Vulkan allocator, if it is dedicated. */
+    host_allocator host_allocator;
     /** @brief The internal Vulkan surface for the window to be drawn to. */
     VkSurfaceKHR surface;
 
@@ -554,10 +1392,21 @@ typedef struct vulkan_context {
     /** @brief The swapchain. */
     vulkan_swapchain swapchain;
 
-    /** @brief The object vertex buffer, used to hold geometry vertices. */
-    renderbuffer object_vertex_buffer;
-    /** @brief The object index buffer, used to hold geometry indices. */
-    renderbuffer object_index_buffer;
+    /**
+     * @brief The blocks of the geometry heap, which hold geometry vertices and indices. Another is chained when
+     * none has room for a geometry, rather than a full one being resized.
+     */
+    vulkan_geometry_block geometry_blocks[VULKAN_MAX_GEOMETRY_BLOCKS];
+    /** @brief The number of geometry blocks in use. */
+    u32 geometry_block_count;
+    /** @brief The layout of the vertex set of each geometry block, a storage buffer read by vertex shaders pulling their vertices. */
+    VkDescriptorSetLayout vertex_set_layout;
+    /** @brief The pool the vertex sets of geometry blocks come from. */
+    VkDescriptorPool vertex_set_pool;
+    /** @brief The block compaction is moving geometries out of, which new ones are not allocated from, or INVALID_ID if none. */
+    u32 geometry_compaction_block;
+    /** @brief The serial of the frame from which compaction next looks for a block to move geometries out of. */
+    u64 geometry_compaction_next_frame;
 
     /** @brief The graphics command buffers, one per frame. @note: darray */
     vulkan_command_buffer* graphics_command_buffers;
@@ -570,11 +1419,59 @@ typedef struct vulkan_context {
 
     /** @brief The current number of in-flight fences. */
     u32 in_flight_fence_count;
-    /** @brief The in-flight fences, used to indicate to the application when a frame is busy/ready. */
-    VkFence in_flight_fences[2];
+    /** @brief The in-flight fences, used to indicate to the application when a frame is busy/ready. Only signalled without timeline semaphores. */
+    VkFence in_flight_fences[VULKAN_MAX_FRAMES_IN_FLIGHT];
 
-    /** @brief Holds pointers to fences which exist and are owned elsewhere, one per frame. */
-    VkFence images_in_flight[3];
+    /** @brief The serial of the frame last submitted to draw to each swapchain image, or 0 if none is in flight. */
+    u64 image_frame_serials[VULKAN_MAX_SWAPCHAIN_IMAGES];
+
+    /**
+     * @brief The timeline semaphore signalled by graphics queue submissions, each with a value one
+     * higher than the last. VK_NULL_HANDLE without timeline semaphores, in which case fences are used.
+     */
+    VkSemaphore graphics_timeline;
+    /** @brief The value signalled by the last submission to the graphics timeline. */
+    u64 graphics_timeline_value;
+    /** @brief For each frame in flight, the value the graphics timeline reaches once it completes. */
+    u64 submitted_timeline_values[2];
+    /**
+     * @brief The timeline semaphore signalled by upload batches on the transfer queue. Kept apart from
+     * the graphics timeline, as the values of one semaphore must rise in the order they are signalled,
+     * which two queues running side by side cannot promise.
+     */
+    VkSemaphore transfer_timeline;
+    /** @brief The value signalled by the last submission to the transfer timeline. */
+    u64 transfer_timeline_value;
+
+    /** @brief Indicates if renderpasses are timed on the GPU, which requires timestamp support on the graphics queue. */
+    b8 timestamps_supported;
+    /** @brief The mask of valid bits in a timestamp written by the graphics queue. */
+    u64 timestamp_mask;
+    /** @brief The number of nanoseconds per timestamp tick. */
+    f32 timestamp_period;
+    /** @brief Timestamp queries, one per frame in flight. */
+    vulkan_timestamp_frame timestamp_frames[2];
+
+    /** @brief Suballocates device memory for buffers and images. */
+    vulkan_memory_allocator memory_allocator;
+
+    /** @brief The pipeline cache, saved at shutdown and loaded on the next run. VK_NULL_HANDLE if it could not be created. */
+    VkPipelineCache pipeline_cache;
+
+    /** @brief The id of the counter of descriptor writes. */
+    u32 descriptor_writes_counter;
+    /** @brief The id of the counter of pipeline, descriptor set and buffer binds skipped as already bound. */
+    u32 redundant_binds_counter;
+    /** @brief The id of the counter of uploads made through a staging buffer. */
+    u32 staged_uploads_counter;
+    /** @brief The id of the counter of bytes uploaded through a staging buffer. */
+    u32 staged_bytes_counter;
+    /** @brief The id of the gauge of geometry heap blocks in use. */
+    u32 geometry_blocks_counter;
+    /** @brief The id of the counter of bytes of geometry moved to other blocks by compaction. */
+    u32 geometry_compacted_bytes_counter;
+    /** @brief The id of the gauge of textures with GPU resources. */
+    u32 textures_resident_counter;
 
     /** @brief The current image index. */
     u32 image_index;
@@ -585,9 +1482,65 @@ typedef struct vulkan_context {
     /** @brief Indicates if the swapchain is currently being recreated. */
     b8 recreating_swapchain;
 
+    /** @brief The swapchain configuration asked for. What is actually used may differ, as limited by the device. */
+    renderer_swapchain_config swapchain_config;
+
+    /** @brief The id of the last present, used to wait for it to reach the display. 0 if none yet. */
+    uint64_t present_id;
+
     /** @brief The A collection of loaded geometries. @todo TODO: make dynamic */
     vulkan_geometry_data geometries[VULKAN_MAX_GEOMETRY_COUNT];
 
+    /** @brief The staging ring which texture and buffer uploads are staged through. */
+    vulkan_staging_ring staging_ring;
+
+    /** @brief The serial of the frame being recorded, which is the number of frames submitted so far. */
+    u64 frame_serial;
+    /** @brief The number of frames known to have completed on the GPU. Deferred deletion, staging reuse and readbacks are checked against it. */
+    u64 frames_completed;
+    /** @brief For each frame in flight, the number of frames submitted once it was submitted, or 0 if it never was. */
+    u64 submitted_frame_counts[2];
+    /** @brief Objects released while frames using them were in flight, oldest first. @note darray */
+    vulkan_deferred_deletion* deferred_deletions;
+
+    /** @brief Geometry uploads in flight on the transfer queue. @note darray */
+    vulkan_geometry_upload* geometry_uploads;
+    /** @brief The batches geometry uploads are recorded into, one per frame in flight. */
+    vulkan_upload_batch upload_batches[2];
+
+    /** @brief The state for drawing geometries in batches. */
+    vulkan_draw_batch draw_batch;
+    /** @brief GPU culling of batched draws. */
+    vulkan_cull_state cull;
+    /** @brief GPU skinning of geometries. */
+    vulkan_skinning_state skinning;
+    /** @brief The bindless texture table. */
+    vulkan_bindless_textures bindless;
+    /** @brief The samplers shared between texture maps. */
+    vulkan_sampler_cache samplers;
+    /** @brief Uniform data which only lives for a frame, such as per-draw locals. */
+    vulkan_frame_uniform_arena frame_uniforms;
+    /** @brief Descriptor sets which only live for a frame. */
+    vulkan_transient_descriptors transient_descriptors;
+    /** @brief Pixels read back from textures a few frames after they were asked for, such as for picking. */
+    vulkan_pixel_readback pixel_readback;
+    /** @brief The shader most recently bound with vulkan_renderer_shader_use. */
+    struct shader* bound_shader;
+    /** @brief The graphics pipeline bound in the current frame's command buffer, so it is not bound again. 0 if none yet. */
+    VkPipeline bound_graphics_pipeline;
+    /** @brief Record batched draws into secondary command buffers on several threads. */
+    vulkan_recorder recorders[VULKAN_MAX_RECORDERS];
+    /** @brief The renderpass begun for secondary command buffers, which batched draws are recorded in parallel within. 0 if none. */
+    vulkan_renderpass* parallel_renderpass;
+    /** @brief The framebuffer of the renderpass begun for secondary command buffers. */
+    VkFramebuffer parallel_framebuffer;
+    /** @brief The viewport rectangle last set, which secondary command buffers set again. */
+    vec4 current_viewport_rect;
+    /** @brief The scissor rectangle last set, which secondary command buffers set again. */
+    vec4 current_scissor_rect;
+    /** @brief The id of the counter of secondary command buffers recorded. */
+    u32 secondary_command_buffers_counter;
+
     /** @brief Render targets used for world rendering. @note One per frame. */
     render_target world_render_targets[3];
 
@@ -601,4 +1554,10 @@ typedef struct vulkan_context {
      * @returns The index of the found memory type. Returns -1 if not found.
      */
     i32 (*find_memory_index)(u32 type_filter, u32 property_flags);
+
+    /**
+     * @brief A function pointer to queue an object for deletion once the frames which may still use it have completed.
+     * @param deletion A pointer to the object to be deleted. Copied.
+     */
+    void (*deferred_delete)(vulkan_deferred_deletion* deletion);
 } vulkan_context;
@@ -130,4 +130,39 @@ b8 vulkan_result_is_success(VkResult result) {
         case VK_ERROR_UNKNOWN:
             return false;
     }
-}
\ No newline at end of file
+}
+
+VkFormat vulkan_texture_format_to_vk(texture_format format, u8 channel_count) {
+    switch (format) {
+        case TEXTURE_FORMAT_BC1:
+            return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        case TEXTURE_FORMAT_BC3:
+            return VK_FORMAT_BC3_UNORM_BLOCK;
+        case TEXTURE_FORMAT_BC5:
+            return VK_FORMAT_BC5_UNORM_BLOCK;
+        case TEXTURE_FORMAT_BC7:
+            return VK_FORMAT_BC7_UNORM_BLOCK;
+        case TEXTURE_FORMAT_ASTC_4X4:
+            return VK_FORMAT_ASTC_4x4_UNORM_BLOCK;
+        default:
+            break;
+    }
+    // NOTE: Assumes 8 bits per channel.
+    switch (channel_count) {
+        case 1:
+            return VK_FORMAT_R8_UNORM;
+        case 2:
+            return VK_FORMAT_R8G8_UNORM;
+        case 3:
+            return VK_FORMAT_R8G8B8_UNORM;
+        default:
+            return VK_FORMAT_R8G8B8A8_UNORM;
+    }
+}
+
+VkImageAspectFlags vulkan_depth_aspect_get(VkFormat format) {
+    if (format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT) {
+        return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    }
+    return VK_IMAGE_ASPECT_DEPTH_BIT;
+}
@@ -26,4 +26,21 @@ const char* vulkan_result_string(VkResult result, b8 get_extended);
  * 
  * @returns True if success; otherwise false. Defaults to true for unknown result types.
  */
-b8 vulkan_result_is_success(VkResult result);
\ No newline at end of file
+b8 vulkan_result_is_success(VkResult result);
+
+/**
+ * @brief Gets the Vulkan format textures in the given format are created in.
+ *
+ * @param format The texture format.
+ * @param channel_count The number of channels, used only by uncompressed textures.
+ * @returns The Vulkan format. Uncompressed textures with an unexpected channel count get 4 channels.
+ */
+VkFormat vulkan_texture_format_to_vk(texture_format format, u8 channel_count);
+
+/**
+ * @brief Gets the aspects of the given depth format, which barriers on images in it must name.
+ *
+ * @param format The depth format.
+ * @returns The depth aspect, and the stencil aspect if the format has one.
+ */
+VkImageAspectFlags vulkan_depth_aspect_get(VkFormat format);
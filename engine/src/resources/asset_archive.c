@@ -0,0 +1,243 @@
+#include "asset_archive.h"
+
+#include "core/kcompress.h"
+#include "core/kmemory.h"
+#include "core/kname.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+
+STATIC_ASSERT(sizeof(asset_archive_header) == 32, "asset_archive_header must match the file format.");
+STATIC_ASSERT(sizeof(asset_archive_entry) == 48, "asset_archive_entry must match the file format.");
+
+b8 asset_archive_open(const char* path, asset_archive* out_archive) {
+    kzero_memory(out_archive, sizeof(asset_archive));
+    if (!filesystem_map(path, &out_archive->mapping)) {
+        return false;
+    }
+
+    const u8* data = out_archive->mapping.data;
+    u64 size = out_archive->mapping.size;
+    const asset_archive_header* header = (const asset_archive_header*)data;
+    if (size < sizeof(asset_archive_header) || header->magic != ASSET_ARCHIVE_MAGIC) {
+        KERROR("asset_archive_open - '%s' is not an asset archive.", path);
+        asset_archive_close(out_archive);
+        return false;
+    }
+    if (header->version != ASSET_ARCHIVE_VERSION) {
+        KERROR("asset_archive_open - '%s' is version %u, but only version %u is supported.", path, header->version, ASSET_ARCHIVE_VERSION);
+        asset_archive_close(out_archive);
+        return false;
+    }
+
+    // Check the whole table of contents up front, so lookups and reads can trust it.
+    u64 toc_end = sizeof(asset_archive_header) + (u64)header->entry_count * sizeof(asset_archive_entry);
+    b8 valid = toc_end <= size && header->names_offset >= toc_end && header->names_offset <= size && header->names_size <= size - header->names_offset;
+    const asset_archive_entry* entries = (const asset_archive_entry*)(data + sizeof(asset_archive_header));
+    const char* names = (const char*)(data + header->names_offset);
+    for (u32 i = 0; valid && i < header->entry_count; ++i) {
+        const asset_archive_entry* e = &entries[i];
+        valid = e->offset <= size && e->stored_size <= size - e->offset &&
+                (u64)e->name_offset + e->name_length < header->names_size && names[e->name_offset + e->name_length] == 0 &&
+                (e->compression == ASSET_ARCHIVE_COMPRESSION_LZ4 || (e->compression == ASSET_ARCHIVE_COMPRESSION_NONE && e->stored_size == e->size)) &&
+                (i == 0 || entries[i - 1].hash <= e->hash);
+    }
+    if (!valid) {
+        KERROR("asset_archive_open - the table of contents of '%s' is corrupt.", path);
+        asset_archive_close(out_archive);
+        return false;
+    }
+
+    out_archive->entry_count = header->entry_count;
+    out_archive->entries = entries;
+    out_archive->names = names;
+    return true;
+}
+
+void asset_archive_close(asset_archive* archive) {
+    filesystem_unmap(&archive->mapping);
+    archive->entry_count = 0;
+    archive->entries = 0;
+    archive->names = 0;
+}
+
+const asset_archive_entry* asset_archive_find(const asset_archive* archive, const char* name) {
+    if (!archive->entries || !name) {
+        return 0;
+    }
+    u64 hash = kname_create(name);
+
+    // The first entry with the hash, if any.
+    u32 low = 0;
+    u32 high = archive->entry_count;
+    while (low < high) {
+        u32 middle = low + (high - low) / 2;
+        if (archive->entries[middle].hash < hash) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    // Names are compared as well, as different names can share a hash.
+    for (u32 i = low; i < archive->entry_count && archive->entries[i].hash == hash; ++i) {
+        if (strings_equal(archive->names + archive->entries[i].name_offset, name)) {
+            return &archive->entries[i];
+        }
+    }
+    return 0;
+}
+
+const void* asset_archive_entry_data(const asset_archive* archive, const asset_archive_entry* entry) {
+    return (const u8*)archive->mapping.data + entry->offset;
+}
+
+b8 asset_archive_read(const asset_archive* archive, const asset_archive_entry* entry, void* out_data) {
+    const void* data = asset_archive_entry_data(archive, entry);
+    if (entry->compression == ASSET_ARCHIVE_COMPRESSION_LZ4) {
+        if (!kdecompress_lz4(data, entry->stored_size, out_data, entry->size)) {
+            KERROR("asset_archive_read - the data of '%s' is corrupt.", archive->names + entry->name_offset);
+            return false;
+        }
+        return true;
+    }
+    kcopy_memory(out_data, data, entry->size);
+    return true;
+}
+
+// Stably sorts entry indices by the hash of their entries, merging through scratch.
+static void entry_order_sort(u32* order, u32* scratch, u32 count, const asset_archive_entry* entries) {
+    for (u32 width = 1; width < count; width *= 2) {
+        for (u32 left = 0; left < count; left += width * 2) {
+            u32 middle = KMIN(left + width, count);
+            u32 right = KMIN(left + width * 2, count);
+            u32 a = left, b = middle, out = left;
+            while (a < middle && b < right) {
+                scratch[out++] = entries[order[b]].hash < entries[order[a]].hash ? order[b++] : order[a++];
+            }
+            while (a < middle) {
+                scratch[out++] = order[a++];
+            }
+            while (b < right) {
+                scratch[out++] = order[b++];
+            }
+        }
+        kcopy_memory(order, scratch, sizeof(u32) * count);
+    }
+}
+
+static b8 write_padding(file_handle* f, u64 count) {
+    static const u8 zeros[ASSET_ARCHIVE_ALIGNMENT] = {0};
+    u64 written = 0;
+    return count == 0 || filesystem_write(f, count, zeros, &written);
+}
+
+b8 asset_archive_write(const char* path, u32 source_count, const asset_archive_source* sources, b8 compress) {
+    asset_archive_entry* entries = kallocate(sizeof(asset_archive_entry) * source_count + 1, MEMORY_TAG_ARRAY);
+    // Compressed contents, for the entries which were worth compressing.
+    void** compressed = kallocate(sizeof(void*) * source_count + 1, MEMORY_TAG_ARRAY);
+    u32* order = kallocate(sizeof(u32) * source_count * 2 + 1, MEMORY_TAG_ARRAY);
+    b8 success = true;
+
+    u64 names_size = 0;
+    for (u32 i = 0; i < source_count; ++i) {
+        const asset_archive_source* s = &sources[i];
+        u64 length = s->name ? string_length(s->name) : 0;
+        if (length == 0 || (!s->data && s->size > 0)) {
+            KERROR("asset_archive_write - source %u needs a name and data.", i);
+            success = false;
+            break;
+        }
+        entries[i].hash = kname_create(s->name);
+        entries[i].name_offset = (u32)names_size;
+        entries[i].name_length = (u32)length;
+        entries[i].size = s->size;
+        entries[i].stored_size = s->size;
+        entries[i].compression = ASSET_ARCHIVE_COMPRESSION_NONE;
+        names_size += length + 1;
+        order[i] = i;
+
+        // Only keep compressed contents which save at least an eighth, as decompressing is not free.
+        if (compress && s->size > 0) {
+            u64 bound = kcompress_lz4_bound(s->size);
+            void* buffer = kallocate(bound, MEMORY_TAG_ARRAY);
+            u64 compressed_size = kcompress_lz4(s->data, s->size, buffer, bound);
+            if (compressed_size > 0 && compressed_size < s->size - s->size / 8) {
+                compressed[i] = kallocate(compressed_size, MEMORY_TAG_ARRAY);
+                kcopy_memory(compressed[i], buffer, compressed_size);
+                entries[i].stored_size = compressed_size;
+                entries[i].compression = ASSET_ARCHIVE_COMPRESSION_LZ4;
+            }
+            kfree(buffer, bound, MEMORY_TAG_ARRAY);
+        }
+    }
+    if (success && names_size > 0xFFFFFFFFull) {
+        KERROR("asset_archive_write - the names are too long to fit in an archive.");
+        success = false;
+    }
+
+    if (success) {
+        entry_order_sort(order, order + source_count, source_count, entries);
+        for (u32 i = 1; i < source_count; ++i) {
+            const asset_archive_entry* previous = &entries[order[i - 1]];
+            if (previous->hash == entries[order[i]].hash && strings_equal(sources[order[i - 1]].name, sources[order[i]].name)) {
+                KERROR("asset_archive_write - '%s' was given more than once.", sources[order[i]].name);
+                success = false;
+                break;
+            }
+        }
+    }
+
+    // Lay the data out after the table of contents and names, each entry aligned.
+    asset_archive_header header = {0};
+    header.magic = ASSET_ARCHIVE_MAGIC;
+    header.version = ASSET_ARCHIVE_VERSION;
+    header.entry_count = source_count;
+    header.alignment = ASSET_ARCHIVE_ALIGNMENT;
+    header.names_offset = sizeof(asset_archive_header) + sizeof(asset_archive_entry) * (u64)source_count;
+    header.names_size = names_size;
+    u64 offset = get_aligned(header.names_offset + names_size, ASSET_ARCHIVE_ALIGNMENT);
+    for (u32 i = 0; success && i < source_count; ++i) {
+        asset_archive_entry* e = &entries[order[i]];
+        e->offset = offset;
+        offset = get_aligned(offset + e->stored_size, ASSET_ARCHIVE_ALIGNMENT);
+    }
+
+    file_handle f;
+    if (success && !filesystem_open(path, FILE_MODE_WRITE, true, &f)) {
+        KERROR("asset_archive_write - unable to open '%s' for writing.", path);
+        success = false;
+    }
+    if (success) {
+        u64 written = 0;
+        success = filesystem_write(&f, sizeof(asset_archive_header), &header, &written);
+        for (u32 i = 0; success && i < source_count; ++i) {
+            success = filesystem_write(&f, sizeof(asset_archive_entry), &entries[order[i]], &written);
+        }
+        for (u32 i = 0; success && i < source_count; ++i) {
+            success = filesystem_write(&f, entries[i].name_length + 1, sources[i].name, &written);
+        }
+        u64 position = header.names_offset + names_size;
+        for (u32 i = 0; success && i < source_count; ++i) {
+            const asset_archive_entry* e = &entries[order[i]];
+            success = write_padding(&f, e->offset - position);
+            if (success && e->stored_size > 0) {
+                const void* data = compressed[order[i]] ? compressed[order[i]] : sources[order[i]].data;
+                success = filesystem_write(&f, e->stored_size, data, &written);
+            }
+            position = e->offset + e->stored_size;
+        }
+        filesystem_close(&f);
+        if (!success) {
+            KERROR("asset_archive_write - failed writing '%s'.", path);
+        }
+    }
+
+    for (u32 i = 0; i < source_count; ++i) {
+        if (compressed[i]) {
+            kfree(compressed[i], entries[i].stored_size, MEMORY_TAG_ARRAY);
+        }
+    }
+    kfree(order, sizeof(u32) * source_count * 2 + 1, MEMORY_TAG_ARRAY);
+    kfree(compressed, sizeof(void*) * source_count + 1, MEMORY_TAG_ARRAY);
+    kfree(entries, sizeof(asset_archive_entry) * source_count + 1, MEMORY_TAG_ARRAY);
+    return success;
+}
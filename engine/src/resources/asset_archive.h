@@ -0,0 +1,147 @@
+/**
+ * @file asset_archive.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief This file contains the packed asset archive format, which holds many asset
+ * files in one, so that they can be loaded without opening each of them.
+ * @details An archive starts with a header, then a table of contents sorted by the
+ * kname of each entry's name, then the names, then the data of each entry, aligned to
+ * ASSET_ARCHIVE_ALIGNMENT. Archives are mapped into memory whole when opened, so the
+ * table of contents is searched in place, and uncompressed entries are used in place.
+ * Entries may be compressed in the LZ4 block format (see kcompress.h).
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "platform/filesystem.h"
+
+/** @brief The first four bytes of an archive, "KPAK". */
+#define ASSET_ARCHIVE_MAGIC 0x4B41504B
+
+/** @brief The version of the archive format. */
+#define ASSET_ARCHIVE_VERSION 1
+
+/** @brief The alignment of the data of each entry, in bytes, within the archive. */
+#define ASSET_ARCHIVE_ALIGNMENT 64
+
+/** @brief How the data of an archive entry is stored. */
+typedef enum asset_archive_compression {
+    /** @brief Stored as is. */
+    ASSET_ARCHIVE_COMPRESSION_NONE = 0,
+    /** @brief Compressed in the LZ4 block format. */
+    ASSET_ARCHIVE_COMPRESSION_LZ4 = 1
+} asset_archive_compression;
+
+/** @brief The header at the start of an archive. */
+typedef struct asset_archive_header {
+    /** @brief Always ASSET_ARCHIVE_MAGIC. */
+    u32 magic;
+    /** @brief The version of the format, ASSET_ARCHIVE_VERSION. */
+    u32 version;
+    /** @brief The number of entries in the table of contents, which follows the header. */
+    u32 entry_count;
+    /** @brief The alignment of the data of each entry, in bytes. */
+    u32 alignment;
+    /** @brief The offset of the names from the start of the archive. Each is null-terminated. */
+    u64 names_offset;
+    /** @brief The size of the names in bytes. */
+    u64 names_size;
+} asset_archive_header;
+
+/** @brief An entry in the table of contents of an archive. */
+typedef struct asset_archive_entry {
+    /** @brief The kname of the entry's name, which the table of contents is sorted by. */
+    u64 hash;
+    /** @brief The offset of the entry's data from the start of the archive. */
+    u64 offset;
+    /** @brief The size of the entry's data as stored in the archive, in bytes. */
+    u64 stored_size;
+    /** @brief The size of the entry's data once decompressed, in bytes. */
+    u64 size;
+    /** @brief The offset of the entry's name from the start of the names. */
+    u32 name_offset;
+    /** @brief The length of the entry's name, not including its terminator. */
+    u32 name_length;
+    /** @brief How the data is stored, an asset_archive_compression. */
+    u32 compression;
+    /** @brief Reserved for future use. Always 0. */
+    u32 reserved;
+} asset_archive_entry;
+
+/** @brief An archive opened for reading. */
+typedef struct asset_archive {
+    /** @brief The whole archive, mapped into memory. */
+    file_mapping mapping;
+    /** @brief The number of entries in the archive. */
+    u32 entry_count;
+    /** @brief The table of contents, sorted by hash. */
+    const asset_archive_entry* entries;
+    /** @brief The names of the entries. */
+    const char* names;
+} asset_archive;
+
+/** @brief A file to be packed into an archive. */
+typedef struct asset_archive_source {
+    /** @brief The name the file is found by, relative to the asset base path, such as "textures/cobblestone.png". */
+    const char* name;
+    /** @brief The contents of the file. */
+    const void* data;
+    /** @brief The size of the contents in bytes. */
+    u64 size;
+} asset_archive_source;
+
+/**
+ * @brief Opens the archive at path, mapping it into memory, and checks that its
+ * table of contents lies within it.
+ * @param path The path of the archive.
+ * @param out_archive A pointer to hold the archive.
+ * @returns True if the archive was opened; otherwise false.
+ */
+KAPI b8 asset_archive_open(const char* path, asset_archive* out_archive);
+
+/**
+ * @brief Closes an archive opened by asset_archive_open. Entries and their data must not be used after.
+ * @param archive A pointer to the archive to be closed.
+ */
+KAPI void asset_archive_close(asset_archive* archive);
+
+/**
+ * @brief Finds the entry with the given name in the archive.
+ * @param archive A constant pointer to the archive.
+ * @param name The name of the entry. Case-sensitive.
+ * @returns A constant pointer to the entry if found; otherwise 0.
+ */
+KAPI const asset_archive_entry* asset_archive_find(const asset_archive* archive, const char* name);
+
+/**
+ * @brief Gets the data of an entry as it is stored in the archive, which is the entry's
+ * contents where it is not compressed.
+ * @param archive A constant pointer to the archive.
+ * @param entry A constant pointer to the entry.
+ * @returns A pointer to the entry's stored_size bytes of data.
+ */
+KAPI const void* asset_archive_entry_data(const asset_archive* archive, const asset_archive_entry* entry);
+
+/**
+ * @brief Reads the contents of an entry into out_data, decompressing it if needed.
+ * @param archive A constant pointer to the archive.
+ * @param entry A constant pointer to the entry.
+ * @param out_data The memory to read into, which must be at least entry->size bytes.
+ * @returns True on success; false if the entry's data is corrupt.
+ */
+KAPI b8 asset_archive_read(const asset_archive* archive, const asset_archive_entry* entry, void* out_data);
+
+/**
+ * @brief Writes an archive holding the given files to path.
+ * @param path The path to write the archive to.
+ * @param source_count The number of files.
+ * @param sources An array of the files. Their names must be unique.
+ * @param compress Indicates if file contents should be compressed, where that makes them meaningfully smaller.
+ * @returns True on success; otherwise false.
+ */
+KAPI b8 asset_archive_write(const char* path, u32 source_count, const asset_archive_source* sources, b8 compress);
@@ -0,0 +1,272 @@
+#include "asset_cook.h"
+
+#include "core/logger.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "containers/darray.h"
+#include "platform/filesystem.h"
+#include "resources/resource_types.h"
+#include "systems/job_system.h"
+#include "systems/resource_system.h"
+
+// A kind of source file, with a runtime format of its own.
+typedef struct asset_cook_kind {
+    const char* extension;
+    // The directory the loader reads from, relative to the asset base directory.
+    const char* type_path;
+    resource_type type;
+    const char* cooked_extension;
+} asset_cook_kind;
+
+static const asset_cook_kind cook_kinds[] = {
+    {".obj", "models", RESOURCE_TYPE_MESH, ".ksm"},
+    {".fnt", "fonts", RESOURCE_TYPE_BITMAP_FONT, ".kbf"},
+    {".fontcfg", "fonts", RESOURCE_TYPE_SYSTEM_FONT, ".ksf"},
+    {".shadercfg", "shaders", RESOURCE_TYPE_SHADER, ".ksc"},
+    {".kmt", "materials", RESOURCE_TYPE_MATERIAL, ".kmb"},
+    // Images are loaded as they are, with metadata found by scanning their pixels cooked beside them.
+    {".png", "textures", RESOURCE_TYPE_IMAGE, ".ktm"},
+    {".tga", "textures", RESOURCE_TYPE_IMAGE, ".ktm"},
+    {".jpg", "textures", RESOURCE_TYPE_IMAGE, ".ktm"},
+    {".bmp", "textures", RESOURCE_TYPE_IMAGE, ".ktm"}};
+
+#define ASSET_COOK_KIND_COUNT (sizeof(cook_kinds) / sizeof(asset_cook_kind))
+
+// A source file being cooked.
+typedef struct asset_cook_item {
+    const char* source;
+    // 0 for files which are used as they are.
+    const asset_cook_kind* kind;
+    // The name the loader knows the asset by.
+    char name[256];
+    // The path of the cooked file, relative to the asset base directory.
+    char output[512];
+    u64 hash;
+    b8 up_to_date;
+    b8 succeeded;
+} asset_cook_item;
+
+// An entry read from an existing manifest.
+typedef struct asset_cook_record {
+    u64 hash;
+    char source[512];
+} asset_cook_record;
+
+u64 asset_cook_hash(const void* data, u64 size) {
+    // 64-bit FNV-1a.
+    const u8* bytes = data;
+    u64 hash = 0xcbf29ce484222325ull;
+    for (u64 i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static b8 ends_with(const char* str, const char* suffix) {
+    u64 length = string_length(str);
+    u64 suffix_length = string_length(suffix);
+    return length >= suffix_length && strings_equali(str + length - suffix_length, suffix);
+}
+
+static b8 parse_hex_u64(kstring_view text, u64* out_value) {
+    if (text.length == 0 || text.length > 16) {
+        return false;
+    }
+    u64 value = 0;
+    for (u64 i = 0; i < text.length; ++i) {
+        char c = text.str[i];
+        u64 digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        value = (value << 4) | digit;
+    }
+    *out_value = value;
+    return true;
+}
+
+// Reads the records of the manifest at path, if there is one.
+static asset_cook_record* manifest_read(const char* path) {
+    asset_cook_record* records = darray_create(asset_cook_record);
+    file_mapping mapping;
+    if (!filesystem_exists(path) || !filesystem_map(path, &mapping)) {
+        return records;
+    }
+
+    // Each line is "<hash>\t<source>\t<output>", as asset names may hold spaces.
+    kstring_view text = string_view_from(mapping.data, mapping.size);
+    kstring_view line;
+    while (string_view_next_line(&text, &line)) {
+        kstring_view hash;
+        kstring_view source;
+        if (!string_view_next_split(&line, '\t', &hash) || hash.length == 0 || hash.str[0] == '#' || !string_view_next_split(&line, '\t', &source)) {
+            continue;
+        }
+        asset_cook_record record = {};
+        if (!parse_hex_u64(hash, &record.hash) || source.length >= sizeof(record.source)) {
+            KWARN("Ignoring a malformed line in cook manifest '%s'.", path);
+            continue;
+        }
+        string_view_copy(record.source, source, sizeof(record.source));
+        darray_push(records, record);
+    }
+    filesystem_unmap(&mapping);
+    return records;
+}
+
+static b8 manifest_write(const char* path, const asset_cook_item* items, u32 item_count) {
+    file_handle f;
+    if (!filesystem_open(path, FILE_MODE_WRITE, false, &f)) {
+        KERROR("Unable to open cook manifest '%s' for writing.", path);
+        return false;
+    }
+    b8 result = filesystem_write_line(&f, "# Ignis cooked assets: <source hash> <source> <file loaded at runtime>");
+    char line[1200];
+    for (u32 i = 0; i < item_count && result; ++i) {
+        // Files which failed are left out, so they are cooked again next time.
+        if (items[i].succeeded) {
+            string_format(line, "%016llx\t%s\t%s", items[i].hash, items[i].source, items[i].output);
+            result = filesystem_write_line(&f, line);
+        }
+    }
+    filesystem_close(&f);
+    return result;
+}
+
+// Cooks each of the given items through its loader. Safe to run on several threads at once.
+static void asset_cook_items_run(u32 start, u32 end, void* user_data) {
+    asset_cook_item** items = user_data;
+    for (u32 i = start; i < end; ++i) {
+        asset_cook_item* item = items[i];
+        KINFO("Cooking %s -> %s...", item->source, item->output);
+        resource r;
+        item->succeeded = resource_system_load(item->name, item->kind->type, 0, &r);
+        if (item->succeeded) {
+            resource_system_unload(&r);
+        } else {
+            KERROR("Failed to cook '%s'.", item->source);
+        }
+    }
+}
+
+// Works out how a source file is cooked, failing if it is not where its loader reads from.
+static b8 asset_cook_item_create(const char* source, asset_cook_item* out_item) {
+    kzero_memory(out_item, sizeof(asset_cook_item));
+    out_item->source = source;
+    string_ncopy(out_item->output, source, sizeof(out_item->output) - 1);
+    for (u32 k = 0; k < ASSET_COOK_KIND_COUNT; ++k) {
+        const asset_cook_kind* kind = &cook_kinds[k];
+        if (!ends_with(source, kind->extension)) {
+            continue;
+        }
+        u64 type_path_length = string_length(kind->type_path);
+        u64 name_length = string_length(source) - type_path_length - 1 - string_length(kind->extension);
+        if (!strings_nequal(source, kind->type_path, type_path_length) || source[type_path_length] != '/' || name_length >= sizeof(out_item->name)) {
+            KERROR("'%s' must be in the '%s' directory to be cooked.", source, kind->type_path);
+            return false;
+        }
+        out_item->kind = kind;
+        string_ncopy(out_item->name, source + type_path_length + 1, name_length);
+        out_item->name[name_length] = 0;
+        string_format(out_item->output, "%s/%s%s", kind->type_path, out_item->name, kind->cooked_extension);
+        break;
+    }
+    return true;
+}
+
+b8 asset_cook(const char* base_path, u32 source_count, const char** sources, u32 thread_count) {
+    if (!base_path || !sources || thread_count < 1) {
+        KERROR("asset_cook requires a base path, sources and at least one thread.");
+        return false;
+    }
+
+    char manifest_path[512];
+    string_format(manifest_path, "%s/%s", base_path, ASSET_COOK_MANIFEST_NAME);
+    asset_cook_record* records = manifest_read(manifest_path);
+    u32 record_count = (u32)darray_length(records);
+
+    // Hash every source, and find which have changed since they were last cooked.
+    b8 result = true;
+    asset_cook_item* items = kallocate(sizeof(asset_cook_item) * source_count, MEMORY_TAG_ARRAY);
+    asset_cook_item** stale = darray_create(asset_cook_item*);
+    for (u32 i = 0; i < source_count; ++i) {
+        asset_cook_item* item = &items[i];
+        char path[1024];
+        string_format(path, "%s/%s", base_path, sources[i]);
+        file_mapping mapping;
+        if (!asset_cook_item_create(sources[i], item) || !filesystem_map(path, &mapping)) {
+            KERROR("Unable to read '%s'.", path);
+            result = false;
+            continue;
+        }
+        item->hash = asset_cook_hash(mapping.data, mapping.size);
+        filesystem_unmap(&mapping);
+
+        char output_path[1024];
+        string_format(output_path, "%s/%s", base_path, item->output);
+        for (u32 r = 0; r < record_count; ++r) {
+            if (records[r].hash == item->hash && strings_equal(records[r].source, item->source)) {
+                item->up_to_date = filesystem_exists(output_path);
+                break;
+            }
+        }
+
+        if (!item->kind || item->up_to_date) {
+            item->succeeded = true;
+        } else {
+            darray_push(stale, item);
+        }
+    }
+    darray_destroy(records);
+
+    u32 stale_count = (u32)darray_length(stale);
+    KINFO("Cooking %u of %u files; the rest are up to date or used as they are.", stale_count, source_count);
+    if (stale_count > 0) {
+        // Job threads to cook on, each taking anything.
+        u32 job_thread_types[JOB_MAX_THREAD_COUNT];
+        thread_count = KMIN(thread_count, JOB_MAX_THREAD_COUNT);
+        for (u32 i = 0; i < thread_count; ++i) {
+            job_thread_types[i] = JOB_TYPE_GENERAL | JOB_TYPE_RESOURCE_LOAD | JOB_TYPE_GPU_RESOURCE;
+        }
+        u64 job_memory_requirement = 0;
+        job_system_initialize(&job_memory_requirement, 0, 0, 0, 0);
+        void* job_state = kallocate(job_memory_requirement, MEMORY_TAG_APPLICATION);
+
+        // Always import, so that the loaders write the cooked files even where old ones exist.
+        resource_system_config resource_config = {};
+        resource_config.asset_base_path = (char*)base_path;
+        resource_config.max_loader_count = 32;
+        resource_config.import_mode = RESOURCE_IMPORT_MODE_ALWAYS;
+        u64 resource_memory_requirement = 0;
+        resource_system_initialize(&resource_memory_requirement, 0, resource_config);
+        void* resource_state = kallocate(resource_memory_requirement, MEMORY_TAG_APPLICATION);
+
+        if (job_system_initialize(&job_memory_requirement, job_state, (u8)thread_count, job_thread_types, 0) &&
+            resource_system_initialize(&resource_memory_requirement, resource_state, resource_config)) {
+            // Each file on its own, as they vary a lot in size.
+            job_system_parallel_for(stale_count, 1, asset_cook_items_run, stale);
+            resource_system_shutdown(resource_state);
+            job_system_shutdown(job_state);
+        } else {
+            KERROR("asset_cook - unable to start the job and resource systems.");
+        }
+
+        for (u32 i = 0; i < stale_count; ++i) {
+            result = result && stale[i]->succeeded;
+        }
+        kfree(resource_state, resource_memory_requirement, MEMORY_TAG_APPLICATION);
+        kfree(job_state, job_memory_requirement, MEMORY_TAG_APPLICATION);
+    }
+    darray_destroy(stale);
+
+    result = manifest_write(manifest_path, items, source_count) && result;
+    kfree(items, sizeof(asset_cook_item) * source_count, MEMORY_TAG_ARRAY);
+    return result;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file asset_cook.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief This file contains asset cooking, which converts asset source files into the binary
+ * formats loaded at runtime ahead of time, so that nothing has to be imported when running.
+ * @details Cooking goes through the resource loaders themselves, with the resource system set to
+ * always import, so cooked files are exactly those the loaders would write the first time they are
+ * asked for an asset. Files with no separate runtime format are recorded, but left as they are.
+ * The content hash of every source file is recorded in a manifest in the asset base directory,
+ * and sources which are unchanged since they were last cooked are skipped.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief The name of the manifest written to the asset base directory when cooking. */
+#define ASSET_COOK_MANIFEST_NAME "cook.manifest"
+
+/**
+ * @brief Hashes the contents of a file, as recorded in the manifest.
+ * @param data The contents.
+ * @param size The size of the contents in bytes.
+ * @returns The 64-bit hash.
+ */
+KAPI u64 asset_cook_hash(const void* data, u64 size);
+
+/**
+ * @brief Cooks the given asset source files, in parallel, and rewrites the manifest. Starts and
+ * stops its own job and resource systems, so should be called with neither running, but with the
+ * memory system initialized.
+ * @param base_path The asset base directory, which the files are relative to and cooked files are written under.
+ * @param source_count The number of source files.
+ * @param sources The paths of the source files relative to base_path, such as "models/sponza.obj".
+ * Each should be in the directory its loader reads from.
+ * @param thread_count The number of job threads to cook on, at least 1.
+ * @returns True if every file was cooked or already up to date; otherwise false.
+ */
+KAPI b8 asset_cook(const char* base_path, u32 source_count, const char** sources, u32 thread_count);
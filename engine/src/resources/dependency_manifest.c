@@ -0,0 +1,143 @@
+#include "dependency_manifest.h"
+
+#include "containers/darray.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+#include "platform/filesystem.h"
+#include "systems/resource_system.h"
+
+typedef struct kdm_header {
+    u32 magic;
+    u32 version;
+    u32 entry_count;
+    u32 reserved;
+} kdm_header;
+
+void dependency_manifest_create(dependency_manifest* out_manifest) {
+    out_manifest->entries = darray_create(dependency_entry);
+}
+
+void dependency_manifest_destroy(dependency_manifest* manifest) {
+    if (!manifest || !manifest->entries) {
+        return;
+    }
+    u32 count = (u32)darray_length(manifest->entries);
+    for (u32 i = 0; i < count; ++i) {
+        string_free(manifest->entries[i].name);
+    }
+    darray_destroy(manifest->entries);
+    manifest->entries = 0;
+}
+
+b8 dependency_manifest_add(dependency_manifest* manifest, dependency_type type, const char* name) {
+    if (!name || !name[0] || string_length(name) > 0xFFFF) {
+        return false;
+    }
+    // Manifests are small, so a search is cheaper than keeping anything to look names up in.
+    u32 count = (u32)darray_length(manifest->entries);
+    for (u32 i = 0; i < count; ++i) {
+        if (manifest->entries[i].type == type && strings_equali(manifest->entries[i].name, name)) {
+            return false;
+        }
+    }
+    dependency_entry entry = {type, string_duplicate(name)};
+    darray_push(manifest->entries, entry);
+    return true;
+}
+
+void* dependency_manifest_build(const dependency_manifest* manifest, u64* out_size) {
+    u32 count = (u32)darray_length(manifest->entries);
+    u64 size = sizeof(kdm_header);
+    for (u32 i = 0; i < count; ++i) {
+        size += sizeof(u8) + sizeof(u16) + string_length(manifest->entries[i].name);
+    }
+
+    u8* data = kallocate(size, MEMORY_TAG_ARRAY);
+    kdm_header header = {DEPENDENCY_MANIFEST_MAGIC, DEPENDENCY_MANIFEST_VERSION, count, 0};
+    kcopy_memory(data, &header, sizeof(kdm_header));
+    u64 offset = sizeof(kdm_header);
+    for (u32 i = 0; i < count; ++i) {
+        u8 type = (u8)manifest->entries[i].type;
+        u16 length = (u16)string_length(manifest->entries[i].name);
+        data[offset++] = type;
+        kcopy_memory(data + offset, &length, sizeof(u16));
+        offset += sizeof(u16);
+        kcopy_memory(data + offset, manifest->entries[i].name, length);
+        offset += length;
+    }
+    *out_size = size;
+    return data;
+}
+
+b8 dependency_manifest_write(const char* path, const dependency_manifest* manifest) {
+    u64 size = 0;
+    void* data = dependency_manifest_build(manifest, &size);
+    b8 result = false;
+    file_handle f;
+    if (!filesystem_open(path, FILE_MODE_WRITE, true, &f)) {
+        KERROR("Unable to open file '%s' for writing. KDM write failed.", path);
+    } else {
+        u64 written = 0;
+        result = filesystem_write(&f, size, data, &written) && written == size;
+        if (!result) {
+            KERROR("Unable to write all of '%s'.", path);
+        }
+        filesystem_close(&f);
+    }
+    kfree(data, size, MEMORY_TAG_ARRAY);
+    return result;
+}
+
+b8 dependency_manifest_read(const void* data, u64 size, const char* path, dependency_manifest* out_manifest) {
+    dependency_manifest_create(out_manifest);
+    kdm_header header = {};
+    if (size >= sizeof(kdm_header)) {
+        kcopy_memory(&header, data, sizeof(kdm_header));
+    }
+    if (header.magic != DEPENDENCY_MANIFEST_MAGIC) {
+        KERROR("'%s' is not a KDM file.", path);
+        return false;
+    }
+    if (header.version != DEPENDENCY_MANIFEST_VERSION) {
+        KERROR("'%s' is KDM version %u, but only version %u is supported. Cook it again.", path, header.version, DEPENDENCY_MANIFEST_VERSION);
+        return false;
+    }
+
+    const u8* bytes = data;
+    u64 offset = sizeof(kdm_header);
+    for (u32 i = 0; i < header.entry_count; ++i) {
+        u16 length = 0;
+        if (size - offset < sizeof(u8) + sizeof(u16)) {
+            KERROR("'%s' is cut short at entry %u.", path, i);
+            return false;
+        }
+        u8 type = bytes[offset++];
+        kcopy_memory(&length, bytes + offset, sizeof(u16));
+        offset += sizeof(u16);
+        if (size - offset < length || type >= DEPENDENCY_TYPE_COUNT) {
+            KERROR("'%s' is cut short or corrupt at entry %u.", path, i);
+            return false;
+        }
+        dependency_entry entry = {(dependency_type)type, string_view_duplicate(string_view_from((const char*)bytes + offset, length))};
+        darray_push(out_manifest->entries, entry);
+        offset += length;
+    }
+    return true;
+}
+
+b8 dependency_manifest_load(const char* type_path, const char* name, dependency_manifest* out_manifest) {
+    char path[512];
+    string_format(path, "%s/%s/%s%s", resource_system_base_path(), type_path, name, ".kdm");
+    // Assets imported before manifests were written have none, and are loaded as they always were.
+    resource_file f;
+    if (!resource_system_file_exists(path) || !resource_system_file_open(path, &f)) {
+        return false;
+    }
+    b8 result = dependency_manifest_read(f.data, f.size, path, out_manifest);
+    resource_system_file_close(&f);
+    if (!result) {
+        dependency_manifest_destroy(out_manifest);
+    }
+    return result;
+}
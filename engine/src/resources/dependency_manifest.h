@@ -0,0 +1,112 @@
+/**
+ * @file dependency_manifest.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief This file contains dependency manifests, which list every asset an asset such as a mesh
+ * needs, so that they can all be loaded at once rather than each as the one before it finds it.
+ * @details A mesh names its materials and a material names its textures, so without a manifest
+ * the textures of a mesh only start loading once the mesh and then each material has loaded. The
+ * manifest of a mesh is written beside its .ksm when it is imported, as a .kdm file, and lists the
+ * textures and materials the mesh uses, each once. Entries are deepest first, as those are at the
+ * end of the longest chain. A .kdm is a header followed by each entry as its type, a u16 length
+ * and its name.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief The magic at the start of every .kdm file, which is "KDM1". */
+#define DEPENDENCY_MANIFEST_MAGIC 0x314D444B
+/** @brief The version of the .kdm format. */
+#define DEPENDENCY_MANIFEST_VERSION 1
+
+/** @brief The kinds of asset a manifest lists. */
+typedef enum dependency_type {
+    /** @brief A texture, acquired through the texture system. */
+    DEPENDENCY_TYPE_TEXTURE = 0,
+    /** @brief A material, acquired through the material system. */
+    DEPENDENCY_TYPE_MATERIAL = 1,
+    DEPENDENCY_TYPE_COUNT
+} dependency_type;
+
+/** @brief An asset listed in a manifest. */
+typedef struct dependency_entry {
+    /** @brief The kind of asset. */
+    dependency_type type;
+    /** @brief The name of the asset, as its system acquires it by. */
+    char* name;
+} dependency_entry;
+
+/** @brief A dependency manifest. */
+typedef struct dependency_manifest {
+    /** @brief A darray of the entries, deepest first. */
+    dependency_entry* entries;
+} dependency_manifest;
+
+/**
+ * @brief Creates an empty manifest.
+ *
+ * @param out_manifest A pointer to hold the manifest.
+ */
+KAPI void dependency_manifest_create(dependency_manifest* out_manifest);
+
+/**
+ * @brief Destroys the given manifest, freeing its entries.
+ *
+ * @param manifest A pointer to the manifest.
+ */
+KAPI void dependency_manifest_destroy(dependency_manifest* manifest);
+
+/**
+ * @brief Adds an asset to the manifest, unless it is already listed.
+ *
+ * @param manifest A pointer to the manifest.
+ * @param type The kind of asset.
+ * @param name The name of the asset. Empty names are not added.
+ * @return True if the asset was added; otherwise false.
+ */
+KAPI b8 dependency_manifest_add(dependency_manifest* manifest, dependency_type type, const char* name);
+
+/**
+ * @brief Lays the manifest out as a .kdm file.
+ *
+ * @param manifest A constant pointer to the manifest.
+ * @param out_size A pointer to hold the size of the file in bytes.
+ * @return The contents of the file, to be freed by the caller with kfree and MEMORY_TAG_ARRAY.
+ */
+KAPI void* dependency_manifest_build(const dependency_manifest* manifest, u64* out_size);
+
+/**
+ * @brief Writes the manifest out as a .kdm file.
+ *
+ * @param path The path to write the file to.
+ * @param manifest A constant pointer to the manifest.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 dependency_manifest_write(const char* path, const dependency_manifest* manifest);
+
+/**
+ * @brief Reads the contents of a .kdm file into a new manifest.
+ *
+ * @param data The contents of the file.
+ * @param size The size of the contents in bytes.
+ * @param path The path of the file, for errors.
+ * @param out_manifest A pointer to hold the manifest, which is destroyed by the caller even on failure.
+ * @return True on success; otherwise false, such as when the file is cut short.
+ */
+KAPI b8 dependency_manifest_read(const void* data, u64 size, const char* path, dependency_manifest* out_manifest);
+
+/**
+ * @brief Loads the manifest of the given asset, if one was written for it.
+ *
+ * @param type_path The directory the asset is loaded from, relative to the asset base directory, such as "models".
+ * @param name The name of the asset.
+ * @param out_manifest A pointer to hold the manifest, which is destroyed by the caller if loaded.
+ * @return True if the asset has a manifest and it was read; otherwise false.
+ */
+KAPI b8 dependency_manifest_load(const char* type_path, const char* name, dependency_manifest* out_manifest);
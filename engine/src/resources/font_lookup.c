@@ -0,0 +1,173 @@
+#include "font_lookup.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+// The smallest power of two holding the given number of entries with at least as many slots free.
+static u32 slot_count_for(u32 entry_count) {
+    if (entry_count == 0) {
+        return 0;
+    }
+    u32 count = 8;
+    while (count < entry_count * 2) {
+        count <<= 1;
+    }
+    return count;
+}
+
+static u32 codepoint_hash(i32 codepoint) {
+    return (u32)codepoint * 2654435761u;
+}
+
+static u32 pair_hash(u64 key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return (u32)key;
+}
+
+static u64 pair_key(i32 codepoint_0, i32 codepoint_1) {
+    return ((u64)(u32)codepoint_0 << 32) | (u32)codepoint_1;
+}
+
+b8 font_lookup_create(u32 glyph_count, const font_glyph* glyphs, u32 kerning_count, const font_kerning* kernings, u64* memory_requirement, void* memory, font_lookup* out_lookup) {
+    if (!memory_requirement) {
+        KERROR("font_lookup_create requires memory_requirement to exist. Create failed.");
+        return false;
+    }
+    if ((glyph_count && !glyphs) || (kerning_count && !kernings)) {
+        KERROR("font_lookup_create requires the glyphs and kernings it is given a count of. Create failed.");
+        return false;
+    }
+
+    // Only codepoints outside the direct table need a glyph slot.
+    u32 hashed_glyph_count = 0;
+    for (u32 i = 0; i < glyph_count; ++i) {
+        if (glyphs[i].codepoint < 0 || glyphs[i].codepoint >= FONT_LOOKUP_DIRECT_COUNT) {
+            hashed_glyph_count++;
+        }
+    }
+    u32 glyph_slot_count = slot_count_for(hashed_glyph_count);
+    u32 kerning_slot_count = slot_count_for(kerning_count);
+
+    // The glyph slots first, then the kerning slots.
+    u64 glyph_slots_requirement = sizeof(font_lookup_glyph_slot) * glyph_slot_count;
+    *memory_requirement = glyph_slots_requirement + sizeof(font_lookup_kerning_slot) * kerning_slot_count;
+
+    // If only obtaining requirement, boot out.
+    if (!memory) {
+        return true;
+    }
+    if (!out_lookup) {
+        KERROR("font_lookup_create requires a pointer to hold the lookup. Create failed.");
+        return false;
+    }
+
+    kzero_memory(out_lookup, sizeof(font_lookup));
+    out_lookup->glyphs = glyphs;
+    out_lookup->unknown_index = INVALID_ID;
+    for (u32 i = 0; i < FONT_LOOKUP_DIRECT_COUNT; ++i) {
+        out_lookup->direct[i] = INVALID_ID;
+    }
+    out_lookup->glyph_slot_count = glyph_slot_count;
+    out_lookup->glyph_slots = glyph_slot_count ? memory : 0;
+    for (u32 i = 0; i < glyph_slot_count; ++i) {
+        out_lookup->glyph_slots[i].glyph_index = INVALID_ID;
+    }
+    out_lookup->kerning_slot_count = kerning_slot_count;
+    out_lookup->kerning_slots = kerning_slot_count ? (font_lookup_kerning_slot*)((u8*)memory + glyph_slots_requirement) : 0;
+    if (kerning_slot_count) {
+        kzero_memory(out_lookup->kerning_slots, sizeof(font_lookup_kerning_slot) * kerning_slot_count);
+    }
+
+    // Where a codepoint repeats, the first glyph is used, as a search would have found.
+    for (u32 i = 0; i < glyph_count; ++i) {
+        i32 codepoint = glyphs[i].codepoint;
+        if (codepoint == -1 && out_lookup->unknown_index == INVALID_ID) {
+            out_lookup->unknown_index = i;
+        }
+        if (codepoint >= 0 && codepoint < FONT_LOOKUP_DIRECT_COUNT) {
+            if (out_lookup->direct[codepoint] == INVALID_ID) {
+                out_lookup->direct[codepoint] = i;
+            }
+            continue;
+        }
+        u32 mask = glyph_slot_count - 1;
+        for (u32 slot = codepoint_hash(codepoint) & mask;; slot = (slot + 1) & mask) {
+            font_lookup_glyph_slot* s = &out_lookup->glyph_slots[slot];
+            if (s->glyph_index == INVALID_ID) {
+                s->codepoint = codepoint;
+                s->glyph_index = i;
+                break;
+            }
+            if (s->codepoint == codepoint) {
+                break;
+            }
+        }
+    }
+
+    for (u32 i = 0; i < kerning_count; ++i) {
+        u64 key = pair_key(kernings[i].codepoint_0, kernings[i].codepoint_1);
+        u32 mask = kerning_slot_count - 1;
+        for (u32 slot = pair_hash(key) & mask;; slot = (slot + 1) & mask) {
+            font_lookup_kerning_slot* s = &out_lookup->kerning_slots[slot];
+            if (!s->used || s->key == key) {
+                s->key = key;
+                s->amount = kernings[i].amount;
+                s->used = true;
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+void font_lookup_destroy(font_lookup* lookup) {
+    if (lookup) {
+        kzero_memory(lookup, sizeof(font_lookup));
+    }
+}
+
+const font_glyph* font_lookup_glyph(const font_lookup* lookup, i32 codepoint) {
+    if (!lookup || !lookup->glyphs) {
+        return 0;
+    }
+
+    u32 index = INVALID_ID;
+    if (codepoint >= 0 && codepoint < FONT_LOOKUP_DIRECT_COUNT) {
+        index = lookup->direct[codepoint];
+    } else if (lookup->glyph_slot_count) {
+        u32 mask = lookup->glyph_slot_count - 1;
+        for (u32 slot = codepoint_hash(codepoint) & mask;; slot = (slot + 1) & mask) {
+            const font_lookup_glyph_slot* s = &lookup->glyph_slots[slot];
+            if (s->glyph_index == INVALID_ID || s->codepoint == codepoint) {
+                index = s->glyph_index;
+                break;
+            }
+        }
+    }
+
+    if (index == INVALID_ID) {
+        index = lookup->unknown_index;
+    }
+    return index == INVALID_ID ? 0 : &lookup->glyphs[index];
+}
+
+i32 font_lookup_kerning(const font_lookup* lookup, i32 codepoint_0, i32 codepoint_1) {
+    if (!lookup || !lookup->kerning_slot_count) {
+        return 0;
+    }
+
+    u64 key = pair_key(codepoint_0, codepoint_1);
+    u32 mask = lookup->kerning_slot_count - 1;
+    for (u32 slot = pair_hash(key) & mask;; slot = (slot + 1) & mask) {
+        const font_lookup_kerning_slot* s = &lookup->kerning_slots[slot];
+        if (!s->used) {
+            return 0;
+        }
+        if (s->key == key) {
+            return s->amount;
+        }
+    }
+}
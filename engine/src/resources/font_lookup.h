@@ -0,0 +1,99 @@
+/**
+ * @file font_lookup.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Finds the glyph of a codepoint and the kerning of a pair of codepoints in constant time.
+ * @details Glyphs of the first 256 codepoints, which is most text, are found directly by codepoint.
+ * Glyphs of the rest, and kerning pairs, are found in open-addressed hash tables at most half full.
+ * The lookup points into the glyphs it was created from, so must be created again whenever they
+ * change. Not thread-safe.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "resources/resource_types.h"
+
+/** @brief The number of codepoints, from 0, whose glyphs are found directly. */
+#define FONT_LOOKUP_DIRECT_COUNT 256
+
+/** @brief A slot of the glyph hash table. */
+typedef struct font_lookup_glyph_slot {
+    /** @brief The codepoint of the glyph. */
+    i32 codepoint;
+    /** @brief The index of the glyph, or INVALID_ID if the slot is empty. */
+    u32 glyph_index;
+} font_lookup_glyph_slot;
+
+/** @brief A slot of the kerning hash table. */
+typedef struct font_lookup_kerning_slot {
+    /** @brief Both codepoints of the pair, the first in the upper 32 bits. */
+    u64 key;
+    /** @brief The kerning amount. */
+    i16 amount;
+    /** @brief Indicates if the slot holds a pair. */
+    b8 used;
+} font_lookup_kerning_slot;
+
+/** @brief The font lookup structure. */
+typedef struct font_lookup {
+    /** @brief The glyphs the lookup was created from. */
+    const font_glyph* glyphs;
+    /** @brief The glyph index of each of the first codepoints, or INVALID_ID if there is none. */
+    u32 direct[FONT_LOOKUP_DIRECT_COUNT];
+    /** @brief The index of the glyph of codepoint -1, used for unknown codepoints, or INVALID_ID if there is none. */
+    u32 unknown_index;
+    /** @brief The number of glyph slots, a power of two. */
+    u32 glyph_slot_count;
+    /** @brief The glyph slots, for the codepoints not found directly. */
+    font_lookup_glyph_slot* glyph_slots;
+    /** @brief The number of kerning slots, a power of two. */
+    u32 kerning_slot_count;
+    /** @brief The kerning slots. */
+    font_lookup_kerning_slot* kerning_slots;
+} font_lookup;
+
+/**
+ * @brief Creates a new font lookup. Should be called twice; once to obtain the memory amount
+ * required (passing memory=0), and a second time with memory being set to an allocated block.
+ *
+ * @param glyph_count The number of glyphs.
+ * @param glyphs The glyphs. Must stay valid for as long as the lookup is used.
+ * @param kerning_count The number of kerning pairs.
+ * @param kernings The kerning pairs. Where a pair repeats, the last one is used.
+ * @param memory_requirement A pointer to hold the required memory for the lookup.
+ * @param memory An allocated block of memory, or 0 if just obtaining the requirement.
+ * @param out_lookup A pointer to hold the lookup.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 font_lookup_create(u32 glyph_count, const font_glyph* glyphs, u32 kerning_count, const font_kerning* kernings, u64* memory_requirement, void* memory, font_lookup* out_lookup);
+
+/**
+ * @brief Destroys the given lookup. The memory passed at creation is not freed.
+ *
+ * @param lookup A pointer to the lookup to be destroyed.
+ */
+KAPI void font_lookup_destroy(font_lookup* lookup);
+
+/**
+ * @brief Finds the glyph of the given codepoint.
+ *
+ * @param lookup A constant pointer to the lookup.
+ * @param codepoint The codepoint.
+ * @return The glyph of the codepoint if there is one, otherwise that of codepoint -1, or 0 if neither exists.
+ */
+KAPI const font_glyph* font_lookup_glyph(const font_lookup* lookup, i32 codepoint);
+
+/**
+ * @brief Finds the kerning between the given pair of codepoints.
+ *
+ * @param lookup A constant pointer to the lookup.
+ * @param codepoint_0 The first codepoint.
+ * @param codepoint_1 The codepoint following it.
+ * @return The kerning amount, or 0 if the pair has none.
+ */
+KAPI i32 font_lookup_kerning(const font_lookup* lookup, i32 codepoint_0, i32 codepoint_1);
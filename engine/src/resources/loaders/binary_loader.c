@@ -1,6 +1,7 @@
 #include "binary_loader.h"
 
 #include "core/logger.h"
+#include "core/profiler.h"
 #include "core/kmemory.h"
 #include "core/kstring.h"
 #include "resources/resource_types.h"
@@ -11,6 +12,7 @@
 #include "loader_utils.h"
 
 b8 binary_loader_load(struct resource_loader* self, const char* name, void* params, resource* out_resource) {
+    KPROFILE_ZONE("binary_loader_load");
     if (!self || !name || !out_resource) {
         return false;
     }
@@ -19,41 +21,33 @@ b8 binary_loader_load(struct resource_loader* self, const char* name, void* para
     char full_file_path[512];
     string_format(full_file_path, format_str, resource_system_base_path(), self->type_path, name, "");
 
-    file_handle f;
-    if (!filesystem_open(full_file_path, FILE_MODE_READ, true, &f)) {
+    // Kept until unloaded, as the data is used straight from where the file was found, without a copy.
+    resource_file* file = kallocate(sizeof(resource_file), MEMORY_TAG_RESOURCE);
+    if (!resource_system_file_open(full_file_path, file)) {
         KERROR("binary_loader_load - unable to open file for binary reading: '%s'.", full_file_path);
+        kfree(file, sizeof(resource_file), MEMORY_TAG_RESOURCE);
         return false;
     }
 
     // TODO: Should be using an allocator here.
     out_resource->full_path = string_duplicate(full_file_path);
 
-    u64 file_size = 0;
-    if (!filesystem_size(&f, &file_size)) {
-        KERROR("Unable to binary read file: %s.", full_file_path);
-        filesystem_close(&f);
-        return false;
-    }
-
-    // TODO: Should be using an allocator here.
-    u8* resource_data = kallocate(sizeof(u8) * file_size, MEMORY_TAG_ARRAY);
-    u64 read_size = 0;
-    if (!filesystem_read_all_bytes(&f, resource_data, &read_size)) {
-        KERROR("Unable to binary read file: %s.", full_file_path);
-        filesystem_close(&f);
-        return false;
-    }
-
-    filesystem_close(&f);
-
-    out_resource->data = resource_data;
-    out_resource->data_size = read_size;
+    out_resource->data = (void*)file->data;
+    out_resource->data_size = file->size;
+    out_resource->loader_data = file;
     out_resource->name = name;
 
     return true;
 }
 
 void binary_loader_unload(struct resource_loader* self, resource* resource) {
+    if (self && resource && resource->loader_data) {
+        resource_system_file_close(resource->loader_data);
+        kfree(resource->loader_data, sizeof(resource_file), MEMORY_TAG_RESOURCE);
+        resource->loader_data = 0;
+        resource->data = 0;
+        resource->data_size = 0;
+    }
     if (!resource_unload(self, resource, MEMORY_TAG_ARRAY)) {
         KWARN("binary_loader_unload called with nullptr for self or resource.");
     }
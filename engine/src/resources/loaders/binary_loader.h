@@ -1,7 +1,8 @@
 /**
  * @file binary_loader.h
  * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
- * @brief A resource loader that handles binary resources.
+ * @brief A resource loader that handles binary resources. The resource data is a
+ * read-only view of the file mapped into memory, which must not be written to.
  * @version 1.0
  * @date 2026-01-11
  * 
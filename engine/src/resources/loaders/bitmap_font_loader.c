@@ -1,6 +1,7 @@
 #include "bitmap_font_loader.h"
 
 #include "core/logger.h"
+#include "core/profiler.h"
 #include "core/kmemory.h"
 #include "core/kstring.h"
 #include "resources/resource_types.h"
@@ -10,8 +11,6 @@
 
 #include "platform/filesystem.h"
 
-#include <stdio.h>  //sscanf
-
 typedef enum bitmap_font_file_type {
     BITMAP_FONT_FILE_TYPE_NOT_FOUND,
     BITMAP_FONT_FILE_TYPE_KBF,
@@ -24,11 +23,12 @@ typedef struct supported_bitmap_font_filetype {
     b8 is_binary;
 } supported_bitmap_font_filetype;
 
-static b8 import_fnt_file(file_handle* fnt_file, const char* out_kbf_filename, bitmap_font_resource_data* out_data);
+static b8 import_fnt_file(const resource_file* fnt_file, const char* out_kbf_filename, bitmap_font_resource_data* out_data);
 static b8 read_kbf_file(file_handle* kbf_file, bitmap_font_resource_data* data);
 static b8 write_kbf_file(const char* path, bitmap_font_resource_data* data);
 
 b8 bitmap_font_loader_load(struct resource_loader* self, const char* name, void* params, resource* out_resource) {
+    KPROFILE_ZONE("bitmap_font_loader_load");
     if (!self || !name || !out_resource) {
         return false;
     }
@@ -38,9 +38,7 @@ b8 bitmap_font_loader_load(struct resource_loader* self, const char* name, void*
 // Supported extensions. Note that these are in order of priority when looked up.
 // This is to prioritize the loading of a binary version of the bitmap font, followed by
 // importing various types of bitmap fonts to binary types, which would be loaded on the
-// next run.
-// TODO: Might be good to be able to specify an override to always import (i.e. skip
-// binary versions) for debug purposes.
+// next run. The resource system's import mode can skip one or the other.
 #define SUPPORTED_FILETYPE_COUNT 2
     supported_bitmap_font_filetype supported_filetypes[SUPPORTED_FILETYPE_COUNT];
     supported_filetypes[0] = (supported_bitmap_font_filetype){".kbf", BITMAP_FONT_FILE_TYPE_KBF, true};
@@ -50,18 +48,24 @@ b8 bitmap_font_loader_load(struct resource_loader* self, const char* name, void*
     bitmap_font_file_type type = BITMAP_FONT_FILE_TYPE_NOT_FOUND;
     // Try each supported extension.
     for (u32 i = 0; i < SUPPORTED_FILETYPE_COUNT; ++i) {
+        if (!resource_system_should_find(supported_filetypes[i].is_binary)) {
+            continue;
+        }
         string_format(full_file_path, format_str, resource_system_base_path(), self->type_path, name, supported_filetypes[i].extension);
-        // If the file exists, open it and stop looking.
-        if (filesystem_exists(full_file_path)) {
-            if (filesystem_open(full_file_path, FILE_MODE_READ, supported_filetypes[i].is_binary, &f)) {
+        // If the file exists, open it and stop looking. Text files are read as resource files.
+        if (supported_filetypes[i].is_binary) {
+            if (filesystem_exists(full_file_path) && filesystem_open(full_file_path, FILE_MODE_READ, true, &f)) {
                 type = supported_filetypes[i].type;
                 break;
             }
+        } else if (resource_system_file_exists(full_file_path)) {
+            type = supported_filetypes[i].type;
+            break;
         }
     }
 
     if (type == BITMAP_FONT_FILE_TYPE_NOT_FOUND) {
-        KERROR("Unable to find bitmap font of supported type called '%s'.", name);
+        KERROR("Unable to find bitmap font of supported type called '%s'.%s", name, resource_system_import_mode() == RESOURCE_IMPORT_MODE_NEVER ? " Importing is disabled, so it must be cooked first." : "");
         return false;
     }
 
@@ -76,11 +80,18 @@ b8 bitmap_font_loader_load(struct resource_loader* self, const char* name, void*
             // Generate the KBF filename.
             char kbf_file_name[512];
             string_format(kbf_file_name, "%s/%s/%s%s", resource_system_base_path(), self->type_path, name, ".kbf");
-            result = import_fnt_file(&f, kbf_file_name, &resource_data);
+            resource_file fnt_file;
+            if (!resource_system_file_open(full_file_path, &fnt_file)) {
+                KERROR("Unable to read file: %s.", full_file_path);
+                break;
+            }
+            result = import_fnt_file(&fnt_file, kbf_file_name, &resource_data);
+            resource_system_file_close(&fnt_file);
             break;
         }
         case BITMAP_FONT_FILE_TYPE_KBF:
             result = read_kbf_file(&f, &resource_data);
+            filesystem_close(&f);
             break;
         case BITMAP_FONT_FILE_TYPE_NOT_FOUND:
             KERROR("Unable to find bitmap font of supported type called '%s'.", name);
@@ -88,8 +99,6 @@ b8 bitmap_font_loader_load(struct resource_loader* self, const char* name, void*
             break;
     }
 
-    filesystem_close(&f);
-
     if (!result) {
         KERROR("Failed to process bitmap font file '%s'.", full_file_path);
         string_free(out_resource->full_path);
@@ -144,151 +153,201 @@ void bitmap_font_loader_unload(struct resource_loader* self, resource* resource)
         return false;                                                                                                                          \
     }
 
-static b8 import_fnt_file(file_handle* fnt_file, const char* out_kbf_filename, bitmap_font_resource_data* out_data) {
+/**
+ * @brief Finds the value of the given key in a line of "key=value" pairs, as used by .fnt
+ * files. Values may be quoted, in which case the view excludes the quotes.
+ */
+static b8 fnt_find_value(kstring_view line, const char* key, kstring_view* out_value) {
+    const char* p = line.str;
+    const char* end = line.str + line.length;
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\t')) {
+            p++;
+        }
+        const char* key_start = p;
+        while (p < end && *p != '=' && *p != ' ' && *p != '\t') {
+            p++;
+        }
+        kstring_view found_key = string_view_from(key_start, (u64)(p - key_start));
+        if (p >= end || *p != '=') {
+            // A word without a value, such as the line's tag.
+            continue;
+        }
+        p++;
+
+        const char* value_start = p;
+        const char* value_end;
+        if (p < end && *p == '"') {
+            value_start = ++p;
+            while (p < end && *p != '"') {
+                p++;
+            }
+            value_end = p;
+            if (p < end) {
+                p++;
+            }
+        } else {
+            while (p < end && *p != ' ' && *p != '\t') {
+                p++;
+            }
+            value_end = p;
+        }
+
+        if (string_view_equal(found_key, key)) {
+            *out_value = string_view_from(value_start, (u64)(value_end - value_start));
+            return true;
+        }
+    }
+    return false;
+}
+
+/** @brief Reads the integer value of the given key from a .fnt line. Returns 1 if read, otherwise 0. */
+static i32 fnt_read_i32(kstring_view line, const char* key, i32* out_value) {
+    kstring_view value;
+    return fnt_find_value(line, key, &value) && string_view_parse_i32(&value, out_value);
+}
+
+/** @brief Reads the string value of the given key from a .fnt line. Returns 1 if read, otherwise 0. */
+static i32 fnt_read_string(kstring_view line, const char* key, char* out_value, u64 max_length) {
+    kstring_view value;
+    if (!fnt_find_value(line, key, &value)) {
+        return 0;
+    }
+    string_view_copy(out_value, value, max_length);
+    return 1;
+}
+
+static b8 import_fnt_file(const resource_file* fnt_file, const char* out_kbf_filename, bitmap_font_resource_data* out_data) {
     kzero_memory(out_data, sizeof(bitmap_font_resource_data));
-    char line_buf[512] = "";
-    char* p = &line_buf[0];
-    u64 line_length = 0;
+    kstring_view text = string_view_from(fnt_file->data, fnt_file->size);
+    kstring_view line;
     u32 line_num = 0;
     u32 glyphs_read = 0;
     u8 pages_read = 0;
     u32 kernings_read = 0;
-    while (true) {
+    while (string_view_next_line(&text, &line)) {
         ++line_num;  // Increment the number right away, since most text editors' line display is 1-indexed.
-        if (!filesystem_read_line(fnt_file, 511, &p, &line_length)) {
-            break;
-        }
 
         // Skip blank lines.
-        if (line_length < 1) {
+        kstring_view fields = line;
+        kstring_view tag;
+        if (!string_view_next_token(&fields, &tag)) {
             continue;
         }
 
-        char first_char = line_buf[0];
-        switch (first_char) {
-            case 'i': {
-                // 'info' line
-
-                // NOTE: only extract the face and size, ignore the rest.
-                i32 elements_read = sscanf(
-                    line_buf,
-                    "info face=\"%[^\"]\" size=%u",
-                    out_data->data.face,
-                    &out_data->data.size);
-                VERIFY_LINE("info", line_num, 2, elements_read);
-                break;
+        if (string_view_equal(tag, "info")) {
+            // NOTE: only extract the face and size, ignore the rest.
+            i32 size = 0;
+            i32 elements_read = fnt_read_string(fields, "face", out_data->data.face, sizeof(out_data->data.face));
+            elements_read += fnt_read_i32(fields, "size", &size);
+            VERIFY_LINE("info", line_num, 2, elements_read);
+            out_data->data.size = (u32)size;
+        } else if (string_view_equal(tag, "common")) {
+            // Ignore everything else.
+            i32 page_count = 0;
+            i32 elements_read = fnt_read_i32(fields, "lineHeight", &out_data->data.line_height);
+            elements_read += fnt_read_i32(fields, "base", &out_data->data.baseline);
+            elements_read += fnt_read_i32(fields, "scaleW", &out_data->data.atlas_size_x);
+            elements_read += fnt_read_i32(fields, "scaleH", &out_data->data.atlas_size_y);
+            elements_read += fnt_read_i32(fields, "pages", &page_count);
+            VERIFY_LINE("common", line_num, 5, elements_read);
+            out_data->page_count = (u32)page_count;
+
+            // Allocate the pages array.
+            if (out_data->page_count > 0) {
+                if (!out_data->pages) {
+                    out_data->pages = kallocate(sizeof(bitmap_font_page) * out_data->page_count, MEMORY_TAG_ARRAY);
+                }
+            } else {
+                KERROR("Pages is 0, which should not be possible. Font file reading aborted.");
+                return false;
             }
-            case 'c': {
-                // 'common', 'char' or 'chars' line
-                if (line_buf[1] == 'o') {
-                    // common
-                    i32 elements_read = sscanf(
-                        line_buf,
-                        "common lineHeight=%d base=%u scaleW=%d scaleH=%d pages=%d",  // ignore everything else.
-                        &out_data->data.line_height,
-                        &out_data->data.baseline,
-                        &out_data->data.atlas_size_x,
-                        &out_data->data.atlas_size_y,
-                        &out_data->page_count);
-
-                    VERIFY_LINE("common", line_num, 5, elements_read);
-
-                    // Allocate the pages array.
-                    if (out_data->page_count > 0) {
-                        if (!out_data->pages) {
-                            out_data->pages = kallocate(sizeof(bitmap_font_page) * out_data->page_count, MEMORY_TAG_ARRAY);
-                        }
-                    } else {
-                        KERROR("Pages is 0, which should not be possible. Font file reading aborted.");
-                        return false;
-                    }
-                } else if (line_buf[1] == 'h') {
-                    if (line_buf[4] == 's') {
-                        // chars line
-                        i32 elements_read = sscanf(line_buf, "chars count=%u", &out_data->data.glyph_count);
-                        VERIFY_LINE("chars", line_num, 1, elements_read);
-
-                        // Allocate the glyphs array.
-                        if (out_data->data.glyph_count > 0) {
-                            if (!out_data->data.glyphs) {
-                                out_data->data.glyphs = kallocate(sizeof(font_glyph) * out_data->data.glyph_count, MEMORY_TAG_ARRAY);
-                            }
-                        } else {
-                            KERROR("Glyph count is 0, which should not be possible. Font file reading aborted.");
-                            return false;
-                        }
-                    } else {
-                        // Assume 'char' line
-                        font_glyph* g = &out_data->data.glyphs[glyphs_read];
-
-                        i32 elements_read = sscanf(
-                            line_buf,
-                            "char id=%d x=%hu y=%hu width=%hu height=%hu xoffset=%hd yoffset=%hd xadvance=%hd page=%hhu chnl=%*u",
-                            &g->codepoint,
-                            &g->x,
-                            &g->y,
-                            &g->width,
-                            &g->height,
-                            &g->x_offset,
-                            &g->y_offset,
-                            &g->x_advance,
-                            &g->page_id);
-
-                        VERIFY_LINE("char", line_num, 9, elements_read);
-
-                        glyphs_read++;
-                    }
-                } else {
-                    // invalid, ignore
+        } else if (string_view_equal(tag, "chars")) {
+            i32 glyph_count = 0;
+            i32 elements_read = fnt_read_i32(fields, "count", &glyph_count);
+            VERIFY_LINE("chars", line_num, 1, elements_read);
+            out_data->data.glyph_count = (u32)glyph_count;
+
+            // Allocate the glyphs array.
+            if (out_data->data.glyph_count > 0) {
+                if (!out_data->data.glyphs) {
+                    out_data->data.glyphs = kallocate(sizeof(font_glyph) * out_data->data.glyph_count, MEMORY_TAG_ARRAY);
                 }
-                break;
+            } else {
+                KERROR("Glyph count is 0, which should not be possible. Font file reading aborted.");
+                return false;
             }
-            case 'p': {
-                // 'page' line
-                bitmap_font_page* page = &out_data->pages[pages_read];
-                i32 elements_read = sscanf(
-                    line_buf,
-                    "page id=%hhi file=\"%[^\"]\"",
-                    &page->id,
-                    page->file);
-
-                // Strip the extension.
-                string_filename_no_extension_from_path(page->file, page->file);
-
-                VERIFY_LINE("page", line_num, 2, elements_read);
-
-                break;
+        } else if (string_view_equal(tag, "char")) {
+            if (glyphs_read >= out_data->data.glyph_count) {
+                KERROR("Error in file format, line %u. More chars than the chars count.", line_num);
+                return false;
             }
-            case 'k': {
-                // 'kernings' or 'kerning' line
-                if (line_buf[7] == 's') {
-                    // Kernings
-                    i32 elements_read = sscanf(line_buf, "kernings count=%u", &out_data->data.kerning_count);
-
-                    VERIFY_LINE("kernings", line_num, 1, elements_read);
-
-                    // Allocate kernings array
-                    if (!out_data->data.kernings) {
-                        out_data->data.kernings = kallocate(sizeof(font_kerning) * out_data->data.kerning_count, MEMORY_TAG_ARRAY);
-                    }
-                } else if (line_buf[7] == ' ') {
-                    // Kerning record
-                    font_kerning* k = &out_data->data.kernings[kernings_read];
-                    i32 elements_read = sscanf(
-                        line_buf,
-                        "kerning first=%i  second=%i amount=%hi",
-                        &k->codepoint_0,
-                        &k->codepoint_1,
-                        &k->amount);
-
-                    VERIFY_LINE("kerning", line_num, 3, elements_read);
-                }
-                break;
+            font_glyph* g = &out_data->data.glyphs[glyphs_read];
+
+            i32 values[8];
+            i32 elements_read = fnt_read_i32(fields, "id", &g->codepoint);
+            elements_read += fnt_read_i32(fields, "x", &values[0]);
+            elements_read += fnt_read_i32(fields, "y", &values[1]);
+            elements_read += fnt_read_i32(fields, "width", &values[2]);
+            elements_read += fnt_read_i32(fields, "height", &values[3]);
+            elements_read += fnt_read_i32(fields, "xoffset", &values[4]);
+            elements_read += fnt_read_i32(fields, "yoffset", &values[5]);
+            elements_read += fnt_read_i32(fields, "xadvance", &values[6]);
+            elements_read += fnt_read_i32(fields, "page", &values[7]);
+            VERIFY_LINE("char", line_num, 9, elements_read);
+
+            g->x = (u16)values[0];
+            g->y = (u16)values[1];
+            g->width = (u16)values[2];
+            g->height = (u16)values[3];
+            g->x_offset = (i16)values[4];
+            g->y_offset = (i16)values[5];
+            g->x_advance = (i16)values[6];
+            g->page_id = (u8)values[7];
+
+            glyphs_read++;
+        } else if (string_view_equal(tag, "page")) {
+            if (pages_read >= out_data->page_count) {
+                KERROR("Error in file format, line %u. More pages than the common pages count.", line_num);
+                return false;
             }
-            default:
-                // Skip the line.
-                break;
+            bitmap_font_page* page = &out_data->pages[pages_read];
+            i32 id = 0;
+            i32 elements_read = fnt_read_i32(fields, "id", &id);
+            elements_read += fnt_read_string(fields, "file", page->file, sizeof(page->file));
+            VERIFY_LINE("page", line_num, 2, elements_read);
+            page->id = (i8)id;
+
+            // Strip the extension.
+            string_filename_no_extension_from_path(page->file, page->file);
+
+            pages_read++;
+        } else if (string_view_equal(tag, "kernings")) {
+            i32 kerning_count = 0;
+            i32 elements_read = fnt_read_i32(fields, "count", &kerning_count);
+            VERIFY_LINE("kernings", line_num, 1, elements_read);
+            out_data->data.kerning_count = (u32)kerning_count;
+
+            // Allocate kernings array
+            if (!out_data->data.kernings) {
+                out_data->data.kernings = kallocate(sizeof(font_kerning) * out_data->data.kerning_count, MEMORY_TAG_ARRAY);
+            }
+        } else if (string_view_equal(tag, "kerning")) {
+            if (kernings_read >= out_data->data.kerning_count) {
+                KERROR("Error in file format, line %u. More kernings than the kernings count.", line_num);
+                return false;
+            }
+            font_kerning* k = &out_data->data.kernings[kernings_read];
+            i32 amount = 0;
+            i32 elements_read = fnt_read_i32(fields, "first", &k->codepoint_0);
+            elements_read += fnt_read_i32(fields, "second", &k->codepoint_1);
+            elements_read += fnt_read_i32(fields, "amount", &amount);
+            VERIFY_LINE("kerning", line_num, 3, elements_read);
+            k->amount = (i16)amount;
+
+            kernings_read++;
         }
+        // Skip any other line.
     }
 
     // Now write the binary bitmap font file.
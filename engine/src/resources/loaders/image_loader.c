@@ -1,39 +1,239 @@
 #include "image_loader.h"
 
 #include "core/logger.h"
+#include "core/profiler.h"
 #include "core/kmemory.h"
 #include "core/kstring.h"
 #include "platform/filesystem.h"
+#include "renderer/renderer_frontend.h"
 #include "resources/resource_types.h"
+#include "resources/texture_container.h"
+#include "systems/job_system.h"
 #include "systems/resource_system.h"
 #include "platform/filesystem.h"
 #include "loader_utils.h"
 
+#include <stdlib.h>
+
+static void* image_decode_malloc(u64 size);
+static void* image_decode_realloc(void* block, u64 size);
+static void image_decode_free(void* block);
+
 // TODO: resource loader.
 #define STB_IMAGE_IMPLEMENTATION
 // Use our own filesystem.
 #define STBI_NO_STDIO
+// Allocations go through the decode target below, so an image may be decoded straight into memory of the caller's.
+#define STBI_MALLOC(size) image_decode_malloc(size)
+#define STBI_REALLOC(block, size) image_decode_realloc(block, size)
+#define STBI_FREE(block) image_decode_free(block)
 #include "vendor/stb_image.h"
 
+/**
+ * Memory of the caller's which the image being decoded on this thread is written to. stb_image
+ * allocates its output with the exact size of the decoded image, so the first allocation of that
+ * size is handed the target. Should that turn out to be a buffer on the way to the output instead,
+ * the output is copied into the target once decoded, as if it had been decoded anywhere else.
+ */
+typedef struct image_decode_target {
+    void* block;
+    u64 size;
+    // Set while the block is handed out to stb_image.
+    b8 taken;
+} image_decode_target;
+
+static _Thread_local image_decode_target decode_target;
+
+static void* image_decode_malloc(u64 size) {
+    if (decode_target.block && !decode_target.taken && size == decode_target.size) {
+        decode_target.taken = true;
+        return decode_target.block;
+    }
+    return malloc(size);
+}
+
+static void* image_decode_realloc(void* block, u64 size) {
+    if (!block || block != decode_target.block) {
+        return realloc(block, size);
+    }
+    if (size <= decode_target.size) {
+        return block;
+    }
+    // Outgrowing the target, so move to memory of its own.
+    void* moved = malloc(size);
+    if (moved) {
+        kcopy_memory(moved, block, decode_target.size);
+        decode_target.taken = false;
+    }
+    return moved;
+}
+
+static void image_decode_free(void* block) {
+    if (block && block == decode_target.block) {
+        decode_target.taken = false;
+        return;
+    }
+    free(block);
+}
+
+// Texture metadata, written beside an image file when it is imported so that what is found by
+// scanning its pixels need not be found again. The magic is "KTM1".
+#define KTM_MAGIC 0x314D544B
+#define KTM_VERSION 1
+#define KTM_FLAG_HAS_TRANSPARENCY 0x1
+
+typedef struct ktm_header {
+    u32 magic;
+    u32 version;
+    // The size of the image file the metadata is for, so that it is not used once that changes.
+    u64 source_size;
+    u32 flags;
+    u32 reserved;
+} ktm_header;
+
+// Reads the metadata at path, failing if there is none or it is not for an image file of source_size bytes.
+static b8 image_metadata_read(const char* path, u64 source_size, u32* out_flags) {
+    resource_file file;
+    if (!resource_system_file_exists(path) || !resource_system_file_open(path, &file)) {
+        return false;
+    }
+    ktm_header header = {};
+    if (file.size >= sizeof(ktm_header)) {
+        kcopy_memory(&header, file.data, sizeof(ktm_header));
+    }
+    resource_system_file_close(&file);
+    if (header.magic != KTM_MAGIC || header.version != KTM_VERSION || header.source_size != source_size) {
+        return false;
+    }
+    *out_flags = header.flags;
+    return true;
+}
+
+static void image_metadata_write(const char* path, u64 source_size, u32 flags) {
+    ktm_header header = {};
+    header.magic = KTM_MAGIC;
+    header.version = KTM_VERSION;
+    header.source_size = source_size;
+    header.flags = flags;
+    file_handle f;
+    u64 written = 0;
+    if (!filesystem_open(path, FILE_MODE_WRITE, true, &f)) {
+        KWARN("Unable to open '%s' for writing; the image will be scanned again next time.", path);
+        return;
+    }
+    if (!filesystem_write(&f, sizeof(ktm_header), &header, &written) || written != sizeof(ktm_header)) {
+        KWARN("Unable to write all of '%s'.", path);
+    }
+    filesystem_close(&f);
+}
+
+// Picks the first level to load of an image with the given size and number of levels.
+static u32 image_first_level(const image_resource_params* params, u32 width, u32 height, u32 level_count) {
+    u32 level = KMIN(params->first_level, level_count - 1);
+    while (params->max_size && level + 1 < level_count && KMAX(width >> level, height >> level) > params->max_size) {
+        ++level;
+    }
+    return level;
+}
+
+// Halves an image in place, averaging each 2x2 block. The last row or column is repeated at odd sizes.
+// Each pixel written lies at or before the first one it is read from, so nothing is overwritten early.
+static void image_halve(u8* pixels, u32 width, u32 height, u32 channel_count) {
+    u32 half_width = KMAX(width >> 1, 1);
+    u32 half_height = KMAX(height >> 1, 1);
+    for (u32 y = 0; y < half_height; ++y) {
+        u32 y0 = KMIN(y * 2, height - 1) * width;
+        u32 y1 = KMIN(y * 2 + 1, height - 1) * width;
+        for (u32 x = 0; x < half_width; ++x) {
+            u32 x0 = KMIN(x * 2, width - 1);
+            u32 x1 = KMIN(x * 2 + 1, width - 1);
+            u8 texel[4];
+            for (u32 c = 0; c < channel_count; ++c) {
+                u32 sum = pixels[(y0 + x0) * channel_count + c] + pixels[(y0 + x1) * channel_count + c] +
+                          pixels[(y1 + x0) * channel_count + c] + pixels[(y1 + x1) * channel_count + c];
+                texel[c] = (u8)((sum + 2) / 4);
+            }
+            kcopy_memory(pixels + (y * half_width + x) * channel_count, texel, channel_count);
+        }
+    }
+}
+
+// Loads the mip levels of a pre-compressed container, or returns 0 if it can not be read or
+// its format can not be used by the renderer. The data is uploaded as it is, so is not
+// flipped; containers should be authored the way up the engine expects.
+static image_resource_data* image_container_load(const char* path, const image_resource_params* params) {
+    resource_file file;
+    if (!resource_system_file_open(path, &file)) {
+        KERROR("Unable to read file: %s.", path);
+        return 0;
+    }
+
+    image_resource_data* resource_data = 0;
+    texture_container_info info;
+    if (!texture_container_read(file.data, file.size, &info)) {
+        KWARN("Unable to read texture container '%s'.", path);
+    } else if (!renderer_texture_format_supported(info.format)) {
+        KWARN("Texture '%s' is %s, which the renderer does not support.", path, texture_format_name(info.format));
+    } else {
+        // Levels before the first one wanted are left out.
+        u32 first = image_first_level(params, info.width, info.height, info.level_count);
+        resource_data = kallocate(sizeof(image_resource_data), MEMORY_TAG_TEXTURE);
+        resource_data->width = info.levels[first].width;
+        resource_data->height = info.levels[first].height;
+        resource_data->channel_count = 4;
+        resource_data->format = info.format;
+        resource_data->mip_levels = info.level_count - first;
+        // Compressed data is not decoded to look, so is taken to have transparency if it can.
+        resource_data->has_transparency = texture_format_has_alpha(info.format);
+        resource_data->first_level = first;
+        resource_data->source_level_count = info.level_count;
+        for (u32 i = first; i < info.level_count; ++i) {
+            resource_data->data_size += info.levels[i].size;
+        }
+        // Levels need not be stored in order, so are gathered largest first.
+        resource_data->pixels = kallocate(resource_data->data_size, MEMORY_TAG_TEXTURE);
+        u64 offset = 0;
+        for (u32 i = first; i < info.level_count; ++i) {
+            kcopy_memory(resource_data->pixels + offset, (const u8*)file.data + info.levels[i].offset, info.levels[i].size);
+            offset += info.levels[i].size;
+        }
+    }
+    resource_system_file_close(&file);
+    return resource_data;
+}
+
 b8 image_loader_load(struct resource_loader* self, const char* name, void* params, resource* out_resource) {
+    KPROFILE_ZONE("image_loader_load");
     if (!self || !name || !out_resource) {
         return false;
     }
 
-    image_resource_params* typed_params = (image_resource_params*)params;
+    image_resource_params default_params = {};
+    image_resource_params* typed_params = params ? (image_resource_params*)params : &default_params;
 
     char* format_str = "%s/%s/%s%s";
     const i32 required_channel_count = 4;
     stbi_set_flip_vertically_on_load_thread(typed_params->flip_y);
     char full_file_path[512];
 
-// Try different extensions
-#define IMAGE_EXTENSION_COUNT 4
+// Try different extensions. Pre-compressed containers first, falling back to the rest if the
+// renderer can not use what one holds.
+#define IMAGE_EXTENSION_COUNT 6
+#define IMAGE_CONTAINER_EXTENSION_COUNT 2
     b8 found = false;
-    char* extensions[IMAGE_EXTENSION_COUNT] = {".tga", ".png", ".jpg", ".bmp"};
+    char* extensions[IMAGE_EXTENSION_COUNT] = {".ktx2", ".dds", ".tga", ".png", ".jpg", ".bmp"};
+    image_resource_data* resource_data = 0;
     for (u32 i = 0; i < IMAGE_EXTENSION_COUNT; ++i) {
         string_format(full_file_path, format_str, resource_system_base_path(), self->type_path, name, extensions[i]);
-        if (filesystem_exists(full_file_path)) {
+        if (!resource_system_file_exists(full_file_path)) {
+            continue;
+        }
+        if (i >= IMAGE_CONTAINER_EXTENSION_COUNT) {
+            found = true;
+            break;
+        }
+        resource_data = image_container_load(full_file_path, typed_params);
+        if (resource_data) {
             found = true;
             break;
         }
@@ -48,59 +248,87 @@ b8 image_loader_load(struct resource_loader* self, const char* name, void* param
         return false;
     }
 
-    file_handle f;
-    if (!filesystem_open(full_file_path, FILE_MODE_READ, true, &f)) {
-        KERROR("Unable to read file: %s.", full_file_path);
-        filesystem_close(&f);
-        return false;
-    }
-
-    u64 file_size = 0;
-    if (!filesystem_size(&f, &file_size)) {
-        KERROR("Unable to get size of file: %s.", full_file_path);
-        filesystem_close(&f);
-        return false;
-    }
-
-    i32 width;
-    i32 height;
-    i32 channel_count;
+    if (!resource_data) {
+        // Decode straight from where the file was found, whether an archive or a loose file.
+        resource_file file;
+        if (!resource_system_file_open(full_file_path, &file)) {
+            KERROR("Unable to read file: %s.", full_file_path);
+            return false;
+        }
+        // A load cancelled while its file was read goes no further than that.
+        if (job_system_cancel_requested()) {
+            resource_system_file_close(&file);
+            KTRACE("Load of image '%s' was cancelled before it was decoded.", full_file_path);
+            return false;
+        }
 
-    u8* raw_data = kallocate(file_size, MEMORY_TAG_TEXTURE);
-    if (!raw_data) {
-        KERROR("Unable to read file '%s'.", full_file_path);
-        filesystem_close(&f);
-        return false;
-    }
+        i32 width;
+        i32 height;
+        i32 channel_count;
+        u64 file_size = file.size;
 
-    u64 bytes_read = 0;
-    b8 read_result = filesystem_read_all_bytes(&f, raw_data, &bytes_read);
-    filesystem_close(&f);
+        // Decode into memory of the caller's if given some, saving a copy of the whole image on the way to the GPU.
+        u8* target = 0;
+        u64 target_size = 0;
+        if (typed_params->pixels_acquire && stbi_info_from_memory(file.data, (i32)file.size, &width, &height, &channel_count)) {
+            target_size = texture_format_size(TEXTURE_FORMAT_UNCOMPRESSED, width, height, required_channel_count);
+            target = typed_params->pixels_acquire(target_size, typed_params->pixels_acquire_user_data);
+        }
+        decode_target = (image_decode_target){target, target_size, false};
+        u8* data = stbi_load_from_memory(file.data, (i32)file.size, &width, &height, &channel_count, required_channel_count);
+        decode_target = (image_decode_target){0};
+        resource_system_file_close(&file);
+        if (!data) {
+            KERROR("Image resource loader failed to load file '%s'.", full_file_path);
+            return false;
+        }
+        if (target && data != target) {
+            kcopy_memory(target, data, target_size);
+            stbi_image_free(data);
+            data = target;
+        }
 
-    if (!read_result) {
-        KERROR("Unable to read file: '%s'", full_file_path);
-        return false;
-    }
+        // Transparency comes from the metadata written when the image was imported, if it is still
+        // for this file. Otherwise the whole image is scanned, before any levels are skipped, and
+        // the metadata written if importing.
+        char metadata_path[512];
+        string_format(metadata_path, format_str, resource_system_base_path(), self->type_path, name, ".ktm");
+        u32 metadata_flags = 0;
+        if (!resource_system_should_find(true) || !image_metadata_read(metadata_path, file_size, &metadata_flags)) {
+            u64 size = texture_format_size(TEXTURE_FORMAT_UNCOMPRESSED, width, height, required_channel_count);
+            metadata_flags = texture_pixels_have_transparency(data, size, required_channel_count) ? KTM_FLAG_HAS_TRANSPARENCY : 0;
+            if (resource_system_should_find(false)) {
+                image_metadata_write(metadata_path, file_size, metadata_flags);
+            }
+        }
 
-    if (bytes_read != file_size) {
-        KERROR("File size if %llu does not match expected: %llu", bytes_read, file_size);
-        return false;
-    }
+        // The renderer generates the levels below the first, so the source has as many as a full chain.
+        u32 level_count = 1;
+        while ((KMAX((u32)width, (u32)height) >> level_count) > 0) {
+            ++level_count;
+        }
+        // Skipped levels are averaged away here, where they would otherwise be generated.
+        u32 first = image_first_level(typed_params, width, height, level_count);
+        for (u32 i = 0; i < first; ++i) {
+            image_halve(data, width, height, required_channel_count);
+            width = KMAX(width >> 1, 1);
+            height = KMAX(height >> 1, 1);
+        }
 
-    u8* data = stbi_load_from_memory(raw_data, file_size, &width, &height, &channel_count, required_channel_count);
-    if (!data) {
-        KERROR("Image resource loader failed to load file '%s'.", full_file_path);
-        return false;
+        resource_data = kallocate(sizeof(image_resource_data), MEMORY_TAG_TEXTURE);
+        resource_data->pixels = data;
+        resource_data->pixels_acquired = target != 0;
+        resource_data->width = width;
+        resource_data->height = height;
+        resource_data->channel_count = required_channel_count;
+        resource_data->format = TEXTURE_FORMAT_UNCOMPRESSED;
+        resource_data->mip_levels = 1;
+        resource_data->first_level = first;
+        resource_data->source_level_count = level_count;
+        resource_data->has_transparency = (metadata_flags & KTM_FLAG_HAS_TRANSPARENCY) != 0;
+        resource_data->data_size = texture_format_size(TEXTURE_FORMAT_UNCOMPRESSED, width, height, required_channel_count);
     }
 
-    kfree(raw_data, file_size, MEMORY_TAG_TEXTURE);
-
-    image_resource_data* resource_data = kallocate(sizeof(image_resource_data), MEMORY_TAG_TEXTURE);
-    resource_data->pixels = data;
-    resource_data->width = width;
-    resource_data->height = height;
-    resource_data->channel_count = required_channel_count;
-
     out_resource->data = resource_data;
     out_resource->data_size = sizeof(image_resource_data);
 
@@ -108,7 +336,14 @@ b8 image_loader_load(struct resource_loader* self, const char* name, void* param
 }
 
 void image_loader_unload(struct resource_loader* self, resource* resource) {
-    stbi_image_free(((image_resource_data*)resource->data)->pixels);
+    image_resource_data* resource_data = resource->data;
+    if (resource_data->pixels_acquired) {
+        // Belongs to whoever acquired it.
+    } else if (resource_data->format == TEXTURE_FORMAT_UNCOMPRESSED) {
+        stbi_image_free(resource_data->pixels);
+    } else {
+        kfree(resource_data->pixels, resource_data->data_size, MEMORY_TAG_TEXTURE);
+    }
     if (!resource_unload(self, resource, MEMORY_TAG_TEXTURE)) {
         KWARN("image_loader_unload called with nullptr for self or resource.");
     }
@@ -3,6 +3,7 @@
 #include "core/kmemory.h"
 #include "core/logger.h"
 #include "core/kstring.h"
+#include "systems/resource_system.h"
 
 b8 resource_unload(struct resource_loader* self, resource* resource, memory_tag tag) {
     if (!self || !resource) {
@@ -25,4 +26,29 @@ b8 resource_unload(struct resource_loader* self, resource* resource, memory_tag
     }
 
     return true;
-}
\ No newline at end of file
+}
+
+b8 resource_file_next_key_value(kstring_view* text, u32* line_number, const char* path, kstring_view* out_name, kstring_view* out_value) {
+    kstring_view line;
+    while (string_view_next_line(text, &line)) {
+        (*line_number)++;
+        line = string_view_trim(line);
+
+        // Skip blank lines and comments.
+        if (line.length < 1 || line.str[0] == '#') {
+            continue;
+        }
+
+        // Split into var/value
+        i64 equal_index = string_view_index_of(line, '=');
+        if (equal_index == -1) {
+            KWARN("Potential formatting issue found in file '%s': '=' token not found. Skipping line %u.", path, *line_number);
+            continue;
+        }
+
+        *out_name = string_view_trim(string_view_mid(line, 0, equal_index));
+        *out_value = string_view_trim(string_view_mid(line, equal_index + 1, -1));
+        return true;
+    }
+    return false;
+}
@@ -13,6 +13,7 @@
 
 #include "defines.h"
 #include "core/kmemory.h"
+#include "core/kstring.h"
 #include "resources/resource_types.h"
 
 struct resource_loader;
@@ -26,3 +27,17 @@ struct resource_loader;
  * @return True on success; otherwise false.
  */
 b8 resource_unload(struct resource_loader* self, resource* resource, memory_tag tag);
+
+/**
+ * @brief Takes the next "name=value" line from the given text, skipping blank lines and
+ * '#' comments, and warning about (and skipping) lines without an '='. Both views are
+ * trimmed, and point into the text.
+ * 
+ * @param text A pointer to the text to be read, which is advanced past the line.
+ * @param line_number A pointer to the number of the last line read, which is advanced as lines are read.
+ * @param path The path of the file, for warnings.
+ * @param out_name A pointer to hold the name.
+ * @param out_value A pointer to hold the value.
+ * @return True if a line was taken; false at the end of the text.
+ */
+b8 resource_file_next_key_value(kstring_view* text, u32* line_number, const char* path, kstring_view* out_name, kstring_view* out_value);
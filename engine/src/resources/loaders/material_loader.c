@@ -1,8 +1,10 @@
 #include "material_loader.h"
 
 #include "core/logger.h"
+#include "core/profiler.h"
 #include "core/kmemory.h"
 #include "core/kstring.h"
+#include "resources/asset_cook.h"
 #include "resources/resource_types.h"
 #include "systems/resource_system.h"
 #include "math/kmath.h"
@@ -10,116 +12,229 @@
 
 #include "platform/filesystem.h"
 
-b8 material_loader_load(struct resource_loader* self, const char* name, void* params, resource* out_resource) {
-    if (!self || !name || !out_resource) {
-        return false;
-    }
-
-    char* format_str = "%s/%s/%s%s";
-    char full_file_path[512];
-    string_format(full_file_path, format_str, resource_system_base_path(), self->type_path, name, ".kmt");
-
-    file_handle f;
-    if (!filesystem_open(full_file_path, FILE_MODE_READ, false, &f)) {
-        KERROR("material_loader_load - unable to open material file for reading: '%s'.", full_file_path);
-        return false;
-    }
-
-    // TODO: Should be using an allocator here.
-    out_resource->full_path = string_duplicate(full_file_path);
+STATIC_ASSERT(sizeof(kmb_file) == 2088, "kmb_file must match the file format.");
+
+// The config with room for its shader name, so that the two are allocated and freed together.
+typedef struct material_resource_data {
+    material_config config;
+    char shader_name[KMB_SHADER_NAME_MAX_LENGTH];
+} material_resource_data;
+
+static void material_resource_data_defaults(material_resource_data* data, const char* name) {
+    kzero_memory(data, sizeof(material_resource_data));
+    data->config.shader_name = data->shader_name;
+    string_ncopy(data->shader_name, "Builtin.Material", KMB_SHADER_NAME_MAX_LENGTH - 1);  // Default material.
+    data->config.auto_release = true;
+    data->config.diffuse_colour = vec4_one();  // white.
+    string_ncopy(data->config.name, name, MATERIAL_NAME_MAX_LENGTH - 1);
+}
 
-    // TODO: Should be using an allocator here.
-    material_config* resource_data = kallocate(sizeof(material_config), MEMORY_TAG_MATERIAL_INSTANCE);
-    // Set some defaults.
-    resource_data->shader_name = "Builtin.Material"; // Default material.
-    resource_data->auto_release = true;
-    resource_data->diffuse_colour = vec4_one();  // white.
-    resource_data->diffuse_map_name[0] = 0;
-    resource_data->specular_map_name[0] = 0;
-    resource_data->normal_map_name[0] = 0;
-    string_ncopy(resource_data->name, name, MATERIAL_NAME_MAX_LENGTH);
+// Parses a .kmt file into data, which should hold the defaults.
+static void kmt_parse(const resource_file* f, const char* full_file_path, material_resource_data* data) {
+    material_config* resource_data = &data->config;
 
     // Read each line of the file.
-    char line_buf[512] = "";
-    char* p = &line_buf[0];
-    u64 line_length = 0;
-    u32 line_number = 1;
-    while (filesystem_read_line(&f, 511, &p, &line_length)) {
-        // Trim the string.
-        char* trimmed = string_trim(line_buf);
-
-        // Get the trimmed length.
-        line_length = string_length(trimmed);
-
-        // Skip blank lines and comments.
-        if (line_length < 1 || trimmed[0] == '#') {
-            line_number++;
-            continue;
-        }
-
-        // Split into var/value
-        i32 equal_index = string_index_of(trimmed, '=');
-        if (equal_index == -1) {
-            KWARN("Potential formatting issue found in file '%s': '=' token not found. Skipping line %ui.", full_file_path, line_number);
-            line_number++;
-            continue;
-        }
-
-        // Assume a max of 64 characters for the variable name.
-        char raw_var_name[64];
-        kzero_memory(raw_var_name, sizeof(char) * 64);
-        string_mid(raw_var_name, trimmed, 0, equal_index);
-        char* trimmed_var_name = string_trim(raw_var_name);
-
-        // Assume a max of 511-65 (446) for the max length of the value to account for the variable name and the '='.
-        char raw_value[446];
-        kzero_memory(raw_value, sizeof(char) * 446);
-        string_mid(raw_value, trimmed, equal_index + 1, -1);  // Read the rest of the line
-        char* trimmed_value = string_trim(raw_value);
-
+    kstring_view text = string_view_from(f->data, f->size);
+    kstring_view var_name;
+    kstring_view value;
+    u32 line_number = 0;
+    while (resource_file_next_key_value(&text, &line_number, full_file_path, &var_name, &value)) {
         // Process the variable.
-        if (strings_equali(trimmed_var_name, "version")) {
+        if (string_view_equali(var_name, "version")) {
             // TODO: version
-        } else if (strings_equali(trimmed_var_name, "name")) {
-            string_ncopy(resource_data->name, trimmed_value, MATERIAL_NAME_MAX_LENGTH);
-        } else if (strings_equali(trimmed_var_name, "diffuse_map_name")) {
-            string_ncopy(resource_data->diffuse_map_name, trimmed_value, TEXTURE_NAME_MAX_LENGTH);
-        } else if (strings_equali(trimmed_var_name, "specular_map_name")) {
-            string_ncopy(resource_data->specular_map_name, trimmed_value, TEXTURE_NAME_MAX_LENGTH);
-        } else if (strings_equali(trimmed_var_name, "normal_map_name")) {
-            string_ncopy(resource_data->normal_map_name, trimmed_value, TEXTURE_NAME_MAX_LENGTH);
-        } else if (strings_equali(trimmed_var_name, "diffuse_colour")) {
+        } else if (string_view_equali(var_name, "name")) {
+            string_view_copy(resource_data->name, value, MATERIAL_NAME_MAX_LENGTH);
+        } else if (string_view_equali(var_name, "diffuse_map_name")) {
+            string_view_copy(resource_data->diffuse_map_name, value, TEXTURE_NAME_MAX_LENGTH);
+        } else if (string_view_equali(var_name, "specular_map_name")) {
+            string_view_copy(resource_data->specular_map_name, value, TEXTURE_NAME_MAX_LENGTH);
+        } else if (string_view_equali(var_name, "normal_map_name")) {
+            string_view_copy(resource_data->normal_map_name, value, TEXTURE_NAME_MAX_LENGTH);
+        } else if (string_view_equali(var_name, "atlas")) {
+            resource_data->atlas = string_view_to_bool(value);
+        } else if (string_view_equali(var_name, "diffuse_colour")) {
             // Parse the colour
-            if (!string_to_vec4(trimmed_value, &resource_data->diffuse_colour)) {
+            vec4 colour;
+            if (string_view_parse_f32(&value, &colour.x) && string_view_parse_f32(&value, &colour.y) &&
+                string_view_parse_f32(&value, &colour.z) && string_view_parse_f32(&value, &colour.w)) {
+                resource_data->diffuse_colour = colour;
+            } else {
                 KWARN("Error parsing diffuse_colour in file '%s'. Using default of white instead.", full_file_path);
                 // NOTE: already assigned above, no need to have it here.
             }
-        } else if (strings_equali(trimmed_var_name, "shader")) {
-            // Take a copy of the material name.
-            resource_data->shader_name = string_duplicate(trimmed_value);
-        } else if (strings_equali(trimmed_var_name, "shininess")) {
-            if(!string_to_f32(trimmed_value, &resource_data->shininess)) {
+        } else if (string_view_equali(var_name, "shader")) {
+            string_view_copy(data->shader_name, value, KMB_SHADER_NAME_MAX_LENGTH);
+        } else if (string_view_equali(var_name, "shininess")) {
+            if (!string_view_parse_f32(&value, &resource_data->shininess)) {
                 KWARN("Error parsing shininess in file '%s'. Using default of 32.0 instead.", full_file_path);
                 resource_data->shininess = 32.0f;
             }
         }
 
         // TODO: more fields.
+    }
+}
+
+// Reads the .kmb file at path into data, failing if it is not one of the current version.
+static b8 kmb_read(const resource_file* f, const char* path, material_resource_data* data) {
+    kmb_file file;
+    if (f->size != sizeof(kmb_file)) {
+        KERROR("'%s' is not a KMB file of the expected size.", path);
+        return false;
+    }
+    kcopy_memory(&file, f->data, sizeof(kmb_file));
+    if (file.magic != KMB_MAGIC) {
+        KERROR("'%s' is not a KMB file.", path);
+        return false;
+    }
+    if (file.version != KMB_VERSION) {
+        KERROR("'%s' is KMB version %u, but only version %u is supported. Cook it again.", path, file.version, KMB_VERSION);
+        return false;
+    }
+
+    material_config* config = &data->config;
+    kcopy_memory(config->name, file.name, MATERIAL_NAME_MAX_LENGTH);
+    kcopy_memory(data->shader_name, file.shader_name, KMB_SHADER_NAME_MAX_LENGTH);
+    kcopy_memory(config->diffuse_map_name, file.diffuse_map_name, TEXTURE_NAME_MAX_LENGTH);
+    kcopy_memory(config->specular_map_name, file.specular_map_name, TEXTURE_NAME_MAX_LENGTH);
+    kcopy_memory(config->normal_map_name, file.normal_map_name, TEXTURE_NAME_MAX_LENGTH);
+    // Terminated even if the file is not.
+    config->name[MATERIAL_NAME_MAX_LENGTH - 1] = 0;
+    data->shader_name[KMB_SHADER_NAME_MAX_LENGTH - 1] = 0;
+    config->diffuse_map_name[TEXTURE_NAME_MAX_LENGTH - 1] = 0;
+    config->specular_map_name[TEXTURE_NAME_MAX_LENGTH - 1] = 0;
+    config->normal_map_name[TEXTURE_NAME_MAX_LENGTH - 1] = 0;
+    config->diffuse_colour = file.diffuse_colour;
+    config->shininess = file.shininess;
+    config->atlas = (file.flags & KMB_FLAG_ATLAS) != 0;
+    return true;
+}
 
-        // Clear the line buffer.
-        kzero_memory(line_buf, sizeof(char) * 512);
-        line_number++;
+// Reads the hash of the .kmt a .kmb file was written from, or 0 if it cannot be read.
+static u64 kmb_source_hash(const char* path) {
+    resource_file file;
+    if (!resource_system_file_open(path, &file)) {
+        return 0;
     }
+    kmb_file header = {};
+    if (file.size >= sizeof(kmb_file)) {
+        kcopy_memory(&header, file.data, sizeof(kmb_file));
+    }
+    resource_system_file_close(&file);
+    return header.magic == KMB_MAGIC ? header.source_hash : 0;
+}
+
+void kmb_file_create(const material_config* config, u64 source_hash, kmb_file* out_file) {
+    kzero_memory(out_file, sizeof(kmb_file));
+    out_file->magic = KMB_MAGIC;
+    out_file->version = KMB_VERSION;
+    out_file->source_hash = source_hash;
+    out_file->diffuse_colour = config->diffuse_colour;
+    out_file->shininess = config->shininess;
+    out_file->flags = config->atlas ? KMB_FLAG_ATLAS : 0;
+    string_ncopy(out_file->name, config->name, MATERIAL_NAME_MAX_LENGTH - 1);
+    if (config->shader_name) {
+        string_ncopy(out_file->shader_name, config->shader_name, KMB_SHADER_NAME_MAX_LENGTH - 1);
+    }
+    string_ncopy(out_file->diffuse_map_name, config->diffuse_map_name, TEXTURE_NAME_MAX_LENGTH - 1);
+    string_ncopy(out_file->specular_map_name, config->specular_map_name, TEXTURE_NAME_MAX_LENGTH - 1);
+    string_ncopy(out_file->normal_map_name, config->normal_map_name, TEXTURE_NAME_MAX_LENGTH - 1);
+}
+
+b8 kmb_file_write(const char* path, const material_config* config, u64 source_hash) {
+    kmb_file file;
+    kmb_file_create(config, source_hash, &file);
 
+    file_handle f;
+    if (!filesystem_open(path, FILE_MODE_WRITE, true, &f)) {
+        KERROR("Unable to open file '%s' for writing. KMB write failed.", path);
+        return false;
+    }
+    KDEBUG("Writing .kmb file '%s'...", path);
+    u64 written = 0;
+    b8 result = filesystem_write(&f, sizeof(kmb_file), &file, &written) && written == sizeof(kmb_file);
+    if (!result) {
+        KERROR("Unable to write all of '%s'.", path);
+    }
     filesystem_close(&f);
+    return result;
+}
+
+b8 material_loader_load(struct resource_loader* self, const char* name, void* params, resource* out_resource) {
+    KPROFILE_ZONE("material_loader_load");
+    if (!self || !name || !out_resource) {
+        return false;
+    }
+
+    char* format_str = "%s/%s/%s%s";
+    char kmt_path[512];
+    char kmb_path[512];
+    string_format(kmt_path, format_str, resource_system_base_path(), self->type_path, name, ".kmt");
+    string_format(kmb_path, format_str, resource_system_base_path(), self->type_path, name, ".kmb");
+
+    // The binary material is preferred, unless a loose .kmt being authored has changed since it was
+    // written. Text materials in archives are still read, but have nowhere to write a .kmb.
+    b8 text_found = resource_system_should_find(false) && resource_system_file_exists(kmt_path);
+    b8 text_loose = text_found && filesystem_exists(kmt_path);
+    b8 use_binary = resource_system_should_find(true) && resource_system_file_exists(kmb_path);
+
+    resource_file text_file = {};
+    b8 text_open = false;
+    if (text_found && (text_loose || !use_binary)) {
+        if (!resource_system_file_open(kmt_path, &text_file)) {
+            KERROR("material_loader_load - unable to open material file for reading: '%s'.", kmt_path);
+            return false;
+        }
+        text_open = true;
+    }
+    u64 source_hash = text_open ? asset_cook_hash(text_file.data, text_file.size) : 0;
+    if (use_binary && text_open && kmb_source_hash(kmb_path) != source_hash) {
+        use_binary = false;
+    }
+    if (!use_binary && !text_open) {
+        KERROR("Unable to find material called '%s'.%s", name, resource_system_import_mode() == RESOURCE_IMPORT_MODE_NEVER ? " Importing is disabled, so it must be cooked first." : "");
+        return false;
+    }
+
+    // TODO: Should be using an allocator here.
+    material_resource_data* resource_data = kallocate(sizeof(material_resource_data), MEMORY_TAG_MATERIAL_INSTANCE);
+    material_resource_data_defaults(resource_data, name);
+
+    b8 result = true;
+    if (use_binary) {
+        out_resource->full_path = string_duplicate(kmb_path);
+        resource_file f;
+        if (!resource_system_file_open(kmb_path, &f)) {
+            KERROR("material_loader_load - unable to open material file for reading: '%s'.", kmb_path);
+            result = false;
+        } else {
+            result = kmb_read(&f, kmb_path, resource_data);
+            resource_system_file_close(&f);
+        }
+    } else {
+        out_resource->full_path = string_duplicate(kmt_path);
+        kmt_parse(&text_file, kmt_path, resource_data);
+        // Failing to write the binary material only means it is parsed again next time.
+        if (text_loose) {
+            kmb_file_write(kmb_path, &resource_data->config, source_hash);
+        }
+    }
+    if (text_open) {
+        resource_system_file_close(&text_file);
+    }
+    if (!result) {
+        kfree(resource_data, sizeof(material_resource_data), MEMORY_TAG_MATERIAL_INSTANCE);
+        kfree(out_resource->full_path, string_length(out_resource->full_path) + 1, MEMORY_TAG_STRING);
+        out_resource->full_path = 0;
+        return false;
+    }
 
     out_resource->data = resource_data;
-    out_resource->data_size = sizeof(material_config);
+    out_resource->data_size = sizeof(material_resource_data);
     out_resource->name = name;
 
     return true;
 }
-
 void material_loader_unload(struct resource_loader* self, resource* resource) {
     if (!resource_unload(self, resource, MEMORY_TAG_MATERIAL_INSTANCE)) {
         KWARN("material_loader_unload called with nullptr for self or resource.");
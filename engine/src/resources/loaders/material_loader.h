@@ -2,6 +2,9 @@
  * @file material_loader.h
  * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
  * @brief A resource loader that handles material resources.
+ * @details Materials are loaded from binary .kmb files, which are a single fixed-size record copied
+ * straight into the config. The text .kmt format is kept for authoring: when a loose .kmt exists and
+ * differs from the one its .kmb was written from, it is parsed instead and the .kmb written again.
  * @version 1.0
  * @date 2026-01-11
  * 
@@ -12,6 +15,45 @@
 #pragma once
 
 #include "systems/resource_system.h"
+#include "resources/resource_types.h"
+
+/** @brief The magic at the start of every .kmb file, which is "KMB1". */
+#define KMB_MAGIC 0x31424D4B
+/** @brief The version of the .kmb format. Files of any other version must be cooked again. */
+#define KMB_VERSION 1
+/** @brief The max length of the shader name in a .kmb file. */
+#define KMB_SHADER_NAME_MAX_LENGTH 256
+/** @brief Set in the flags of a .kmb file whose diffuse map may be packed into the atlas. */
+#define KMB_FLAG_ATLAS 0x1
+
+/**
+ * @brief The layout of a .kmb file. Names are stored at their full width, zero-padded, so the file is
+ * read with a single copy. The layout is the file format, so must not change without a new version.
+ */
+typedef struct kmb_file {
+    /** @brief KMB_MAGIC. */
+    u32 magic;
+    /** @brief KMB_VERSION. */
+    u32 version;
+    /** @brief The hash of the .kmt the file was written from, or 0 if written from no .kmt. */
+    u64 source_hash;
+    /** @brief The diffuse colour. */
+    vec4 diffuse_colour;
+    /** @brief The shininess. */
+    f32 shininess;
+    /** @brief KMB_FLAG_ bits. */
+    u32 flags;
+    /** @brief The material name. */
+    char name[MATERIAL_NAME_MAX_LENGTH];
+    /** @brief The name of the shader the material is drawn with. */
+    char shader_name[KMB_SHADER_NAME_MAX_LENGTH];
+    /** @brief The diffuse map name, or empty for none. */
+    char diffuse_map_name[TEXTURE_NAME_MAX_LENGTH];
+    /** @brief The specular map name, or empty for none. */
+    char specular_map_name[TEXTURE_NAME_MAX_LENGTH];
+    /** @brief The normal map name, or empty for none. */
+    char normal_map_name[TEXTURE_NAME_MAX_LENGTH];
+} kmb_file;
 
 /**
  * @brief Creates and returns a material resource loader.
@@ -19,3 +61,22 @@
  * @return The newly created resource loader.
  */
 resource_loader material_resource_loader_create();
+
+/**
+ * @brief Lays out the given material config as a .kmb file.
+ *
+ * @param config A constant pointer to the config. Names longer than their fields are cut short.
+ * @param source_hash The hash of the .kmt the config was parsed from, or 0 if none.
+ * @param out_file A pointer to hold the file contents.
+ */
+KAPI void kmb_file_create(const material_config* config, u64 source_hash, kmb_file* out_file);
+
+/**
+ * @brief Writes the given material config out as a .kmb file.
+ *
+ * @param path The path to write the file to.
+ * @param config A constant pointer to the config.
+ * @param source_hash The hash of the .kmt the config was parsed from, or 0 if none.
+ * @returns True on success; otherwise false.
+ */
+KAPI b8 kmb_file_write(const char* path, const material_config* config, u64 source_hash);
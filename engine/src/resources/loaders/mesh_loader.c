@@ -1,20 +1,24 @@
 #include "mesh_loader.h"
 
 #include "core/logger.h"
+#include "core/profiler.h"
 #include "core/kmemory.h"
 #include "core/kstring.h"
+#include "core/kcompress.h"
 #include "containers/darray.h"
+#include "memory/scratch_allocator.h"
 #include "resources/resource_types.h"
 #include "systems/resource_system.h"
 #include "systems/geometry_system.h"
+#include "systems/job_system.h"
 #include "math/kmath.h"
 #include "math/geometry_utils.h"
 #include "loader_utils.h"
+#include "material_loader.h"
+#include "resources/dependency_manifest.h"
 
 #include "platform/filesystem.h"
 
-#include <stdio.h>  //sscanf
-
 typedef enum mesh_file_type {
     MESH_FILE_TYPE_NOT_FOUND,
     MESH_FILE_TYPE_KSM,
@@ -27,6 +31,126 @@ typedef struct supported_mesh_filetype {
     b8 is_binary;
 } supported_mesh_filetype;
 
+// The first version, which stored full vertex_3d vertices. It also wrote each of the center and
+// extents with the size of a vertex_3d, so they are followed by garbage which must be skipped.
+#define KSM_VERSION_FULL_VERTICES 0x0001U
+// Stores vertex_3d_packed vertices, ready to be uploaded.
+#define KSM_VERSION_PACKED_VERTICES 0x0002U
+// Adds the levels of detail of each geometry, after its extents.
+#define KSM_VERSION_LODS 0x0003U
+// Lays the file out to be used in place with a single read: a fixed header, a table with an entry
+// per geometry, then the vertices and indices of each geometry, each starting on a KSM_BLOB_ALIGNMENT
+// boundary. Vertices and indices are then used straight out of the mapped file, without a copy.
+#define KSM_VERSION_MAPPED 0x0004U
+
+// The alignment of each block of vertices or indices, from the start of a KSM_VERSION_MAPPED file.
+#define KSM_BLOB_ALIGNMENT 16
+
+// The header at the start of a KSM_VERSION_MAPPED file. The version is first in every version.
+typedef struct ksm_header {
+    u16 version;
+    // ksm_flag bits. Were always zero before there were any.
+    u16 flags;
+    u32 geometry_count;
+    // From the start of the file.
+    u64 geometry_table_offset;
+    // The extents of the whole mesh, over every geometry.
+    vec3 min_extents;
+    vec3 max_extents;
+    char name[256];
+} ksm_header;
+
+// An entry in the geometry table of a KSM_VERSION_MAPPED file.
+typedef struct ksm_geometry_entry {
+    // From the start of the file, each a multiple of KSM_BLOB_ALIGNMENT.
+    u64 vertex_offset;
+    u64 index_offset;
+    u32 vertex_size;
+    u32 vertex_count;
+    u32 index_size;
+    u32 index_count;
+    vec3 center;
+    vec3 min_extents;
+    vec3 max_extents;
+    u32 lod_count;
+    geometry_lod lods[GEOMETRY_MAX_LODS];
+    char name[GEOMETRY_NAME_MAX_LENGTH];
+    char material_name[MATERIAL_NAME_MAX_LENGTH];
+} ksm_geometry_entry;
+
+// The layouts are the file format, so must not change without a new version.
+STATIC_ASSERT(sizeof(ksm_header) == 296, "ksm_header must match the file format.");
+STATIC_ASSERT(sizeof(ksm_geometry_entry) == 632, "ksm_geometry_entry must match the file format.");
+
+// As KSM_VERSION_MAPPED, except that the vertices and indices of each geometry may be compressed. The
+// geometry table is followed by a stream table, holding an entry for the vertices and then one for the
+// indices of each geometry, and the offsets in the geometry table are those of the stored bytes.
+#define KSM_VERSION_COMPRESSED 0x0005U
+
+// How a stream of vertices or indices is stored in a KSM_VERSION_COMPRESSED file.
+typedef enum ksm_stream_compression {
+    KSM_STREAM_COMPRESSION_NONE = 0,
+    // Filtered, then compressed in the LZ4 block format.
+    KSM_STREAM_COMPRESSION_LZ4 = 1
+} ksm_stream_compression;
+
+// How a stream is rearranged before being compressed, so that it compresses better.
+typedef enum ksm_stream_filter {
+    KSM_STREAM_FILTER_NONE = 0,
+    // The first byte of every element comes first, then the second byte of every element and so on.
+    // Neighbouring vertices hold similar values, so this puts long runs of similar bytes together.
+    KSM_STREAM_FILTER_TRANSPOSE = 1,
+    // Each index is replaced by its zigzag-encoded difference from the one before, then transposed.
+    // Optimized indices mostly refer to nearby vertices, so the upper bytes are nearly all zero.
+    KSM_STREAM_FILTER_DELTA_TRANSPOSE = 2
+} ksm_stream_filter;
+
+// An entry in the stream table of a KSM_VERSION_COMPRESSED file.
+typedef struct ksm_stream_entry {
+    u16 compression;
+    u16 filter;
+    u32 reserved;
+    // The number of bytes stored, which is the decompressed size if the stream is not compressed.
+    u64 stored_size;
+} ksm_stream_entry;
+
+STATIC_ASSERT(sizeof(ksm_stream_entry) == 16, "ksm_stream_entry must match the file format.");
+
+// Flags of a KSM_VERSION_MAPPED or KSM_VERSION_COMPRESSED header, which readers not knowing them ignore.
+typedef enum ksm_flag {
+    // The tables are followed by a meshlet table, with an entry for each geometry, and the meshlets of each
+    // geometry follow its indices.
+    KSM_FLAG_MESHLETS = 0x0001
+} ksm_flag;
+
+// An entry in the meshlet table of a file with KSM_FLAG_MESHLETS.
+typedef struct ksm_meshlet_entry {
+    // From the start of the file, a multiple of KSM_BLOB_ALIGNMENT. 0 if the geometry has no meshlets.
+    u64 offset;
+    u32 count;
+    u32 reserved;
+} ksm_meshlet_entry;
+
+STATIC_ASSERT(sizeof(ksm_meshlet_entry) == 16, "ksm_meshlet_entry must match the file format.");
+STATIC_ASSERT(sizeof(geometry_meshlet) == 52, "geometry_meshlet must match the file format.");
+
+// Only streams which compress by at least this fraction are stored compressed, as decoding is not free.
+#define KSM_STREAM_MIN_SAVING 0.125f
+
+// A .ksm file being read straight out of its contents.
+typedef struct ksm_reader {
+    const u8* data;
+    u64 size;
+    u64 offset;
+} ksm_reader;
+
+// Each level of detail is simplified to about this fraction of the indices of the one before.
+#define OBJ_LOD_REDUCTION 0.5f
+// The furthest a level of detail's surface may move, relative to the geometry's size.
+#define OBJ_LOD_MAX_ERROR 0.05f
+// Geometries of fewer triangles are not split into meshlets, as culling them whole costs little.
+#define OBJ_MESHLET_MIN_TRIANGLES 1024
+
 typedef struct mesh_vertex_index_data {
     u32 position_index;
     u32 normal_index;
@@ -42,27 +166,26 @@ typedef struct mesh_group_data {
     mesh_face_data* faces;
 } mesh_group_data;
 
-b8 import_obj_file(file_handle* obj_file, const char* out_ksm_filename, geometry_config** out_geometries_darray);
+b8 import_obj_file(const resource_file* obj_file, const char* out_ksm_filename, geometry_config** out_geometries_darray);
 void process_subobject(vec3* positions, vec3* normals, vec2* tex_coords, mesh_face_data* faces, geometry_config* out_data);
-b8 import_obj_material_library_file(const char* mtl_file_path);
+b8 import_obj_material_library_file(const char* mtl_file_path, material_config** out_configs_darray);
 
-b8 load_ksm_file(file_handle* ksm_file, geometry_config** out_geometries_darray);
-b8 write_ksm_file(const char* path, const char* name, u32 geometry_count, geometry_config* geometries);
-b8 write_kmt_file(const char* directory, material_config* config);
+b8 load_ksm_file(const char* path, geometry_config** out_geometries_darray, resource_file** out_mapped_file);
+b8 write_ksm_file(const char* path, const char* name, u32 geometry_count, geometry_config* geometries, b8 compress);
+b8 write_mtl_kmb_file(const char* mtl_file_path, material_config* config);
+static b8 write_kdm_file(const char* ksm_file_path, u32 geometry_count, const geometry_config* geometries, material_config* library);
 
 b8 mesh_loader_load(struct resource_loader* self, const char* name, void* params, resource* out_resource) {
+    KPROFILE_ZONE("mesh_loader_load");
     if (!self || !name || !out_resource) {
         return false;
     }
 
     char* format_str = "%s/%s/%s%s";
-    file_handle f;
     // Supported extensions. Note that these are in order of priority when looked up.
     // This is to prioritize the loading of a binary version of the mesh, followed by
     // importing various types of meshes to binary types, which would be loaded on the
-    // next run.
-    // TODO: Might be good to be able to specify an override to always import (i.e. skip
-    // binary versions) for debug purposes.
+    // next run. The resource system's import mode can skip one or the other.
 #define SUPPORTED_FILETYPE_COUNT 2
     supported_mesh_filetype supported_filetypes[SUPPORTED_FILETYPE_COUNT];
     supported_filetypes[0] = (supported_mesh_filetype){".ksm", MESH_FILE_TYPE_KSM, true};
@@ -72,18 +195,25 @@ b8 mesh_loader_load(struct resource_loader* self, const char* name, void* params
     mesh_file_type type = MESH_FILE_TYPE_NOT_FOUND;
     // Try each supported extension.
     for (u32 i = 0; i < SUPPORTED_FILETYPE_COUNT; ++i) {
+        if (!resource_system_should_find(supported_filetypes[i].is_binary)) {
+            continue;
+        }
         string_format(full_file_path, format_str, resource_system_base_path(), self->type_path, name, supported_filetypes[i].extension);
-        // If the file exists, open it and stop looking.
-        if (filesystem_exists(full_file_path)) {
-            if (filesystem_open(full_file_path, FILE_MODE_READ, supported_filetypes[i].is_binary, &f)) {
+        // If the file exists, open it and stop looking. Binary files are opened through the resource system when
+        // loaded instead, so they can come from an archive. Files to import are always loose.
+        if (supported_filetypes[i].is_binary) {
+            if (resource_system_file_exists(full_file_path)) {
                 type = supported_filetypes[i].type;
                 break;
             }
+        } else if (filesystem_exists(full_file_path)) {
+            type = supported_filetypes[i].type;
+            break;
         }
     }
 
     if (type == MESH_FILE_TYPE_NOT_FOUND) {
-        KERROR("Unable to find mesh of supported type called '%s'.", name);
+        KERROR("Unable to find mesh of supported type called '%s'.%s", name, resource_system_import_mode() == RESOURCE_IMPORT_MODE_NEVER ? " Importing is disabled, so it must be cooked first." : "");
         return false;
     }
 
@@ -98,12 +228,22 @@ b8 mesh_loader_load(struct resource_loader* self, const char* name, void* params
             // Generate the ksm filename.
             char ksm_file_name[512];
             string_format(ksm_file_name, "%s/%s/%s%s", resource_system_base_path(), self->type_path, name, ".ksm");
-            result = import_obj_file(&f, ksm_file_name, &resource_data);
+            resource_file obj_file;
+            if (!resource_system_file_open(full_file_path, &obj_file)) {
+                KERROR("Unable to read file: %s.", full_file_path);
+                break;
+            }
+            result = import_obj_file(&obj_file, ksm_file_name, &resource_data);
+            resource_system_file_close(&obj_file);
             break;
         }
-        case MESH_FILE_TYPE_KSM:
-            result = load_ksm_file(&f, &resource_data);
+        case MESH_FILE_TYPE_KSM: {
+            // Kept open until unloaded if the geometry data is used straight out of it.
+            resource_file* mapped_file = 0;
+            result = load_ksm_file(full_file_path, &resource_data, &mapped_file);
+            out_resource->loader_data = mapped_file;
             break;
+        }
         default:
         case MESH_FILE_TYPE_NOT_FOUND:
             KERROR("Unable to find mesh of supported type called '%s'.", name);
@@ -111,8 +251,6 @@ b8 mesh_loader_load(struct resource_loader* self, const char* name, void* params
             break;
     }
 
-    filesystem_close(&f);
-
     if (!result) {
         KERROR("Failed to process mesh file '%s'.", full_file_path);
         darray_destroy(resource_data);
@@ -129,425 +267,1146 @@ b8 mesh_loader_load(struct resource_loader* self, const char* name, void* params
 }
 
 void mesh_loader_unload(struct resource_loader* self, resource* resource) {
+    // Nothing was loaded if the load failed.
+    if (!resource->data) {
+        return;
+    }
     u32 count = darray_length(resource->data);
     for (u32 i = 0; i < count; ++i) {
         geometry_config* config = &((geometry_config*)resource->data)[i];
+        if (resource->loader_data) {
+            // Borrowed from the file, rather than allocated.
+            config->vertices = 0;
+            config->indices = 0;
+        }
         geometry_system_config_dispose(config);
     }
     darray_destroy(resource->data);
     resource->data = 0;
     resource->data_size = 0;
+
+    if (resource->loader_data) {
+        resource_system_file_close(resource->loader_data);
+        kfree(resource->loader_data, sizeof(resource_file), MEMORY_TAG_RESOURCE);
+        resource->loader_data = 0;
+    }
 }
 
-b8 load_ksm_file(file_handle* ksm_file, geometry_config** out_geometries_darray) {
-    // Version
-    u64 bytes_read = 0;
-    u16 version = 0;
-    filesystem_read(ksm_file, sizeof(u16), &version, &bytes_read);
+// Copies size bytes out of the file, failing if it is too short.
+static b8 ksm_read(ksm_reader* reader, u64 size, void* out_data) {
+    if (size > reader->size - reader->offset) {
+        return false;
+    }
+    kcopy_memory(out_data, reader->data + reader->offset, size);
+    reader->offset += size;
+    return true;
+}
 
-    // Name length
-    u32 name_length = 0;
-    filesystem_read(ksm_file, sizeof(u32), &name_length, &bytes_read);
-    // Name + terminator
-    char name[256];
-    filesystem_read(ksm_file, sizeof(char) * name_length, name, &bytes_read);
+// Reads a length followed by that many characters, failing if they would not fit in a buffer of max_length.
+static b8 ksm_read_string(ksm_reader* reader, u32 max_length, char* out_string) {
+    u32 length = 0;
+    if (!ksm_read(reader, sizeof(u32), &length) || length > max_length) {
+        return false;
+    }
+    return ksm_read(reader, sizeof(char) * length, out_string);
+}
+
+static b8 ksm_read_geometry(ksm_reader* reader, u16 version, geometry_config* g) {
+    // How much space each of the center and extents take up.
+    u64 bounds_size = version == KSM_VERSION_FULL_VERTICES ? sizeof(vertex_3d) : sizeof(vec3);
 
-    // Geometry count
+    // Vertices (size/count/array)
+    if (!ksm_read(reader, sizeof(u32), &g->vertex_size) || !ksm_read(reader, sizeof(u32), &g->vertex_count)) {
+        return false;
+    }
+    u64 vertices_size = (u64)g->vertex_size * g->vertex_count;
+    if (vertices_size > reader->size - reader->offset) {
+        return false;
+    }
+    g->vertices = kallocate(vertices_size, MEMORY_TAG_ARRAY);
+    ksm_read(reader, vertices_size, g->vertices);
+
+    // Indices (size/count/array)
+    if (!ksm_read(reader, sizeof(u32), &g->index_size) || !ksm_read(reader, sizeof(u32), &g->index_count)) {
+        return false;
+    }
+    u64 indices_size = (u64)g->index_size * g->index_count;
+    if (indices_size > reader->size - reader->offset) {
+        return false;
+    }
+    g->indices = kallocate(indices_size, MEMORY_TAG_ARRAY);
+    ksm_read(reader, indices_size, g->indices);
+
+    // Name and material name
+    if (!ksm_read_string(reader, GEOMETRY_NAME_MAX_LENGTH, g->name) || !ksm_read_string(reader, MATERIAL_NAME_MAX_LENGTH, g->material_name)) {
+        return false;
+    }
+
+    // Center and extents (min/max), each read whole and only the vec3 at the start kept.
+    vertex_3d bounds;
+    if (!ksm_read(reader, bounds_size, &bounds)) {
+        return false;
+    }
+    g->center = bounds.position;
+    if (!ksm_read(reader, bounds_size, &bounds)) {
+        return false;
+    }
+    g->min_extents = bounds.position;
+    if (!ksm_read(reader, bounds_size, &bounds)) {
+        return false;
+    }
+    g->max_extents = bounds.position;
+
+    // Levels of detail (count/array). Older versions only have the full geometry.
+    if (version >= KSM_VERSION_LODS) {
+        u32 lod_count = 0;
+        if (!ksm_read(reader, sizeof(u32), &lod_count)) {
+            return false;
+        }
+        if (lod_count > GEOMETRY_MAX_LODS) {
+            KERROR("load_ksm_file - geometry '%s' has %u levels of detail, more than the max of %u.", g->name, lod_count, GEOMETRY_MAX_LODS);
+            return false;
+        }
+        g->lod_count = (u8)lod_count;
+        if (!ksm_read(reader, sizeof(geometry_lod) * lod_count, g->lods)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Reads a file of one of the versions before KSM_VERSION_MAPPED, copying the geometry data out of it.
+static b8 load_ksm_stream(const resource_file* file, const char* path, u16 version, geometry_config** out_geometries_darray) {
+    ksm_reader reader = {file->data, file->size, sizeof(u16)};
+
+    // Name + terminator, and geometry count
+    char name[256];
     u32 geometry_count = 0;
-    filesystem_read(ksm_file, sizeof(u32), &geometry_count, &bytes_read);
+    if (!ksm_read_string(&reader, sizeof(name), name) || !ksm_read(&reader, sizeof(u32), &geometry_count)) {
+        KERROR("load_ksm_file - '%s' is truncated.", path);
+        return false;
+    }
 
     // Each geometry
     for (u32 i = 0; i < geometry_count; ++i) {
         geometry_config g = {};
+        if (!ksm_read_geometry(&reader, version, &g)) {
+            KERROR("load_ksm_file - '%s' is truncated or corrupt at geometry %u.", path, i);
+            geometry_system_config_dispose(&g);
+            return false;
+        }
 
-        // Vertices (size/count/array)
-        filesystem_read(ksm_file, sizeof(u32), &g.vertex_size, &bytes_read);
-        filesystem_read(ksm_file, sizeof(u32), &g.vertex_count, &bytes_read);
-        g.vertices = kallocate(g.vertex_size * g.vertex_count, MEMORY_TAG_ARRAY);
-        filesystem_read(ksm_file, g.vertex_size * g.vertex_count, g.vertices, &bytes_read);
+        // Add to the output array.
+        darray_push(*out_geometries_darray, g);
+    }
 
-        // Indices (size/count/array)
-        filesystem_read(ksm_file, sizeof(u32), &g.index_size, &bytes_read);
-        filesystem_read(ksm_file, sizeof(u32), &g.index_count, &bytes_read);
-        g.indices = kallocate(g.index_size * g.index_count, MEMORY_TAG_ARRAY);
-        filesystem_read(ksm_file, g.index_size * g.index_count, g.indices, &bytes_read);
+    return true;
+}
 
-        // Name
-        u32 g_name_length = 0;
-        filesystem_read(ksm_file, sizeof(u32), &g_name_length, &bytes_read);
-        filesystem_read(ksm_file, sizeof(char) * g_name_length, g.name, &bytes_read);
+// Indicates if a block of size bytes at offset lies within a file of file_size bytes, on a KSM_BLOB_ALIGNMENT boundary.
+static b8 ksm_blob_valid(u64 file_size, u64 offset, u64 size) {
+    return offset % KSM_BLOB_ALIGNMENT == 0 && offset <= file_size && size <= file_size - offset;
+}
 
-        // Material Name
-        u32 m_name_length = 0;
-        filesystem_read(ksm_file, sizeof(u32), &m_name_length, &bytes_read);
-        filesystem_read(ksm_file, sizeof(char) * m_name_length, g.material_name, &bytes_read);
+// Groups byte b of each element together, for every b in turn.
+static void ksm_transpose(const u8* source, u64 element_count, u32 element_size, u8* out_data) {
+    for (u64 i = 0; i < element_count; ++i) {
+        for (u32 b = 0; b < element_size; ++b) {
+            out_data[b * element_count + i] = source[i * element_size + b];
+        }
+    }
+}
 
-        // Center
-        filesystem_read(ksm_file, sizeof(vertex_3d), &g.center, &bytes_read);
+// Undoes ksm_transpose.
+static void ksm_untranspose(const u8* source, u64 element_count, u32 element_size, u8* out_data) {
+    for (u32 b = 0; b < element_size; ++b) {
+        const u8* plane = source + b * element_count;
+        for (u64 i = 0; i < element_count; ++i) {
+            out_data[i * element_size + b] = plane[i];
+        }
+    }
+}
 
-        // Extents (min/max)
-        filesystem_read(ksm_file, sizeof(vertex_3d), &g.min_extents, &bytes_read);
-        filesystem_read(ksm_file, sizeof(vertex_3d), &g.max_extents, &bytes_read);
+// Replaces each index with its zigzag-encoded difference from the one before, in place.
+static void ksm_delta_encode(void* indices, u64 index_count, u32 index_size) {
+    if (index_size == sizeof(u32)) {
+        u32* typed = indices;
+        u32 previous = 0;
+        for (u64 i = 0; i < index_count; ++i) {
+            u32 delta = typed[i] - previous;
+            previous = typed[i];
+            typed[i] = (delta << 1) ^ (u32)((i32)delta >> 31);
+        }
+    } else {
+        u16* typed = indices;
+        u16 previous = 0;
+        for (u64 i = 0; i < index_count; ++i) {
+            u16 delta = (u16)(typed[i] - previous);
+            previous = typed[i];
+            typed[i] = (u16)((delta << 1) ^ (u16)((i16)delta >> 15));
+        }
+    }
+}
+
+// Undoes ksm_delta_encode, in place.
+static void ksm_delta_decode(void* indices, u64 index_count, u32 index_size) {
+    if (index_size == sizeof(u32)) {
+        u32* typed = indices;
+        u32 previous = 0;
+        for (u64 i = 0; i < index_count; ++i) {
+            u32 delta = (typed[i] >> 1) ^ (0 - (typed[i] & 1));
+            previous += delta;
+            typed[i] = previous;
+        }
+    } else {
+        u16* typed = indices;
+        u16 previous = 0;
+        for (u64 i = 0; i < index_count; ++i) {
+            u16 delta = (u16)((typed[i] >> 1) ^ (0 - (typed[i] & 1)));
+            previous = (u16)(previous + delta);
+            typed[i] = previous;
+        }
+    }
+}
+
+// A stream of vertices or indices, as it is to be written.
+typedef struct ksm_stream_data {
+    ksm_stream_entry entry;
+    // The bytes to be written, either the source or allocated.
+    const void* data;
+    // Memory allocated while preparing the stream, if any, and its size.
+    void* allocated;
+    u64 allocated_size;
+} ksm_stream_data;
+
+// Filters and compresses a stream, keeping the result only if it is meaningfully smaller.
+static void ksm_stream_encode(ksm_stream_data* stream, u64 element_count, u32 element_size, b8 is_index) {
+    u64 size = element_count * element_size;
+    if (size == 0) {
+        return;
+    }
+
+    ksm_stream_filter filter = is_index && (element_size == sizeof(u32) || element_size == sizeof(u16)) ? KSM_STREAM_FILTER_DELTA_TRANSPOSE : KSM_STREAM_FILTER_TRANSPOSE;
+    u8* filtered = kallocate(size, MEMORY_TAG_ARRAY);
+    if (filter == KSM_STREAM_FILTER_DELTA_TRANSPOSE) {
+        u8* deltas = kallocate(size, MEMORY_TAG_ARRAY);
+        kcopy_memory(deltas, stream->data, size);
+        ksm_delta_encode(deltas, element_count, element_size);
+        ksm_transpose(deltas, element_count, element_size, filtered);
+        kfree(deltas, size, MEMORY_TAG_ARRAY);
+    } else {
+        ksm_transpose(stream->data, element_count, element_size, filtered);
+    }
+
+    u64 bound = kcompress_lz4_bound(size);
+    u8* compressed = kallocate(bound, MEMORY_TAG_ARRAY);
+    u64 compressed_size = kcompress_lz4(filtered, size, compressed, bound);
+    kfree(filtered, size, MEMORY_TAG_ARRAY);
+    if (compressed_size == 0 || compressed_size > size - (u64)(size * KSM_STREAM_MIN_SAVING)) {
+        kfree(compressed, bound, MEMORY_TAG_ARRAY);
+        return;
+    }
+
+    if (stream->allocated) {
+        kfree(stream->allocated, stream->allocated_size, MEMORY_TAG_ARRAY);
+    }
+    stream->allocated = compressed;
+    stream->allocated_size = bound;
+    stream->data = compressed;
+    stream->entry.compression = KSM_STREAM_COMPRESSION_LZ4;
+    stream->entry.filter = filter;
+    stream->entry.stored_size = compressed_size;
+}
+
+// Indicates if a stream entry describes a stream which can be decoded into element_count elements of element_size.
+static b8 ksm_stream_valid(const ksm_stream_entry* stream, u64 element_count, u32 element_size, b8 is_index) {
+    u64 size = element_count * element_size;
+    if (stream->compression == KSM_STREAM_COMPRESSION_NONE) {
+        return stream->filter == KSM_STREAM_FILTER_NONE && stream->stored_size == size;
+    }
+    if (stream->compression != KSM_STREAM_COMPRESSION_LZ4) {
+        return false;
+    }
+    if (stream->filter == KSM_STREAM_FILTER_DELTA_TRANSPOSE) {
+        return is_index && (element_size == sizeof(u32) || element_size == sizeof(u16));
+    }
+    return stream->filter == KSM_STREAM_FILTER_NONE || stream->filter == KSM_STREAM_FILTER_TRANSPOSE;
+}
+
+// Decodes a stream checked by ksm_stream_valid into out_data, which holds element_count elements of element_size.
+static b8 ksm_stream_decode(const ksm_stream_entry* stream, const u8* stored, u64 element_count, u32 element_size, void* out_data) {
+    u64 size = element_count * element_size;
+    if (stream->compression == KSM_STREAM_COMPRESSION_NONE) {
+        kcopy_memory(out_data, stored, size);
+        return true;
+    }
+    if (stream->filter == KSM_STREAM_FILTER_NONE) {
+        return kdecompress_lz4(stored, stream->stored_size, out_data, size);
+    }
+
+    u8* filtered = kallocate(size, MEMORY_TAG_ARRAY);
+    b8 result = kdecompress_lz4(stored, stream->stored_size, filtered, size);
+    if (result) {
+        ksm_untranspose(filtered, element_count, element_size, out_data);
+        if (stream->filter == KSM_STREAM_FILTER_DELTA_TRANSPOSE) {
+            ksm_delta_decode(out_data, element_count, element_size);
+        }
+    }
+    kfree(filtered, size, MEMORY_TAG_ARRAY);
+    return result;
+}
+
+// Reads a KSM_VERSION_MAPPED or KSM_VERSION_COMPRESSED file. The vertices and indices of a mapped file are
+// used where they are if the contents are aligned, as those of loose files and uncompressed archive entries
+// are, in which case out_borrowed is set and the file must be kept open for as long as the geometries are
+// used. Compressed streams are decoded on the calling thread, which for meshes is a loader job's.
+static b8 load_ksm_mapped(const resource_file* file, const char* path, u16 version, geometry_config** out_geometries_darray, b8* out_borrowed) {
+    *out_borrowed = false;
+
+    // Copied out, as nothing says the contents are aligned for the header itself.
+    ksm_header header;
+    if (file->size < sizeof(ksm_header)) {
+        KERROR("load_ksm_file - '%s' is truncated.", path);
+        return false;
+    }
+    kcopy_memory(&header, file->data, sizeof(ksm_header));
+    u64 table_size = sizeof(ksm_geometry_entry) * (u64)header.geometry_count;
+    if (version == KSM_VERSION_COMPRESSED) {
+        table_size += sizeof(ksm_stream_entry) * 2 * (u64)header.geometry_count;
+    }
+    u64 meshlet_table_offset = header.geometry_table_offset + table_size;
+    if (header.flags & KSM_FLAG_MESHLETS) {
+        table_size += sizeof(ksm_meshlet_entry) * (u64)header.geometry_count;
+    }
+    if (header.geometry_table_offset > file->size || table_size > file->size - header.geometry_table_offset) {
+        KERROR("load_ksm_file - '%s' is truncated.", path);
+        return false;
+    }
+    const u8* data = file->data;
+    const u8* table = data + header.geometry_table_offset;
+    const u8* stream_table = table + sizeof(ksm_geometry_entry) * (u64)header.geometry_count;
+    const u8* meshlet_table = (header.flags & KSM_FLAG_MESHLETS) ? data + meshlet_table_offset : 0;
+
+    // Check every entry first, so nothing is added to the output unless all of it can be.
+    for (u32 i = 0; i < header.geometry_count; ++i) {
+        ksm_geometry_entry entry;
+        kcopy_memory(&entry, table + sizeof(ksm_geometry_entry) * i, sizeof(ksm_geometry_entry));
+        u64 vertices_stored_size = (u64)entry.vertex_size * entry.vertex_count;
+        u64 indices_stored_size = (u64)entry.index_size * entry.index_count;
+        b8 streams_valid = true;
+        if (version == KSM_VERSION_COMPRESSED) {
+            ksm_stream_entry streams[2];
+            kcopy_memory(streams, stream_table + sizeof(streams) * i, sizeof(streams));
+            streams_valid = ksm_stream_valid(&streams[0], entry.vertex_count, entry.vertex_size, false) &&
+                            ksm_stream_valid(&streams[1], entry.index_count, entry.index_size, true);
+            vertices_stored_size = streams[0].stored_size;
+            indices_stored_size = streams[1].stored_size;
+        }
+        ksm_meshlet_entry meshlets = {};
+        if (meshlet_table) {
+            kcopy_memory(&meshlets, meshlet_table + sizeof(ksm_meshlet_entry) * i, sizeof(ksm_meshlet_entry));
+        }
+        if (!streams_valid ||
+            (meshlets.count > 0 && !ksm_blob_valid(file->size, meshlets.offset, sizeof(geometry_meshlet) * (u64)meshlets.count)) ||
+            !ksm_blob_valid(file->size, entry.vertex_offset, vertices_stored_size) ||
+            !ksm_blob_valid(file->size, entry.index_offset, indices_stored_size) ||
+            entry.lod_count > GEOMETRY_MAX_LODS) {
+            KERROR("load_ksm_file - '%s' is truncated or corrupt at geometry %u.", path, i);
+            return false;
+        }
+    }
+
+    // Only whole files of uncompressed streams are borrowed, so that unloading can tell what to free.
+    b8 borrow = version == KSM_VERSION_MAPPED && ((u64)data % KSM_BLOB_ALIGNMENT) == 0;
+    u32 first = (u32)darray_length(*out_geometries_darray);
+    for (u32 i = 0; i < header.geometry_count; ++i) {
+        ksm_geometry_entry entry;
+        kcopy_memory(&entry, table + sizeof(ksm_geometry_entry) * i, sizeof(ksm_geometry_entry));
+
+        geometry_config g = {};
+        g.vertex_size = entry.vertex_size;
+        g.vertex_count = entry.vertex_count;
+        g.index_size = entry.index_size;
+        g.index_count = entry.index_count;
+        g.center = entry.center;
+        g.min_extents = entry.min_extents;
+        g.max_extents = entry.max_extents;
+        g.lod_count = (u8)entry.lod_count;
+        kcopy_memory(g.lods, entry.lods, sizeof(geometry_lod) * entry.lod_count);
+        string_ncopy(g.name, entry.name, GEOMETRY_NAME_MAX_LENGTH - 1);
+        string_ncopy(g.material_name, entry.material_name, MATERIAL_NAME_MAX_LENGTH - 1);
+
+        // Meshlets are small, so always copied, whether or not the rest is borrowed.
+        if (meshlet_table) {
+            ksm_meshlet_entry meshlets;
+            kcopy_memory(&meshlets, meshlet_table + sizeof(ksm_meshlet_entry) * i, sizeof(ksm_meshlet_entry));
+            if (meshlets.count > 0) {
+                g.meshlet_count = meshlets.count;
+                g.meshlets = kallocate(sizeof(geometry_meshlet) * meshlets.count, MEMORY_TAG_ARRAY);
+                kcopy_memory(g.meshlets, data + meshlets.offset, sizeof(geometry_meshlet) * meshlets.count);
+            }
+        }
+
+        if (borrow) {
+            g.vertices = (void*)(data + entry.vertex_offset);
+            g.indices = (void*)(data + entry.index_offset);
+        } else {
+            // Uncompressed streams are described as such, so this also copies mapped files.
+            ksm_stream_entry streams[2] = {
+                {KSM_STREAM_COMPRESSION_NONE, KSM_STREAM_FILTER_NONE, 0, (u64)entry.vertex_size * entry.vertex_count},
+                {KSM_STREAM_COMPRESSION_NONE, KSM_STREAM_FILTER_NONE, 0, (u64)entry.index_size * entry.index_count}};
+            if (version == KSM_VERSION_COMPRESSED) {
+                kcopy_memory(streams, stream_table + sizeof(streams) * i, sizeof(streams));
+            }
+            g.vertices = kallocate((u64)entry.vertex_size * entry.vertex_count, MEMORY_TAG_ARRAY);
+            g.indices = kallocate((u64)entry.index_size * entry.index_count, MEMORY_TAG_ARRAY);
+            if (!ksm_stream_decode(&streams[0], data + entry.vertex_offset, entry.vertex_count, entry.vertex_size, g.vertices) ||
+                !ksm_stream_decode(&streams[1], data + entry.index_offset, entry.index_count, entry.index_size, g.indices)) {
+                KERROR("load_ksm_file - '%s' has corrupt compressed data at geometry %u.", path, i);
+                geometry_system_config_dispose(&g);
+                // Take back the geometries already added.
+                u32 count = (u32)darray_length(*out_geometries_darray);
+                for (u32 j = first; j < count; ++j) {
+                    geometry_system_config_dispose(&(*out_geometries_darray)[j]);
+                }
+                darray_length_set(*out_geometries_darray, first);
+                return false;
+            }
+        }
 
         // Add to the output array.
         darray_push(*out_geometries_darray, g);
     }
 
-    filesystem_close(ksm_file);
-
+    *out_borrowed = borrow;
     return true;
 }
 
-b8 write_ksm_file(const char* path, const char* name, u32 geometry_count, geometry_config* geometries) {
-    if (filesystem_exists(path)) {
-        KINFO("File '%s' already exists and will be overwritten.", path);
-    }
+b8 load_ksm_file(const char* path, geometry_config** out_geometries_darray, resource_file** out_mapped_file) {
+    *out_mapped_file = 0;
 
-    file_handle f;
-    if (!filesystem_open(path, FILE_MODE_WRITE, true, &f)) {
-        KERROR("Unable to open file '%s' for writing. KSM write failed.", path);
+    // Read straight out of the file's contents, rather than through many small buffered reads.
+    resource_file* file = kallocate(sizeof(resource_file), MEMORY_TAG_RESOURCE);
+    if (!resource_system_file_open(path, file)) {
+        kfree(file, sizeof(resource_file), MEMORY_TAG_RESOURCE);
         return false;
     }
 
     // Version
-    u64 written = 0;
-    u16 version = 0x0001U;
-    filesystem_write(&f, sizeof(u16), &version, &written);
+    u16 version = 0;
+    if (file->size >= sizeof(u16)) {
+        kcopy_memory(&version, file->data, sizeof(u16));
+    }
 
-    // Name length
-    u32 name_length = string_length(name) + 1;
-    filesystem_write(&f, sizeof(u32), &name_length, &written);
-    // Name + terminator
-    filesystem_write(&f, sizeof(char) * name_length, name, &written);
+    b8 result = false;
+    b8 borrowed = false;
+    if (version == KSM_VERSION_MAPPED || version == KSM_VERSION_COMPRESSED) {
+        result = load_ksm_mapped(file, path, version, out_geometries_darray, &borrowed);
+    } else if (version == KSM_VERSION_FULL_VERTICES || version == KSM_VERSION_PACKED_VERTICES || version == KSM_VERSION_LODS) {
+        result = load_ksm_stream(file, path, version, out_geometries_darray);
+    } else {
+        KERROR("load_ksm_file - unsupported version %u.", version);
+    }
 
-    // Geometry count
-    filesystem_write(&f, sizeof(u32), &geometry_count, &written);
+    if (result && borrowed) {
+        *out_mapped_file = file;
+        return true;
+    }
 
-    // Each geometry
+    resource_system_file_close(file);
+    kfree(file, sizeof(resource_file), MEMORY_TAG_RESOURCE);
+    return result;
+}
+
+void* ksm_file_build(const char* name, u32 geometry_count, const geometry_config* geometries, b8 compress, u64* out_size) {
+    // Prepare the vertices then indices of each geometry as they are to be stored.
+    ksm_stream_data* streams = kallocate(sizeof(ksm_stream_data) * 2 * (u64)geometry_count, MEMORY_TAG_ARRAY);
+    b8 any_compressed = false;
+    for (u32 i = 0; i < geometry_count; ++i) {
+        const geometry_config* g = &geometries[i];
+        ksm_stream_data* vertices = &streams[i * 2];
+        ksm_stream_data* indices = &streams[i * 2 + 1];
+
+        // Vertices are packed so they are half the size on disk and ready to upload.
+        u32 vertex_size = g->vertex_size == sizeof(vertex_3d) ? sizeof(vertex_3d_packed) : g->vertex_size;
+        vertices->entry.stored_size = (u64)vertex_size * g->vertex_count;
+        vertices->data = g->vertices;
+        if (g->vertex_size == sizeof(vertex_3d)) {
+            vertices->allocated_size = vertices->entry.stored_size;
+            vertices->allocated = kallocate(vertices->allocated_size, MEMORY_TAG_ARRAY);
+            geometry_pack_vertices(g->vertex_count, g->vertices, vertices->allocated);
+            vertices->data = vertices->allocated;
+        }
+        indices->entry.stored_size = (u64)g->index_size * g->index_count;
+        indices->data = g->indices;
+
+        if (compress) {
+            ksm_stream_encode(vertices, g->vertex_count, vertex_size, false);
+            ksm_stream_encode(indices, g->index_count, g->index_size, true);
+            any_compressed |= vertices->entry.compression != KSM_STREAM_COMPRESSION_NONE || indices->entry.compression != KSM_STREAM_COMPRESSION_NONE;
+        }
+    }
+
+    // Files with nothing compressed are kept as KSM_VERSION_MAPPED, so they can still be used in place.
+    u16 version = any_compressed ? KSM_VERSION_COMPRESSED : KSM_VERSION_MAPPED;
+    u16 flags = 0;
     for (u32 i = 0; i < geometry_count; ++i) {
-        geometry_config* g = &geometries[i];
+        if (geometries[i].meshlet_count > 0) {
+            flags |= KSM_FLAG_MESHLETS;
+        }
+    }
 
-        // Vertices (size/count/array)
-        filesystem_write(&f, sizeof(u32), &g->vertex_size, &written);
-        filesystem_write(&f, sizeof(u32), &g->vertex_count, &written);
-        filesystem_write(&f, g->vertex_size * g->vertex_count, g->vertices, &written);
+    // Size everything up: the header, the tables, then each geometry's vertices, indices and meshlets.
+    u64 tables_size = sizeof(ksm_geometry_entry) * (u64)geometry_count;
+    if (version == KSM_VERSION_COMPRESSED) {
+        tables_size += sizeof(ksm_stream_entry) * 2 * (u64)geometry_count;
+    }
+    u64 meshlet_table_offset = sizeof(ksm_header) + tables_size;
+    if (flags & KSM_FLAG_MESHLETS) {
+        tables_size += sizeof(ksm_meshlet_entry) * (u64)geometry_count;
+    }
+    u64 size = sizeof(ksm_header) + tables_size;
+    for (u32 i = 0; i < geometry_count; ++i) {
+        size = get_aligned(size, KSM_BLOB_ALIGNMENT) + streams[i * 2].entry.stored_size;
+        size = get_aligned(size, KSM_BLOB_ALIGNMENT) + streams[i * 2 + 1].entry.stored_size;
+        if (geometries[i].meshlet_count > 0) {
+            size = get_aligned(size, KSM_BLOB_ALIGNMENT) + sizeof(geometry_meshlet) * (u64)geometries[i].meshlet_count;
+        }
+    }
 
-        // Indices (size/count/array)
-        filesystem_write(&f, sizeof(u32), &g->index_size, &written);
-        filesystem_write(&f, sizeof(u32), &g->index_count, &written);
-        filesystem_write(&f, g->index_size * g->index_count, g->indices, &written);
+    // Zeroed, so that any padding is too.
+    u8* data = kallocate_aligned(size, KSM_BLOB_ALIGNMENT, MEMORY_TAG_ARRAY);
 
-        // Name
-        u32 g_name_length = string_length(g->name) + 1;
-        filesystem_write(&f, sizeof(u32), &g_name_length, &written);
-        filesystem_write(&f, sizeof(char) * g_name_length, g->name, &written);
+    ksm_header header = {};
+    header.version = version;
+    header.flags = flags;
+    header.geometry_count = geometry_count;
+    header.geometry_table_offset = sizeof(ksm_header);
+    string_ncopy(header.name, name, sizeof(header.name) - 1);
 
-        // Material Name
-        u32 m_name_length = string_length(g->material_name) + 1;
-        filesystem_write(&f, sizeof(u32), &m_name_length, &written);
-        filesystem_write(&f, sizeof(char) * m_name_length, g->material_name, &written);
+    u8* stream_table = data + sizeof(ksm_header) + sizeof(ksm_geometry_entry) * (u64)geometry_count;
+    u64 offset = sizeof(ksm_header) + tables_size;
+    for (u32 i = 0; i < geometry_count; ++i) {
+        const geometry_config* g = &geometries[i];
+        const ksm_stream_data* vertices = &streams[i * 2];
+        const ksm_stream_data* indices = &streams[i * 2 + 1];
+        ksm_geometry_entry entry = {};
+        entry.vertex_size = g->vertex_size == sizeof(vertex_3d) ? sizeof(vertex_3d_packed) : g->vertex_size;
+        entry.vertex_count = g->vertex_count;
+        entry.index_size = g->index_size;
+        entry.index_count = g->index_count;
+        entry.center = g->center;
+        entry.min_extents = g->min_extents;
+        entry.max_extents = g->max_extents;
+        entry.lod_count = g->lod_count;
+        kcopy_memory(entry.lods, g->lods, sizeof(geometry_lod) * g->lod_count);
+        string_ncopy(entry.name, g->name, GEOMETRY_NAME_MAX_LENGTH - 1);
+        string_ncopy(entry.material_name, g->material_name, MATERIAL_NAME_MAX_LENGTH - 1);
+
+        // Vertices
+        offset = get_aligned(offset, KSM_BLOB_ALIGNMENT);
+        entry.vertex_offset = offset;
+        kcopy_memory(data + offset, vertices->data, vertices->entry.stored_size);
+        offset += vertices->entry.stored_size;
+
+        // Indices
+        offset = get_aligned(offset, KSM_BLOB_ALIGNMENT);
+        entry.index_offset = offset;
+        kcopy_memory(data + offset, indices->data, indices->entry.stored_size);
+        offset += indices->entry.stored_size;
+
+        // Meshlets
+        if (flags & KSM_FLAG_MESHLETS) {
+            ksm_meshlet_entry meshlets = {};
+            if (g->meshlet_count > 0) {
+                offset = get_aligned(offset, KSM_BLOB_ALIGNMENT);
+                meshlets.offset = offset;
+                meshlets.count = g->meshlet_count;
+                kcopy_memory(data + offset, g->meshlets, sizeof(geometry_meshlet) * g->meshlet_count);
+                offset += sizeof(geometry_meshlet) * g->meshlet_count;
+            }
+            kcopy_memory(data + meshlet_table_offset + sizeof(ksm_meshlet_entry) * i, &meshlets, sizeof(ksm_meshlet_entry));
+        }
 
-        // Center
-        filesystem_write(&f, sizeof(vertex_3d), &g->center, &written);
+        kcopy_memory(data + sizeof(ksm_header) + sizeof(ksm_geometry_entry) * i, &entry, sizeof(ksm_geometry_entry));
+        if (version == KSM_VERSION_COMPRESSED) {
+            kcopy_memory(stream_table + sizeof(ksm_stream_entry) * 2 * i, &vertices->entry, sizeof(ksm_stream_entry));
+            kcopy_memory(stream_table + sizeof(ksm_stream_entry) * (2 * i + 1), &indices->entry, sizeof(ksm_stream_entry));
+        }
 
-        // Extents (min/max)
-        filesystem_write(&f, sizeof(vertex_3d), &g->min_extents, &written);
-        filesystem_write(&f, sizeof(vertex_3d), &g->max_extents, &written);
+        // The extents of the whole mesh.
+        for (u32 e = 0; e < 3; ++e) {
+            header.min_extents.elements[e] = i == 0 ? g->min_extents.elements[e] : KMIN(header.min_extents.elements[e], g->min_extents.elements[e]);
+            header.max_extents.elements[e] = i == 0 ? g->max_extents.elements[e] : KMAX(header.max_extents.elements[e], g->max_extents.elements[e]);
+        }
     }
+    kcopy_memory(data, &header, sizeof(ksm_header));
 
-    filesystem_close(&f);
+    for (u32 i = 0; i < geometry_count * 2; ++i) {
+        if (streams[i].allocated) {
+            kfree(streams[i].allocated, streams[i].allocated_size, MEMORY_TAG_ARRAY);
+        }
+    }
+    kfree(streams, sizeof(ksm_stream_data) * 2 * (u64)geometry_count, MEMORY_TAG_ARRAY);
 
-    return true;
+    *out_size = size;
+    return data;
 }
 
-/**
- * @brief Imports an obj file. This reads the obj, creates geometry configs, then calls logic to write
- * those geometries out to a binary ksm file. That file can be used on the next load.
- *
- * @param obj_file A pointer to the obj file handle to be read.
- * @param out_ksm_filename The path to the ksm file to be written to.
- * @param out_geometries_darray A darray of geometries parsed from the file.
- * @return True on success; otherwise false.
- */
-b8 import_obj_file(file_handle* obj_file, const char* out_ksm_filename, geometry_config** out_geometries_darray) {
-    // Positions
-    vec3* positions = darray_reserve(vec3, 16384);
+b8 write_ksm_file(const char* path, const char* name, u32 geometry_count, geometry_config* geometries, b8 compress) {
+    if (filesystem_exists(path)) {
+        KINFO("File '%s' already exists and will be overwritten.", path);
+    }
 
-    // Normals
-    vec3* normals = darray_reserve(vec3, 16384);
+    // Laid out whole in memory, then written at once.
+    u64 size = 0;
+    void* data = ksm_file_build(name, geometry_count, geometries, compress, &size);
 
-    // Normals
-    vec2* tex_coords = darray_reserve(vec2, 16384);
+    file_handle f;
+    if (!filesystem_open(path, FILE_MODE_WRITE, true, &f)) {
+        KERROR("Unable to open file '%s' for writing. KSM write failed.", path);
+        kfree_aligned(data, size, KSM_BLOB_ALIGNMENT, MEMORY_TAG_ARRAY);
+        return false;
+    }
 
-    // Groups
-    mesh_group_data* groups = darray_reserve(mesh_group_data, 4);
+    u64 written = 0;
+    b8 result = filesystem_write(&f, size, data, &written) && written == size;
+    if (!result) {
+        KERROR("Unable to write all of file '%s'. KSM write failed.", path);
+    }
 
-    char material_file_name[512] = "";
+    filesystem_close(&f);
+    kfree_aligned(data, size, KSM_BLOB_ALIGNMENT, MEMORY_TAG_ARRAY);
 
-    char name[512];
-    kzero_memory(name, sizeof(char) * 512);
-    u8 current_mat_name_count = 0;
-    char material_names[32][64];
+    return result;
+}
 
-    char line_buf[512] = "";
-    char* p = &line_buf[0];
-    u64 line_length = 0;
+b8 ksm_file_convert(const char* source_path, const char* out_path, b8 compress) {
+    geometry_config* geometries = darray_create(geometry_config);
+    resource_file* mapped_file = 0;
+    if (!load_ksm_file(source_path, &geometries, &mapped_file)) {
+        KERROR("ksm_file_convert - unable to load '%s'.", source_path);
+        darray_destroy(geometries);
+        return false;
+    }
 
-    // index 0 is previous, 1 is previous before that.
-    char prev_first_chars[2] = {0, 0};
-    while (true) {
-        if (!filesystem_read_line(obj_file, 511, &p, &line_length)) {
-            break;
+    u32 count = (u32)darray_length(geometries);
+    char name[256];
+    string_filename_no_extension_from_path(name, source_path);
+    b8 result = write_ksm_file(out_path, name, count, geometries, compress);
+
+    for (u32 i = 0; i < count; ++i) {
+        if (mapped_file) {
+            geometries[i].vertices = 0;
+            geometries[i].indices = 0;
         }
+        geometry_system_config_dispose(&geometries[i]);
+    }
+    darray_destroy(geometries);
+    if (mapped_file) {
+        resource_system_file_close(mapped_file);
+        kfree(mapped_file, sizeof(resource_file), MEMORY_TAG_RESOURCE);
+    }
+    return result;
+}
 
-        // Skip blank lines.
-        if (line_length < 1) {
-            continue;
+// Simplifies the given geometry into coarser levels of detail, which are appended after its own indices.
+static void obj_geometry_generate_lods(geometry_config* g) {
+    u32 full_count = g->index_count;
+    g->lod_count = 1;
+    g->lods[0] = (geometry_lod){0, full_count, 0.0f};
+
+    // Every level fits in the space of the full geometry, and there are at most GEOMETRY_MAX_LODS - 1 of them.
+    u32* lod_indices = kallocate(sizeof(u32) * full_count * GEOMETRY_MAX_LODS, MEMORY_TAG_ARRAY);
+    kcopy_memory(lod_indices, g->indices, sizeof(u32) * full_count);
+    u32 total_count = full_count;
+    for (u32 l = 1; l < GEOMETRY_MAX_LODS; ++l) {
+        u32 previous_count = g->lods[l - 1].index_count;
+        u32 target_count = (u32)(previous_count * OBJ_LOD_REDUCTION);
+        f32 error = 0.0f;
+        // Simplified from the full geometry each time, so that errors do not build up.
+        u32 count = geometry_simplify(g->vertex_count, g->vertices, full_count, g->indices, target_count, OBJ_LOD_MAX_ERROR, &lod_indices[total_count], &error);
+        if (count == 0 || count > previous_count * 0.8f) {
+            // Not worth another level.
+            break;
         }
+        geometry_optimize_vertex_cache(g->vertex_count, count, &lod_indices[total_count], GEOMETRY_VERTEX_CACHE_SIZE);
+        g->lods[l] = (geometry_lod){total_count, count, error};
+        g->lod_count++;
+        total_count += count;
+        KDEBUG("Geometry '%s' LOD %u has %u triangles, with an error of %.4f.", g->name, l, count / 3, error);
+    }
 
-        char first_char = line_buf[0];
+    kfree(g->indices, sizeof(u32) * full_count, MEMORY_TAG_ARRAY);
+    g->indices = kallocate(sizeof(u32) * total_count, MEMORY_TAG_ARRAY);
+    kcopy_memory(g->indices, lod_indices, sizeof(u32) * total_count);
+    g->index_count = total_count;
+    kfree(lod_indices, sizeof(u32) * full_count * GEOMETRY_MAX_LODS, MEMORY_TAG_ARRAY);
+}
 
-        switch (first_char) {
-            case '#':
-                // Skip comments
+// Welds the vertices of the given geometry, generates its tangents and optimizes its order for the GPU.
+static void obj_geometry_finalize(geometry_config* g) {
+    KDEBUG("Geometry de-duplication process starting on geometry object named '%s'...", g->name);
+
+    u32 new_vert_count = 0;
+    vertex_3d* unique_verts = 0;
+    geometry_deduplicate_vertices(g->vertex_count, g->vertices, g->index_count, g->indices, &new_vert_count, &unique_verts);
+
+    // Destroy the old, large array...
+    darray_destroy(g->vertices);
+
+    // And replace with the de-duplicated one.
+    g->vertices = unique_verts;
+    g->vertex_count = new_vert_count;
+
+    // Take a copy of the indices as a normal, non-darray
+    u32* indices = kallocate(sizeof(u32) * g->index_count, MEMORY_TAG_ARRAY);
+    kcopy_memory(indices, g->indices, sizeof(u32) * g->index_count);
+    // Destroy the darray
+    darray_destroy(g->indices);
+    // Replace with the non-darray version.
+    g->indices = indices;
+
+    // Also generate tangents here, this way tangents are also stored in the output file.
+    geometry_generate_tangents(g->vertex_count, g->vertices, g->index_count, g->indices);
+
+    // Reorder triangles for the vertex cache and then for less overdraw.
+    f32 acmr_before = geometry_acmr(g->vertex_count, g->index_count, g->indices, GEOMETRY_VERTEX_CACHE_SIZE);
+    geometry_optimize_vertex_cache(g->vertex_count, g->index_count, g->indices, GEOMETRY_VERTEX_CACHE_SIZE);
+    geometry_optimize_overdraw(g->vertex_count, g->vertices, g->index_count, g->indices, GEOMETRY_VERTEX_CACHE_SIZE);
+    f32 acmr_after = geometry_acmr(g->vertex_count, g->index_count, g->indices, GEOMETRY_VERTEX_CACHE_SIZE);
+    KDEBUG("Geometry '%s' optimized, ACMR %.3f -> %.3f.", g->name, acmr_before, acmr_after);
+
+    obj_geometry_generate_lods(g);
+
+    // Then reorder vertices to match, over every level of detail.
+    geometry_optimize_vertex_fetch(g->vertex_count, g->vertices, g->index_count, g->indices);
+
+    // Large geometries are split into meshlets, so parts of them can be culled. Only the full level of
+    // detail is, as the others are for when the geometry is small on screen. It is first in the indices.
+    if (g->lods[0].index_count / 3 >= OBJ_MESHLET_MIN_TRIANGLES) {
+        g->meshlet_count = geometry_build_meshlets(g->vertex_count, g->vertices, g->lods[0].index_count, g->indices, GEOMETRY_MESHLET_MAX_VERTICES, GEOMETRY_MESHLET_MAX_TRIANGLES, &g->meshlets);
+        KDEBUG("Geometry '%s' split into %u meshlets.", g->name, g->meshlet_count);
+    }
+}
+
+/**
+ * @brief Parses one "p", "p/t", "p//n" or "p/t/n" face vertex from the front of the given text.
+ * Indices which are not present are left as they were.
+ */
+static b8 obj_parse_face_vertex(kstring_view* text, mesh_vertex_index_data* out_vertex) {
+    kstring_view token;
+    i32 index = 0;
+    if (!string_view_next_token(text, &token) || !string_view_parse_i32(&token, &index)) {
+        return false;
+    }
+    out_vertex->position_index = (u32)index;
+    if (token.length && token.str[0] == '/') {
+        token = string_view_mid(token, 1, -1);
+        if (string_view_parse_i32(&token, &index)) {
+            out_vertex->texcoord_index = (u32)index;
+        }
+        if (token.length && token.str[0] == '/') {
+            token = string_view_mid(token, 1, -1);
+            if (string_view_parse_i32(&token, &index)) {
+                out_vertex->normal_index = (u32)index;
+            }
+        }
+    }
+    return true;
+}
+
+// The approximate size of each chunk of an obj file parsed on its own. Each is cut at the next line boundary.
+#define OBJ_PARSE_CHUNK_SIZE KIBIBYTES(256)
+
+// The statements which change how the faces after them are grouped.
+typedef enum obj_statement_type {
+    OBJ_STATEMENT_MTLLIB,
+    OBJ_STATEMENT_USEMTL,
+    OBJ_STATEMENT_GROUP
+} obj_statement_type;
+
+// A grouping statement, found while parsing a chunk.
+typedef struct obj_statement {
+    obj_statement_type type;
+    // The number of faces of the chunk before the statement.
+    u64 face_index;
+    // The rest of the line, as a view of the file.
+    kstring_view argument;
+} obj_statement;
+
+// A chunk of an obj file and what was parsed from it. Vertex data holds the same indices wherever it
+// is found in the file, so positions, normals and texture coordinates are simply joined up afterwards,
+// while faces are grouped by replaying the statements of each chunk in order.
+typedef struct obj_chunk {
+    kstring_view text;
+    // darrays, on the heap as they outlive the job thread which fills them.
+    vec3* positions;
+    vec3* normals;
+    vec2* tex_coords;
+    mesh_face_data* faces;
+    obj_statement* statements;
+} obj_chunk;
+
+// Parses each of the given chunks. Safe to run on several threads at once.
+static void obj_chunks_parse(u32 start, u32 end, void* user_data) {
+    obj_chunk* chunks = user_data;
+    for (u32 c = start; c < end; ++c) {
+        obj_chunk* chunk = &chunks[c];
+        chunk->positions = darray_create(vec3);
+        chunk->normals = darray_create(vec3);
+        chunk->tex_coords = darray_create(vec2);
+        chunk->faces = darray_create(mesh_face_data);
+        chunk->statements = darray_create(obj_statement);
+
+        // Each line is parsed in place, as views of the file.
+        kstring_view text = chunk->text;
+        kstring_view line;
+        while (string_view_next_line(&text, &line)) {
+            kstring_view rest = line;
+            kstring_view keyword;
+            // Skip blank lines and comments.
+            if (!string_view_next_token(&rest, &keyword) || keyword.str[0] == '#') {
                 continue;
-            case 'v': {
-                char second_char = line_buf[1];
-                switch (second_char) {
-                    case ' ': {
-                        // Vertex position
-                        vec3 pos;
-                        char t[2];
-                        sscanf(
-                            line_buf,
-                            "%s %f %f %f",
-                            t,
-                            &pos.x,
-                            &pos.y,
-                            &pos.z);
-
-                        darray_push(positions, pos);
-                    } break;
-                    case 'n': {
-                        // Vertex normal
-                        vec3 norm;
-                        char t[2];
-                        sscanf(
-                            line_buf,
-                            "%s %f %f %f",
-                            t,
-                            &norm.x,
-                            &norm.y,
-                            &norm.z);
-
-                        darray_push(normals, norm);
-                    } break;
-                    case 't': {
-                        // Vertex texture coords.
-                        vec2 tex_coord;
-                        char t[2];
-
-                        // NOTE: Ignoring Z if present.
-                        sscanf(
-                            line_buf,
-                            "%s %f %f",
-                            t,
-                            &tex_coord.x,
-                            &tex_coord.y);
-
-                        darray_push(tex_coords, tex_coord);
-                    } break;
-                }
-            } break;
-            case 's': {
-            } break;
-            case 'f': {
+            }
+
+            if (string_view_equal(keyword, "v")) {
+                // Vertex position
+                vec3 pos = vec3_zero();
+                string_view_parse_f32(&rest, &pos.x);
+                string_view_parse_f32(&rest, &pos.y);
+                string_view_parse_f32(&rest, &pos.z);
+
+                darray_push(chunk->positions, pos);
+            } else if (string_view_equal(keyword, "vn")) {
+                // Vertex normal
+                vec3 norm = vec3_zero();
+                string_view_parse_f32(&rest, &norm.x);
+                string_view_parse_f32(&rest, &norm.y);
+                string_view_parse_f32(&rest, &norm.z);
+
+                darray_push(chunk->normals, norm);
+            } else if (string_view_equal(keyword, "vt")) {
+                // Vertex texture coords.
+                // NOTE: Ignoring Z if present.
+                vec2 tex_coord = vec2_zero();
+                string_view_parse_f32(&rest, &tex_coord.x);
+                string_view_parse_f32(&rest, &tex_coord.y);
+
+                darray_push(chunk->tex_coords, tex_coord);
+            } else if (string_view_equal(keyword, "f")) {
                 // face
                 // f 1/1/1 2/2/2 3/3/3  = pos/tex/norm pos/tex/norm pos/tex/norm
-                mesh_face_data face;
-                char t[2];
-
-                u64 normal_count = darray_length(normals);
-                u64 tex_coord_count = darray_length(tex_coords);
-
-                if (normal_count == 0 || tex_coord_count == 0) {
-                    sscanf(
-                        line_buf,
-                        "%s %d %d %d",
-                        t,
-                        &face.vertices[0].position_index,
-                        &face.vertices[1].position_index,
-                        &face.vertices[2].position_index);
-                } else {
-                    sscanf(
-                        line_buf,
-                        "%s %d/%d/%d %d/%d/%d %d/%d/%d",
-                        t,
-                        &face.vertices[0].position_index,
-                        &face.vertices[0].texcoord_index,
-                        &face.vertices[0].normal_index,
-
-                        &face.vertices[1].position_index,
-                        &face.vertices[1].texcoord_index,
-                        &face.vertices[1].normal_index,
-
-                        &face.vertices[2].position_index,
-                        &face.vertices[2].texcoord_index,
-                        &face.vertices[2].normal_index);
+                mesh_face_data face = {};
+                for (u32 i = 0; i < 3; ++i) {
+                    obj_parse_face_vertex(&rest, &face.vertices[i]);
                 }
-                u64 group_index = darray_length(groups) - 1;
-                darray_push(groups[group_index].faces, face);
-            } break;
-            case 'm': {
-                // Material library file.
-                char substr[7];
-
-                sscanf(
-                    line_buf,
-                    "%s %s",
-                    substr,
-                    material_file_name);
-
-                // If found, save off the material file name.
-                if (strings_nequali(substr, "mtllib", 6)) {
-                    // TODO: verification
-                }
-            } break;
-            case 'u': {
-                // Any time there is a usemtl, assume a new group.
-                // New named group or smoothing group, all faces coming after should be added to it.
-                mesh_group_data new_group;
-                new_group.faces = darray_reserve(mesh_face_data, 16384);
-                darray_push(groups, new_group);
-
-                // usemtl
-                // Read the material name.
-                char t[8];
-                sscanf(line_buf, "%s %s", t, material_names[current_mat_name_count]);
-                current_mat_name_count++;
-            } break;
-            case 'g': {
-                u64 group_count = darray_length(groups);
-                // Process each group as a subobject.
-                for (u64 i = 0; i < group_count; ++i) {
-                    geometry_config new_data = {};
-                    string_ncopy(new_data.name, name, 255);
-                    if (i > 0) {
-                        string_append_int(new_data.name, new_data.name, i);
-                    }
-                    string_ncopy(new_data.material_name, material_names[i], 255);
-
-                    process_subobject(positions, normals, tex_coords, groups[i].faces, &new_data);
-                    new_data.vertex_count = darray_length(new_data.vertices);
-                    new_data.vertex_size = sizeof(vertex_3d);
-                    new_data.index_count = darray_length(new_data.indices);
-                    new_data.index_size = sizeof(u32);
-
-                    darray_push(*out_geometries_darray, new_data);
-
-                    // Increment the number of objects.
-                    darray_destroy(groups[i].faces);
-                    kzero_memory(material_names[i], 64);
-                }
-
-                current_mat_name_count = 0;
-                darray_clear(groups);
-                kzero_memory(name, 512);
-
-                // Read the name
-                char t[2];
-                sscanf(line_buf, "%s %s", t, name);
-
-            } break;
-        }
+                darray_push(chunk->faces, face);
+            } else if (string_view_equal(keyword, "mtllib") || string_view_equal(keyword, "usemtl") || string_view_equal(keyword, "g")) {
+                obj_statement statement;
+                statement.type = string_view_equal(keyword, "mtllib") ? OBJ_STATEMENT_MTLLIB : string_view_equal(keyword, "usemtl") ? OBJ_STATEMENT_USEMTL
+                                                                                                                                   : OBJ_STATEMENT_GROUP;
+                statement.face_index = darray_length(chunk->faces);
+                statement.argument = rest;
+                darray_push(chunk->statements, statement);
+            }
+        }  // each line
+    }
+}
 
-        prev_first_chars[1] = prev_first_chars[0];
-        prev_first_chars[0] = first_char;
-    }  // each line
+// The sub-objects of an obj file, each processed into the geometry at the same index.
+typedef struct obj_subobjects {
+    vec3* positions;
+    vec3* normals;
+    vec2* tex_coords;
+    // darray of darrays, one per geometry.
+    mesh_face_data** faces;
+    geometry_config* geometries;
+} obj_subobjects;
+
+// Builds, welds and optimizes each of the given sub-objects. Safe to run on several threads at once.
+static void obj_subobjects_process(u32 start, u32 end, void* user_data) {
+    obj_subobjects* subobjects = user_data;
+    for (u32 i = start; i < end; ++i) {
+        // The intermediate vertices and indices live on this thread's scratch allocator until replaced.
+        linear_allocator* scratch = scratch_allocator_get();
+        linear_allocator_marker scratch_marker = linear_allocator_get_marker(scratch);
+
+        geometry_config* g = &subobjects->geometries[i];
+        process_subobject(subobjects->positions, subobjects->normals, subobjects->tex_coords, subobjects->faces[i], g);
+        g->vertex_count = darray_length(g->vertices);
+        g->vertex_size = sizeof(vertex_3d);
+        g->index_count = darray_length(g->indices);
+        g->index_size = sizeof(u32);
+
+        obj_geometry_finalize(g);
+
+        linear_allocator_free_to_marker(scratch, scratch_marker);
+    }
+}
 
-    // Process the remaining group since the last one will not have been trigged
-    // by the finding of a new name.
-    // Process each group as a subobject.
-    u64 group_count = darray_length(groups);
+// The state of grouping faces into sub-objects, as the statements of each chunk are replayed.
+typedef struct obj_grouping {
+    linear_allocator* scratch;
+    // The groups of the current object, each with its own material.
+    mesh_group_data* groups;
+    u8 material_count;
+    char material_names[32][64];
+    char name[512];
+    char material_file_name[512];
+    // The sub-objects found so far, and the faces of each.
+    geometry_config** geometries;
+    mesh_face_data*** faces;
+} obj_grouping;
+
+// Turns each group of the current object into a sub-object, ready to be processed.
+static void obj_grouping_flush(obj_grouping* grouping) {
+    u64 group_count = darray_length(grouping->groups);
     for (u64 i = 0; i < group_count; ++i) {
         geometry_config new_data = {};
-        string_ncopy(new_data.name, name, 255);
+        string_ncopy(new_data.name, grouping->name, 255);
         if (i > 0) {
             string_append_int(new_data.name, new_data.name, i);
         }
-        string_ncopy(new_data.material_name, material_names[i], 255);
+        string_ncopy(new_data.material_name, grouping->material_names[i], 255);
 
-        process_subobject(positions, normals, tex_coords, groups[i].faces, &new_data);
-        new_data.vertex_count = darray_length(new_data.vertices);
-        new_data.vertex_size = sizeof(vertex_3d);
-        new_data.index_count = darray_length(new_data.indices);
-        new_data.index_size = sizeof(u32);
+        darray_push(*grouping->geometries, new_data);
+        darray_push(*grouping->faces, grouping->groups[i].faces);
+        kzero_memory(grouping->material_names[i], 64);
+    }
+    grouping->material_count = 0;
+    darray_clear(grouping->groups);
+}
 
-        darray_push(*out_geometries_darray, new_data);
+// Adds a run of faces to the current group, starting one if there is none yet.
+static void obj_grouping_add_faces(obj_grouping* grouping, const mesh_face_data* faces, u64 count) {
+    if (count == 0) {
+        return;
+    }
+    if (darray_length(grouping->groups) == 0) {
+        KWARN("Faces found before any material is used. They are given no material.");
+        mesh_group_data new_group;
+        new_group.faces = darray_reserve_with_allocator(mesh_face_data, 16384, grouping->scratch);
+        darray_push(grouping->groups, new_group);
+        grouping->material_count = 1;
+    }
+    u64 group_index = darray_length(grouping->groups) - 1;
+    darray_push_range(grouping->groups[group_index].faces, faces, count);
+}
 
-        // Increment the number of objects.
-        darray_destroy(groups[i].faces);
+static void obj_grouping_apply(obj_grouping* grouping, const obj_statement* statement) {
+    switch (statement->type) {
+        case OBJ_STATEMENT_MTLLIB:
+            // Material library file. Save off the material file name.
+            // TODO: verification
+            string_view_copy(grouping->material_file_name, string_view_trim(statement->argument), sizeof(grouping->material_file_name));
+            break;
+        case OBJ_STATEMENT_USEMTL: {
+            if (grouping->material_count >= 32) {
+                KWARN("Object '%s' uses more than 32 materials. The faces after are kept with the last.", grouping->name);
+                break;
+            }
+            // Any time there is a usemtl, assume a new group.
+            // New named group or smoothing group, all faces coming after should be added to it.
+            mesh_group_data new_group;
+            new_group.faces = darray_reserve_with_allocator(mesh_face_data, 16384, grouping->scratch);
+            darray_push(grouping->groups, new_group);
+
+            // Read the material name.
+            string_view_copy(grouping->material_names[grouping->material_count], string_view_trim(statement->argument), 64);
+            grouping->material_count++;
+        } break;
+        case OBJ_STATEMENT_GROUP:
+            // Process each group as a subobject.
+            obj_grouping_flush(grouping);
+            kzero_memory(grouping->name, 512);
+
+            // Read the name
+            string_view_copy(grouping->name, string_view_trim(statement->argument), sizeof(grouping->name));
+            break;
     }
+}
 
-    darray_destroy(groups);
-    darray_destroy(positions);
-    darray_destroy(normals);
-    darray_destroy(tex_coords);
+/**
+ * @brief Imports an obj file. This reads the obj, creates geometry configs, then calls logic to write
+ * those geometries out to a binary ksm file. That file can be used on the next load.
+ * @details The file is split into chunks at line boundaries, which are parsed in parallel. The chunks are
+ * then joined up in order on the calling thread, and each sub-object processed in parallel.
+ *
+ * @param obj_file A constant pointer to the obj file to be read, opened through the resource system.
+ * @param out_ksm_filename The path to the ksm file to be written to.
+ * @param out_geometries_darray A darray of geometries parsed from the file.
+ * @return True on success; otherwise false.
+ */
+b8 import_obj_file(const resource_file* obj_file, const char* out_ksm_filename, geometry_config** out_geometries_darray) {
+    // All intermediate data lives on this thread's scratch allocator, and is freed at once when done.
+    linear_allocator* scratch = scratch_allocator_get();
+    linear_allocator_marker scratch_marker = linear_allocator_get_marker(scratch);
+
+    // Split the file into chunks, each ending at the end of a line.
+    const char* text = obj_file->data;
+    u64 size = obj_file->size;
+    u32 chunk_count = 0;
+    obj_chunk* chunks = darray_reserve_with_allocator(obj_chunk, size / OBJ_PARSE_CHUNK_SIZE + 1, scratch);
+    for (u64 offset = 0; offset < size;) {
+        u64 chunk_end = KMIN(size, offset + OBJ_PARSE_CHUNK_SIZE);
+        while (chunk_end < size && text[chunk_end - 1] != '\n') {
+            chunk_end++;
+        }
+        obj_chunk chunk = {};
+        chunk.text = string_view_from(text + offset, chunk_end - offset);
+        darray_push(chunks, chunk);
+        chunk_count++;
+        offset = chunk_end;
+    }
+
+    job_system_parallel_for(chunk_count, 1, obj_chunks_parse, chunks);
 
-    if (string_length(material_file_name) > 0) {
+    // Join up the vertex data of every chunk.
+    u64 position_count = 0;
+    u64 normal_count = 0;
+    u64 tex_coord_count = 0;
+    for (u32 c = 0; c < chunk_count; ++c) {
+        position_count += darray_length(chunks[c].positions);
+        normal_count += darray_length(chunks[c].normals);
+        tex_coord_count += darray_length(chunks[c].tex_coords);
+    }
+    vec3* positions = darray_reserve_with_allocator(vec3, position_count, scratch);
+    vec3* normals = darray_reserve_with_allocator(vec3, normal_count, scratch);
+    vec2* tex_coords = darray_reserve_with_allocator(vec2, tex_coord_count, scratch);
+
+    // Group the faces of every chunk by replaying its statements, in the order they are in the file.
+    obj_grouping grouping_state = {};
+    obj_grouping* grouping = &grouping_state;
+    grouping->scratch = scratch;
+    grouping->groups = darray_reserve_with_allocator(mesh_group_data, 4, scratch);
+    grouping->geometries = out_geometries_darray;
+    mesh_face_data** faces = darray_reserve_with_allocator(mesh_face_data*, 16, scratch);
+    grouping->faces = &faces;
+    u32 first_geometry = (u32)darray_length(*out_geometries_darray);
+    for (u32 c = 0; c < chunk_count; ++c) {
+        obj_chunk* chunk = &chunks[c];
+        darray_push_range(positions, chunk->positions, darray_length(chunk->positions));
+        darray_push_range(normals, chunk->normals, darray_length(chunk->normals));
+        darray_push_range(tex_coords, chunk->tex_coords, darray_length(chunk->tex_coords));
+
+        u64 face_index = 0;
+        u64 statement_count = darray_length(chunk->statements);
+        for (u64 s = 0; s < statement_count; ++s) {
+            const obj_statement* statement = &chunk->statements[s];
+            obj_grouping_add_faces(grouping, &chunk->faces[face_index], statement->face_index - face_index);
+            face_index = statement->face_index;
+            obj_grouping_apply(grouping, statement);
+        }
+        obj_grouping_add_faces(grouping, &chunk->faces[face_index], darray_length(chunk->faces) - face_index);
+
+        darray_destroy(chunk->positions);
+        darray_destroy(chunk->normals);
+        darray_destroy(chunk->tex_coords);
+        darray_destroy(chunk->faces);
+        darray_destroy(chunk->statements);
+    }
+
+    // Process the remaining group since the last one will not have been trigged
+    // by the finding of a new name.
+    obj_grouping_flush(grouping);
+
+    // The materials written from the material library, kept to list their textures in the manifest.
+    material_config* library = darray_create(material_config);
+    if (string_length(grouping->material_file_name) > 0) {
         // Load up the material file
         char full_mtl_path[512];
         kzero_memory(full_mtl_path, sizeof(char) * 512);
         string_directory_from_path(full_mtl_path, out_ksm_filename);
-        string_append_string(full_mtl_path, full_mtl_path, material_file_name);
+        string_append_string(full_mtl_path, full_mtl_path, grouping->material_file_name);
 
         // Process material library file.
-        if (!import_obj_material_library_file(full_mtl_path)) {
+        if (!import_obj_material_library_file(full_mtl_path, &library)) {
             KERROR("Error reading obj mtl file.");
         }
     }
 
-    // De-duplicate geometry
-    u32 count = darray_length(*out_geometries_darray);
-    for (u64 i = 0; i < count; ++i) {
-        geometry_config* g = &((*out_geometries_darray)[i]);
-        KDEBUG("Geometry de-duplication process starting on geometry object named '%s'...", g->name);
-
-        u32 new_vert_count = 0;
-        vertex_3d* unique_verts = 0;
-        geometry_deduplicate_vertices(g->vertex_count, g->vertices, g->index_count, g->indices, &new_vert_count, &unique_verts);
+    // Build and de-duplicate geometry, with each object done in parallel.
+    u32 count = darray_length(*out_geometries_darray) - first_geometry;
+    obj_subobjects subobjects = {positions, normals, tex_coords, faces, *out_geometries_darray + first_geometry};
+    job_system_parallel_for(count, 1, obj_subobjects_process, &subobjects);
 
-        // Destroy the old, large array...
-        darray_destroy(g->vertices);
-
-        // And replace with the de-duplicated one.
-        g->vertices = unique_verts;
-        g->vertex_count = new_vert_count;
-
-        // Take a copy of the indices as a normal, non-darray
-        u32* indices = kallocate(sizeof(u32) * g->index_count, MEMORY_TAG_ARRAY);
-        kcopy_memory(indices, g->indices, sizeof(u32) * g->index_count);
-        // Destroy the darray
-        darray_destroy(g->indices);
-        // Replace with the non-darray version.
-        g->indices = indices;
-
-        // Also generate tangents here, this way tangents are also stored in the output file.
-        geometry_generate_tangents(g->vertex_count, g->vertices, g->index_count, g->indices);
+    // Taken before the scratch allocator is freed.
+    char name[512];
+    string_ncopy(name, grouping->name, sizeof(name) - 1);
+    name[sizeof(name) - 1] = 0;
+
+    // Nothing on the scratch allocator is referenced any more.
+    linear_allocator_free_to_marker(scratch, scratch_marker);
+
+    // Output a ksm file, which will be loaded in the future. Left uncompressed so that it can be used in
+    // place; files are compressed for shipping with ksm_file_convert.
+    b8 result = write_ksm_file(out_ksm_filename, name, count, *out_geometries_darray + first_geometry, false);
+    // Failing to write the manifest only means the mesh's dependencies are found one stage at a time.
+    if (result) {
+        write_kdm_file(out_ksm_filename, count, *out_geometries_darray + first_geometry, library);
     }
+    darray_destroy(library);
+    return result;
+}
 
-    // Output a ksm file, which will be loaded in the future.
-    return write_ksm_file(out_ksm_filename, name, count, *out_geometries_darray);
+// Writes the dependency manifest of an imported mesh beside its ksm file. Materials not in its
+// material library are listed, but not their textures, as they are only found once loaded.
+static b8 write_kdm_file(const char* ksm_file_path, u32 geometry_count, const geometry_config* geometries, material_config* library) {
+    dependency_manifest manifest;
+    dependency_manifest_create(&manifest);
+    dependency_manifest materials;
+    dependency_manifest_create(&materials);
+    u32 library_count = (u32)darray_length(library);
+    for (u32 i = 0; i < geometry_count; ++i) {
+        if (!dependency_manifest_add(&materials, DEPENDENCY_TYPE_MATERIAL, geometries[i].material_name)) {
+            continue;
+        }
+        for (u32 m = 0; m < library_count; ++m) {
+            const material_config* config = &library[m];
+            if (strings_equali(config->name, geometries[i].material_name)) {
+                // Atlased diffuse maps are packed rather than loaded on their own.
+                if (!config->atlas) {
+                    dependency_manifest_add(&manifest, DEPENDENCY_TYPE_TEXTURE, config->diffuse_map_name);
+                }
+                dependency_manifest_add(&manifest, DEPENDENCY_TYPE_TEXTURE, config->specular_map_name);
+                dependency_manifest_add(&manifest, DEPENDENCY_TYPE_TEXTURE, config->normal_map_name);
+                break;
+            }
+        }
+    }
+    // Textures were listed first, as the deepest.
+    u32 material_count = (u32)darray_length(materials.entries);
+    for (u32 i = 0; i < material_count; ++i) {
+        dependency_manifest_add(&manifest, DEPENDENCY_TYPE_MATERIAL, materials.entries[i].name);
+    }
+    dependency_manifest_destroy(&materials);
+
+    char kdm_file_path[512];
+    u64 length = string_length(ksm_file_path) - string_length(".ksm");
+    string_ncopy(kdm_file_path, ksm_file_path, length);
+    kdm_file_path[length] = 0;
+    string_append_string(kdm_file_path, kdm_file_path, ".kdm");
+    b8 result = dependency_manifest_write(kdm_file_path, &manifest);
+    dependency_manifest_destroy(&manifest);
+    return result;
 }
 
 void process_subobject(vec3* positions, vec3* normals, vec2* tex_coords, mesh_face_data* faces, geometry_config* out_data) {
-    out_data->indices = darray_create(u32);
-    out_data->vertices = darray_create(vertex_3d);
+    // These are only intermediate, and are replaced by copies once de-duplicated.
+    // Every face contributes exactly 3 vertices and indices, so both are sized once up front and written directly.
+    linear_allocator* scratch = scratch_allocator_get();
+    u64 face_count = darray_length(faces);
+    u32* indices = darray_reserve_with_allocator(u32, face_count * 3, scratch);
+    vertex_3d* vertices = darray_reserve_with_allocator(vertex_3d, face_count * 3, scratch);
+    darray_resize_uninitialized(indices, face_count * 3);
+    darray_resize_uninitialized(vertices, face_count * 3);
+    out_data->indices = indices;
+    out_data->vertices = vertices;
     b8 extent_set = false;
     kzero_memory(&out_data->min_extents, sizeof(vec3));
     kzero_memory(&out_data->max_extents, sizeof(vec3));
 
-    u64 face_count = darray_length(faces);
     u64 normal_count = darray_length(normals);
     u64 tex_coord_count = darray_length(tex_coords);
 
@@ -567,7 +1426,7 @@ void process_subobject(vec3* positions, vec3* normals, vec2* tex_coords, mesh_fa
         // Each vertex
         for (u64 i = 0; i < 3; ++i) {
             mesh_vertex_index_data index_data = face.vertices[i];
-            darray_push(out_data->indices, (u32)(i + (f * 3)));
+            indices[i + (f * 3)] = (u32)(i + (f * 3));
 
             vertex_3d vert;
 
@@ -613,7 +1472,7 @@ void process_subobject(vec3* positions, vec3* normals, vec2* tex_coords, mesh_fa
             // TODO: Color. Hardcode to white for now.
             vert.colour = vec4_one();
 
-            darray_push(out_data->vertices, vert);
+            vertices[i + (f * 3)] = vert;
         }
     }
 
@@ -624,20 +1483,20 @@ void process_subobject(vec3* positions, vec3* normals, vec2* tex_coords, mesh_fa
 }
 
 // TODO: Load the material library file, and create material definitions from it.
-// These definitions should be output to .kmt files. These .kmt files are then
+// These definitions should be output to .kmb files. These .kmb files are then
 // loaded when the material is acquired on mesh load.
-// NOTE: This should eventually account for duplicate materials. When the .kmt
+// NOTE: This should eventually account for duplicate materials. When the .kmb
 // files are written, if the file already exists the material should have something
 // such as a number appended to its name and a warning thrown to the console. The artist
 // should make sure material names are unique. When the material is acquired, the _original_
 // existing material name would be used, which would visually be wrong and serve as additional
 // reinforcement of the message for material uniqueness.
-// Material configs should not be returned or used here.
-b8 import_obj_material_library_file(const char* mtl_file_path) {
+// Material configs are only returned so that their textures can be listed in the mesh's dependency manifest.
+b8 import_obj_material_library_file(const char* mtl_file_path, material_config** out_configs_darray) {
     KDEBUG("Importing obj .mtl file '%s'...", mtl_file_path);
     // Grab the .mtl file, if it exists, and read the material information.
-    file_handle mtl_file;
-    if (!filesystem_open(mtl_file_path, FILE_MODE_READ, false, &mtl_file)) {
+    resource_file mtl_file;
+    if (!resource_system_file_open(mtl_file_path, &mtl_file)) {
         KERROR("Unable to open mtl file: %s", mtl_file_path);
         return false;
     }
@@ -647,154 +1506,83 @@ b8 import_obj_material_library_file(const char* mtl_file_path) {
 
     b8 hit_name = false;
 
-    char* line = 0;
-    char line_buffer[512];
-    char* p = &line_buffer[0];
-    u64 line_length = 0;
-    while (true) {
-        if (!filesystem_read_line(&mtl_file, 512, &p, &line_length)) {
-            break;
-        }
-        // Trim the line first.
-        line = string_trim(line_buffer);
-        line_length = string_length(line);
-
-        // Skip blank lines.
-        if (line_length < 1) {
+    kstring_view text = string_view_from(mtl_file.data, mtl_file.size);
+    kstring_view line;
+    while (string_view_next_line(&text, &line)) {
+        kstring_view rest = line;
+        kstring_view keyword;
+        // Skip blank lines and comments.
+        if (!string_view_next_token(&rest, &keyword) || keyword.str[0] == '#') {
             continue;
         }
 
-        char first_char = line[0];
-        switch (first_char) {
-            case '#':
-                // Skip comments
-                continue;
-            case 'K': {
-                char second_char = line[1];
-                switch (second_char) {
-                    case 'a':
-                    case 'd': {
-                        // Ambient/Diffuse colour are treated the same at this level.
-                        // ambient colour is determined by the level.
-                        char t[2];
-                        sscanf(
-                            line,
-                            "%s %f %f %f",
-                            t,
-                            &current_config.diffuse_colour.r,
-                            &current_config.diffuse_colour.g,
-                            &current_config.diffuse_colour.b);
-
-                        // NOTE: This is only used by the colour shader, and will set to max_norm by default.
-                        // Transparency could be added as a material property all its own at a later time.
-                        current_config.diffuse_colour.a = 1.0f;
-                    } break;
-                    case 's': {
-                        // Specular colour
-                        char t[2];
-
-                        // NOTE: Not using this for now.
-                        f32 spec_rubbish = 0.0f;
-                        sscanf(
-                            line,
-                            "%s %f %f %f",
-                            t,
-                            &spec_rubbish,
-                            &spec_rubbish,
-                            &spec_rubbish);
-                    } break;
-                }
-            } break;
-            case 'N': {
-                char second_char = line[1];
-                switch (second_char) {
-                    case 's': {
-                        // Specular exponent
-                        char t[2];
-
-                        sscanf(line, "%s %f", t, &current_config.shininess);
-                    } break;
-                }
-            } break;
-            case 'm': {
-                // map
-                char substr[10];
-                char texture_file_name[512];
-
-                sscanf(
-                    line,
-                    "%s %s",
-                    substr,
-                    texture_file_name);
-
-                //
-                if (strings_nequali(substr, "map_Kd", 6)) {
-                    // Is a diffuse texture map
-                    string_filename_no_extension_from_path(current_config.diffuse_map_name, texture_file_name);
-                } else if (strings_nequali(substr, "map_Ks", 6)) {
-                    // Is a specular texture map
-                    string_filename_no_extension_from_path(current_config.specular_map_name, texture_file_name);
-                } else if (strings_nequali(substr, "map_bump", 8)) {
-                    // Is a bump texture map
-                    string_filename_no_extension_from_path(current_config.normal_map_name, texture_file_name);
-                }
-            } break;
-            case 'b': {
-                // Some implementations use 'bump' instead of 'map_bump'.
-                char substr[10];
-                char texture_file_name[512];
-
-                sscanf(
-                    line,
-                    "%s %s",
-                    substr,
-                    texture_file_name);
-                if (strings_nequali(substr, "bump", 4)) {
-                    // Is a bump (normal) texture map
-                    string_filename_no_extension_from_path(current_config.normal_map_name, texture_file_name);
-                }
+        if (string_view_equal(keyword, "Ka") || string_view_equal(keyword, "Kd")) {
+            // Ambient/Diffuse colour are treated the same at this level.
+            // ambient colour is determined by the level.
+            string_view_parse_f32(&rest, &current_config.diffuse_colour.r);
+            string_view_parse_f32(&rest, &current_config.diffuse_colour.g);
+            string_view_parse_f32(&rest, &current_config.diffuse_colour.b);
+
+            // NOTE: This is only used by the colour shader, and will set to max_norm by default.
+            // Transparency could be added as a material property all its own at a later time.
+            current_config.diffuse_colour.a = 1.0f;
+        } else if (string_view_equal(keyword, "Ks")) {
+            // Specular colour
+            // NOTE: Not using this for now.
+        } else if (string_view_equal(keyword, "Ns")) {
+            // Specular exponent
+            string_view_parse_f32(&rest, &current_config.shininess);
+        } else if (string_view_equal(keyword, "map_Kd") || string_view_equal(keyword, "map_Ks") ||
+                   string_view_equal(keyword, "map_bump") || string_view_equal(keyword, "bump")) {
+            // Some implementations use 'bump' instead of 'map_bump'.
+            char texture_file_name[512];
+            kstring_view file_name;
+            string_view_next_token(&rest, &file_name);
+            string_view_copy(texture_file_name, file_name, sizeof(texture_file_name));
+
+            if (string_view_equal(keyword, "map_Kd")) {
+                // Is a diffuse texture map
+                string_filename_no_extension_from_path(current_config.diffuse_map_name, texture_file_name);
+            } else if (string_view_equal(keyword, "map_Ks")) {
+                // Is a specular texture map
+                string_filename_no_extension_from_path(current_config.specular_map_name, texture_file_name);
+            } else {
+                // Is a bump (normal) texture map
+                string_filename_no_extension_from_path(current_config.normal_map_name, texture_file_name);
+            }
+        } else if (string_view_equal(keyword, "newmtl")) {
+            // Is a material name.
+
+            // NOTE: Hardcoding default material shader name because all objects imported this way
+            // will be treated the same.
+            current_config.shader_name = "Shader.Builtin.Material";
+            // NOTE: Shininess of 0 will cause problems in the shader. Use a default
+            // if this is the case.
+            if (current_config.shininess == 0.0f) {
+                current_config.shininess = 8.0f;
             }
-            case 'n': {
-                // Some implementations use 'bump' instead of 'map_bump'.
-                char substr[10];
-                char material_name[512];
-
-                sscanf(
-                    line,
-                    "%s %s",
-                    substr,
-                    material_name);
-                if (strings_nequali(substr, "newmtl", 6)) {
-                    // Is a material name.
-
-                    // NOTE: Hardcoding default material shader name because all objects imported this way
-                    // will be treated the same.
-                    current_config.shader_name = "Shader.Builtin.Material";
-                    // NOTE: Shininess of 0 will cause problems in the shader. Use a default
-                    // if this is the case.
-                    if (current_config.shininess == 0.0f) {
-                        current_config.shininess = 8.0f;
-                    }
-                    if (hit_name) {
-                        //  Write out a kmt file and move on.
-                        if (!write_kmt_file(mtl_file_path, &current_config)) {
-                            KERROR("Unable to write kmt file.");
-                            return false;
-                        }
-
-                        // Reset the material for the next round.
-                        kzero_memory(&current_config, sizeof(current_config));
-                    }
-
-                    hit_name = true;
-
-                    string_ncopy(current_config.name, material_name, 256);
+            if (hit_name) {
+                //  Write out a kmb file and move on.
+                if (!write_mtl_kmb_file(mtl_file_path, &current_config)) {
+                    KERROR("Unable to write kmb file.");
+                    resource_system_file_close(&mtl_file);
+                    return false;
                 }
+                darray_push(*out_configs_darray, current_config);
+
+                // Reset the material for the next round.
+                kzero_memory(&current_config, sizeof(current_config));
             }
+
+            hit_name = true;
+
+            string_view_copy(current_config.name, string_view_trim(rest), sizeof(current_config.name));
         }
     }  // each line
 
-    // Write out the remaining kmt file.
+    resource_system_file_close(&mtl_file);
+
+    // Write out the remaining kmb file.
     // NOTE: Hardcoding default material shader name because all objects imported this way
     // will be treated the same.
     current_config.shader_name = "Shader.Builtin.Material";
@@ -803,68 +1591,34 @@ b8 import_obj_material_library_file(const char* mtl_file_path) {
     if (current_config.shininess == 0.0f) {
         current_config.shininess = 8.0f;
     }
-    if (!write_kmt_file(mtl_file_path, &current_config)) {
-        KERROR("Unable to write kmt file.");
+    if (!write_mtl_kmb_file(mtl_file_path, &current_config)) {
+        KERROR("Unable to write kmb file.");
         return false;
     }
+    darray_push(*out_configs_darray, current_config);
 
-    filesystem_close(&mtl_file);
     return true;
 }
 
 /**
- * @brief Write out a Ignis material file from config. This gets loaded by name later when the mesh
- * is requested for load.
+ * @brief Write out a Ignis binary material file from config. This gets loaded by name later when the
+ * mesh is requested for load.
  *
  * @param mtl_file_path The filepath of the material library file which originally contained the material definition.
- * @param config A pointer to the config to be converted to kmt.
+ * @param config A pointer to the config to be converted to kmb.
  * @return True on success; otherwise false.
  */
-b8 write_kmt_file(const char* mtl_file_path, material_config* config) {
+b8 write_mtl_kmb_file(const char* mtl_file_path, material_config* config) {
     // NOTE: The .obj file this came from (and resulting .mtl file) sit in the
     // models directory. This moves up a level and back into the materials folder.
     // TODO: Read from config and get an absolute path for output.
-    char* format_str = "%s../materials/%s%s";
-    file_handle f;
     char directory[320];
     string_directory_from_path(directory, mtl_file_path);
 
     char full_file_path[512];
-    string_format(full_file_path, format_str, directory, config->name, ".kmt");
-    if (!filesystem_open(full_file_path, FILE_MODE_WRITE, false, &f)) {
-        KERROR("Error opening material file for writing: '%s'", full_file_path);
-        return false;
-    }
-    KDEBUG("Writing .kmt file '%s'...", full_file_path);
-
-    char line_buffer[512];
-    filesystem_write_line(&f, "#material file");
-    filesystem_write_line(&f, "");
-    filesystem_write_line(&f, "version=0.1");  // TODO: hardcoded version.
-    string_format(line_buffer, "name=%s", config->name);
-    filesystem_write_line(&f, line_buffer);
-    string_format(line_buffer, "diffuse_colour=%.6f %.6f %.6f %.6f", config->diffuse_colour.r, config->diffuse_colour.g, config->diffuse_colour.b, config->diffuse_colour.a);
-    filesystem_write_line(&f, line_buffer);
-    string_format(line_buffer, "shininess=%.6f", config->shininess);
-    filesystem_write_line(&f, line_buffer);
-    if (config->diffuse_map_name[0]) {
-        string_format(line_buffer, "diffuse_map_name=%s", config->diffuse_map_name);
-        filesystem_write_line(&f, line_buffer);
-    }
-    if (config->specular_map_name[0]) {
-        string_format(line_buffer, "specular_map_name=%s", config->specular_map_name);
-        filesystem_write_line(&f, line_buffer);
-    }
-    if (config->normal_map_name[0]) {
-        string_format(line_buffer, "normal_map_name=%s", config->normal_map_name);
-        filesystem_write_line(&f, line_buffer);
-    }
-    string_format(line_buffer, "shader=%s", config->shader_name);
-    filesystem_write_line(&f, line_buffer);
-
-    filesystem_close(&f);
-
-    return true;
+    string_format(full_file_path, "%s../materials/%s%s", directory, config->name, ".kmb");
+    // Written straight to the binary format, as only the engine reads these. There is no .kmt to hash.
+    return kmb_file_write(full_file_path, config, 0);
 }
 
 resource_loader mesh_resource_loader_create() {
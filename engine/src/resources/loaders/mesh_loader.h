@@ -12,6 +12,7 @@
 #pragma once
 
 #include "systems/resource_system.h"
+#include "systems/geometry_system.h"
 
 /**
  * @brief Creates and returns a mesh resource loader.
@@ -19,3 +20,28 @@
  * @return The newly created resource loader.
  */
 resource_loader mesh_resource_loader_create();
+
+/**
+ * @brief Lays the given geometries out as the contents of a .ksm file, in the current version,
+ * which can be loaded with a single read. Full 3D vertices are packed on the way.
+ *
+ * @param name The name of the mesh.
+ * @param geometry_count The number of geometries.
+ * @param geometries An array of geometry_count geometries.
+ * @param compress Indicates if the vertices and indices should be compressed, where that makes them
+ * meaningfully smaller. Compressed files are decoded on load, rather than used in place.
+ * @param out_size A pointer to hold the size of the contents in bytes.
+ * @return The contents, which should be freed with kfree_aligned, an alignment of 16 and MEMORY_TAG_ARRAY.
+ */
+KAPI void* ksm_file_build(const char* name, u32 geometry_count, const geometry_config* geometries, b8 compress, u64* out_size);
+
+/**
+ * @brief Rewrites a .ksm file of any supported version in the current version, such as to compress
+ * meshes before they are shipped.
+ *
+ * @param source_path The path of the file to be read, which may be in a mounted archive.
+ * @param out_path The path of the file to be written.
+ * @param compress Indicates if the vertices and indices should be compressed, as per ksm_file_build.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 ksm_file_convert(const char* source_path, const char* out_path, b8 compress);
@@ -1,6 +1,7 @@
 #include "shader_loader.h"
 
 #include "core/logger.h"
+#include "core/profiler.h"
 #include "core/kmemory.h"
 #include "core/kstring.h"
 #include "resources/resource_types.h"
@@ -8,26 +9,67 @@
 #include "math/kmath.h"
 #include "loader_utils.h"
 #include "containers/darray.h"
-
 #include "platform/filesystem.h"
-
-b8 shader_loader_load(struct resource_loader* self, const char* name, void* params, resource* out_resource) {
-    if (!self || !name || !out_resource) {
-        return false;
-    }
-
-    char* format_str = "%s/%s/%s%s";
-    char full_file_path[512];
-    string_format(full_file_path, format_str, resource_system_base_path(), self->type_path, name, ".shadercfg");
-
-    file_handle f;
-    if (!filesystem_open(full_file_path, FILE_MODE_READ, false, &f)) {
-        KERROR("shader_loader_load - unable to open shader file for reading: '%s'.", full_file_path);
-        return false;
+#include "resources/spirv_reflect.h"
+
+/**
+ * @brief Splits a comma-separated value into up to max_count trimmed fields.
+ * @returns The number of fields in the value, which may be more than max_count.
+ */
+static u32 split_fields(kstring_view value, u32 max_count, kstring_view* out_fields) {
+    u32 count = 0;
+    kstring_view field;
+    while (string_view_next_split(&value, ',', &field)) {
+        if (count < max_count) {
+            out_fields[count] = field;
+        }
+        count++;
     }
+    return count;
+}
 
-    out_resource->full_path = string_duplicate(full_file_path);
-
+// The binary shader config, written when a .shadercfg is imported so that it need not be parsed
+// again. A header is followed by the name, then each stage, attribute, uniform and variant in turn.
+// Strings are a u16 length followed by their characters. The magic is "KSC1".
+#define KSC_MAGIC 0x3143534B
+#define KSC_VERSION 2
+#define KSC_FLAG_DEPTH_TEST 0x1
+#define KSC_FLAG_DEPTH_WRITE 0x2
+#define KSC_FLAG_DRAW_DATA 0x4
+#define KSC_FLAG_BINDLESS 0x8
+#define KSC_FLAG_LOCAL_UBO 0x10
+#define KSC_FLAG_VERTEX_PULLING 0x20
+#define KSC_FLAG_LINES 0x40
+
+typedef struct ksc_header {
+    u32 magic;
+    u32 version;
+    // The size of the .shadercfg the file was compiled from, so that it is not used once that changes.
+    u64 source_size;
+    u8 cull_mode;
+    u8 flags;
+    u8 stage_count;
+    u8 attribute_count;
+    u8 uniform_count;
+    u8 variant_count;
+    u8 reserved[2];
+} ksc_header;
+
+// Writes to a buffer, or only counts the bytes written if it has none.
+typedef struct ksc_writer {
+    u8* data;
+    u64 offset;
+} ksc_writer;
+
+// Reads from a buffer, failing any read past its end.
+typedef struct ksc_reader {
+    const u8* data;
+    u64 size;
+    u64 offset;
+    b8 failed;
+} ksc_reader;
+
+static shader_config* shader_config_create(void) {
     shader_config* resource_data = kallocate(sizeof(shader_config), MEMORY_TAG_RESOURCE);
     // Set some defaults, create arrays.
     resource_data->attribute_count = 0;
@@ -37,63 +79,72 @@ b8 shader_loader_load(struct resource_loader* self, const char* name, void* para
     resource_data->stage_count = 0;
     resource_data->stages = darray_create(shader_stage);
     resource_data->cull_mode = FACE_CULL_MODE_BACK;
-    resource_data->stage_count = 0;
     resource_data->stage_names = darray_create(char*);
     resource_data->stage_filenames = darray_create(char*);
+    resource_data->variant_count = 0;
+    resource_data->variant_names = darray_create(char*);
 
     resource_data->name = 0;
+    return resource_data;
+}
 
-    // Read each line of the file.
-    char line_buf[512] = "";
-    char* p = &line_buf[0];
-    u64 line_length = 0;
-    u32 line_number = 1;
-    while (filesystem_read_line(&f, 511, &p, &line_length)) {
-        // Trim the string.
-        char* trimmed = string_trim(line_buf);
-
-        // Get the trimmed length.
-        line_length = string_length(trimmed);
-
-        // Skip blank lines and comments.
-        if (line_length < 1 || trimmed[0] == '#') {
-            line_number++;
-            continue;
-        }
+// Frees everything the config owns, but not the config itself.
+static void shader_config_free_contents(shader_config* data) {
+    string_cleanup_split_array(data->stage_filenames);
+    darray_destroy(data->stage_filenames);
 
-        // Split into var/value
-        i32 equal_index = string_index_of(trimmed, '=');
-        if (equal_index == -1) {
-            KWARN("Potential formatting issue found in file '%s': '=' token not found. Skipping line %ui.", full_file_path, line_number);
-            line_number++;
-            continue;
-        }
+    string_cleanup_split_array(data->stage_names);
+    darray_destroy(data->stage_names);
+
+    darray_destroy(data->stages);
+
+    string_cleanup_split_array(data->variant_names);
+    darray_destroy(data->variant_names);
 
-        // Assume a max of 64 characters for the variable name.
-        char raw_var_name[64];
-        kzero_memory(raw_var_name, sizeof(char) * 64);
-        string_mid(raw_var_name, trimmed, 0, equal_index);
-        char* trimmed_var_name = string_trim(raw_var_name);
+    // Clean up attributes.
+    u32 count = darray_length(data->attributes);
+    for (u32 i = 0; i < count; ++i) {
+        u32 len = string_length(data->attributes[i].name);
+        kfree(data->attributes[i].name, sizeof(char) * (len + 1), MEMORY_TAG_STRING);
+    }
+    darray_destroy(data->attributes);
+
+    // Clean up uniforms.
+    count = darray_length(data->uniforms);
+    for (u32 i = 0; i < count; ++i) {
+        u32 len = string_length(data->uniforms[i].name);
+        kfree(data->uniforms[i].name, sizeof(char) * (len + 1), MEMORY_TAG_STRING);
+    }
+    darray_destroy(data->uniforms);
 
-        // Assume a max of 511-65 (446) for the max length of the value to account for the variable name and the '='.
-        char raw_value[446];
-        kzero_memory(raw_value, sizeof(char) * 446);
-        string_mid(raw_value, trimmed, equal_index + 1, -1);  // Read the rest of the line
-        char* trimmed_value = string_trim(raw_value);
+    if (data->name) {
+        kfree(data->name, sizeof(char) * (string_length(data->name) + 1), MEMORY_TAG_STRING);
+    }
+}
 
+static b8 shader_config_parse(const resource_file* f, const char* full_file_path, shader_config* resource_data) {
+    // Read each line of the file.
+    kstring_view text = string_view_from(f->data, f->size);
+    kstring_view var_name;
+    kstring_view value;
+    u32 line_number = 0;
+    while (resource_file_next_key_value(&text, &line_number, full_file_path, &var_name, &value)) {
         // Process the variable.
-        if (strings_equali(trimmed_var_name, "version")) {
+        if (string_view_equali(var_name, "version")) {
             // TODO: version
-        } else if (strings_equali(trimmed_var_name, "name")) {
-            resource_data->name = string_duplicate(trimmed_value);
-        } else if (strings_equali(trimmed_var_name, "renderpass")) {
-            // resource_data->renderpass_name = string_duplicate(trimmed_value);
+        } else if (string_view_equali(var_name, "name")) {
+            resource_data->name = string_view_duplicate(value);
+        } else if (string_view_equali(var_name, "renderpass")) {
             // Ignore this now.
-        } else if (strings_equali(trimmed_var_name, "stages")) {
+        } else if (string_view_equali(var_name, "stages")) {
             // Parse the stages
-            char** stage_names = darray_create(char*);
-            u32 count = string_split(trimmed_value, ',', &stage_names, true, true);
-            resource_data->stage_names = stage_names;
+            u32 count = 0;
+            kstring_view stage_name;
+            while (string_view_next_split(&value, ',', &stage_name)) {
+                darray_push(resource_data->stage_names, string_view_duplicate(stage_name));
+                count++;
+            }
+            char** stage_names = resource_data->stage_names;
             // Ensure stage name and stage file name count are the same, as they should align.
             if (resource_data->stage_count == 0) {
                 resource_data->stage_count = count;
@@ -114,144 +165,185 @@ b8 shader_loader_load(struct resource_loader* self, const char* name, void* para
                     KERROR("shader_loader_load: Invalid file layout. Unrecognized stage '%s'", stage_names[i]);
                 }
             }
-        } else if (strings_equali(trimmed_var_name, "stagefiles")) {
+        } else if (string_view_equali(var_name, "stagefiles")) {
             // Parse the stage file names
-            resource_data->stage_filenames = darray_create(char*);
-            u32 count = string_split(trimmed_value, ',', &resource_data->stage_filenames, true, true);
+            u32 count = 0;
+            kstring_view stage_filename;
+            while (string_view_next_split(&value, ',', &stage_filename)) {
+                darray_push(resource_data->stage_filenames, string_view_duplicate(stage_filename));
+                count++;
+            }
             // Ensure stage name and stage file name count are the same, as they should align.
             if (resource_data->stage_count == 0) {
                 resource_data->stage_count = count;
             } else if (resource_data->stage_count != count) {
                 KERROR("shader_loader_load: Invalid file layout. Count mismatch between stage names and stage filenames.");
             }
-        } else if (strings_equali(trimmed_var_name, "cull_mode")) {
-            if (strings_equali(trimmed_value, "front")) {
+        } else if (string_view_equali(var_name, "cull_mode")) {
+            if (string_view_equali(value, "front")) {
                 resource_data->cull_mode = FACE_CULL_MODE_FRONT;
-            } else if (strings_equali(trimmed_value, "front_and_back")) {
+            } else if (string_view_equali(value, "front_and_back")) {
                 resource_data->cull_mode = FACE_CULL_MODE_FRONT_AND_BACK;
-            } else if (strings_equali(trimmed_value, "none")) {
+            } else if (string_view_equali(value, "none")) {
                 resource_data->cull_mode = FACE_CULL_MODE_NONE;
             }
             // Any other value will use the default of BACK.
-        } else if (strings_equali(trimmed_var_name, "depth_test")) {
-            string_to_bool(trimmed_value, &resource_data->depth_test);
-        } else if (strings_equali(trimmed_var_name, "depth_write")) {
-            string_to_bool(trimmed_value, &resource_data->depth_write); 
-        } else if (strings_equali(trimmed_var_name, "attribute")) {
+        } else if (string_view_equali(var_name, "depth_test")) {
+            resource_data->depth_test = string_view_to_bool(value);
+        } else if (string_view_equali(var_name, "depth_write")) {
+            resource_data->depth_write = string_view_to_bool(value);
+        } else if (string_view_equali(var_name, "draw_data")) {
+            resource_data->draw_data = string_view_to_bool(value);
+        } else if (string_view_equali(var_name, "bindless")) {
+            resource_data->bindless = string_view_to_bool(value);
+        } else if (string_view_equali(var_name, "local_ubo")) {
+            resource_data->local_ubo = string_view_to_bool(value);
+        } else if (string_view_equali(var_name, "vertex_pulling")) {
+            resource_data->vertex_pulling = string_view_to_bool(value);
+        } else if (string_view_equali(var_name, "lines")) {
+            resource_data->lines = string_view_to_bool(value);
+        } else if (string_view_equali(var_name, "variants")) {
+            kstring_view fields[SHADER_MAX_VARIANTS];
+            u32 count = split_fields(value, SHADER_MAX_VARIANTS, fields);
+            if (resource_data->variant_count != 0) {
+                KERROR("shader_loader_load: '%s' line %u: Variants may only be given once.", full_file_path, line_number);
+            } else if (count > SHADER_MAX_VARIANTS) {
+                KERROR("shader_loader_load: '%s' line %u: At most %u variants are supported, but %u were given.", full_file_path, line_number, SHADER_MAX_VARIANTS, count);
+                return false;
+            } else {
+                for (u32 i = 0; i < count; ++i) {
+                    char* variant_name = string_view_duplicate(fields[i]);
+                    darray_push(resource_data->variant_names, variant_name);
+                }
+                resource_data->variant_count = (u8)count;
+            }
+        } else if (string_view_equali(var_name, "attribute")) {
             // Parse attribute.
-            char** fields = darray_create(char*);
-            u32 field_count = string_split(trimmed_value, ',', &fields, true, true);
+            kstring_view fields[2];
+            u32 field_count = split_fields(value, 2, fields);
             if (field_count != 2) {
                 KERROR("shader_loader_load: Invalid file layout. Attribute fields must be 'type,name'. Skipping.");
             } else {
                 shader_attribute_config attribute;
                 // Parse field type
-                if (strings_equali(fields[0], "f32")) {
+                if (string_view_equali(fields[0], "f32")) {
                     attribute.type = SHADER_ATTRIB_TYPE_FLOAT32;
                     attribute.size = 4;
-                } else if (strings_equali(fields[0], "vec2")) {
+                } else if (string_view_equali(fields[0], "vec2")) {
                     attribute.type = SHADER_ATTRIB_TYPE_FLOAT32_2;
                     attribute.size = 8;
-                } else if (strings_equali(fields[0], "vec3")) {
+                } else if (string_view_equali(fields[0], "vec3")) {
                     attribute.type = SHADER_ATTRIB_TYPE_FLOAT32_3;
                     attribute.size = 12;
-                } else if (strings_equali(fields[0], "vec4")) {
+                } else if (string_view_equali(fields[0], "vec4")) {
                     attribute.type = SHADER_ATTRIB_TYPE_FLOAT32_4;
                     attribute.size = 16;
-                } else if (strings_equali(fields[0], "u8")) {
+                } else if (string_view_equali(fields[0], "u8")) {
                     attribute.type = SHADER_ATTRIB_TYPE_UINT8;
                     attribute.size = 1;
-                } else if (strings_equali(fields[0], "u16")) {
+                } else if (string_view_equali(fields[0], "u16")) {
                     attribute.type = SHADER_ATTRIB_TYPE_UINT16;
                     attribute.size = 2;
-                } else if (strings_equali(fields[0], "u32")) {
+                } else if (string_view_equali(fields[0], "u32")) {
                     attribute.type = SHADER_ATTRIB_TYPE_UINT32;
                     attribute.size = 4;
-                } else if (strings_equali(fields[0], "i8")) {
+                } else if (string_view_equali(fields[0], "i8")) {
                     attribute.type = SHADER_ATTRIB_TYPE_INT8;
                     attribute.size = 1;
-                } else if (strings_equali(fields[0], "i16")) {
+                } else if (string_view_equali(fields[0], "i16")) {
                     attribute.type = SHADER_ATTRIB_TYPE_INT16;
                     attribute.size = 2;
-                } else if (strings_equali(fields[0], "i32")) {
+                } else if (string_view_equali(fields[0], "i32")) {
                     attribute.type = SHADER_ATTRIB_TYPE_INT32;
                     attribute.size = 4;
+                } else if (string_view_equali(fields[0], "snorm16x2")) {
+                    attribute.type = SHADER_ATTRIB_TYPE_SNORM16_2;
+                    attribute.size = 4;
+                } else if (string_view_equali(fields[0], "f16x2")) {
+                    attribute.type = SHADER_ATTRIB_TYPE_FLOAT16_2;
+                    attribute.size = 4;
+                } else if (string_view_equali(fields[0], "unorm8x4")) {
+                    attribute.type = SHADER_ATTRIB_TYPE_UNORM8_4;
+                    attribute.size = 4;
                 } else {
-                    KERROR("shader_loader_load: Invalid file layout. Attribute type must be f32, vec2, vec3, vec4, i8, i16, i32, u8, u16, or u32.");
+                    KERROR("shader_loader_load: Invalid file layout. Attribute type must be f32, vec2, vec3, vec4, i8, i16, i32, u8, u16, u32, snorm16x2, f16x2 or unorm8x4.");
                     KWARN("Defaulting to f32.");
                     attribute.type = SHADER_ATTRIB_TYPE_FLOAT32;
                     attribute.size = 4;
                 }
 
                 // Take a copy of the attribute name.
-                attribute.name_length = string_length(fields[1]);
-                attribute.name = string_duplicate(fields[1]);
+                attribute.name_length = fields[1].length;
+                attribute.name = string_view_duplicate(fields[1]);
 
                 // Add the attribute.
                 darray_push(resource_data->attributes, attribute);
                 resource_data->attribute_count++;
             }
-
-            string_cleanup_split_array(fields);
-            darray_destroy(fields);
-        } else if (strings_equali(trimmed_var_name, "uniform")) {
+        } else if (string_view_equali(var_name, "uniform")) {
             // Parse uniform.
-            char** fields = darray_create(char*);
-            u32 field_count = string_split(trimmed_value, ',', &fields, true, true);
+            kstring_view fields[3];
+            u32 field_count = split_fields(value, 3, fields);
             if (field_count != 3) {
                 KERROR("shader_loader_load: Invalid file layout. Uniform fields must be 'type,scope,name'. Skipping.");
             } else {
                 shader_uniform_config uniform;
                 // Parse field type
-                if (strings_equali(fields[0], "f32")) {
+                if (string_view_equali(fields[0], "f32")) {
                     uniform.type = SHADER_UNIFORM_TYPE_FLOAT32;
                     uniform.size = 4;
-                } else if (strings_equali(fields[0], "vec2")) {
+                } else if (string_view_equali(fields[0], "vec2")) {
                     uniform.type = SHADER_UNIFORM_TYPE_FLOAT32_2;
                     uniform.size = 8;
-                } else if (strings_equali(fields[0], "vec3")) {
+                } else if (string_view_equali(fields[0], "vec3")) {
                     uniform.type = SHADER_UNIFORM_TYPE_FLOAT32_3;
                     uniform.size = 12;
-                } else if (strings_equali(fields[0], "vec4")) {
+                } else if (string_view_equali(fields[0], "vec4")) {
                     uniform.type = SHADER_UNIFORM_TYPE_FLOAT32_4;
                     uniform.size = 16;
-                } else if (strings_equali(fields[0], "u8")) {
+                } else if (string_view_equali(fields[0], "u8")) {
                     uniform.type = SHADER_UNIFORM_TYPE_UINT8;
                     uniform.size = 1;
-                } else if (strings_equali(fields[0], "u16")) {
+                } else if (string_view_equali(fields[0], "u16")) {
                     uniform.type = SHADER_UNIFORM_TYPE_UINT16;
                     uniform.size = 2;
-                } else if (strings_equali(fields[0], "u32")) {
+                } else if (string_view_equali(fields[0], "u32")) {
                     uniform.type = SHADER_UNIFORM_TYPE_UINT32;
                     uniform.size = 4;
-                } else if (strings_equali(fields[0], "i8")) {
+                } else if (string_view_equali(fields[0], "i8")) {
                     uniform.type = SHADER_UNIFORM_TYPE_INT8;
                     uniform.size = 1;
-                } else if (strings_equali(fields[0], "i16")) {
+                } else if (string_view_equali(fields[0], "i16")) {
                     uniform.type = SHADER_UNIFORM_TYPE_INT16;
                     uniform.size = 2;
-                } else if (strings_equali(fields[0], "i32")) {
+                } else if (string_view_equali(fields[0], "i32")) {
                     uniform.type = SHADER_UNIFORM_TYPE_INT32;
                     uniform.size = 4;
-                } else if (strings_equali(fields[0], "mat4")) {
+                } else if (string_view_equali(fields[0], "mat4")) {
                     uniform.type = SHADER_UNIFORM_TYPE_MATRIX_4;
                     uniform.size = 64;
-                } else if (strings_equali(fields[0], "samp") || strings_equali(fields[0], "sampler")) {
+                } else if (string_view_equali(fields[0], "samp") || string_view_equali(fields[0], "sampler")) {
                     uniform.type = SHADER_UNIFORM_TYPE_SAMPLER;
                     uniform.size = 0;  // Samplers don't have a size.
+                } else if (string_view_equali(fields[0], "storage_buffer")) {
+                    uniform.type = SHADER_UNIFORM_TYPE_STORAGE_BUFFER;
+                    uniform.size = 0;  // Bound whole, so has no size of its own.
+                } else if (string_view_equali(fields[0], "storage_image")) {
+                    uniform.type = SHADER_UNIFORM_TYPE_STORAGE_IMAGE;
+                    uniform.size = 0;
                 } else {
-                    KERROR("shader_loader_load: Invalid file layout. Uniform type must be f32, vec2, vec3, vec4, i8, i16, i32, u8, u16, u32 or mat4.");
+                    KERROR("shader_loader_load: Invalid file layout. Uniform type must be f32, vec2, vec3, vec4, i8, i16, i32, u8, u16, u32, mat4, samp, storage_buffer or storage_image.");
                     KWARN("Defaulting to f32.");
                     uniform.type = SHADER_UNIFORM_TYPE_FLOAT32;
                     uniform.size = 4;
                 }
 
                 // Parse the scope
-                if (strings_equal(fields[1], "0")) {
+                if (string_view_equal(fields[1], "0")) {
                     uniform.scope = SHADER_SCOPE_GLOBAL;
-                } else if (strings_equal(fields[1], "1")) {
+                } else if (string_view_equal(fields[1], "1")) {
                     uniform.scope = SHADER_SCOPE_INSTANCE;
-                } else if (strings_equal(fields[1], "2")) {
+                } else if (string_view_equal(fields[1], "2")) {
                     uniform.scope = SHADER_SCOPE_LOCAL;
                 } else {
                     KERROR("shader_loader_load: Invalid file layout: Uniform scope must be 0 for global, 1 for instance or 2 for local.");
@@ -260,62 +352,362 @@ b8 shader_loader_load(struct resource_loader* self, const char* name, void* para
                 }
 
                 // Take a copy of the attribute name.
-                uniform.name_length = string_length(fields[2]);
-                uniform.name = string_duplicate(fields[2]);
+                uniform.name_length = fields[2].length;
+                uniform.name = string_view_duplicate(fields[2]);
 
                 // Add the attribute.
                 darray_push(resource_data->uniforms, uniform);
                 resource_data->uniform_count++;
             }
-
-            string_cleanup_split_array(fields);
-            darray_destroy(fields);
         }
 
         // TODO: more fields.
+    }
+
+    // Everything after this indexes the stage arrays by stage, so they must all line up.
+    if (darray_length(resource_data->stages) != resource_data->stage_count || darray_length(resource_data->stage_filenames) != resource_data->stage_count) {
+        KERROR("shader_loader_load: '%s' does not name a file for each of its stages.", full_file_path);
+        return false;
+    }
+    return true;
+}
 
-        // Clear the line buffer.
-        kzero_memory(line_buf, sizeof(char) * 512);
-        line_number++;
+static void ksc_write(ksc_writer* w, const void* data, u64 size) {
+    if (w->data) {
+        kcopy_memory(w->data + w->offset, data, size);
     }
+    w->offset += size;
+}
 
-    filesystem_close(&f);
+static void ksc_write_string(ksc_writer* w, const char* str) {
+    u16 length = str ? (u16)string_length(str) : 0;
+    ksc_write(w, &length, sizeof(u16));
+    ksc_write(w, str, length);
+}
 
-    out_resource->data = resource_data;
-    out_resource->data_size = sizeof(shader_config);
+// Lays the config out as a .ksc file. Returns the size of the file, writing nothing if w has no buffer.
+static u64 ksc_build(ksc_writer* w, const shader_config* config, u64 source_size) {
+    ksc_header header = {};
+    header.magic = KSC_MAGIC;
+    header.version = KSC_VERSION;
+    header.source_size = source_size;
+    header.cull_mode = (u8)config->cull_mode;
+    header.flags = (config->depth_test ? KSC_FLAG_DEPTH_TEST : 0) | (config->depth_write ? KSC_FLAG_DEPTH_WRITE : 0) | (config->draw_data ? KSC_FLAG_DRAW_DATA : 0) |
+                   (config->bindless ? KSC_FLAG_BINDLESS : 0) | (config->local_ubo ? KSC_FLAG_LOCAL_UBO : 0) |
+                   (config->vertex_pulling ? KSC_FLAG_VERTEX_PULLING : 0) | (config->lines ? KSC_FLAG_LINES : 0);
+    header.stage_count = config->stage_count;
+    header.attribute_count = config->attribute_count;
+    header.uniform_count = config->uniform_count;
+    header.variant_count = config->variant_count;
+    ksc_write(w, &header, sizeof(ksc_header));
+    ksc_write_string(w, config->name);
+    for (u8 i = 0; i < config->stage_count; ++i) {
+        u32 stage = config->stages[i];
+        ksc_write(w, &stage, sizeof(u32));
+        ksc_write_string(w, config->stage_names[i]);
+        ksc_write_string(w, config->stage_filenames[i]);
+    }
+    for (u8 i = 0; i < config->attribute_count; ++i) {
+        u8 fields[2] = {(u8)config->attributes[i].type, config->attributes[i].size};
+        ksc_write(w, fields, sizeof(fields));
+        ksc_write_string(w, config->attributes[i].name);
+    }
+    for (u8 i = 0; i < config->uniform_count; ++i) {
+        u8 fields[3] = {(u8)config->uniforms[i].type, (u8)config->uniforms[i].scope, config->uniforms[i].size};
+        ksc_write(w, fields, sizeof(fields));
+        ksc_write_string(w, config->uniforms[i].name);
+    }
+    for (u8 i = 0; i < config->variant_count; ++i) {
+        ksc_write_string(w, config->variant_names[i]);
+    }
+    return w->offset;
+}
+
+static b8 write_ksc_file(const char* path, const shader_config* config, u64 source_size) {
+    ksc_writer counter = {};
+    u64 size = ksc_build(&counter, config, source_size);
+    ksc_writer w = {};
+    w.data = kallocate(size, MEMORY_TAG_ARRAY);
+    ksc_build(&w, config, source_size);
+
+    b8 result = false;
+    file_handle f;
+    if (!filesystem_open(path, FILE_MODE_WRITE, true, &f)) {
+        KERROR("Unable to open file '%s' for writing. KSC write failed.", path);
+    } else {
+        u64 written = 0;
+        result = filesystem_write(&f, size, w.data, &written) && written == size;
+        if (!result) {
+            KERROR("Unable to write all of '%s'.", path);
+        }
+        filesystem_close(&f);
+    }
+    kfree(w.data, size, MEMORY_TAG_ARRAY);
+    return result;
+}
+
+static void ksc_read(ksc_reader* r, void* out_data, u64 size) {
+    if (r->failed || r->offset + size > r->size) {
+        r->failed = true;
+        kzero_memory(out_data, size);
+        return;
+    }
+    kcopy_memory(out_data, r->data + r->offset, size);
+    r->offset += size;
+}
+
+// Reads a string into a new allocation, which is 0 if the read failed.
+static char* ksc_read_string(ksc_reader* r) {
+    u16 length = 0;
+    ksc_read(r, &length, sizeof(u16));
+    if (r->failed || r->offset + length > r->size) {
+        r->failed = true;
+        return 0;
+    }
+    char* str = string_view_duplicate(string_view_from((const char*)r->data + r->offset, length));
+    r->offset += length;
+    return str;
+}
 
+// Reads a .ksc file into config, which should be freshly created. Anything read before a failure
+// is left in config to be freed with it.
+static b8 ksc_parse(const resource_file* f, const char* path, shader_config* config) {
+    ksc_reader r = {};
+    r.data = (const u8*)f->data;
+    r.size = f->size;
+    ksc_header header;
+    ksc_read(&r, &header, sizeof(ksc_header));
+    if (r.failed || header.magic != KSC_MAGIC) {
+        KERROR("'%s' is not a KSC file.", path);
+        return false;
+    }
+    if (header.version != KSC_VERSION) {
+        KERROR("'%s' is KSC version %u, but only version %u is supported. Cook it again.", path, header.version, KSC_VERSION);
+        return false;
+    }
+    config->cull_mode = (face_cull_mode)header.cull_mode;
+    config->depth_test = (header.flags & KSC_FLAG_DEPTH_TEST) != 0;
+    config->depth_write = (header.flags & KSC_FLAG_DEPTH_WRITE) != 0;
+    config->draw_data = (header.flags & KSC_FLAG_DRAW_DATA) != 0;
+    config->bindless = (header.flags & KSC_FLAG_BINDLESS) != 0;
+    config->local_ubo = (header.flags & KSC_FLAG_LOCAL_UBO) != 0;
+    config->vertex_pulling = (header.flags & KSC_FLAG_VERTEX_PULLING) != 0;
+    config->lines = (header.flags & KSC_FLAG_LINES) != 0;
+    config->name = ksc_read_string(&r);
+    for (u8 i = 0; i < header.stage_count && !r.failed; ++i) {
+        u32 stage = 0;
+        ksc_read(&r, &stage, sizeof(u32));
+        char* stage_name = ksc_read_string(&r);
+        char* stage_filename = ksc_read_string(&r);
+        if (!stage_name || !stage_filename) {
+            // Whichever was read is freed here, as the arrays would not stay aligned otherwise.
+            if (stage_name) {
+                kfree(stage_name, string_length(stage_name) + 1, MEMORY_TAG_STRING);
+            }
+            break;
+        }
+        darray_push(config->stages, (shader_stage)stage);
+        darray_push(config->stage_names, stage_name);
+        darray_push(config->stage_filenames, stage_filename);
+        config->stage_count++;
+    }
+    for (u8 i = 0; i < header.attribute_count && !r.failed; ++i) {
+        u8 fields[2];
+        ksc_read(&r, fields, sizeof(fields));
+        shader_attribute_config attribute = {};
+        attribute.type = (shader_attribute_type)fields[0];
+        attribute.size = fields[1];
+        attribute.name = ksc_read_string(&r);
+        if (!attribute.name) {
+            break;
+        }
+        attribute.name_length = (u8)string_length(attribute.name);
+        darray_push(config->attributes, attribute);
+        config->attribute_count++;
+    }
+    for (u8 i = 0; i < header.uniform_count && !r.failed; ++i) {
+        u8 fields[3];
+        ksc_read(&r, fields, sizeof(fields));
+        shader_uniform_config uniform = {};
+        uniform.type = (shader_uniform_type)fields[0];
+        uniform.scope = (shader_scope)fields[1];
+        uniform.size = fields[2];
+        uniform.name = ksc_read_string(&r);
+        if (!uniform.name) {
+            break;
+        }
+        uniform.name_length = (u8)string_length(uniform.name);
+        darray_push(config->uniforms, uniform);
+        config->uniform_count++;
+    }
+    for (u8 i = 0; i < header.variant_count && !r.failed; ++i) {
+        char* variant_name = ksc_read_string(&r);
+        if (!variant_name) {
+            break;
+        }
+        darray_push(config->variant_names, variant_name);
+        config->variant_count++;
+    }
+    if (r.failed || !config->name) {
+        KERROR("'%s' is cut short.", path);
+        return false;
+    }
     return true;
 }
 
-void shader_loader_unload(struct resource_loader* self, resource* resource) {
-    shader_config* data = (shader_config*)resource->data;
+// Checks the uniforms of the config against its compiled stages, found relative to base_path. If any
+// stage has not been compiled yet the check is skipped with a warning, as the uniforms may be declared
+// by that stage alone.
+static b8 shader_config_reflect(const shader_config* config, const char* base_path) {
+    if (config->stage_count == 0) {
+        return true;
+    }
+    spirv_reflection* reflections = kallocate(sizeof(spirv_reflection) * config->stage_count, MEMORY_TAG_RESOURCE);
+    b8 result = true;
+    b8 checked = true;
+    for (u8 i = 0; i < config->stage_count && result && checked; ++i) {
+        char path[512];
+        string_format(path, "%s/%s", base_path, config->stage_filenames[i]);
+        resource_file file;
+        if (!resource_system_file_exists(path) || !resource_system_file_open(path, &file)) {
+            KWARN("Stage file '%s' of shader '%s' was not found, so its uniforms are not checked.", path, config->name);
+            checked = false;
+            break;
+        }
+        if (!spirv_reflect(file.data, file.size, &reflections[i])) {
+            KERROR("Stage file '%s' of shader '%s' is not valid SPIR-V.", path, config->name);
+            result = false;
+        }
+        resource_system_file_close(&file);
+    }
+    if (result && checked && !spirv_reflection_check_uniforms(config, config->stage_count, reflections)) {
+        KERROR("The uniforms of shader '%s' do not match its stages.", config->name);
+        result = false;
+    }
+    kfree(reflections, sizeof(spirv_reflection) * config->stage_count, MEMORY_TAG_RESOURCE);
+    return result;
+}
 
-    string_cleanup_split_array(data->stage_filenames);
-    darray_destroy(data->stage_filenames);
+// Finds the size of a loose file, or 0 if it cannot be opened.
+static u64 loose_file_size(const char* path) {
+    file_handle f;
+    u64 size = 0;
+    if (filesystem_exists(path) && filesystem_open(path, FILE_MODE_READ, true, &f)) {
+        if (!filesystem_size(&f, &size)) {
+            size = 0;
+        }
+        filesystem_close(&f);
+    }
+    return size;
+}
 
-    string_cleanup_split_array(data->stage_names);
-    darray_destroy(data->stage_names);
+// Reads the size of the source a .ksc file was compiled from, or 0 if it cannot be read.
+static u64 ksc_source_size(const char* path) {
+    resource_file file;
+    if (!resource_system_file_open(path, &file)) {
+        return 0;
+    }
+    ksc_header header = {};
+    if (file.size >= sizeof(ksc_header)) {
+        kcopy_memory(&header, file.data, sizeof(ksc_header));
+    }
+    resource_system_file_close(&file);
+    return header.magic == KSC_MAGIC ? header.source_size : 0;
+}
 
-    darray_destroy(data->stages);
+// Parses and checks the .shadercfg at path, found with stage files relative to base_path.
+static shader_config* shader_config_import(const char* path, const char* base_path, u64* out_source_size) {
+    resource_file f;
+    if (!resource_system_file_open(path, &f)) {
+        KERROR("shader_loader_load - unable to open shader file for reading: '%s'.", path);
+        return 0;
+    }
+    shader_config* config = shader_config_create();
+    b8 result = shader_config_parse(&f, path, config);
+    *out_source_size = f.size;
+    resource_system_file_close(&f);
+    if (result) {
+        result = shader_config_reflect(config, base_path);
+    }
+    if (!result) {
+        shader_config_free_contents(config);
+        kfree(config, sizeof(shader_config), MEMORY_TAG_RESOURCE);
+        return 0;
+    }
+    return config;
+}
 
-    // Clean up attributes.
-    u32 count = darray_length(data->attributes);
-    for (u32 i = 0; i < count; ++i) {
-        u32 len = string_length(data->attributes[i].name);
-        kfree(data->attributes[i].name, sizeof(char) * (len + 1), MEMORY_TAG_STRING);
+b8 shader_loader_load(struct resource_loader* self, const char* name, void* params, resource* out_resource) {
+    KPROFILE_ZONE("shader_loader_load");
+    if (!self || !name || !out_resource) {
+        return false;
     }
-    darray_destroy(data->attributes);
 
-    // Clean up uniforms.
-    count = darray_length(data->uniforms);
-    for (u32 i = 0; i < count; ++i) {
-        u32 len = string_length(data->uniforms[i].name);
-        kfree(data->uniforms[i].name, sizeof(char) * (len + 1), MEMORY_TAG_STRING);
+    char* format_str = "%s/%s/%s%s";
+    char source_path[512];
+    char ksc_path[512];
+    string_format(source_path, format_str, resource_system_base_path(), self->type_path, name, ".shadercfg");
+    string_format(ksc_path, format_str, resource_system_base_path(), self->type_path, name, ".ksc");
+
+    // The binary config is preferred, unless the .shadercfg it was compiled from has changed since
+    // and may be imported again. Files to import are always loose.
+    b8 can_import = resource_system_should_find(false) && filesystem_exists(source_path);
+    u64 source_size = can_import ? loose_file_size(source_path) : 0;
+    b8 use_binary = resource_system_should_find(true) && resource_system_file_exists(ksc_path);
+    if (use_binary && can_import && ksc_source_size(ksc_path) != source_size) {
+        use_binary = false;
+    }
+
+    shader_config* resource_data = 0;
+    if (use_binary) {
+        out_resource->full_path = string_duplicate(ksc_path);
+        resource_file f;
+        if (!resource_system_file_open(ksc_path, &f)) {
+            KERROR("shader_loader_load - unable to open shader file for reading: '%s'.", ksc_path);
+            return false;
+        }
+        resource_data = shader_config_create();
+        b8 result = ksc_parse(&f, ksc_path, resource_data);
+        resource_system_file_close(&f);
+        if (!result) {
+            shader_config_free_contents(resource_data);
+            kfree(resource_data, sizeof(shader_config), MEMORY_TAG_RESOURCE);
+            return false;
+        }
+    } else if (can_import) {
+        out_resource->full_path = string_duplicate(source_path);
+        resource_data = shader_config_import(source_path, resource_system_base_path(), &source_size);
+        if (!resource_data) {
+            return false;
+        }
+        // Failing to write the binary config only means it is imported again next time.
+        write_ksc_file(ksc_path, resource_data, source_size);
+    } else {
+        KERROR("Unable to find shader config called '%s'.%s", name, resource_system_import_mode() == RESOURCE_IMPORT_MODE_NEVER ? " Importing is disabled, so it must be cooked first." : "");
+        return false;
     }
-    darray_destroy(data->uniforms);
 
-    kfree(data->name, sizeof(char) * (string_length(data->name) + 1), MEMORY_TAG_STRING);
-    kzero_memory(data, sizeof(shader_config));
+    out_resource->data = resource_data;
+    out_resource->data_size = sizeof(shader_config);
+
+    return true;
+}
+
+b8 ksc_file_compile(const char* source_path, const char* base_path, const char* out_path) {
+    u64 source_size = 0;
+    shader_config* config = shader_config_import(source_path, base_path, &source_size);
+    if (!config) {
+        KERROR("ksc_file_compile - unable to import '%s'.", source_path);
+        return false;
+    }
+    b8 result = write_ksc_file(out_path, config, source_size);
+    shader_config_free_contents(config);
+    kfree(config, sizeof(shader_config), MEMORY_TAG_RESOURCE);
+    return result;
+}
+
+void shader_loader_unload(struct resource_loader* self, resource* resource) {
+    shader_config_free_contents((shader_config*)resource->data);
 
     if (!resource_unload(self, resource, MEMORY_TAG_RESOURCE)) {
         KWARN("shader_loader_unload called with nullptr for self or resource.");
@@ -19,3 +19,14 @@
  * @return The newly created resource loader.
  */
 resource_loader shader_resource_loader_create();
+
+/**
+ * @brief Compiles a .shadercfg into a binary .ksc config, which is loaded in its place. The uniforms
+ * are first checked against the compiled stages, which are found relative to base_path.
+ *
+ * @param source_path The path of the .shadercfg.
+ * @param base_path The asset base directory, which stage file names are relative to.
+ * @param out_path The path to write the .ksc file to.
+ * @returns True on success; otherwise false, such as when the uniforms do not match the stages.
+ */
+KAPI b8 ksc_file_compile(const char* source_path, const char* base_path, const char* out_path);
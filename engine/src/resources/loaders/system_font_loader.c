@@ -1,6 +1,7 @@
 #include "system_font_loader.h"
 
 #include "core/logger.h"
+#include "core/profiler.h"
 #include "core/kmemory.h"
 #include "core/kstring.h"
 #include "resources/resource_types.h"
@@ -28,6 +29,7 @@ b8 read_ksf_file(file_handle* file, system_font_resource_data* data);
 b8 write_ksf_file(const char* out_ksf_filename, system_font_resource_data* resource);
 
 b8 system_font_loader_load(struct resource_loader* self, const char* name, void* params, resource* out_resource) {
+    KPROFILE_ZONE("system_font_loader_load");
     if (!self || !name || !out_resource) {
         return false;
     }
@@ -37,9 +39,7 @@ b8 system_font_loader_load(struct resource_loader* self, const char* name, void*
     // Supported extensions. Note that these are in order of priority when looked up.
     // This is to prioritize the loading of a binary version of the system font, followed by
     // importing various types of system fonts to binary types, which would be loaded on the
-    // next run.
-    // TODO: Might be good to be able to specify an override to always import (i.e. skip
-    // binary versions) for debug purposes.
+    // next run. The resource system's import mode can skip one or the other.
 #define SUPPORTED_FILETYPE_COUNT 2
     supported_system_font_filetype supported_filetypes[SUPPORTED_FILETYPE_COUNT];
     supported_filetypes[0] = (supported_system_font_filetype){".ksf", SYSTEM_FONT_FILE_TYPE_KSF, true};
@@ -49,6 +49,9 @@ b8 system_font_loader_load(struct resource_loader* self, const char* name, void*
     system_font_file_type type = SYSTEM_FONT_FILE_TYPE_NOT_FOUND;
     // Try each supported extension.
     for (u32 i = 0; i < SUPPORTED_FILETYPE_COUNT; ++i) {
+        if (!resource_system_should_find(supported_filetypes[i].is_binary)) {
+            continue;
+        }
         string_format(full_file_path, format_str, resource_system_base_path(), self->type_path, name, supported_filetypes[i].extension);
         // If the file exists, open it and stop looking.
         if (filesystem_exists(full_file_path)) {
@@ -60,7 +63,7 @@ b8 system_font_loader_load(struct resource_loader* self, const char* name, void*
     }
 
     if (type == SYSTEM_FONT_FILE_TYPE_NOT_FOUND) {
-        KERROR("Unable to find system font of supported type called '%s'.", name);
+        KERROR("Unable to find system font of supported type called '%s'.%s", name, resource_system_import_mode() == RESOURCE_IMPORT_MODE_NEVER ? " Importing is disabled, so it must be cooked first." : "");
         return false;
     }
 
@@ -1,6 +1,7 @@
 #include "text_loader.h"
 
 #include "core/logger.h"
+#include "core/profiler.h"
 #include "core/kmemory.h"
 #include "core/kstring.h"
 #include "resources/resource_types.h"
@@ -11,6 +12,7 @@
 #include "platform/filesystem.h"
 
 b8 text_loader_load(struct resource_loader* self, const char* name, void* params, resource* out_resource) {
+    KPROFILE_ZONE("text_loader_load");
     if (!self || !name || !out_resource) {
         return false;
     }
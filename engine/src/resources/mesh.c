@@ -2,7 +2,11 @@
 
 #include "core/kmemory.h"
 #include "core/logger.h"
+#include "containers/darray.h"
 #include "systems/job_system.h"
+#include "systems/material_system.h"
+#include "systems/texture_system.h"
+#include "resources/dependency_manifest.h"
 
 #include "systems/resource_system.h"
 #include "systems/geometry_system.h"
@@ -13,6 +17,8 @@ typedef struct mesh_load_params {
     const char* resource_name;
     mesh* out_mesh;
     resource mesh_resource;
+    // Set if the job stopped early, having been cancelled.
+    b8 cancelled;
 } mesh_load_params;
 
 /**
@@ -23,7 +29,8 @@ typedef struct mesh_load_params {
 void mesh_load_job_success(void* params) {
     mesh_load_params* mesh_params = (mesh_load_params*)params;
 
-    // This also handles the GPU upload. Can't be jobified until the renderer is multithreaded.
+    // This also starts the GPU upload, which the renderer finishes on its transfer queue without
+    // waiting; the geometries are drawn once it lands.
     geometry_config* configs = (geometry_config*)mesh_params->mesh_resource.data;
     mesh_params->out_mesh->geometry_count = mesh_params->mesh_resource.data_size;
     mesh_params->out_mesh->geometries = kallocate(sizeof(geometry*) * mesh_params->out_mesh->geometry_count, MEMORY_TAG_ARRAY);
@@ -45,11 +52,36 @@ void mesh_load_job_success(void* params) {
 void mesh_load_job_fail(void* params) {
     mesh_load_params* mesh_params = (mesh_load_params*)params;
 
-    KERROR("Failed to load mesh '%s'.", mesh_params->resource_name);
+    if (mesh_params->cancelled) {
+        KTRACE("Load of mesh '%s' was cancelled.", mesh_params->resource_name);
+    } else {
+        KERROR("Failed to load mesh '%s'.", mesh_params->resource_name);
+    }
+
+    // Finished, with nothing to draw, so that whoever waits on the load knows it is done.
+    mesh_params->out_mesh->geometry_count = 0;
+    mesh_params->out_mesh->geometries = 0;
+    mesh_params->out_mesh->generation = 0;
 
     resource_system_unload(&mesh_params->mesh_resource);
 }
 
+/**
+ * @brief Called when the job is cancelled before it starts.
+ *
+ * @param params The parameters the job was created with.
+ */
+void mesh_load_job_cancel(void* params) {
+    mesh_load_params* mesh_params = (mesh_load_params*)params;
+
+    KTRACE("Load of mesh '%s' was cancelled before it started.", mesh_params->resource_name);
+
+    // Finished, with nothing to draw, as when the load fails.
+    mesh_params->out_mesh->geometry_count = 0;
+    mesh_params->out_mesh->geometries = 0;
+    mesh_params->out_mesh->generation = 0;
+}
+
 /**
  * @brief Called when a mesh loading job begins.
  *
@@ -60,6 +92,12 @@ void mesh_load_job_fail(void* params) {
 b8 mesh_load_job_start(void* params, void* result_data) {
     mesh_load_params* load_params = (mesh_load_params*)params;
     b8 result = resource_system_load(load_params->resource_name, RESOURCE_TYPE_MESH, 0, &load_params->mesh_resource);
+    // Cancelled while it was read, so its geometries are never uploaded.
+    load_params->cancelled = job_system_cancel_requested();
+    if (result && load_params->cancelled) {
+        resource_system_unload(&load_params->mesh_resource);
+        result = false;
+    }
 
     // NOTE: The load params are also used as the result data here, only the mesh_resource field is populated now.
     kcopy_memory(result_data, load_params, sizeof(mesh_load_params));
@@ -67,30 +105,98 @@ b8 mesh_load_job_start(void* params, void* result_data) {
     return result;
 }
 
+// Acquires everything in the mesh's manifest at once, deepest first, so that its textures and
+// materials load alongside the mesh rather than each once the one before it has.
+static void mesh_dependencies_acquire(const char* resource_name, mesh* m) {
+    dependency_manifest manifest;
+    if (!dependency_manifest_load("models", resource_name, &manifest)) {
+        return;
+    }
+    u32 count = (u32)darray_length(manifest.entries);
+    for (u32 i = 0; i < count; ++i) {
+        const dependency_entry* entry = &manifest.entries[i];
+        switch (entry->type) {
+            case DEPENDENCY_TYPE_TEXTURE:
+                texture_system_acquire(entry->name, true);
+                break;
+            case DEPENDENCY_TYPE_MATERIAL:
+                material_system_acquire_async(entry->name);
+                break;
+            default:
+                break;
+        }
+    }
+    KTRACE("Prefetching %u dependencies of mesh '%s'.", count, resource_name);
+    m->dependencies = kallocate(sizeof(dependency_manifest), MEMORY_TAG_ARRAY);
+    *m->dependencies = manifest;
+}
+
+// Releases what mesh_dependencies_acquire acquired, once everything else holds what it still needs.
+static void mesh_dependencies_release(mesh* m) {
+    if (!m->dependencies) {
+        return;
+    }
+    // Materials first, as they hold their textures.
+    u32 count = (u32)darray_length(m->dependencies->entries);
+    for (u32 i = count; i > 0; --i) {
+        const dependency_entry* entry = &m->dependencies->entries[i - 1];
+        if (entry->type == DEPENDENCY_TYPE_MATERIAL) {
+            material_system_release(entry->name);
+        } else if (entry->type == DEPENDENCY_TYPE_TEXTURE) {
+            texture_system_release(entry->name);
+        }
+    }
+    dependency_manifest_destroy(m->dependencies);
+    kfree(m->dependencies, sizeof(dependency_manifest), MEMORY_TAG_ARRAY);
+    m->dependencies = 0;
+}
+
 b8 mesh_load_from_resource(const char* resource_name, mesh* out_mesh) {
     out_mesh->generation = INVALID_ID_U8;
+    out_mesh->dependencies = 0;
+    mesh_dependencies_acquire(resource_name, out_mesh);
 
     mesh_load_params params;
     params.resource_name = resource_name;
     params.out_mesh = out_mesh;
     params.mesh_resource = (resource){};
+    params.cancelled = false;
 
     job_info job = job_create(mesh_load_job_start, mesh_load_job_success, mesh_load_job_fail, &params, sizeof(mesh_load_params), sizeof(mesh_load_params));
-    job_system_submit(job);
+    job.on_cancel = mesh_load_job_cancel;
+    out_mesh->load_job = job_system_submit(job);
 
     return true;
 }
 
+b8 mesh_load_cancel(mesh* m) {
+    if (!m || m->generation != INVALID_ID_U8) {
+        return false;
+    }
+    return job_system_cancel(m->load_job);
+}
+
+b8 mesh_load_priority_set(mesh* m, job_priority priority) {
+    if (!m || m->generation != INVALID_ID_U8) {
+        return false;
+    }
+    return job_system_priority_set(m->load_job, priority);
+}
+
 void mesh_unload(mesh* m) {
     if (m) {
         for (u32 i = 0; i < m->geometry_count; ++i) {
             geometry_system_release(m->geometries[i]);
         }
 
-        kfree(m->geometries, sizeof(geometry*) * m->geometry_count, MEMORY_TAG_ARRAY);
+        if (m->geometries) {
+            kfree(m->geometries, sizeof(geometry*) * m->geometry_count, MEMORY_TAG_ARRAY);
+        }
+        mesh_dependencies_release(m);
         kzero_memory(m, sizeof(mesh));
 
         // For good measure, invalidate the geometry so it doesn't attempt to be rendered.
         m->generation = INVALID_ID_U8;
+        m->load_job = INVALID_ID;
     }
 }
@@ -1,7 +1,25 @@
 #pragma once
 
 #include "resource_types.h"
+#include "systems/job_system.h"
 
 KAPI b8 mesh_load_from_resource(const char* resource_name, mesh* out_mesh);
 
+/**
+ * @brief Cancels the load of the given mesh, if still in flight. A load not yet started is dropped, and one
+ * under way stops once its file is read, before anything is uploaded. The mesh then finishes loading with
+ * nothing to draw, and must be kept until it has, as with any load.
+ * @param m A pointer to the mesh.
+ * @returns True if the load was cancelled before it started; otherwise false.
+ */
+KAPI b8 mesh_load_cancel(mesh* m);
+
+/**
+ * @brief Moves the load of the given mesh to another priority, if it has not yet started.
+ * @param m A pointer to the mesh.
+ * @param priority The priority to load at.
+ * @returns True if the load was moved; otherwise false.
+ */
+KAPI b8 mesh_load_priority_set(mesh* m, job_priority priority);
+
 KAPI void mesh_unload(mesh* m);
@@ -0,0 +1,128 @@
+#include "resource_cache.h"
+
+#include "core/counters.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+
+static void entry_unlink(resource_cache* cache, u32 handle) {
+    resource_cache_entry* entry = &cache->entries[handle];
+    if (entry->newer != INVALID_ID) {
+        cache->entries[entry->newer].older = entry->older;
+    } else {
+        cache->newest = entry->older;
+    }
+    if (entry->older != INVALID_ID) {
+        cache->entries[entry->older].newer = entry->newer;
+    } else {
+        cache->oldest = entry->newer;
+    }
+    cache->size -= entry->size;
+    cache->count--;
+    kzero_memory(entry, sizeof(resource_cache_entry));
+    counter_set(cache->size_gauge, (i64)cache->size);
+}
+
+b8 resource_cache_create(const char* name, u32 capacity, u64 budget, u64* memory_requirement, void* memory, resource_cache* out_cache) {
+    if (capacity == 0) {
+        KERROR("resource_cache_create requires a non-zero capacity. Create failed.");
+        return false;
+    }
+    if (!memory_requirement) {
+        KERROR("resource_cache_create requires memory_requirement to exist. Create failed.");
+        return false;
+    }
+
+    *memory_requirement = sizeof(resource_cache_entry) * capacity;
+
+    // If only obtaining requirement, boot out.
+    if (!memory) {
+        return true;
+    }
+    if (!out_cache) {
+        KERROR("resource_cache_create requires a pointer to hold the cache. Create failed.");
+        return false;
+    }
+
+    kzero_memory(out_cache, sizeof(resource_cache));
+    out_cache->capacity = capacity;
+    out_cache->budget = budget;
+    out_cache->newest = INVALID_ID;
+    out_cache->oldest = INVALID_ID;
+    out_cache->entries = memory;
+    kzero_memory(out_cache->entries, sizeof(resource_cache_entry) * capacity);
+
+    out_cache->size_gauge = INVALID_ID;
+    out_cache->hits_counter = INVALID_ID;
+    if (name) {
+        char counter_name[64];
+        string_format(counter_name, "%s.cached_bytes", name);
+        out_cache->size_gauge = counter_register(counter_name, COUNTER_TYPE_GAUGE);
+        string_format(counter_name, "%s.cache_hits", name);
+        out_cache->hits_counter = counter_register(counter_name, COUNTER_TYPE_COUNTER);
+        counter_set(out_cache->size_gauge, 0);
+    }
+    return true;
+}
+
+void resource_cache_destroy(resource_cache* cache) {
+    if (cache) {
+        counter_set(cache->size_gauge, 0);
+        kzero_memory(cache, sizeof(resource_cache));
+    }
+}
+
+b8 resource_cache_insert(resource_cache* cache, u32 handle, u64 size) {
+    if (!cache || !cache->entries || handle >= cache->capacity || size > cache->budget) {
+        return false;
+    }
+    resource_cache_entry* entry = &cache->entries[handle];
+    if (entry->cached) {
+        // Released again without being acquired, so only moved to the front.
+        entry_unlink(cache, handle);
+    }
+
+    entry->cached = true;
+    entry->size = size;
+    entry->newer = INVALID_ID;
+    entry->older = cache->newest;
+    if (cache->newest != INVALID_ID) {
+        cache->entries[cache->newest].newer = handle;
+    } else {
+        cache->oldest = handle;
+    }
+    cache->newest = handle;
+    cache->size += size;
+    cache->count++;
+    counter_set(cache->size_gauge, (i64)cache->size);
+    return true;
+}
+
+b8 resource_cache_remove(resource_cache* cache, u32 handle) {
+    if (!resource_cache_contains(cache, handle)) {
+        return false;
+    }
+    entry_unlink(cache, handle);
+    return true;
+}
+
+b8 resource_cache_acquire(resource_cache* cache, u32 handle) {
+    if (!resource_cache_remove(cache, handle)) {
+        return false;
+    }
+    counter_add(cache->hits_counter, 1);
+    return true;
+}
+
+b8 resource_cache_contains(const resource_cache* cache, u32 handle) {
+    return cache && cache->entries && handle < cache->capacity && cache->entries[handle].cached;
+}
+
+b8 resource_cache_evict(resource_cache* cache, u64 max_size, u32* out_handle) {
+    if (!cache || cache->oldest == INVALID_ID || cache->size <= max_size) {
+        return false;
+    }
+    *out_handle = cache->oldest;
+    entry_unlink(cache, cache->oldest);
+    return true;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file resource_cache.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Keeps resources nothing refers to any more loaded, within a budget of bytes, so that one
+ * acquired again soon after its release, such as a texture released during a material swap, is
+ * there at once instead of being loaded again.
+ * @details Resources are known by the handle their system gives them, below the capacity of the
+ * cache. Each is put in the cache as its last reference is released, and taken out when acquired
+ * again or destroyed. Once the resources held take more than the budget, those released longest
+ * ago are handed back one at a time for their system to destroy. Entries are a list through an
+ * array indexed by handle, so every operation takes constant time. The bytes held are reported as
+ * a "<name>.cached_bytes" gauge, and resources found in the cache as a "<name>.cache_hits" counter.
+ * Not thread-safe.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief The entry of a resource in the cache. */
+typedef struct resource_cache_entry {
+    /** @brief The handle of the resource released after this one, or INVALID_ID. */
+    u32 newer;
+    /** @brief The handle of the resource released before this one, or INVALID_ID. */
+    u32 older;
+    /** @brief The bytes the resource holds, as given when it was put in the cache. */
+    u64 size;
+    /** @brief Indicates if the resource is in the cache. */
+    b8 cached;
+} resource_cache_entry;
+
+/** @brief The resource cache structure. */
+typedef struct resource_cache {
+    /** @brief The number of handles the cache can hold, one past the largest. */
+    u32 capacity;
+    /** @brief The most bytes the resources held may take between them. 0 holds none. */
+    u64 budget;
+    /** @brief The bytes the resources held take between them. */
+    u64 size;
+    /** @brief The number of resources held. */
+    u32 count;
+    /** @brief The handle of the resource released most recently, or INVALID_ID. */
+    u32 newest;
+    /** @brief The handle of the resource released longest ago, or INVALID_ID. */
+    u32 oldest;
+    /** @brief The entries, indexed by handle. */
+    resource_cache_entry* entries;
+    /** @brief The id of the gauge of bytes held. */
+    u32 size_gauge;
+    /** @brief The id of the counter of resources taken back out of the cache when acquired. */
+    u32 hits_counter;
+} resource_cache;
+
+/**
+ * @brief Creates a new resource cache. Should be called twice; once to obtain the memory amount
+ * required (passing memory=0), and a second time with memory being set to an allocated block.
+ *
+ * @param name The name the cache's counters are reported under, conventionally the system's, such as "textures". Can be 0 to report none.
+ * @param capacity The number of handles the cache can hold.
+ * @param budget The most bytes the resources held may take between them. 0 holds none.
+ * @param memory_requirement A pointer to hold the required memory for the cache.
+ * @param memory An allocated block of memory, or 0 if just obtaining the requirement.
+ * @param out_cache A pointer to hold the cache.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 resource_cache_create(const char* name, u32 capacity, u64 budget, u64* memory_requirement, void* memory, resource_cache* out_cache);
+
+/**
+ * @brief Destroys the given cache. Resources still held are not destroyed, which is left to their
+ * system. The memory passed at creation is not freed.
+ *
+ * @param cache A pointer to the cache to be destroyed.
+ */
+KAPI void resource_cache_destroy(resource_cache* cache);
+
+/**
+ * @brief Puts a resource whose last reference was released in the cache, as the most recently
+ * released. Resources larger than the whole budget are not held.
+ *
+ * @param cache A pointer to the cache.
+ * @param handle The handle of the resource.
+ * @param size The bytes the resource holds.
+ * @return True if the resource is now held; otherwise false, in which case it should be destroyed.
+ */
+KAPI b8 resource_cache_insert(resource_cache* cache, u32 handle, u64 size);
+
+/**
+ * @brief Takes a resource out of the cache, such as when it is acquired again or destroyed.
+ *
+ * @param cache A pointer to the cache.
+ * @param handle The handle of the resource.
+ * @return True if the resource was held; otherwise false.
+ */
+KAPI b8 resource_cache_remove(resource_cache* cache, u32 handle);
+
+/**
+ * @brief Takes a resource which is being acquired again out of the cache, counting it as a hit.
+ *
+ * @param cache A pointer to the cache.
+ * @param handle The handle of the resource.
+ * @return True if the resource was held; otherwise false.
+ */
+KAPI b8 resource_cache_acquire(resource_cache* cache, u32 handle);
+
+/**
+ * @brief Indicates if the given resource is held.
+ *
+ * @param cache A constant pointer to the cache.
+ * @param handle The handle of the resource.
+ * @return True if held; otherwise false.
+ */
+KAPI b8 resource_cache_contains(const resource_cache* cache, u32 handle);
+
+/**
+ * @brief Takes out the resource released longest ago if those held take more than the given
+ * size, for its system to destroy. Called until it returns false to bring the cache within it.
+ *
+ * @param cache A pointer to the cache.
+ * @param max_size The most bytes the resources held should take. Usually the budget, or 0 to empty the cache.
+ * @param out_handle A pointer to hold the handle of the resource taken out.
+ * @return True if a resource was taken out; otherwise false.
+ */
+KAPI b8 resource_cache_evict(resource_cache* cache, u64 max_size, u32* out_handle);
@@ -67,8 +67,31 @@ typedef struct resource {
     u64 data_size;
     /** @brief The resource data. */
     void* data;
+    /** @brief Data kept by the loader until the resource is unloaded, such as what data was read from, or 0. */
+    void* loader_data;
 } resource;
 
+/**
+ * @brief The formats texture data can be held in on the GPU. Block-compressed formats
+ * are uploaded as they are; all of those supported use blocks of 4x4 texels.
+ */
+typedef enum texture_format {
+    /** @brief 8 bits for each of channel_count channels, uncompressed. */
+    TEXTURE_FORMAT_UNCOMPRESSED = 0,
+    /** @brief BC1, 8 bytes per block. RGB with optional 1-bit alpha. */
+    TEXTURE_FORMAT_BC1,
+    /** @brief BC3, 16 bytes per block. RGBA. */
+    TEXTURE_FORMAT_BC3,
+    /** @brief BC5, 16 bytes per block. Two channels, typically normal maps. */
+    TEXTURE_FORMAT_BC5,
+    /** @brief BC7, 16 bytes per block. High quality RGBA. */
+    TEXTURE_FORMAT_BC7,
+    /** @brief ASTC with 4x4 blocks, 16 bytes per block. RGBA. */
+    TEXTURE_FORMAT_ASTC_4X4,
+    /** @brief The number of formats. */
+    TEXTURE_FORMAT_COUNT
+} texture_format;
+
 /**
  * @brief A structure to hold image resource data.
  */
@@ -79,14 +102,47 @@ typedef struct image_resource_data {
     u32 width;
     /** @brief The height of the image. */
     u32 height;
+    /** @brief The format of the pixel data. Anything but uncompressed was loaded pre-compressed from a container. */
+    texture_format format;
+    /** @brief The number of mip levels in the pixel data, one after another, largest first. */
+    u32 mip_levels;
+    /** @brief The level of the source image the pixel data starts at. 0 unless levels were skipped. */
+    u32 first_level;
+    /** @brief The number of levels the source image can be loaded at, counting levels which may be generated from it. */
+    u32 source_level_count;
+    /** @brief Indicates if any of the image is less than fully opaque, as found when it was imported or loaded. */
+    b8 has_transparency;
+    /** @brief The size of the pixel data in bytes. */
+    u64 data_size;
     /** @brief The pixel data of the image. */
     u8* pixels;
+    /** @brief Indicates if the pixels were decoded into memory from image_resource_params.pixels_acquire, which the loader does not own. */
+    b8 pixels_acquired;
 } image_resource_data;
 
+/**
+ * @brief A function pointer definition for acquiring the memory an image is decoded into.
+ * Invoked from the loading thread, with the size of the decoded image before any levels are skipped.
+ * Returns the memory, which should be cached for reading as the image is decoded and scanned in place,
+ * or 0 to have the loader allocate its own. The memory stays the caller's, whether or not the load succeeds.
+ */
+typedef void* (*pfn_image_pixels_acquire)(u64 size, void* user_data);
+
 /** @brief Parameters used when loading an image. */
 typedef struct image_resource_params {
     /** @brief Indicates if the image should be flipped on the y-axis when loaded. */
     b8 flip_y;
+    /** @brief The number of the image's largest levels to skip, loading it smaller. Clamped to its smallest level. */
+    u32 first_level;
+    /** @brief If nonzero, further levels are skipped until the first one loaded is no larger than this across. */
+    u32 max_size;
+    /**
+     * @brief Acquires the memory uncompressed images are decoded into, such as mapped staging memory, so they are
+     * not copied there afterward. Optional. Images loaded pre-compressed from a container do not use it.
+     */
+    pfn_image_pixels_acquire pixels_acquire;
+    /** @brief The data passed to pixels_acquire. */
+    void* pixels_acquire_user_data;
 } image_resource_params;
 
 /** @brief Determines face culling mode during rendering. */
@@ -114,7 +170,17 @@ typedef enum texture_flag {
     /** @brief Indicates if the texture was created via wrapping vs traditional creation. */
     TEXTURE_FLAG_IS_WRAPPED = 0x4,
     /** @brief Indicates the texture is a depth texture. */
-    TEXTURE_FLAG_DEPTH = 0x8
+    TEXTURE_FLAG_DEPTH = 0x8,
+    /**
+     * @brief Indicates a writeable texture may also be bound as a storage image. It is kept in the
+     * general layout, in which it may be both sampled and written by shaders.
+     */
+    TEXTURE_FLAG_IS_STORAGE = 0x10,
+    /**
+     * @brief Indicates a writeable texture is only ever an attachment whose contents never leave
+     * the pass rendering to it, so it may be backed by lazily-allocated memory.
+     */
+    TEXTURE_FLAG_TRANSIENT = 0x20
 } texture_flag;
 
 /** @brief Holds bit flags for textures.. */
@@ -144,6 +210,14 @@ typedef struct texture {
     u32 height;
     /** @brief The number of channels in the texture. */
     u8 channel_count;
+    /** @brief The format the texture is held in on the GPU. */
+    texture_format format;
+    /**
+     * @brief The number of mip levels. When creating, the number held in the data, one after
+     * another; given just one, the renderer generates the rest of the chain where it can.
+     * Set to the number the texture ends up with.
+     */
+    u32 mip_levels;
     /** @brief Holds various flags for this texture. */
     texture_flag_bits flags;
     /** @brief The texture generation. Incremented every time the data is reloaded. */
@@ -231,6 +305,9 @@ typedef enum font_type {
 
 typedef struct font_data {
     font_type type;
+    // Glyphs are signed distance fields, each texel the distance to the glyph's edge, with 0.5 on it.
+    // Such fonts are drawn at any size from an atlas of a single size.
+    b8 sdf;
     char face[256];
     u32 size;
     i32 line_height;
@@ -242,6 +319,11 @@ typedef struct font_data {
     font_glyph* glyphs;
     u32 kerning_count;
     font_kerning* kernings;
+    // Finds glyphs and kernings without searching them. Rebuilt whenever they change.
+    u64 lookup_size;
+    struct font_lookup* lookup;
+    // Changes whenever the glyphs are added to, placed or drawn, so that layouts of older glyphs are not reused.
+    u32 generation;
     f32 tab_x_advance;
     u32 internal_data_size;
     void* internal_data;
@@ -293,6 +375,12 @@ typedef struct material_config {
     char specular_map_name[TEXTURE_NAME_MAX_LENGTH];
     /** @brief The normal map name. */
     char normal_map_name[TEXTURE_NAME_MAX_LENGTH];
+    /**
+     * @brief Indicates if the diffuse map may be packed into the shared texture atlas, as suits small
+     * UI textures which are not repeated. Geometries of the material have their texture coordinates
+     * mapped into its part of the atlas.
+     */
+    b8 atlas;
 } material_config;
 
 /**
@@ -313,6 +401,11 @@ typedef struct material {
     vec4 diffuse_colour;
     /** @brief The diffuse texture map. */
     texture_map diffuse_map;
+    /**
+     * @brief The part of the diffuse map's texture the material is drawn from: its offset in xy and its
+     * size in zw. The whole texture, but for materials whose diffuse map is packed into the atlas.
+     */
+    vec4 diffuse_uv_rect;
     /** @brief The specular texture map. */
     texture_map specular_map;
     /** @brief The normal texture map. */
@@ -324,12 +417,28 @@ typedef struct material {
     u32 shader_id;
 
     /** @brief Synced to the renderer's current frame number when the material has been applied that frame. */
-    u32 render_frame_number;
+    u64 render_frame_number;
 } material;
 
 /** @brief The maximum length of a geometry name. */
 #define GEOMETRY_NAME_MAX_LENGTH 256
 
+/** @brief The most levels of detail a geometry can have, including the full one. */
+#define GEOMETRY_MAX_LODS 4
+
+/** @brief A level of detail of a geometry, as a range of its index buffer. */
+typedef struct geometry_lod {
+    /** @brief The first index of the level in the geometry's index buffer. */
+    u32 index_offset;
+    /** @brief The number of indices in the level. */
+    u32 index_count;
+    /**
+     * @brief The furthest the level's surface is from the full geometry's, relative to the
+     * radius of the sphere around the geometry's extents. 0 for the full geometry.
+     */
+    f32 error;
+} geometry_lod;
+
 /**
  * @brief Represents actual geometry in the world.
  * Typically (but not always, depending on use) paired with a material.
@@ -345,6 +454,14 @@ typedef struct geometry {
     vec3 center;
     /** @brief The extents of the geometry in local coordinates. */
     extents_3d extents;
+    /** @brief The number of levels of detail. At least 1, once uploaded. */
+    u8 lod_count;
+    /** @brief The levels of detail, from the full geometry to the coarsest, all sharing the same vertices. */
+    geometry_lod lods[GEOMETRY_MAX_LODS];
+    /** @brief The number of meshlets the full level of detail is split into, or 0 if it is culled whole. */
+    u32 meshlet_count;
+    /** @brief The meshlets of the full level of detail, each a range of its indices. Owned by the geometry. */
+    geometry_meshlet* meshlets;
     /** @brief The geometry name. */
     char name[GEOMETRY_NAME_MAX_LENGTH];
     /** @brief A pointer to the material associated with this geometry.. */
@@ -357,6 +474,10 @@ typedef struct mesh {
     u16 geometry_count;
     geometry** geometries;
     transform transform;
+    /** @brief The dependencies acquired as loading began, held until the mesh is unloaded, or 0 if it has no manifest. */
+    struct dependency_manifest* dependencies;
+    /** @brief The handle of the job loading the mesh, as a job_handle. */
+    u32 load_job;
 } mesh;
 
 /** @brief Shader stages available in the system. */
@@ -380,6 +501,12 @@ typedef enum shader_attribute_type {
     SHADER_ATTRIB_TYPE_UINT16 = 8U,
     SHADER_ATTRIB_TYPE_INT32 = 9U,
     SHADER_ATTRIB_TYPE_UINT32 = 10U,
+    /** @brief Two 16-bit signed normalized values, read by the shader as a vec2 in [-1, 1]. */
+    SHADER_ATTRIB_TYPE_SNORM16_2 = 11U,
+    /** @brief Two 16-bit (half precision) floats, read by the shader as a vec2. */
+    SHADER_ATTRIB_TYPE_FLOAT16_2 = 12U,
+    /** @brief Four 8-bit unsigned normalized values, read by the shader as a vec4 in [0, 1]. */
+    SHADER_ATTRIB_TYPE_UNORM8_4 = 13U,
 } shader_attribute_type;
 
 /** @brief Available uniform types. */
@@ -396,6 +523,10 @@ typedef enum shader_uniform_type {
     SHADER_UNIFORM_TYPE_UINT32 = 9U,
     SHADER_UNIFORM_TYPE_MATRIX_4 = 10U,
     SHADER_UNIFORM_TYPE_SAMPLER = 11U,
+    /** @brief A buffer read and written by shaders, bound as a renderbuffer. Global scope only. */
+    SHADER_UNIFORM_TYPE_STORAGE_BUFFER = 12U,
+    /** @brief An image read and written by shaders, bound as a texture created with TEXTURE_FLAG_IS_STORAGE. Global scope only. */
+    SHADER_UNIFORM_TYPE_STORAGE_IMAGE = 13U,
     SHADER_UNIFORM_TYPE_CUSTOM = 255U
 } shader_uniform_type;
 
@@ -440,6 +571,9 @@ typedef struct shader_uniform_config {
     shader_scope scope;
 } shader_uniform_config;
 
+/** @brief The most variants a shader may have. */
+#define SHADER_MAX_VARIANTS 8
+
 /**
  * @brief Configuration for a shader. Typically created and
  * destroyed by the shader resource loader, and set to the
@@ -471,6 +605,14 @@ typedef struct shader_config {
     /** @brief The collection of stage file names to be loaded (one per stage). Must align with stages array. Darray. */
     char** stage_filenames;
 
+    /** @brief The number of variants. 0 if the shader has none, but the one it is built as. */
+    u8 variant_count;
+    /**
+     * @brief The names of the variants, in order. Each is built as its own pipeline, with its index as the
+     * specialization constant with id 0, so stages may branch on it at no cost. Darray.
+     */
+    char** variant_names;
+
     // TODO: Convert these bools to flags.
     /** @brief Indicates if depth testing should be done. */
     b8 depth_test;
@@ -479,4 +621,30 @@ typedef struct shader_config {
      * NOTE: This is ignored if depth_test is false.
      */
     b8 depth_write;
+    /**
+     * @brief Indicates if the shader reads per-draw data, such as the model matrix, from the renderer's
+     * draw data buffer rather than from push constants. It is bound at the set after the shader's own.
+     */
+    b8 draw_data;
+    /**
+     * @brief Indicates if the shader samples its instance textures from the renderer's bindless texture table.
+     * Each instance sampler is then a u32 index in the instance uniform buffer, in configured order, and the
+     * table is bound at the set after the draw data set, if any.
+     */
+    b8 bindless;
+    /**
+     * @brief Indicates if the shader reads its local uniforms from a uniform buffer in the renderer's per-frame
+     * uniform arena rather than from push constants, allowing more per-draw data. It is bound with a dynamic
+     * offset at the set after all others but the vertex set.
+     */
+    b8 local_ubo;
+    /**
+     * @brief Indicates if the shader pulls its vertices from the vertex buffer, bound as a storage buffer at the
+     * set after all others, by gl_VertexIndex, rather than having them fed through vertex attributes. A pipeline
+     * of such a shader has no vertex input, so geometries of any vertex format may be drawn with it. Batched draws
+     * find the stride of their geometry's vertices in their draw data; others must know it.
+     */
+    b8 vertex_pulling;
+    /** @brief Indicates if the shader draws a list of lines, two vertices each, rather than of triangles. */
+    b8 lines;
 } shader_config;
@@ -0,0 +1,384 @@
+#include "spirv_reflect.h"
+
+#include "core/logger.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+
+#define SPIRV_MAGIC 0x07230203
+// The header is five words: magic, version, generator, id bound and schema.
+#define SPIRV_HEADER_WORD_COUNT 5
+
+// Opcodes.
+#define SPIRV_OP_MEMBER_NAME 6
+#define SPIRV_OP_TYPE_INT 21
+#define SPIRV_OP_TYPE_FLOAT 22
+#define SPIRV_OP_TYPE_VECTOR 23
+#define SPIRV_OP_TYPE_MATRIX 24
+#define SPIRV_OP_TYPE_IMAGE 25
+#define SPIRV_OP_TYPE_SAMPLER 26
+#define SPIRV_OP_TYPE_SAMPLED_IMAGE 27
+#define SPIRV_OP_TYPE_ARRAY 28
+#define SPIRV_OP_TYPE_STRUCT 30
+#define SPIRV_OP_TYPE_POINTER 32
+#define SPIRV_OP_CONSTANT 43
+#define SPIRV_OP_VARIABLE 59
+#define SPIRV_OP_DECORATE 71
+#define SPIRV_OP_MEMBER_DECORATE 72
+
+// Decorations.
+#define SPIRV_DECORATION_BLOCK 2
+#define SPIRV_DECORATION_BINDING 33
+#define SPIRV_DECORATION_DESCRIPTOR_SET 34
+#define SPIRV_DECORATION_OFFSET 35
+
+// Storage classes.
+#define SPIRV_STORAGE_UNIFORM_CONSTANT 0
+#define SPIRV_STORAGE_UNIFORM 2
+#define SPIRV_STORAGE_PUSH_CONSTANT 9
+
+// The Sampled operand of OpTypeImage for images used without a sampler, as storage images.
+#define SPIRV_IMAGE_SAMPLED_STORAGE 2
+
+// The deepest types are followed when sizing, which nothing real comes near.
+#define SPIRV_MAX_TYPE_DEPTH 8
+
+// What is known of an id.
+typedef struct spirv_id {
+    // The word index of the instruction defining the id, or 0 if it is not a type, constant or variable.
+    u32 definition;
+    u32 set;
+    u32 binding;
+    b8 is_block;
+} spirv_id;
+
+typedef struct spirv_module {
+    const u32* words;
+    u32 word_count;
+    u32 bound;
+    spirv_id* ids;
+} spirv_module;
+
+// The word of the instruction at index, holding its word count and opcode.
+static u32 instruction_opcode(const spirv_module* m, u32 index) {
+    return m->words[index] & 0xFFFF;
+}
+
+static u32 instruction_word_count(const spirv_module* m, u32 index) {
+    return m->words[index] >> 16;
+}
+
+// Gets the operand of an id's defining instruction, or 0 if it has none or it is out of range.
+static u32 id_operand(const spirv_module* m, u32 id, u32 operand) {
+    if (id >= m->bound || !m->ids[id].definition) {
+        return 0;
+    }
+    u32 index = m->ids[id].definition;
+    return operand < instruction_word_count(m, index) ? m->words[index + operand] : 0;
+}
+
+static u32 id_opcode(const spirv_module* m, u32 id) {
+    return (id < m->bound && m->ids[id].definition) ? instruction_opcode(m, m->ids[id].definition) : 0;
+}
+
+// Copies the string operand starting at word of the instruction at index.
+static void instruction_string(const spirv_module* m, u32 index, u32 word, char* out_str, u32 max_length) {
+    u32 end = index + instruction_word_count(m, index);
+    const char* str = (const char*)(m->words + index + word);
+    u32 available = (end > index + word) ? (end - index - word) * 4 : 0;
+    u32 i = 0;
+    for (; i < available && i + 1 < max_length && str[i]; ++i) {
+        out_str[i] = str[i];
+    }
+    out_str[i] = 0;
+}
+
+// The size of a type in bytes, without padding. Arrays take their stride-less size.
+static u32 type_size(const spirv_module* m, u32 type, u32 depth) {
+    if (depth > SPIRV_MAX_TYPE_DEPTH) {
+        return 0;
+    }
+    switch (id_opcode(m, type)) {
+        case SPIRV_OP_TYPE_INT:
+        case SPIRV_OP_TYPE_FLOAT:
+            return id_operand(m, type, 2) / 8;
+        case SPIRV_OP_TYPE_VECTOR:
+        case SPIRV_OP_TYPE_MATRIX:
+            return id_operand(m, type, 3) * type_size(m, id_operand(m, type, 2), depth + 1);
+        case SPIRV_OP_TYPE_ARRAY: {
+            u32 length = id_opcode(m, id_operand(m, type, 3)) == SPIRV_OP_CONSTANT ? id_operand(m, id_operand(m, type, 3), 3) : 0;
+            return length * type_size(m, id_operand(m, type, 2), depth + 1);
+        }
+        case SPIRV_OP_TYPE_STRUCT: {
+            u32 size = 0;
+            u32 member_count = instruction_word_count(m, m->ids[type].definition) - 2;
+            for (u32 i = 0; i < member_count; ++i) {
+                size += type_size(m, id_operand(m, type, 2 + i), depth + 1);
+            }
+            return size;
+        }
+        default:
+            return 0;
+    }
+}
+
+// Gathers the members of the block whose struct type is given.
+static void block_members_gather(const spirv_module* m, u32 struct_type, spirv_block* block) {
+    u32 member_count = KMIN(instruction_word_count(m, m->ids[struct_type].definition) - 2, SPIRV_MAX_BLOCK_MEMBERS);
+    block->member_count = member_count;
+    for (u32 i = 0; i < member_count; ++i) {
+        block->members[i].size = type_size(m, id_operand(m, struct_type, 2 + i), 0);
+    }
+    for (u32 index = SPIRV_HEADER_WORD_COUNT; index < m->word_count; index += instruction_word_count(m, index)) {
+        u32 opcode = instruction_opcode(m, index);
+        if ((opcode != SPIRV_OP_MEMBER_NAME && opcode != SPIRV_OP_MEMBER_DECORATE) || instruction_word_count(m, index) < 4 ||
+            m->words[index + 1] != struct_type || m->words[index + 2] >= member_count) {
+            continue;
+        }
+        spirv_block_member* member = &block->members[m->words[index + 2]];
+        if (opcode == SPIRV_OP_MEMBER_NAME) {
+            instruction_string(m, index, 3, member->name, SPIRV_MAX_NAME_LENGTH);
+        } else if (m->words[index + 3] == SPIRV_DECORATION_OFFSET && instruction_word_count(m, index) >= 5) {
+            member->offset = m->words[index + 4];
+        }
+    }
+}
+
+// Adds what the variable at index declares, if it is a uniform block or samplers.
+static void variable_reflect(const spirv_module* m, u32 index, spirv_reflection* out_reflection) {
+    u32 variable = m->words[index + 2];
+    u32 storage = m->words[index + 3];
+    u32 type = id_operand(m, m->words[index + 1], 3);
+    if (variable >= m->bound) {
+        return;
+    }
+
+    if (storage == SPIRV_STORAGE_UNIFORM || storage == SPIRV_STORAGE_PUSH_CONSTANT) {
+        // Uniform storage also holds old-style storage buffers, which are not decorated as blocks.
+        if (id_opcode(m, type) != SPIRV_OP_TYPE_STRUCT || !m->ids[type].is_block || out_reflection->block_count == SPIRV_MAX_BLOCKS) {
+            return;
+        }
+        spirv_block* block = &out_reflection->blocks[out_reflection->block_count++];
+        block->is_push_constant = storage == SPIRV_STORAGE_PUSH_CONSTANT;
+        block->set = m->ids[variable].set;
+        block->binding = m->ids[variable].binding;
+        block_members_gather(m, type, block);
+    } else if (storage == SPIRV_STORAGE_UNIFORM_CONSTANT) {
+        // Arrays of samplers count each one.
+        u32 count = 1;
+        for (u32 depth = 0; depth < SPIRV_MAX_TYPE_DEPTH && id_opcode(m, type) == SPIRV_OP_TYPE_ARRAY; ++depth) {
+            u32 length = id_operand(m, type, 3);
+            count *= id_opcode(m, length) == SPIRV_OP_CONSTANT ? id_operand(m, length, 3) : 1;
+            type = id_operand(m, type, 2);
+        }
+        u32 opcode = id_opcode(m, type);
+        if ((opcode != SPIRV_OP_TYPE_SAMPLED_IMAGE && opcode != SPIRV_OP_TYPE_IMAGE && opcode != SPIRV_OP_TYPE_SAMPLER) || out_reflection->sampler_count == SPIRV_MAX_SAMPLERS) {
+            return;
+        }
+        // Storage images are bound with the storage set, not as samplers.
+        if (opcode == SPIRV_OP_TYPE_IMAGE && id_operand(m, type, 7) == SPIRV_IMAGE_SAMPLED_STORAGE) {
+            return;
+        }
+        spirv_sampler* sampler = &out_reflection->samplers[out_reflection->sampler_count++];
+        sampler->set = m->ids[variable].set;
+        sampler->binding = m->ids[variable].binding;
+        sampler->count = count;
+    }
+}
+
+b8 spirv_reflect(const void* code, u64 size, spirv_reflection* out_reflection) {
+    if (!code || !out_reflection) {
+        return false;
+    }
+    kzero_memory(out_reflection, sizeof(spirv_reflection));
+    if (size < SPIRV_HEADER_WORD_COUNT * 4 || size % 4 != 0 || ((const u32*)code)[0] != SPIRV_MAGIC) {
+        KERROR("spirv_reflect - the code is not SPIR-V.");
+        return false;
+    }
+
+    spirv_module m = {};
+    m.words = code;
+    m.word_count = (u32)(size / 4);
+    m.bound = m.words[3];
+    if (m.bound == 0 || m.bound > m.word_count) {
+        KERROR("spirv_reflect - the SPIR-V has an invalid id bound (%u).", m.bound);
+        return false;
+    }
+    m.ids = kallocate(sizeof(spirv_id) * m.bound, MEMORY_TAG_ARRAY);
+
+    // Find where each id is defined, and what it is decorated with.
+    b8 result = true;
+    for (u32 index = SPIRV_HEADER_WORD_COUNT; index < m.word_count;) {
+        u32 word_count = instruction_word_count(&m, index);
+        if (word_count == 0 || index + word_count > m.word_count) {
+            KERROR("spirv_reflect - the SPIR-V has an instruction which runs past its end.");
+            result = false;
+            break;
+        }
+        u32 opcode = instruction_opcode(&m, index);
+        u32 result_id = INVALID_ID;
+        if (opcode >= SPIRV_OP_TYPE_INT && opcode <= SPIRV_OP_TYPE_POINTER && word_count >= 2) {
+            result_id = m.words[index + 1];
+        } else if ((opcode == SPIRV_OP_CONSTANT || opcode == SPIRV_OP_VARIABLE) && word_count >= 4) {
+            result_id = m.words[index + 2];
+        } else if (opcode == SPIRV_OP_DECORATE && word_count >= 3 && m.words[index + 1] < m.bound) {
+            spirv_id* target = &m.ids[m.words[index + 1]];
+            u32 decoration = m.words[index + 2];
+            if (decoration == SPIRV_DECORATION_BLOCK) {
+                target->is_block = true;
+            } else if (decoration == SPIRV_DECORATION_DESCRIPTOR_SET && word_count >= 4) {
+                target->set = m.words[index + 3];
+            } else if (decoration == SPIRV_DECORATION_BINDING && word_count >= 4) {
+                target->binding = m.words[index + 3];
+            }
+        }
+        if (result_id < m.bound) {
+            m.ids[result_id].definition = index;
+        }
+        index += word_count;
+    }
+
+    // Then gather the variables holding uniforms.
+    for (u32 index = SPIRV_HEADER_WORD_COUNT; result && index < m.word_count; index += instruction_word_count(&m, index)) {
+        if (instruction_opcode(&m, index) == SPIRV_OP_VARIABLE && instruction_word_count(&m, index) >= 4) {
+            variable_reflect(&m, index, out_reflection);
+        }
+    }
+
+    kfree(m.ids, sizeof(spirv_id) * m.bound, MEMORY_TAG_ARRAY);
+    return result;
+}
+
+// Indicates if a block holds uniforms of the given scope. Locals are push constants, unless the shader
+// takes a local uniform block, which follows the global and instance sets.
+static b8 block_in_scope(const shader_config* config, const spirv_block* block, shader_scope scope) {
+    if (scope == SHADER_SCOPE_LOCAL) {
+        return config->local_ubo ? (!block->is_push_constant && block->set > SHADER_SCOPE_INSTANCE) : block->is_push_constant;
+    }
+    return !block->is_push_constant && block->set == (u32)scope;
+}
+
+// Indicates if a uniform type is the same size in shader code as in the config.
+static b8 uniform_size_is_exact(shader_uniform_type type) {
+    switch (type) {
+        case SHADER_UNIFORM_TYPE_FLOAT32:
+        case SHADER_UNIFORM_TYPE_FLOAT32_2:
+        case SHADER_UNIFORM_TYPE_FLOAT32_3:
+        case SHADER_UNIFORM_TYPE_FLOAT32_4:
+        case SHADER_UNIFORM_TYPE_INT32:
+        case SHADER_UNIFORM_TYPE_UINT32:
+        case SHADER_UNIFORM_TYPE_MATRIX_4:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static const char* scope_block_name(const shader_config* config, shader_scope scope) {
+    switch (scope) {
+        case SHADER_SCOPE_GLOBAL:
+            return "set 0 uniform block";
+        case SHADER_SCOPE_INSTANCE:
+            return "set 1 uniform block";
+        default:
+            return config->local_ubo ? "local uniform block" : "push constant block";
+    }
+}
+
+b8 spirv_reflection_check_uniforms(const shader_config* config, u32 stage_count, const spirv_reflection* reflections) {
+    if (!config || (stage_count && !reflections)) {
+        return false;
+    }
+
+    b8 result = true;
+    u32 config_sampler_counts[2] = {0, 0};
+    for (u32 u = 0; u < config->uniform_count; ++u) {
+        const shader_uniform_config* uniform = &config->uniforms[u];
+        if (uniform->type == SHADER_UNIFORM_TYPE_SAMPLER) {
+            if (uniform->scope < SHADER_SCOPE_LOCAL) {
+                config_sampler_counts[uniform->scope]++;
+            }
+            continue;
+        }
+        if (uniform->type == SHADER_UNIFORM_TYPE_STORAGE_BUFFER || uniform->type == SHADER_UNIFORM_TYPE_STORAGE_IMAGE) {
+            // Storage bindings are in a set of their own, which is not reflected.
+            continue;
+        }
+
+        // Look for it in any stage, noting whether there is anything named to look among.
+        const spirv_block_member* found = 0;
+        b8 block_found = false;
+        b8 names_found = false;
+        for (u32 s = 0; s < stage_count && !found; ++s) {
+            for (u32 b = 0; b < reflections[s].block_count && !found; ++b) {
+                const spirv_block* block = &reflections[s].blocks[b];
+                if (!block_in_scope(config, block, uniform->scope)) {
+                    continue;
+                }
+                block_found = true;
+                for (u32 i = 0; i < block->member_count; ++i) {
+                    names_found = names_found || block->members[i].name[0];
+                    if (strings_equal(block->members[i].name, uniform->name)) {
+                        found = &block->members[i];
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (!block_found) {
+            KERROR("Shader '%s' has uniform '%s', but no stage has a %s.", config->name, uniform->name, scope_block_name(config, uniform->scope));
+            result = false;
+        } else if (!found && names_found) {
+            KERROR("Shader '%s' has uniform '%s', but it is not in any stage's %s.", config->name, uniform->name, scope_block_name(config, uniform->scope));
+            result = false;
+        } else if (found && uniform_size_is_exact(uniform->type) && found->size != uniform->size) {
+            KERROR("Shader '%s' has uniform '%s' of %u bytes, but the stages declare it as %u bytes.", config->name, uniform->name, uniform->size, found->size);
+            result = false;
+        }
+    }
+
+    // Samplers bound in each set, counting bindings declared by several stages once.
+    for (u32 scope = 0; scope < 2; ++scope) {
+        u32 bound_count = 0;
+        for (u32 s = 0; s < stage_count; ++s) {
+            for (u32 i = 0; i < reflections[s].sampler_count; ++i) {
+                const spirv_sampler* sampler = &reflections[s].samplers[i];
+                if (sampler->set != scope) {
+                    continue;
+                }
+                b8 seen = false;
+                for (u32 earlier = 0; earlier < s && !seen; ++earlier) {
+                    for (u32 j = 0; j < reflections[earlier].sampler_count; ++j) {
+                        if (reflections[earlier].samplers[j].set == sampler->set && reflections[earlier].samplers[j].binding == sampler->binding) {
+                            seen = true;
+                            break;
+                        }
+                    }
+                }
+                bound_count += seen ? 0 : sampler->count;
+            }
+        }
+        if (stage_count && bound_count != config_sampler_counts[scope]) {
+            KERROR("Shader '%s' has %u %s samplers, but the stages bind %u in set %u.", config->name, config_sampler_counts[scope], scope == 0 ? "global" : "instance", bound_count, scope);
+            result = false;
+        }
+    }
+
+    // Members the config does not mention are not updated, which is allowed but likely a mistake.
+    for (u32 s = 0; s < stage_count; ++s) {
+        for (u32 b = 0; b < reflections[s].block_count; ++b) {
+            const spirv_block* block = &reflections[s].blocks[b];
+            for (u32 i = 0; i < block->member_count; ++i) {
+                const char* name = block->members[i].name;
+                b8 known = !name[0];
+                for (u32 u = 0; u < config->uniform_count && !known; ++u) {
+                    known = block_in_scope(config, block, config->uniforms[u].scope) && strings_equal(config->uniforms[u].name, name);
+                }
+                if (!known) {
+                    KWARN("Shader '%s' stage %u declares '%s' in its %s, which the config does not have.", config->name, s, name, block->is_push_constant ? "push constant block" : "uniform block");
+                }
+            }
+        }
+    }
+    return result;
+}
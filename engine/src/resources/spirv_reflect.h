@@ -0,0 +1,97 @@
+/**
+ * @file spirv_reflect.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief This file contains reflection of compiled SPIR-V shader stages, finding the uniform
+ * blocks, push constants and samplers they declare, and checking those against the uniforms
+ * of a shader config.
+ * @details Only what the checks need is gathered: the set and binding of each uniform block and
+ * sampler, and the names, offsets and sizes of block members. Member names come from debug names,
+ * which glslc keeps unless told to strip them; stages without them are not checked by name.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "resources/resource_types.h"
+
+/** @brief The most uniform blocks gathered from a stage. */
+#define SPIRV_MAX_BLOCKS 8
+/** @brief The most members gathered from a uniform block. */
+#define SPIRV_MAX_BLOCK_MEMBERS 32
+/** @brief The most sampler bindings gathered from a stage. */
+#define SPIRV_MAX_SAMPLERS 8
+/** @brief The longest member name gathered, including its terminator. Longer names are cut short. */
+#define SPIRV_MAX_NAME_LENGTH 64
+
+/** @brief A member of a uniform block. */
+typedef struct spirv_block_member {
+    /** @brief The member's name, or empty if the stage has no debug names. */
+    char name[SPIRV_MAX_NAME_LENGTH];
+    /** @brief The offset of the member from the start of the block, in bytes. */
+    u32 offset;
+    /** @brief The size of the member in bytes, not counting any padding after it. */
+    u32 size;
+} spirv_block_member;
+
+/** @brief A uniform block, or the push constant block. */
+typedef struct spirv_block {
+    /** @brief Indicates if this is the push constant block, which has no set or binding. */
+    b8 is_push_constant;
+    /** @brief The descriptor set of the block. */
+    u32 set;
+    /** @brief The binding of the block within its set. */
+    u32 binding;
+    /** @brief The number of members gathered. */
+    u32 member_count;
+    /** @brief The members gathered, in the order they are declared. */
+    spirv_block_member members[SPIRV_MAX_BLOCK_MEMBERS];
+} spirv_block;
+
+/** @brief A binding of one or an array of samplers. */
+typedef struct spirv_sampler {
+    /** @brief The descriptor set of the binding. */
+    u32 set;
+    /** @brief The binding within its set. */
+    u32 binding;
+    /** @brief The number of samplers, which is the length of the array if it is one. */
+    u32 count;
+} spirv_sampler;
+
+/** @brief What was found in a SPIR-V stage. */
+typedef struct spirv_reflection {
+    /** @brief The number of uniform blocks found. */
+    u32 block_count;
+    /** @brief The uniform blocks found. */
+    spirv_block blocks[SPIRV_MAX_BLOCKS];
+    /** @brief The number of sampler bindings found. */
+    u32 sampler_count;
+    /** @brief The sampler bindings found. */
+    spirv_sampler samplers[SPIRV_MAX_SAMPLERS];
+} spirv_reflection;
+
+/**
+ * @brief Gathers the uniform blocks and samplers declared by a SPIR-V stage.
+ * @param code The SPIR-V code.
+ * @param size The size of the code in bytes.
+ * @param out_reflection A pointer to hold what was found.
+ * @returns True if the code was read; false if it is not valid SPIR-V.
+ */
+KAPI b8 spirv_reflect(const void* code, u64 size, spirv_reflection* out_reflection);
+
+/**
+ * @brief Checks the uniforms of a shader config against the stages it is made of. Each uniform
+ * must be a member of a block of its scope in at least one stage: a set 0 uniform block for global
+ * scope, a set 1 uniform block for instance scope and the push constant block for local scope. Its
+ * size must match, for types whose size is the same in shader code. Samplers of each scope must add
+ * up to the samplers bound in that scope's set. Members the config does not mention are warned about.
+ * @param config The shader config.
+ * @param stage_count The number of stages reflected.
+ * @param reflections What was found in each stage.
+ * @returns True if the uniforms match; otherwise false, with each mismatch logged.
+ */
+KAPI b8 spirv_reflection_check_uniforms(const shader_config* config, u32 stage_count, const spirv_reflection* reflections);
@@ -0,0 +1,147 @@
+#include "text_layout_cache.h"
+
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+
+// FNV-1a, continuing from the given hash.
+static u64 bytes_hash(u64 hash, const u8* bytes, u64 size) {
+    for (u64 i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static u64 string_hash(const char* text) {
+    return bytes_hash(0xcbf29ce484222325ull, (const u8*)text, string_length(text));
+}
+
+static u64 font_hash(const font_data* font) {
+    u64 hash = string_hash(font->face);
+    u8 type = (u8)font->type;
+    return bytes_hash(hash, &type, 1);
+}
+
+static void run_release(text_layout_run* run) {
+    if (run->text) {
+        kfree(run->text, sizeof(char) * (string_length(run->text) + 1), MEMORY_TAG_STRING);
+        run->text = 0;
+    }
+    if (run->vertices) {
+        kfree(run->vertices, sizeof(vertex_2d) * 4 * run->quad_count, MEMORY_TAG_ARRAY);
+        kfree(run->indices, sizeof(u32) * 6 * run->quad_count, MEMORY_TAG_ARRAY);
+        run->vertices = 0;
+        run->indices = 0;
+    }
+    run->quad_count = 0;
+}
+
+b8 text_layout_cache_create(u32 capacity, u64* memory_requirement, void* memory, text_layout_cache* out_cache) {
+    if (capacity == 0) {
+        KERROR("text_layout_cache_create requires a non-zero capacity. Create failed.");
+        return false;
+    }
+    if (!memory_requirement) {
+        KERROR("text_layout_cache_create requires memory_requirement to exist. Create failed.");
+        return false;
+    }
+
+    *memory_requirement = sizeof(text_layout_run) * capacity;
+
+    // If only obtaining requirement, boot out.
+    if (!memory) {
+        return true;
+    }
+    if (!out_cache) {
+        KERROR("text_layout_cache_create requires a pointer to hold the cache. Create failed.");
+        return false;
+    }
+
+    kzero_memory(out_cache, sizeof(text_layout_cache));
+    out_cache->capacity = capacity;
+    out_cache->runs = memory;
+    kzero_memory(out_cache->runs, sizeof(text_layout_run) * capacity);
+    return true;
+}
+
+void text_layout_cache_destroy(text_layout_cache* cache) {
+    if (cache) {
+        text_layout_cache_clear(cache);
+        kzero_memory(cache, sizeof(text_layout_cache));
+    }
+}
+
+void text_layout_cache_clear(text_layout_cache* cache) {
+    if (!cache || !cache->runs) {
+        return;
+    }
+    for (u32 i = 0; i < cache->capacity; ++i) {
+        run_release(&cache->runs[i]);
+    }
+}
+
+// Finds the run of the given key, or 0 if there is none.
+static text_layout_run* run_find(text_layout_cache* cache, u64 text_hash, u64 hash_of_font, const font_data* font, f32 scale, const char* text) {
+    for (u32 i = 0; i < cache->capacity; ++i) {
+        text_layout_run* run = &cache->runs[i];
+        if (run->text && run->text_hash == text_hash && run->font_hash == hash_of_font && run->font_size == font->size &&
+            run->font_generation == font->generation && run->scale == scale && strings_equal(run->text, text)) {
+            return run;
+        }
+    }
+    return 0;
+}
+
+const text_layout_run* text_layout_cache_get(text_layout_cache* cache, const font_data* font, f32 scale, const char* text) {
+    if (!cache || !cache->runs || !font || !text) {
+        return 0;
+    }
+
+    text_layout_run* run = run_find(cache, string_hash(text), font_hash(font), font, scale, text);
+    if (!run) {
+        cache->miss_count++;
+        return 0;
+    }
+    cache->hit_count++;
+    run->last_used = ++cache->tick;
+    return run;
+}
+
+b8 text_layout_cache_put(text_layout_cache* cache, const font_data* font, f32 scale, const char* text, u32 quad_count, const vertex_2d* vertices, const u32* indices) {
+    if (!cache || !cache->runs || !font || !text || (quad_count && (!vertices || !indices))) {
+        KERROR("text_layout_cache_put requires a created cache, a font, a string and its quads.");
+        return false;
+    }
+
+    // Replaces the run of the same key if there is one, or otherwise an unused or the least recently used one.
+    u64 text_hash = string_hash(text);
+    u64 hash_of_font = font_hash(font);
+    text_layout_run* run = run_find(cache, text_hash, hash_of_font, font, scale, text);
+    if (!run) {
+        run = &cache->runs[0];
+        for (u32 i = 0; i < cache->capacity && run->text; ++i) {
+            text_layout_run* candidate = &cache->runs[i];
+            if (!candidate->text || candidate->last_used < run->last_used) {
+                run = candidate;
+            }
+        }
+    }
+    run_release(run);
+
+    run->text_hash = text_hash;
+    run->font_hash = hash_of_font;
+    run->font_size = font->size;
+    run->font_generation = font->generation;
+    run->scale = scale;
+    run->text = string_duplicate(text);
+    run->quad_count = quad_count;
+    if (quad_count) {
+        run->vertices = kallocate(sizeof(vertex_2d) * 4 * quad_count, MEMORY_TAG_ARRAY);
+        run->indices = kallocate(sizeof(u32) * 6 * quad_count, MEMORY_TAG_ARRAY);
+        kcopy_memory(run->vertices, vertices, sizeof(vertex_2d) * 4 * quad_count);
+        kcopy_memory(run->indices, indices, sizeof(u32) * 6 * quad_count);
+    }
+    run->last_used = ++cache->tick;
+    return true;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file text_layout_cache.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Keeps the laid out glyphs of recently laid out strings, so that text changing back to
+ * a string it held before, such as a label flipping between a few values, need not be laid out again.
+ * @details A run is found by its font, the font's glyph generation, the scale of the text and the
+ * string itself. A font's generation changes whenever its glyphs do, so runs laid out with glyphs
+ * since moved or drawn are never found again, and are evicted in time. Once full, the least recently
+ * used run is evicted to make room. Runs are a handful, found by comparing hashes. Not thread-safe.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "math/math_types.h"
+#include "resources/resource_types.h"
+
+/** @brief The laid out glyphs of a string. */
+typedef struct text_layout_run {
+    /** @brief The hash of the string. */
+    u64 text_hash;
+    /** @brief The hash of the font's face and type. */
+    u64 font_hash;
+    /** @brief The size of the font. */
+    u32 font_size;
+    /** @brief The glyph generation of the font the run was laid out with. */
+    u32 font_generation;
+    /** @brief The scale the glyphs were laid out at. */
+    f32 scale;
+    /** @brief A copy of the string, or 0 if the run is unused. */
+    char* text;
+    /** @brief The number of quads, one per UTF-8 character. */
+    u32 quad_count;
+    /** @brief The vertices, four per quad, relative to the text's origin. */
+    vertex_2d* vertices;
+    /** @brief The indices, six per quad, into the vertices of the run. All 0 for quads of characters without glyphs, such as newlines. */
+    u32* indices;
+    /** @brief The tick the run was last used on. */
+    u64 last_used;
+} text_layout_run;
+
+/** @brief The text layout cache structure. */
+typedef struct text_layout_cache {
+    /** @brief The most runs the cache can hold. */
+    u32 capacity;
+    /** @brief The runs. */
+    text_layout_run* runs;
+    /** @brief Counts every get and put, to tell which run was used least recently. */
+    u64 tick;
+    /** @brief The number of gets which found a run. */
+    u64 hit_count;
+    /** @brief The number of gets which did not. */
+    u64 miss_count;
+} text_layout_cache;
+
+/**
+ * @brief Creates a new text layout cache. Should be called twice; once to obtain the memory amount
+ * required (passing memory=0), and a second time with memory being set to an allocated block.
+ *
+ * @param capacity The most runs the cache should hold.
+ * @param memory_requirement A pointer to hold the required memory for the cache.
+ * @param memory An allocated block of memory, or 0 if just obtaining the requirement.
+ * @param out_cache A pointer to hold the cache.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 text_layout_cache_create(u32 capacity, u64* memory_requirement, void* memory, text_layout_cache* out_cache);
+
+/**
+ * @brief Destroys the given cache, freeing its runs. The memory passed at creation is not freed.
+ *
+ * @param cache A pointer to the cache to be destroyed.
+ */
+KAPI void text_layout_cache_destroy(text_layout_cache* cache);
+
+/**
+ * @brief Evicts every run of the cache.
+ *
+ * @param cache A pointer to the cache.
+ */
+KAPI void text_layout_cache_clear(text_layout_cache* cache);
+
+/**
+ * @brief Finds the run laid out for the given string with the given font at the given scale.
+ *
+ * @param cache A pointer to the cache.
+ * @param font A constant pointer to the font.
+ * @param scale The scale of the text.
+ * @param text The string.
+ * @return A constant pointer to the run if there is one; otherwise 0. Valid until the next put.
+ */
+KAPI const text_layout_run* text_layout_cache_get(text_layout_cache* cache, const font_data* font, f32 scale, const char* text);
+
+/**
+ * @brief Keeps a copy of the given laid out glyphs of the given string, evicting the least
+ * recently used run if the cache is full.
+ *
+ * @param cache A pointer to the cache.
+ * @param font A constant pointer to the font the string was laid out with.
+ * @param scale The scale of the text.
+ * @param text The string.
+ * @param quad_count The number of quads.
+ * @param vertices The vertices, four per quad.
+ * @param indices The indices, six per quad.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 text_layout_cache_put(text_layout_cache* cache, const font_data* font, f32 scale, const char* text, u32 quad_count, const vertex_2d* vertices, const u32* indices);
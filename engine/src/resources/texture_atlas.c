@@ -0,0 +1,148 @@
+#include "texture_atlas.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+b8 texture_atlas_create(u32 width, u32 height, u8 channel_count, u32 padding, u64* memory_requirement, void* memory, texture_atlas* out_atlas) {
+    if (width == 0 || height == 0 || channel_count == 0) {
+        KERROR("texture_atlas_create requires a non-zero size and channel count. Create failed.");
+        return false;
+    }
+    if (!memory_requirement) {
+        KERROR("texture_atlas_create requires memory_requirement to exist. Create failed.");
+        return false;
+    }
+
+    // The shelves first, then the pixels.
+    u64 shelves_requirement = sizeof(texture_atlas_shelf) * height;
+    *memory_requirement = shelves_requirement + (u64)width * height * channel_count;
+
+    // If only obtaining requirement, boot out.
+    if (!memory) {
+        return true;
+    }
+    if (!out_atlas) {
+        KERROR("texture_atlas_create requires a pointer to hold the atlas. Create failed.");
+        return false;
+    }
+
+    kzero_memory(out_atlas, sizeof(texture_atlas));
+    out_atlas->width = width;
+    out_atlas->height = height;
+    out_atlas->channel_count = channel_count;
+    out_atlas->padding = padding;
+    out_atlas->shelf_capacity = height;
+    out_atlas->shelves = memory;
+    out_atlas->pixels = (u8*)memory + shelves_requirement;
+    texture_atlas_clear(out_atlas);
+    return true;
+}
+
+void texture_atlas_destroy(texture_atlas* atlas) {
+    if (atlas) {
+        kzero_memory(atlas, sizeof(texture_atlas));
+    }
+}
+
+// Finds the shelf the given padded size fits on wasting the fewest rows, or opens a new one.
+static texture_atlas_shelf* shelf_find(texture_atlas* atlas, u32 width, u32 height) {
+    texture_atlas_shelf* best = 0;
+    for (u32 i = 0; i < atlas->shelf_count; ++i) {
+        texture_atlas_shelf* shelf = &atlas->shelves[i];
+        if (shelf->height >= height && atlas->width - shelf->used_width >= width && (!best || shelf->height < best->height)) {
+            best = shelf;
+        }
+    }
+    if (best) {
+        return best;
+    }
+
+    u32 top = 0;
+    if (atlas->shelf_count) {
+        const texture_atlas_shelf* last = &atlas->shelves[atlas->shelf_count - 1];
+        top = last->y + last->height;
+    }
+    if (atlas->shelf_count == atlas->shelf_capacity || atlas->height - top < height || atlas->width < width) {
+        return 0;
+    }
+    texture_atlas_shelf* shelf = &atlas->shelves[atlas->shelf_count++];
+    shelf->y = top;
+    shelf->height = height;
+    shelf->used_width = 0;
+    return shelf;
+}
+
+b8 texture_atlas_add(texture_atlas* atlas, u32 width, u32 height, const u8* pixels, texture_atlas_region* out_region) {
+    if (!atlas || !atlas->pixels || width == 0 || height == 0 || !pixels || !out_region) {
+        KERROR("texture_atlas_add requires a created atlas, an image with pixels and a pointer to hold its region.");
+        return false;
+    }
+
+    u32 padding = atlas->padding;
+    u32 padded_width = width + padding * 2;
+    u32 padded_height = height + padding * 2;
+    texture_atlas_shelf* shelf = shelf_find(atlas, padded_width, padded_height);
+    if (!shelf) {
+        return false;
+    }
+    u32 left = shelf->used_width;
+    shelf->used_width += padded_width;
+
+    // Each border pixel repeats the nearest pixel of the image.
+    u32 channels = atlas->channel_count;
+    for (u32 row = 0; row < padded_height; ++row) {
+        u32 source_row = row < padding ? 0 : KMIN(row - padding, height - 1);
+        u8* dest = atlas->pixels + ((u64)(shelf->y + row) * atlas->width + left) * channels;
+        const u8* source = pixels + (u64)source_row * width * channels;
+        for (u32 column = 0; column < padding; ++column) {
+            kcopy_memory(dest + column * channels, source, channels);
+            kcopy_memory(dest + (padding + width + column) * channels, source + (width - 1) * channels, channels);
+        }
+        kcopy_memory(dest + padding * channels, source, (u64)width * channels);
+    }
+
+    out_region->x = left + padding;
+    out_region->y = shelf->y + padding;
+    out_region->width = width;
+    out_region->height = height;
+    out_region->uv_rect = (vec4){
+        (f32)out_region->x / atlas->width,
+        (f32)out_region->y / atlas->height,
+        (f32)width / atlas->width,
+        (f32)height / atlas->height};
+    atlas->region_count++;
+    atlas->dirty = true;
+    return true;
+}
+
+b8 texture_atlas_copy(const texture_atlas* source, texture_atlas* dest) {
+    if (!source || !source->pixels || !dest || !dest->pixels) {
+        KERROR("texture_atlas_copy requires two created atlases.");
+        return false;
+    }
+    if (dest->width < source->width || dest->height < source->height || dest->channel_count != source->channel_count || dest->padding != source->padding) {
+        KERROR("texture_atlas_copy requires an atlas at least as large, with the same channel count and padding, to copy to.");
+        return false;
+    }
+
+    texture_atlas_clear(dest);
+    u64 source_pitch = (u64)source->width * source->channel_count;
+    u64 dest_pitch = (u64)dest->width * dest->channel_count;
+    for (u32 row = 0; row < source->height; ++row) {
+        kcopy_memory(dest->pixels + row * dest_pitch, source->pixels + row * source_pitch, source_pitch);
+    }
+    kcopy_memory(dest->shelves, source->shelves, sizeof(texture_atlas_shelf) * source->shelf_count);
+    dest->shelf_count = source->shelf_count;
+    dest->region_count = source->region_count;
+    return true;
+}
+
+void texture_atlas_clear(texture_atlas* atlas) {
+    if (!atlas || !atlas->pixels) {
+        return;
+    }
+    kzero_memory(atlas->pixels, (u64)atlas->width * atlas->height * atlas->channel_count);
+    atlas->shelf_count = 0;
+    atlas->region_count = 0;
+    atlas->dirty = true;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file texture_atlas.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Packs many small images into the pixels of one larger texture.
+ * @details Images are placed on shelves, rows as tall as the first image placed on them, each
+ * going on the shelf it fits best or on a new shelf above the others. Each image is surrounded
+ * by a border of its own edge pixels, so filtering at its edges does not sample its neighbours.
+ * Images stay where they were placed until the atlas is cleared. The atlas only holds pixels;
+ * uploading them to a texture is up to its owner, whenever dirty is set. Not thread-safe.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "math/math_types.h"
+
+/** @brief Where an image was placed in an atlas. */
+typedef struct texture_atlas_region {
+    /** @brief The position of the image's first column, in pixels, not counting its border. */
+    u32 x;
+    /** @brief The position of the image's first row, in pixels, not counting its border. */
+    u32 y;
+    /** @brief The width of the image in pixels. */
+    u32 width;
+    /** @brief The height of the image in pixels. */
+    u32 height;
+    /** @brief The image's part of the atlas in texture coordinates: its offset in xy and its size in zw. */
+    vec4 uv_rect;
+} texture_atlas_region;
+
+/** @brief A row of an atlas which images are placed along. */
+typedef struct texture_atlas_shelf {
+    /** @brief The first row of the shelf. */
+    u32 y;
+    /** @brief The number of rows of the shelf. */
+    u32 height;
+    /** @brief The number of columns used from the left. */
+    u32 used_width;
+} texture_atlas_shelf;
+
+/** @brief The texture atlas structure. */
+typedef struct texture_atlas {
+    /** @brief The width of the atlas in pixels. */
+    u32 width;
+    /** @brief The height of the atlas in pixels. */
+    u32 height;
+    /** @brief The number of channels of each pixel, each a byte. */
+    u8 channel_count;
+    /** @brief The number of pixels of border around each image. */
+    u32 padding;
+    /** @brief The number of shelves. */
+    u32 shelf_count;
+    /** @brief The most shelves the atlas may have, one for each row. */
+    u32 shelf_capacity;
+    /** @brief The shelves, from the bottom up. */
+    texture_atlas_shelf* shelves;
+    /** @brief The number of images placed. */
+    u32 region_count;
+    /** @brief The pixels of the atlas, row by row. Zeroed where nothing was placed. */
+    u8* pixels;
+    /** @brief Set whenever pixels change. Cleared by the owner once they are uploaded. */
+    b8 dirty;
+} texture_atlas;
+
+/**
+ * @brief Maps texture coordinates of an image into its region of an atlas.
+ *
+ * @param uv_rect The region's uv rectangle.
+ * @param uv The coordinates within the image, from 0 to 1.
+ * @return The coordinates within the atlas.
+ */
+KINLINE vec2 texture_atlas_uv_map(vec4 uv_rect, vec2 uv) {
+    return (vec2){uv_rect.x + uv.x * uv_rect.z, uv_rect.y + uv.y * uv_rect.w};
+}
+
+/**
+ * @brief Creates a new texture atlas. Should be called twice; once to obtain the memory amount
+ * required (passing memory=0), and a second time with memory being set to an allocated block.
+ *
+ * @param width The width of the atlas in pixels.
+ * @param height The height of the atlas in pixels.
+ * @param channel_count The number of channels of each pixel, each a byte.
+ * @param padding The number of pixels of border to put around each image.
+ * @param memory_requirement A pointer to hold the required memory for the atlas.
+ * @param memory An allocated block of memory, or 0 if just obtaining the requirement.
+ * @param out_atlas A pointer to hold the atlas.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 texture_atlas_create(u32 width, u32 height, u8 channel_count, u32 padding, u64* memory_requirement, void* memory, texture_atlas* out_atlas);
+
+/**
+ * @brief Destroys the given atlas. The memory passed at creation is not freed.
+ *
+ * @param atlas A pointer to the atlas to be destroyed.
+ */
+KAPI void texture_atlas_destroy(texture_atlas* atlas);
+
+/**
+ * @brief Places the given image in the atlas, copying its pixels in along with its border.
+ *
+ * @param atlas A pointer to the atlas.
+ * @param width The width of the image in pixels.
+ * @param height The height of the image in pixels.
+ * @param pixels The pixels of the image, row by row, with as many channels as the atlas.
+ * @param out_region A pointer to hold where the image was placed.
+ * @return True on success; false if there is no room left for it.
+ */
+KAPI b8 texture_atlas_add(texture_atlas* atlas, u32 width, u32 height, const u8* pixels, texture_atlas_region* out_region);
+
+/**
+ * @brief Copies every image of one atlas into another at least as large, at the same positions,
+ * replacing what it held. Used to grow an atlas without moving what was placed in it; the space
+ * gained is to the right of the shelves and above them.
+ *
+ * @param source A constant pointer to the atlas to copy from.
+ * @param dest A pointer to the atlas to copy to, of the same channel count and padding.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 texture_atlas_copy(const texture_atlas* source, texture_atlas* dest);
+
+/**
+ * @brief Removes every image from the atlas, zeroing its pixels.
+ *
+ * @param atlas A pointer to the atlas.
+ */
+KAPI void texture_atlas_clear(texture_atlas* atlas);
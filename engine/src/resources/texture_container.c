@@ -0,0 +1,319 @@
+#include "texture_container.h"
+
+#include "core/logger.h"
+#include "core/kmemory.h"
+#include "math/ksimd.h"
+
+// The first twelve bytes of a KTX2 file, "«KTX 20»\r\n\x1A\n".
+static const u8 ktx2_identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+// The size of a KTX2 header and index, after which the level index starts.
+#define KTX2_LEVEL_INDEX_OFFSET 80
+// The size of each level index entry: offset, length and uncompressed length.
+#define KTX2_LEVEL_ENTRY_SIZE 24
+
+// The first four bytes of a DDS file, "DDS ".
+#define DDS_MAGIC 0x20534444
+// The size of the magic and header, and of the extended header which may follow.
+#define DDS_HEADER_SIZE 128
+#define DDS_HEADER_DX10_SIZE 20
+// Header flags.
+#define DDSD_MIPMAPCOUNT 0x20000
+#define DDPF_FOURCC 0x4
+#define DDSCAPS2_CUBEMAP 0x200
+#define DDS_DIMENSION_TEXTURE2D 3
+
+#define FOURCC(a, b, c, d) ((u32)(a) | ((u32)(b) << 8) | ((u32)(c) << 16) | ((u32)(d) << 24))
+
+static b8 is_ktx2(const u8* data, u64 size) {
+    if (size < sizeof(ktx2_identifier)) {
+        return false;
+    }
+    for (u32 i = 0; i < sizeof(ktx2_identifier); ++i) {
+        if (data[i] != ktx2_identifier[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static u32 read_u32(const u8* data, u64 offset) {
+    u32 value;
+    kcopy_memory(&value, data + offset, sizeof(u32));
+    return value;
+}
+
+static u64 read_u64(const u8* data, u64 offset) {
+    u64 value;
+    kcopy_memory(&value, data + offset, sizeof(u64));
+    return value;
+}
+
+u64 texture_format_size(texture_format format, u32 width, u32 height, u8 channel_count) {
+    u64 blocks = (u64)((width + 3) / 4) * ((height + 3) / 4);
+    switch (format) {
+        case TEXTURE_FORMAT_UNCOMPRESSED:
+            return (u64)width * height * channel_count;
+        case TEXTURE_FORMAT_BC1:
+            return blocks * 8;
+        case TEXTURE_FORMAT_BC3:
+        case TEXTURE_FORMAT_BC5:
+        case TEXTURE_FORMAT_BC7:
+        case TEXTURE_FORMAT_ASTC_4X4:
+            return blocks * 16;
+        default:
+            return 0;
+    }
+}
+
+u64 texture_format_chain_size(texture_format format, u32 width, u32 height, u8 channel_count) {
+    u64 size = texture_format_size(format, width, height, channel_count);
+    while (width > 1 || height > 1) {
+        width = KMAX(width >> 1, 1);
+        height = KMAX(height >> 1, 1);
+        size += texture_format_size(format, width, height, channel_count);
+    }
+    return size;
+}
+
+u32 texture_mip_level_for_screen_size(u32 width, u32 height, u32 level_count, f32 screen_size) {
+    u32 texels = KMAX(width, height);
+    u32 level = 0;
+    while (level + 1 < level_count && (f32)(texels >> (level + 1)) >= screen_size) {
+        ++level;
+    }
+    return level;
+}
+
+b8 texture_pixels_have_transparency(const u8* pixels, u64 size, u8 channel_count) {
+    // Only grey-alpha and RGBA data have alpha, in their last channel.
+    if (!pixels || (channel_count != 2 && channel_count != 4)) {
+        return false;
+    }
+    u64 i = 0;
+#if defined(KSIMD_ENABLED)
+    if (channel_count == 4) {
+        // Sixteen pixels at a time. The colour bytes are set, so the block is all set only if every alpha is 255.
+        ksimd_u8x16 colour_mask = ksimd_u8_splat_u32(0x00FFFFFF);
+        for (; i + 64 <= size; i += 64) {
+            ksimd_u8x16 a = ksimd_u8_and(ksimd_u8_load(pixels + i), ksimd_u8_load(pixels + i + 16));
+            ksimd_u8x16 b = ksimd_u8_and(ksimd_u8_load(pixels + i + 32), ksimd_u8_load(pixels + i + 48));
+            if (!ksimd_u8_all_set(ksimd_u8_or(ksimd_u8_and(a, b), colour_mask))) {
+                return true;
+            }
+        }
+    }
+#endif
+    // The rest one pixel at a time.
+    for (i += channel_count - 1; i < size; i += channel_count) {
+        if (pixels[i] < 255) {
+            return true;
+        }
+    }
+    return false;
+}
+
+b8 texture_format_has_alpha(texture_format format) {
+    return format != TEXTURE_FORMAT_BC5;
+}
+
+const char* texture_format_name(texture_format format) {
+    switch (format) {
+        case TEXTURE_FORMAT_UNCOMPRESSED:
+            return "uncompressed";
+        case TEXTURE_FORMAT_BC1:
+            return "BC1";
+        case TEXTURE_FORMAT_BC3:
+            return "BC3";
+        case TEXTURE_FORMAT_BC5:
+            return "BC5";
+        case TEXTURE_FORMAT_BC7:
+            return "BC7";
+        case TEXTURE_FORMAT_ASTC_4X4:
+            return "ASTC 4x4";
+        default:
+            return "unknown";
+    }
+}
+
+// Maps the VkFormat of a KTX2 file. sRGB formats are taken as their UNORM equivalents, as
+// uncompressed images are uploaded as UNORM too.
+static b8 ktx2_format(u32 vk_format, texture_format* out_format) {
+    switch (vk_format) {
+        case 131:  // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+        case 132:  // VK_FORMAT_BC1_RGB_SRGB_BLOCK
+        case 133:  // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+        case 134:  // VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+            *out_format = TEXTURE_FORMAT_BC1;
+            return true;
+        case 137:  // VK_FORMAT_BC3_UNORM_BLOCK
+        case 138:  // VK_FORMAT_BC3_SRGB_BLOCK
+            *out_format = TEXTURE_FORMAT_BC3;
+            return true;
+        case 141:  // VK_FORMAT_BC5_UNORM_BLOCK
+            *out_format = TEXTURE_FORMAT_BC5;
+            return true;
+        case 145:  // VK_FORMAT_BC7_UNORM_BLOCK
+        case 146:  // VK_FORMAT_BC7_SRGB_BLOCK
+            *out_format = TEXTURE_FORMAT_BC7;
+            return true;
+        case 157:  // VK_FORMAT_ASTC_4x4_UNORM_BLOCK
+        case 158:  // VK_FORMAT_ASTC_4x4_SRGB_BLOCK
+            *out_format = TEXTURE_FORMAT_ASTC_4X4;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Maps the DXGI_FORMAT of a DDS file with the extended header.
+static b8 dxgi_format(u32 dxgi, texture_format* out_format) {
+    switch (dxgi) {
+        case 71:  // DXGI_FORMAT_BC1_UNORM
+        case 72:  // DXGI_FORMAT_BC1_UNORM_SRGB
+            *out_format = TEXTURE_FORMAT_BC1;
+            return true;
+        case 77:  // DXGI_FORMAT_BC3_UNORM
+        case 78:  // DXGI_FORMAT_BC3_UNORM_SRGB
+            *out_format = TEXTURE_FORMAT_BC3;
+            return true;
+        case 83:  // DXGI_FORMAT_BC5_UNORM
+            *out_format = TEXTURE_FORMAT_BC5;
+            return true;
+        case 98:  // DXGI_FORMAT_BC7_UNORM
+        case 99:  // DXGI_FORMAT_BC7_UNORM_SRGB
+            *out_format = TEXTURE_FORMAT_BC7;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Fills in and checks the size of each level. Levels are each half the size of the one before.
+static b8 container_levels_check(u64 size, texture_container_info* info) {
+    for (u32 i = 0; i < info->level_count; ++i) {
+        texture_container_level* level = &info->levels[i];
+        level->width = KMAX(info->width >> i, 1);
+        level->height = KMAX(info->height >> i, 1);
+        if (level->size != texture_format_size(info->format, level->width, level->height, 0) || level->offset > size || level->size > size - level->offset) {
+            KERROR("Texture container level %u is the wrong size or out of bounds.", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+static b8 ktx2_read(const u8* data, u64 size, texture_container_info* out_info) {
+    if (size < KTX2_LEVEL_INDEX_OFFSET) {
+        KERROR("KTX2 file is too small to hold a header.");
+        return false;
+    }
+    u32 vk_format = read_u32(data, 12);
+    u32 depth = read_u32(data, 28);
+    u32 layer_count = read_u32(data, 32);
+    u32 face_count = read_u32(data, 36);
+    u32 level_count = read_u32(data, 40);
+    u32 supercompression = read_u32(data, 44);
+    out_info->width = read_u32(data, 20);
+    out_info->height = read_u32(data, 24);
+
+    if (!ktx2_format(vk_format, &out_info->format)) {
+        KERROR("KTX2 file has an unsupported VkFormat (%u).", vk_format);
+        return false;
+    }
+    if (out_info->width == 0 || out_info->height == 0 || depth > 1 || layer_count > 1 || face_count != 1) {
+        KERROR("KTX2 file must hold a single 2D image.");
+        return false;
+    }
+    if (supercompression != 0) {
+        KERROR("KTX2 file is supercompressed (scheme %u), which is not supported.", supercompression);
+        return false;
+    }
+
+    // No levels means the reader should generate them, with only the first stored.
+    out_info->level_count = KMIN(KMAX(level_count, 1), TEXTURE_CONTAINER_MAX_LEVELS);
+    if (size < KTX2_LEVEL_INDEX_OFFSET + (u64)KMAX(level_count, 1) * KTX2_LEVEL_ENTRY_SIZE) {
+        KERROR("KTX2 file is too small to hold its level index.");
+        return false;
+    }
+    for (u32 i = 0; i < out_info->level_count; ++i) {
+        u64 entry = KTX2_LEVEL_INDEX_OFFSET + (u64)i * KTX2_LEVEL_ENTRY_SIZE;
+        out_info->levels[i].offset = read_u64(data, entry);
+        out_info->levels[i].size = read_u64(data, entry + 8);
+    }
+    return container_levels_check(size, out_info);
+}
+
+static b8 dds_read(const u8* data, u64 size, texture_container_info* out_info) {
+    if (size < DDS_HEADER_SIZE || read_u32(data, 4) != 124) {
+        KERROR("DDS file is too small to hold a header, or its header is the wrong size.");
+        return false;
+    }
+    u32 flags = read_u32(data, 8);
+    out_info->height = read_u32(data, 12);
+    out_info->width = read_u32(data, 16);
+    u32 mip_count = (flags & DDSD_MIPMAPCOUNT) ? read_u32(data, 28) : 1;
+    u32 pixel_format_flags = read_u32(data, 80);
+    u32 fourcc = read_u32(data, 84);
+    u32 caps2 = read_u32(data, 112);
+
+    u64 data_offset = DDS_HEADER_SIZE;
+    if (!(pixel_format_flags & DDPF_FOURCC)) {
+        KERROR("DDS file is not block-compressed.");
+        return false;
+    }
+    if (fourcc == FOURCC('D', 'X', '1', '0')) {
+        if (size < DDS_HEADER_SIZE + DDS_HEADER_DX10_SIZE) {
+            KERROR("DDS file is too small to hold its extended header.");
+            return false;
+        }
+        u32 dxgi = read_u32(data, DDS_HEADER_SIZE);
+        if (!dxgi_format(dxgi, &out_info->format)) {
+            KERROR("DDS file has an unsupported DXGI format (%u).", dxgi);
+            return false;
+        }
+        if (read_u32(data, DDS_HEADER_SIZE + 4) != DDS_DIMENSION_TEXTURE2D || read_u32(data, DDS_HEADER_SIZE + 12) > 1) {
+            KERROR("DDS file must hold a single 2D image.");
+            return false;
+        }
+        data_offset += DDS_HEADER_DX10_SIZE;
+    } else if (fourcc == FOURCC('D', 'X', 'T', '1')) {
+        out_info->format = TEXTURE_FORMAT_BC1;
+    } else if (fourcc == FOURCC('D', 'X', 'T', '5')) {
+        out_info->format = TEXTURE_FORMAT_BC3;
+    } else if (fourcc == FOURCC('A', 'T', 'I', '2') || fourcc == FOURCC('B', 'C', '5', 'U')) {
+        out_info->format = TEXTURE_FORMAT_BC5;
+    } else {
+        KERROR("DDS file has an unsupported format.");
+        return false;
+    }
+    if (out_info->width == 0 || out_info->height == 0 || (caps2 & DDSCAPS2_CUBEMAP)) {
+        KERROR("DDS file must hold a single 2D image.");
+        return false;
+    }
+
+    // Levels follow one another, largest first.
+    out_info->level_count = KMIN(KMAX(mip_count, 1), TEXTURE_CONTAINER_MAX_LEVELS);
+    for (u32 i = 0; i < out_info->level_count; ++i) {
+        out_info->levels[i].offset = data_offset;
+        out_info->levels[i].size = texture_format_size(out_info->format, KMAX(out_info->width >> i, 1), KMAX(out_info->height >> i, 1), 0);
+        data_offset += out_info->levels[i].size;
+    }
+    return container_levels_check(size, out_info);
+}
+
+b8 texture_container_read(const void* data, u64 size, texture_container_info* out_info) {
+    if (!data || !out_info) {
+        return false;
+    }
+    kzero_memory(out_info, sizeof(texture_container_info));
+    const u8* bytes = data;
+    if (is_ktx2(bytes, size)) {
+        return ktx2_read(bytes, size, out_info);
+    }
+    if (size >= 4 && read_u32(bytes, 0) == DDS_MAGIC) {
+        return dds_read(bytes, size, out_info);
+    }
+    KERROR("Texture container is neither a KTX2 nor a DDS file.");
+    return false;
+}
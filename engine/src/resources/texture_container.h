@@ -0,0 +1,114 @@
+/**
+ * @file texture_container.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief This file contains reading of KTX2 and DDS texture containers, which hold
+ * texture data already block-compressed for the GPU, along with sizing of texture data
+ * in each texture format.
+ * @details Only containers holding a single 2D image in one of the texture formats are
+ * read, without supercompression. The contents are not copied; the levels found refer to
+ * ranges of the container's data.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "resources/resource_types.h"
+
+/** @brief The most mip levels read from a container. */
+#define TEXTURE_CONTAINER_MAX_LEVELS 16
+
+/** @brief One mip level of the image in a container. */
+typedef struct texture_container_level {
+    /** @brief The offset of the level's data from the start of the container. */
+    u64 offset;
+    /** @brief The size of the level's data in bytes. */
+    u64 size;
+    /** @brief The width of the level in texels. */
+    u32 width;
+    /** @brief The height of the level in texels. */
+    u32 height;
+} texture_container_level;
+
+/** @brief What was found in a texture container. */
+typedef struct texture_container_info {
+    /** @brief The format of the image. Never uncompressed. */
+    texture_format format;
+    /** @brief The width of the image in texels. */
+    u32 width;
+    /** @brief The height of the image in texels. */
+    u32 height;
+    /** @brief The number of mip levels found, at least one. */
+    u32 level_count;
+    /** @brief The mip levels, largest first. */
+    texture_container_level levels[TEXTURE_CONTAINER_MAX_LEVELS];
+} texture_container_info;
+
+/**
+ * @brief Gets the size of an image's data in the given format.
+ * @param format The format of the data.
+ * @param width The width of the image in texels.
+ * @param height The height of the image in texels.
+ * @param channel_count The number of channels, used only by uncompressed data.
+ * @returns The size in bytes.
+ */
+KAPI u64 texture_format_size(texture_format format, u32 width, u32 height, u8 channel_count);
+
+/**
+ * @brief Gets the size of an image's data with every mip level below it, down to 1x1.
+ * @param format The format of the data.
+ * @param width The width of the image in texels.
+ * @param height The height of the image in texels.
+ * @param channel_count The number of channels, used only by uncompressed data.
+ * @returns The size in bytes.
+ */
+KAPI u64 texture_format_chain_size(texture_format format, u32 width, u32 height, u8 channel_count);
+
+/**
+ * @brief Gets the coarsest mip level of an image which still has at least as many texels
+ * across as the given screen size, in pixels, so that drawing it there loses no detail.
+ * @param width The width of the image's first level in texels.
+ * @param height The height of the image's first level in texels.
+ * @param level_count The number of levels the image has.
+ * @param screen_size The size the image covers on screen, in pixels, across its longest side.
+ * @returns The level, from 0 to level_count - 1.
+ */
+KAPI u32 texture_mip_level_for_screen_size(u32 width, u32 height, u32 level_count, f32 screen_size);
+
+/**
+ * @brief Indicates if any pixel of uncompressed data is less than fully opaque, stopping at the
+ * first one found. Scans sixteen pixels at a time where SIMD instructions are available.
+ * @param pixels The pixel data.
+ * @param size The size of the data in bytes.
+ * @param channel_count The number of channels. Only data with 2 or 4 channels has alpha, in its last channel.
+ * @returns True if any alpha is below 255; otherwise false.
+ */
+KAPI b8 texture_pixels_have_transparency(const u8* pixels, u64 size, u8 channel_count);
+
+/**
+ * @brief Indicates if data in the given format may hold transparency. Compressed data is
+ * not inspected, so this is true of any format which can hold alpha.
+ * @param format The format.
+ * @returns True if the format has an alpha channel; otherwise false.
+ */
+KAPI b8 texture_format_has_alpha(texture_format format);
+
+/**
+ * @brief Gets a name for the given format, for logging.
+ * @param format The format.
+ * @returns The name.
+ */
+KAPI const char* texture_format_name(texture_format format);
+
+/**
+ * @brief Reads the header of a KTX2 or DDS container, telling them apart by their first bytes.
+ * @param data The contents of the container.
+ * @param size The size of the contents in bytes.
+ * @param out_info A pointer to hold what was found.
+ * @returns True if the container was read and holds a supported image; otherwise false.
+ */
+KAPI b8 texture_container_read(const void* data, u64 size, texture_container_info* out_info);
@@ -6,6 +6,8 @@
 #include "core/identifier.h"
 #include "math/kmath.h"
 #include "math/transform.h"
+#include "resources/font_lookup.h"
+#include "resources/text_layout_cache.h"
 #include "renderer/renderer_types.inl"
 #include "renderer/renderer_frontend.h"
 
@@ -24,6 +26,8 @@ b8 ui_text_create(ui_text_type type, const char* font_name, u16 font_size, const
 
     // Assign the type first
     out_text->type = type;
+    // Drawn at the size of the font's glyphs, unless the font system scales them.
+    out_text->scale = 1.0f;
 
     // Acquire the font of the correct type and assign its internal data.
     // This also gets the atlas texture.
@@ -95,6 +99,11 @@ void ui_text_destroy(ui_text* text) {
         // Release the unique identifier.
         identifier_release_id(text->unique_id);
 
+        // Stop being refreshed by the font.
+        if (text->data) {
+            font_system_release(text);
+        }
+
         if (text->text) {
             u32 text_length = string_length(text->text);
             kfree(text->text, sizeof(char) * text_length, MEMORY_TAG_STRING);
@@ -104,6 +113,10 @@ void ui_text_destroy(ui_text* text) {
         // Destroy buffers.
         renderer_renderbuffer_destroy(&text->vertex_buffer);
         renderer_renderbuffer_destroy(&text->index_buffer);
+        if (text->vertices) {
+            kfree(text->vertices, sizeof(vertex_2d) * 4 * text->quad_capacity, MEMORY_TAG_ARRAY);
+            kfree(text->indices, sizeof(u32) * 6 * text->quad_capacity, MEMORY_TAG_ARRAY);
+        }
 
         // Release resources for font texture map.
         shader* ui_shader = shader_system_get("Shader.Builtin.UI");  // TODO: text shader.
@@ -115,6 +128,8 @@ void ui_text_destroy(ui_text* text) {
 }
 
 void ui_text_set_position(ui_text* u_text, vec3 position) {
+    // A frame being drawn may be reading the text.
+    renderer_frame_sync();
     transform_set_position(&u_text->transform, position);
 }
 
@@ -125,6 +140,9 @@ void ui_text_set_text(ui_text* u_text, const char* text) {
             return;
         }
 
+        // A frame being drawn may be reading the text.
+        renderer_frame_sync();
+
         u32 text_length = string_length(u_text->text);
         kfree(u_text->text, sizeof(char) * text_length, MEMORY_TAG_STRING);
         u_text->text = string_duplicate(text);
@@ -138,9 +156,15 @@ void ui_text_set_text(ui_text* u_text, const char* text) {
     }
 }
 
+void ui_text_refresh(ui_text* u_text) {
+    if (u_text && u_text->text) {
+        regenerate_geometry(u_text);
+    }
+}
+
 void ui_text_draw(ui_text* u_text) {
-    // TODO: utf8 length
-    u32 text_length = string_length(u_text->text);
+    // One quad per UTF-8 character, as generated.
+    u32 text_length = u_text->quad_count;
     static const u64 quad_vert_count = 4;
     if (!renderer_renderbuffer_draw(&u_text->vertex_buffer, 0, text_length * quad_vert_count, true)) {
         KERROR("Failed to draw ui font vertex buffer.");
@@ -152,40 +176,76 @@ void ui_text_draw(ui_text* u_text) {
     }
 }
 
-void regenerate_geometry(ui_text* text) {
-    // Get the UTF-8 string length
-    u32 text_length_utf8 = string_utf8_length(text->text);
-    // Also get the length in characters.
-    u32 char_length = string_length(text->text);
+// A span of quads changed by regenerating geometry, empty while first > last.
+typedef struct ui_text_dirty_span {
+    u32 first;
+    u32 last;
+} ui_text_dirty_span;
 
-    // Calculate buffer sizes.
-    static const u64 verts_per_quad = 4;
-    static const u8 indices_per_quad = 6;
-    u64 vertex_buffer_size = sizeof(vertex_2d) * verts_per_quad * text_length_utf8;
-    u64 index_buffer_size = sizeof(u32) * indices_per_quad * text_length_utf8;
+static void dirty_span_add(ui_text_dirty_span* span, u32 quad) {
+    span->first = KMIN(span->first, quad);
+    span->last = span->last == INVALID_ID ? quad : KMAX(span->last, quad);
+}
 
-    // Resize the vertex buffer, but only if larger.
-    if (vertex_buffer_size > text->vertex_buffer.total_size) {
-        if (!renderer_renderbuffer_resize(&text->vertex_buffer, vertex_buffer_size)) {
-            KERROR("regenerate_geometry for ui text failed to resize vertex renderbuffer.");
-            return;
+// Writes the given quad, or an empty one if vertices and indices are 0, over the kept geometry,
+// marking it dirty only if it differs from what is there.
+static b8 quad_vertices_equal(const vertex_2d* a, const vertex_2d* b) {
+    for (u32 i = 0; i < 4; ++i) {
+        if (a[i].position.x != b[i].position.x || a[i].position.y != b[i].position.y ||
+            a[i].texcoord.x != b[i].texcoord.x || a[i].texcoord.y != b[i].texcoord.y) {
+            return false;
         }
     }
+    return true;
+}
 
-    // Resize the index buffer, but only if larger.
-    if (index_buffer_size > text->index_buffer.total_size) {
-        if (!renderer_renderbuffer_resize(&text->index_buffer, index_buffer_size)) {
-            KERROR("regenerate_geometry for ui text failed to resize index renderbuffer.");
-            return;
+static b8 quad_indices_equal(const u32* a, const u32* b) {
+    for (u32 i = 0; i < 6; ++i) {
+        if (a[i] != b[i]) {
+            return false;
         }
     }
+    return true;
+}
+
+static void quad_write(ui_text* text, u32 quad, const vertex_2d* vertices, const u32* indices, ui_text_dirty_span* vertex_span, ui_text_dirty_span* index_span) {
+    static const vertex_2d empty_vertices[4] = {0};
+    static const u32 empty_indices[6] = {0};
+    vertex_2d* dest_vertices = text->vertices + quad * 4;
+    u32* dest_indices = text->indices + quad * 6;
+    if (!vertices) {
+        vertices = empty_vertices;
+        indices = empty_indices;
+    }
+    if (!quad_vertices_equal(dest_vertices, vertices)) {
+        kcopy_memory(dest_vertices, vertices, sizeof(vertex_2d) * 4);
+        dirty_span_add(vertex_span, quad);
+    }
+    if (!quad_indices_equal(dest_indices, indices)) {
+        kcopy_memory(dest_indices, indices, sizeof(u32) * 6);
+        dirty_span_add(index_span, quad);
+    }
+}
+
+// Uploads the given span of the kept vertices or indices, of the given size per quad, to the buffer.
+static b8 dirty_span_load(renderbuffer* buffer, const ui_text_dirty_span* span, u64 quad_size, const void* data) {
+    if (span->last == INVALID_ID) {
+        return true;
+    }
+    u64 offset = quad_size * span->first;
+    return renderer_renderbuffer_load_range(buffer, offset, quad_size * (span->last - span->first + 1), (const u8*)data + offset);
+}
+
+// Lays out each character of the text, writing its quad over the kept geometry.
+static void layout_glyphs(ui_text* text, ui_text_dirty_span* vertex_span, ui_text_dirty_span* index_span) {
+    // Get the UTF-8 string length, as set by the caller, and also the length in characters.
+    u32 text_length_utf8 = text->quad_count;
+    u32 char_length = string_length(text->text);
 
-    // Generate new geometry for each character.
+    // Generate new geometry for each character, scaled from the size of the font's glyphs to that of the text.
     f32 x = 0;
     f32 y = 0;
-    // Temp arrays to hold vertex/index data.
-    vertex_2d* vertex_buffer_data = kallocate(vertex_buffer_size, MEMORY_TAG_ARRAY);
-    u32* index_buffer_data = kallocate(index_buffer_size, MEMORY_TAG_ARRAY);
+    f32 scale = text->scale;
 
     // Take the length in chars and get the correct codepoint from it.
     for (u32 c = 0, uc = 0; c < char_length; ++c) {
@@ -194,14 +254,16 @@ void regenerate_geometry(ui_text* text) {
         // Continue to next line for newline.
         if (codepoint == '\n') {
             x = 0;
-            y += text->data->line_height;
+            y += text->data->line_height * scale;
+            quad_write(text, uc, 0, 0, vertex_span, index_span);
             // Increment utf-8 character count.
             uc++;
             continue;
         }
 
         if (codepoint == '\t') {
-            x += text->data->tab_x_advance;
+            x += text->data->tab_x_advance * scale;
+            quad_write(text, uc, 0, 0, vertex_span, index_span);
             uc++;
             continue;
         }
@@ -213,31 +275,16 @@ void regenerate_geometry(ui_text* text) {
             codepoint = -1;
         }
 
-        font_glyph* g = 0;
-        for (u32 i = 0; i < text->data->glyph_count; ++i) {
-            if (text->data->glyphs[i].codepoint == codepoint) {
-                g = &text->data->glyphs[i];
-                break;
-            }
-        }
-
-        if (!g) {
-            // If not found, use the codepoint -1
-            codepoint = -1;
-            for (u32 i = 0; i < text->data->glyph_count; ++i) {
-                if (text->data->glyphs[i].codepoint == codepoint) {
-                    g = &text->data->glyphs[i];
-                    break;
-                }
-            }
-        }
+        // Falls back to the glyph of codepoint -1 if there is none for this one.
+        const font_glyph* g = font_lookup_glyph(text->data->lookup, codepoint);
 
         if (g) {
             // Found the glyph. generate points.
-            f32 minx = x + g->x_offset;
-            f32 miny = y + g->y_offset;
-            f32 maxx = minx + g->width;
-            f32 maxy = miny + g->height;
+            codepoint = g->codepoint;
+            f32 minx = x + g->x_offset * scale;
+            f32 miny = y + g->y_offset * scale;
+            f32 maxx = minx + g->width * scale;
+            f32 maxy = miny + g->height * scale;
             f32 tminx = (f32)g->x / text->data->atlas_size_x;
             f32 tmaxx = (f32)(g->x + g->width) / text->data->atlas_size_x;
             f32 tminy = (f32)g->y / text->data->atlas_size_y;
@@ -253,10 +300,21 @@ void regenerate_geometry(ui_text* text) {
             vertex_2d p2 = (vertex_2d){vec2_create(maxx, maxy), vec2_create(tmaxx, tmaxy)};
             vertex_2d p3 = (vertex_2d){vec2_create(minx, maxy), vec2_create(tminx, tmaxy)};
 
-            vertex_buffer_data[(uc * 4) + 0] = p0;  // 0    3
-            vertex_buffer_data[(uc * 4) + 1] = p2;  //
-            vertex_buffer_data[(uc * 4) + 2] = p3;  //
-            vertex_buffer_data[(uc * 4) + 3] = p1;  // 2    1
+            vertex_2d quad_vertices[4] = {
+                p0,   // 0    3
+                p2,   //
+                p3,   //
+                p1};  // 2    1
+
+            // Index data 210301
+            u32 quad_indices[6] = {
+                (uc * 4) + 2,
+                (uc * 4) + 1,
+                (uc * 4) + 0,
+                (uc * 4) + 3,
+                (uc * 4) + 0,
+                (uc * 4) + 1};
+            quad_write(text, uc, quad_vertices, quad_indices, vertex_span, index_span);
 
             // Try to find kerning
             i32 kerning = 0;
@@ -273,50 +331,101 @@ void regenerate_geometry(ui_text* text) {
                     KWARN("Invalid UTF-8 found in string, using unknown codepoint of -1");
                     codepoint = -1;
                 } else {
-                    for (u32 i = 0; i < text->data->kerning_count; ++i) {
-                        font_kerning* k = &text->data->kernings[i];
-                        if (k->codepoint_0 == codepoint && k->codepoint_1 == next_codepoint) {
-                            kerning = k->amount;
-                        }
-                    }
+                    kerning = font_lookup_kerning(text->data->lookup, codepoint, next_codepoint);
                 }
             }
-            x += g->x_advance + kerning;
+            x += (g->x_advance + kerning) * scale;
 
         } else {
             KERROR("Unable to find unknown codepoint. Skipping.");
+            quad_write(text, uc, 0, 0, vertex_span, index_span);
             // Increment utf-8 character count.
             uc++;
             continue;
         }
 
-        // Index data 210301
-        index_buffer_data[(uc * 6) + 0] = (uc * 4) + 2;
-        index_buffer_data[(uc * 6) + 1] = (uc * 4) + 1;
-        index_buffer_data[(uc * 6) + 2] = (uc * 4) + 0;
-        index_buffer_data[(uc * 6) + 3] = (uc * 4) + 3;
-        index_buffer_data[(uc * 6) + 4] = (uc * 4) + 0;
-        index_buffer_data[(uc * 6) + 5] = (uc * 4) + 1;
-
         // Now advance c
         c += advance - 1;  // Subtracting 1 because the loop always increments once for single-byte anyway.
         // Increment utf-8 character count.
         uc++;
     }
+}
+
+void regenerate_geometry(ui_text* text) {
+    text->revision++;
+
+    // Get the UTF-8 string length
+    u32 text_length_utf8 = string_utf8_length(text->text);
+
+    // Calculate buffer sizes.
+    static const u64 verts_per_quad = 4;
+    static const u8 indices_per_quad = 6;
+    u64 vertex_buffer_size = sizeof(vertex_2d) * verts_per_quad * text_length_utf8;
+    u64 index_buffer_size = sizeof(u32) * indices_per_quad * text_length_utf8;
+
+    // Resize the vertex buffer, but only if larger. Resizing keeps what was loaded.
+    if (vertex_buffer_size > text->vertex_buffer.total_size) {
+        if (!renderer_renderbuffer_resize(&text->vertex_buffer, vertex_buffer_size)) {
+            KERROR("regenerate_geometry for ui text failed to resize vertex renderbuffer.");
+            return;
+        }
+    }
 
-    // Load up the data.
-    b8 vertex_load_result = renderer_renderbuffer_load_range(&text->vertex_buffer, 0, vertex_buffer_size, vertex_buffer_data);
-    b8 index_load_result = renderer_renderbuffer_load_range(&text->index_buffer, 0, index_buffer_size, index_buffer_data);
+    // Resize the index buffer, but only if larger.
+    if (index_buffer_size > text->index_buffer.total_size) {
+        if (!renderer_renderbuffer_resize(&text->index_buffer, index_buffer_size)) {
+            KERROR("regenerate_geometry for ui text failed to resize index renderbuffer.");
+            return;
+        }
+    }
+
+    // The geometry is kept, both for UI batching and to find what changed since it was last
+    // loaded, so the arrays holding it only grow and keep their contents when they do.
+    if (text_length_utf8 > text->quad_capacity) {
+        vertex_2d* vertices = kallocate(vertex_buffer_size, MEMORY_TAG_ARRAY);
+        u32* indices = kallocate(index_buffer_size, MEMORY_TAG_ARRAY);
+        if (text->vertices) {
+            kcopy_memory(vertices, text->vertices, sizeof(vertex_2d) * verts_per_quad * text->quad_count);
+            kcopy_memory(indices, text->indices, sizeof(u32) * indices_per_quad * text->quad_count);
+            kfree(text->vertices, sizeof(vertex_2d) * verts_per_quad * text->quad_capacity, MEMORY_TAG_ARRAY);
+            kfree(text->indices, sizeof(u32) * indices_per_quad * text->quad_capacity, MEMORY_TAG_ARRAY);
+        }
+        text->quad_capacity = text_length_utf8;
+        text->vertices = vertices;
+        text->indices = indices;
+    }
 
-    // Clean up.
-    kfree(vertex_buffer_data, vertex_buffer_size, MEMORY_TAG_ARRAY);
-    kfree(index_buffer_data, index_buffer_size, MEMORY_TAG_ARRAY);
+    // Quads past those last loaded hold nothing of use, so are always loaded.
+    u32 previous_quad_count = text->quad_count;
+    text->quad_count = text_length_utf8;
+    ui_text_dirty_span vertex_span = {INVALID_ID, INVALID_ID};
+    ui_text_dirty_span index_span = {INVALID_ID, INVALID_ID};
+    if (text_length_utf8 > previous_quad_count) {
+        vertex_span = (ui_text_dirty_span){previous_quad_count, text_length_utf8 - 1};
+        index_span = vertex_span;
+    }
+
+    // Strings laid out before with the same glyphs, such as those a label flips between, are copied
+    // rather than laid out again.
+    text_layout_cache* cache = font_system_layout_cache();
+    const text_layout_run* run = cache ? text_layout_cache_get(cache, text->data, text->scale, text->text) : 0;
+    if (run && run->quad_count == text_length_utf8) {
+        for (u32 q = 0; q < run->quad_count; ++q) {
+            quad_write(text, q, run->vertices + q * 4, run->indices + q * 6, &vertex_span, &index_span);
+        }
+    } else {
+        layout_glyphs(text, &vertex_span, &index_span);
+        if (cache) {
+            text_layout_cache_put(cache, text->data, text->scale, text->text, text_length_utf8, text->vertices, text->indices);
+        }
+    }
 
-    // Verify results.
-    if (!vertex_load_result) {
+    // Load up only the quads that changed, so text changing by a character or two, such as a
+    // counter, loads only those. Its own buffers are still used to draw it by itself, such as for picking.
+    if (!dirty_span_load(&text->vertex_buffer, &vertex_span, sizeof(vertex_2d) * verts_per_quad, text->vertices)) {
         KERROR("regenerate_geometry failed to load data into vertex buffer range.");
     }
-    if (!index_load_result) {
+    if (!dirty_span_load(&text->index_buffer, &index_span, sizeof(u32) * indices_per_quad, text->indices)) {
         KERROR("regenerate_geometry failed to load data into index buffer range.");
     }
 }
@@ -15,8 +15,19 @@ typedef struct ui_text {
     u32 unique_id;
     ui_text_type type;
     struct font_data* data;
+    // The size of the text relative to that of the font's glyphs. Only not 1 for distance field fonts.
+    f32 scale;
     renderbuffer vertex_buffer;
     renderbuffer index_buffer;
+    // A copy of the geometry as last loaded, for batching with other UI and to load only what changes. One quad per UTF-8 character.
+    u32 quad_count;
+    u32 quad_capacity;
+    vertex_2d* vertices;
+    u32* indices;
+    // Changes whenever the geometry is regenerated, so that UI drawn with it knows to be batched again.
+    u32 revision;
+    // The rectangle in screen space the text is clipped to: its position in xy and its size in zw. Unclipped if of no size.
+    vec4 clip_rect;
     char* text;
     transform transform;
     u32 instance_id;
@@ -28,5 +39,7 @@ KAPI void ui_text_destroy(ui_text* text);
 
 KAPI void ui_text_set_position(ui_text* u_text, vec3 position);
 KAPI void ui_text_set_text(ui_text* u_text, const char* text);
+// Lays the text out again, such as once glyphs it was drawn without have been drawn into its font's atlas.
+KAPI void ui_text_refresh(ui_text* u_text);
 
 KAPI void ui_text_draw(ui_text* u_text);
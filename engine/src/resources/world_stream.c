@@ -0,0 +1,179 @@
+#include "world_stream.h"
+
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+#include "math/kmath.h"
+#include "math/transform.h"
+#include "resources/mesh.h"
+
+// The distance from point to the box, 0 if inside it.
+static f32 cell_distance(const world_cell* cell, vec3 point) {
+    vec3 nearest = {
+        KCLAMP(point.x, cell->min.x, cell->max.x),
+        KCLAMP(point.y, cell->min.y, cell->max.y),
+        KCLAMP(point.z, cell->min.z, cell->max.z)};
+    return vec3_distance(point, nearest);
+}
+
+static void cell_unload(world_stream* stream, world_cell* cell) {
+    mesh_unload(&cell->cell_mesh);
+    cell->state = WORLD_CELL_STATE_UNLOADED;
+    stream->resident_size -= cell->size;
+}
+
+// Finds the loaded cell furthest from the camera, if it is further than distance.
+static u32 furthest_loaded_cell(const world_stream* stream, f32 distance) {
+    u32 furthest = INVALID_ID;
+    for (u32 i = 0; i < stream->cell_count; ++i) {
+        const world_cell* cell = &stream->cells[i];
+        if (cell->state == WORLD_CELL_STATE_LOADED && cell->distance > distance) {
+            distance = cell->distance;
+            furthest = i;
+        }
+    }
+    return furthest;
+}
+
+b8 world_stream_create(world_stream_config config, u32 capacity, u64* memory_requirement, void* memory, world_stream* out_stream) {
+    if (capacity == 0) {
+        KERROR("world_stream_create requires a non-zero capacity. Create failed.");
+        return false;
+    }
+    if (!memory_requirement) {
+        KERROR("world_stream_create requires memory_requirement to exist. Create failed.");
+        return false;
+    }
+
+    *memory_requirement = (sizeof(world_cell) + sizeof(u32)) * capacity;
+
+    // If only obtaining requirement, boot out.
+    if (!memory) {
+        return true;
+    }
+    if (!out_stream) {
+        KERROR("world_stream_create requires a pointer to hold the stream. Create failed.");
+        return false;
+    }
+
+    kzero_memory(out_stream, sizeof(world_stream));
+    kzero_memory(memory, *memory_requirement);
+    out_stream->config = config;
+    out_stream->config.unload_distance = KMAX(config.unload_distance, config.load_distance);
+    out_stream->config.max_loads_in_flight = KMAX(config.max_loads_in_flight, 1);
+    out_stream->capacity = capacity;
+    out_stream->cells = memory;
+    out_stream->candidates = (u32*)(out_stream->cells + capacity);
+    return true;
+}
+
+void world_stream_destroy(world_stream* stream) {
+    if (!stream) {
+        return;
+    }
+    for (u32 i = 0; i < stream->cell_count; ++i) {
+        world_cell* cell = &stream->cells[i];
+        if (cell->state == WORLD_CELL_STATE_LOADED) {
+            cell_unload(stream, cell);
+        } else if (cell->state == WORLD_CELL_STATE_LOADING) {
+            KWARN("world_stream_destroy - cell '%s' is still loading, and will not be unloaded.", cell->name);
+        }
+    }
+    kzero_memory(stream, sizeof(world_stream));
+}
+
+u32 world_stream_cell_add(world_stream* stream, const char* name, vec3 min, vec3 max, u64 size) {
+    if (!stream || !name || stream->cell_count == stream->capacity) {
+        KERROR("world_stream_cell_add - the stream is full or no name was given.");
+        return INVALID_ID;
+    }
+    u32 index = stream->cell_count++;
+    world_cell* cell = &stream->cells[index];
+    kzero_memory(cell, sizeof(world_cell));
+    string_ncopy(cell->name, name, WORLD_CELL_NAME_MAX_LENGTH - 1);
+    cell->min = min;
+    cell->max = max;
+    cell->size = size;
+    cell->state = WORLD_CELL_STATE_UNLOADED;
+    cell->cell_mesh.generation = INVALID_ID_U8;
+    return index;
+}
+
+b8 world_stream_grid_add(world_stream* stream, const char* prefix, vec3 origin, f32 cell_size, f32 height, u32 count_x, u32 count_z, u64 size) {
+    for (u32 z = 0; z < count_z; ++z) {
+        for (u32 x = 0; x < count_x; ++x) {
+            char name[WORLD_CELL_NAME_MAX_LENGTH];
+            string_format(name, "%s_%u_%u", prefix, x, z);
+            vec3 min = {origin.x + x * cell_size, origin.y, origin.z + z * cell_size};
+            vec3 max = {min.x + cell_size, origin.y + height, min.z + cell_size};
+            if (world_stream_cell_add(stream, name, min, max, size) == INVALID_ID) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void world_stream_update(world_stream* stream, vec3 camera_position) {
+    if (!stream || !stream->cells) {
+        return;
+    }
+
+    // Find the loads which finished, and unload the cells now too far away.
+    u32 candidate_count = 0;
+    for (u32 i = 0; i < stream->cell_count; ++i) {
+        world_cell* cell = &stream->cells[i];
+        cell->distance = cell_distance(cell, camera_position);
+        if (cell->state == WORLD_CELL_STATE_LOADING && cell->cell_mesh.generation != INVALID_ID_U8) {
+            cell->state = WORLD_CELL_STATE_LOADED;
+            stream->loads_in_flight--;
+        }
+        if (cell->state == WORLD_CELL_STATE_LOADING) {
+            if (cell->distance > stream->config.unload_distance) {
+                // No longer wanted, so what is left of it need not be read or uploaded.
+                mesh_load_cancel(&cell->cell_mesh);
+            } else if (cell->distance == 0.0f) {
+                mesh_load_priority_set(&cell->cell_mesh, JOB_PRIORITY_HIGH);
+            }
+        }
+        if (cell->state == WORLD_CELL_STATE_LOADED && cell->distance > stream->config.unload_distance) {
+            cell_unload(stream, cell);
+        }
+        if (cell->state != WORLD_CELL_STATE_UNLOADED || cell->distance > stream->config.load_distance) {
+            continue;
+        }
+
+        // Kept nearest first. Only the cells near the camera are wanted, so there are few of them.
+        u32 c = candidate_count++;
+        while (c > 0 && stream->cells[stream->candidates[c - 1]].distance > cell->distance) {
+            stream->candidates[c] = stream->candidates[c - 1];
+            c--;
+        }
+        stream->candidates[c] = i;
+    }
+
+    // Start loading the nearest, making room for them within the budget from those furthest away.
+    for (u32 c = 0; c < candidate_count && stream->loads_in_flight < stream->config.max_loads_in_flight; ++c) {
+        world_cell* cell = &stream->cells[stream->candidates[c]];
+        while (stream->resident_size + cell->size > stream->config.budget) {
+            u32 furthest = furthest_loaded_cell(stream, cell->distance);
+            if (furthest == INVALID_ID) {
+                break;
+            }
+            cell_unload(stream, &stream->cells[furthest]);
+        }
+        if (stream->resident_size + cell->size > stream->config.budget) {
+            // Cells further away wait, rather than take the room this one needs.
+            break;
+        }
+
+        cell->cell_mesh.transform = transform_create();
+        if (!mesh_load_from_resource(cell->name, &cell->cell_mesh)) {
+            KERROR("world_stream_update - failed to start loading cell '%s'.", cell->name);
+            continue;
+        }
+        cell->state = WORLD_CELL_STATE_LOADING;
+        stream->resident_size += cell->size;
+        stream->loads_in_flight++;
+    }
+}
@@ -0,0 +1,145 @@
+/**
+ * @file world_stream.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief Streams a world divided into spatial cells in and out around the camera, so that worlds far
+ * larger than memory can be drawn, with only the cells near the camera loaded.
+ * @details Each cell is a mesh, loaded by name with mesh_load_from_resource, so through the job
+ * system and the renderer's asynchronous uploads, and covers a box of the world. Cells are loaded
+ * once the camera comes within the load distance of their box, nearest first, and unloaded once it
+ * is further than the unload distance, which is kept further so that a camera moving along a cell
+ * border does not load and unload it over and over. The cells loaded or loading may hold no more
+ * than the budget between them; a nearer cell which does not fit takes the place of the furthest
+ * loaded one further from the camera than it. Loads of cells the camera moves beyond the unload distance
+ * of are cancelled, and those of cells the camera moves into are moved ahead of the rest. A cancelled
+ * load still finishes, with nothing to draw, before its cell is unloaded. Sizes are as given for each
+ * cell, usually by the cook step.
+ * Not thread-safe; updated on the main thread.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "resource_types.h"
+
+/** @brief The max length of the name of a cell's mesh. */
+#define WORLD_CELL_NAME_MAX_LENGTH 128
+
+/** @brief The states of a cell. */
+typedef enum world_cell_state {
+    /** @brief Not loaded, and holding nothing. */
+    WORLD_CELL_STATE_UNLOADED,
+    /** @brief Its mesh is being loaded. */
+    WORLD_CELL_STATE_LOADING,
+    /** @brief Its mesh has loaded, or failed to, and may be drawn. */
+    WORLD_CELL_STATE_LOADED
+} world_cell_state;
+
+/** @brief A cell of the world. */
+typedef struct world_cell {
+    /** @brief The name of the cell's mesh resource. */
+    char name[WORLD_CELL_NAME_MAX_LENGTH];
+    /** @brief The corner of the cell's box with the smallest coordinates. */
+    vec3 min;
+    /** @brief The corner of the cell's box with the largest coordinates. */
+    vec3 max;
+    /** @brief The bytes the cell holds once loaded, counted against the budget. */
+    u64 size;
+    /** @brief The state of the cell. */
+    world_cell_state state;
+    /** @brief The distance from the camera to the cell's box as of the last update, 0 if inside it. */
+    f32 distance;
+    /** @brief The cell's mesh, valid to draw while its generation is not INVALID_ID_U8. */
+    mesh cell_mesh;
+} world_cell;
+
+/** @brief The configuration of a world stream. */
+typedef struct world_stream_config {
+    /** @brief The distance from the camera within which cells are loaded. */
+    f32 load_distance;
+    /** @brief The distance from the camera beyond which cells are unloaded. Raised to the load distance if less. */
+    f32 unload_distance;
+    /** @brief The most bytes the cells loaded or loading may hold between them. */
+    u64 budget;
+    /** @brief The most cells loading at once. 0 is taken as 1. */
+    u32 max_loads_in_flight;
+} world_stream_config;
+
+/** @brief A world stream. */
+typedef struct world_stream {
+    /** @brief The configuration, with defaults filled in. */
+    world_stream_config config;
+    /** @brief The most cells the stream can hold. */
+    u32 capacity;
+    /** @brief The number of cells. */
+    u32 cell_count;
+    /** @brief The cells. */
+    world_cell* cells;
+    /** @brief The cells to be loaded in the current update, nearest first. Scratch for world_stream_update. */
+    u32* candidates;
+    /** @brief The bytes held by the cells loaded or loading. */
+    u64 resident_size;
+    /** @brief The number of cells loading. */
+    u32 loads_in_flight;
+} world_stream;
+
+/**
+ * @brief Creates a new world stream with no cells. Should be called twice; once to obtain the memory
+ * amount required (passing memory=0), and a second time with memory being set to an allocated block.
+ *
+ * @param config The configuration.
+ * @param capacity The most cells the stream can hold.
+ * @param memory_requirement A pointer to hold the required memory for the stream.
+ * @param memory An allocated block of memory, or 0 if just obtaining the requirement.
+ * @param out_stream A pointer to hold the stream.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 world_stream_create(world_stream_config config, u32 capacity, u64* memory_requirement, void* memory, world_stream* out_stream);
+
+/**
+ * @brief Destroys the given stream, unloading every cell loaded. Cells still loading leave their
+ * loads running, so should be waited for first. The memory passed at creation is not freed.
+ *
+ * @param stream A pointer to the stream.
+ */
+KAPI void world_stream_destroy(world_stream* stream);
+
+/**
+ * @brief Adds a cell to the stream, unloaded.
+ *
+ * @param stream A pointer to the stream.
+ * @param name The name of the cell's mesh resource.
+ * @param min The corner of the cell's box with the smallest coordinates.
+ * @param max The corner of the cell's box with the largest coordinates.
+ * @param size The bytes the cell holds once loaded.
+ * @return The index of the cell, or INVALID_ID if the stream is full.
+ */
+KAPI u32 world_stream_cell_add(world_stream* stream, const char* name, vec3 min, vec3 max, u64 size);
+
+/**
+ * @brief Adds a grid of cells along x and z, reaching from min_y to max_y. The mesh of each is named
+ * "<prefix>_<x>_<z>", from the cell's column and row of the grid.
+ *
+ * @param stream A pointer to the stream.
+ * @param prefix The start of the name of each cell's mesh.
+ * @param origin The corner of the grid with the smallest coordinates. Its y is the bottom of the cells.
+ * @param cell_size The size of each cell along x and z.
+ * @param height The height of each cell.
+ * @param count_x The number of cells along x.
+ * @param count_z The number of cells along z.
+ * @param size The bytes each cell holds once loaded.
+ * @return True if every cell was added; otherwise false.
+ */
+KAPI b8 world_stream_grid_add(world_stream* stream, const char* prefix, vec3 origin, f32 cell_size, f32 height, u32 count_x, u32 count_z, u64 size);
+
+/**
+ * @brief Finds the loads which finished, unloads the cells too far from the camera, and starts
+ * loading the nearest wanted ones. Called once a frame.
+ *
+ * @param stream A pointer to the stream.
+ * @param camera_position The position of the camera.
+ */
+KAPI void world_stream_update(world_stream* stream, vec3 camera_position);
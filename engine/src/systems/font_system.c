@@ -6,8 +6,12 @@
 #include "containers/darray.h"
 #include "containers/hashtable.h"
 #include "resources/resource_types.h"
+#include "resources/font_lookup.h"
+#include "resources/text_layout_cache.h"
+#include "resources/texture_atlas.h"
 #include "resources/ui_text.h"
 #include "renderer/renderer_frontend.h"
+#include "systems/job_system.h"
 #include "systems/texture_system.h"
 #include "systems/resource_system.h"
 
@@ -21,12 +25,59 @@ typedef struct bitmap_font_internal_data {
     bitmap_font_resource_data* resource_data;
 } bitmap_font_internal_data;
 
+// The number of laid out strings kept for reuse.
+#define FONT_SYSTEM_LAYOUT_CACHE_SIZE 128
+
+// The size glyph atlases of system fonts start at, and the most they may grow to.
+#define SYSTEM_FONT_ATLAS_INITIAL_SIZE 1024
+#define SYSTEM_FONT_ATLAS_MAX_SIZE 4096
+// The pixels of border around each glyph in the atlas.
+#define SYSTEM_FONT_ATLAS_PADDING 1
+// The distance in pixels outside a glyph's edge its distance field reaches, and the value of the edge.
+#define SYSTEM_FONT_SDF_SPREAD 4
+#define SYSTEM_FONT_SDF_ON_EDGE 128
+
 typedef struct system_font_variant_data {
     // darray
     i32* codepoints;
     f32 scale;
+    // Where glyphs are placed, holding a copy of the pixels of the atlas texture.
+    texture_atlas packer;
+    u64 packer_memory_size;
+    void* packer_memory;
+    // Glyphs from this one on have their metrics, but are yet to be given to a job to draw into the atlas.
+    u32 rasterized_count;
+    // Indicates if a job is drawing glyphs of the variant, and its handle.
+    b8 rasterizing;
+    job_handle raster_job;
+    // darray of the texts drawn with the variant, refreshed as the glyphs they wait on arrive.
+    ui_text** texts;
 } system_font_variant_data;
 
+// A glyph drawn by a raster job.
+typedef struct system_font_glyph_raster {
+    i32 glyph_index;
+    u32 width;
+    u32 height;
+    // Where the glyph's pixels start in those of the job.
+    u64 pixel_offset;
+} system_font_glyph_raster;
+
+// Also used as result_data from job. Everything the job reads is copied or never changes while it runs.
+typedef struct system_font_raster_params {
+    u16 font_id;
+    u16 size;
+    // The first glyph of the variant drawn, and how many are.
+    u32 first_glyph;
+    u32 glyph_count;
+    f32 scale;
+    b8 sdf;
+    const stbtt_fontinfo* info;
+    system_font_glyph_raster* glyphs;
+    u64 pixels_size;
+    u8* pixels;
+} system_font_raster_params;
+
 typedef struct bitmap_font_lookup {
     u16 id;
     u16 reference_count;
@@ -45,6 +96,8 @@ typedef struct system_font_lookup {
     i32 offset;
     i32 index;
     stbtt_fontinfo info;
+    // Glyphs are distance fields, so the one and only size variant serves every size.
+    b8 sdf;
 } system_font_lookup;
 
 typedef struct font_system_state {
@@ -53,31 +106,43 @@ typedef struct font_system_state {
     hashtable system_font_lookup;
     bitmap_font_lookup* bitmap_fonts;
     system_font_lookup* system_fonts;
-    void* bitmap_hashtable_block;
-    void* system_hashtable_block;
+    // Set while shutting down, so that no more glyphs are given to jobs to draw.
+    b8 shutting_down;
+    // Laid out strings of every font, for texts changing back to strings they held before.
+    text_layout_cache layout_cache;
 } font_system_state;
 
 b8 setup_font_data(font_data* font);
 void cleanup_font_data(font_data* font);
+b8 rebuild_font_lookup(font_data* font);
+void release_font_lookup(font_data* font);
 b8 create_system_font_variant(system_font_lookup* lookup, u16 size, const char* font_name, font_data* out_variant);
-b8 rebuild_system_font_variant_atlas(system_font_lookup* lookup, font_data* variant);
+b8 grow_system_font_variant_atlas(font_data* variant);
+b8 add_system_font_variant_glyphs(system_font_lookup* lookup, font_data* variant);
+void rasterize_system_font_variant_glyphs(system_font_lookup* lookup, font_data* variant);
 b8 verify_system_font_size_variant(system_font_lookup* lookup, font_data* variant, const char* text);
 
 static font_system_state* state_ptr;
 
+// Tracks the given text as drawn with its system font variant, to refresh it as glyphs arrive.
+static void system_font_text_add(ui_text* text) {
+    system_font_variant_data* internal_data = (system_font_variant_data*)text->data->internal_data;
+    darray_push(internal_data->texts, text);
+}
+
 b8 font_system_initialize(u64* memory_requirement, void* memory, font_system_config* config) {
     if (config->max_bitmap_font_count == 0 || config->max_system_font_count == 0) {
         KFATAL("font_system_initialize - config.max_bitmap_font_count and config.max_system_font_count must be > 0.");
         return false;
     }
 
-    // Block of memory will contain state structure, then blocks for arrays, then blocks for hashtables.
+    // Block of memory will contain state structure, then blocks for arrays. The hashtables own their memory.
     u64 struct_requirement = sizeof(font_system_state);
     u64 bmp_array_requirement = sizeof(bitmap_font_lookup) * config->max_bitmap_font_count;
     u64 sys_array_requirement = sizeof(system_font_lookup) * config->max_system_font_count;
-    u64 bmp_hashtable_requirement = sizeof(u16) * config->max_bitmap_font_count;
-    u64 sys_hashtable_requirement = sizeof(u16) * config->max_system_font_count;
-    *memory_requirement = struct_requirement + bmp_array_requirement + sys_array_requirement + bmp_hashtable_requirement + sys_hashtable_requirement;
+    u64 layout_cache_requirement = 0;
+    text_layout_cache_create(FONT_SYSTEM_LAYOUT_CACHE_SIZE, &layout_cache_requirement, 0, 0);
+    *memory_requirement = struct_requirement + bmp_array_requirement + sys_array_requirement + layout_cache_requirement;
 
     if (!memory) {
         return true;
@@ -92,14 +157,12 @@ b8 font_system_initialize(u64* memory_requirement, void* memory, font_system_con
 
     state_ptr->bitmap_fonts = bmp_array_block;
     state_ptr->system_fonts = sys_array_block;
-
-    // Hashtable blocks are after arrays.
-    void* bmp_hashtable_block = (void*)(((u8*)sys_array_block) + sys_array_requirement);
-    void* sys_hashtable_block = (void*)(((u8*)bmp_hashtable_block) + bmp_hashtable_requirement);
+    void* layout_cache_block = (void*)(((u8*)sys_array_block) + sys_array_requirement);
+    text_layout_cache_create(FONT_SYSTEM_LAYOUT_CACHE_SIZE, &layout_cache_requirement, layout_cache_block, &state_ptr->layout_cache);
 
     // Create hashtables for font lookups.
-    hashtable_create(sizeof(u16), state_ptr->config.max_bitmap_font_count, bmp_hashtable_block, false, &state_ptr->bitmap_font_lookup);
-    hashtable_create(sizeof(u16), state_ptr->config.max_system_font_count, sys_hashtable_block, false, &state_ptr->system_font_lookup);
+    hashtable_create_with_mode(sizeof(u16), state_ptr->config.max_bitmap_font_count, HASHTABLE_MODE_OPEN_ADDRESSING, 0, false, &state_ptr->bitmap_font_lookup);
+    hashtable_create_with_mode(sizeof(u16), state_ptr->config.max_system_font_count, HASHTABLE_MODE_OPEN_ADDRESSING, 0, false, &state_ptr->system_font_lookup);
 
     // Fill both hashtables with invalid references to use as a default.
     u16 invalid_id = INVALID_ID_U16;
@@ -146,6 +209,20 @@ void font_system_shutdown(void* memory) {
             }
         }
 
+        // Let any glyphs still being drawn finish first, since their jobs read the fonts.
+        state_ptr->shutting_down = true;
+        for (u16 i = 0; i < state_ptr->config.max_system_font_count; ++i) {
+            if (state_ptr->system_fonts[i].id != INVALID_ID_U16) {
+                u32 variant_count = darray_length(state_ptr->system_fonts[i].size_variants);
+                for (u32 j = 0; j < variant_count; ++j) {
+                    system_font_variant_data* internal_data = (system_font_variant_data*)state_ptr->system_fonts[i].size_variants[j].internal_data;
+                    if (internal_data->rasterizing) {
+                        job_system_wait(internal_data->raster_job);
+                    }
+                }
+            }
+        }
+
         // Cleanup system fonts.
         for (u16 i = 0; i < state_ptr->config.max_system_font_count; ++i) {
             if (state_ptr->system_fonts[i].id != INVALID_ID_U16) {
@@ -161,6 +238,12 @@ void font_system_shutdown(void* memory) {
                 state_ptr->system_fonts[i].size_variants = 0;
             }
         }
+
+        hashtable_destroy(&state_ptr->bitmap_font_lookup);
+        hashtable_destroy(&state_ptr->system_font_lookup);
+        text_layout_cache_destroy(&state_ptr->layout_cache);
+        // Jobs completing after this find no font to place their glyphs in.
+        state_ptr = 0;
     }
 }
 
@@ -213,6 +296,7 @@ b8 font_system_load_system_font(system_font_config* config) {
         lookup->font_binary = resource_data->font_binary;
         lookup->face = string_duplicate(face->name);
         lookup->index = i;
+        lookup->sdf = config->sdf;
         // To hold the size variants.
         lookup->size_variants = darray_create(font_data);
 
@@ -341,12 +425,22 @@ b8 font_system_acquire(const char* font_name, u16 font_size, struct ui_text* tex
         // Get the lookup.
         system_font_lookup* lookup = &state_ptr->system_fonts[id];
 
+        // Distance field glyphs are scaled to the size of the text.
+        if (lookup->sdf && darray_length(lookup->size_variants)) {
+            text->data = &lookup->size_variants[0];
+            text->scale = (f32)font_size / text->data->size;
+            system_font_text_add(text);
+            lookup->reference_count++;
+            return true;
+        }
+
         // Search the size variants for the correct size.
         u32 count = darray_length(lookup->size_variants);
         for (u32 i = 0; i < count; ++i) {
             if (lookup->size_variants[i].size == font_size) {
                 // Assign the data, increment the reference.
                 text->data = &lookup->size_variants[i];
+                system_font_text_add(text);
                 lookup->reference_count++;
                 return true;
             }
@@ -369,6 +463,7 @@ b8 font_system_acquire(const char* font_name, u16 font_size, struct ui_text* tex
         u32 length = darray_length(lookup->size_variants);
         // Assign the data, increment the reference.
         text->data = &lookup->size_variants[length - 1];
+        system_font_text_add(text);
         lookup->reference_count++;
         return true;
     }
@@ -377,8 +472,23 @@ b8 font_system_acquire(const char* font_name, u16 font_size, struct ui_text* tex
     return false;
 }
 
+text_layout_cache* font_system_layout_cache(void) {
+    return state_ptr ? &state_ptr->layout_cache : 0;
+}
+
 b8 font_system_release(struct ui_text* text) {
     // TODO: Lookup font by name in appropriate hashtable.
+    // Texts of system fonts stop being refreshed as glyphs arrive.
+    if (state_ptr && text && text->data && text->data->type == FONT_TYPE_SYSTEM && text->data->internal_data) {
+        system_font_variant_data* internal_data = (system_font_variant_data*)text->data->internal_data;
+        u32 count = darray_length(internal_data->texts);
+        for (u32 i = 0; i < count; ++i) {
+            if (internal_data->texts[i] == text) {
+                darray_swap_remove(internal_data->texts, i, 0);
+                break;
+            }
+        }
+    }
     return true;
 }
 
@@ -418,23 +528,25 @@ b8 setup_font_data(font_data* font) {
         return false;
     }
 
+    // System font variants build their lookup along with their atlas.
+    if (!font->lookup && !rebuild_font_lookup(font)) {
+        return false;
+    }
+
     // Check for a tab glyph, as there may not always be one exported. If there is, store its
     // x_advance and just use that. If there is not, then create one based off spacex4
     if (!font->tab_x_advance) {
-        for (u32 i = 0; i < font->glyph_count; ++i) {
-            if (font->glyphs[i].codepoint == '\t') {
-                font->tab_x_advance = font->glyphs[i].x_advance;
-                break;
-            }
+        const font_lookup* lookup = font->lookup;
+        // Unknown codepoints find the glyph of -1, so only a glyph of its own counts.
+        const font_glyph* g = font_lookup_glyph(lookup, '\t');
+        if (g && g->codepoint == '\t') {
+            font->tab_x_advance = g->x_advance;
         }
         // If still not found, use space x 4.
         if (!font->tab_x_advance) {
-            for (u32 i = 0; i < font->glyph_count; ++i) {
-                // Search for space
-                if (font->glyphs[i].codepoint == ' ') {
-                    font->tab_x_advance = font->glyphs[i].x_advance * 4;
-                    break;
-                }
+            g = font_lookup_glyph(lookup, ' ');
+            if (g && g->codepoint == ' ') {
+                font->tab_x_advance = g->x_advance * 4;
             }
             if (!font->tab_x_advance) {
                 // If _still_ not there, then a space wasn't present either, so just
@@ -456,19 +568,67 @@ void cleanup_font_data(font_data* font) {
         texture_system_release(font->atlas.texture->name);
     }
     font->atlas.texture = 0;
+
+    // If a system font, release the copy of its atlas.
+    if (font->type == FONT_TYPE_SYSTEM && font->internal_data) {
+        system_font_variant_data* internal_data = (system_font_variant_data*)font->internal_data;
+        if (internal_data->packer_memory) {
+            texture_atlas_destroy(&internal_data->packer);
+            kfree(internal_data->packer_memory, internal_data->packer_memory_size, MEMORY_TAG_SYSTEM_FONT);
+            internal_data->packer_memory = 0;
+        }
+        if (internal_data->texts) {
+            darray_destroy(internal_data->texts);
+            internal_data->texts = 0;
+        }
+    }
+
+    release_font_lookup(font);
+}
+
+b8 rebuild_font_lookup(font_data* font) {
+    release_font_lookup(font);
+    font->generation++;
+
+    u64 requirement = 0;
+    if (!font_lookup_create(font->glyph_count, font->glyphs, font->kerning_count, font->kernings, &requirement, 0, 0)) {
+        KERROR("Unable to size the glyph lookup for font '%s'.", font->face);
+        return false;
+    }
+    // The lookup first, then its tables.
+    font->lookup_size = sizeof(font_lookup) + requirement;
+    font->lookup = kallocate(font->lookup_size, MEMORY_TAG_ARRAY);
+    if (!font_lookup_create(font->glyph_count, font->glyphs, font->kerning_count, font->kernings, &requirement, font->lookup + 1, font->lookup)) {
+        KERROR("Unable to create the glyph lookup for font '%s'.", font->face);
+        release_font_lookup(font);
+        return false;
+    }
+    return true;
+}
+
+void release_font_lookup(font_data* font) {
+    if (font->lookup) {
+        font_lookup_destroy(font->lookup);
+        kfree(font->lookup, font->lookup_size, MEMORY_TAG_ARRAY);
+        font->lookup = 0;
+        font->lookup_size = 0;
+    }
 }
 
 b8 create_system_font_variant(system_font_lookup* lookup, u16 size, const char* font_name, font_data* out_variant) {
     kzero_memory(out_variant, sizeof(font_data));
-    out_variant->atlas_size_x = 1024;  // TODO: configurable size
-    out_variant->atlas_size_y = 1024;
+    out_variant->atlas_size_x = SYSTEM_FONT_ATLAS_INITIAL_SIZE;
+    out_variant->atlas_size_y = SYSTEM_FONT_ATLAS_INITIAL_SIZE;
     out_variant->size = size;
     out_variant->type = FONT_TYPE_SYSTEM;
+    out_variant->sdf = lookup->sdf;
     string_ncopy(out_variant->face, font_name, 255);
     out_variant->internal_data_size = sizeof(system_font_variant_data);
     out_variant->internal_data = kallocate(out_variant->internal_data_size, MEMORY_TAG_SYSTEM_FONT);
 
     system_font_variant_data* internal_data = (system_font_variant_data*)out_variant->internal_data;
+    internal_data->raster_job = INVALID_ID;
+    internal_data->texts = darray_create(ui_text*);
 
     // Push default codepoints (ascii 32-127) always, plus a -1 for unknown.
     internal_data->codepoints = darray_reserve(i32, 96);
@@ -478,10 +638,20 @@ b8 create_system_font_variant(system_font_lookup* lookup, u16 size, const char*
     }
     darray_length_set(internal_data->codepoints, 96);
 
-    // Create texture.
+    // Glyphs are placed in a single-channel atlas as they are first needed.
+    texture_atlas_create(out_variant->atlas_size_x, out_variant->atlas_size_y, 1, SYSTEM_FONT_ATLAS_PADDING, &internal_data->packer_memory_size, 0, 0);
+    internal_data->packer_memory = kallocate(internal_data->packer_memory_size, MEMORY_TAG_SYSTEM_FONT);
+    if (!texture_atlas_create(out_variant->atlas_size_x, out_variant->atlas_size_y, 1, SYSTEM_FONT_ATLAS_PADDING, &internal_data->packer_memory_size, internal_data->packer_memory, &internal_data->packer)) {
+        KERROR("Failed to create the glyph atlas of system font variant '%s'.", font_name);
+        return false;
+    }
+
+    // Create texture, written whole once so that glyphs may be written to it one rectangle at a time.
     char font_tex_name[255];
     string_format(font_tex_name, "__system_text_atlas_%s_i%i_sz%i__", font_name, lookup->index, size);
-    out_variant->atlas.texture = texture_system_aquire_writeable(font_tex_name, out_variant->atlas_size_x, out_variant->atlas_size_y, 4, true);
+    out_variant->atlas.texture = texture_system_aquire_writeable(font_tex_name, out_variant->atlas_size_x, out_variant->atlas_size_y, 1, true);
+    texture_system_write_data(out_variant->atlas.texture, 0, out_variant->atlas_size_x * out_variant->atlas_size_y, internal_data->packer.pixels);
+    internal_data->packer.dirty = false;
 
     // Obtain some metrics
     internal_data->scale = stbtt_ScaleForPixelHeight(&lookup->info, (f32)size);
@@ -489,105 +659,310 @@ b8 create_system_font_variant(system_font_lookup* lookup, u16 size, const char*
     stbtt_GetFontVMetrics(&lookup->info, &ascent, &descent, &line_gap);
     out_variant->line_height = (ascent - descent + line_gap) * internal_data->scale;
 
-    return rebuild_system_font_variant_atlas(lookup, out_variant);
+    // Kernings do not depend on which glyphs are in the atlas, so are only obtained once.
+    out_variant->kerning_count = stbtt_GetKerningTableLength(&lookup->info);
+    if (out_variant->kerning_count) {
+        out_variant->kernings = kallocate(sizeof(font_kerning) * out_variant->kerning_count, MEMORY_TAG_ARRAY);
+        // Get the kerning table for the current font.
+        stbtt_kerningentry* kerning_table = kallocate(sizeof(stbtt_kerningentry) * out_variant->kerning_count, MEMORY_TAG_ARRAY);
+        i32 entry_count = stbtt_GetKerningTable(&lookup->info, kerning_table, out_variant->kerning_count);
+        if (entry_count != out_variant->kerning_count) {
+            KERROR("Kerning entry count mismatch: %i->%i", entry_count, out_variant->kerning_count);
+            return false;
+        }
+
+        for (u32 i = 0; i < out_variant->kerning_count; ++i) {
+            font_kerning* k = &out_variant->kernings[i];
+            k->codepoint_0 = kerning_table[i].glyph1;
+            k->codepoint_1 = kerning_table[i].glyph2;
+            k->amount = kerning_table[i].advance;
+        }
+        kfree(kerning_table, sizeof(stbtt_kerningentry) * out_variant->kerning_count, MEMORY_TAG_ARRAY);
+    }
+
+    return add_system_font_variant_glyphs(lookup, out_variant);
 }
 
-b8 rebuild_system_font_variant_atlas(system_font_lookup* lookup, font_data* variant) {
+b8 grow_system_font_variant_atlas(font_data* variant) {
     system_font_variant_data* internal_data = (system_font_variant_data*)variant->internal_data;
-
-    u32 pack_image_size = variant->atlas_size_x * variant->atlas_size_y * sizeof(u8);
-    u8* pixels = kallocate(pack_image_size, MEMORY_TAG_ARRAY);
-    u32 codepoint_count = darray_length(internal_data->codepoints);
-    stbtt_packedchar* packed_chars = kallocate(sizeof(stbtt_packedchar) * codepoint_count, MEMORY_TAG_ARRAY);
-
-    // Begin packing all known characters into the atlas. This
-    // creates a single-channel image with rendered glyphs at the
-    // given size.
-    stbtt_pack_context context;
-    if (!stbtt_PackBegin(&context, pixels, variant->atlas_size_x, variant->atlas_size_y, 0, 1, 0)) {
-        KERROR("stbtt_PackBegin failed");
+    u32 size = internal_data->packer.width * 2;
+    if (size > SYSTEM_FONT_ATLAS_MAX_SIZE) {
         return false;
     }
 
-    // Fit all codepoints into a single range for packing.
-    stbtt_pack_range range;
-    range.first_unicode_codepoint_in_range = 0;
-    range.font_size = variant->size;
-    range.num_chars = codepoint_count;
-    range.chardata_for_range = packed_chars;
-    range.array_of_unicode_codepoints = internal_data->codepoints;
-    if (!stbtt_PackFontRanges(&context, lookup->font_binary, lookup->index, &range, 1)) {
-        KERROR("stbtt_PackFontRanges failed");
+    // Glyphs keep their place in the larger atlas, the space gained being right of and below them.
+    u64 memory_size = 0;
+    texture_atlas_create(size, size, 1, SYSTEM_FONT_ATLAS_PADDING, &memory_size, 0, 0);
+    void* memory = kallocate(memory_size, MEMORY_TAG_SYSTEM_FONT);
+    texture_atlas packer;
+    if (!texture_atlas_create(size, size, 1, SYSTEM_FONT_ATLAS_PADDING, &memory_size, memory, &packer) || !texture_atlas_copy(&internal_data->packer, &packer)) {
+        kfree(memory, memory_size, MEMORY_TAG_SYSTEM_FONT);
         return false;
     }
-
-    stbtt_PackEnd(&context);
-    // Packing complete.
-
-    // Convert from single-channel to RGBA, or pack_image_size * 4.
-    u8* rgba_pixels = kallocate(pack_image_size * 4, MEMORY_TAG_ARRAY);
-    for (i32 j = 0; j < pack_image_size; ++j) {
-        rgba_pixels[(j * 4) + 0] = pixels[j];
-        rgba_pixels[(j * 4) + 1] = pixels[j];
-        rgba_pixels[(j * 4) + 2] = pixels[j];
-        rgba_pixels[(j * 4) + 3] = pixels[j];
+    texture_atlas_destroy(&internal_data->packer);
+    kfree(internal_data->packer_memory, internal_data->packer_memory_size, MEMORY_TAG_SYSTEM_FONT);
+    internal_data->packer = packer;
+    internal_data->packer_memory = memory;
+    internal_data->packer_memory_size = memory_size;
+
+    // The contents of the texture are lost, so it is written whole once its glyphs are added.
+    if (!texture_system_resize(variant->atlas.texture, size, size, true)) {
+        KERROR("Failed to resize the atlas texture of system font variant '%s'.", variant->face);
+        return false;
     }
+    variant->atlas_size_x = size;
+    variant->atlas_size_y = size;
+    KINFO("Grew the glyph atlas of system font '%s' size %u to %ux%u.", variant->face, variant->size, size, size);
+    return true;
+}
 
-    // Write texture data to atlas.
-    texture_system_write_data(variant->atlas.texture, 0, pack_image_size * 4, rgba_pixels);
+// Obtains the box of the given glyph as stb_truetype draws it, for distance fields larger by
+// how far they reach. Returns false for glyphs with nothing to draw, such as spaces.
+static b8 system_font_glyph_box(const stbtt_fontinfo* info, i32 glyph_index, f32 scale, b8 sdf, i32* out_x0, i32* out_y0, u32* out_width, u32* out_height) {
+    i32 x0, y0, x1, y1;
+    stbtt_GetGlyphBitmapBox(info, glyph_index, scale, scale, &x0, &y0, &x1, &y1);
+    if (x0 == x1 || y0 == y1) {
+        return false;
+    }
+    if (sdf) {
+        x0 -= SYSTEM_FONT_SDF_SPREAD;
+        y0 -= SYSTEM_FONT_SDF_SPREAD;
+        x1 += SYSTEM_FONT_SDF_SPREAD;
+        y1 += SYSTEM_FONT_SDF_SPREAD;
+    }
+    *out_x0 = x0;
+    *out_y0 = y0;
+    *out_width = x1 - x0;
+    *out_height = y1 - y0;
+    return true;
+}
 
-    // Free pixel/rgba_pixel data.
-    kfree(pixels, pack_image_size, MEMORY_TAG_ARRAY);
-    kfree(rgba_pixels, pack_image_size * 4, MEMORY_TAG_ARRAY);
+b8 add_system_font_variant_glyphs(system_font_lookup* lookup, font_data* variant) {
+    system_font_variant_data* internal_data = (system_font_variant_data*)variant->internal_data;
+    u32 first = variant->glyph_count;
+    u32 codepoint_count = darray_length(internal_data->codepoints);
+    if (first == codepoint_count) {
+        return true;
+    }
 
-    // Regenerate glyphs
-    if (variant->glyphs && variant->glyph_count) {
+    // Glyphs already placed keep their place, so only the new ones are added.
+    font_glyph* glyphs = kallocate(sizeof(font_glyph) * codepoint_count, MEMORY_TAG_ARRAY);
+    if (variant->glyphs) {
+        kcopy_memory(glyphs, variant->glyphs, sizeof(font_glyph) * first);
         kfree(variant->glyphs, sizeof(font_glyph) * variant->glyph_count, MEMORY_TAG_ARRAY);
     }
+    variant->glyphs = glyphs;
     variant->glyph_count = codepoint_count;
-    variant->glyphs = kallocate(sizeof(font_glyph) * codepoint_count, MEMORY_TAG_ARRAY);
-    for (u16 i = 0; i < variant->glyph_count; ++i) {
-        stbtt_packedchar* pc = &packed_chars[i];
-        font_glyph* g = &variant->glyphs[i];
+
+    // Metrics are cheap to obtain, so text is laid out with them right away. The glyphs are
+    // drawn into the atlas by a job, and have no size, so draw nothing, until then.
+    f32 scale = internal_data->scale;
+    for (u32 i = first; i < codepoint_count; ++i) {
+        font_glyph* g = &glyphs[i];
         g->codepoint = internal_data->codepoints[i];
         g->page_id = 0;
-        g->x_offset = pc->xoff;
-        g->y_offset = pc->yoff;
-        g->x = pc->x0;  // xmin;
-        g->y = pc->y0;
-        g->width = pc->x1 - pc->x0;
-        g->height = pc->y1 - pc->y0;
-        g->x_advance = pc->xadvance;
-    }
-
-    // Regenerate kernings
-    if (variant->kernings && variant->kerning_count) {
-        kfree(variant->kernings, sizeof(font_kerning) * variant->kerning_count, MEMORY_TAG_ARRAY);
-    }
-    variant->kerning_count = stbtt_GetKerningTableLength(&lookup->info);
-    if (variant->kerning_count) {
-        variant->kernings = kallocate(sizeof(font_kerning) * variant->kerning_count, MEMORY_TAG_ARRAY);
-        // Get the kerning table for the current font.
-        stbtt_kerningentry* kerning_table = kallocate(sizeof(stbtt_kerningentry) * variant->kerning_count, MEMORY_TAG_ARRAY);
-        i32 entry_count = stbtt_GetKerningTable(&lookup->info, kerning_table, variant->kerning_count);
-        if (entry_count != variant->kerning_count) {
-            KERROR("Kerning entry count mismatch: %i->%i", entry_count, variant->kerning_count);
-            return false;
+
+        i32 glyph_index = stbtt_FindGlyphIndex(&lookup->info, g->codepoint);
+        i32 advance, left_side_bearing;
+        stbtt_GetGlyphHMetrics(&lookup->info, glyph_index, &advance, &left_side_bearing);
+        g->x_advance = advance * scale;
+
+        i32 x0, y0;
+        u32 width, height;
+        if (system_font_glyph_box(&lookup->info, glyph_index, scale, variant->sdf, &x0, &y0, &width, &height)) {
+            g->x_offset = x0;
+            g->y_offset = y0;
         }
+    }
 
-        for (u32 i = 0; i < variant->kerning_count; ++i) {
-            font_kerning* k = &variant->kernings[i];
-            k->codepoint_0 = kerning_table[i].glyph1;
-            k->codepoint_1 = kerning_table[i].glyph2;
-            k->amount = kerning_table[i].advance;
+    if (!rebuild_font_lookup(variant)) {
+        return false;
+    }
+    rasterize_system_font_variant_glyphs(lookup, variant);
+    return true;
+}
+
+static void system_font_raster_params_free(system_font_raster_params* params) {
+    if (params->glyphs) {
+        kfree(params->glyphs, sizeof(system_font_glyph_raster) * params->glyph_count, MEMORY_TAG_ARRAY);
+        params->glyphs = 0;
+    }
+    if (params->pixels) {
+        kfree(params->pixels, params->pixels_size, MEMORY_TAG_ARRAY);
+        params->pixels = 0;
+    }
+}
+
+// Finds the variant a raster job drew glyphs for, if it still exists.
+static font_data* system_font_raster_variant(const system_font_raster_params* params) {
+    if (!state_ptr) {
+        return 0;
+    }
+    system_font_lookup* lookup = &state_ptr->system_fonts[params->font_id];
+    u32 count = lookup->size_variants ? darray_length(lookup->size_variants) : 0;
+    for (u32 i = 0; i < count; ++i) {
+        if (lookup->size_variants[i].size == params->size) {
+            return &lookup->size_variants[i];
+        }
+    }
+    return 0;
+}
+
+b8 system_font_raster_job_start(void* params, void* result_data) {
+    system_font_raster_params* raster_params = (system_font_raster_params*)params;
+
+    // Only reads the font, which is never changed once loaded, so any number may run at once.
+    for (u32 i = 0; i < raster_params->glyph_count; ++i) {
+        const system_font_glyph_raster* r = &raster_params->glyphs[i];
+        if (!r->width) {
+            continue;
+        }
+        u8* dest = raster_params->pixels + r->pixel_offset;
+        if (raster_params->sdf) {
+            i32 width, height, x0, y0;
+            u8* field = stbtt_GetGlyphSDF(raster_params->info, raster_params->scale, r->glyph_index, SYSTEM_FONT_SDF_SPREAD, SYSTEM_FONT_SDF_ON_EDGE,
+                                          (f32)SYSTEM_FONT_SDF_ON_EDGE / SYSTEM_FONT_SDF_SPREAD, &width, &height, &x0, &y0);
+            if (field) {
+                // The same box is obtained as when it was measured, but never write past it regardless.
+                u32 copy_width = KMIN(r->width, (u32)width);
+                u32 copy_height = KMIN(r->height, (u32)height);
+                for (u32 row = 0; row < copy_height; ++row) {
+                    kcopy_memory(dest + (u64)row * r->width, field + (u64)row * width, copy_width);
+                }
+                stbtt_FreeSDF(field, 0);
+            }
+        } else {
+            stbtt_MakeGlyphBitmap(raster_params->info, dest, r->width, r->height, r->width, raster_params->scale, raster_params->scale, r->glyph_index);
         }
-    } else {
-        variant->kernings = 0;
     }
 
+    // NOTE: The params are also used as the result data, the pixels now being drawn.
+    kcopy_memory(result_data, raster_params, sizeof(system_font_raster_params));
     return true;
 }
 
+void system_font_raster_job_success(void* params) {
+    system_font_raster_params* raster_params = (system_font_raster_params*)params;
+    font_data* variant = system_font_raster_variant(raster_params);
+    if (!variant) {
+        // The font was unloaded while its glyphs were drawn.
+        system_font_raster_params_free(raster_params);
+        return;
+    }
+    system_font_variant_data* internal_data = (system_font_variant_data*)variant->internal_data;
+    internal_data->rasterizing = false;
+    internal_data->raster_job = INVALID_ID;
+
+    // Place the glyphs, noting the rectangle of the atlas written, borders included, to upload.
+    u32 min_x = INVALID_ID, min_y = INVALID_ID, max_x = 0, max_y = 0;
+    b8 grown = false;
+    for (u32 i = 0; i < raster_params->glyph_count; ++i) {
+        const system_font_glyph_raster* r = &raster_params->glyphs[i];
+        if (!r->width) {
+            continue;
+        }
+        font_glyph* g = &variant->glyphs[raster_params->first_glyph + i];
+        const u8* pixels = raster_params->pixels + r->pixel_offset;
+
+        texture_atlas_region region;
+        b8 placed = texture_atlas_add(&internal_data->packer, r->width, r->height, pixels, &region);
+        while (!placed && grow_system_font_variant_atlas(variant)) {
+            grown = true;
+            placed = texture_atlas_add(&internal_data->packer, r->width, r->height, pixels, &region);
+        }
+        if (!placed) {
+            KWARN("The glyph atlas of system font '%s' size %u is full. Codepoint %i will not be drawn.", variant->face, variant->size, g->codepoint);
+            continue;
+        }
+        g->x = region.x;
+        g->y = region.y;
+        g->width = r->width;
+        g->height = r->height;
+
+        min_x = KMIN(min_x, region.x - SYSTEM_FONT_ATLAS_PADDING);
+        min_y = KMIN(min_y, region.y - SYSTEM_FONT_ATLAS_PADDING);
+        max_x = KMAX(max_x, region.x + r->width + SYSTEM_FONT_ATLAS_PADDING);
+        max_y = KMAX(max_y, region.y + r->height + SYSTEM_FONT_ATLAS_PADDING);
+    }
+    system_font_raster_params_free(raster_params);
+
+    // Upload only what was written, unless the texture was recreated larger.
+    texture_atlas* packer = &internal_data->packer;
+    if (grown) {
+        texture_system_write_data(variant->atlas.texture, 0, packer->width * packer->height, packer->pixels);
+    } else if (min_x < max_x) {
+        u32 width = max_x - min_x;
+        u32 height = max_y - min_y;
+        u8* region_pixels = kallocate((u64)width * height, MEMORY_TAG_ARRAY);
+        for (u32 row = 0; row < height; ++row) {
+            kcopy_memory(region_pixels + (u64)row * width, packer->pixels + (u64)(min_y + row) * packer->width + min_x, width);
+        }
+        texture_system_write_region(variant->atlas.texture, min_x, min_y, width, height, region_pixels);
+        kfree(region_pixels, (u64)width * height, MEMORY_TAG_ARRAY);
+    }
+    packer->dirty = false;
+    variant->generation++;
+
+    // Texts waiting on the glyphs are laid out again to draw them.
+    u32 text_count = darray_length(internal_data->texts);
+    // Their font is pointed at again, as the variant may have moved since they acquired it.
+    for (u32 i = 0; i < text_count; ++i) {
+        internal_data->texts[i]->data = variant;
+        ui_text_refresh(internal_data->texts[i]);
+    }
+
+    // Glyphs added while these were drawn are drawn next.
+    rasterize_system_font_variant_glyphs(&state_ptr->system_fonts[raster_params->font_id], variant);
+}
+
+void system_font_raster_job_fail(void* params) {
+    system_font_raster_params* raster_params = (system_font_raster_params*)params;
+    font_data* variant = system_font_raster_variant(raster_params);
+    if (variant) {
+        KERROR("Failed to draw the glyphs of system font '%s' size %u. They will not be drawn.", variant->face, variant->size);
+        system_font_variant_data* internal_data = (system_font_variant_data*)variant->internal_data;
+        internal_data->rasterizing = false;
+        internal_data->raster_job = INVALID_ID;
+    }
+    system_font_raster_params_free(raster_params);
+}
+
+void rasterize_system_font_variant_glyphs(system_font_lookup* lookup, font_data* variant) {
+    system_font_variant_data* internal_data = (system_font_variant_data*)variant->internal_data;
+    // One job at a time per variant, each placing its glyphs in the order they were added.
+    if (state_ptr->shutting_down || internal_data->rasterizing || internal_data->rasterized_count == variant->glyph_count) {
+        return;
+    }
+
+    system_font_raster_params params = {};
+    // The lookup may not have its id yet while its first variant is created.
+    params.font_id = (u16)(lookup - state_ptr->system_fonts);
+    params.size = variant->size;
+    params.first_glyph = internal_data->rasterized_count;
+    params.glyph_count = variant->glyph_count - params.first_glyph;
+    params.scale = internal_data->scale;
+    params.sdf = variant->sdf;
+    params.info = &lookup->info;
+    params.glyphs = kallocate(sizeof(system_font_glyph_raster) * params.glyph_count, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < params.glyph_count; ++i) {
+        system_font_glyph_raster* r = &params.glyphs[i];
+        r->glyph_index = stbtt_FindGlyphIndex(&lookup->info, variant->glyphs[params.first_glyph + i].codepoint);
+        i32 x0, y0;
+        if (system_font_glyph_box(&lookup->info, r->glyph_index, params.scale, params.sdf, &x0, &y0, &r->width, &r->height)) {
+            r->pixel_offset = params.pixels_size;
+            params.pixels_size += (u64)r->width * r->height;
+        }
+    }
+    if (params.pixels_size) {
+        params.pixels = kallocate(params.pixels_size, MEMORY_TAG_ARRAY);
+    }
+    internal_data->rasterized_count = variant->glyph_count;
+    internal_data->rasterizing = true;
+
+    job_info job = job_create(system_font_raster_job_start, system_font_raster_job_success, system_font_raster_job_fail, &params, sizeof(system_font_raster_params), sizeof(system_font_raster_params));
+    internal_data->raster_job = job_system_submit(job);
+}
+
 b8 verify_system_font_size_variant(system_font_lookup* lookup, font_data* variant, const char* text) {
     system_font_variant_data* internal_data = (system_font_variant_data*)variant->internal_data;
 
@@ -607,9 +982,15 @@ b8 verify_system_font_size_variant(system_font_lookup* lookup, font_data* varian
             if (codepoint < 128) {
                 continue;
             }
+            // Those with glyphs are found by the lookup, which finds the unknown glyph for the rest,
+            // so only codepoints added for this text need searching for.
+            const font_glyph* g = font_lookup_glyph(variant->lookup, codepoint);
+            if (g && g->codepoint == codepoint) {
+                continue;
+            }
             u32 codepoint_count = darray_length(internal_data->codepoints);
             b8 found = false;
-            for (u32 j = 95; j < codepoint_count; ++j) {
+            for (u32 j = variant->glyph_count; j < codepoint_count; ++j) {
                 if (internal_data->codepoints[j] == codepoint) {
                     found = true;
                     break;
@@ -622,9 +1003,9 @@ b8 verify_system_font_size_variant(system_font_lookup* lookup, font_data* varian
         }
     }
 
-    // If codepoints were added, rebuild the atlas.
+    // If codepoints were added, add their glyphs to the atlas.
     if (added_codepoint_count > 0) {
-        return rebuild_system_font_variant_atlas(lookup, variant);
+        return add_system_font_variant_glyphs(lookup, variant);
     }
 
     // Otherwise, proceed as normal.
@@ -7,6 +7,11 @@ typedef struct system_font_config {
     char* name;
     u16 default_size;
     char* resource_name;
+    /**
+     * @brief Renders glyphs as signed distance fields at default_size, from which text of every size
+     * is drawn, rather than a separate atlas for each size.
+     */
+    b8 sdf;
 } system_font_config;
 
 typedef struct bitmap_font_config {
@@ -26,6 +31,7 @@ typedef struct font_system_config {
 } font_system_config;
 
 struct ui_text;
+struct text_layout_cache;
 
 b8 font_system_initialize(u64* memory_requirement, void* memory, font_system_config* config);
 void font_system_shutdown(void* memory);
@@ -51,4 +57,20 @@ b8 font_system_acquire(const char* font_name, u16 font_size, struct ui_text* tex
  */
 b8 font_system_release(struct ui_text* text);
 
+/**
+ * @brief Obtains the cache of laid out strings shared by every text.
+ *
+ * @return A pointer to the cache, or 0 if the font system is not initialized.
+ */
+struct text_layout_cache* font_system_layout_cache(void);
+
+/**
+ * @brief Makes sure the font has glyphs for every codepoint of the given text. For system fonts, the
+ * metrics of new glyphs are obtained at once, while the glyphs themselves are drawn into the atlas by a
+ * job, after which the texts drawn with the font are refreshed.
+ *
+ * @param font A pointer to the font.
+ * @param text The text to verify the glyphs of.
+ * @return True on success; otherwise false.
+ */
 b8 font_system_verify_atlas(font_data* font, const char* text);
@@ -1,17 +1,24 @@
 #include "geometry_system.h"
 
+#include "containers/slot_map.h"
+#include "core/event.h"
 #include "core/logger.h"
 #include "core/kmemory.h"
 #include "core/kstring.h"
 #include "math/geometry_utils.h"
+#include "resources/resource_cache.h"
+#include "resources/texture_atlas.h"
 #include "systems/material_system.h"
 #include "renderer/renderer_frontend.h"
-#include "math/geometry_utils.h"
 
 typedef struct geometry_reference {
     u64 reference_count;
     geometry geometry;
     b8 auto_release;
+    // The handle of this reference's slot.
+    slot_handle handle;
+    // The memory the geometry holds, as counted against the cache budget.
+    u64 size;
 } geometry_reference;
 
 typedef struct geometry_system_state {
@@ -20,8 +27,13 @@ typedef struct geometry_system_state {
     geometry default_geometry;
     geometry default_2d_geometry;
 
-    // Array of registered meshes.
+    // Slots of registered geometries.
+    slot_map geometry_slots;
+    // The slot map's elements, indexed by geometry id.
     geometry_reference* registered_geometries;
+
+    // Released auto-release geometries kept loaded in case they are acquired again, by id.
+    resource_cache cache;
 } geometry_system_state;
 
 static geometry_system_state* state_ptr = 0;
@@ -29,6 +41,8 @@ static geometry_system_state* state_ptr = 0;
 b8 create_default_geometries(geometry_system_state* state);
 b8 create_geometry(geometry_system_state* state, geometry_config config, geometry* g);
 void destroy_geometry(geometry_system_state* state, geometry* g);
+static void geometry_unload(geometry_system_state* state, geometry_reference* ref);
+static b8 geometry_system_on_memory_pressure(u16 code, void* sender, void* listener_inst, event_context context);
 
 b8 geometry_system_initialize(u64* memory_requirement, void* state, geometry_system_config config) {
     if (config.max_geometry_count == 0) {
@@ -36,10 +50,13 @@ b8 geometry_system_initialize(u64* memory_requirement, void* state, geometry_sys
         return false;
     }
 
-    // Block of memory will contain state structure, then block for array, then block for hashtable.
+    // Block of memory will contain state structure, then block for the slot map, then the cache's entries.
     u64 struct_requirement = sizeof(geometry_system_state);
-    u64 array_requirement = sizeof(geometry_reference) * config.max_geometry_count;
-    *memory_requirement = struct_requirement + array_requirement;
+    u64 slot_map_requirement = 0;
+    slot_map_create(sizeof(geometry_reference), config.max_geometry_count, &slot_map_requirement, 0, 0);
+    u64 cache_requirement = 0;
+    resource_cache_create(0, config.max_geometry_count, config.cache_budget, &cache_requirement, 0, 0);
+    *memory_requirement = struct_requirement + slot_map_requirement + cache_requirement;
 
     if (!state) {
         return true;
@@ -48,9 +65,11 @@ b8 geometry_system_initialize(u64* memory_requirement, void* state, geometry_sys
     state_ptr = state;
     state_ptr->config = config;
 
-    // The array block is after the state. Already allocated, so just set the pointer.
-    void* array_block = state + struct_requirement;
-    state_ptr->registered_geometries = array_block;
+    // The slot map block is after the state. Already allocated, so just set the pointer.
+    void* slot_map_block = state + struct_requirement;
+    slot_map_create(sizeof(geometry_reference), config.max_geometry_count, &slot_map_requirement, slot_map_block, &state_ptr->geometry_slots);
+    state_ptr->registered_geometries = state_ptr->geometry_slots.elements;
+    resource_cache_create("geometries", config.max_geometry_count, config.cache_budget, &cache_requirement, (u8*)slot_map_block + slot_map_requirement, &state_ptr->cache);
 
     // Invalidate all geometries in the array.
     u32 count = state_ptr->config.max_geometry_count;
@@ -58,6 +77,7 @@ b8 geometry_system_initialize(u64* memory_requirement, void* state, geometry_sys
         state_ptr->registered_geometries[i].geometry.id = INVALID_ID;
         state_ptr->registered_geometries[i].geometry.internal_id = INVALID_ID;
         state_ptr->registered_geometries[i].geometry.generation = INVALID_ID_U16;
+        state_ptr->registered_geometries[i].handle = SLOT_HANDLE_INVALID;
     }
 
     if (!create_default_geometries(state_ptr)) {
@@ -65,15 +85,24 @@ b8 geometry_system_initialize(u64* memory_requirement, void* state, geometry_sys
         return false;
     }
 
+    // Geometries nothing refers to are unloaded when GPU memory is about to run out.
+    event_register(EVENT_CODE_GPU_MEMORY_PRESSURE, state_ptr, geometry_system_on_memory_pressure);
+
     return true;
 }
 
 void geometry_system_shutdown(void* state) {
-    // NOTE: nothing to do here.
+    if (state_ptr) {
+        event_unregister(EVENT_CODE_GPU_MEMORY_PRESSURE, state_ptr, geometry_system_on_memory_pressure);
+        resource_cache_destroy(&state_ptr->cache);
+        slot_map_destroy(&state_ptr->geometry_slots);
+    }
 }
 
 geometry* geometry_system_acquire_by_id(u32 id) {
-    if (id != INVALID_ID && state_ptr->registered_geometries[id].geometry.id != INVALID_ID) {
+    if (id < state_ptr->config.max_geometry_count && state_ptr->registered_geometries[id].geometry.id != INVALID_ID) {
+        // Held by the cache since its last release, so back in use as it was.
+        resource_cache_acquire(&state_ptr->cache, id);
         state_ptr->registered_geometries[id].reference_count++;
         return &state_ptr->registered_geometries[id].geometry;
     }
@@ -83,28 +112,63 @@ geometry* geometry_system_acquire_by_id(u32 id) {
     return 0;
 }
 
-geometry* geometry_system_acquire_from_config(geometry_config config, b8 auto_release) {
-    geometry* g = 0;
-    for (u32 i = 0; i < state_ptr->config.max_geometry_count; ++i) {
-        if (state_ptr->registered_geometries[i].geometry.id == INVALID_ID) {
-            // Found empty slot.
-            state_ptr->registered_geometries[i].auto_release = auto_release;
-            state_ptr->registered_geometries[i].reference_count = 1;
-            g = &state_ptr->registered_geometries[i].geometry;
-            g->id = i;
-            break;
+geometry* geometry_system_acquire_by_handle(slot_handle handle) {
+    // Resolves only if the slot has not been freed since the handle was given out.
+    geometry_reference* ref = slot_map_get(&state_ptr->geometry_slots, handle);
+    if (ref && ref->geometry.id != INVALID_ID) {
+        resource_cache_acquire(&state_ptr->cache, ref->geometry.id);
+        ref->reference_count++;
+        return &ref->geometry;
+    }
+
+    KERROR("geometry_system_acquire_by_handle cannot load a geometry which has been unloaded. Returning nullptr.");
+    return 0;
+}
+
+geometry* geometry_system_acquire_by_name(const char* name) {
+    // Only looked up by tools such as replays, so a search is enough.
+    u32 count = state_ptr->config.max_geometry_count;
+    for (u32 i = 0; i < count; ++i) {
+        geometry_reference* ref = &state_ptr->registered_geometries[i];
+        if (ref->geometry.id != INVALID_ID && strings_equal(ref->geometry.name, name)) {
+            resource_cache_acquire(&state_ptr->cache, ref->geometry.id);
+            ref->reference_count++;
+            return &ref->geometry;
         }
     }
+    return 0;
+}
 
-    if (!g) {
+slot_handle geometry_system_handle_get(const geometry* g) {
+    if (!g || g->id >= state_ptr->config.max_geometry_count) {
+        return SLOT_HANDLE_INVALID;
+    }
+    const geometry_reference* ref = &state_ptr->registered_geometries[g->id];
+    return &ref->geometry == g ? ref->handle : SLOT_HANDLE_INVALID;
+}
+
+geometry* geometry_system_acquire_from_config(geometry_config config, b8 auto_release) {
+    geometry_reference ref = {0};
+    ref.reference_count = 1;
+    ref.auto_release = auto_release;
+    ref.geometry.internal_id = INVALID_ID;
+    ref.geometry.generation = INVALID_ID_U16;
+    slot_handle handle = slot_map_insert(&state_ptr->geometry_slots, &ref);
+    if (handle == SLOT_HANDLE_INVALID) {
         KERROR("Unable to obtain free slot for geometry. Adjust configuration to allow more space. Returning nullptr.");
         return 0;
     }
 
+    geometry_reference* slot = slot_map_get(&state_ptr->geometry_slots, handle);
+    slot->handle = handle;
+    geometry* g = &slot->geometry;
+    g->id = slot_handle_index(handle);
+
     if (!create_geometry(state_ptr, config, g)) {
         KERROR("Failed to create geometry. Returning nullptr.");
         return 0;
     }
+    slot->size = (u64)config.vertex_size * config.vertex_count + (u64)config.index_size * config.index_count + sizeof(geometry_meshlet) * g->meshlet_count;
 
     return g;
 }
@@ -114,15 +178,18 @@ void geometry_system_config_dispose(geometry_config* config) {
         if (config->vertices) {
             kfree(config->vertices, config->vertex_size * config->vertex_count, MEMORY_TAG_ARRAY);
         }
-        if (config->vertices) {
+        if (config->indices) {
             kfree(config->indices, config->index_size * config->index_count, MEMORY_TAG_ARRAY);
         }
+        if (config->meshlets) {
+            kfree(config->meshlets, sizeof(geometry_meshlet) * config->meshlet_count, MEMORY_TAG_ARRAY);
+        }
         kzero_memory(config, sizeof(geometry_config));
     }
 }
 
 void geometry_system_release(geometry* geometry) {
-    if (geometry && geometry->id != INVALID_ID) {
+    if (geometry && geometry->id < state_ptr->config.max_geometry_count) {
         geometry_reference* ref = &state_ptr->registered_geometries[geometry->id];
 
         // Take a copy of the id;
@@ -132,11 +199,16 @@ void geometry_system_release(geometry* geometry) {
                 ref->reference_count--;
             }
 
-            // Also blanks out the geometry id.
+            // Cached in case it is acquired again, or destroyed if it does not fit. Destroying also blanks out the geometry id.
             if (ref->reference_count < 1 && ref->auto_release) {
-                destroy_geometry(state_ptr, &ref->geometry);
-                ref->reference_count = 0;
-                ref->auto_release = false;
+                if (resource_cache_insert(&state_ptr->cache, id, ref->size)) {
+                    u32 evicted;
+                    while (resource_cache_evict(&state_ptr->cache, state_ptr->cache.budget, &evicted)) {
+                        geometry_unload(state_ptr, &state_ptr->registered_geometries[evicted]);
+                    }
+                } else {
+                    geometry_unload(state_ptr, ref);
+                }
             }
         } else {
             KFATAL("Geometry id mismatch. Check registration logic, as this should never occur.");
@@ -147,6 +219,41 @@ void geometry_system_release(geometry* geometry) {
     KWARN("geometry_system_release cannot release invalid geometry id. Nothing was done.");
 }
 
+static b8 geometry_system_on_memory_pressure(u16 code, void* sender, void* listener_inst, event_context context) {
+    geometry_system_state* state = listener_inst;
+    if ((renderer_memory_pressure)context.data.u8[0] != RENDERER_MEMORY_PRESSURE_CRITICAL) {
+        // Left for other systems to act on.
+        return false;
+    }
+
+    // Those cached, or released without auto release, are kept loaded in case they are acquired
+    // again, which is no longer worth the memory. Each one's vertices and every level of detail go together.
+    u32 unloaded = 0;
+    for (u32 i = 0; i < state->config.max_geometry_count; ++i) {
+        geometry_reference* ref = &state->registered_geometries[i];
+        if (ref->handle == SLOT_HANDLE_INVALID || ref->geometry.id == INVALID_ID || ref->reference_count > 0) {
+            continue;
+        }
+        geometry_unload(state, ref);
+        unloaded++;
+    }
+    if (unloaded) {
+        KINFO("Unloaded %u unreferenced geometries, as GPU memory is nearly exhausted.", unloaded);
+    }
+    return false;
+}
+
+// Destroys a registered geometry nothing refers to, and frees its slot.
+static void geometry_unload(geometry_system_state* state, geometry_reference* ref) {
+    resource_cache_remove(&state->cache, ref->geometry.id);
+    destroy_geometry(state, &ref->geometry);
+    ref->reference_count = 0;
+    ref->auto_release = false;
+    ref->size = 0;
+    slot_map_remove(&state->geometry_slots, ref->handle);
+    ref->handle = SLOT_HANDLE_INVALID;
+}
+
 geometry* geometry_system_get_default() {
     if (state_ptr) {
         return &state_ptr->default_geometry;
@@ -165,12 +272,90 @@ geometry* geometry_system_get_default_2d() {
     return 0;
 }
 
+// Uploads geometry to the GPU. Full 3D vertices are packed first, as the 3D shaders read the packed layout,
+// and 32-bit indices are narrowed to 16 bits where there are few enough vertices, halving their size.
+static b8 geometry_upload(geometry* g, u32 vertex_size, u32 vertex_count, const void* vertices, u32 index_size, u32 index_count, const void* indices) {
+    // All of the indices make up the only level of detail, unless told otherwise.
+    g->lod_count = 1;
+    g->lods[0] = (geometry_lod){0, index_count, 0.0f};
+
+    u16* narrowed = 0;
+    u64 narrowed_size = 0;
+    if (index_size == sizeof(u32) && index_count && indices && vertex_count <= INVALID_ID_U16) {
+        narrowed_size = sizeof(u16) * index_count;
+        narrowed = kallocate(narrowed_size, MEMORY_TAG_ARRAY);
+        for (u32 i = 0; i < index_count; ++i) {
+            narrowed[i] = (u16)((const u32*)indices)[i];
+        }
+        index_size = sizeof(u16);
+        indices = narrowed;
+    }
+
+    b8 result;
+    if (vertex_size != sizeof(vertex_3d) || !vertices) {
+        result = renderer_create_geometry(g, vertex_size, vertex_count, vertices, index_size, index_count, indices);
+    } else {
+        u64 packed_size = sizeof(vertex_3d_packed) * vertex_count;
+        vertex_3d_packed* packed = kallocate(packed_size, MEMORY_TAG_ARRAY);
+        geometry_pack_vertices(vertex_count, vertices, packed);
+        result = renderer_create_geometry(g, sizeof(vertex_3d_packed), vertex_count, packed, index_size, index_count, indices);
+        kfree(packed, packed_size, MEMORY_TAG_ARRAY);
+    }
+
+    if (narrowed) {
+        kfree(narrowed, narrowed_size, MEMORY_TAG_ARRAY);
+    }
+    return result;
+}
+
+// Copies the given 2D vertices with their texture coordinates mapped into the given part of a texture,
+// such as where a material's diffuse map was packed into the atlas. The copy is owned by the caller.
+static vertex_2d* texcoords_remap_2d(u32 vertex_count, const vertex_2d* vertices, vec4 uv_rect) {
+    vertex_2d* remapped = kallocate(sizeof(vertex_2d) * vertex_count, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < vertex_count; ++i) {
+        remapped[i] = vertices[i];
+        remapped[i].texcoord = texture_atlas_uv_map(uv_rect, vertices[i].texcoord);
+    }
+    return remapped;
+}
+
 b8 create_geometry(geometry_system_state* state, geometry_config config, geometry* g) {
+    // Acquire the material first, as 2D geometries are drawn from the part of its diffuse map's texture it uses,
+    // so wait for it to load. Others are drawn with the default material until theirs is loaded.
+    if (string_length(config.material_name) > 0) {
+        g->material = config.vertex_size == sizeof(vertex_2d) ? material_system_acquire(config.material_name) : material_system_acquire_async(config.material_name);
+        if (!g->material) {
+            g->material = material_system_get_default();
+        }
+    }
+
+    vertex_2d* remapped = 0;
+    const void* vertices = config.vertices;
+    if (g->material && config.vertex_size == sizeof(vertex_2d) && config.vertices) {
+        vec4 rect = g->material->diffuse_uv_rect;
+        if (rect.x != 0.0f || rect.y != 0.0f || rect.z != 1.0f || rect.w != 1.0f) {
+            remapped = texcoords_remap_2d(config.vertex_count, config.vertices, rect);
+            vertices = remapped;
+        }
+    }
+
     // Send the geometry off to the renderer to be uploaded to the GPU.
-    if (!renderer_create_geometry(g, config.vertex_size, config.vertex_count, config.vertices, config.index_size, config.index_count, config.indices)) {
+    b8 uploaded = geometry_upload(g, config.vertex_size, config.vertex_count, vertices, config.index_size, config.index_count, config.indices);
+    if (remapped) {
+        kfree(remapped, sizeof(vertex_2d) * config.vertex_count, MEMORY_TAG_ARRAY);
+    }
+    if (!uploaded) {
+        if (g->material && string_length(g->material->name) > 0) {
+            material_system_release(g->material->name);
+        }
+        g->material = 0;
+
         // Invalidate the entry.
-        state->registered_geometries[g->id].reference_count = 0;
-        state->registered_geometries[g->id].auto_release = false;
+        geometry_reference* ref = &state->registered_geometries[g->id];
+        ref->reference_count = 0;
+        ref->auto_release = false;
+        slot_map_remove(&state->geometry_slots, ref->handle);
+        ref->handle = SLOT_HANDLE_INVALID;
         g->id = INVALID_ID;
         g->generation = INVALID_ID_U16;
         g->internal_id = INVALID_ID;
@@ -178,19 +363,40 @@ b8 create_geometry(geometry_system_state* state, geometry_config config, geometr
         return false;
     }
 
+    if (config.lod_count > 0) {
+        b8 lods_valid = config.lod_count <= GEOMETRY_MAX_LODS;
+        for (u32 i = 0; i < config.lod_count && lods_valid; ++i) {
+            lods_valid = config.lods[i].index_offset + config.lods[i].index_count <= config.index_count;
+        }
+        if (lods_valid) {
+            g->lod_count = config.lod_count;
+            kcopy_memory(g->lods, config.lods, sizeof(geometry_lod) * config.lod_count);
+        } else {
+            KWARN("Geometry '%s' has invalid levels of detail, so only the full geometry will be drawn.", config.name);
+        }
+    }
+
+    // Meshlets must lie within the full level of detail.
+    if (config.meshlet_count > 0 && config.meshlets) {
+        u32 full_end = g->lods[0].index_offset + g->lods[0].index_count;
+        b8 meshlets_valid = true;
+        for (u32 i = 0; i < config.meshlet_count && meshlets_valid; ++i) {
+            meshlets_valid = config.meshlets[i].index_offset + config.meshlets[i].index_count <= full_end;
+        }
+        if (meshlets_valid) {
+            g->meshlet_count = config.meshlet_count;
+            g->meshlets = kallocate(sizeof(geometry_meshlet) * config.meshlet_count, MEMORY_TAG_ARRAY);
+            kcopy_memory(g->meshlets, config.meshlets, sizeof(geometry_meshlet) * config.meshlet_count);
+        } else {
+            KWARN("Geometry '%s' has invalid meshlets, so it will be culled whole.", config.name);
+        }
+    }
+
     // Copy over extents, center, etc.
     g->center = config.center;
     g->extents.min = config.min_extents;
     g->extents.max = config.max_extents;
 
-    // Acquire the material
-    if (string_length(config.material_name) > 0) {
-        g->material = material_system_acquire(config.material_name);
-        if (!g->material) {
-            g->material = material_system_get_default();
-        }
-    }
-
     return true;
 }
 
@@ -200,6 +406,12 @@ void destroy_geometry(geometry_system_state* state, geometry* g) {
     g->generation = INVALID_ID_U16;
     g->id = INVALID_ID;
 
+    if (g->meshlets) {
+        kfree(g->meshlets, sizeof(geometry_meshlet) * g->meshlet_count, MEMORY_TAG_ARRAY);
+        g->meshlets = 0;
+    }
+    g->meshlet_count = 0;
+
     string_empty(g->name);
 
     // Release the material.
@@ -239,7 +451,7 @@ b8 create_default_geometries(geometry_system_state* state) {
 
     // Send the geometry off to the renderer to be uploaded to the GPU.
     state->default_geometry.internal_id = INVALID_ID;
-    if (!renderer_create_geometry(&state->default_geometry, sizeof(vertex_3d), 4, verts, sizeof(u32), 6, indices)) {
+    if (!geometry_upload(&state->default_geometry, sizeof(vertex_3d), 4, verts, sizeof(u32), 6, indices)) {
         KFATAL("Failed to create default geometry. Application cannot continue.");
         return false;
     }
@@ -312,7 +524,7 @@ geometry_config geometry_system_generate_plane_config(f32 width, f32 height, u32
         tile_y = 1.0f;
     }
 
-    geometry_config config;
+    geometry_config config = {};
     config.vertex_size = sizeof(vertex_3d);
     config.vertex_count = x_segment_count * y_segment_count * 4;  // 4 verts per segment
     config.vertices = kallocate(sizeof(vertex_3d) * config.vertex_count, MEMORY_TAG_ARRAY);
@@ -411,7 +623,7 @@ geometry_config geometry_system_generate_cube_config(f32 width, f32 height, f32
         tile_y = 1.0f;
     }
 
-    geometry_config config;
+    geometry_config config = {};
     config.vertex_size = sizeof(vertex_3d);
     config.vertex_count = 4 * 6;  // 4 verts per side, 6 sides
     config.vertices = kallocate(sizeof(vertex_3d) * config.vertex_count, MEMORY_TAG_ARRAY);
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include "containers/slot_map.h"
 #include "renderer/renderer_types.inl"
 
 /** @brief The geometry system configuration. */
@@ -22,14 +23,23 @@ typedef struct geometry_system_config {
      * Take other systems into account as well.
      */
     u32 max_geometry_count;
-
+    /**
+     * @brief The most memory, in bytes, auto-released geometries nothing refers to any more may
+     * keep holding, so that they are there at once if acquired again by id or handle. Those
+     * released longest ago are destroyed to stay within it. If zero, they are destroyed as soon
+     * as they are released.
+     */
+    u64 cache_budget;
 } geometry_system_config;
 
 /**
  * @brief Represents the configuration for a geometry.
  */
 typedef struct geometry_config {
-    /** @brief The size of each vertex. */
+    /**
+     * @brief The size of each vertex. vertex_3d vertices are packed into vertex_3d_packed ones
+     * when uploaded, and vertex_3d_packed and vertex_2d ones are uploaded as they are.
+     */
     u32 vertex_size;
     /** @brief The number of vertices. */
     u32 vertex_count;
@@ -37,10 +47,21 @@ typedef struct geometry_config {
     void* vertices;
     /** @brief The size of each index. */
     u32 index_size;
-    /** @brief The number of indices. */
+    /** @brief The number of indices, including those of every level of detail. */
     u32 index_count;
     /** @brief An array of indices. */
     void* indices;
+    /**
+     * @brief The number of levels of detail, each a range of the indices. If 0, all of the
+     * indices make up the only level.
+     */
+    u8 lod_count;
+    /** @brief The levels of detail, from the full geometry to the coarsest. */
+    geometry_lod lods[GEOMETRY_MAX_LODS];
+    /** @brief The number of meshlets of the full level of detail, or 0 if it is not split into any. */
+    u32 meshlet_count;
+    /** @brief The meshlets of the full level of detail, each a range of its indices. */
+    geometry_meshlet* meshlets;
 
     vec3 center;
     vec3 min_extents;
@@ -75,7 +96,8 @@ b8 geometry_system_initialize(u64* memory_requirement, void* state, geometry_sys
 void geometry_system_shutdown(void* state);
 
 /**
- * @brief Acquires an existing geometry by id.
+ * @brief Acquires an existing geometry by id. Ids are reused once their geometry is unloaded, so
+ * anything holding one across unloads should hold a handle instead.
  *
  * @param id The geometry identifier to acquire by.
  * @return A pointer to the acquired geometry or nullptr if failed.
@@ -83,7 +105,36 @@ void geometry_system_shutdown(void* state);
 KAPI geometry* geometry_system_acquire_by_id(u32 id);
 
 /**
- * @brief Registers and acquires a new geometry using the given config.
+ * @brief Acquires an existing geometry by handle. Unlike ids, handles stop resolving once their
+ * geometry is unloaded, even if another geometry has since been loaded into its slot.
+ *
+ * @param handle The handle of the geometry, as from geometry_system_handle_get().
+ * @return A pointer to the acquired geometry or nullptr if the handle no longer refers to one.
+ */
+KAPI geometry* geometry_system_acquire_by_handle(slot_handle handle);
+
+/**
+ * @brief Acquires the first loaded geometry found with the given name. Names need not be unique,
+ * so this is meant for tools rather than for games, which should hold handles instead. Searches
+ * every slot, so takes time in proportion to the max geometry count.
+ *
+ * @param name The name of the geometry.
+ * @return A pointer to the acquired geometry or nullptr if none by that name is loaded.
+ */
+KAPI geometry* geometry_system_acquire_by_name(const char* name);
+
+/**
+ * @brief Obtains the generational handle of the given registered geometry, which may be held in
+ * place of a pointer and checked with geometry_system_acquire_by_handle().
+ *
+ * @param g A constant pointer to the geometry.
+ * @return The handle of the geometry, or SLOT_HANDLE_INVALID if it is not registered.
+ */
+KAPI slot_handle geometry_system_handle_get(const geometry* g);
+
+/**
+ * @brief Registers and acquires a new geometry using the given config. Its slot is taken from a
+ * free list, so registering takes the same time however many geometries are loaded.
  *
  * @param config The geometry configuration.
  * @param auto_release Indicates if the acquired geometry should be unloaded when its reference count reaches 0.
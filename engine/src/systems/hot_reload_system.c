@@ -0,0 +1,162 @@
+#include "hot_reload_system.h"
+
+#include "core/logger.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "platform/file_watcher.h"
+#include "platform/platform.h"
+
+#include "systems/material_system.h"
+#include "systems/resource_system.h"
+#include "systems/shader_system.h"
+#include "systems/texture_system.h"
+
+typedef struct pending_change {
+    char path[FILE_WATCHER_MAX_PATH_LENGTH];
+    // The time the file was last seen changing.
+    f64 last_change_time;
+} pending_change;
+
+typedef struct hot_reload_system_state {
+    hot_reload_system_config config;
+    file_watcher watcher;
+    // Array of changes waiting to settle.
+    pending_change* pending;
+    u32 pending_count;
+} hot_reload_system_state;
+
+static hot_reload_system_state* state_ptr = 0;
+
+b8 hot_reload_system_initialize(u64* memory_requirement, void* state, hot_reload_system_config config) {
+    if (config.max_pending_count == 0) {
+        KFATAL("hot_reload_system_initialize - config.max_pending_count must be > 0.");
+        return false;
+    }
+
+    // Block of memory will contain state structure, then block for array.
+    u64 struct_requirement = sizeof(hot_reload_system_state);
+    u64 array_requirement = sizeof(pending_change) * config.max_pending_count;
+    *memory_requirement = struct_requirement + array_requirement;
+
+    if (!state) {
+        return true;
+    }
+
+    hot_reload_system_state* s = (hot_reload_system_state*)state;
+    s->config = config;
+    s->pending = (pending_change*)((u8*)state + struct_requirement);
+    s->pending_count = 0;
+
+    if (!file_watcher_create(resource_system_base_path(), &s->watcher)) {
+        KWARN("hot_reload_system_initialize - unable to watch '%s'. Assets will not be reloaded.", resource_system_base_path());
+        return false;
+    }
+
+    state_ptr = s;
+    KINFO("Hot reload watching '%s'.", resource_system_base_path());
+    return true;
+}
+
+void hot_reload_system_shutdown(void* state) {
+    hot_reload_system_state* s = (hot_reload_system_state*)state;
+    if (s) {
+        file_watcher_destroy(&s->watcher);
+        kzero_memory(s, sizeof(hot_reload_system_state));
+    }
+    state_ptr = 0;
+}
+
+// Gets the name of the asset at the given path, which is the part after the type directory without
+// the extension (e.g. "textures/cobblestone.png" is "cobblestone"). Returns false if the path is not
+// in the given type directory.
+static b8 asset_name_from_path(const char* path, const char* type_path, char* out_name, u64 max_length) {
+    kstring_view view = string_view_create(path);
+    u64 prefix_length = string_length(type_path);
+    if (view.length <= prefix_length + 1 || !strings_nequal(view.str, type_path, prefix_length) || view.str[prefix_length] != '/') {
+        return false;
+    }
+    kstring_view name = string_view_mid(view, prefix_length + 1, -1);
+    // Strip the extension, if there is one after the last separator.
+    for (i64 i = (i64)name.length - 1; i >= 0; --i) {
+        if (name.str[i] == '/') {
+            break;
+        }
+        if (name.str[i] == '.') {
+            name.length = (u64)i;
+            break;
+        }
+    }
+    if (!name.length) {
+        return false;
+    }
+    string_view_copy(out_name, name, max_length);
+    return true;
+}
+
+static b8 path_has_extension(const char* path, const char* extension) {
+    u64 length = string_length(path);
+    u64 extension_length = string_length(extension);
+    return length > extension_length && strings_equali(path + length - extension_length, extension);
+}
+
+static void reload_file(const char* path) {
+    // Only loaded assets are reloaded; everything else is ignored quietly.
+    char name[FILE_WATCHER_MAX_PATH_LENGTH];
+    if (asset_name_from_path(path, "textures", name, sizeof(name))) {
+        // Cube textures are loaded from several files, and are not reloaded.
+        texture_system_reload(name);
+    } else if (asset_name_from_path(path, "materials", name, sizeof(name))) {
+        if (path_has_extension(path, ".kmt")) {
+            material_system_reload(name);
+        }
+    } else if (path_has_extension(path, ".spv")) {
+        // Shaders refer to their stage files by path relative to the base path, which is also
+        // the name the stage is shared under, so the old code is dropped before reloading.
+        resource_system_invalidate(path, RESOURCE_TYPE_BINARY);
+        shader_system_reload_stage_file(path);
+    }
+}
+
+void hot_reload_system_update() {
+    if (!state_ptr) {
+        return;
+    }
+
+    f64 now = platform_get_absolute_time();
+
+    // Collect new changes, merging repeats of the same file.
+    char path[FILE_WATCHER_MAX_PATH_LENGTH];
+    while (file_watcher_next_change(&state_ptr->watcher, path, sizeof(path))) {
+        u32 index = INVALID_ID;
+        for (u32 i = 0; i < state_ptr->pending_count; ++i) {
+            if (strings_equal(state_ptr->pending[i].path, path)) {
+                index = i;
+                break;
+            }
+        }
+        if (index == INVALID_ID) {
+            if (state_ptr->pending_count == state_ptr->config.max_pending_count) {
+                KWARN("hot_reload_system_update - too many changed files waiting; '%s' will not be reloaded.", path);
+                continue;
+            }
+            index = state_ptr->pending_count++;
+            string_ncopy(state_ptr->pending[index].path, path, FILE_WATCHER_MAX_PATH_LENGTH);
+        }
+        state_ptr->pending[index].last_change_time = now;
+    }
+
+    // Reload files that have settled.
+    for (u32 i = 0; i < state_ptr->pending_count;) {
+        pending_change* change = &state_ptr->pending[i];
+        if (now - change->last_change_time < state_ptr->config.settle_seconds) {
+            ++i;
+            continue;
+        }
+        reload_file(change->path);
+        // Order does not matter, so fill the gap with the last entry.
+        state_ptr->pending_count--;
+        if (i != state_ptr->pending_count) {
+            state_ptr->pending[i] = state_ptr->pending[state_ptr->pending_count];
+        }
+    }
+}
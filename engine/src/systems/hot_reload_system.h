@@ -0,0 +1,54 @@
+/**
+ * @file hot_reload_system.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief The hot reload system watches the asset directory and reloads textures, materials
+ * and shaders whose files change while the application runs.
+ * @details Changes are collected once per frame. Each changed file waits until it has been
+ * quiet for the configured settle time, so that a file written in several steps is reloaded
+ * once. Textures and materials are read on jobs and swapped in on the main thread as the
+ * jobs complete; shaders are rebuilt directly. Anything that fails to reload keeps its
+ * previous version.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief The hot reload system configuration. */
+typedef struct hot_reload_system_config {
+    /** @brief The maximum number of changed files waiting to be reloaded at once. Further changes are dropped. */
+    u32 max_pending_count;
+    /** @brief How long, in seconds, a file must go unchanged before it is reloaded. */
+    f64 settle_seconds;
+} hot_reload_system_config;
+
+/**
+ * @brief Initializes the hot reload system, watching the resource system's base path.
+ * Should be called twice; once to get the memory requirement (passing state=0), and a second
+ * time passing an allocated block of memory to actually initialize the system.
+ * Requires the resource, texture, material and shader systems.
+ *
+ * @param memory_requirement A pointer to hold the memory requirement as it is calculated.
+ * @param state A block of memory to hold the state or, if gathering the memory requirement, 0.
+ * @param config The configuration for this system.
+ * @return True on success; otherwise false, such as when watching is not supported.
+ */
+b8 hot_reload_system_initialize(u64* memory_requirement, void* state, hot_reload_system_config config);
+
+/**
+ * @brief Shuts down the hot reload system.
+ *
+ * @param state The state block of memory.
+ */
+void hot_reload_system_shutdown(void* state);
+
+/**
+ * @brief Collects changed files and starts reloading those that have settled. Should be
+ * called once per frame, before the job system is updated.
+ */
+void hot_reload_system_update();
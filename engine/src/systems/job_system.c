@@ -2,93 +2,818 @@
 
 #include "core/kthread.h"
 #include "core/kmutex.h"
+#include "core/ksemaphore.h"
+#include "core/katomic.h"
+#include "core/kfiber.h"
 #include "core/kmemory.h"
 #include "core/logger.h"
+#include "core/kstring.h"
+#include "core/profiler.h"
+#include "core/counters.h"
+#include "containers/darray.h"
+#include "containers/mpmc_queue.h"
 #include "containers/ring_queue.h"
+#include "containers/work_deque.h"
+#include "memory/scratch_allocator.h"
+#include "platform/platform.h"
+
+// The max number of jobs each of a thread's deques can hold. Must be a power of 2.
+#define JOB_DEQUE_CAPACITY 512
+// The number of jobs each of a thread's inboxes can hold initially. Inboxes grow as needed.
+#define JOB_INBOX_CAPACITY 1024
+// The number of released waiting jobs taken off the waiting list at a time.
+#define JOB_RELEASE_CHUNK_SIZE 16
+// The number of jobs job_system_submit_batch hands over at a time.
+#define JOB_BATCH_CHUNK_SIZE 64
+// The max number of fiber jobs each thread can have in flight at once.
+#define JOB_FIBERS_PER_THREAD 8
+// The stack size of each job fiber, in bytes.
+#define JOB_FIBER_STACK_SIZE (256 * 1024)
+// How often a thread with suspended fiber jobs checks on them while idle, in milliseconds.
+#define JOB_FIBER_POLL_MS 1
+// How often the load of the job threads is sampled under JOB_POWER_POLICY_BATTERY, in microseconds.
+#define JOB_LOAD_SAMPLE_US 250000
+// The share of its time the active threads must spend busy over a sample for another to be unparked.
+#define JOB_LOAD_HIGH 0.75
+// The share below which one of the active threads is parked.
+#define JOB_LOAD_LOW 0.25
+
+// How long shutting down waits for the job threads to finish the jobs they are on and exit.
+#define JOB_SHUTDOWN_TIMEOUT_MS 2000
+
+struct job_thread;
+
+/**
+ * A fiber which runs fiber jobs for a single job thread. Once started, a fiber job
+ * always resumes on the same thread, as thread-local state may not be safely reloaded
+ * by code which moves between threads.
+ */
+typedef struct job_fiber {
+    kfiber fiber;
+    // The thread this fiber belongs to.
+    struct job_thread* owner;
+    // The job being run on this fiber.
+    job_info info;
+    // The job which must complete before this fiber is resumed. INVALID_ID if none.
+    job_handle wait_handle;
+    // A condition which must be met before this fiber is resumed, and the data passed to it. 0 if none.
+    pfn_job_wait_condition wait_condition;
+    void* wait_user_data;
+    // Set once the job has finished, so the fiber can be handed a new one.
+    b8 finished;
+} job_fiber;
 
 typedef struct job_thread {
     u8 index;
     kthread thread;
-    job_info info;
-    // A mutex to guard access to this thread's info.
-    kmutex info_mutex;
 
     // The types of jobs this thread can handle.
     u32 type_mask;
+
+    // Lock-free deques owned by this thread, one per priority. Jobs submitted from
+    // this thread are pushed here, and other idle threads steal from the top.
+    work_deque deques[JOB_PRIORITY_COUNT];
+
+    // Jobs submitted from outside the job threads, one per priority. Moved into the
+    // deques by the owning thread, but may also be taken directly by other threads.
+    ring_queue inboxes[JOB_PRIORITY_COUNT];
+    // A mutex to guard access to this thread's inboxes.
+    kmutex inbox_mutex;
+
+    // Signalled when work is available for this thread, so it can sleep while idle.
+    ksemaphore wake_semaphore;
+    // Non-zero while this thread is asleep, waiting for work.
+    u32 sleeping;
+    // Non-zero while this thread is parked. A parked thread runs only what is handed to it
+    // directly, so is never claimed or woken for work another thread could be given.
+    u32 parked;
+    // Used to vary which thread is stolen from first.
+    u32 steal_index;
+
+    // A fiber representing the thread itself, which fiber jobs switch back to when they finish or yield.
+    kfiber thread_fiber;
+    // Indicates if the thread fiber was created, and so fiber jobs can be run on fibers.
+    b8 fibers_enabled;
+    // Fibers owned by this thread, created as they are needed.
+    job_fiber fibers[JOB_FIBERS_PER_THREAD];
+    u8 fiber_count;
+    // Indices of the fibers not running a job.
+    u8 free_fibers[JOB_FIBERS_PER_THREAD];
+    u8 free_fiber_count;
+    // Indices of the fibers whose job has yielded, to be resumed later.
+    u8 suspended_fibers[JOB_FIBERS_PER_THREAD];
+    u8 suspended_fiber_count;
+
+    // The time the thread started running, in microseconds.
+    u64 start_time_us;
+    // The total time spent running jobs, in microseconds. Only written by this thread.
+    u64 busy_time_us;
+    // The busy time as of the last load sample. Only used on the main thread.
+    u64 sampled_busy_time_us;
+    // The number of jobs run by this thread. Only written by this thread.
+    u64 jobs_run;
+    // Set once the thread is done with the job system's state and about to exit.
+    u32 exited;
 } job_thread;
 
 typedef struct job_result_entry {
-    u16 id;
     pfn_job_on_complete callback;
     u32 param_size;
     void* params;
 } job_result_entry;
 
-// The max number of job results that can be stored at once.
-#define MAX_JOB_RESULTS 512
+// The max number of job results that can be stored at once. Must be a power of 2.
+#define MAX_JOB_RESULTS 4096
+
+// The size of each block in the small job payload pool, in bytes.
+#define JOB_PAYLOAD_SMALL_BLOCK_SIZE 128
+// The number of blocks in the small job payload pool.
+#define JOB_PAYLOAD_SMALL_BLOCK_COUNT 2048
+// The size of each block in the large job payload pool, in bytes.
+#define JOB_PAYLOAD_LARGE_BLOCK_SIZE 1024
+// The number of blocks in the large job payload pool.
+#define JOB_PAYLOAD_LARGE_BLOCK_COUNT 512
+
+/**
+ * A pool of fixed-size blocks used to hold job parameter and result data, so that
+ * submitting a typical job does not go through the (mutex-guarded) global allocator.
+ * Free blocks are kept in a lock-free stack.
+ */
+typedef struct job_payload_pool {
+    u32 block_size;
+    u32 block_count;
+    u8* blocks;
+    // The index of the next free block after each free block.
+    u32* next_free;
+    // The index of the first free block in the low 32 bits, and a tag that changes
+    // with every push/pop in the high 32 bits to guard against ABA problems.
+    u64 free_head;
+} job_payload_pool;
+
+// The max number of helper jobs a parallel for submits.
+#define JOB_MAX_PARALLEL_FOR_HELPERS 32
+
+// The alignment of the job system state, in bytes. Matches the cache line size.
+#define JOB_STATE_ALIGNMENT 64
+
+// The max number of jobs which can be tracked by handle at once. Handles hold the
+// record index in the low 16 bits and the record generation in the high 16 bits.
+#define JOB_MAX_RECORDS 16384
+
+// The state of a record holds its generation in the low 16 bits, then these flags, then the priority of its job.
+#define JOB_RECORD_GENERATION_MASK 0xFFFF
+// Set once the job is queued, past any dependencies.
+#define JOB_RECORD_QUEUED 0x10000
+// Set once a thread has taken the job to run or cancel, so that any other copy of it queued is dropped.
+#define JOB_RECORD_STARTED 0x20000
+// Set once the job is asked to cancel.
+#define JOB_RECORD_CANCELLED 0x40000
+#define JOB_RECORD_PRIORITY_SHIFT 20
+#define JOB_RECORD_PRIORITY_MASK (0x3 << JOB_RECORD_PRIORITY_SHIFT)
 
 typedef struct job_system_state {
     b8 running;
     u8 thread_count;
-    job_thread job_threads[32];
+    job_thread job_threads[JOB_MAX_THREAD_COUNT];
+    // The number of threads not parked, which are always the lowest-indexed ones.
+    u8 active_thread_count;
+    // How the number of active threads is chosen.
+    job_power_policy power_policy;
+    // The time of the last load sample, in microseconds.
+    u64 load_sample_time_us;
+
+    // Used to spread jobs submitted from outside the job threads across threads.
+    u32 next_submit_index;
+    // Used to vary which thread is stolen from first when helping from outside the job threads.
+    u32 external_steal_index;
+
+    // The state of each job record, its generation incremented when its job completes.
+    u32 record_states[JOB_MAX_RECORDS];
+    // A copy of the job of each record as submitted, from which it is queued again when moved to another priority.
+    job_info* record_infos;
+    // A lock-free queue of the indices (u16) of the records not in use by an in-flight job.
+    mpmc_queue free_records;
 
-    ring_queue low_priority_queue;
-    ring_queue normal_priority_queue;
-    ring_queue high_priority_queue;
+    // A darray of jobs waiting on their dependencies to complete.
+    job_info* waiting_jobs;
+    // The number of jobs waiting (or about to wait) on dependencies.
+    u32 waiting_count;
+    // A mutex for the waiting job list.
+    kmutex dependency_mutex;
 
-    // Mutexes for each queue, since a job could be kicked off from another job (thread).
-    kmutex low_pri_queue_mutex;
-    kmutex normal_pri_queue_mutex;
-    kmutex high_pri_queue_mutex;
+    // A bounded lock-free queue of results, written by the job threads
+    // and drained in order on the main thread.
+    mpmc_queue results;
+    // The highest number of results waiting to be processed at once.
+    u32 result_high_water;
 
-    job_result_entry pending_results[MAX_JOB_RESULTS];
-    kmutex result_mutex;
-    // A mutex for the result array
+    // Pools for job parameter and result data, smallest first.
+    job_payload_pool payload_pools[2];
+
+    // Histograms of submit-to-start latency and run time, per job type.
+    u64 latency_histograms[JOB_TYPE_COUNT][JOB_HISTOGRAM_BUCKET_COUNT];
+    u64 run_time_histograms[JOB_TYPE_COUNT][JOB_HISTOGRAM_BUCKET_COUNT];
+
+    // Published counters.
+    u32 submitted_counter;
+    u32 run_counter;
+    u32 failed_counter;
+    u32 cancelled_counter;
 } job_system_state;
 
 static job_system_state* state_ptr;
 
+// The job thread running on the calling thread, if any.
+static _Thread_local job_thread* current_thread;
+// Indicates if the calling thread is the one the system was initialized on, which alone processes results.
+static _Thread_local b8 is_main_thread;
+// The fiber running on the calling thread, if any.
+static _Thread_local job_fiber* current_fiber;
+// The job running directly on the calling thread, if any. Fiber jobs are found through their fiber.
+static _Thread_local job_handle current_job_handle = INVALID_ID;
+
+static void payload_pool_create(u32 block_size, u32 block_count, void* memory, job_payload_pool* out_pool) {
+    out_pool->block_size = block_size;
+    out_pool->block_count = block_count;
+    out_pool->blocks = memory;
+    out_pool->next_free = (u32*)(out_pool->blocks + (u64)block_size * block_count);
+    for (u32 i = 0; i < block_count; ++i) {
+        out_pool->next_free[i] = i + 1 < block_count ? i + 1 : INVALID_ID;
+    }
+    out_pool->free_head = 0;
+}
+
+static u64 payload_pool_memory_requirement(u32 block_size, u32 block_count) {
+    return ((u64)block_size + sizeof(u32)) * block_count;
+}
+
+static void* payload_pool_allocate(job_payload_pool* pool) {
+    u64 head = katomic_load(&pool->free_head);
+    while (true) {
+        u32 index = (u32)head;
+        if (index == INVALID_ID) {
+            return 0;
+        }
+        // NOTE: If another thread pops this block first, next may be stale. The tag
+        // will have changed in that case, so the exchange fails and this is retried.
+        u32 next = katomic_load_relaxed(&pool->next_free[index]);
+        u64 new_head = (((head >> 32) + 1) << 32) | next;
+        if (katomic_compare_exchange(&pool->free_head, &head, new_head)) {
+            return pool->blocks + (u64)index * pool->block_size;
+        }
+    }
+}
+
+static void payload_pool_free(job_payload_pool* pool, void* block) {
+    u32 index = (u32)(((u8*)block - pool->blocks) / pool->block_size);
+    u64 head = katomic_load(&pool->free_head);
+    while (true) {
+        katomic_store_relaxed(&pool->next_free[index], (u32)head);
+        u64 new_head = (((head >> 32) + 1) << 32) | index;
+        if (katomic_compare_exchange(&pool->free_head, &head, new_head)) {
+            return;
+        }
+    }
+}
+
+/**
+ * Allocates a block for job parameter/result data from the smallest pool it fits in.
+ * Falls back to the global allocator if the data is too large or the pools are exhausted.
+ */
+static void* job_payload_allocate(u32 size) {
+    if (state_ptr) {
+        for (u32 i = 0; i < 2; ++i) {
+            job_payload_pool* pool = &state_ptr->payload_pools[i];
+            if (size <= pool->block_size) {
+                void* block = payload_pool_allocate(pool);
+                if (block) {
+                    return block;
+                }
+            }
+        }
+    }
+    return kallocate(size, MEMORY_TAG_JOB);
+}
+
+static void job_payload_free(void* block, u32 size) {
+    if (state_ptr) {
+        for (u32 i = 0; i < 2; ++i) {
+            job_payload_pool* pool = &state_ptr->payload_pools[i];
+            if ((u8*)block >= pool->blocks && (u8*)block < pool->blocks + (u64)pool->block_size * pool->block_count) {
+                payload_pool_free(pool, block);
+                return;
+            }
+        }
+    }
+    kfree(block, size, MEMORY_TAG_JOB);
+}
+
+static b8 try_enqueue_result(const job_result_entry* entry) {
+    if (!mpmc_queue_try_push(&state_ptr->results, entry)) {
+        return false;
+    }
+
+    // Track the high-water mark of results waiting to be processed.
+    u32 occupancy = mpmc_queue_length(&state_ptr->results);
+    u32 high_water = katomic_load_relaxed(&state_ptr->result_high_water);
+    while (occupancy > high_water && !katomic_compare_exchange(&state_ptr->result_high_water, &high_water, occupancy)) {
+    }
+    return true;
+}
+
+static void process_results();
+
 void store_result(pfn_job_on_complete callback, u32 param_size, void* params) {
     // Create the new entry.
     job_result_entry entry;
-    entry.id = INVALID_ID_U16;
     entry.param_size = param_size;
     entry.callback = callback;
     if (entry.param_size > 0) {
         // Take a copy, as the job is destroyed after this.
-        entry.params = kallocate(param_size, MEMORY_TAG_JOB);
+        entry.params = job_payload_allocate(param_size);
         kcopy_memory(entry.params, params, param_size);
     } else {
         entry.params = 0;
     }
 
-    // Lock, find a free space, store, unlock.
-    if (!kmutex_lock(&state_ptr->result_mutex)) {
-        KERROR("Failed to obtain mutex lock for storing a result! Result storage may be corrupted.");
+    // If the queue is full, wait for the main thread to make room rather than losing the result.
+    b8 warned = false;
+    while (!try_enqueue_result(&entry)) {
+        if (!state_ptr->running) {
+            // Shutting down, so no room will be made and the result would never be processed.
+            if (entry.params) {
+                job_payload_free(entry.params, entry.param_size);
+            }
+            return;
+        }
+        if (is_main_thread) {
+            // A job run by the main thread while it waits. Nothing else makes room, so it does so itself.
+            process_results();
+            continue;
+        }
+        if (!warned) {
+            KWARN("Job result queue is full (%u results). Waiting for results to be processed.", MAX_JOB_RESULTS);
+            warned = true;
+        }
+        platform_sleep(0);
+    }
+}
+
+static b8 thread_can_run_job(const void* value, void* context) {
+    const job_info* info = value;
+    u32 type_mask = *(u32*)context;
+    return (type_mask & info->type) != 0;
+}
+
+/**
+ * Acquires records for up to count jobs at once, writing their handles to out_handles.
+ * @returns The number of records acquired, which is less than count if records ran out.
+ */
+static u32 acquire_records(job_handle* out_handles, u32 count) {
+    u32 acquired = 0;
+    u16 index;
+    for (; acquired < count && mpmc_queue_try_pop(&state_ptr->free_records, &index); ++acquired) {
+        u32 generation = katomic_load(&state_ptr->record_states[index]) & JOB_RECORD_GENERATION_MASK;
+        out_handles[acquired] = (generation << 16) | index;
     }
-    for (u16 i = 0; i < MAX_JOB_RESULTS; ++i) {
-        if (state_ptr->pending_results[i].id == INVALID_ID_U16) {
-            state_ptr->pending_results[i] = entry;
-            state_ptr->pending_results[i].id = i;
-            break;
+    return acquired;
+}
+
+static job_handle acquire_record() {
+    job_handle handle = INVALID_ID;
+    acquire_records(&handle, 1);
+    return handle;
+}
+
+static void complete_record(job_handle handle) {
+    if (handle == INVALID_ID) {
+        return;
+    }
+    u16 index = handle & 0xFFFF;
+    // Bumping the generation marks every outstanding handle to this record as complete, and clears its flags.
+    katomic_store(&state_ptr->record_states[index], ((handle >> 16) + 1) & JOB_RECORD_GENERATION_MASK);
+    // Never fails, as the queue holds every record and this one was taken from it.
+    mpmc_queue_try_push(&state_ptr->free_records, &index);
+}
+
+/**
+ * Sets up the record of a job being submitted, keeping a copy of the job.
+ */
+static void record_open(const job_info* info) {
+    if (info->handle == INVALID_ID) {
+        return;
+    }
+    u16 index = info->handle & 0xFFFF;
+    state_ptr->record_infos[index] = *info;
+    katomic_store(&state_ptr->record_states[index], (info->handle >> 16) | ((u32)info->priority << JOB_RECORD_PRIORITY_SHIFT));
+}
+
+/**
+ * Marks the job as queued, taking on the priority it was last given, which may have been
+ * changed while it waited on its dependencies.
+ */
+static void record_queue(job_info* info) {
+    if (info->handle == INVALID_ID) {
+        return;
+    }
+    u32* record_state = &state_ptr->record_states[info->handle & 0xFFFF];
+    u32 current = katomic_load(record_state);
+    do {
+        info->priority = (job_priority)((current & JOB_RECORD_PRIORITY_MASK) >> JOB_RECORD_PRIORITY_SHIFT);
+    } while (!katomic_compare_exchange(record_state, &current, current | JOB_RECORD_QUEUED));
+}
+
+/**
+ * Takes the job to be run or dropped, so that no other copy of it is. Unless any_priority is set,
+ * only a copy queued at the priority the job was last given is taken. out_cancelled is set if the
+ * job taken was asked to cancel.
+ * @returns True if the job was taken; false if another copy of it has been, or will be.
+ */
+static b8 record_claim(const job_info* info, b8 any_priority, b8* out_cancelled) {
+    *out_cancelled = false;
+    if (info->handle == INVALID_ID) {
+        return true;
+    }
+    u32* record_state = &state_ptr->record_states[info->handle & 0xFFFF];
+    u32 current = katomic_load(record_state);
+    do {
+        if ((current & JOB_RECORD_GENERATION_MASK) != (info->handle >> 16) || (current & JOB_RECORD_STARTED)) {
+            return false;
+        }
+        if (!any_priority && ((current & JOB_RECORD_PRIORITY_MASK) >> JOB_RECORD_PRIORITY_SHIFT) != (u32)info->priority) {
+            return false;
+        }
+    } while (!katomic_compare_exchange(record_state, &current, current | JOB_RECORD_STARTED));
+    *out_cancelled = (current & JOB_RECORD_CANCELLED) != 0;
+    return true;
+}
+
+static b8 dependencies_complete(const job_info* info) {
+    for (u8 i = 0; i < info->dependency_count; ++i) {
+        if (!job_system_is_complete(info->dependencies[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Wakes a sleeping job thread which is able to run any of the given job types, other
+ * than the one provided. Used when a deque holds more work than its owner can run right away.
+ */
+static void wake_idle_thread(u32 type_mask, job_thread* exclude) {
+    // Make sure the pushed job is visible before checking who is asleep. Paired
+    // with the fence in job_thread_run between marking itself asleep and looking for work.
+    katomic_thread_fence();
+    for (u8 i = 0; i < state_ptr->thread_count; ++i) {
+        job_thread* thread = &state_ptr->job_threads[i];
+        if (thread == exclude || (thread->type_mask & type_mask) == 0 || katomic_load_relaxed(&thread->parked)) {
+            continue;
+        }
+        u32 expected = 1;
+        if (katomic_compare_exchange(&thread->sleeping, &expected, 0)) {
+            ksemaphore_signal(&thread->wake_semaphore);
+            return;
+        }
+    }
+}
+
+/**
+ * Moves jobs submitted from outside into the thread's own deques,
+ * so they can be popped locally or stolen without locking.
+ */
+static void drain_inboxes(job_thread* thread) {
+    if (!kmutex_lock(&thread->inbox_mutex)) {
+        KERROR("Failed to obtain lock on job thread inbox mutex!");
+        return;
+    }
+    for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+        ring_queue* inbox = &thread->inboxes[p];
+        while (inbox->length > 0) {
+            job_info info;
+            ring_queue_peek(inbox, &info);
+            if (!work_deque_push(&thread->deques[p], &info)) {
+                // Deque is full, leave the rest in the inbox for now.
+                break;
+            }
+            ring_queue_dequeue(inbox, &info);
         }
     }
-    if (!kmutex_unlock(&state_ptr->result_mutex)) {
-        KERROR("Failed to release mutex lock for result storage, storage may be corrupted.");
+    if (!kmutex_unlock(&thread->inbox_mutex)) {
+        KERROR("Failed to release lock on job thread inbox mutex!");
     }
 }
 
+/**
+ * Takes a job directly from another thread's inbox, if it is one of the given types.
+ * Used so that work is not held up by a busy thread that has not drained its inbox yet.
+ */
+static b8 take_from_inbox(job_thread* victim, u32 priority, u32 type_mask, job_info* out_info) {
+    ring_queue* inbox = &victim->inboxes[priority];
+    if (katomic_load_relaxed(&inbox->length) == 0) {
+        return false;
+    }
+
+    b8 found = false;
+    if (!kmutex_lock(&victim->inbox_mutex)) {
+        KERROR("Failed to obtain lock on job thread inbox mutex!");
+        return false;
+    }
+    if (inbox->length > 0) {
+        ring_queue_peek(inbox, out_info);
+        if (thread_can_run_job(out_info, &type_mask)) {
+            ring_queue_dequeue(inbox, out_info);
+            found = true;
+        }
+    }
+    if (!kmutex_unlock(&victim->inbox_mutex)) {
+        KERROR("Failed to release lock on job thread inbox mutex!");
+    }
+    return found;
+}
+
+/**
+ * Finds the next job of the given types for the given thread. Higher priorities are always checked
+ * first. The thread's own deques are checked before stealing from other threads' deques and inboxes.
+ * Thread may be 0 when called from outside the job threads, in which case only stealing is done.
+ */
+static b8 find_job(job_thread* thread, u32 type_mask, job_info* out_info) {
+    u8 thread_count = state_ptr->thread_count;
+    for (u32 p = JOB_PRIORITY_COUNT; p-- > 0;) {
+        if (thread && work_deque_pop(&thread->deques[p], out_info)) {
+            return true;
+        }
+
+        // Nothing local, try to steal. Start with a different thread each time
+        // to avoid every idle thread hammering the same one.
+        u32 start = thread ? thread->steal_index++ : katomic_fetch_add(&state_ptr->external_steal_index, 1);
+        for (u8 i = 0; i < thread_count; ++i) {
+            job_thread* victim = &state_ptr->job_threads[(start + i) % thread_count];
+            if (victim == thread) {
+                continue;
+            }
+            if (work_deque_steal(&victim->deques[p], thread_can_run_job, &type_mask, out_info)) {
+                // If there is more left, get someone else to help out.
+                if (work_deque_length(&victim->deques[p]) > 0) {
+                    wake_idle_thread(victim->type_mask, thread);
+                }
+                return true;
+            }
+        }
+        for (u8 i = 0; i < thread_count; ++i) {
+            job_thread* victim = &state_ptr->job_threads[(start + i) % thread_count];
+            if (take_from_inbox(victim, p, type_mask, out_info)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * Finds the next job in the given thread's own deques, highest priority first, without stealing.
+ * Used while the thread is parked, so that it leaves the work of others to the active threads.
+ */
+static b8 find_local_job(job_thread* thread, job_info* out_info) {
+    for (u32 p = JOB_PRIORITY_COUNT; p-- > 0;) {
+        if (work_deque_pop(&thread->deques[p], out_info)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void enqueue_job(job_info* info);
+static void release_waiting_jobs();
+
+/**
+ * Throws away a job which cannot be run, releasing its data and completing its
+ * record so that nothing waits on it forever. Does nothing if another copy of the
+ * job was already taken, as that copy owns its data.
+ */
+static void discard_job(job_info* info) {
+    b8 cancelled;
+    if (!record_claim(info, true, &cancelled)) {
+        return;
+    }
+    if (info->param_data) {
+        job_payload_free(info->param_data, info->param_data_size);
+    }
+    if (info->result_data) {
+        job_payload_free(info->result_data, info->result_data_size);
+    }
+    complete_record(info->handle);
+    release_waiting_jobs();
+}
+
+static u64 time_us() {
+    return (u64)(platform_get_absolute_time() * 1000000.0);
+}
+
+static u32 job_type_index(job_type type) {
+    switch (type) {
+        case JOB_TYPE_RESOURCE_LOAD:
+            return 1;
+        case JOB_TYPE_GPU_RESOURCE:
+            return 2;
+        case JOB_TYPE_GENERAL:
+        default:
+            return 0;
+    }
+}
+
+static void histogram_record(u64* histogram, u64 time_us) {
+    u32 bucket = 0;
+    while (time_us > 1 && bucket < JOB_HISTOGRAM_BUCKET_COUNT - 1) {
+        time_us >>= 1;
+        bucket++;
+    }
+    katomic_fetch_add(&histogram[bucket], 1);
+}
+
+/**
+ * Completes a job which was cancelled before it started, without running it. Its cancel
+ * callback, if any, is handed its parameters on the main thread.
+ */
+static void cancel_job(job_info* info) {
+    counter_add(state_ptr->cancelled_counter, 1);
+    if (info->on_cancel) {
+        store_result(info->on_cancel, info->param_data_size, info->param_data);
+    }
+    if (info->param_data) {
+        job_payload_free(info->param_data, info->param_data_size);
+    }
+    if (info->result_data) {
+        job_payload_free(info->result_data, info->result_data_size);
+    }
+    complete_record(info->handle);
+    release_waiting_jobs();
+}
+
+static void run_job(job_info* info) {
+    u32 type_index = job_type_index(info->type);
+    f64 start_time = platform_get_absolute_time();
+    histogram_record(state_ptr->latency_histograms[type_index], (u64)((start_time - info->submit_time) * 1000000.0));
+    job_thread* thread = current_thread;
+    if (thread) {
+        katomic_store_relaxed(&thread->jobs_run, thread->jobs_run + 1);
+    }
+
+    job_handle outer_handle = current_job_handle;
+    current_job_handle = info->handle;
+    b8 result = info->entry_point(info->param_data, info->result_data);
+    current_job_handle = outer_handle;
+    histogram_record(state_ptr->run_time_histograms[type_index], (u64)((platform_get_absolute_time() - start_time) * 1000000.0));
+    counter_add(state_ptr->run_counter, 1);
+    if (!result) {
+        counter_add(state_ptr->failed_counter, 1);
+    }
+
+    // Store the result to be executed on the main thread later.
+    // Note that store_result takes a copy of the result_data
+    // so it does not have to be held onto by this thread any longer.
+    if (result && info->on_success) {
+        store_result(info->on_success, info->result_data_size, info->result_data);
+    } else if (!result && info->on_fail) {
+        store_result(info->on_fail, info->result_data_size, info->result_data);
+    }
+
+    // Clear the param data and result data.
+    if (info->param_data) {
+        job_payload_free(info->param_data, info->param_data_size);
+    }
+    if (info->result_data) {
+        job_payload_free(info->result_data, info->result_data_size);
+    }
+
+    // Mark the job as complete, then kick off anything that was waiting on it.
+    complete_record(info->handle);
+    release_waiting_jobs();
+}
+
+static void job_fiber_run(void* params) {
+    job_fiber* fiber = params;
+    // Each time the fiber is switched back to after finishing, it has been handed a new job.
+    while (true) {
+        run_job(&fiber->info);
+        fiber->finished = true;
+        kfiber_switch(&fiber->fiber, &fiber->owner->thread_fiber);
+    }
+}
+
+/**
+ * Switches to the given fiber until its job finishes or yields. Must be
+ * called from the thread itself, rather than from one of its fibers.
+ */
+static void resume_fiber(job_thread* thread, job_fiber* fiber) {
+    current_fiber = fiber;
+    kfiber_switch(&thread->thread_fiber, &fiber->fiber);
+    current_fiber = 0;
+
+    u8 index = (u8)(fiber - thread->fibers);
+    if (fiber->finished) {
+        thread->free_fibers[thread->free_fiber_count++] = index;
+    } else {
+        thread->suspended_fibers[thread->suspended_fiber_count++] = index;
+    }
+}
+
+/**
+ * Starts the given job on one of the thread's fibers.
+ * @returns True if the job was started; false if no fiber is available to run it.
+ */
+static b8 start_fiber_job(job_thread* thread, job_info* info) {
+    job_fiber* fiber = 0;
+    if (thread->free_fiber_count > 0) {
+        fiber = &thread->fibers[thread->free_fibers[--thread->free_fiber_count]];
+    } else if (thread->fiber_count < JOB_FIBERS_PER_THREAD) {
+        fiber = &thread->fibers[thread->fiber_count];
+        fiber->owner = thread;
+        if (!kfiber_create(job_fiber_run, fiber, JOB_FIBER_STACK_SIZE, &fiber->fiber)) {
+            return false;
+        }
+        thread->fiber_count++;
+    } else {
+        return false;
+    }
+
+    fiber->info = *info;
+    fiber->wait_handle = INVALID_ID;
+    fiber->wait_condition = 0;
+    fiber->finished = false;
+    resume_fiber(thread, fiber);
+    return true;
+}
+
+/**
+ * Resumes each of the thread's suspended fibers whose wait is over.
+ * @returns True if any fiber was resumed; otherwise false.
+ */
+static b8 resume_ready_fibers(job_thread* thread) {
+    // Take the list as it is now, since fibers which yield again are added back to it.
+    u8 suspended_count = thread->suspended_fiber_count;
+    u8 suspended[JOB_FIBERS_PER_THREAD];
+    kcopy_memory(suspended, thread->suspended_fibers, sizeof(u8) * suspended_count);
+    thread->suspended_fiber_count = 0;
+
+    b8 resumed = false;
+    for (u8 i = 0; i < suspended_count; ++i) {
+        job_fiber* fiber = &thread->fibers[suspended[i]];
+        if (job_system_is_complete(fiber->wait_handle) && (!fiber->wait_condition || fiber->wait_condition(fiber->wait_user_data))) {
+            resume_fiber(thread, fiber);
+            resumed = true;
+        } else {
+            thread->suspended_fibers[thread->suspended_fiber_count++] = suspended[i];
+        }
+    }
+    return resumed;
+}
+
+/**
+ * Suspends the calling fiber job until the given job has completed and the given condition
+ * (if any) is met, switching back to its thread. With neither, the fiber is resumed when its
+ * thread next checks on it.
+ */
+static void suspend_fiber(job_handle wait_handle, pfn_job_wait_condition condition, void* user_data) {
+    job_fiber* fiber = current_fiber;
+    fiber->wait_handle = wait_handle;
+    fiber->wait_condition = condition;
+    fiber->wait_user_data = user_data;
+    kfiber_switch(&fiber->fiber, &fiber->owner->thread_fiber);
+}
+
+/**
+ * Runs the given job, on a fiber if it asks for one and the thread is able to provide it.
+ * Thread may be 0 when called from outside the job threads.
+ */
+static void dispatch_job(job_thread* thread, job_info* info) {
+    // Copies left behind by a move to another priority are dropped here, as are cancelled jobs.
+    b8 cancelled;
+    if (!record_claim(info, false, &cancelled)) {
+        return;
+    }
+    if (cancelled) {
+        cancel_job(info);
+        return;
+    }
+    KPROFILE_ZONE("job");
+    if (info->use_fiber && thread && thread->fibers_enabled && !current_fiber && start_fiber_job(thread, info)) {
+        return;
+    }
+    run_job(info);
+}
+
 u32 job_thread_run(void* params) {
     u32 index = *(u32*)params;
     job_thread* thread = &state_ptr->job_threads[index];
     u64 thread_id = thread->thread.thread_id;
     KTRACE("Starting job thread #%i (id=%#x, type=%#x).", thread->index, thread_id, thread->type_mask);
-
-    // A mutex to lock info for this thread.
-    if (!kmutex_create(&thread->info_mutex)) {
-        KERROR("Failed to create job thread mutex! Aborting thread.");
-        return 0;
-    }
+    current_thread = thread;
+    char profile_name[32];
+    string_format(profile_name, "Job %u", thread->index);
+    profiler_thread_name_set(profile_name);
+    thread->fibers_enabled = kfiber_create_from_thread(&thread->thread_fiber);
+    katomic_store_relaxed(&thread->start_time_us, time_us());
 
     // Run forever, waiting for jobs.
     while (true) {
@@ -96,110 +821,187 @@ u32 job_thread_run(void* params) {
             break;
         }
 
-        // Lock and grab a copy of the info
-        if (!kmutex_lock(&thread->info_mutex)) {
-            KERROR("Failed to obtain lock on job thread mutex!");
-        }
-        job_info info = thread->info;
-        if (!kmutex_unlock(&thread->info_mutex)) {
-            KERROR("Failed to release lock on job thread mutex!");
-        }
+        drain_inboxes(thread);
 
-        if (info.entry_point) {
-            b8 result = info.entry_point(info.param_data, info.result_data);
+        // Carry on with fiber jobs which are done waiting before starting anything new.
+        u64 busy_start = time_us();
+        b8 resumed = thread->suspended_fiber_count > 0 && resume_ready_fibers(thread);
 
-            // Store the result to be executed on the main thread later.
-            // Note that store_result takes a copy of the result_data
-            // so it does not have to be held onto by this thread any longer.
-            if (result && info.on_success) {
-                store_result(info.on_success, info.result_data_size, info.result_data);
-            } else if (!result && info.on_fail) {
-                store_result(info.on_fail, info.result_data_size, info.result_data);
+        job_info info;
+        b8 parked = katomic_load_relaxed(&thread->parked);
+        if (parked ? find_local_job(thread, &info) : find_job(thread, thread->type_mask, &info)) {
+            // Let other threads steal whatever else is waiting here.
+            for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+                if (work_deque_length(&thread->deques[p]) > 0) {
+                    wake_idle_thread(thread->type_mask, thread);
+                    break;
+                }
             }
+            dispatch_job(thread, &info);
+            katomic_store_relaxed(&thread->busy_time_us, thread->busy_time_us + (time_us() - busy_start));
+            continue;
+        }
+        if (resumed) {
+            katomic_store_relaxed(&thread->busy_time_us, thread->busy_time_us + (time_us() - busy_start));
+            continue;
+        }
 
-            // Clear the param data and result data.
-            if (info.param_data) {
-                kfree(info.param_data, info.param_data_size, MEMORY_TAG_JOB);
-            }
-            if (info.result_data) {
-                kfree(info.result_data, info.result_data_size, MEMORY_TAG_JOB);
+        if (parked) {
+            // Parked threads never announce that they are asleep, so are only woken for jobs handed
+            // to them directly (or to be unparked). Those always signal, so none can be missed.
+            if (!state_ptr->running) {
+                break;
             }
+            ksemaphore_wait(&thread->wake_semaphore, thread->suspended_fiber_count > 0 ? JOB_FIBER_POLL_MS : KSEMAPHORE_WAIT_INFINITE);
+            continue;
+        }
 
-            // Lock and reset the thread's info object
-            if (!kmutex_lock(&thread->info_mutex)) {
-                KERROR("Failed to obtain lock on job thread mutex!");
-            }
-            kzero_memory(&thread->info, sizeof(job_info));
-            if (!kmutex_unlock(&thread->info_mutex)) {
-                KERROR("Failed to release lock on job thread mutex!");
-            }
+        // Nothing to do. Announce that this thread is going to sleep, then look once more
+        // in case a job was pushed before the announcement could be seen.
+        katomic_store(&thread->sleeping, 1);
+        katomic_thread_fence();
+        if (find_job(thread, thread->type_mask, &info)) {
+            katomic_store(&thread->sleeping, 0);
+            busy_start = time_us();
+            dispatch_job(thread, &info);
+            katomic_store_relaxed(&thread->busy_time_us, thread->busy_time_us + (time_us() - busy_start));
+            continue;
         }
 
-        if (state_ptr->running) {
-            // TODO: Should probably find a better way to do this, such as sleeping until
-            // a request comes through for a new job.
-            kthread_sleep(&thread->thread, 10);
-        } else {
+        if (!state_ptr->running) {
             break;
         }
+
+        // Sleep until work is submitted (or the system is shut down). Suspended fiber
+        // jobs are not signalled when their wait is over, so check on them regularly.
+        ksemaphore_wait(&thread->wake_semaphore, thread->suspended_fiber_count > 0 ? JOB_FIBER_POLL_MS : KSEMAPHORE_WAIT_INFINITE);
+        katomic_store(&thread->sleeping, 0);
     }
 
-    // Destroy the mutex for this thread.
-    kmutex_destroy(&thread->info_mutex);
+    if (thread->suspended_fiber_count > 0) {
+        KWARN("Job thread #%i shutting down with %u suspended fiber jobs, which will not be completed.", thread->index, thread->suspended_fiber_count);
+    }
+    // Fibers are destroyed here, as the thread fiber must be destroyed on its own thread.
+    for (u8 i = 0; i < thread->fiber_count; ++i) {
+        kfiber_destroy(&thread->fibers[i].fiber);
+    }
+    thread->fiber_count = 0;
+    if (thread->fibers_enabled) {
+        kfiber_destroy(&thread->thread_fiber);
+        thread->fibers_enabled = false;
+    }
+
+    // Hand back any memory cached by this thread, as it is about to exit.
+    kmemory_thread_cache_flush();
+    scratch_allocator_release();
+
+    current_thread = 0;
+    katomic_store(&thread->exited, 1);
     return 1;
 }
 
-b8 job_system_initialize(u64* job_system_memory_requirement, void* state, u8 job_thread_count, u32 type_masks[]) {
-    *job_system_memory_requirement = sizeof(job_system_state);
+b8 job_system_initialize(u64* job_system_memory_requirement, void* state, u8 job_thread_count, u32 type_masks[], u64 affinity_masks[]) {
+    // Block of memory will contain state structure, then the small payload pool, then the large payload pool,
+    // then the result queue, then the free record queue, then the copy of the job of each record.
+    // NOTE: Extra space is required so the state can be aligned to a cache line. Much of it is accessed
+    // atomically, and atomics which straddle cache lines are extremely slow.
+    u64 struct_requirement = sizeof(job_system_state);
+    u64 small_pool_requirement = payload_pool_memory_requirement(JOB_PAYLOAD_SMALL_BLOCK_SIZE, JOB_PAYLOAD_SMALL_BLOCK_COUNT);
+    u64 large_pool_requirement = payload_pool_memory_requirement(JOB_PAYLOAD_LARGE_BLOCK_SIZE, JOB_PAYLOAD_LARGE_BLOCK_COUNT);
+    u64 results_requirement = mpmc_queue_memory_requirement(sizeof(job_result_entry), MAX_JOB_RESULTS);
+    u64 records_requirement = mpmc_queue_memory_requirement(sizeof(u16), JOB_MAX_RECORDS);
+    u64 record_infos_requirement = sizeof(job_info) * JOB_MAX_RECORDS;
+    *job_system_memory_requirement = JOB_STATE_ALIGNMENT + struct_requirement + small_pool_requirement + large_pool_requirement + results_requirement + records_requirement + record_infos_requirement;
     if (state == 0) {
         return true;
     }
+    if (job_thread_count > JOB_MAX_THREAD_COUNT) {
+        KERROR("job_system_initialize - job_thread_count (%u) exceeds the max of %u.", job_thread_count, JOB_MAX_THREAD_COUNT);
+        return false;
+    }
 
-    kzero_memory(state, sizeof(job_system_state));
+    state_ptr = (job_system_state*)get_aligned((u64)state, JOB_STATE_ALIGNMENT);
+    kzero_memory(state_ptr, sizeof(job_system_state));
 
-    state_ptr = state;
+    // The pool and queue blocks are after the state. Already allocated, so just set the pointers.
+    void* small_pool_block = (void*)state_ptr + struct_requirement;
+    void* large_pool_block = small_pool_block + small_pool_requirement;
+    void* results_block = large_pool_block + large_pool_requirement;
+    void* records_block = results_block + results_requirement;
+    state_ptr->record_infos = records_block + records_requirement;
+    payload_pool_create(JOB_PAYLOAD_SMALL_BLOCK_SIZE, JOB_PAYLOAD_SMALL_BLOCK_COUNT, small_pool_block, &state_ptr->payload_pools[0]);
+    payload_pool_create(JOB_PAYLOAD_LARGE_BLOCK_SIZE, JOB_PAYLOAD_LARGE_BLOCK_COUNT, large_pool_block, &state_ptr->payload_pools[1]);
+    if (!mpmc_queue_create(sizeof(job_result_entry), MAX_JOB_RESULTS, results_block, &state_ptr->results) ||
+        !mpmc_queue_create(sizeof(u16), JOB_MAX_RECORDS, records_block, &state_ptr->free_records)) {
+        KERROR("Failed to create job system queues.");
+        return false;
+    }
     state_ptr->running = true;
-
-    ring_queue_create(sizeof(job_info), 1024, 0, &state_ptr->low_priority_queue);
-    ring_queue_create(sizeof(job_info), 1024, 0, &state_ptr->normal_priority_queue);
-    ring_queue_create(sizeof(job_info), 1024, 0, &state_ptr->high_priority_queue);
+    is_main_thread = true;
     state_ptr->thread_count = job_thread_count;
+    state_ptr->active_thread_count = job_thread_count;
+    state_ptr->power_policy = JOB_POWER_POLICY_PERFORMANCE;
+    state_ptr->submitted_counter = counter_register("jobs.submitted", COUNTER_TYPE_COUNTER);
+    state_ptr->run_counter = counter_register("jobs.run", COUNTER_TYPE_COUNTER);
+    state_ptr->failed_counter = counter_register("jobs.failed", COUNTER_TYPE_COUNTER);
+    state_ptr->cancelled_counter = counter_register("jobs.cancelled", COUNTER_TYPE_COUNTER);
 
-    // Invalidate all result slots
-    for (u16 i = 0; i < MAX_JOB_RESULTS; ++i) {
-        state_ptr->pending_results[i].id = INVALID_ID_U16;
+    KDEBUG("Main thread id is: %#x", get_thread_id());
+
+    // All job records start out free.
+    for (u32 i = 0; i < JOB_MAX_RECORDS; ++i) {
+        u16 index = (u16)i;
+        mpmc_queue_try_push(&state_ptr->free_records, &index);
     }
+    state_ptr->waiting_jobs = darray_create(job_info);
 
-    KDEBUG("Main thread id is: %#x", get_thread_id());
+    // Create needed mutexes
+    if (!kmutex_create(&state_ptr->dependency_mutex)) {
+        KERROR("Failed to create job dependency mutex!.");
+        return false;
+    }
+
+    // Create all thread data before any thread starts, since threads steal from one another.
+    for (u8 i = 0; i < state_ptr->thread_count; ++i) {
+        job_thread* thread = &state_ptr->job_threads[i];
+        thread->index = i;
+        thread->type_mask = type_masks[i];
+        thread->steal_index = i + 1;
+        for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+            if (!work_deque_create(sizeof(job_info), JOB_DEQUE_CAPACITY, 0, &thread->deques[p])) {
+                KERROR("Failed to create job thread deque!");
+                return false;
+            }
+            if (!ring_queue_create(sizeof(job_info), JOB_INBOX_CAPACITY, 0, &thread->inboxes[p])) {
+                KERROR("Failed to create job thread inbox!");
+                return false;
+            }
+        }
+        if (!kmutex_create(&thread->inbox_mutex)) {
+            KERROR("Failed to create job thread inbox mutex!");
+            return false;
+        }
+        if (!ksemaphore_create(&thread->wake_semaphore, 65535, 0)) {
+            KERROR("Failed to create job thread semaphore!");
+            return false;
+        }
+    }
 
     KDEBUG("Spawning %i job threads.", state_ptr->thread_count);
 
     for (u8 i = 0; i < state_ptr->thread_count; ++i) {
-        state_ptr->job_threads[i].index = i;
-        state_ptr->job_threads[i].type_mask = type_masks[i];
-        if (!kthread_create(job_thread_run, &state_ptr->job_threads[i].index, false, &state_ptr->job_threads[i].thread)) {
+        job_thread* thread = &state_ptr->job_threads[i];
+        if (!kthread_create(job_thread_run, &thread->index, false, &thread->thread)) {
             KFATAL("OS Error in creating job thread. Application cannot continue.");
             return false;
         }
-        kzero_memory(&state_ptr->job_threads[i].info, sizeof(job_info));
-    }
-
-    // Create needed mutexes
-    if (!kmutex_create(&state_ptr->result_mutex)) {
-        KERROR("Failed to create result mutex!.");
-        return false;
-    }
-    if (!kmutex_create(&state_ptr->low_pri_queue_mutex)) {
-        KERROR("Failed to create low priority queue mutex!.");
-        return false;
-    }
-    if (!kmutex_create(&state_ptr->normal_pri_queue_mutex)) {
-        KERROR("Failed to create normal priority queue mutex!.");
-        return false;
-    }
-    if (!kmutex_create(&state_ptr->high_pri_queue_mutex)) {
-        KERROR("Failed to create high priority queue mutex!.");
-        return false;
+        if (affinity_masks && affinity_masks[i]) {
+            if (kthread_set_affinity(&thread->thread, affinity_masks[i])) {
+                KDEBUG("Job thread #%i pinned to processors %#llx.", i, affinity_masks[i]);
+            } else {
+                KWARN("Unable to pin job thread #%i to processors %#llx. It will run unpinned.", i, affinity_masks[i]);
+            }
+        }
     }
 
     return true;
@@ -208,169 +1010,686 @@ b8 job_system_initialize(u64* job_system_memory_requirement, void* state, u8 job
 void job_system_shutdown(void* state) {
     if (state_ptr) {
         state_ptr->running = false;
+        is_main_thread = false;
 
         u64 thread_count = state_ptr->thread_count;
 
-        // Check for a free thread first.
+        // Wake any sleeping threads so they can see the system is no longer running.
+        for (u8 i = 0; i < thread_count; ++i) {
+            ksemaphore_signal(&state_ptr->job_threads[i].wake_semaphore);
+        }
+        // Let each thread finish the job it is on and clean up after itself before anything is torn
+        // down under it. Only a thread stuck in a job is cancelled without doing so.
+        f64 deadline = platform_get_absolute_time() + JOB_SHUTDOWN_TIMEOUT_MS / 1000.0;
+        for (u8 i = 0; i < thread_count; ++i) {
+            job_thread* thread = &state_ptr->job_threads[i];
+            while (!katomic_load(&thread->exited) && platform_get_absolute_time() < deadline) {
+                platform_sleep(0);
+            }
+            if (!katomic_load(&thread->exited)) {
+                KWARN("Job thread #%i did not finish its job within %ums of shutting down, and will be cancelled.", i, JOB_SHUTDOWN_TIMEOUT_MS);
+            }
+        }
         for (u8 i = 0; i < thread_count; ++i) {
             kthread_destroy(&state_ptr->job_threads[i].thread);
         }
-        ring_queue_destroy(&state_ptr->low_priority_queue);
-        ring_queue_destroy(&state_ptr->normal_priority_queue);
-        ring_queue_destroy(&state_ptr->high_priority_queue);
+        for (u8 i = 0; i < thread_count; ++i) {
+            job_thread* thread = &state_ptr->job_threads[i];
+            for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+                work_deque_destroy(&thread->deques[p]);
+                ring_queue_destroy(&thread->inboxes[p]);
+            }
+            kmutex_destroy(&thread->inbox_mutex);
+            ksemaphore_destroy(&thread->wake_semaphore);
+        }
+
+        if (state_ptr->waiting_count > 0) {
+            KWARN("Job system shutting down with %u jobs still waiting on dependencies.", state_ptr->waiting_count);
+        }
+        darray_destroy(state_ptr->waiting_jobs);
+        state_ptr->waiting_jobs = 0;
+
+        mpmc_queue_destroy(&state_ptr->results);
+        mpmc_queue_destroy(&state_ptr->free_records);
 
         // Destroy mutexes
-        kmutex_destroy(&state_ptr->result_mutex);
-        kmutex_destroy(&state_ptr->low_pri_queue_mutex);
-        kmutex_destroy(&state_ptr->normal_pri_queue_mutex);
-        kmutex_destroy(&state_ptr->high_pri_queue_mutex);
+        kmutex_destroy(&state_ptr->dependency_mutex);
 
         state_ptr = 0;
     }
 }
 
-void process_queue(ring_queue* queue, kmutex* queue_mutex) {
-    u64 thread_count = state_ptr->thread_count;
+static void process_results() {
+    // Process pending results in the order they were stored. Only process as many as the queue
+    // holds, so callbacks which kick off quick jobs cannot keep this going forever.
+    job_result_entry entry;
+    for (u32 i = 0; i < MAX_JOB_RESULTS && mpmc_queue_try_pop(&state_ptr->results, &entry); ++i) {
+        // Execute the callback.
+        entry.callback(entry.params);
 
-    // Check for a free thread first.
-    while (queue->length > 0) {
-        job_info info;
-        if (!ring_queue_peek(queue, &info)) {
-            break;
+        if (entry.params) {
+            job_payload_free(entry.params, entry.param_size);
         }
+    }
+}
 
-        b8 thread_found = false;
-        for (u8 i = 0; i < thread_count; ++i) {
+/**
+ * Parks every thread from the given count on, and unparks the rest, waking those unparked so they
+ * announce themselves as idle again.
+ */
+static void active_threads_set(u8 count) {
+    state_ptr->active_thread_count = count;
+    for (u8 i = 0; i < state_ptr->thread_count; ++i) {
+        job_thread* thread = &state_ptr->job_threads[i];
+        u32 parked = i >= count;
+        if (katomic_exchange(&thread->parked, parked) && !parked) {
+            ksemaphore_signal(&thread->wake_semaphore);
+        }
+    }
+}
+
+/**
+ * Samples how busy the active threads have been since the last sample, unparking a thread if
+ * they were mostly busy, or parking one if they were mostly idle.
+ */
+static void load_balance() {
+    u64 now = time_us();
+    u64 elapsed = now - state_ptr->load_sample_time_us;
+    if (elapsed < JOB_LOAD_SAMPLE_US) {
+        return;
+    }
+    state_ptr->load_sample_time_us = now;
+
+    u64 busy = 0;
+    for (u8 i = 0; i < state_ptr->thread_count; ++i) {
+        job_thread* thread = &state_ptr->job_threads[i];
+        u64 busy_time = katomic_load_relaxed(&thread->busy_time_us);
+        if (i < state_ptr->active_thread_count) {
+            busy += busy_time - thread->sampled_busy_time_us;
+        }
+        thread->sampled_busy_time_us = busy_time;
+    }
+
+    f64 load = (f64)busy / ((f64)elapsed * state_ptr->active_thread_count);
+    if (load > JOB_LOAD_HIGH && state_ptr->active_thread_count < state_ptr->thread_count) {
+        active_threads_set(state_ptr->active_thread_count + 1);
+    } else if (load < JOB_LOAD_LOW && state_ptr->active_thread_count > 1) {
+        active_threads_set(state_ptr->active_thread_count - 1);
+    }
+}
+
+void job_system_update() {
+    if (!state_ptr || !state_ptr->running) {
+        return;
+    }
+
+    if (state_ptr->power_policy == JOB_POWER_POLICY_BATTERY && state_ptr->thread_count > 0) {
+        load_balance();
+    }
+
+    process_results();
+}
+
+void job_system_power_policy_set(job_power_policy policy) {
+    if (!state_ptr) {
+        return;
+    }
+    state_ptr->power_policy = policy;
+    if (policy == JOB_POWER_POLICY_PERFORMANCE) {
+        active_threads_set(state_ptr->thread_count);
+    } else {
+        // Start the samples afresh, so what ran before is not counted toward the first.
+        state_ptr->load_sample_time_us = time_us();
+        for (u8 i = 0; i < state_ptr->thread_count; ++i) {
             job_thread* thread = &state_ptr->job_threads[i];
-            if ((thread->type_mask & info.type) == 0) {
-                continue;
+            thread->sampled_busy_time_us = katomic_load_relaxed(&thread->busy_time_us);
+        }
+    }
+}
+
+job_power_policy job_system_power_policy_get() {
+    return state_ptr ? state_ptr->power_policy : JOB_POWER_POLICY_PERFORMANCE;
+}
+
+void job_system_active_thread_count_set(u8 count) {
+    if (!state_ptr || state_ptr->thread_count == 0) {
+        return;
+    }
+    active_threads_set(KCLAMP(count, 1, state_ptr->thread_count));
+}
+
+u8 job_system_active_thread_count_get() {
+    return state_ptr ? state_ptr->active_thread_count : 0;
+}
+
+u32 job_system_result_queue_high_water() {
+    return state_ptr ? katomic_load_relaxed(&state_ptr->result_high_water) : 0;
+}
+
+void job_system_stats_get(job_system_stats* out_stats) {
+    if (!out_stats) {
+        return;
+    }
+    kzero_memory(out_stats, sizeof(job_system_stats));
+    if (!state_ptr) {
+        return;
+    }
+
+    u64 now = time_us();
+    out_stats->thread_count = state_ptr->thread_count;
+    for (u8 i = 0; i < state_ptr->thread_count; ++i) {
+        job_thread* thread = &state_ptr->job_threads[i];
+        job_thread_stats* thread_stats = &out_stats->threads[i];
+        thread_stats->type_mask = thread->type_mask;
+        u64 start_time = katomic_load_relaxed(&thread->start_time_us);
+        thread_stats->elapsed_time_us = start_time && now > start_time ? now - start_time : 0;
+        thread_stats->busy_time_us = katomic_load_relaxed(&thread->busy_time_us);
+        thread_stats->jobs_run = katomic_load_relaxed(&thread->jobs_run);
+        thread_stats->parked = katomic_load_relaxed(&thread->parked) != 0;
+
+        for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+            out_stats->queue_depths[p] += work_deque_length(&thread->deques[p]);
+            out_stats->queue_depths[p] += katomic_load_relaxed(&thread->inboxes[p].length);
+        }
+    }
+
+    out_stats->waiting_count = katomic_load_relaxed(&state_ptr->waiting_count);
+    out_stats->pending_result_count = mpmc_queue_length(&state_ptr->results);
+    for (u32 t = 0; t < JOB_TYPE_COUNT; ++t) {
+        for (u32 b = 0; b < JOB_HISTOGRAM_BUCKET_COUNT; ++b) {
+            out_stats->latency_histograms[t][b] = katomic_load_relaxed(&state_ptr->latency_histograms[t][b]);
+            out_stats->run_time_histograms[t][b] = katomic_load_relaxed(&state_ptr->run_time_histograms[t][b]);
+        }
+    }
+}
+
+/**
+ * Picks a thread to hand a job of the given type to, preferring one that is asleep.
+ * A sleeping thread is claimed (marked awake), so must be signalled once the job is queued.
+ * Parked threads are only picked when no active thread can run the job type.
+ * @returns The thread to queue the job on, or 0 if no thread can run the job type.
+ */
+static job_thread* select_target_thread(job_type type) {
+    u8 thread_count = state_ptr->thread_count;
+    job_thread* target = 0;
+    job_thread* parked = 0;
+    u32 start = katomic_fetch_add(&state_ptr->next_submit_index, 1);
+    for (u8 i = 0; i < thread_count; ++i) {
+        job_thread* thread = &state_ptr->job_threads[(start + i) % thread_count];
+        if ((thread->type_mask & type) == 0) {
+            continue;
+        }
+        if (katomic_load_relaxed(&thread->parked)) {
+            if (!parked) {
+                parked = thread;
             }
+            continue;
+        }
+        if (!target) {
+            target = thread;
+        }
+        // Claim a sleeping thread, so the next submission goes to another one.
+        u32 expected = 1;
+        if (katomic_compare_exchange(&thread->sleeping, &expected, 0)) {
+            target = thread;
+            break;
+        }
+    }
+    return target ? target : parked;
+}
+
+/**
+ * Adds the job to the thread's inbox for its priority, growing the inbox if it is full.
+ * The thread's inbox mutex must be held.
+ */
+static b8 inbox_push(job_thread* thread, job_info* info) {
+    ring_queue* inbox = &thread->inboxes[info->priority];
+    if (inbox->length == inbox->capacity) {
+        KDEBUG("Job thread %u inbox is full, growing it from %u to %u jobs.", thread->index, inbox->capacity, inbox->capacity * 2);
+        if (!ring_queue_resize(inbox, inbox->capacity * 2)) {
+            return false;
+        }
+    }
+    return ring_queue_enqueue(inbox, info);
+}
+
+static void enqueue_job(job_info* info) {
+    // If submitted from a job thread that can run the job, keep it local. Other idle
+    // threads will steal it if this thread is busy for long enough.
+    job_thread* local = current_thread;
+    if (local && (local->type_mask & info->type)) {
+        if (work_deque_push(&local->deques[info->priority], info)) {
+            wake_idle_thread(info->type, local);
+            return;
+        }
+    }
+
+    // Otherwise hand it to a thread that can run it.
+    job_thread* target = select_target_thread(info->type);
+    if (!target) {
+        KERROR("No job thread can handle job type %#x. Job will not be run.", info->type);
+        discard_job(info);
+        return;
+    }
+
+    // NOTE: Locking here in case the job is submitted from another job/thread.
+    if (!kmutex_lock(&target->inbox_mutex)) {
+        KERROR("Failed to obtain lock on job thread inbox mutex!");
+    }
+    b8 queued = inbox_push(target, info);
+    if (!kmutex_unlock(&target->inbox_mutex)) {
+        KERROR("Failed to release lock on job thread inbox mutex!");
+    }
+    if (!queued) {
+        KERROR("Unable to queue job on thread %u. Job will not be run.", target->index);
+        discard_job(info);
+        return;
+    }
+    KTRACE("Job queued on thread %u.", target->index);
+
+    // Wake the thread right away rather than waiting for it to look for work.
+    ksemaphore_signal(&target->wake_semaphore);
+}
 
-            // Check that the job thread can handle the job type.
-            if (!kmutex_lock(&thread->info_mutex)) {
-                KERROR("Failed to obtain lock on job thread mutex!");
+/**
+ * Holds the job back if any of its dependencies are incomplete.
+ * @returns True if the job was deferred; false if it can run right away.
+ */
+static b8 defer_job(job_info* info) {
+    // NOTE: Announce the waiting job before checking its dependencies. A job completing in the
+    // meantime will then either be seen as complete here, or will see the waiting job and release it.
+    katomic_fetch_add(&state_ptr->waiting_count, 1);
+    if (!kmutex_lock(&state_ptr->dependency_mutex)) {
+        KERROR("Failed to obtain lock on job dependency mutex!");
+    }
+    b8 deferred = !dependencies_complete(info);
+    if (deferred) {
+        darray_push(state_ptr->waiting_jobs, *info);
+    }
+    if (!kmutex_unlock(&state_ptr->dependency_mutex)) {
+        KERROR("Failed to release lock on job dependency mutex!");
+    }
+    if (!deferred) {
+        katomic_fetch_sub(&state_ptr->waiting_count, 1);
+    }
+    return deferred;
+}
+
+/**
+ * Queues any waiting jobs whose dependencies have all completed.
+ */
+static void release_waiting_jobs() {
+    // NOTE: Ready jobs are only taken off the waiting list while it is locked, and queued once it
+    // is unlocked. Queueing a job may discard it, which completes its record and releases in turn.
+    job_info ready[JOB_RELEASE_CHUNK_SIZE];
+    u32 ready_count;
+    do {
+        if (katomic_load(&state_ptr->waiting_count) == 0) {
+            return;
+        }
+
+        if (!kmutex_lock(&state_ptr->dependency_mutex)) {
+            KERROR("Failed to obtain lock on job dependency mutex!");
+        }
+        ready_count = 0;
+        u64 i = 0;
+        while (i < darray_length(state_ptr->waiting_jobs) && ready_count < JOB_RELEASE_CHUNK_SIZE) {
+            if (dependencies_complete(&state_ptr->waiting_jobs[i])) {
+                // Waiting jobs are unordered, so the hole can be filled from the end.
+                darray_swap_remove(state_ptr->waiting_jobs, i, &ready[ready_count]);
+                ready_count++;
+                katomic_fetch_sub(&state_ptr->waiting_count, 1);
+            } else {
+                ++i;
+            }
+        }
+        if (!kmutex_unlock(&state_ptr->dependency_mutex)) {
+            KERROR("Failed to release lock on job dependency mutex!");
+        }
+
+        for (u32 r = 0; r < ready_count; ++r) {
+            record_queue(&ready[r]);
+            enqueue_job(&ready[r]);
+        }
+        // A full chunk may have left more ready jobs behind.
+    } while (ready_count == JOB_RELEASE_CHUNK_SIZE);
+}
+
+job_handle job_system_submit(job_info info) {
+    counter_add(state_ptr->submitted_counter, 1);
+    info.submit_time = platform_get_absolute_time();
+    info.handle = acquire_record();
+    if (info.handle == INVALID_ID) {
+        KWARN("Out of job records; the submitted job cannot be waited on.");
+    }
+    job_handle handle = info.handle;
+    record_open(&info);
+
+    if (info.dependency_count == 0 || !defer_job(&info)) {
+        record_queue(&info);
+        enqueue_job(&info);
+    }
+    return handle;
+}
+
+void job_system_submit_batch(job_info* infos, u32 count, job_handle* out_handles) {
+    if (!infos || count == 0) {
+        return;
+    }
+
+    counter_add(state_ptr->submitted_counter, count);
+    f64 submit_time = platform_get_absolute_time();
+    job_thread* local = current_thread;
+    u8 thread_count = state_ptr->thread_count;
+
+    // Jobs are handed over in chunks, so where each one is going can be tracked on the stack.
+    for (u32 base = 0; base < count; base += JOB_BATCH_CHUNK_SIZE) {
+        u32 chunk_count = KMIN(JOB_BATCH_CHUNK_SIZE, count - base);
+        job_info* chunk = infos + base;
+
+        job_handle handles[JOB_BATCH_CHUNK_SIZE];
+        u32 acquired = acquire_records(handles, chunk_count);
+        if (acquired < chunk_count) {
+            KWARN("Out of job records; %u submitted jobs cannot be waited on.", chunk_count - acquired);
+        }
+
+        // Work out where each job goes. Jobs which cannot go anywhere are discarded afterward,
+        // as discarding may queue other jobs, and so must not happen while an inbox is locked.
+        job_thread* targets[JOB_BATCH_CHUNK_SIZE];
+        b8 discard[JOB_BATCH_CHUNK_SIZE];
+        b8 pushed_local = false;
+        for (u32 i = 0; i < chunk_count; ++i) {
+            job_info* info = &chunk[i];
+            info->submit_time = submit_time;
+            info->handle = i < acquired ? handles[i] : INVALID_ID;
+            if (out_handles) {
+                out_handles[base + i] = info->handle;
+            }
+            targets[i] = 0;
+            discard[i] = false;
+            record_open(info);
+
+            if (info->dependency_count > 0 && defer_job(info)) {
+                continue;
+            }
+            record_queue(info);
+            // Keep jobs local where possible, as with job_system_submit.
+            if (local && (local->type_mask & info->type) && work_deque_push(&local->deques[info->priority], info)) {
+                pushed_local = true;
+                continue;
+            }
+            targets[i] = select_target_thread(info->type);
+            if (!targets[i]) {
+                KERROR("No job thread can handle job type %#x. Job will not be run.", info->type);
+                discard[i] = true;
             }
-            if (!thread->info.entry_point) {
-                // Make sure to remove the entry from the queue.
-                if (!kmutex_lock(queue_mutex)) {
-                    KERROR("Failed to obtain lock on queue mutex!");
+        }
+        if (pushed_local) {
+            wake_idle_thread(local->type_mask, local);
+        }
+
+        // Hand the rest over, locking each thread's inbox once.
+        for (u8 t = 0; t < thread_count; ++t) {
+            job_thread* thread = &state_ptr->job_threads[t];
+            b8 locked = false;
+            b8 queued = false;
+            for (u32 i = 0; i < chunk_count; ++i) {
+                if (targets[i] != thread) {
+                    continue;
+                }
+                if (!locked) {
+                    if (!kmutex_lock(&thread->inbox_mutex)) {
+                        KERROR("Failed to obtain lock on job thread inbox mutex!");
+                    }
+                    locked = true;
                 }
-                ring_queue_dequeue(queue, &info);
-                if (!kmutex_unlock(queue_mutex)) {
-                    KERROR("Failed to release lock on queue mutex!");
+                if (inbox_push(thread, &chunk[i])) {
+                    queued = true;
+                } else {
+                    KERROR("Unable to queue job on thread %u. Job will not be run.", thread->index);
+                    discard[i] = true;
                 }
-                thread->info = info;
-                KTRACE("Assigning job to thread: %u", thread->index);
-                thread_found = true;
             }
-            if (!kmutex_unlock(&thread->info_mutex)) {
-                KERROR("Failed to release lock on job thread mutex!");
+            if (locked) {
+                if (!kmutex_unlock(&thread->inbox_mutex)) {
+                    KERROR("Failed to release lock on job thread inbox mutex!");
+                }
+            }
+            if (queued) {
+                ksemaphore_signal(&thread->wake_semaphore);
             }
+        }
 
-            // Break after unlocking if an available thread was found.
-            if (thread_found) {
-                break;
+        for (u32 i = 0; i < chunk_count; ++i) {
+            if (discard[i]) {
+                discard_job(&chunk[i]);
             }
         }
+    }
+}
 
-        // This means all of the threads are currently handling a job,
-        // So wait until the next update and try again.
-        if (!thread_found) {
-            break;
+b8 job_system_is_complete(job_handle handle) {
+    if (handle == INVALID_ID || !state_ptr) {
+        return true;
+    }
+    u32 generation = katomic_load(&state_ptr->record_states[handle & 0xFFFF]) & JOB_RECORD_GENERATION_MASK;
+    return generation != (handle >> 16);
+}
+
+b8 job_system_cancel(job_handle handle) {
+    if (handle == INVALID_ID || !state_ptr) {
+        return false;
+    }
+    u32* record_state = &state_ptr->record_states[handle & 0xFFFF];
+    u32 current = katomic_load(record_state);
+    do {
+        if ((current & JOB_RECORD_GENERATION_MASK) != (handle >> 16)) {
+            // Already complete.
+            return false;
         }
+    } while (!katomic_compare_exchange(record_state, &current, current | JOB_RECORD_CANCELLED));
+    return (current & JOB_RECORD_STARTED) == 0;
+}
+
+b8 job_system_cancel_requested() {
+    if (!state_ptr) {
+        return false;
+    }
+    job_handle handle = current_fiber ? current_fiber->info.handle : current_job_handle;
+    if (handle == INVALID_ID) {
+        return false;
     }
+    u32 current = katomic_load_relaxed(&state_ptr->record_states[handle & 0xFFFF]);
+    return (current & JOB_RECORD_GENERATION_MASK) == (handle >> 16) && (current & JOB_RECORD_CANCELLED);
 }
 
-void job_system_update() {
-    if (!state_ptr || !state_ptr->running) {
+b8 job_system_priority_set(job_handle handle, job_priority priority) {
+    if (handle == INVALID_ID || !state_ptr) {
+        return false;
+    }
+    u16 index = handle & 0xFFFF;
+    u32* record_state = &state_ptr->record_states[index];
+    u32 current = katomic_load(record_state);
+    job_info info;
+    do {
+        if ((current & JOB_RECORD_GENERATION_MASK) != (handle >> 16) || (current & (JOB_RECORD_STARTED | JOB_RECORD_CANCELLED))) {
+            return false;
+        }
+        if (((current & JOB_RECORD_PRIORITY_MASK) >> JOB_RECORD_PRIORITY_SHIFT) == (u32)priority) {
+            return true;
+        }
+        // NOTE: Copied before the exchange, which fails if the record completes and is taken by another job meanwhile.
+        if (current & JOB_RECORD_QUEUED) {
+            info = state_ptr->record_infos[index];
+        }
+    } while (!katomic_compare_exchange(record_state, &current, (current & ~JOB_RECORD_PRIORITY_MASK) | ((u32)priority << JOB_RECORD_PRIORITY_SHIFT)));
+
+    // A job still waiting on its dependencies is queued at its new priority once they complete. One already
+    // queued is queued again; whichever copy is found first at the priority last given is run, and the rest dropped.
+    if (current & JOB_RECORD_QUEUED) {
+        info.priority = priority;
+        enqueue_job(&info);
+    }
+    return true;
+}
+
+/**
+ * Does a single unit of useful work on behalf of a waiting thread, or yields if there is none.
+ */
+static void help_while_waiting() {
+    if (current_fiber) {
+        // Fiber jobs let their thread get on with other work instead.
+        suspend_fiber(INVALID_ID, 0, 0);
         return;
     }
 
-    process_queue(&state_ptr->high_priority_queue, &state_ptr->high_pri_queue_mutex);
-    process_queue(&state_ptr->normal_priority_queue, &state_ptr->normal_pri_queue_mutex);
-    process_queue(&state_ptr->low_priority_queue, &state_ptr->low_pri_queue_mutex);
+    job_thread* thread = current_thread;
+    if (thread && thread->suspended_fiber_count > 0 && resume_ready_fibers(thread)) {
+        return;
+    }
+    if (!thread && !is_main_thread) {
+        // Other threads, such as the render thread, leave jobs to the job threads. The results of a
+        // job run here could wait on the main thread, which may itself be waiting on this one.
+        platform_sleep(0);
+        return;
+    }
 
-    // Process pending results.
-    for (u16 i = 0; i < MAX_JOB_RESULTS; ++i) {
-        // Lock and take a copy, unlock.
-        if (!kmutex_lock(&state_ptr->result_mutex)) {
-            KERROR("Failed to obtain lock on result mutex!");
+    // On the main thread, only general jobs can be helped with.
+    u32 type_mask = thread ? thread->type_mask : JOB_TYPE_GENERAL;
+    job_info info;
+    if (find_job(thread, type_mask, &info)) {
+        dispatch_job(thread, &info);
+    } else {
+        if (!thread) {
+            // Process results so job threads waiting on a full result queue are able to finish
+            // what is being waited on.
+            process_results();
         }
-        job_result_entry entry = state_ptr->pending_results[i];
-        if (!kmutex_unlock(&state_ptr->result_mutex)) {
-            KERROR("Failed to release lock on result mutex!");
+        // Nothing to help with, give the time back to the OS.
+        platform_sleep(0);
+    }
+}
+
+void job_system_wait(job_handle handle) {
+    while (!job_system_is_complete(handle)) {
+        if (current_fiber) {
+            suspend_fiber(handle, 0, 0);
+        } else {
+            help_while_waiting();
         }
+    }
+}
 
-        if (entry.id != INVALID_ID_U16) {
-            // Execute the callback.
-            entry.callback(entry.params);
+void job_system_wait_for(pfn_job_wait_condition condition, void* user_data) {
+    while (!condition(user_data)) {
+        if (current_fiber) {
+            suspend_fiber(INVALID_ID, condition, user_data);
+        } else {
+            help_while_waiting();
+        }
+    }
+}
 
-            if (entry.params) {
-                kfree(entry.params, entry.param_size, MEMORY_TAG_JOB);
-            }
+b8 job_system_in_fiber_job() {
+    return current_fiber != 0;
+}
 
-            // Lock actual entry, invalidate and clear it
-            if (!kmutex_lock(&state_ptr->result_mutex)) {
-                KERROR("Failed to obtain lock on result mutex!");
-            }
-            kzero_memory(&state_ptr->pending_results[i], sizeof(job_result_entry));
-            state_ptr->pending_results[i].id = INVALID_ID_U16;
-            if (!kmutex_unlock(&state_ptr->result_mutex)) {
-                KERROR("Failed to release lock on result mutex!");
-            }
+void job_system_yield() {
+    if (current_fiber) {
+        suspend_fiber(INVALID_ID, 0, 0);
+    }
+}
+
+typedef struct parallel_for_context {
+    pfn_job_parallel_for fn;
+    void* user_data;
+    u32 count;
+    u32 batch_size;
+    // The first index of the next batch to be claimed.
+    u32 next_index;
+    // The number of helper jobs which have not finished yet.
+    u32 active_helpers;
+} parallel_for_context;
+
+static void parallel_for_run_batches(parallel_for_context* context) {
+    while (true) {
+        u32 start = katomic_fetch_add(&context->next_index, context->batch_size);
+        if (start >= context->count) {
+            break;
         }
+        u32 end = KMIN(start + context->batch_size, context->count);
+        context->fn(start, end, context->user_data);
     }
 }
 
-void job_system_submit(job_info info) {
-    u64 thread_count = state_ptr->thread_count;
-    ring_queue* queue = &state_ptr->normal_priority_queue;
-    kmutex* queue_mutex = &state_ptr->normal_pri_queue_mutex;
+static b8 parallel_for_job_start(void* params, void* result_data) {
+    parallel_for_context* context = *(parallel_for_context**)params;
+    parallel_for_run_batches(context);
+    // NOTE: The context must not be touched after this, as the caller may have returned.
+    katomic_fetch_sub(&context->active_helpers, 1);
+    return true;
+}
 
-    // If the job is high priority, try to kick it off immediately.
-    if (info.priority == JOB_PRIORITY_HIGH) {
-        queue = &state_ptr->high_priority_queue;
-        queue_mutex = &state_ptr->high_pri_queue_mutex;
+void job_system_parallel_for(u32 count, u32 batch_size, pfn_job_parallel_for fn, void* user_data) {
+    if (!fn || count == 0) {
+        return;
+    }
 
-        // Check for a free thread that supports the job type first.
-        for (u8 i = 0; i < thread_count; ++i) {
+    // Helpers can run on any active thread which takes general jobs, other than this one.
+    job_thread* current = current_thread;
+    u32 helper_count = 0;
+    if (state_ptr) {
+        for (u8 i = 0; i < state_ptr->thread_count; ++i) {
             job_thread* thread = &state_ptr->job_threads[i];
-            if (state_ptr->job_threads[i].type_mask & info.type) {
-                b8 found = false;
-                if (!kmutex_lock(&thread->info_mutex)) {
-                    KERROR("Failed to obtain lock on job thread mutex!");
-                }
-                if (!state_ptr->job_threads[i].info.entry_point) {
-                    KTRACE("Job immediately submitted on thread %i", state_ptr->job_threads[i].index);
-                    state_ptr->job_threads[i].info = info;
-                    found = true;
-                }
-                if (!kmutex_unlock(&thread->info_mutex)) {
-                    KERROR("Failed to release lock on job thread mutex!");
-                }
-                if (found) {
-                    return;
-                }
+            if (thread != current && (thread->type_mask & JOB_TYPE_GENERAL) && !katomic_load_relaxed(&thread->parked)) {
+                helper_count++;
             }
         }
     }
 
-    // If this point is reached, all threads are busy (if high) or it can wait a frame.
-    // Add to the queue and try again next cycle.
-    if (info.priority == JOB_PRIORITY_LOW) {
-        queue = &state_ptr->low_priority_queue;
-        queue_mutex = &state_ptr->low_pri_queue_mutex;
+    if (batch_size == 0) {
+        // Aim for a few batches per thread so uneven batches balance out.
+        batch_size = KMAX(count / ((helper_count + 1) * 4), 1);
     }
+    u32 batch_count = (count + batch_size - 1) / batch_size;
+    helper_count = KMIN(helper_count, batch_count - 1);
+    helper_count = KMIN(helper_count, JOB_MAX_PARALLEL_FOR_HELPERS);
 
-    // NOTE: Locking here in case the job is submitted from another job/thread.
-    if (!kmutex_lock(queue_mutex)) {
-        KERROR("Failed to obtain lock on queue mutex!");
+    parallel_for_context context;
+    context.fn = fn;
+    context.user_data = user_data;
+    context.count = count;
+    context.batch_size = batch_size;
+    context.next_index = 0;
+    context.active_helpers = helper_count;
+
+    // Kick off helpers, each of which claims batches until there are none left.
+    parallel_for_context* context_ptr = &context;
+    for (u32 i = 0; i < helper_count; ++i) {
+        job_info job = job_create_priority(parallel_for_job_start, 0, 0, &context_ptr, sizeof(parallel_for_context*), 0, JOB_TYPE_GENERAL, JOB_PRIORITY_HIGH);
+        job_system_submit(job);
+    }
+
+    // Pitch in on this thread as well.
+    parallel_for_run_batches(&context);
+
+    // The context lives on this stack, so every helper must be done with it before returning.
+    // Helpers which have not started yet find nothing left to do and finish right away.
+    while (katomic_load(&context.active_helpers) > 0) {
+        help_while_waiting();
     }
-    ring_queue_enqueue(queue, &info);
-    if (!kmutex_unlock(queue_mutex)) {
-        KERROR("Failed to release lock on queue mutex!");
+}
+
+b8 job_add_dependency(job_info* info, job_handle dependency) {
+    if (!info) {
+        return false;
     }
-    KTRACE("Job queued.");
+    if (info->dependency_count >= JOB_MAX_DEPENDENCIES) {
+        KERROR("job_add_dependency - job already has the max number of dependencies (%u).", JOB_MAX_DEPENDENCIES);
+        return false;
+    }
+    info->dependencies[info->dependency_count++] = dependency;
+    return true;
 }
 
 job_info job_create(pfn_job_start entry_point, pfn_job_on_complete on_success, pfn_job_on_complete on_fail, void* param_data, u32 param_data_size, u32 result_data_size) {
@@ -386,12 +1705,16 @@ job_info job_create_priority(pfn_job_start entry_point, pfn_job_on_complete on_s
     job.entry_point = entry_point;
     job.on_success = on_success;
     job.on_fail = on_fail;
+    job.on_cancel = 0;
     job.type = type;
     job.priority = priority;
+    job.dependency_count = 0;
+    job.handle = INVALID_ID;
+    job.use_fiber = false;
 
     job.param_data_size = param_data_size;
     if (param_data_size) {
-        job.param_data = kallocate(param_data_size, MEMORY_TAG_JOB);
+        job.param_data = job_payload_allocate(param_data_size);
         kcopy_memory(job.param_data, param_data, param_data_size);
     } else {
         job.param_data = 0;
@@ -399,7 +1722,7 @@ job_info job_create_priority(pfn_job_start entry_point, pfn_job_on_complete on_s
 
     job.result_data_size = result_data_size;
     if (result_data_size) {
-        job.result_data = kallocate(result_data_size, MEMORY_TAG_JOB);
+        job.result_data = job_payload_allocate(result_data_size);
     } else {
         job.result_data = 0;
     }
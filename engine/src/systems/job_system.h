@@ -8,6 +8,43 @@ typedef b8 (*pfn_job_start)(void*, void*);
 /** @brief A function pointer definition for completion of a job. */
 typedef void (*pfn_job_on_complete)(void*);
 
+/**
+ * @brief A handle to a submitted job, used to wait on it or to make other jobs depend
+ * on it. A handle of INVALID_ID refers to no job, and is always considered complete.
+ */
+typedef u32 job_handle;
+
+/**
+ * @brief A function pointer definition for a condition waited on by job_system_wait_for.
+ * Returns true once the condition is met. May be called from any job thread, and often.
+ */
+typedef b8 (*pfn_job_wait_condition)(void* user_data);
+
+/**
+ * @brief A function pointer definition for the body of a parallel for loop.
+ * Invoked once per batch with the range of indices [start, end) to process.
+ */
+typedef void (*pfn_job_parallel_for)(u32 start, u32 end, void* user_data);
+
+/** @brief The maximum number of jobs a single job can depend on. */
+#define JOB_MAX_DEPENDENCIES 4
+
+/** @brief The number of job types, used to size per-type statistics. */
+#define JOB_TYPE_COUNT 3
+
+/** @brief The number of job priorities, used to size per-priority statistics. */
+#define JOB_PRIORITY_COUNT 3
+
+/**
+ * @brief The number of buckets in job timing histograms. Bucket 0 counts times under 2us,
+ * and each bucket i after it counts times in [2^i, 2^(i+1)) microseconds. The last bucket
+ * also counts everything longer.
+ */
+#define JOB_HISTOGRAM_BUCKET_COUNT 20
+
+/** @brief The maximum number of job threads. */
+#define JOB_MAX_THREAD_COUNT 32
+
 /** @brief Describes a type of job */
 typedef enum job_type {
     /** 
@@ -31,9 +68,9 @@ typedef enum job_type {
 } job_type;
 
 /**
- * @brief Determines which job queue a job uses. The high-priority queue is always
- * exhausted first before processing the normal-priority queue, which must also
- * be exhausted before processing the low-priority queue.
+ * @brief Determines which job queue a job uses. Each job thread always exhausts the
+ * high-priority work available to it (its own and any it can steal) before processing
+ * normal-priority work, which must also be exhausted before processing low-priority work.
  */
 typedef enum job_priority {
     /** @brief The lowest-priority job, used for things that can wait to be done if need be, such as log flushing. */
@@ -44,6 +81,21 @@ typedef enum job_priority {
     JOB_PRIORITY_HIGH
 } job_priority;
 
+/**
+ * @brief Determines how many job threads are kept active. The rest are parked, running only the
+ * jobs of types no active thread can run, so they cost nothing while idle and never spin up for
+ * work the active threads could do. Completion callbacks are unaffected.
+ */
+typedef enum job_power_policy {
+    /** @brief Every job thread is kept active, unless the active count is set lower. The default. */
+    JOB_POWER_POLICY_PERFORMANCE,
+    /**
+     * @brief Job threads are parked and unparked with load, sampled in job_system_update, so that only as
+     * many stay active as are kept busy. Suited to laptops on battery, and to running in the background.
+     */
+    JOB_POWER_POLICY_BATTERY
+} job_power_policy;
+
 /**
  * @brief Describes a job to be run.
  */
@@ -63,6 +115,12 @@ typedef struct job_info {
     /** @brief A function pointer to be invoked when the job successfully fails. Optional. */
     pfn_job_on_complete on_fail;
 
+    /**
+     * @brief A function pointer to be invoked, with a copy of the parameter data, when the job is cancelled before
+     * it starts (see job_system_cancel). Neither on_success nor on_fail are invoked then. Optional.
+     */
+    pfn_job_on_complete on_cancel;
+
     /** @brief Data to be passed to the entry point upon execution. */
     void* param_data;
 
@@ -74,6 +132,25 @@ typedef struct job_info {
 
     /** @brief The size of the data passed to the success/fail function. */
     u32 result_data_size;
+
+    /** @brief The number of jobs which must complete before this one starts. */
+    u8 dependency_count;
+
+    /** @brief Handles to the jobs which must complete before this one starts. Use job_add_dependency to add to these. */
+    job_handle dependencies[JOB_MAX_DEPENDENCIES];
+
+    /** @brief The handle of this job. Assigned by the job system upon submission. */
+    job_handle handle;
+
+    /** @brief The time at which the job was submitted, in seconds. Set by the job system upon submission. */
+    f64 submit_time;
+
+    /**
+     * @brief Indicates if this job should run on its own fiber. A fiber job can yield (see job_system_yield),
+     * and waits on other jobs by yielding, leaving its job thread free to run other work in the meantime.
+     * Where fibers are unavailable, the job simply runs directly on the job thread.
+     */
+    b8 use_fiber;
 } job_info;
 
 /**
@@ -84,25 +161,208 @@ typedef struct job_info {
  * @param max_job_thread_count The maximum number of job threads to be spun up. 
  * Should be no more than the number of cores on the CPU, minus one to account for the main thread.
  * @param type_masks A collection of type masks for each job thread. Must match max_job_thread_count.
+ * @param affinity_masks A collection of processor affinity masks for each job thread, where bit n refers to the logical
+ * processor with index n (see platform_get_cpu_topology). A mask of 0 leaves the thread unpinned. Optional; pass 0 to pin no threads.
  * @returns True if the job system started up successfully; otherwise false.
  */
-b8 job_system_initialize(u64* job_system_memory_requirement, void* state, u8 max_job_thread_count, u32 type_masks[]);
+KAPI b8 job_system_initialize(u64* job_system_memory_requirement, void* state, u8 max_job_thread_count, u32 type_masks[], u64 affinity_masks[]);
 
 /**
  * @brief Shuts the job system down.
  */
-void job_system_shutdown(void* state);
+KAPI void job_system_shutdown(void* state);
+
+/**
+ * @brief Updates the job system, invoking the completion callbacks of finished jobs
+ * on the calling (main) thread. Should happen once an update cycle. Jobs themselves
+ * are picked up by the job threads as soon as they are submitted.
+ */
+KAPI void job_system_update();
+
+/**
+ * @brief Obtains the highest number of job results which have been waiting to be
+ * processed by job_system_update at once since the job system was initialized.
+ * @returns The high-water mark of the job result queue.
+ */
+KAPI u32 job_system_result_queue_high_water();
+
+/**
+ * @brief Sets how many job threads are kept active. Choosing JOB_POWER_POLICY_PERFORMANCE makes every
+ * thread active; JOB_POWER_POLICY_BATTERY goes on from the current count.
+ * @param policy The policy to use.
+ */
+KAPI void job_system_power_policy_set(job_power_policy policy);
+
+/**
+ * @brief Obtains the policy determining how many job threads are kept active.
+ * @returns The policy in use.
+ */
+KAPI job_power_policy job_system_power_policy_get();
 
 /**
- * @brief Updates the job system. Should happen once an update cycle.
+ * @brief Keeps the given number of job threads active, parking the highest-indexed threads past it.
+ * Under JOB_POWER_POLICY_BATTERY, this count moves on with load from where it is set.
+ * @param count The number of active threads, kept between 1 and the number of job threads.
  */
-void job_system_update();
+KAPI void job_system_active_thread_count_set(u8 count);
 
 /**
- * @brief Submits the provided job to be queued for execution.
+ * @brief Obtains the number of job threads kept active.
+ * @returns The number of active threads; 0 if the job system is not running.
+ */
+KAPI u8 job_system_active_thread_count_get();
+
+/** @brief Statistics for a single job thread. */
+typedef struct job_thread_stats {
+    /** @brief The types of jobs the thread can handle. */
+    u32 type_mask;
+    /** @brief The time since the thread started, in microseconds. */
+    u64 elapsed_time_us;
+    /** @brief The time the thread has spent running jobs, in microseconds. The rest was spent idle. */
+    u64 busy_time_us;
+    /** @brief The number of jobs the thread has run. */
+    u64 jobs_run;
+    /** @brief Indicates if the thread is parked (see job_power_policy). */
+    b8 parked;
+} job_thread_stats;
+
+/**
+ * @brief A snapshot of job system statistics. Counters accumulate from the time
+ * the job system was initialized. Histograms are indexed by job type, with 0 being
+ * general, 1 being resource load and 2 being GPU resource jobs.
+ */
+typedef struct job_system_stats {
+    /** @brief The number of job threads. */
+    u8 thread_count;
+    /** @brief Statistics for each job thread. */
+    job_thread_stats threads[JOB_MAX_THREAD_COUNT];
+    /** @brief The number of jobs queued across all threads, per priority (indexed by job_priority). */
+    u32 queue_depths[JOB_PRIORITY_COUNT];
+    /** @brief The number of jobs waiting on dependencies to complete. */
+    u32 waiting_count;
+    /** @brief The number of results waiting to be processed by job_system_update. */
+    u32 pending_result_count;
+    /** @brief Histograms of the time between jobs being submitted and starting, including waits on dependencies. */
+    u64 latency_histograms[JOB_TYPE_COUNT][JOB_HISTOGRAM_BUCKET_COUNT];
+    /** @brief Histograms of the time jobs take to run. For fiber jobs, this includes time spent suspended. */
+    u64 run_time_histograms[JOB_TYPE_COUNT][JOB_HISTOGRAM_BUCKET_COUNT];
+} job_system_stats;
+
+/**
+ * @brief Takes a snapshot of the job system's statistics. Values are gathered while
+ * jobs are running, so may be slightly inconsistent with one another.
+ * @param out_stats A pointer to hold the statistics. Zeroed if the job system is not running.
+ */
+KAPI void job_system_stats_get(job_system_stats* out_stats);
+
+/**
+ * @brief Submits the provided job to be queued for execution. Jobs submitted from
+ * within a job stay on that job thread (if it can run their type), where idle threads
+ * may steal them. Otherwise, the job is handed to a thread that can run it, preferring
+ * one that is asleep. If the job has dependencies, it is held back until all of them
+ * have completed, and then queued from the thread which completed the last one.
  * @param info The description of the job to be executed.
+ * @returns A handle to the job, which can be waited on or depended upon. INVALID_ID if the job cannot be tracked.
+ */
+KAPI job_handle job_system_submit(job_info info);
+
+/**
+ * @brief Submits a number of jobs at once. Behaves as if each job were submitted in turn with
+ * job_system_submit, but job records and each receiving thread's queue are only locked once
+ * per group of jobs, rather than once per job. Preferred when queuing many jobs together.
+ * @param infos An array of the jobs to be executed. Note that the jobs in the array are modified.
+ * @param count The number of jobs in the array.
+ * @param out_handles An array to hold a handle to each job, which must be able to hold count handles. Optional.
+ */
+KAPI void job_system_submit_batch(job_info* infos, u32 count, job_handle* out_handles);
+
+/**
+ * @brief Indicates if the job with the given handle has completed. Note that the job's
+ * success/fail callback may not have been invoked yet, as that happens in job_system_update.
+ * @param handle The handle of the job to check.
+ * @returns True if the job has completed (or the handle is INVALID_ID); otherwise false.
+ */
+KAPI b8 job_system_is_complete(job_handle handle);
+
+/**
+ * @brief Asks the job with the given handle to cancel. A job which has not yet started is completed
+ * without being run, its data freed and its on_cancel callback invoked in job_system_update. A job which
+ * is already running may check job_system_cancel_requested and finish early. Jobs depending on it are run
+ * once it completes either way.
+ * @param handle The handle of the job to cancel.
+ * @returns True if the job will not be run; false if it is running or has completed.
+ */
+KAPI b8 job_system_cancel(job_handle handle);
+
+/**
+ * @brief Indicates if the job calling this has been asked to cancel, so that it may stop early.
+ * @returns True if called from a job which has been asked to cancel; otherwise false.
+ */
+KAPI b8 job_system_cancel_requested();
+
+/**
+ * @brief Moves the job with the given handle to another priority, such as when an asset being loaded
+ * becomes needed sooner. A job already queued is queued again at the new priority, and the copy left
+ * behind is dropped once found. A job waiting on its dependencies is queued at the new priority.
+ * @param handle The handle of the job.
+ * @param priority The priority to move the job to.
+ * @returns True if the job was moved, or already had the priority; false if it has started, been cancelled or completed.
+ */
+KAPI b8 job_system_priority_set(job_handle handle, job_priority priority);
+
+/**
+ * @brief Blocks until the job with the given handle has completed. Rather than idling, the
+ * calling thread runs other jobs while it waits. When called from a job thread, any job that
+ * thread can handle may be run. When called from the thread the system was initialized on, only
+ * general jobs are run, and the success/fail callbacks of finished jobs may also be invoked, as in
+ * job_system_update. Any other thread, such as the render thread, yields to the OS instead. When
+ * called from a fiber job, the job yields until the job being waited on has completed.
+ * @param handle The handle of the job to wait on.
+ */
+KAPI void job_system_wait(job_handle handle);
+
+/**
+ * @brief Blocks until the given condition is met, such as for waiting on work done outside
+ * the job system. When called from a fiber job, the job is suspended and only resumed once its
+ * job thread finds the condition met; otherwise the calling thread runs other jobs while it
+ * waits, as in job_system_wait. Idle job threads check on suspended fibers every millisecond
+ * or so, so conditions should be cheap to check.
+ * @param condition A pointer to the function which checks the condition. Required.
+ * @param user_data Data to be passed to condition. Optional.
+ */
+KAPI void job_system_wait_for(pfn_job_wait_condition condition, void* user_data);
+
+/**
+ * @brief Indicates if the calling code is running as a fiber job, and so is able to yield.
+ * @returns True if called from a fiber job; otherwise false.
+ */
+KAPI b8 job_system_in_fiber_job();
+
+/**
+ * @brief Suspends the calling fiber job, letting its job thread run other work before the
+ * job is resumed. Useful for breaking up long-running jobs, such as between reading a file
+ * and processing it. Does nothing when not called from a fiber job.
+ */
+KAPI void job_system_yield();
+
+/**
+ * @brief Splits the range [0, count) into batches and processes them in parallel across all job
+ * threads which can run general jobs, as well as the calling thread. Returns once every batch
+ * has been processed. May be called from within a job.
+ * @param count The number of items to process.
+ * @param batch_size The number of items to process per invocation of fn. Pass 0 to choose automatically.
+ * @param fn A pointer to the function to be invoked for each batch. Required. Must be safe to call from multiple threads at once.
+ * @param user_data Data to be passed to fn. Optional.
+ */
+KAPI void job_system_parallel_for(u32 count, u32 batch_size, pfn_job_parallel_for fn, void* user_data);
+
+/**
+ * @brief Adds a dependency to the given job, which must complete before the job starts.
+ * @param info A pointer to the job to add the dependency to.
+ * @param dependency The handle of the job to depend on.
+ * @returns True on success; otherwise false if the job already has the max number of dependencies.
  */
-KAPI void job_system_submit(job_info info);
+KAPI b8 job_add_dependency(job_info* info, job_handle dependency);
 
 /**
  * @brief Creates a new job with default type (Generic) and priority (Normal).
@@ -0,0 +1,167 @@
+#include "light_system.h"
+
+#include "core/logger.h"
+#include "core/kmemory.h"
+#include "math/kmath.h"
+
+typedef struct light_system_state {
+    light_system_config config;
+    directional_light directional;
+    // The point lights, packed.
+    u32 point_light_count;
+    point_light* point_lights;
+    // The index in point_lights of the light with each id, or INVALID_ID if the id is free.
+    u32* indices;
+    // The id of the light at each index of point_lights.
+    u32* ids;
+    // The first id not yet handed out. Freed ids below it are found in indices.
+    u32 next_id;
+} light_system_state;
+
+static light_system_state* state_ptr;
+
+b8 light_system_initialize(u64* memory_requirement, void* state, light_system_config config) {
+    if (config.max_point_light_count == 0) {
+        KFATAL("light_system_initialize - config.max_point_light_count must be > 0.");
+        return false;
+    }
+
+    // Block of memory will contain state structure, then the lights, then the index of each id, then the id of each index.
+    u64 struct_requirement = sizeof(light_system_state);
+    u64 lights_requirement = sizeof(point_light) * config.max_point_light_count;
+    u64 indices_requirement = sizeof(u32) * config.max_point_light_count;
+    *memory_requirement = struct_requirement + lights_requirement + indices_requirement * 2;
+
+    if (!state) {
+        return true;
+    }
+
+    state_ptr = (light_system_state*)state;
+    kzero_memory(state_ptr, sizeof(light_system_state));
+    state_ptr->config = config;
+    state_ptr->point_lights = (point_light*)((u8*)state + struct_requirement);
+    state_ptr->indices = (u32*)((u8*)state_ptr->point_lights + lights_requirement);
+    state_ptr->ids = (u32*)((u8*)state_ptr->indices + indices_requirement);
+    for (u32 i = 0; i < config.max_point_light_count; ++i) {
+        state_ptr->indices[i] = INVALID_ID;
+    }
+
+    // A dim light from above until the scene sets its own.
+    state_ptr->directional.direction = vec3_normalized((vec3){-1.0f, -1.0f, -1.0f});
+    state_ptr->directional.colour = (vec4){0.4f, 0.4f, 0.2f, 1.0f};
+    return true;
+}
+
+void light_system_shutdown(void* state) {
+    if (state) {
+        kzero_memory(state, sizeof(light_system_state));
+    }
+    state_ptr = 0;
+}
+
+b8 light_system_directional_set(const directional_light* light) {
+    if (!state_ptr || !light) {
+        return false;
+    }
+    state_ptr->directional = *light;
+    state_ptr->directional.direction = vec3_normalized(light->direction);
+    return true;
+}
+
+directional_light light_system_directional_get(void) {
+    if (!state_ptr) {
+        return (directional_light){0};
+    }
+    return state_ptr->directional;
+}
+
+f32 light_system_point_radius(const point_light* light) {
+    // The light is fainter than the cutoff beyond the distance at which its attenuation divides its
+    // brightest channel down to it.
+    f32 brightest = KMAX(light->colour.r, KMAX(light->colour.g, light->colour.b));
+    f32 attenuation = brightest / LIGHT_SYSTEM_CUTOFF;
+    if (attenuation <= light->constant_f) {
+        return 0.0f;
+    }
+    if (light->quadratic > 0.0f) {
+        // The positive root of quadratic * d^2 + linear * d + constant - attenuation.
+        f32 discriminant = light->linear * light->linear - 4.0f * light->quadratic * (light->constant_f - attenuation);
+        return (-light->linear + ksqrt(discriminant)) / (2.0f * light->quadratic);
+    }
+    if (light->linear > 0.0f) {
+        return (attenuation - light->constant_f) / light->linear;
+    }
+    // Never fades, so reaches everything.
+    return K_INFINITY;
+}
+
+u32 light_system_point_add(const point_light* light) {
+    if (!state_ptr || !light) {
+        return INVALID_ID;
+    }
+    if (state_ptr->point_light_count == state_ptr->config.max_point_light_count) {
+        KERROR("light_system_point_add - The system is full, with %u point lights.", state_ptr->config.max_point_light_count);
+        return INVALID_ID;
+    }
+
+    // Reuse a freed id if there is one, so ids stay below the capacity.
+    u32 id = state_ptr->next_id;
+    if (id == state_ptr->config.max_point_light_count) {
+        for (id = 0; state_ptr->indices[id] != INVALID_ID; ++id) {
+        }
+    } else {
+        state_ptr->next_id++;
+    }
+
+    u32 index = state_ptr->point_light_count++;
+    state_ptr->point_lights[index] = *light;
+    state_ptr->point_lights[index].radius = light_system_point_radius(light);
+    state_ptr->indices[id] = index;
+    state_ptr->ids[index] = id;
+    return id;
+}
+
+b8 light_system_point_update(u32 id, const point_light* light) {
+    if (!state_ptr || !light || id >= state_ptr->config.max_point_light_count || state_ptr->indices[id] == INVALID_ID) {
+        KERROR("light_system_point_update - There is no point light with id %u.", id);
+        return false;
+    }
+    point_light* target = &state_ptr->point_lights[state_ptr->indices[id]];
+    *target = *light;
+    target->radius = light_system_point_radius(light);
+    return true;
+}
+
+b8 light_system_point_remove(u32 id) {
+    if (!state_ptr || id >= state_ptr->config.max_point_light_count || state_ptr->indices[id] == INVALID_ID) {
+        KERROR("light_system_point_remove - There is no point light with id %u.", id);
+        return false;
+    }
+
+    // The last light takes the place of the removed one, keeping them packed.
+    u32 index = state_ptr->indices[id];
+    u32 last = --state_ptr->point_light_count;
+    if (index != last) {
+        state_ptr->point_lights[index] = state_ptr->point_lights[last];
+        state_ptr->ids[index] = state_ptr->ids[last];
+        state_ptr->indices[state_ptr->ids[index]] = index;
+    }
+    state_ptr->indices[id] = INVALID_ID;
+    return true;
+}
+
+const point_light* light_system_point_get(u32 id) {
+    if (!state_ptr || id >= state_ptr->config.max_point_light_count || state_ptr->indices[id] == INVALID_ID) {
+        return 0;
+    }
+    return &state_ptr->point_lights[state_ptr->indices[id]];
+}
+
+u32 light_system_point_lights_get(const point_light** out_lights) {
+    if (!state_ptr) {
+        *out_lights = 0;
+        return 0;
+    }
+    *out_lights = state_ptr->point_lights;
+    return state_ptr->point_light_count;
+}
@@ -0,0 +1,140 @@
+/**
+ * @file light_system.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief The light system holds the dynamic lights of the scene: one directional light, such as the
+ * sun, and any number of point lights up to its capacity.
+ * @details Point lights are referred to by id, which stays the same while a light lives, and are
+ * kept packed in one array so the renderer can read them all at once. Each frame the world view
+ * assigns them to the clusters of its view frustum which they reach, so the materials only light
+ * each fragment with the lights near it. The system is not thread-safe, so lights should be changed
+ * on the main thread, and not while render packets are being built.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "math/math_types.h"
+
+/** @brief A light shining from infinitely far away in one direction, such as the sun. */
+typedef struct directional_light {
+    /** @brief The direction the light shines in. Normalized. */
+    vec3 direction;
+    /** @brief The colour of the light. */
+    vec4 colour;
+} directional_light;
+
+/** @brief A light shining in every direction from a point, fading with distance. */
+typedef struct point_light {
+    /** @brief The position of the light, in world space. */
+    vec3 position;
+    /** @brief The colour of the light. */
+    vec4 colour;
+    /** @brief The constant part of the attenuation. Usually 1, so the light is never brighter than its colour. */
+    f32 constant_f;
+    /** @brief The part of the attenuation growing linearly with distance. */
+    f32 linear;
+    /** @brief The part of the attenuation growing with the square of distance. */
+    f32 quadratic;
+    /**
+     * @brief The distance beyond which the light adds nothing. Worked out from the colour and
+     * attenuation by the light system when the light is added or updated.
+     */
+    f32 radius;
+} point_light;
+
+/** @brief The brightness, as a fraction of its colour, a point light is faded to nothing beneath. */
+#define LIGHT_SYSTEM_CUTOFF (1.0f / 256.0f)
+
+/** @brief The light system configuration. */
+typedef struct light_system_config {
+    /** @brief The maximum number of point lights that can exist at once. */
+    u32 max_point_light_count;
+} light_system_config;
+
+/**
+ * @brief Initializes the light system.
+ * Should be called twice; once to get the memory requirement (passing state=0), and a second
+ * time passing an allocated block of memory to actually initialize the system.
+ *
+ * @param memory_requirement A pointer to hold the memory requirement as it is calculated.
+ * @param state A block of memory to hold the state or, if gathering the memory requirement, 0.
+ * @param config The configuration for this system.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 light_system_initialize(u64* memory_requirement, void* state, light_system_config config);
+
+/**
+ * @brief Shuts down the light system.
+ *
+ * @param state The state block of memory.
+ */
+KAPI void light_system_shutdown(void* state);
+
+/**
+ * @brief Sets the directional light of the scene.
+ *
+ * @param light A pointer to the light. Its direction is normalized.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 light_system_directional_set(const directional_light* light);
+
+/**
+ * @brief Gets the directional light of the scene.
+ *
+ * @return The directional light.
+ */
+KAPI directional_light light_system_directional_get(void);
+
+/**
+ * @brief Adds a point light. Its radius is worked out from its colour and attenuation.
+ *
+ * @param light A pointer to the light to add.
+ * @return The id of the light, or INVALID_ID if the system is full.
+ */
+KAPI u32 light_system_point_add(const point_light* light);
+
+/**
+ * @brief Changes the point light with the given id. Its radius is worked out again.
+ *
+ * @param id The id of the light.
+ * @param light A pointer to the new values of the light.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 light_system_point_update(u32 id, const point_light* light);
+
+/**
+ * @brief Removes the point light with the given id, after which the id may be handed out again.
+ *
+ * @param id The id of the light.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 light_system_point_remove(u32 id);
+
+/**
+ * @brief Gets the point light with the given id.
+ *
+ * @param id The id of the light.
+ * @return A pointer to the light, valid until lights are next added or removed, or 0 if there is none with the id.
+ */
+KAPI const point_light* light_system_point_get(u32 id);
+
+/**
+ * @brief Gets every point light, packed in no particular order.
+ *
+ * @param out_lights A pointer to hold the lights, valid until lights are next added or removed.
+ * @return The number of point lights.
+ */
+KAPI u32 light_system_point_lights_get(const point_light** out_lights);
+
+/**
+ * @brief Works out the distance beyond which a point light of the given colour and attenuation
+ * is fainter than LIGHT_SYSTEM_CUTOFF.
+ *
+ * @param light A pointer to the light. Its radius is ignored.
+ * @return The radius of the light.
+ */
+KAPI f32 light_system_point_radius(const point_light* light);
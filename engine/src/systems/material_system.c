@@ -1,12 +1,15 @@
 #include "material_system.h"
 
+#include "core/event.h"
 #include "core/logger.h"
 #include "core/kstring.h"
 #include "containers/hashtable.h"
 #include "math/kmath.h"
 #include "renderer/renderer_frontend.h"
+#include "resources/resource_cache.h"
 #include "systems/texture_system.h"
 
+#include "systems/job_system.h"
 #include "systems/resource_system.h"
 #include "systems/shader_system.h"
 
@@ -20,9 +23,9 @@ typedef struct material_shader_uniform_locations {
     u16 diffuse_texture;
     u16 specular_texture;
     u16 normal_texture;
-    u16 model;
-    u16 render_mode;
     u16 time;
+    // The variant of the shader for each render mode, indexed by renderer_debug_view_mode.
+    u8 render_mode_variants[3];
 } material_shader_uniform_locations;
 
 typedef struct ui_shader_uniform_locations {
@@ -51,6 +54,9 @@ typedef struct material_system_state {
     // Known locations for the UI shader.
     ui_shader_uniform_locations ui_locations;
     u32 ui_shader_id;
+
+    // Released auto-release materials kept loaded in case they are acquired again, by handle.
+    resource_cache cache;
 } material_system_state;
 
 typedef struct material_reference {
@@ -59,11 +65,83 @@ typedef struct material_reference {
     b8 auto_release;
 } material_reference;
 
+// Also used as result_data from the reload job.
+typedef struct material_reload_params {
+    char resource_name[MATERIAL_NAME_MAX_LENGTH];
+    resource material_resource;
+} material_reload_params;
+
+// Also used as result_data from the job of an async acquire.
+typedef struct material_load_params {
+    char resource_name[MATERIAL_NAME_MAX_LENGTH];
+    // The slot the material was given, which is drawn as the default material until loaded into.
+    u32 handle;
+    resource material_resource;
+} material_load_params;
+
 static material_system_state* state_ptr = 0;
 
 b8 create_default_material(material_system_state* state);
 b8 load_material(material_config config, material* m);
 void destroy_material(material* m);
+static void material_cache_trim(u64 max_size);
+static b8 material_system_on_memory_pressure(u16 code, void* sender, void* listener_inst, event_context context);
+
+// Finds a free slot for a material, or INVALID_ID if there is none.
+static u32 material_slot_find(void) {
+    u32 count = state_ptr->config.max_material_count;
+    for (u32 i = 0; i < count; ++i) {
+        if (state_ptr->registered_materials[i].id == INVALID_ID) {
+            return i;
+        }
+    }
+    return INVALID_ID;
+}
+
+// Loads a material from its config into its slot, saving off the uniform locations of the
+// builtin shaders the first time a material uses them.
+static b8 material_slot_load(const material_config* config, material* m, u32 handle) {
+    if (!load_material(*config, m)) {
+        return false;
+    }
+
+    // Get the uniform indices.
+    shader* s = shader_system_get_by_id(m->shader_id);
+    // Save off the locations for known types for quick lookups.
+    if (state_ptr->material_shader_id == INVALID_ID && strings_equal(config->shader_name, "Shader.Builtin.Material")) {
+        state_ptr->material_shader_id = s->id;
+        state_ptr->material_locations.projection = shader_system_uniform_index(s, "projection");
+        state_ptr->material_locations.view = shader_system_uniform_index(s, "view");
+        state_ptr->material_locations.ambient_colour = shader_system_uniform_index(s, "ambient_colour");
+        state_ptr->material_locations.view_position = shader_system_uniform_index(s, "view_position");
+        state_ptr->material_locations.diffuse_colour = shader_system_uniform_index(s, "diffuse_colour");
+        state_ptr->material_locations.diffuse_texture = shader_system_uniform_index(s, "diffuse_texture");
+        state_ptr->material_locations.specular_texture = shader_system_uniform_index(s, "specular_texture");
+        state_ptr->material_locations.normal_texture = shader_system_uniform_index(s, "normal_texture");
+        state_ptr->material_locations.shininess = shader_system_uniform_index(s, "shininess");
+        state_ptr->material_locations.time = shader_system_uniform_index(s, "time");
+        state_ptr->material_locations.render_mode_variants[RENDERER_VIEW_MODE_DEFAULT] = shader_system_variant_index(s, "default");
+        state_ptr->material_locations.render_mode_variants[RENDERER_VIEW_MODE_LIGHTING] = shader_system_variant_index(s, "lighting");
+        state_ptr->material_locations.render_mode_variants[RENDERER_VIEW_MODE_NORMALS] = shader_system_variant_index(s, "normals");
+    } else if (state_ptr->ui_shader_id == INVALID_ID && strings_equal(config->shader_name, "Shader.Builtin.UI")) {
+        state_ptr->ui_shader_id = s->id;
+        state_ptr->ui_locations.projection = shader_system_uniform_index(s, "projection");
+        state_ptr->ui_locations.view = shader_system_uniform_index(s, "view");
+        state_ptr->ui_locations.diffuse_colour = shader_system_uniform_index(s, "diffuse_colour");
+        state_ptr->ui_locations.diffuse_texture = shader_system_uniform_index(s, "diffuse_texture");
+        state_ptr->ui_locations.model = shader_system_uniform_index(s, "model");
+    }
+
+    if (m->generation == INVALID_ID) {
+        m->generation = 0;
+    } else {
+        m->generation++;
+    }
+
+    // Also use the handle as the material id.
+    m->id = handle;
+    return true;
+}
 
 b8 material_system_initialize(u64* memory_requirement, void* state, material_system_config config) {
     if (config.max_material_count == 0) {
@@ -71,11 +149,12 @@ b8 material_system_initialize(u64* memory_requirement, void* state, material_sys
         return false;
     }
 
-    // Block of memory will contain state structure, then block for array, then block for hashtable.
+    // Block of memory will contain state structure, then block for array, then the cache's entries. The hashtable owns its memory.
     u64 struct_requirement = sizeof(material_system_state);
     u64 array_requirement = sizeof(material) * config.max_material_count;
-    u64 hashtable_requirement = sizeof(material_reference) * config.max_material_count;
-    *memory_requirement = struct_requirement + array_requirement + hashtable_requirement;
+    u64 cache_requirement = 0;
+    resource_cache_create(0, config.max_material_count, config.cache_budget, &cache_requirement, 0, 0);
+    *memory_requirement = struct_requirement + array_requirement + cache_requirement;
 
     if (!state) {
         return true;
@@ -93,9 +172,10 @@ b8 material_system_initialize(u64* memory_requirement, void* state, material_sys
     state_ptr->material_locations.normal_texture = INVALID_ID_U16;
     state_ptr->material_locations.ambient_colour = INVALID_ID_U16;
     state_ptr->material_locations.shininess = INVALID_ID_U16;
-    state_ptr->material_locations.model = INVALID_ID_U16;
-    state_ptr->material_locations.render_mode = INVALID_ID_U16;
     state_ptr->material_locations.time = INVALID_ID_U16;
+    for (u32 i = 0; i < 3; ++i) {
+        state_ptr->material_locations.render_mode_variants[i] = INVALID_ID_U8;
+    }
 
     state_ptr->ui_shader_id = INVALID_ID;
     state_ptr->ui_locations.diffuse_colour = INVALID_ID_U16;
@@ -107,12 +187,10 @@ b8 material_system_initialize(u64* memory_requirement, void* state, material_sys
     // The array block is after the state. Already allocated, so just set the pointer.
     void* array_block = state + struct_requirement;
     state_ptr->registered_materials = array_block;
-
-    // Hashtable block is after array.
-    void* hashtable_block = array_block + array_requirement;
+    resource_cache_create("materials", config.max_material_count, config.cache_budget, &cache_requirement, (u8*)array_block + array_requirement, &state_ptr->cache);
 
     // Create a hashtable for material lookups.
-    hashtable_create(sizeof(material_reference), config.max_material_count, hashtable_block, false, &state_ptr->registered_material_table);
+    hashtable_create_with_mode(sizeof(material_reference), config.max_material_count, HASHTABLE_MODE_OPEN_ADDRESSING, 0, false, &state_ptr->registered_material_table);
 
     // Fill the hashtable with invalid references to use as a default.
     material_reference invalid_ref;
@@ -127,7 +205,7 @@ b8 material_system_initialize(u64* memory_requirement, void* state, material_sys
         state_ptr->registered_materials[i].id = INVALID_ID;
         state_ptr->registered_materials[i].generation = INVALID_ID;
         state_ptr->registered_materials[i].internal_id = INVALID_ID;
-        state_ptr->registered_materials[i].render_frame_number = INVALID_ID;
+        state_ptr->registered_materials[i].render_frame_number = INVALID_ID_U64;
     }
 
     if (!create_default_material(state_ptr)) {
@@ -135,12 +213,17 @@ b8 material_system_initialize(u64* memory_requirement, void* state, material_sys
         return false;
     }
 
+    // Cached materials hold on to their textures, so they are let go when GPU memory runs short.
+    event_register(EVENT_CODE_GPU_MEMORY_PRESSURE, state_ptr, material_system_on_memory_pressure);
+
     return true;
 }
 
 void material_system_shutdown(void* state) {
     material_system_state* s = (material_system_state*)state;
     if (s) {
+        event_unregister(EVENT_CODE_GPU_MEMORY_PRESSURE, s, material_system_on_memory_pressure);
+
         // Invalidate all materials in the array.
         u32 count = s->config.max_material_count;
         for (u32 i = 0; i < count; ++i) {
@@ -151,6 +234,9 @@ void material_system_shutdown(void* state) {
 
         // Destroy the default material.
         destroy_material(&s->default_material);
+
+        resource_cache_destroy(&s->cache);
+        hashtable_destroy(&s->registered_material_table);
     }
 
     state_ptr = 0;
@@ -195,65 +281,36 @@ material* material_system_acquire_from_config(material_config config) {
         ref.reference_count++;
         if (ref.handle == INVALID_ID) {
             // This means no material exists here. Find a free index first.
-            u32 count = state_ptr->config.max_material_count;
-            material* m = 0;
-            for (u32 i = 0; i < count; ++i) {
-                if (state_ptr->registered_materials[i].id == INVALID_ID) {
-                    // A free slot has been found. Use its index as the handle.
-                    ref.handle = i;
-                    m = &state_ptr->registered_materials[i];
-                    break;
-                }
-            }
-
-            // Make sure an empty slot was actually found.
-            if (!m || ref.handle == INVALID_ID) {
+            ref.handle = material_slot_find();
+            if (ref.handle == INVALID_ID) {
                 KFATAL("material_system_acquire - Material system cannot hold anymore materials. Adjust configuration to allow more.");
                 return 0;
             }
+            material* m = &state_ptr->registered_materials[ref.handle];
 
             // Create new material.
-            if (!load_material(config, m)) {
+            if (!material_slot_load(&config, m, ref.handle)) {
                 KERROR("Failed to load material '%s'.", config.name);
                 return 0;
             }
-
-            // Get the uniform indices.
-            shader* s = shader_system_get_by_id(m->shader_id);
-            // Save off the locations for known types for quick lookups.
-            if (state_ptr->material_shader_id == INVALID_ID && strings_equal(config.shader_name, "Shader.Builtin.Material")) {
-                state_ptr->material_shader_id = s->id;
-                state_ptr->material_locations.projection = shader_system_uniform_index(s, "projection");
-                state_ptr->material_locations.view = shader_system_uniform_index(s, "view");
-                state_ptr->material_locations.ambient_colour = shader_system_uniform_index(s, "ambient_colour");
-                state_ptr->material_locations.view_position = shader_system_uniform_index(s, "view_position");
-                state_ptr->material_locations.diffuse_colour = shader_system_uniform_index(s, "diffuse_colour");
-                state_ptr->material_locations.diffuse_texture = shader_system_uniform_index(s, "diffuse_texture");
-                state_ptr->material_locations.specular_texture = shader_system_uniform_index(s, "specular_texture");
-                state_ptr->material_locations.normal_texture = shader_system_uniform_index(s, "normal_texture");
-                state_ptr->material_locations.shininess = shader_system_uniform_index(s, "shininess");
-                state_ptr->material_locations.model = shader_system_uniform_index(s, "model");
-                state_ptr->material_locations.render_mode = shader_system_uniform_index(s, "mode");
-                state_ptr->material_locations.time = shader_system_uniform_index(s, "time");
-            } else if (state_ptr->ui_shader_id == INVALID_ID && strings_equal(config.shader_name, "Shader.Builtin.UI")) {
-                state_ptr->ui_shader_id = s->id;
-                state_ptr->ui_locations.projection = shader_system_uniform_index(s, "projection");
-                state_ptr->ui_locations.view = shader_system_uniform_index(s, "view");
-                state_ptr->ui_locations.diffuse_colour = shader_system_uniform_index(s, "diffuse_colour");
-                state_ptr->ui_locations.diffuse_texture = shader_system_uniform_index(s, "diffuse_texture");
-                state_ptr->ui_locations.model = shader_system_uniform_index(s, "model");
-            }
-
-            if (m->generation == INVALID_ID) {
-                m->generation = 0;
-            } else {
-                m->generation++;
-            }
-
-            // Also use the handle as the material id.
-            m->id = ref.handle;
             // KTRACE("Material '%s' does not yet exist. Created, and ref_count is now %i.", config.name, ref.reference_count);
         } else {
+            // Held by the cache since its last release, so back in use as it was.
+            resource_cache_acquire(&state_ptr->cache, ref.handle);
+
+            // Still loading from an async acquire, so loaded now from the config at hand instead,
+            // as the caller expects it loaded. The job finds it loaded and drops what it read.
+            material* m = &state_ptr->registered_materials[ref.handle];
+            if (!material_system_is_loaded(m)) {
+                material temp;
+                if (!material_slot_load(&config, &temp, ref.handle)) {
+                    KERROR("Failed to load material '%s'.", config.name);
+                    temp.internal_id = INVALID_ID;
+                    destroy_material(&temp);
+                } else {
+                    *m = temp;
+                }
+            }
             // KTRACE("Material '%s' already exists, ref_count increased to %i.", config.name, ref.reference_count);
         }
 
@@ -282,13 +339,23 @@ void material_system_release(const char* name) {
         if (ref.reference_count == 0 && ref.auto_release) {
             material* m = &state_ptr->registered_materials[ref.handle];
 
+            // Cached in case it is acquired again, such as by the next material swap, or destroyed if it does not fit.
+            shader* s = shader_system_get_by_id(m->shader_id);
+            u64 size = sizeof(material) + (s ? s->ubo_stride : 0);
+            if (resource_cache_insert(&state_ptr->cache, ref.handle, size)) {
+                hashtable_set(&state_ptr->registered_material_table, name, &ref);
+                material_cache_trim(state_ptr->cache.budget);
+                return;
+            }
+
+            // The entry is no longer needed; a missing name reads back as the invalid reference.
+            // Removed first, as name is generally the material's own name, which is wiped on destroy.
+            hashtable_remove(&state_ptr->registered_material_table, name);
+
             // Destroy/reset material.
             destroy_material(m);
-
-            // Reset the reference.
-            ref.handle = INVALID_ID;
-            ref.auto_release = false;
             // KTRACE("Released material '%s'., Material unloaded because reference count=0 and auto_release=true.", name);
+            return;
         } else {
             // KTRACE("Released material '%s', now has a reference count of '%i' (auto_release=%s).", name, ref.reference_count, ref.auto_release ? "true" : "false");
         }
@@ -300,6 +367,196 @@ void material_system_release(const char* name) {
     }
 }
 
+static b8 material_reload_job_start(void* params, void* result_data) {
+    material_reload_params* reload_params = (material_reload_params*)params;
+    b8 result = resource_system_load(reload_params->resource_name, RESOURCE_TYPE_MATERIAL, 0, &reload_params->material_resource);
+    if (!result || !reload_params->material_resource.data) {
+        reload_params->material_resource.data = 0;
+        result = false;
+    }
+    kcopy_memory(result_data, reload_params, sizeof(material_reload_params));
+    return result;
+}
+
+static void material_reload_job_success(void* params) {
+    material_reload_params* reload_params = (material_reload_params*)params;
+    material_config* config = (material_config*)reload_params->material_resource.data;
+
+    material_reference ref;
+    if (!state_ptr || !hashtable_get(&state_ptr->registered_material_table, config->name, &ref) || ref.handle == INVALID_ID) {
+        KDEBUG("Material '%s' is not loaded; nothing to reload.", config->name);
+        resource_system_unload(&reload_params->material_resource);
+        return;
+    }
+
+    // Build the new material alongside the old one. Its textures are acquired before the old
+    // material releases its own, so shared textures stay loaded.
+    material* m = &state_ptr->registered_materials[ref.handle];
+    material temp;
+    if (!load_material(*config, &temp)) {
+        KERROR("Failed to reload material '%s'; keeping the previous version.", config->name);
+        // Only resources acquired before the failure are released.
+        temp.internal_id = INVALID_ID;
+        destroy_material(&temp);
+        resource_system_unload(&reload_params->material_resource);
+        return;
+    }
+
+    material old = *m;
+    temp.id = old.id;
+    temp.generation = old.generation + 1;
+    temp.render_frame_number = INVALID_ID_U64;
+    destroy_material(&old);
+    *m = temp;
+
+    KINFO("Reloaded material '%s'.", m->name);
+    resource_system_unload(&reload_params->material_resource);
+}
+
+static void material_reload_job_fail(void* params) {
+    material_reload_params* reload_params = (material_reload_params*)params;
+    KERROR("Failed to read material '%s' for reloading.", reload_params->resource_name);
+    if (reload_params->material_resource.data) {
+        resource_system_unload(&reload_params->material_resource);
+    }
+}
+
+static b8 material_load_job_start(void* params, void* result_data) {
+    material_load_params* load_params = (material_load_params*)params;
+    b8 result = resource_system_load(load_params->resource_name, RESOURCE_TYPE_MATERIAL, 0, &load_params->material_resource);
+    if (!result || !load_params->material_resource.data) {
+        load_params->material_resource.data = 0;
+        result = false;
+    }
+    kcopy_memory(result_data, load_params, sizeof(material_load_params));
+    return result;
+}
+
+static void material_load_job_success(void* params) {
+    material_load_params* load_params = (material_load_params*)params;
+    material_config* config = (material_config*)load_params->material_resource.data;
+
+    // Released and destroyed since, or loaded some other way, such as by a synchronous acquire.
+    material_reference ref;
+    material* m = state_ptr ? &state_ptr->registered_materials[load_params->handle] : 0;
+    if (!m || !hashtable_get(&state_ptr->registered_material_table, load_params->resource_name, &ref) || ref.handle != load_params->handle || m->id != ref.handle || material_system_is_loaded(m)) {
+        resource_system_unload(&load_params->material_resource);
+        return;
+    }
+
+    // Registered under the name it was asked for, whatever its file calls it, so it is released by that name.
+    string_ncopy(config->name, load_params->resource_name, MATERIAL_NAME_MAX_LENGTH);
+
+    // Its textures are acquired here, each one loading on its own job alongside the others.
+    material temp;
+    if (!material_slot_load(config, &temp, ref.handle)) {
+        KERROR("Failed to load material '%s'; it is drawn as the default material.", load_params->resource_name);
+        temp.internal_id = INVALID_ID;
+        destroy_material(&temp);
+    } else {
+        *m = temp;
+        ref.auto_release = config->auto_release;
+        hashtable_set(&state_ptr->registered_material_table, load_params->resource_name, &ref);
+    }
+    resource_system_unload(&load_params->material_resource);
+}
+
+static void material_load_job_fail(void* params) {
+    material_load_params* load_params = (material_load_params*)params;
+    KERROR("Failed to read material '%s'; it is drawn as the default material.", load_params->resource_name);
+    if (load_params->material_resource.data) {
+        resource_system_unload(&load_params->material_resource);
+    }
+}
+
+material* material_system_acquire_async(const char* name) {
+    if (!state_ptr || !name) {
+        return 0;
+    }
+    if (strings_equali(name, DEFAULT_MATERIAL_NAME)) {
+        return &state_ptr->default_material;
+    }
+
+    material_reference ref;
+    if (!hashtable_get(&state_ptr->registered_material_table, name, &ref)) {
+        KERROR("material_system_acquire_async failed to acquire material '%s'. Null pointer will be returned.", name);
+        return 0;
+    }
+
+    if (ref.handle != INVALID_ID) {
+        // Loaded, cached or already on its way.
+        resource_cache_acquire(&state_ptr->cache, ref.handle);
+        ref.reference_count++;
+        hashtable_set(&state_ptr->registered_material_table, name, &ref);
+        return &state_ptr->registered_materials[ref.handle];
+    }
+
+    ref.handle = material_slot_find();
+    if (ref.handle == INVALID_ID) {
+        KFATAL("material_system_acquire_async - Material system cannot hold anymore materials. Adjust configuration to allow more.");
+        return 0;
+    }
+
+    // Held as a placeholder, with no resources of its own, until the job loads it. Whether it is
+    // released automatically is only known once its config is read, so it is until then.
+    material* m = &state_ptr->registered_materials[ref.handle];
+    kzero_memory(m, sizeof(material));
+    string_ncopy(m->name, name, MATERIAL_NAME_MAX_LENGTH);
+    m->id = ref.handle;
+    m->generation = INVALID_ID;
+    m->internal_id = INVALID_ID;
+    m->shader_id = INVALID_ID;
+    m->render_frame_number = INVALID_ID_U64;
+    m->diffuse_colour = vec4_one();
+    m->diffuse_uv_rect = (vec4){0.0f, 0.0f, 1.0f, 1.0f};
+    ref.reference_count = 1;
+    ref.auto_release = true;
+    hashtable_set(&state_ptr->registered_material_table, m->name, &ref);
+
+    material_load_params params = {};
+    string_ncopy(params.resource_name, m->name, MATERIAL_NAME_MAX_LENGTH - 1);
+    params.handle = ref.handle;
+    job_info job = job_create(material_load_job_start, material_load_job_success, material_load_job_fail, &params, sizeof(material_load_params), sizeof(material_load_params));
+    job_system_submit(job);
+    return m;
+}
+
+b8 material_system_is_loaded(const material* m) {
+    // Placeholders have no renderer resources until loaded into.
+    return m && m->internal_id != INVALID_ID;
+}
+
+b8 material_system_reload(const char* name) {
+    if (!state_ptr || !name || strings_equali(name, DEFAULT_MATERIAL_NAME)) {
+        return false;
+    }
+
+    material_reload_params params = {};
+    string_ncopy(params.resource_name, name, MATERIAL_NAME_MAX_LENGTH - 1);
+    job_info job = job_create(material_reload_job_start, material_reload_job_success, material_reload_job_fail, &params, sizeof(material_reload_params), sizeof(material_reload_params));
+    job_system_submit(job);
+    return true;
+}
+
+// Destroys the materials released longest ago until those cached take no more than the given size.
+static void material_cache_trim(u64 max_size) {
+    u32 handle;
+    while (resource_cache_evict(&state_ptr->cache, max_size, &handle)) {
+        material* m = &state_ptr->registered_materials[handle];
+        // Removed first, as the name is wiped on destroy.
+        hashtable_remove(&state_ptr->registered_material_table, m->name);
+        destroy_material(m);
+    }
+}
+
+static b8 material_system_on_memory_pressure(u16 code, void* sender, void* listener_inst, event_context context) {
+    if ((renderer_memory_pressure)context.data.u8[0] != RENDERER_MEMORY_PRESSURE_NONE) {
+        material_cache_trim(0);
+    }
+    // Left for other systems to act on too.
+    return false;
+}
+
 material* material_system_get_default() {
     if (state_ptr) {
         return &state_ptr->default_material;
@@ -328,8 +585,12 @@ b8 material_system_apply_global(u32 shader_id, u64 renderer_frame_number, const
         MATERIAL_APPLY_OR_FAIL(shader_system_uniform_set_by_index(state_ptr->material_locations.view, view));
         MATERIAL_APPLY_OR_FAIL(shader_system_uniform_set_by_index(state_ptr->material_locations.ambient_colour, ambient_colour));
         MATERIAL_APPLY_OR_FAIL(shader_system_uniform_set_by_index(state_ptr->material_locations.view_position, view_position));
-        MATERIAL_APPLY_OR_FAIL(shader_system_uniform_set_by_index(state_ptr->material_locations.render_mode, &render_mode));
         MATERIAL_APPLY_OR_FAIL(shader_system_uniform_set_by_index(state_ptr->material_locations.time, &time));
+        // Each render mode is a variant of the shader, so draws need not branch on it.
+        u8 variant = render_mode < 3 ? state_ptr->material_locations.render_mode_variants[render_mode] : INVALID_ID_U8;
+        if (variant != INVALID_ID_U8) {
+            MATERIAL_APPLY_OR_FAIL(shader_system_variant_use(variant));
+        }
     } else if (shader_id == state_ptr->ui_shader_id) {
         MATERIAL_APPLY_OR_FAIL(shader_system_uniform_set_by_index(state_ptr->ui_locations.projection, projection));
         MATERIAL_APPLY_OR_FAIL(shader_system_uniform_set_by_index(state_ptr->ui_locations.view, view));
@@ -370,10 +631,9 @@ b8 material_system_apply_instance(material* m, b8 needs_update) {
 }
 
 b8 material_system_apply_local(material* m, const mat4* model) {
-    if (m->shader_id == state_ptr->material_shader_id) {
-        return shader_system_uniform_set_by_index(state_ptr->material_locations.model, model);
-    } else if (m->shader_id == state_ptr->ui_shader_id) {
-        return shader_system_uniform_set_by_index(state_ptr->ui_locations.model, model);
+    // NOTE: The material shader takes its model matrices from draw data, so is drawn in batches instead.
+    if (m->shader_id == state_ptr->ui_shader_id) {
+        return shader_system_uniform_set_by_index(state_ptr->ui_locations.model, model) && shader_system_apply_local();
     }
 
     KERROR("Unrecognized shader id '%d'", m->shader_id);
@@ -395,15 +655,22 @@ b8 load_material(material_config config, material* m) {
     // Diffuse map
     // TODO: Make this configurable.
     // TODO: DRY
+    // Atlased maps are clamped, so they never sample their neighbours.
+    b8 atlased = config.atlas && string_length(config.diffuse_map_name) > 0;
+    m->diffuse_uv_rect = (vec4){0.0f, 0.0f, 1.0f, 1.0f};
     m->diffuse_map.filter_minify = m->diffuse_map.filter_magnify = TEXTURE_FILTER_MODE_LINEAR;
-    m->diffuse_map.repeat_u = m->diffuse_map.repeat_v = m->diffuse_map.repeat_w = TEXTURE_REPEAT_REPEAT;
+    m->diffuse_map.repeat_u = m->diffuse_map.repeat_v = m->diffuse_map.repeat_w = atlased ? TEXTURE_REPEAT_CLAMP_TO_EDGE : TEXTURE_REPEAT_REPEAT;
     if (!renderer_texture_map_acquire_resources(&m->diffuse_map)) {
         KERROR("Unable to acquire resources for diffuse texture map.");
         return false;
     }
     if (string_length(config.diffuse_map_name) > 0) {
         m->diffuse_map.use = TEXTURE_USE_MAP_DIFFUSE;
-        m->diffuse_map.texture = texture_system_acquire(config.diffuse_map_name, true);
+        if (atlased) {
+            m->diffuse_map.texture = texture_system_acquire_atlased(config.diffuse_map_name, &m->diffuse_uv_rect);
+        } else {
+            m->diffuse_map.texture = texture_system_acquire(config.diffuse_map_name, true);
+        }
         if (!m->diffuse_map.texture) {
             // Configured, but not found.
             KWARN("Unable to load texture '%s' for material '%s', using default.", config.diffuse_map_name, m->name);
@@ -506,7 +773,7 @@ void destroy_material(material* m) {
     m->id = INVALID_ID;
     m->generation = INVALID_ID;
     m->internal_id = INVALID_ID;
-    m->render_frame_number = INVALID_ID;
+    m->render_frame_number = INVALID_ID_U64;
 }
 
 b8 create_default_material(material_system_state* state) {
@@ -517,6 +784,7 @@ b8 create_default_material(material_system_state* state) {
     state->default_material.diffuse_colour = vec4_one();  // white
     state->default_material.diffuse_map.use = TEXTURE_USE_MAP_DIFFUSE;
     state->default_material.diffuse_map.texture = texture_system_get_default_texture();
+    state->default_material.diffuse_uv_rect = (vec4){0.0f, 0.0f, 1.0f, 1.0f};
 
     state->default_material.specular_map.use = TEXTURE_USE_MAP_SPECULAR;
     state->default_material.specular_map.texture = texture_system_get_default_specular_texture();
@@ -23,6 +23,13 @@
 typedef struct material_system_config {
     /** @brief The maximum number of loaded materials. */
     u32 max_material_count;
+    /**
+     * @brief The most memory, in bytes, auto-released materials nothing refers to any more may
+     * keep holding, so that they are there at once if acquired again. A cached material keeps its
+     * textures. Those released longest ago are destroyed to stay within it. If zero, they are
+     * destroyed as soon as they are released.
+     */
+    u64 cache_budget;
 } material_system_config;
 
 /**
@@ -64,6 +71,27 @@ KAPI material* material_system_acquire(const char* name);
  */
 KAPI material* material_system_acquire_from_config(material_config config);
 
+/**
+ * @brief Acquires the material with the given name without waiting for it to load. If it is not
+ * yet loaded, its file is read and parsed on a job, and the material returned is a placeholder,
+ * drawn as the default material, until it is loaded into in place. Its textures then start
+ * loading at once, each on its own job. If the material is already loaded or loading, its
+ * reference counter is incremented. Released with material_system_release, as any other.
+ *
+ * @param name The name of the material to acquire.
+ * @return A pointer to the material, which stays the same once loaded, or 0 on failure.
+ */
+KAPI material* material_system_acquire_async(const char* name);
+
+/**
+ * @brief Indicates if the given material is loaded, rather than a placeholder still waiting on
+ * its job after material_system_acquire_async. Placeholders should be drawn as the default material.
+ *
+ * @param m A constant pointer to the material.
+ * @return True if loaded; otherwise false.
+ */
+KAPI b8 material_system_is_loaded(const material* m);
+
 /**
  * @brief Releases a material with the given name. Ignores non-existant materials.
  * Decreases the reference counter by 1. If the reference counter reaches 0 and
@@ -73,6 +101,17 @@ KAPI material* material_system_acquire_from_config(material_config config);
  */
 KAPI void material_system_release(const char* name);
 
+/**
+ * @brief Reloads the material asset with the given name, such as after its file has changed.
+ * The file is read on a job, and the material is rebuilt from it on the main thread. The material
+ * registered under the name in the file is updated in place, so existing pointers to it see the
+ * change. If the material is not loaded, or the new config fails to load, nothing changes.
+ *
+ * @param name The name of the material asset to reload.
+ * @return True if a reload was started; otherwise false.
+ */
+KAPI b8 material_system_reload(const char* name);
+
 /**
  * @brief Gets a pointer to the default material. Does not reference count.
  */
@@ -87,7 +126,7 @@ KAPI material* material_system_get_default();
  * @param view A constant pointer to a view matrix.
  * @param ambient_colour The ambient colour of the scene.
  * @param view_position The camera position.
- * @param render_mode The render mode.
+ * @param render_mode The render mode, drawn with the variant of the shader named for it, if it has one.
  * @return True on success; otherwise false.
  */
 KAPI b8 material_system_apply_global(u32 shader_id, u64 renderer_frame_number, const mat4* projection, const mat4* view, const vec4* ambient_colour, const vec3* view_position, u32 render_mode, f32 time);
@@ -102,7 +141,8 @@ KAPI b8 material_system_apply_global(u32 shader_id, u64 renderer_frame_number, c
 KAPI b8 material_system_apply_instance(material* m, b8 needs_update);
 
 /**
- * @brief Applies local-level material data (typically just model matrix).
+ * @brief Applies local-level material data (typically just model matrix). Not used by materials of
+ * the material shader, whose model matrices are given with each batch of draws.
  *
  * @param m A pointer to the material to be applied.
  * @param model A constant pointer to the model matrix to be applied.
@@ -4,21 +4,40 @@
 #include "core/logger.h"
 #include "core/kmemory.h"
 #include "core/kstring.h"
+#include "core/uuid.h"
+#include "memory/frame_arena.h"
+#include "renderer/render_graph.h"
 #include "renderer/renderer_frontend.h"
+#include "systems/job_system.h"
 
 // TODO: temporary - make factory and register instead.
 #include "renderer/views/render_view_world.h"
 #include "renderer/views/render_view_ui.h"
 #include "renderer/views/render_view_skybox.h"
 #include "renderer/views/render_view_pick.h"
+#include "renderer/views/render_view_debug.h"
+#include "renderer/views/render_view_particles.h"
+
+// The most packets built in parallel at once. Any more are built by the next run of builds.
+#define RENDER_VIEW_SYSTEM_MAX_PARALLEL_BUILDS 8
+// The size reserved for each parallel build's frame buffers. Only what is used is committed.
+#define RENDER_VIEW_SYSTEM_BUILD_ARENA_SIZE MEBIBYTES(64)
 
 typedef struct render_view_system_state {
     hashtable lookup;
-    void* table_block;
     u32 max_view_count;
     render_view* registered_views;
+    // One per parallel build, as linear allocators cannot be shared between threads.
+    frame_arena build_arenas[RENDER_VIEW_SYSTEM_MAX_PARALLEL_BUILDS];
+    // The images of shared attachments, one per alias slot, each created when first needed.
+    texture shared_attachments[RENDER_GRAPH_MAX_RESOURCES];
 } render_view_system_state;
 
+typedef struct parallel_build_data {
+    render_view_packet_build* builds[RENDER_VIEW_SYSTEM_MAX_PARALLEL_BUILDS];
+    b8 results[RENDER_VIEW_SYSTEM_MAX_PARALLEL_BUILDS];
+} parallel_build_data;
+
 static render_view_system_state* state_ptr = 0;
 
 b8 render_view_system_initialize(u64* memory_requirement, void* state, render_view_system_config config) {
@@ -27,11 +46,10 @@ b8 render_view_system_initialize(u64* memory_requirement, void* state, render_vi
         return false;
     }
 
-    // Block of memory will contain state structure, then block for hashtable, then block for array.
+    // Block of memory will contain state structure, then block for array. The hashtable owns its memory.
     u64 struct_requirement = sizeof(render_view_system_state);
-    u64 hashtable_requirement = sizeof(u16) * config.max_view_count;
     u64 array_requirement = sizeof(render_view) * config.max_view_count;
-    *memory_requirement = struct_requirement + hashtable_requirement + array_requirement;
+    *memory_requirement = struct_requirement + array_requirement;
 
     if (!state) {
         return true;
@@ -40,15 +58,12 @@ b8 render_view_system_initialize(u64* memory_requirement, void* state, render_vi
     state_ptr = state;
     state_ptr->max_view_count = config.max_view_count;
 
-    // The hashtable block is after the state. Already allocated, so just set the pointer.
+    // The array block is after the state. Already allocated, so just set the pointer.
     u64 addr = (u64)state_ptr;
-    state_ptr->table_block = (void*)((u64)addr + struct_requirement);
-
-    // Array block is after hashtable.
-    state_ptr->registered_views = (void*)((u64)state_ptr->table_block + hashtable_requirement);
+    state_ptr->registered_views = (void*)(addr + struct_requirement);
 
     // Create a hashtable for view lookups.
-    hashtable_create(sizeof(u16), state_ptr->max_view_count, state_ptr->table_block, false, &state_ptr->lookup);
+    hashtable_create_with_mode(sizeof(u16), state_ptr->max_view_count, HASHTABLE_MODE_OPEN_ADDRESSING, 0, false, &state_ptr->lookup);
     // Fill the hashtable with invalid ids
     u16 invalid_id = INVALID_ID_U16;
     hashtable_fill(&state_ptr->lookup, &invalid_id);
@@ -58,6 +73,14 @@ b8 render_view_system_initialize(u64* memory_requirement, void* state, render_vi
         state_ptr->registered_views[i].id = INVALID_ID_U16;
     }
 
+    // Double-buffered, as packets are consumed while the next frame's are built.
+    for (u32 i = 0; i < RENDER_VIEW_SYSTEM_MAX_PARALLEL_BUILDS; ++i) {
+        if (!frame_arena_create(RENDER_VIEW_SYSTEM_BUILD_ARENA_SIZE, 2, &state_ptr->build_arenas[i])) {
+            KFATAL("render_view_system_initialize - Failed to create the frame arenas for parallel packet builds.");
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -78,6 +101,18 @@ void render_view_system_shutdown(void* state) {
         }
     }
 
+    hashtable_destroy(&state_ptr->lookup);
+
+    for (u32 i = 0; i < RENDER_VIEW_SYSTEM_MAX_PARALLEL_BUILDS; ++i) {
+        frame_arena_destroy(&state_ptr->build_arenas[i]);
+    }
+
+    for (u32 i = 0; i < RENDER_GRAPH_MAX_RESOURCES; ++i) {
+        if (state_ptr->shared_attachments[i].internal_data) {
+            renderer_texture_destroy(&state_ptr->shared_attachments[i]);
+        }
+    }
+
     state_ptr = 0;
 }
 
@@ -125,6 +160,9 @@ b8 render_view_system_create(const render_view_config* config) {
     // TODO: Leaking the name, create a destroy method and kill this.
     view->name = string_duplicate(config->name);
     view->custom_shader_name = config->custom_shader_name;
+    view->resolution_scaled = config->resolution_scaled;
+    view->lazy_render_targets = config->lazy_render_targets;
+    view->render_targets_generated = false;
     view->renderpass_count = config->pass_count;
     view->passes = kallocate(sizeof(renderpass) * view->renderpass_count, MEMORY_TAG_ARRAY);
 
@@ -146,6 +184,7 @@ b8 render_view_system_create(const render_view_config* config) {
         view->on_destroy = render_view_world_on_destroy;
         view->on_resize = render_view_world_on_resize;
         view->regenerate_attachment_target = 0;
+        view->build_thread_safe = true;
     } else if (config->type == RENDERER_VIEW_KNOWN_TYPE_UI) {
         view->on_build_packet = render_view_ui_on_build_packet;      // For building the packet
         view->on_destroy_packet = render_view_ui_on_destroy_packet;  // For destroying the packet.
@@ -154,6 +193,7 @@ b8 render_view_system_create(const render_view_config* config) {
         view->on_destroy = render_view_ui_on_destroy;
         view->on_resize = render_view_ui_on_resize;
         view->regenerate_attachment_target = 0;
+        view->build_thread_safe = true;
     } else if (config->type == RENDERER_VIEW_KNOWN_TYPE_SKYBOX) {
         view->on_build_packet = render_view_skybox_on_build_packet;      // For building the packet
         view->on_destroy_packet = render_view_skybox_on_destroy_packet;  // For destroying the packet.
@@ -162,6 +202,8 @@ b8 render_view_system_create(const render_view_config* config) {
         view->on_destroy = render_view_skybox_on_destroy;
         view->on_resize = render_view_skybox_on_resize;
         view->regenerate_attachment_target = 0;
+        // Reads the world camera, as the world view does.
+        view->build_thread_safe = false;
     } else if (config->type == RENDERER_VIEW_KNOWN_TYPE_PICK) {
         view->on_build_packet = render_view_pick_on_build_packet;      // For building the packet
         view->on_destroy_packet = render_view_pick_on_destroy_packet;  // For destroying the packet.
@@ -170,6 +212,30 @@ b8 render_view_system_create(const render_view_config* config) {
         view->on_destroy = render_view_pick_on_destroy;
         view->on_resize = render_view_pick_on_resize;
         view->regenerate_attachment_target = render_view_pick_regenerate_attachment_target;
+        // Updates the instances it picks between as it builds.
+        view->build_thread_safe = false;
+    } else if (config->type == RENDERER_VIEW_KNOWN_TYPE_PARTICLES) {
+        view->on_build_packet = render_view_particles_on_build_packet;      // For building the packet
+        view->on_destroy_packet = render_view_particles_on_destroy_packet;  // For destroying the packet.
+        view->on_render = render_view_particles_on_render;                  // For rendering the packet
+        view->on_create = render_view_particles_on_create;
+        view->on_destroy = render_view_particles_on_destroy;
+        view->on_resize = render_view_particles_on_resize;
+        view->regenerate_attachment_target = 0;
+        // Takes what the emitters spawn from the main thread.
+        view->build_thread_safe = false;
+#if defined(KDEBUG_DRAW_ENABLED)
+    } else if (config->type == RENDERER_VIEW_KNOWN_TYPE_DEBUG) {
+        view->on_build_packet = render_view_debug_on_build_packet;      // For building the packet
+        view->on_destroy_packet = render_view_debug_on_destroy_packet;  // For destroying the packet.
+        view->on_render = render_view_debug_on_render;                  // For rendering the packet
+        view->on_create = render_view_debug_on_create;
+        view->on_destroy = render_view_debug_on_destroy;
+        view->on_resize = render_view_debug_on_resize;
+        view->regenerate_attachment_target = 0;
+        // Takes what was drawn from the main thread.
+        view->build_thread_safe = false;
+#endif
     }
 
     // Call the on create
@@ -208,25 +274,206 @@ render_view* render_view_system_get(const char* name) {
     return 0;
 }
 
+render_view* render_view_system_get_by_kname(kname name) {
+    if (state_ptr) {
+        u16 id = INVALID_ID_U16;
+        hashtable_get_by_kname(&state_ptr->lookup, name, &id);
+        if (id != INVALID_ID_U16) {
+            return &state_ptr->registered_views[id];
+        }
+    }
+    return 0;
+}
+
+static void render_targets_generate(render_view* view);
+
+// Creates the targets of a lazy view the first time a packet of it renders to them. Must be called
+// on the main thread, after the build.
+static void lazy_render_targets_resolve(const render_view* view, const render_view_packet* packet) {
+    if (view->lazy_render_targets && !view->render_targets_generated && !packet->targets_unused) {
+        render_targets_generate(&state_ptr->registered_views[view->id]);
+    }
+}
+
 b8 render_view_system_build_packet(const render_view* view, struct linear_allocator* frame_allocator, void* data, struct render_view_packet* out_packet) {
     if (view && out_packet) {
-        return view->on_build_packet(view, frame_allocator, data, out_packet);
+        // Packets are built from the frame allocator only. Any targets are created after, as they may allocate.
+        kmemory_no_alloc_begin("view packet build");
+        b8 result = view->on_build_packet(view, frame_allocator, data, out_packet);
+        kmemory_no_alloc_end();
+        if (!result) {
+            return false;
+        }
+        lazy_render_targets_resolve(view, out_packet);
+        return true;
     }
 
     KERROR("render_view_system_build_packet requires valid pointers to a view and a packet.");
     return false;
 }
 
+static void build_packets_parallel(u32 start, u32 end, void* user_data) {
+    parallel_build_data* data = user_data;
+    for (u32 i = start; i < end; ++i) {
+        render_view_packet_build* build = data->builds[i];
+        linear_allocator* allocator = frame_arena_allocator(&state_ptr->build_arenas[i]);
+        // Any targets are created once back on the calling thread.
+        kmemory_no_alloc_begin("view packet build");
+        data->results[i] = build->view->on_build_packet(build->view, allocator, build->data, build->out_packet);
+        kmemory_no_alloc_end();
+    }
+}
+
+// Builds the gathered thread-safe packets together, returning once all are built.
+static b8 flush_parallel_builds(parallel_build_data* data, u32 count) {
+    if (count == 0) {
+        return true;
+    }
+    // One view per batch, as packets are few and each is built by one function.
+    job_system_parallel_for(count, 1, build_packets_parallel, data);
+
+    b8 success = true;
+    for (u32 i = 0; i < count; ++i) {
+        if (!data->results[i]) {
+            KERROR("Failed to build packet for view '%s'.", data->builds[i]->view->name);
+            success = false;
+            continue;
+        }
+        lazy_render_targets_resolve(data->builds[i]->view, data->builds[i]->out_packet);
+    }
+    return success;
+}
+
+b8 render_view_system_build_packets(u32 count, render_view_packet_build* builds, struct linear_allocator* frame_allocator) {
+    if (!state_ptr || !builds) {
+        KERROR("render_view_system_build_packets requires the system to be initialized and a valid array of builds.");
+        return false;
+    }
+
+    // Runs of builds one after another may use the same arenas, so all move on to their next buffer up front.
+    for (u32 i = 0; i < RENDER_VIEW_SYSTEM_MAX_PARALLEL_BUILDS; ++i) {
+        frame_arena_begin_frame(&state_ptr->build_arenas[i]);
+    }
+
+    b8 success = true;
+    parallel_build_data parallel = {0};
+    u32 parallel_count = 0;
+    for (u32 i = 0; i < count; ++i) {
+        render_view_packet_build* build = &builds[i];
+        if (build->view && build->view->build_thread_safe) {
+            // A run is built once it has as many builds as there are arenas, after which they are free again.
+            if (parallel_count == RENDER_VIEW_SYSTEM_MAX_PARALLEL_BUILDS) {
+                success &= flush_parallel_builds(&parallel, parallel_count);
+                parallel_count = 0;
+            }
+            parallel.builds[parallel_count++] = build;
+            continue;
+        }
+
+        // Anything not thread-safe may depend on the builds before it, so waits for them.
+        success &= flush_parallel_builds(&parallel, parallel_count);
+        parallel_count = 0;
+
+        if (!render_view_system_build_packet(build->view, frame_allocator, build->data, build->out_packet)) {
+            KERROR("Failed to build packet for view '%s'.", build->view ? build->view->name : "unknown");
+            success = false;
+        }
+    }
+    success &= flush_parallel_builds(&parallel, parallel_count);
+
+    return success;
+}
+
 b8 render_view_system_on_render(const render_view* view, const render_view_packet* packet, u64 frame_number, u64 render_target_index) {
     if (view && packet) {
-        return view->on_render(view, packet, frame_number, render_target_index);
+        kmemory_no_alloc_begin("view render");
+        b8 result = view->on_render(view, packet, frame_number, render_target_index);
+        kmemory_no_alloc_end();
+        return result;
     }
 
     KERROR("render_view_system_on_render requires a valid pointer to a data.");
     return false;
 }
 
+// True if the render targets of the view must be regenerated. That is the case if they were never generated,
+// if they render to the window, whose images go with the swapchain, or if they render to images of the
+// view which are no longer the size of the pass. It is decided for the whole view, since its passes may
+// share images.
+static b8 render_targets_regenerate_needed(const render_view* view) {
+    for (u64 r = 0; r < view->renderpass_count; ++r) {
+        const renderpass* pass = &view->passes[r];
+        u32 width = (u32)pass->render_area.z;
+        u32 height = (u32)pass->render_area.w;
+        for (u8 i = 0; i < pass->render_target_count; ++i) {
+            const render_target* target = &pass->targets[i];
+            for (u32 a = 0; a < target->attachment_count; ++a) {
+                const render_target_attachment* attachment = &target->attachments[a];
+                if (!attachment->texture || attachment->source == RENDER_TARGET_ATTACHMENT_SOURCE_DEFAULT) {
+                    return true;
+                }
+                if (attachment->texture->width != width || attachment->texture->height != height) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+// Obtains the shared image of the given attachment, created, or created again, if it does not yet
+// exist at the given size. Attachments of one slot are of the same size, as only such are aliased.
+static texture* shared_attachment_get(const render_target_attachment* attachment, u32 width, u32 height) {
+    if (attachment->alias_slot >= RENDER_GRAPH_MAX_RESOURCES) {
+        KERROR("Shared attachment has an invalid alias slot %u.", attachment->alias_slot);
+        return 0;
+    }
+    texture* t = &state_ptr->shared_attachments[attachment->alias_slot];
+    b8 depth = attachment->type == RENDER_TARGET_ATTACHMENT_TYPE_DEPTH;
+    if (t->internal_data && t->width == width && t->height == height && ((t->flags & TEXTURE_FLAG_DEPTH) != 0) == depth) {
+        return t;
+    }
+
+    if (t->internal_data) {
+        renderer_texture_destroy(t);
+        kzero_memory(t, sizeof(texture));
+    }
+
+    // Generate a UUID to act as the texture name.
+    uuid texture_name_uuid = uuid_generate();
+    t->id = INVALID_ID;
+    t->type = TEXTURE_TYPE_2D;
+    string_ncopy(t->name, texture_name_uuid.value, TEXTURE_NAME_MAX_LENGTH);
+    t->width = width;
+    t->height = height;
+    t->channel_count = 4;
+    t->generation = INVALID_ID;
+    t->flags = TEXTURE_FLAG_IS_WRITEABLE;
+    if (depth) {
+        t->flags |= TEXTURE_FLAG_DEPTH;
+    }
+    // Never transient, as a later attachment of the slot may keep its contents between passes.
+    t->internal_data = 0;
+    renderer_texture_create_writeable(t);
+    return t;
+}
+
 void render_view_system_regenerate_render_targets(render_view* view) {
+    // Targets created lazily are first created for the first packet to render to them.
+    if (view->lazy_render_targets && !view->render_targets_generated) {
+        return;
+    }
+    render_targets_generate(view);
+}
+
+static void render_targets_generate(render_view* view) {
+    view->render_targets_generated = true;
+
+    // Targets which already match are kept as they are.
+    if (!render_targets_regenerate_needed(view)) {
+        return;
+    }
+
     // Create render targets for each. TODO: Should be configurable.
 
     for (u64 r = 0; r < view->renderpass_count; ++r) {
@@ -235,7 +482,6 @@ void render_view_system_regenerate_render_targets(render_view* view) {
         for (u8 i = 0; i < pass->render_target_count; ++i) {
             render_target* target = &pass->targets[i];
             // Destroy the old first if it exists.
-            // TODO: check if a resize is actually needed for this target.
             renderer_render_target_destroy(target, false);
 
             for (u32 a = 0; a < target->attachment_count; ++a) {
@@ -258,6 +504,11 @@ void render_view_system_regenerate_render_targets(render_view* view) {
                             KERROR("View failed to regenerate attachment target for attachment type: 0x%x", attachment->type);
                         }
                     }
+                } else if (attachment->source == RENDER_TARGET_ATTACHMENT_SOURCE_SHARED) {
+                    attachment->texture = shared_attachment_get(attachment, (u32)pass->render_area.z, (u32)pass->render_area.w);
+                    if (!attachment->texture) {
+                        continue;
+                    }
                 }
             }
 
@@ -12,6 +12,7 @@
 #pragma once
 
 #include "defines.h"
+#include "core/kname.h"
 #include "math/math_types.h"
 #include "renderer/renderer_types.inl"
 
@@ -65,7 +66,17 @@ KAPI void render_view_system_on_window_resize(u32 width, u32 height);
 KAPI render_view* render_view_system_get(const char* name);
 
 /**
- * @brief Builds a render view packet using the provided view and meshes.
+ * @brief Obtains a pointer to a view with the given pre-hashed name. Avoids
+ * hashing the name, so prefer this for lookups made every frame.
+ *
+ * @param name The kname of the view.
+ * @return A pointer to a view if found; otherwise 0.
+ */
+KAPI render_view* render_view_system_get_by_kname(kname name);
+
+/**
+ * @brief Builds a render view packet using the provided view and meshes. Creates the targets of a
+ * lazy view if this is the first packet to render to them.
  *
  * @param view A pointer to the view to use.
  * @param frame_allocator An allocator used this frame to build a packet.
@@ -75,6 +86,31 @@ KAPI render_view* render_view_system_get(const char* name);
  */
 KAPI b8 render_view_system_build_packet(const render_view* view, struct linear_allocator* frame_allocator, void* data, struct render_view_packet* out_packet);
 
+/** @brief A packet to be built by render_view_system_build_packets. */
+typedef struct render_view_packet_build {
+    /** @brief A pointer to the view to use. */
+    const render_view* view;
+    /** @brief Freeform data used to build the packet. */
+    void* data;
+    /** @brief A pointer to hold the generated packet. */
+    struct render_view_packet* out_packet;
+} render_view_packet_build;
+
+/**
+ * @brief Builds the packets of several views, in the order given. Consecutive views whose builds
+ * are thread-safe are built together in parallel jobs, each allocating from a frame arena of its
+ * own. Any other view is built on the calling thread with the given allocator, once the builds
+ * before it are done, so it may use what they produced, and the builds after it may use what it
+ * resolves, such as the view matrix of a camera. Should be called once a frame, as the arenas move
+ * on to their next buffer with every call.
+ *
+ * @param count The number of packets to build.
+ * @param builds An array of the packets to build.
+ * @param frame_allocator An allocator used this frame, for the builds which are not thread-safe.
+ * @return True if every packet was built; otherwise false.
+ */
+KAPI b8 render_view_system_build_packets(u32 count, render_view_packet_build* builds, struct linear_allocator* frame_allocator);
+
 /**
  * @brief Uses the given view and packet to render the contents therein.
  *
@@ -86,4 +122,11 @@ KAPI b8 render_view_system_build_packet(const render_view* view, struct linear_a
  */
 KAPI b8 render_view_system_on_render(const render_view* view, const render_view_packet* packet, u64 frame_number, u64 render_target_index);
 
+/**
+ * @brief Regenerates the render targets of the given view, if any are not the size of their passes
+ * or render to the window. Those of a lazy view wait for the first packet to render to them.
+ * Shared attachments are taken from the images the system keeps for each alias slot.
+ *
+ * @param view A pointer to the view.
+ */
 KAPI void render_view_system_regenerate_render_targets(render_view* view);
@@ -1,7 +1,13 @@
 #include "resource_system.h"
 
+#include "core/counters.h"
 #include "core/logger.h"
+#include "core/kmemory.h"
+#include "core/kmutex.h"
 #include "core/kstring.h"
+#include "platform/async_io.h"
+#include "platform/platform.h"
+#include "resources/asset_archive.h"
 
 // Known resource loaders.
 #include "resources/loaders/text_loader.h"
@@ -13,9 +19,44 @@
 #include "resources/loaders/bitmap_font_loader.h"
 #include "resources/loaders/system_font_loader.h"
 
+/** @brief The longest name of a resource which is shared, including its terminator. Longer ones are loaded unshared. */
+#define RESOURCE_CACHE_MAX_NAME_LENGTH 256
+
+typedef enum resource_cache_entry_state {
+    RESOURCE_CACHE_ENTRY_FREE = 0,
+    RESOURCE_CACHE_ENTRY_LOADING,
+    RESOURCE_CACHE_ENTRY_LOADED
+} resource_cache_entry_state;
+
+// A resource shared between everyone who acquired it.
+typedef struct resource_cache_entry {
+    resource_cache_entry_state state;
+    resource_type type;
+    char name[RESOURCE_CACHE_MAX_NAME_LENGTH];
+    u32 ref_count;
+    // Set when the resource is invalidated while in use, so that it is unloaded on its last release
+    // rather than kept, and is not handed out again.
+    b8 stale;
+    // When the resource was last released, so the least recently used is evicted first.
+    u64 release_tick;
+    resource resource;
+} resource_cache_entry;
+
 typedef struct resource_system_state {
     resource_system_config config;
     resource_loader* registered_loaders;
+    asset_archive archives[RESOURCE_SYSTEM_MAX_ARCHIVES];
+    u32 archive_count;
+
+    // Shared resources, or 0 if none are kept. Guarded by cache_mutex, as loads are made on job threads.
+    resource_cache_entry* cache;
+    kmutex cache_mutex;
+    // The total data size of shared resources no one holds, which is kept within config.cache_budget.
+    u64 cache_unreferenced_size;
+    u64 cache_tick;
+    u32 cache_hits_counter;
+    u32 cache_misses_counter;
+    u32 cache_size_gauge;
 } resource_system_state;
 
 static resource_system_state* state_ptr = 0;
@@ -28,7 +69,7 @@ b8 resource_system_initialize(u64* memory_requirement, void* state, resource_sys
         return false;
     }
 
-    *memory_requirement = sizeof(resource_system_state) + (sizeof(resource_loader) * config.max_loader_count);
+    *memory_requirement = sizeof(resource_system_state) + (sizeof(resource_loader) * config.max_loader_count) + (sizeof(resource_cache_entry) * config.max_cached_count);
 
     if (!state) {
         return true;
@@ -46,6 +87,20 @@ b8 resource_system_initialize(u64* memory_requirement, void* state, resource_sys
         state_ptr->registered_loaders[i].id = INVALID_ID;
     }
 
+    state_ptr->cache = 0;
+    if (config.max_cached_count) {
+        if (!kmutex_create(&state_ptr->cache_mutex)) {
+            KERROR("Unable to create the resource cache mutex; resources will not be shared.");
+        } else {
+            // Entries are zeroed, so all start free.
+            state_ptr->cache = array_block + (sizeof(resource_loader) * config.max_loader_count);
+            kzero_memory(state_ptr->cache, sizeof(resource_cache_entry) * config.max_cached_count);
+            state_ptr->cache_hits_counter = counter_register("resources.cache_hits", COUNTER_TYPE_COUNTER);
+            state_ptr->cache_misses_counter = counter_register("resources.cache_misses", COUNTER_TYPE_COUNTER);
+            state_ptr->cache_size_gauge = counter_register("resources.cache_unreferenced_bytes", COUNTER_TYPE_GAUGE);
+        }
+    }
+
     // NOTE: Auto-register known loader types here.
     resource_system_register_loader(text_resource_loader_create());
     resource_system_register_loader(binary_resource_loader_create());
@@ -63,6 +118,23 @@ b8 resource_system_initialize(u64* memory_requirement, void* state, resource_sys
 
 void resource_system_shutdown(void* state) {
     if (state_ptr) {
+        if (state_ptr->cache) {
+            for (u32 i = 0; i < state_ptr->config.max_cached_count; ++i) {
+                resource_cache_entry* entry = &state_ptr->cache[i];
+                if (entry->state == RESOURCE_CACHE_ENTRY_LOADED) {
+                    if (entry->ref_count) {
+                        KWARN("Shared resource '%s' is still held by %u users at shutdown.", entry->name, entry->ref_count);
+                    }
+                    resource_system_unload(&entry->resource);
+                }
+            }
+            kmutex_destroy(&state_ptr->cache_mutex);
+            state_ptr->cache = 0;
+        }
+        for (u32 i = 0; i < state_ptr->archive_count; ++i) {
+            asset_archive_close(&state_ptr->archives[i]);
+        }
+        state_ptr->archive_count = 0;
         state_ptr = 0;
     }
 }
@@ -96,23 +168,206 @@ b8 resource_system_register_loader(resource_loader loader) {
     return false;
 }
 
-b8 resource_system_load(const char* name, resource_type type, void* params, resource* out_resource) {
+static resource_loader* loader_find(resource_type type) {
     if (state_ptr && type != RESOURCE_TYPE_CUSTOM) {
-        // Select loader.
         u32 count = state_ptr->config.max_loader_count;
         for (u32 i = 0; i < count; ++i) {
             resource_loader* l = &state_ptr->registered_loaders[i];
             if (l->id != INVALID_ID && l->type == type) {
-                return load(name, l, params, out_resource);
+                return l;
             }
         }
     }
+    return 0;
+}
+
+b8 resource_system_load(const char* name, resource_type type, void* params, resource* out_resource) {
+    // Select loader.
+    resource_loader* l = loader_find(type);
+    if (l) {
+        return load(name, l, params, out_resource);
+    }
 
     out_resource->loader_id = INVALID_ID;
     KERROR("resource_system_load - No loader for type %d was found.", type);
     return false;
 }
 
+// Finds the shared resource of the given type and name, skipping stale ones. The cache mutex must be held.
+static resource_cache_entry* cache_find(const char* name, resource_type type) {
+    for (u32 i = 0; i < state_ptr->config.max_cached_count; ++i) {
+        resource_cache_entry* entry = &state_ptr->cache[i];
+        if (entry->state != RESOURCE_CACHE_ENTRY_FREE && !entry->stale && entry->type == type && strings_equal(entry->name, name)) {
+            return entry;
+        }
+    }
+    return 0;
+}
+
+// Unloads a shared resource and frees its entry. The cache mutex must be held.
+static void cache_evict(resource_cache_entry* entry) {
+    if (entry->ref_count == 0) {
+        state_ptr->cache_unreferenced_size -= entry->resource.data_size;
+    }
+    resource_system_unload(&entry->resource);
+    kzero_memory(entry, sizeof(resource_cache_entry));
+}
+
+// The least recently released resource no one holds, or 0 if every one is held. The cache mutex must be held.
+static resource_cache_entry* cache_least_recently_used(void) {
+    resource_cache_entry* oldest = 0;
+    for (u32 i = 0; i < state_ptr->config.max_cached_count; ++i) {
+        resource_cache_entry* entry = &state_ptr->cache[i];
+        if (entry->state == RESOURCE_CACHE_ENTRY_LOADED && entry->ref_count == 0 && (!oldest || entry->release_tick < oldest->release_tick)) {
+            oldest = entry;
+        }
+    }
+    return oldest;
+}
+
+// Evicts resources no one holds until those left fit the budget. The cache mutex must be held.
+static void cache_trim(void) {
+    resource_cache_entry* entry;
+    while (state_ptr->cache_unreferenced_size > state_ptr->config.cache_budget && (entry = cache_least_recently_used())) {
+        cache_evict(entry);
+    }
+    counter_set(state_ptr->cache_size_gauge, (i64)state_ptr->cache_unreferenced_size);
+}
+
+b8 resource_system_acquire(const char* name, resource_type type, void* params, resource* out_resource) {
+    // Loads with parameters may differ from one another, so only those without are shared.
+    if (!state_ptr || !state_ptr->cache || params || !name || string_length(name) >= RESOURCE_CACHE_MAX_NAME_LENGTH) {
+        return resource_system_load(name, type, params, out_resource);
+    }
+    resource_loader* loader = loader_find(type);
+    if (!loader) {
+        out_resource->loader_id = INVALID_ID;
+        KERROR("resource_system_acquire - No loader for type %d was found.", type);
+        return false;
+    }
+
+    kmutex_lock(&state_ptr->cache_mutex);
+    resource_cache_entry* entry;
+    while ((entry = cache_find(name, type)) && entry->state == RESOURCE_CACHE_ENTRY_LOADING) {
+        // Someone else is loading it already, so wait for them rather than loading it twice.
+        kmutex_unlock(&state_ptr->cache_mutex);
+        platform_sleep(1);
+        kmutex_lock(&state_ptr->cache_mutex);
+    }
+    if (entry) {
+        if (entry->ref_count == 0) {
+            state_ptr->cache_unreferenced_size -= entry->resource.data_size;
+            counter_set(state_ptr->cache_size_gauge, (i64)state_ptr->cache_unreferenced_size);
+        }
+        entry->ref_count++;
+        *out_resource = entry->resource;
+        kmutex_unlock(&state_ptr->cache_mutex);
+        counter_add(state_ptr->cache_hits_counter, 1);
+        return true;
+    }
+
+    // Take a free entry, or make one by evicting the least recently used.
+    for (u32 i = 0; i < state_ptr->config.max_cached_count && !entry; ++i) {
+        if (state_ptr->cache[i].state == RESOURCE_CACHE_ENTRY_FREE) {
+            entry = &state_ptr->cache[i];
+        }
+    }
+    if (!entry && (entry = cache_least_recently_used())) {
+        cache_evict(entry);
+        counter_set(state_ptr->cache_size_gauge, (i64)state_ptr->cache_unreferenced_size);
+    }
+    if (!entry) {
+        // Every entry is held, so this one is not shared.
+        kmutex_unlock(&state_ptr->cache_mutex);
+        return load(name, loader, 0, out_resource);
+    }
+    entry->state = RESOURCE_CACHE_ENTRY_LOADING;
+    entry->type = type;
+    string_ncopy(entry->name, name, RESOURCE_CACHE_MAX_NAME_LENGTH - 1);
+    entry->ref_count = 1;
+    kmutex_unlock(&state_ptr->cache_mutex);
+    counter_add(state_ptr->cache_misses_counter, 1);
+
+    // The entry's own copy of the name is passed, as loaders may keep it as the resource name.
+    resource loaded = {};
+    b8 result = load(entry->name, loader, 0, &loaded);
+
+    kmutex_lock(&state_ptr->cache_mutex);
+    if (result) {
+        entry->resource = loaded;
+        entry->state = RESOURCE_CACHE_ENTRY_LOADED;
+        *out_resource = loaded;
+    } else {
+        kzero_memory(entry, sizeof(resource_cache_entry));
+        out_resource->loader_id = INVALID_ID;
+    }
+    kmutex_unlock(&state_ptr->cache_mutex);
+    return result;
+}
+
+void resource_system_release(resource* resource) {
+    if (!resource) {
+        return;
+    }
+    if (state_ptr && state_ptr->cache && resource->loader_id != INVALID_ID) {
+        kmutex_lock(&state_ptr->cache_mutex);
+        // Every load makes its own copy of the full path, so it tells shared resources apart.
+        for (u32 i = 0; i < state_ptr->config.max_cached_count; ++i) {
+            resource_cache_entry* entry = &state_ptr->cache[i];
+            if (entry->state != RESOURCE_CACHE_ENTRY_LOADED || entry->ref_count == 0 || entry->resource.full_path != resource->full_path ||
+                entry->resource.data != resource->data) {
+                continue;
+            }
+            entry->ref_count--;
+            if (entry->ref_count == 0) {
+                if (entry->stale) {
+                    cache_evict(entry);
+                } else {
+                    entry->release_tick = ++state_ptr->cache_tick;
+                    state_ptr->cache_unreferenced_size += entry->resource.data_size;
+                    cache_trim();
+                }
+            }
+            kmutex_unlock(&state_ptr->cache_mutex);
+            kzero_memory(resource, sizeof(struct resource));
+            resource->loader_id = INVALID_ID;
+            return;
+        }
+        kmutex_unlock(&state_ptr->cache_mutex);
+    }
+    // It was not shared, so it is the caller's alone.
+    resource_system_unload(resource);
+}
+
+b8 resource_system_is_pending(const char* name, resource_type type) {
+    if (!state_ptr || !state_ptr->cache || !name) {
+        return false;
+    }
+    kmutex_lock(&state_ptr->cache_mutex);
+    resource_cache_entry* entry = cache_find(name, type);
+    b8 pending = entry && entry->state == RESOURCE_CACHE_ENTRY_LOADING;
+    kmutex_unlock(&state_ptr->cache_mutex);
+    return pending;
+}
+
+void resource_system_invalidate(const char* name, resource_type type) {
+    if (!state_ptr || !state_ptr->cache || !name) {
+        return;
+    }
+    kmutex_lock(&state_ptr->cache_mutex);
+    resource_cache_entry* entry = cache_find(name, type);
+    if (entry) {
+        if (entry->state == RESOURCE_CACHE_ENTRY_LOADED && entry->ref_count == 0) {
+            cache_evict(entry);
+            counter_set(state_ptr->cache_size_gauge, (i64)state_ptr->cache_unreferenced_size);
+        } else {
+            // Whoever holds it keeps the old version until they release it.
+            entry->stale = true;
+        }
+    }
+    kmutex_unlock(&state_ptr->cache_mutex);
+}
+
 b8 resource_system_load_custom(const char* name, const char* custom_type, void* params, resource* out_resource) {
     if (state_ptr && custom_type && string_length(custom_type) > 0) {
         // Select loader.
@@ -150,6 +405,113 @@ const char* resource_system_base_path() {
     return "";
 }
 
+resource_import_mode resource_system_import_mode() {
+    return state_ptr ? state_ptr->config.import_mode : RESOURCE_IMPORT_MODE_AS_NEEDED;
+}
+
+b8 resource_system_should_find(b8 is_binary) {
+    resource_import_mode mode = resource_system_import_mode();
+    return is_binary ? mode != RESOURCE_IMPORT_MODE_ALWAYS : mode != RESOURCE_IMPORT_MODE_NEVER;
+}
+
+b8 resource_system_mount_archive(const char* path) {
+    if (!state_ptr) {
+        KERROR("resource_system_mount_archive called before initialization.");
+        return false;
+    }
+    if (state_ptr->archive_count == RESOURCE_SYSTEM_MAX_ARCHIVES) {
+        KERROR("resource_system_mount_archive - the max of %u archives are already mounted.", RESOURCE_SYSTEM_MAX_ARCHIVES);
+        return false;
+    }
+    asset_archive* archive = &state_ptr->archives[state_ptr->archive_count];
+    if (!asset_archive_open(path, archive)) {
+        return false;
+    }
+    state_ptr->archive_count++;
+    KINFO("Mounted asset archive '%s' of %u files.", path, archive->entry_count);
+    return true;
+}
+
+// Finds the archive entry for the given path, which is named relative to the base path.
+static const asset_archive_entry* archive_find(const char* path, const asset_archive** out_archive) {
+    if (!state_ptr || state_ptr->archive_count == 0) {
+        return 0;
+    }
+    const char* base_path = state_ptr->config.asset_base_path;
+    u64 base_length = string_length(base_path);
+    const char* name = path;
+    if (strings_nequal(path, base_path, base_length) && path[base_length] == '/') {
+        name = path + base_length + 1;
+        // Loaders with no type path leave an empty path segment.
+        while (*name == '/') {
+            name++;
+        }
+    }
+    for (u32 i = 0; i < state_ptr->archive_count; ++i) {
+        const asset_archive_entry* entry = asset_archive_find(&state_ptr->archives[i], name);
+        if (entry) {
+            *out_archive = &state_ptr->archives[i];
+            return entry;
+        }
+    }
+    return 0;
+}
+
+b8 resource_system_file_exists(const char* path) {
+    const asset_archive* archive;
+    return archive_find(path, &archive) || filesystem_exists(path);
+}
+
+b8 resource_system_file_open(const char* path, resource_file* out_file) {
+    kzero_memory(out_file, sizeof(resource_file));
+
+    const asset_archive* archive;
+    const asset_archive_entry* entry = archive_find(path, &archive);
+    if (entry) {
+        out_file->size = entry->size;
+        if (entry->compression == ASSET_ARCHIVE_COMPRESSION_NONE) {
+            out_file->data = entry->size ? asset_archive_entry_data(archive, entry) : 0;
+            return true;
+        }
+        out_file->allocated = kallocate(entry->size, MEMORY_TAG_RESOURCE);
+        if (!asset_archive_read(archive, entry, out_file->allocated)) {
+            resource_system_file_close(out_file);
+            return false;
+        }
+        out_file->data = out_file->allocated;
+        return true;
+    }
+
+    if (async_io_system_is_running()) {
+        // Read with several reads in flight, which lets a fiber job give up its thread while it waits.
+        void* data;
+        u64 size;
+        if (!async_io_read_file(path, MEMORY_TAG_RESOURCE, &data, &size)) {
+            return false;
+        }
+        out_file->allocated = data;
+        out_file->data = data;
+        out_file->size = size;
+        return true;
+    }
+
+    // Map rather than read the file, so it is not copied and only the pages used are read in.
+    if (!filesystem_map(path, &out_file->mapping)) {
+        return false;
+    }
+    out_file->data = out_file->mapping.data;
+    out_file->size = out_file->mapping.size;
+    return true;
+}
+
+void resource_system_file_close(resource_file* file) {
+    if (file->allocated) {
+        kfree(file->allocated, file->size, MEMORY_TAG_RESOURCE);
+    }
+    filesystem_unmap(&file->mapping);
+    kzero_memory(file, sizeof(resource_file));
+}
+
 b8 load(const char* name, resource_loader* loader, void* params, resource* out_resource) {
     if (!name || !loader || !loader->load || !out_resource) {
         if (out_resource) {
@@ -159,5 +521,6 @@ b8 load(const char* name, resource_loader* loader, void* params, resource* out_r
     }
 
     out_resource->loader_id = loader->id;
+    out_resource->loader_data = 0;
     return loader->load(loader, name, params, out_resource);
 }
\ No newline at end of file
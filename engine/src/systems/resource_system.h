@@ -13,16 +13,54 @@
 
 #pragma once
 
+#include "platform/filesystem.h"
 #include "resources/resource_types.h"
 
+/** @brief The most asset archives which can be mounted at once. */
+#define RESOURCE_SYSTEM_MAX_ARCHIVES 8
+
+/**
+ * @brief Controls whether loaders which import source files into binary runtime formats, such as
+ * meshes and fonts, use the binary versions or the source files.
+ */
+typedef enum resource_import_mode {
+    /** @brief Use the binary version if there is one; otherwise import the source and write it. */
+    RESOURCE_IMPORT_MODE_AS_NEEDED = 0,
+    /** @brief Always import the source, rewriting the binary version. Used when cooking assets. */
+    RESOURCE_IMPORT_MODE_ALWAYS,
+    /** @brief Never import, so that loading fails for assets which have not been cooked. */
+    RESOURCE_IMPORT_MODE_NEVER
+} resource_import_mode;
+
 /** @brief The configuration for the resource system */
 typedef struct resource_system_config {
     /** @brief The maximum number of loaders that can be registered with this system. */
     u32 max_loader_count;
     /** @brief The relative base path for assets. */
     char* asset_base_path;
+    /** @brief Whether source files are imported. */
+    resource_import_mode import_mode;
+    /** @brief The most resources shared through resource_system_acquire at once. 0 turns sharing off. */
+    u32 max_cached_count;
+    /** @brief The total data size in bytes of shared resources kept once no one holds them, evicting the least recently used first. */
+    u64 cache_budget;
 } resource_system_config;
 
+/**
+ * @brief The contents of an asset file, found in a mounted archive or else read from
+ * the loose file. Released with resource_system_file_close.
+ */
+typedef struct resource_file {
+    /** @brief The contents of the file, or 0 if it is empty. Must not be written to. */
+    const void* data;
+    /** @brief The size of the contents in bytes. */
+    u64 size;
+    /** @brief The mapping of the loose file, if the contents are mapped from one. */
+    file_mapping mapping;
+    /** @brief The memory holding the contents, if they were decompressed or read into it. */
+    void* allocated;
+} resource_file;
+
 /** @brief An "interface" for a resource loader. All registered loaders use this. */
 typedef struct resource_loader {
     /** @brief The loader identifier. */
@@ -107,5 +145,92 @@ KAPI b8 resource_system_load_custom(const char* name, const char* custom_type, v
  */
 KAPI void resource_system_unload(resource* resource);
 
+/**
+ * @brief Gets a resource of the given name, shared with everyone else who acquires it. Only the first
+ * acquire loads it; if that load is still in progress, later ones wait for it rather than loading it
+ * again. Shared resources must not be written to, and are released with resource_system_release.
+ * Loads with params, or when sharing is off, are not shared.
+ * 
+ * @param name The name of the resource to load.
+ * @param type The type of resource to load.
+ * @param params Parameters to be passed to the loader, or 0.
+ * @param out_resource A pointer to hold the resource.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 resource_system_acquire(const char* name, resource_type type, void* params, resource* out_resource);
+
+/**
+ * @brief Releases a resource got from resource_system_acquire. Once no one holds it, it is kept for
+ * the next acquire within the cache budget.
+ * 
+ * @param resource A pointer to the resource to be released.
+ */
+KAPI void resource_system_release(resource* resource);
+
+/**
+ * @brief Indicates if a shared resource of the given name is being loaded.
+ * 
+ * @param name The name of the resource.
+ * @param type The type of the resource.
+ * @return True if it is being loaded; otherwise false.
+ */
+KAPI b8 resource_system_is_pending(const char* name, resource_type type);
+
+/**
+ * @brief Drops the shared resource of the given name, such as when its file has changed, so the next
+ * acquire loads it again. Anyone holding it keeps the old version until they release it.
+ * 
+ * @param name The name of the resource.
+ * @param type The type of the resource.
+ */
+KAPI void resource_system_invalidate(const char* name, resource_type type);
+
 /** @brief Returns the base path of the resource system. */
 KAPI const char* resource_system_base_path();
+
+/** @brief Returns the import mode of the resource system, or RESOURCE_IMPORT_MODE_AS_NEEDED before initialization. */
+KAPI resource_import_mode resource_system_import_mode();
+
+/**
+ * @brief Indicates if a loader should look for a file of the given kind, as per the import mode.
+ *
+ * @param is_binary True for a binary runtime format; false for a source file which is imported.
+ * @return True if files of that kind should be looked for; otherwise false.
+ */
+KAPI b8 resource_system_should_find(b8 is_binary);
+
+/**
+ * @brief Mounts the asset archive at path, so that the files in it are found there rather
+ * than opened one by one. Archives are searched in the order they were mounted, before loose
+ * files. Should be done before loading begins, as mounting is not thread-safe.
+ *
+ * @param path The path of the archive.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 resource_system_mount_archive(const char* path);
+
+/**
+ * @brief Indicates if the asset file at path exists, either in a mounted archive or as a loose file.
+ *
+ * @param path The path of the file, starting with the base path, as loaders build it.
+ * @return True if the file exists; otherwise false.
+ */
+KAPI b8 resource_system_file_exists(const char* path);
+
+/**
+ * @brief Opens the asset file at path, looking in the mounted archives before the loose files.
+ * Uncompressed archive entries are used in place without any copy; compressed ones are decompressed.
+ * Loose files are read with the async I/O system when it is running, and mapped otherwise.
+ *
+ * @param path The path of the file, starting with the base path, as loaders build it.
+ * @param out_file A pointer to hold the contents of the file.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 resource_system_file_open(const char* path, resource_file* out_file);
+
+/**
+ * @brief Releases the contents of a file opened by resource_system_file_open.
+ *
+ * @param file A pointer to the file.
+ */
+KAPI void resource_system_file_close(resource_file* file);
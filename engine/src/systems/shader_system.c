@@ -15,8 +15,6 @@ typedef struct shader_system_state {
     shader_system_config config;
     // A lookup table for shader name->id
     hashtable lookup;
-    // The memory used for the lookup table.
-    void* lookup_memory;
     // The identifier for the currently bound shader.
     u32 current_shader_id;
     // A collection of created shaders.
@@ -28,6 +26,7 @@ static shader_system_state* state_ptr = 0;
 
 b8 add_attribute(shader* shader, const shader_attribute_config* config);
 b8 add_sampler(shader* shader, shader_uniform_config* config);
+b8 add_storage(shader* shader, shader_uniform_config* config);
 b8 add_uniform(shader* shader, shader_uniform_config* config);
 u32 get_shader_id(const char* shader_name);
 u32 new_shader_id();
@@ -39,22 +38,15 @@ void shader_destroy(shader* s);
 
 b8 shader_system_initialize(u64* memory_requirement, void* memory, shader_system_config config) {
     // Verify configuration.
-    if (config.max_shader_count < 512) {
-        if (config.max_shader_count == 0) {
-            KERROR("shader_system_initialize - config.max_shader_count must be greater than 0");
-            return false;
-        } else {
-            // This is to help avoid hashtable collisions.
-            KWARN("shader_system_initialize - config.max_shader_count is recommended to be at least 512.");
-        }
+    if (config.max_shader_count == 0) {
+        KERROR("shader_system_initialize - config.max_shader_count must be greater than 0");
+        return false;
     }
 
-    // Figure out how large of a hashtable is needed.
-    // Block of memory will contain state structure then the block for the hashtable.
+    // Block of memory will contain state structure then the shader array. The hashtable owns its memory.
     u64 struct_requirement = sizeof(shader_system_state);
-    u64 hashtable_requirement = sizeof(u32) * config.max_shader_count;
     u64 shader_array_requirement = sizeof(shader) * config.max_shader_count;
-    *memory_requirement = struct_requirement + hashtable_requirement + shader_array_requirement;
+    *memory_requirement = struct_requirement + shader_array_requirement;
 
     if (!memory) {
         return true;
@@ -63,11 +55,10 @@ b8 shader_system_initialize(u64* memory_requirement, void* memory, shader_system
     // Setup the state pointer, memory block, shader array, then create the hashtable.
     state_ptr = memory;
     u64 addr = (u64)memory;
-    state_ptr->lookup_memory = (void*)(addr + struct_requirement);
-    state_ptr->shaders = (void*)((u64)state_ptr->lookup_memory + hashtable_requirement);
+    state_ptr->shaders = (void*)(addr + struct_requirement);
     state_ptr->config = config;
     state_ptr->current_shader_id = INVALID_ID;
-    hashtable_create(sizeof(u32), config.max_shader_count, state_ptr->lookup_memory, false, &state_ptr->lookup);
+    hashtable_create_with_mode(sizeof(u32), config.max_shader_count, HASHTABLE_MODE_OPEN_ADDRESSING, 0, false, &state_ptr->lookup);
 
     // Invalidate all shader ids.
     for (u32 i = 0; i < config.max_shader_count; ++i) {
@@ -107,6 +98,39 @@ void shader_system_shutdown(void* state) {
 }
 
 b8 shader_system_create(renderpass* pass, const shader_config* config) {
+    // A compute stage can't be mixed with others, and has no vertex input or renderpass.
+    b8 is_compute = false;
+    for (u32 i = 0; i < config->stage_count; ++i) {
+        is_compute = is_compute || config->stages[i] == SHADER_STAGE_COMPUTE;
+    }
+    if (is_compute && (config->stage_count != 1 || config->attribute_count)) {
+        KERROR("shader_system_create: compute shader '%s' must have a single stage and no attributes.", config->name);
+        return false;
+    }
+    if (!is_compute && !pass) {
+        KERROR("shader_system_create: shader '%s' requires a renderpass.", config->name);
+        return false;
+    }
+    if (config->bindless && !renderer_bindless_supported()) {
+        KERROR("shader_system_create: shader '%s' is bindless, which the renderer does not support.", config->name);
+        return false;
+    }
+    if (config->local_ubo && is_compute) {
+        KERROR("shader_system_create: compute shader '%s' can't take a local uniform buffer.", config->name);
+        return false;
+    }
+    if (config->variant_count && is_compute) {
+        KERROR("shader_system_create: compute shader '%s' can't have variants.", config->name);
+        return false;
+    }
+    for (u32 i = 0; i < config->uniform_count; ++i) {
+        shader_uniform_type type = config->uniforms[i].type;
+        if ((type == SHADER_UNIFORM_TYPE_STORAGE_BUFFER || type == SHADER_UNIFORM_TYPE_STORAGE_IMAGE) && config->uniforms[i].scope != SHADER_SCOPE_GLOBAL) {
+            KERROR("shader_system_create: storage uniform '%s' of shader '%s' must be of global scope.", config->uniforms[i].name, config->name);
+            return false;
+        }
+    }
+
     u32 id = new_shader_id();
     shader* out_shader = &state_ptr->shaders[id];
     kzero_memory(out_shader, sizeof(shader));
@@ -126,16 +150,27 @@ b8 shader_system_create(renderpass* pass, const shader_config* config) {
     out_shader->global_texture_maps = darray_create(texture_map*);
     out_shader->uniforms = darray_create(shader_uniform);
     out_shader->attributes = darray_create(shader_attribute);
+    out_shader->stage_filenames = darray_create(char*);
+    for (u32 i = 0; i < config->stage_count; ++i) {
+        char* filename = string_duplicate(config->stage_filenames[i]);
+        darray_push(out_shader->stage_filenames, filename);
+    }
+    out_shader->variant_count = config->variant_count;
+    out_shader->variant_names = darray_create(char*);
+    for (u32 i = 0; i < config->variant_count; ++i) {
+        char* variant_name = string_duplicate(config->variant_names[i]);
+        darray_push(out_shader->variant_names, variant_name);
+    }
+    out_shader->variant = 0;
 
     // Create a hashtable to store uniform array indexes. This provides a direct index into the
     // 'uniforms' array stored in the shader for quick lookups by name.
     u64 element_size = sizeof(u16);  // Indexes are stored as u16s.
-    u64 element_count = 1024;        // This is more uniforms than we will ever need, but a bigger table reduces collision chance.
-    out_shader->hashtable_block = kallocate(element_size * element_count, MEMORY_TAG_UNKNOWN);
-    hashtable_create(element_size, element_count, out_shader->hashtable_block, false, &out_shader->uniform_lookup);
+    u64 element_count = 32;          // Enough for a typical shader; the table grows if more are added.
+    hashtable_create_with_mode(element_size, element_count, HASHTABLE_MODE_OPEN_ADDRESSING, 0, false, &out_shader->uniform_lookup);
 
-    // Invalidate all spots in the hashtable.
-    u32 invalid = INVALID_ID;
+    // Missing names read back as an invalid index.
+    u16 invalid = INVALID_ID_U16;
     hashtable_fill(&out_shader->uniform_lookup, &invalid);
 
     // A running total of the actual global uniform buffer object size.
@@ -149,6 +184,8 @@ b8 shader_system_create(renderpass* pass, const shader_config* config) {
     // lowest common denominator of 128B will be used.
     out_shader->push_constant_stride = 128;
     out_shader->push_constant_size = 0;
+    // A running total of the actual local uniform buffer object size, if locals aren't push constants.
+    out_shader->local_ubo_size = 0;
 
     // Process flags.
     out_shader->flags = 0;
@@ -158,6 +195,24 @@ b8 shader_system_create(renderpass* pass, const shader_config* config) {
     if (config->depth_write) {
         out_shader->flags |= SHADER_FLAG_DEPTH_WRITE;
     }
+    if (config->draw_data) {
+        out_shader->flags |= SHADER_FLAG_DRAW_DATA;
+    }
+    if (config->bindless) {
+        out_shader->flags |= SHADER_FLAG_BINDLESS;
+    }
+    if (config->local_ubo) {
+        out_shader->flags |= SHADER_FLAG_LOCAL_UBO;
+    }
+    if (config->vertex_pulling) {
+        out_shader->flags |= SHADER_FLAG_VERTEX_PULLING;
+    }
+    if (config->lines) {
+        out_shader->flags |= SHADER_FLAG_LINES;
+    }
+    if (is_compute) {
+        out_shader->flags |= SHADER_FLAG_COMPUTE;
+    }
 
     if (!renderer_shader_create(out_shader, config, pass, config->stage_count, (const char**)config->stage_filenames, config->stages)) {
         KERROR("Error creating shader.");
@@ -176,6 +231,8 @@ b8 shader_system_create(renderpass* pass, const shader_config* config) {
     for (u32 i = 0; i < config->uniform_count; ++i) {
         if (config->uniforms[i].type == SHADER_UNIFORM_TYPE_SAMPLER) {
             add_sampler(out_shader, &config->uniforms[i]);
+        } else if (config->uniforms[i].type == SHADER_UNIFORM_TYPE_STORAGE_BUFFER || config->uniforms[i].type == SHADER_UNIFORM_TYPE_STORAGE_IMAGE) {
+            add_storage(out_shader, &config->uniforms[i]);
         } else {
             add_uniform(out_shader, &config->uniforms[i]);
         }
@@ -187,6 +244,7 @@ b8 shader_system_create(renderpass* pass, const shader_config* config) {
         // NOTE: initialize automatically destroys the shader if it fails.
         return false;
     }
+    out_shader->state = SHADER_STATE_INITIALIZED;
 
     // At this point, creation is successful, so store the shader id in the hashtable
     // so this can be looked up by name later.
@@ -218,6 +276,47 @@ shader* shader_system_get(const char* shader_name) {
     return 0;
 }
 
+shader* shader_system_get_by_kname(kname shader_name) {
+    u32 shader_id = INVALID_ID;
+    if (!hashtable_get_by_kname(&state_ptr->lookup, shader_name, &shader_id) || shader_id == INVALID_ID) {
+        return 0;
+    }
+    return shader_system_get_by_id(shader_id);
+}
+
+b8 shader_system_reload(const char* shader_name) {
+    shader* s = shader_system_get(shader_name);
+    if (!s || s->state != SHADER_STATE_INITIALIZED) {
+        return false;
+    }
+    if (!renderer_shader_reload(s)) {
+        KERROR("Failed to reload shader '%s'; keeping the previous version.", shader_name);
+        return false;
+    }
+    KINFO("Reloaded shader '%s'.", shader_name);
+    return true;
+}
+
+u32 shader_system_reload_stage_file(const char* stage_filename) {
+    u32 reloaded_count = 0;
+    for (u32 i = 0; i < state_ptr->config.max_shader_count; ++i) {
+        shader* s = &state_ptr->shaders[i];
+        if (s->id == INVALID_ID || s->state != SHADER_STATE_INITIALIZED || !s->stage_filenames) {
+            continue;
+        }
+        u32 stage_count = darray_length(s->stage_filenames);
+        for (u32 j = 0; j < stage_count; ++j) {
+            if (strings_equal(s->stage_filenames[j], stage_filename)) {
+                if (shader_system_reload(s->name)) {
+                    reloaded_count++;
+                }
+                break;
+            }
+        }
+    }
+    return reloaded_count;
+}
+
 void shader_destroy(shader* s) {
     renderer_shader_destroy(s);
 
@@ -230,6 +329,26 @@ void shader_destroy(shader* s) {
     }
     darray_destroy(s->global_texture_maps);
 
+    hashtable_destroy(&s->uniform_lookup);
+
+    if (s->stage_filenames) {
+        u32 stage_count = darray_length(s->stage_filenames);
+        for (u32 i = 0; i < stage_count; ++i) {
+            string_free(s->stage_filenames[i]);
+        }
+        darray_destroy(s->stage_filenames);
+        s->stage_filenames = 0;
+    }
+
+    if (s->variant_names) {
+        for (u32 i = 0; i < s->variant_count; ++i) {
+            string_free(s->variant_names[i]);
+        }
+        darray_destroy(s->variant_names);
+        s->variant_names = 0;
+        s->variant_count = 0;
+    }
+
     // Free the name.
     if (s->name) {
         u32 length = string_length(s->name);
@@ -246,6 +365,8 @@ void shader_system_destroy(const char* shader_name) {
 
     shader* s = &state_ptr->shaders[shader_id];
 
+    // Remove the lookup entry while the shader's name is still valid.
+    hashtable_remove(&state_ptr->lookup, s->name);
     shader_destroy(s);
 }
 
@@ -258,6 +379,16 @@ b8 shader_system_use(const char* shader_name) {
     return shader_system_use_by_id(next_shader_id);
 }
 
+b8 shader_system_use_by_kname(kname shader_name) {
+    u32 next_shader_id = INVALID_ID;
+    if (!hashtable_get_by_kname(&state_ptr->lookup, shader_name, &next_shader_id) || next_shader_id == INVALID_ID) {
+        KERROR("There is no shader registered with the given name.");
+        return false;
+    }
+
+    return shader_system_use_by_id(next_shader_id);
+}
+
 b8 shader_system_use_by_id(u32 shader_id) {
     // Only perform the use if the shader id is different.
     if (state_ptr->current_shader_id != shader_id) {
@@ -275,6 +406,38 @@ b8 shader_system_use_by_id(u32 shader_id) {
     return true;
 }
 
+u8 shader_system_variant_index(shader* s, const char* variant_name) {
+    if (!s || s->id == INVALID_ID) {
+        KERROR("shader_system_variant_index called with invalid shader.");
+        return INVALID_ID_U8;
+    }
+    for (u8 i = 0; i < s->variant_count; ++i) {
+        if (strings_equali(s->variant_names[i], variant_name)) {
+            return i;
+        }
+    }
+    return INVALID_ID_U8;
+}
+
+b8 shader_system_variant_use(u8 variant) {
+    if (state_ptr->current_shader_id == INVALID_ID) {
+        KERROR("shader_system_variant_use requires a shader in use.");
+        return false;
+    }
+    shader* s = &state_ptr->shaders[state_ptr->current_shader_id];
+    if (variant >= KMAX(s->variant_count, 1)) {
+        KERROR("Shader '%s' has no variant %u.", s->name, variant);
+        return false;
+    }
+    if (s->variant == variant) {
+        return true;
+    }
+    // Using the shader again binds the pipeline of its new variant. Variants share a layout, so whatever
+    // is bound stays bound.
+    s->variant = variant;
+    return renderer_shader_use(s);
+}
+
 u16 shader_system_uniform_index(shader* s, const char* uniform_name) {
     if (!s || s->id == INVALID_ID) {
         KERROR("shader_system_uniform_location called with invalid shader.");
@@ -289,6 +452,20 @@ u16 shader_system_uniform_index(shader* s, const char* uniform_name) {
     return s->uniforms[index].index;
 }
 
+u16 shader_system_uniform_index_by_kname(shader* s, kname uniform_name) {
+    if (!s || s->id == INVALID_ID) {
+        KERROR("shader_system_uniform_index_by_kname called with invalid shader.");
+        return INVALID_ID_U16;
+    }
+
+    u16 index = INVALID_ID_U16;
+    if (!hashtable_get_by_kname(&s->uniform_lookup, uniform_name, &index) || index == INVALID_ID_U16) {
+        KERROR("Shader '%s' does not have a registered uniform with the given name.", s->name);
+        return INVALID_ID_U16;
+    }
+    return s->uniforms[index].index;
+}
+
 b8 shader_system_uniform_set(const char* uniform_name, const void* value) {
     if (state_ptr->current_shader_id == INVALID_ID) {
         KERROR("shader_system_uniform_set called without a shader in use.");
@@ -299,10 +476,28 @@ b8 shader_system_uniform_set(const char* uniform_name, const void* value) {
     return shader_system_uniform_set_by_index(index, value);
 }
 
+b8 shader_system_uniform_set_by_kname(kname uniform_name, const void* value) {
+    if (state_ptr->current_shader_id == INVALID_ID) {
+        KERROR("shader_system_uniform_set_by_kname called without a shader in use.");
+        return false;
+    }
+    shader* s = &state_ptr->shaders[state_ptr->current_shader_id];
+    u16 index = shader_system_uniform_index_by_kname(s, uniform_name);
+    return shader_system_uniform_set_by_index(index, value);
+}
+
 b8 shader_system_sampler_set(const char* sampler_name, const texture* t) {
     return shader_system_uniform_set(sampler_name, t);
 }
 
+b8 shader_system_storage_buffer_set(const char* uniform_name, const renderbuffer* buffer) {
+    return shader_system_uniform_set(uniform_name, buffer);
+}
+
+b8 shader_system_storage_image_set(const char* uniform_name, const texture* t) {
+    return shader_system_uniform_set(uniform_name, t);
+}
+
 b8 shader_system_uniform_set_by_index(u16 index, const void* value) {
     shader* shader = &state_ptr->shaders[state_ptr->current_shader_id];
     shader_uniform* uniform = &shader->uniforms[index];
@@ -329,6 +524,10 @@ b8 shader_system_apply_instance(b8 needs_update) {
     return renderer_shader_apply_instance(&state_ptr->shaders[state_ptr->current_shader_id], needs_update);
 }
 
+b8 shader_system_apply_local() {
+    return renderer_shader_apply_local(&state_ptr->shaders[state_ptr->current_shader_id]);
+}
+
 b8 shader_system_bind_instance(u32 instance_id) {
     shader* s = &state_ptr->shaders[state_ptr->current_shader_id];
     s->bound_instance_id = instance_id;
@@ -349,6 +548,9 @@ b8 add_attribute(shader* shader, const shader_attribute_config* config) {
         case SHADER_ATTRIB_TYPE_FLOAT32:
         case SHADER_ATTRIB_TYPE_INT32:
         case SHADER_ATTRIB_TYPE_UINT32:
+        case SHADER_ATTRIB_TYPE_SNORM16_2:
+        case SHADER_ATTRIB_TYPE_FLOAT16_2:
+        case SHADER_ATTRIB_TYPE_UNORM8_4:
             size = 4;
             break;
         case SHADER_ATTRIB_TYPE_FLOAT32_2:
@@ -436,6 +638,28 @@ b8 add_sampler(shader* shader, shader_uniform_config* config) {
         return false;
     }
 
+    // A bindless instance sampler is a u32 index into the texture table, following the instance uniforms before it.
+    if (config->scope == SHADER_SCOPE_INSTANCE && (shader->flags & SHADER_FLAG_BINDLESS)) {
+        shader_uniform* entry = &shader->uniforms[darray_length(shader->uniforms) - 1];
+        entry->offset = shader->ubo_size;
+        shader->ubo_size += sizeof(u32);
+    }
+
+    return true;
+}
+
+b8 add_storage(shader* shader, shader_uniform_config* config) {
+    if (!shader_uniform_add_state_valid(shader) || !uniform_name_valid(shader, config->name)) {
+        return false;
+    }
+
+    // Like samplers, storage bindings have no place in a uniform buffer. Their location is their
+    // binding in the storage set, in the order they are configured.
+    if (!uniform_add(shader, config->name, 0, config->type, config->scope, shader->storage_binding_count, true)) {
+        KERROR("Unable to add storage uniform.");
+        return false;
+    }
+    shader->storage_binding_count++;
     return true;
 }
 
@@ -482,7 +706,13 @@ b8 uniform_add(shader* shader, const char* uniform_name, u32 size, shader_unifor
         entry.location = entry.index;
     }
 
-    if (scope != SHADER_SCOPE_LOCAL) {
+    if (scope == SHADER_SCOPE_LOCAL && (shader->flags & SHADER_FLAG_LOCAL_UBO)) {
+        // Laid out one after another in the local uniform buffer object.
+        entry.set_index = INVALID_ID_U8;
+        entry.offset = shader->local_ubo_size;
+        entry.size = size;
+        shader->local_ubo_size += size;
+    } else if (scope != SHADER_SCOPE_LOCAL) {
         entry.set_index = (u32)scope;
         entry.offset = is_sampler ? 0 : is_global ? shader->global_ubo_size
                                                   : shader->ubo_size;
@@ -16,6 +16,7 @@
 #include "defines.h"
 #include "renderer/renderer_types.inl"
 #include "containers/hashtable.h"
+#include "core/kname.h"
 
 /** @brief Configuration for the shader system. */
 typedef struct shader_system_config {
@@ -79,7 +80,19 @@ typedef struct shader_attribute {
 typedef enum shader_flags {
     SHADER_FLAG_NONE = 0x0,
     SHADER_FLAG_DEPTH_TEST = 0x1,
-    SHADER_FLAG_DEPTH_WRITE = 0x2
+    SHADER_FLAG_DEPTH_WRITE = 0x2,
+    /** @brief The shader reads per-draw data from the renderer's draw data buffer, and is drawn in batches. */
+    SHADER_FLAG_DRAW_DATA = 0x4,
+    /** @brief The shader has a single compute stage, and is run with renderer_dispatch() rather than drawn. */
+    SHADER_FLAG_COMPUTE = 0x8,
+    /** @brief The shader samples its instance textures from the renderer's bindless texture table, by indices in the instance uniform buffer. */
+    SHADER_FLAG_BINDLESS = 0x10,
+    /** @brief The shader reads its local uniforms from the renderer's per-frame uniform arena rather than push constants. */
+    SHADER_FLAG_LOCAL_UBO = 0x20,
+    /** @brief The shader reads its vertices from the vertex buffer by vertex index, so has no vertex attributes. */
+    SHADER_FLAG_VERTEX_PULLING = 0x40,
+    /** @brief The shader draws lists of lines rather than triangles. */
+    SHADER_FLAG_LINES = 0x80
 } shader_flags;
 
 typedef u32 shader_flag_bits;
@@ -126,12 +139,18 @@ typedef struct shader {
     /** @brief The push constant stride, aligned to 4 bytes as required by Vulkan. */
     u64 push_constant_stride;
 
+    /** @brief The size of the local uniform buffer object, for shaders with SHADER_FLAG_LOCAL_UBO. */
+    u64 local_ubo_size;
+
     /** @brief An array of global texture map pointers. Darray */
     texture_map** global_texture_maps;
 
     /** @brief The number of instance textures. */
     u8 instance_texture_count;
 
+    /** @brief The number of storage buffer and storage image bindings, all of global scope. */
+    u8 storage_binding_count;
+
     shader_scope bound_scope;
 
     /** @brief The identifier of the currently bound instance. */
@@ -139,8 +158,6 @@ typedef struct shader {
     /** @brief The currently bound instance's ubo offset. */
     u32 bound_ubo_offset;
 
-    /** @brief The block of memory used by the uniform hashtable. */
-    void* hashtable_block;
     /** @brief A hashtable to store uniform index/locations by name. */
     hashtable uniform_lookup;
 
@@ -150,6 +167,16 @@ typedef struct shader {
     /** @brief An array of attributes. Darray. */
     shader_attribute* attributes;
 
+    /** @brief The file names of the shader's stages, as configured. Darray. */
+    char** stage_filenames;
+
+    /** @brief The number of variants, as configured. 0 if the shader has none, but the one it is built as. */
+    u8 variant_count;
+    /** @brief The names of the variants, in order. Darray. */
+    char** variant_names;
+    /** @brief The index of the variant drawn with when the shader is used. */
+    u8 variant;
+
     /** @brief The internal state of the shader. */
     shader_state state;
 
@@ -187,9 +214,10 @@ b8 shader_system_initialize(u64* memory_requirement, void* memory, shader_system
 void shader_system_shutdown(void* state);
 
 /**
- * @brief Creates a new shader with the given config.
+ * @brief Creates a new shader with the given config. A shader whose only stage is a compute stage
+ * is a compute shader, run with renderer_dispatch(), and needs no renderpass.
  * 
- * @param pass A pointer to the renderpass to be used with this shader.
+ * @param pass A pointer to the renderpass to be used with this shader. Ignored for compute shaders.
  * @param config The configuration to be used when creating the shader.
  * @return True on success; otherwise false.
  */
@@ -219,6 +247,33 @@ KAPI shader* shader_system_get_by_id(u32 shader_id);
  */
 KAPI shader* shader_system_get(const char* shader_name);
 
+/**
+ * @brief Returns a pointer to a shader with the given pre-hashed name.
+ * Avoids hashing the name on every call.
+ *
+ * @param shader_name The kname of the shader to search for.
+ * @return A pointer to a shader, if found; otherwise 0.
+ */
+KAPI shader* shader_system_get_by_kname(kname shader_name);
+
+/**
+ * @brief Reloads the stage files of the shader with the given name, such as after they have been
+ * recompiled. The shader keeps its previous stages if any of the new ones fail to load. Only
+ * the stage code is replaced; changes to uniforms, attributes or layouts need a restart.
+ *
+ * @param shader_name The name of the shader to reload.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 shader_system_reload(const char* shader_name);
+
+/**
+ * @brief Reloads every shader using the given stage file.
+ *
+ * @param stage_filename The stage file name, as configured in the shader config (e.g. "shaders/Builtin.UIShader.frag.spv").
+ * @return The number of shaders reloaded.
+ */
+KAPI u32 shader_system_reload_stage_file(const char* stage_filename);
+
 /**
  * @brief Uses the shader with the given name.
  * 
@@ -235,6 +290,33 @@ KAPI b8 shader_system_use(const char* shader_name);
  */
 KAPI b8 shader_system_use_by_id(u32 shader_id);
 
+/**
+ * @brief Uses the shader with the given pre-hashed name.
+ *
+ * @param shader_name The kname of the shader to use.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 shader_system_use_by_kname(kname shader_name);
+
+/**
+ * @brief Returns the index of the variant of the given shader with the given name, if found.
+ *
+ * @param s A pointer to the shader to obtain the index from.
+ * @param variant_name The name of the variant, as configured.
+ * @return The variant index, if found; otherwise INVALID_ID_U8.
+ */
+KAPI u8 shader_system_variant_index(shader* s, const char* variant_name);
+
+/**
+ * @brief Draws with the variant with the given index from now on, binding its pipeline if it was not
+ * already, without changing anything applied or bound otherwise.
+ * NOTE: Operates against the currently-used shader.
+ *
+ * @param variant The index of the variant.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 shader_system_variant_use(u8 variant);
+
 /**
  * @brief Returns the uniform index for a uniform with the given name, if found.
  * 
@@ -244,6 +326,15 @@ KAPI b8 shader_system_use_by_id(u32 shader_id);
  */
 KAPI u16 shader_system_uniform_index(shader* s, const char* uniform_name);
 
+/**
+ * @brief Returns the uniform index for a uniform with the given pre-hashed name, if found.
+ *
+ * @param s A pointer to the shader to obtain the index from.
+ * @param uniform_name The kname of the uniform to search for.
+ * @return The uniform index, if found; otherwise INVALID_ID_U16.
+ */
+KAPI u16 shader_system_uniform_index_by_kname(shader* s, kname uniform_name);
+
 /**
  * @brief Sets the value of a uniform with the given name to the supplied value.
  * NOTE: Operates against the currently-used shader.
@@ -254,6 +345,16 @@ KAPI u16 shader_system_uniform_index(shader* s, const char* uniform_name);
  */
 KAPI b8 shader_system_uniform_set(const char* uniform_name, const void* value);
 
+/**
+ * @brief Sets the value of a uniform with the given pre-hashed name to the supplied value.
+ * NOTE: Operates against the currently-used shader.
+ *
+ * @param uniform_name The kname of the uniform to be set.
+ * @param value The value to be set.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 shader_system_uniform_set_by_kname(kname uniform_name, const void* value);
+
 /**
  * @brief Sets the texture of a sampler with the given name to the supplied texture.
  * NOTE: Operates against the currently-used shader.
@@ -264,6 +365,30 @@ KAPI b8 shader_system_uniform_set(const char* uniform_name, const void* value);
  */
 KAPI b8 shader_system_sampler_set(const char* sampler_name, const texture* t);
 
+/**
+ * @brief Sets the buffer bound to a storage buffer uniform with the given name. Storage bindings are
+ * written to the current frame's set right away, so should be set once per frame, before the shader
+ * is applied or dispatched.
+ * NOTE: Operates against the currently-used shader.
+ *
+ * @param uniform_name The name of the storage buffer uniform.
+ * @param buffer A pointer to the renderbuffer to be bound, which must be a storage or indirect buffer.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 shader_system_storage_buffer_set(const char* uniform_name, const renderbuffer* buffer);
+
+/**
+ * @brief Sets the texture bound to a storage image uniform with the given name. Storage bindings are
+ * written to the current frame's set right away, so should be set once per frame, before the shader
+ * is applied or dispatched.
+ * NOTE: Operates against the currently-used shader.
+ *
+ * @param uniform_name The name of the storage image uniform.
+ * @param t A pointer to the texture to be bound, which must be created with TEXTURE_FLAG_IS_STORAGE.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 shader_system_storage_image_set(const char* uniform_name, const texture* t);
+
 /**
  * @brief Sets a uniform value by index.
  * NOTE: Operates against the currently-used shader.
@@ -302,6 +427,16 @@ KAPI b8 shader_system_apply_global();
  */
 KAPI b8 shader_system_apply_instance(b8 needs_update);
 
+/**
+ * @brief Applies local-scoped uniforms, once all of those of the next draw are set.
+ * Shaders taking locals as push constants have them applied as they are set, so
+ * this does nothing for them.
+ * NOTE: Operates against the currently-used shader.
+ *
+ * @return True on success; otherwise false.
+ */
+KAPI b8 shader_system_apply_local();
+
 /**
  * @brief Binds the instance with the given id for use. Must be done before setting
  * instance-scoped uniforms.
@@ -1,27 +1,106 @@
 #include "texture_system.h"
 
+#include "core/counters.h"
+#include "core/event.h"
+#include "core/katomic.h"
+#include "core/profiler.h"
 #include "core/logger.h"
 #include "core/kstring.h"
 #include "core/kmemory.h"
+#include "containers/darray.h"
 #include "containers/hashtable.h"
 
 #include "renderer/renderer_frontend.h"
+#include "resources/resource_cache.h"
+#include "resources/texture_atlas.h"
+#include "resources/texture_container.h"
 
 #include "systems/resource_system.h"
 #include "systems/job_system.h"
 
+/** @brief The size, across its longest side, that streamed textures are first loaded at and drop back to when unused. */
+#define TEXTURE_STREAMING_REST_SIZE 64
+/** @brief The number of updates a streamed texture may go without being reported before it counts as unused. */
+#define TEXTURE_STREAMING_HOLD_FRAMES 120
+/** @brief The most streamed texture loads in flight at once. */
+#define TEXTURE_STREAMING_MAX_LOADS 4
+/** @brief The levels streamed textures are wanted coarser by for each step of GPU memory pressure. */
+#define TEXTURE_STREAMING_PRESSURE_LEVELS 1
+/** @brief The width and height of the texture small textures are packed into. */
+#define TEXTURE_ATLAS_SIZE 1024
+/** @brief The largest size, across either side, of textures packed into the atlas. Larger ones are loaded whole. */
+#define TEXTURE_ATLAS_MAX_IMAGE_SIZE 256
+/** @brief The pixels of border around each texture in the atlas, so filtering does not reach its neighbours. */
+#define TEXTURE_ATLAS_PADDING 2
+
+// The streaming state of a texture loaded from a file. Sizes are of a level's whole chain,
+// estimated from the full size of the image.
+typedef struct texture_stream {
+    // The full size of the image, and the number of levels it can be loaded at.
+    u32 full_width;
+    u32 full_height;
+    u32 level_count;
+    // The first level uploaded, and the one loaded when no longer in use.
+    u32 resident_level;
+    u32 rest_level;
+    // The level the load in flight brings in, and its serial. No load is in flight while the serial is 0.
+    u32 target_level;
+    u32 serial;
+    // The job of the load in flight.
+    job_handle job;
+    // The finest level reported this frame, or INVALID_ID.
+    u32 frame_level;
+    // The finest level last reported.
+    u32 wanted_level;
+    // The update the texture was first loaded on and was last used on.
+    u64 loaded_frame;
+    u64 last_used_frame;
+    // The memory the texture holds once the load in flight lands.
+    u64 size;
+    b8 tracked;
+    b8 reported;
+} texture_stream;
+
 typedef struct texture_system_state {
     texture_system_config config;
     texture default_texture;
     texture default_diffuse_texture;
     texture default_specular_texture;
     texture default_normal_texture;
+    texture default_cube_texture;
 
     // Array of registered textures.
     texture* registered_textures;
 
     // Hashtable for texture lookups.
     hashtable registered_texture_table;
+
+    // Counter ids for textures loaded and textures which failed to load.
+    u32 loads_counter;
+    u32 load_failures_counter;
+
+    // Streaming state for each registered texture, and the ids of those being tracked.
+    texture_stream* streams;
+    u32* streamed_ids;
+    // The memory streamed textures hold between them, counting loads in flight as landed.
+    u64 streaming_size;
+    u32 streaming_size_gauge;
+    u32 streaming_loads;
+    u32 streaming_serial;
+    u64 streaming_frame;
+    // The pressure on GPU memory, as last posted by the renderer.
+    renderer_memory_pressure memory_pressure;
+
+    // Released auto-release textures kept loaded in case they are acquired again, by handle.
+    resource_cache cache;
+
+    // Small textures packed together, created when the first is, and the texture they are uploaded to.
+    texture_atlas atlas;
+    void* atlas_memory;
+    u64 atlas_memory_size;
+    texture* atlas_texture;
+    // Where each texture acquired for the atlas was placed, by name. A width of INVALID_ID marks those loaded whole.
+    hashtable atlas_region_table;
 } texture_system_state;
 
 typedef struct texture_reference {
@@ -37,16 +116,53 @@ typedef struct texture_load_params {
     texture temp_texture;
     u32 current_generation;
     resource image_resource;
+    // The levels to load, as in image_resource_params.
+    u32 first_level;
+    u32 max_size;
+    // The texture's stream serial for this load, or 0 if it is not streamed.
+    u32 stream_serial;
+    // Indicates if temp_texture was already created and uploaded by the job.
+    b8 uploaded;
+    // Indicates if the job stopped early, having been cancelled.
+    b8 cancelled;
+    // The staging buffer the image was decoded into, if any, until the texture takes it.
+    renderbuffer staging;
 } texture_load_params;
 
+// The six sides of a cube texture, each loaded by its own job. The side to finish last joins them
+// into one image on its job thread, and its success uploads it.
+typedef struct cube_texture_load {
+    char name[TEXTURE_NAME_MAX_LENGTH];
+    char side_names[6][TEXTURE_NAME_MAX_LENGTH];
+    texture* out_texture;
+    texture temp_texture;
+    u32 current_generation;
+    resource sides[6];
+    // The sides still loading.
+    u32 remaining;
+    // The joined sides, and the size of each.
+    u8* pixels;
+    u64 side_size;
+} cube_texture_load;
+
+// Also used as result_data from job.
+typedef struct cube_side_load_params {
+    cube_texture_load* load;
+    u8 side;
+    // Set for the side which finished last, and so joined the sides.
+    b8 last;
+} cube_side_load_params;
+
 static texture_system_state* state_ptr = 0;
 
 b8 create_default_textures(texture_system_state* state);
 void destroy_default_textures(texture_system_state* state);
-b8 load_texture(const char* texture_name, texture* t);
+b8 load_texture(const char* texture_name, texture* t, u32 first_level, u32 max_size);
 b8 load_cube_textures(const char* name, const char texture_names[6][TEXTURE_NAME_MAX_LENGTH], texture* t);
 void destroy_texture(texture* t);
 b8 process_texture_reference(const char* name, texture_type type, i8 reference_diff, b8 auto_release, b8 skip_load, u32* out_texture_id);
+static b8 texture_system_on_memory_pressure(u16 code, void* sender, void* listener_inst, event_context context);
+static void texture_cache_trim(u64 max_size);
 
 b8 texture_system_initialize(u64* memory_requirement, void* state, texture_system_config config) {
     if (config.max_texture_count == 0) {
@@ -54,11 +170,13 @@ b8 texture_system_initialize(u64* memory_requirement, void* state, texture_syste
         return false;
     }
 
-    // Block of memory will contain state structure, then block for array, then block for hashtable.
+    // Block of memory will contain state structure, then block for array. The hashtable owns its memory.
     u64 struct_requirement = sizeof(texture_system_state);
     u64 array_requirement = sizeof(texture) * config.max_texture_count;
-    u64 hashtable_requirement = sizeof(texture_reference) * config.max_texture_count;
-    *memory_requirement = struct_requirement + array_requirement + hashtable_requirement;
+    u64 streams_requirement = sizeof(texture_stream) * config.max_texture_count;
+    u64 cache_requirement = 0;
+    resource_cache_create(0, config.max_texture_count, config.cache_budget, &cache_requirement, 0, 0);
+    *memory_requirement = struct_requirement + array_requirement + streams_requirement + cache_requirement;
 
     if (!state) {
         return true;
@@ -66,16 +184,23 @@ b8 texture_system_initialize(u64* memory_requirement, void* state, texture_syste
 
     state_ptr = state;
     state_ptr->config = config;
+    state_ptr->loads_counter = counter_register("textures.loads", COUNTER_TYPE_COUNTER);
+    state_ptr->load_failures_counter = counter_register("textures.load_failures", COUNTER_TYPE_COUNTER);
 
     // The array block is after the state. Already allocated, so just set the pointer.
     void* array_block = state + struct_requirement;
     state_ptr->registered_textures = array_block;
-
-    // Hashtable block is after array.
-    void* hashtable_block = array_block + array_requirement;
+    state_ptr->streams = (void*)((u8*)array_block + array_requirement);
+    kzero_memory(state_ptr->streams, streams_requirement);
+    state_ptr->streamed_ids = darray_create(u32);
+    state_ptr->streaming_size_gauge = counter_register("textures.streamed_bytes", COUNTER_TYPE_GAUGE);
+    resource_cache_create("textures", config.max_texture_count, config.cache_budget, &cache_requirement, (u8*)state_ptr->streams + streams_requirement, &state_ptr->cache);
 
     // Create a hashtable for texture lookups.
-    hashtable_create(sizeof(texture_reference), config.max_texture_count, hashtable_block, false, &state_ptr->registered_texture_table);
+    hashtable_create_with_mode(sizeof(texture_reference), config.max_texture_count, HASHTABLE_MODE_OPEN_ADDRESSING, 0, false, &state_ptr->registered_texture_table);
+    hashtable_create_with_mode(sizeof(texture_atlas_region), config.max_texture_count, HASHTABLE_MODE_OPEN_ADDRESSING, 0, false, &state_ptr->atlas_region_table);
+    texture_atlas_region no_region = {0};
+    hashtable_fill(&state_ptr->atlas_region_table, &no_region);
 
     // Fill the hashtable with invalid references to use as a default.
     texture_reference invalid_ref;
@@ -94,11 +219,16 @@ b8 texture_system_initialize(u64* memory_requirement, void* state, texture_syste
     // Create default textures for use in the system.
     create_default_textures(state_ptr);
 
+    // Streamed textures give back their finest levels while GPU memory is short.
+    event_register(EVENT_CODE_GPU_MEMORY_PRESSURE, state_ptr, texture_system_on_memory_pressure);
+
     return true;
 }
 
 void texture_system_shutdown(void* state) {
     if (state_ptr) {
+        event_unregister(EVENT_CODE_GPU_MEMORY_PRESSURE, state_ptr, texture_system_on_memory_pressure);
+
         // Destroy all loaded textures.
         for (u32 i = 0; i < state_ptr->config.max_texture_count; ++i) {
             texture* t = &state_ptr->registered_textures[i];
@@ -109,6 +239,17 @@ void texture_system_shutdown(void* state) {
 
         destroy_default_textures(state_ptr);
 
+        if (state_ptr->atlas_memory) {
+            texture_atlas_destroy(&state_ptr->atlas);
+            kfree(state_ptr->atlas_memory, state_ptr->atlas_memory_size, MEMORY_TAG_TEXTURE);
+            state_ptr->atlas_memory = 0;
+        }
+
+        darray_destroy(state_ptr->streamed_ids);
+        resource_cache_destroy(&state_ptr->cache);
+        hashtable_destroy(&state_ptr->registered_texture_table);
+        hashtable_destroy(&state_ptr->atlas_region_table);
+
         state_ptr = 0;
     }
 }
@@ -149,6 +290,65 @@ texture* texture_system_acquire_cube(const char* name, b8 auto_release) {
     return &state_ptr->registered_textures[id];
 }
 
+// Loads the given image and packs it into the atlas, creating the atlas if it is the first. Fails for images
+// which are too big, not 8-bit RGBA or do not fit in what is left.
+static b8 atlas_image_add(const char* name, texture_atlas_region* out_region) {
+    image_resource_params params = {};
+    params.flip_y = true;
+    resource image_resource;
+    if (!resource_system_load(name, RESOURCE_TYPE_IMAGE, &params, &image_resource)) {
+        counter_add(state_ptr->load_failures_counter, 1);
+        return false;
+    }
+
+    b8 result = false;
+    image_resource_data* data = image_resource.data;
+    if (data->format == TEXTURE_FORMAT_UNCOMPRESSED && data->channel_count == 4 && data->width <= TEXTURE_ATLAS_MAX_IMAGE_SIZE && data->height <= TEXTURE_ATLAS_MAX_IMAGE_SIZE) {
+        if (!state_ptr->atlas_memory) {
+            texture_atlas_create(TEXTURE_ATLAS_SIZE, TEXTURE_ATLAS_SIZE, 4, TEXTURE_ATLAS_PADDING, &state_ptr->atlas_memory_size, 0, 0);
+            state_ptr->atlas_memory = kallocate(state_ptr->atlas_memory_size, MEMORY_TAG_TEXTURE);
+            texture_atlas_create(TEXTURE_ATLAS_SIZE, TEXTURE_ATLAS_SIZE, 4, TEXTURE_ATLAS_PADDING, &state_ptr->atlas_memory_size, state_ptr->atlas_memory, &state_ptr->atlas);
+            state_ptr->atlas_texture = texture_system_aquire_writeable(TEXTURE_ATLAS_NAME, TEXTURE_ATLAS_SIZE, TEXTURE_ATLAS_SIZE, 4, true);
+        }
+        result = state_ptr->atlas_texture && texture_atlas_add(&state_ptr->atlas, data->width, data->height, data->pixels, out_region);
+        if (result) {
+            counter_add(state_ptr->loads_counter, 1);
+        }
+    }
+    resource_system_unload(&image_resource);
+    return result;
+}
+
+texture* texture_system_acquire_atlased(const char* name, vec4* out_uv_rect) {
+    *out_uv_rect = (vec4){0.0f, 0.0f, 1.0f, 1.0f};
+    if (!state_ptr) {
+        KERROR("texture_system_acquire_atlased called before texture system initialization! Null pointer returned.");
+        return 0;
+    }
+
+    texture_atlas_region region;
+    hashtable_get(&state_ptr->atlas_region_table, name, &region);
+    if (region.width == 0) {
+        // Placed once, then found here from then on.
+        if (!atlas_image_add(name, &region)) {
+            region.width = INVALID_ID;
+        }
+        hashtable_set(&state_ptr->atlas_region_table, name, &region);
+    }
+    if (region.width == INVALID_ID) {
+        return texture_system_acquire(name, true);
+    }
+
+    // Every acquirer holds a reference to the atlas, which is never released.
+    u32 id = INVALID_ID;
+    if (!process_texture_reference(TEXTURE_ATLAS_NAME, TEXTURE_TYPE_2D, 1, false, true, &id)) {
+        KERROR("texture_system_acquire_atlased failed to reference the atlas.");
+        return 0;
+    }
+    *out_uv_rect = region.uv_rect;
+    return state_ptr->atlas_texture;
+}
+
 texture* texture_system_aquire_writeable(const char* name, u32 width, u32 height, u8 channel_count, b8 has_transparency) {
     u32 id = INVALID_ID;
     // NOTE: Wrapped textures are never auto-released because it means that thier
@@ -165,6 +365,8 @@ texture* texture_system_aquire_writeable(const char* name, u32 width, u32 height
     t->width = width;
     t->height = height;
     t->channel_count = channel_count;
+    t->format = TEXTURE_FORMAT_UNCOMPRESSED;
+    t->mip_levels = 1;
     t->generation = INVALID_ID;
     t->flags |= has_transparency ? TEXTURE_FLAG_HAS_TRANSPARENCY : 0;
     t->flags |= TEXTURE_FLAG_IS_WRITEABLE;
@@ -212,6 +414,8 @@ void texture_system_wrap_internal(const char* name, u32 width, u32 height, u8 ch
     t->width = width;
     t->height = height;
     t->channel_count = channel_count;
+    t->format = TEXTURE_FORMAT_UNCOMPRESSED;
+    t->mip_levels = 1;
     t->generation = INVALID_ID;
     t->flags |= has_transparency ? TEXTURE_FLAG_HAS_TRANSPARENCY : 0;
     t->flags |= is_writeable ? TEXTURE_FLAG_IS_WRITEABLE : 0;
@@ -243,7 +447,7 @@ b8 texture_system_resize(texture* t, u32 width, u32 height, b8 regenerate_intern
         if (!(t->flags & TEXTURE_FLAG_IS_WRAPPED) && regenerate_internal_data) {
             // Regenerate internals for the new size.
             renderer_texture_resize(t, width, height);
-            return false;
+            return true;
         }
         t->generation++;
         return true;
@@ -259,6 +463,19 @@ b8 texture_system_write_data(texture* t, u32 offset, u32 size, void* data) {
     return false;
 }
 
+b8 texture_system_write_region(texture* t, u32 x, u32 y, u32 width, u32 height, const void* pixels) {
+    if (!t || !pixels || !(t->flags & TEXTURE_FLAG_IS_WRITEABLE)) {
+        KERROR("texture_system_write_region requires a writeable texture and pixels to write.");
+        return false;
+    }
+    if (width == 0 || height == 0 || x + width > t->width || y + height > t->height) {
+        KERROR("texture_system_write_region was given a rectangle outside of texture '%s'.", t->name);
+        return false;
+    }
+    renderer_texture_write_region(t, x, y, width, height, pixels);
+    return true;
+}
+
 #define RETURN_TEXT_PTR_OR_NULL(texture, func_name)                                              \
     if (state_ptr) {                                                                             \
         return &texture;                                                                         \
@@ -282,6 +499,10 @@ texture* texture_system_get_default_normal_texture() {
     RETURN_TEXT_PTR_OR_NULL(state_ptr->default_normal_texture, "texture_system_get_default_normal_texture");
 }
 
+texture* texture_system_get_default_cube_texture() {
+    RETURN_TEXT_PTR_OR_NULL(state_ptr->default_cube_texture, "texture_system_get_default_cube_texture");
+}
+
 b8 create_default_textures(texture_system_state* state) {
     // NOTE: Create default texture, a 256x256 blue/white checkerboard pattern.
     // This is done in code to eliminate asset dependencies.
@@ -383,6 +604,22 @@ b8 create_default_textures(texture_system_state* state) {
     // Manually set the texture generation to invalid since this is a default texture.
     state->default_normal_texture.generation = INVALID_ID;
 
+    // Cube texture, sampled by skyboxes while theirs load.
+    // KTRACE("Creating default cube texture...");
+    u8 cube_pixels[16 * 16 * 4 * 6];
+    // Default cube map is all black.
+    kset_memory(cube_pixels, 0, sizeof(u8) * 16 * 16 * 4 * 6);
+    string_ncopy(state->default_cube_texture.name, DEFAULT_CUBE_TEXTURE_NAME, TEXTURE_NAME_MAX_LENGTH);
+    state->default_cube_texture.width = 16;
+    state->default_cube_texture.height = 16;
+    state->default_cube_texture.channel_count = 4;
+    state->default_cube_texture.generation = INVALID_ID;
+    state->default_cube_texture.flags = 0;
+    state->default_cube_texture.type = TEXTURE_TYPE_CUBE;
+    renderer_texture_create(cube_pixels, &state->default_cube_texture);
+    // Manually set the texture generation to invalid since this is a default texture.
+    state->default_cube_texture.generation = INVALID_ID;
+
     return true;
 }
 
@@ -392,73 +629,406 @@ void destroy_default_textures(texture_system_state* state) {
         destroy_texture(&state->default_diffuse_texture);
         destroy_texture(&state->default_specular_texture);
         destroy_texture(&state->default_normal_texture);
+        destroy_texture(&state->default_cube_texture);
     }
 }
 
-b8 load_cube_textures(const char* name, const char texture_names[6][TEXTURE_NAME_MAX_LENGTH], texture* t) {
-    u8* pixels = 0;
-    u64 image_size = 0;
+// Joins the loaded sides of a cube texture into one image, in the order they are uploaded, unloading each.
+static b8 cube_sides_join(cube_texture_load* load) {
+    b8 result = true;
+    texture* t = &load->temp_texture;
     for (u8 i = 0; i < 6; ++i) {
-        image_resource_params params;
-        params.flip_y = false;
-
-        resource img_resource;
-        if (!resource_system_load(texture_names[i], RESOURCE_TYPE_IMAGE, &params, &img_resource)) {
-            KERROR("load_cube_textures() - Failed to load image resource for texture '%s'", texture_names[i]);
-            return false;
+        image_resource_data* resource_data = load->sides[i].data;
+        if (!resource_data) {
+            result = false;
+            continue;
         }
-
-        image_resource_data* resource_data = img_resource.data;
-        if (!pixels) {
+        if (i == 0) {
             t->width = resource_data->width;
             t->height = resource_data->height;
             t->channel_count = resource_data->channel_count;
-            t->flags = 0;
-            t->generation = 0;
-            // Take a copy of the name.
-            string_ncopy(t->name, name, TEXTURE_NAME_MAX_LENGTH);
+            t->format = resource_data->format;
+        } else if (t->width != resource_data->width || t->height != resource_data->height || t->channel_count != resource_data->channel_count || t->format != resource_data->format) {
+            // Verify all textures are the same size.
+            KERROR("load_cube_textures - All textures must be the same resolution, bit depth and format.");
+            result = false;
+        }
+    }
 
-            image_size = t->width * t->height * t->channel_count;
-            // NOTE: no need for transparency in cube maps, so not checking for it.
+    if (result) {
+        load->side_size = texture_format_size(t->format, t->width, t->height, t->channel_count);
+        // NOTE: no need for transparency in cube maps, so not checking for it.
+        load->pixels = kallocate(sizeof(u8) * load->side_size * 6, MEMORY_TAG_ARRAY);
+        for (u8 i = 0; i < 6; ++i) {
+            // Copy to the relevant portion of the array.
+            kcopy_memory(load->pixels + load->side_size * i, ((image_resource_data*)load->sides[i].data)->pixels, load->side_size);
+        }
 
-            pixels = kallocate(sizeof(u8) * image_size * 6, MEMORY_TAG_ARRAY);
-        } else {
-            // Verify all textures are the same size.
-            if (t->width != resource_data->width || t->height != resource_data->height || t->channel_count != resource_data->channel_count) {
-                KERROR("load_cube_textures - All textures must be the same resolution and bit depth.");
-                kfree(pixels, sizeof(u8) * image_size * 6, MEMORY_TAG_ARRAY);
-                pixels = 0;
-                return false;
-            }
+        // Only the first level of each side is taken, and the rest generated where possible.
+        t->mip_levels = 1;
+        t->flags = 0;
+        t->generation = INVALID_ID;
+        string_ncopy(t->name, load->name, TEXTURE_NAME_MAX_LENGTH);
+    }
+
+    // Clean up data.
+    for (u8 i = 0; i < 6; ++i) {
+        if (load->sides[i].data) {
+            resource_system_unload(&load->sides[i]);
         }
+    }
+    return result;
+}
+
+static void cube_texture_load_free(cube_texture_load* load) {
+    if (load->pixels) {
+        kfree(load->pixels, sizeof(u8) * load->side_size * 6, MEMORY_TAG_ARRAY);
+    }
+    kfree(load, sizeof(cube_texture_load), MEMORY_TAG_TEXTURE);
+}
+
+void cube_side_load_job_success(void* params) {
+    cube_side_load_params* side_params = (cube_side_load_params*)params;
+    if (!side_params->last) {
+        return;
+    }
+    cube_texture_load* load = side_params->load;
+    texture* out_texture = load->out_texture;
+
+    // The texture may have been released while it loaded.
+    if (state_ptr && out_texture->type == TEXTURE_TYPE_CUBE && strings_equal(out_texture->name, load->name)) {
+        // Acquire internal texture resources and upload to GPU. Can't be jobified until the renderer is multithreaded.
+        renderer_texture_create(load->pixels, &load->temp_texture);
+
+        // Take a copy of the old texture. The new one takes its place in the registry.
+        texture old = *out_texture;
+        load->temp_texture.id = old.id;
+        load->temp_texture.type = old.type;
+        *out_texture = load->temp_texture;
+        if (old.generation != INVALID_ID) {
+            renderer_texture_destroy(&old);
+        }
+        out_texture->generation = load->current_generation == INVALID_ID ? 0 : load->current_generation + 1;
+
+        KTRACE("Successfully loaded cube texture '%s'.", load->name);
+        counter_add(state_ptr->loads_counter, 1);
+    }
+
+    cube_texture_load_free(load);
+}
 
-        // Copy to the relevant portion of the array.
-        kcopy_memory(pixels + image_size * i, resource_data->pixels, image_size);
+void cube_side_load_job_fail(void* params) {
+    cube_side_load_params* side_params = (cube_side_load_params*)params;
+    if (!side_params->last) {
+        return;
+    }
+    cube_texture_load* load = side_params->load;
 
-        // Clean up data.
-        resource_system_unload(&img_resource);
+    // The texture keeps whatever it had before.
+    KERROR("Failed to load cube texture '%s'.", load->name);
+    if (state_ptr) {
+        counter_add(state_ptr->load_failures_counter, 1);
     }
+    cube_texture_load_free(load);
+}
 
-    // Acquire internal texture resources and upload to GPU.
-    renderer_texture_create(pixels, t);
+b8 cube_side_load_job_start(void* params, void* result_data) {
+    cube_side_load_params* side_params = (cube_side_load_params*)params;
+    cube_texture_load* load = side_params->load;
 
-    kfree(pixels, sizeof(u8) * image_size * 6, MEMORY_TAG_ARRAY);
-    pixels = 0;
+    image_resource_params resource_params = {};
+    resource_params.flip_y = false;
 
+    resource* side = &load->sides[side_params->side];
+    if (!resource_system_load(load->side_names[side_params->side], RESOURCE_TYPE_IMAGE, &resource_params, side) || !side->data) {
+        KERROR("load_cube_textures() - Failed to load image resource for texture '%s'", load->side_names[side_params->side]);
+        side->data = 0;
+    }
+
+    // The side to finish last sees every other side loaded, and joins them.
+    b8 result = true;
+    side_params->last = katomic_fetch_sub(&load->remaining, 1) == 1;
+    if (side_params->last) {
+        result = cube_sides_join(load);
+    }
+
+    // NOTE: The load params are also used as the result data here.
+    kcopy_memory(result_data, side_params, sizeof(cube_side_load_params));
+    return result;
+}
+
+b8 load_cube_textures(const char* name, const char texture_names[6][TEXTURE_NAME_MAX_LENGTH], texture* t) {
+    // Kick off a job for each side. Only handles loading from disk to CPU, and joining the sides.
+    // GPU upload is handled after completion of the last of them.
+    cube_texture_load* load = kallocate(sizeof(cube_texture_load), MEMORY_TAG_TEXTURE);
+    kzero_memory(load, sizeof(cube_texture_load));
+    string_ncopy(load->name, name, TEXTURE_NAME_MAX_LENGTH);
+    kcopy_memory(load->side_names, texture_names, sizeof(load->side_names));
+    load->out_texture = t;
+    load->current_generation = t->generation;
+    load->remaining = 6;
+
+    // Take a copy of the name now, so a release while loading is noticed. The default cube texture
+    // is sampled in its place meanwhile.
+    string_ncopy(t->name, name, TEXTURE_NAME_MAX_LENGTH);
+
+    for (u8 i = 0; i < 6; ++i) {
+        cube_side_load_params params;
+        params.load = load;
+        params.side = i;
+        params.last = false;
+        job_info job = job_create(cube_side_load_job_start, cube_side_load_job_success, cube_side_load_job_fail, &params, sizeof(cube_side_load_params), sizeof(cube_side_load_params));
+        // A fiber, so that the job thread runs other loads while this one waits on its file reads.
+        job.use_fiber = true;
+        job_system_submit(job);
+    }
     return true;
 }
 
+// The estimated memory taken by a streamed texture loaded from the given level.
+static u64 texture_stream_size(const texture_stream* s, const texture* t, u32 level) {
+    return texture_format_chain_size(t->format, KMAX(s->full_width >> level, 1), KMAX(s->full_height >> level, 1), t->channel_count);
+}
+
+// Starts loading the given level of a streamed texture. Its memory is counted as landed right
+// away, so that evictions and upgrades in the same update see room made or taken.
+static void texture_stream_load(u32 index, u32 level) {
+    texture_stream* s = &state_ptr->streams[index];
+    texture* t = &state_ptr->registered_textures[index];
+    u64 size = texture_stream_size(s, t, level);
+    state_ptr->streaming_size = state_ptr->streaming_size - s->size + size;
+    s->size = size;
+    s->target_level = level;
+    load_texture(t->name, t, level, 0);
+}
+
+// Records what a streamed load brought in, tracking the texture if this was its first load.
+static void texture_stream_loaded(u32 index, const image_resource_data* resource_data) {
+    texture_stream* s = &state_ptr->streams[index];
+    texture* t = &state_ptr->registered_textures[index];
+    if (!s->tracked) {
+        s->tracked = true;
+        s->frame_level = INVALID_ID;
+        s->wanted_level = resource_data->first_level;
+        s->loaded_frame = state_ptr->streaming_frame;
+        s->last_used_frame = state_ptr->streaming_frame;
+        darray_push(state_ptr->streamed_ids, index);
+    }
+    s->full_width = t->width << resource_data->first_level;
+    s->full_height = t->height << resource_data->first_level;
+    s->level_count = KMAX(resource_data->source_level_count, 1);
+    s->resident_level = resource_data->first_level;
+    s->rest_level = 0;
+    while (s->rest_level + 1 < s->level_count && KMAX(s->full_width >> s->rest_level, s->full_height >> s->rest_level) > TEXTURE_STREAMING_REST_SIZE) {
+        s->rest_level++;
+    }
+
+    u64 size = texture_stream_size(s, t, s->resident_level);
+    state_ptr->streaming_size = state_ptr->streaming_size - s->size + size;
+    s->size = size;
+}
+
+// Stops streaming a texture which is being destroyed. A load still in flight is cancelled, or dropped when it lands.
+static void texture_stream_forget(u32 index) {
+    texture_stream* s = &state_ptr->streams[index];
+    if (s->serial) {
+        job_system_cancel(s->job);
+    }
+    state_ptr->streaming_size -= s->size;
+    if (s->tracked) {
+        u32 count = darray_length(state_ptr->streamed_ids);
+        for (u32 i = 0; i < count; ++i) {
+            if (state_ptr->streamed_ids[i] == index) {
+                u32 removed;
+                darray_swap_remove(state_ptr->streamed_ids, i, &removed);
+                break;
+            }
+        }
+    }
+    kzero_memory(s, sizeof(texture_stream));
+}
+
+// The level a streamed texture was last wanted at, coarser while GPU memory is short.
+static u32 texture_stream_wanted_level(const texture_stream* s) {
+    u32 level = s->wanted_level + (u32)state_ptr->memory_pressure * TEXTURE_STREAMING_PRESSURE_LEVELS;
+    return KMIN(level, KMAX(s->level_count, 1) - 1);
+}
+
+// The level a streamed texture should hold at most: the one it is wanted at, or the one it rests
+// at once unused for a while. Never finer than its rest level, which it is first loaded at.
+static u32 texture_stream_desired_level(const texture_stream* s) {
+    if (s->reported && state_ptr->streaming_frame - s->last_used_frame > TEXTURE_STREAMING_HOLD_FRAMES) {
+        return s->rest_level;
+    }
+    return KMIN(texture_stream_wanted_level(s), s->rest_level);
+}
+
+// Finds the streamed texture holding finer levels than it needs which was used longest ago, or INVALID_ID.
+static u32 texture_stream_victim_find(u32 excluded_index) {
+    u32 victim = INVALID_ID;
+    u32 count = darray_length(state_ptr->streamed_ids);
+    for (u32 i = 0; i < count; ++i) {
+        u32 index = state_ptr->streamed_ids[i];
+        const texture_stream* s = &state_ptr->streams[index];
+        if (index == excluded_index || s->serial != 0 || s->resident_level >= texture_stream_desired_level(s)) {
+            continue;
+        }
+        if (victim == INVALID_ID || s->last_used_frame < state_ptr->streams[victim].last_used_frame) {
+            victim = index;
+        }
+    }
+    return victim;
+}
+
+void texture_system_report_usage(texture* t, f32 screen_size) {
+    if (!state_ptr || !state_ptr->config.streaming_budget || !t || t < state_ptr->registered_textures || t >= state_ptr->registered_textures + state_ptr->config.max_texture_count) {
+        return;
+    }
+    texture_stream* s = &state_ptr->streams[t - state_ptr->registered_textures];
+    if (s->tracked) {
+        u32 level = texture_mip_level_for_screen_size(s->full_width, s->full_height, s->level_count, screen_size);
+        // Views may be built on several threads at once, all reporting the same textures.
+        u32 current = katomic_load_relaxed(&s->frame_level);
+        while (level < current && !katomic_compare_exchange(&s->frame_level, &current, level)) {
+        }
+    }
+}
+
+void texture_system_update(void) {
+    if (!state_ptr) {
+        return;
+    }
+
+    // Textures packed since the last update are uploaded together.
+    if (state_ptr->atlas.dirty && state_ptr->atlas_texture) {
+        texture_system_write_data(state_ptr->atlas_texture, 0, TEXTURE_ATLAS_SIZE * TEXTURE_ATLAS_SIZE * 4, state_ptr->atlas.pixels);
+        state_ptr->atlas.dirty = false;
+    }
+
+    // While GPU memory is short, textures nothing refers to are the first to go, including those
+    // released since, such as by materials leaving their own cache.
+    if (state_ptr->memory_pressure != RENDERER_MEMORY_PRESSURE_NONE) {
+        texture_cache_trim(0);
+    }
+
+    if (!state_ptr->config.streaming_budget) {
+        return;
+    }
+    KPROFILE_ZONE("texture_system_update");
+    u64 frame = ++state_ptr->streaming_frame;
+
+    // Take in this frame's reports, and find the texture furthest from the level it wants.
+    u32 best = INVALID_ID;
+    u32 best_gap = 0;
+    u32 count = darray_length(state_ptr->streamed_ids);
+    for (u32 i = 0; i < count; ++i) {
+        u32 index = state_ptr->streamed_ids[i];
+        texture_stream* s = &state_ptr->streams[index];
+        if (s->frame_level != INVALID_ID) {
+            s->wanted_level = s->frame_level;
+            s->frame_level = INVALID_ID;
+            s->reported = true;
+            s->last_used_frame = frame;
+            // Drawn again, so a load it waits on no longer waits on those of textures which are not.
+            if (s->serial) {
+                job_system_priority_set(s->job, JOB_PRIORITY_NORMAL);
+            }
+        } else if (!s->reported && frame - s->loaded_frame > TEXTURE_STREAMING_HOLD_FRAMES) {
+            // Never reported, so drawn some other way, such as by the UI. Wanted whole, and always in use.
+            s->wanted_level = 0;
+            s->last_used_frame = frame;
+        }
+        // A load bringing in finer levels than are now wanted is cancelled, so its memory and bandwidth go elsewhere.
+        if (s->serial && s->target_level < texture_stream_desired_level(s)) {
+            job_system_cancel(s->job);
+        }
+        u32 wanted = texture_stream_wanted_level(s);
+        if (s->serial == 0 && wanted < s->resident_level && s->resident_level - wanted > best_gap) {
+            best = index;
+            best_gap = s->resident_level - wanted;
+        }
+    }
+
+    // While GPU memory is short, the finest levels of textures holding more than they now want are
+    // given back, one texture an update, and nothing is brought in while it is critical.
+    if (state_ptr->memory_pressure != RENDERER_MEMORY_PRESSURE_NONE && state_ptr->streaming_loads < TEXTURE_STREAMING_MAX_LOADS) {
+        u32 victim = texture_stream_victim_find(INVALID_ID);
+        if (victim != INVALID_ID) {
+            texture_stream_load(victim, texture_stream_desired_level(&state_ptr->streams[victim]));
+        }
+    }
+    if (state_ptr->memory_pressure == RENDERER_MEMORY_PRESSURE_CRITICAL) {
+        best = INVALID_ID;
+    }
+
+    // Bring in as fine a level as fits, dropping levels other textures no longer need to make room.
+    if (best != INVALID_ID && state_ptr->streaming_loads < TEXTURE_STREAMING_MAX_LOADS) {
+        texture_stream* s = &state_ptr->streams[best];
+        texture* t = &state_ptr->registered_textures[best];
+        for (u32 level = texture_stream_wanted_level(s); level < s->resident_level; ++level) {
+            u64 extra = texture_stream_size(s, t, level) - s->size;
+            while (state_ptr->streaming_size + extra > state_ptr->config.streaming_budget && state_ptr->streaming_loads < TEXTURE_STREAMING_MAX_LOADS - 1) {
+                u32 victim = texture_stream_victim_find(best);
+                if (victim == INVALID_ID) {
+                    break;
+                }
+                texture_stream_load(victim, texture_stream_desired_level(&state_ptr->streams[victim]));
+            }
+            if (state_ptr->streaming_size + extra <= state_ptr->config.streaming_budget) {
+                texture_stream_load(best, level);
+                break;
+            }
+        }
+    }
+
+    counter_set(state_ptr->streaming_size_gauge, (i64)state_ptr->streaming_size);
+}
+
+static b8 texture_system_on_memory_pressure(u16 code, void* sender, void* listener_inst, event_context context) {
+    texture_system_state* state = listener_inst;
+    renderer_memory_pressure pressure = (renderer_memory_pressure)context.data.u8[0];
+    if (state->config.streaming_budget && pressure > state->memory_pressure) {
+        KDEBUG("Dropping the finest levels of streamed textures, as GPU memory is short.");
+    }
+    state->memory_pressure = pressure;
+    // Left for other systems to act on too.
+    return false;
+}
+
 void texture_load_job_success(void* params) {
     texture_load_params* texture_params = (texture_load_params*)params;
 
-    // This also handles the GPU upload. Can't be jobified until the renderer is multithreaded.
+    // This also handles the GPU upload, unless the job did it because the renderer is multithreaded.
     image_resource_data* resource_data = (image_resource_data*)texture_params->image_resource.data;
 
-    // Acquire internal texture resources and upload to GPU. Can't be jobified until the renderer is multithreaded.
-    renderer_texture_create(resource_data->pixels, &texture_params->temp_texture);
+    u32 stream_index = INVALID_ID;
+    if (texture_params->stream_serial && state_ptr) {
+        state_ptr->streaming_loads--;
+        stream_index = (u32)(texture_params->out_texture - state_ptr->registered_textures);
+        texture_stream* s = &state_ptr->streams[stream_index];
+        if (s->serial != texture_params->stream_serial) {
+            // The texture was released, or another load was started after this one, while it loaded.
+            if (texture_params->uploaded) {
+                renderer_texture_destroy(&texture_params->temp_texture);
+            }
+            resource_system_unload(&texture_params->image_resource);
+            u32 length = string_length(texture_params->resource_name);
+            kfree(texture_params->resource_name, sizeof(char) * length + 1, MEMORY_TAG_STRING);
+            texture_params->resource_name = 0;
+            return;
+        }
+        s->serial = 0;
+    }
+
+    // Acquire internal texture resources and upload to GPU, if the job could not.
+    if (!texture_params->uploaded) {
+        renderer_texture_create(resource_data->pixels, &texture_params->temp_texture);
+    }
 
-    // Take a copy of the old texture.
+    // Take a copy of the old texture. The new one takes its place in the registry.
     texture old = *texture_params->out_texture;
+    texture_params->temp_texture.id = old.id;
+    texture_params->temp_texture.type = old.type;
 
     // Assign the temp texture to the pointer.
     *texture_params->out_texture = texture_params->temp_texture;
@@ -473,7 +1043,14 @@ void texture_load_job_success(void* params) {
         texture_params->out_texture->generation = texture_params->current_generation + 1;
     }
 
+    if (stream_index != INVALID_ID) {
+        texture_stream_loaded(stream_index, resource_data);
+    }
+
     KTRACE("Successfully loaded texture '%s'.", texture_params->resource_name);
+    if (state_ptr) {
+        counter_add(state_ptr->loads_counter, 1);
+    }
 
     // Clean up data.
     resource_system_unload(&texture_params->image_resource);
@@ -484,21 +1061,98 @@ void texture_load_job_success(void* params) {
     }
 }
 
+// Releases what a load which did not land holds.
+static void texture_load_abandon(texture_load_params* texture_params) {
+    // A streamed texture goes back to counting what it already holds.
+    if (texture_params->stream_serial && state_ptr) {
+        state_ptr->streaming_loads--;
+        texture_stream* s = &state_ptr->streams[texture_params->out_texture - state_ptr->registered_textures];
+        if (s->serial == texture_params->stream_serial) {
+            s->serial = 0;
+            u64 size = s->tracked ? texture_stream_size(s, texture_params->out_texture, s->resident_level) : 0;
+            state_ptr->streaming_size = state_ptr->streaming_size - s->size + size;
+            s->size = size;
+        }
+    }
+
+    // The texture keeps whatever it had before.
+    if (texture_params->image_resource.data) {
+        resource_system_unload(&texture_params->image_resource);
+    }
+    if (texture_params->resource_name) {
+        u32 length = string_length(texture_params->resource_name);
+        kfree(texture_params->resource_name, sizeof(char) * length + 1, MEMORY_TAG_STRING);
+        texture_params->resource_name = 0;
+    }
+}
+
 void texture_load_job_fail(void* params) {
     texture_load_params* texture_params = (texture_load_params*)params;
 
-    KERROR("Failed to load texture '%s'.", texture_params->resource_name);
+    if (texture_params->cancelled) {
+        KTRACE("Load of texture '%s' was cancelled.", texture_params->resource_name);
+    } else {
+        KERROR("Failed to load texture '%s'.", texture_params->resource_name);
+        if (state_ptr) {
+            counter_add(state_ptr->load_failures_counter, 1);
+        }
+    }
+    texture_load_abandon(texture_params);
+}
+
+void texture_load_job_cancel(void* params) {
+    texture_load_params* texture_params = (texture_load_params*)params;
 
-    resource_system_unload(&texture_params->image_resource);
+    KTRACE("Load of texture '%s' was cancelled before it started.", texture_params->resource_name);
+    texture_load_abandon(texture_params);
+}
+
+// Creates a staging buffer for the image being loaded to be decoded into, so it need not be copied there before its upload.
+static void* texture_staging_acquire(u64 size, void* user_data) {
+    texture_load_params* load_params = user_data;
+    if (!renderer_renderbuffer_create(RENDERBUFFER_TYPE_STAGING_CACHED, size, false, &load_params->staging)) {
+        return 0;
+    }
+    renderer_renderbuffer_bind(&load_params->staging, 0);
+    void* pixels = renderer_renderbuffer_map_memory(&load_params->staging, 0, size);
+    if (!pixels) {
+        renderer_renderbuffer_unbind(&load_params->staging);
+        renderer_renderbuffer_destroy(&load_params->staging);
+        kzero_memory(&load_params->staging, sizeof(renderbuffer));
+    }
+    return pixels;
 }
 
 b8 texture_load_job_start(void* params, void* result_data) {
     texture_load_params* load_params = (texture_load_params*)params;
 
-    image_resource_params resource_params;
+    image_resource_params resource_params = {};
     resource_params.flip_y = true;
+    resource_params.first_level = load_params->first_level;
+    resource_params.max_size = load_params->max_size;
+    // Where the upload is made right here, decode straight into its staging memory.
+    b8 multithreaded = renderer_is_multithreaded();
+    if (multithreaded) {
+        resource_params.pixels_acquire = texture_staging_acquire;
+        resource_params.pixels_acquire_user_data = load_params;
+    }
 
     b8 result = resource_system_load(load_params->resource_name, RESOURCE_TYPE_IMAGE, &resource_params, &load_params->image_resource);
+    load_params->cancelled = job_system_cancel_requested();
+    if (result && load_params->cancelled) {
+        // Cancelled while it decoded, so not uploaded.
+        resource_system_unload(&load_params->image_resource);
+        result = false;
+    }
+    if (!result || !load_params->image_resource.data) {
+        if (load_params->staging.internal_data) {
+            renderer_renderbuffer_unbind(&load_params->staging);
+            renderer_renderbuffer_destroy(&load_params->staging);
+        }
+        load_params->image_resource.data = 0;
+        kcopy_memory(result_data, load_params, sizeof(texture_load_params));
+        return false;
+    }
 
     image_resource_data* resource_data = load_params->image_resource.data;
 
@@ -506,25 +1160,31 @@ b8 texture_load_job_start(void* params, void* result_data) {
     load_params->temp_texture.width = resource_data->width;
     load_params->temp_texture.height = resource_data->height;
     load_params->temp_texture.channel_count = resource_data->channel_count;
-
-    load_params->current_generation = load_params->out_texture->generation;
-    load_params->out_texture->generation = INVALID_ID;
-
-    u64 total_size = load_params->temp_texture.width * load_params->temp_texture.height * load_params->temp_texture.channel_count;
-    // Check for transparency
-    b32 has_transparency = false;
-    for (u64 i = 0; i < total_size; i += load_params->temp_texture.channel_count) {
-        u8 a = resource_data->pixels[i + 3];
-        if (a < 255) {
-            has_transparency = true;
-            break;
-        }
-    }
+    load_params->temp_texture.format = resource_data->format;
+    load_params->temp_texture.mip_levels = resource_data->mip_levels;
 
     // Take a copy of the name.
     string_ncopy(load_params->temp_texture.name, load_params->resource_name, TEXTURE_NAME_MAX_LENGTH);
     load_params->temp_texture.generation = INVALID_ID;
-    load_params->temp_texture.flags |= has_transparency ? TEXTURE_FLAG_HAS_TRANSPARENCY : 0;
+    load_params->temp_texture.flags |= resource_data->has_transparency ? TEXTURE_FLAG_HAS_TRANSPARENCY : 0;
+
+    // A multithreaded renderer takes the upload from any thread, so it is done here rather than
+    // holding up the main thread once the job completes.
+    if (multithreaded) {
+        if (resource_data->pixels_acquired) {
+            renderer_texture_create_staged(&load_params->staging, &load_params->temp_texture);
+            // The buffer is the texture's now, so its pixels are no longer to be read.
+            resource_data->pixels = 0;
+        } else {
+            renderer_texture_create(resource_data->pixels, &load_params->temp_texture);
+        }
+        load_params->uploaded = true;
+    }
+    // Anything not decoded into the buffer, such as a pre-compressed container, does not need it.
+    if (load_params->staging.internal_data) {
+        renderer_renderbuffer_unbind(&load_params->staging);
+        renderer_renderbuffer_destroy(&load_params->staging);
+    }
 
     // NOTE: The load params are also used as the result data here, only the image_resource field is populated now.
     kcopy_memory(result_data, load_params, sizeof(texture_load_params));
@@ -532,7 +1192,7 @@ b8 texture_load_job_start(void* params, void* result_data) {
     return result;
 }
 
-b8 load_texture(const char* texture_name, texture* t) {
+b8 load_texture(const char* texture_name, texture* t, u32 first_level, u32 max_size) {
     // Kick off a texture loading job. Only handles loading from disk
     // to CPU. GPU upload is handled after completion of this job.
     texture_load_params params;
@@ -541,12 +1201,73 @@ b8 load_texture(const char* texture_name, texture* t) {
     params.image_resource = (resource){};
     params.current_generation = t->generation;
     params.temp_texture = (texture){};
+    params.first_level = first_level;
+    params.max_size = max_size;
+    params.stream_serial = 0;
+    params.uploaded = false;
+    params.cancelled = false;
+    params.staging = (renderbuffer){0};
+
+    // Every texture loaded from a file is streamed while streaming is enabled. The serial tells
+    // the latest load apart from any still in flight for the same slot, which is cancelled.
+    texture_stream* s = 0;
+    job_priority priority = JOB_PRIORITY_NORMAL;
+    if (state_ptr && state_ptr->config.streaming_budget) {
+        s = &state_ptr->streams[t - state_ptr->registered_textures];
+        if (s->serial) {
+            job_system_cancel(s->job);
+        }
+        state_ptr->streaming_serial = KMAX(state_ptr->streaming_serial + 1, 1);
+        s->serial = state_ptr->streaming_serial;
+        params.stream_serial = s->serial;
+        state_ptr->streaming_loads++;
+        // The loads of textures not drawn this update, such as those giving back levels, wait on those of textures which are.
+        if (s->tracked && s->last_used_frame != state_ptr->streaming_frame) {
+            priority = JOB_PRIORITY_LOW;
+        }
+    }
 
-    job_info job = job_create(texture_load_job_start, texture_load_job_success, texture_load_job_fail, &params, sizeof(texture_load_params), sizeof(texture_load_params));
-    job_system_submit(job);
+    job_info job = job_create_priority(texture_load_job_start, texture_load_job_success, texture_load_job_fail, &params, sizeof(texture_load_params), sizeof(texture_load_params), JOB_TYPE_GENERAL, priority);
+    job.on_cancel = texture_load_job_cancel;
+    // A fiber, so that the job thread runs other loads while this one waits on its file reads.
+    job.use_fiber = true;
+    job_handle handle = job_system_submit(job);
+    if (s) {
+        s->job = handle;
+    }
     return true;
 }
 
+b8 texture_system_reload(const char* name) {
+    if (!state_ptr) {
+        return false;
+    }
+
+    texture_reference ref;
+    if (!hashtable_get(&state_ptr->registered_texture_table, name, &ref) || ref.handle == INVALID_ID) {
+        return false;
+    }
+
+    texture* t = &state_ptr->registered_textures[ref.handle];
+    // Not yet loaded, or still loading; the load under way reads the file anyway.
+    if (t->generation == INVALID_ID) {
+        return false;
+    }
+    if (t->type == TEXTURE_TYPE_CUBE || (t->flags & (TEXTURE_FLAG_IS_WRITEABLE | TEXTURE_FLAG_IS_WRAPPED))) {
+        return false;
+    }
+
+    // The texture is swapped on the main thread once the job is done, so it stays usable meanwhile.
+    KINFO("Reloading texture '%s'.", name);
+    texture_stream* s = &state_ptr->streams[ref.handle];
+    if (state_ptr->config.streaming_budget && s->tracked) {
+        // At the level it holds, or is about to.
+        texture_stream_load(ref.handle, s->serial ? s->target_level : s->resident_level);
+        return true;
+    }
+    return load_texture(name, t, 0, 0);
+}
+
 void destroy_texture(texture* t) {
     // Clean up backend resources.
     renderer_texture_destroy(t);
@@ -557,6 +1278,40 @@ void destroy_texture(texture* t) {
     t->generation = INVALID_ID;
 }
 
+// The memory a registered texture holds, as counted against the cache budget.
+static u64 texture_cached_size(u32 handle) {
+    const texture_stream* s = &state_ptr->streams[handle];
+    if (s->tracked) {
+        return s->size;
+    }
+    const texture* t = &state_ptr->registered_textures[handle];
+    u64 size = texture_format_chain_size(t->format, KMAX(t->width, 1), KMAX(t->height, 1), t->channel_count);
+    return t->type == TEXTURE_TYPE_CUBE ? size * 6 : size;
+}
+
+// Destroys a registered texture nothing refers to, and forgets its name.
+static void texture_unload(u32 handle) {
+    texture* t = &state_ptr->registered_textures[handle];
+    // Taken first, as the name is wiped out when destroyed.
+    char name_copy[TEXTURE_NAME_MAX_LENGTH];
+    string_ncopy(name_copy, t->name, TEXTURE_NAME_MAX_LENGTH);
+
+    resource_cache_remove(&state_ptr->cache, handle);
+    destroy_texture(t);
+    texture_stream_forget(handle);
+
+    // The entry is no longer needed; a missing name reads back as the invalid reference.
+    hashtable_remove(&state_ptr->registered_texture_table, name_copy);
+}
+
+// Destroys the textures released longest ago until those cached take no more than the given size.
+static void texture_cache_trim(u64 max_size) {
+    u32 handle;
+    while (resource_cache_evict(&state_ptr->cache, max_size, &handle)) {
+        texture_unload(handle);
+    }
+}
+
 b8 process_texture_reference(const char* name, texture_type type, i8 reference_diff, b8 auto_release, b8 skip_load, u32* out_texture_id) {
     *out_texture_id = INVALID_ID;
     if (state_ptr) {
@@ -591,17 +1346,18 @@ b8 process_texture_reference(const char* name, texture_type type, i8 reference_d
             // If decrementing, this means a release.
             if (reference_diff < 0) {
                 // Check if the reference count has reached 0. If it has, and the reference
-                // is set to auto-release, destroy the texture.
+                // is set to auto-release, cache the texture in case it is acquired again, or
+                // destroy it if it does not fit.
                 if (ref.reference_count == 0 && ref.auto_release) {
-                    texture* t = &state_ptr->registered_textures[ref.handle];
-
-                    // Destroy/reset texture.
-                    destroy_texture(t);
+                    if (resource_cache_insert(&state_ptr->cache, ref.handle, texture_cached_size(ref.handle))) {
+                        hashtable_set(&state_ptr->registered_texture_table, name_copy, &ref);
+                        texture_cache_trim(state_ptr->cache.budget);
+                        return true;
+                    }
 
-                    // Reset the reference.
-                    ref.handle = INVALID_ID;
-                    ref.auto_release = false;
+                    texture_unload(ref.handle);
                     // KTRACE("Released texture '%s'., Texture unloaded because reference count=0 and auto_release=true.", name_copy);
+                    return true;
                 } else {
                     // KTRACE("Released texture '%s', now has a reference count of '%i' (auto_release=%s).", name_copy, ref.reference_count, ref.auto_release ? "true" : "false");
                 }
@@ -649,7 +1405,9 @@ b8 process_texture_reference(const char* name, texture_type type, i8 reference_d
                                     return false;
                                 }
                             } else {
-                                if (!load_texture(name, t)) {
+                                // Streamed textures start small, and are brought up to the size they are drawn at.
+                                u32 max_size = state_ptr->config.streaming_budget ? TEXTURE_STREAMING_REST_SIZE : 0;
+                                if (!load_texture(name, t, 0, max_size)) {
                                     *out_texture_id = INVALID_ID;
                                     KERROR("Failed to load texture '%s'.", name);
                                     return false;
@@ -661,6 +1419,8 @@ b8 process_texture_reference(const char* name, texture_type type, i8 reference_d
                     }
                 } else {
                     *out_texture_id = ref.handle;
+                    // Held by the cache since its last release, so back in use as it was.
+                    resource_cache_acquire(&state_ptr->cache, ref.handle);
                     // KTRACE("Texture '%s' already exists, ref_count increased to %i.", name, ref.reference_count);
                 }
             }
@@ -20,6 +20,18 @@
 typedef struct texture_system_config {
     /** @brief The maximum number of textures that can be loaded at once. */
     u32 max_texture_count;
+    /**
+     * @brief The most memory, in bytes, textures loaded from files may take between them.
+     * If nonzero, these textures are streamed: each is loaded small first, and the levels it
+     * needs are brought in as it is seen closer up. If zero, each is loaded whole.
+     */
+    u64 streaming_budget;
+    /**
+     * @brief The most memory, in bytes, auto-released textures nothing refers to any more may keep
+     * holding, so that they are there at once if acquired again. Those released longest ago are
+     * destroyed to stay within it. If zero, they are destroyed as soon as they are released.
+     */
+    u64 cache_budget;
 } texture_system_config;
 
 /** @brief The default texture name. */
@@ -34,6 +46,12 @@ typedef struct texture_system_config {
 /** @brief The default normal texture name. */
 #define DEFAULT_NORMAL_TEXTURE_NAME "default_NORM"
 
+/** @brief The default cube texture name. */
+#define DEFAULT_CUBE_TEXTURE_NAME "default_CUBE"
+
+/** @brief The name of the texture small textures acquired with texture_system_acquire_atlased are packed into. */
+#define TEXTURE_ATLAS_NAME "__texture_atlas"
+
 /**
  * @brief Initializes the texture system.
  * Should be called twice; once to get the memory requirement (passing state=0), and a second
@@ -86,6 +104,21 @@ texture* texture_system_acquire(const char* name, b8 auto_release);
  */
 texture* texture_system_acquire_cube(const char* name, b8 auto_release);
 
+/**
+ * @brief Attempts to acquire the texture with the given name packed into the shared texture atlas,
+ * so that everything drawn from atlased textures shares one image. Only small 8-bit RGBA textures
+ * are packed, loaded at once rather than on a job, and stay packed until shutdown; others are
+ * acquired as by texture_system_acquire, auto-releasing. Texture coordinates must be mapped into
+ * the returned rectangle, with texture_atlas_uv_map, and do not repeat. Releasing the returned
+ * texture by name releases a reference as usual.
+ *
+ * @param name The name of the texture to find.
+ * @param out_uv_rect A pointer to hold the texture's part of the returned texture: its offset in xy
+ * and its size in zw. The whole texture, (0, 0, 1, 1), if it was not packed.
+ * @return A pointer to the atlas texture, or to the texture itself if it was not packed.
+ */
+texture* texture_system_acquire_atlased(const char* name, vec4* out_uv_rect);
+
 /**
  * @brief Attempts to acquire a writeable texture with the given name. This does not point to
  * nor attempt to load a texture file. Does also increment the reference counter.
@@ -109,6 +142,34 @@ texture* texture_system_aquire_writeable(const char* name, u32 width, u32 height
  */
 void texture_system_release(const char* name);
 
+/**
+ * @brief Reloads the already-loaded texture with the given name from its file, such as
+ * after the file has changed. The load happens on a job; the texture keeps its current
+ * image until the new one is uploaded, and keeps it if the load fails.
+ * Writeable, wrapped and cube textures are not reloaded.
+ *
+ * @param name The name of the texture to reload.
+ * @return True if a reload was started; false if the texture is not loaded or cannot be reloaded.
+ */
+b8 texture_system_reload(const char* name);
+
+/**
+ * @brief Reports the size a texture is drawn at this frame, so that streaming brings in the
+ * levels it needs. A texture drawn several times keeps the largest size reported. Does nothing
+ * unless streaming is enabled and the texture is streamed. May be called from any thread.
+ *
+ * @param t A pointer to the texture.
+ * @param screen_size The size the texture covers on screen, in pixels, across its longest side.
+ */
+void texture_system_report_usage(texture* t, f32 screen_size);
+
+/**
+ * @brief Starts loading the levels streamed textures need, from what has been reported since the
+ * last update, and drops levels which have gone unused to stay within the streaming budget.
+ * Should be called once per frame.
+ */
+void texture_system_update(void);
+
 /**
  * @brief Wraps the provided internal data in a texture structure using the parameters
  * provided. This is best used for when the renderer system creates internal resources
@@ -162,6 +223,20 @@ b8 texture_system_resize(texture* t, u32 width, u32 height, b8 regenerate_intern
  */
 b8 texture_system_write_data(texture* t, u32 offset, u32 size, void* data);
 
+/**
+ * @brief Writes the given pixels to a rectangle of the provided texture, leaving the rest as it was.
+ * May only be used on writeable textures which have been written whole at least once.
+ *
+ * @param t A pointer to the texture to be written to.
+ * @param x The first column of the rectangle.
+ * @param y The first row of the rectangle.
+ * @param width The width of the rectangle in pixels.
+ * @param height The height of the rectangle in pixels.
+ * @param pixels The pixels of the rectangle, row by row with no gaps between rows.
+ * @return True on success; otherwise false.
+ */
+b8 texture_system_write_region(texture* t, u32 x, u32 y, u32 width, u32 height, const void* pixels);
+
 /**
  * @brief Gets a pointer to the default texture. No reference counting is
  * done for default textures.
@@ -184,4 +259,10 @@ texture* texture_system_get_default_specular_texture();
  * @brief Gets a pointer to the default normal texture. No reference counting is
  * done for default textures.
  */
-texture* texture_system_get_default_normal_texture();
\ No newline at end of file
+texture* texture_system_get_default_normal_texture();
+
+/**
+ * @brief Gets a pointer to the default cube texture, sampled in place of cube textures
+ * which are still loading. No reference counting is done for default textures.
+ */
+texture* texture_system_get_default_cube_texture();
\ No newline at end of file
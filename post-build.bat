@@ -6,6 +6,7 @@ PUSHD bin
 tools.exe buildshaders ^
 ..\assets\shaders\Builtin.MaterialShader.vert.glsl ^
 ..\assets\shaders\Builtin.MaterialShader.frag.glsl ^
+..\assets\shaders\Builtin.MaterialBindlessShader.frag.glsl ^
 ..\assets\shaders\Builtin.UIShader.vert.glsl ^
 ..\assets\shaders\Builtin.UIShader.frag.glsl ^
 ..\assets\shaders\Builtin.SkyboxShader.vert.glsl ^
@@ -14,6 +15,29 @@ tools.exe buildshaders ^
 ..\assets\shaders\Builtin.UIPickShader.frag.glsl ^
 ..\assets\shaders\Builtin.WorldPickShader.vert.glsl ^
 ..\assets\shaders\Builtin.WorldPickShader.frag.glsl ^
+..\assets\shaders\Builtin.DepthPyramidShader.comp.glsl ^
+..\assets\shaders\Builtin.CullShader.comp.glsl ^
+..\assets\shaders\Builtin.SkinningShader.comp.glsl ^
+..\assets\shaders\Builtin.DepthPrepassShader.vert.glsl ^
+..\assets\shaders\Builtin.DebugShader.vert.glsl ^
+..\assets\shaders\Builtin.DebugShader.frag.glsl ^
+..\assets\shaders\Builtin.ParticleEmitShader.comp.glsl ^
+..\assets\shaders\Builtin.ParticleSimulateShader.comp.glsl ^
+..\assets\shaders\Builtin.ParticleSortShader.comp.glsl ^
+..\assets\shaders\Builtin.ParticleShader.vert.glsl ^
+..\assets\shaders\Builtin.ParticleShader.frag.glsl ^
+..\assets\shaders\Shader.Builtin.Material.shadercfg ^
+..\assets\shaders\Shader.Builtin.MaterialBindless.shadercfg ^
+..\assets\shaders\Shader.Builtin.Skybox.shadercfg ^
+..\assets\shaders\Shader.Builtin.UI.shadercfg ^
+..\assets\shaders\Shader.Builtin.UIPick.shadercfg ^
+..\assets\shaders\Shader.Builtin.WorldPick.shadercfg ^
+..\assets\shaders\Shader.Builtin.DepthPrepass.shadercfg ^
+..\assets\shaders\Shader.Builtin.Debug.shadercfg ^
+..\assets\shaders\Shader.Builtin.ParticleEmit.shadercfg ^
+..\assets\shaders\Shader.Builtin.ParticleSimulate.shadercfg ^
+..\assets\shaders\Shader.Builtin.ParticleSort.shadercfg ^
+..\assets\shaders\Shader.Builtin.Particle.shadercfg ^
 IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
 
 POPD
@@ -12,8 +12,14 @@ b8 create_game(game* out_game) {
     out_game->app_config.start_width = 1280;
     out_game->app_config.start_height = 720;
     out_game->app_config.name = "Ignis Engine Testbed";
+    out_game->app_config.hot_reload = true;
+    out_game->app_config.pipelined_simulation = true;
+    out_game->app_config.render_thread = true;
+    // Integrated GPUs cannot keep up at high resolutions, so the world drops resolution to hold 60 fps.
+    out_game->app_config.resolution.enabled = true;
     out_game->boot = game_boot;
     out_game->initialize = game_initialize;
+    out_game->fixed_update = game_fixed_update;
     out_game->update = game_update;
     out_game->render = game_render;
     out_game->on_resize = game_on_resize;
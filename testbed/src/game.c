@@ -7,25 +7,44 @@
 #include <core/input.h>
 #include <core/event.h>
 #include <core/metrics.h>
+#include <core/counters.h>
+#include <core/profiler.h>
 
 #include <containers/darray.h>
 
 #include <math/kmath.h>
 #include <renderer/renderer_types.inl>
 #include <renderer/renderer_frontend.h>
+#include <renderer/render_graph.h>
+#include <renderer/render_capture.h>
+#include <renderer/debug_draw.h>
+#include <renderer/particles.h>
 
 // TODO: temp
 #include <core/identifier.h>
 #include <math/transform.h>
+#include <math/transform_hierarchy.h>
+#include <math/geometry_utils.h>
 #include <resources/skybox.h>
 #include <resources/ui_text.h>
 #include <resources/mesh.h>
 #include <systems/geometry_system.h>
 #include <systems/material_system.h>
 #include <systems/render_view_system.h>
+#include <systems/job_system.h>
+#include <systems/light_system.h>
 // TODO: end temp
 
 b8 configure_render_views(application_config* config);
+static void debug_text_position_update(game_state* state);
+static void debug_text_counters_format(char* buffer, u32 buffer_size);
+static void benchmark_camera_update(game_state* state, f32 delta_time);
+static benchmark_scene benchmark_scene_parse(const char* name);
+static b8 benchmark_scene_create(game_state* state);
+static void benchmark_scene_update(game* game_inst, game_state* state, f32 delta_time);
+static void benchmark_scene_proxies_add(game_state* state);
+static void lights_create(game_state* state);
+static void lights_update(game_state* state, f32 delta_time);
 
 b8 game_on_event(u16 code, void* sender, void* listener_inst, event_context context) {
     game* game_inst = (game*)listener_inst;
@@ -120,8 +139,11 @@ b8 game_on_key(u16 code, void* sender, void* listener_inst, event_context contex
 b8 game_boot(struct game* game_inst) {
     KINFO("Booting testbed...");
 
-    // Setup the frame allocator.
-    linear_allocator_create(MEBIBYTES(64), 0, &game_inst->frame_allocator);
+    // Setup the frame arena, one buffer per frame in flight. Only what a frame uses is committed.
+    if (!frame_arena_create(MEBIBYTES(256), 2, &game_inst->frame_arena)) {
+        KERROR("Failed to create frame arena.");
+        return false;
+    }
 
     application_config* config = &game_inst->app_config;
 
@@ -141,6 +163,7 @@ b8 game_boot(struct game* game_inst) {
     sys_font_config.default_size = 20;
     sys_font_config.name = "Noto Sans";
     sys_font_config.resource_name = "NotoSansCJK";
+    sys_font_config.sdf = false;
 
     config->font_config.default_system_font_count = 1;
     config->font_config.system_font_configs = kallocate(sizeof(sys_font_config) * 1, MEMORY_TAG_ARRAY);
@@ -166,6 +189,29 @@ b8 game_initialize(game* game_inst) {
     // TODO: temp load/prepare stuff
 
     state->models_loaded = false;
+    state->benchmarking = game_inst->app_config.benchmark.frame_count != 0;
+    state->bench_scene = state->benchmarking ? benchmark_scene_parse(game_inst->app_config.benchmark.scene) : BENCHMARK_SCENE_SPONZA;
+
+    state->skybox_view_name = kname_create("skybox");
+    state->world_view_name = kname_create("world");
+    state->ui_view_name = kname_create("ui");
+    state->pick_view_name = kname_create("pick");
+    state->debug_view_name = kname_create("debug");
+    state->particles_view_name = kname_create("particles");
+
+    // A fountain, thrown up and falling back, fading from warm to cool.
+    particle_emitter_config fountain = {0};
+    fountain.position = (vec3){0.0f, 0.0f, -10.0f};
+    fountain.velocity = (vec3){0.0f, 8.0f, 0.0f};
+    fountain.spread = 2.0f;
+    fountain.acceleration = (vec3){0.0f, -9.8f, 0.0f};
+    fountain.rate = 10000.0f;
+    fountain.lifetime = 2.0f;
+    fountain.size_start = 0.15f;
+    fountain.size_end = 0.05f;
+    fountain.colour_start = (vec4){1.0f, 0.8f, 0.3f, 1.0f};
+    fountain.colour_end = (vec4){0.2f, 0.4f, 1.0f, 0.0f};
+    state->fountain_emitter = particle_emitter_create(&fountain);
 
     // Create test ui text objects
     if (!ui_text_create(UI_TEXT_TYPE_BITMAP, "Ubuntu Mono 21px", 21, "Some test text 123,\n\tyo!", &state->test_text)) {
@@ -173,7 +219,7 @@ b8 game_initialize(game* game_inst) {
         return false;
     }
     // Move debug text to new bottom of screen.
-    ui_text_set_position(&state->test_text, vec3_create(20, game_inst->app_config.start_height - 75, 0));
+    ui_text_set_position(&state->test_text, vec3_create(20, game_inst->app_config.start_height - 100, 0));
 
     if (!ui_text_create(UI_TEXT_TYPE_SYSTEM, "Noto Sans CJK JP", 31, "Some system text 123, \n\tyo!\n\n\tこんにちは 한", &state->test_sys_text)) {
         KERROR("Failed to load basic ui system text.");
@@ -192,6 +238,26 @@ b8 game_initialize(game* game_inst) {
     for (u32 i = 0; i < 10; ++i) {
         state->meshes[i].generation = INVALID_ID_U8;
         state->ui_meshes[i].generation = INVALID_ID_U8;
+        state->mesh_transform_ids[i] = INVALID_ID;
+        state->world_scene_generations[i] = INVALID_ID_U8;
+    }
+
+    // The world transforms of the meshes.
+    // Room is kept for the cubes scene's grid.
+    u32 transform_capacity = 64 + (state->bench_scene == BENCHMARK_SCENE_CUBES ? BENCHMARK_CUBE_COUNT : 0);
+    transform_hierarchy_create(transform_capacity, &state->world_transforms_memory_size, 0, 0);
+    state->world_transforms_memory = kallocate(state->world_transforms_memory_size, MEMORY_TAG_TRANSFORM);
+    if (!transform_hierarchy_create(transform_capacity, &state->world_transforms_memory_size, state->world_transforms_memory, &state->world_transforms)) {
+        KERROR("Failed to create world transform hierarchy, aborting game.");
+        return false;
+    }
+
+    // The render proxies of the meshes' geometries.
+    render_scene_create(4096, &state->world_scene_memory_size, 0, 0);
+    state->world_scene_memory = kallocate(state->world_scene_memory_size, MEMORY_TAG_RENDERER);
+    if (!render_scene_create(4096, &state->world_scene_memory_size, state->world_scene_memory, &state->world_scene)) {
+        KERROR("Failed to create world render scene, aborting game.");
+        return false;
     }
 
     u8 mesh_count = 0;
@@ -203,6 +269,7 @@ b8 game_initialize(game* game_inst) {
     geometry_config g_config = geometry_system_generate_cube_config(10.0f, 10.0f, 10.0f, 1.0f, 1.0f, "test_cube", "test_material");
     cube_mesh->geometries[0] = geometry_system_acquire_from_config(g_config, true);
     cube_mesh->transform = transform_create();
+    state->mesh_transform_ids[mesh_count] = transform_hierarchy_add(&state->world_transforms, &cube_mesh->transform, INVALID_ID);
     mesh_count++;
     cube_mesh->generation = 0;
     cube_mesh->unique_id = identifier_aquire_new_id(cube_mesh);
@@ -217,7 +284,7 @@ b8 game_initialize(game* game_inst) {
     cube_mesh_2->geometries[0] = geometry_system_acquire_from_config(g_config, true);
     cube_mesh_2->transform = transform_from_position((vec3){10.0f, 0.0f, 1.0f});
     // Set the first cube as the parent to the second.
-    transform_set_parent(&cube_mesh_2->transform, &cube_mesh->transform);
+    state->mesh_transform_ids[mesh_count] = transform_hierarchy_add(&state->world_transforms, &cube_mesh_2->transform, state->mesh_transform_ids[0]);
     mesh_count++;
     cube_mesh_2->generation = 0;
     cube_mesh_2->unique_id = identifier_aquire_new_id(cube_mesh_2);
@@ -232,7 +299,7 @@ b8 game_initialize(game* game_inst) {
     cube_mesh_3->geometries[0] = geometry_system_acquire_from_config(g_config, true);
     cube_mesh_3->transform = transform_from_position((vec3){5.0f, 0.0f, 1.0f});
     // Set the second cube as the parent to the third.
-    transform_set_parent(&cube_mesh_3->transform, &cube_mesh_2->transform);
+    state->mesh_transform_ids[mesh_count] = transform_hierarchy_add(&state->world_transforms, &cube_mesh_3->transform, state->mesh_transform_ids[1]);
     mesh_count++;
     cube_mesh_3->generation = 0;
     cube_mesh_3->unique_id = identifier_aquire_new_id(cube_mesh_3);
@@ -242,15 +309,17 @@ b8 game_initialize(game* game_inst) {
     state->car_mesh = &state->meshes[mesh_count];
     state->car_mesh->unique_id = identifier_aquire_new_id(state->car_mesh);
     state->car_mesh->transform = transform_from_position((vec3){15.0f, 0.0f, 1.0f});
+    state->mesh_transform_ids[mesh_count] = transform_hierarchy_add(&state->world_transforms, &state->car_mesh->transform, INVALID_ID);
     mesh_count++;
 
     state->sponza_mesh = &state->meshes[mesh_count];
     state->sponza_mesh->unique_id = identifier_aquire_new_id(state->sponza_mesh);
     state->sponza_mesh->transform = transform_from_position_rotation_scale((vec3){15.0f, 0.0f, 1.0f}, quat_identity(), (vec3){0.05f, 0.05f, 0.05f});
+    state->mesh_transform_ids[mesh_count] = transform_hierarchy_add(&state->world_transforms, &state->sponza_mesh->transform, INVALID_ID);
     mesh_count++;
 
     // Load up some test UI geometry.
-    geometry_config ui_config;
+    geometry_config ui_config = {};
     ui_config.vertex_size = sizeof(vertex_2d);
     ui_config.vertex_count = 4;
     ui_config.index_size = sizeof(u32);
@@ -302,6 +371,8 @@ b8 game_initialize(game* game_inst) {
     state->world_camera = camera_system_get_default();
     camera_position_set(state->world_camera, (vec3){10.5f, 5.0f, 9.5f});
 
+    lights_create(state);
+
     // TODO: temp
     event_register(EVENT_CODE_DEBUG0, game_inst, game_on_debug_event);
     event_register(EVENT_CODE_DEBUG1, game_inst, game_on_debug_event);
@@ -313,6 +384,19 @@ b8 game_initialize(game* game_inst) {
 
     kzero_memory(&game_inst->frame_data, sizeof(game_frame_data));
 
+    // Set up what the benchmark scene needs straight away. NOTE: The benchmark itself is only
+    // stood up once the game is initialized, so the config is checked rather than application_benchmark_running.
+    if (state->benchmarking) {
+        if (state->bench_scene == BENCHMARK_SCENE_SPONZA || state->bench_scene == BENCHMARK_SCENE_STREAMING) {
+            event_context context = {};
+            event_fire(EVENT_CODE_DEBUG1, game_inst, context);
+        }
+        if (!benchmark_scene_create(state)) {
+            KERROR("Failed to create the benchmark scene, aborting game.");
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -325,6 +409,10 @@ void game_shutdown(game* game_inst) {
     // Destroy ui texts
     ui_text_destroy(&state->test_text);
     ui_text_destroy(&state->test_sys_text);
+    for (u32 i = 0; i < state->benchmark_text_count; ++i) {
+        ui_text_destroy(&state->benchmark_texts[i]);
+    }
+    state->benchmark_text_count = 0;
 
     event_unregister(EVENT_CODE_DEBUG0, game_inst, game_on_debug_event);
     event_unregister(EVENT_CODE_DEBUG1, game_inst, game_on_debug_event);
@@ -334,28 +422,42 @@ void game_shutdown(game* game_inst) {
     event_unregister(EVENT_CODE_KEY_PRESSED, game_inst, game_on_key);
     event_unregister(EVENT_CODE_KEY_RELEASED, game_inst, game_on_key);
 
-    if (game_inst->frame_data.world_geometries) {
-        darray_destroy(game_inst->frame_data.world_geometries);
-        game_inst->frame_data.world_geometries = 0;
+    for (u32 i = 0; i < 2; ++i) {
+        light_system_point_remove(state->fixed_light_ids[i]);
     }
+    for (u32 i = 0; i < GAME_DRIFTING_LIGHT_COUNT; ++i) {
+        light_system_point_remove(state->drifting_light_ids[i]);
+    }
+
+    // The world geometries are the scene's, so go with it.
+    game_inst->frame_data.world_geometries = 0;
+    render_scene_destroy(&state->world_scene);
+    kfree(state->world_scene_memory, state->world_scene_memory_size, MEMORY_TAG_RENDERER);
+    state->world_scene_memory = 0;
+
+    transform_hierarchy_destroy(&state->world_transforms);
+    kfree(state->world_transforms_memory, state->world_transforms_memory_size, MEMORY_TAG_TRANSFORM);
+    state->world_transforms_memory = 0;
+
+    frame_arena_destroy(&game_inst->frame_arena);
 }
 
-b8 game_update(game* game_inst, f32 delta_time) {
-    // Save the world_geometries darray pointer so we can reuse its allocation
-    // instead of destroying and re-creating it every frame (heap churn).
-    geometry_render_data* saved_geometries = game_inst->frame_data.world_geometries;
+b8 game_fixed_update(game* game_inst, f32 step_time) {
+    game_state* state = (game_state*)game_inst->state;
 
-    // Reset the frame allocator
-    linear_allocator_free_all(&game_inst->frame_allocator);
+    // Only the spin is simulated here, as everything else reads input. It runs alongside the frame
+    // being drawn, so touches nothing but its own angles.
+    state->previous_spin_angle = state->spin_angle;
+    state->spin_angle += 0.5f * step_time;
+    return true;
+}
 
-    // Clear frame data (zeroes world_geometries too, so restore below)
-    kzero_memory(&game_inst->frame_data, sizeof(game_frame_data));
+b8 game_update(game* game_inst, f32 delta_time) {
+    // Move on to the next frame buffer, wiping it.
+    frame_arena_begin_frame(&game_inst->frame_arena);
 
-    // Restore the pre-allocated darray and just reset its length to 0.
-    if (saved_geometries) {
-        darray_clear(saved_geometries);
-        game_inst->frame_data.world_geometries = saved_geometries;
-    }
+    // Clear frame data. The world geometries are set from the render scene below.
+    kzero_memory(&game_inst->frame_data, sizeof(game_frame_data));
 
     static u64 alloc_count = 0;
     u64 prev_alloc_count = alloc_count;
@@ -367,6 +469,12 @@ b8 game_update(game* game_inst, f32 delta_time) {
         KDEBUG("Allocations: %llu (%llu this frame)", alloc_count, alloc_count - prev_alloc_count);
     }
 
+    // Capture a CPU trace of the next few frames, for chrome://tracing or Perfetto.
+    if (input_is_key_up(KEY_F9) && input_was_key_down(KEY_F9)) {
+        KINFO("Capturing a profile of the next 120 frames to 'profile.json'.");
+        profiler_capture_frames(120, "profile.json");
+    }
+
     // TODO: temp
     if (input_is_key_up('T') && input_was_key_down('T')) {
         KDEBUG("Swapping texture!");
@@ -377,6 +485,33 @@ b8 game_update(game* game_inst, f32 delta_time) {
 
     game_state* state = (game_state*)game_inst->state;
 
+    // Capture the render packets of the next few frames, to be replayed with --replay=capture.krc.
+    if (input_is_key_up(KEY_F10) && input_was_key_down(KEY_F10)) {
+        const char* mesh_names[2] = {"falcon", "sponza"};
+        KINFO("Capturing the render packets of the next 60 frames to 'capture.krc'.");
+        render_capture_frames(60, "capture.krc", state->models_loaded ? 2 : 0, mesh_names);
+    }
+
+    // Cycle through the pages of debug text.
+    if (input_is_key_up(KEY_F3) && input_was_key_down(KEY_F3)) {
+        state->debug_page = (state->debug_page + 1) % DEBUG_TEXT_PAGE_COUNT;
+        debug_text_position_update(state);
+    }
+
+    // Toggle the depth prepass of the world view.
+    if (input_is_key_up(KEY_F4) && input_was_key_down(KEY_F4)) {
+        state->depth_prepass = !state->depth_prepass;
+        event_context data = {};
+        data.data.u8[0] = state->depth_prepass;
+        event_fire(EVENT_CODE_SET_DEPTH_PREPASS, game_inst, data);
+    }
+
+    // Toggle drawing the bounds the world is culled by. Only in debug builds.
+    if (input_is_key_up(KEY_F5) && input_was_key_down(KEY_F5)) {
+        debug_draw_enabled_set(!debug_draw_enabled());
+        KINFO("Debug drawing %s.", debug_draw_enabled() ? "enabled" : "disabled");
+    }
+
     // HACK: temp hack to move camera around.
     if (input_is_key_down('A') || input_is_key_down(KEY_LEFT)) {
         camera_yaw(state->world_camera, 1.0f * delta_time);
@@ -420,6 +555,11 @@ b8 game_update(game* game_inst, f32 delta_time) {
         camera_move_down(state->world_camera, temp_move_speed * delta_time);
     }
 
+    // Benchmarks drive their scene, flying the camera along a fixed path instead.
+    if (application_benchmark_running()) {
+        benchmark_scene_update(game_inst, state, delta_time);
+    }
+
     // TODO: temp
     if (input_is_key_up('P') && input_was_key_down('P')) {
         KDEBUG(
@@ -457,15 +597,23 @@ b8 game_update(game* game_inst, f32 delta_time) {
 
     // TODO: end temp
 
-    // Perform a small rotation on the first mesh.
-    quat rotation = quat_from_axis_angle((vec3){0, 1, 0}, 0.5f * delta_time, false);
-    transform_rotate(&state->meshes[0].transform, rotation);
+    // Perform a small rotation on the first mesh, by as far as the spin has come since the last
+    // frame, blended between its last two fixed steps.
+    f32 spin = state->previous_spin_angle + (state->spin_angle - state->previous_spin_angle) * game_inst->fixed_step_alpha;
+    quat rotation = quat_from_axis_angle((vec3){0, 1, 0}, spin - state->applied_spin_angle, false);
+    state->applied_spin_angle = spin;
+    transform_hierarchy_rotate(&state->world_transforms, state->mesh_transform_ids[0], rotation);
 
     // Perform a similar rotation on the second mesh, if it exists.
-    transform_rotate(&state->meshes[1].transform, rotation);
+    transform_hierarchy_rotate(&state->world_transforms, state->mesh_transform_ids[1], rotation);
 
     // Perform a similar rotation on the third mesh, if it exists.
-    transform_rotate(&state->meshes[2].transform, rotation);
+    transform_hierarchy_rotate(&state->world_transforms, state->mesh_transform_ids[2], rotation);
+
+    lights_update(state, delta_time);
+
+    // Bring the world matrices of everything moved up to date, once for the frame.
+    transform_hierarchy_update(&state->world_transforms, false);
 
     // Update the bitmap text with camera position. NOTE: just using the default camera for now.
     camera* world_camera = camera_system_get_default();
@@ -484,103 +632,93 @@ b8 game_update(game* game_inst, f32 delta_time) {
 
     f64 fps, frame_time;
     metrics_frame(&fps, &frame_time);
+    frame_stats stats;
+    metrics_frame_stats_get(&stats);
 
-    // Update the frustum
-    vec3 forward = camera_forward(state->world_camera);
-    vec3 right = camera_right(state->world_camera);
-    vec3 up = camera_up(state->world_camera);
-    // TODO: get camera fov, aspect, etc.
-    state->camera_frustum = frustom_create(&state->world_camera->position, &forward, &right, &up, (f32)state->width / state->height, deg_to_rad(45.0f), 0.1f, 1000.0f);
+    job_system_stats job_stats;
+    job_system_stats_get(&job_stats);
 
-    // Allocate only on first frame; subsequent frames reuse the saved darray above.
-    if (!game_inst->frame_data.world_geometries) {
-        game_inst->frame_data.world_geometries = darray_reserve(geometry_render_data, 512);
-    }
-    u32 draw_count = 0;
+    // A mesh which loaded or changed has its proxies added again. The rest are kept as they were.
     for (u32 i = 0; i < 10; ++i) {
         mesh* m = &state->meshes[i];
-        if (m->generation != INVALID_ID_U8) {
-            mat4 model = transform_get_world(&m->transform);
-
-            for (u32 j = 0; j < m->geometry_count; ++j) {
-                geometry* g = m->geometries[j];
-
-                // // Bounding sphere calculation.
-                // {
-                //     // Translate/scale the extents.
-                //     vec3 extents_min = vec3_mul_mat4(g->extents.min, model);
-                //     vec3 extents_max = vec3_mul_mat4(g->extents.max, model);
-
-                //     f32 min = KMIN(KMIN(extents_min.x, extents_min.y), extents_min.z);
-                //     f32 max = KMAX(KMAX(extents_max.x, extents_max.y), extents_max.z);
-                //     f32 diff = kabs(max - min);
-                //     f32 radius = diff * 0.5f;
-
-                //     // Translate/scale the center.
-                //     vec3 center = vec3_mul_mat4(g->center, model);
-
-                //     if (frustum_intersects_sphere(&state->camera_frustum, &center, radius)) {
-                //         // Add it to the list to be rendered.
-                //         geometry_render_data data = {0};
-                //         data.model = model;
-                //         data.geometry = g;
-                //         data.unique_id = m->unique_id;
-                //         darray_push(game_inst->frame_data.world_geometries, data);
-
-                //         draw_count++;
-                //     }
-                // }
-
-                // AABB calculation
-                {
-                    // Translate/scale the extents.
-                    // vec3 extents_min = vec3_mul_mat4(g->extents.min, model);
-                    vec3 extents_max = vec3_mul_mat4(g->extents.max, model);
-
-                    // Translate/scale the center.
-                    vec3 center = vec3_mul_mat4(g->center, model);
-                    vec3 half_extents = {
-                        kabs(extents_max.x - center.x),
-                        kabs(extents_max.y - center.y),
-                        kabs(extents_max.z - center.z),
-                    };
-
-                    if (frustum_intersects_aabb(&state->camera_frustum, &center, &half_extents)) {
-                        // Add it to the list to be rendered.
-                        geometry_render_data data = {0};
-                        data.model = model;
-                        data.geometry = g;
-                        data.unique_id = m->unique_id;
-                        darray_push(game_inst->frame_data.world_geometries, data);
-
-                        draw_count++;
-                    }
+        if (m->generation != state->world_scene_generations[i]) {
+            render_scene_clear(&state->world_scene);
+            for (u32 k = 0; k < 10; ++k) {
+                mesh* other = &state->meshes[k];
+                state->world_scene_generations[k] = other->generation;
+                if (other->generation == INVALID_ID_U8) {
+                    continue;
+                }
+                for (u32 j = 0; j < other->geometry_count; ++j) {
+                    render_scene_proxy_add(&state->world_scene, other->geometries[j], state->mesh_transform_ids[k], other->unique_id);
                 }
             }
+            benchmark_scene_proxies_add(state);
+            break;
         }
     }
 
-
-    char text_buffer[256];
-    string_format(
-        text_buffer,
-        "\
+    // Only moved proxies are updated, and only a moved camera or proxy culls again. Culled against
+    // the camera's own frustum, so exactly what its views render with.
+    render_scene_update(&state->world_scene, &state->world_transforms, camera_frustum_get(state->world_camera));
+    game_inst->frame_data.world_geometries = render_scene_visible_get(&state->world_scene);
+    u32 draw_count = darray_length(game_inst->frame_data.world_geometries);
+
+#if defined(KDEBUG_DRAW_ENABLED)
+    // The sphere each drawn geometry was culled by.
+    if (debug_draw_enabled()) {
+        vec4 colour = (vec4){0.0f, 1.0f, 0.0f, 1.0f};
+        for (u32 i = 0; i < draw_count; ++i) {
+            const geometry_render_data* g_data = &game_inst->frame_data.world_geometries[i];
+            debug_draw_sphere(bounding_sphere_transform(bounding_sphere_from_extents(g_data->geometry->extents), g_data->model), colour);
+        }
+    }
+#endif
+
+    char* text_buffer = state->debug_text;
+    if (state->debug_page == DEBUG_TEXT_PAGE_COUNTERS) {
+        debug_text_counters_format(text_buffer, sizeof(state->debug_text));
+    } else {
+        string_format(
+            text_buffer,
+            "\
 FPS: %5.1f(%4.1fms)        Pos=[%7.3f %7.3f %7.3f] Rot=[%7.3f, %7.3f, %7.3f]\n\
+Frame: p50=%.2f p95=%.2f p99=%.2f max=%.2fms Hitches: %u   CPU: update=%.2f render=%.2f sleep=%.2fms\n\
 Mouse: X=%-5d Y=%-5d   L=%s R=%s   NDC: X=%.6f, Y=%.6f\n\
-Drawn: %-5u Hovered: %s%u",
-        fps,
-        frame_time,
-        pos.x, pos.y, pos.z,
-        rad_to_deg(rot.x), rad_to_deg(rot.y), rad_to_deg(rot.z),
-        mouse_x, mouse_y,
-        left_down ? "Y" : "N",
-        right_down ? "Y" : "N",
-        mouse_x_ndc,
-        mouse_y_ndc,
-        draw_count,
-        state->hovered_object_id == INVALID_ID ? "none" : "",
-        state->hovered_object_id == INVALID_ID ? 0 : state->hovered_object_id);
-    ui_text_set_text(&state->test_text, text_buffer);
+Drawn: %-5u Hovered: %s%u\n\
+Jobs: %5.1f%% busy   Queued: H=%-4u N=%-4u L=%-4u Waiting: %-4u\n\
+GPU: Skybox=%.2fms World=%.2fms UI=%.2fms Pick=%.2fms   Resolution: %3.0f%%",
+            fps,
+            frame_time,
+            pos.x, pos.y, pos.z,
+            rad_to_deg(rot.x), rad_to_deg(rot.y), rad_to_deg(rot.z),
+            stats.frame_p50_ms,
+            stats.frame_p95_ms,
+            stats.frame_p99_ms,
+            stats.frame_max_ms,
+            stats.hitch_count,
+            stats.update_avg_ms,
+            stats.render_avg_ms,
+            stats.sleep_avg_ms,
+            mouse_x, mouse_y,
+            left_down ? "Y" : "N",
+            right_down ? "Y" : "N",
+            mouse_x_ndc,
+            mouse_y_ndc,
+            draw_count,
+            state->hovered_object_id == INVALID_ID ? "none" : "",
+            state->hovered_object_id == INVALID_ID ? 0 : state->hovered_object_id,
+            metrics_job_utilization(),
+            job_stats.queue_depths[JOB_PRIORITY_HIGH],
+            job_stats.queue_depths[JOB_PRIORITY_NORMAL],
+            job_stats.queue_depths[JOB_PRIORITY_LOW],
+            job_stats.waiting_count,
+            metrics_gpu_time("skybox"),
+            metrics_gpu_time("world"),
+            metrics_gpu_time("ui"),
+            metrics_gpu_time("pick"),
+            renderer_resolution_scale_get() * 100.0f);
+    }
 
     return true;
 }
@@ -589,32 +727,26 @@ b8 game_render(game* game_inst, struct render_packet* packet, f32 delta_time) {
     game_state* state = (game_state*)game_inst->state;
 
     // TODO: temp
+    ui_text_set_text(&state->test_text, state->debug_text);
 
     // TODO: Read from frame config.
-    packet->view_count = 4;
-    packet->views = linear_allocator_allocate(&game_inst->frame_allocator, sizeof(render_view_packet) * packet->view_count);
+#if defined(KDEBUG_DRAW_ENABLED)
+    packet->view_count = 6;
+#else
+    packet->view_count = 5;
+#endif
+    packet->views = frame_arena_allocate(&game_inst->frame_arena, sizeof(render_view_packet) * packet->view_count);
 
     // Skybox
     skybox_packet_data skybox_data = {};
     skybox_data.sb = &state->sb;
-    if (!render_view_system_build_packet(render_view_system_get("skybox"), &game_inst->frame_allocator, &skybox_data, &packet->views[0])) {
-        KERROR("Failed to build packet for view 'skybox'.");
-        return false;
-    }
-
-    // World
-    // TODO: performs a lookup on every frame.
-    if (!render_view_system_build_packet(render_view_system_get("world"), &game_inst->frame_allocator, game_inst->frame_data.world_geometries, &packet->views[1])) {
-        KERROR("Failed to build packet for view 'world_opaque'.");
-        return false;
-    }
 
     // ui
     ui_packet_data ui_packet = {};
 
     u32 ui_mesh_count = 0;
     u32 max_ui_meshes = 10;
-    mesh** ui_meshes = linear_allocator_allocate(&game_inst->frame_allocator, sizeof(mesh*) * max_ui_meshes);
+    mesh** ui_meshes = frame_arena_allocate(&game_inst->frame_arena, sizeof(mesh*) * max_ui_meshes);
 
     for (u32 i = 0; i < max_ui_meshes; ++i) {
         if (state->ui_meshes[i].generation != INVALID_ID_U8) {
@@ -625,25 +757,45 @@ b8 game_render(game* game_inst, struct render_packet* packet, f32 delta_time) {
 
     ui_packet.mesh_data.mesh_count = ui_mesh_count;
     ui_packet.mesh_data.meshes = ui_meshes;
-    ui_packet.text_count = 2;
-    ui_text** texts = linear_allocator_allocate(&game_inst->frame_allocator, sizeof(ui_text*) * ui_packet.text_count);
+    ui_packet.text_count = 2 + state->benchmark_text_count;
+    ui_text** texts = frame_arena_allocate(&game_inst->frame_arena, sizeof(ui_text*) * ui_packet.text_count);
     texts[0] = &state->test_text;
     texts[1] = &state->test_sys_text;
-    ui_packet.texts = texts;
-    if (!render_view_system_build_packet(render_view_system_get("ui"), &game_inst->frame_allocator, &ui_packet, &packet->views[2])) {
-        KERROR("Failed to build packet for view 'ui'.");
-        return false;
+    for (u32 i = 0; i < state->benchmark_text_count; ++i) {
+        texts[2 + i] = &state->benchmark_texts[i];
     }
+    ui_packet.texts = texts;
 
     // Pick uses both world and ui packet data.
     pick_packet_data pick_packet = {};
     pick_packet.ui_mesh_data = ui_packet.mesh_data;
     pick_packet.world_mesh_data = game_inst->frame_data.world_geometries;
+    pick_packet.world_scene = &state->world_scene;
     pick_packet.texts = ui_packet.texts;
     pick_packet.text_count = ui_packet.text_count;
 
-    if (!render_view_system_build_packet(render_view_system_get("pick"), &game_inst->frame_allocator, &pick_packet, &packet->views[3])) {
-        KERROR("Failed to build packet for view 'ui'.");
+    // World and ui are built together. Pick comes after them, as it draws the lods the world view picks.
+    // The skybox is rendered after the world, as it is depth tested against it, so its packet goes second.
+    // Particles are blended over both, so follow them, moved on by the frame's time. Debug drawing follows
+    // them, depth tested against the world too, and takes no data.
+#if defined(KDEBUG_DRAW_ENABLED)
+    render_view_packet_build builds[6] = {
+        {render_view_system_get_by_kname(state->skybox_view_name), &skybox_data, &packet->views[1]},
+        {render_view_system_get_by_kname(state->world_view_name), game_inst->frame_data.world_geometries, &packet->views[0]},
+        {render_view_system_get_by_kname(state->particles_view_name), &delta_time, &packet->views[2]},
+        {render_view_system_get_by_kname(state->debug_view_name), 0, &packet->views[3]},
+        {render_view_system_get_by_kname(state->ui_view_name), &ui_packet, &packet->views[4]},
+        {render_view_system_get_by_kname(state->pick_view_name), &pick_packet, &packet->views[5]}};
+#else
+    render_view_packet_build builds[5] = {
+        {render_view_system_get_by_kname(state->skybox_view_name), &skybox_data, &packet->views[1]},
+        {render_view_system_get_by_kname(state->world_view_name), game_inst->frame_data.world_geometries, &packet->views[0]},
+        {render_view_system_get_by_kname(state->particles_view_name), &delta_time, &packet->views[2]},
+        {render_view_system_get_by_kname(state->ui_view_name), &ui_packet, &packet->views[3]},
+        {render_view_system_get_by_kname(state->pick_view_name), &pick_packet, &packet->views[4]}};
+#endif
+    if (!render_view_system_build_packets(packet->view_count, builds, frame_arena_allocator(&game_inst->frame_arena))) {
+        KERROR("Failed to build render view packets.");
         return false;
     }
     // TODO: end temp
@@ -658,14 +810,264 @@ void game_on_resize(game* game_inst, u32 width, u32 height) {
     state->height = height;
 
     // TODO: temp
-    // Move debug text to new bottom of screen.
-    ui_text_set_position(&state->test_text, vec3_create(20, state->height - 75, 0));
+    // Move debug text to the new edge of the screen.
+    debug_text_position_update(state);
     // TODO: end temp
 }
 
+typedef struct benchmark_camera_key {
+    vec3 position;
+    // Pitch, yaw and roll in radians.
+    vec3 rotation;
+} benchmark_camera_key;
+
+// A loop through and around the scene. The last key matches the first, a full turn later.
+static const benchmark_camera_key benchmark_camera_path[] = {
+    {{10.5f, 5.0f, 9.5f}, {0.0f, 0.0f, 0.0f}},
+    {{15.0f, 5.0f, 30.0f}, {-0.1f, 0.8f, 0.0f}},
+    {{40.0f, 8.0f, 1.0f}, {-0.2f, K_HALF_PI, 0.0f}},
+    {{15.0f, 12.0f, -30.0f}, {-0.3f, K_PI, 0.0f}},
+    {{10.5f, 5.0f, 9.5f}, {0.0f, K_PI_2, 0.0f}},
+};
+
+// The time taken between keys, in seconds.
+#define BENCHMARK_CAMERA_KEY_SECONDS 4.0f
+
+static void benchmark_camera_update(game_state* state, f32 delta_time) {
+    const u32 segment_count = (sizeof(benchmark_camera_path) / sizeof(benchmark_camera_key)) - 1;
+    const f32 path_seconds = BENCHMARK_CAMERA_KEY_SECONDS * segment_count;
+    state->benchmark_time += delta_time;
+    while (state->benchmark_time >= path_seconds) {
+        state->benchmark_time -= path_seconds;
+    }
+    u32 segment = (u32)(state->benchmark_time / BENCHMARK_CAMERA_KEY_SECONDS);
+    segment = KMIN(segment, segment_count - 1);
+    f32 t = (state->benchmark_time - segment * BENCHMARK_CAMERA_KEY_SECONDS) / BENCHMARK_CAMERA_KEY_SECONDS;
+
+    const benchmark_camera_key* from = &benchmark_camera_path[segment];
+    const benchmark_camera_key* to = &benchmark_camera_path[segment + 1];
+    camera_position_set(state->world_camera, vec3_add(from->position, vec3_mul_scalar(vec3_sub(to->position, from->position), t)));
+    camera_rotation_euler_set(state->world_camera, vec3_add(from->rotation, vec3_mul_scalar(vec3_sub(to->rotation, from->rotation), t)));
+}
+
+static const char* benchmark_scene_names[BENCHMARK_SCENE_COUNT] = {"sponza", "cubes", "ui", "streaming"};
+
+static benchmark_scene benchmark_scene_parse(const char* name) {
+    for (u32 i = 0; i < BENCHMARK_SCENE_COUNT; ++i) {
+        if (name && strings_equali(name, benchmark_scene_names[i])) {
+            return (benchmark_scene)i;
+        }
+    }
+    KWARN("Unknown benchmark scene '%s', benchmarking '%s' instead.", name ? name : "", benchmark_scene_names[BENCHMARK_SCENE_SPONZA]);
+    return BENCHMARK_SCENE_SPONZA;
+}
+
+// The spacing between the cubes of the cubes scene, and the corner the grid starts at.
+#define BENCHMARK_CUBE_SPACING 4.0f
+#define BENCHMARK_CUBE_GRID_ORIGIN ((vec3){-50.0f, -8.0f, -64.0f})
+
+// The seconds taken to fly out from and back in to sponza in the streaming scene, how much
+// further out it gets, and how often the first cube's material is swapped.
+#define BENCHMARK_STREAMING_PERIOD_SECONDS 6.0f
+#define BENCHMARK_STREAMING_MAX_DISTANCE_SCALE 12.0f
+#define BENCHMARK_STREAMING_SWAP_FRAMES 90
+
+static b8 benchmark_scene_create(game_state* state) {
+    if (state->bench_scene == BENCHMARK_SCENE_CUBES) {
+        // Each cube is its own transform, so each is its own proxy, culled and drawn separately.
+        for (u32 z = 0; z < BENCHMARK_CUBE_GRID_SIZE; ++z) {
+            for (u32 x = 0; x < BENCHMARK_CUBE_GRID_SIZE; ++x) {
+                vec3 position = vec3_add(BENCHMARK_CUBE_GRID_ORIGIN, (vec3){x * BENCHMARK_CUBE_SPACING, 0.0f, z * BENCHMARK_CUBE_SPACING});
+                transform t = transform_from_position(position);
+                u32 id = transform_hierarchy_add(&state->world_transforms, &t, INVALID_ID);
+                if (id == INVALID_ID) {
+                    KERROR("Failed to add a benchmark cube transform.");
+                    return false;
+                }
+                state->benchmark_cube_transform_ids[z * BENCHMARK_CUBE_GRID_SIZE + x] = id;
+            }
+        }
+    } else if (state->bench_scene == BENCHMARK_SCENE_UI) {
+        // Laid out in columns down the screen, between the debug texts.
+        for (u32 i = 0; i < BENCHMARK_UI_TEXT_COUNT; ++i) {
+            if (!ui_text_create(UI_TEXT_TYPE_BITMAP, "Ubuntu Mono 21px", 21, "", &state->benchmark_texts[i])) {
+                KERROR("Failed to create a benchmark text.");
+                return false;
+            }
+            state->benchmark_text_count++;
+            ui_text_set_position(&state->benchmark_texts[i], vec3_create(20.0f + (i % 4) * 320.0f, 120.0f + (i / 4) * 60.0f, 0));
+        }
+    }
+    return true;
+}
+
+// Adds the proxies of the cubes scene, if it is the one running, after the meshes' proxies are added again.
+static void benchmark_scene_proxies_add(game_state* state) {
+    if (!state->benchmarking || state->bench_scene != BENCHMARK_SCENE_CUBES) {
+        return;
+    }
+    // All share the smallest cube's geometry. The id is that cube's, so any of them is picked as it.
+    mesh* cube = &state->meshes[2];
+    for (u32 i = 0; i < BENCHMARK_CUBE_COUNT; ++i) {
+        render_scene_proxy_add(&state->world_scene, cube->geometries[0], state->benchmark_cube_transform_ids[i], cube->unique_id);
+    }
+}
+
+static void benchmark_scene_update(game* game_inst, game_state* state, f32 delta_time) {
+    benchmark_camera_update(state, delta_time);
+    u32 frame = state->benchmark_frame++;
+
+    if (state->bench_scene == BENCHMARK_SCENE_UI) {
+        // Every text changes every frame, so each is laid out and uploaded again.
+        char text[512];
+        for (u32 i = 0; i < state->benchmark_text_count; ++i) {
+            string_format(text, "Text %2u frame %6u\nvalue=%10.4f\nhash=%08x", i, frame, (f32)(frame * (i + 1)) * 0.0137f, (frame + 1) * 2654435761u ^ i);
+            ui_text_set_text(&state->benchmark_texts[i], text);
+        }
+    } else if (state->bench_scene == BENCHMARK_SCENE_STREAMING) {
+        // Fly out along the path until far enough that textures drop to their smallest levels, then
+        // back in so they stream back in again.
+        f32 phase = (f32)(state->benchmark_time / BENCHMARK_STREAMING_PERIOD_SECONDS) * K_PI_2;
+        f32 scale = 1.0f + (BENCHMARK_STREAMING_MAX_DISTANCE_SCALE - 1.0f) * (0.5f - 0.5f * kcos(phase));
+        vec3 position = camera_position_get(state->world_camera);
+        camera_position_set(state->world_camera, vec3_mul_scalar(position, scale));
+
+        // Swap out the first cube's material now and then, acquiring and releasing its textures.
+        if (frame % BENCHMARK_STREAMING_SWAP_FRAMES == BENCHMARK_STREAMING_SWAP_FRAMES - 1) {
+            event_context context = {};
+            event_fire(EVENT_CODE_DEBUG0, game_inst, context);
+        }
+    }
+}
+
+// The stats page sits at the bottom of the screen, and the taller counters page at the top.
+// The position of a drifting light at the given time, each on a loop of its own around the scene.
+static vec3 drifting_light_position(u32 index, f32 time) {
+    f32 phase = index * 2.39996323f;
+    f32 loop = 4.0f + (index % 7) * 2.5f;
+    f32 speed = 0.2f + (index % 5) * 0.05f;
+    return (vec3){
+        kcos(phase + time * speed) * loop,
+        1.5f + (index % 4) * 2.0f + ksin(phase * 3.0f + time) * 0.5f,
+        ksin(phase + time * speed) * loop * 0.5f};
+}
+
+static void lights_create(game_state* state) {
+    point_light light = {0};
+    light.constant_f = 1.0f;
+    light.linear = 0.35f;
+    light.quadratic = 0.44f;
+
+    // A green light and a red one, where the material shader used to have them.
+    light.position = (vec3){-5.5f, 0.0f, -5.5f};
+    light.colour = (vec4){0.0f, 1.0f, 0.0f, 1.0f};
+    state->fixed_light_ids[0] = light_system_point_add(&light);
+    light.position = (vec3){5.5f, 0.0f, -5.5f};
+    light.colour = (vec4){1.0f, 0.0f, 0.0f, 1.0f};
+    state->fixed_light_ids[1] = light_system_point_add(&light);
+
+    // Many small, dim lights, each of its own colour, which only reach a few metres.
+    light.linear = 0.7f;
+    light.quadratic = 1.8f;
+    for (u32 i = 0; i < GAME_DRIFTING_LIGHT_COUNT; ++i) {
+        light.position = drifting_light_position(i, 0.0f);
+        f32 hue = i * 0.61803399f * 2.0f * K_PI;
+        light.colour = (vec4){0.5f + 0.5f * kcos(hue), 0.5f + 0.5f * kcos(hue - 2.0943951f), 0.5f + 0.5f * kcos(hue + 2.0943951f), 1.0f};
+        state->drifting_light_ids[i] = light_system_point_add(&light);
+    }
+    state->light_time = 0.0f;
+}
+
+static void lights_update(game_state* state, f32 delta_time) {
+    state->light_time += delta_time;
+    for (u32 i = 0; i < GAME_DRIFTING_LIGHT_COUNT; ++i) {
+        const point_light* current = light_system_point_get(state->drifting_light_ids[i]);
+        if (current) {
+            point_light light = *current;
+            light.position = drifting_light_position(i, state->light_time);
+            light_system_point_update(state->drifting_light_ids[i], &light);
+        }
+    }
+}
+
+static void debug_text_position_update(game_state* state) {
+    f32 y = state->debug_page == DEBUG_TEXT_PAGE_COUNTERS ? 20.0f : state->height - 100.0f;
+    ui_text_set_position(&state->test_text, vec3_create(20, y, 0));
+}
+
+// Lists the counters which changed in the last frame and the gauges which are non-zero, two to a line.
+static void debug_text_counters_format(char* buffer, u32 buffer_size) {
+    kstring_builder text;
+    string_builder_create_from_buffer(buffer, buffer_size, &text);
+    string_builder_append(&text, "Counters (F3 for stats)        name: this frame (total), or level for gauges\n");
+    u32 shown = 0;
+    u32 count = counters_count();
+    for (u32 i = 0; i < count; ++i) {
+        counter_snapshot snapshot;
+        if (!counter_snapshot_get(i, &snapshot) || snapshot.frame_value == 0) {
+            continue;
+        }
+        char cell[COUNTER_NAME_MAX_LENGTH + 48];
+        if (snapshot.type == COUNTER_TYPE_GAUGE) {
+            string_nformat(cell, sizeof(cell), "%s: %lld", snapshot.name, snapshot.frame_value);
+        } else {
+            string_nformat(cell, sizeof(cell), "%s: %lld (%lld)", snapshot.name, snapshot.frame_value, snapshot.value);
+        }
+        // Only whole cells are shown, so stop at the first which is cut off.
+        u64 length = text.length;
+        if (!string_builder_append_format(&text, (shown % 2) ? "%s\n" : "%-64s", cell)) {
+            string_builder_truncate(&text, length);
+            break;
+        }
+        shown++;
+    }
+}
+
 b8 configure_render_views(application_config* config) {
     config->render_views = darray_create(render_view_config);
 
+    // The passes and what they render to, from which the load and store operations of every
+    // attachment are derived.
+    render_graph graph;
+    render_graph_create(&graph);
+    u32 window_colour = render_graph_resource_add(&graph, "window_colour", RENDER_TARGET_ATTACHMENT_TYPE_COLOUR, RENDER_TARGET_ATTACHMENT_SOURCE_DEFAULT, 0, 0, RENDER_GRAPH_RESOURCE_FLAG_PRESENT);
+    // Kept, as culling tests against it next frame.
+    u32 window_depth = render_graph_resource_add(&graph, "window_depth", RENDER_TARGET_ATTACHMENT_TYPE_DEPTH, RENDER_TARGET_ATTACHMENT_SOURCE_DEFAULT, 0, 0, RENDER_GRAPH_RESOURCE_FLAG_EXTERNAL);
+    // Kept, as it is read back to find what is under the cursor.
+    u32 pick_colour = render_graph_resource_add(&graph, "pick_colour", RENDER_TARGET_ATTACHMENT_TYPE_COLOUR, RENDER_TARGET_ATTACHMENT_SOURCE_VIEW, 0, 0, RENDER_GRAPH_RESOURCE_FLAG_EXTERNAL);
+    // Shared, as no other pass needs it, so any later depth alike may use the same image.
+    u32 pick_depth = render_graph_resource_add(&graph, "pick_depth", RENDER_TARGET_ATTACHMENT_TYPE_DEPTH, RENDER_TARGET_ATTACHMENT_SOURCE_SHARED, 0, 0, RENDER_GRAPH_RESOURCE_FLAG_NONE);
+
+    u32 world_node = render_graph_pass_add(&graph, "world", RENDERPASS_CLEAR_COLOUR_BUFFER_FLAG | RENDERPASS_CLEAR_DEPTH_BUFFER_FLAG | RENDERPASS_CLEAR_STENCIL_BUFFER_FLAG);
+    render_graph_pass_use(&graph, world_node, window_colour, RENDER_GRAPH_ACCESS_ATTACHMENT);
+    render_graph_pass_use(&graph, world_node, window_depth, RENDER_GRAPH_ACCESS_ATTACHMENT);
+    // The skybox is drawn after the world, depth tested against it, so only shades what the world left uncovered.
+    u32 skybox_node = render_graph_pass_add(&graph, "skybox", RENDERPASS_CLEAR_NONE_FLAG);
+    render_graph_pass_use(&graph, skybox_node, window_colour, RENDER_GRAPH_ACCESS_ATTACHMENT);
+    render_graph_pass_use(&graph, skybox_node, window_depth, RENDER_GRAPH_ACCESS_ATTACHMENT);
+    // Particles are blended over the world and skybox, tested against the world's depth.
+    u32 particles_node = render_graph_pass_add(&graph, "particles", RENDERPASS_CLEAR_NONE_FLAG);
+    render_graph_pass_use(&graph, particles_node, window_colour, RENDER_GRAPH_ACCESS_ATTACHMENT);
+    render_graph_pass_use(&graph, particles_node, window_depth, RENDER_GRAPH_ACCESS_ATTACHMENT);
+#if defined(KDEBUG_DRAW_ENABLED)
+    // Debug drawing is depth tested against the world too, with nothing drawn over it but the ui.
+    u32 debug_node = render_graph_pass_add(&graph, "debug", RENDERPASS_CLEAR_NONE_FLAG);
+    render_graph_pass_use(&graph, debug_node, window_colour, RENDER_GRAPH_ACCESS_ATTACHMENT);
+    render_graph_pass_use(&graph, debug_node, window_depth, RENDER_GRAPH_ACCESS_ATTACHMENT);
+#endif
+    u32 ui_node = render_graph_pass_add(&graph, "ui", RENDERPASS_CLEAR_NONE_FLAG);
+    render_graph_pass_use(&graph, ui_node, window_colour, RENDER_GRAPH_ACCESS_ATTACHMENT);
+    u32 world_pick_node = render_graph_pass_add(&graph, "world_pick", RENDERPASS_CLEAR_COLOUR_BUFFER_FLAG | RENDERPASS_CLEAR_DEPTH_BUFFER_FLAG);
+    render_graph_pass_use(&graph, world_pick_node, pick_colour, RENDER_GRAPH_ACCESS_ATTACHMENT);
+    render_graph_pass_use(&graph, world_pick_node, pick_depth, RENDER_GRAPH_ACCESS_ATTACHMENT);
+    u32 ui_pick_node = render_graph_pass_add(&graph, "ui_pick", RENDERPASS_CLEAR_NONE_FLAG);
+    render_graph_pass_use(&graph, ui_pick_node, pick_colour, RENDER_GRAPH_ACCESS_ATTACHMENT);
+
+    if (!render_graph_compile(&graph)) {
+        KERROR("Failed to compile the render graph.");
+        return false;
+    }
+
     // Skybox view
     render_view_config skybox_config = {};
     skybox_config.type = RENDERER_VIEW_KNOWN_TYPE_SKYBOX;
@@ -673,6 +1075,8 @@ b8 configure_render_views(application_config* config) {
     skybox_config.height = 0;
     skybox_config.name = "skybox";
     skybox_config.view_matrix_source = RENDER_VIEW_VIEW_MATRIX_SOURCE_SCENE_CAMERA;
+    // The skybox and world are rendered at the dynamic resolution, then upscaled before the ui.
+    skybox_config.resolution_scaled = true;
 
     // Renderpass config.
     skybox_config.passes = darray_create(renderpass_config);
@@ -680,21 +1084,10 @@ b8 configure_render_views(application_config* config) {
     skybox_pass.name = "Renderpass.Builtin.Skybox";
     skybox_pass.render_area = (vec4){0, 0, (f32)config->start_width, (f32)config->start_height};  // Default render area resolution.
     skybox_pass.clear_colour = (vec4){0.0f, 0.0f, 0.2f, 1.0f};
-    skybox_pass.clear_flags = RENDERPASS_CLEAR_COLOUR_BUFFER_FLAG;
+    skybox_pass.clear_flags = RENDERPASS_CLEAR_NONE_FLAG;
     skybox_pass.depth = 1.0f;
     skybox_pass.stencil = 0;
-    skybox_pass.target.attachments = darray_create(render_target_attachment_config);
-
-    // Color attachment.
-    render_target_attachment_config skybox_target_colour = {0};
-    skybox_target_colour.type = RENDER_TARGET_ATTACHMENT_TYPE_COLOUR;
-    skybox_target_colour.source = RENDER_TARGET_ATTACHMENT_SOURCE_DEFAULT;
-    skybox_target_colour.load_operation = RENDER_TARGET_ATTACHMENT_LOAD_OPERATION_DONT_CARE;
-    skybox_target_colour.store_operation = RENDER_TARGET_ATTACHMENT_STORE_OPERATION_STORE;
-    skybox_target_colour.present_after = false;
-    darray_push(skybox_pass.target.attachments, skybox_target_colour);
-
-    skybox_pass.target.attachment_count = darray_length(skybox_pass.target.attachments);
+    render_graph_pass_attachments_get(&graph, skybox_node, &skybox_pass);
 
     skybox_pass.render_target_count = renderer_window_attachment_count_get();
 
@@ -710,6 +1103,7 @@ b8 configure_render_views(application_config* config) {
     world_config.height = 0;
     world_config.name = "world";
     world_config.view_matrix_source = RENDER_VIEW_VIEW_MATRIX_SOURCE_SCENE_CAMERA;
+    world_config.resolution_scaled = true;
     world_config.passes = darray_create(renderpass_config);
 
     // Renderpass config.
@@ -717,30 +1111,10 @@ b8 configure_render_views(application_config* config) {
     world_pass.name = "Renderpass.Builtin.World";
     world_pass.render_area = (vec4){0, 0, (f32)config->start_width, (f32)config->start_height};  // Default render area resolution.
     world_pass.clear_colour = (vec4){0.0f, 0.0f, 0.2f, 1.0f};
-    world_pass.clear_flags = RENDERPASS_CLEAR_DEPTH_BUFFER_FLAG | RENDERPASS_CLEAR_STENCIL_BUFFER_FLAG;
+    world_pass.clear_flags = RENDERPASS_CLEAR_COLOUR_BUFFER_FLAG | RENDERPASS_CLEAR_DEPTH_BUFFER_FLAG | RENDERPASS_CLEAR_STENCIL_BUFFER_FLAG;
     world_pass.depth = 1.0f;
     world_pass.stencil = 0;
-    world_pass.target.attachments = darray_create(render_target_attachment_config);
-
-    // Colour attachment
-    render_target_attachment_config world_target_colour = {0};
-    world_target_colour.type = RENDER_TARGET_ATTACHMENT_TYPE_COLOUR;
-    world_target_colour.source = RENDER_TARGET_ATTACHMENT_SOURCE_DEFAULT;
-    world_target_colour.load_operation = RENDER_TARGET_ATTACHMENT_LOAD_OPERATION_LOAD;
-    world_target_colour.store_operation = RENDER_TARGET_ATTACHMENT_STORE_OPERATION_STORE;
-    world_target_colour.present_after = false;
-    darray_push(world_pass.target.attachments, world_target_colour);
-
-    // Depth attachment
-    render_target_attachment_config world_target_depth = {0};
-    world_target_depth.type = RENDER_TARGET_ATTACHMENT_TYPE_DEPTH;
-    world_target_depth.source = RENDER_TARGET_ATTACHMENT_SOURCE_DEFAULT;
-    world_target_depth.load_operation = RENDER_TARGET_ATTACHMENT_LOAD_OPERATION_DONT_CARE;
-    world_target_depth.store_operation = RENDER_TARGET_ATTACHMENT_STORE_OPERATION_STORE;
-    world_target_depth.present_after = false;
-    darray_push(world_pass.target.attachments, world_target_depth);
-
-    world_pass.target.attachment_count = darray_length(world_pass.target.attachments);
+    render_graph_pass_attachments_get(&graph, world_node, &world_pass);
     world_pass.render_target_count = renderer_window_attachment_count_get();
     darray_push(world_config.passes, world_pass);
 
@@ -748,6 +1122,58 @@ b8 configure_render_views(application_config* config) {
 
     darray_push(config->render_views, world_config);
 
+    // Particles view
+    render_view_config particles_config = {};
+    particles_config.type = RENDERER_VIEW_KNOWN_TYPE_PARTICLES;
+    particles_config.width = 0;
+    particles_config.height = 0;
+    particles_config.name = "particles";
+    particles_config.view_matrix_source = RENDER_VIEW_VIEW_MATRIX_SOURCE_SCENE_CAMERA;
+    // At the resolution of the world, whose depth it is tested against.
+    particles_config.resolution_scaled = true;
+    particles_config.passes = darray_create(renderpass_config);
+
+    renderpass_config particles_pass = {0};
+    particles_pass.name = "Renderpass.Builtin.Particles";
+    particles_pass.render_area = (vec4){0, 0, (f32)config->start_width, (f32)config->start_height};
+    particles_pass.clear_colour = (vec4){0.0f, 0.0f, 0.2f, 1.0f};
+    particles_pass.clear_flags = RENDERPASS_CLEAR_NONE_FLAG;
+    particles_pass.depth = 1.0f;
+    particles_pass.stencil = 0;
+    render_graph_pass_attachments_get(&graph, particles_node, &particles_pass);
+    particles_pass.render_target_count = renderer_window_attachment_count_get();
+    darray_push(particles_config.passes, particles_pass);
+    particles_config.pass_count = darray_length(particles_config.passes);
+
+    darray_push(config->render_views, particles_config);
+
+#if defined(KDEBUG_DRAW_ENABLED)
+    // Debug view
+    render_view_config debug_config = {};
+    debug_config.type = RENDERER_VIEW_KNOWN_TYPE_DEBUG;
+    debug_config.width = 0;
+    debug_config.height = 0;
+    debug_config.name = "debug";
+    debug_config.view_matrix_source = RENDER_VIEW_VIEW_MATRIX_SOURCE_SCENE_CAMERA;
+    // At the resolution of the world, whose depth it is tested against.
+    debug_config.resolution_scaled = true;
+    debug_config.passes = darray_create(renderpass_config);
+
+    renderpass_config debug_pass = {0};
+    debug_pass.name = "Renderpass.Builtin.Debug";
+    debug_pass.render_area = (vec4){0, 0, (f32)config->start_width, (f32)config->start_height};
+    debug_pass.clear_colour = (vec4){0.0f, 0.0f, 0.2f, 1.0f};
+    debug_pass.clear_flags = RENDERPASS_CLEAR_NONE_FLAG;
+    debug_pass.depth = 1.0f;
+    debug_pass.stencil = 0;
+    render_graph_pass_attachments_get(&graph, debug_node, &debug_pass);
+    debug_pass.render_target_count = renderer_window_attachment_count_get();
+    darray_push(debug_config.passes, debug_pass);
+    debug_config.pass_count = darray_length(debug_config.passes);
+
+    darray_push(config->render_views, debug_config);
+#endif
+
     // UI view
     render_view_config ui_view_config = {};
     ui_view_config.type = RENDERER_VIEW_KNOWN_TYPE_UI;
@@ -758,25 +1184,14 @@ b8 configure_render_views(application_config* config) {
     ui_view_config.passes = darray_create(renderpass_config);
 
     // Renderpass config
-    renderpass_config ui_pass;
+    renderpass_config ui_pass = {0};
     ui_pass.name = "Renderpass.Builtin.UI";
     ui_pass.render_area = (vec4){0, 0, (f32)config->start_width, (f32)config->start_height};
     ui_pass.clear_colour = (vec4){0.0f, 0.0f, 0.2f, 1.0f};
     ui_pass.clear_flags = RENDERPASS_CLEAR_NONE_FLAG;
     ui_pass.depth = 1.0f;
     ui_pass.stencil = 0;
-    ui_pass.target.attachments = darray_create(render_target_attachment_config);
-
-    render_target_attachment_config ui_target_attachment = {};
-    // Colour attachment.
-    ui_target_attachment.type = RENDER_TARGET_ATTACHMENT_TYPE_COLOUR;
-    ui_target_attachment.source = RENDER_TARGET_ATTACHMENT_SOURCE_DEFAULT;
-    ui_target_attachment.load_operation = RENDER_TARGET_ATTACHMENT_LOAD_OPERATION_LOAD;
-    ui_target_attachment.store_operation = RENDER_TARGET_ATTACHMENT_STORE_OPERATION_STORE;
-    ui_target_attachment.present_after = true;
-
-    darray_push(ui_pass.target.attachments, ui_target_attachment);
-    ui_pass.target.attachment_count = darray_length(ui_pass.target.attachments);
+    render_graph_pass_attachments_get(&graph, ui_node, &ui_pass);
     ui_pass.render_target_count = renderer_window_attachment_count_get();
 
     darray_push(ui_view_config.passes, ui_pass);
@@ -791,6 +1206,8 @@ b8 configure_render_views(application_config* config) {
     pick_view_config.height = 0;
     pick_view_config.name = "pick";
     pick_view_config.view_matrix_source = RENDER_VIEW_VIEW_MATRIX_SOURCE_SCENE_CAMERA;
+    // Its targets are only created once it first renders to them, so never when picking on the CPU.
+    pick_view_config.lazy_render_targets = true;
 
     pick_view_config.passes = darray_create(renderpass_config);
 
@@ -802,27 +1219,7 @@ b8 configure_render_views(application_config* config) {
     world_pick_pass.clear_flags = RENDERPASS_CLEAR_COLOUR_BUFFER_FLAG | RENDERPASS_CLEAR_DEPTH_BUFFER_FLAG;
     world_pick_pass.depth = 1.0f;
     world_pick_pass.stencil = 0;
-    world_pick_pass.target.attachments = darray_create(render_target_attachment_config);
-
-    // Colour attachment
-    render_target_attachment_config world_pick_pass_colour = {0};
-    world_pick_pass_colour.type = RENDER_TARGET_ATTACHMENT_TYPE_COLOUR;
-    world_pick_pass_colour.source = RENDER_TARGET_ATTACHMENT_SOURCE_VIEW;  // Obtain the attachment from the view.
-    world_pick_pass_colour.load_operation = RENDER_TARGET_ATTACHMENT_LOAD_OPERATION_DONT_CARE;
-    world_pick_pass_colour.store_operation = RENDER_TARGET_ATTACHMENT_STORE_OPERATION_STORE;
-    world_pick_pass_colour.present_after = false;
-    darray_push(world_pick_pass.target.attachments, world_pick_pass_colour);
-
-    // Depth attachment
-    render_target_attachment_config world_pick_pass_depth = {0};
-    world_pick_pass_depth.type = RENDER_TARGET_ATTACHMENT_TYPE_DEPTH;
-    world_pick_pass_depth.source = RENDER_TARGET_ATTACHMENT_SOURCE_VIEW;  // Obtain the attachment from the view.
-    world_pick_pass_depth.load_operation = RENDER_TARGET_ATTACHMENT_LOAD_OPERATION_DONT_CARE;
-    world_pick_pass_depth.store_operation = RENDER_TARGET_ATTACHMENT_STORE_OPERATION_STORE;
-    world_pick_pass_depth.present_after = false;
-    darray_push(world_pick_pass.target.attachments, world_pick_pass_depth);
-
-    world_pick_pass.target.attachment_count = darray_length(world_pick_pass.target.attachments);
+    render_graph_pass_attachments_get(&graph, world_pick_node, &world_pick_pass);
     world_pick_pass.render_target_count = 1;  // Not triple-buffering this.
     darray_push(pick_view_config.passes, world_pick_pass);
 
@@ -834,19 +1231,7 @@ b8 configure_render_views(application_config* config) {
     ui_pick_pass.clear_flags = RENDERPASS_CLEAR_NONE_FLAG;
     ui_pick_pass.depth = 1.0f;
     ui_pick_pass.stencil = 0;
-    ui_pick_pass.target.attachments = darray_create(render_target_attachment_config);
-
-    render_target_attachment_config ui_pick_pass_attachment = {0};
-    ui_pick_pass_attachment.type = RENDER_TARGET_ATTACHMENT_TYPE_COLOUR;
-    // Obtain the attachment from the view.
-    ui_pick_pass_attachment.source = RENDER_TARGET_ATTACHMENT_SOURCE_VIEW;
-    ui_pick_pass_attachment.load_operation = RENDER_TARGET_ATTACHMENT_LOAD_OPERATION_LOAD;
-    // Need to store it so it can be sampled afterward.
-    ui_pick_pass_attachment.store_operation = RENDER_TARGET_ATTACHMENT_STORE_OPERATION_STORE;
-    ui_pick_pass_attachment.present_after = false;
-    darray_push(ui_pick_pass.target.attachments, ui_pick_pass_attachment);
-
-    ui_pick_pass.target.attachment_count = darray_length(ui_pick_pass.target.attachments);
+    render_graph_pass_attachments_get(&graph, ui_pick_node, &ui_pick_pass);
     ui_pick_pass.render_target_count = 1;  // Not triple-buffering this.
     darray_push(pick_view_config.passes, ui_pick_pass);
 
@@ -1,36 +1,122 @@
 #pragma once
 
 #include <defines.h>
+#include <core/kname.h>
 #include <game_types.h>
 #include <math/math_types.h>
+#include <math/transform_hierarchy.h>
+#include <renderer/render_scene.h>
 #include <systems/camera_system.h>
 
 // TODO: temp
 #include <resources/skybox.h>
 #include <resources/ui_text.h>
 
+// The pages of debug text, cycled through with F3.
+typedef enum debug_text_page {
+    // Frame timings, the camera, the mouse and job and GPU stats.
+    DEBUG_TEXT_PAGE_STATS,
+    // The engine's counters and gauges which changed in the last frame.
+    DEBUG_TEXT_PAGE_COUNTERS,
+    DEBUG_TEXT_PAGE_COUNT
+} debug_text_page;
+
+// The scenes a benchmark can run, chosen with --benchmark-scene.
+typedef enum benchmark_scene {
+    // Sponza and the car, flown around along the camera path.
+    BENCHMARK_SCENE_SPONZA,
+    // A grid of many cubes sharing one geometry, flown around along the camera path.
+    BENCHMARK_SCENE_CUBES,
+    // Many texts, all of which change every frame.
+    BENCHMARK_SCENE_UI,
+    // Sponza flown towards and away from, swapping a material, so textures stream in and out.
+    BENCHMARK_SCENE_STREAMING,
+    BENCHMARK_SCENE_COUNT
+} benchmark_scene;
+
+// The number of cubes along each side of the cubes scene's grid.
+#define BENCHMARK_CUBE_GRID_SIZE 32
+#define BENCHMARK_CUBE_COUNT (BENCHMARK_CUBE_GRID_SIZE * BENCHMARK_CUBE_GRID_SIZE)
+
+// The number of texts in the ui scene.
+#define BENCHMARK_UI_TEXT_COUNT 32
+
+// The number of point lights drifting around the scene, beyond the two fixed ones.
+#define GAME_DRIFTING_LIGHT_COUNT 254
+
 typedef struct game_state {
     f32 delta_time;
     camera* world_camera;
 
     u16 width, height;
 
-    frustum camera_frustum;
-
     // TODO: temp
     skybox sb;
 
     mesh meshes[10];
+    // The world transforms of the meshes, updated once per frame. Their own transforms only hold where they start.
+    transform_hierarchy world_transforms;
+    void* world_transforms_memory;
+    u64 world_transforms_memory_size;
+    // The id of each mesh's transform in world_transforms, or INVALID_ID.
+    u32 mesh_transform_ids[10];
+    // A render proxy for every geometry of the meshes, kept from frame to frame, so only those
+    // whose world transform changes are updated, and nothing is culled again when nothing moves.
+    render_scene world_scene;
+    void* world_scene_memory;
+    u64 world_scene_memory_size;
+    // The generation of each mesh when its proxies were added to world_scene.
+    u8 world_scene_generations[10];
     mesh* car_mesh;
     mesh* sponza_mesh;
     b8 models_loaded;
+    // The angle the cubes have spun to as of the last two fixed steps, and the angle last applied
+    // to their transforms, blended between the two.
+    f32 spin_angle;
+    f32 previous_spin_angle;
+    f32 applied_spin_angle;
 
     mesh ui_meshes[10];
     ui_text test_text;
     ui_text test_sys_text;
+    // The debug text formatted by the last update, set on test_text once the last frame is drawn.
+    char debug_text[4096];
+    // The page of debug text shown in test_text.
+    debug_text_page debug_page;
+    // Whether the world view draws a depth prepass.
+    b8 depth_prepass;
+    // The ids of the two fixed point lights, and of the lights drifting around the scene.
+    u32 fixed_light_ids[2];
+    u32 drifting_light_ids[GAME_DRIFTING_LIGHT_COUNT];
+    // The time the drifting lights have moved for, in seconds.
+    f32 light_time;
+
+    // Whether a benchmark is running, and the scene it runs.
+    b8 benchmarking;
+    benchmark_scene bench_scene;
+    // The time into the benchmark camera path, in seconds.
+    f32 benchmark_time;
+    // The number of frames the benchmark has updated.
+    u32 benchmark_frame;
+    // The ids of the cubes scene's transforms in world_transforms.
+    u32 benchmark_cube_transform_ids[BENCHMARK_CUBE_COUNT];
+    // The texts of the ui scene.
+    ui_text benchmark_texts[BENCHMARK_UI_TEXT_COUNT];
+    u32 benchmark_text_count;
 
     // The unique identifier of the currently hovered-over object.
     u32 hovered_object_id;
+
+    // View names, hashed once so that they aren't hashed every frame.
+    kname skybox_view_name;
+    kname world_view_name;
+    kname ui_view_name;
+    kname pick_view_name;
+    kname particles_view_name;
+    // Only created in debug builds.
+    kname debug_view_name;
+    // A fountain of particles, to show them off.
+    u32 fountain_emitter;
     // TODO: end temp
 } game_state;
 
@@ -40,6 +126,8 @@ b8 game_boot(struct game* game_inst);
 
 b8 game_initialize(game* game_inst);
 
+b8 game_fixed_update(game* game_inst, f32 step_time);
+
 b8 game_update(game* game_inst, f32 delta_time);
 
 b8 game_render(game* game_inst, struct render_packet* packet, f32 delta_time);
@@ -0,0 +1,89 @@
+#include "bitset_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <containers/bitset.h>
+
+u8 bitset_should_set_clear_and_count() {
+    bitset set;
+    expect_to_be_true(bitset_create(100, 0, &set));
+    expect_should_be(100, set.bit_count);
+    // Storage is whole cache lines.
+    expect_should_be(8, set.word_count);
+    expect_should_be(0, bitset_count(&set));
+
+    bitset_set(&set, 0);
+    bitset_set(&set, 63);
+    bitset_set(&set, 64);
+    bitset_set(&set, 99);
+    expect_to_be_true(bitset_test(&set, 63));
+    expect_to_be_true(bitset_test(&set, 64));
+    expect_to_be_false(bitset_test(&set, 62));
+    expect_should_be(4, bitset_count(&set));
+
+    bitset_clear(&set, 63);
+    expect_to_be_false(bitset_test(&set, 63));
+    expect_should_be(3, bitset_count(&set));
+
+    // Setting everything only sets the usable bits.
+    bitset_set_all(&set);
+    expect_should_be(100, bitset_count(&set));
+    bitset_clear_all(&set);
+    expect_should_be(0, bitset_count(&set));
+
+    bitset_destroy(&set);
+    expect_should_be(0, set.words);
+    return true;
+}
+
+u8 bitset_should_find_and_iterate_set_bits() {
+    bitset set;
+    expect_to_be_true(bitset_create(1000, 0, &set));
+    expect_should_be(INVALID_ID, bitset_find_first_set(&set, 0));
+
+    u32 indices[5] = {3, 64, 65, 511, 999};
+    for (u32 i = 0; i < 5; ++i) {
+        bitset_set(&set, indices[i]);
+    }
+    expect_should_be(64, bitset_find_first_set(&set, 4));
+    expect_should_be(INVALID_ID, bitset_find_first_set(&set, 1000));
+
+    u32 found = 0;
+    for (u32 i = bitset_find_first_set(&set, 0); i != INVALID_ID; i = bitset_find_first_set(&set, i + 1)) {
+        expect_should_be(indices[found], i);
+        found++;
+    }
+    expect_should_be(5, found);
+
+    bitset_destroy(&set);
+    return true;
+}
+
+u8 bitset_should_resize_keeping_bits() {
+    bitset set;
+    expect_to_be_true(bitset_create(10, 0, &set));
+    bitset_set_all(&set);
+
+    // Added bits start clear.
+    expect_to_be_true(bitset_resize(&set, 2000));
+    expect_should_be(10, bitset_count(&set));
+    expect_to_be_false(bitset_test(&set, 10));
+    bitset_set(&set, 1999);
+    expect_should_be(1999, bitset_find_first_set(&set, 10));
+
+    // Shrinking drops the bits past the new end.
+    expect_to_be_true(bitset_resize(&set, 5));
+    expect_should_be(5, bitset_count(&set));
+    expect_should_be(INVALID_ID, bitset_find_first_set(&set, 5));
+
+    bitset_destroy(&set);
+    return true;
+}
+
+void bitset_register_tests() {
+    test_manager_register_test(bitset_should_set_clear_and_count, "Bitset should set, clear and count bits");
+    test_manager_register_test(bitset_should_find_and_iterate_set_bits, "Bitset should find and iterate set bits");
+    test_manager_register_test(bitset_should_resize_keeping_bits, "Bitset should resize, keeping existing bits");
+}
@@ -0,0 +1,162 @@
+#include "darray_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <containers/darray.h>
+#include <core/kmemory.h>
+#include <memory/pool_allocator.h>
+
+u8 darray_should_live_in_buffer_until_outgrown() {
+    darray_buffer(buffer, u32, 4);
+    u32* array = darray_create_in_buffer(u32, buffer);
+    expect_should_be((void*)buffer, (void*)((u64*)array - DARRAY_FIELD_LENGTH));
+    expect_should_be(4, darray_capacity(array));
+
+    u64 alloc_count = get_memory_alloc_count();
+    for (u32 i = 0; i < 4; ++i) {
+        darray_push(array, i);
+    }
+    // Filling the buffer doesn't touch the heap.
+    expect_should_be(alloc_count, get_memory_alloc_count());
+    expect_should_be(DARRAY_STORAGE_BUFFER, _darray_field_get(array, DARRAY_STORAGE));
+
+    // Outgrowing it moves the array to the heap, keeping the contents.
+    u32 value = 4;
+    darray_push(array, value);
+    expect_should_be(DARRAY_STORAGE_HEAP, _darray_field_get(array, DARRAY_STORAGE));
+    expect_should_be(8, darray_capacity(array));
+    expect_should_be(5, darray_length(array));
+    for (u32 i = 0; i < 5; ++i) {
+        expect_should_be(i, array[i]);
+    }
+
+    darray_destroy(array);
+    return true;
+}
+
+u8 darray_should_use_pool_block_until_outgrown() {
+    pool_allocator pool;
+    u64 memory_requirement = 0;
+    u64 block_size = DARRAY_BUFFER_SIZE(u64, 8);
+    pool_allocator_create(block_size, 16, 2, &memory_requirement, 0, 0);
+    void* memory = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    expect_to_be_true(pool_allocator_create(block_size, 16, 2, &memory_requirement, memory, &pool));
+
+    u64* array = darray_create_with_pool(u64, &pool);
+    expect_should_be(DARRAY_STORAGE_POOL, _darray_field_get(array, DARRAY_STORAGE));
+    expect_should_be(8, darray_capacity(array));
+    expect_should_be(1, pool_allocator_free_count(&pool));
+
+    for (u64 i = 0; i < 9; ++i) {
+        darray_push(array, i);
+    }
+    // The array moved to the heap and gave its block back.
+    expect_should_be(DARRAY_STORAGE_HEAP, _darray_field_get(array, DARRAY_STORAGE));
+    expect_should_be(2, pool_allocator_free_count(&pool));
+    for (u64 i = 0; i < 9; ++i) {
+        expect_should_be(i, array[i]);
+    }
+    darray_destroy(array);
+
+    // Destroying an array which stays in its block returns the block.
+    array = darray_create_with_pool(u64, &pool);
+    darray_push(array, (u64)7);
+    expect_should_be(1, pool_allocator_free_count(&pool));
+    darray_destroy(array);
+    expect_should_be(2, pool_allocator_free_count(&pool));
+
+    pool_allocator_destroy(&pool);
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+u8 darray_should_push_range_and_resize_uninitialized() {
+    u32* array = darray_create(u32);
+    u32 values[5] = {1, 2, 3, 4, 5};
+    darray_push_range(array, values, 5);
+    expect_should_be(5, darray_length(array));
+    darray_push_range(array, values, 3);
+    expect_should_be(8, darray_length(array));
+    for (u32 i = 0; i < 8; ++i) {
+        expect_should_be(values[i % 5], array[i]);
+    }
+
+    // Growing past double the capacity goes straight to the needed size.
+    darray_resize_uninitialized(array, 100);
+    expect_should_be(100, darray_length(array));
+    expect_should_be(100, darray_capacity(array));
+    expect_should_be(3, array[7]);
+    array[99] = 42;
+
+    // Shrinking just changes the length.
+    darray_resize_uninitialized(array, 2);
+    expect_should_be(2, darray_length(array));
+    expect_should_be(100, darray_capacity(array));
+
+    darray_destroy(array);
+    return true;
+}
+
+u8 darray_should_swap_remove() {
+    u32* array = darray_create(u32);
+    u32 values[4] = {10, 20, 30, 40};
+    darray_push_range(array, values, 4);
+
+    u32 removed = 0;
+    darray_swap_remove(array, 1, &removed);
+    expect_should_be(20, removed);
+    expect_should_be(3, darray_length(array));
+    // The last entry fills the hole.
+    expect_should_be(10, array[0]);
+    expect_should_be(40, array[1]);
+    expect_should_be(30, array[2]);
+
+    // Removing the last entry, without taking it.
+    darray_swap_remove(array, 2, 0);
+    expect_should_be(2, darray_length(array));
+    expect_should_be(40, array[1]);
+
+    darray_destroy(array);
+    return true;
+}
+
+u8 darray_should_insert_and_pop_at_preserving_order() {
+    u32* array = darray_create(u32);
+    u32 values[3] = {10, 30, 50};
+    darray_push_range(array, values, 3);
+
+    // In the middle, before the last entry, and at the end.
+    u32 value = 20;
+    darray_insert_at(array, 1, value);
+    value = 40;
+    darray_insert_at(array, 3, value);
+    value = 60;
+    darray_insert_at(array, 5, value);
+    expect_should_be(6, darray_length(array));
+    for (u32 i = 0; i < 6; ++i) {
+        expect_should_be((i + 1) * 10, array[i]);
+    }
+
+    u32 popped = 0;
+    darray_pop_at(array, 1, &popped);
+    expect_should_be(20, popped);
+    darray_pop_at(array, 3, 0);
+    expect_should_be(4, darray_length(array));
+    expect_should_be(10, array[0]);
+    expect_should_be(30, array[1]);
+    expect_should_be(40, array[2]);
+    expect_should_be(60, array[3]);
+
+    darray_destroy(array);
+    return true;
+}
+
+void darray_register_tests() {
+    test_manager_register_test(darray_should_live_in_buffer_until_outgrown, "Darray should live in a buffer until it outgrows it");
+    test_manager_register_test(darray_should_use_pool_block_until_outgrown, "Darray should use a pool block until it outgrows it");
+    test_manager_register_test(darray_should_push_range_and_resize_uninitialized, "Darray should push ranges and resize without initializing");
+    test_manager_register_test(darray_should_swap_remove, "Darray should swap remove");
+    test_manager_register_test(darray_should_insert_and_pop_at_preserving_order, "Darray should insert and pop at an index, preserving order");
+}
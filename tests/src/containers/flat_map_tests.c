@@ -0,0 +1,83 @@
+#include "flat_map_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <containers/flat_map.h>
+
+u8 flat_map_should_set_get_and_remove() {
+    flat_map map;
+    expect_to_be_true(flat_map_create(sizeof(u32), 0, &map));
+    expect_should_be(0, flat_map_get(&map, 5));
+
+    // Insert out of order, enough to grow a few times.
+    for (u32 i = 0; i < 100; ++i) {
+        u64 key = (i * 37) % 100;
+        u32 value = (u32)key * 10;
+        expect_should_not_be(0, flat_map_set(&map, key, &value));
+    }
+    expect_should_be(100, map.count);
+
+    // Setting an existing key replaces the value.
+    u32 value = 12345;
+    flat_map_set(&map, 42, &value);
+    expect_should_be(100, map.count);
+    expect_should_be(12345, *(u32*)flat_map_get(&map, 42));
+    expect_should_be(990, *(u32*)flat_map_get(&map, 99));
+
+    // Keys are iterated in order.
+    for (u32 i = 0; i < map.count; ++i) {
+        expect_should_be(i, flat_map_key_at(&map, i));
+    }
+
+    u32 removed = 0;
+    expect_to_be_true(flat_map_remove(&map, 0, &removed));
+    expect_should_be(0, removed);
+    expect_to_be_false(flat_map_remove(&map, 0, 0));
+    expect_to_be_true(flat_map_remove(&map, 50, 0));
+    expect_should_be(98, map.count);
+    expect_should_be(0, flat_map_get(&map, 50));
+    expect_should_be(510, *(u32*)flat_map_get(&map, 51));
+    expect_should_be(1, flat_map_key_at(&map, 0));
+
+    flat_map_destroy(&map);
+    expect_should_be(0, map.keys);
+    return true;
+}
+
+u8 flat_map_should_query_ranges() {
+    flat_map map;
+    expect_to_be_true(flat_map_create(sizeof(u64), 16, &map));
+    for (u64 key = 10; key <= 100; key += 10) {
+        flat_map_set(&map, key, &key);
+    }
+
+    expect_should_be(0, flat_map_lower_bound(&map, 0));
+    expect_should_be(2, flat_map_lower_bound(&map, 30));
+    expect_should_be(3, flat_map_lower_bound(&map, 31));
+    expect_should_be(10, flat_map_lower_bound(&map, 101));
+
+    // Both ends of the range are inclusive.
+    u32 first = 0;
+    u32 count = flat_map_range(&map, 25, 60, &first);
+    expect_should_be(2, first);
+    expect_should_be(4, count);
+    expect_should_be(30, *(u64*)flat_map_value_at(&map, first));
+    expect_should_be(60, *(u64*)flat_map_value_at(&map, first + count - 1));
+
+    expect_should_be(10, flat_map_range(&map, 0, INVALID_ID_U64, &first));
+    expect_should_be(0, flat_map_range(&map, 61, 69, &first));
+    expect_should_be(0, flat_map_range(&map, 60, 10, &first));
+
+    flat_map_clear(&map);
+    expect_should_be(0, flat_map_range(&map, 0, INVALID_ID_U64, &first));
+
+    flat_map_destroy(&map);
+    return true;
+}
+
+void flat_map_register_tests() {
+    test_manager_register_test(flat_map_should_set_get_and_remove, "Flat map should set, get and remove in key order");
+    test_manager_register_test(flat_map_should_query_ranges, "Flat map should query key ranges");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void flat_map_register_tests();
@@ -326,7 +326,7 @@ u8 util_freelist_free(freelist* list, alloc_data* data, u64* currently_allocated
     return true;
 }
 
-u8 freelist_multiple_alloc_and_free_random() {
+static u8 freelist_random_alloc_and_free(freelist_mode mode) {
     freelist list;
 
     // Pick random sizes.
@@ -346,11 +346,11 @@ u8 freelist_multiple_alloc_and_free_random() {
 
     // Get the memory requirement
     u64 memory_requirement = 0;
-    freelist_create(total_size, &memory_requirement, 0, 0);
+    freelist_create_with_mode(total_size, mode, &memory_requirement, 0, 0);
 
     // Allocate and create the freelist.
     void* block = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
-    freelist_create(total_size, &memory_requirement, block, &list);
+    freelist_create_with_mode(total_size, mode, &memory_requirement, block, &list);
 
     // Verify free space.
     u64 free_space = freelist_free_space(&list);
@@ -411,6 +411,164 @@ u8 freelist_multiple_alloc_and_free_random() {
     return true;
 }
 
+u8 freelist_multiple_alloc_and_free_random() {
+    return freelist_random_alloc_and_free(FREELIST_MODE_FIRST_FIT);
+}
+
+u8 freelist_segregated_multiple_alloc_and_free_random() {
+    return freelist_random_alloc_and_free(FREELIST_MODE_SEGREGATED_FIT);
+}
+
+u8 freelist_segregated_should_coalesce_and_report_fragmentation() {
+    freelist list;
+
+    // Get the memory requirement
+    u64 memory_requirement = 0;
+    u64 total_size = 1024;
+    freelist_create_with_mode(total_size, FREELIST_MODE_SEGREGATED_FIT, &memory_requirement, 0, 0);
+
+    // Allocate and create the freelist.
+    void* block = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    freelist_create_with_mode(total_size, FREELIST_MODE_SEGREGATED_FIT, &memory_requirement, block, &list);
+    expect_float_to_be(0.0f, freelist_fragmentation(&list));
+
+    // Fill the list in four blocks, which should be taken from the start of the free range.
+    u64 offsets[4];
+    for (u32 i = 0; i < 4; ++i) {
+        expect_to_be_true(freelist_allocate_block(&list, 256, &offsets[i]));
+        expect_should_be(256 * i, offsets[i]);
+    }
+    expect_should_be(0, freelist_free_space(&list));
+
+    // Free two blocks which do not touch, splitting the free space in half.
+    expect_to_be_true(freelist_free_block(&list, 256, offsets[1]));
+    expect_to_be_true(freelist_free_block(&list, 256, offsets[3]));
+    expect_should_be(512, freelist_free_space(&list));
+    expect_float_to_be(0.5f, freelist_fragmentation(&list));
+
+    // A request larger than either range should fail while fragmented.
+    u64 offset = INVALID_ID;
+    KDEBUG("The following warning message is intentional.");
+    expect_to_be_false(freelist_allocate_block(&list, 512, &offset));
+
+    // Freeing the block between them should join all three into one range.
+    expect_to_be_true(freelist_free_block(&list, 256, offsets[2]));
+    expect_float_to_be(0.0f, freelist_fragmentation(&list));
+    expect_to_be_true(freelist_allocate_block(&list, 768, &offset));
+    expect_should_be(256, offset);
+    expect_should_be(0, freelist_free_space(&list));
+
+    // Free everything, which should leave a single range covering the whole list.
+    expect_to_be_true(freelist_free_block(&list, 768, offset));
+    expect_to_be_true(freelist_free_block(&list, 256, offsets[0]));
+    expect_should_be(total_size, freelist_free_space(&list));
+    expect_to_be_true(freelist_allocate_block(&list, total_size, &offset));
+    expect_should_be(0, offset);
+
+    // Destroy and verify that the memory was unassigned.
+    freelist_destroy(&list);
+    expect_should_be(0, list.memory);
+    kfree(block, memory_requirement, MEMORY_TAG_APPLICATION);
+
+    return true;
+}
+
+u8 freelist_segregated_should_resize() {
+    freelist list;
+
+    // Get the memory requirement
+    u64 memory_requirement = 0;
+    u64 total_size = 512;
+    freelist_create_with_mode(total_size, FREELIST_MODE_SEGREGATED_FIT, &memory_requirement, 0, 0);
+
+    // Allocate and create the freelist.
+    void* block = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    freelist_create_with_mode(total_size, FREELIST_MODE_SEGREGATED_FIT, &memory_requirement, block, &list);
+
+    // Leave a gap at the start, and fill the rest.
+    u64 offset = INVALID_ID;
+    expect_to_be_true(freelist_allocate_block(&list, 64, &offset));
+    expect_to_be_true(freelist_allocate_block(&list, 448, &offset));
+    expect_to_be_true(freelist_free_block(&list, 64, 0));
+
+    // Resize the list, which should keep the gap and add the new space on the end.
+    u64 new_memory_requirement = 0;
+    expect_to_be_true(freelist_resize(&list, &new_memory_requirement, 0, 1024, 0));
+    void* new_block = kallocate(new_memory_requirement, MEMORY_TAG_APPLICATION);
+    void* old_block = 0;
+    expect_to_be_true(freelist_resize(&list, &new_memory_requirement, new_block, 1024, &old_block));
+    expect_should_be(block, old_block);
+    kfree(old_block, memory_requirement, MEMORY_TAG_APPLICATION);
+    expect_should_be(64 + 512, freelist_free_space(&list));
+
+    expect_to_be_true(freelist_allocate_block(&list, 512, &offset));
+    expect_should_be(512, offset);
+    expect_to_be_true(freelist_allocate_block(&list, 64, &offset));
+    expect_should_be(0, offset);
+    expect_should_be(0, freelist_free_space(&list));
+
+    // Destroy and verify that the memory was unassigned.
+    freelist_destroy(&list);
+    expect_should_be(0, list.memory);
+    kfree(new_block, new_memory_requirement, MEMORY_TAG_APPLICATION);
+
+    return true;
+}
+
+static u8 freelist_extend_block_in_mode(freelist_mode mode) {
+    freelist list;
+
+    // Get the memory requirement
+    u64 memory_requirement = 0;
+    u64 total_size = 1024;
+    freelist_create_with_mode(total_size, mode, &memory_requirement, 0, 0);
+
+    // Allocate and create the freelist.
+    void* block = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    freelist_create_with_mode(total_size, mode, &memory_requirement, block, &list);
+
+    // Two blocks, with free space after the second.
+    u64 first = INVALID_ID;
+    u64 second = INVALID_ID;
+    expect_to_be_true(freelist_allocate_block(&list, 128, &first));
+    expect_to_be_true(freelist_allocate_block(&list, 128, &second));
+    expect_should_be(0, first);
+    expect_should_be(128, second);
+
+    // The first block is followed by an allocated block, so it can't grow.
+    expect_to_be_false(freelist_extend_block(&list, first, 128, 64));
+
+    // The second can grow into part of the space after it, and then all of the rest.
+    expect_to_be_true(freelist_extend_block(&list, second, 128, 256));
+    expect_should_be(total_size - 512, freelist_free_space(&list));
+    expect_to_be_false(freelist_extend_block(&list, second, 384, total_size));
+    expect_to_be_true(freelist_extend_block(&list, second, 384, total_size - 512));
+    expect_should_be(0, freelist_free_space(&list));
+
+    // Once the first is freed, everything should coalesce back into one range.
+    expect_to_be_true(freelist_free_block(&list, 128, first));
+    expect_to_be_true(freelist_free_block(&list, total_size - 128, second));
+    expect_should_be(total_size, freelist_free_space(&list));
+    u64 offset = INVALID_ID;
+    expect_to_be_true(freelist_allocate_block(&list, total_size, &offset));
+    expect_should_be(0, offset);
+
+    // Destroy and verify that the memory was unassigned.
+    freelist_destroy(&list);
+    expect_should_be(0, list.memory);
+    kfree(block, memory_requirement, MEMORY_TAG_APPLICATION);
+
+    return true;
+}
+
+u8 freelist_should_extend_block() {
+    return freelist_extend_block_in_mode(FREELIST_MODE_FIRST_FIT);
+}
+
+u8 freelist_segregated_should_extend_block() {
+    return freelist_extend_block_in_mode(FREELIST_MODE_SEGREGATED_FIT);
+}
+
 void freelist_register_tests() {
     test_manager_register_test(freelist_should_create_and_destroy, "Freelist should create and destroy");
     test_manager_register_test(freelist_should_allocate_one_and_free_one, "Freelist allocate and free one entry.");
@@ -418,4 +576,9 @@ void freelist_register_tests() {
     test_manager_register_test(freelist_should_allocate_one_and_free_multi_varying_sizes, "Freelist allocate and free multiple entries of varying sizes.");
     test_manager_register_test(freelist_should_allocate_to_full_and_fail_to_allocate_more, "Freelist allocate to full and fail when trying to allocate more.");
     test_manager_register_test(freelist_multiple_alloc_and_free_random, "Freelist should randomly allocate and free.");
+    test_manager_register_test(freelist_segregated_multiple_alloc_and_free_random, "Segregated freelist should randomly allocate and free.");
+    test_manager_register_test(freelist_segregated_should_coalesce_and_report_fragmentation, "Segregated freelist should coalesce and report fragmentation.");
+    test_manager_register_test(freelist_segregated_should_resize, "Segregated freelist should resize.");
+    test_manager_register_test(freelist_should_extend_block, "Freelist should extend a block in place.");
+    test_manager_register_test(freelist_segregated_should_extend_block, "Segregated freelist should extend a block in place.");
 }
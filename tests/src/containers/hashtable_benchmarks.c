@@ -0,0 +1,106 @@
+#include "hashtable_benchmarks.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+#include <containers/hashtable.h>
+#include <core/kname.h>
+#include <core/kstring.h>
+
+// The number of entries in the tables, about as many as the engine's larger registries hold.
+#define HASHTABLE_BENCH_ENTRY_COUNT 4096
+
+// The number of slots of the direct table, kept large against collisions as its users do.
+#define HASHTABLE_BENCH_DIRECT_SLOT_COUNT (HASHTABLE_BENCH_ENTRY_COUNT * 8)
+
+#define HASHTABLE_BENCH_NAME_LENGTH 32
+
+// Written to so that the compiler can't drop the work being timed.
+static volatile u64 hashtable_bench_sink;
+
+static char names[HASHTABLE_BENCH_ENTRY_COUNT][HASHTABLE_BENCH_NAME_LENGTH];
+static kname knames[HASHTABLE_BENCH_ENTRY_COUNT];
+static hashtable open_table;
+static hashtable direct_table;
+static u64 direct_memory[HASHTABLE_BENCH_DIRECT_SLOT_COUNT];
+
+static u8 tables_setup() {
+    hashtable_create_with_mode(sizeof(u64), 16, HASHTABLE_MODE_OPEN_ADDRESSING, 0, false, &open_table);
+    hashtable_create(sizeof(u64), HASHTABLE_BENCH_DIRECT_SLOT_COUNT, direct_memory, false, &direct_table);
+    for (u64 i = 0; i < HASHTABLE_BENCH_ENTRY_COUNT; ++i) {
+        // Names shaped like the engine's resource names.
+        string_format(names[i], "resource_%04llu.material", i);
+        knames[i] = kname_create(names[i]);
+        if (!hashtable_set(&open_table, names[i], &i) || !hashtable_set(&direct_table, names[i], &i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static u8 tables_teardown() {
+    hashtable_destroy(&open_table);
+    hashtable_destroy(&direct_table);
+    return true;
+}
+
+// Visits the entries with a stride, so consecutive lookups land far apart in the table.
+static u32 entry_index(u32 i) {
+    return (i * 1021) % HASHTABLE_BENCH_ENTRY_COUNT;
+}
+
+static u8 open_get_run(u32 op_count) {
+    u64 total = 0;
+    for (u32 i = 0; i < op_count; ++i) {
+        u64 value;
+        if (!hashtable_get(&open_table, names[entry_index(i)], &value)) {
+            return false;
+        }
+        total += value;
+    }
+    hashtable_bench_sink = total;
+    return true;
+}
+
+static u8 open_get_by_kname_run(u32 op_count) {
+    u64 total = 0;
+    for (u32 i = 0; i < op_count; ++i) {
+        u64 value;
+        if (!hashtable_get_by_kname(&open_table, knames[entry_index(i)], &value)) {
+            return false;
+        }
+        total += value;
+    }
+    hashtable_bench_sink = total;
+    return true;
+}
+
+// Overwrites entries already held, so the table neither grows nor interns new names.
+static u8 open_set_run(u32 op_count) {
+    for (u32 i = 0; i < op_count; ++i) {
+        u64 value = i;
+        if (!hashtable_set(&open_table, names[entry_index(i)], &value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static u8 direct_get_run(u32 op_count) {
+    u64 total = 0;
+    for (u32 i = 0; i < op_count; ++i) {
+        u64 value;
+        if (!hashtable_get(&direct_table, names[entry_index(i)], &value)) {
+            return false;
+        }
+        total += value;
+    }
+    hashtable_bench_sink = total;
+    return true;
+}
+
+void hashtable_register_benchmarks() {
+    test_manager_register_benchmark(tables_setup, open_get_run, tables_teardown, 100000, "hashtable.open_get");
+    test_manager_register_benchmark(tables_setup, open_get_by_kname_run, tables_teardown, 100000, "hashtable.open_get_by_kname");
+    test_manager_register_benchmark(tables_setup, open_set_run, tables_teardown, 100000, "hashtable.open_set");
+    test_manager_register_benchmark(tables_setup, direct_get_run, tables_teardown, 100000, "hashtable.direct_get");
+}
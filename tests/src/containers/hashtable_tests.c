@@ -4,6 +4,8 @@
 
 #include <defines.h>
 #include <containers/hashtable.h>
+#include <core/kname.h>
+#include <core/kstring.h>
 
 u8 hashtable_should_create_and_destroy() {
     hashtable table;
@@ -318,6 +320,135 @@ u8 hashtable_should_set_get_and_update_ptr_successfully() {
     return true;
 }
 
+u8 hashtable_open_should_keep_colliding_names_apart() {
+    hashtable table;
+    // Start small so that the table has to grow several times.
+    hashtable_create_with_mode(sizeof(u64), 4, HASHTABLE_MODE_OPEN_ADDRESSING, 0, false, &table);
+    expect_should_not_be(0, table.memory);
+    expect_should_be(0, table.entry_count);
+
+    char name[32];
+    for (u64 i = 0; i < 1000; ++i) {
+        string_format(name, "entry_%llu", i);
+        expect_to_be_true(hashtable_set(&table, name, &i));
+    }
+    expect_should_be(1000, table.entry_count);
+    // Never over 80% load.
+    expect_to_be_true((table.entry_count * 5 <= table.element_count * 4));
+
+    for (u64 i = 0; i < 1000; ++i) {
+        string_format(name, "entry_%llu", i);
+        u64 value = INVALID_ID_U64;
+        expect_to_be_true(hashtable_get(&table, name, &value));
+        expect_should_be(i, value);
+    }
+
+    // Overwriting keeps a single entry.
+    u64 value = 5000;
+    hashtable_set(&table, "entry_10", &value);
+    expect_should_be(1000, table.entry_count);
+    value = 0;
+    hashtable_get(&table, "entry_10", &value);
+    expect_should_be(5000, value);
+
+    // With no fill value, missing names are not found.
+    expect_to_be_false(hashtable_get(&table, "missing", &value));
+
+    hashtable_destroy(&table);
+    expect_should_be(0, table.memory);
+
+    return true;
+}
+
+u8 hashtable_open_should_remove_and_fill() {
+    hashtable table;
+    hashtable_create_with_mode(sizeof(u64), 64, HASHTABLE_MODE_OPEN_ADDRESSING, 0, false, &table);
+
+    u64 invalid = INVALID_ID_U64;
+    expect_to_be_true(hashtable_fill(&table, &invalid));
+
+    char name[32];
+    for (u64 i = 0; i < 50; ++i) {
+        string_format(name, "entry_%llu", i);
+        hashtable_set(&table, name, &i);
+    }
+
+    // Remove every other entry, then make sure the rest are still reachable past the gaps.
+    for (u64 i = 0; i < 50; i += 2) {
+        string_format(name, "entry_%llu", i);
+        expect_to_be_true(hashtable_remove(&table, name));
+    }
+    expect_should_be(25, table.entry_count);
+    expect_to_be_false(hashtable_remove(&table, "entry_0"));
+
+    for (u64 i = 0; i < 50; ++i) {
+        string_format(name, "entry_%llu", i);
+        u64 value = 0;
+        // Missing names yield the fill value.
+        expect_to_be_true(hashtable_get(&table, name, &value));
+        expect_should_be(((i % 2) ? i : INVALID_ID_U64), value);
+    }
+
+    hashtable_destroy(&table);
+
+    return true;
+}
+
+u8 hashtable_open_should_intern_names_and_unset_ptr() {
+    hashtable table;
+    hashtable_create_with_mode(sizeof(ht_test_struct*), 8, HASHTABLE_MODE_OPEN_ADDRESSING, 0, true, &table);
+
+    ht_test_struct t = {0};
+    t.u_value = 63;
+    ht_test_struct* testval1 = &t;
+
+    // The table keeps its own copy of the name.
+    char name[16];
+    string_ncopy(name, "test1", sizeof(name));
+    expect_to_be_true(hashtable_set_ptr(&table, name, (void**)&testval1));
+    string_ncopy(name, "other", sizeof(name));
+
+    ht_test_struct* get_testval_1 = 0;
+    expect_to_be_true(hashtable_get_ptr(&table, "test1", (void**)&get_testval_1));
+    expect_should_be(63, get_testval_1->u_value);
+    expect_to_be_false(hashtable_get_ptr(&table, "other", (void**)&get_testval_1));
+    expect_should_be(0, get_testval_1);
+
+    // Unsetting removes the entry.
+    expect_to_be_true(hashtable_set_ptr(&table, "test1", 0));
+    expect_should_be(0, table.entry_count);
+    expect_to_be_false(hashtable_get_ptr(&table, "test1", (void**)&get_testval_1));
+
+    hashtable_destroy(&table);
+
+    return true;
+}
+
+u8 hashtable_open_should_get_by_kname() {
+    hashtable table;
+    hashtable_create_with_mode(sizeof(u64), 8, HASHTABLE_MODE_OPEN_ADDRESSING, 0, false, &table);
+
+    u64 value = 42;
+    hashtable_set(&table, "world", &value);
+    value = 7;
+    hashtable_set(&table, "ui", &value);
+
+    kname world = kname_create("world");
+    expect_should_be(world, kname_create("world"));
+    expect_should_not_be(world, kname_create("World"));
+
+    value = 0;
+    expect_to_be_true(hashtable_get_by_kname(&table, world, &value));
+    expect_should_be(42, value);
+    expect_to_be_true(hashtable_get_by_kname(&table, kname_create("ui"), &value));
+    expect_should_be(7, value);
+    expect_to_be_false(hashtable_get_by_kname(&table, kname_create("skybox"), &value));
+
+    hashtable_destroy(&table);
+
+    return true;
+}
+
 void hashtable_register_tests() {
     test_manager_register_test(hashtable_should_create_and_destroy, "Hashtable should create and destroy");
     test_manager_register_test(hashtable_should_set_and_get_successfully, "Hashtable should set and get");
@@ -328,4 +459,8 @@ void hashtable_register_tests() {
     test_manager_register_test(hashtable_try_call_non_ptr_on_ptr_table, "Hashtable try calling non-pointer functions on pointer type table.");
     test_manager_register_test(hashtable_try_call_ptr_on_non_ptr_table, "Hashtable try calling pointer functions on non-pointer type table.");
     test_manager_register_test(hashtable_should_set_get_and_update_ptr_successfully, "Hashtable Should get pointer, update, and get again successfully.");
+    test_manager_register_test(hashtable_open_should_keep_colliding_names_apart, "Open-addressing hashtable should keep colliding names apart while growing.");
+    test_manager_register_test(hashtable_open_should_remove_and_fill, "Open-addressing hashtable should remove entries and return the fill value for missing names.");
+    test_manager_register_test(hashtable_open_should_intern_names_and_unset_ptr, "Open-addressing hashtable should intern names and unset pointer entries.");
+    test_manager_register_test(hashtable_open_should_get_by_kname, "Open-addressing hashtable should get entries by kname.");
 }
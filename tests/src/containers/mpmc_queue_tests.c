@@ -0,0 +1,117 @@
+#include "mpmc_queue_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <containers/mpmc_queue.h>
+#include <core/katomic.h>
+#include <core/kmemory.h>
+#include <core/kthread.h>
+
+// The number of producer and consumer threads in the threaded test.
+#define MPMC_TEST_THREAD_COUNT 3
+// The number of values each producer pushes in the threaded test.
+#define MPMC_TEST_VALUES_PER_PRODUCER 50000
+
+u8 mpmc_queue_should_push_and_pop_in_order() {
+    // Provide the memory this time, to cover queues which don't own their block.
+    u64 requirement = mpmc_queue_memory_requirement(sizeof(u32), 4);
+    expect_should_be((sizeof(u64) * 2 * 4), requirement);
+    void* memory = kallocate(requirement, MEMORY_TAG_APPLICATION);
+
+    mpmc_queue queue;
+    expect_to_be_true(mpmc_queue_create(sizeof(u32), 4, memory, &queue));
+    expect_should_be(0, mpmc_queue_length(&queue));
+
+    u32 value = 0;
+    expect_to_be_false(mpmc_queue_try_pop(&queue, &value));
+    for (u32 lap = 0; lap < 3; ++lap) {
+        u32 values[4] = {lap, lap + 1, lap + 2, lap + 3};
+        expect_should_be(4, mpmc_queue_push_batch(&queue, values, 4));
+        expect_to_be_false(mpmc_queue_try_push(&queue, &value));
+        expect_should_be(4, mpmc_queue_length(&queue));
+
+        for (u32 i = 0; i < 4; ++i) {
+            expect_to_be_true(mpmc_queue_try_pop(&queue, &value));
+            expect_should_be((lap + i), value);
+        }
+        expect_should_be(0, mpmc_queue_pop_batch(&queue, values, 4));
+    }
+
+    expect_to_be_false(mpmc_queue_create(sizeof(u32), 3, 0, &queue));
+    mpmc_queue_destroy(&queue);
+    kfree(memory, requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+typedef struct mpmc_test_thread {
+    mpmc_queue* queue;
+    u64 first_value;
+    // For consumers, the sum of the values popped.
+    u64 sum;
+    // Shared by all threads. Consumers stop once every value has been popped.
+    volatile u32* popped_count;
+    volatile u32* finished_count;
+} mpmc_test_thread;
+
+static u32 mpmc_test_produce(void* params) {
+    mpmc_test_thread* thread = params;
+    for (u64 i = 0; i < MPMC_TEST_VALUES_PER_PRODUCER;) {
+        u64 value = thread->first_value + i;
+        if (mpmc_queue_try_push(thread->queue, &value)) {
+            ++i;
+        }
+    }
+    katomic_fetch_add(thread->finished_count, 1);
+    return 0;
+}
+
+static u32 mpmc_test_consume(void* params) {
+    mpmc_test_thread* thread = params;
+    u64 value;
+    while (katomic_load_acquire(thread->popped_count) < MPMC_TEST_THREAD_COUNT * MPMC_TEST_VALUES_PER_PRODUCER) {
+        if (mpmc_queue_try_pop(thread->queue, &value)) {
+            thread->sum += value;
+            katomic_fetch_add(thread->popped_count, 1);
+        }
+    }
+    katomic_fetch_add(thread->finished_count, 1);
+    return 0;
+}
+
+u8 mpmc_queue_should_pass_values_between_threads() {
+    mpmc_queue queue;
+    expect_to_be_true(mpmc_queue_create(sizeof(u64), 128, 0, &queue));
+
+    volatile u32 popped_count = 0;
+    volatile u32 finished_count = 0;
+    mpmc_test_thread threads[MPMC_TEST_THREAD_COUNT * 2] = {0};
+    kthread handles[MPMC_TEST_THREAD_COUNT * 2];
+    for (u32 i = 0; i < MPMC_TEST_THREAD_COUNT * 2; ++i) {
+        threads[i].queue = &queue;
+        threads[i].first_value = (u64)(i / 2) * MPMC_TEST_VALUES_PER_PRODUCER;
+        threads[i].popped_count = &popped_count;
+        threads[i].finished_count = &finished_count;
+        expect_to_be_true(kthread_create((i % 2) ? mpmc_test_consume : mpmc_test_produce, &threads[i], true, &handles[i]));
+    }
+    while (katomic_load_acquire(&finished_count) < MPMC_TEST_THREAD_COUNT * 2) {
+    }
+
+    // Every value should have been popped exactly once, so the sums add up to the sum of 0..n-1.
+    u64 total = MPMC_TEST_THREAD_COUNT * MPMC_TEST_VALUES_PER_PRODUCER;
+    u64 sum = 0;
+    for (u32 i = 1; i < MPMC_TEST_THREAD_COUNT * 2; i += 2) {
+        sum += threads[i].sum;
+    }
+    expect_should_be((total * (total - 1) / 2), sum);
+    expect_should_be(0, mpmc_queue_length(&queue));
+
+    mpmc_queue_destroy(&queue);
+    return true;
+}
+
+void mpmc_queue_register_tests() {
+    test_manager_register_test(mpmc_queue_should_push_and_pop_in_order, "MPMC queue should push and pop in order");
+    test_manager_register_test(mpmc_queue_should_pass_values_between_threads, "MPMC queue should pass every value between threads exactly once");
+}
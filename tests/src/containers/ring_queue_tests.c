@@ -0,0 +1,96 @@
+#include "ring_queue_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/ring_queue.h>
+
+u8 ring_queue_should_enqueue_and_dequeue_in_order() {
+    ring_queue queue;
+    expect_to_be_true(ring_queue_create(sizeof(u64), 4, 0, &queue));
+
+    for (u64 i = 1; i <= 4; ++i) {
+        expect_to_be_true(ring_queue_enqueue(&queue, &i));
+    }
+    expect_should_be(4, queue.length);
+
+    u64 value = 0;
+    for (u64 i = 1; i <= 4; ++i) {
+        expect_to_be_true(ring_queue_dequeue(&queue, &value));
+        expect_should_be(i, value);
+    }
+    expect_should_be(0, queue.length);
+
+    ring_queue_destroy(&queue);
+    expect_should_be(0, queue.block);
+    return true;
+}
+
+u8 ring_queue_should_not_enqueue_when_full() {
+    ring_queue queue;
+    u64 memory[2];
+    ring_queue_create(sizeof(u64), 2, memory, &queue);
+
+    u64 value = 1;
+    expect_to_be_true(ring_queue_enqueue(&queue, &value));
+    expect_to_be_true(ring_queue_enqueue(&queue, &value));
+    expect_to_be_false(ring_queue_enqueue(&queue, &value));
+
+    ring_queue_destroy(&queue);
+    return true;
+}
+
+u8 ring_queue_should_resize_and_keep_order() {
+    ring_queue queue;
+    ring_queue_create(sizeof(u64), 4, 0, &queue);
+
+    // Wrap the queue around before resizing, so the contents are split across the block.
+    u64 value = 0;
+    for (u64 i = 1; i <= 4; ++i) {
+        ring_queue_enqueue(&queue, &i);
+    }
+    ring_queue_dequeue(&queue, &value);
+    ring_queue_dequeue(&queue, &value);
+    for (u64 i = 5; i <= 6; ++i) {
+        ring_queue_enqueue(&queue, &i);
+    }
+
+    expect_to_be_true(ring_queue_resize(&queue, 8));
+    expect_should_be(8, queue.capacity);
+    expect_should_be(4, queue.length);
+    for (u64 i = 7; i <= 10; ++i) {
+        expect_to_be_true(ring_queue_enqueue(&queue, &i));
+    }
+
+    for (u64 i = 3; i <= 10; ++i) {
+        expect_to_be_true(ring_queue_dequeue(&queue, &value));
+        expect_should_be(i, value);
+    }
+    expect_should_be(0, queue.length);
+
+    ring_queue_destroy(&queue);
+    return true;
+}
+
+u8 ring_queue_should_not_resize_below_length_or_external_memory() {
+    ring_queue queue;
+    ring_queue_create(sizeof(u64), 4, 0, &queue);
+    u64 value = 1;
+    ring_queue_enqueue(&queue, &value);
+    ring_queue_enqueue(&queue, &value);
+    expect_to_be_false(ring_queue_resize(&queue, 1));
+    ring_queue_destroy(&queue);
+
+    u64 memory[4];
+    ring_queue_create(sizeof(u64), 4, memory, &queue);
+    expect_to_be_false(ring_queue_resize(&queue, 8));
+    ring_queue_destroy(&queue);
+    return true;
+}
+
+void ring_queue_register_tests() {
+    test_manager_register_test(ring_queue_should_enqueue_and_dequeue_in_order, "Ring queue should enqueue and dequeue in order");
+    test_manager_register_test(ring_queue_should_not_enqueue_when_full, "Ring queue should not enqueue when full");
+    test_manager_register_test(ring_queue_should_resize_and_keep_order, "Ring queue should resize and keep order");
+    test_manager_register_test(ring_queue_should_not_resize_below_length_or_external_memory, "Ring queue should not resize below length or external memory");
+}
@@ -0,0 +1,117 @@
+#include "slot_map_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <containers/slot_map.h>
+#include <core/kmemory.h>
+
+typedef struct slot_map_test_context {
+    slot_map map;
+    void* memory;
+    u64 memory_requirement;
+} slot_map_test_context;
+
+static b8 create_map(u32 capacity, slot_map_test_context* context) {
+    if (!slot_map_create(sizeof(u64), capacity, &context->memory_requirement, 0, 0)) {
+        return false;
+    }
+    context->memory = kallocate(context->memory_requirement, MEMORY_TAG_APPLICATION);
+    return slot_map_create(sizeof(u64), capacity, &context->memory_requirement, context->memory, &context->map);
+}
+
+static void destroy_map(slot_map_test_context* context) {
+    slot_map_destroy(&context->map);
+    kfree(context->memory, context->memory_requirement, MEMORY_TAG_APPLICATION);
+}
+
+u8 slot_map_should_create_and_destroy() {
+    slot_map_test_context context;
+    expect_to_be_true(create_map(8, &context));
+    expect_should_not_be(0, context.map.elements);
+    expect_should_be(8, context.map.capacity);
+    expect_should_be(0, context.map.count);
+
+    destroy_map(&context);
+    expect_should_be(0, context.map.elements);
+    return true;
+}
+
+u8 slot_map_should_insert_get_and_remove() {
+    slot_map_test_context context;
+    expect_to_be_true(create_map(4, &context));
+
+    slot_handle handles[4];
+    for (u64 i = 0; i < 4; ++i) {
+        u64 value = i * 10;
+        handles[i] = slot_map_insert(&context.map, &value);
+        expect_should_not_be(SLOT_HANDLE_INVALID, handles[i]);
+    }
+    expect_should_be(4, context.map.count);
+
+    // Full.
+    KDEBUG("The following error message is intentional.");
+    u64 value = 99;
+    expect_should_be(SLOT_HANDLE_INVALID, slot_map_insert(&context.map, &value));
+
+    for (u64 i = 0; i < 4; ++i) {
+        u64* element = slot_map_get(&context.map, handles[i]);
+        expect_should_not_be(0, element);
+        expect_should_be(i * 10, *element);
+    }
+
+    expect_to_be_true(slot_map_remove(&context.map, handles[1]));
+    expect_should_be(3, context.map.count);
+    expect_should_be(0, slot_map_get(&context.map, handles[1]));
+    // Removing twice fails.
+    expect_to_be_false(slot_map_remove(&context.map, handles[1]));
+
+    // The freed slot is reused, but the stale handle must not see the new element.
+    slot_handle reused = slot_map_insert(&context.map, &value);
+    expect_should_be(slot_handle_index(handles[1]), slot_handle_index(reused));
+    expect_should_not_be(handles[1], reused);
+    expect_should_be(0, slot_map_get(&context.map, handles[1]));
+    expect_should_be(99, *(u64*)slot_map_get(&context.map, reused));
+
+    destroy_map(&context);
+    return true;
+}
+
+u8 slot_map_should_iterate_live_elements() {
+    slot_map_test_context context;
+    expect_to_be_true(create_map(16, &context));
+
+    slot_handle handles[16];
+    for (u64 i = 0; i < 16; ++i) {
+        handles[i] = slot_map_insert(&context.map, &i);
+    }
+    // Remove the even values.
+    for (u32 i = 0; i < 16; i += 2) {
+        expect_to_be_true(slot_map_remove(&context.map, handles[i]));
+    }
+    expect_should_be(8, context.map.count);
+
+    u64 sum = 0;
+    for (u32 i = 0; i < context.map.count; ++i) {
+        u64* element = slot_map_element_at(&context.map, i);
+        expect_should_be(1, *element % 2);
+        // Handles obtained while iterating resolve to the same element.
+        expect_should_be(element, slot_map_get(&context.map, slot_map_handle_at(&context.map, i)));
+        sum += *element;
+    }
+    expect_should_be(1 + 3 + 5 + 7 + 9 + 11 + 13 + 15, sum);
+
+    slot_map_clear(&context.map);
+    expect_should_be(0, context.map.count);
+    expect_should_be(0, slot_map_get(&context.map, handles[1]));
+
+    destroy_map(&context);
+    return true;
+}
+
+void slot_map_register_tests() {
+    test_manager_register_test(slot_map_should_create_and_destroy, "Slot map should create and destroy");
+    test_manager_register_test(slot_map_should_insert_get_and_remove, "Slot map should insert, get and remove, rejecting stale handles");
+    test_manager_register_test(slot_map_should_iterate_live_elements, "Slot map should iterate only live elements");
+}
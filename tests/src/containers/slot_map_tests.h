@@ -0,0 +1,3 @@
+#pragma once
+
+void slot_map_register_tests();
@@ -0,0 +1,122 @@
+#include "spsc_queue_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <containers/spsc_queue.h>
+#include <core/katomic.h>
+#include <core/kthread.h>
+
+// The number of values passed between threads in the threaded test.
+#define SPSC_TEST_VALUE_COUNT 200000
+
+u8 spsc_queue_should_push_and_pop_in_order() {
+    spsc_queue queue;
+    expect_to_be_true(spsc_queue_create(sizeof(u32), 4, 0, &queue));
+    expect_should_be(0, spsc_queue_length(&queue));
+
+    u32 value = 0;
+    expect_to_be_false(spsc_queue_try_pop(&queue, &value));
+
+    // Go around the end of the block a few times.
+    for (u32 lap = 0; lap < 3; ++lap) {
+        for (u32 i = 0; i < 4; ++i) {
+            value = lap * 10 + i;
+            expect_to_be_true(spsc_queue_try_push(&queue, &value));
+        }
+        value = 99;
+        expect_to_be_false(spsc_queue_try_push(&queue, &value));
+        expect_should_be(4, spsc_queue_length(&queue));
+
+        for (u32 i = 0; i < 4; ++i) {
+            expect_to_be_true(spsc_queue_try_pop(&queue, &value));
+            expect_should_be((lap * 10 + i), value);
+        }
+        expect_to_be_false(spsc_queue_try_pop(&queue, &value));
+    }
+
+    spsc_queue_destroy(&queue);
+    expect_should_be(0, queue.block);
+    return true;
+}
+
+u8 spsc_queue_should_push_and_pop_batches() {
+    spsc_queue queue;
+    expect_to_be_true(spsc_queue_create(sizeof(u32), 8, 0, &queue));
+
+    // Offset the positions so the batches wrap around the end of the block.
+    u32 values[8] = {0};
+    expect_should_be(5, spsc_queue_push_batch(&queue, values, 5));
+    expect_should_be(5, spsc_queue_pop_batch(&queue, values, 8));
+
+    for (u32 i = 0; i < 8; ++i) {
+        values[i] = i + 1;
+    }
+    // Only as many as fit are pushed.
+    expect_should_be(6, spsc_queue_push_batch(&queue, values, 6));
+    expect_should_be(2, spsc_queue_push_batch(&queue, values + 6, 2));
+    expect_should_be(0, spsc_queue_push_batch(&queue, values, 1));
+
+    u32 out_values[8] = {0};
+    expect_should_be(3, spsc_queue_pop_batch(&queue, out_values, 3));
+    expect_should_be(5, spsc_queue_pop_batch(&queue, out_values + 3, 8));
+    for (u32 i = 0; i < 8; ++i) {
+        expect_should_be((i + 1), out_values[i]);
+    }
+    expect_should_be(0, spsc_queue_pop_batch(&queue, out_values, 8));
+
+    expect_to_be_false(spsc_queue_create(sizeof(u32), 6, 0, &queue));
+    spsc_queue_destroy(&queue);
+    return true;
+}
+
+typedef struct spsc_test_producer {
+    spsc_queue* queue;
+    volatile u32 finished;
+} spsc_test_producer;
+
+static u32 spsc_test_produce(void* params) {
+    spsc_test_producer* producer = params;
+    for (u64 i = 0; i < SPSC_TEST_VALUE_COUNT;) {
+        if (spsc_queue_try_push(producer->queue, &i)) {
+            ++i;
+        }
+    }
+    katomic_store_release(&producer->finished, 1);
+    return 0;
+}
+
+u8 spsc_queue_should_pass_values_between_threads() {
+    spsc_queue queue;
+    expect_to_be_true(spsc_queue_create(sizeof(u64), 64, 0, &queue));
+
+    spsc_test_producer producer = {&queue, 0};
+    kthread thread;
+    expect_to_be_true(kthread_create(spsc_test_produce, &producer, true, &thread));
+
+    // Every value should arrive exactly once, in order.
+    b8 in_order = true;
+    u64 expected = 0;
+    u64 values[16];
+    while (expected < SPSC_TEST_VALUE_COUNT) {
+        u32 count = spsc_queue_pop_batch(&queue, values, 16);
+        for (u32 i = 0; i < count; ++i) {
+            in_order = in_order && values[i] == expected;
+            ++expected;
+        }
+    }
+    while (!katomic_load_acquire(&producer.finished)) {
+    }
+    expect_to_be_true(in_order);
+    expect_should_be(0, spsc_queue_length(&queue));
+
+    spsc_queue_destroy(&queue);
+    return true;
+}
+
+void spsc_queue_register_tests() {
+    test_manager_register_test(spsc_queue_should_push_and_pop_in_order, "SPSC queue should push and pop in order");
+    test_manager_register_test(spsc_queue_should_push_and_pop_batches, "SPSC queue should push and pop batches");
+    test_manager_register_test(spsc_queue_should_pass_values_between_threads, "SPSC queue should pass values between threads in order");
+}
@@ -0,0 +1,133 @@
+#include "work_deque_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/work_deque.h>
+
+u8 work_deque_should_create_and_destroy() {
+    work_deque deque;
+    u64 memory[4];
+
+    expect_to_be_true(work_deque_create(sizeof(u64), 4, memory, &deque));
+    expect_should_not_be(0, deque.block);
+    expect_should_be(sizeof(u64), deque.stride);
+    expect_should_be(4, deque.capacity);
+    expect_should_be(0, work_deque_length(&deque));
+
+    work_deque_destroy(&deque);
+
+    expect_should_be(0, deque.block);
+    expect_should_be(0, deque.stride);
+    expect_should_be(0, deque.capacity);
+
+    return true;
+}
+
+u8 work_deque_should_reject_non_power_of_two_capacity() {
+    work_deque deque;
+    u64 memory[3];
+
+    expect_to_be_false(work_deque_create(sizeof(u64), 3, memory, &deque));
+
+    return true;
+}
+
+u8 work_deque_should_pop_last_in_first_out() {
+    work_deque deque;
+    u64 memory[4];
+    work_deque_create(sizeof(u64), 4, memory, &deque);
+
+    for (u64 i = 1; i <= 3; ++i) {
+        expect_to_be_true(work_deque_push(&deque, &i));
+    }
+    expect_should_be(3, work_deque_length(&deque));
+
+    u64 value = 0;
+    for (u64 i = 3; i >= 1; --i) {
+        expect_to_be_true(work_deque_pop(&deque, &value));
+        expect_should_be(i, value);
+    }
+    expect_to_be_false(work_deque_pop(&deque, &value));
+    expect_should_be(0, work_deque_length(&deque));
+
+    work_deque_destroy(&deque);
+    return true;
+}
+
+u8 work_deque_should_steal_first_in_first_out() {
+    work_deque deque;
+    u64 memory[4];
+    work_deque_create(sizeof(u64), 4, memory, &deque);
+
+    for (u64 i = 1; i <= 3; ++i) {
+        work_deque_push(&deque, &i);
+    }
+
+    u64 value = 0;
+    expect_to_be_true(work_deque_steal(&deque, 0, 0, &value));
+    expect_should_be(1, value);
+    expect_to_be_true(work_deque_pop(&deque, &value));
+    expect_should_be(3, value);
+    expect_to_be_true(work_deque_steal(&deque, 0, 0, &value));
+    expect_should_be(2, value);
+    expect_to_be_false(work_deque_steal(&deque, 0, 0, &value));
+    expect_to_be_false(work_deque_pop(&deque, &value));
+
+    work_deque_destroy(&deque);
+    return true;
+}
+
+u8 work_deque_should_not_push_when_full() {
+    work_deque deque;
+    u64 memory[4];
+    work_deque_create(sizeof(u64), 4, memory, &deque);
+
+    for (u64 i = 0; i < 4; ++i) {
+        expect_to_be_true(work_deque_push(&deque, &i));
+    }
+    u64 extra = 99;
+    expect_to_be_false(work_deque_push(&deque, &extra));
+
+    // Making room should allow pushing again, wrapping around the block.
+    u64 value = 0;
+    expect_to_be_true(work_deque_steal(&deque, 0, 0, &value));
+    expect_should_be(0, value);
+    expect_to_be_true(work_deque_push(&deque, &extra));
+    expect_to_be_true(work_deque_pop(&deque, &value));
+    expect_should_be(99, value);
+
+    work_deque_destroy(&deque);
+    return true;
+}
+
+static b8 only_even_values(const void* value, void* context) {
+    return (*(const u64*)value % 2) == 0;
+}
+
+u8 work_deque_should_respect_steal_filter() {
+    work_deque deque;
+    u64 memory[4];
+    work_deque_create(sizeof(u64), 4, memory, &deque);
+
+    u64 odd = 1;
+    work_deque_push(&deque, &odd);
+
+    u64 value = 0;
+    expect_to_be_false(work_deque_steal(&deque, only_even_values, 0, &value));
+    expect_should_be(1, work_deque_length(&deque));
+    expect_to_be_true(work_deque_steal(&deque, 0, 0, &value));
+    expect_should_be(1, value);
+
+    work_deque_destroy(&deque);
+    return true;
+}
+
+void work_deque_register_tests() {
+    test_manager_register_test(work_deque_should_create_and_destroy, "Work deque should create and destroy");
+    test_manager_register_test(work_deque_should_reject_non_power_of_two_capacity, "Work deque should reject non power of two capacity");
+    test_manager_register_test(work_deque_should_pop_last_in_first_out, "Work deque should pop last in, first out");
+    test_manager_register_test(work_deque_should_steal_first_in_first_out, "Work deque should steal first in, first out");
+    test_manager_register_test(work_deque_should_not_push_when_full, "Work deque should not push when full");
+    test_manager_register_test(work_deque_should_respect_steal_filter, "Work deque should respect steal filter");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void work_deque_register_tests();
@@ -0,0 +1,126 @@
+#include "benchmark_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/benchmark.h>
+#include <core/counters.h>
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <core/metrics.h>
+#include <platform/filesystem.h>
+
+#include <stdio.h>  // remove
+
+u8 benchmark_should_parse_its_command_line_arguments() {
+    benchmark_config config;
+    char* no_benchmark[] = {"testbed", "--other"};
+    benchmark_config_parse(2, no_benchmark, &config);
+    expect_should_be(0, config.frame_count);
+
+    char* defaults[] = {"testbed", "--benchmark"};
+    benchmark_config_parse(2, defaults, &config);
+    expect_should_be(BENCHMARK_DEFAULT_FRAME_COUNT, config.frame_count);
+    expect_should_be(BENCHMARK_DEFAULT_WARMUP_FRAME_COUNT, config.warmup_frame_count);
+    expect_to_be_true(strings_equal(config.output_path, BENCHMARK_DEFAULT_OUTPUT_PATH));
+    expect_to_be_true(strings_equal(config.scene, BENCHMARK_DEFAULT_SCENE));
+    expect_to_be_true(config.baseline_path == 0);
+    expect_float_to_be(BENCHMARK_DEFAULT_THRESHOLD_PERCENT, config.threshold_percent);
+
+    char* all[] = {"testbed", "--benchmark-output=out.json", "--benchmark=500", "--benchmark-warmup=10",
+                   "--benchmark-scene=cubes", "--benchmark-baseline=base.json", "--benchmark-threshold=2.5"};
+    benchmark_config_parse(7, all, &config);
+    expect_should_be(500, config.frame_count);
+    expect_should_be(10, config.warmup_frame_count);
+    expect_to_be_true(strings_equal(config.output_path, "out.json"));
+    expect_to_be_true(strings_equal(config.scene, "cubes"));
+    expect_to_be_true(strings_equal(config.baseline_path, "base.json"));
+    expect_float_to_be(2.5f, config.threshold_percent);
+
+    // Bad counts and thresholds fall back to the defaults.
+    char* invalid[] = {"testbed", "--benchmark=lots", "--benchmark-threshold=-5"};
+    benchmark_config_parse(3, invalid, &config);
+    expect_should_be(BENCHMARK_DEFAULT_FRAME_COUNT, config.frame_count);
+    expect_float_to_be(BENCHMARK_DEFAULT_THRESHOLD_PERCENT, config.threshold_percent);
+    return true;
+}
+
+u8 benchmark_should_write_stats_over_the_measured_frames() {
+    metrics_initialize();
+    u32 counter = counter_register("test.benchmark", COUNTER_TYPE_COUNTER);
+    counters_snapshot();
+
+    benchmark_config config = {4, 2, "benchmark_test.json", "test_scene", 0, BENCHMARK_DEFAULT_THRESHOLD_PERCENT};
+    u64 size = 0;
+    benchmark_initialize(&size, 0, &config);
+    void* state = kallocate(size, MEMORY_TAG_APPLICATION);
+    expect_to_be_true(benchmark_initialize(&size, state, &config));
+
+    // Two slow warm-up frames which aren't measured, then 4ms down to 1ms.
+    f64 frame_times[] = {0.1, 0.1, 0.004, 0.003, 0.002, 0.001};
+    b8 result = false;
+    for (u32 i = 0; i < 6; ++i) {
+        counter_add(counter, 2);
+        metrics_update(frame_times[i], frame_times[i] / 2, frame_times[i] / 2, 0);
+        counters_snapshot();
+        expect_should_be((i == 5), benchmark_frame_end(frame_times[i], frame_times[i] / 2, frame_times[i] / 2, &result));
+    }
+    expect_to_be_true(result);
+
+    file_handle handle;
+    expect_to_be_true(filesystem_open("benchmark_test.json", FILE_MODE_READ, false, &handle));
+    u64 file_size = 0;
+    filesystem_size(&handle, &file_size);
+    char* text = kallocate(file_size + 1, MEMORY_TAG_STRING);
+    u64 read = 0;
+    filesystem_read_all_text(&handle, text, &read);
+    text[read] = 0;
+    filesystem_close(&handle);
+
+    expect_to_be_true(strings_nequal(text, "{\n\"frames\":4,\n\"warmup_frames\":2,", 30));
+    const char* frame_ms = "\"frame_ms\":{\"avg\":2.5000,\"min\":1.0000,\"p50\":2.0000,\"p95\":4.0000,\"p99\":4.0000,\"max\":4.0000}";
+    const char* scene = "\"scene\":\"test_scene\"";
+    const char* counter_totals = "\"test.benchmark\":{\"total\":8,\"per_frame\":2.00}";
+    b8 found_frame_ms = false;
+    b8 found_counter = false;
+    b8 found_scene = false;
+    for (const char* c = text; *c; ++c) {
+        found_frame_ms |= strings_nequal(c, frame_ms, string_length(frame_ms));
+        found_counter |= strings_nequal(c, counter_totals, string_length(counter_totals));
+        found_scene |= strings_nequal(c, scene, string_length(scene));
+    }
+    expect_to_be_true(found_frame_ms);
+    expect_to_be_true(found_counter);
+    expect_to_be_true(found_scene);
+    string_free(text);
+    remove("benchmark_test.json");
+
+    benchmark_shutdown(state);
+    kfree(state, size, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+u8 benchmark_should_count_times_which_grew_past_the_threshold() {
+    const char* baseline = "{\n\"frames\":4,\n\"frame_ms\":{\"avg\":2.0,\"p50\":2.0000,\"p95\":4.0000,\"p99\":5.0000},\n\"update_ms\":{\"p50\":1.0000,\"p95\":1.0000,\"p99\":1.0000}\n}\n";
+
+    // Within 10%, along with the tolerance.
+    const char* same = "{\n\"frame_ms\":{\"p50\":2.1000,\"p95\":4.3000,\"p99\":5.5000},\n\"update_ms\":{\"p50\":1.1400,\"p95\":0.5000,\"p99\":1.0000}\n}\n";
+    expect_should_be(0, benchmark_results_compare(same, baseline, 10.0f));
+
+    // The tails of the frame time grew past 10%. Without any slack, the medians grew too much as well.
+    const char* slower = "{\n\"frame_ms\":{\"p50\":2.1000,\"p95\":5.0000,\"p99\":6.0000},\n\"update_ms\":{\"p50\":1.1400,\"p95\":1.0000,\"p99\":1.0000}\n}\n";
+    expect_should_be(2, benchmark_results_compare(slower, baseline, 10.0f));
+    expect_should_be(4, benchmark_results_compare(slower, baseline, 0.0f));
+
+    // Times missing from the baseline, such as those of a new series, are skipped.
+    const char* more = "{\n\"frame_ms\":{\"p50\":2.0},\n\"render_ms\":{\"p50\":100.0}\n}\n";
+    expect_should_be(0, benchmark_results_compare(more, baseline, 10.0f));
+    return true;
+}
+
+void benchmark_register_tests() {
+    test_manager_register_test(benchmark_should_parse_its_command_line_arguments, "Benchmark should parse its command line arguments");
+    test_manager_register_test(benchmark_should_write_stats_over_the_measured_frames, "Benchmark should write stats over the measured frames");
+    test_manager_register_test(benchmark_should_count_times_which_grew_past_the_threshold, "Benchmark should count times which grew past the threshold");
+}
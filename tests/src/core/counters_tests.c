@@ -0,0 +1,135 @@
+#include "counters_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/counters.h>
+#include <core/katomic.h>
+#include <core/kstring.h>
+#include <core/kthread.h>
+
+#define COUNTERS_TEST_THREAD_COUNT 4
+#define COUNTERS_TEST_ADDS_PER_THREAD 10000
+
+u8 counter_should_snapshot_the_amount_added_each_frame() {
+    u32 id = counter_register("test.counter", COUNTER_TYPE_COUNTER);
+    expect_should_not_be(INVALID_ID, id);
+    // Registering the same name again gives the same counter.
+    expect_should_be(id, counter_register("test.counter", COUNTER_TYPE_COUNTER));
+
+    counters_snapshot();
+    counter_snapshot snapshot;
+    expect_to_be_true(counter_snapshot_get(id, &snapshot));
+    i64 start = snapshot.value;
+
+    counter_add(id, 3);
+    counter_add(id, 4);
+    counters_snapshot();
+    expect_to_be_true(counter_snapshot_get(id, &snapshot));
+    expect_to_be_true(strings_equal(snapshot.name, "test.counter"));
+    expect_should_be(COUNTER_TYPE_COUNTER, snapshot.type);
+    expect_should_be(7, snapshot.frame_value);
+    expect_should_be((start + 7), snapshot.value);
+
+    // Nothing added in the next frame.
+    counters_snapshot();
+    expect_to_be_true(counter_snapshot_get(id, &snapshot));
+    expect_should_be(0, snapshot.frame_value);
+    expect_should_be((start + 7), snapshot.value);
+
+    // Updates to an invalid id are ignored.
+    counter_add(INVALID_ID, 1);
+    expect_to_be_false(counter_snapshot_get(INVALID_ID, &snapshot));
+    return true;
+}
+
+u8 gauge_should_snapshot_its_level() {
+    u32 id = counter_register("test.gauge", COUNTER_TYPE_GAUGE);
+    expect_should_not_be(INVALID_ID, id);
+
+    counter_set(id, 10);
+    counter_add(id, -3);
+    counters_snapshot();
+    counter_snapshot snapshot;
+    expect_to_be_true(counter_snapshot_get(id, &snapshot));
+    expect_should_be(COUNTER_TYPE_GAUGE, snapshot.type);
+    expect_should_be(7, snapshot.frame_value);
+    expect_should_be(7, snapshot.value);
+
+    // The level holds across frames.
+    counters_snapshot();
+    expect_to_be_true(counter_snapshot_get(id, &snapshot));
+    expect_should_be(7, snapshot.frame_value);
+    return true;
+}
+
+u8 counter_should_read_its_source_until_cleared() {
+    u64 source = 5;
+    u32 id = counter_register_source("test.source", COUNTER_TYPE_COUNTER, &source);
+    expect_should_not_be(INVALID_ID, id);
+
+    counters_snapshot();
+    counter_snapshot snapshot;
+    expect_to_be_true(counter_snapshot_get(id, &snapshot));
+    expect_should_be(5, snapshot.value);
+
+    katomic_fetch_add(&source, 2);
+    counters_snapshot();
+    expect_to_be_true(counter_snapshot_get(id, &snapshot));
+    expect_should_be(2, snapshot.frame_value);
+    expect_should_be(7, snapshot.value);
+
+    // Once cleared, the counter keeps its last value and no longer reads the source.
+    counter_source_clear(id);
+    source = 100;
+    counters_snapshot();
+    expect_to_be_true(counter_snapshot_get(id, &snapshot));
+    expect_should_be(0, snapshot.frame_value);
+    expect_should_be(7, snapshot.value);
+    return true;
+}
+
+typedef struct counters_test_thread {
+    u32 id;
+    volatile u32* finished_count;
+} counters_test_thread;
+
+static u32 counters_test_add(void* params) {
+    counters_test_thread* thread = params;
+    for (u32 i = 0; i < COUNTERS_TEST_ADDS_PER_THREAD; ++i) {
+        counter_add(thread->id, 1);
+    }
+    katomic_fetch_add(thread->finished_count, 1);
+    return 0;
+}
+
+u8 counter_should_count_adds_from_every_thread() {
+    u32 id = counter_register("test.threaded", COUNTER_TYPE_COUNTER);
+    expect_should_not_be(INVALID_ID, id);
+    counters_snapshot();
+
+    volatile u32 finished_count = 0;
+    counters_test_thread threads[COUNTERS_TEST_THREAD_COUNT];
+    kthread handles[COUNTERS_TEST_THREAD_COUNT];
+    for (u32 i = 0; i < COUNTERS_TEST_THREAD_COUNT; ++i) {
+        threads[i].id = id;
+        threads[i].finished_count = &finished_count;
+        expect_to_be_true(kthread_create(counters_test_add, &threads[i], true, &handles[i]));
+    }
+    while (katomic_load_acquire(&finished_count) < COUNTERS_TEST_THREAD_COUNT) {
+    }
+
+    counters_snapshot();
+    counter_snapshot snapshot;
+    expect_to_be_true(counter_snapshot_get(id, &snapshot));
+    expect_should_be((COUNTERS_TEST_THREAD_COUNT * COUNTERS_TEST_ADDS_PER_THREAD), snapshot.frame_value);
+    return true;
+}
+
+void counters_register_tests() {
+    test_manager_register_test(counter_should_snapshot_the_amount_added_each_frame, "Counter should snapshot the amount added each frame");
+    test_manager_register_test(gauge_should_snapshot_its_level, "Gauge should snapshot its level");
+    test_manager_register_test(counter_should_read_its_source_until_cleared, "Counter should read its source until cleared");
+    test_manager_register_test(counter_should_count_adds_from_every_thread, "Counter should count adds from every thread");
+}
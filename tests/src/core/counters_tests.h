@@ -0,0 +1,3 @@
+#pragma once
+
+void counters_register_tests();
@@ -0,0 +1,255 @@
+#include "event_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/event.h>
+#include <core/katomic.h>
+#include <core/kmemory.h>
+#include <core/kthread.h>
+
+#define EVENT_TEST_CODE 0x200
+#define EVENT_TEST_OTHER_CODE 0x201
+
+typedef struct event_test_listener {
+    u32 count;
+    u32 last_value;
+    u32 values[16];
+} event_test_listener;
+
+static void* event_test_setup(u64* out_size) {
+    event_system_initialize(out_size, 0);
+    void* state = kallocate(*out_size, MEMORY_TAG_APPLICATION);
+    event_system_initialize(out_size, state);
+    return state;
+}
+
+static void event_test_teardown(void* state, u64 size) {
+    event_system_shutdown(state);
+    kfree(state, size, MEMORY_TAG_APPLICATION);
+}
+
+static b8 event_test_on_event(u16 code, void* sender, void* listener_inst, event_context data) {
+    event_test_listener* listener = listener_inst;
+    if (listener->count < 16) {
+        listener->values[listener->count] = data.data.u32[0];
+    }
+    listener->count++;
+    listener->last_value = data.data.u32[0];
+    return false;
+}
+
+static b8 event_test_on_event_reposts(u16 code, void* sender, void* listener_inst, event_context data) {
+    event_test_on_event(code, sender, listener_inst, data);
+    // Posting while dispatching should wait for the next dispatch.
+    event_post(code, sender, data);
+    return false;
+}
+
+static b8 event_test_on_event_handles(u16 code, void* sender, void* listener_inst, event_context data) {
+    event_test_on_event(code, sender, listener_inst, data);
+    return true;
+}
+
+u8 event_should_register_fire_and_unregister() {
+    u64 size = 0;
+    void* state = event_test_setup(&size);
+
+    // Codes registered out of order, with listeners for one added around the others.
+    event_test_listener a = {0};
+    event_test_listener b = {0};
+    event_test_listener c = {0};
+    expect_to_be_true(event_register(EVENT_TEST_OTHER_CODE, &a, event_test_on_event));
+    expect_to_be_true(event_register(EVENT_TEST_CODE, &a, event_test_on_event));
+    expect_to_be_true(event_register(0xFFFF, &c, event_test_on_event));
+    expect_to_be_true(event_register(EVENT_TEST_CODE, &b, event_test_on_event));
+    expect_to_be_true(event_register(EVENT_TEST_OTHER_CODE, &b, event_test_on_event_handles));
+    expect_to_be_true(event_register(EVENT_TEST_OTHER_CODE, &c, event_test_on_event));
+    // Duplicates are refused.
+    expect_to_be_false(event_register(EVENT_TEST_CODE, &b, event_test_on_event));
+
+    event_context context = {0};
+    expect_to_be_false(event_fire(EVENT_TEST_CODE, 0, context));
+    expect_should_be(1, a.count);
+    expect_should_be(1, b.count);
+
+    // b handles the other code, so c, registered after it, never sees it.
+    expect_to_be_true(event_fire(EVENT_TEST_OTHER_CODE, 0, context));
+    expect_should_be(2, a.count);
+    expect_should_be(2, b.count);
+    expect_should_be(0, c.count);
+
+    expect_to_be_false(event_fire(0xFFFF, 0, context));
+    expect_should_be(1, c.count);
+    // Nothing is registered for this one.
+    expect_to_be_false(event_fire(EVENT_TEST_CODE + 10, 0, context));
+
+    // Removing a code's listeners leaves the others in place.
+    expect_to_be_true(event_unregister(EVENT_TEST_CODE, &a, event_test_on_event));
+    expect_to_be_true(event_unregister(EVENT_TEST_CODE, &b, event_test_on_event));
+    expect_to_be_false(event_unregister(EVENT_TEST_CODE, &b, event_test_on_event));
+    expect_to_be_true(event_unregister(EVENT_TEST_OTHER_CODE, &b, event_test_on_event_handles));
+    expect_to_be_false(event_fire(EVENT_TEST_CODE, 0, context));
+    expect_to_be_false(event_fire(EVENT_TEST_OTHER_CODE, 0, context));
+    expect_should_be(3, a.count);
+    expect_should_be(2, b.count);
+    expect_should_be(2, c.count);
+    event_fire(0xFFFF, 0, context);
+    expect_should_be(3, c.count);
+
+    event_test_teardown(state, size);
+    return true;
+}
+
+u8 event_should_dispatch_posted_events_in_order() {
+    u64 size = 0;
+    void* state = event_test_setup(&size);
+
+    event_test_listener listener = {0};
+    expect_to_be_true(event_register(EVENT_TEST_CODE, &listener, event_test_on_event));
+    expect_to_be_true(event_register(EVENT_TEST_OTHER_CODE, &listener, event_test_on_event));
+
+    event_context context = {0};
+    for (u32 i = 0; i < 3; ++i) {
+        context.data.u32[0] = i;
+        expect_to_be_true(event_post(i == 1 ? EVENT_TEST_OTHER_CODE : EVENT_TEST_CODE, 0, context));
+    }
+    // Nothing is fired until dispatched.
+    expect_should_be(0, listener.count);
+
+    expect_should_be(3, event_dispatch_deferred());
+    expect_should_be(3, listener.count);
+    for (u32 i = 0; i < 3; ++i) {
+        expect_should_be(i, listener.values[i]);
+    }
+
+    // The queue is empty again.
+    expect_should_be(0, event_dispatch_deferred());
+
+    event_test_teardown(state, size);
+    return true;
+}
+
+u8 event_should_coalesce_posted_events() {
+    u64 size = 0;
+    void* state = event_test_setup(&size);
+
+    event_test_listener moved = {0};
+    event_test_listener other = {0};
+    expect_to_be_true(event_register(EVENT_CODE_MOUSE_MOVED, &moved, event_test_on_event));
+    expect_to_be_true(event_register(EVENT_TEST_CODE, &other, event_test_on_event));
+
+    // Mouse moves are coalesced by default, so only the latest is fired. Others are not.
+    event_context context = {0};
+    for (u32 i = 0; i < 5; ++i) {
+        context.data.u32[0] = i;
+        event_post(EVENT_CODE_MOUSE_MOVED, 0, context);
+        event_post(EVENT_TEST_CODE, 0, context);
+    }
+    expect_should_be(6, event_dispatch_deferred());
+    expect_should_be(1, moved.count);
+    expect_should_be(4, moved.last_value);
+    expect_should_be(5, other.count);
+
+    // Coalescing can be switched on and off per code.
+    event_set_coalesced(EVENT_TEST_CODE, true);
+    event_set_coalesced(EVENT_CODE_MOUSE_MOVED, false);
+    for (u32 i = 0; i < 5; ++i) {
+        context.data.u32[0] = i;
+        event_post(EVENT_CODE_MOUSE_MOVED, 0, context);
+        event_post(EVENT_TEST_CODE, 0, context);
+    }
+    expect_should_be(6, event_dispatch_deferred());
+    expect_should_be(6, moved.count);
+    expect_should_be(6, other.count);
+    expect_should_be(4, other.last_value);
+
+    // Codes met in one dispatch don't affect the next.
+    context.data.u32[0] = 7;
+    event_post(EVENT_TEST_CODE, 0, context);
+    expect_should_be(1, event_dispatch_deferred());
+    expect_should_be(7, other.count);
+    expect_should_be(7, other.last_value);
+
+    event_test_teardown(state, size);
+    return true;
+}
+
+u8 event_should_defer_events_posted_during_dispatch() {
+    u64 size = 0;
+    void* state = event_test_setup(&size);
+
+    event_test_listener listener = {0};
+    expect_to_be_true(event_register(EVENT_TEST_CODE, &listener, event_test_on_event_reposts));
+
+    event_context context = {0};
+    event_post(EVENT_TEST_CODE, 0, context);
+    expect_should_be(1, event_dispatch_deferred());
+    expect_should_be(1, listener.count);
+    expect_should_be(1, event_dispatch_deferred());
+    expect_should_be(2, listener.count);
+
+    event_test_teardown(state, size);
+    return true;
+}
+
+#define EVENT_TEST_THREAD_COUNT 4
+#define EVENT_TEST_POSTS_PER_THREAD 200
+
+typedef struct event_test_thread {
+    u32 first_value;
+    volatile u32* finished_count;
+} event_test_thread;
+
+static u32 event_test_post_thread(void* params) {
+    event_test_thread* thread = params;
+    event_context context = {0};
+    for (u32 i = 0; i < EVENT_TEST_POSTS_PER_THREAD; ++i) {
+        context.data.u32[0] = thread->first_value + i;
+        event_post(EVENT_TEST_CODE, 0, context);
+    }
+    katomic_fetch_add(thread->finished_count, 1);
+    return 0;
+}
+
+static b8 event_test_on_event_sums(u16 code, void* sender, void* listener_inst, event_context data) {
+    u64* sum = listener_inst;
+    *sum += data.data.u32[0];
+    return false;
+}
+
+u8 event_should_accept_posts_from_other_threads() {
+    u64 size = 0;
+    void* state = event_test_setup(&size);
+
+    u64 sum = 0;
+    expect_to_be_true(event_register(EVENT_TEST_CODE, &sum, event_test_on_event_sums));
+
+    volatile u32 finished_count = 0;
+    event_test_thread threads[EVENT_TEST_THREAD_COUNT];
+    kthread handles[EVENT_TEST_THREAD_COUNT];
+    for (u32 i = 0; i < EVENT_TEST_THREAD_COUNT; ++i) {
+        threads[i].first_value = i * EVENT_TEST_POSTS_PER_THREAD;
+        threads[i].finished_count = &finished_count;
+        expect_to_be_true(kthread_create(event_test_post_thread, &threads[i], true, &handles[i]));
+    }
+    while (katomic_load_acquire(&finished_count) < EVENT_TEST_THREAD_COUNT) {
+    }
+
+    // Every value from 0 to count-1 was posted exactly once.
+    u32 total = EVENT_TEST_THREAD_COUNT * EVENT_TEST_POSTS_PER_THREAD;
+    expect_should_be(total, event_dispatch_deferred());
+    expect_should_be((u64)total * (total - 1) / 2, sum);
+
+    event_test_teardown(state, size);
+    return true;
+}
+
+void event_register_tests() {
+    test_manager_register_test(event_should_register_fire_and_unregister, "Event system should register, fire and unregister listeners");
+    test_manager_register_test(event_should_dispatch_posted_events_in_order, "Event system should dispatch posted events in order");
+    test_manager_register_test(event_should_coalesce_posted_events, "Event system should coalesce posted events");
+    test_manager_register_test(event_should_defer_events_posted_during_dispatch, "Event system should defer events posted during dispatch");
+    test_manager_register_test(event_should_accept_posts_from_other_threads, "Event system should accept posts from other threads");
+}
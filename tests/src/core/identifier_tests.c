@@ -0,0 +1,110 @@
+#include "identifier_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/identifier.h>
+#include <core/katomic.h>
+#include <core/kthread.h>
+
+// Identifiers are global, so each test only relies on the identifiers it acquires itself.
+
+u8 identifier_should_acquire_unique_ids() {
+    u32 owners[3];
+    u32 a = identifier_aquire_new_id(&owners[0]);
+    u32 b = identifier_aquire_new_id(&owners[1]);
+    u32 c = identifier_aquire_new_id(&owners[2]);
+    expect_should_not_be(0, a);
+    expect_should_not_be(INVALID_ID, a);
+    expect_should_not_be(a, b);
+    expect_should_not_be(a, c);
+    expect_should_not_be(b, c);
+    expect_should_be(&owners[1], identifier_owner_get(b));
+
+    identifier_release_id(a);
+    identifier_release_id(b);
+    identifier_release_id(c);
+    expect_should_be(0, identifier_owner_get(b));
+    return true;
+}
+
+u8 identifier_should_detect_stale_generations() {
+    u32 first_owner, second_owner;
+    u32 id = identifier_aquire_new_id(&first_owner);
+    u32 generation = identifier_generation_get(id);
+    expect_to_be_true(identifier_is_current(id, generation));
+
+    identifier_release_id(id);
+    expect_to_be_false(identifier_is_current(id, generation));
+
+    // The released identifier is handed out next, with a new generation.
+    u32 reused = identifier_aquire_new_id(&second_owner);
+    expect_should_be(id, reused);
+    expect_should_not_be(generation, identifier_generation_get(reused));
+    expect_to_be_false(identifier_is_current(reused, generation));
+    expect_to_be_true(identifier_is_current(reused, identifier_generation_get(reused)));
+    expect_should_be(&second_owner, identifier_owner_get(reused));
+
+    identifier_release_id(reused);
+    expect_should_be(INVALID_ID, identifier_generation_get(0));
+    expect_to_be_false(identifier_is_current(0, 0));
+    return true;
+}
+
+#define IDENTIFIER_TEST_THREAD_COUNT 4
+#define IDENTIFIER_TEST_IDS_PER_THREAD 256
+
+typedef struct identifier_test_thread {
+    u32 ids[IDENTIFIER_TEST_IDS_PER_THREAD];
+    volatile u32* finished_count;
+} identifier_test_thread;
+
+static u32 identifier_test_churn(void* params) {
+    identifier_test_thread* thread = params;
+    // Churn through the free list, then keep a set of identifiers to compare with the other threads'.
+    for (u32 round = 0; round < 16; ++round) {
+        for (u32 i = 0; i < IDENTIFIER_TEST_IDS_PER_THREAD; ++i) {
+            thread->ids[i] = identifier_aquire_new_id(thread);
+        }
+        if (round < 15) {
+            for (u32 i = 0; i < IDENTIFIER_TEST_IDS_PER_THREAD; ++i) {
+                identifier_release_id(thread->ids[i]);
+            }
+        }
+    }
+    katomic_fetch_add(thread->finished_count, 1);
+    return 0;
+}
+
+u8 identifier_should_acquire_unique_ids_across_threads() {
+    volatile u32 finished_count = 0;
+    identifier_test_thread threads[IDENTIFIER_TEST_THREAD_COUNT] = {0};
+    kthread handles[IDENTIFIER_TEST_THREAD_COUNT];
+    for (u32 i = 0; i < IDENTIFIER_TEST_THREAD_COUNT; ++i) {
+        threads[i].finished_count = &finished_count;
+        expect_to_be_true(kthread_create(identifier_test_churn, &threads[i], true, &handles[i]));
+    }
+    while (katomic_load_acquire(&finished_count) < IDENTIFIER_TEST_THREAD_COUNT) {
+    }
+
+    // Every identifier held should be owned by the thread which acquired it, and by no other.
+    for (u32 t = 0; t < IDENTIFIER_TEST_THREAD_COUNT; ++t) {
+        for (u32 i = 0; i < IDENTIFIER_TEST_IDS_PER_THREAD; ++i) {
+            expect_should_not_be(INVALID_ID, threads[t].ids[i]);
+            expect_should_be(&threads[t], identifier_owner_get(threads[t].ids[i]));
+        }
+    }
+    for (u32 t = 0; t < IDENTIFIER_TEST_THREAD_COUNT; ++t) {
+        for (u32 i = 0; i < IDENTIFIER_TEST_IDS_PER_THREAD; ++i) {
+            identifier_release_id(threads[t].ids[i]);
+        }
+    }
+    return true;
+}
+
+void identifier_register_tests() {
+    test_manager_register_test(identifier_should_acquire_unique_ids, "Identifier should acquire unique ids");
+    test_manager_register_test(identifier_should_detect_stale_generations, "Identifier should detect stale generations");
+    test_manager_register_test(identifier_should_acquire_unique_ids_across_threads, "Identifier should acquire unique ids across threads");
+}
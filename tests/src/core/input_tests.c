@@ -0,0 +1,176 @@
+#include "input_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/event.h>
+#include <core/input.h>
+#include <core/kmemory.h>
+
+typedef struct input_test_listener {
+    u32 count;
+    u16 last_code;
+    // The mouse position when the event fired.
+    i32 x;
+    i32 y;
+    f64 time;
+} input_test_listener;
+
+static b8 input_test_on_event(u16 code, void* sender, void* listener_inst, event_context data) {
+    input_test_listener* listener = listener_inst;
+    listener->count++;
+    listener->last_code = data.data.u16[0];
+    input_get_mouse_position(&listener->x, &listener->y);
+    listener->time = input_event_time();
+    return false;
+}
+
+u8 input_should_batch_and_merge_platform_events() {
+    u64 event_size = 0;
+    event_system_initialize(&event_size, 0);
+    void* event_state = kallocate(event_size, MEMORY_TAG_APPLICATION);
+    event_system_initialize(&event_size, event_state);
+    u64 input_size = 0;
+    input_system_initialize(&input_size, 0);
+    void* input_state = kallocate(input_size, MEMORY_TAG_APPLICATION);
+    input_system_initialize(&input_size, input_state);
+
+    input_test_listener button_listener = {};
+    input_test_listener key_listener = {};
+    expect_to_be_true(event_register(EVENT_CODE_BUTTON_PRESSED, &button_listener, input_test_on_event));
+    expect_to_be_true(event_register(EVENT_CODE_KEY_PRESSED, &key_listener, input_test_on_event));
+
+    // Far more motion than the queue holds, as a high polling rate mouse delivers, around a button press.
+    for (i16 i = 1; i <= 1000; ++i) {
+        input_process_mouse_move(i, i);
+        input_process_mouse_raw_move(1, -2);
+    }
+    input_process_button(BUTTON_LEFT, true);
+    for (i16 i = 1001; i <= 2000; ++i) {
+        input_process_mouse_move(i, i / 2);
+    }
+    input_process_key(KEY_A, true);
+    input_process_key(KEY_A, false);
+    input_process_key(KEY_B, true);
+
+    // Nothing applies until dispatched.
+    i32 x = -1;
+    i32 y = -1;
+    input_get_mouse_position(&x, &y);
+    expect_should_be(0, x);
+    expect_should_be(0, y);
+    expect_to_be_false(input_is_button_down(BUTTON_LEFT));
+    expect_should_be(0, button_listener.count);
+
+    input_dispatch_events();
+
+    // In order: the press sees the position of the moves before it.
+    expect_should_be(1, button_listener.count);
+    expect_should_be(BUTTON_LEFT, button_listener.last_code);
+    expect_should_be(1000, button_listener.x);
+    expect_should_be(1000, button_listener.y);
+    expect_to_be_true((button_listener.time > 0));
+    expect_to_be_true(input_is_button_down(BUTTON_LEFT));
+
+    // Key presses are never merged away.
+    expect_should_be(2, key_listener.count);
+    expect_should_be(KEY_B, key_listener.last_code);
+    expect_to_be_false(input_is_key_down(KEY_A));
+    expect_to_be_true(input_is_key_down(KEY_B));
+    expect_to_be_true((key_listener.time >= button_listener.time));
+
+    input_get_mouse_position(&x, &y);
+    expect_should_be(2000, x);
+    expect_should_be(1000, y);
+
+    // Raw motion is summed over the frame, and starts over with the next.
+    input_get_mouse_raw_delta(&x, &y);
+    expect_should_be(1000, x);
+    expect_should_be(-2000, y);
+    input_update(0);
+    input_get_mouse_raw_delta(&x, &y);
+    expect_should_be(0, x);
+    expect_should_be(0, y);
+
+    // An empty dispatch does nothing.
+    input_dispatch_events();
+    expect_should_be(1, button_listener.count);
+
+    event_unregister(EVENT_CODE_BUTTON_PRESSED, &button_listener, input_test_on_event);
+    event_unregister(EVENT_CODE_KEY_PRESSED, &key_listener, input_test_on_event);
+    input_system_shutdown(input_state);
+    kfree(input_state, input_size, MEMORY_TAG_APPLICATION);
+    event_system_shutdown(event_state);
+    kfree(event_state, event_size, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+u8 input_snapshots_should_hold_a_frame_until_the_next_but_one() {
+    u64 event_size = 0;
+    event_system_initialize(&event_size, 0);
+    void* event_state = kallocate(event_size, MEMORY_TAG_APPLICATION);
+    event_system_initialize(&event_size, event_state);
+    u64 input_size = 0;
+    input_system_initialize(&input_size, 0);
+    void* input_state = kallocate(input_size, MEMORY_TAG_APPLICATION);
+    input_system_initialize(&input_size, input_state);
+
+    // Before any is taken, an empty one.
+    const input_snapshot* empty = input_snapshot_get();
+    expect_to_be_true(empty != 0);
+    expect_should_be(0, empty->event_count);
+    expect_to_be_false(input_snapshot_is_key_down(empty, KEY_A));
+
+    input_process_key(KEY_A, true);
+    input_process_mouse_move(10, 20);
+    input_process_mouse_wheel(1);
+    input_process_mouse_wheel(2);
+    input_dispatch_events();
+    input_snapshot_take();
+
+    const input_snapshot* first = input_snapshot_get();
+    expect_should_be(0, first->frame);
+    expect_to_be_true(input_snapshot_is_key_down(first, KEY_A));
+    expect_to_be_false(input_snapshot_was_key_down(first, KEY_A));
+    expect_should_be(10, first->mouse_x);
+    expect_should_be(20, first->mouse_y);
+    expect_should_be(3, first->mouse_wheel_delta);
+    // The key, the move, and the merged scrolls, in order.
+    expect_should_be(3, first->event_count);
+    expect_should_be(INPUT_EVENT_TYPE_KEY, first->events[0].type);
+    expect_should_be(INPUT_EVENT_TYPE_MOUSE_WHEEL, first->events[2].type);
+    expect_to_be_true((first->events[0].timestamp <= first->events[2].timestamp));
+
+    // The next frame's state does not change the snapshot taken before it.
+    input_update(0);
+    input_process_key(KEY_A, false);
+    input_process_button(BUTTON_LEFT, true);
+    input_dispatch_events();
+    expect_to_be_true(input_snapshot_is_key_down(first, KEY_A));
+    expect_to_be_false(input_snapshot_is_button_down(first, BUTTON_LEFT));
+    input_snapshot_take();
+
+    const input_snapshot* second = input_snapshot_get();
+    expect_to_be_true(second != first);
+    expect_should_be(1, second->frame);
+    expect_to_be_false(input_snapshot_is_key_down(second, KEY_A));
+    expect_to_be_true(input_snapshot_was_key_down(second, KEY_A));
+    expect_to_be_true(input_snapshot_is_button_down(second, BUTTON_LEFT));
+    expect_should_be(0, second->mouse_wheel_delta);
+    expect_should_be(2, second->event_count);
+    // Still the first frame's until the one after is taken.
+    expect_should_be(0, first->frame);
+    expect_to_be_true(input_snapshot_is_key_down(first, KEY_A));
+
+    input_system_shutdown(input_state);
+    kfree(input_state, input_size, MEMORY_TAG_APPLICATION);
+    event_system_shutdown(event_state);
+    kfree(event_state, event_size, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+void input_register_tests() {
+    test_manager_register_test(input_should_batch_and_merge_platform_events, "Input should batch platform events, merging motion");
+    test_manager_register_test(input_snapshots_should_hold_a_frame_until_the_next_but_one, "Input snapshots should hold a frame until the next but one is taken");
+}
@@ -0,0 +1,102 @@
+#include "kcompress_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kcompress.h>
+#include <core/kmemory.h>
+#include <math/kmath.h>
+
+#define KCOMPRESS_TEST_SIZE 100000
+
+static b8 round_trip(const u8* data, u64 size, u64* out_compressed_size) {
+    u64 bound = kcompress_lz4_bound(size);
+    u8* compressed = kallocate(bound, MEMORY_TAG_ARRAY);
+    u8* decompressed = kallocate(size + 1, MEMORY_TAG_ARRAY);
+    u64 compressed_size = kcompress_lz4(data, size, compressed, bound);
+    b8 result = compressed_size > 0 && compressed_size <= bound && kdecompress_lz4(compressed, compressed_size, decompressed, size);
+    for (u64 i = 0; result && i < size; ++i) {
+        result = decompressed[i] == data[i];
+    }
+    *out_compressed_size = compressed_size;
+    kfree(decompressed, size + 1, MEMORY_TAG_ARRAY);
+    kfree(compressed, bound, MEMORY_TAG_ARRAY);
+    return result;
+}
+
+u8 kcompress_lz4_should_round_trip() {
+    u8* data = kallocate(KCOMPRESS_TEST_SIZE, MEMORY_TAG_ARRAY);
+    krandom_state rng;
+    krandom_state_seed(&rng, 42);
+    u64 compressed_size = 0;
+
+    // Empty, and too short to hold a match.
+    expect_to_be_true(round_trip(data, 0, &compressed_size));
+    expect_should_be(1, compressed_size);
+    expect_to_be_true(round_trip((const u8*)"hello", 5, &compressed_size));
+
+    // Runs of a repeated byte, which overlap their own matches, and long literal runs.
+    for (u32 i = 0; i < KCOMPRESS_TEST_SIZE; ++i) {
+        data[i] = (i / 1000) % 2 ? 'a' : (u8)krandom_state_u32(&rng);
+    }
+    expect_to_be_true(round_trip(data, KCOMPRESS_TEST_SIZE, &compressed_size));
+    expect_to_be_true((compressed_size < KCOMPRESS_TEST_SIZE * 3 / 5));
+
+    // Text-like data with matches at many distances.
+    const char* words[] = {"vertex ", "index ", "texture ", "material ", "shader ", "\n"};
+    for (u32 i = 0; i < KCOMPRESS_TEST_SIZE;) {
+        const char* word = words[krandom_state_u32(&rng) % 6];
+        for (u32 j = 0; word[j] && i < KCOMPRESS_TEST_SIZE; ++j) {
+            data[i++] = (u8)word[j];
+        }
+    }
+    expect_to_be_true(round_trip(data, KCOMPRESS_TEST_SIZE, &compressed_size));
+    expect_to_be_true((compressed_size < KCOMPRESS_TEST_SIZE / 2));
+
+    // Random data does not compress, but stays within the bound.
+    for (u32 i = 0; i < KCOMPRESS_TEST_SIZE; ++i) {
+        data[i] = (u8)krandom_state_u32(&rng);
+    }
+    expect_to_be_true(round_trip(data, KCOMPRESS_TEST_SIZE, &compressed_size));
+    expect_to_be_true((compressed_size > KCOMPRESS_TEST_SIZE));
+
+    // Too little room to compress into fails rather than overrunning.
+    u8 small[64];
+    expect_should_be(0, kcompress_lz4(data, KCOMPRESS_TEST_SIZE, small, sizeof(small)));
+
+    kfree(data, KCOMPRESS_TEST_SIZE, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 kdecompress_lz4_should_reject_corrupt_input() {
+    // "abcd" then a match 4 back of 8 bytes, then the last 5 literals "efghi".
+    const u8 valid[] = {0x44, 'a', 'b', 'c', 'd', 0x04, 0x00, 0x50, 'e', 'f', 'g', 'h', 'i'};
+    u8 out[32];
+    expect_to_be_true(kdecompress_lz4(valid, sizeof(valid), out, 17));
+    const char* expected = "abcdabcdabcdefghi";
+    for (u32 i = 0; i < 17; ++i) {
+        expect_should_be(expected[i], out[i]);
+    }
+
+    // The wrong size, either way.
+    expect_to_be_false(kdecompress_lz4(valid, sizeof(valid), out, 16));
+    expect_to_be_false(kdecompress_lz4(valid, sizeof(valid), out, 18));
+    // Truncated input.
+    for (u32 i = 1; i < sizeof(valid); ++i) {
+        expect_to_be_false(kdecompress_lz4(valid, i, out, 17));
+    }
+    // A match reaching back before the start of the output, or with no offset.
+    u8 corrupt[sizeof(valid)];
+    kcopy_memory(corrupt, valid, sizeof(valid));
+    corrupt[5] = 5;
+    expect_to_be_false(kdecompress_lz4(corrupt, sizeof(corrupt), out, 17));
+    corrupt[5] = 0;
+    expect_to_be_false(kdecompress_lz4(corrupt, sizeof(corrupt), out, 17));
+    return true;
+}
+
+void kcompress_register_tests() {
+    test_manager_register_test(kcompress_lz4_should_round_trip, "LZ4 compression should round trip");
+    test_manager_register_test(kdecompress_lz4_should_reject_corrupt_input, "LZ4 decompression should reject corrupt input");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void kcompress_register_tests();
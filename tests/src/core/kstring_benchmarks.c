@@ -0,0 +1,102 @@
+#include "kstring_benchmarks.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <core/kstring.h>
+
+// Written to so that the compiler can't drop the work being timed.
+static volatile f64 kstring_bench_sink;
+
+// Numbers as asset files hold them: short decimals, exponents and the odd long one.
+static const char* float_inputs[] = {"0.5", "-1.25", "3.14159265", "100", "1e-3", "-2.5E+4", "0.000123456789", "65535.0"};
+#define FLOAT_INPUT_COUNT (sizeof(float_inputs) / sizeof(float_inputs[0]))
+
+static const char* integer_inputs[] = {"0", "42", "-17", "65535", "4294967295", "-2147483648", "123456789012", "7"};
+#define INTEGER_INPUT_COUNT (sizeof(integer_inputs) / sizeof(integer_inputs[0]))
+
+// A line of a material or mesh config, split into its tokens.
+static const char* config_line = "diffuse_colour = 0.800000 0.640000 0.120000 1.000000";
+
+static u64 float_input_lengths[FLOAT_INPUT_COUNT];
+static u64 integer_input_lengths[INTEGER_INPUT_COUNT];
+
+static u8 inputs_setup() {
+    for (u32 i = 0; i < FLOAT_INPUT_COUNT; ++i) {
+        float_input_lengths[i] = string_length(float_inputs[i]);
+    }
+    for (u32 i = 0; i < INTEGER_INPUT_COUNT; ++i) {
+        integer_input_lengths[i] = string_length(integer_inputs[i]);
+    }
+    return true;
+}
+
+static u8 parse_f32_run(u32 op_count) {
+    f32 total = 0;
+    for (u32 i = 0; i < op_count; ++i) {
+        u32 input = i % FLOAT_INPUT_COUNT;
+        f32 value = 0;
+        if (!string_parse_f32(float_inputs[input], float_input_lengths[input], &value)) {
+            return false;
+        }
+        total += value;
+    }
+    kstring_bench_sink = total;
+    return true;
+}
+
+static u8 parse_f64_run(u32 op_count) {
+    f64 total = 0;
+    for (u32 i = 0; i < op_count; ++i) {
+        u32 input = i % FLOAT_INPUT_COUNT;
+        f64 value = 0;
+        if (!string_parse_f64(float_inputs[input], float_input_lengths[input], &value)) {
+            return false;
+        }
+        total += value;
+    }
+    kstring_bench_sink = total;
+    return true;
+}
+
+static u8 parse_i64_run(u32 op_count) {
+    i64 total = 0;
+    for (u32 i = 0; i < op_count; ++i) {
+        u32 input = i % INTEGER_INPUT_COUNT;
+        i64 value = 0;
+        if (!string_parse_i64(integer_inputs[input], integer_input_lengths[input], &value)) {
+            return false;
+        }
+        total += value;
+    }
+    kstring_bench_sink = (f64)total;
+    return true;
+}
+
+// Timed per line, splitting it and parsing its four values as the config loaders do.
+static u8 config_line_run(u32 op_count) {
+    f32 total = 0;
+    for (u32 i = 0; i < op_count; ++i) {
+        kstring_view text = string_view_create(config_line);
+        kstring_view name;
+        if (!string_view_next_split(&text, '=', &name)) {
+            return false;
+        }
+        for (u32 j = 0; j < 4; ++j) {
+            f32 value;
+            if (!string_view_parse_f32(&text, &value)) {
+                return false;
+            }
+            total += value;
+        }
+    }
+    kstring_bench_sink = total;
+    return true;
+}
+
+void kstring_register_benchmarks() {
+    test_manager_register_benchmark(inputs_setup, parse_f32_run, 0, 200000, "kstring.parse_f32");
+    test_manager_register_benchmark(inputs_setup, parse_f64_run, 0, 200000, "kstring.parse_f64");
+    test_manager_register_benchmark(inputs_setup, parse_i64_run, 0, 200000, "kstring.parse_i64");
+    test_manager_register_benchmark(0, config_line_run, 0, 50000, "kstring.config_line");
+}
@@ -0,0 +1,311 @@
+#include "kstring_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kstring.h>
+#include <core/kmemory.h>
+#include <core/logger.h>
+#include <math/kmath.h>
+#include <memory/linear_allocator.h>
+
+#include <stdlib.h>  // strtof, strtod
+#include <locale.h>  // setlocale
+
+u8 string_view_should_split_lines_and_tokens() {
+    kstring_view text = string_view_create("first line\r\n\n  a  b\tc \nlast");
+    kstring_view line;
+
+    expect_to_be_true(string_view_next_line(&text, &line));
+    expect_to_be_true(string_view_equal(line, "first line"));
+    expect_to_be_true(string_view_next_line(&text, &line));
+    expect_should_be(0, line.length);
+    expect_to_be_true(string_view_next_line(&text, &line));
+    expect_to_be_true(string_view_equal(string_view_trim(line), "a  b\tc"));
+
+    kstring_view token;
+    expect_to_be_true(string_view_next_token(&line, &token));
+    expect_to_be_true(string_view_equal(token, "a"));
+    expect_to_be_true(string_view_next_token(&line, &token));
+    expect_to_be_true(string_view_equal(token, "b"));
+    expect_to_be_true(string_view_next_token(&line, &token));
+    expect_to_be_true(string_view_equal(token, "c"));
+    expect_to_be_false(string_view_next_token(&line, &token));
+
+    // The last line has no line ending.
+    expect_to_be_true(string_view_next_line(&text, &line));
+    expect_to_be_true(string_view_equal(line, "last"));
+    expect_to_be_false(string_view_next_line(&text, &line));
+    return true;
+}
+
+u8 string_view_should_split_and_compare() {
+    kstring_view text = string_view_create(" vec3 , Position,,in_colour");
+    kstring_view entry;
+    expect_to_be_true(string_view_next_split(&text, ',', &entry));
+    expect_to_be_true(string_view_equal(entry, "vec3"));
+    expect_to_be_true(string_view_next_split(&text, ',', &entry));
+    expect_to_be_false(string_view_equal(entry, "position"));
+    expect_to_be_true(string_view_equali(entry, "position"));
+    expect_to_be_true(string_view_next_split(&text, ',', &entry));
+    expect_should_be(0, entry.length);
+    expect_to_be_true(string_view_next_split(&text, ',', &entry));
+    expect_to_be_true(string_view_equal(entry, "in_colour"));
+    expect_to_be_false(string_view_next_split(&text, ',', &entry));
+
+    kstring_view view = string_view_create("name=value");
+    expect_should_be(4, string_view_index_of(view, '='));
+    expect_should_be(-1, string_view_index_of(view, '#'));
+    expect_to_be_true(string_view_equal(string_view_mid(view, 5, -1), "value"));
+    expect_to_be_true(string_view_equal(string_view_mid(view, 0, 4), "name"));
+    expect_should_be(0, string_view_mid(view, 20, 4).length);
+
+    // Copies are truncated to fit, and always terminated.
+    char buffer[5];
+    string_view_copy(buffer, view, sizeof(buffer));
+    expect_to_be_true(strings_equal(buffer, "name"));
+    char* copy = string_view_duplicate(string_view_mid(view, 5, -1));
+    expect_to_be_true(strings_equal(copy, "value"));
+    string_free(copy);
+
+    expect_to_be_true(string_view_to_bool(string_view_create("TRUE")));
+    expect_to_be_true(string_view_to_bool(string_view_create("1")));
+    expect_to_be_false(string_view_to_bool(string_view_create("0")));
+    return true;
+}
+
+u8 string_view_should_parse_numbers() {
+    // Parsed the same as strtof does.
+    const char* floats[] = {"0", "1", "-1", "0.5", "3.14159265", "-0.0001", "1e10", "1.5E-3", "123456.789",
+                            "0.000000000000000000000000000000000000011754944", "3.4028234e38", "16777217", "0.1",
+                            "1234567890123456789012345", "-2.5e-7", "+7.25", "9.999999e-21"};
+    for (u32 i = 0; i < sizeof(floats) / sizeof(floats[0]); ++i) {
+        kstring_view text = string_view_create(floats[i]);
+        f32 f = -123.0f;
+        expect_to_be_true(string_view_parse_f32(&text, &f));
+        expect_should_be(0, text.length);
+        f32 expected = strtof(floats[i], 0);
+        expect_to_be_true((f == expected));
+    }
+
+    // Consecutive values, stopping just after each.
+    kstring_view text = string_view_create("  1.0 -2.5 3e2 4");
+    f32 values[4];
+    for (u32 i = 0; i < 4; ++i) {
+        expect_to_be_true(string_view_parse_f32(&text, &values[i]));
+    }
+    expect_float_to_be(1.0f, values[0]);
+    expect_float_to_be(-2.5f, values[1]);
+    expect_float_to_be(300.0f, values[2]);
+    expect_float_to_be(4.0f, values[3]);
+    f32 f;
+    expect_to_be_false(string_view_parse_f32(&text, &f));
+
+    // An exponent without digits is not part of the number.
+    text = string_view_create("3e");
+    expect_to_be_true(string_view_parse_f32(&text, &f));
+    expect_float_to_be(3.0f, f);
+    expect_to_be_true(string_view_equal(text, "e"));
+
+    text = string_view_create("x");
+    expect_to_be_false(string_view_parse_f32(&text, &f));
+    expect_should_be(1, text.length);
+
+    // Face vertices, as in an obj file.
+    text = string_view_create("12/-3/7");
+    i32 i = 0;
+    expect_to_be_true(string_view_parse_i32(&text, &i));
+    expect_should_be(12, i);
+    expect_to_be_true(string_view_equal(text, "/-3/7"));
+    text = string_view_mid(text, 1, -1);
+    expect_to_be_true(string_view_parse_i32(&text, &i));
+    expect_should_be(-3, i);
+    text = string_view_create("/");
+    expect_to_be_false(string_view_parse_i32(&text, &i));
+    return true;
+}
+
+u8 string_parse_should_round_like_the_c_library() {
+    krandom_state rng;
+    krandom_state_seed(&rng, 7);
+    char text[64];
+    for (u32 n = 0; n < 50000; ++n) {
+        // A random number of digits, with the point anywhere among them, and sometimes an exponent.
+        u32 length = 0;
+        if (krandom_state_u32(&rng) & 1) {
+            text[length++] = '-';
+        }
+        u32 digit_count = 1 + krandom_state_u32(&rng) % 24;
+        u32 point = krandom_state_u32(&rng) % (digit_count + 1);
+        for (u32 i = 0; i < digit_count; ++i) {
+            if (i == point) {
+                text[length++] = '.';
+            }
+            text[length++] = (char)('0' + krandom_state_u32(&rng) % 10);
+        }
+        if (krandom_state_u32(&rng) & 1) {
+            i32 exponent = (i32)(krandom_state_u32(&rng) % 90) - 50;
+            length += string_format(&text[length], "e%d", exponent);
+        }
+        text[length] = 0;
+
+        f32 f = 0;
+        f64 d = 0;
+        expect_should_be(length, string_parse_f32(text, length, &f));
+        expect_should_be(length, string_parse_f64(text, length, &d));
+        f32 expected_f = strtof(text, 0);
+        f64 expected_d = strtod(text, 0);
+        if (f != expected_f || d != expected_d) {
+            KERROR("Parsing '%s' gave %.9g and %.17g.", text, f, d);
+            return false;
+        }
+    }
+
+    // Halfway between two floats, which the double on its own cannot tell apart.
+    f32 f = 0;
+    expect_should_be(8, string_parse_f32("16777217", 8, &f));
+    expect_to_be_true((f == 16777216.0f));
+    expect_should_be(27, string_parse_f32("0.5000000298023223876953125", 27, &f));
+    expect_to_be_true((f == 0.5f));
+    expect_should_be(28, string_parse_f32("0.50000002980232238769531251", 28, &f));
+    expect_to_be_true((f > 0.5f));
+
+    // Only the given characters are read, with no terminator needed.
+    expect_should_be(4, string_parse_f32(" 2.5e3", 4, &f));
+    expect_float_to_be(2.5f, f);
+    return true;
+}
+
+u8 string_parse_should_ignore_the_locale() {
+    // Any locale which writes its decimal point as a comma.
+    const char* locales[] = {"de_DE.UTF-8", "de_DE", "fr_FR.UTF-8", "fr_FR", "German"};
+    b8 set = false;
+    for (u32 i = 0; i < sizeof(locales) / sizeof(locales[0]) && !set; ++i) {
+        set = setlocale(LC_NUMERIC, locales[i]) != 0;
+    }
+    if (!set) {
+        // No such locale is installed here.
+        return BYPASS;
+    }
+
+    // Too many digits for the fast path, so the C library rounds them.
+    const char* text = "1.2500000000000000000000000001";
+    f32 f = 0;
+    f64 d = 0;
+    u64 f_length = string_parse_f32(text, 30, &f);
+    u64 d_length = string_parse_f64(text, 30, &d);
+    setlocale(LC_NUMERIC, "C");
+
+    expect_should_be(30, f_length);
+    expect_should_be(30, d_length);
+    expect_to_be_true((f == 1.25f));
+    expect_to_be_true((d == 1.25));
+    return true;
+}
+
+u8 string_parse_should_check_integer_ranges() {
+    i64 i = 0;
+    u64 u = 0;
+    expect_should_be(20, string_parse_i64("-9223372036854775808", 20, &i));
+    expect_to_be_true((i == (-9223372036854775807ll - 1)));
+    expect_should_be(0, string_parse_i64("9223372036854775808", 19, &i));
+    expect_should_be(20, string_parse_u64("18446744073709551615", 20, &u));
+    expect_to_be_true((u == 0xFFFFFFFFFFFFFFFFull));
+    expect_should_be(0, string_parse_u64("18446744073709551616", 20, &u));
+    expect_should_be(0, string_parse_u64("-1", 2, &u));
+
+    u8 byte = 0;
+    expect_to_be_true(string_to_u8("255", &byte));
+    expect_should_be(255, byte);
+    expect_to_be_false(string_to_u8("256", &byte));
+    i8 small = 0;
+    expect_to_be_true(string_to_i8("-128", &small));
+    expect_should_be(-128, small);
+    expect_to_be_false(string_to_i8("abc", &small));
+
+    vec3 v;
+    expect_to_be_true(string_to_vec3("1 -2.5 3e1", &v));
+    expect_float_to_be(30.0f, v.z);
+    expect_to_be_false(string_to_vec3("1 2", &v));
+    return true;
+}
+
+u8 string_builder_should_grow_from_the_heap() {
+    kstring_builder builder;
+    string_builder_create(4, &builder);
+    expect_to_be_true(string_builder_append(&builder, "Pos=["));
+    expect_to_be_true(string_builder_append_format(&builder, "%.1f %d", 1.5f, 42));
+    expect_to_be_true(string_builder_append_char(&builder, ']'));
+    expect_to_be_true(string_builder_append_view(&builder, string_view_from(" done and more", 5)));
+    expect_to_be_true(strings_equal("Pos=[1.5 42] done", builder.data));
+    expect_should_be(17, builder.length);
+    expect_to_be_false(builder.truncated);
+
+    string_builder_clear(&builder);
+    expect_should_be(0, builder.length);
+    expect_to_be_true(string_view_equal(string_builder_view(&builder), ""));
+    string_builder_destroy(&builder);
+    expect_should_be(0, builder.data);
+    return true;
+}
+
+u8 string_builder_should_cut_off_in_a_caller_buffer() {
+    char buffer[8];
+    kstring_builder builder;
+    string_builder_create_from_buffer(buffer, sizeof(buffer), &builder);
+    expect_to_be_true(string_builder_append(&builder, "abc"));
+    expect_to_be_false(string_builder_append_format(&builder, "%d", 123456));
+    expect_to_be_true(builder.truncated);
+    expect_should_be(7, builder.length);
+    expect_to_be_true(strings_equal("abc1234", buffer));
+
+    string_builder_truncate(&builder, 3);
+    expect_to_be_true(strings_equal("abc", buffer));
+    expect_to_be_false(string_builder_append(&builder, "defgh"));
+    expect_to_be_true(strings_equal("abcdefg", buffer));
+    return true;
+}
+
+u8 string_builder_should_grow_in_place_in_an_arena() {
+    char memory[64];
+    linear_allocator allocator;
+    linear_allocator_create(sizeof(memory), memory, &allocator);
+
+    kstring_builder builder;
+    string_builder_create_arena(&allocator, 4, &builder);
+    expect_to_be_true(string_builder_append_format(&builder, "%s/%s.%s", "assets", "textures", "kbt"));
+    expect_to_be_true(strings_equal("assets/textures.kbt", builder.data));
+    // Grown in place, as the builder's buffer was the last allocation.
+    expect_should_be(memory, builder.data);
+
+    // Formatted strings are sized exactly.
+    u64 allocated = allocator.allocated;
+    kstring_view view = string_format_arena(&allocator, "%u:%u", 12, 345);
+    expect_to_be_true(string_view_equal(view, "12:345"));
+    expect_should_be(allocated + 7, allocator.allocated);
+    expect_should_be(0, view.str[view.length]);
+
+    // Once full, what fit is kept.
+    expect_to_be_false(string_builder_append_format(&builder, "%64s", "x"));
+    expect_to_be_true(builder.truncated);
+    string_builder_destroy(&builder);
+    linear_allocator_destroy(&allocator);
+
+    char dest[6];
+    expect_should_be(9, string_nformat(dest, sizeof(dest), "%s", "truncated"));
+    expect_to_be_true(strings_equal("trunc", dest));
+    return true;
+}
+
+void kstring_register_tests() {
+    test_manager_register_test(string_view_should_split_lines_and_tokens, "String views should split lines and tokens");
+    test_manager_register_test(string_view_should_split_and_compare, "String views should split and compare");
+    test_manager_register_test(string_view_should_parse_numbers, "String views should parse numbers");
+    test_manager_register_test(string_parse_should_round_like_the_c_library, "Number parsing should round like the C library");
+    test_manager_register_test(string_parse_should_ignore_the_locale, "Number parsing should ignore the locale");
+    test_manager_register_test(string_parse_should_check_integer_ranges, "Integer parsing should check ranges");
+    test_manager_register_test(string_builder_should_grow_from_the_heap, "String builder should grow from the heap");
+    test_manager_register_test(string_builder_should_cut_off_in_a_caller_buffer, "String builder should cut off in a caller buffer");
+    test_manager_register_test(string_builder_should_grow_in_place_in_an_arena, "String builder should grow in place in an arena");
+}
@@ -0,0 +1,113 @@
+#include "logger_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <core/log_deferred.h>
+#include <core/logger.h>
+#include <platform/filesystem.h>
+
+#include <stdarg.h>
+#include <stdio.h>  // remove
+
+// Captures and formats the given arguments as a deferred entry would be, then compares the result with string_format.
+static b8 deferred_matches(const char* format, ...) {
+    u8 payload[512];
+    char deferred[512];
+    char expected[512];
+
+    __builtin_va_list args;
+    va_start(args, format);
+    u32 size = log_deferred_capture(format, args, payload, sizeof(payload));
+    va_end(args);
+    if (size == INVALID_ID) {
+        return false;
+    }
+    log_deferred_format(format, payload, size, deferred, sizeof(deferred));
+
+    va_start(args, format);
+    string_format_v(expected, format, args);
+    va_end(args);
+    if (!strings_equal(deferred, expected)) {
+        KERROR("Deferred '%s' formatted as '%s', expected '%s'.", format, deferred, expected);
+        return false;
+    }
+    return true;
+}
+
+static u32 capture_size(u32 max_size, const char* format, ...) {
+    u8 payload[64];
+    __builtin_va_list args;
+    va_start(args, format);
+    u32 size = log_deferred_capture(format, args, payload, max_size);
+    va_end(args);
+    return size;
+}
+
+u8 logger_deferred_should_format_like_printf() {
+    expect_to_be_true(deferred_matches("no arguments, 100%% literal"));
+    expect_to_be_true(deferred_matches("%d %i %u %x %X %o", -42, 17, 3000000000u, 0xbeef, 0xCAFE, 8));
+    expect_to_be_true(deferred_matches("%lld %llu %zu %ld", -1234567890123ll, 18446744073709551615ull, (u64)77, -5l));
+    expect_to_be_true(deferred_matches("%hhu %hd %c", 300, 70000, 'k'));
+    expect_to_be_true(deferred_matches("%f %.2f %e %g %8.3f", 1.5, 3.14159, 12345.678, 0.0001, -2.5));
+    expect_to_be_true(deferred_matches("[%s] [%10s] [%-6s|] [%.3s]", "hello", "right", "left", "truncated"));
+    expect_to_be_true(deferred_matches("%*d|%-*d|%.*f", 6, 42, 4, 7, 3, 2.71828));
+    expect_to_be_true(deferred_matches("%s and %s", (const char*)0, ""));
+    expect_to_be_true(deferred_matches("%p", (void*)0x1234));
+
+    // Numbers which don't fit are reported, rather than cut off, but strings are truncated.
+    expect_should_be(INVALID_ID, capture_size(12, "%d %d", 1, 2));
+    expect_should_be(16, capture_size(16, "%d %d", 1, 2));
+    expect_should_be(12, capture_size(12, "%d %s", 1, "longer than it fits"));
+    return true;
+}
+
+u8 logger_should_round_trip_a_binary_log() {
+    u64 size = 0;
+    initialize_logging(&size, 0);
+    void* state = kallocate(size, MEMORY_TAG_APPLICATION);
+    expect_to_be_true(initialize_logging(&size, state));
+
+    expect_to_be_true(log_binary_open("logger_test.klog"));
+    for (u32 i = 0; i < 100; ++i) {
+        KTRACE_DEFERRED(LOG_CATEGORY_GAME, "entry %u of %s at %.1f", i, "test", i * 0.5);
+    }
+    KDEBUG_DEFERRED(LOG_CATEGORY_JOBS, "last");
+    log_binary_close();
+
+    // Skipped by the category level, so not written at all.
+    log_category_level_set(LOG_CATEGORY_GAME, LOG_LEVEL_INFO);
+    KTRACE_DEFERRED(LOG_CATEGORY_GAME, "skipped");
+    log_category_level_set(LOG_CATEGORY_GAME, LOG_LEVEL_TRACE);
+
+    shutdown_logging(state);
+    kfree(state, size, MEMORY_TAG_APPLICATION);
+
+    expect_to_be_true(log_binary_decode("logger_test.klog", "logger_test.txt"));
+    file_handle handle;
+    expect_to_be_true(filesystem_open("logger_test.txt", FILE_MODE_READ, false, &handle));
+    char buffer[256];
+    char* line = buffer;
+    u64 length = 0;
+    char expected[256];
+    for (u32 i = 0; i < 100; ++i) {
+        expect_to_be_true(filesystem_read_line(&handle, sizeof(buffer), &line, &length));
+        string_format(expected, "[TRACE]: entry %u of test at %.1f\n", i, i * 0.5);
+        expect_to_be_true(strings_equal(expected, line));
+    }
+    expect_to_be_true(filesystem_read_line(&handle, sizeof(buffer), &line, &length));
+    expect_to_be_true(strings_equal("[DEBUG]: last\n", line));
+    expect_to_be_false(filesystem_read_line(&handle, sizeof(buffer), &line, &length));
+    filesystem_close(&handle);
+    remove("logger_test.klog");
+    remove("logger_test.txt");
+    return true;
+}
+
+void logger_register_tests() {
+    test_manager_register_test(logger_deferred_should_format_like_printf, "Deferred log entries should format as printf would");
+    test_manager_register_test(logger_should_round_trip_a_binary_log, "Logger should write and decode a binary log");
+}
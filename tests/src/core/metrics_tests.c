@@ -0,0 +1,51 @@
+#include "metrics_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/metrics.h>
+
+u8 metrics_should_report_frame_percentiles_and_hitches() {
+    metrics_initialize();
+
+    // 1ms to 100ms, then a hitch, each frame split evenly between update and render.
+    for (u32 i = 1; i <= 100; ++i) {
+        f64 frame = i / 1000.0;
+        metrics_update(frame, frame / 2, frame / 2, 0.001);
+    }
+    metrics_update(0.5, 0.25, 0.25, 0);
+
+    frame_stats stats;
+    metrics_frame_stats_get(&stats);
+    expect_should_be(101, stats.frame_count);
+    expect_float_to_be(51.0, stats.frame_p50_ms);
+    expect_float_to_be(96.0, stats.frame_p95_ms);
+    expect_float_to_be(100.0, stats.frame_p99_ms);
+    expect_float_to_be(500.0, stats.frame_max_ms);
+    expect_float_to_be((5550.0 / 101), stats.frame_avg_ms);
+    expect_float_to_be((2775.0 / 101), stats.update_avg_ms);
+    expect_float_to_be((2775.0 / 101), stats.render_avg_ms);
+    expect_float_to_be((100.0 / 101), stats.sleep_avg_ms);
+
+    // Frame n of the rising ones takes exactly twice the average before it, n / 2, so only the last is a hitch.
+    expect_should_be(1, stats.hitch_count);
+    expect_should_be(1, stats.total_hitch_count);
+
+    // GPU time recorded during a frame is counted towards it.
+    metrics_initialize();
+    metrics_gpu_time_record("world", 2.0);
+    metrics_gpu_time_record("ui", 0.5);
+    metrics_update(0.01, 0.005, 0.005, 0);
+    metrics_frame_stats_get(&stats);
+    expect_should_be(1, stats.frame_count);
+    expect_float_to_be(2.5, stats.gpu_avg_ms);
+    expect_float_to_be(2.5, metrics_frame_gpu_time());
+    expect_float_to_be(2.0, metrics_gpu_time("world"));
+    expect_should_be(0, stats.hitch_count);
+    return true;
+}
+
+void metrics_register_tests() {
+    test_manager_register_test(metrics_should_report_frame_percentiles_and_hitches, "Metrics should report frame percentiles and hitches");
+}
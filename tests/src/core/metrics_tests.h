@@ -0,0 +1,3 @@
+#pragma once
+
+void metrics_register_tests();
@@ -0,0 +1,145 @@
+#include "profiler_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/katomic.h>
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <core/kthread.h>
+#include <core/profiler.h>
+#include <platform/filesystem.h>
+
+#include <stdio.h>  // remove
+
+#define PROFILER_TEST_THREAD_COUNT 4
+#define PROFILER_TEST_ZONES_PER_THREAD 100
+
+// Reads a whole capture into memory, which the caller frees with string_free.
+static char* read_capture(const char* path) {
+    file_handle handle;
+    if (!filesystem_open(path, FILE_MODE_READ, false, &handle)) {
+        return 0;
+    }
+    u64 size = 0;
+    filesystem_size(&handle, &size);
+    char* text = kallocate(size + 1, MEMORY_TAG_STRING);
+    u64 read = 0;
+    filesystem_read_all_text(&handle, text, &read);
+    text[read] = 0;
+    filesystem_close(&handle);
+    return text;
+}
+
+static u32 count_occurrences(const char* text, const char* search) {
+    u32 count = 0;
+    u64 length = string_length(search);
+    for (const char* c = text; *c; ++c) {
+        if (strings_nequal(c, search, length)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static void nested_zones(u32 depth) {
+    KPROFILE_ZONE("nested");
+    if (depth > 1) {
+        nested_zones(depth - 1);
+    }
+}
+
+typedef struct profiler_test_thread {
+    u32 index;
+    volatile u32* finished_count;
+} profiler_test_thread;
+
+static u32 profiler_test_record(void* params) {
+    profiler_test_thread* thread = params;
+    char name[32];
+    string_format(name, "Worker %u", thread->index);
+    profiler_thread_name_set(name);
+    for (u32 i = 0; i < PROFILER_TEST_ZONES_PER_THREAD; ++i) {
+        KPROFILE_ZONE("worker");
+    }
+    katomic_fetch_add(thread->finished_count, 1);
+    return 0;
+}
+
+u8 profiler_should_capture_nested_zones_on_every_thread() {
+    u64 size = 0;
+    profiler_initialize(&size, 0);
+    void* state = kallocate(size, MEMORY_TAG_APPLICATION);
+    expect_to_be_true(profiler_initialize(&size, state));
+
+    // Nothing is recorded outside of a capture.
+    nested_zones(5);
+
+    profiler_capture_begin();
+    expect_to_be_true(profiler_recording);
+    {
+        KPROFILE_ZONE("outer");
+        nested_zones(3);
+    }
+
+    volatile u32 finished_count = 0;
+    profiler_test_thread threads[PROFILER_TEST_THREAD_COUNT];
+    kthread handles[PROFILER_TEST_THREAD_COUNT];
+    for (u32 i = 0; i < PROFILER_TEST_THREAD_COUNT; ++i) {
+        threads[i].index = i;
+        threads[i].finished_count = &finished_count;
+        expect_to_be_true(kthread_create(profiler_test_record, &threads[i], true, &handles[i]));
+    }
+    while (katomic_load_acquire(&finished_count) < PROFILER_TEST_THREAD_COUNT) {
+    }
+    expect_to_be_true(profiler_capture_end("profiler_test.json"));
+    expect_to_be_false(profiler_recording);
+
+    char* text = read_capture("profiler_test.json");
+    expect_to_be_true((text != 0));
+    expect_to_be_true(strings_nequal(text, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 39));
+    expect_should_be(1, count_occurrences(text, "\"name\":\"outer\""));
+    expect_should_be(3, count_occurrences(text, "\"name\":\"nested\""));
+    expect_should_be(PROFILER_TEST_THREAD_COUNT * PROFILER_TEST_ZONES_PER_THREAD, count_occurrences(text, "\"name\":\"worker\""));
+    expect_should_be(1 + PROFILER_TEST_THREAD_COUNT, count_occurrences(text, "\"ph\":\"M\""));
+    expect_should_be(1, count_occurrences(text, "\"args\":{\"name\":\"Main\"}"));
+    expect_should_be(1, count_occurrences(text, "\"args\":{\"name\":\"Worker 3\"}"));
+    string_free(text);
+    remove("profiler_test.json");
+
+    profiler_shutdown(state);
+    kfree(state, size, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+u8 profiler_should_capture_a_number_of_frames() {
+    u64 size = 0;
+    profiler_initialize(&size, 0);
+    void* state = kallocate(size, MEMORY_TAG_APPLICATION);
+    expect_to_be_true(profiler_initialize(&size, state));
+
+    profiler_capture_frames(3, "profiler_frames_test.json");
+    for (u32 i = 0; i < 5; ++i) {
+        profile_zone zone = profiler_zone_begin("frame");
+        profiler_zone_end(&zone);
+        profiler_frame_end();
+        // Still recording until the last frame has ended.
+        expect_should_be((i < 2), profiler_recording);
+    }
+
+    char* text = read_capture("profiler_frames_test.json");
+    expect_to_be_true((text != 0));
+    expect_should_be(3, count_occurrences(text, "\"name\":\"frame\""));
+    string_free(text);
+    remove("profiler_frames_test.json");
+
+    profiler_shutdown(state);
+    kfree(state, size, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+void profiler_register_tests() {
+    test_manager_register_test(profiler_should_capture_nested_zones_on_every_thread, "Profiler should capture nested zones on every thread");
+    test_manager_register_test(profiler_should_capture_a_number_of_frames, "Profiler should capture a given number of frames");
+}
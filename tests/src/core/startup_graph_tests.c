@@ -0,0 +1,143 @@
+#include "startup_graph_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/katomic.h>
+#include <core/kmemory.h>
+#include <core/startup_graph.h>
+#include <platform/platform.h>
+#include <systems/job_system.h>
+
+#define STARTUP_GRAPH_TEST_JOB_THREAD_COUNT 2
+
+typedef struct startup_graph_test_stage {
+    // The order the stage ran in, shared by every stage of a test.
+    u32* next_order;
+    u32 order;
+    b8 result;
+    // How long the stage should take, in seconds.
+    f64 duration;
+} startup_graph_test_stage;
+
+static b8 test_stage_run(void* user_data) {
+    startup_graph_test_stage* stage = user_data;
+    stage->order = katomic_fetch_add(stage->next_order, 1);
+    if (stage->duration > 0) {
+        platform_wait_until(platform_get_absolute_time() + stage->duration);
+    }
+    return stage->result;
+}
+
+u8 startup_graph_should_run_stages_after_their_dependencies() {
+    u32 next_order = 0;
+    startup_graph_test_stage test_stages[4] = {};
+    for (u32 i = 0; i < 4; ++i) {
+        test_stages[i].next_order = &next_order;
+        test_stages[i].order = INVALID_ID;
+        test_stages[i].result = true;
+    }
+
+    startup_graph graph = {};
+    u32 a = startup_graph_add(&graph, "a", test_stage_run, &test_stages[0], STARTUP_STAGE_THREAD_MAIN, 0, 0);
+    u32 b = startup_graph_add(&graph, "b", test_stage_run, &test_stages[1], STARTUP_STAGE_THREAD_MAIN, 1, (u32[]){a});
+    u32 c = startup_graph_add(&graph, "c", test_stage_run, &test_stages[2], STARTUP_STAGE_THREAD_MAIN, 1, (u32[]){a});
+    u32 d = startup_graph_add(&graph, "d", test_stage_run, &test_stages[3], STARTUP_STAGE_THREAD_MAIN, 2, (u32[]){c, b});
+    expect_should_be(3, d);
+
+    expect_to_be_true(startup_graph_run(&graph));
+    expect_should_be(4, next_order);
+    expect_should_be(0, test_stages[a].order);
+    expect_to_be_true((test_stages[b].order < test_stages[d].order));
+    expect_to_be_true((test_stages[c].order < test_stages[d].order));
+    for (u32 i = 0; i < 4; ++i) {
+        expect_to_be_true(graph.stages[i].finished);
+        expect_to_be_true(graph.stages[i].succeeded);
+    }
+    expect_to_be_true((graph.total_time >= 0));
+    return true;
+}
+
+u8 startup_graph_should_reject_unknown_dependencies() {
+    u32 next_order = 0;
+    startup_graph_test_stage test_stage = {&next_order, INVALID_ID, true, 0};
+
+    startup_graph graph = {};
+    // A stage can only depend on stages added before it, so can not depend on itself.
+    expect_should_be(INVALID_ID, startup_graph_add(&graph, "self", test_stage_run, &test_stage, STARTUP_STAGE_THREAD_MAIN, 1, (u32[]){0}));
+    expect_should_be(INVALID_ID, startup_graph_add(&graph, "no run", 0, 0, STARTUP_STAGE_THREAD_MAIN, 0, 0));
+    expect_should_be(0, graph.stage_count);
+
+    // An empty graph succeeds.
+    expect_to_be_true(startup_graph_run(&graph));
+    return true;
+}
+
+u8 startup_graph_should_not_start_stages_after_a_failure() {
+    u32 next_order = 0;
+    startup_graph_test_stage test_stages[3] = {};
+    for (u32 i = 0; i < 3; ++i) {
+        test_stages[i].next_order = &next_order;
+        test_stages[i].order = INVALID_ID;
+        test_stages[i].result = true;
+    }
+    test_stages[1].result = false;
+
+    startup_graph graph = {};
+    u32 a = startup_graph_add(&graph, "a", test_stage_run, &test_stages[0], STARTUP_STAGE_THREAD_MAIN, 0, 0);
+    u32 failing = startup_graph_add(&graph, "failing", test_stage_run, &test_stages[1], STARTUP_STAGE_THREAD_MAIN, 1, (u32[]){a});
+    startup_graph_add(&graph, "dependent", test_stage_run, &test_stages[2], STARTUP_STAGE_THREAD_MAIN, 1, (u32[]){failing});
+
+    expect_to_be_false(startup_graph_run(&graph));
+    expect_should_be(2, next_order);
+    expect_to_be_false(graph.stages[failing].succeeded);
+    expect_to_be_false(graph.stages[2].started);
+    expect_should_be(INVALID_ID, test_stages[2].order);
+    return true;
+}
+
+u8 startup_graph_should_run_independent_stages_on_job_threads() {
+    u32 thread_types[STARTUP_GRAPH_TEST_JOB_THREAD_COUNT];
+    for (u32 i = 0; i < STARTUP_GRAPH_TEST_JOB_THREAD_COUNT; ++i) {
+        thread_types[i] = JOB_TYPE_GENERAL | JOB_TYPE_RESOURCE_LOAD | JOB_TYPE_GPU_RESOURCE;
+    }
+    u64 job_memory_requirement = 0;
+    job_system_initialize(&job_memory_requirement, 0, 0, 0, 0);
+    void* job_state = kallocate(job_memory_requirement, MEMORY_TAG_APPLICATION);
+    expect_to_be_true(job_system_initialize(&job_memory_requirement, job_state, STARTUP_GRAPH_TEST_JOB_THREAD_COUNT, thread_types, 0));
+
+    u32 next_order = 0;
+    startup_graph_test_stage test_stages[4] = {};
+    for (u32 i = 0; i < 4; ++i) {
+        test_stages[i].next_order = &next_order;
+        test_stages[i].order = INVALID_ID;
+        test_stages[i].result = true;
+        test_stages[i].duration = 0.05;
+    }
+
+    // A main thread stage alongside two that can run anywhere, then one depending on all of them.
+    startup_graph graph = {};
+    u32 main_stage = startup_graph_add(&graph, "main", test_stage_run, &test_stages[0], STARTUP_STAGE_THREAD_MAIN, 0, 0);
+    u32 any_a = startup_graph_add(&graph, "any a", test_stage_run, &test_stages[1], STARTUP_STAGE_THREAD_ANY, 0, 0);
+    u32 any_b = startup_graph_add(&graph, "any b", test_stage_run, &test_stages[2], STARTUP_STAGE_THREAD_ANY, 0, 0);
+    u32 last = startup_graph_add(&graph, "last", test_stage_run, &test_stages[3], STARTUP_STAGE_THREAD_MAIN, 3, (u32[]){main_stage, any_a, any_b});
+
+    b8 result = startup_graph_run(&graph);
+    job_system_shutdown(job_state);
+    kfree(job_state, job_memory_requirement, MEMORY_TAG_APPLICATION);
+
+    expect_to_be_true(result);
+    expect_should_be(3, test_stages[last].order);
+    // The first three overlapped, so took well under their combined time.
+    expect_to_be_true((graph.total_time < 0.05 * 3 + 0.05 * 0.5));
+    expect_to_be_true((graph.stages[last].start_time >= 0.05 * 0.9));
+    return true;
+}
+
+void startup_graph_register_tests() {
+    test_manager_register_test(startup_graph_should_run_stages_after_their_dependencies, "Startup graph should run stages after their dependencies");
+    test_manager_register_test(startup_graph_should_reject_unknown_dependencies, "Startup graph should reject unknown dependencies");
+    test_manager_register_test(startup_graph_should_not_start_stages_after_a_failure, "Startup graph should not start stages after a failure");
+    test_manager_register_test(startup_graph_should_run_independent_stages_on_job_threads, "Startup graph should run independent stages on job threads");
+}
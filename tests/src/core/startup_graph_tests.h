@@ -0,0 +1,3 @@
+#pragma once
+
+void startup_graph_register_tests();
@@ -5,7 +5,7 @@
  * @brief Expects expected to be equal to actual.
  */
 #define expect_should_be(expected, actual)                                                              \
-    if (actual != expected) {                                                                           \
+    if ((actual) != (expected)) {                                                                       \
         KERROR("--> Expected %lld, but got: %lld. File: %s:%d.", expected, actual, __FILE__, __LINE__); \
         return false;                                                                                   \
     }
@@ -14,7 +14,7 @@
  * @brief Expects expected to NOT be equal to actual.
  */
 #define expect_should_not_be(expected, actual)                                                                   \
-    if (actual == expected) {                                                                                    \
+    if ((actual) == (expected)) {                                                                                \
         KERROR("--> Expected %d != %d, but they are equal. File: %s:%d.", expected, actual, __FILE__, __LINE__); \
         return false;                                                                                            \
     }
@@ -32,7 +32,7 @@
  * @brief Expects actual to be true.
  */
 #define expect_to_be_true(actual)                                                      \
-    if (actual != true) {                                                              \
+    if ((actual) != true) {                                                            \
         KERROR("--> Expected true, but got: false. File: %s:%d.", __FILE__, __LINE__); \
         return false;                                                                  \
     }
@@ -41,7 +41,7 @@
  * @brief Expects actual to be false.
  */
 #define expect_to_be_false(actual)                                                     \
-    if (actual != false) {                                                             \
+    if ((actual) != false) {                                                           \
         KERROR("--> Expected false, but got: true. File: %s:%d.", __FILE__, __LINE__); \
         return false;                                                                  \
     }
\ No newline at end of file
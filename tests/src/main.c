@@ -2,20 +2,172 @@
 
 #include "memory/linear_allocator_tests.h"
 #include "containers/hashtable_tests.h"
+#include "containers/flat_map_tests.h"
 #include "containers/freelist_tests.h"
 #include "memory/dynamic_allocator_tests.h"
+#include "containers/work_deque_tests.h"
+#include "containers/bitset_tests.h"
+#include "containers/darray_tests.h"
+#include "containers/ring_queue_tests.h"
+#include "containers/spsc_queue_tests.h"
+#include "containers/mpmc_queue_tests.h"
+#include "memory/pool_allocator_tests.h"
+#include "memory/slab_allocator_tests.h"
+#include "memory/frame_arena_tests.h"
+#include "memory/scratch_allocator_tests.h"
+#include "memory/host_allocator_tests.h"
+#include "containers/slot_map_tests.h"
+#include "core/event_tests.h"
+#include "core/input_tests.h"
+#include "core/logger_tests.h"
+#include "core/profiler_tests.h"
+#include "core/metrics_tests.h"
+#include "core/counters_tests.h"
+#include "core/benchmark_tests.h"
+#include "core/kcompress_tests.h"
+#include "core/kstring_tests.h"
+#include "core/startup_graph_tests.h"
+#include "core/identifier_tests.h"
+#include "math/kmath_tests.h"
+#include "math/transform_hierarchy_tests.h"
+#include "math/bvh_tests.h"
+#include "math/geometry_utils_tests.h"
+#include "math/skeleton_tests.h"
+#include "platform/platform_tests.h"
+#include "platform/filesystem_tests.h"
+#include "platform/async_io_tests.h"
+#include "platform/file_watcher_tests.h"
+#include "resources/asset_archive_tests.h"
+#include "resources/mesh_loader_tests.h"
+#include "resources/material_loader_tests.h"
+#include "resources/dependency_manifest_tests.h"
+#include "resources/world_stream_tests.h"
+#include "resources/texture_container_tests.h"
+#include "resources/texture_atlas_tests.h"
+#include "resources/font_lookup_tests.h"
+#include "resources/text_layout_cache_tests.h"
+#include "resources/resource_cache_tests.h"
+#include "resources/spirv_reflect_tests.h"
+#include "renderer/render_queue_tests.h"
+#include "renderer/ui_batch_tests.h"
+#include "renderer/debug_draw_tests.h"
+#include "renderer/particles_tests.h"
+#include "renderer/render_scene_tests.h"
+#include "renderer/render_graph_tests.h"
+#include "renderer/camera_tests.h"
+#include "renderer/light_clusters_tests.h"
+#include "renderer/resolution_scale_tests.h"
+#include "renderer/render_capture_tests.h"
+#include "systems/job_system_tests.h"
+#include "systems/light_system_tests.h"
+#include "systems/resource_system_tests.h"
 
+#include "math/kmath_benchmarks.h"
+#include "core/kstring_benchmarks.h"
+#include "containers/hashtable_benchmarks.h"
+#include "memory/allocator_benchmarks.h"
+#include "systems/job_system_benchmarks.h"
+
+#include <core/kstring.h>
 #include <core/logger.h>
 
-int main() {
+// The file benchmark results are written to when not given a path.
+#define TEST_BENCHMARK_DEFAULT_OUTPUT_PATH "test_benchmarks.json"
+
+/**
+ * Runs the tests, or with --bench[=prefix] the benchmarks instead, only those whose names start
+ * with the prefix if one is given. Results are written to --bench-output=path.
+ */
+int main(int argc, char** argv) {
     // Always initalize the test manager first.
     test_manager_init();
 
     // TODO: add test registrations here.
     linear_allocator_register_tests();
     hashtable_register_tests();
+    flat_map_register_tests();
     freelist_register_tests();
     dynamic_allocator_register_tests();
+    work_deque_register_tests();
+    bitset_register_tests();
+    darray_register_tests();
+    ring_queue_register_tests();
+    spsc_queue_register_tests();
+    mpmc_queue_register_tests();
+    pool_allocator_register_tests();
+    slab_allocator_register_tests();
+    frame_arena_register_tests();
+    scratch_allocator_register_tests();
+    host_allocator_register_tests();
+    slot_map_register_tests();
+    event_register_tests();
+    input_register_tests();
+    logger_register_tests();
+    profiler_register_tests();
+    metrics_register_tests();
+    counters_register_tests();
+    benchmark_register_tests();
+    kcompress_register_tests();
+    kstring_register_tests();
+    startup_graph_register_tests();
+    identifier_register_tests();
+    kmath_register_tests();
+    transform_hierarchy_register_tests();
+    bvh_register_tests();
+    geometry_utils_register_tests();
+    skeleton_register_tests();
+    platform_register_tests();
+    filesystem_register_tests();
+    async_io_register_tests();
+    file_watcher_register_tests();
+    asset_archive_register_tests();
+    mesh_loader_register_tests();
+    material_loader_register_tests();
+    dependency_manifest_register_tests();
+    world_stream_register_tests();
+    texture_container_register_tests();
+    texture_atlas_register_tests();
+    font_lookup_register_tests();
+    text_layout_cache_register_tests();
+    resource_cache_register_tests();
+    spirv_reflect_register_tests();
+    render_queue_register_tests();
+    ui_batch_register_tests();
+    debug_draw_register_tests();
+    particles_register_tests();
+    render_scene_register_tests();
+    render_graph_register_tests();
+    camera_register_tests();
+    light_clusters_register_tests();
+    resolution_scale_register_tests();
+    render_capture_register_tests();
+    job_system_register_tests();
+    light_system_register_tests();
+    resource_system_register_tests();
+
+    kmath_register_benchmarks();
+    kstring_register_benchmarks();
+    hashtable_register_benchmarks();
+    allocator_register_benchmarks();
+    job_system_register_benchmarks();
+
+    b8 run_benchmarks = false;
+    const char* benchmark_filter = 0;
+    const char* benchmark_output_path = TEST_BENCHMARK_DEFAULT_OUTPUT_PATH;
+    for (i32 i = 1; i < argc; ++i) {
+        if (strings_equal(argv[i], "--bench")) {
+            run_benchmarks = true;
+        } else if (strings_nequal(argv[i], "--bench=", 8)) {
+            run_benchmarks = true;
+            benchmark_filter = argv[i] + 8;
+        } else if (strings_nequal(argv[i], "--bench-output=", 15)) {
+            benchmark_output_path = argv[i] + 15;
+        }
+    }
+    if (run_benchmarks) {
+        KDEBUG("Starting benchmarks...");
+        return test_manager_run_benchmarks(benchmark_filter, benchmark_output_path) ? 0 : 1;
+    }
 
     KDEBUG("Starting tests...");
 
@@ -0,0 +1,226 @@
+#include "bvh_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <math/bvh.h>
+#include <math/geometry_utils.h>
+#include <math/kmath.h>
+
+#define BVH_TEST_BOX_COUNT 1000
+
+static void* tree_create(u32 capacity, f32 margin, bvh* out_tree, u64* out_size) {
+    bvh_create(capacity, margin, out_size, 0, 0);
+    void* memory = kallocate(*out_size, MEMORY_TAG_ARRAY);
+    bvh_create(capacity, margin, out_size, memory, out_tree);
+    return memory;
+}
+
+static extents_3d random_box(krandom_state* rng) {
+    vec3 center = {krandom_state_f32(rng) * 200.0f - 100.0f, krandom_state_f32(rng) * 200.0f - 100.0f, krandom_state_f32(rng) * 200.0f - 100.0f};
+    vec3 half_extents = {0.5f + krandom_state_f32(rng) * 2.0f, 0.5f + krandom_state_f32(rng) * 2.0f, 0.5f + krandom_state_f32(rng) * 2.0f};
+    extents_3d box = {vec3_sub(center, half_extents), vec3_add(center, half_extents)};
+    return box;
+}
+
+typedef struct found_set {
+    u8 found[BVH_TEST_BOX_COUNT];
+    u32 count;
+} found_set;
+
+static b8 found_mark(u32 leaf_id, u32 value, void* user_data) {
+    found_set* set = user_data;
+    set->found[value]++;
+    set->count++;
+    return true;
+}
+
+static b8 stop_at_first(u32 leaf_id, u32 value, void* user_data) {
+    (*(u32*)user_data)++;
+    return false;
+}
+
+// Each node bounds its children, and its height is one more than the taller of them.
+static b8 node_valid(const bvh* tree, u32 index, u32* out_leaf_count) {
+    const bvh_node* node = &tree->nodes[index];
+    if (node->child_a == INVALID_ID) {
+        (*out_leaf_count)++;
+        return node->height == 0;
+    }
+    const bvh_node* a = &tree->nodes[node->child_a];
+    const bvh_node* b = &tree->nodes[node->child_b];
+    if (a->parent != index || b->parent != index || node->height != 1 + KMAX(a->height, b->height)) {
+        return false;
+    }
+    for (u32 i = 0; i < 3; ++i) {
+        if (a->bounds.min.elements[i] < node->bounds.min.elements[i] || b->bounds.max.elements[i] > node->bounds.max.elements[i]) {
+            return false;
+        }
+    }
+    return node_valid(tree, node->child_a, out_leaf_count) && node_valid(tree, node->child_b, out_leaf_count);
+}
+
+u8 bvh_should_stay_valid_and_balanced() {
+    bvh tree;
+    u64 size = 0;
+    void* memory = tree_create(BVH_TEST_BOX_COUNT, 0.1f, &tree, &size);
+    krandom_state rng;
+    krandom_state_seed(&rng, 1);
+
+    u32 ids[BVH_TEST_BOX_COUNT];
+    for (u32 i = 0; i < BVH_TEST_BOX_COUNT; ++i) {
+        ids[i] = bvh_insert(&tree, random_box(&rng), i);
+        expect_should_not_be(INVALID_ID, ids[i]);
+    }
+    expect_should_be(INVALID_ID, bvh_insert(&tree, random_box(&rng), 0));
+
+    // Remove every other leaf, then move the rest far enough to be reinserted.
+    for (u32 i = 0; i < BVH_TEST_BOX_COUNT; i += 2) {
+        expect_to_be_true(bvh_remove(&tree, ids[i]));
+    }
+    expect_to_be_false(bvh_remove(&tree, ids[0]));
+    for (u32 i = 1; i < BVH_TEST_BOX_COUNT; i += 2) {
+        expect_to_be_true(bvh_move(&tree, ids[i], random_box(&rng)));
+        expect_should_be(i, bvh_value_get(&tree, ids[i]));
+    }
+
+    u32 leaf_count = 0;
+    expect_to_be_true(node_valid(&tree, tree.root, &leaf_count));
+    expect_should_be(BVH_TEST_BOX_COUNT / 2, leaf_count);
+    expect_should_be(BVH_TEST_BOX_COUNT / 2, tree.leaf_count);
+    // 500 leaves is at least 9 deep; the balancing keeps it within twice that.
+    expect_to_be_true(tree.nodes[tree.root].height <= 18);
+
+    bvh_destroy(&tree);
+    kfree(memory, size, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 bvh_should_only_reinsert_beyond_margin() {
+    bvh tree;
+    u64 size = 0;
+    void* memory = tree_create(4, 1.0f, &tree, &size);
+
+    extents_3d box = {{-1.0f, -1.0f, -1.0f}, {1.0f, 1.0f, 1.0f}};
+    u32 id = bvh_insert(&tree, box, 7);
+
+    // Within the margin, only the box changes.
+    extents_3d nudged = {{-0.5f, -1.0f, -1.0f}, {1.5f, 1.0f, 1.0f}};
+    expect_to_be_false(bvh_move(&tree, id, nudged));
+    expect_float_to_be(1.5f, tree.nodes[id].tight.max.x);
+
+    extents_3d moved = {{9.0f, -1.0f, -1.0f}, {11.0f, 1.0f, 1.0f}};
+    expect_to_be_true(bvh_move(&tree, id, moved));
+    expect_float_to_be(12.0f, tree.nodes[id].bounds.max.x);
+
+    bvh_destroy(&tree);
+    kfree(memory, size, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 bvh_frustum_query_should_match_brute_force() {
+    bvh tree;
+    u64 size = 0;
+    void* memory = tree_create(BVH_TEST_BOX_COUNT, 0.0f, &tree, &size);
+    krandom_state rng;
+    krandom_state_seed(&rng, 2);
+
+    extents_3d boxes[BVH_TEST_BOX_COUNT];
+    for (u32 i = 0; i < BVH_TEST_BOX_COUNT; ++i) {
+        boxes[i] = random_box(&rng);
+        bvh_insert(&tree, boxes[i], i);
+    }
+
+    vec3 position = {0, 0, 0};
+    vec3 forward = {0, 0, -1};
+    vec3 right = {1, 0, 0};
+    vec3 up = {0, 1, 0};
+    frustum f = frustom_create(&position, &forward, &right, &up, 16.0f / 9.0f, deg_to_rad(45.0f), 0.1f, 100.0f);
+
+    found_set set;
+    kzero_memory(&set, sizeof(found_set));
+    bvh_query_frustum(&tree, &f, found_mark, &set);
+
+    u32 expected_count = 0;
+    for (u32 i = 0; i < BVH_TEST_BOX_COUNT; ++i) {
+        vec3 center = extents_3d_center(boxes[i]);
+        vec3 half_extents = extents_3d_half_extents(boxes[i]);
+        b8 visible = frustum_intersects_aabb(&f, &center, &half_extents);
+        expect_should_be(visible ? 1 : 0, set.found[i]);
+        expected_count += visible;
+    }
+    expect_should_be(expected_count, set.count);
+    expect_to_be_true(expected_count > 0 && expected_count < BVH_TEST_BOX_COUNT);
+
+    // Queries end when the callback says so.
+    u32 calls = 0;
+    bvh_query_frustum(&tree, &f, stop_at_first, &calls);
+    expect_should_be(1, calls);
+
+    bvh_destroy(&tree);
+    kfree(memory, size, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 bvh_extents_and_ray_queries_should_match_brute_force() {
+    bvh tree;
+    u64 size = 0;
+    void* memory = tree_create(BVH_TEST_BOX_COUNT, 0.0f, &tree, &size);
+    krandom_state rng;
+    krandom_state_seed(&rng, 3);
+
+    extents_3d boxes[BVH_TEST_BOX_COUNT];
+    for (u32 i = 0; i < BVH_TEST_BOX_COUNT; ++i) {
+        boxes[i] = random_box(&rng);
+        bvh_insert(&tree, boxes[i], i);
+    }
+
+    extents_3d range = {{-20.0f, -20.0f, -20.0f}, {20.0f, 20.0f, 20.0f}};
+    found_set set;
+    kzero_memory(&set, sizeof(found_set));
+    bvh_query_extents(&tree, range, found_mark, &set);
+    for (u32 i = 0; i < BVH_TEST_BOX_COUNT; ++i) {
+        b8 overlaps = boxes[i].min.x <= range.max.x && boxes[i].max.x >= range.min.x && boxes[i].min.y <= range.max.y &&
+                      boxes[i].max.y >= range.min.y && boxes[i].min.z <= range.max.z && boxes[i].max.z >= range.min.z;
+        expect_should_be(overlaps ? 1 : 0, set.found[i]);
+    }
+
+    // Rays from outside at boxes, so each hits at least one.
+    for (u32 k = 0; k < 16; ++k) {
+        vec3 origin = {-150.0f, krandom_state_f32(&rng) * 40.0f - 20.0f, krandom_state_f32(&rng) * 40.0f - 20.0f};
+        ray r = {origin, vec3_normalized(vec3_sub(extents_3d_center(boxes[k * 37]), origin))};
+
+        u32 nearest = INVALID_ID;
+        f32 nearest_distance = 1000.0f;
+        kzero_memory(&set, sizeof(found_set));
+        bvh_query_ray(&tree, r, 1000.0f, found_mark, &set);
+        for (u32 i = 0; i < BVH_TEST_BOX_COUNT; ++i) {
+            f32 distance = 0.0f;
+            b8 hit = ray_intersects_extents(r, boxes[i], &distance) && distance <= 1000.0f;
+            expect_should_be(hit ? 1 : 0, set.found[i]);
+            if (hit && distance < nearest_distance) {
+                nearest = i;
+                nearest_distance = distance;
+            }
+        }
+
+        f32 distance = 0.0f;
+        u32 leaf = bvh_raycast(&tree, r, 1000.0f, &distance);
+        expect_should_not_be(INVALID_ID, nearest);
+        expect_should_be(nearest, bvh_value_get(&tree, leaf));
+        expect_float_to_be(nearest_distance, distance);
+    }
+
+    bvh_destroy(&tree);
+    kfree(memory, size, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+void bvh_register_tests() {
+    test_manager_register_test(bvh_should_stay_valid_and_balanced, "BVH should stay valid and balanced");
+    test_manager_register_test(bvh_should_only_reinsert_beyond_margin, "BVH should only reinsert leaves moved beyond the margin");
+    test_manager_register_test(bvh_frustum_query_should_match_brute_force, "BVH frustum query should match brute force");
+    test_manager_register_test(bvh_extents_and_ray_queries_should_match_brute_force, "BVH extents and ray queries should match brute force");
+}
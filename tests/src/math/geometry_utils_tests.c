@@ -0,0 +1,576 @@
+#include "geometry_utils_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <math/kmath.h>
+#include <math/geometry_utils.h>
+
+u8 half_conversion_should_round_trip_and_round() {
+    // Values a half holds exactly come back exactly.
+    f32 exact[] = {0.0f, 1.0f, -2.0f, 0.5f, 1024.0f, 65504.0f, 0.000061035156f, 0.000000059604645f};
+    for (u32 i = 0; i < sizeof(exact) / sizeof(f32); ++i) {
+        expect_to_be_true((half_to_f32(f32_to_half(exact[i])) == exact[i]));
+    }
+    expect_should_be(0x3C00, f32_to_half(1.0f));
+    expect_should_be(0xC000, f32_to_half(-2.0f));
+
+    // Halfway between 1 and the next half, which rounds to the even one, 1.
+    expect_should_be(0x3C00, f32_to_half(1.0f + 1.0f / 2048.0f));
+    // Just past halfway rounds up.
+    expect_should_be(0x3C01, f32_to_half(1.0f + 1.0f / 2048.0f + 1.0f / 65536.0f));
+
+    // Too large becomes infinity, and NaN stays NaN.
+    expect_should_be(0x7C00, f32_to_half(70000.0f));
+    expect_should_be(0xFC00, f32_to_half(-70000.0f));
+    u16 nan = f32_to_half(0.0f / 0.0f);
+    expect_to_be_true(((nan & 0x7C00) == 0x7C00 && (nan & 0x3FF) != 0));
+
+    // Every half survives a round trip through f32.
+    for (u32 bits = 0; bits < 0x7C00; ++bits) {
+        expect_should_be(bits, f32_to_half(half_to_f32((u16)bits)));
+    }
+    return true;
+}
+
+u8 octahedral_encoding_should_preserve_direction() {
+    vec3 axes[6] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+    for (u32 i = 0; i < 6; ++i) {
+        vec3 decoded = octahedral_snorm16_to_vec3(vec3_to_octahedral_snorm16(axes[i]));
+        expect_to_be_true((vec3_dot(decoded, axes[i]) > 0.99999f));
+    }
+
+    // A fixed sequence of directions covering every octant.
+    u32 seed = 7;
+    for (u32 i = 0; i < 10000; ++i) {
+        vec3 v;
+        for (u32 j = 0; j < 3; ++j) {
+            seed = seed * 1664525u + 1013904223u;
+            v.elements[j] = (seed >> 8) / 8388608.0f - 1.0f;
+        }
+        if (vec3_length(v) < 0.01f) {
+            continue;
+        }
+        v = vec3_normalized(v);
+        vec3 decoded = octahedral_snorm16_to_vec3(vec3_to_octahedral_snorm16(v));
+        // Within 0.01 degrees, measured by the sine of the angle as a dot product near 1 is too coarse.
+        expect_to_be_true((vec3_length(vec3_cross(decoded, v)) < 0.000175f));
+    }
+    return true;
+}
+
+u8 vertex_pack_should_round_trip() {
+    expect_should_be(28, sizeof(vertex_3d_packed));
+
+    vertex_3d vertex;
+    vertex.position = (vec3){1.5f, -2.25f, 100.0f};
+    vertex.normal = vec3_normalized((vec3){0.3f, -0.8f, -0.2f});
+    vertex.texcoord = (vec2){0.25f, 3.75f};
+    vertex.colour = (vec4){1.0f, 0.5f, 0.0f, 0.2f};
+    vertex.tangent = vec3_normalized((vec3){-0.5f, 0.1f, 0.9f});
+
+    vertex_3d_packed packed = vertex_3d_pack(&vertex);
+    vertex_3d unpacked = vertex_3d_unpack(&packed);
+    expect_to_be_true(vec3_compare(vertex.position, unpacked.position, 0.0f));
+    expect_to_be_true((vec3_dot(vertex.normal, unpacked.normal) > 0.9999f));
+    expect_to_be_true((vec3_dot(vertex.tangent, unpacked.tangent) > 0.9999f));
+    expect_float_to_be(0.25f, unpacked.texcoord.x);
+    expect_float_to_be(3.75f, unpacked.texcoord.y);
+    for (u32 i = 0; i < 4; ++i) {
+        expect_to_be_true((kabs(vertex.colour.elements[i] - unpacked.colour.elements[i]) <= 0.5f / 255.0f + 1e-6f));
+    }
+    // Red in the low byte, as a unorm8x4 attribute reads it.
+    expect_should_be(0xFF, (packed.colour & 0xFF));
+    return true;
+}
+
+u8 skinned_vertex_pack_should_keep_heaviest_weights() {
+    expect_should_be(36, sizeof(vertex_3d_skinned));
+
+    vertex_3d vertex;
+    kzero_memory(&vertex, sizeof(vertex_3d));
+    vertex.position = (vec3){1.0f, 2.0f, 3.0f};
+    vertex.normal = (vec3){0.0f, 1.0f, 0.0f};
+    vertex.tangent = (vec3){1.0f, 0.0f, 0.0f};
+
+    // The lightest of six is dropped, and the rest are normalized over what is kept.
+    u32 joints[6] = {7, 3, 9, 12, 40, 2};
+    f32 weights[6] = {0.05f, 0.4f, 0.1f, 0.2f, 0.2f, 0.05f};
+    vertex_3d_skinned skinned = vertex_3d_skinned_pack(&vertex, 6, joints, weights);
+    expect_to_be_true(vec3_compare(vertex.position, skinned.vertex.position, 0.0f));
+    expect_should_be(3, skinned.joints[0]);
+    expect_should_be(9, skinned.joints[3]);
+    u32 total = 0;
+    for (u32 i = 0; i < VERTEX_MAX_JOINT_INFLUENCES; ++i) {
+        total += skinned.weights[i];
+    }
+    expect_should_be(255, total);
+    expect_to_be_true((kabs(skinned.weights[0] / 255.0f - 0.4f / 0.9f) <= 1.5f / 255.0f));
+
+    // Fewer influences leave the rest unweighted.
+    skinned = vertex_3d_skinned_pack(&vertex, 2, joints, weights);
+    expect_should_be(3, skinned.joints[0]);
+    expect_should_be(7, skinned.joints[1]);
+    expect_should_be(255, skinned.weights[0] + skinned.weights[1]);
+    expect_should_be(0, skinned.weights[2]);
+
+    // No weight at all binds the vertex to its first joint.
+    f32 none[1] = {0.0f};
+    skinned = vertex_3d_skinned_pack(&vertex, 1, &joints[2], none);
+    expect_should_be(9, skinned.joints[0]);
+    expect_should_be(255, skinned.weights[0]);
+    return true;
+}
+
+// Whether the extents contain the point, allowing for rounding.
+static b8 extents_contain(extents_3d e, vec3 p) {
+    for (u32 i = 0; i < 3; ++i) {
+        if (p.elements[i] < e.min.elements[i] - 1e-4f || p.elements[i] > e.max.elements[i] + 1e-4f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+u8 extents_transform_should_enclose_rotated_corners() {
+    extents_3d local = {{-1.0f, -2.0f, -0.5f}, {3.0f, 1.0f, 0.5f}};
+    quat rotation = quat_from_axis_angle(vec3_normalized((vec3){1.0f, 2.0f, 3.0f}), 0.7f, false);
+    mat4 m = mat4_mul(mat4_mul(mat4_scale((vec3){2.0f, 1.0f, 3.0f}), quat_to_mat4(rotation)), mat4_translation((vec3){10.0f, -5.0f, 2.0f}));
+
+    extents_3d world = extents_3d_transform(local, m);
+    vec3 corners[8];
+    for (u32 i = 0; i < 8; ++i) {
+        vec3 corner = {
+            (i & 1) ? local.max.x : local.min.x,
+            (i & 2) ? local.max.y : local.min.y,
+            (i & 4) ? local.max.z : local.min.z};
+        corners[i] = vec3_mul_mat4(corner, m);
+        expect_to_be_true(extents_contain(world, corners[i]));
+    }
+    // And is no larger than the corners need, as the enclosing box of a box is tight.
+    extents_3d expected = extents_3d_from_points(8, corners);
+    expect_to_be_true(vec3_compare(world.min, expected.min, 1e-4f));
+    expect_to_be_true(vec3_compare(world.max, expected.max, 1e-4f));
+
+    // The oriented box encloses the same corners.
+    oriented_box box = oriented_box_from_extents(local, m);
+    extents_3d box_extents = oriented_box_extents(&box);
+    expect_to_be_true(vec3_compare(box_extents.min, expected.min, 1e-4f));
+    expect_to_be_true(vec3_compare(box_extents.max, expected.max, 1e-4f));
+    return true;
+}
+
+u8 bounding_volumes_should_merge_and_enclose() {
+    extents_3d a = {{0, 0, 0}, {1, 1, 1}};
+    extents_3d b = {{-2, 0.5f, 0.5f}, {0.5f, 3, 0.75f}};
+    extents_3d merged = extents_3d_merge(a, b);
+    expect_to_be_true(vec3_compare(merged.min, (vec3){-2, 0, 0}, 0.0f));
+    expect_to_be_true(vec3_compare(merged.max, (vec3){1, 3, 1}, 0.0f));
+
+    bounding_sphere sphere = bounding_sphere_from_extents(a);
+    expect_float_to_be(0.5f, sphere.center.x);
+    expect_float_to_be(ksqrt(0.75f), sphere.radius);
+
+    // A non-uniform scale grows the radius by the largest scale.
+    bounding_sphere scaled = bounding_sphere_transform((bounding_sphere){{1, 0, 0}, 1.0f}, mat4_mul(mat4_scale((vec3){1, 4, 2}), mat4_translation((vec3){0, 1, 0})));
+    expect_float_to_be(4.0f, scaled.radius);
+    expect_to_be_true(vec3_compare(scaled.center, (vec3){1, 1, 0}, 1e-5f));
+
+    // Apart, the merged sphere touches the far side of both.
+    bounding_sphere left = {{-3, 0, 0}, 1.0f};
+    bounding_sphere right = {{2, 0, 0}, 2.0f};
+    bounding_sphere both = bounding_sphere_merge(left, right);
+    expect_float_to_be(4.0f, both.radius);
+    expect_float_to_be(0.0f, both.center.x);
+    // One inside the other merges to the outer one.
+    bounding_sphere inner = {{2.5f, 0, 0}, 0.5f};
+    both = bounding_sphere_merge(inner, right);
+    expect_float_to_be(2.0f, both.radius);
+    expect_float_to_be(2.0f, both.center.x);
+    return true;
+}
+
+u8 ray_should_hit_extents_in_front_and_miss_others() {
+    extents_3d box = {{-1, -1, -1}, {1, 1, 1}};
+    f32 distance = 0;
+
+    // Straight at the box from in front enters at its near face.
+    expect_to_be_true(ray_intersects_extents((ray){{0, 0, 5}, {0, 0, -1}}, box, &distance));
+    expect_float_to_be(4.0f, distance);
+    // Starting inside hits at once.
+    expect_to_be_true(ray_intersects_extents((ray){{0.5f, 0, 0}, {1, 0, 0}}, box, &distance));
+    expect_float_to_be(0.0f, distance);
+    // Behind the ray, beside it, and parallel to a face outside it all miss.
+    expect_to_be_false(ray_intersects_extents((ray){{0, 0, 5}, {0, 0, 1}}, box, 0));
+    expect_to_be_false(ray_intersects_extents((ray){{3, 0, 5}, {0, 0, -1}}, box, 0));
+    expect_to_be_false(ray_intersects_extents((ray){{0, 2, 5}, {0.6f, 0, -0.8f}}, box, 0));
+    return true;
+}
+
+u8 ray_from_screen_should_pass_through_the_cursor() {
+    mat4 projection = mat4_perspective(deg_to_rad(90.0f), 1.0f, 0.1f, 100.0f);
+    // A camera at z 10 looking down -z.
+    mat4 view = mat4_inverse(mat4_translation((vec3){0, 0, 10}));
+
+    // The center of the screen looks straight ahead.
+    ray center = ray_from_screen(50.0f, 50.0f, 100.0f, 100.0f, view, projection);
+    expect_to_be_true(vec3_compare(center.direction, (vec3){0, 0, -1}, 1e-4f));
+    expect_float_to_be(10.0f - 0.1f, center.origin.z);
+
+    // The top right corner is up and to the right, 45 degrees out on each axis with this field of view.
+    ray corner = ray_from_screen(100.0f, 0.0f, 100.0f, 100.0f, view, projection);
+    expect_to_be_true((corner.direction.x > 0.0f && corner.direction.y > 0.0f));
+    expect_float_to_be(corner.direction.x, -corner.direction.z);
+    expect_float_to_be(corner.direction.y, -corner.direction.z);
+    return true;
+}
+
+// The tangent of one triangle as the engine has always generated it, for comparison.
+static vec3 reference_triangle_tangent(const vertex_3d* v0, const vertex_3d* v1, const vertex_3d* v2) {
+    vec3 edge1 = vec3_sub(v1->position, v0->position);
+    vec3 edge2 = vec3_sub(v2->position, v0->position);
+    f32 delta_u1 = v1->texcoord.x - v0->texcoord.x;
+    f32 delta_v1 = v1->texcoord.y - v0->texcoord.y;
+    f32 delta_u2 = v2->texcoord.x - v0->texcoord.x;
+    f32 delta_v2 = v2->texcoord.y - v0->texcoord.y;
+    f32 fc = 1.0f / (delta_u1 * delta_v2 - delta_u2 * delta_v1);
+    vec3 tangent = vec3_normalized(vec3_mul_scalar(vec3_sub(vec3_mul_scalar(edge1, delta_v2), vec3_mul_scalar(edge2, delta_v1)), fc));
+    f32 handedness = ((delta_v1 * delta_u2 - delta_v2 * delta_u1) < 0.0f) ? -1.0f : 1.0f;
+    return vec3_mul_scalar(tangent, handedness);
+}
+
+#define TRIANGLE_SOUP_COUNT 5001
+
+u8 generated_tangents_should_match_per_triangle_reference() {
+    // Enough unshared triangles to be split into batches and run four at a time, with a remainder.
+    vertex_3d* vertices = kallocate(sizeof(vertex_3d) * TRIANGLE_SOUP_COUNT * 3, MEMORY_TAG_ARRAY);
+    u32* indices = kallocate(sizeof(u32) * TRIANGLE_SOUP_COUNT * 3, MEMORY_TAG_ARRAY);
+    u32 seed = 11;
+    for (u32 i = 0; i < TRIANGLE_SOUP_COUNT * 3; ++i) {
+        f32 values[5];
+        for (u32 j = 0; j < 5; ++j) {
+            seed = seed * 1664525u + 1013904223u;
+            values[j] = (seed >> 8) / 16777216.0f;
+        }
+        vertices[i].position = (vec3){values[0] * 10.0f, values[1] * 10.0f, values[2] * 10.0f};
+        vertices[i].texcoord = (vec2){values[3], values[4]};
+        indices[i] = i;
+    }
+
+    geometry_generate_normals(TRIANGLE_SOUP_COUNT * 3, vertices, TRIANGLE_SOUP_COUNT * 3, indices);
+    geometry_generate_tangents(TRIANGLE_SOUP_COUNT * 3, vertices, TRIANGLE_SOUP_COUNT * 3, indices);
+
+    for (u32 t = 0; t < TRIANGLE_SOUP_COUNT; ++t) {
+        vertex_3d* v = &vertices[t * 3];
+        vec3 face_normal = vec3_normalized(vec3_cross(vec3_sub(v[1].position, v[0].position), vec3_sub(v[2].position, v[0].position)));
+        vec3 expected = reference_triangle_tangent(&v[0], &v[1], &v[2]);
+        for (u32 c = 0; c < 3; ++c) {
+            expect_to_be_true(vec3_compare(v[c].normal, face_normal, 1e-4f));
+            // Thin triangles lose precision either way, so compare by angle.
+            expect_to_be_true((vec3_dot(v[c].tangent, expected) > 0.999f));
+        }
+    }
+
+    kfree(vertices, sizeof(vertex_3d) * TRIANGLE_SOUP_COUNT * 3, MEMORY_TAG_ARRAY);
+    kfree(indices, sizeof(u32) * TRIANGLE_SOUP_COUNT * 3, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 generated_normals_and_tangents_should_be_shared() {
+    // Two triangles folded along the y axis, like a tent, sharing their edge.
+    vertex_3d vertices[4] = {0};
+    vertices[0].position = (vec3){0, 0, 0};
+    vertices[1].position = (vec3){0, 1, 0};
+    vertices[2].position = (vec3){-1, 0, 1};
+    vertices[3].position = (vec3){1, 0, 1};
+    vertices[0].texcoord = (vec2){0.5f, 0};
+    vertices[1].texcoord = (vec2){0.5f, 1};
+    vertices[2].texcoord = (vec2){0, 0};
+    vertices[3].texcoord = (vec2){1, 0};
+    u32 indices[6] = {0, 1, 2, 0, 3, 1};
+
+    geometry_generate_normals(4, vertices, 6, indices);
+    geometry_generate_tangents(4, vertices, 6, indices);
+
+    // The shared vertices point out of the ridge.
+    expect_to_be_true(vec3_compare(vertices[0].normal, (vec3){0, 0, 1}, 1e-5f));
+    expect_to_be_true(vec3_compare(vertices[1].normal, (vec3){0, 0, 1}, 1e-5f));
+    // The others keep their own triangle's normal.
+    expect_to_be_true(vec3_compare(vertices[2].normal, vec3_normalized((vec3){1, 0, 1}), 1e-5f));
+    for (u32 i = 0; i < 4; ++i) {
+        expect_float_to_be(1.0f, vec3_length(vertices[i].tangent));
+        expect_float_to_be(0.0f, vec3_dot(vertices[i].tangent, vertices[i].normal));
+    }
+    // u increases along x on both triangles, so the shared tangent is the negated x axis, as the shaders expect.
+    expect_to_be_true(vec3_compare(vertices[0].tangent, (vec3){-1, 0, 0}, 1e-5f));
+    return true;
+}
+
+u8 weld_vertices_should_merge_duplicates_and_remap_indices() {
+    // A quad as two triangles of unshared vertices, as the OBJ importer builds them.
+    vertex_3d corners[4] = {0};
+    corners[0].position = (vec3){0, 0, 0};
+    corners[1].position = (vec3){1, 0, 0};
+    corners[2].position = (vec3){1, 1, 0};
+    corners[3].position = (vec3){0, 1, 0};
+    u32 corner_order[6] = {0, 1, 2, 0, 2, 3};
+    vertex_3d vertices[6];
+    u32 indices[6];
+    for (u32 i = 0; i < 6; ++i) {
+        vertices[i] = corners[corner_order[i]];
+        indices[i] = i;
+    }
+    // Negative zero is the same position as zero.
+    vertices[3].position.x = -0.0f;
+
+    u32 unique_count = 0;
+    vertex_3d* unique = 0;
+    geometry_deduplicate_vertices(6, vertices, 6, indices, &unique_count, &unique);
+    expect_should_be(4, unique_count);
+    for (u32 i = 0; i < 6; ++i) {
+        expect_to_be_true(vec3_compare(unique[indices[i]].position, corners[corner_order[i]].position, 0.0f));
+    }
+    // In the order first seen.
+    expect_should_be(0, indices[3]);
+    expect_should_be(2, indices[4]);
+    expect_should_be(3, indices[5]);
+    kfree(unique, sizeof(vertex_3d) * unique_count, MEMORY_TAG_ARRAY);
+
+    // Nearly the same position only merges given an epsilon, and other attributes must still match.
+    vertex_3d near[3] = {0};
+    near[0].position = (vec3){0.5001f, 2.0003f, -1.0004f};
+    near[1].position = (vec3){0.5002f, 2.0001f, -1.0009f};
+    near[2].position = near[1].position;
+    near[2].texcoord = (vec2){0.5f, 0};
+    u32 near_indices[3] = {0, 1, 2};
+    geometry_deduplicate_vertices(3, near, 3, near_indices, &unique_count, &unique);
+    expect_should_be(3, unique_count);
+    kfree(unique, sizeof(vertex_3d) * unique_count, MEMORY_TAG_ARRAY);
+
+    u32 welded_indices[3] = {0, 1, 2};
+    geometry_weld_vertices(3, near, 3, welded_indices, 0.001f, 0.0f, &unique_count, &unique);
+    expect_should_be(2, unique_count);
+    expect_should_be(0, welded_indices[1]);
+    expect_should_be(1, welded_indices[2]);
+    expect_float_to_be(0.5001f, unique[0].position.x);
+    kfree(unique, sizeof(vertex_3d) * unique_count, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+#define OPTIMIZE_GRID_SIZE 60
+#define OPTIMIZE_VERTEX_COUNT ((OPTIMIZE_GRID_SIZE + 1) * (OPTIMIZE_GRID_SIZE + 1))
+#define OPTIMIZE_INDEX_COUNT (OPTIMIZE_GRID_SIZE * OPTIMIZE_GRID_SIZE * 6)
+
+// Sums a value per triangle which is the same whichever corner it starts at, to check triangles survive reordering.
+static u64 triangles_checksum(const vertex_3d* vertices, const u32* indices, u32 index_count) {
+    u64 sum = 0;
+    for (u32 i = 0; i < index_count; i += 3) {
+        u64 corners[3];
+        for (u32 c = 0; c < 3; ++c) {
+            vec3 p = vertices[indices[i + c]].position;
+            corners[c] = (u64)(p.x * 1000.0f) * 1000003ull + (u64)(p.y * 1000.0f);
+        }
+        // Winding matters, so pair each corner with the next.
+        for (u32 c = 0; c < 3; ++c) {
+            u64 pair = corners[c] * 31ull + corners[(c + 1) % 3];
+            sum += pair * pair;
+        }
+    }
+    return sum;
+}
+
+u8 optimize_indices_should_lower_acmr_and_keep_triangles() {
+    u32 one_triangle[3] = {0, 1, 2};
+    expect_float_to_be(3.0f, geometry_acmr(3, 3, one_triangle, GEOMETRY_VERTEX_CACHE_SIZE));
+
+    vertex_3d* vertices = kallocate(sizeof(vertex_3d) * OPTIMIZE_VERTEX_COUNT, MEMORY_TAG_ARRAY);
+    u32* indices = kallocate(sizeof(u32) * OPTIMIZE_INDEX_COUNT, MEMORY_TAG_ARRAY);
+    for (u32 y = 0; y <= OPTIMIZE_GRID_SIZE; ++y) {
+        for (u32 x = 0; x <= OPTIMIZE_GRID_SIZE; ++x) {
+            vertices[y * (OPTIMIZE_GRID_SIZE + 1) + x].position = (vec3){(f32)x, (f32)y, 0};
+        }
+    }
+    u32 index = 0;
+    for (u32 y = 0; y < OPTIMIZE_GRID_SIZE; ++y) {
+        for (u32 x = 0; x < OPTIMIZE_GRID_SIZE; ++x) {
+            u32 v = y * (OPTIMIZE_GRID_SIZE + 1) + x;
+            u32 quad[6] = {v, v + 1, v + OPTIMIZE_GRID_SIZE + 2, v, v + OPTIMIZE_GRID_SIZE + 2, v + OPTIMIZE_GRID_SIZE + 1};
+            for (u32 i = 0; i < 6; ++i) {
+                indices[index++] = quad[i];
+            }
+        }
+    }
+    // Shuffle the triangles, as an unordered import might leave them.
+    u32 seed = 5;
+    for (u32 t = OPTIMIZE_INDEX_COUNT / 3 - 1; t > 0; --t) {
+        seed = seed * 1664525u + 1013904223u;
+        u32 other = (seed >> 8) % (t + 1);
+        for (u32 c = 0; c < 3; ++c) {
+            u32 temp = indices[t * 3 + c];
+            indices[t * 3 + c] = indices[other * 3 + c];
+            indices[other * 3 + c] = temp;
+        }
+    }
+    u64 checksum = triangles_checksum(vertices, indices, OPTIMIZE_INDEX_COUNT);
+    f32 shuffled_acmr = geometry_acmr(OPTIMIZE_VERTEX_COUNT, OPTIMIZE_INDEX_COUNT, indices, GEOMETRY_VERTEX_CACHE_SIZE);
+    expect_to_be_true((shuffled_acmr > 2.0f));
+
+    geometry_optimize_vertex_cache(OPTIMIZE_VERTEX_COUNT, OPTIMIZE_INDEX_COUNT, indices, GEOMETRY_VERTEX_CACHE_SIZE);
+    f32 optimized_acmr = geometry_acmr(OPTIMIZE_VERTEX_COUNT, OPTIMIZE_INDEX_COUNT, indices, GEOMETRY_VERTEX_CACHE_SIZE);
+    // Better than drawing the grid row by row, which shades each vertex twice, so 1 per triangle.
+    expect_to_be_true((optimized_acmr < 0.9f));
+    expect_should_be(checksum, triangles_checksum(vertices, indices, OPTIMIZE_INDEX_COUNT));
+
+    // Reordering clusters only costs a little.
+    geometry_optimize_overdraw(OPTIMIZE_VERTEX_COUNT, vertices, OPTIMIZE_INDEX_COUNT, indices, GEOMETRY_VERTEX_CACHE_SIZE);
+    expect_to_be_true((geometry_acmr(OPTIMIZE_VERTEX_COUNT, OPTIMIZE_INDEX_COUNT, indices, GEOMETRY_VERTEX_CACHE_SIZE) < optimized_acmr + 0.05f));
+    expect_should_be(checksum, triangles_checksum(vertices, indices, OPTIMIZE_INDEX_COUNT));
+
+    // Vertices end up in the order they are first used.
+    geometry_optimize_vertex_fetch(OPTIMIZE_VERTEX_COUNT, vertices, OPTIMIZE_INDEX_COUNT, indices);
+    expect_should_be(checksum, triangles_checksum(vertices, indices, OPTIMIZE_INDEX_COUNT));
+    u32 next = 0;
+    for (u32 i = 0; i < OPTIMIZE_INDEX_COUNT; ++i) {
+        expect_to_be_true((indices[i] <= next));
+        if (indices[i] == next) {
+            next++;
+        }
+    }
+    expect_should_be(OPTIMIZE_VERTEX_COUNT, next);
+
+    kfree(vertices, sizeof(vertex_3d) * OPTIMIZE_VERTEX_COUNT, MEMORY_TAG_ARRAY);
+    kfree(indices, sizeof(u32) * OPTIMIZE_INDEX_COUNT, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+#define SIMPLIFY_GRID_SIZE 20
+#define SIMPLIFY_VERTEX_COUNT ((SIMPLIFY_GRID_SIZE + 1) * (SIMPLIFY_GRID_SIZE + 1))
+#define SIMPLIFY_INDEX_COUNT (SIMPLIFY_GRID_SIZE * SIMPLIFY_GRID_SIZE * 6)
+
+u8 simplify_should_reduce_flat_grid_and_keep_border() {
+    vertex_3d vertices[SIMPLIFY_VERTEX_COUNT] = {0};
+    u32 indices[SIMPLIFY_INDEX_COUNT];
+    u32 simplified[SIMPLIFY_INDEX_COUNT];
+    for (u32 y = 0; y <= SIMPLIFY_GRID_SIZE; ++y) {
+        for (u32 x = 0; x <= SIMPLIFY_GRID_SIZE; ++x) {
+            vertices[y * (SIMPLIFY_GRID_SIZE + 1) + x].position = (vec3){(f32)x, (f32)y, 0};
+        }
+    }
+    u32 index = 0;
+    for (u32 y = 0; y < SIMPLIFY_GRID_SIZE; ++y) {
+        for (u32 x = 0; x < SIMPLIFY_GRID_SIZE; ++x) {
+            u32 v = y * (SIMPLIFY_GRID_SIZE + 1) + x;
+            u32 quad[6] = {v, v + 1, v + SIMPLIFY_GRID_SIZE + 2, v, v + SIMPLIFY_GRID_SIZE + 2, v + SIMPLIFY_GRID_SIZE + 1};
+            for (u32 i = 0; i < 6; ++i) {
+                indices[index++] = quad[i];
+            }
+        }
+    }
+
+    // Flat, so it can lose most of its triangles for no error. The border has 80 edges, so it needs at least 78 triangles.
+    f32 error = 1.0f;
+    u32 count = geometry_simplify(SIMPLIFY_VERTEX_COUNT, vertices, SIMPLIFY_INDEX_COUNT, indices, SIMPLIFY_INDEX_COUNT / 4, 0.01f, simplified, &error);
+    expect_to_be_true((count <= SIMPLIFY_INDEX_COUNT / 4));
+    expect_to_be_true((count > 0));
+    expect_float_to_be(0.0f, error);
+
+    b8 used[SIMPLIFY_VERTEX_COUNT] = {0};
+    f32 area = 0.0f;
+    for (u32 i = 0; i < count; i += 3) {
+        vec3 p0 = vertices[simplified[i]].position;
+        vec3 normal = vec3_cross(vec3_sub(vertices[simplified[i + 1]].position, p0), vec3_sub(vertices[simplified[i + 2]].position, p0));
+        // Nothing turned over.
+        expect_to_be_true((normal.z >= 0.0f));
+        area += normal.z * 0.5f;
+        for (u32 c = 0; c < 3; ++c) {
+            used[simplified[i + c]] = true;
+        }
+    }
+    // No holes, and the border stays where it was.
+    expect_float_to_be((f32)(SIMPLIFY_GRID_SIZE * SIMPLIFY_GRID_SIZE), area);
+    for (u32 i = 0; i <= SIMPLIFY_GRID_SIZE; ++i) {
+        expect_to_be_true(used[i]);
+        expect_to_be_true(used[SIMPLIFY_GRID_SIZE * (SIMPLIFY_GRID_SIZE + 1) + i]);
+        expect_to_be_true(used[i * (SIMPLIFY_GRID_SIZE + 1)]);
+        expect_to_be_true(used[i * (SIMPLIFY_GRID_SIZE + 1) + SIMPLIFY_GRID_SIZE]);
+    }
+
+    // Folded into a ridge down the middle, reducing below what the error allows stops early.
+    for (u32 y = 0; y <= SIMPLIFY_GRID_SIZE; ++y) {
+        vertices[y * (SIMPLIFY_GRID_SIZE + 1) + SIMPLIFY_GRID_SIZE / 2].position.z = 5.0f;
+    }
+    count = geometry_simplify(SIMPLIFY_VERTEX_COUNT, vertices, SIMPLIFY_INDEX_COUNT, indices, 0, 0.001f, simplified, &error);
+    expect_to_be_true((count > 0));
+    expect_to_be_true((error <= 0.001f));
+    return true;
+}
+
+u8 meshlets_should_cover_triangles_within_limits() {
+    vertex_3d vertices[SIMPLIFY_VERTEX_COUNT] = {0};
+    u32 indices[SIMPLIFY_INDEX_COUNT];
+    for (u32 y = 0; y <= SIMPLIFY_GRID_SIZE; ++y) {
+        for (u32 x = 0; x <= SIMPLIFY_GRID_SIZE; ++x) {
+            vertices[y * (SIMPLIFY_GRID_SIZE + 1) + x].position = (vec3){(f32)x, (f32)y, 0};
+        }
+    }
+    u32 index = 0;
+    for (u32 y = 0; y < SIMPLIFY_GRID_SIZE; ++y) {
+        for (u32 x = 0; x < SIMPLIFY_GRID_SIZE; ++x) {
+            u32 v = y * (SIMPLIFY_GRID_SIZE + 1) + x;
+            u32 quad[6] = {v, v + 1, v + SIMPLIFY_GRID_SIZE + 2, v, v + SIMPLIFY_GRID_SIZE + 2, v + SIMPLIFY_GRID_SIZE + 1};
+            for (u32 i = 0; i < 6; ++i) {
+                indices[index++] = quad[i];
+            }
+        }
+    }
+
+    geometry_meshlet* meshlets = 0;
+    u32 count = geometry_build_meshlets(SIMPLIFY_VERTEX_COUNT, vertices, SIMPLIFY_INDEX_COUNT, indices, GEOMETRY_MESHLET_MAX_VERTICES, GEOMETRY_MESHLET_MAX_TRIANGLES, &meshlets);
+    expect_to_be_true((count > 1));
+
+    // One range after another, over every index, each within the limits and inside its extents.
+    u32 next_index = 0;
+    for (u32 m = 0; m < count; ++m) {
+        const geometry_meshlet* meshlet = &meshlets[m];
+        expect_should_be(next_index, meshlet->index_offset);
+        expect_to_be_true((meshlet->index_count > 0 && meshlet->index_count <= GEOMETRY_MESHLET_MAX_TRIANGLES * 3));
+        expect_to_be_true((meshlet->vertex_count >= 3 && meshlet->vertex_count <= GEOMETRY_MESHLET_MAX_VERTICES));
+        for (u32 i = 0; i < meshlet->index_count; ++i) {
+            expect_to_be_true(extents_contain(meshlet->extents, vertices[indices[meshlet->index_offset + i]].position));
+        }
+
+        // Flat, so every triangle faces straight along the axis.
+        expect_float_to_be(1.0f, meshlet->cone_axis.z);
+        expect_float_to_be(0.0f, meshlet->cone_cutoff);
+        next_index += meshlet->index_count;
+    }
+    expect_should_be(SIMPLIFY_INDEX_COUNT, next_index);
+    kfree(meshlets, sizeof(geometry_meshlet) * count, MEMORY_TAG_ARRAY);
+
+    // A triangle facing the other way widens the cone until it is never culled.
+    u32 flipped[6] = {0, 1, SIMPLIFY_GRID_SIZE + 2, 0, SIMPLIFY_GRID_SIZE + 2, 1};
+    count = geometry_build_meshlets(SIMPLIFY_VERTEX_COUNT, vertices, 6, flipped, GEOMETRY_MESHLET_MAX_VERTICES, GEOMETRY_MESHLET_MAX_TRIANGLES, &meshlets);
+    expect_should_be(1, count);
+    expect_float_to_be(1.0f, meshlets[0].cone_cutoff);
+    kfree(meshlets, sizeof(geometry_meshlet) * count, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+void geometry_utils_register_tests() {
+    test_manager_register_test(half_conversion_should_round_trip_and_round, "Half conversion should round trip and round to nearest even");
+    test_manager_register_test(octahedral_encoding_should_preserve_direction, "Octahedral encoding should preserve direction");
+    test_manager_register_test(vertex_pack_should_round_trip, "Packed vertices should round trip");
+    test_manager_register_test(skinned_vertex_pack_should_keep_heaviest_weights, "Skinned vertices should keep their heaviest weights, summing to 255");
+    test_manager_register_test(extents_transform_should_enclose_rotated_corners, "Transformed extents should enclose rotated corners");
+    test_manager_register_test(bounding_volumes_should_merge_and_enclose, "Bounding volumes should merge and enclose");
+    test_manager_register_test(ray_should_hit_extents_in_front_and_miss_others, "Rays should hit extents in front of them and miss others");
+    test_manager_register_test(ray_from_screen_should_pass_through_the_cursor, "Rays from the screen should pass through the cursor");
+    test_manager_register_test(generated_tangents_should_match_per_triangle_reference, "Generated tangents should match the per-triangle reference");
+    test_manager_register_test(generated_normals_and_tangents_should_be_shared, "Generated normals and tangents should be shared between triangles");
+    test_manager_register_test(weld_vertices_should_merge_duplicates_and_remap_indices, "Welding vertices should merge duplicates and remap indices");
+    test_manager_register_test(optimize_indices_should_lower_acmr_and_keep_triangles, "Optimizing indices should lower ACMR and keep every triangle");
+    test_manager_register_test(simplify_should_reduce_flat_grid_and_keep_border, "Simplifying should reduce a flat grid and keep its border");
+    test_manager_register_test(meshlets_should_cover_triangles_within_limits, "Meshlets should cover every triangle within their limits");
+}
@@ -0,0 +1,124 @@
+#include "kmath_benchmarks.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <math/kmath.h>
+
+// The number of inputs cycled through, small enough to stay in cache so only the math is timed.
+#define KMATH_BENCH_INPUT_COUNT 64
+
+// A multiple of 64, as the batch frustum test takes whole words of boxes.
+#define KMATH_BENCH_BOX_COUNT 4096
+
+// Written to so that the compiler can't drop the work being timed.
+static volatile f32 kmath_bench_sink;
+
+static mat4 inputs[KMATH_BENCH_INPUT_COUNT];
+static vec3 centers[KMATH_BENCH_BOX_COUNT];
+static vec3 extents[KMATH_BENCH_BOX_COUNT];
+static f32 box_data[KMATH_BENCH_BOX_COUNT * 6];
+static u64 visibility[KMATH_BENCH_BOX_COUNT / 64];
+static frustum bench_frustum;
+
+// A fixed sequence, so that every run times the same inputs.
+static u32 kmath_bench_seed;
+
+static f32 random_in_range(f32 min, f32 max) {
+    kmath_bench_seed = kmath_bench_seed * 1664525u + 1013904223u;
+    return min + (max - min) * ((kmath_bench_seed >> 8) / 16777216.0f);
+}
+
+static u8 matrices_setup() {
+    kmath_bench_seed = 1;
+    for (u32 i = 0; i < KMATH_BENCH_INPUT_COUNT; ++i) {
+        // Rotations and translations, as the engine's matrices mostly are, so all are invertible.
+        vec3 axis = vec3_normalized((vec3){random_in_range(-1.0f, 1.0f), random_in_range(0.1f, 1.0f), random_in_range(-1.0f, 1.0f)});
+        quat rotation = quat_from_axis_angle(axis, random_in_range(0.0f, K_PI), true);
+        inputs[i] = mat4_mul(quat_to_mat4(rotation), mat4_translation((vec3){random_in_range(-50.0f, 50.0f), random_in_range(-50.0f, 50.0f), random_in_range(-50.0f, 50.0f)}));
+    }
+    return true;
+}
+
+static u8 boxes_setup() {
+    kmath_bench_seed = 2;
+    vec3 position = {0, 0, 0};
+    vec3 forward = {0, 0, -1};
+    vec3 right = {1, 0, 0};
+    vec3 up = {0, 1, 0};
+    bench_frustum = frustom_create(&position, &forward, &right, &up, 16.0f / 9.0f, deg_to_rad(45.0f), 0.1f, 100.0f);
+
+    // Scattered all around the camera, so about as many are culled as not.
+    for (u32 i = 0; i < KMATH_BENCH_BOX_COUNT; ++i) {
+        centers[i] = (vec3){random_in_range(-100.0f, 100.0f), random_in_range(-100.0f, 100.0f), random_in_range(-150.0f, 50.0f)};
+        extents[i] = (vec3){random_in_range(0.1f, 5.0f), random_in_range(0.1f, 5.0f), random_in_range(0.1f, 5.0f)};
+        box_data[KMATH_BENCH_BOX_COUNT * 0 + i] = centers[i].x;
+        box_data[KMATH_BENCH_BOX_COUNT * 1 + i] = centers[i].y;
+        box_data[KMATH_BENCH_BOX_COUNT * 2 + i] = centers[i].z;
+        box_data[KMATH_BENCH_BOX_COUNT * 3 + i] = extents[i].x;
+        box_data[KMATH_BENCH_BOX_COUNT * 4 + i] = extents[i].y;
+        box_data[KMATH_BENCH_BOX_COUNT * 5 + i] = extents[i].z;
+    }
+    return true;
+}
+
+static u8 mat4_mul_run(u32 op_count) {
+    mat4 result = mat4_identity();
+    for (u32 i = 0; i < op_count; ++i) {
+        result = mat4_mul(inputs[i % KMATH_BENCH_INPUT_COUNT], inputs[(i + 1) % KMATH_BENCH_INPUT_COUNT]);
+        kmath_bench_sink = result.data[i & 15];
+    }
+    return true;
+}
+
+static u8 mat4_inverse_run(u32 op_count) {
+    for (u32 i = 0; i < op_count; ++i) {
+        mat4 result = mat4_inverse(inputs[i % KMATH_BENCH_INPUT_COUNT]);
+        kmath_bench_sink = result.data[i & 15];
+    }
+    return true;
+}
+
+static u8 frustum_intersects_aabb_run(u32 op_count) {
+    u32 visible = 0;
+    for (u32 i = 0; i < op_count; ++i) {
+        u32 box = i % KMATH_BENCH_BOX_COUNT;
+        visible += frustum_intersects_aabb(&bench_frustum, &centers[box], &extents[box]);
+    }
+    kmath_bench_sink = (f32)visible;
+    return true;
+}
+
+static u8 frustum_intersects_sphere_run(u32 op_count) {
+    u32 visible = 0;
+    for (u32 i = 0; i < op_count; ++i) {
+        u32 box = i % KMATH_BENCH_BOX_COUNT;
+        visible += frustum_intersects_sphere(&bench_frustum, &centers[box], extents[box].x);
+    }
+    kmath_bench_sink = (f32)visible;
+    return true;
+}
+
+// Timed per box, so it compares directly with frustum_intersects_aabb.
+static u8 frustum_intersects_aabb_batch_run(u32 op_count) {
+    aabb_soa boxes = {
+        box_data + KMATH_BENCH_BOX_COUNT * 0,
+        box_data + KMATH_BENCH_BOX_COUNT * 1,
+        box_data + KMATH_BENCH_BOX_COUNT * 2,
+        box_data + KMATH_BENCH_BOX_COUNT * 3,
+        box_data + KMATH_BENCH_BOX_COUNT * 4,
+        box_data + KMATH_BENCH_BOX_COUNT * 5};
+    for (u32 done = 0; done < op_count; done += KMATH_BENCH_BOX_COUNT) {
+        frustum_intersects_aabb_batch(&bench_frustum, &boxes, 0, KMATH_BENCH_BOX_COUNT, visibility);
+        kmath_bench_sink = (f32)visibility[done & (KMATH_BENCH_BOX_COUNT / 64 - 1)];
+    }
+    return true;
+}
+
+void kmath_register_benchmarks() {
+    test_manager_register_benchmark(matrices_setup, mat4_mul_run, 0, 100000, "kmath.mat4_mul");
+    test_manager_register_benchmark(matrices_setup, mat4_inverse_run, 0, 100000, "kmath.mat4_inverse");
+    test_manager_register_benchmark(boxes_setup, frustum_intersects_aabb_run, 0, 100000, "kmath.frustum_intersects_aabb");
+    test_manager_register_benchmark(boxes_setup, frustum_intersects_sphere_run, 0, 100000, "kmath.frustum_intersects_sphere");
+    test_manager_register_benchmark(boxes_setup, frustum_intersects_aabb_batch_run, 0, KMATH_BENCH_BOX_COUNT * 25, "kmath.frustum_intersects_aabb_batch");
+}
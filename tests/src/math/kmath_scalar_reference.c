@@ -0,0 +1,56 @@
+#include "kmath_scalar_reference.h"
+
+#define KSIMD_DISABLE
+#include <math/kmath.h>
+
+#if defined(KSIMD_ENABLED)
+#error "kmath_scalar_reference.c must be built with the scalar fallback."
+#endif
+
+vec4 scalar_vec4_add(vec4 vector_0, vec4 vector_1) {
+    return vec4_add(vector_0, vector_1);
+}
+
+vec4 scalar_vec4_sub(vec4 vector_0, vec4 vector_1) {
+    return vec4_sub(vector_0, vector_1);
+}
+
+vec4 scalar_vec4_mul(vec4 vector_0, vec4 vector_1) {
+    return vec4_mul(vector_0, vector_1);
+}
+
+vec4 scalar_vec4_div(vec4 vector_0, vec4 vector_1) {
+    return vec4_div(vector_0, vector_1);
+}
+
+mat4 scalar_mat4_mul(mat4 matrix_0, mat4 matrix_1) {
+    return mat4_mul(matrix_0, matrix_1);
+}
+
+mat4 scalar_mat4_transposed(mat4 matrix) {
+    return mat4_transposed(matrix);
+}
+
+mat4 scalar_mat4_inverse(mat4 matrix) {
+    return mat4_inverse(matrix);
+}
+
+vec3 scalar_vec3_transform(vec3 v, mat4 m) {
+    return vec3_transform(v, m);
+}
+
+vec3 scalar_vec3_mul_mat4(vec3 v, mat4 m) {
+    return vec3_mul_mat4(v, m);
+}
+
+vec4 scalar_mat4_mul_vec4(mat4 m, vec4 v) {
+    return mat4_mul_vec4(m, v);
+}
+
+vec4 scalar_vec4_mul_mat4(vec4 v, mat4 m) {
+    return vec4_mul_mat4(v, m);
+}
+
+quat scalar_quat_mul(quat q_0, quat q_1) {
+    return quat_mul(q_0, q_1);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <math/math_types.h>
+
+// The scalar fallbacks of the kmath operations which have SIMD implementations, built with
+// KSIMD_DISABLE so that the SIMD implementations can be compared against them.
+
+vec4 scalar_vec4_add(vec4 vector_0, vec4 vector_1);
+vec4 scalar_vec4_sub(vec4 vector_0, vec4 vector_1);
+vec4 scalar_vec4_mul(vec4 vector_0, vec4 vector_1);
+vec4 scalar_vec4_div(vec4 vector_0, vec4 vector_1);
+mat4 scalar_mat4_mul(mat4 matrix_0, mat4 matrix_1);
+mat4 scalar_mat4_transposed(mat4 matrix);
+mat4 scalar_mat4_inverse(mat4 matrix);
+vec3 scalar_vec3_transform(vec3 v, mat4 m);
+vec3 scalar_vec3_mul_mat4(vec3 v, mat4 m);
+vec4 scalar_mat4_mul_vec4(mat4 m, vec4 v);
+vec4 scalar_vec4_mul_mat4(vec4 v, mat4 m);
+quat scalar_quat_mul(quat q_0, quat q_1);
@@ -0,0 +1,295 @@
+#include "kmath_tests.h"
+#include "kmath_scalar_reference.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/logger.h>
+#include <math/kmath.h>
+
+#define KMATH_TEST_ITERATIONS 1000
+
+// Sums of products of the random inputs can cancel, and fused multiply-adds round differently,
+// so these are compared less tightly than single operations.
+#define KMATH_PRODUCT_TOLERANCE 1e-4f
+
+// A fixed sequence, so that failures can be reproduced.
+static u32 kmath_test_seed;
+
+static f32 random_in_range(f32 min, f32 max) {
+    kmath_test_seed = kmath_test_seed * 1664525u + 1013904223u;
+    return min + (max - min) * ((kmath_test_seed >> 8) / 16777216.0f);
+}
+
+static vec4 random_vec4(void) {
+    return (vec4){random_in_range(-10.0f, 10.0f), random_in_range(-10.0f, 10.0f), random_in_range(-10.0f, 10.0f), random_in_range(-10.0f, 10.0f)};
+}
+
+static mat4 random_mat4(void) {
+    mat4 m;
+    for (u32 i = 0; i < 16; ++i) {
+        m.data[i] = random_in_range(-10.0f, 10.0f);
+    }
+    return m;
+}
+
+// Agrees to within the given fraction of the larger magnitude, or of 1 for small values.
+static b8 floats_close(f32 a, f32 b, f32 tolerance) {
+    f32 scale = KMAX(kabs(a), kabs(b));
+    scale = KMAX(scale, 1.0f);
+    return kabs(a - b) <= tolerance * scale;
+}
+
+static b8 floats_array_close(const f32* a, const f32* b, u32 count, f32 tolerance) {
+    for (u32 i = 0; i < count; ++i) {
+        if (!floats_close(a[i], b[i], tolerance)) {
+            KERROR("--> Element %u differs: %f vs %f.", i, a[i], b[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+u8 kmath_simd_vector_operations_should_match_scalar() {
+    kmath_test_seed = 1;
+    for (u32 i = 0; i < KMATH_TEST_ITERATIONS; ++i) {
+        vec4 a = random_vec4();
+        vec4 b = random_vec4();
+        vec4 result = vec4_add(a, b);
+        vec4 expected = scalar_vec4_add(a, b);
+        expect_to_be_true(floats_array_close(result.elements, expected.elements, 4, 1e-6f));
+        result = vec4_sub(a, b);
+        expected = scalar_vec4_sub(a, b);
+        expect_to_be_true(floats_array_close(result.elements, expected.elements, 4, 1e-6f));
+        result = vec4_mul(a, b);
+        expected = scalar_vec4_mul(a, b);
+        expect_to_be_true(floats_array_close(result.elements, expected.elements, 4, 1e-6f));
+        result = vec4_div(a, b);
+        expected = scalar_vec4_div(a, b);
+        expect_to_be_true(floats_array_close(result.elements, expected.elements, 4, 1e-5f));
+
+        quat q_result = quat_mul(a, b);
+        quat q_expected = scalar_quat_mul(a, b);
+        expect_to_be_true(floats_array_close(q_result.elements, q_expected.elements, 4, KMATH_PRODUCT_TOLERANCE));
+    }
+    return true;
+}
+
+u8 kmath_simd_matrix_operations_should_match_scalar() {
+    kmath_test_seed = 2;
+    for (u32 i = 0; i < KMATH_TEST_ITERATIONS; ++i) {
+        mat4 a = random_mat4();
+        mat4 b = random_mat4();
+        mat4 result = mat4_mul(a, b);
+        mat4 expected = scalar_mat4_mul(a, b);
+        expect_to_be_true(floats_array_close(result.data, expected.data, 16, KMATH_PRODUCT_TOLERANCE));
+
+        result = mat4_transposed(a);
+        expected = scalar_mat4_transposed(a);
+        expect_to_be_true(floats_array_close(result.data, expected.data, 16, 0.0f));
+
+        vec4 v = random_vec4();
+        vec3 v3 = vec4_to_vec3(v);
+        vec3 result3 = vec3_transform(v3, a);
+        vec3 expected3 = scalar_vec3_transform(v3, a);
+        expect_to_be_true(floats_array_close(result3.elements, expected3.elements, 3, KMATH_PRODUCT_TOLERANCE));
+        result3 = vec3_mul_mat4(v3, a);
+        expected3 = scalar_vec3_mul_mat4(v3, a);
+        expect_to_be_true(floats_array_close(result3.elements, expected3.elements, 3, KMATH_PRODUCT_TOLERANCE));
+
+        vec4 result4 = vec4_mul_mat4(v, a);
+        vec4 expected4 = scalar_vec4_mul_mat4(v, a);
+        expect_to_be_true(floats_array_close(result4.elements, expected4.elements, 4, KMATH_PRODUCT_TOLERANCE));
+        result4 = mat4_mul_vec4(a, v);
+        expected4 = scalar_mat4_mul_vec4(a, v);
+        expect_to_be_true(floats_array_close(result4.elements, expected4.elements, 4, KMATH_PRODUCT_TOLERANCE));
+    }
+    return true;
+}
+
+u8 kmath_simd_inverse_should_match_scalar() {
+    kmath_test_seed = 3;
+    mat4 identity = mat4_identity();
+    for (u32 i = 0; i < KMATH_TEST_ITERATIONS; ++i) {
+        // Weight the diagonal so that the matrices are well conditioned.
+        mat4 m = random_mat4();
+        for (u32 j = 0; j < 4; ++j) {
+            m.data[j * 5] += 40.0f;
+        }
+        mat4 result = mat4_inverse(m);
+        mat4 expected = scalar_mat4_inverse(m);
+        expect_to_be_true(floats_array_close(result.data, expected.data, 16, 1e-4f));
+
+        mat4 product = mat4_mul(m, result);
+        expect_to_be_true(floats_array_close(product.data, identity.data, 16, 1e-4f));
+    }
+
+    // The inverse of a transform undoes it.
+    mat4 transform = mat4_mul(mat4_scale((vec3){2.0f, 4.0f, 0.5f}), mat4_translation((vec3){1.0f, -2.0f, 3.0f}));
+    vec3 point = (vec3){5.0f, 6.0f, 7.0f};
+    vec3 back = vec3_transform(vec3_transform(point, transform), mat4_inverse(transform));
+    expect_to_be_true(floats_array_close(back.elements, point.elements, 3, 1e-5f));
+    return true;
+}
+
+#define KMATH_CULL_BOX_COUNT 1000
+
+// The margin by which a box is inside the frustum, negative if it is outside, as frustum_intersects_aabb sees it.
+static f32 frustum_aabb_margin(const frustum* f, const vec3* center, const vec3* extents) {
+    f32 margin = 0;
+    for (u32 i = 0; i < 6; ++i) {
+        const plane_3d* p = &f->sides[i];
+        f32 r = extents->x * kabs(p->normal.x) + extents->y * kabs(p->normal.y) + extents->z * kabs(p->normal.z);
+        f32 plane_margin = plane_signed_distance(p, center) + r;
+        margin = i ? KMIN(margin, plane_margin) : plane_margin;
+    }
+    return margin;
+}
+
+u8 kmath_frustum_aabb_batch_should_match_single() {
+    kmath_test_seed = 4;
+    vec3 position = {0, 0, 0};
+    vec3 forward = {0, 0, -1};
+    vec3 right = {1, 0, 0};
+    vec3 up = {0, 1, 0};
+    frustum f = frustom_create(&position, &forward, &right, &up, 16.0f / 9.0f, deg_to_rad(45.0f), 0.1f, 100.0f);
+
+    f32 box_data[KMATH_CULL_BOX_COUNT * 6];
+    aabb_soa boxes = {
+        box_data,
+        box_data + KMATH_CULL_BOX_COUNT,
+        box_data + KMATH_CULL_BOX_COUNT * 2,
+        box_data + KMATH_CULL_BOX_COUNT * 3,
+        box_data + KMATH_CULL_BOX_COUNT * 4,
+        box_data + KMATH_CULL_BOX_COUNT * 5};
+    for (u32 i = 0; i < KMATH_CULL_BOX_COUNT; ++i) {
+        box_data[i] = random_in_range(-100.0f, 100.0f);
+        box_data[i + KMATH_CULL_BOX_COUNT] = random_in_range(-100.0f, 100.0f);
+        box_data[i + KMATH_CULL_BOX_COUNT * 2] = random_in_range(-150.0f, 50.0f);
+        box_data[i + KMATH_CULL_BOX_COUNT * 3] = random_in_range(0.0f, 5.0f);
+        box_data[i + KMATH_CULL_BOX_COUNT * 4] = random_in_range(0.0f, 5.0f);
+        box_data[i + KMATH_CULL_BOX_COUNT * 5] = random_in_range(0.0f, 5.0f);
+    }
+
+    // Fill with garbage, to check every bit gets written, including those past the end.
+    u64 visibility[(KMATH_CULL_BOX_COUNT + 63) / 64];
+    for (u32 i = 0; i < (KMATH_CULL_BOX_COUNT + 63) / 64; ++i) {
+        visibility[i] = 0xAAAAAAAAAAAAAAAAull;
+    }
+    // In two ranges split at a multiple of 64, as a parallel-for would.
+    frustum_intersects_aabb_batch(&f, &boxes, 0, 128, visibility);
+    frustum_intersects_aabb_batch(&f, &boxes, 128, KMATH_CULL_BOX_COUNT, visibility);
+
+    u32 visible_count = 0;
+    for (u32 i = 0; i < KMATH_CULL_BOX_COUNT; ++i) {
+        vec3 center = {boxes.center_x[i], boxes.center_y[i], boxes.center_z[i]};
+        vec3 extents = {boxes.extents_x[i], boxes.extents_y[i], boxes.extents_z[i]};
+        b8 expected = frustum_intersects_aabb(&f, &center, &extents);
+        b8 visible = (visibility[i / 64] >> (i % 64)) & 1;
+        if (visible != expected) {
+            // Only boxes within rounding of a plane may disagree.
+            f32 margin = frustum_aabb_margin(&f, &center, &extents);
+            expect_to_be_true((kabs(margin) < 1e-3f));
+        }
+        visible_count += visible;
+    }
+    // Some of each, so that both outcomes were tested.
+    expect_to_be_true((visible_count > 0));
+    expect_to_be_true((visible_count < KMATH_CULL_BOX_COUNT));
+    expect_should_be(0, visibility[KMATH_CULL_BOX_COUNT / 64] >> (KMATH_CULL_BOX_COUNT % 64));
+    return true;
+}
+
+u8 krandom_state_should_be_repeatable_and_in_range() {
+    // The first values of xoshiro256** seeded through splitmix64; changing them changes every seeded sequence.
+    krandom_state state;
+    krandom_state_seed(&state, 12345);
+    expect_should_be(0xBE6A36374160D49Bull, krandom_state_next(&state));
+    expect_should_be(0x214AAA0637A688C6ull, krandom_state_next(&state));
+    expect_should_be(0xF69D16DE9954D388ull, krandom_state_next(&state));
+    krandom_state_seed(&state, 12345);
+    krandom_state_jump(&state);
+    expect_should_be(0x3ED575283F0594E6ull, krandom_state_next(&state));
+    expect_should_be(0x4B77BCFA88A79146ull, krandom_state_next(&state));
+
+    // Filling gives the same values as one call per value.
+    krandom_state a, b;
+    krandom_state_seed(&a, 7);
+    krandom_state_seed(&b, 7);
+    u32 integers[KMATH_TEST_ITERATIONS];
+    f32 floats[KMATH_TEST_ITERATIONS];
+    krandom_state_fill_u32(&a, KMATH_TEST_ITERATIONS, integers);
+    krandom_state_fill_f32(&a, KMATH_TEST_ITERATIONS, -2.0f, 3.0f, floats);
+    for (u32 i = 0; i < KMATH_TEST_ITERATIONS; ++i) {
+        expect_should_be(krandom_state_u32(&b), integers[i]);
+    }
+    for (u32 i = 0; i < KMATH_TEST_ITERATIONS; ++i) {
+        expect_float_to_be(krandom_state_f32_in_range(&b, -2.0f, 3.0f), floats[i]);
+        expect_to_be_true((floats[i] >= -2.0f && floats[i] < 3.0f));
+    }
+
+    // Every value of a small range turns up, and nothing outside it.
+    u32 hits[7] = {0};
+    for (u32 i = 0; i < KMATH_TEST_ITERATIONS * 7; ++i) {
+        i32 value = krandom_state_in_range(&a, -3, 3);
+        expect_to_be_true((value >= -3 && value <= 3));
+        hits[value + 3]++;
+    }
+    for (u32 i = 0; i < 7; ++i) {
+        expect_to_be_true((hits[i] > KMATH_TEST_ITERATIONS / 2));
+    }
+    expect_should_be(5, krandom_state_in_range(&a, 5, 5));
+    // The full range of an i32 does not overflow.
+    krandom_state_in_range(&a, -2147483647 - 1, 2147483647);
+
+    // Each thread's generator is its own.
+    expect_to_be_true((krandom_thread_state() == krandom_thread_state()));
+    return true;
+}
+
+#define KMATH_NOISE_POINT_COUNT 1003
+
+u8 kmath_noise_batch_should_match_scalar() {
+    kmath_test_seed = 5;
+    f32 x[KMATH_NOISE_POINT_COUNT], y[KMATH_NOISE_POINT_COUNT], z[KMATH_NOISE_POINT_COUNT];
+    for (u32 i = 0; i < KMATH_NOISE_POINT_COUNT; ++i) {
+        x[i] = random_in_range(-50.0f, 50.0f);
+        y[i] = random_in_range(-50.0f, 50.0f);
+        z[i] = random_in_range(-50.0f, 50.0f);
+    }
+    f32 perlin[KMATH_NOISE_POINT_COUNT], value[KMATH_NOISE_POINT_COUNT];
+    noise_perlin_3d_batch(KMATH_NOISE_POINT_COUNT, x, y, z, 9, perlin);
+    noise_value_3d_batch(KMATH_NOISE_POINT_COUNT, x, y, z, 9, value);
+    u32 seed_differences = 0;
+    for (u32 i = 0; i < KMATH_NOISE_POINT_COUNT; ++i) {
+        expect_to_be_true(floats_close(noise_perlin_3d(x[i], y[i], z[i], 9), perlin[i], 1e-5f));
+        expect_to_be_true(floats_close(noise_value_3d(x[i], y[i], z[i], 9), value[i], 1e-5f));
+        expect_to_be_true((kabs(perlin[i]) <= 1.1f));
+        expect_to_be_true((value[i] >= -1.0f && value[i] <= 1.0f));
+        seed_differences += noise_perlin_3d(x[i], y[i], z[i], 10) != perlin[i];
+
+        // Zero on the lattice, and continuous across cells.
+        f32 lx = (f32)(i32)x[i], ly = (f32)(i32)y[i];
+        expect_float_to_be(0.0f, noise_perlin_3d(lx, ly, 2.0f, 9));
+        expect_to_be_true((kabs(noise_perlin_3d(lx - 1e-4f, ly, 0.5f, 9) - noise_perlin_3d(lx + 1e-4f, ly, 0.5f, 9)) < 1e-3f));
+    }
+    expect_to_be_true((seed_differences > KMATH_NOISE_POINT_COUNT / 2));
+    return true;
+}
+
+void kmath_register_tests() {
+#if defined(KSIMD_SSE)
+    KDEBUG("kmath tests are comparing the SSE implementation against the scalar one.");
+#elif defined(KSIMD_NEON)
+    KDEBUG("kmath tests are comparing the NEON implementation against the scalar one.");
+#else
+    KDEBUG("kmath tests are comparing the scalar implementation against itself, as SIMD is disabled.");
+#endif
+    test_manager_register_test(kmath_simd_vector_operations_should_match_scalar, "SIMD vector and quaternion operations should match scalar");
+    test_manager_register_test(kmath_simd_matrix_operations_should_match_scalar, "SIMD matrix operations should match scalar");
+    test_manager_register_test(kmath_simd_inverse_should_match_scalar, "SIMD matrix inverse should match scalar");
+    test_manager_register_test(kmath_frustum_aabb_batch_should_match_single, "Batched frustum AABB culling should match single box tests");
+    test_manager_register_test(krandom_state_should_be_repeatable_and_in_range, "Seeded random numbers should be repeatable and in range");
+    test_manager_register_test(kmath_noise_batch_should_match_scalar, "Batched noise should match scalar noise");
+}
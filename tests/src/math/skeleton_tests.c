@@ -0,0 +1,140 @@
+#include "skeleton_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <math/kmath.h>
+#include <math/skeleton.h>
+
+static b8 vectors_close(vec4 a, vec4 b) {
+    for (u32 i = 0; i < 4; ++i) {
+        if (kabs(a.elements[i] - b.elements[i]) > 0.0001f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A chain of three joints along x, each a unit from its parent, in its bind pose.
+static void* chain_create(skeleton* out_skeleton, u64* out_size, mat4 out_binds[3]) {
+    u32 parents[3] = {INVALID_ID, 0, 1};
+    mat4 inverse_binds[3];
+    for (u32 i = 0; i < 3; ++i) {
+        out_binds[i] = mat4_translation((vec3){(f32)i, 0.0f, 0.0f});
+        inverse_binds[i] = mat4_inverse(out_binds[i]);
+    }
+    skeleton_create(3, parents, inverse_binds, out_size, 0, 0);
+    void* memory = kallocate(*out_size, MEMORY_TAG_ARRAY);
+    skeleton_create(3, parents, inverse_binds, out_size, memory, out_skeleton);
+    return memory;
+}
+
+u8 skeleton_should_reject_parents_after_children() {
+    u32 parents[2] = {1, INVALID_ID};
+    mat4 inverse_binds[2] = {mat4_identity(), mat4_identity()};
+    u64 size = 0;
+    expect_to_be_true(skeleton_create(2, parents, inverse_binds, &size, 0, 0));
+    void* memory = kallocate(size, MEMORY_TAG_ARRAY);
+    skeleton s;
+    expect_to_be_false(skeleton_create(2, parents, inverse_binds, &size, memory, &s));
+    expect_to_be_false(skeleton_create(0, parents, inverse_binds, &size, 0, 0));
+    expect_to_be_false(skeleton_create(SKELETON_MAX_JOINTS + 1, parents, inverse_binds, &size, 0, 0));
+    kfree(memory, size, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 skeleton_palette_should_be_identity_in_bind_pose() {
+    skeleton s;
+    u64 size = 0;
+    mat4 binds[3];
+    void* memory = chain_create(&s, &size, binds);
+
+    // Each joint a unit along x from its parent is the bind pose.
+    mat4 locals[3] = {binds[0], mat4_translation((vec3){1.0f, 0.0f, 0.0f}), mat4_translation((vec3){1.0f, 0.0f, 0.0f})};
+    mat4 palette[3];
+    skeleton_pose pose = {&s, locals, palette};
+    skeleton_palette_compute(&pose);
+    vec4 point = {0.5f, 2.0f, -1.0f, 1.0f};
+    for (u32 i = 0; i < 3; ++i) {
+        expect_to_be_true(vectors_close(point, vec4_mul_mat4(point, palette[i])));
+    }
+
+    skeleton_destroy(&s);
+    kfree(memory, size, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 skeleton_palette_should_carry_parent_motion_to_children() {
+    skeleton s;
+    u64 size = 0;
+    mat4 binds[3];
+    void* memory = chain_create(&s, &size, binds);
+
+    // The root is lifted and the middle joint turned a quarter about z, swinging the last joint up.
+    mat4 locals[3] = {
+        mat4_translation((vec3){0.0f, 5.0f, 0.0f}),
+        mat4_mul(mat4_euler_z(K_PI_2 * 0.25f), mat4_translation((vec3){1.0f, 0.0f, 0.0f})),
+        mat4_translation((vec3){1.0f, 0.0f, 0.0f})};
+    mat4 palette[3];
+    skeleton_pose pose = {&s, locals, palette};
+    skeleton_palette_compute(&pose);
+
+    // The root only moves up.
+    vec4 at_root = {0.0f, 0.0f, 0.0f, 1.0f};
+    expect_to_be_true(vectors_close((vec4){0.0f, 5.0f, 0.0f, 1.0f}, vec4_mul_mat4(at_root, palette[0])));
+    // The last joint, at x=2 bound, ends a unit above the middle joint.
+    vec4 at_last = {2.0f, 0.0f, 0.0f, 1.0f};
+    vec4 moved = vec4_mul_mat4(at_last, palette[2]);
+    vec4 middle = vec4_mul_mat4((vec4){1.0f, 0.0f, 0.0f, 1.0f}, palette[1]);
+    expect_to_be_true(vectors_close((vec4){1.0f, 5.0f, 0.0f, 1.0f}, middle));
+    expect_to_be_true(vectors_close((vec4){1.0f, 6.0f, 0.0f, 1.0f}, moved));
+
+    skeleton_destroy(&s);
+    kfree(memory, size, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 skeleton_palettes_should_match_one_at_a_time() {
+    skeleton s;
+    u64 size = 0;
+    mat4 binds[3];
+    void* memory = chain_create(&s, &size, binds);
+
+    // Enough poses to be spread across batches, each posed a little differently.
+    const u32 pose_count = SKELETON_PARALLEL_MIN * 2 + 3;
+    mat4* locals = kallocate(sizeof(mat4) * 3 * pose_count, MEMORY_TAG_ARRAY);
+    mat4* palettes = kallocate(sizeof(mat4) * 3 * pose_count, MEMORY_TAG_ARRAY);
+    skeleton_pose* poses = kallocate(sizeof(skeleton_pose) * pose_count, MEMORY_TAG_ARRAY);
+    for (u32 p = 0; p < pose_count; ++p) {
+        for (u32 j = 0; j < 3; ++j) {
+            locals[p * 3 + j] = mat4_mul(mat4_euler_y(0.01f * (f32)(p + j)), mat4_translation((vec3){1.0f, 0.0f, (f32)p}));
+        }
+        poses[p] = (skeleton_pose){&s, &locals[p * 3], &palettes[p * 3]};
+    }
+    skeleton_palettes_compute(pose_count, poses, true);
+
+    for (u32 p = 0; p < pose_count; ++p) {
+        mat4 expected[3];
+        skeleton_pose single = {&s, &locals[p * 3], expected};
+        skeleton_palette_compute(&single);
+        for (u32 j = 0; j < 3 * 16; ++j) {
+            expect_float_to_be(expected[j / 16].data[j % 16], palettes[p * 3 + j / 16].data[j % 16]);
+        }
+    }
+
+    kfree(poses, sizeof(skeleton_pose) * pose_count, MEMORY_TAG_ARRAY);
+    kfree(palettes, sizeof(mat4) * 3 * pose_count, MEMORY_TAG_ARRAY);
+    kfree(locals, sizeof(mat4) * 3 * pose_count, MEMORY_TAG_ARRAY);
+    skeleton_destroy(&s);
+    kfree(memory, size, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+void skeleton_register_tests() {
+    test_manager_register_test(skeleton_should_reject_parents_after_children, "Skeletons should reject parents after their children");
+    test_manager_register_test(skeleton_palette_should_be_identity_in_bind_pose, "Skeleton palettes should be identity in the bind pose");
+    test_manager_register_test(skeleton_palette_should_carry_parent_motion_to_children, "Skeleton palettes should carry parent motion to children");
+    test_manager_register_test(skeleton_palettes_should_match_one_at_a_time, "Skeleton palettes computed together should match those computed one at a time");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void skeleton_register_tests();
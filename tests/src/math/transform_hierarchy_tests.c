@@ -0,0 +1,182 @@
+#include "transform_hierarchy_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <math/kmath.h>
+#include <math/transform.h>
+#include <math/transform_hierarchy.h>
+
+static void* hierarchy_create(u32 capacity, transform_hierarchy* out_hierarchy, u64* out_size) {
+    transform_hierarchy_create(capacity, out_size, 0, 0);
+    void* memory = kallocate(*out_size, MEMORY_TAG_TRANSFORM);
+    transform_hierarchy_create(capacity, out_size, memory, out_hierarchy);
+    return memory;
+}
+
+static b8 matrices_close(mat4 a, mat4 b) {
+    for (u32 i = 0; i < 16; ++i) {
+        if (kabs(a.data[i] - b.data[i]) > 0.0001f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+u8 transform_hierarchy_should_match_transform_world() {
+    transform_hierarchy h;
+    u64 size = 0;
+    void* memory = hierarchy_create(8, &h, &size);
+
+    // The same chain built both ways.
+    transform a = transform_from_position((vec3){1.0f, 2.0f, 3.0f});
+    transform b = transform_from_position_rotation((vec3){10.0f, 0.0f, 1.0f}, quat_from_axis_angle((vec3){0, 1, 0}, 0.7f, true));
+    transform c = transform_from_position_rotation_scale((vec3){5.0f, 0.0f, 1.0f}, quat_identity(), (vec3){2.0f, 2.0f, 2.0f});
+    transform_set_parent(&b, &a);
+    transform_set_parent(&c, &b);
+
+    u32 a_id = transform_hierarchy_add(&h, &a, INVALID_ID);
+    u32 b_id = transform_hierarchy_add(&h, &b, a_id);
+    u32 c_id = transform_hierarchy_add(&h, &c, b_id);
+    expect_should_not_be(INVALID_ID, c_id);
+    expect_should_be(b_id, transform_hierarchy_parent_get(&h, c_id));
+    expect_should_be(INVALID_ID, transform_hierarchy_parent_get(&h, a_id));
+
+    transform_hierarchy_update(&h, false);
+    expect_to_be_true(matrices_close(transform_get_world(&c), transform_hierarchy_world_get(&h, c_id)));
+    expect_to_be_true(matrices_close(transform_get_world(&b), transform_hierarchy_world_get(&h, b_id)));
+
+    // Changes to an ancestor reach descendants.
+    quat rotation = quat_from_axis_angle((vec3){0, 0, 1}, 0.3f, true);
+    transform_rotate(&a, rotation);
+    transform_hierarchy_rotate(&h, a_id, rotation);
+    transform_hierarchy_update(&h, false);
+    expect_to_be_true(matrices_close(transform_get_world(&c), transform_hierarchy_world_get(&h, c_id)));
+
+    transform_hierarchy_destroy(&h);
+    kfree(memory, size, MEMORY_TAG_TRANSFORM);
+    return true;
+}
+
+u8 transform_hierarchy_should_only_update_dirty_branches() {
+    transform_hierarchy h;
+    u64 size = 0;
+    void* memory = hierarchy_create(8, &h, &size);
+
+    transform t = transform_from_position((vec3){1.0f, 0.0f, 0.0f});
+    u32 root_a = transform_hierarchy_add(&h, &t, INVALID_ID);
+    u32 child_a = transform_hierarchy_add(&h, &t, root_a);
+    u32 root_b = transform_hierarchy_add(&h, &t, INVALID_ID);
+    u32 child_b = transform_hierarchy_add(&h, &t, root_b);
+
+    // Everything is new, so everything changes.
+    transform_hierarchy_update(&h, false);
+    expect_to_be_true(transform_hierarchy_world_changed(&h, child_a));
+    expect_to_be_true(transform_hierarchy_world_changed(&h, child_b));
+
+    // Nothing changed since.
+    transform_hierarchy_update(&h, false);
+    expect_to_be_false(transform_hierarchy_world_changed(&h, root_a));
+    expect_to_be_false(transform_hierarchy_world_changed(&h, child_b));
+
+    // Only the moved branch changes.
+    transform_hierarchy_translate(&h, root_a, (vec3){0.0f, 1.0f, 0.0f});
+    transform_hierarchy_update(&h, false);
+    expect_to_be_true(transform_hierarchy_world_changed(&h, root_a));
+    expect_to_be_true(transform_hierarchy_world_changed(&h, child_a));
+    expect_to_be_false(transform_hierarchy_world_changed(&h, root_b));
+    expect_to_be_false(transform_hierarchy_world_changed(&h, child_b));
+    mat4 world = transform_hierarchy_world_get(&h, child_a);
+    expect_float_to_be(2.0f, world.data[12]);
+    expect_float_to_be(1.0f, world.data[13]);
+
+    transform_hierarchy_destroy(&h);
+    kfree(memory, size, MEMORY_TAG_TRANSFORM);
+    return true;
+}
+
+u8 transform_hierarchy_should_reparent_and_remove() {
+    transform_hierarchy h;
+    u64 size = 0;
+    void* memory = hierarchy_create(4, &h, &size);
+
+    transform t = transform_from_position((vec3){1.0f, 0.0f, 0.0f});
+    u32 a = transform_hierarchy_add(&h, &t, INVALID_ID);
+    u32 b = transform_hierarchy_add(&h, &t, INVALID_ID);
+    u32 c = transform_hierarchy_add(&h, &t, b);
+
+    // Placing b under c, which would be a cycle, is refused.
+    expect_to_be_false(transform_hierarchy_set_parent(&h, b, c));
+    expect_to_be_false(transform_hierarchy_set_parent(&h, b, b));
+
+    // a was added before b, but ends up below it, so the order must be rebuilt for it to follow.
+    expect_to_be_true(transform_hierarchy_set_parent(&h, a, c));
+    transform_hierarchy_update(&h, false);
+    expect_float_to_be(3.0f, transform_hierarchy_world_get(&h, a).data[12]);
+
+    // Removing c moves a up to b.
+    expect_to_be_true(transform_hierarchy_remove(&h, c));
+    expect_to_be_false(transform_hierarchy_remove(&h, c));
+    expect_should_be(b, transform_hierarchy_parent_get(&h, a));
+    transform_hierarchy_update(&h, false);
+    expect_float_to_be(2.0f, transform_hierarchy_world_get(&h, a).data[12]);
+    expect_should_be(2, h.count);
+
+    // Ids and positions are reused once the hierarchy fills up.
+    u32 d = transform_hierarchy_add(&h, &t, a);
+    u32 e = transform_hierarchy_add(&h, &t, d);
+    expect_should_not_be(INVALID_ID, e);
+    expect_should_be(INVALID_ID, transform_hierarchy_add(&h, &t, INVALID_ID));
+    transform_hierarchy_update(&h, false);
+    expect_float_to_be(4.0f, transform_hierarchy_world_get(&h, e).data[12]);
+
+    transform_hierarchy_destroy(&h);
+    kfree(memory, size, MEMORY_TAG_TRANSFORM);
+    return true;
+}
+
+u8 transform_hierarchy_parallel_update_should_match_serial() {
+    transform_hierarchy serial;
+    transform_hierarchy parallel;
+    u32 count = TRANSFORM_HIERARCHY_PARALLEL_MIN * 3;
+    u64 size = 0;
+    void* serial_memory = hierarchy_create(count, &serial, &size);
+    void* parallel_memory = hierarchy_create(count, &parallel, &size);
+
+    // A few roots, each with a wide level of children, each with one grandchild.
+    u32 parents[4];
+    for (u32 i = 0; i < 4; ++i) {
+        transform t = transform_from_position((vec3){(f32)i, 0.0f, 0.0f});
+        parents[i] = transform_hierarchy_add(&serial, &t, INVALID_ID);
+        transform_hierarchy_add(&parallel, &t, INVALID_ID);
+    }
+    u32 ids[TRANSFORM_HIERARCHY_PARALLEL_MIN * 3];
+    for (u32 i = 4; i < count; i += 2) {
+        transform t = transform_from_position_rotation((vec3){0.0f, (f32)i * 0.01f, 0.0f}, quat_from_axis_angle((vec3){0, 1, 0}, (f32)i * 0.001f, true));
+        ids[i] = transform_hierarchy_add(&serial, &t, parents[i % 4]);
+        transform_hierarchy_add(&parallel, &t, parents[i % 4]);
+        ids[i + 1] = transform_hierarchy_add(&serial, &t, ids[i]);
+        transform_hierarchy_add(&parallel, &t, ids[i]);
+    }
+
+    transform_hierarchy_update(&serial, false);
+    transform_hierarchy_update(&parallel, true);
+    for (u32 i = 4; i < count; ++i) {
+        expect_to_be_true(matrices_close(transform_hierarchy_world_get(&serial, ids[i]), transform_hierarchy_world_get(&parallel, ids[i])));
+    }
+
+    transform_hierarchy_destroy(&serial);
+    transform_hierarchy_destroy(&parallel);
+    kfree(serial_memory, size, MEMORY_TAG_TRANSFORM);
+    kfree(parallel_memory, size, MEMORY_TAG_TRANSFORM);
+    return true;
+}
+
+void transform_hierarchy_register_tests() {
+    test_manager_register_test(transform_hierarchy_should_match_transform_world, "Transform hierarchy world matrices should match transform_get_world");
+    test_manager_register_test(transform_hierarchy_should_only_update_dirty_branches, "Transform hierarchy should only update dirty branches");
+    test_manager_register_test(transform_hierarchy_should_reparent_and_remove, "Transform hierarchy should reparent and remove transforms");
+    test_manager_register_test(transform_hierarchy_parallel_update_should_match_serial, "Transform hierarchy parallel update should match serial update");
+}
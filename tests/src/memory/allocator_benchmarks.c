@@ -0,0 +1,171 @@
+#include "allocator_benchmarks.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <memory/dynamic_allocator.h>
+#include <memory/host_allocator.h>
+#include <memory/linear_allocator.h>
+#include <memory/pool_allocator.h>
+
+// The number of blocks held at once, freed in a different order than they were allocated.
+#define ALLOCATOR_BENCH_LIVE_COUNT 256
+
+// The sizes of the blocks, cycled through, from small objects up to a few pages.
+static const u64 block_sizes[] = {16, 48, 64, 200, 256, 1024, 4000, 16384};
+#define BLOCK_SIZE_COUNT (sizeof(block_sizes) / sizeof(block_sizes[0]))
+
+#define ALLOCATOR_BENCH_POOL_BLOCK_SIZE 64
+#define ALLOCATOR_BENCH_LINEAR_SIZE MEBIBYTES(64)
+#define ALLOCATOR_BENCH_DYNAMIC_SIZE MEBIBYTES(64)
+
+// Written to so that the compiler can't drop the work being timed.
+static volatile u64 allocator_bench_sink;
+
+static void* live[ALLOCATOR_BENCH_LIVE_COUNT];
+static void* allocator_memory;
+static u64 allocator_memory_requirement;
+
+static linear_allocator linear;
+static pool_allocator pool;
+static dynamic_allocator dynamic;
+static host_allocator host;
+
+// The order blocks are freed in: every block once, striding through them.
+static u32 free_index(u32 i) {
+    return (i * 97) % ALLOCATOR_BENCH_LIVE_COUNT;
+}
+
+static u8 linear_setup() {
+    linear_allocator_create(ALLOCATOR_BENCH_LINEAR_SIZE, 0, &linear);
+    return linear.memory != 0;
+}
+
+static u8 linear_teardown() {
+    linear_allocator_destroy(&linear);
+    return true;
+}
+
+// Timed per allocation, including an occasional free_all once full, as a frame allocator is.
+static u8 linear_run(u32 op_count) {
+    for (u32 i = 0; i < op_count; ++i) {
+        u64 size = block_sizes[i % BLOCK_SIZE_COUNT];
+        if (linear.allocated + size > linear.total_size) {
+            linear_allocator_free_all(&linear);
+        }
+        void* block = linear_allocator_allocate(&linear, size);
+        if (!block) {
+            return false;
+        }
+        allocator_bench_sink = (u64)block;
+    }
+    linear_allocator_free_all(&linear);
+    return true;
+}
+
+static u8 pool_setup() {
+    pool_allocator_create(ALLOCATOR_BENCH_POOL_BLOCK_SIZE, 16, ALLOCATOR_BENCH_LIVE_COUNT, &allocator_memory_requirement, 0, 0);
+    allocator_memory = kallocate(allocator_memory_requirement, MEMORY_TAG_APPLICATION);
+    return pool_allocator_create(ALLOCATOR_BENCH_POOL_BLOCK_SIZE, 16, ALLOCATOR_BENCH_LIVE_COUNT, &allocator_memory_requirement, allocator_memory, &pool);
+}
+
+static u8 pool_teardown() {
+    pool_allocator_destroy(&pool);
+    kfree(allocator_memory, allocator_memory_requirement, MEMORY_TAG_APPLICATION);
+    allocator_memory = 0;
+    return true;
+}
+
+// Timed per allocation and free pair.
+static u8 pool_run(u32 op_count) {
+    for (u32 done = 0; done < op_count; done += ALLOCATOR_BENCH_LIVE_COUNT) {
+        for (u32 i = 0; i < ALLOCATOR_BENCH_LIVE_COUNT; ++i) {
+            live[i] = pool_allocator_allocate(&pool);
+            if (!live[i]) {
+                return false;
+            }
+        }
+        for (u32 i = 0; i < ALLOCATOR_BENCH_LIVE_COUNT; ++i) {
+            pool_allocator_free(&pool, live[free_index(i)]);
+        }
+    }
+    return true;
+}
+
+static u8 dynamic_setup() {
+    dynamic_allocator_create(ALLOCATOR_BENCH_DYNAMIC_SIZE, &allocator_memory_requirement, 0, 0);
+    allocator_memory = kallocate(allocator_memory_requirement, MEMORY_TAG_APPLICATION);
+    return dynamic_allocator_create(ALLOCATOR_BENCH_DYNAMIC_SIZE, &allocator_memory_requirement, allocator_memory, &dynamic);
+}
+
+static u8 dynamic_teardown() {
+    dynamic_allocator_destroy(&dynamic);
+    kfree(allocator_memory, allocator_memory_requirement, MEMORY_TAG_APPLICATION);
+    allocator_memory = 0;
+    return true;
+}
+
+// Timed per allocation and free pair, of mixed sizes.
+static u8 dynamic_run(u32 op_count) {
+    for (u32 done = 0; done < op_count; done += ALLOCATOR_BENCH_LIVE_COUNT) {
+        for (u32 i = 0; i < ALLOCATOR_BENCH_LIVE_COUNT; ++i) {
+            live[i] = dynamic_allocator_allocate_aligned(&dynamic, block_sizes[i % BLOCK_SIZE_COUNT], 16);
+            if (!live[i]) {
+                return false;
+            }
+        }
+        for (u32 i = 0; i < ALLOCATOR_BENCH_LIVE_COUNT; ++i) {
+            dynamic_allocator_free_aligned(&dynamic, live[free_index(i)]);
+        }
+    }
+    return true;
+}
+
+static u8 host_setup() {
+    return host_allocator_create(MEBIBYTES(4), 2, MEMORY_TAG_RENDERER, &host);
+}
+
+static u8 host_teardown() {
+    host_allocator_destroy(&host);
+    return true;
+}
+
+// Timed per allocation and free pair, of mixed sizes, once the pools are warm.
+static u8 host_run(u32 op_count) {
+    for (u32 done = 0; done < op_count; done += ALLOCATOR_BENCH_LIVE_COUNT) {
+        for (u32 i = 0; i < ALLOCATOR_BENCH_LIVE_COUNT; ++i) {
+            live[i] = host_allocator_allocate(&host, block_sizes[i % BLOCK_SIZE_COUNT], 16, false);
+            if (!live[i]) {
+                return false;
+            }
+        }
+        for (u32 i = 0; i < ALLOCATOR_BENCH_LIVE_COUNT; ++i) {
+            host_allocator_free(&host, live[free_index(i)]);
+        }
+    }
+    return true;
+}
+
+// Timed per transient allocation, moving on to the next arena every so often as frames do.
+static u8 host_transient_run(u32 op_count) {
+    for (u32 i = 0; i < op_count; ++i) {
+        void* block = host_allocator_allocate(&host, block_sizes[i % BLOCK_SIZE_COUNT], 16, true);
+        if (!block) {
+            return false;
+        }
+        host_allocator_free(&host, block);
+        if (i % 1024 == 1023) {
+            host_allocator_frame_begin(&host);
+        }
+    }
+    return true;
+}
+
+void allocator_register_benchmarks() {
+    test_manager_register_benchmark(linear_setup, linear_run, linear_teardown, 100000, "allocator.linear_allocate");
+    test_manager_register_benchmark(pool_setup, pool_run, pool_teardown, ALLOCATOR_BENCH_LIVE_COUNT * 400, "allocator.pool_allocate_free");
+    test_manager_register_benchmark(dynamic_setup, dynamic_run, dynamic_teardown, ALLOCATOR_BENCH_LIVE_COUNT * 100, "allocator.dynamic_allocate_free");
+    test_manager_register_benchmark(host_setup, host_run, host_teardown, ALLOCATOR_BENCH_LIVE_COUNT * 400, "allocator.host_allocate_free");
+    test_manager_register_benchmark(host_setup, host_transient_run, host_teardown, 100000, "allocator.host_transient");
+}
@@ -687,6 +687,61 @@ u8 dynamic_allocator_multiple_alloc_and_free_aligned_different_alignments_random
     return true;
 }
 
+u8 dynamic_allocator_should_reallocate() {
+    dynamic_allocator alloc;
+    u64 memory_requirement = 0;
+    const u64 allocator_size = 4096;
+    dynamic_allocator_create(allocator_size, &memory_requirement, 0, 0);
+    void* memory = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    expect_to_be_true(dynamic_allocator_create(allocator_size, &memory_requirement, memory, &alloc));
+
+    u8* block = dynamic_allocator_allocate_aligned(&alloc, 64, 16);
+    expect_should_not_be(0, block);
+    for (u32 i = 0; i < 64; ++i) {
+        block[i] = (u8)i;
+    }
+    u64 free_space = dynamic_allocator_free_space(&alloc);
+
+    // Nothing follows the block, so it should grow in place.
+    u8* grown = dynamic_allocator_reallocate(&alloc, block, 512);
+    expect_should_be(block, grown);
+    expect_should_be(free_space - (512 - 64), dynamic_allocator_free_space(&alloc));
+    u64 size = 0;
+    u16 alignment = 0;
+    dynamic_allocator_get_size_alignment(grown, &size, &alignment);
+    expect_should_be(512, size);
+    expect_should_be(16, alignment);
+
+    // Shrinking should also stay in place, and give the space back.
+    u8* shrunk = dynamic_allocator_reallocate(&alloc, grown, 32);
+    expect_should_be(block, shrunk);
+    expect_should_be(free_space + 32, dynamic_allocator_free_space(&alloc));
+
+    // Once something follows the block, growing has to move it.
+    void* blocker = dynamic_allocator_allocate(&alloc, 64);
+    expect_should_not_be(0, blocker);
+    u8* moved = dynamic_allocator_reallocate(&alloc, shrunk, 1024);
+    expect_should_not_be(0, moved);
+    expect_should_not_be(block, moved);
+    expect_should_be(0, (u64)moved % 16);
+    for (u32 i = 0; i < 32; ++i) {
+        expect_should_be(i, moved[i]);
+    }
+
+    // Asking for more than there is should fail, and leave the block alone.
+    KDEBUG("Note: The following errors are intentionally caused by this test.");
+    expect_should_be(0, dynamic_allocator_reallocate(&alloc, moved, allocator_size * 2));
+    expect_should_be(31, moved[31]);
+
+    expect_to_be_true(dynamic_allocator_free_aligned(&alloc, moved));
+    expect_to_be_true(dynamic_allocator_free(&alloc, blocker, 64));
+    expect_should_be(allocator_size, dynamic_allocator_free_space(&alloc));
+
+    dynamic_allocator_destroy(&alloc);
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
 void dynamic_allocator_register_tests() {
     test_manager_register_test(dynamic_allocator_should_create_and_destroy, "Dynamic allocator should create and destroy");
     test_manager_register_test(dynamic_allocator_single_allocation_all_space, "Dynamic allocator single alloc for all space");
@@ -697,4 +752,5 @@ void dynamic_allocator_register_tests() {
     test_manager_register_test(dynamic_allocator_multiple_alloc_aligned_different_alignments, "Dynamic allocator multiple aligned allocations with different alignments");
     test_manager_register_test(dynamic_allocator_multiple_alloc_aligned_different_alignments_random, "Dynamic allocator multiple aligned allocations with different alignments in random order.");
     test_manager_register_test(dynamic_allocator_multiple_alloc_and_free_aligned_different_alignments_random, "Dynamic allocator randomization test.");
+    test_manager_register_test(dynamic_allocator_should_reallocate, "Dynamic allocator should reallocate in place where possible.");
 }
@@ -0,0 +1,86 @@
+#include "frame_arena_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <containers/darray.h>
+#include <memory/frame_arena.h>
+
+u8 frame_arena_should_rotate_buffers() {
+    frame_arena arena;
+    expect_to_be_true(frame_arena_create(1024, 2, &arena));
+    expect_should_be(2, arena.buffer_count);
+
+    // Allocations from one frame should survive the next, and be wiped the frame after.
+    linear_allocator* first = frame_arena_allocator(&arena);
+    void* block = frame_arena_allocate(&arena, 64);
+    expect_should_not_be(0, block);
+    expect_should_be(64, first->allocated);
+
+    frame_arena_begin_frame(&arena);
+    linear_allocator* second = frame_arena_allocator(&arena);
+    expect_should_not_be(first, second);
+    expect_should_be(64, first->allocated);
+    expect_should_be(0, second->allocated);
+
+    frame_arena_begin_frame(&arena);
+    expect_should_be(first, frame_arena_allocator(&arena));
+    expect_should_be(0, first->allocated);
+
+    frame_arena_destroy(&arena);
+    expect_should_be(0, arena.buffer_count);
+    return true;
+}
+
+u8 frame_arena_darray_should_grow_within_arena() {
+    frame_arena arena;
+    expect_to_be_true(frame_arena_create(4096, 2, &arena));
+    linear_allocator* allocator = frame_arena_allocator(&arena);
+
+    u32* values = darray_create_with_allocator(u32, allocator);
+    for (u32 i = 0; i < 64; ++i) {
+        darray_push(values, i);
+    }
+    expect_should_be(64, darray_length(values));
+    for (u32 i = 0; i < 64; ++i) {
+        expect_should_be(i, values[i]);
+    }
+    // The array and every copy made while growing should have come from the arena.
+    expect_to_be_true((u8*)values > (u8*)allocator->memory && (u8*)values < (u8*)allocator->memory + allocator->total_size);
+    expect_to_be_true(allocator->allocated > 64 * sizeof(u32));
+
+    // Destroying does nothing, as the memory is reclaimed with the frame.
+    u64 allocated = allocator->allocated;
+    darray_destroy(values);
+    expect_should_be(allocated, allocator->allocated);
+
+    frame_arena_destroy(&arena);
+    return true;
+}
+
+u8 frame_arena_darray_should_fall_back_to_heap() {
+    frame_arena arena;
+    // Buffers are reserved in whole commit granules, so this holds a single granule.
+    expect_to_be_true(frame_arena_create(128, 1, &arena));
+    linear_allocator* allocator = frame_arena_allocator(&arena);
+    expect_should_be(LINEAR_ALLOCATOR_COMMIT_GRANULARITY, allocator->total_size);
+
+    // Too large for the arena, so the array should be placed on the heap instead.
+    KDEBUG("Note: The following errors are intentionally caused by this test.");
+    u64* values = darray_reserve_with_allocator(u64, LINEAR_ALLOCATOR_COMMIT_GRANULARITY / sizeof(u64), allocator);
+    expect_should_not_be(0, values);
+    expect_should_be(0, allocator->allocated);
+    darray_push(values, (u64)42);
+    expect_should_be(42, values[0]);
+    darray_destroy(values);
+
+    frame_arena_destroy(&arena);
+    return true;
+}
+
+void frame_arena_register_tests() {
+    test_manager_register_test(frame_arena_should_rotate_buffers, "Frame arena should rotate between buffers");
+    test_manager_register_test(frame_arena_darray_should_grow_within_arena, "Frame arena darray should grow within the arena");
+    test_manager_register_test(frame_arena_darray_should_fall_back_to_heap, "Frame arena darray should fall back to the heap when full");
+}
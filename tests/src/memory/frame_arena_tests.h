@@ -0,0 +1,3 @@
+#pragma once
+
+void frame_arena_register_tests();
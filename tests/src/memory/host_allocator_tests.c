@@ -0,0 +1,193 @@
+#include "host_allocator_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/katomic.h>
+#include <core/kthread.h>
+#include <memory/host_allocator.h>
+
+u8 host_allocator_should_reuse_freed_blocks() {
+    host_allocator alloc;
+    expect_to_be_true(host_allocator_create(0, 0, MEMORY_TAG_VULKAN, &alloc));
+
+    void* block = host_allocator_allocate(&alloc, 100, 8, false);
+    expect_should_not_be(0, block);
+    expect_should_be(100, host_allocator_block_size(block));
+    expect_should_be(1, alloc.heap_allocation_count);
+    host_allocator_free(&alloc, block);
+
+    // A block of the same size class comes back from the pool rather than the heap.
+    void* reused = host_allocator_allocate(&alloc, 90, 8, false);
+    expect_should_be(block, reused);
+    expect_should_be(1, alloc.heap_allocation_count);
+    host_allocator_free(&alloc, reused);
+
+    // Too large for any pool.
+    void* large = host_allocator_allocate(&alloc, MEBIBYTES(1), 16, false);
+    expect_should_not_be(0, large);
+    expect_should_be(2, alloc.heap_allocation_count);
+    host_allocator_free(&alloc, large);
+
+    expect_should_be(0, host_allocator_allocate(&alloc, 0, 8, false));
+
+    host_allocator_destroy(&alloc);
+    return true;
+}
+
+u8 host_allocator_should_align_blocks() {
+    host_allocator alloc;
+    expect_to_be_true(host_allocator_create(KIBIBYTES(4), 2, MEMORY_TAG_VULKAN, &alloc));
+
+    u16 alignments[] = {1, 8, 16, 64, 256, 4096};
+    for (u32 i = 0; i < sizeof(alignments) / sizeof(alignments[0]); ++i) {
+        void* pooled = host_allocator_allocate(&alloc, 24, alignments[i], false);
+        void* transient = host_allocator_allocate(&alloc, 24, alignments[i], true);
+        expect_should_be(0, (u64)pooled % alignments[i]);
+        expect_should_be(0, (u64)transient % alignments[i]);
+        host_allocator_free(&alloc, pooled);
+        host_allocator_free(&alloc, transient);
+    }
+
+    host_allocator_destroy(&alloc);
+    return true;
+}
+
+u8 host_allocator_should_empty_arenas_once_freed() {
+    host_allocator alloc;
+    expect_to_be_true(host_allocator_create(KIBIBYTES(1), 2, MEMORY_TAG_VULKAN, &alloc));
+
+    void* first = host_allocator_allocate(&alloc, 64, 8, true);
+    expect_should_not_be(0, first);
+    expect_should_be(0, alloc.heap_allocation_count);
+
+    // A full arena falls back to the pools.
+    void* overflow = host_allocator_allocate(&alloc, KIBIBYTES(2), 8, true);
+    expect_should_not_be(0, overflow);
+    expect_should_be(1, alloc.heap_allocation_count);
+    host_allocator_free(&alloc, overflow);
+
+    // The arena still in use is kept as it is when it comes around again.
+    host_allocator_frame_begin(&alloc);
+    host_allocator_frame_begin(&alloc);
+    void* second = host_allocator_allocate(&alloc, 64, 8, true);
+    expect_should_not_be(first, second);
+
+    // Once freed, it is emptied.
+    host_allocator_free(&alloc, first);
+    host_allocator_free(&alloc, second);
+    host_allocator_frame_begin(&alloc);
+    host_allocator_frame_begin(&alloc);
+    void* third = host_allocator_allocate(&alloc, 64, 8, true);
+    expect_should_be(first, third);
+    host_allocator_free(&alloc, third);
+
+    host_allocator_destroy(&alloc);
+    return true;
+}
+
+u8 host_allocator_should_reallocate_in_place_or_by_copy() {
+    host_allocator alloc;
+    expect_to_be_true(host_allocator_create(0, 0, MEMORY_TAG_VULKAN, &alloc));
+
+    u8* block = host_allocator_allocate(&alloc, 40, 8, false);
+    for (u8 i = 0; i < 40; ++i) {
+        block[i] = i;
+    }
+
+    // Still fits its size class.
+    u8* grown = host_allocator_reallocate(&alloc, block, 44, 8, false);
+    expect_should_be(block, grown);
+    expect_should_be(44, host_allocator_block_size(grown));
+
+    // Needs a larger one.
+    u8* moved = host_allocator_reallocate(&alloc, grown, 1000, 8, false);
+    expect_should_not_be(0, moved);
+    expect_should_not_be(grown, moved);
+    for (u8 i = 0; i < 40; ++i) {
+        expect_should_be(i, moved[i]);
+    }
+
+    // The original alignment must be kept.
+    expect_should_be(0, host_allocator_reallocate(&alloc, moved, 2000, 16, false));
+
+    expect_should_be(0, host_allocator_reallocate(&alloc, moved, 0, 8, false));
+
+    host_allocator_destroy(&alloc);
+    return true;
+}
+
+#define HOST_ALLOCATOR_TEST_THREAD_COUNT 4
+#define HOST_ALLOCATOR_TEST_BLOCKS_PER_THREAD 64
+
+typedef struct host_allocator_test_thread {
+    host_allocator* alloc;
+    u32 index;
+    volatile u32* failed_count;
+    volatile u32* finished_count;
+} host_allocator_test_thread;
+
+static u32 host_allocator_test_churn(void* params) {
+    host_allocator_test_thread* thread = params;
+    u32* blocks[HOST_ALLOCATOR_TEST_BLOCKS_PER_THREAD];
+    for (u32 round = 0; round < 64; ++round) {
+        for (u32 i = 0; i < HOST_ALLOCATOR_TEST_BLOCKS_PER_THREAD; ++i) {
+            u64 size = 16 + ((i * 37 + round) % 512);
+            blocks[i] = host_allocator_allocate(thread->alloc, size, 16, (i & 1) != 0);
+            if (!blocks[i]) {
+                katomic_fetch_add(thread->failed_count, 1);
+                continue;
+            }
+            blocks[i][0] = thread->index;
+        }
+        // No block should have been handed to another thread meanwhile.
+        for (u32 i = 0; i < HOST_ALLOCATOR_TEST_BLOCKS_PER_THREAD; ++i) {
+            if (blocks[i]) {
+                if (blocks[i][0] != thread->index) {
+                    katomic_fetch_add(thread->failed_count, 1);
+                }
+                host_allocator_free(thread->alloc, blocks[i]);
+            }
+        }
+    }
+    katomic_fetch_add(thread->finished_count, 1);
+    return 0;
+}
+
+u8 host_allocator_should_allocate_across_threads() {
+    host_allocator alloc;
+    expect_to_be_true(host_allocator_create(KIBIBYTES(64), 2, MEMORY_TAG_VULKAN, &alloc));
+
+    volatile u32 failed_count = 0;
+    volatile u32 finished_count = 0;
+    host_allocator_test_thread threads[HOST_ALLOCATOR_TEST_THREAD_COUNT];
+    kthread handles[HOST_ALLOCATOR_TEST_THREAD_COUNT];
+    for (u32 i = 0; i < HOST_ALLOCATOR_TEST_THREAD_COUNT; ++i) {
+        threads[i].alloc = &alloc;
+        threads[i].index = i;
+        threads[i].failed_count = &failed_count;
+        threads[i].finished_count = &finished_count;
+        expect_to_be_true(kthread_create(host_allocator_test_churn, &threads[i], true, &handles[i]));
+    }
+    // Frames move on while the threads allocate.
+    while (katomic_load_acquire(&finished_count) < HOST_ALLOCATOR_TEST_THREAD_COUNT) {
+        host_allocator_frame_begin(&alloc);
+    }
+
+    expect_should_be(0, failed_count);
+    for (u8 i = 0; i < alloc.arena_count; ++i) {
+        expect_should_be(0, alloc.arenas[i].outstanding);
+    }
+
+    host_allocator_destroy(&alloc);
+    return true;
+}
+
+void host_allocator_register_tests() {
+    test_manager_register_test(host_allocator_should_reuse_freed_blocks, "Host allocator should reuse freed blocks");
+    test_manager_register_test(host_allocator_should_align_blocks, "Host allocator should align blocks");
+    test_manager_register_test(host_allocator_should_empty_arenas_once_freed, "Host allocator should empty arenas once freed");
+    test_manager_register_test(host_allocator_should_reallocate_in_place_or_by_copy, "Host allocator should reallocate in place or by copy");
+    test_manager_register_test(host_allocator_should_allocate_across_threads, "Host allocator should allocate across threads");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void host_allocator_register_tests();
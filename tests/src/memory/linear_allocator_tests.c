@@ -108,10 +108,52 @@ u8 linear_allocator_multi_allocation_all_space_then_free() {
     return true;
 }
 
+u8 linear_allocator_reserved_should_commit_on_demand() {
+    u64 reserve_size = LINEAR_ALLOCATOR_COMMIT_GRANULARITY * 16;
+    linear_allocator alloc;
+    expect_to_be_true(linear_allocator_create_reserved(reserve_size, &alloc));
+    expect_should_not_be(0, alloc.memory);
+    expect_should_be(reserve_size, alloc.total_size);
+    expect_should_be(0, alloc.committed);
+
+    // The first allocation commits a single granule.
+    u8* first = linear_allocator_allocate(&alloc, 100);
+    expect_should_be(alloc.memory, first);
+    expect_should_be(LINEAR_ALLOCATOR_COMMIT_GRANULARITY, alloc.committed);
+    first[99] = 0xFF;
+
+    // Crossing into more granules commits only what is needed, and nothing moves.
+    u8* second = linear_allocator_allocate(&alloc, LINEAR_ALLOCATOR_COMMIT_GRANULARITY * 2);
+    expect_should_be(first + 100, second);
+    expect_should_be(LINEAR_ALLOCATOR_COMMIT_GRANULARITY * 3, alloc.committed);
+    second[LINEAR_ALLOCATOR_COMMIT_GRANULARITY * 2 - 1] = 0xFF;
+    expect_should_be(0xFF, first[99]);
+
+    // Free all should zero what was used, but keep it committed.
+    linear_allocator_free_all(&alloc);
+    expect_should_be(0, alloc.allocated);
+    expect_should_be(LINEAR_ALLOCATOR_COMMIT_GRANULARITY * 3, alloc.committed);
+    expect_should_be(0, first[99]);
+    expect_should_be(0, second[LINEAR_ALLOCATOR_COMMIT_GRANULARITY * 2 - 1]);
+
+    // Allocating everything should work, but not a byte more.
+    expect_should_not_be(0, linear_allocator_allocate(&alloc, reserve_size));
+    expect_should_be(reserve_size, alloc.committed);
+    KDEBUG("Note: The following error is intentionally caused by this test.");
+    expect_should_be(0, linear_allocator_allocate(&alloc, 1));
+
+    linear_allocator_destroy(&alloc);
+    expect_should_be(0, alloc.memory);
+    expect_should_be(0, alloc.committed);
+
+    return true;
+}
+
 void linear_allocator_register_tests() {
     test_manager_register_test(linear_allocator_should_create_and_destroy, "Linear allocator should create and destroy");
     test_manager_register_test(linear_allocator_single_allocation_all_space, "Linear allocator single alloc for all space");
     test_manager_register_test(linear_allocator_multi_allocation_all_space, "Linear allocator multi alloc for all space");
     test_manager_register_test(linear_allocator_multi_allocation_over_allocate, "Linear allocator try over allocate");
     test_manager_register_test(linear_allocator_multi_allocation_all_space_then_free, "Linear allocator allocated should be 0 after free_all");
+    test_manager_register_test(linear_allocator_reserved_should_commit_on_demand, "Linear allocator reserved should commit on demand");
 }
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "pool_allocator_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <memory/pool_allocator.h>
+
+u8 pool_allocator_should_create_and_destroy() {
+    pool_allocator alloc;
+    u64 memory_requirement = 0;
+    // Get the memory requirement
+    b8 result = pool_allocator_create(sizeof(u64), 8, 16, &memory_requirement, 0, 0);
+    expect_to_be_true(result);
+
+    // Actually create the allocator.
+    void* memory = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    result = pool_allocator_create(sizeof(u64), 8, 16, &memory_requirement, memory, &alloc);
+    expect_to_be_true(result);
+    expect_should_not_be(0, alloc.blocks);
+    expect_should_be(16, pool_allocator_free_count(&alloc));
+
+    // Destroy the allocator.
+    pool_allocator_destroy(&alloc);
+    expect_should_be(0, alloc.blocks);
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+u8 pool_allocator_multi_allocation_all_space() {
+    pool_allocator alloc;
+    u64 memory_requirement = 0;
+    const u32 block_count = 64;
+    const u16 alignment = 16;
+    pool_allocator_create(24, alignment, block_count, &memory_requirement, 0, 0);
+    void* memory = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    b8 result = pool_allocator_create(24, alignment, block_count, &memory_requirement, memory, &alloc);
+    expect_to_be_true(result);
+
+    void* blocks[64];
+    for (u32 i = 0; i < block_count; ++i) {
+        blocks[i] = pool_allocator_allocate(&alloc);
+        expect_should_not_be(0, blocks[i]);
+        // Each block should honour the alignment and not overlap the previous one.
+        expect_should_be(0, (u64)blocks[i] % alignment);
+        if (i > 0) {
+            expect_to_be_true((u8*)blocks[i] >= (u8*)blocks[i - 1] + 24);
+        }
+        expect_should_be(block_count - i - 1, pool_allocator_free_count(&alloc));
+    }
+
+    // The pool is exhausted, so the next allocation should fail.
+    KDEBUG("Note: The following error is intentionally caused by this test.");
+    expect_should_be(0, pool_allocator_allocate(&alloc));
+
+    pool_allocator_destroy(&alloc);
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+u8 pool_allocator_free_and_reuse() {
+    pool_allocator alloc;
+    u64 memory_requirement = 0;
+    pool_allocator_create(sizeof(u64), 8, 4, &memory_requirement, 0, 0);
+    void* memory = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    pool_allocator_create(sizeof(u64), 8, 4, &memory_requirement, memory, &alloc);
+
+    void* a = pool_allocator_allocate(&alloc);
+    void* b = pool_allocator_allocate(&alloc);
+    void* c = pool_allocator_allocate(&alloc);
+    expect_should_be(1, pool_allocator_free_count(&alloc));
+
+    // The most recently freed block should be handed out first.
+    expect_to_be_true(pool_allocator_free(&alloc, b));
+    expect_to_be_true(pool_allocator_free(&alloc, a));
+    expect_should_be(3, pool_allocator_free_count(&alloc));
+    expect_should_be(a, pool_allocator_allocate(&alloc));
+    expect_should_be(b, pool_allocator_allocate(&alloc));
+
+    // Blocks which did not come from the pool should be rejected.
+    KDEBUG("Note: The following errors are intentionally caused by this test.");
+    expect_to_be_false(pool_allocator_free(&alloc, (u8*)c + 1));
+    expect_to_be_false(pool_allocator_free(&alloc, (u8*)memory + memory_requirement));
+
+    // Freeing everything should make the whole pool available again.
+    pool_allocator_free_all(&alloc);
+    expect_should_be(4, pool_allocator_free_count(&alloc));
+    for (u32 i = 0; i < 4; ++i) {
+        expect_should_not_be(0, pool_allocator_allocate(&alloc));
+    }
+
+    pool_allocator_destroy(&alloc);
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+void pool_allocator_register_tests() {
+    test_manager_register_test(pool_allocator_should_create_and_destroy, "Pool allocator should create and destroy");
+    test_manager_register_test(pool_allocator_multi_allocation_all_space, "Pool allocator multi alloc for all space");
+    test_manager_register_test(pool_allocator_free_and_reuse, "Pool allocator should free and reuse blocks");
+}
@@ -0,0 +1,75 @@
+#include "scratch_allocator_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <containers/darray.h>
+#include <memory/scratch_allocator.h>
+
+u8 scratch_allocator_should_free_to_nested_markers() {
+    linear_allocator* scratch = scratch_allocator_get();
+    expect_should_not_be(0, scratch);
+    expect_should_be(scratch, scratch_allocator_get());
+    expect_should_be(0, scratch->allocated);
+
+    linear_allocator_marker outer = linear_allocator_get_marker(scratch);
+    u8* outer_block = linear_allocator_allocate(scratch, 256);
+    expect_should_not_be(0, outer_block);
+    outer_block[255] = 0xFF;
+
+    // Everything allocated after the inner marker goes when freeing to it, but nothing before.
+    linear_allocator_marker inner = linear_allocator_get_marker(scratch);
+    expect_should_be(256, inner);
+    u8* inner_block = linear_allocator_allocate(scratch, 1024);
+    inner_block[0] = 0xFF;
+    linear_allocator_free_to_marker(scratch, inner);
+    expect_should_be(256, scratch->allocated);
+    expect_should_be(0xFF, outer_block[255]);
+    expect_should_be(0, inner_block[0]);
+
+    linear_allocator_free_to_marker(scratch, outer);
+    expect_should_be(0, scratch->allocated);
+    expect_should_be(0, outer_block[255]);
+
+    scratch_allocator_release();
+    expect_should_be(0, scratch->memory);
+    return true;
+}
+
+u8 scratch_allocator_darray_should_grow_in_place() {
+    linear_allocator* scratch = scratch_allocator_get();
+    linear_allocator_marker marker = linear_allocator_get_marker(scratch);
+
+    // The newest block on the allocator is extended rather than copied.
+    u32* values = darray_create_with_allocator(u32, scratch);
+    u32* first = values;
+    for (u32 i = 0; i < 1000; ++i) {
+        darray_push(values, i);
+    }
+    expect_should_be(first, values);
+    for (u32 i = 0; i < 1000; ++i) {
+        expect_should_be(i, values[i]);
+    }
+
+    // Once something else has been allocated, growing has to copy.
+    u32* other = darray_create_with_allocator(u32, scratch);
+    u64 capacity = darray_capacity(values);
+    for (u32 i = (u32)darray_length(values); i <= capacity; ++i) {
+        darray_push(values, i);
+    }
+    expect_should_not_be(first, values);
+    expect_should_be(capacity, values[capacity]);
+    darray_destroy(other);
+    darray_destroy(values);
+
+    linear_allocator_free_to_marker(scratch, marker);
+    expect_should_be(0, scratch->allocated);
+    scratch_allocator_release();
+    return true;
+}
+
+void scratch_allocator_register_tests() {
+    test_manager_register_test(scratch_allocator_should_free_to_nested_markers, "Scratch allocator should free to nested markers");
+    test_manager_register_test(scratch_allocator_darray_should_grow_in_place, "Scratch allocator darray should grow in place");
+}
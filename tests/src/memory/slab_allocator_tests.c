@@ -0,0 +1,113 @@
+#include "slab_allocator_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <memory/slab_allocator.h>
+
+u8 slab_allocator_should_create_and_destroy() {
+    slab_allocator alloc;
+    u64 memory_requirement = 0;
+    // Get the memory requirement
+    b8 result = slab_allocator_create(SLAB_ALLOCATOR_SLAB_SIZE * 4, &memory_requirement, 0, 0);
+    expect_to_be_true(result);
+
+    // Actually create the allocator.
+    void* memory = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    result = slab_allocator_create(SLAB_ALLOCATOR_SLAB_SIZE * 4, &memory_requirement, memory, &alloc);
+    expect_to_be_true(result);
+    expect_should_not_be(0, alloc.memory);
+    expect_should_be(4, slab_allocator_free_slab_count(&alloc));
+
+    // Destroy the allocator.
+    slab_allocator_destroy(&alloc);
+    expect_should_be(0, alloc.memory);
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+u8 slab_allocator_size_classes() {
+    slab_allocator alloc;
+    u64 memory_requirement = 0;
+    slab_allocator_create(SLAB_ALLOCATOR_SLAB_SIZE * 4, &memory_requirement, 0, 0);
+    void* memory = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    slab_allocator_create(SLAB_ALLOCATOR_SLAB_SIZE * 4, &memory_requirement, memory, &alloc);
+
+    // Different size classes should come from different slabs.
+    void* small = slab_allocator_allocate(&alloc, 12);
+    void* medium = slab_allocator_allocate(&alloc, 100);
+    void* large = slab_allocator_allocate(&alloc, SLAB_ALLOCATOR_MAX_BLOCK_SIZE);
+    expect_should_not_be(0, small);
+    expect_should_not_be(0, medium);
+    expect_should_not_be(0, large);
+    expect_should_be(0, (u64)small % SLAB_ALLOCATOR_MIN_BLOCK_SIZE);
+    expect_should_be(0, (u64)medium % SLAB_ALLOCATOR_MIN_BLOCK_SIZE);
+    expect_should_be(1, slab_allocator_free_slab_count(&alloc));
+
+    // Sizes within the same class should share a slab, one block apart.
+    void* small2 = slab_allocator_allocate(&alloc, 16);
+    expect_should_be((u8*)small + 16, small2);
+    expect_should_be(1, slab_allocator_free_slab_count(&alloc));
+
+    // Requests above the largest class should fail.
+    KDEBUG("Note: The following error is intentionally caused by this test.");
+    expect_should_be(0, slab_allocator_allocate(&alloc, SLAB_ALLOCATOR_MAX_BLOCK_SIZE + 1));
+
+    // Emptying a slab should return it for reuse.
+    expect_to_be_true(slab_allocator_free(&alloc, small));
+    expect_to_be_true(slab_allocator_free(&alloc, small2));
+    expect_to_be_true(slab_allocator_free(&alloc, medium));
+    expect_to_be_true(slab_allocator_free(&alloc, large));
+    expect_should_be(4, slab_allocator_free_slab_count(&alloc));
+
+    slab_allocator_destroy(&alloc);
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+u8 slab_allocator_fill_and_free_all() {
+    slab_allocator alloc;
+    u64 memory_requirement = 0;
+    slab_allocator_create(SLAB_ALLOCATOR_SLAB_SIZE * 2, &memory_requirement, 0, 0);
+    void* memory = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    slab_allocator_create(SLAB_ALLOCATOR_SLAB_SIZE * 2, &memory_requirement, memory, &alloc);
+
+    // Fill both slabs with the largest size class.
+    const u32 block_count = (SLAB_ALLOCATOR_SLAB_SIZE / SLAB_ALLOCATOR_MAX_BLOCK_SIZE) * 2;
+    void* blocks[(SLAB_ALLOCATOR_SLAB_SIZE / SLAB_ALLOCATOR_MAX_BLOCK_SIZE) * 2];
+    for (u32 i = 0; i < block_count; ++i) {
+        blocks[i] = slab_allocator_allocate(&alloc, SLAB_ALLOCATOR_MAX_BLOCK_SIZE);
+        expect_should_not_be(0, blocks[i]);
+    }
+    expect_should_be(0, slab_allocator_free_slab_count(&alloc));
+
+    // Every slab is in use, so no other class can be served.
+    KDEBUG("Note: The following error is intentionally caused by this test.");
+    expect_should_be(0, slab_allocator_allocate(&alloc, 16));
+
+    // Freeing a block from a full slab should make it available again.
+    expect_to_be_true(slab_allocator_free(&alloc, blocks[3]));
+    expect_should_be(blocks[3], slab_allocator_allocate(&alloc, SLAB_ALLOCATOR_MAX_BLOCK_SIZE));
+
+    // Invalid frees should be rejected.
+    KDEBUG("Note: The following errors are intentionally caused by this test.");
+    expect_to_be_false(slab_allocator_free(&alloc, (u8*)blocks[0] + 8));
+    expect_to_be_false(slab_allocator_free(&alloc, (u8*)memory + memory_requirement));
+
+    for (u32 i = 0; i < block_count; ++i) {
+        expect_to_be_true(slab_allocator_free(&alloc, blocks[i]));
+    }
+    expect_should_be(2, slab_allocator_free_slab_count(&alloc));
+
+    slab_allocator_destroy(&alloc);
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+void slab_allocator_register_tests() {
+    test_manager_register_test(slab_allocator_should_create_and_destroy, "Slab allocator should create and destroy");
+    test_manager_register_test(slab_allocator_size_classes, "Slab allocator should serve each size class from its own slabs");
+    test_manager_register_test(slab_allocator_fill_and_free_all, "Slab allocator should fill, reuse and release slabs");
+}
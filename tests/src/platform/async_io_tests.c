@@ -0,0 +1,123 @@
+#include "async_io_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <platform/async_io.h>
+#include <platform/filesystem.h>
+
+#include <stdio.h>  // remove
+
+#define ASYNC_IO_TEST_PATH "async_io_test.bin"
+// Not a whole number of chunks, so the last read is a short one.
+#define ASYNC_IO_TEST_SIZE (3 * ASYNC_IO_FILE_CHUNK_SIZE + 123)
+#define ASYNC_IO_TEST_READ_COUNT 16
+#define ASYNC_IO_TEST_READ_SIZE 4096
+
+static u8 test_byte(u64 i) {
+    return (u8)((i * 2654435761u) >> 13);
+}
+
+static b8 write_test_file(void) {
+    u8* bytes = kallocate(ASYNC_IO_TEST_SIZE, MEMORY_TAG_ARRAY);
+    for (u64 i = 0; i < ASYNC_IO_TEST_SIZE; ++i) {
+        bytes[i] = test_byte(i);
+    }
+    file_handle f;
+    b8 result = filesystem_open(ASYNC_IO_TEST_PATH, FILE_MODE_WRITE, true, &f);
+    if (result) {
+        u64 written = 0;
+        result = filesystem_write(&f, ASYNC_IO_TEST_SIZE, bytes, &written) && written == ASYNC_IO_TEST_SIZE;
+        filesystem_close(&f);
+    }
+    kfree(bytes, ASYNC_IO_TEST_SIZE, MEMORY_TAG_ARRAY);
+    return result;
+}
+
+static u8 run_async_io_tests(b8 force_worker_threads) {
+    expect_to_be_true(write_test_file());
+
+    async_io_system_config config = {};
+    config.force_worker_threads = force_worker_threads;
+    u64 memory_requirement = 0;
+    async_io_system_initialize(&memory_requirement, 0, config);
+    void* state = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    expect_to_be_true(async_io_system_initialize(&memory_requirement, state, config));
+    expect_to_be_true(async_io_system_is_running());
+
+    // The whole file, in several reads at once.
+    void* data = 0;
+    u64 size = 0;
+    expect_to_be_true(async_io_read_file(ASYNC_IO_TEST_PATH, MEMORY_TAG_ARRAY, &data, &size));
+    expect_should_be(ASYNC_IO_TEST_SIZE, size);
+    const u8* bytes = data;
+    for (u64 i = 0; i < ASYNC_IO_TEST_SIZE; ++i) {
+        if (bytes[i] != test_byte(i)) {
+            expect_should_be(test_byte(i), bytes[i]);
+        }
+    }
+    kfree(data, size, MEMORY_TAG_ARRAY);
+
+    // Many reads in flight, waited on in the opposite order to their submission.
+    async_file file;
+    expect_to_be_true(async_io_open(ASYNC_IO_TEST_PATH, &file));
+    expect_should_be(ASYNC_IO_TEST_SIZE, file.size);
+    u8* buffers = kallocate(ASYNC_IO_TEST_READ_COUNT * ASYNC_IO_TEST_READ_SIZE, MEMORY_TAG_ARRAY);
+    async_read reads[ASYNC_IO_TEST_READ_COUNT];
+    for (u32 i = 0; i < ASYNC_IO_TEST_READ_COUNT; ++i) {
+        u64 offset = (u64)i * 196613;
+        expect_to_be_true(async_io_read(&file, offset, ASYNC_IO_TEST_READ_SIZE, buffers + i * ASYNC_IO_TEST_READ_SIZE, &reads[i]));
+    }
+    for (i32 i = ASYNC_IO_TEST_READ_COUNT - 1; i >= 0; --i) {
+        expect_to_be_true(async_io_wait(&reads[i]));
+        expect_to_be_true(async_io_is_complete(&reads[i]));
+        expect_should_be(ASYNC_IO_TEST_READ_SIZE, reads[i].bytes_read);
+        u64 offset = (u64)i * 196613;
+        for (u32 j = 0; j < ASYNC_IO_TEST_READ_SIZE; ++j) {
+            if (buffers[i * ASYNC_IO_TEST_READ_SIZE + j] != test_byte(offset + j)) {
+                expect_should_be(test_byte(offset + j), buffers[i * ASYNC_IO_TEST_READ_SIZE + j]);
+            }
+        }
+    }
+
+    // A read past the end of the file stops short, and one starting there reads nothing.
+    async_read tail;
+    expect_to_be_true(async_io_read(&file, ASYNC_IO_TEST_SIZE - 100, ASYNC_IO_TEST_READ_SIZE, buffers, &tail));
+    expect_to_be_true(async_io_wait(&tail));
+    expect_should_be(100, tail.bytes_read);
+    for (u32 j = 0; j < 100; ++j) {
+        expect_should_be(test_byte(ASYNC_IO_TEST_SIZE - 100 + j), buffers[j]);
+    }
+    expect_to_be_true(async_io_read(&file, ASYNC_IO_TEST_SIZE, ASYNC_IO_TEST_READ_SIZE, buffers, &tail));
+    expect_to_be_true(async_io_wait(&tail));
+    expect_should_be(0, tail.bytes_read);
+
+    kfree(buffers, ASYNC_IO_TEST_READ_COUNT * ASYNC_IO_TEST_READ_SIZE, MEMORY_TAG_ARRAY);
+    async_io_close(&file);
+    expect_to_be_false(file.is_valid);
+
+    remove(ASYNC_IO_TEST_PATH);
+    expect_to_be_false(async_io_open(ASYNC_IO_TEST_PATH, &file));
+    expect_to_be_false(async_io_read_file(ASYNC_IO_TEST_PATH, MEMORY_TAG_ARRAY, &data, &size));
+    expect_should_be(0, data);
+
+    async_io_system_shutdown(state);
+    expect_to_be_false(async_io_system_is_running());
+    kfree(state, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+u8 async_io_should_read_files() {
+    return run_async_io_tests(false);
+}
+
+u8 async_io_reading_threads_should_read_files() {
+    return run_async_io_tests(true);
+}
+
+void async_io_register_tests() {
+    test_manager_register_test(async_io_should_read_files, "Async I/O should read files with the platform's backend");
+    test_manager_register_test(async_io_reading_threads_should_read_files, "Async I/O should read files with reading threads");
+}
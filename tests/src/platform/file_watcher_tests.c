@@ -0,0 +1,98 @@
+#include "file_watcher_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kstring.h>
+#include <platform/file_watcher.h>
+#include <platform/filesystem.h>
+#include <platform/platform.h>
+
+#include <stdio.h>  // remove
+
+#if KPLATFORM_WINDOWS
+#include <direct.h>
+#define make_directory(path) _mkdir(path)
+#define remove_directory(path) _rmdir(path)
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#define make_directory(path) mkdir(path, 0755)
+#define remove_directory(path) rmdir(path)
+#endif
+
+#define FILE_WATCHER_TEST_DIRECTORY "file_watcher_test"
+
+static b8 write_file(const char* path) {
+    file_handle f;
+    if (!filesystem_open(path, FILE_MODE_WRITE, false, &f)) {
+        return false;
+    }
+    b8 result = filesystem_write_line(&f, "changed");
+    filesystem_close(&f);
+    return result;
+}
+
+// Waits up to a couple of seconds for a change to the given path, skipping any others.
+static b8 wait_for_change(file_watcher* watcher, const char* expected_path) {
+    char path[FILE_WATCHER_MAX_PATH_LENGTH];
+    f64 deadline = platform_get_absolute_time() + 2.0;
+    while (platform_get_absolute_time() < deadline) {
+        while (file_watcher_next_change(watcher, path, sizeof(path))) {
+            if (strings_equal(path, expected_path)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+u8 file_watcher_should_report_changed_files() {
+    remove(FILE_WATCHER_TEST_DIRECTORY "/sub/b.txt");
+    remove(FILE_WATCHER_TEST_DIRECTORY "/a.txt");
+    remove_directory(FILE_WATCHER_TEST_DIRECTORY "/sub");
+    remove_directory(FILE_WATCHER_TEST_DIRECTORY);
+    make_directory(FILE_WATCHER_TEST_DIRECTORY);
+
+    file_watcher watcher;
+    if (!file_watcher_create(FILE_WATCHER_TEST_DIRECTORY, &watcher)) {
+#if KPLATFORM_WINDOWS || KPLATFORM_LINUX
+        expect_to_be_true(false);
+#endif
+        // Watching is not supported here.
+        remove_directory(FILE_WATCHER_TEST_DIRECTORY);
+        return BYPASS;
+    }
+    expect_to_be_true(watcher.is_valid);
+
+    // Nothing has changed yet.
+    char path[FILE_WATCHER_MAX_PATH_LENGTH];
+    expect_to_be_false(file_watcher_next_change(&watcher, path, sizeof(path)));
+
+    expect_to_be_true(write_file(FILE_WATCHER_TEST_DIRECTORY "/a.txt"));
+    expect_to_be_true(wait_for_change(&watcher, "a.txt"));
+
+    // Directories created after the watch started are watched too; give the watcher a chance to pick it up first.
+    expect_should_be(0, make_directory(FILE_WATCHER_TEST_DIRECTORY "/sub"));
+    f64 settle = platform_get_absolute_time() + 0.05;
+    while (platform_get_absolute_time() < settle) {
+        file_watcher_next_change(&watcher, path, sizeof(path));
+    }
+    expect_to_be_true(write_file(FILE_WATCHER_TEST_DIRECTORY "/sub/b.txt"));
+    expect_to_be_true(wait_for_change(&watcher, "sub/b.txt"));
+
+    file_watcher_destroy(&watcher);
+    expect_to_be_false(watcher.is_valid);
+    expect_to_be_false(file_watcher_next_change(&watcher, path, sizeof(path)));
+
+    remove(FILE_WATCHER_TEST_DIRECTORY "/sub/b.txt");
+    remove(FILE_WATCHER_TEST_DIRECTORY "/a.txt");
+    remove_directory(FILE_WATCHER_TEST_DIRECTORY "/sub");
+    remove_directory(FILE_WATCHER_TEST_DIRECTORY);
+    return true;
+}
+
+void file_watcher_register_tests() {
+    test_manager_register_test(file_watcher_should_report_changed_files, "File watcher should report files changed in the watched tree");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void file_watcher_register_tests();
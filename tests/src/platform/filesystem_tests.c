@@ -0,0 +1,52 @@
+#include "filesystem_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <platform/filesystem.h>
+
+#include <stdio.h>  // remove
+
+#define FILESYSTEM_TEST_PATH "filesystem_test.bin"
+#define FILESYSTEM_TEST_SIZE 10000
+
+u8 filesystem_map_should_match_written_file() {
+    u8 bytes[FILESYSTEM_TEST_SIZE];
+    for (u32 i = 0; i < FILESYSTEM_TEST_SIZE; ++i) {
+        bytes[i] = (u8)(i * 31 + 7);
+    }
+    file_handle f;
+    expect_to_be_true(filesystem_open(FILESYSTEM_TEST_PATH, FILE_MODE_WRITE, true, &f));
+    u64 written = 0;
+    expect_to_be_true(filesystem_write(&f, FILESYSTEM_TEST_SIZE, bytes, &written));
+    filesystem_close(&f);
+
+    file_mapping mapping;
+    expect_to_be_true(filesystem_map(FILESYSTEM_TEST_PATH, &mapping));
+    expect_should_be(FILESYSTEM_TEST_SIZE, mapping.size);
+    expect_to_be_true((mapping.data != 0));
+    const u8* mapped = mapping.data;
+    for (u32 i = 0; i < FILESYSTEM_TEST_SIZE; ++i) {
+        expect_should_be(bytes[i], mapped[i]);
+    }
+    filesystem_unmap(&mapping);
+    expect_should_be(0, mapping.data);
+    expect_should_be(0, mapping.size);
+
+    // An empty file maps, with no data.
+    expect_to_be_true(filesystem_open(FILESYSTEM_TEST_PATH, FILE_MODE_WRITE, true, &f));
+    filesystem_close(&f);
+    expect_to_be_true(filesystem_map(FILESYSTEM_TEST_PATH, &mapping));
+    expect_should_be(0, mapping.size);
+    expect_should_be(0, mapping.data);
+    filesystem_unmap(&mapping);
+
+    remove(FILESYSTEM_TEST_PATH);
+    expect_to_be_false(filesystem_map(FILESYSTEM_TEST_PATH, &mapping));
+    return true;
+}
+
+void filesystem_register_tests() {
+    test_manager_register_test(filesystem_map_should_match_written_file, "Mapping a file should give its contents");
+}
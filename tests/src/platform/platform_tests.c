@@ -0,0 +1,45 @@
+#include "platform_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <platform/platform.h>
+
+u8 platform_absolute_time_should_be_monotonic() {
+    f64 previous = platform_get_absolute_time();
+    for (u32 i = 0; i < 100000; ++i) {
+        f64 now = platform_get_absolute_time();
+        expect_to_be_true((now >= previous));
+        previous = now;
+    }
+    return true;
+}
+
+u8 platform_wait_until_should_wake_on_time() {
+    // Already passed; returns straight away.
+    f64 start = platform_get_absolute_time();
+    platform_wait_until(start - 1.0);
+    expect_to_be_true((platform_get_absolute_time() - start < 0.001));
+
+    // Several frame-sized waits against a running deadline, as the frame limiter does.
+    const f64 interval = 0.004;
+    f64 deadline = platform_get_absolute_time();
+    f64 total_lateness = 0;
+    for (u32 i = 0; i < 10; ++i) {
+        deadline += interval;
+        platform_wait_until(deadline);
+        f64 now = platform_get_absolute_time();
+        // Never early.
+        expect_to_be_true((now >= deadline));
+        total_lateness += now - deadline;
+    }
+    // A loose bound, as the machine may be busy; millisecond sleeps miss by far more than this on average.
+    expect_to_be_true((total_lateness / 10 < 0.002));
+    return true;
+}
+
+void platform_register_tests() {
+    test_manager_register_test(platform_absolute_time_should_be_monotonic, "Platform absolute time should never go backwards");
+    test_manager_register_test(platform_wait_until_should_wake_on_time, "Platform wait until should wake at the target time");
+}
@@ -0,0 +1,63 @@
+#include "camera_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <math/kmath.h>
+#include <renderer/camera.h>
+
+u8 camera_should_rebuild_only_when_changed() {
+    camera c = camera_create();
+    camera_position_set(&c, (vec3){1.0f, 2.0f, 3.0f});
+
+    mat4 view = camera_view_get(&c);
+    u32 generation = c.generation;
+    camera_projection_get(&c);
+    camera_frustum_get(&c);
+    expect_should_be(generation, c.generation);
+
+    // The same aspect ratio changes nothing.
+    camera_aspect_set(&c, c.aspect_ratio);
+    camera_view_projection_get(&c);
+    expect_should_be(generation, c.generation);
+
+    camera_aspect_set(&c, 4.0f / 3.0f);
+    mat4 view_projection = camera_view_projection_get(&c);
+    expect_should_be(generation + 1, c.generation);
+    mat4 expected = mat4_mul(view, mat4_perspective(CAMERA_DEFAULT_FOV, 4.0f / 3.0f, CAMERA_DEFAULT_NEAR_CLIP, CAMERA_DEFAULT_FAR_CLIP));
+    for (u32 i = 0; i < 16; ++i) {
+        expect_float_to_be(expected.data[i], view_projection.data[i]);
+    }
+
+    camera_yaw(&c, 0.5f);
+    camera_view_get(&c);
+    expect_should_be(generation + 2, c.generation);
+    return true;
+}
+
+u8 camera_should_cull_with_its_frustum() {
+    camera c = camera_create();
+    camera_perspective_set(&c, deg_to_rad(60.0f), 0.1f, 100.0f);
+
+    // Looking down -z, so only what is ahead is inside.
+    const frustum* f = camera_frustum_get(&c);
+    vec3 ahead = {0.0f, 0.0f, -10.0f};
+    vec3 behind = {0.0f, 0.0f, 10.0f};
+    vec3 beyond = {0.0f, 0.0f, -200.0f};
+    expect_to_be_true(frustum_intersects_sphere(f, &ahead, 1.0f));
+    expect_to_be_false(frustum_intersects_sphere(f, &behind, 1.0f));
+    expect_to_be_false(frustum_intersects_sphere(f, &beyond, 1.0f));
+
+    // Turned around, the frustum follows.
+    camera_yaw(&c, K_PI);
+    f = camera_frustum_get(&c);
+    expect_to_be_false(frustum_intersects_sphere(f, &ahead, 1.0f));
+    expect_to_be_true(frustum_intersects_sphere(f, &behind, 1.0f));
+    return true;
+}
+
+void camera_register_tests() {
+    test_manager_register_test(camera_should_rebuild_only_when_changed, "Camera should rebuild only when changed");
+    test_manager_register_test(camera_should_cull_with_its_frustum, "Camera should cull with its frustum");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void camera_register_tests();
@@ -0,0 +1,160 @@
+#include "debug_draw_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <math/kmath.h>
+#include <memory/linear_allocator.h>
+#include <renderer/debug_draw.h>
+
+static void* debug_draw_start(u32 vertex_capacity, u64* out_size) {
+    debug_draw_initialize(vertex_capacity, out_size, 0);
+    void* state = kallocate(*out_size, MEMORY_TAG_ARRAY);
+    debug_draw_initialize(vertex_capacity, out_size, state);
+    return state;
+}
+
+static void debug_draw_stop(void* state, u64 size) {
+    debug_draw_shutdown(state);
+    kfree(state, size, MEMORY_TAG_ARRAY);
+}
+
+u8 debug_draw_should_gather_nothing_while_off() {
+    u64 size = 0;
+    void* state = debug_draw_start(64, &size);
+    linear_allocator allocator;
+    linear_allocator_create(KIBIBYTES(16), 0, &allocator);
+    vec4 colour = (vec4){1.0f, 0.0f, 0.0f, 1.0f};
+
+    expect_to_be_false(debug_draw_enabled());
+    debug_draw_line(vec3_zero(), vec3_one(), colour);
+    debug_draw_packet_data data;
+    expect_to_be_true(debug_draw_take(&allocator, &data));
+    expect_should_be(0, data.vertex_count);
+
+    // Turning off drops what was gathered.
+    debug_draw_enabled_set(true);
+    debug_draw_line(vec3_zero(), vec3_one(), colour);
+    debug_draw_enabled_set(false);
+    expect_to_be_true(debug_draw_take(&allocator, &data));
+    expect_should_be(0, data.vertex_count);
+
+    linear_allocator_destroy(&allocator);
+    debug_draw_stop(state, size);
+    // Calls made once shut down are ignored.
+    debug_draw_line(vec3_zero(), vec3_one(), colour);
+    expect_to_be_false(debug_draw_enabled());
+    return true;
+}
+
+u8 debug_draw_should_group_primitives_by_kind() {
+    u64 size = 0;
+    void* state = debug_draw_start(256, &size);
+    linear_allocator allocator;
+    linear_allocator_create(KIBIBYTES(64), 0, &allocator);
+    vec4 colour = (vec4){0.0f, 1.0f, 0.0f, 1.0f};
+    debug_draw_enabled_set(true);
+
+    // Drawn out of order, but taken by kind.
+    debug_draw_aabb((extents_3d){{-1.0f, -2.0f, -3.0f}, {1.0f, 2.0f, 3.0f}}, colour);
+    debug_draw_line(vec3_zero(), (vec3){0.0f, 5.0f, 0.0f}, colour);
+    debug_draw_sphere((bounding_sphere){{0.0f, 0.0f, 0.0f}, 2.0f}, colour);
+    debug_draw_line(vec3_zero(), (vec3){5.0f, 0.0f, 0.0f}, colour);
+
+    debug_draw_packet_data data;
+    expect_to_be_true(debug_draw_take(&allocator, &data));
+    expect_should_be(0, data.first_vertex[DEBUG_DRAW_PRIMITIVE_LINE]);
+    expect_should_be(4, data.vertex_counts[DEBUG_DRAW_PRIMITIVE_LINE]);
+    expect_should_be(4, data.first_vertex[DEBUG_DRAW_PRIMITIVE_BOX]);
+    expect_should_be(24, data.vertex_counts[DEBUG_DRAW_PRIMITIVE_BOX]);
+    expect_should_be(28, data.first_vertex[DEBUG_DRAW_PRIMITIVE_SPHERE]);
+    expect_should_be(DEBUG_DRAW_SPHERE_SEGMENTS * 6, data.vertex_counts[DEBUG_DRAW_PRIMITIVE_SPHERE]);
+    expect_should_be(0, data.vertex_counts[DEBUG_DRAW_PRIMITIVE_FRUSTUM]);
+    expect_should_be(28 + DEBUG_DRAW_SPHERE_SEGMENTS * 6, data.vertex_count);
+    expect_float_to_be(5.0f, data.vertices[1].position.y);
+    expect_float_to_be(5.0f, data.vertices[3].position.x);
+
+    // Every edge of the box runs along one axis, the length of the box along it.
+    f32 total_length = 0.0f;
+    for (u32 i = 0; i < 24; i += 2) {
+        vec3 a = data.vertices[4 + i].position;
+        vec3 b = data.vertices[4 + i + 1].position;
+        u32 axes = (a.x != b.x) + (a.y != b.y) + (a.z != b.z);
+        expect_should_be(1, axes);
+        total_length += vec3_distance(a, b);
+    }
+    expect_float_to_be(4.0f * (2.0f + 4.0f + 6.0f), total_length);
+
+    // Every point of the sphere is on it.
+    for (u32 i = 0; i < DEBUG_DRAW_SPHERE_SEGMENTS * 6; ++i) {
+        expect_float_to_be(2.0f, vec3_length(data.vertices[28 + i].position));
+    }
+
+    // Taking starts the next frame.
+    expect_to_be_true(debug_draw_take(&allocator, &data));
+    expect_should_be(0, data.vertex_count);
+
+    linear_allocator_destroy(&allocator);
+    debug_draw_stop(state, size);
+    return true;
+}
+
+u8 debug_draw_should_draw_the_corners_of_a_frustum() {
+    u64 size = 0;
+    void* state = debug_draw_start(64, &size);
+    linear_allocator allocator;
+    linear_allocator_create(KIBIBYTES(16), 0, &allocator);
+    debug_draw_enabled_set(true);
+
+    // The frustum of no view or projection is clip space itself.
+    debug_draw_frustum(mat4_identity(), vec4_one());
+    debug_draw_packet_data data;
+    expect_to_be_true(debug_draw_take(&allocator, &data));
+    expect_should_be(24, data.vertex_counts[DEBUG_DRAW_PRIMITIVE_FRUSTUM]);
+    const debug_vertex* vertices = &data.vertices[data.first_vertex[DEBUG_DRAW_PRIMITIVE_FRUSTUM]];
+    for (u32 i = 0; i < 24; ++i) {
+        expect_float_to_be(1.0f, kabs(vertices[i].position.x));
+        expect_float_to_be(1.0f, kabs(vertices[i].position.y));
+        expect_float_to_be(1.0f, kabs(vertices[i].position.z));
+    }
+
+    linear_allocator_destroy(&allocator);
+    debug_draw_stop(state, size);
+    return true;
+}
+
+u8 debug_draw_should_drop_primitives_which_do_not_fit() {
+    u64 size = 0;
+    void* state = debug_draw_start(30, &size);
+    linear_allocator allocator;
+    linear_allocator_create(KIBIBYTES(16), 0, &allocator);
+    vec4 colour = vec4_one();
+    debug_draw_enabled_set(true);
+
+    // One box fits, the second does not, and is dropped whole. Lines have room of their own.
+    debug_draw_aabb((extents_3d){{0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}}, colour);
+    debug_draw_aabb((extents_3d){{0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}}, colour);
+    debug_draw_line(vec3_zero(), vec3_one(), colour);
+
+    debug_draw_packet_data data;
+    expect_to_be_true(debug_draw_take(&allocator, &data));
+    expect_should_be(24, data.vertex_counts[DEBUG_DRAW_PRIMITIVE_BOX]);
+    expect_should_be(2, data.vertex_counts[DEBUG_DRAW_PRIMITIVE_LINE]);
+    expect_should_be(1, data.dropped_count);
+
+    expect_to_be_true(debug_draw_take(&allocator, &data));
+    expect_should_be(0, data.dropped_count);
+
+    linear_allocator_destroy(&allocator);
+    debug_draw_stop(state, size);
+    return true;
+}
+
+void debug_draw_register_tests() {
+    test_manager_register_test(debug_draw_should_gather_nothing_while_off, "Debug drawing should gather nothing while off");
+    test_manager_register_test(debug_draw_should_group_primitives_by_kind, "Debug drawing should group primitives by kind");
+    test_manager_register_test(debug_draw_should_draw_the_corners_of_a_frustum, "Debug drawing should draw the corners of a frustum");
+    test_manager_register_test(debug_draw_should_drop_primitives_which_do_not_fit, "Debug drawing should drop primitives which do not fit");
+}
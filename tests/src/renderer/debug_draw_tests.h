@@ -0,0 +1,3 @@
+#pragma once
+
+void debug_draw_register_tests();
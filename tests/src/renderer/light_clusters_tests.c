@@ -0,0 +1,175 @@
+#include "light_clusters_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <math/kmath.h>
+#include <renderer/light_clusters.h>
+
+// A view from the origin down -z, as the world view's camera looks before it is moved.
+static light_clusters_view test_view(void) {
+    light_clusters_view view;
+    view.view = mat4_identity();
+    view.projection = mat4_perspective(0.785398163f, 16.0f / 9.0f, 0.1f, 1000.0f);
+    view.near_clip = 0.1f;
+    view.far_clip = 1000.0f;
+    return view;
+}
+
+static point_light test_light(vec3 position, f32 radius) {
+    point_light light = {0};
+    light.position = position;
+    light.colour = (vec4){1.0f, 1.0f, 1.0f, 1.0f};
+    light.constant_f = 1.0f;
+    light.radius = radius;
+    return light;
+}
+
+static b8 cluster_lists(const light_cluster_data* data, u32 cluster, u32 light) {
+    for (u32 i = 0; i < data->clusters[cluster][1]; ++i) {
+        if (data->indices[data->clusters[cluster][0] + i] == light) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The same numbers every run.
+static f32 test_random(u32* seed, f32 min, f32 max) {
+    *seed = *seed * 1664525u + 1013904223u;
+    return min + (max - min) * ((*seed >> 8) / 16777216.0f);
+}
+
+u8 light_clusters_should_list_lights_only_where_they_reach() {
+    light_clusters* clusters = kallocate(sizeof(light_clusters), MEMORY_TAG_RENDERER);
+    light_clusters_view view = test_view();
+    directional_light sun = {{0.0f, -1.0f, 0.0f}, {1.0f, 1.0f, 1.0f, 1.0f}};
+    point_light lights[3] = {
+        // Ahead, in the middle of the screen.
+        test_light((vec3){0.0f, 0.0f, -10.0f}, 1.0f),
+        // Behind the camera.
+        test_light((vec3){0.0f, 0.0f, 10.0f}, 1.0f),
+        // Ahead, off to the right.
+        test_light((vec3){6.0f, 0.0f, -10.0f}, 1.0f)};
+    light_clusters_build(&view, &sun, 3, lights, clusters);
+
+    expect_should_be(LIGHT_CLUSTERS_X, clusters->data.dimensions[0]);
+    expect_should_be(3, clusters->data.dimensions[3]);
+    expect_should_be(0, clusters->dropped_index_count);
+    expect_should_be(0, clusters->dropped_light_count);
+    expect_float_to_be(-1.0f, clusters->data.directional_direction.y);
+    expect_to_be_true(clusters->ranges[1].culled);
+
+    u32 centre = light_clusters_index(&clusters->data, &view, (vec3){0.0f, 0.0f, -10.0f});
+    u32 right = light_clusters_index(&clusters->data, &view, (vec3){6.0f, 0.0f, -10.0f});
+    expect_to_be_true(centre != right);
+    expect_to_be_true(cluster_lists(&clusters->data, centre, 0));
+    expect_to_be_false(cluster_lists(&clusters->data, centre, 2));
+    expect_to_be_true(cluster_lists(&clusters->data, right, 2));
+    expect_to_be_false(cluster_lists(&clusters->data, right, 0));
+
+    // Nothing reaches the clusters far beyond the lights, and the light behind is listed nowhere.
+    u32 far = light_clusters_index(&clusters->data, &view, (vec3){0.0f, 0.0f, -500.0f});
+    expect_should_be(0, clusters->data.clusters[far][1]);
+    for (u32 i = 0; i < clusters->index_count; ++i) {
+        expect_should_not_be(1, clusters->data.indices[i]);
+    }
+
+    // Only what is used is uploaded.
+    expect_should_be(sizeof(u32) * 4 + sizeof(vec4) * 3 + sizeof(light_cluster_point_light) * 3, light_clusters_lights_size(&clusters->data));
+    expect_should_be(sizeof(clusters->data.clusters) + sizeof(u32) * clusters->index_count, light_clusters_lists_size(clusters));
+    kfree(clusters, sizeof(light_clusters), MEMORY_TAG_RENDERER);
+    return true;
+}
+
+u8 light_clusters_should_list_every_light_reaching_a_point() {
+    light_clusters* clusters = kallocate(sizeof(light_clusters), MEMORY_TAG_RENDERER);
+    light_clusters_view view = test_view();
+    // Looking from elsewhere, so the view matrix matters too.
+    view.view = mat4_inverse(mat4_mul(mat4_euler_y(0.7f), mat4_translation((vec3){3.0f, 2.0f, -4.0f})));
+    directional_light sun = {{0.0f, -1.0f, 0.0f}, {1.0f, 1.0f, 1.0f, 1.0f}};
+
+    // Enough lights to be clustered across job threads, where there are any.
+    const u32 light_count = 300;
+    point_light lights[300];
+    u32 seed = 7;
+    for (u32 i = 0; i < light_count; ++i) {
+        vec3 position = {test_random(&seed, -40.0f, 40.0f), test_random(&seed, -10.0f, 10.0f), test_random(&seed, -40.0f, 40.0f)};
+        lights[i] = test_light(position, test_random(&seed, 0.5f, 6.0f));
+    }
+    light_clusters_build(&view, &sun, light_count, lights, clusters);
+    expect_should_be(0, clusters->dropped_index_count);
+
+    // Every light whose sphere holds a point in the frustum must be listed in the cluster of the point.
+    u32 missing = 0;
+    u32 tested = 0;
+    for (u32 s = 0; s < 20000; ++s) {
+        vec3 point = {test_random(&seed, -40.0f, 40.0f), test_random(&seed, -10.0f, 10.0f), test_random(&seed, -40.0f, 40.0f)};
+        vec3 view_point = vec3_transform(point, view.view);
+        vec4 clip = vec4_mul_mat4(vec4_from_vec3(view_point, 1.0f), view.projection);
+        if (-view_point.z < view.near_clip || kabs(clip.x) > clip.w || kabs(clip.y) > clip.w) {
+            continue;
+        }
+        tested++;
+        u32 cluster = light_clusters_index(&clusters->data, &view, view_point);
+        for (u32 i = 0; i < light_count; ++i) {
+            if (vec3_distance(point, lights[i].position) <= lights[i].radius && !cluster_lists(&clusters->data, cluster, i)) {
+                missing++;
+            }
+        }
+    }
+    expect_to_be_true(tested > 1000);
+    expect_should_be(0, missing);
+
+    // Clusters list far fewer lights than there are.
+    u32 most = 0;
+    for (u32 i = 0; i < LIGHT_CLUSTERS_COUNT; ++i) {
+        most = KMAX(most, clusters->data.clusters[i][1]);
+    }
+    expect_to_be_true(most < light_count / 4);
+    kfree(clusters, sizeof(light_clusters), MEMORY_TAG_RENDERER);
+    return true;
+}
+
+u8 light_clusters_should_drop_what_does_not_fit() {
+    light_clusters* clusters = kallocate(sizeof(light_clusters), MEMORY_TAG_RENDERER);
+    light_clusters_view view = test_view();
+    directional_light sun = {{0.0f, -1.0f, 0.0f}, {1.0f, 1.0f, 1.0f, 1.0f}};
+
+    // More lights than are drawn, each reaching every cluster.
+    const u32 light_count = LIGHT_CLUSTERS_MAX_LIGHTS + 10;
+    point_light* lights = kallocate(sizeof(point_light) * light_count, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < light_count; ++i) {
+        lights[i] = test_light((vec3){0.0f, 0.0f, -5.0f}, 5000.0f);
+    }
+    light_clusters_build(&view, &sun, light_count, lights, clusters);
+
+    expect_should_be(10, clusters->dropped_light_count);
+    expect_should_be(LIGHT_CLUSTERS_MAX_LIGHTS, clusters->data.dimensions[3]);
+    expect_should_be(LIGHT_CLUSTERS_MAX_INDICES, clusters->index_count);
+    expect_should_be((u64)LIGHT_CLUSTERS_COUNT * LIGHT_CLUSTERS_MAX_LIGHTS - LIGHT_CLUSTERS_MAX_INDICES, clusters->dropped_index_count);
+
+    // The lists are laid out one after another, the first full, the last empty, all in range.
+    u32 offset = 0;
+    for (u32 i = 0; i < LIGHT_CLUSTERS_COUNT; ++i) {
+        expect_should_be(offset, clusters->data.clusters[i][0]);
+        offset += clusters->data.clusters[i][1];
+    }
+    expect_should_be(LIGHT_CLUSTERS_MAX_LIGHTS, clusters->data.clusters[0][1]);
+    expect_should_be(0, clusters->data.clusters[LIGHT_CLUSTERS_COUNT - 1][1]);
+    for (u32 i = 0; i < LIGHT_CLUSTERS_MAX_LIGHTS; ++i) {
+        expect_should_be(i, clusters->data.indices[i]);
+    }
+
+    kfree(lights, sizeof(point_light) * light_count, MEMORY_TAG_ARRAY);
+    kfree(clusters, sizeof(light_clusters), MEMORY_TAG_RENDERER);
+    return true;
+}
+
+void light_clusters_register_tests() {
+    test_manager_register_test(light_clusters_should_list_lights_only_where_they_reach, "Light clusters should list lights only where they reach");
+    test_manager_register_test(light_clusters_should_list_every_light_reaching_a_point, "Light clusters should list every light reaching a point");
+    test_manager_register_test(light_clusters_should_drop_what_does_not_fit, "Light clusters should drop what does not fit");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void light_clusters_register_tests();
@@ -0,0 +1,184 @@
+#include "particles_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <math/kmath.h>
+#include <memory/linear_allocator.h>
+#include <renderer/particles.h>
+
+static void* particles_start(u32 capacity, u64* out_size) {
+    particles_initialize(capacity, out_size, 0);
+    void* state = kallocate(*out_size, MEMORY_TAG_ARRAY);
+    particles_initialize(capacity, out_size, state);
+    return state;
+}
+
+static void particles_stop(void* state, u64 size) {
+    particles_shutdown(state);
+    kfree(state, size, MEMORY_TAG_ARRAY);
+}
+
+static particle_emitter_config emitter_config(f32 rate) {
+    particle_emitter_config config = {0};
+    config.position = (vec3){1.0f, 2.0f, 3.0f};
+    config.velocity = (vec3){0.0f, 1.0f, 0.0f};
+    config.rate = rate;
+    config.lifetime = 2.0f;
+    config.size_start = 1.0f;
+    config.colour_start = vec4_one();
+    return config;
+}
+
+u8 particles_should_carry_fractions_of_the_rate_between_frames() {
+    u64 size = 0;
+    void* state = particles_start(1024, &size);
+    linear_allocator allocator;
+    linear_allocator_create(KIBIBYTES(16), 0, &allocator);
+
+    particle_emitter_config config = emitter_config(10.0f);
+    u32 emitter = particle_emitter_create(&config);
+    expect_should_not_be(INVALID_ID, emitter);
+
+    // A quarter of a second at 10 a second spawns two, with half of one left over.
+    particles_packet_data data;
+    expect_to_be_true(particles_take(0.25f, &allocator, &data));
+    expect_should_be(2, data.spawn_count);
+    expect_should_be(1, data.emitter_count);
+    expect_float_to_be(0.25f, data.delta_time);
+    expect_float_to_be(2.0f, data.emitters[0].position.y);
+    expect_float_to_be(2.0f, data.emitters[0].lifetime);
+
+    expect_to_be_true(particles_take(0.25f, &allocator, &data));
+    expect_should_be(3, data.spawn_count);
+
+    // Nothing spawns over no time.
+    expect_to_be_true(particles_take(0.0f, &allocator, &data));
+    expect_should_be(0, data.spawn_count);
+    expect_should_be(0, data.emitter_count);
+
+    linear_allocator_destroy(&allocator);
+    particles_stop(state, size);
+    return true;
+}
+
+u8 particles_should_spawn_bursts_once() {
+    u64 size = 0;
+    void* state = particles_start(1024, &size);
+    linear_allocator allocator;
+    linear_allocator_create(KIBIBYTES(16), 0, &allocator);
+
+    particle_emitter_config config = emitter_config(0.0f);
+    u32 emitter = particle_emitter_create(&config);
+    particle_emitter_burst(emitter, 100);
+    particle_emitter_burst(emitter, 20);
+
+    particles_packet_data data;
+    expect_to_be_true(particles_take(0.016f, &allocator, &data));
+    expect_should_be(120, data.spawn_count);
+    expect_to_be_true(particles_take(0.016f, &allocator, &data));
+    expect_should_be(0, data.spawn_count);
+
+    linear_allocator_destroy(&allocator);
+    particles_stop(state, size);
+    return true;
+}
+
+u8 particles_should_place_each_emitter_after_those_before_it() {
+    u64 size = 0;
+    void* state = particles_start(1024, &size);
+    linear_allocator allocator;
+    linear_allocator_create(KIBIBYTES(16), 0, &allocator);
+
+    particle_emitter_config config = emitter_config(0.0f);
+    u32 first = particle_emitter_create(&config);
+    u32 idle = particle_emitter_create(&config);
+    u32 last = particle_emitter_create(&config);
+    particle_emitter_burst(first, 5);
+    particle_emitter_burst(last, 7);
+    particle_emitter_position_set(last, (vec3){4.0f, 5.0f, 6.0f});
+    expect_should_not_be(INVALID_ID, idle);
+
+    // Emitters spawning nothing are left out.
+    particles_packet_data data;
+    expect_to_be_true(particles_take(0.016f, &allocator, &data));
+    expect_should_be(2, data.emitter_count);
+    expect_should_be(12, data.spawn_count);
+    expect_should_be(0, data.emitters[0].first_spawn);
+    expect_should_be(5, data.emitters[0].spawn_count);
+    expect_should_be(5, data.emitters[1].first_spawn);
+    expect_should_be(7, data.emitters[1].spawn_count);
+    expect_float_to_be(4.0f, data.emitters[1].position.x);
+    expect_should_not_be(data.emitters[0].seed, data.emitters[1].seed);
+
+    // A destroyed emitter spawns no more, and its slot is taken again.
+    particle_emitter_burst(first, 5);
+    particle_emitter_destroy(first);
+    expect_to_be_true(particles_take(0.016f, &allocator, &data));
+    expect_should_be(0, data.spawn_count);
+    expect_should_be(first, particle_emitter_create(&config));
+
+    linear_allocator_destroy(&allocator);
+    particles_stop(state, size);
+    return true;
+}
+
+u8 particles_should_keep_a_frame_within_the_capacity() {
+    u64 size = 0;
+    void* state = particles_start(100, &size);
+    linear_allocator allocator;
+    linear_allocator_create(KIBIBYTES(16), 0, &allocator);
+
+    particle_emitter_config config = emitter_config(1000.0f);
+    particle_emitter_create(&config);
+    u32 b = particle_emitter_create(&config);
+    particle_emitter_burst(b, 10);
+
+    // A long frame would spawn thousands, of which the first emitter takes all there is room for.
+    particles_packet_data data;
+    expect_to_be_true(particles_take(5.0f, &allocator, &data));
+    expect_should_be(100, data.spawn_count);
+    expect_should_be(1, data.emitter_count);
+    expect_should_be(100, data.emitters[0].spawn_count);
+
+    // The rest are dropped rather than spawned later.
+    particle_emitter_destroy(b);
+    expect_to_be_true(particles_take(0.001f, &allocator, &data));
+    expect_should_be(1, data.spawn_count);
+
+    linear_allocator_destroy(&allocator);
+    particles_stop(state, size);
+    return true;
+}
+
+u8 particles_should_refuse_emitters_past_the_limit() {
+    u64 size = 0;
+    void* state = particles_start(16, &size);
+
+    particle_emitter_config config = emitter_config(1.0f);
+    for (u32 i = 0; i < PARTICLE_MAX_EMITTERS; ++i) {
+        expect_should_be(i, particle_emitter_create(&config));
+    }
+    expect_should_be(INVALID_ID, particle_emitter_create(&config));
+
+    // A lifetime is required.
+    particle_emitter_destroy(0);
+    config.lifetime = 0.0f;
+    expect_should_be(INVALID_ID, particle_emitter_create(&config));
+
+    particles_stop(state, size);
+    // Calls made once shut down are ignored.
+    expect_should_be(INVALID_ID, particle_emitter_create(&config));
+    particle_emitter_burst(1, 10);
+    return true;
+}
+
+void particles_register_tests() {
+    test_manager_register_test(particles_should_carry_fractions_of_the_rate_between_frames, "Particles should carry fractions of the rate between frames");
+    test_manager_register_test(particles_should_spawn_bursts_once, "Particles should spawn bursts once");
+    test_manager_register_test(particles_should_place_each_emitter_after_those_before_it, "Particles should place each emitter after those before it");
+    test_manager_register_test(particles_should_keep_a_frame_within_the_capacity, "Particles should keep a frame within the capacity");
+    test_manager_register_test(particles_should_refuse_emitters_past_the_limit, "Particles should refuse emitters past the limit");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void particles_register_tests();
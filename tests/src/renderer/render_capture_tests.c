@@ -0,0 +1,250 @@
+#include "render_capture_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <containers/darray.h>
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <math/kmath.h>
+#include <memory/linear_allocator.h>
+#include <platform/filesystem.h>
+#include <renderer/light_clusters.h>
+#include <renderer/render_capture.h>
+
+#include <stdio.h>  // remove
+
+#define RENDER_CAPTURE_TEST_PATH "render_capture_test.krc"
+
+// What a packet of the test frames is built from.
+typedef struct capture_test_scene {
+    render_view world_view;
+    render_view ui_view;
+    material brick;
+    geometry wall;
+    geometry floor;
+    light_clusters* clusters;
+    geometry_render_data world_geometries[3];
+    render_view_packet views[2];
+    render_packet packet;
+} capture_test_scene;
+
+static void scene_create(capture_test_scene* scene) {
+    kzero_memory(scene, sizeof(capture_test_scene));
+    scene->world_view.name = "world";
+    scene->world_view.type = RENDERER_VIEW_KNOWN_TYPE_WORLD;
+    scene->ui_view.name = "ui";
+    scene->ui_view.type = RENDERER_VIEW_KNOWN_TYPE_UI;
+    kcopy_memory(scene->brick.name, "brick", 6);
+    kcopy_memory(scene->wall.name, "wall", 5);
+    kcopy_memory(scene->floor.name, "floor", 6);
+    scene->wall.material = &scene->brick;
+
+    // The wall is drawn twice, at different levels of detail.
+    scene->world_geometries[0] = (geometry_render_data){mat4_translation((vec3){1, 2, 3}), &scene->wall, 7, 0};
+    scene->world_geometries[1] = (geometry_render_data){mat4_identity(), &scene->floor, 8, 0};
+    scene->world_geometries[2] = (geometry_render_data){mat4_translation((vec3){-4, 0, 0}), &scene->wall, 9, 2};
+
+    mat4 view = mat4_inverse(mat4_translation((vec3){0, 2, 10}));
+    mat4 projection = mat4_perspective(deg_to_rad(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    directional_light directional = {{0, -1, 0}, {0.5f, 0.5f, 0.5f, 1.0f}};
+    point_light lights[2] = {
+        {{0, 1, 0}, {1, 0, 0, 1}, 1.0f, 0.35f, 0.44f, 12.0f},
+        {{5, 1, -5}, {0, 1, 0, 1}, 1.0f, 0.7f, 1.8f, 6.0f}};
+    scene->clusters = kallocate(sizeof(light_clusters), MEMORY_TAG_RENDERER);
+    light_clusters_view lights_view = {view, projection, 0.1f, 100.0f};
+    light_clusters_build(&lights_view, &directional, 2, lights, scene->clusters);
+
+    render_view_packet* world = &scene->views[0];
+    world->view = &scene->world_view;
+    world->view_matrix = view;
+    world->projection_matrix = projection;
+    world->view_position = (vec3){0, 2, 10};
+    world->ambient_colour = (vec4){0.25f, 0.25f, 0.25f, 1.0f};
+    world->geometry_count = 3;
+    world->geometries = scene->world_geometries;
+    world->extended_data = scene->clusters;
+    scene->views[1].view = &scene->ui_view;
+    scene->views[1].view_matrix = mat4_identity();
+    scene->views[1].projection_matrix = mat4_orthographic(0, 1280, 720, 0, -100.0f, 100.0f);
+
+    scene->packet.delta_time = 1.0f / 60.0f;
+    scene->packet.view_count = 2;
+    scene->packet.views = scene->views;
+}
+
+static void scene_destroy(capture_test_scene* scene) {
+    kfree(scene->clusters, sizeof(light_clusters), MEMORY_TAG_RENDERER);
+}
+
+static b8 capture_read(void** out_data, u64* out_size) {
+    file_handle f;
+    if (!filesystem_open(RENDER_CAPTURE_TEST_PATH, FILE_MODE_READ, true, &f)) {
+        return false;
+    }
+    b8 result = filesystem_size(&f, out_size) && *out_size;
+    if (result) {
+        *out_data = kallocate(*out_size, MEMORY_TAG_ARRAY);
+        u64 read = 0;
+        result = filesystem_read_all_bytes(&f, *out_data, &read) && read == *out_size;
+    }
+    filesystem_close(&f);
+    return result;
+}
+
+u8 render_capture_should_round_trip_captured_frames() {
+    capture_test_scene* scene = kallocate(sizeof(capture_test_scene), MEMORY_TAG_ARRAY);
+    scene_create(scene);
+
+    const char* mesh_names[2] = {"falcon", "sponza"};
+    expect_to_be_true(render_capture_frames(2, RENDER_CAPTURE_TEST_PATH, 2, mesh_names));
+    expect_to_be_true(render_capture_running());
+    // Only one capture runs at a time.
+    expect_to_be_false(render_capture_frames(5, RENDER_CAPTURE_TEST_PATH, 0, 0));
+    render_capture_frame(&scene->packet);
+    scene->packet.delta_time = 0.5f;
+    render_capture_frame(&scene->packet);
+    expect_to_be_false(render_capture_running());
+    // Past the end of the capture, so not written.
+    render_capture_frame(&scene->packet);
+
+    render_replay_config config = {RENDER_CAPTURE_TEST_PATH, 3};
+    render_replay replay;
+    expect_to_be_true(render_replay_load(&config, &replay));
+    expect_should_be(2, replay.frame_count);
+    expect_should_be(3, replay.loop_count);
+    expect_should_be(2, replay.mesh_count);
+    expect_to_be_true(strings_equal("sponza", replay.mesh_names[1]));
+    // Each geometry is held once, however many times it is drawn.
+    expect_should_be(2, darray_length(replay.geometries));
+    expect_to_be_true(strings_equal("wall", replay.geometries[0].name));
+    expect_to_be_true(strings_equal("brick", replay.geometries[0].material_name));
+    expect_to_be_true(strings_equal("", replay.geometries[1].material_name));
+
+    render_replay_frame* frame = &replay.frames[1];
+    expect_float_to_be(0.5f, frame->delta_time);
+    expect_should_be(2, frame->view_count);
+    render_replay_view* world = &frame->views[0];
+    expect_to_be_true(strings_equal("world", world->name));
+    expect_should_be(3, world->draw_count);
+    expect_should_be(0, world->draws[2].geometry_index);
+    expect_should_be(2, world->draws[2].lod);
+    expect_should_be(9, world->draws[2].unique_id);
+    expect_float_to_be(-4.0f, world->draws[2].model.data[12]);
+    expect_float_to_be(10.0f, world->view_position.z);
+    expect_float_to_be(scene->views[0].projection_matrix.data[5], world->projection_matrix.data[5]);
+    expect_to_be_true(world->has_lights);
+    expect_float_to_be(100.0f, world->far_clip);
+    expect_should_be(2, world->point_light_count);
+    expect_float_to_be(5.0f, world->point_lights[1].position.x);
+    expect_float_to_be(6.0f, world->point_lights[1].radius);
+    expect_float_to_be(1.8f, world->point_lights[1].quadratic);
+    expect_to_be_false(frame->views[1].has_lights);
+    expect_should_be(0, frame->views[1].draw_count);
+
+    render_replay_destroy(&replay);
+    scene_destroy(scene);
+    kfree(scene, sizeof(capture_test_scene), MEMORY_TAG_ARRAY);
+    remove(RENDER_CAPTURE_TEST_PATH);
+    return true;
+}
+
+u8 render_capture_should_keep_the_frames_before_a_cut() {
+    capture_test_scene* scene = kallocate(sizeof(capture_test_scene), MEMORY_TAG_ARRAY);
+    scene_create(scene);
+    expect_to_be_true(render_capture_frames(2, RENDER_CAPTURE_TEST_PATH, 0, 0));
+    render_capture_frame(&scene->packet);
+    render_capture_frame(&scene->packet);
+
+    void* data = 0;
+    u64 size = 0;
+    expect_to_be_true(capture_read(&data, &size));
+    render_replay replay;
+    // Cut in the second frame, so only the first is left.
+    expect_to_be_true(render_replay_read(data, size - 10, "test.krc", 0, &replay));
+    expect_should_be(1, replay.frame_count);
+    expect_should_be(RENDER_REPLAY_DEFAULT_LOOP_COUNT, replay.loop_count);
+    render_replay_destroy(&replay);
+
+    // Cut in the first, so nothing is left.
+    expect_to_be_false(render_replay_read(data, 40, "test.krc", 0, &replay));
+    render_replay_destroy(&replay);
+
+    // Captured by a later version.
+    ((u32*)data)[1] = RENDER_CAPTURE_VERSION + 1;
+    expect_to_be_false(render_replay_read(data, size, "test.krc", 0, &replay));
+    render_replay_destroy(&replay);
+
+    kfree(data, size, MEMORY_TAG_ARRAY);
+    scene_destroy(scene);
+    kfree(scene, sizeof(capture_test_scene), MEMORY_TAG_ARRAY);
+    remove(RENDER_CAPTURE_TEST_PATH);
+    return true;
+}
+
+u8 render_replay_should_build_world_packets_and_time_every_loop() {
+    capture_test_scene* scene = kallocate(sizeof(capture_test_scene), MEMORY_TAG_ARRAY);
+    scene_create(scene);
+    expect_to_be_true(render_capture_frames(2, RENDER_CAPTURE_TEST_PATH, 0, 0));
+    render_capture_frame(&scene->packet);
+    scene->world_geometries[0].lod = 1;
+    render_capture_frame(&scene->packet);
+
+    void* data = 0;
+    u64 size = 0;
+    expect_to_be_true(capture_read(&data, &size));
+    render_replay replay;
+    expect_to_be_true(render_replay_read(data, size, "test.krc", 2, &replay));
+
+    // Resolved by hand, as there are no systems to resolve them: the wall is loaded, the floor is not,
+    // and only the world view is replayed.
+    replay.geometries[0].resolved = &scene->wall;
+    for (u32 f = 0; f < replay.frame_count; ++f) {
+        replay.frames[f].views[0].view = &scene->world_view;
+    }
+    replay.resolved = true;
+    expect_to_be_true(render_replay_ready(&replay));
+
+    linear_allocator allocator;
+    linear_allocator_create(MEBIBYTES(4), 0, &allocator);
+    render_packet packet = {0};
+    expect_to_be_true(render_replay_packet_build(&replay, &allocator, &packet));
+    expect_should_be(1, packet.view_count);
+    expect_to_be_true(packet.views[0].view == &scene->world_view);
+    expect_should_be(2, packet.views[0].geometry_count);
+    expect_to_be_true(packet.views[0].geometries[1].geometry == &scene->wall);
+    expect_should_be(2, packet.views[0].geometries[1].lod);
+    // The clusters are built again from the captured lights.
+    const light_clusters* clusters = packet.views[0].extended_data;
+    expect_to_be_true(clusters != 0);
+    expect_should_be(2, clusters->data.dimensions[3]);
+    expect_to_be_false(render_replay_frame_end(&replay, 0.010));
+
+    // The next frame is the second captured.
+    linear_allocator_free_all(&allocator);
+    expect_to_be_true(render_replay_packet_build(&replay, &allocator, &packet));
+    expect_should_be(1, packet.views[0].geometries[0].lod);
+    expect_to_be_false(render_replay_frame_end(&replay, 0.030));
+
+    // Done after every frame is replayed twice.
+    expect_to_be_false(render_replay_frame_end(&replay, 0.020));
+    expect_to_be_true(render_replay_frame_end(&replay, 0.010));
+    expect_float_to_be(0.030f, (f32)replay.frames[0].total_time);
+    expect_float_to_be(0.030f, (f32)replay.frames[1].max_time);
+
+    linear_allocator_destroy(&allocator);
+    replay.geometries[0].resolved = 0;
+    render_replay_destroy(&replay);
+    kfree(data, size, MEMORY_TAG_ARRAY);
+    scene_destroy(scene);
+    kfree(scene, sizeof(capture_test_scene), MEMORY_TAG_ARRAY);
+    remove(RENDER_CAPTURE_TEST_PATH);
+    return true;
+}
+
+void render_capture_register_tests() {
+    test_manager_register_test(render_capture_should_round_trip_captured_frames, "Render capture should round trip captured frames");
+    test_manager_register_test(render_capture_should_keep_the_frames_before_a_cut, "Render capture should keep the frames before a cut");
+    test_manager_register_test(render_replay_should_build_world_packets_and_time_every_loop, "Render replay should build world packets and time every loop");
+}
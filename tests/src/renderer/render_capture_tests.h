@@ -0,0 +1,3 @@
+#pragma once
+
+void render_capture_register_tests();
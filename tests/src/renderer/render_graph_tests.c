@@ -0,0 +1,142 @@
+#include "render_graph_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <containers/darray.h>
+#include <renderer/render_graph.h>
+
+u8 render_graph_should_derive_attachment_operations() {
+    render_graph graph;
+    render_graph_create(&graph);
+    u32 colour = render_graph_resource_add(&graph, "colour", RENDER_TARGET_ATTACHMENT_TYPE_COLOUR, RENDER_TARGET_ATTACHMENT_SOURCE_DEFAULT, 0, 0, RENDER_GRAPH_RESOURCE_FLAG_PRESENT);
+    u32 depth = render_graph_resource_add(&graph, "depth", RENDER_TARGET_ATTACHMENT_TYPE_DEPTH, RENDER_TARGET_ATTACHMENT_SOURCE_DEFAULT, 0, 0, RENDER_GRAPH_RESOURCE_FLAG_NONE);
+
+    u32 sky = render_graph_pass_add(&graph, "sky", RENDERPASS_CLEAR_COLOUR_BUFFER_FLAG);
+    expect_to_be_true(render_graph_pass_use(&graph, sky, colour, RENDER_GRAPH_ACCESS_ATTACHMENT));
+    u32 world = render_graph_pass_add(&graph, "world", RENDERPASS_CLEAR_DEPTH_BUFFER_FLAG);
+    expect_to_be_true(render_graph_pass_use(&graph, world, colour, RENDER_GRAPH_ACCESS_ATTACHMENT));
+    expect_to_be_true(render_graph_pass_use(&graph, world, depth, RENDER_GRAPH_ACCESS_ATTACHMENT));
+    u32 ui = render_graph_pass_add(&graph, "ui", RENDERPASS_CLEAR_NONE_FLAG);
+    expect_to_be_true(render_graph_pass_use(&graph, ui, colour, RENDER_GRAPH_ACCESS_ATTACHMENT));
+    expect_to_be_true(render_graph_compile(&graph));
+
+    // Cleared first, so nothing is loaded, but what is drawn is kept for the next pass.
+    expect_should_be(RENDER_TARGET_ATTACHMENT_LOAD_OPERATION_DONT_CARE, graph.passes[sky].uses[0].load_operation);
+    expect_should_be(RENDER_TARGET_ATTACHMENT_STORE_OPERATION_STORE, graph.passes[sky].uses[0].store_operation);
+    expect_to_be_false(graph.passes[sky].uses[0].present_after);
+
+    // Drawn over, so loaded. Depth is only used here, so neither loaded nor stored.
+    expect_should_be(RENDER_TARGET_ATTACHMENT_LOAD_OPERATION_LOAD, graph.passes[world].uses[0].load_operation);
+    expect_should_be(RENDER_TARGET_ATTACHMENT_LOAD_OPERATION_DONT_CARE, graph.passes[world].uses[1].load_operation);
+    expect_should_be(RENDER_TARGET_ATTACHMENT_STORE_OPERATION_DONT_CARE, graph.passes[world].uses[1].store_operation);
+    expect_to_be_true(graph.resources[depth].transient);
+
+    // Presented, so stored after the last pass.
+    expect_should_be(RENDER_TARGET_ATTACHMENT_LOAD_OPERATION_LOAD, graph.passes[ui].uses[0].load_operation);
+    expect_should_be(RENDER_TARGET_ATTACHMENT_STORE_OPERATION_STORE, graph.passes[ui].uses[0].store_operation);
+    expect_to_be_true(graph.passes[ui].uses[0].present_after);
+    expect_to_be_false(graph.resources[colour].transient);
+    return true;
+}
+
+u8 render_graph_should_keep_external_resources() {
+    render_graph graph;
+    render_graph_create(&graph);
+    u32 pick = render_graph_resource_add(&graph, "pick", RENDER_TARGET_ATTACHMENT_TYPE_COLOUR, RENDER_TARGET_ATTACHMENT_SOURCE_VIEW, 0, 0, RENDER_GRAPH_RESOURCE_FLAG_EXTERNAL);
+    u32 pass = render_graph_pass_add(&graph, "pick", RENDERPASS_CLEAR_COLOUR_BUFFER_FLAG);
+    render_graph_pass_use(&graph, pass, pick, RENDER_GRAPH_ACCESS_ATTACHMENT);
+    expect_to_be_true(render_graph_compile(&graph));
+
+    expect_should_be(RENDER_TARGET_ATTACHMENT_STORE_OPERATION_STORE, graph.passes[pass].uses[0].store_operation);
+    expect_to_be_false(graph.resources[pick].transient);
+    return true;
+}
+
+u8 render_graph_should_alias_disjoint_resources() {
+    render_graph graph;
+    render_graph_create(&graph);
+    u32 a = render_graph_resource_add(&graph, "a", RENDER_TARGET_ATTACHMENT_TYPE_COLOUR, RENDER_TARGET_ATTACHMENT_SOURCE_VIEW, 256, 256, RENDER_GRAPH_RESOURCE_FLAG_NONE);
+    u32 b = render_graph_resource_add(&graph, "b", RENDER_TARGET_ATTACHMENT_TYPE_COLOUR, RENDER_TARGET_ATTACHMENT_SOURCE_VIEW, 256, 256, RENDER_GRAPH_RESOURCE_FLAG_NONE);
+    u32 c = render_graph_resource_add(&graph, "c", RENDER_TARGET_ATTACHMENT_TYPE_COLOUR, RENDER_TARGET_ATTACHMENT_SOURCE_VIEW, 256, 256, RENDER_GRAPH_RESOURCE_FLAG_NONE);
+    u32 other = render_graph_resource_add(&graph, "other", RENDER_TARGET_ATTACHMENT_TYPE_COLOUR, RENDER_TARGET_ATTACHMENT_SOURCE_VIEW, 128, 128, RENDER_GRAPH_RESOURCE_FLAG_NONE);
+    u32 out = render_graph_resource_add(&graph, "out", RENDER_TARGET_ATTACHMENT_TYPE_COLOUR, RENDER_TARGET_ATTACHMENT_SOURCE_DEFAULT, 0, 0, RENDER_GRAPH_RESOURCE_FLAG_PRESENT);
+
+    // a is written then sampled into b, after which a is free for c.
+    u32 p0 = render_graph_pass_add(&graph, "p0", RENDERPASS_CLEAR_COLOUR_BUFFER_FLAG);
+    render_graph_pass_use(&graph, p0, a, RENDER_GRAPH_ACCESS_ATTACHMENT);
+    u32 p1 = render_graph_pass_add(&graph, "p1", RENDERPASS_CLEAR_COLOUR_BUFFER_FLAG);
+    render_graph_pass_use(&graph, p1, b, RENDER_GRAPH_ACCESS_ATTACHMENT);
+    render_graph_pass_use(&graph, p1, a, RENDER_GRAPH_ACCESS_SAMPLED);
+    u32 p2 = render_graph_pass_add(&graph, "p2", RENDERPASS_CLEAR_COLOUR_BUFFER_FLAG);
+    render_graph_pass_use(&graph, p2, c, RENDER_GRAPH_ACCESS_ATTACHMENT);
+    render_graph_pass_use(&graph, p2, other, RENDER_GRAPH_ACCESS_ATTACHMENT);
+    render_graph_pass_use(&graph, p2, b, RENDER_GRAPH_ACCESS_SAMPLED);
+    u32 p3 = render_graph_pass_add(&graph, "p3", RENDERPASS_CLEAR_NONE_FLAG);
+    render_graph_pass_use(&graph, p3, out, RENDER_GRAPH_ACCESS_ATTACHMENT);
+    render_graph_pass_use(&graph, p3, c, RENDER_GRAPH_ACCESS_SAMPLED);
+    expect_to_be_true(render_graph_compile(&graph));
+
+    // Sampled later, so stored.
+    expect_should_be(RENDER_TARGET_ATTACHMENT_STORE_OPERATION_STORE, graph.passes[p0].uses[0].store_operation);
+    expect_to_be_false(graph.resources[a].transient);
+
+    expect_should_be(graph.resources[a].alias_slot, graph.resources[c].alias_slot);
+    expect_should_not_be(graph.resources[a].alias_slot, graph.resources[b].alias_slot);
+    expect_should_not_be(graph.resources[c].alias_slot, graph.resources[other].alias_slot);
+    expect_should_not_be(graph.resources[a].alias_slot, graph.resources[out].alias_slot);
+    expect_should_be(4, graph.alias_slot_count);
+    return true;
+}
+
+u8 render_graph_should_give_shared_attachments_their_slots() {
+    render_graph graph;
+    render_graph_create(&graph);
+    u32 first = render_graph_resource_add(&graph, "first", RENDER_TARGET_ATTACHMENT_TYPE_DEPTH, RENDER_TARGET_ATTACHMENT_SOURCE_SHARED, 0, 0, RENDER_GRAPH_RESOURCE_FLAG_NONE);
+    u32 second = render_graph_resource_add(&graph, "second", RENDER_TARGET_ATTACHMENT_TYPE_DEPTH, RENDER_TARGET_ATTACHMENT_SOURCE_SHARED, 0, 0, RENDER_GRAPH_RESOURCE_FLAG_NONE);
+    u32 own = render_graph_resource_add(&graph, "own", RENDER_TARGET_ATTACHMENT_TYPE_DEPTH, RENDER_TARGET_ATTACHMENT_SOURCE_VIEW, 0, 0, RENDER_GRAPH_RESOURCE_FLAG_NONE);
+
+    // The passes of two views, one after the other, each with depth of its own.
+    u32 p0 = render_graph_pass_add(&graph, "p0", RENDERPASS_CLEAR_DEPTH_BUFFER_FLAG);
+    render_graph_pass_use(&graph, p0, first, RENDER_GRAPH_ACCESS_ATTACHMENT);
+    u32 p1 = render_graph_pass_add(&graph, "p1", RENDERPASS_CLEAR_DEPTH_BUFFER_FLAG);
+    render_graph_pass_use(&graph, p1, second, RENDER_GRAPH_ACCESS_ATTACHMENT);
+    u32 p2 = render_graph_pass_add(&graph, "p2", RENDERPASS_CLEAR_DEPTH_BUFFER_FLAG);
+    render_graph_pass_use(&graph, p2, own, RENDER_GRAPH_ACCESS_ATTACHMENT);
+    expect_to_be_true(render_graph_compile(&graph));
+
+    // Shared with each other, but not with one from elsewhere.
+    expect_should_be(graph.resources[first].alias_slot, graph.resources[second].alias_slot);
+    expect_should_not_be(graph.resources[second].alias_slot, graph.resources[own].alias_slot);
+
+    // The slot goes with the attachment, for the render view system to find the image by.
+    renderpass_config config = {0};
+    expect_to_be_true(render_graph_pass_attachments_get(&graph, p1, &config));
+    expect_should_be(1, config.target.attachment_count);
+    expect_should_be(RENDER_TARGET_ATTACHMENT_SOURCE_SHARED, config.target.attachments[0].source);
+    expect_should_be(graph.resources[second].alias_slot, config.target.attachments[0].alias_slot);
+    darray_destroy(config.target.attachments);
+    return true;
+}
+
+u8 render_graph_should_reject_sampling_unwritten() {
+    render_graph graph;
+    render_graph_create(&graph);
+    u32 a = render_graph_resource_add(&graph, "a", RENDER_TARGET_ATTACHMENT_TYPE_COLOUR, RENDER_TARGET_ATTACHMENT_SOURCE_VIEW, 0, 0, RENDER_GRAPH_RESOURCE_FLAG_NONE);
+    u32 p0 = render_graph_pass_add(&graph, "p0", RENDERPASS_CLEAR_NONE_FLAG);
+    render_graph_pass_use(&graph, p0, a, RENDER_GRAPH_ACCESS_SAMPLED);
+    expect_to_be_false(render_graph_compile(&graph));
+
+    // Using a resource twice in one pass is rejected.
+    expect_to_be_false(render_graph_pass_use(&graph, p0, a, RENDER_GRAPH_ACCESS_ATTACHMENT));
+    return true;
+}
+
+void render_graph_register_tests() {
+    test_manager_register_test(render_graph_should_derive_attachment_operations, "Render graph should derive attachment operations");
+    test_manager_register_test(render_graph_should_keep_external_resources, "Render graph should keep external resources");
+    test_manager_register_test(render_graph_should_alias_disjoint_resources, "Render graph should alias disjoint resources");
+    test_manager_register_test(render_graph_should_give_shared_attachments_their_slots, "Render graph should give shared attachments their slots");
+    test_manager_register_test(render_graph_should_reject_sampling_unwritten, "Render graph should reject sampling unwritten resources");
+}
@@ -0,0 +1,109 @@
+#include "render_queue_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <renderer/render_queue.h>
+
+u8 render_queue_keys_should_order_by_pass_then_state() {
+    // The pass comes before all else.
+    expect_to_be_true(render_queue_key(0, 100, 100, 1.0f, false) < render_queue_key(1, 0, 0, 0.0f, true));
+
+    // Opaque draws group by pipeline, then material, then nearest first.
+    expect_to_be_true(render_queue_key(0, 1, 9, 0.0f, false) < render_queue_key(0, 2, 0, 0.0f, false));
+    expect_to_be_true(render_queue_key(0, 1, 1, 0.9f, false) < render_queue_key(0, 1, 2, 0.1f, false));
+    expect_to_be_true(render_queue_key(0, 1, 1, 0.1f, false) < render_queue_key(0, 1, 1, 0.9f, false));
+
+    // Translucent draws go farthest first, whatever their state.
+    expect_to_be_true(render_queue_key(1, 2, 2, 0.9f, true) < render_queue_key(1, 1, 1, 0.1f, true));
+
+    // Depths out of range are clamped.
+    expect_should_be(render_queue_key(0, 1, 1, 1.0f, false), render_queue_key(0, 1, 1, 5.0f, false));
+    expect_should_be(render_queue_key(0, 1, 1, 0.0f, false), render_queue_key(0, 1, 1, -5.0f, false));
+    return true;
+}
+
+u8 render_queue_sort_should_be_stable() {
+    render_queue_entry entries[6];
+    render_queue_entry scratch[6];
+    u64 keys[6] = {0x0300000000000002ull, 0x0100000000000001ull, 0x0300000000000002ull, 0x0000000000000005ull, 0x0100000000000001ull, 0x0000000000000005ull};
+    for (u32 i = 0; i < 6; ++i) {
+        entries[i].key = keys[i];
+        entries[i].index = i;
+    }
+    render_queue_sort(6, entries, scratch);
+
+    u32 expected[6] = {3, 5, 1, 4, 0, 2};
+    for (u32 i = 0; i < 6; ++i) {
+        expect_should_be(expected[i], entries[i].index);
+    }
+    return true;
+}
+
+u8 render_queue_sort_should_handle_equal_keys() {
+    render_queue_entry entries[3] = {{7, 0}, {7, 1}, {7, 2}};
+    render_queue_entry scratch[3];
+    render_queue_sort(3, entries, scratch);
+    for (u32 i = 0; i < 3; ++i) {
+        expect_should_be(i, entries[i].index);
+    }
+    return true;
+}
+
+u8 render_queue_sort_should_order_presorted_and_reversed_depths() {
+    // Opaque draws already front to back, as when the camera is still, then translucent ones also
+    // front to back, which must be reversed. Depths are squared distances, as the world view keys them.
+    const u32 count = 2048;
+    render_queue_entry entries[2048];
+    render_queue_entry scratch[2048];
+    for (u32 i = 0; i < count; ++i) {
+        b8 translucent = i >= count / 2;
+        f32 distance = (f32)(i % (count / 2) + 1) / (f32)(count / 2);
+        entries[i].key = render_queue_key(translucent ? 1 : 0, 1, 1, distance * distance, translucent);
+        entries[i].index = i;
+    }
+    render_queue_sort(count, entries, scratch);
+
+    for (u32 i = 0; i < count / 2; ++i) {
+        expect_should_be(i, entries[i].index);
+    }
+    for (u32 i = count / 2; i < count; ++i) {
+        expect_should_be(count - 1 - (i - count / 2), entries[i].index);
+    }
+    return true;
+}
+
+u8 render_queue_group_instances_should_gather_same_geometry() {
+    // Opaque draws of one material at increasing depth, of geometry A, B, A, B, then a translucent pair of A.
+    render_queue_entry entries[6];
+    render_queue_entry scratch[6];
+    render_queue_entry groups[6];
+    u64 instance_keys[6] = {1, 2, 1, 2, RENDER_QUEUE_NO_INSTANCE, RENDER_QUEUE_NO_INSTANCE};
+    entries[0].key = render_queue_key(0, 1, 1, 0.1f, false);
+    entries[1].key = render_queue_key(0, 1, 1, 0.2f, false);
+    entries[2].key = render_queue_key(0, 1, 1, 0.3f, false);
+    entries[3].key = render_queue_key(0, 1, 1, 0.4f, false);
+    entries[4].key = render_queue_key(1, 1, 1, 0.9f, true);
+    entries[5].key = render_queue_key(1, 1, 1, 0.5f, true);
+    for (u32 i = 0; i < 6; ++i) {
+        entries[i].index = i;
+    }
+    render_queue_sort(6, entries, scratch);
+    render_queue_group_instances(6, entries, instance_keys, scratch, groups);
+
+    // The As take the place of the first, the Bs follow, and translucent draws stay farthest first.
+    u32 expected[6] = {0, 2, 1, 3, 4, 5};
+    for (u32 i = 0; i < 6; ++i) {
+        expect_should_be(expected[i], entries[i].index);
+    }
+    return true;
+}
+
+void render_queue_register_tests() {
+    test_manager_register_test(render_queue_keys_should_order_by_pass_then_state, "Render queue keys should order by pass, then state");
+    test_manager_register_test(render_queue_sort_should_be_stable, "Render queue sort should be stable");
+    test_manager_register_test(render_queue_sort_should_handle_equal_keys, "Render queue sort should handle equal keys");
+    test_manager_register_test(render_queue_sort_should_order_presorted_and_reversed_depths, "Render queue sort should order presorted and reversed depths");
+    test_manager_register_test(render_queue_group_instances_should_gather_same_geometry, "Render queue should group instances of the same geometry");
+}
@@ -0,0 +1,245 @@
+#include "render_scene_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <containers/darray.h>
+#include <core/kmemory.h>
+#include <math/kmath.h>
+#include <math/transform.h>
+#include <math/transform_hierarchy.h>
+#include <renderer/render_scene.h>
+
+typedef struct scene_fixture {
+    transform_hierarchy transforms;
+    void* transforms_memory;
+    u64 transforms_size;
+    render_scene scene;
+    void* scene_memory;
+    u64 scene_size;
+    geometry unit_box;
+    frustum f;
+} scene_fixture;
+
+// A hierarchy and scene of the given capacity, a unit box to draw, and a frustum looking down -z.
+static void fixture_create(u32 capacity, scene_fixture* out_fixture) {
+    kzero_memory(out_fixture, sizeof(scene_fixture));
+    transform_hierarchy_create(capacity, &out_fixture->transforms_size, 0, 0);
+    out_fixture->transforms_memory = kallocate(out_fixture->transforms_size, MEMORY_TAG_TRANSFORM);
+    transform_hierarchy_create(capacity, &out_fixture->transforms_size, out_fixture->transforms_memory, &out_fixture->transforms);
+
+    render_scene_create(capacity, &out_fixture->scene_size, 0, 0);
+    out_fixture->scene_memory = kallocate(out_fixture->scene_size, MEMORY_TAG_RENDERER);
+    render_scene_create(capacity, &out_fixture->scene_size, out_fixture->scene_memory, &out_fixture->scene);
+
+    out_fixture->unit_box.extents.min = (vec3){-0.5f, -0.5f, -0.5f};
+    out_fixture->unit_box.extents.max = (vec3){0.5f, 0.5f, 0.5f};
+
+    vec3 position = {0, 0, 0};
+    vec3 forward = {0, 0, -1};
+    vec3 right = {1, 0, 0};
+    vec3 up = {0, 1, 0};
+    out_fixture->f = frustom_create(&position, &forward, &right, &up, 16.0f / 9.0f, deg_to_rad(45.0f), 0.1f, 100.0f);
+}
+
+static void fixture_destroy(scene_fixture* fixture) {
+    render_scene_destroy(&fixture->scene);
+    kfree(fixture->scene_memory, fixture->scene_size, MEMORY_TAG_RENDERER);
+    transform_hierarchy_destroy(&fixture->transforms);
+    kfree(fixture->transforms_memory, fixture->transforms_size, MEMORY_TAG_TRANSFORM);
+}
+
+static u32 proxy_add_at(scene_fixture* fixture, vec3 position, u32 unique_id) {
+    transform t = transform_from_position(position);
+    u32 transform_id = transform_hierarchy_add(&fixture->transforms, &t, INVALID_ID);
+    return render_scene_proxy_add(&fixture->scene, &fixture->unit_box, transform_id, unique_id);
+}
+
+u8 render_scene_should_cull_proxies() {
+    scene_fixture fx;
+    fixture_create(8, &fx);
+
+    // One in front of the camera, one behind it.
+    expect_should_be(0, proxy_add_at(&fx, (vec3){0.0f, 0.0f, -10.0f}, 7));
+    expect_should_be(1, proxy_add_at(&fx, (vec3){0.0f, 0.0f, 10.0f}, 8));
+    transform_hierarchy_update(&fx.transforms, false);
+    expect_to_be_true(render_scene_update(&fx.scene, &fx.transforms, &fx.f));
+
+    geometry_render_data* visible = render_scene_visible_get(&fx.scene);
+    expect_should_be(1, darray_length(visible));
+    expect_should_be(7, visible[0].unique_id);
+    expect_float_to_be(-10.0f, visible[0].model.data[14]);
+
+    fixture_destroy(&fx);
+    return true;
+}
+
+u8 render_scene_should_keep_list_when_nothing_changes() {
+    scene_fixture fx;
+    fixture_create(8, &fx);
+
+    proxy_add_at(&fx, (vec3){0.0f, 0.0f, -10.0f}, 1);
+    proxy_add_at(&fx, (vec3){2.0f, 0.0f, -20.0f}, 2);
+    transform_hierarchy_update(&fx.transforms, false);
+    expect_to_be_true(render_scene_update(&fx.scene, &fx.transforms, &fx.f));
+    expect_should_be(2, darray_length(render_scene_visible_get(&fx.scene)));
+
+    // Nothing moved and the camera is still, so the list is not rebuilt.
+    transform_hierarchy_update(&fx.transforms, false);
+    expect_to_be_false(render_scene_update(&fx.scene, &fx.transforms, &fx.f));
+    expect_should_be(2, darray_length(render_scene_visible_get(&fx.scene)));
+
+    // A camera turned away culls both.
+    vec3 position = {0, 0, 0};
+    vec3 forward = {0, 0, 1};
+    vec3 right = {-1, 0, 0};
+    vec3 up = {0, 1, 0};
+    frustum behind = frustom_create(&position, &forward, &right, &up, 16.0f / 9.0f, deg_to_rad(45.0f), 0.1f, 100.0f);
+    expect_to_be_true(render_scene_update(&fx.scene, &fx.transforms, &behind));
+    expect_should_be(0, darray_length(render_scene_visible_get(&fx.scene)));
+
+    fixture_destroy(&fx);
+    return true;
+}
+
+u8 render_scene_should_follow_moved_transforms() {
+    scene_fixture fx;
+    fixture_create(8, &fx);
+
+    transform t = transform_from_position((vec3){0.0f, 0.0f, -10.0f});
+    u32 transform_id = transform_hierarchy_add(&fx.transforms, &t, INVALID_ID);
+    render_scene_proxy_add(&fx.scene, &fx.unit_box, transform_id, 3);
+    transform_hierarchy_update(&fx.transforms, false);
+    render_scene_update(&fx.scene, &fx.transforms, &fx.f);
+    expect_should_be(1, darray_length(render_scene_visible_get(&fx.scene)));
+
+    // Moved behind the camera, it is culled in the same frame.
+    transform_hierarchy_set_position(&fx.transforms, transform_id, (vec3){0.0f, 0.0f, 10.0f});
+    transform_hierarchy_update(&fx.transforms, false);
+    expect_to_be_true(render_scene_update(&fx.scene, &fx.transforms, &fx.f));
+    expect_should_be(0, darray_length(render_scene_visible_get(&fx.scene)));
+
+    // And back again.
+    transform_hierarchy_set_position(&fx.transforms, transform_id, (vec3){0.0f, 0.0f, -5.0f});
+    transform_hierarchy_update(&fx.transforms, false);
+    expect_to_be_true(render_scene_update(&fx.scene, &fx.transforms, &fx.f));
+    geometry_render_data* visible = render_scene_visible_get(&fx.scene);
+    expect_should_be(1, darray_length(visible));
+    expect_float_to_be(-5.0f, visible[0].model.data[14]);
+
+    fixture_destroy(&fx);
+    return true;
+}
+
+u8 render_scene_should_reuse_removed_ids() {
+    scene_fixture fx;
+    fixture_create(2, &fx);
+
+    u32 a = proxy_add_at(&fx, (vec3){0.0f, 0.0f, -10.0f}, 1);
+    u32 b = proxy_add_at(&fx, (vec3){0.0f, 0.0f, -12.0f}, 2);
+    expect_should_be(INVALID_ID, proxy_add_at(&fx, (vec3){0.0f, 0.0f, -14.0f}, 3));
+    transform_hierarchy_update(&fx.transforms, false);
+    render_scene_update(&fx.scene, &fx.transforms, &fx.f);
+    expect_should_be(2, darray_length(render_scene_visible_get(&fx.scene)));
+
+    // A removal rebuilds the list, even with nothing moving.
+    expect_to_be_true(render_scene_proxy_remove(&fx.scene, a));
+    expect_to_be_false(render_scene_proxy_remove(&fx.scene, a));
+    expect_to_be_true(render_scene_update(&fx.scene, &fx.transforms, &fx.f));
+    geometry_render_data* visible = render_scene_visible_get(&fx.scene);
+    expect_should_be(1, darray_length(visible));
+    expect_should_be(2, visible[0].unique_id);
+
+    expect_should_be(a, render_scene_proxy_add(&fx.scene, &fx.unit_box, fx.scene.transform_ids[b], 4));
+    expect_should_be(2, fx.scene.count);
+
+    render_scene_clear(&fx.scene);
+    expect_should_be(0, fx.scene.count);
+    expect_to_be_true(render_scene_update(&fx.scene, &fx.transforms, &fx.f));
+    expect_should_be(0, darray_length(render_scene_visible_get(&fx.scene)));
+
+    fixture_destroy(&fx);
+    return true;
+}
+
+u8 render_scene_should_cull_and_raycast_large_scenes_through_bvh() {
+    scene_fixture fx;
+    u32 count = RENDER_SCENE_BVH_MIN_PROXIES + 76;
+    fixture_create(count, &fx);
+
+    // Rows of boxes stretching away from the camera, wider than it sees.
+    for (u32 i = 0; i < count; ++i) {
+        proxy_add_at(&fx, (vec3){((f32)(i % 50) - 25.0f) * 4.0f, 0.0f, -(f32)(i / 50) * 4.0f - 5.0f}, i);
+    }
+    transform_hierarchy_update(&fx.transforms, false);
+    render_scene_update(&fx.scene, &fx.transforms, &fx.f);
+
+    u32 expected_count = 0;
+    geometry_render_data* visible = render_scene_visible_get(&fx.scene);
+    for (u32 i = 0; i < count; ++i) {
+        vec3 center = {((f32)(i % 50) - 25.0f) * 4.0f, 0.0f, -(f32)(i / 50) * 4.0f - 5.0f};
+        vec3 half_extents = {0.5f, 0.5f, 0.5f};
+        if (frustum_intersects_aabb(&fx.f, &center, &half_extents)) {
+            // In order of id, as the boxes are.
+            expect_should_be(i, visible[expected_count].unique_id);
+            expected_count++;
+        }
+    }
+    expect_should_be(expected_count, darray_length(visible));
+    expect_to_be_true(expected_count > 0 && expected_count < count);
+
+    // Straight ahead is the middle of the nearest row.
+    ray r = {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, -1.0f}};
+    f32 distance = 0.0f;
+    expect_should_be(25, render_scene_raycast(&fx.scene, r, 1000.0f, &distance));
+    expect_float_to_be(4.5f, distance);
+
+    // Removed, the next row is hit.
+    render_scene_proxy_remove(&fx.scene, 25);
+    expect_should_be(75, render_scene_raycast(&fx.scene, r, 1000.0f, &distance));
+
+    fixture_destroy(&fx);
+    return true;
+}
+
+u8 render_scene_should_find_visible_proxies_a_ray_hits() {
+    scene_fixture fx;
+    fixture_create(8, &fx);
+
+    // Two in a line ahead, one off to the side, and one behind the camera.
+    proxy_add_at(&fx, (vec3){0.0f, 0.0f, -5.0f}, 10);
+    proxy_add_at(&fx, (vec3){0.0f, 0.0f, -10.0f}, 11);
+    proxy_add_at(&fx, (vec3){3.0f, 0.0f, -5.0f}, 12);
+    proxy_add_at(&fx, (vec3){0.0f, 0.0f, 5.0f}, 13);
+    transform_hierarchy_update(&fx.transforms, false);
+    render_scene_update(&fx.scene, &fx.transforms, &fx.f);
+
+    // Both ahead are hit, however one hides the other; the one behind, though on the ray's line, is culled.
+    geometry_render_data* hits = darray_create(geometry_render_data);
+    ray r = {{0.0f, 0.0f, 20.0f}, {0.0f, 0.0f, -1.0f}};
+    expect_should_be(2, render_scene_ray_query(&fx.scene, r, 1000.0f, &hits));
+    expect_should_be(2, darray_length(hits));
+    u32 found = 0;
+    for (u32 i = 0; i < 2; ++i) {
+        found |= 1u << (hits[i].unique_id - 10);
+    }
+    expect_should_be(0x3, found);
+
+    // Nothing is hit short of the first.
+    darray_clear(hits);
+    expect_should_be(0, render_scene_ray_query(&fx.scene, r, 20.0f, &hits));
+
+    darray_destroy(hits);
+    fixture_destroy(&fx);
+    return true;
+}
+
+void render_scene_register_tests() {
+    test_manager_register_test(render_scene_should_cull_proxies, "Render scene should cull proxies");
+    test_manager_register_test(render_scene_should_keep_list_when_nothing_changes, "Render scene should keep its list when nothing changes");
+    test_manager_register_test(render_scene_should_follow_moved_transforms, "Render scene should follow moved transforms");
+    test_manager_register_test(render_scene_should_reuse_removed_ids, "Render scene should reuse removed ids");
+    test_manager_register_test(render_scene_should_cull_and_raycast_large_scenes_through_bvh, "Render scene should cull and raycast large scenes through its bvh");
+    test_manager_register_test(render_scene_should_find_visible_proxies_a_ray_hits, "Render scene should find the visible proxies a ray hits");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void render_scene_register_tests();
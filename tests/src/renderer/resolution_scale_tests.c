@@ -0,0 +1,83 @@
+#include "resolution_scale_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <renderer/resolution_scale.h>
+
+static resolution_scale_controller test_controller(void) {
+    renderer_resolution_config config = {0};
+    config.enabled = true;
+    config.target_frame_ms = 16.0f;
+    config.min_scale = 0.5f;
+    resolution_scale_controller controller;
+    resolution_scale_controller_create(&config, &controller);
+    return controller;
+}
+
+u8 resolution_scale_should_drop_at_once_and_wait_to_settle() {
+    resolution_scale_controller controller = test_controller();
+    expect_float_to_be(1.0f, controller.scale);
+
+    // 6ms of ui leave 10ms for the world, which takes 20ms at full resolution, so needs about 0.68.
+    f32 scale = resolution_scale_update(&controller, 20.0, 6.0);
+    expect_to_be_true(scale < 0.7f);
+    expect_to_be_true(scale >= 0.6f);
+
+    // Timings of frames drawn before the change are still arriving, so are not judged.
+    for (u32 i = 0; i < RESOLUTION_SCALE_SETTLE_FRAMES; ++i) {
+        expect_float_to_be(scale, resolution_scale_update(&controller, 20.0, 6.0));
+    }
+
+    // Drawn at the new scale, the world fits, so the scale holds.
+    f32 world_ms = 20.0f * scale * scale;
+    for (u32 i = 0; i < 20; ++i) {
+        expect_float_to_be(scale, resolution_scale_update(&controller, world_ms, 6.0));
+    }
+
+    // Never below the least configured, however far over budget.
+    for (u32 i = 0; i < 20; ++i) {
+        scale = resolution_scale_update(&controller, 200.0, 6.0);
+    }
+    expect_float_to_be(0.5f, scale);
+    return true;
+}
+
+u8 resolution_scale_should_rise_slowly_to_full() {
+    resolution_scale_controller controller = test_controller();
+    controller.scale = 0.5f;
+
+    // Far under budget, the scale rises a little at a time, up to full resolution.
+    f32 last = controller.scale;
+    for (u32 i = 0; i < 100; ++i) {
+        f32 scale = resolution_scale_update(&controller, 1.0, 1.0);
+        expect_to_be_true(scale <= last + RESOLUTION_SCALE_MAX_RISE + K_FLOAT_EPSILON);
+        expect_to_be_true(scale >= last);
+        last = scale;
+    }
+    expect_float_to_be(1.0f, last);
+    return true;
+}
+
+u8 resolution_scale_should_stay_full_when_disabled_or_unmeasured() {
+    resolution_scale_controller controller = test_controller();
+    // Without timings there is nothing to go by.
+    expect_float_to_be(1.0f, resolution_scale_update(&controller, 0.0, 0.0));
+
+    controller.config.enabled = false;
+    expect_float_to_be(1.0f, resolution_scale_update(&controller, 100.0, 6.0));
+
+    // The extents rendered to are rounded, never empty and never beyond full.
+    expect_should_be(1920, resolution_scale_extent(1.0f, 1920));
+    expect_should_be(1440, resolution_scale_extent(0.75f, 1920));
+    expect_should_be(1, resolution_scale_extent(0.0f, 1920));
+    expect_should_be(720, resolution_scale_extent(2.0f, 720));
+    return true;
+}
+
+void resolution_scale_register_tests() {
+    test_manager_register_test(resolution_scale_should_drop_at_once_and_wait_to_settle, "Resolution scale should drop at once and wait to settle");
+    test_manager_register_test(resolution_scale_should_rise_slowly_to_full, "Resolution scale should rise slowly to full");
+    test_manager_register_test(resolution_scale_should_stay_full_when_disabled_or_unmeasured, "Resolution scale should stay full when disabled or unmeasured");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void resolution_scale_register_tests();
@@ -0,0 +1,219 @@
+#include "ui_batch_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <math/transform.h>
+#include <renderer/ui_batch.h>
+#include <resources/ui_text.h>
+
+static void* batch_create(u32 quad_capacity, u32 draw_capacity, ui_batch* out_batch) {
+    u64 size = 0;
+    ui_batch_create(quad_capacity * 4, quad_capacity * 6, draw_capacity, &size, 0, 0);
+    void* memory = kallocate(size, MEMORY_TAG_ARRAY);
+    ui_batch_create(quad_capacity * 4, quad_capacity * 6, draw_capacity, &size, memory, out_batch);
+    return memory;
+}
+
+static void batch_free(ui_batch* batch, void* memory) {
+    u64 size = 0;
+    ui_batch_create(batch->vertex_capacity, batch->index_capacity, batch->draw_capacity, &size, 0, 0);
+    ui_batch_destroy(batch);
+    kfree(memory, size, MEMORY_TAG_ARRAY);
+}
+
+u8 ui_batch_should_merge_draws_of_the_same_material() {
+    ui_batch batch;
+    void* memory = batch_create(16, 4, &batch);
+    material a = {0};
+    material b = {0};
+    vec4 uv = (vec4){0.0f, 0.0f, 1.0f, 1.0f};
+
+    expect_to_be_true(ui_batch_quad_add(&batch, &a, (vec4){0.0f, 0.0f, 10.0f, 10.0f}, uv));
+    expect_to_be_true(ui_batch_quad_add(&batch, &a, (vec4){20.0f, 0.0f, 10.0f, 10.0f}, uv));
+    expect_to_be_true(ui_batch_quad_add(&batch, &b, (vec4){40.0f, 0.0f, 10.0f, 10.0f}, uv));
+    // Not merged with the first draw, so it stays drawn over b.
+    expect_to_be_true(ui_batch_quad_add(&batch, &a, (vec4){60.0f, 0.0f, 10.0f, 10.0f}, uv));
+
+    expect_should_be(16, batch.vertex_count);
+    expect_should_be(24, batch.index_count);
+    expect_should_be(3, batch.draw_count);
+    expect_to_be_true(batch.draws[0].m == &a);
+    expect_should_be(0, batch.draws[0].first_index);
+    expect_should_be(12, batch.draws[0].index_count);
+    expect_to_be_true(batch.draws[1].m == &b);
+    expect_should_be(12, batch.draws[1].first_index);
+    expect_should_be(6, batch.draws[1].index_count);
+    expect_to_be_true(batch.draws[2].m == &a);
+    expect_should_be(18, batch.draws[2].first_index);
+
+    // Indices index the whole vertex array.
+    expect_should_be(4 + 2, batch.indices[6]);
+    expect_should_be(12 + 1, batch.indices[18 + 1]);
+
+    ui_batch_reset(&batch);
+    expect_should_be(0, batch.vertex_count);
+    expect_should_be(0, batch.index_count);
+    expect_should_be(0, batch.draw_count);
+
+    batch_free(&batch, memory);
+    return true;
+}
+
+u8 ui_batch_should_place_quads_and_text() {
+    ui_batch batch;
+    void* memory = batch_create(16, 4, &batch);
+    material m = {0};
+
+    expect_to_be_true(ui_batch_quad_add(&batch, &m, (vec4){5.0f, 6.0f, 10.0f, 20.0f}, (vec4){0.5f, 0.25f, 0.5f, 0.25f}));
+    expect_float_to_be(5.0f, batch.vertices[0].position.x);
+    expect_float_to_be(6.0f, batch.vertices[0].position.y);
+    expect_float_to_be(15.0f, batch.vertices[1].position.x);
+    expect_float_to_be(26.0f, batch.vertices[1].position.y);
+    expect_float_to_be(0.5f, batch.vertices[0].texcoord.x);
+    expect_float_to_be(0.25f, batch.vertices[0].texcoord.y);
+    expect_float_to_be(1.0f, batch.vertices[1].texcoord.x);
+    expect_float_to_be(0.5f, batch.vertices[1].texcoord.y);
+
+    // A text of two quads, moved by its transform.
+    font_data font = {0};
+    vertex_2d vertices[8] = {0};
+    u32 indices[12];
+    for (u32 i = 0; i < 8; ++i) {
+        vertices[i].position = (vec2){(f32)i, 1.0f};
+    }
+    for (u32 i = 0; i < 12; ++i) {
+        indices[i] = i % 8;
+    }
+    ui_text text = {0};
+    text.data = &font;
+    text.quad_count = 2;
+    text.vertices = vertices;
+    text.indices = indices;
+    text.transform = transform_create();
+    transform_set_position(&text.transform, (vec3){100.0f, 200.0f, 0.0f});
+    ui_text other = text;
+
+    expect_to_be_true(ui_batch_text_add(&batch, &text));
+    expect_to_be_true(ui_batch_text_add(&batch, &other));
+    expect_should_be(4 + 16, batch.vertex_count);
+    expect_float_to_be(103.0f, batch.vertices[4 + 3].position.x);
+    expect_float_to_be(201.0f, batch.vertices[4 + 3].position.y);
+    expect_should_be(4 + 7, batch.indices[6 + 7]);
+    expect_should_be(12 + 7, batch.indices[6 + 12 + 7]);
+
+    // Texts of the same font are drawn together, with the first's instance.
+    expect_should_be(2, batch.draw_count);
+    expect_to_be_true(batch.draws[1].m == 0);
+    expect_to_be_true(batch.draws[1].text == &text);
+    expect_to_be_true(batch.draws[1].atlas == &font.atlas);
+    expect_should_be(24, batch.draws[1].index_count);
+
+    batch_free(&batch, memory);
+    return true;
+}
+
+u8 ui_batch_should_refuse_when_full() {
+    ui_batch batch;
+    void* memory = batch_create(2, 2, &batch);
+    material a = {0};
+    material b = {0};
+    material c = {0};
+    vec4 rect = (vec4){0.0f, 0.0f, 1.0f, 1.0f};
+
+    // Out of draws.
+    expect_to_be_true(ui_batch_quad_add(&batch, &a, rect, rect));
+    expect_to_be_true(ui_batch_quad_add(&batch, &b, rect, rect));
+    expect_to_be_false(ui_batch_quad_add(&batch, &c, rect, rect));
+    // Out of vertices.
+    ui_batch_reset(&batch);
+    expect_to_be_true(ui_batch_quad_add(&batch, &a, rect, rect));
+    expect_to_be_true(ui_batch_quad_add(&batch, &a, rect, rect));
+    expect_to_be_false(ui_batch_quad_add(&batch, &a, rect, rect));
+    expect_should_be(8, batch.vertex_count);
+    expect_should_be(12, batch.draws[0].index_count);
+
+    batch_free(&batch, memory);
+    return true;
+}
+
+u8 ui_batch_should_track_changes_since_loaded() {
+    ui_batch batch;
+    void* memory = batch_create(16, 4, &batch);
+    material a = {0};
+    vec4 uv = (vec4){0.0f, 0.0f, 1.0f, 1.0f};
+
+    // Nothing has been loaded, so everything is dirty.
+    expect_to_be_true(ui_batch_quad_add(&batch, &a, (vec4){0.0f, 0.0f, 10.0f, 10.0f}, uv));
+    expect_to_be_true(ui_batch_quad_add(&batch, &a, (vec4){20.0f, 0.0f, 10.0f, 10.0f}, uv));
+    expect_should_be(0, batch.dirty_vertex_first);
+    expect_should_be(7, batch.dirty_vertex_last);
+    expect_should_be(0, batch.dirty_index_first);
+    expect_should_be(11, batch.dirty_index_last);
+
+    // The same frame again changes nothing.
+    ui_batch_mark_loaded(&batch);
+    ui_batch_reset(&batch);
+    expect_to_be_true(ui_batch_quad_add(&batch, &a, (vec4){0.0f, 0.0f, 10.0f, 10.0f}, uv));
+    expect_to_be_true(ui_batch_quad_add(&batch, &a, (vec4){20.0f, 0.0f, 10.0f, 10.0f}, uv));
+    expect_should_be(INVALID_ID, batch.dirty_vertex_first);
+    expect_should_be(INVALID_ID, batch.dirty_index_first);
+
+    // Moving the second quad dirties only its vertices, and a third quad is past what was loaded.
+    ui_batch_mark_loaded(&batch);
+    ui_batch_reset(&batch);
+    expect_to_be_true(ui_batch_quad_add(&batch, &a, (vec4){0.0f, 0.0f, 10.0f, 10.0f}, uv));
+    expect_to_be_true(ui_batch_quad_add(&batch, &a, (vec4){30.0f, 0.0f, 10.0f, 10.0f}, uv));
+    expect_should_be(4, batch.dirty_vertex_first);
+    expect_should_be(7, batch.dirty_vertex_last);
+    expect_should_be(INVALID_ID, batch.dirty_index_first);
+    expect_to_be_true(ui_batch_quad_add(&batch, &a, (vec4){0.0f, 0.0f, 10.0f, 10.0f}, uv));
+    expect_should_be(11, batch.dirty_vertex_last);
+    expect_should_be(12, batch.dirty_index_first);
+    expect_should_be(17, batch.dirty_index_last);
+
+    // After a failed load, the same frame is dirty again.
+    ui_batch_mark_unloaded(&batch);
+    ui_batch_reset(&batch);
+    expect_to_be_true(ui_batch_quad_add(&batch, &a, (vec4){0.0f, 0.0f, 10.0f, 10.0f}, uv));
+    expect_should_be(0, batch.dirty_vertex_first);
+    expect_should_be(3, batch.dirty_vertex_last);
+
+    batch_free(&batch, memory);
+    return true;
+}
+
+u8 ui_batch_should_split_draws_clipped_differently() {
+    ui_batch batch;
+    void* memory = batch_create(16, 4, &batch);
+    material a = {0};
+    vec4 rect = (vec4){0.0f, 0.0f, 1.0f, 1.0f};
+    vec4 clip = (vec4){10.0f, 20.0f, 30.0f, 40.0f};
+
+    expect_to_be_true(ui_batch_quad_add(&batch, &a, rect, rect));
+    ui_batch_clip_set(&batch, clip);
+    expect_to_be_true(ui_batch_quad_add(&batch, &a, rect, rect));
+    expect_to_be_true(ui_batch_quad_add(&batch, &a, rect, rect));
+    expect_should_be(2, batch.draw_count);
+    expect_float_to_be(0.0f, batch.draws[0].clip_rect.z);
+    expect_float_to_be(30.0f, batch.draws[1].clip_rect.z);
+    expect_should_be(12, batch.draws[1].index_count);
+
+    // Resetting stops clipping.
+    ui_batch_reset(&batch);
+    expect_to_be_true(ui_batch_quad_add(&batch, &a, rect, rect));
+    expect_float_to_be(0.0f, batch.draws[0].clip_rect.z);
+
+    batch_free(&batch, memory);
+    return true;
+}
+
+void ui_batch_register_tests() {
+    test_manager_register_test(ui_batch_should_merge_draws_of_the_same_material, "UI batches should merge draws of the same material");
+    test_manager_register_test(ui_batch_should_place_quads_and_text, "UI batches should place quads and text");
+    test_manager_register_test(ui_batch_should_refuse_when_full, "UI batches should refuse additions when full");
+    test_manager_register_test(ui_batch_should_track_changes_since_loaded, "UI batches should track what changed since they were loaded");
+    test_manager_register_test(ui_batch_should_split_draws_clipped_differently, "UI batches should split draws clipped differently");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void ui_batch_register_tests();
@@ -0,0 +1,176 @@
+#include "asset_archive_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <math/kmath.h>
+#include <platform/filesystem.h>
+#include <resources/asset_archive.h>
+#include <systems/resource_system.h>
+
+#include <stdio.h>  // remove
+
+#define ARCHIVE_TEST_PATH "asset_archive_test.kpak"
+#define ARCHIVE_TEST_BASE_PATH "archive_test"
+#define ARCHIVE_TEST_TEXT_SIZE 50000
+#define ARCHIVE_TEST_RANDOM_SIZE 3000
+
+static const char* material_text = "version=0.1\nname=packed\n\ndiffuse_colour=0.5 0.25 1.0 1.0\nshininess=8.0\n";
+
+typedef struct archive_test_data {
+    u8 text[ARCHIVE_TEST_TEXT_SIZE];
+    u8 random[ARCHIVE_TEST_RANDOM_SIZE];
+    asset_archive_source sources[4];
+} archive_test_data;
+
+static void archive_test_data_create(archive_test_data* data) {
+    krandom_state rng;
+    krandom_state_seed(&rng, 7);
+    const char* words[] = {"diffuse ", "specular ", "normal ", "\n"};
+    for (u32 i = 0; i < ARCHIVE_TEST_TEXT_SIZE;) {
+        const char* word = words[krandom_state_u32(&rng) % 4];
+        for (u32 j = 0; word[j] && i < ARCHIVE_TEST_TEXT_SIZE; ++j) {
+            data->text[i++] = (u8)word[j];
+        }
+    }
+    for (u32 i = 0; i < ARCHIVE_TEST_RANDOM_SIZE; ++i) {
+        data->random[i] = (u8)krandom_state_u32(&rng);
+    }
+    data->sources[0] = (asset_archive_source){"textures/words.txt", data->text, ARCHIVE_TEST_TEXT_SIZE};
+    data->sources[1] = (asset_archive_source){"meshes/random.ksm", data->random, ARCHIVE_TEST_RANDOM_SIZE};
+    data->sources[2] = (asset_archive_source){"shaders/empty", 0, 0};
+    data->sources[3] = (asset_archive_source){"materials/packed.kmt", material_text, string_length(material_text)};
+}
+
+static b8 bytes_equal(const void* a, const void* b, u64 size) {
+    for (u64 i = 0; i < size; ++i) {
+        if (((const u8*)a)[i] != ((const u8*)b)[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+u8 asset_archive_should_find_and_read_entries() {
+    archive_test_data* data = kallocate(sizeof(archive_test_data), MEMORY_TAG_ARRAY);
+    archive_test_data_create(data);
+    expect_to_be_true(asset_archive_write(ARCHIVE_TEST_PATH, 4, data->sources, true));
+
+    asset_archive archive;
+    expect_to_be_true(asset_archive_open(ARCHIVE_TEST_PATH, &archive));
+    expect_should_be(4, archive.entry_count);
+    for (u32 i = 0; i < 4; ++i) {
+        const asset_archive_entry* entry = asset_archive_find(&archive, data->sources[i].name);
+        expect_to_be_true((entry != 0));
+        expect_should_be(data->sources[i].size, entry->size);
+        expect_should_be(0, entry->offset % ASSET_ARCHIVE_ALIGNMENT);
+        u8* contents = kallocate(entry->size + 1, MEMORY_TAG_ARRAY);
+        expect_to_be_true(asset_archive_read(&archive, entry, contents));
+        expect_to_be_true(bytes_equal(contents, data->sources[i].data, entry->size));
+        kfree(contents, entry->size + 1, MEMORY_TAG_ARRAY);
+    }
+
+    // Only what compresses well is compressed.
+    const asset_archive_entry* text = asset_archive_find(&archive, "textures/words.txt");
+    expect_should_be(ASSET_ARCHIVE_COMPRESSION_LZ4, text->compression);
+    expect_to_be_true((text->stored_size < ARCHIVE_TEST_TEXT_SIZE / 2));
+    const asset_archive_entry* random = asset_archive_find(&archive, "meshes/random.ksm");
+    expect_should_be(ASSET_ARCHIVE_COMPRESSION_NONE, random->compression);
+    expect_to_be_true(bytes_equal(asset_archive_entry_data(&archive, random), data->random, ARCHIVE_TEST_RANDOM_SIZE));
+
+    // Names are matched exactly.
+    expect_should_be(0, asset_archive_find(&archive, "textures/Words.txt"));
+    expect_should_be(0, asset_archive_find(&archive, "textures/words"));
+    expect_should_be(0, asset_archive_find(&archive, "missing"));
+    asset_archive_close(&archive);
+    expect_should_be(0, asset_archive_find(&archive, "meshes/random.ksm"));
+
+    // Names must be unique.
+    data->sources[2].name = data->sources[0].name;
+    expect_to_be_false(asset_archive_write(ARCHIVE_TEST_PATH "2", 4, data->sources, false));
+
+    // A truncated archive is rejected.
+    expect_to_be_true(asset_archive_write(ARCHIVE_TEST_PATH, 2, data->sources, false));
+    file_mapping mapping;
+    expect_to_be_true(filesystem_map(ARCHIVE_TEST_PATH, &mapping));
+    file_handle f;
+    expect_to_be_true(filesystem_open(ARCHIVE_TEST_PATH "2", FILE_MODE_WRITE, true, &f));
+    u64 written = 0;
+    expect_to_be_true(filesystem_write(&f, sizeof(asset_archive_header) + sizeof(asset_archive_entry), mapping.data, &written));
+    filesystem_close(&f);
+    filesystem_unmap(&mapping);
+    expect_to_be_false(asset_archive_open(ARCHIVE_TEST_PATH "2", &archive));
+
+    remove(ARCHIVE_TEST_PATH);
+    remove(ARCHIVE_TEST_PATH "2");
+    expect_to_be_false(asset_archive_open(ARCHIVE_TEST_PATH, &archive));
+    kfree(data, sizeof(archive_test_data), MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 resource_system_should_load_from_mounted_archive() {
+    archive_test_data* data = kallocate(sizeof(archive_test_data), MEMORY_TAG_ARRAY);
+    archive_test_data_create(data);
+    expect_to_be_true(asset_archive_write(ARCHIVE_TEST_PATH, 4, data->sources, true));
+
+    resource_system_config config = {};
+    config.asset_base_path = ARCHIVE_TEST_BASE_PATH;
+    config.max_loader_count = 32;
+    u64 memory_requirement = 0;
+    expect_to_be_true(resource_system_initialize(&memory_requirement, 0, config));
+    void* state = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    expect_to_be_true(resource_system_initialize(&memory_requirement, state, config));
+    expect_to_be_true(resource_system_mount_archive(ARCHIVE_TEST_PATH));
+
+    // Paths are looked up relative to the base path.
+    expect_to_be_true(resource_system_file_exists(ARCHIVE_TEST_BASE_PATH "/textures/words.txt"));
+    expect_to_be_false(resource_system_file_exists(ARCHIVE_TEST_BASE_PATH "/textures/missing.txt"));
+    resource_file file;
+    expect_to_be_true(resource_system_file_open(ARCHIVE_TEST_BASE_PATH "/textures/words.txt", &file));
+    expect_should_be(ARCHIVE_TEST_TEXT_SIZE, file.size);
+    expect_to_be_true(bytes_equal(file.data, data->text, ARCHIVE_TEST_TEXT_SIZE));
+    resource_system_file_close(&file);
+    expect_should_be(0, file.data);
+
+    // Uncompressed entries are used in place.
+    expect_to_be_true(resource_system_file_open(ARCHIVE_TEST_BASE_PATH "/meshes/random.ksm", &file));
+    expect_should_be(0, file.allocated);
+    expect_to_be_true(bytes_equal(file.data, data->random, ARCHIVE_TEST_RANDOM_SIZE));
+    resource_system_file_close(&file);
+
+    // Loose files are still found.
+    expect_to_be_false(resource_system_file_open(ARCHIVE_TEST_BASE_PATH "/loose.bin", &file));
+    expect_to_be_true(resource_system_file_exists(ARCHIVE_TEST_PATH));
+    expect_to_be_true(resource_system_file_open(ARCHIVE_TEST_PATH, &file));
+    expect_to_be_true((file.size > ARCHIVE_TEST_RANDOM_SIZE));
+    resource_system_file_close(&file);
+
+    // Loaders read from the archive.
+    resource material;
+    expect_to_be_true(resource_system_load("packed", RESOURCE_TYPE_MATERIAL, 0, &material));
+    material_config* config_data = material.data;
+    expect_to_be_true(strings_equal("packed", config_data->name));
+    expect_float_to_be(0.25f, config_data->diffuse_colour.y);
+    expect_float_to_be(8.0f, config_data->shininess);
+    resource_system_unload(&material);
+
+    resource binary;
+    expect_to_be_true(resource_system_load("meshes/random.ksm", RESOURCE_TYPE_BINARY, 0, &binary));
+    expect_should_be(ARCHIVE_TEST_RANDOM_SIZE, binary.data_size);
+    expect_to_be_true(bytes_equal(binary.data, data->random, ARCHIVE_TEST_RANDOM_SIZE));
+    resource_system_unload(&binary);
+
+    resource_system_shutdown(state);
+    kfree(state, memory_requirement, MEMORY_TAG_APPLICATION);
+    remove(ARCHIVE_TEST_PATH);
+    kfree(data, sizeof(archive_test_data), MEMORY_TAG_ARRAY);
+    return true;
+}
+
+void asset_archive_register_tests() {
+    test_manager_register_test(asset_archive_should_find_and_read_entries, "Asset archives should find and read their entries");
+    test_manager_register_test(resource_system_should_load_from_mounted_archive, "Resource system should load from a mounted archive");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void asset_archive_register_tests();
@@ -0,0 +1,49 @@
+#include "dependency_manifest_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <containers/darray.h>
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <resources/dependency_manifest.h>
+
+u8 dependency_manifest_should_list_each_asset_once() {
+    dependency_manifest manifest;
+    dependency_manifest_create(&manifest);
+    expect_to_be_true(dependency_manifest_add(&manifest, DEPENDENCY_TYPE_TEXTURE, "stone_diffuse"));
+    expect_to_be_true(dependency_manifest_add(&manifest, DEPENDENCY_TYPE_TEXTURE, "stone_normal"));
+    expect_to_be_false(dependency_manifest_add(&manifest, DEPENDENCY_TYPE_TEXTURE, "Stone_Diffuse"));
+    expect_to_be_false(dependency_manifest_add(&manifest, DEPENDENCY_TYPE_TEXTURE, ""));
+    // The same name is a different asset of another kind.
+    expect_to_be_true(dependency_manifest_add(&manifest, DEPENDENCY_TYPE_MATERIAL, "stone_diffuse"));
+    expect_should_be(3, darray_length(manifest.entries));
+
+    u64 size = 0;
+    void* data = dependency_manifest_build(&manifest, &size);
+    dependency_manifest read;
+    expect_to_be_true(dependency_manifest_read(data, size, "test.kdm", &read));
+    expect_should_be(3, darray_length(read.entries));
+    for (u32 i = 0; i < 3; ++i) {
+        expect_should_be(manifest.entries[i].type, read.entries[i].type);
+        expect_to_be_true(strings_equal(manifest.entries[i].name, read.entries[i].name));
+    }
+    dependency_manifest_destroy(&read);
+    expect_should_be(0, read.entries);
+
+    // Files cut short, or of another version, are refused.
+    expect_to_be_false(dependency_manifest_read(data, size - 1, "test.kdm", &read));
+    dependency_manifest_destroy(&read);
+    ((u32*)data)[1] = DEPENDENCY_MANIFEST_VERSION + 1;
+    expect_to_be_false(dependency_manifest_read(data, size, "test.kdm", &read));
+    dependency_manifest_destroy(&read);
+
+    kfree(data, size, MEMORY_TAG_ARRAY);
+    dependency_manifest_destroy(&manifest);
+    return true;
+}
+
+void dependency_manifest_register_tests() {
+    test_manager_register_test(dependency_manifest_should_list_each_asset_once, "Dependency manifests should list each asset once");
+}
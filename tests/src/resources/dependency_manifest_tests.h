@@ -0,0 +1,3 @@
+#pragma once
+
+void dependency_manifest_register_tests();
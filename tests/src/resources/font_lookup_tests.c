@@ -0,0 +1,94 @@
+#include "font_lookup_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <resources/font_lookup.h>
+
+static void* lookup_create(u32 glyph_count, const font_glyph* glyphs, u32 kerning_count, const font_kerning* kernings, u64* out_size, font_lookup* out_lookup) {
+    font_lookup_create(glyph_count, glyphs, kerning_count, kernings, out_size, 0, 0);
+    void* memory = kallocate(*out_size, MEMORY_TAG_ARRAY);
+    font_lookup_create(glyph_count, glyphs, kerning_count, kernings, out_size, memory, out_lookup);
+    return memory;
+}
+
+u8 font_lookup_should_find_glyphs() {
+    // Ascii, Latin-1, beyond, and more than the hash table's smallest size.
+    font_glyph glyphs[64] = {0};
+    u32 count = 0;
+    glyphs[count++].codepoint = -1;
+    for (i32 c = 'a'; c <= 'z'; ++c) {
+        glyphs[count++].codepoint = c;
+    }
+    glyphs[count++].codepoint = 0xE9;
+    for (i32 c = 0x3B1; c < 0x3B1 + 24; ++c) {
+        glyphs[count++].codepoint = c;
+    }
+    for (u32 i = 0; i < count; ++i) {
+        glyphs[i].x_advance = (i16)i;
+    }
+
+    u64 size = 0;
+    font_lookup lookup;
+    void* memory = lookup_create(count, glyphs, 0, 0, &size, &lookup);
+
+    for (u32 i = 0; i < count; ++i) {
+        expect_to_be_true(font_lookup_glyph(&lookup, glyphs[i].codepoint) == &glyphs[i]);
+    }
+    // Anything else finds the glyph of -1.
+    expect_to_be_true(font_lookup_glyph(&lookup, 'A') == &glyphs[0]);
+    expect_to_be_true(font_lookup_glyph(&lookup, 0x4E2D) == &glyphs[0]);
+    expect_to_be_true(font_lookup_glyph(&lookup, -7) == &glyphs[0]);
+
+    font_lookup_destroy(&lookup);
+    kfree(memory, size, MEMORY_TAG_ARRAY);
+
+    // Without a glyph of -1, nothing is found.
+    memory = lookup_create(count - 1, glyphs + 1, 0, 0, &size, &lookup);
+    expect_to_be_true(font_lookup_glyph(&lookup, 'A') == 0);
+    expect_to_be_true(font_lookup_glyph(&lookup, 0x4E2D) == 0);
+    expect_to_be_true(font_lookup_glyph(&lookup, 'b') == &glyphs[2]);
+    font_lookup_destroy(&lookup);
+    kfree(memory, size, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 font_lookup_should_find_kernings() {
+    font_kerning kernings[] = {
+        {'A', 'V', -3},
+        {'V', 'A', -2},
+        {'T', 'o', -4},
+        {0x3B1, 'A', 5},
+        {'A', 'V', -6}};
+
+    u64 size = 0;
+    font_lookup lookup;
+    void* memory = lookup_create(0, 0, 5, kernings, &size, &lookup);
+
+    // The last of a repeated pair is used.
+    expect_should_be(-6, font_lookup_kerning(&lookup, 'A', 'V'));
+    expect_should_be(-2, font_lookup_kerning(&lookup, 'V', 'A'));
+    expect_should_be(-4, font_lookup_kerning(&lookup, 'T', 'o'));
+    expect_should_be(5, font_lookup_kerning(&lookup, 0x3B1, 'A'));
+    expect_should_be(0, font_lookup_kerning(&lookup, 'o', 'T'));
+    expect_should_be(0, font_lookup_kerning(&lookup, 'A', 0x3B1));
+
+    font_lookup_destroy(&lookup);
+    kfree(memory, size, MEMORY_TAG_ARRAY);
+
+    // No pairs at all, needing no memory but for the lookup itself.
+    u8 unused = 0;
+    font_lookup_create(0, 0, 0, 0, &size, 0, 0);
+    expect_should_be(0, size);
+    expect_to_be_true(font_lookup_create(0, 0, 0, 0, &size, &unused, &lookup));
+    expect_should_be(0, font_lookup_kerning(&lookup, 'A', 'V'));
+    font_lookup_destroy(&lookup);
+    return true;
+}
+
+void font_lookup_register_tests() {
+    test_manager_register_test(font_lookup_should_find_glyphs, "Font lookups should find glyphs by codepoint");
+    test_manager_register_test(font_lookup_should_find_kernings, "Font lookups should find kernings by pair");
+}
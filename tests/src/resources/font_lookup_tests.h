@@ -0,0 +1,3 @@
+#pragma once
+
+void font_lookup_register_tests();
@@ -0,0 +1,77 @@
+#include "material_loader_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <math/kmath.h>
+#include <resources/asset_archive.h>
+#include <resources/loaders/material_loader.h>
+#include <systems/resource_system.h>
+
+#include <stdio.h>  // remove
+
+#define MATERIAL_TEST_ARCHIVE_PATH "material_loader_test.kpak"
+#define MATERIAL_TEST_BASE_PATH "material_test"
+
+u8 material_loader_should_load_binary_materials() {
+    material_config config = {};
+    string_ncopy(config.name, "cooked", MATERIAL_NAME_MAX_LENGTH - 1);
+    config.shader_name = "Shader.Builtin.Material";
+    config.diffuse_colour = (vec4){0.5f, 0.25f, 1.0f, 0.75f};
+    config.shininess = 16.0f;
+    config.atlas = true;
+    string_ncopy(config.diffuse_map_name, "stone_diffuse", TEXTURE_NAME_MAX_LENGTH - 1);
+    string_ncopy(config.normal_map_name, "stone_normal", TEXTURE_NAME_MAX_LENGTH - 1);
+
+    kmb_file* files = kallocate(sizeof(kmb_file) * 2, MEMORY_TAG_ARRAY);
+    kmb_file_create(&config, 0, &files[0]);
+    // The same material, from a version which is no longer read.
+    kmb_file_create(&config, 0, &files[1]);
+    files[1].version = KMB_VERSION + 1;
+
+    asset_archive_source sources[2] = {
+        {"materials/cooked.kmb", &files[0], sizeof(kmb_file)},
+        {"materials/future.kmb", &files[1], sizeof(kmb_file)}};
+    expect_to_be_true(asset_archive_write(MATERIAL_TEST_ARCHIVE_PATH, 2, sources, false));
+
+    resource_system_config resource_config = {};
+    resource_config.asset_base_path = MATERIAL_TEST_BASE_PATH;
+    resource_config.max_loader_count = 32;
+    u64 memory_requirement = 0;
+    expect_to_be_true(resource_system_initialize(&memory_requirement, 0, resource_config));
+    void* state = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    expect_to_be_true(resource_system_initialize(&memory_requirement, state, resource_config));
+    expect_to_be_true(resource_system_mount_archive(MATERIAL_TEST_ARCHIVE_PATH));
+
+    resource material;
+    expect_to_be_true(resource_system_load("cooked", RESOURCE_TYPE_MATERIAL, 0, &material));
+    material_config* loaded = material.data;
+    expect_to_be_true(strings_equal("cooked", loaded->name));
+    expect_to_be_true(strings_equal("Shader.Builtin.Material", loaded->shader_name));
+    expect_to_be_true(strings_equal("stone_diffuse", loaded->diffuse_map_name));
+    expect_should_be(0, loaded->specular_map_name[0]);
+    expect_to_be_true(strings_equal("stone_normal", loaded->normal_map_name));
+    expect_float_to_be(0.25f, loaded->diffuse_colour.y);
+    expect_float_to_be(0.75f, loaded->diffuse_colour.w);
+    expect_float_to_be(16.0f, loaded->shininess);
+    expect_to_be_true(loaded->atlas);
+    expect_to_be_true(loaded->auto_release);
+    resource_system_unload(&material);
+
+    // Other versions are refused rather than misread.
+    resource future;
+    expect_to_be_false(resource_system_load("future", RESOURCE_TYPE_MATERIAL, 0, &future));
+
+    resource_system_shutdown(state);
+    kfree(state, memory_requirement, MEMORY_TAG_APPLICATION);
+    kfree(files, sizeof(kmb_file) * 2, MEMORY_TAG_ARRAY);
+    remove(MATERIAL_TEST_ARCHIVE_PATH);
+    return true;
+}
+
+void material_loader_register_tests() {
+    test_manager_register_test(material_loader_should_load_binary_materials, "Material loader should load binary materials");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void material_loader_register_tests();
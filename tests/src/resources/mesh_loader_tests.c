@@ -0,0 +1,299 @@
+#include "mesh_loader_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <math/geometry_utils.h>
+#include <math/kmath.h>
+#include <resources/asset_archive.h>
+#include <resources/loaders/mesh_loader.h>
+#include <systems/geometry_system.h>
+#include <systems/resource_system.h>
+
+#include <stdio.h>  // remove
+
+#define MESH_TEST_ARCHIVE_PATH "mesh_loader_test.kpak"
+#define MESH_TEST_BASE_PATH "mesh_test"
+
+// Fills in a triangle with an odd number of vertices, so its indices need padding to be aligned.
+static void mesh_test_triangle_create(geometry_config* g, vertex_3d* vertices, u32* indices, f32 offset) {
+    for (u32 i = 0; i < 3; ++i) {
+        vertices[i] = (vertex_3d){};
+        vertices[i].position = vec3_create(offset + i, (f32)i * 2.0f, -1.0f);
+        vertices[i].normal = vec3_create(0, 0, 1);
+        vertices[i].colour = vec4_one();
+        vertices[i].tangent = vec3_create(1, 0, 0);
+        indices[i] = 2 - i;
+    }
+    *g = (geometry_config){};
+    g->vertex_size = sizeof(vertex_3d);
+    g->vertex_count = 3;
+    g->vertices = vertices;
+    g->index_size = sizeof(u32);
+    g->index_count = 3;
+    g->indices = indices;
+    g->lod_count = 1;
+    g->lods[0] = (geometry_lod){0, 3, 0.0f};
+    g->min_extents = vec3_create(offset, 0, -1);
+    g->max_extents = vec3_create(offset + 2, 4, -1);
+}
+
+// Writes the contents of a version 3 file holding a single packed triangle.
+static u64 mesh_test_v3_file_create(u8* out_data, const vertex_3d_packed* vertices, const u32* indices) {
+    u64 size = 0;
+#define WRITE(value_size, value)                        \
+    kcopy_memory(out_data + size, value, value_size); \
+    size += value_size;
+    u16 version = 3;
+    u32 name_length = 4;
+    u32 geometry_count = 1;
+    u32 vertex_size = sizeof(vertex_3d_packed);
+    u32 count = 3;
+    u32 index_size = sizeof(u32);
+    u32 material_name_length = 4;
+    vec3 bounds = vec3_create(1, 2, 3);
+    u32 lod_count = 1;
+    geometry_lod lod = {0, 3, 0.0f};
+    WRITE(sizeof(u16), &version);
+    WRITE(sizeof(u32), &name_length);
+    WRITE(name_length, "old");
+    WRITE(sizeof(u32), &geometry_count);
+    WRITE(sizeof(u32), &vertex_size);
+    WRITE(sizeof(u32), &count);
+    WRITE(sizeof(vertex_3d_packed) * 3, vertices);
+    WRITE(sizeof(u32), &index_size);
+    WRITE(sizeof(u32), &count);
+    WRITE(sizeof(u32) * 3, indices);
+    WRITE(sizeof(u32), &name_length);
+    WRITE(name_length, "old");
+    WRITE(sizeof(u32), &material_name_length);
+    WRITE(material_name_length, "mat");
+    WRITE(sizeof(vec3), &bounds);
+    WRITE(sizeof(vec3), &bounds);
+    WRITE(sizeof(vec3), &bounds);
+    WRITE(sizeof(u32), &lod_count);
+    WRITE(sizeof(geometry_lod), &lod);
+#undef WRITE
+    return size;
+}
+
+static b8 mesh_test_bytes_equal(const void* a, const void* b, u64 size) {
+    const u8* x = a;
+    const u8* y = b;
+    for (u64 i = 0; i < size; ++i) {
+        if (x[i] != y[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+u8 mesh_loader_should_load_geometry_in_place() {
+    vertex_3d vertices[2][3];
+    u32 indices[2][3];
+    geometry_config geometries[2];
+    mesh_test_triangle_create(&geometries[0], vertices[0], indices[0], 0.0f);
+    mesh_test_triangle_create(&geometries[1], vertices[1], indices[1], 10.0f);
+    string_ncopy(geometries[0].name, "first", GEOMETRY_NAME_MAX_LENGTH - 1);
+    string_ncopy(geometries[1].name, "second", GEOMETRY_NAME_MAX_LENGTH - 1);
+    string_ncopy(geometries[1].material_name, "stone", MATERIAL_NAME_MAX_LENGTH - 1);
+    geometry_meshlet meshlet = {0, 3, 3, {{10, 0, -1}, {12, 4, -1}}, {0, 0, 1}, 0.0f};
+    geometries[1].meshlet_count = 1;
+    geometries[1].meshlets = &meshlet;
+
+    u64 ksm_size = 0;
+    void* ksm = ksm_file_build("triangles", 2, geometries, false, &ksm_size);
+    expect_to_be_true((ksm != 0));
+
+    // The same first triangle, in a file of the previous version.
+    vertex_3d_packed packed[3];
+    geometry_pack_vertices(3, vertices[0], packed);
+    u8 old_ksm[2048];
+    u64 old_ksm_size = mesh_test_v3_file_create(old_ksm, packed, indices[0]);
+
+    asset_archive_source sources[2] = {
+        {"models/triangles.ksm", ksm, ksm_size},
+        {"models/old.ksm", old_ksm, old_ksm_size}};
+    expect_to_be_true(asset_archive_write(MESH_TEST_ARCHIVE_PATH, 2, sources, false));
+
+    resource_system_config config = {};
+    config.asset_base_path = MESH_TEST_BASE_PATH;
+    config.max_loader_count = 32;
+    u64 memory_requirement = 0;
+    expect_to_be_true(resource_system_initialize(&memory_requirement, 0, config));
+    void* state = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    expect_to_be_true(resource_system_initialize(&memory_requirement, state, config));
+    expect_to_be_true(resource_system_mount_archive(MESH_TEST_ARCHIVE_PATH));
+
+    // The current version is used straight out of the archive, with the blobs aligned.
+    resource mesh;
+    expect_to_be_true(resource_system_load("triangles", RESOURCE_TYPE_MESH, 0, &mesh));
+    expect_should_be(2, mesh.data_size);
+    expect_to_be_true((mesh.loader_data != 0));
+    const resource_file* file = mesh.loader_data;
+    geometry_config* loaded = mesh.data;
+    for (u32 i = 0; i < 2; ++i) {
+        const u8* v = loaded[i].vertices;
+        const u8* ix = loaded[i].indices;
+        expect_should_be(sizeof(vertex_3d_packed), loaded[i].vertex_size);
+        expect_should_be(3, loaded[i].vertex_count);
+        expect_should_be(3, loaded[i].index_count);
+        expect_should_be(0, ((u64)v % 16));
+        expect_should_be(0, ((u64)ix % 16));
+        expect_to_be_true((v >= (const u8*)file->data && v + sizeof(vertex_3d_packed) * 3 <= (const u8*)file->data + file->size));
+        expect_to_be_true((ix >= (const u8*)file->data && ix + sizeof(u32) * 3 <= (const u8*)file->data + file->size));
+        expect_to_be_true(mesh_test_bytes_equal(ix, indices[i], sizeof(u32) * 3));
+        expect_float_to_be(vertices[i][1].position.x, ((vertex_3d_packed*)v)[1].position.x);
+        expect_should_be(1, loaded[i].lod_count);
+        expect_should_be(3, loaded[i].lods[0].index_count);
+        expect_float_to_be(geometries[i].max_extents.x, loaded[i].max_extents.x);
+    }
+    expect_to_be_true(strings_equal("second", loaded[1].name));
+    expect_to_be_true(strings_equal("stone", loaded[1].material_name));
+    // Meshlets are copied out, even when the rest is borrowed.
+    expect_should_be(0, loaded[0].meshlet_count);
+    expect_should_be(1, loaded[1].meshlet_count);
+    expect_to_be_true((loaded[1].meshlets < (geometry_meshlet*)file->data || loaded[1].meshlets >= (geometry_meshlet*)((u8*)file->data + file->size)));
+    expect_to_be_true(mesh_test_bytes_equal(loaded[1].meshlets, &meshlet, sizeof(geometry_meshlet)));
+    resource_system_unload(&mesh);
+    expect_should_be(0, mesh.loader_data);
+
+    // The previous version is still read, into copies.
+    resource old_mesh;
+    expect_to_be_true(resource_system_load("old", RESOURCE_TYPE_MESH, 0, &old_mesh));
+    expect_should_be(1, old_mesh.data_size);
+    expect_should_be(0, old_mesh.loader_data);
+    loaded = old_mesh.data;
+    expect_should_be(3, loaded[0].vertex_count);
+    expect_to_be_true(mesh_test_bytes_equal(loaded[0].vertices, packed, sizeof(packed)));
+    expect_to_be_true(mesh_test_bytes_equal(loaded[0].indices, indices[0], sizeof(u32) * 3));
+    expect_to_be_true(strings_equal("mat", loaded[0].material_name));
+    expect_float_to_be(2.0f, loaded[0].center.y);
+    resource_system_unload(&old_mesh);
+
+    resource_system_shutdown(state);
+    kfree(state, memory_requirement, MEMORY_TAG_APPLICATION);
+    kfree_aligned(ksm, ksm_size, 16, MEMORY_TAG_ARRAY);
+    remove(MESH_TEST_ARCHIVE_PATH);
+    return true;
+}
+
+#define MESH_TEST_GRID_SIZE 32
+
+u8 mesh_loader_should_load_compressed_streams() {
+    // A grid, which like most meshes has smoothly varying vertices and indices of nearby vertices.
+    u32 vertex_count = MESH_TEST_GRID_SIZE * MESH_TEST_GRID_SIZE;
+    u32 index_count = (MESH_TEST_GRID_SIZE - 1) * (MESH_TEST_GRID_SIZE - 1) * 6;
+    vertex_3d* vertices = kallocate(sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    u32* indices = kallocate(sizeof(u32) * index_count, MEMORY_TAG_ARRAY);
+    for (u32 y = 0; y < MESH_TEST_GRID_SIZE; ++y) {
+        for (u32 x = 0; x < MESH_TEST_GRID_SIZE; ++x) {
+            vertex_3d* v = &vertices[y * MESH_TEST_GRID_SIZE + x];
+            v->position = vec3_create((f32)x, 0.0f, (f32)y);
+            v->normal = vec3_create(0, 1, 0);
+            v->texcoord = vec2_create((f32)x / MESH_TEST_GRID_SIZE, (f32)y / MESH_TEST_GRID_SIZE);
+            v->colour = vec4_one();
+            v->tangent = vec3_create(1, 0, 0);
+        }
+    }
+    u32 written = 0;
+    for (u32 y = 0; y < MESH_TEST_GRID_SIZE - 1; ++y) {
+        for (u32 x = 0; x < MESH_TEST_GRID_SIZE - 1; ++x) {
+            u32 corner = y * MESH_TEST_GRID_SIZE + x;
+            u32 quad[6] = {corner, corner + MESH_TEST_GRID_SIZE, corner + 1, corner + 1, corner + MESH_TEST_GRID_SIZE, corner + MESH_TEST_GRID_SIZE + 1};
+            kcopy_memory(&indices[written], quad, sizeof(quad));
+            written += 6;
+        }
+    }
+    geometry_config geometry = {};
+    geometry.vertex_size = sizeof(vertex_3d);
+    geometry.vertex_count = vertex_count;
+    geometry.vertices = vertices;
+    geometry.index_size = sizeof(u32);
+    geometry.index_count = index_count;
+    geometry.indices = indices;
+    string_ncopy(geometry.name, "grid", GEOMETRY_NAME_MAX_LENGTH - 1);
+
+    u64 raw_size = 0;
+    void* raw = ksm_file_build("grid", 1, &geometry, false, &raw_size);
+    u64 compressed_size = 0;
+    void* compressed = ksm_file_build("grid", 1, &geometry, true, &compressed_size);
+    expect_to_be_true((compressed_size < raw_size / 2));
+
+    asset_archive_source source = {"models/grid.ksm", compressed, compressed_size};
+    expect_to_be_true(asset_archive_write(MESH_TEST_ARCHIVE_PATH, 1, &source, false));
+
+    resource_system_config config = {};
+    config.asset_base_path = MESH_TEST_BASE_PATH;
+    config.max_loader_count = 32;
+    u64 memory_requirement = 0;
+    expect_to_be_true(resource_system_initialize(&memory_requirement, 0, config));
+    void* state = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    expect_to_be_true(resource_system_initialize(&memory_requirement, state, config));
+    expect_to_be_true(resource_system_mount_archive(MESH_TEST_ARCHIVE_PATH));
+
+    // Decoded into copies, which match the uncompressed file exactly.
+    resource mesh;
+    expect_to_be_true(resource_system_load("grid", RESOURCE_TYPE_MESH, 0, &mesh));
+    expect_should_be(1, mesh.data_size);
+    expect_should_be(0, mesh.loader_data);
+    geometry_config* loaded = mesh.data;
+    expect_should_be(vertex_count, loaded->vertex_count);
+    expect_should_be(index_count, loaded->index_count);
+    expect_to_be_true(mesh_test_bytes_equal(loaded->indices, indices, sizeof(u32) * index_count));
+    vertex_3d_packed* packed = kallocate(sizeof(vertex_3d_packed) * vertex_count, MEMORY_TAG_ARRAY);
+    geometry_pack_vertices(vertex_count, vertices, packed);
+    expect_to_be_true(mesh_test_bytes_equal(loaded->vertices, packed, sizeof(vertex_3d_packed) * vertex_count));
+    resource_system_unload(&mesh);
+
+    resource_system_shutdown(state);
+    kfree(state, memory_requirement, MEMORY_TAG_APPLICATION);
+    kfree(packed, sizeof(vertex_3d_packed) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree_aligned(raw, raw_size, 16, MEMORY_TAG_ARRAY);
+    kfree_aligned(compressed, compressed_size, 16, MEMORY_TAG_ARRAY);
+    kfree(vertices, sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(indices, sizeof(u32) * index_count, MEMORY_TAG_ARRAY);
+    remove(MESH_TEST_ARCHIVE_PATH);
+    return true;
+}
+
+u8 mesh_loader_should_reject_corrupt_files() {
+    vertex_3d vertices[3];
+    u32 indices[3];
+    geometry_config geometry;
+    mesh_test_triangle_create(&geometry, vertices, indices, 0.0f);
+
+    u64 ksm_size = 0;
+    u8* ksm = ksm_file_build("triangle", 1, &geometry, false, &ksm_size);
+
+    // Cut off part way through the indices.
+    asset_archive_source source = {"models/cut.ksm", ksm, ksm_size - 4};
+    expect_to_be_true(asset_archive_write(MESH_TEST_ARCHIVE_PATH, 1, &source, false));
+
+    resource_system_config config = {};
+    config.asset_base_path = MESH_TEST_BASE_PATH;
+    config.max_loader_count = 32;
+    u64 memory_requirement = 0;
+    expect_to_be_true(resource_system_initialize(&memory_requirement, 0, config));
+    void* state = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    expect_to_be_true(resource_system_initialize(&memory_requirement, state, config));
+    expect_to_be_true(resource_system_mount_archive(MESH_TEST_ARCHIVE_PATH));
+
+    resource mesh;
+    expect_to_be_false(resource_system_load("cut", RESOURCE_TYPE_MESH, 0, &mesh));
+
+    resource_system_shutdown(state);
+    kfree(state, memory_requirement, MEMORY_TAG_APPLICATION);
+    kfree_aligned(ksm, ksm_size, 16, MEMORY_TAG_ARRAY);
+    remove(MESH_TEST_ARCHIVE_PATH);
+    return true;
+}
+
+void mesh_loader_register_tests() {
+    test_manager_register_test(mesh_loader_should_load_geometry_in_place, "Mesh loader should use geometry in place and read older versions");
+    test_manager_register_test(mesh_loader_should_load_compressed_streams, "Mesh loader should load compressed streams");
+    test_manager_register_test(mesh_loader_should_reject_corrupt_files, "Mesh loader should reject corrupt files");
+}
@@ -0,0 +1,99 @@
+#include "resource_cache_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <resources/resource_cache.h>
+
+static void* resource_cache_test_create(u32 capacity, u64 budget, resource_cache* out_cache, u64* out_memory_requirement) {
+    resource_cache_create(0, capacity, budget, out_memory_requirement, 0, 0);
+    void* memory = kallocate(*out_memory_requirement, MEMORY_TAG_APPLICATION);
+    resource_cache_create(0, capacity, budget, out_memory_requirement, memory, out_cache);
+    return memory;
+}
+
+u8 resource_cache_should_evict_least_recently_released_over_budget() {
+    resource_cache cache;
+    u64 memory_requirement = 0;
+    void* memory = resource_cache_test_create(8, 100, &cache, &memory_requirement);
+
+    expect_to_be_true(resource_cache_insert(&cache, 3, 40));
+    expect_to_be_true(resource_cache_insert(&cache, 5, 40));
+    expect_to_be_true(resource_cache_insert(&cache, 1, 20));
+    expect_should_be(100, cache.size);
+    expect_should_be(3, cache.count);
+
+    // Within budget, nothing goes.
+    u32 handle = INVALID_ID;
+    expect_to_be_false(resource_cache_evict(&cache, cache.budget, &handle));
+
+    // Over it, the one released longest ago goes first.
+    expect_to_be_true(resource_cache_insert(&cache, 7, 30));
+    expect_to_be_true(resource_cache_evict(&cache, cache.budget, &handle));
+    expect_should_be(3, handle);
+    expect_to_be_false(resource_cache_evict(&cache, cache.budget, &handle));
+    expect_should_be(90, cache.size);
+    expect_to_be_false(resource_cache_contains(&cache, 3));
+
+    // Acquired again, so no longer the next to go.
+    expect_to_be_true(resource_cache_acquire(&cache, 5));
+    expect_to_be_false(resource_cache_acquire(&cache, 5));
+    expect_to_be_true(resource_cache_insert(&cache, 5, 40));
+
+    // Emptied oldest first.
+    u32 expected[3] = {1, 7, 5};
+    for (u32 i = 0; i < 3; ++i) {
+        expect_to_be_true(resource_cache_evict(&cache, 0, &handle));
+        expect_should_be(expected[i], handle);
+    }
+    expect_to_be_false(resource_cache_evict(&cache, 0, &handle));
+    expect_should_be(0, cache.size);
+    expect_should_be(0, cache.count);
+
+    resource_cache_destroy(&cache);
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+u8 resource_cache_should_refuse_what_cannot_be_held() {
+    resource_cache cache;
+    u64 memory_requirement = 0;
+    void* memory = resource_cache_test_create(4, 100, &cache, &memory_requirement);
+
+    // Larger than the whole budget, or outside the handles the cache holds.
+    expect_to_be_false(resource_cache_insert(&cache, 0, 101));
+    expect_to_be_false(resource_cache_insert(&cache, 4, 10));
+    expect_to_be_false(resource_cache_remove(&cache, 2));
+    expect_to_be_false(resource_cache_contains(&cache, 4));
+
+    // Released twice, it is counted once, at its newest size and place.
+    expect_to_be_true(resource_cache_insert(&cache, 2, 10));
+    expect_to_be_true(resource_cache_insert(&cache, 0, 10));
+    expect_to_be_true(resource_cache_insert(&cache, 2, 30));
+    expect_should_be(40, cache.size);
+    expect_should_be(2, cache.count);
+    u32 handle = INVALID_ID;
+    expect_to_be_true(resource_cache_evict(&cache, 30, &handle));
+    expect_should_be(0, handle);
+
+    // Removed when destroyed some other way.
+    expect_to_be_true(resource_cache_remove(&cache, 2));
+    expect_should_be(INVALID_ID, cache.newest);
+    expect_should_be(INVALID_ID, cache.oldest);
+    resource_cache_destroy(&cache);
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+
+    // With no budget, nothing is held.
+    memory = resource_cache_test_create(4, 0, &cache, &memory_requirement);
+    expect_to_be_false(resource_cache_insert(&cache, 1, 1));
+    resource_cache_destroy(&cache);
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+void resource_cache_register_tests() {
+    test_manager_register_test(resource_cache_should_evict_least_recently_released_over_budget, "Resource cache should evict least recently released over budget");
+    test_manager_register_test(resource_cache_should_refuse_what_cannot_be_held, "Resource cache should refuse what cannot be held");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void resource_cache_register_tests();
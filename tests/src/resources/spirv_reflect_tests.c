@@ -0,0 +1,221 @@
+#include "spirv_reflect_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <resources/spirv_reflect.h>
+
+#define TEST_MAX_WORDS 256
+
+// A module assembled by hand, one instruction at a time.
+typedef struct test_module {
+    u32 words[TEST_MAX_WORDS];
+    u32 count;
+} test_module;
+
+static void emit(test_module* m, u32 opcode, u32 operand_count, const u32* operands) {
+    m->words[m->count++] = ((operand_count + 1) << 16) | opcode;
+    for (u32 i = 0; i < operand_count; ++i) {
+        m->words[m->count++] = operands[i];
+    }
+}
+
+// Emits OpMemberName, whose name is packed into words after the struct and member.
+static void emit_member_name(test_module* m, u32 struct_id, u32 member, const char* name) {
+    u32 operands[16] = {struct_id, member};
+    u32 length = string_length(name);
+    kcopy_memory(&operands[2], name, length);
+    emit(m, 6, 2 + (length / 4) + 1, operands);
+}
+
+// A vertex stage with a set 0 block of { mat4 projection; vec4 tint; } at binding 0 and an
+// array of two sampled images at set 1, binding 1.
+static u32 module_create(test_module* m) {
+    kzero_memory(m, sizeof(test_module));
+    u32 header[5] = {0x07230203, 0x00010000, 0, 16, 0};
+    kcopy_memory(m->words, header, sizeof(header));
+    m->count = 5;
+    emit_member_name(m, 5, 0, "projection");
+    emit_member_name(m, 5, 1, "tint");
+    emit(m, 71, 2, (u32[]){5, 2});
+    emit(m, 72, 4, (u32[]){5, 0, 35, 0});
+    emit(m, 72, 4, (u32[]){5, 1, 35, 64});
+    emit(m, 71, 3, (u32[]){7, 34, 0});
+    emit(m, 71, 3, (u32[]){7, 33, 0});
+    emit(m, 71, 3, (u32[]){14, 34, 1});
+    emit(m, 71, 3, (u32[]){14, 33, 1});
+    emit(m, 22, 2, (u32[]){2, 32});
+    emit(m, 23, 3, (u32[]){3, 2, 4});
+    emit(m, 24, 3, (u32[]){4, 3, 4});
+    emit(m, 30, 3, (u32[]){5, 4, 3});
+    emit(m, 32, 3, (u32[]){6, 2, 5});
+    emit(m, 59, 3, (u32[]){6, 7, 2});
+    emit(m, 25, 8, (u32[]){8, 2, 1, 0, 0, 0, 1, 0});
+    emit(m, 27, 2, (u32[]){9, 8});
+    emit(m, 21, 3, (u32[]){10, 32, 0});
+    emit(m, 43, 3, (u32[]){10, 11, 2});
+    emit(m, 28, 3, (u32[]){12, 9, 11});
+    emit(m, 32, 3, (u32[]){13, 0, 12});
+    emit(m, 59, 3, (u32[]){13, 14, 0});
+    return m->count * sizeof(u32);
+}
+
+static shader_uniform_config uniform_create(const char* name, shader_uniform_type type, u8 size, shader_scope scope) {
+    shader_uniform_config uniform = {};
+    uniform.name = (char*)name;
+    uniform.name_length = string_length(name);
+    uniform.type = type;
+    uniform.size = size;
+    uniform.scope = scope;
+    return uniform;
+}
+
+u8 spirv_reflect_should_find_blocks_and_samplers() {
+    test_module m;
+    u32 size = module_create(&m);
+    spirv_reflection reflection;
+    expect_to_be_true(spirv_reflect(m.words, size, &reflection));
+
+    expect_should_be(1, reflection.block_count);
+    const spirv_block* block = &reflection.blocks[0];
+    expect_to_be_false(block->is_push_constant);
+    expect_should_be(0, block->set);
+    expect_should_be(0, block->binding);
+    expect_should_be(2, block->member_count);
+    expect_to_be_true(strings_equal("projection", block->members[0].name));
+    expect_should_be(0, block->members[0].offset);
+    expect_should_be(64, block->members[0].size);
+    expect_to_be_true(strings_equal("tint", block->members[1].name));
+    expect_should_be(64, block->members[1].offset);
+    expect_should_be(16, block->members[1].size);
+
+    expect_should_be(1, reflection.sampler_count);
+    expect_should_be(1, reflection.samplers[0].set);
+    expect_should_be(1, reflection.samplers[0].binding);
+    expect_should_be(2, reflection.samplers[0].count);
+    return true;
+}
+
+u8 spirv_reflect_should_reject_invalid_code() {
+    test_module m;
+    u32 size = module_create(&m);
+    spirv_reflection reflection;
+
+    // Not a multiple of a word, or too short to hold a header.
+    expect_to_be_false(spirv_reflect(m.words, size - 1, &reflection));
+    expect_to_be_false(spirv_reflect(m.words, 8, &reflection));
+
+    // An instruction running past the end.
+    expect_to_be_false(spirv_reflect(m.words, size - 4, &reflection));
+
+    m.words[0] = 0;
+    expect_to_be_false(spirv_reflect(m.words, size, &reflection));
+    return true;
+}
+
+u8 spirv_reflection_should_check_uniforms() {
+    test_module m;
+    u32 size = module_create(&m);
+    spirv_reflection reflection;
+    expect_to_be_true(spirv_reflect(m.words, size, &reflection));
+
+    shader_uniform_config uniforms[4];
+    uniforms[0] = uniform_create("projection", SHADER_UNIFORM_TYPE_MATRIX_4, 64, SHADER_SCOPE_GLOBAL);
+    uniforms[1] = uniform_create("tint", SHADER_UNIFORM_TYPE_FLOAT32_4, 16, SHADER_SCOPE_GLOBAL);
+    uniforms[2] = uniform_create("diffuse_texture", SHADER_UNIFORM_TYPE_SAMPLER, 0, SHADER_SCOPE_INSTANCE);
+    uniforms[3] = uniform_create("specular_texture", SHADER_UNIFORM_TYPE_SAMPLER, 0, SHADER_SCOPE_INSTANCE);
+    shader_config config = {};
+    config.name = "test";
+    config.uniforms = uniforms;
+    config.uniform_count = 4;
+    expect_to_be_true(spirv_reflection_check_uniforms(&config, 1, &reflection));
+
+    // A size which does not match.
+    uniforms[1] = uniform_create("tint", SHADER_UNIFORM_TYPE_FLOAT32_3, 12, SHADER_SCOPE_GLOBAL);
+    expect_to_be_false(spirv_reflection_check_uniforms(&config, 1, &reflection));
+
+    // A name not in the block.
+    uniforms[1] = uniform_create("colour", SHADER_UNIFORM_TYPE_FLOAT32_4, 16, SHADER_SCOPE_GLOBAL);
+    expect_to_be_false(spirv_reflection_check_uniforms(&config, 1, &reflection));
+
+    // A scope with no block.
+    uniforms[1] = uniform_create("tint", SHADER_UNIFORM_TYPE_FLOAT32_4, 16, SHADER_SCOPE_LOCAL);
+    expect_to_be_false(spirv_reflection_check_uniforms(&config, 1, &reflection));
+
+    // Fewer samplers than are bound.
+    uniforms[1] = uniform_create("tint", SHADER_UNIFORM_TYPE_FLOAT32_4, 16, SHADER_SCOPE_GLOBAL);
+    config.uniform_count = 3;
+    expect_to_be_false(spirv_reflection_check_uniforms(&config, 1, &reflection));
+
+    // The same binding declared by two stages is counted once.
+    config.uniform_count = 4;
+    spirv_reflection stages[2] = {reflection, reflection};
+    expect_to_be_true(spirv_reflection_check_uniforms(&config, 2, stages));
+    return true;
+}
+
+u8 spirv_reflection_should_find_locals_in_a_local_uniform_block() {
+    test_module m;
+    u32 size = module_create(&m);
+    spirv_reflection reflection;
+    expect_to_be_true(spirv_reflect(m.words, size, &reflection));
+    // The block as if it followed the global and instance sets.
+    reflection.blocks[0].set = 2;
+
+    shader_uniform_config uniforms[4];
+    uniforms[0] = uniform_create("projection", SHADER_UNIFORM_TYPE_MATRIX_4, 64, SHADER_SCOPE_LOCAL);
+    uniforms[1] = uniform_create("tint", SHADER_UNIFORM_TYPE_FLOAT32_4, 16, SHADER_SCOPE_LOCAL);
+    uniforms[2] = uniform_create("diffuse_texture", SHADER_UNIFORM_TYPE_SAMPLER, 0, SHADER_SCOPE_INSTANCE);
+    uniforms[3] = uniform_create("specular_texture", SHADER_UNIFORM_TYPE_SAMPLER, 0, SHADER_SCOPE_INSTANCE);
+    shader_config config = {};
+    config.name = "test";
+    config.uniforms = uniforms;
+    config.uniform_count = 4;
+    config.local_ubo = true;
+    expect_to_be_true(spirv_reflection_check_uniforms(&config, 1, &reflection));
+
+    // Without a local uniform block, locals must be push constants.
+    config.local_ubo = false;
+    expect_to_be_false(spirv_reflection_check_uniforms(&config, 1, &reflection));
+    return true;
+}
+
+u8 spirv_reflect_should_not_count_storage_images_as_samplers() {
+    // A compute stage with a storage image at set 1, binding 0, as in 'image2D' declared rgba8.
+    test_module m;
+    kzero_memory(&m, sizeof(test_module));
+    u32 header[5] = {0x07230203, 0x00010000, 0, 6, 0};
+    kcopy_memory(m.words, header, sizeof(header));
+    m.count = 5;
+    emit(&m, 71, 3, (u32[]){3, 34, 1});
+    emit(&m, 71, 3, (u32[]){3, 33, 0});
+    emit(&m, 22, 2, (u32[]){1, 32});
+    emit(&m, 25, 8, (u32[]){2, 1, 1, 0, 0, 0, 2, 4});
+    emit(&m, 32, 3, (u32[]){4, 0, 2});
+    emit(&m, 59, 3, (u32[]){4, 3, 0});
+    spirv_reflection reflection;
+    expect_to_be_true(spirv_reflect(m.words, m.count * sizeof(u32), &reflection));
+    expect_should_be(0, reflection.sampler_count);
+
+    // Storage uniforms are not matched against blocks or samplers.
+    shader_uniform_config uniforms[2];
+    uniforms[0] = uniform_create("output_image", SHADER_UNIFORM_TYPE_STORAGE_IMAGE, 0, SHADER_SCOPE_GLOBAL);
+    uniforms[1] = uniform_create("particles", SHADER_UNIFORM_TYPE_STORAGE_BUFFER, 0, SHADER_SCOPE_GLOBAL);
+    shader_config config = {};
+    config.name = "test";
+    config.uniforms = uniforms;
+    config.uniform_count = 2;
+    expect_to_be_true(spirv_reflection_check_uniforms(&config, 1, &reflection));
+    return true;
+}
+
+void spirv_reflect_register_tests() {
+    test_manager_register_test(spirv_reflect_should_find_blocks_and_samplers, "SPIR-V reflection should find blocks and samplers");
+    test_manager_register_test(spirv_reflect_should_reject_invalid_code, "SPIR-V reflection should reject invalid code");
+    test_manager_register_test(spirv_reflection_should_check_uniforms, "SPIR-V reflection should check shader uniforms");
+    test_manager_register_test(spirv_reflection_should_find_locals_in_a_local_uniform_block, "SPIR-V reflection should find locals in a local uniform block");
+    test_manager_register_test(spirv_reflect_should_not_count_storage_images_as_samplers, "SPIR-V reflection should not count storage images as samplers");
+}
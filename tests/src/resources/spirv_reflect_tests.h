@@ -0,0 +1,3 @@
+#pragma once
+
+void spirv_reflect_register_tests();
@@ -0,0 +1,101 @@
+#include "text_layout_cache_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <resources/text_layout_cache.h>
+
+static void* cache_create(u32 capacity, text_layout_cache* out_cache) {
+    u64 size = 0;
+    text_layout_cache_create(capacity, &size, 0, 0);
+    void* memory = kallocate(size, MEMORY_TAG_ARRAY);
+    text_layout_cache_create(capacity, &size, memory, out_cache);
+    return memory;
+}
+
+static void cache_free(text_layout_cache* cache, void* memory) {
+    u32 capacity = cache->capacity;
+    text_layout_cache_destroy(cache);
+    kfree(memory, sizeof(text_layout_run) * capacity, MEMORY_TAG_ARRAY);
+}
+
+static font_data font_create(const char* face, u32 size) {
+    font_data font = {0};
+    font.type = FONT_TYPE_SYSTEM;
+    font.size = size;
+    string_ncopy(font.face, face, 255);
+    return font;
+}
+
+// Puts a string of a single quad, placed at x.
+static b8 put_quad(text_layout_cache* cache, const font_data* font, f32 scale, const char* text, f32 x) {
+    vertex_2d vertices[4] = {0};
+    vertices[0].position.x = x;
+    u32 indices[6] = {2, 1, 0, 3, 0, 1};
+    return text_layout_cache_put(cache, font, scale, text, 1, vertices, indices);
+}
+
+u8 text_layout_cache_should_find_runs_by_font_scale_and_string() {
+    text_layout_cache cache;
+    void* memory = cache_create(4, &cache);
+    font_data font = font_create("Noto Sans", 20);
+    font_data other_face = font_create("Noto Serif", 20);
+    font_data other_size = font_create("Noto Sans", 32);
+
+    expect_to_be_true(put_quad(&cache, &font, 1.0f, "Play", 1.0f));
+    const text_layout_run* run = text_layout_cache_get(&cache, &font, 1.0f, "Play");
+    expect_to_be_true(run != 0);
+    expect_should_be(1, run->quad_count);
+    expect_float_to_be(1.0f, run->vertices[0].position.x);
+    expect_should_be(2, run->indices[0]);
+
+    expect_to_be_true(text_layout_cache_get(&cache, &font, 1.0f, "Pause") == 0);
+    expect_to_be_true(text_layout_cache_get(&cache, &font, 2.0f, "Play") == 0);
+    expect_to_be_true(text_layout_cache_get(&cache, &other_face, 1.0f, "Play") == 0);
+    expect_to_be_true(text_layout_cache_get(&cache, &other_size, 1.0f, "Play") == 0);
+    expect_should_be(1, cache.hit_count);
+    expect_should_be(4, cache.miss_count);
+
+    // Glyphs changing make runs laid out with the old ones stale.
+    font.generation++;
+    expect_to_be_true(text_layout_cache_get(&cache, &font, 1.0f, "Play") == 0);
+
+    // Putting the same key again replaces its run.
+    expect_to_be_true(put_quad(&cache, &font, 1.0f, "Play", 5.0f));
+    expect_to_be_true(put_quad(&cache, &font, 1.0f, "Play", 6.0f));
+    run = text_layout_cache_get(&cache, &font, 1.0f, "Play");
+    expect_to_be_true(run != 0);
+    expect_float_to_be(6.0f, run->vertices[0].position.x);
+
+    cache_free(&cache, memory);
+    return true;
+}
+
+u8 text_layout_cache_should_evict_the_least_recently_used() {
+    text_layout_cache cache;
+    void* memory = cache_create(2, &cache);
+    font_data font = font_create("Noto Sans", 20);
+
+    expect_to_be_true(put_quad(&cache, &font, 1.0f, "a", 0.0f));
+    expect_to_be_true(put_quad(&cache, &font, 1.0f, "b", 0.0f));
+    // Using "a" leaves "b" the least recently used.
+    expect_to_be_true(text_layout_cache_get(&cache, &font, 1.0f, "a") != 0);
+    expect_to_be_true(put_quad(&cache, &font, 1.0f, "c", 0.0f));
+    expect_to_be_true(text_layout_cache_get(&cache, &font, 1.0f, "a") != 0);
+    expect_to_be_true(text_layout_cache_get(&cache, &font, 1.0f, "b") == 0);
+    expect_to_be_true(text_layout_cache_get(&cache, &font, 1.0f, "c") != 0);
+
+    text_layout_cache_clear(&cache);
+    expect_to_be_true(text_layout_cache_get(&cache, &font, 1.0f, "a") == 0);
+
+    cache_free(&cache, memory);
+    return true;
+}
+
+void text_layout_cache_register_tests() {
+    test_manager_register_test(text_layout_cache_should_find_runs_by_font_scale_and_string, "Text layout caches should find runs by font, scale and string");
+    test_manager_register_test(text_layout_cache_should_evict_the_least_recently_used, "Text layout caches should evict the least recently used run");
+}
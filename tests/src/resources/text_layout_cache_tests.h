@@ -0,0 +1,3 @@
+#pragma once
+
+void text_layout_cache_register_tests();
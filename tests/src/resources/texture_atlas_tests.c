@@ -0,0 +1,176 @@
+#include "texture_atlas_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <resources/texture_atlas.h>
+
+static void* atlas_create(u32 width, u32 height, u32 padding, texture_atlas* out_atlas) {
+    u64 size = 0;
+    texture_atlas_create(width, height, 4, padding, &size, 0, 0);
+    void* memory = kallocate(size, MEMORY_TAG_ARRAY);
+    texture_atlas_create(width, height, 4, padding, &size, memory, out_atlas);
+    return memory;
+}
+
+static void atlas_free(texture_atlas* atlas, void* memory) {
+    u64 size = 0;
+    texture_atlas_create(atlas->width, atlas->height, atlas->channel_count, atlas->padding, &size, 0, 0);
+    texture_atlas_destroy(atlas);
+    kfree(memory, size, MEMORY_TAG_ARRAY);
+}
+
+static b8 regions_overlap(const texture_atlas_region* a, const texture_atlas_region* b, u32 padding) {
+    return a->x - padding < b->x + b->width + padding && b->x - padding < a->x + a->width + padding &&
+           a->y - padding < b->y + b->height + padding && b->y - padding < a->y + a->height + padding;
+}
+
+u8 texture_atlas_should_pack_without_overlap() {
+    texture_atlas atlas;
+    void* memory = atlas_create(256, 256, 1, &atlas);
+    u8 pixels[32 * 32 * 4] = {0};
+
+    // Images of a few sizes, until the atlas is full.
+    texture_atlas_region regions[256];
+    u32 count = 0;
+    while (count < 256) {
+        u32 size = 8 + (count % 3) * 12;
+        if (!texture_atlas_add(&atlas, size, size, pixels, &regions[count])) {
+            break;
+        }
+        count++;
+    }
+    expect_should_be(count, atlas.region_count);
+    expect_to_be_true(count > 40);
+
+    for (u32 i = 0; i < count; ++i) {
+        expect_to_be_true(regions[i].x >= 1 && regions[i].x + regions[i].width + 1 <= 256);
+        expect_to_be_true(regions[i].y >= 1 && regions[i].y + regions[i].height + 1 <= 256);
+        for (u32 j = i + 1; j < count; ++j) {
+            expect_to_be_false(regions_overlap(&regions[i], &regions[j], 1));
+        }
+    }
+
+    // Too big for what is left.
+    texture_atlas_region region;
+    expect_to_be_false(texture_atlas_add(&atlas, 300, 4, pixels, &region));
+
+    atlas_free(&atlas, memory);
+    return true;
+}
+
+u8 texture_atlas_should_map_uvs() {
+    texture_atlas atlas;
+    void* memory = atlas_create(128, 64, 0, &atlas);
+    u8 pixels[16 * 16 * 4] = {0};
+
+    texture_atlas_region first;
+    texture_atlas_region second;
+    expect_to_be_true(texture_atlas_add(&atlas, 32, 16, pixels, &first));
+    expect_to_be_true(texture_atlas_add(&atlas, 16, 16, pixels, &second));
+    expect_should_be(0, first.x);
+    expect_should_be(32, second.x);
+    expect_float_to_be(0.25f, first.uv_rect.z);
+    expect_float_to_be(0.25f, first.uv_rect.w);
+
+    vec2 mapped = texture_atlas_uv_map(second.uv_rect, (vec2){1.0f, 1.0f});
+    expect_float_to_be(48.0f / 128.0f, mapped.x);
+    expect_float_to_be(16.0f / 64.0f, mapped.y);
+    mapped = texture_atlas_uv_map(second.uv_rect, (vec2){0.0f, 0.0f});
+    expect_float_to_be(0.25f, mapped.x);
+    expect_float_to_be(0.0f, mapped.y);
+
+    atlas_free(&atlas, memory);
+    return true;
+}
+
+u8 texture_atlas_should_copy_pixels_and_borders() {
+    texture_atlas atlas;
+    void* memory = atlas_create(32, 32, 2, &atlas);
+
+    // A 2x2 image of four distinct pixels.
+    u8 pixels[2 * 2 * 4];
+    for (u32 i = 0; i < 4; ++i) {
+        kset_memory(&pixels[i * 4], (u8)(10 + i), 4);
+    }
+    texture_atlas_region region;
+    atlas.dirty = false;
+    expect_to_be_true(texture_atlas_add(&atlas, 2, 2, pixels, &region));
+    expect_to_be_true(atlas.dirty);
+    expect_should_be(2, region.x);
+    expect_should_be(2, region.y);
+
+#define ATLAS_PIXEL(px, py) atlas.pixels[((py) * 32 + (px)) * 4]
+    // The image itself.
+    expect_should_be(10, ATLAS_PIXEL(2, 2));
+    expect_should_be(11, ATLAS_PIXEL(3, 2));
+    expect_should_be(12, ATLAS_PIXEL(2, 3));
+    expect_should_be(13, ATLAS_PIXEL(3, 3));
+    // Its border repeats its edges, corners included.
+    expect_should_be(10, ATLAS_PIXEL(0, 0));
+    expect_should_be(11, ATLAS_PIXEL(5, 1));
+    expect_should_be(12, ATLAS_PIXEL(1, 4));
+    expect_should_be(13, ATLAS_PIXEL(5, 5));
+    // Nothing past the border.
+    expect_should_be(0, ATLAS_PIXEL(6, 0));
+#undef ATLAS_PIXEL
+
+    texture_atlas_clear(&atlas);
+    expect_should_be(0, atlas.region_count);
+    expect_should_be(0, atlas.pixels[(2 * 32 + 2) * 4]);
+    expect_to_be_true(texture_atlas_add(&atlas, 2, 2, pixels, &region));
+    expect_should_be(2, region.x);
+
+    atlas_free(&atlas, memory);
+    return true;
+}
+
+u8 texture_atlas_should_copy_into_larger_atlas() {
+    texture_atlas small;
+    void* small_memory = atlas_create(16, 16, 1, &small);
+    u8 pixels[6 * 6 * 4];
+    kset_memory(pixels, 7, sizeof(pixels));
+
+    // Fill the small atlas.
+    texture_atlas_region regions[8];
+    u32 count = 0;
+    while (count < 8 && texture_atlas_add(&small, 6, 6, pixels, &regions[count])) {
+        count++;
+    }
+    expect_should_be(4, count);
+
+    texture_atlas large;
+    void* large_memory = atlas_create(32, 32, 1, &large);
+    expect_to_be_true(texture_atlas_copy(&small, &large));
+    expect_should_be(count, large.region_count);
+    expect_to_be_true(large.dirty);
+
+    // What was placed is where it was.
+    for (u32 i = 0; i < count; ++i) {
+        expect_should_be(7, large.pixels[(regions[i].y * 32 + regions[i].x) * 4]);
+    }
+    expect_should_be(0, large.pixels[(20 * 32 + 20) * 4]);
+
+    // And there is room for more, not overlapping it.
+    texture_atlas_region region;
+    expect_to_be_true(texture_atlas_add(&large, 6, 6, pixels, &region));
+    for (u32 i = 0; i < count; ++i) {
+        expect_to_be_false(regions_overlap(&regions[i], &region, 1));
+    }
+
+    // Not into a smaller one.
+    expect_to_be_false(texture_atlas_copy(&large, &small));
+
+    atlas_free(&large, large_memory);
+    atlas_free(&small, small_memory);
+    return true;
+}
+
+void texture_atlas_register_tests() {
+    test_manager_register_test(texture_atlas_should_pack_without_overlap, "Texture atlases should pack images without overlap");
+    test_manager_register_test(texture_atlas_should_map_uvs, "Texture atlases should map uvs into regions");
+    test_manager_register_test(texture_atlas_should_copy_pixels_and_borders, "Texture atlases should copy pixels and borders");
+    test_manager_register_test(texture_atlas_should_copy_into_larger_atlas, "Texture atlases should copy into larger atlases");
+}
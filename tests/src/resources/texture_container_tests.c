@@ -0,0 +1,210 @@
+#include "texture_container_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <resources/texture_container.h>
+
+#define TEST_CONTAINER_SIZE 512
+
+static const u8 ktx2_identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+static void write_u32(u8* data, u64 offset, u32 value) {
+    kcopy_memory(data + offset, &value, sizeof(u32));
+}
+
+static void write_u64(u8* data, u64 offset, u64 value) {
+    kcopy_memory(data + offset, &value, sizeof(u64));
+}
+
+// Writes a KTX2 header for a width x height image with level_count levels, stored one after
+// another after the level index. Returns the size of the file.
+static u64 ktx2_create(u8* data, u32 vk_format, u32 width, u32 height, u32 level_count, texture_format format) {
+    kzero_memory(data, TEST_CONTAINER_SIZE);
+    kcopy_memory(data, ktx2_identifier, sizeof(ktx2_identifier));
+    write_u32(data, 12, vk_format);
+    write_u32(data, 16, 1);
+    write_u32(data, 20, width);
+    write_u32(data, 24, height);
+    write_u32(data, 36, 1);
+    write_u32(data, 40, level_count);
+    u64 offset = 80 + level_count * 24;
+    for (u32 i = 0; i < level_count; ++i) {
+        u64 size = texture_format_size(format, KMAX(width >> i, 1), KMAX(height >> i, 1), 0);
+        write_u64(data, 80 + i * 24, offset);
+        write_u64(data, 80 + i * 24 + 8, size);
+        write_u64(data, 80 + i * 24 + 16, size);
+        offset += size;
+    }
+    return offset;
+}
+
+// Writes a DDS header with the given FourCC for a width x height image with level_count levels.
+static u64 dds_create(u8* data, u32 fourcc, u32 width, u32 height, u32 level_count) {
+    kzero_memory(data, TEST_CONTAINER_SIZE);
+    write_u32(data, 0, 0x20534444);
+    write_u32(data, 4, 124);
+    write_u32(data, 8, 0x1007 | 0x20000);
+    write_u32(data, 12, height);
+    write_u32(data, 16, width);
+    write_u32(data, 28, level_count);
+    write_u32(data, 76, 32);
+    write_u32(data, 80, 0x4);
+    write_u32(data, 84, fourcc);
+    return 128;
+}
+
+u8 texture_format_should_size_blocks() {
+    expect_should_be(8 * 8 * 4, texture_format_size(TEXTURE_FORMAT_UNCOMPRESSED, 8, 8, 4));
+    expect_should_be(4 * 8, texture_format_size(TEXTURE_FORMAT_BC1, 8, 8, 0));
+    expect_should_be(4 * 16, texture_format_size(TEXTURE_FORMAT_BC7, 8, 8, 0));
+    // Partial blocks at the edges take whole blocks, as do levels smaller than a block.
+    expect_should_be(2 * 16, texture_format_size(TEXTURE_FORMAT_BC3, 5, 3, 0));
+    expect_should_be(8, texture_format_size(TEXTURE_FORMAT_BC1, 1, 1, 0));
+    expect_to_be_true(texture_format_has_alpha(TEXTURE_FORMAT_BC3));
+    expect_to_be_false(texture_format_has_alpha(TEXTURE_FORMAT_BC5));
+    return true;
+}
+
+u8 texture_format_should_size_chains() {
+    // 4x2, 2x1 and 1x1.
+    expect_should_be((8 + 2 + 1) * 4, texture_format_chain_size(TEXTURE_FORMAT_UNCOMPRESSED, 4, 2, 4));
+    // 8x8, 4x4, 2x2 and 1x1, the last two taking a block each.
+    expect_should_be((4 + 1 + 1 + 1) * 8, texture_format_chain_size(TEXTURE_FORMAT_BC1, 8, 8, 0));
+    return true;
+}
+
+u8 texture_pixels_should_find_transparency() {
+    // Enough pixels for several blocks of sixteen, then a few more.
+    u8 pixels[4 * 53];
+    kset_memory(pixels, 255, sizeof(pixels));
+    expect_to_be_false(texture_pixels_have_transparency(pixels, sizeof(pixels), 4));
+
+    // Found within one of the blocks, and among the pixels after them.
+    pixels[4 * 20 + 3] = 254;
+    expect_to_be_true(texture_pixels_have_transparency(pixels, sizeof(pixels), 4));
+    pixels[4 * 20 + 3] = 255;
+    pixels[4 * 52 + 3] = 0;
+    expect_to_be_true(texture_pixels_have_transparency(pixels, sizeof(pixels), 4));
+
+    // Colour below 255 is not transparency, and data without an alpha channel has none.
+    kset_memory(pixels, 255, sizeof(pixels));
+    pixels[4 * 5] = 0;
+    expect_to_be_false(texture_pixels_have_transparency(pixels, sizeof(pixels), 4));
+    expect_to_be_false(texture_pixels_have_transparency(pixels, 3 * 53, 3));
+    expect_to_be_false(texture_pixels_have_transparency(pixels, 2 * 53, 2));
+    pixels[11] = 10;
+    expect_to_be_true(texture_pixels_have_transparency(pixels, 2 * 53, 2));
+    return true;
+}
+
+u8 texture_mip_level_should_follow_screen_size() {
+    // A 1024 texel image drawn at 1024 pixels or more needs its first level.
+    expect_should_be(0, texture_mip_level_for_screen_size(1024, 512, 11, 1024.0f));
+    expect_should_be(0, texture_mip_level_for_screen_size(1024, 512, 11, 4000.0f));
+    // At 200 pixels, 256 texels is the coarsest level that keeps up.
+    expect_should_be(2, texture_mip_level_for_screen_size(1024, 512, 11, 200.0f));
+    // Out of sight, or with only a few levels, it goes as coarse as it can.
+    expect_should_be(10, texture_mip_level_for_screen_size(1024, 512, 11, 0.0f));
+    expect_should_be(1, texture_mip_level_for_screen_size(1024, 512, 2, 10.0f));
+    return true;
+}
+
+u8 texture_container_should_read_ktx2_levels() {
+    u8 data[TEST_CONTAINER_SIZE];
+    // VK_FORMAT_BC7_SRGB_BLOCK, 8x8 with levels of 8x8, 4x4, 2x2 and 1x1.
+    u64 size = ktx2_create(data, 146, 8, 8, 4, TEXTURE_FORMAT_BC7);
+    texture_container_info info;
+    expect_to_be_true(texture_container_read(data, size, &info));
+    expect_should_be(TEXTURE_FORMAT_BC7, info.format);
+    expect_should_be(8, info.width);
+    expect_should_be(8, info.height);
+    expect_should_be(4, info.level_count);
+    expect_should_be(80 + 4 * 24, info.levels[0].offset);
+    expect_should_be(64, info.levels[0].size);
+    expect_should_be(16, info.levels[1].size);
+    expect_should_be(2, info.levels[2].width);
+    expect_should_be(1, info.levels[3].height);
+    expect_should_be(16, info.levels[3].size);
+
+    // VK_FORMAT_ASTC_4x4_UNORM_BLOCK, with a single level.
+    size = ktx2_create(data, 157, 16, 4, 1, TEXTURE_FORMAT_ASTC_4X4);
+    expect_to_be_true(texture_container_read(data, size, &info));
+    expect_should_be(TEXTURE_FORMAT_ASTC_4X4, info.format);
+    expect_should_be(64, info.levels[0].size);
+    return true;
+}
+
+u8 texture_container_should_reject_unsupported_ktx2() {
+    u8 data[TEST_CONTAINER_SIZE];
+    texture_container_info info;
+
+    // VK_FORMAT_R8G8B8A8_UNORM is not compressed.
+    u64 size = ktx2_create(data, 37, 8, 8, 1, TEXTURE_FORMAT_BC1);
+    expect_to_be_false(texture_container_read(data, size, &info));
+
+    // Supercompressed.
+    size = ktx2_create(data, 133, 8, 8, 1, TEXTURE_FORMAT_BC1);
+    write_u32(data, 44, 2);
+    expect_to_be_false(texture_container_read(data, size, &info));
+
+    // Cube maps are loaded a face at a time.
+    size = ktx2_create(data, 133, 8, 8, 1, TEXTURE_FORMAT_BC1);
+    write_u32(data, 36, 6);
+    expect_to_be_false(texture_container_read(data, size, &info));
+
+    // Levels which are the wrong size, or run past the end.
+    size = ktx2_create(data, 133, 8, 8, 1, TEXTURE_FORMAT_BC1);
+    write_u64(data, 88, 16);
+    expect_to_be_false(texture_container_read(data, size, &info));
+    size = ktx2_create(data, 133, 8, 8, 1, TEXTURE_FORMAT_BC1);
+    expect_to_be_false(texture_container_read(data, size - 1, &info));
+
+    // Neither format.
+    data[0] = 0;
+    expect_to_be_false(texture_container_read(data, size, &info));
+    return true;
+}
+
+u8 texture_container_should_read_dds() {
+    u8 data[TEST_CONTAINER_SIZE];
+    texture_container_info info;
+
+    // DXT5 8x8 with two levels, following the header.
+    u64 size = dds_create(data, 0x35545844, 8, 8, 2) + 64 + 16;
+    expect_to_be_true(texture_container_read(data, size, &info));
+    expect_should_be(TEXTURE_FORMAT_BC3, info.format);
+    expect_should_be(2, info.level_count);
+    expect_should_be(128, info.levels[0].offset);
+    expect_should_be(128 + 64, info.levels[1].offset);
+    expect_should_be(16, info.levels[1].size);
+    expect_to_be_false(texture_container_read(data, size - 1, &info));
+
+    // DX10 header holding BC5.
+    size = dds_create(data, 0x30315844, 4, 4, 1);
+    write_u32(data, 128, 83);
+    write_u32(data, 132, 3);
+    write_u32(data, 140, 1);
+    size += 20 + 16;
+    expect_to_be_true(texture_container_read(data, size, &info));
+    expect_should_be(TEXTURE_FORMAT_BC5, info.format);
+    expect_should_be(148, info.levels[0].offset);
+
+    // Uncompressed pixel formats are not read.
+    dds_create(data, 0, 4, 4, 1);
+    write_u32(data, 80, 0x41);
+    expect_to_be_false(texture_container_read(data, 128 + 64, &info));
+    return true;
+}
+
+void texture_container_register_tests() {
+    test_manager_register_test(texture_format_should_size_blocks, "Texture formats should be sized by block");
+    test_manager_register_test(texture_format_should_size_chains, "Texture formats should size mip chains");
+    test_manager_register_test(texture_pixels_should_find_transparency, "Texture pixels should be scanned for transparency");
+    test_manager_register_test(texture_mip_level_should_follow_screen_size, "Texture mip levels should follow screen size");
+    test_manager_register_test(texture_container_should_read_ktx2_levels, "Texture containers should read KTX2 levels");
+    test_manager_register_test(texture_container_should_reject_unsupported_ktx2, "Texture containers should reject unsupported KTX2 files");
+    test_manager_register_test(texture_container_should_read_dds, "Texture containers should read DDS files");
+}
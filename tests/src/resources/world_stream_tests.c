@@ -0,0 +1,140 @@
+#include "world_stream_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <platform/platform.h>
+#include <resources/world_stream.h>
+#include <systems/job_system.h>
+#include <systems/resource_system.h>
+
+#define WORLD_STREAM_TEST_CELL_SIZE 10.0f
+#define WORLD_STREAM_TEST_CELL_BYTES 100
+// How long a test waits on loads before giving up, in seconds.
+#define WORLD_STREAM_TEST_TIMEOUT 10.0
+
+typedef struct world_stream_test_systems {
+    void* job_state;
+    u64 job_memory_requirement;
+    void* resource_state;
+    u64 resource_memory_requirement;
+} world_stream_test_systems;
+
+// Starts the job and resource systems. No meshes exist, so every load fails, which finishes it with nothing to draw.
+static b8 world_stream_test_start(world_stream_test_systems* systems) {
+    u32 thread_types[1] = {JOB_TYPE_GENERAL | JOB_TYPE_RESOURCE_LOAD | JOB_TYPE_GPU_RESOURCE};
+    job_system_initialize(&systems->job_memory_requirement, 0, 0, 0, 0);
+    systems->job_state = kallocate(systems->job_memory_requirement, MEMORY_TAG_APPLICATION);
+    if (!job_system_initialize(&systems->job_memory_requirement, systems->job_state, 1, thread_types, 0)) {
+        return false;
+    }
+    resource_system_config config = {};
+    config.asset_base_path = "world_stream_test";
+    config.max_loader_count = 32;
+    resource_system_initialize(&systems->resource_memory_requirement, 0, config);
+    systems->resource_state = kallocate(systems->resource_memory_requirement, MEMORY_TAG_APPLICATION);
+    return resource_system_initialize(&systems->resource_memory_requirement, systems->resource_state, config);
+}
+
+static void world_stream_test_stop(world_stream_test_systems* systems) {
+    resource_system_shutdown(systems->resource_state);
+    kfree(systems->resource_state, systems->resource_memory_requirement, MEMORY_TAG_APPLICATION);
+    job_system_shutdown(systems->job_state);
+    kfree(systems->job_state, systems->job_memory_requirement, MEMORY_TAG_APPLICATION);
+}
+
+// Updates the stream until nothing is loading.
+static b8 world_stream_test_settle(world_stream* stream, f32 camera_x) {
+    vec3 camera = {camera_x, 1.0f, 5.0f};
+    f64 start = platform_get_absolute_time();
+    world_stream_update(stream, camera);
+    while (stream->loads_in_flight > 0) {
+        if (platform_get_absolute_time() - start > WORLD_STREAM_TEST_TIMEOUT) {
+            return false;
+        }
+        job_system_update();
+        world_stream_update(stream, camera);
+    }
+    return true;
+}
+
+static b8 world_stream_test_loaded(const world_stream* stream, u32 cell) {
+    return stream->cells[cell].state == WORLD_CELL_STATE_LOADED;
+}
+
+static void* world_stream_test_create(u64 budget, world_stream* out_stream, u64* out_memory_requirement) {
+    world_stream_config config = {15.0f, 25.0f, budget, 2};
+    world_stream_create(config, 8, out_memory_requirement, 0, 0);
+    void* memory = kallocate(*out_memory_requirement, MEMORY_TAG_APPLICATION);
+    world_stream_create(config, 8, out_memory_requirement, memory, out_stream);
+    // A row of cells along x.
+    world_stream_grid_add(out_stream, "cell", vec3_zero(), WORLD_STREAM_TEST_CELL_SIZE, 10.0f, 8, 1, WORLD_STREAM_TEST_CELL_BYTES);
+    return memory;
+}
+
+u8 world_stream_should_load_nearest_cells_within_budget() {
+    world_stream_test_systems systems = {};
+    expect_to_be_true(world_stream_test_start(&systems));
+    world_stream stream;
+    u64 memory_requirement = 0;
+    void* memory = world_stream_test_create(WORLD_STREAM_TEST_CELL_BYTES * 3, &stream, &memory_requirement);
+    expect_should_be(8, stream.cell_count);
+
+    // Only two load at once, nearest first.
+    world_stream_update(&stream, (vec3){5.0f, 1.0f, 5.0f});
+    expect_should_be(2, stream.loads_in_flight);
+    expect_should_be(WORLD_CELL_STATE_LOADING, stream.cells[0].state);
+    expect_should_be(WORLD_CELL_STATE_LOADING, stream.cells[1].state);
+    expect_should_be(WORLD_CELL_STATE_UNLOADED, stream.cells[2].state);
+    expect_to_be_true(world_stream_test_settle(&stream, 5.0f));
+    for (u32 i = 0; i < 8; ++i) {
+        expect_should_be(i < 3, world_stream_test_loaded(&stream, i));
+    }
+    expect_should_be(WORLD_STREAM_TEST_CELL_BYTES * 3, stream.resident_size);
+
+    // Moving on, the newly near cell takes the place of the furthest.
+    expect_to_be_true(world_stream_test_settle(&stream, 22.0f));
+    expect_to_be_false(world_stream_test_loaded(&stream, 0));
+    expect_to_be_true(world_stream_test_loaded(&stream, 3));
+    expect_should_be(WORLD_STREAM_TEST_CELL_BYTES * 3, stream.resident_size);
+
+    world_stream_destroy(&stream);
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+    world_stream_test_stop(&systems);
+    return true;
+}
+
+u8 world_stream_should_unload_cells_only_past_unload_distance() {
+    world_stream_test_systems systems = {};
+    expect_to_be_true(world_stream_test_start(&systems));
+    world_stream stream;
+    u64 memory_requirement = 0;
+    void* memory = world_stream_test_create(WORLD_STREAM_TEST_CELL_BYTES * 8, &stream, &memory_requirement);
+
+    expect_to_be_true(world_stream_test_settle(&stream, 5.0f));
+    expect_to_be_true(world_stream_test_loaded(&stream, 0));
+
+    // Past the load distance of the first cell, but not its unload distance, so it stays.
+    expect_to_be_true(world_stream_test_settle(&stream, 30.0f));
+    expect_to_be_true(world_stream_test_loaded(&stream, 0));
+    expect_to_be_true(world_stream_test_loaded(&stream, 4));
+    expect_to_be_false(world_stream_test_loaded(&stream, 5));
+
+    // Past its unload distance.
+    expect_to_be_true(world_stream_test_settle(&stream, 40.0f));
+    expect_to_be_false(world_stream_test_loaded(&stream, 0));
+    expect_to_be_true(world_stream_test_loaded(&stream, 1));
+    expect_should_be(WORLD_STREAM_TEST_CELL_BYTES * 5, stream.resident_size);
+
+    world_stream_destroy(&stream);
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+    world_stream_test_stop(&systems);
+    return true;
+}
+
+void world_stream_register_tests() {
+    test_manager_register_test(world_stream_should_load_nearest_cells_within_budget, "World stream should load the nearest cells within its budget");
+    test_manager_register_test(world_stream_should_unload_cells_only_past_unload_distance, "World stream should unload cells only past the unload distance");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void world_stream_register_tests();
@@ -0,0 +1,86 @@
+#include "job_system_benchmarks.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <systems/job_system.h>
+
+#define JOB_BENCH_THREAD_COUNT 4
+
+// The number of jobs submitted before waiting on them, well within what the job system holds at once.
+#define JOB_BENCH_BATCH_SIZE 256
+
+static void* job_state;
+static u64 job_memory_requirement;
+static job_handle handles[JOB_BENCH_BATCH_SIZE];
+
+// Does nothing, so only the job system's own cost is timed.
+static b8 empty_job(void* params, void* result_data) {
+    return true;
+}
+
+static u8 job_system_setup() {
+    u32 thread_types[JOB_BENCH_THREAD_COUNT];
+    for (u32 i = 0; i < JOB_BENCH_THREAD_COUNT; ++i) {
+        thread_types[i] = JOB_TYPE_GENERAL | JOB_TYPE_RESOURCE_LOAD | JOB_TYPE_GPU_RESOURCE;
+    }
+    job_system_initialize(&job_memory_requirement, 0, 0, 0, 0);
+    job_state = kallocate(job_memory_requirement, MEMORY_TAG_APPLICATION);
+    return job_system_initialize(&job_memory_requirement, job_state, JOB_BENCH_THREAD_COUNT, thread_types, 0);
+}
+
+static u8 job_system_teardown() {
+    job_system_shutdown(job_state);
+    kfree(job_state, job_memory_requirement, MEMORY_TAG_APPLICATION);
+    job_state = 0;
+    return true;
+}
+
+// Timed per job: submitted one at a time a batch at a time, then all waited on.
+static u8 submit_run(u32 op_count) {
+    for (u32 done = 0; done < op_count; done += JOB_BENCH_BATCH_SIZE) {
+        for (u32 i = 0; i < JOB_BENCH_BATCH_SIZE; ++i) {
+            handles[i] = job_system_submit(job_create(empty_job, 0, 0, 0, 0, 0));
+        }
+        for (u32 i = 0; i < JOB_BENCH_BATCH_SIZE; ++i) {
+            job_system_wait(handles[i]);
+        }
+        job_system_update();
+    }
+    return true;
+}
+
+// As above, submitting each batch in one call.
+static u8 submit_batch_run(u32 op_count) {
+    job_info infos[JOB_BENCH_BATCH_SIZE];
+    for (u32 done = 0; done < op_count; done += JOB_BENCH_BATCH_SIZE) {
+        for (u32 i = 0; i < JOB_BENCH_BATCH_SIZE; ++i) {
+            infos[i] = job_create(empty_job, 0, 0, 0, 0, 0);
+        }
+        job_system_submit_batch(infos, JOB_BENCH_BATCH_SIZE, handles);
+        for (u32 i = 0; i < JOB_BENCH_BATCH_SIZE; ++i) {
+            job_system_wait(handles[i]);
+        }
+        job_system_update();
+    }
+    return true;
+}
+
+// Timed per job: each submitted and waited on before the next, so the latency from submit to done.
+static u8 round_trip_run(u32 op_count) {
+    for (u32 i = 0; i < op_count; ++i) {
+        job_system_wait(job_system_submit(job_create(empty_job, 0, 0, 0, 0, 0)));
+        if (i % JOB_BENCH_BATCH_SIZE == JOB_BENCH_BATCH_SIZE - 1) {
+            job_system_update();
+        }
+    }
+    job_system_update();
+    return true;
+}
+
+void job_system_register_benchmarks() {
+    test_manager_register_benchmark(job_system_setup, submit_run, job_system_teardown, JOB_BENCH_BATCH_SIZE * 40, "job_system.submit");
+    test_manager_register_benchmark(job_system_setup, submit_batch_run, job_system_teardown, JOB_BENCH_BATCH_SIZE * 40, "job_system.submit_batch");
+    test_manager_register_benchmark(job_system_setup, round_trip_run, job_system_teardown, 2000, "job_system.round_trip");
+}
@@ -0,0 +1,628 @@
+#include "job_system_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/katomic.h>
+#include <core/kmemory.h>
+#include <core/logger.h>
+#include <platform/platform.h>
+#include <systems/job_system.h>
+
+#define JOB_TEST_THREAD_COUNT 4
+
+// The number of jobs submitted at each priority by the stress test.
+#define JOB_TEST_JOBS_PER_PRIORITY 2000
+
+#define JOB_TEST_OUTER_JOB_COUNT 64
+#define JOB_TEST_INNER_JOB_COUNT 16
+
+#define JOB_TEST_CALLBACK_JOB_COUNT 1000
+
+// More jobs than the job system has records, thread deque slots or result queue slots for.
+#define JOB_TEST_OVERFLOW_JOB_COUNT 24000
+
+// Overflow jobs are submitted this many at a time.
+#define JOB_TEST_OVERFLOW_BATCH_SIZE 1000
+
+#define JOB_TEST_LATENCY_JOB_COUNT 256
+
+// How long a test waits on callbacks before giving up, in seconds.
+#define JOB_TEST_TIMEOUT 10.0
+
+static void* job_state;
+static u64 job_memory_requirement;
+
+static b8 job_test_start(u8 thread_count, u32 type_mask) {
+    u32 thread_types[JOB_TEST_THREAD_COUNT];
+    for (u32 i = 0; i < thread_count; ++i) {
+        thread_types[i] = type_mask;
+    }
+    job_system_initialize(&job_memory_requirement, 0, 0, 0, 0);
+    job_state = kallocate(job_memory_requirement, MEMORY_TAG_APPLICATION);
+    return job_system_initialize(&job_memory_requirement, job_state, thread_count, thread_types, 0);
+}
+
+static void job_test_stop() {
+    job_system_shutdown(job_state);
+    kfree(job_state, job_memory_requirement, MEMORY_TAG_APPLICATION);
+    job_state = 0;
+}
+
+typedef struct counter_job_params {
+    u32* counter;
+} counter_job_params;
+
+static b8 counter_job(void* params, void* result_data) {
+    counter_job_params* p = params;
+    katomic_fetch_add(p->counter, 1);
+    return true;
+}
+
+u8 job_system_should_run_thousands_of_jobs_at_every_priority() {
+    if (!job_test_start(JOB_TEST_THREAD_COUNT, JOB_TYPE_GENERAL | JOB_TYPE_RESOURCE_LOAD | JOB_TYPE_GPU_RESOURCE)) {
+        return false;
+    }
+
+    static job_handle handles[JOB_PRIORITY_COUNT * JOB_TEST_JOBS_PER_PRIORITY];
+    u32 counters[JOB_PRIORITY_COUNT] = {0};
+    // Interleave the priorities, so every thread's queues hold some of each at once.
+    for (u32 i = 0; i < JOB_TEST_JOBS_PER_PRIORITY; ++i) {
+        for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+            counter_job_params params = {&counters[p]};
+            job_info info = job_create_priority(counter_job, 0, 0, &params, sizeof(counter_job_params), 0, JOB_TYPE_GENERAL, (job_priority)p);
+            handles[i * JOB_PRIORITY_COUNT + p] = job_system_submit(info);
+        }
+    }
+    for (u32 i = 0; i < JOB_PRIORITY_COUNT * JOB_TEST_JOBS_PER_PRIORITY; ++i) {
+        job_system_wait(handles[i]);
+    }
+    job_system_update();
+    job_system_stats stats;
+    job_system_stats_get(&stats);
+    job_test_stop();
+
+    for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+        expect_should_be(JOB_TEST_JOBS_PER_PRIORITY, counters[p]);
+        expect_should_be(0, stats.queue_depths[p]);
+    }
+    return true;
+}
+
+typedef struct outer_job_params {
+    u32* inner_counter;
+    u32* outer_counter;
+} outer_job_params;
+
+// Submits inner jobs from within a job, then waits on them before finishing.
+static b8 outer_job(void* params, void* result_data) {
+    outer_job_params* p = params;
+    job_handle handles[JOB_TEST_INNER_JOB_COUNT];
+    for (u32 i = 0; i < JOB_TEST_INNER_JOB_COUNT; ++i) {
+        counter_job_params inner = {p->inner_counter};
+        handles[i] = job_system_submit(job_create(counter_job, 0, 0, &inner, sizeof(counter_job_params), 0));
+    }
+    for (u32 i = 0; i < JOB_TEST_INNER_JOB_COUNT; ++i) {
+        job_system_wait(handles[i]);
+        if (!job_system_is_complete(handles[i])) {
+            return false;
+        }
+    }
+    katomic_fetch_add(p->outer_counter, 1);
+    return true;
+}
+
+u8 job_system_should_run_jobs_submitted_from_within_jobs() {
+    if (!job_test_start(JOB_TEST_THREAD_COUNT, JOB_TYPE_GENERAL | JOB_TYPE_RESOURCE_LOAD | JOB_TYPE_GPU_RESOURCE)) {
+        return false;
+    }
+
+    u32 inner_counter = 0;
+    u32 outer_counter = 0;
+    job_handle handles[JOB_TEST_OUTER_JOB_COUNT];
+    for (u32 i = 0; i < JOB_TEST_OUTER_JOB_COUNT; ++i) {
+        outer_job_params params = {&inner_counter, &outer_counter};
+        handles[i] = job_system_submit(job_create(outer_job, 0, 0, &params, sizeof(outer_job_params), 0));
+    }
+    for (u32 i = 0; i < JOB_TEST_OUTER_JOB_COUNT; ++i) {
+        job_system_wait(handles[i]);
+    }
+    job_system_update();
+    job_test_stop();
+
+    expect_should_be(JOB_TEST_OUTER_JOB_COUNT * JOB_TEST_INNER_JOB_COUNT, inner_counter);
+    expect_should_be(JOB_TEST_OUTER_JOB_COUNT, outer_counter);
+    return true;
+}
+
+// Shared with the callbacks, which only ever run on this thread.
+typedef struct callback_state {
+    // The order jobs ran in, taken by each job.
+    u32 next_run;
+    // The number of callbacks invoked so far.
+    u32 callback_count;
+    u32 success_count;
+    u32 fail_count;
+    // The number of callbacks invoked out of the order their jobs ran in.
+    u32 out_of_order_count;
+    // The number of callbacks invoked outside of job_system_update.
+    u32 outside_update_count;
+    b8 updating;
+} callback_state;
+
+static callback_state callbacks;
+
+typedef struct callback_job_result {
+    u32 run_order;
+} callback_job_result;
+
+typedef struct callback_job_params {
+    b8 succeed;
+} callback_job_params;
+
+static b8 callback_job(void* params, void* result_data) {
+    callback_job_params* p = params;
+    callback_job_result* result = result_data;
+    result->run_order = katomic_fetch_add(&callbacks.next_run, 1);
+    return p->succeed;
+}
+
+static void callback_check(callback_job_result* result) {
+    if (result->run_order != callbacks.callback_count) {
+        callbacks.out_of_order_count++;
+    }
+    if (!callbacks.updating) {
+        callbacks.outside_update_count++;
+    }
+    callbacks.callback_count++;
+}
+
+static void callback_job_success(void* params) {
+    callback_check(params);
+    callbacks.success_count++;
+}
+
+static void callback_job_fail(void* params) {
+    callback_check(params);
+    callbacks.fail_count++;
+}
+
+// Updates the job system until the given number of callbacks have been invoked, or it times out.
+static void callbacks_wait(u32 count) {
+    f64 deadline = platform_get_absolute_time() + JOB_TEST_TIMEOUT;
+    while (callbacks.callback_count < count && platform_get_absolute_time() < deadline) {
+        callbacks.updating = true;
+        job_system_update();
+        callbacks.updating = false;
+        platform_sleep(0);
+    }
+}
+
+u8 job_system_should_invoke_callbacks_once_in_the_order_jobs_finished() {
+    // A single thread taking only resource load jobs, which the main thread never helps with, so
+    // jobs finish one after another in the order they ran.
+    if (!job_test_start(1, JOB_TYPE_RESOURCE_LOAD)) {
+        return false;
+    }
+
+    kzero_memory(&callbacks, sizeof(callback_state));
+    for (u32 i = 0; i < JOB_TEST_CALLBACK_JOB_COUNT; ++i) {
+        // Every third job fails, so both callbacks are interleaved.
+        callback_job_params params = {i % 3 != 0};
+        job_system_submit(job_create_type(callback_job, callback_job_success, callback_job_fail, &params, sizeof(callback_job_params), sizeof(callback_job_result), JOB_TYPE_RESOURCE_LOAD));
+    }
+    callbacks_wait(JOB_TEST_CALLBACK_JOB_COUNT);
+    // Anything left over would be an extra callback.
+    platform_sleep(10);
+    callbacks.updating = true;
+    job_system_update();
+    callbacks.updating = false;
+    job_test_stop();
+
+    expect_should_be(JOB_TEST_CALLBACK_JOB_COUNT, callbacks.callback_count);
+    expect_should_be(JOB_TEST_CALLBACK_JOB_COUNT / 3 + 1, callbacks.fail_count);
+    expect_should_be(JOB_TEST_CALLBACK_JOB_COUNT - callbacks.fail_count, callbacks.success_count);
+    expect_should_be(0, callbacks.out_of_order_count);
+    expect_should_be(0, callbacks.outside_update_count);
+    return true;
+}
+
+u8 job_system_should_complete_jobs_beyond_its_queue_capacities() {
+    if (!job_test_start(1, JOB_TYPE_RESOURCE_LOAD)) {
+        return false;
+    }
+
+    kzero_memory(&callbacks, sizeof(callback_state));
+    // Submitted without updating, so the result queue fills and the job thread has to wait on it.
+    // Jobs past the number of records have no handle, but must still run.
+    static job_info infos[JOB_TEST_OVERFLOW_BATCH_SIZE];
+    job_handle handles[JOB_TEST_OVERFLOW_BATCH_SIZE];
+    u32 invalid_handle_count = 0;
+    for (u32 submitted = 0; submitted < JOB_TEST_OVERFLOW_JOB_COUNT; submitted += JOB_TEST_OVERFLOW_BATCH_SIZE) {
+        for (u32 i = 0; i < JOB_TEST_OVERFLOW_BATCH_SIZE; ++i) {
+            callback_job_params params = {true};
+            infos[i] = job_create_type(callback_job, callback_job_success, 0, &params, sizeof(callback_job_params), sizeof(callback_job_result), JOB_TYPE_RESOURCE_LOAD);
+        }
+        job_system_submit_batch(infos, JOB_TEST_OVERFLOW_BATCH_SIZE, handles);
+        for (u32 i = 0; i < JOB_TEST_OVERFLOW_BATCH_SIZE; ++i) {
+            if (handles[i] == INVALID_ID) {
+                invalid_handle_count++;
+            }
+        }
+    }
+    callbacks_wait(JOB_TEST_OVERFLOW_JOB_COUNT);
+    u32 high_water = job_system_result_queue_high_water();
+    job_system_stats stats;
+    job_system_stats_get(&stats);
+    job_test_stop();
+
+    expect_should_be(JOB_TEST_OVERFLOW_JOB_COUNT, callbacks.callback_count);
+    expect_should_be(JOB_TEST_OVERFLOW_JOB_COUNT, callbacks.success_count);
+    expect_should_be(0, callbacks.out_of_order_count);
+    expect_to_be_true(invalid_handle_count > 0);
+    expect_to_be_true(high_water > 0);
+    expect_should_be(0, stats.pending_result_count);
+    for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+        expect_should_be(0, stats.queue_depths[p]);
+    }
+    return true;
+}
+
+// True once every job submitted by the test has run.
+static b8 callback_jobs_run(void* user_data) {
+    return katomic_load(&callbacks.next_run) >= *(u32*)user_data;
+}
+
+u8 job_system_should_wait_on_the_main_thread_with_its_result_queue_full() {
+    // General jobs, which the main thread helps with while it waits. Their results fill the queue
+    // before the wait, so the jobs the main thread runs itself find no room for them either.
+    if (!job_test_start(1, JOB_TYPE_GENERAL)) {
+        return false;
+    }
+
+    kzero_memory(&callbacks, sizeof(callback_state));
+    static job_info infos[JOB_TEST_OVERFLOW_BATCH_SIZE];
+    job_handle handles[JOB_TEST_OVERFLOW_BATCH_SIZE];
+    for (u32 submitted = 0; submitted < JOB_TEST_OVERFLOW_JOB_COUNT; submitted += JOB_TEST_OVERFLOW_BATCH_SIZE) {
+        for (u32 i = 0; i < JOB_TEST_OVERFLOW_BATCH_SIZE; ++i) {
+            callback_job_params params = {true};
+            infos[i] = job_create(callback_job, callback_job_success, 0, &params, sizeof(callback_job_params), sizeof(callback_job_result));
+        }
+        job_system_submit_batch(infos, JOB_TEST_OVERFLOW_BATCH_SIZE, handles);
+    }
+    u32 job_count = JOB_TEST_OVERFLOW_JOB_COUNT;
+    job_system_wait_for(callback_jobs_run, &job_count);
+    callbacks_wait(JOB_TEST_OVERFLOW_JOB_COUNT);
+    u32 high_water = job_system_result_queue_high_water();
+    job_test_stop();
+
+    // Callbacks run during the wait as well, and results from both threads interleave, so only the counts are checked.
+    expect_should_be(JOB_TEST_OVERFLOW_JOB_COUNT, callbacks.callback_count);
+    expect_should_be(JOB_TEST_OVERFLOW_JOB_COUNT, callbacks.success_count);
+    expect_to_be_true(high_water > 0);
+    return true;
+}
+
+typedef struct latency_job_result {
+    u32 index;
+    f64 start_time;
+} latency_job_result;
+
+typedef struct latency_job_params {
+    u32 index;
+} latency_job_params;
+
+static f64 submit_times[JOB_TEST_LATENCY_JOB_COUNT];
+static f64 start_times[JOB_TEST_LATENCY_JOB_COUNT];
+static f64 callback_times[JOB_TEST_LATENCY_JOB_COUNT];
+static u32 latency_callback_count;
+
+static b8 latency_job(void* params, void* result_data) {
+    latency_job_params* p = params;
+    latency_job_result* result = result_data;
+    result->index = p->index;
+    result->start_time = platform_get_absolute_time();
+    return true;
+}
+
+static void latency_job_success(void* params) {
+    latency_job_result* result = params;
+    start_times[result->index] = result->start_time;
+    callback_times[result->index] = platform_get_absolute_time();
+    latency_callback_count++;
+}
+
+// Sorts the given times in place and obtains the given percentile of them.
+static f64 percentile_get(f64* times, u32 count, f32 percentile) {
+    for (u32 i = 1; i < count; ++i) {
+        f64 value = times[i];
+        u32 j = i;
+        for (; j > 0 && times[j - 1] > value; --j) {
+            times[j] = times[j - 1];
+        }
+        times[j] = value;
+    }
+    u32 index = (u32)((count - 1) * percentile);
+    return times[index];
+}
+
+u8 job_system_should_start_jobs_and_invoke_callbacks_promptly() {
+    if (!job_test_start(JOB_TEST_THREAD_COUNT, JOB_TYPE_GENERAL | JOB_TYPE_RESOURCE_LOAD | JOB_TYPE_GPU_RESOURCE)) {
+        return false;
+    }
+
+    // One job at a time, updating in between, so each is timed on an otherwise idle job system.
+    latency_callback_count = 0;
+    for (u32 i = 0; i < JOB_TEST_LATENCY_JOB_COUNT; ++i) {
+        latency_job_params params = {i};
+        submit_times[i] = platform_get_absolute_time();
+        job_system_submit(job_create(latency_job, latency_job_success, 0, &params, sizeof(latency_job_params), sizeof(latency_job_result)));
+        f64 deadline = platform_get_absolute_time() + JOB_TEST_TIMEOUT;
+        while (latency_callback_count <= i && platform_get_absolute_time() < deadline) {
+            job_system_update();
+        }
+    }
+    job_system_stats stats;
+    job_system_stats_get(&stats);
+    job_test_stop();
+
+    expect_should_be(JOB_TEST_LATENCY_JOB_COUNT, latency_callback_count);
+
+    f64 start_latencies[JOB_TEST_LATENCY_JOB_COUNT];
+    f64 callback_latencies[JOB_TEST_LATENCY_JOB_COUNT];
+    for (u32 i = 0; i < JOB_TEST_LATENCY_JOB_COUNT; ++i) {
+        start_latencies[i] = start_times[i] - submit_times[i];
+        callback_latencies[i] = callback_times[i] - start_times[i];
+        expect_to_be_true(start_latencies[i] >= 0.0);
+        expect_to_be_true(callback_latencies[i] >= 0.0);
+    }
+    f64 start_p50 = percentile_get(start_latencies, JOB_TEST_LATENCY_JOB_COUNT, 0.5f);
+    f64 start_p99 = percentile_get(start_latencies, JOB_TEST_LATENCY_JOB_COUNT, 0.99f);
+    f64 callback_p50 = percentile_get(callback_latencies, JOB_TEST_LATENCY_JOB_COUNT, 0.5f);
+    f64 callback_p99 = percentile_get(callback_latencies, JOB_TEST_LATENCY_JOB_COUNT, 0.99f);
+    KINFO("Job latency: submit->start p50 %.1fus p99 %.1fus, start->callback p50 %.1fus p99 %.1fus.",
+          start_p50 * 1000000.0, start_p99 * 1000000.0, callback_p50 * 1000000.0, callback_p99 * 1000000.0);
+
+    // Loose bounds, so a busy machine does not fail the test, while a lost wakeup still would.
+    expect_to_be_true(start_p50 < 0.005);
+    expect_to_be_true(start_p99 < 0.05);
+    expect_to_be_true(callback_p50 < 0.005);
+    expect_to_be_true(callback_p99 < 0.05);
+
+    // Every job was counted by the job system's own latency histogram.
+    u64 counted = 0;
+    for (u32 i = 0; i < JOB_HISTOGRAM_BUCKET_COUNT; ++i) {
+        counted += stats.latency_histograms[0][i];
+    }
+    expect_should_be(JOB_TEST_LATENCY_JOB_COUNT, counted);
+    return true;
+}
+
+u8 job_system_should_run_jobs_with_threads_parked() {
+    // Only the last thread takes resource loads, so those are left to it once it is parked.
+    u32 thread_types[JOB_TEST_THREAD_COUNT] = {JOB_TYPE_GENERAL, JOB_TYPE_GENERAL, JOB_TYPE_GENERAL, JOB_TYPE_RESOURCE_LOAD};
+    job_system_initialize(&job_memory_requirement, 0, 0, 0, 0);
+    job_state = kallocate(job_memory_requirement, MEMORY_TAG_APPLICATION);
+    if (!job_system_initialize(&job_memory_requirement, job_state, JOB_TEST_THREAD_COUNT, thread_types, 0)) {
+        return false;
+    }
+
+    job_system_active_thread_count_set(1);
+    u8 active_count = job_system_active_thread_count_get();
+
+    u32 general_counter = 0;
+    u32 load_counter = 0;
+    static job_handle handles[JOB_TEST_CALLBACK_JOB_COUNT];
+    for (u32 i = 0; i < JOB_TEST_CALLBACK_JOB_COUNT; ++i) {
+        b8 load = (i % 4) == 0;
+        counter_job_params params = {load ? &load_counter : &general_counter};
+        handles[i] = job_system_submit(job_create_type(counter_job, 0, 0, &params, sizeof(counter_job_params), 0, load ? JOB_TYPE_RESOURCE_LOAD : JOB_TYPE_GENERAL));
+    }
+    for (u32 i = 0; i < JOB_TEST_CALLBACK_JOB_COUNT; ++i) {
+        job_system_wait(handles[i]);
+    }
+    job_system_update();
+    job_system_stats stats;
+    job_system_stats_get(&stats);
+
+    // Asking for none still keeps one, and the performance policy brings every thread back.
+    job_system_active_thread_count_set(0);
+    u8 least_count = job_system_active_thread_count_get();
+    job_system_power_policy_set(JOB_POWER_POLICY_PERFORMANCE);
+    u8 restored_count = job_system_active_thread_count_get();
+    job_test_stop();
+
+    expect_should_be(1, active_count);
+    expect_should_be(JOB_TEST_CALLBACK_JOB_COUNT / 4, load_counter);
+    expect_should_be(JOB_TEST_CALLBACK_JOB_COUNT - JOB_TEST_CALLBACK_JOB_COUNT / 4, general_counter);
+    expect_to_be_false(stats.threads[0].parked);
+    for (u32 i = 1; i < JOB_TEST_THREAD_COUNT; ++i) {
+        expect_to_be_true(stats.threads[i].parked);
+    }
+    expect_should_be(1, least_count);
+    expect_should_be(JOB_TEST_THREAD_COUNT, restored_count);
+    return true;
+}
+
+// The number of dependent jobs no thread can run, released together by the discard test.
+#define JOB_TEST_UNRUNNABLE_JOB_COUNT 40
+
+typedef struct hold_job_params {
+    u32* started;
+    u32* released;
+} hold_job_params;
+
+// Holds its thread until it is released.
+static b8 hold_job(void* params, void* result_data) {
+    hold_job_params* p = params;
+    katomic_store(p->started, 1);
+    while (!katomic_load(p->released)) {
+        platform_sleep(0);
+    }
+    return true;
+}
+
+u8 job_system_should_discard_released_jobs_no_thread_can_run() {
+    if (!job_test_start(1, JOB_TYPE_GENERAL)) {
+        return false;
+    }
+
+    // Hold the only thread, so that the dependents are left waiting.
+    u32 hold_started = 0;
+    u32 hold_released = 0;
+    hold_job_params hold_params = {&hold_started, &hold_released};
+    job_handle hold = job_system_submit(job_create(hold_job, 0, 0, &hold_params, sizeof(hold_job_params), 0));
+    while (!katomic_load(&hold_started)) {
+        platform_sleep(0);
+    }
+
+    // More dependents than are released at a time, of a type that no thread runs.
+    u32 run_count = 0;
+    counter_job_params params = {&run_count};
+    job_handle handles[JOB_TEST_UNRUNNABLE_JOB_COUNT];
+    for (u32 i = 0; i < JOB_TEST_UNRUNNABLE_JOB_COUNT; ++i) {
+        job_info info = job_create_type(counter_job, 0, 0, &params, sizeof(counter_job_params), 0, JOB_TYPE_GPU_RESOURCE);
+        job_add_dependency(&info, hold);
+        handles[i] = job_system_submit(info);
+    }
+    // Discarding a dependency releases what waits on it in turn.
+    job_info chained = job_create(counter_job, 0, 0, &params, sizeof(counter_job_params), 0);
+    job_add_dependency(&chained, handles[0]);
+    job_handle chained_handle = job_system_submit(chained);
+
+    katomic_store(&hold_released, 1);
+    job_system_wait(hold);
+    for (u32 i = 0; i < JOB_TEST_UNRUNNABLE_JOB_COUNT; ++i) {
+        job_system_wait(handles[i]);
+    }
+    job_system_wait(chained_handle);
+    b8 all_complete = true;
+    for (u32 i = 0; i < JOB_TEST_UNRUNNABLE_JOB_COUNT; ++i) {
+        all_complete = all_complete && job_system_is_complete(handles[i]);
+    }
+    job_test_stop();
+
+    expect_to_be_true(all_complete);
+    // Only the chained job could run.
+    expect_should_be(1, run_count);
+    return true;
+}
+
+// The number of jobs queued behind the gate by the cancellation test.
+#define JOB_TEST_QUEUED_JOB_COUNT 8
+
+typedef struct gate_job_params {
+    u32* started;
+} gate_job_params;
+
+// Holds its thread until it is asked to cancel.
+static b8 gate_job(void* params, void* result_data) {
+    gate_job_params* p = params;
+    katomic_store(p->started, 1);
+    while (!job_system_cancel_requested()) {
+        platform_sleep(0);
+    }
+    return false;
+}
+
+typedef struct order_job_params {
+    u32* sequence;
+    u32* order;
+    u32* run_count;
+} order_job_params;
+
+static b8 order_job(void* params, void* result_data) {
+    order_job_params* p = params;
+    *p->order = katomic_fetch_add(p->sequence, 1);
+    katomic_fetch_add(p->run_count, 1);
+    return true;
+}
+
+static u32 gate_fail_count;
+static u32 cancel_count;
+
+static void gate_job_fail(void* params) {
+    gate_fail_count++;
+}
+
+static void order_job_cancel(void* params) {
+    cancel_count++;
+}
+
+u8 job_system_should_cancel_and_move_queued_jobs() {
+    if (!job_test_start(1, JOB_TYPE_GENERAL)) {
+        return false;
+    }
+    gate_fail_count = 0;
+    cancel_count = 0;
+
+    // Hold the only thread, so that everything after it stays queued.
+    u32 gate_started = 0;
+    gate_job_params gate_params = {&gate_started};
+    job_handle gate = job_system_submit(job_create(gate_job, 0, gate_job_fail, &gate_params, sizeof(gate_job_params), 0));
+    while (!katomic_load(&gate_started)) {
+        platform_sleep(0);
+    }
+
+    u32 sequence = 0;
+    u32 run_count = 0;
+    u32 orders[JOB_TEST_QUEUED_JOB_COUNT];
+    job_handle handles[JOB_TEST_QUEUED_JOB_COUNT];
+    for (u32 i = 0; i < JOB_TEST_QUEUED_JOB_COUNT; ++i) {
+        orders[i] = INVALID_ID;
+        order_job_params params = {&sequence, &orders[i], &run_count};
+        job_info info = job_create_priority(order_job, 0, 0, &params, sizeof(order_job_params), 0, JOB_TYPE_GENERAL, JOB_PRIORITY_LOW);
+        info.on_cancel = order_job_cancel;
+        handles[i] = job_system_submit(info);
+    }
+
+    // Every other job is cancelled, and the last is moved ahead of the rest.
+    b8 all_cancelled = true;
+    for (u32 i = 0; i < JOB_TEST_QUEUED_JOB_COUNT; i += 2) {
+        all_cancelled = all_cancelled && job_system_cancel(handles[i]);
+    }
+    b8 cancelled_moved = job_system_priority_set(handles[0], JOB_PRIORITY_HIGH);
+    b8 moved = job_system_priority_set(handles[JOB_TEST_QUEUED_JOB_COUNT - 1], JOB_PRIORITY_HIGH);
+
+    // The gate is running, so it is only asked to stop.
+    b8 gate_cancelled = job_system_cancel(gate);
+    job_system_wait(gate);
+    for (u32 i = 0; i < JOB_TEST_QUEUED_JOB_COUNT; ++i) {
+        job_system_wait(handles[i]);
+    }
+    f64 start = platform_get_absolute_time();
+    while ((cancel_count < JOB_TEST_QUEUED_JOB_COUNT / 2 || gate_fail_count < 1) && platform_get_absolute_time() - start < JOB_TEST_TIMEOUT) {
+        job_system_update();
+        platform_sleep(0);
+    }
+    b8 completed_cancelled = job_system_cancel(handles[1]);
+    job_test_stop();
+
+    expect_to_be_true(all_cancelled);
+    expect_to_be_false(cancelled_moved);
+    expect_to_be_true(moved);
+    expect_to_be_false(gate_cancelled);
+    expect_to_be_false(completed_cancelled);
+    expect_should_be(1, gate_fail_count);
+    expect_should_be(JOB_TEST_QUEUED_JOB_COUNT / 2, cancel_count);
+    expect_should_be(JOB_TEST_QUEUED_JOB_COUNT / 2, run_count);
+    for (u32 i = 0; i < JOB_TEST_QUEUED_JOB_COUNT; i += 2) {
+        expect_should_be(INVALID_ID, orders[i]);
+    }
+    // Moved to high priority, so it ran before every job left at low priority.
+    expect_should_be(0, orders[JOB_TEST_QUEUED_JOB_COUNT - 1]);
+    return true;
+}
+
+void job_system_register_tests() {
+    test_manager_register_test(job_system_should_run_thousands_of_jobs_at_every_priority, "Job system should run thousands of jobs at every priority");
+    test_manager_register_test(job_system_should_run_jobs_submitted_from_within_jobs, "Job system should run jobs submitted from within jobs");
+    test_manager_register_test(job_system_should_invoke_callbacks_once_in_the_order_jobs_finished, "Job system should invoke callbacks once in the order jobs finished");
+    test_manager_register_test(job_system_should_complete_jobs_beyond_its_queue_capacities, "Job system should complete jobs beyond its queue capacities");
+    test_manager_register_test(job_system_should_wait_on_the_main_thread_with_its_result_queue_full, "Job system should wait on the main thread with its result queue full");
+    test_manager_register_test(job_system_should_start_jobs_and_invoke_callbacks_promptly, "Job system should start jobs and invoke callbacks promptly");
+    test_manager_register_test(job_system_should_discard_released_jobs_no_thread_can_run, "Job system should discard released jobs no thread can run");
+    test_manager_register_test(job_system_should_run_jobs_with_threads_parked, "Job system should run jobs with threads parked");
+    test_manager_register_test(job_system_should_cancel_and_move_queued_jobs, "Job system should cancel and move queued jobs");
+}
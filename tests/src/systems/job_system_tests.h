@@ -0,0 +1,3 @@
+#pragma once
+
+void job_system_register_tests();
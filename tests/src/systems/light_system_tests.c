@@ -0,0 +1,101 @@
+#include "light_system_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <math/kmath.h>
+#include <systems/light_system.h>
+
+static void* light_system_test_start(u32 capacity, u64* out_memory_requirement) {
+    light_system_config config = {capacity};
+    light_system_initialize(out_memory_requirement, 0, config);
+    void* state = kallocate(*out_memory_requirement, MEMORY_TAG_APPLICATION);
+    light_system_initialize(out_memory_requirement, state, config);
+    return state;
+}
+
+static void light_system_test_stop(void* state, u64 memory_requirement) {
+    light_system_shutdown(state);
+    kfree(state, memory_requirement, MEMORY_TAG_APPLICATION);
+}
+
+static point_light test_light(f32 x) {
+    point_light light = {0};
+    light.position = (vec3){x, 0.0f, 0.0f};
+    light.colour = (vec4){1.0f, 0.5f, 0.25f, 1.0f};
+    light.constant_f = 1.0f;
+    light.linear = 0.35f;
+    light.quadratic = 0.44f;
+    return light;
+}
+
+u8 light_system_should_keep_ids_across_removal() {
+    u64 memory_requirement = 0;
+    void* state = light_system_test_start(4, &memory_requirement);
+
+    u32 ids[4];
+    for (u32 i = 0; i < 4; ++i) {
+        point_light light = test_light((f32)i);
+        ids[i] = light_system_point_add(&light);
+        expect_should_not_be(INVALID_ID, ids[i]);
+    }
+    // Full.
+    point_light extra = test_light(9.0f);
+    expect_should_be(INVALID_ID, light_system_point_add(&extra));
+
+    // Removing one moves another into its place, but every id still finds its own light.
+    expect_to_be_true(light_system_point_remove(ids[1]));
+    expect_to_be_false(light_system_point_remove(ids[1]));
+    expect_to_be_true(light_system_point_get(ids[1]) == 0);
+    const point_light* lights = 0;
+    expect_should_be(3, light_system_point_lights_get(&lights));
+    expect_float_to_be(0.0f, light_system_point_get(ids[0])->position.x);
+    expect_float_to_be(2.0f, light_system_point_get(ids[2])->position.x);
+    expect_float_to_be(3.0f, light_system_point_get(ids[3])->position.x);
+
+    // The freed id is handed out again, and updates reach the right light.
+    u32 id = light_system_point_add(&extra);
+    expect_should_be(ids[1], id);
+    point_light moved = test_light(-5.0f);
+    expect_to_be_true(light_system_point_update(ids[3], &moved));
+    expect_float_to_be(-5.0f, light_system_point_get(ids[3])->position.x);
+    expect_float_to_be(9.0f, light_system_point_get(id)->position.x);
+
+    light_system_test_stop(state, memory_requirement);
+    return true;
+}
+
+u8 light_system_should_work_out_radius_from_attenuation() {
+    u64 memory_requirement = 0;
+    void* state = light_system_test_start(2, &memory_requirement);
+
+    point_light light = test_light(0.0f);
+    light.radius = 1000.0f;
+    u32 id = light_system_point_add(&light);
+    f32 radius = light_system_point_get(id)->radius;
+
+    // At the radius, the brightest channel is attenuated down to the cutoff.
+    f32 attenuation = light.constant_f + light.linear * radius + light.quadratic * radius * radius;
+    expect_float_to_be(LIGHT_SYSTEM_CUTOFF, light.colour.r / attenuation);
+
+    // Linear only, and none at all.
+    light.quadratic = 0.0f;
+    expect_float_to_be((256.0f - 1.0f) / 0.35f, light_system_point_radius(&light));
+    light.linear = 0.0f;
+    expect_to_be_true(light_system_point_radius(&light) >= K_INFINITY);
+
+    // The directional light is normalized.
+    directional_light sun = {{0.0f, -2.0f, 0.0f}, {1.0f, 1.0f, 1.0f, 1.0f}};
+    expect_to_be_true(light_system_directional_set(&sun));
+    expect_float_to_be(-1.0f, light_system_directional_get().direction.y);
+
+    light_system_test_stop(state, memory_requirement);
+    return true;
+}
+
+void light_system_register_tests() {
+    test_manager_register_test(light_system_should_keep_ids_across_removal, "Light system should keep ids across removal");
+    test_manager_register_test(light_system_should_work_out_radius_from_attenuation, "Light system should work out radius from attenuation");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void light_system_register_tests();
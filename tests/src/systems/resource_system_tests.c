@@ -0,0 +1,115 @@
+#include "resource_system_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <platform/filesystem.h>
+#include <systems/resource_system.h>
+
+#include <stdio.h>  // remove
+
+#define RESOURCE_TEST_BASE_PATH "."
+#define RESOURCE_TEST_NAME "resource_system_test.bin"
+#define RESOURCE_TEST_SIZE 64
+
+static b8 resource_test_file_write(u8 seed) {
+    u8 bytes[RESOURCE_TEST_SIZE];
+    for (u32 i = 0; i < RESOURCE_TEST_SIZE; ++i) {
+        bytes[i] = (u8)(i + seed);
+    }
+    file_handle f;
+    if (!filesystem_open(RESOURCE_TEST_NAME, FILE_MODE_WRITE, true, &f)) {
+        return false;
+    }
+    u64 written = 0;
+    b8 result = filesystem_write(&f, RESOURCE_TEST_SIZE, bytes, &written) && written == RESOURCE_TEST_SIZE;
+    filesystem_close(&f);
+    return result;
+}
+
+static void* resource_test_system_create(u64 cache_budget, u64* out_memory_requirement) {
+    resource_system_config config = {};
+    config.asset_base_path = RESOURCE_TEST_BASE_PATH;
+    config.max_loader_count = 32;
+    config.max_cached_count = 4;
+    config.cache_budget = cache_budget;
+    resource_system_initialize(out_memory_requirement, 0, config);
+    void* state = kallocate(*out_memory_requirement, MEMORY_TAG_APPLICATION);
+    if (!resource_system_initialize(out_memory_requirement, state, config)) {
+        kfree(state, *out_memory_requirement, MEMORY_TAG_APPLICATION);
+        return 0;
+    }
+    return state;
+}
+
+u8 resource_system_should_share_acquired_resources() {
+    expect_to_be_true(resource_test_file_write(0));
+    u64 memory_requirement = 0;
+    void* state = resource_test_system_create(RESOURCE_TEST_SIZE, &memory_requirement);
+    expect_to_be_true((state != 0));
+
+    resource a;
+    resource b;
+    expect_to_be_true(resource_system_acquire(RESOURCE_TEST_NAME, RESOURCE_TYPE_BINARY, 0, &a));
+    expect_to_be_true(resource_system_acquire(RESOURCE_TEST_NAME, RESOURCE_TYPE_BINARY, 0, &b));
+    expect_should_be(RESOURCE_TEST_SIZE, a.data_size);
+    expect_to_be_true((a.data == b.data));
+    expect_to_be_false(resource_system_is_pending(RESOURCE_TEST_NAME, RESOURCE_TYPE_BINARY));
+
+    // Loads with parameters are never shared.
+    u32 params = 0;
+    resource c;
+    expect_to_be_true(resource_system_acquire(RESOURCE_TEST_NAME, RESOURCE_TYPE_BINARY, &params, &c));
+    expect_to_be_true((c.data != a.data));
+    resource_system_release(&c);
+
+    // Kept once released, as it fits the budget.
+    const void* shared = a.data;
+    resource_system_release(&a);
+    resource_system_release(&b);
+    expect_to_be_true(resource_system_acquire(RESOURCE_TEST_NAME, RESOURCE_TYPE_BINARY, 0, &a));
+    expect_to_be_true((a.data == shared));
+
+    // Invalidated while held, so the holder keeps its copy and the next acquire loads the file again.
+    expect_to_be_true(resource_test_file_write(1));
+    resource_system_invalidate(RESOURCE_TEST_NAME, RESOURCE_TYPE_BINARY);
+    expect_to_be_true(resource_system_acquire(RESOURCE_TEST_NAME, RESOURCE_TYPE_BINARY, 0, &b));
+    expect_to_be_true((b.data != a.data));
+    expect_should_be(1, ((const u8*)b.data)[0]);
+    resource_system_release(&a);
+    resource_system_release(&b);
+
+    resource_system_shutdown(state);
+    kfree(state, memory_requirement, MEMORY_TAG_APPLICATION);
+    remove(RESOURCE_TEST_NAME);
+    return true;
+}
+
+u8 resource_system_should_evict_beyond_budget() {
+    expect_to_be_true(resource_test_file_write(0));
+    u64 memory_requirement = 0;
+    void* state = resource_test_system_create(0, &memory_requirement);
+    expect_to_be_true((state != 0));
+
+    // With no budget, a released resource is unloaded at once, so the file is read again.
+    resource a;
+    expect_to_be_true(resource_system_acquire(RESOURCE_TEST_NAME, RESOURCE_TYPE_BINARY, 0, &a));
+    expect_should_be(0, ((const u8*)a.data)[0]);
+    resource_system_release(&a);
+    expect_to_be_true(resource_test_file_write(2));
+    expect_to_be_true(resource_system_acquire(RESOURCE_TEST_NAME, RESOURCE_TYPE_BINARY, 0, &a));
+    expect_should_be(2, ((const u8*)a.data)[0]);
+    resource_system_release(&a);
+
+    resource_system_shutdown(state);
+    kfree(state, memory_requirement, MEMORY_TAG_APPLICATION);
+    remove(RESOURCE_TEST_NAME);
+    return true;
+}
+
+void resource_system_register_tests() {
+    test_manager_register_test(resource_system_should_share_acquired_resources, "Resource system should share acquired resources");
+    test_manager_register_test(resource_system_should_evict_beyond_budget, "Resource system should evict resources beyond its budget");
+}
@@ -4,16 +4,36 @@
 #include <core/logger.h>
 #include <core/kstring.h>
 #include <core/clock.h>
+#include <platform/filesystem.h>
+#include <platform/platform.h>
 
 typedef struct test_entry {
     PFN_test func;
     char* desc;
 } test_entry;
 
+typedef struct benchmark_entry {
+    PFN_test setup;
+    PFN_benchmark run;
+    PFN_test teardown;
+    u32 op_count;
+    char* name;
+} benchmark_entry;
+
+// The time per operation of a benchmark's samples, in nanoseconds.
+typedef struct benchmark_result {
+    f64 min_ns;
+    f64 median_ns;
+    f64 p99_ns;
+    f64 mean_ns;
+} benchmark_result;
+
 static test_entry* tests;
+static benchmark_entry* benchmarks;
 
 void test_manager_init() {
     tests = darray_create(test_entry);
+    benchmarks = darray_create(benchmark_entry);
 }
 
 void test_manager_register_test(u8 (*PFN_test)(), char* desc) {
@@ -57,4 +77,121 @@ void test_manager_run_tests() {
     clock_stop(&total_time);
 
     KINFO("Results: %d passed, %d failed, %d skipped.", passed, failed, skipped);
-}
\ No newline at end of file
+}
+
+void test_manager_register_benchmark(PFN_test setup, PFN_benchmark run, PFN_test teardown, u32 op_count, char* name) {
+    benchmark_entry e;
+    e.setup = setup;
+    e.run = run;
+    e.teardown = teardown;
+    e.op_count = KMAX(op_count, 1);
+    e.name = name;
+    darray_push(benchmarks, e);
+}
+
+// Insertion sort, as there are only ever a few samples.
+static void samples_sort(f64* samples, u32 count) {
+    for (u32 i = 1; i < count; ++i) {
+        f64 value = samples[i];
+        u32 j = i;
+        for (; j > 0 && samples[j - 1] > value; --j) {
+            samples[j] = samples[j - 1];
+        }
+        samples[j] = value;
+    }
+}
+
+static b8 benchmark_run(benchmark_entry* entry, benchmark_result* out_result) {
+    if (entry->setup && !entry->setup()) {
+        KERROR("[FAILED]: %s setup", entry->name);
+        return false;
+    }
+
+    b8 result = true;
+    f64 samples[TEST_MANAGER_BENCHMARK_SAMPLE_COUNT];
+    for (u32 i = 0; i < TEST_MANAGER_BENCHMARK_WARMUP_COUNT + TEST_MANAGER_BENCHMARK_SAMPLE_COUNT; ++i) {
+        f64 start = platform_get_absolute_time();
+        if (!entry->run(entry->op_count)) {
+            result = false;
+            break;
+        }
+        f64 elapsed = platform_get_absolute_time() - start;
+        if (i >= TEST_MANAGER_BENCHMARK_WARMUP_COUNT) {
+            samples[i - TEST_MANAGER_BENCHMARK_WARMUP_COUNT] = elapsed * 1000000000.0 / entry->op_count;
+        }
+    }
+
+    if (entry->teardown && !entry->teardown()) {
+        KERROR("[FAILED]: %s teardown", entry->name);
+        result = false;
+    }
+    if (!result) {
+        KERROR("[FAILED]: %s", entry->name);
+        return false;
+    }
+
+    f64 total = 0;
+    for (u32 i = 0; i < TEST_MANAGER_BENCHMARK_SAMPLE_COUNT; ++i) {
+        total += samples[i];
+    }
+    samples_sort(samples, TEST_MANAGER_BENCHMARK_SAMPLE_COUNT);
+    out_result->min_ns = samples[0];
+    out_result->median_ns = samples[TEST_MANAGER_BENCHMARK_SAMPLE_COUNT / 2];
+    // The rank the p99 falls at, which over so few samples is the slowest.
+    u32 p99_rank = (u32)(TEST_MANAGER_BENCHMARK_SAMPLE_COUNT * 0.99 + 0.999999);
+    out_result->p99_ns = samples[KMIN(p99_rank, TEST_MANAGER_BENCHMARK_SAMPLE_COUNT) - 1];
+    out_result->mean_ns = total / TEST_MANAGER_BENCHMARK_SAMPLE_COUNT;
+    return true;
+}
+
+b8 test_manager_run_benchmarks(const char* filter, const char* output_path) {
+    u32 count = darray_length(benchmarks);
+    u64 filter_length = filter ? string_length(filter) : 0;
+
+    file_handle output;
+    b8 has_output = false;
+    if (output_path) {
+        if (!filesystem_open(output_path, FILE_MODE_WRITE, false, &output)) {
+            KERROR("Unable to open '%s' to write benchmark results to.", output_path);
+            return false;
+        }
+        has_output = true;
+        filesystem_write_line(&output, "{\"benchmarks\":[");
+    }
+
+    u32 run_count = 0;
+    u32 failed = 0;
+    b8 write_failed = false;
+    for (u32 i = 0; i < count; ++i) {
+        benchmark_entry* entry = &benchmarks[i];
+        if (filter_length && !strings_nequal(entry->name, filter, filter_length)) {
+            continue;
+        }
+
+        benchmark_result result;
+        if (!benchmark_run(entry, &result)) {
+            ++failed;
+            continue;
+        }
+        KINFO("  %-36s min %10.2f ns/op  median %10.2f ns/op  p99 %10.2f ns/op", entry->name, result.min_ns, result.median_ns, result.p99_ns);
+
+        if (has_output) {
+            char line[512];
+            string_format(line, "%s{\"name\":\"%s\",\"ops_per_sample\":%u,\"samples\":%u,\"min_ns\":%.3f,\"median_ns\":%.3f,\"p99_ns\":%.3f,\"mean_ns\":%.3f}",
+                          run_count ? "," : "", entry->name, entry->op_count, TEST_MANAGER_BENCHMARK_SAMPLE_COUNT, result.min_ns, result.median_ns, result.p99_ns, result.mean_ns);
+            write_failed |= !filesystem_write_line(&output, line);
+        }
+        ++run_count;
+    }
+
+    if (has_output) {
+        write_failed |= !filesystem_write_line(&output, "]}");
+        filesystem_close(&output);
+        if (write_failed) {
+            KERROR("Failed to write benchmark results to '%s'.", output_path);
+        }
+    }
+
+    KINFO("Benchmarks: %d run, %d failed.", run_count, failed);
+    return failed == 0 && !write_failed;
+}
@@ -4,10 +4,44 @@
 
 #define BYPASS 2
 
+/** @brief The number of untimed samples a benchmark runs first, to warm caches and branch predictors. */
+#define TEST_MANAGER_BENCHMARK_WARMUP_COUNT 3
+
+/** @brief The number of timed samples taken of each benchmark. */
+#define TEST_MANAGER_BENCHMARK_SAMPLE_COUNT 31
+
 typedef u8 (*PFN_test)();
 
+/**
+ * @brief Runs a benchmark's operation the given number of times, as one timed sample.
+ * @returns True on success; otherwise false, which fails the benchmark.
+ */
+typedef u8 (*PFN_benchmark)(u32 op_count);
+
 void test_manager_init();
 
 void test_manager_register_test(PFN_test, char* desc);
 
-void test_manager_run_tests();
\ No newline at end of file
+void test_manager_run_tests();
+
+/**
+ * @brief Registers a benchmark, which is only run by test_manager_run_benchmarks.
+ *
+ * @param setup Run once before the benchmark's samples are taken, or 0 if nothing is needed.
+ * @param run Runs the operation being measured op_count times.
+ * @param teardown Run once after the last sample, or 0 if nothing is needed.
+ * @param op_count The number of operations each sample runs, so that a sample is long enough to time.
+ * @param name The name of the benchmark, such as "kmath.mat4_mul", by which it can be filtered.
+ */
+void test_manager_register_benchmark(PFN_test setup, PFN_benchmark run, PFN_test teardown, u32 op_count, char* name);
+
+/**
+ * @brief Runs the registered benchmarks, each for TEST_MANAGER_BENCHMARK_WARMUP_COUNT untimed and
+ * TEST_MANAGER_BENCHMARK_SAMPLE_COUNT timed samples, logging the min, median and p99 time per
+ * operation of each, and writing them as JSON.
+ *
+ * @param filter Only benchmarks whose names start with this are run, or 0 to run all.
+ * @param output_path The path of the JSON file to write the results to, or 0 to only log them.
+ * @returns True if every benchmark run succeeded and the results could be written; otherwise false.
+ */
+b8 test_manager_run_benchmarks(const char* filter, const char* output_path);
@@ -0,0 +1,278 @@
+#include "shader_build.h"
+
+#include <core/logger.h>
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <containers/darray.h>
+#include <platform/filesystem.h>
+#include <resources/asset_cook.h>
+#include <systems/job_system.h>
+
+// For executing shell commands.
+#include <stdlib.h>
+
+// A stage being built.
+typedef struct shader_build_stage {
+    const char* source;
+    char stage[5];
+    char output[512];
+    // The hash of the source, the sources it includes and the build options.
+    u64 hash;
+    b8 up_to_date;
+    b8 succeeded;
+} shader_build_stage;
+
+// An entry read from an existing manifest.
+typedef struct shader_build_record {
+    u64 hash;
+    char source[512];
+} shader_build_record;
+
+static const char* sdk_path;
+static b8 optimize;
+
+static b8 parse_hex_u64(kstring_view text, u64* out_value) {
+    if (text.length == 0 || text.length > 16) {
+        return false;
+    }
+    u64 value = 0;
+    for (u64 i = 0; i < text.length; ++i) {
+        char c = text.str[i];
+        u64 digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        value = (value << 4) | digit;
+    }
+    *out_value = value;
+    return true;
+}
+
+// Reads the records of the manifest at path, if there is one.
+static shader_build_record* manifest_read(const char* path) {
+    shader_build_record* records = darray_create(shader_build_record);
+    file_mapping mapping;
+    if (!filesystem_exists(path) || !filesystem_map(path, &mapping)) {
+        return records;
+    }
+
+    // Each line is "<hash>\t<source>", as paths may hold spaces.
+    kstring_view text = string_view_from(mapping.data, mapping.size);
+    kstring_view line;
+    while (string_view_next_line(&text, &line)) {
+        kstring_view hash;
+        kstring_view source;
+        if (!string_view_next_split(&line, '\t', &hash) || hash.length == 0 || hash.str[0] == '#' || !string_view_next_split(&line, '\t', &source)) {
+            continue;
+        }
+        shader_build_record record = {};
+        if (!parse_hex_u64(hash, &record.hash) || source.length >= sizeof(record.source)) {
+            KWARN("Ignoring a malformed line in shader manifest '%s'.", path);
+            continue;
+        }
+        string_view_copy(record.source, source, sizeof(record.source));
+        darray_push(records, record);
+    }
+    filesystem_unmap(&mapping);
+    return records;
+}
+
+static b8 manifest_write(const char* path, const shader_build_stage* stages, u32 stage_count) {
+    file_handle f;
+    if (!filesystem_open(path, FILE_MODE_WRITE, false, &f)) {
+        KERROR("Unable to open shader manifest '%s' for writing.", path);
+        return false;
+    }
+    b8 result = filesystem_write_line(&f, "# Ignis compiled shader stages: <hash of source, includes and options> <source>");
+    char line[600];
+    for (u32 i = 0; i < stage_count && result; ++i) {
+        // Stages which failed are left out, so they are compiled again next time.
+        if (stages[i].succeeded) {
+            string_format(line, "%016llx\t%s", stages[i].hash, stages[i].source);
+            result = filesystem_write_line(&f, line);
+        }
+    }
+    filesystem_close(&f);
+    return result;
+}
+
+// Folds the contents of the file at path, and of everything it includes, into hash.
+static b8 source_hash(const char* path, u32 depth, u64* hash) {
+    file_mapping mapping;
+    if (!filesystem_map(path, &mapping)) {
+        KERROR("Unable to read '%s'.", path);
+        return false;
+    }
+    *hash = (*hash ^ asset_cook_hash(mapping.data, mapping.size)) * 0x100000001b3ull;
+
+    // Includes are relative to the file including them, as glslc resolves them.
+    char directory[512] = {};
+    string_directory_from_path(directory, path);
+    b8 result = true;
+    kstring_view text = string_view_from(mapping.data, mapping.size);
+    kstring_view line;
+    while (result && string_view_next_line(&text, &line)) {
+        kstring_view directive;
+        line = string_view_trim(line);
+        if (!string_view_next_token(&line, &directive) || !string_view_equal(directive, "#include")) {
+            continue;
+        }
+        line = string_view_trim(line);
+        i64 end = line.length > 1 ? string_view_index_of(string_view_mid(line, 1, -1), '"') : -1;
+        if (line.str[0] != '"' || end < 0) {
+            // Only quoted includes, relative to the file, are followed.
+            continue;
+        }
+        if (depth >= SHADER_BUILD_MAX_INCLUDE_DEPTH) {
+            KERROR("'%s' nests includes deeper than %u.", path, SHADER_BUILD_MAX_INCLUDE_DEPTH);
+            result = false;
+            break;
+        }
+        char include_name[256];
+        char include_path[768];
+        string_view_copy(include_name, string_view_mid(line, 1, end), sizeof(include_name));
+        string_format(include_path, "%s%s", directory, include_name);
+        result = source_hash(include_path, depth + 1, hash);
+    }
+    filesystem_unmap(&mapping);
+    return result;
+}
+
+// Works out the stage and output of a source, failing if its name has no known stage.
+static b8 shader_build_stage_create(const char* source, shader_build_stage* out_stage) {
+    kzero_memory(out_stage, sizeof(shader_build_stage));
+    out_stage->source = source;
+    u64 length = string_length(source);
+    static const char* stage_names[] = {"vert", "frag", "geom", "comp"};
+    for (u32 i = 0; i < 4; ++i) {
+        char suffix[16];
+        string_format(suffix, "%s.glsl", stage_names[i]);
+        if (length >= 9 && strings_equali(source + length - 9, suffix)) {
+            string_ncopy(out_stage->stage, stage_names[i], 4);
+            break;
+        }
+    }
+    if (!out_stage->stage[0] || length - 4 + 3 >= sizeof(out_stage->output)) {
+        KERROR("'%s' must end in <stage>.glsl, where <stage> is one of vert, frag, geom or comp.", source);
+        return false;
+    }
+
+    // Output filename, just has different extension of spv.
+    string_ncopy(out_stage->output, source, length - 4);
+    string_ncopy(out_stage->output + length - 4, "spv", 3);
+    out_stage->output[length - 1] = 0;
+    return true;
+}
+
+// Compiles each of the given stages. Safe to run on several threads at once.
+static void shader_build_stages_run(u32 start, u32 end, void* user_data) {
+    shader_build_stage** stages = user_data;
+    for (u32 i = start; i < end; ++i) {
+        shader_build_stage* stage = stages[i];
+        KINFO("Processing %s -> %s...", stage->source, stage->output);
+
+        // Construct the command and execute it.
+        char command[4096];
+        string_format(command, "%s/bin/glslc -fshader-stage=%s %s -o %s", sdk_path, stage->stage, stage->source, stage->output);
+        stage->succeeded = system(command) == 0;
+        if (stage->succeeded && optimize) {
+            string_format(command, "%s/bin/spirv-opt -O %s -o %s", sdk_path, stage->output, stage->output);
+            stage->succeeded = system(command) == 0;
+        }
+        if (!stage->succeeded) {
+            KERROR("Error compiling shader '%s'. See logs.", stage->source);
+        }
+    }
+}
+
+b8 shader_build_stages(u32 stage_count, const char** sources, shader_build_options options) {
+    if (stage_count == 0) {
+        return true;
+    }
+    if (!sources || options.thread_count < 1) {
+        KERROR("shader_build_stages requires stages and at least one thread.");
+        return false;
+    }
+
+    char directory[512] = {};
+    char manifest_path[1024];
+    string_directory_from_path(directory, sources[0]);
+    string_format(manifest_path, "%s%s", directory, SHADER_BUILD_MANIFEST_NAME);
+    shader_build_record* records = manifest_read(manifest_path);
+    u32 record_count = (u32)darray_length(records);
+
+    // Hash every stage, and find which have changed since they were last built.
+    b8 result = true;
+    shader_build_stage* stages = kallocate(sizeof(shader_build_stage) * stage_count, MEMORY_TAG_ARRAY);
+    shader_build_stage** stale = darray_create(shader_build_stage*);
+    for (u32 i = 0; i < stage_count; ++i) {
+        shader_build_stage* stage = &stages[i];
+        if (!shader_build_stage_create(sources[i], stage)) {
+            result = false;
+            continue;
+        }
+        // The options are part of the hash, so changing them rebuilds everything.
+        stage->hash = 0xcbf29ce484222325ull ^ (options.optimize ? 1 : 0);
+        if (!source_hash(sources[i], 0, &stage->hash)) {
+            result = false;
+            continue;
+        }
+        for (u32 r = 0; r < record_count && !options.force; ++r) {
+            if (records[r].hash == stage->hash && strings_equal(records[r].source, stage->source)) {
+                stage->up_to_date = filesystem_exists(stage->output);
+                break;
+            }
+        }
+
+        if (stage->up_to_date) {
+            stage->succeeded = true;
+        } else {
+            darray_push(stale, stage);
+        }
+    }
+    darray_destroy(records);
+
+    u32 stale_count = (u32)darray_length(stale);
+    KINFO("Compiling %u of %u shader stages; the rest are up to date.", stale_count, stage_count);
+    if (stale_count > 0) {
+        sdk_path = getenv("VULKAN_SDK");
+        optimize = options.optimize;
+        if (!sdk_path) {
+            KERROR("Environment variable VULKAN_SDK not found. Check your Vulkan installation.");
+            result = false;
+        } else {
+            // Job threads to compile on, each taking anything.
+            u32 job_thread_types[JOB_MAX_THREAD_COUNT];
+            u32 thread_count = KMIN(options.thread_count, JOB_MAX_THREAD_COUNT);
+            for (u32 i = 0; i < thread_count; ++i) {
+                job_thread_types[i] = JOB_TYPE_GENERAL | JOB_TYPE_RESOURCE_LOAD | JOB_TYPE_GPU_RESOURCE;
+            }
+            u64 job_memory_requirement = 0;
+            job_system_initialize(&job_memory_requirement, 0, 0, 0, 0);
+            void* job_state = kallocate(job_memory_requirement, MEMORY_TAG_APPLICATION);
+            if (job_system_initialize(&job_memory_requirement, job_state, (u8)thread_count, job_thread_types, 0)) {
+                // Each stage on its own, as each is a process of its own.
+                job_system_parallel_for(stale_count, 1, shader_build_stages_run, stale);
+                job_system_shutdown(job_state);
+            } else {
+                KERROR("shader_build_stages - unable to start the job system.");
+            }
+            kfree(job_state, job_memory_requirement, MEMORY_TAG_APPLICATION);
+
+            for (u32 i = 0; i < stale_count; ++i) {
+                result = result && stale[i]->succeeded;
+            }
+        }
+    }
+    darray_destroy(stale);
+
+    result = manifest_write(manifest_path, stages, stage_count) && result;
+    kfree(stages, sizeof(shader_build_stage) * stage_count, MEMORY_TAG_ARRAY);
+    return result;
+}
@@ -0,0 +1,46 @@
+/**
+ * @file shader_build.h
+ * @author Syed Nofel Talha (syednofeltalha2@gmail.com)
+ * @brief This file contains the building of GLSL shader stages into SPIR-V for the tools.
+ * @details Each stage is compiled by glslc from the Vulkan SDK, and optionally optimized for
+ * performance by spirv-opt afterward. Stages are compiled in parallel on the job system, as each is
+ * a separate process. The hash of every stage's source, along with the sources it includes and the
+ * options it was built with, is recorded in a manifest beside the stages, and stages which are
+ * unchanged since they were last built are skipped.
+ * @version 1.0
+ * @date 2026-10-14
+ *
+ * @copyright Ignis Game Engine is Copyright (c) Syed Nofel Talha 2025-2026
+ *
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief The name of the manifest written to the directory of the first stage built. */
+#define SHADER_BUILD_MANIFEST_NAME "shaders.manifest"
+
+/** @brief The deepest #include nesting followed when hashing a stage. */
+#define SHADER_BUILD_MAX_INCLUDE_DEPTH 8
+
+/** @brief Options for building shader stages. */
+typedef struct shader_build_options {
+    /** @brief Indicates if spirv-opt should optimize each stage for performance once compiled. */
+    b8 optimize;
+    /** @brief Indicates if every stage should be compiled, even those which are up to date. */
+    b8 force;
+    /** @brief The number of job threads to compile on, at least 1. */
+    u32 thread_count;
+} shader_build_options;
+
+/**
+ * @brief Compiles the given GLSL stages to .spv files beside them, in parallel, and rewrites the
+ * manifest. Starts and stops its own job system, so should be called with it not running, but with
+ * the memory system initialized.
+ * @param stage_count The number of stages.
+ * @param sources The paths of the stages, each ending in <stage>.glsl, where <stage> is one of vert, frag, geom or comp.
+ * @param options The options to build with.
+ * @returns True if every stage was compiled or already up to date; otherwise false.
+ */
+b8 shader_build_stages(u32 stage_count, const char** sources, shader_build_options options);
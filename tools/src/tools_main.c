@@ -1,12 +1,23 @@
 #include <defines.h>
 #include <core/logger.h>
 #include <core/kstring.h>
+#include <core/kmemory.h>
+#include <platform/filesystem.h>
+#include <platform/platform.h>
+#include <resources/asset_cook.h>
+#include <resources/asset_archive.h>
+#include <resources/loaders/mesh_loader.h>
+#include <resources/loaders/shader_loader.h>
+
+#include "shader_build.h"
 
-// For executing shell commands.
-#include <stdlib.h>
 
 void print_help();
 i32 process_shaders(i32 argc, char** argv);
+i32 process_log_decode(i32 argc, char** argv);
+i32 process_pack(i32 argc, char** argv);
+i32 process_ksm(i32 argc, char** argv);
+i32 process_cook(i32 argc, char** argv);
 
 i32 main(i32 argc, char** argv) {
     // The first arg is always the program itself.
@@ -19,6 +30,14 @@ i32 main(i32 argc, char** argv) {
     // The second argument tells us what mode to go into.
     if (strings_equali(argv[1], "buildshaders") || strings_equali(argv[1], "bshaders")) {
         return process_shaders(argc, argv);
+    } else if (strings_equali(argv[1], "decodelog")) {
+        return process_log_decode(argc, argv);
+    } else if (strings_equali(argv[1], "pack")) {
+        return process_pack(argc, argv);
+    } else if (strings_equali(argv[1], "ksm")) {
+        return process_ksm(argc, argv);
+    } else if (strings_equali(argv[1], "cook")) {
+        return process_cook(argc, argv);
     } else {
         KERROR("Unrecognized argument '%s'.", argv[1]);
         print_help();
@@ -34,53 +53,210 @@ i32 process_shaders(i32 argc, char** argv) {
         return -3;
     }
 
-    // Starting at third argument. One argument = 1 shader.
+    memory_system_configuration memory_system_config = {0};
+    memory_system_config.total_alloc_size = MEBIBYTES(256);
+    if (!memory_system_initialize(memory_system_config)) {
+        KERROR("Failed to initialize memory system.");
+        return -4;
+    }
+
+    // Starting at third argument. One argument = 1 shader, or an option.
+    shader_build_options options = {};
+    const char** stages = kallocate(sizeof(const char*) * argc, MEMORY_TAG_ARRAY);
+    const char** configs = kallocate(sizeof(const char*) * argc, MEMORY_TAG_ARRAY);
+    u32 stage_count = 0;
+    u32 config_count = 0;
+    const char* config_extension = ".shadercfg";
+    i32 config_extension_length = string_length(config_extension);
     for (u32 i = 2; i < argc; ++i) {
-        char* sdk_path = getenv("VULKAN_SDK");
-        if (!sdk_path) {
-            KERROR("Environment variable VULKAN_SDK not found. Check your Vulkan installation.");
-            return -4;
+        i32 length = string_length(argv[i]);
+        if (strings_equal(argv[i], "-O")) {
+            options.optimize = true;
+        } else if (strings_equal(argv[i], "-f")) {
+            options.force = true;
+        } else if (length > config_extension_length && strings_equali(argv[i] + length - config_extension_length, config_extension)) {
+            configs[config_count++] = argv[i];
+        } else {
+            stages[stage_count++] = argv[i];
         }
+    }
 
-        char end_path[10];
-        i32 length = string_length(argv[i]);
-        string_ncopy(end_path, argv[i] + length - 9, 9);
-
-        // Parse the stage from the file name.
-        char stage[5];
-        if (strings_equali(end_path, "frag.glsl")) {
-            string_ncopy(stage, "frag", 4);
-        } else if (strings_equali(end_path, "vert.glsl")) {
-            string_ncopy(stage, "vert", 4);
-        } else if (strings_equali(end_path, "geom.glsl")) {
-            string_ncopy(stage, "geom", 4);
-        } else if (strings_equali(end_path, "comp.glsl")) {
-            string_ncopy(stage, "comp", 4);
+    // Every stage is compiled before any shader config is checked against them. Leave a core for
+    // this thread, which waits on and helps with the compiling.
+    options.thread_count = (u32)KCLAMP(platform_get_processor_count() - 1, 1, 15);
+    i32 result = 0;
+    if (!shader_build_stages(stage_count, stages, options)) {
+        KERROR("Error compiling shaders. See logs. Aborting process.");
+        result = -5;
+    }
+
+    // Shader configs are compiled to .ksc beside them, after checking them against their stages.
+    // Stage files are relative to the asset base directory, the parent of the shaders directory.
+    for (u32 i = 0; i < config_count && result == 0; ++i) {
+        i32 length = string_length(configs[i]);
+        char shaders_dir[512] = {};
+        char base_path[512] = {};
+        string_directory_from_path(shaders_dir, configs[i]);
+        i32 shaders_dir_length = string_length(shaders_dir);
+        if (shaders_dir_length > 0) {
+            // Drop the trailing separator so the parent is found.
+            shaders_dir[shaders_dir_length - 1] = 0;
+            string_directory_from_path(base_path, shaders_dir);
+        }
+        if (!base_path[0]) {
+            string_ncopy(base_path, ".", 1);
         }
-        stage[4] = 0;
-
-        // Output filename, just has different extension of spv.
-        char out_filename[255];
-        string_ncopy(out_filename, argv[i], length - 4);
-        string_ncopy(out_filename + length - 4, "spv", 3);
-        out_filename[length - 1] = 0;
-
-        // Some output.
-        KINFO("Processing %s -> %s...", argv[i], out_filename);
-
-        // Construct the command and execute it.
-        char command[4096];
-        string_format(command, "%s/bin/glslc -fshader-stage=%s %s -o %s", sdk_path, stage, argv[i], out_filename);
-        // Vulkan shader compilation
-        i32 retcode = system(command);
-        if (retcode != 0) {
-            KERROR("Error compiling shader. See logs. Aborting process.");
-            return -5;
+        char out_filename[512];
+        string_ncopy(out_filename, configs[i], length - config_extension_length);
+        string_ncopy(out_filename + length - config_extension_length, ".ksc", 4);
+        out_filename[length - config_extension_length + 4] = 0;
+
+        KINFO("Processing %s -> %s...", configs[i], out_filename);
+        if (!ksc_file_compile(configs[i], base_path, out_filename)) {
+            KERROR("Error compiling shader config. See logs. Aborting process.");
+            result = -5;
         }
     }
 
-    KINFO("Successfully processed all shaders.");
-    return 0;
+    kfree(stages, sizeof(const char*) * argc, MEMORY_TAG_ARRAY);
+    kfree(configs, sizeof(const char*) * argc, MEMORY_TAG_ARRAY);
+    memory_system_shutdown();
+    if (result == 0) {
+        KINFO("Successfully processed all shaders.");
+    }
+    return result;
+}
+
+i32 process_log_decode(i32 argc, char** argv) {
+    if (argc < 4) {
+        KERROR("Decode log mode requires an input and an output path.");
+        return -3;
+    }
+
+    memory_system_configuration memory_system_config = {0};
+    memory_system_config.total_alloc_size = MEBIBYTES(256);
+    if (!memory_system_initialize(memory_system_config)) {
+        KERROR("Failed to initialize memory system.");
+        return -4;
+    }
+
+    KINFO("Decoding %s -> %s...", argv[2], argv[3]);
+    b8 result = log_binary_decode(argv[2], argv[3]);
+    memory_system_shutdown();
+    return result ? 0 : -5;
+}
+
+i32 process_pack(i32 argc, char** argv) {
+    // The archive, the base directory, optionally -c, then at least one file.
+    b8 compress = argc > 4 && strings_equal(argv[4], "-c");
+    i32 first_file = compress ? 5 : 4;
+    if (argc <= first_file) {
+        KERROR("Pack mode requires an output path, a base directory and at least one file.");
+        return -3;
+    }
+
+    memory_system_configuration memory_system_config = {0};
+    memory_system_config.total_alloc_size = GIBIBYTES(1);
+    if (!memory_system_initialize(memory_system_config)) {
+        KERROR("Failed to initialize memory system.");
+        return -4;
+    }
+
+    u32 source_count = (u32)(argc - first_file);
+    asset_archive_source* sources = kallocate(sizeof(asset_archive_source) * source_count, MEMORY_TAG_ARRAY);
+    i32 result = 0;
+    for (u32 i = 0; i < source_count; ++i) {
+        const char* name = argv[first_file + i];
+        char path[512];
+        string_format(path, "%s/%s", argv[3], name);
+        file_handle f;
+        u64 size = 0;
+        if (!filesystem_open(path, FILE_MODE_READ, true, &f)) {
+            KERROR("Unable to open '%s'.", path);
+            result = -5;
+            break;
+        }
+        if (!filesystem_size(&f, &size)) {
+            KERROR("Unable to get the size of '%s'.", path);
+            filesystem_close(&f);
+            result = -5;
+            break;
+        }
+        // Entries are named relative to the base directory, as the resource system looks them up.
+        sources[i].name = name;
+        sources[i].size = size;
+        if (size > 0) {
+            u8* data = kallocate(size, MEMORY_TAG_ARRAY);
+            u64 read = 0;
+            sources[i].data = data;
+            if (!filesystem_read_all_bytes(&f, data, &read) || read != size) {
+                KERROR("Unable to read '%s'.", path);
+                filesystem_close(&f);
+                result = -5;
+                break;
+            }
+        }
+        filesystem_close(&f);
+    }
+
+    if (result == 0) {
+        KINFO("Packing %u files into %s...", source_count, argv[2]);
+        if (!asset_archive_write(argv[2], source_count, sources, compress)) {
+            result = -6;
+        }
+    }
+
+    for (u32 i = 0; i < source_count; ++i) {
+        if (sources[i].data) {
+            kfree((void*)sources[i].data, sources[i].size, MEMORY_TAG_ARRAY);
+        }
+    }
+    kfree(sources, sizeof(asset_archive_source) * source_count, MEMORY_TAG_ARRAY);
+    memory_system_shutdown();
+    return result;
+}
+
+i32 process_ksm(i32 argc, char** argv) {
+    // The input, the output, then optionally -c.
+    if (argc < 4) {
+        KERROR("KSM mode requires an input and an output path.");
+        return -3;
+    }
+    b8 compress = argc > 4 && strings_equal(argv[4], "-c");
+
+    memory_system_configuration memory_system_config = {0};
+    memory_system_config.total_alloc_size = GIBIBYTES(1);
+    if (!memory_system_initialize(memory_system_config)) {
+        KERROR("Failed to initialize memory system.");
+        return -4;
+    }
+
+    KINFO("Converting %s -> %s%s...", argv[2], argv[3], compress ? " (compressed)" : "");
+    b8 result = ksm_file_convert(argv[2], argv[3], compress);
+    memory_system_shutdown();
+    return result ? 0 : -5;
+}
+
+i32 process_cook(i32 argc, char** argv) {
+    // The base directory, then at least one file.
+    if (argc < 4) {
+        KERROR("Cook mode requires a base directory and at least one file.");
+        return -3;
+    }
+
+    memory_system_configuration memory_system_config = {0};
+    memory_system_config.total_alloc_size = GIBIBYTES(1);
+    if (!memory_system_initialize(memory_system_config)) {
+        KERROR("Failed to initialize memory system.");
+        return -4;
+    }
+
+    // Leave a core for this thread, which waits on and helps with the cooking.
+    i32 thread_count = KCLAMP(platform_get_processor_count() - 1, 1, 15);
+    KINFO("Cooking %i files under %s on %i threads...", argc - 3, argv[2], thread_count);
+    b8 result = asset_cook(argv[2], (u32)(argc - 3), (const char**)argv + 3, (u32)thread_count);
+    memory_system_shutdown();
+    return result ? 0 : -5;
 }
 
 void print_help() {
@@ -99,6 +275,31 @@ void print_help() {
                     should be provided that all end in <stage>.glsl, where <stage> is\n\
                     replaced by one of the following supported stages:\n\
                         vert, frag, geom, comp\n\
-                    The compiled .spv file is output to the same path as the input file.\n",
-        extension);
+                    The compiled .spv file is output to the same path as the input file.\n\
+                    Stages are compiled in parallel, skipping any which, along with what\n\
+                    they include, are unchanged since they were last compiled, as recorded\n\
+                    in a manifest beside them. Pass -f to compile every stage anyway, and\n\
+                    -O to optimize each for performance with spirv-opt.\n\
+                    Files ending in .shadercfg are compiled to .ksc at the same path once\n\
+                    their uniforms are checked against their stages, which are always\n\
+                    compiled first.\n\
+    decodelog    -  Decodes a binary log into text. Takes the path of the binary\n\
+                    log, then the path of the text file to write.\n\
+    pack         -  Packs asset files into an archive the resource system can mount.\n\
+                    Takes the path of the archive, then the base directory the files\n\
+                    are relative to, then optionally -c to compress them, then the\n\
+                    files. For example:\n\
+                        tools%s pack assets/assets.kpak assets -c textures/a.png\n\
+    ksm          -  Rewrites a .ksm mesh in the current version. Takes the path of the\n\
+                    mesh, then the path to write, then optionally -c to compress its\n\
+                    vertices and indices, which are then decoded on load rather than\n\
+                    used in place. For example:\n\
+                        tools%s ksm assets/models/a.ksm out/models/a.ksm -c\n\
+    cook         -  Cooks asset source files into the formats loaded at runtime, in\n\
+                    parallel, skipping any unchanged since they were last cooked. Takes\n\
+                    the base directory the files are relative to, then the files. A\n\
+                    manifest of what was cooked is written to the base directory.\n\
+                    For example:\n\
+                        tools%s cook assets models/sponza.obj fonts/Ubuntu Mono 21px.fnt\n",
+        extension, extension, extension, extension);
 }